@@ -0,0 +1,689 @@
+/**
+ * @file Benchmark.cpp
+ * @brief Accuracy and throughput report for EngineMath, the batch kernels and the
+ *        vector/matrix/quaternion types.
+ *
+ * Every float function is sampled over its useful domain and compared with the double
+ * precision <cmath> result (max/mean ULP and max absolute error), then timed as a scalar
+ * loop and, where one exists, through the batch API. Precision tiers are reported side by
+ * side. Pass a substring as the first argument to run only matching rows.
+ *
+ * Build in Release (the Benchmarks project in the solution), or by hand with e.g.
+ *   cl /O2 /std:c++17 /EHsc /I ..\EngineUtilities\include src\Benchmark.cpp
+ *   g++ -O2 -std=c++17 -march=native -I ../EngineUtilities/include src/Benchmark.cpp
+ * The replication row is built when the SFML headers are on the include path, as in the x64
+ * configurations of the project; it then needs sfml-network and sfml-system at link time.
+ */
+
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Precision.h>
+#include <Math/TrigLUT.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector4.h>
+#include <Vectors/VectorBatch.h>
+#include <Vectors/Vector3Packet.h>
+#include <Vectors/Vector3Stream.h>
+#include <Vectors/VectorPacked.h>
+#include <Geometry/ConvexHull.h>
+#include <Matrices/Matrix2x2.h>
+#include <Matrices/Matrix3x3.h>
+#include <Matrices/Matrix4x4.h>
+#include <Rotations/Quaternion.h>
+#include <Rotations/QuaternionPacked.h>
+#if __has_include(<SFML/Network/Packet.hpp>)
+#include <Network/Replication.h>
+#define EU_BENCHMARK_REPLICATION 1
+#endif
+
+namespace {
+ const size_t SAMPLES = 1 << 20;   ///< Accuracy sample count per function
+ const size_t BLOCK = 4096;        ///< Elements per timed pass, fits in L1/L2
+ const double MIN_SECONDS = 0.05;  ///< Minimum timed duration per row
+
+ volatile float g_sink;
+ const char* g_filter = nullptr;
+
+ bool
+  selected(const char* name) {
+  return g_filter == nullptr || std::strstr(name, g_filter) != nullptr;
+ }
+
+ /** Deterministic uniform floats in [lo, hi]. */
+ std::vector<float>
+  samples(size_t n, float lo, float hi, uint32_t seed) {
+  std::vector<float> v(n);
+  uint32_t s = seed * 2654435761u + 1u;
+  for (size_t i = 0; i < n; ++i) {
+   s ^= s << 13;
+   s ^= s >> 17;
+   s ^= s << 5;
+   v[i] = lo + (hi - lo) * static_cast<float>(s >> 8) * (1.0f / 16777216.0f);
+  }
+  return v;
+ }
+
+ /**
+  * n vectors of dim components in [-1, 1], each vector scaled by its own power of two from
+  * 2^-150 to 2^127: squared lengths that underflow to zero or subnormals, or overflow.
+  */
+ std::vector<float>
+  rangeSamples(size_t n, size_t dim, uint32_t seed) {
+  std::vector<float> v = samples(dim * n, -1.0f, 1.0f, seed);
+  for (size_t i = 0; i < n; ++i) {
+   const int exponent = -150 + static_cast<int>(i % 278);
+   for (size_t c = 0; c < dim; ++c) v[dim * i + c] = std::ldexp(v[dim * i + c], exponent);
+  }
+  return v;
+ }
+
+ /** Distance between got and the exact value in units of the float spacing at exact. */
+ double
+  ulpError(float got, double exact) {
+  if (std::isnan(exact) || std::isinf(exact)) {
+   return (std::isnan(got) == std::isnan(exact) && got == static_cast<float>(exact)) ? 0.0 : 1e30;
+  }
+  float rounded = static_cast<float>(exact);
+  if (std::isinf(rounded)) {
+   return std::isinf(got) ? 0.0 : 1e30;
+  }
+  float mag = std::fabs(rounded);
+  double ulp = static_cast<double>(std::nextafter(mag, INFINITY)) - mag;
+  return std::fabs(static_cast<double>(got) - exact) / ulp;
+ }
+
+ struct ErrorStats {
+  double maxUlp = 0.0;
+  double sumUlp = 0.0;
+  double maxAbs = 0.0;
+  size_t count = 0;
+
+  void
+   add(float got, double exact) {
+   double u = ulpError(got, exact);
+   double a = static_cast<double>(got) == exact ? 0.0 : std::fabs(static_cast<double>(got) - exact);
+   if (u > maxUlp) maxUlp = u;
+   if (a > maxAbs || std::isnan(a)) maxAbs = a;
+   sumUlp += u;
+   ++count;
+  }
+
+  double mean() const { return count ? sumUlp / static_cast<double>(count) : 0.0; }
+ };
+
+ /** Runs pass() (ops operations per call) until MIN_SECONDS elapse, returns ns per op. */
+ template<typename Pass>
+ double
+  nsPerOp(size_t ops, Pass pass) {
+  using Clock = std::chrono::steady_clock;
+  pass();
+  size_t calls = 0;
+  Clock::time_point start = Clock::now();
+  double elapsed = 0.0;
+  do {
+   for (int i = 0; i < 16; ++i) pass();
+   calls += 16;
+   elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  } while (elapsed < MIN_SECONDS);
+  return elapsed * 1e9 / static_cast<double>(calls * ops);
+ }
+
+ void
+  header(const char* title) {
+  std::printf("\n== %s\n", title);
+  std::printf("%-30s %10s %10s %12s %12s %12s\n", "function", "scalar ns", "batch ns", "max ulp", "mean ulp", "max abs");
+ }
+
+ void
+  row(const char* name, double scalarNs, double batchNs, const ErrorStats& e) {
+  char batch[32];
+  if (batchNs > 0.0) std::snprintf(batch, sizeof(batch), "%10.3f", batchNs);
+  else std::snprintf(batch, sizeof(batch), "%10s", "-");
+  std::printf("%-30s %10.3f %s %12.2f %12.3f %12.3g\n", name, scalarNs, batch, e.maxUlp, e.mean(), e.maxAbs);
+ }
+
+ typedef void (*BatchFn)(const float*, float*, size_t);
+ typedef void (*BatchFn2)(const float*, const float*, float*, size_t);
+
+ /** One-argument function: accuracy over [lo, hi], scalar and optional batch timing. */
+ template<typename Fn, typename Ref>
+ void
+  unary(const char* name, Fn fn, Ref ref, float lo, float hi, BatchFn batchFn = nullptr) {
+  if (!selected(name)) return;
+  std::vector<float> in = samples(SAMPLES, lo, hi, 1);
+  std::vector<float> out(SAMPLES);
+  ErrorStats e;
+  for (size_t i = 0; i < SAMPLES; ++i) e.add(fn(in[i]), ref(static_cast<double>(in[i])));
+  if (batchFn) {
+   batchFn(in.data(), out.data(), SAMPLES);
+   for (size_t i = 0; i < SAMPLES; ++i) e.add(out[i], ref(static_cast<double>(in[i])));
+  }
+  const float* block = in.data();
+  float* dst = out.data();
+  double scalar = nsPerOp(BLOCK, [&] {
+   for (size_t i = 0; i < BLOCK; ++i) dst[i] = fn(block[i]);
+   g_sink = dst[BLOCK - 1];
+  });
+  double batch = 0.0;
+  if (batchFn) {
+   batch = nsPerOp(BLOCK, [&] {
+    batchFn(block, dst, BLOCK);
+    g_sink = dst[BLOCK - 1];
+   });
+  }
+  row(name, scalar, batch, e);
+ }
+
+ /** Two-argument function, both arguments drawn from their own ranges. */
+ template<typename Fn, typename Ref>
+ void
+  binary(const char* name, Fn fn, Ref ref, float aLo, float aHi, float bLo, float bHi, BatchFn2 batchFn = nullptr) {
+  if (!selected(name)) return;
+  std::vector<float> a = samples(SAMPLES, aLo, aHi, 2);
+  std::vector<float> b = samples(SAMPLES, bLo, bHi, 3);
+  std::vector<float> out(SAMPLES);
+  ErrorStats e;
+  for (size_t i = 0; i < SAMPLES; ++i) e.add(fn(a[i], b[i]), ref(static_cast<double>(a[i]), static_cast<double>(b[i])));
+  if (batchFn) {
+   batchFn(a.data(), b.data(), out.data(), SAMPLES);
+   for (size_t i = 0; i < SAMPLES; ++i) e.add(out[i], ref(static_cast<double>(a[i]), static_cast<double>(b[i])));
+  }
+  const float* pa = a.data();
+  const float* pb = b.data();
+  float* dst = out.data();
+  double scalar = nsPerOp(BLOCK, [&] {
+   for (size_t i = 0; i < BLOCK; ++i) dst[i] = fn(pa[i], pb[i]);
+   g_sink = dst[BLOCK - 1];
+  });
+  double batch = 0.0;
+  if (batchFn) {
+   batch = nsPerOp(BLOCK, [&] {
+    batchFn(pa, pb, dst, BLOCK);
+    g_sink = dst[BLOCK - 1];
+   });
+  }
+  row(name, scalar, batch, e);
+ }
+
+ /** fn at the edges of its domain: zero, denormals, the smallest and largest normals and infinity. */
+ template<typename Fn, typename Ref>
+ void
+  edges(const char* name, Fn fn, Ref ref) {
+  if (!selected(name)) return;
+  const float values[] = { 0.0f, 1e-45f, 1e-40f, 1e-39f, FLT_MIN, 1.0f, FLT_MAX, INFINITY };
+  ErrorStats e;
+  for (float v : values) e.add(fn(v), ref(static_cast<double>(v)));
+  row(name, 0.0, 0.0, e);
+ }
+
+ /**
+  * fn at the 129 floats around every odd multiple of PI/2 in [-limit, limit], where tan()
+  * divides the absolute error of its reduction by the distance to the pole.
+  */
+ template<typename Fn, typename Ref>
+ void
+  poles(const char* name, Fn fn, Ref ref, float limit, BatchFn batchFn = nullptr) {
+  if (!selected(name)) return;
+  const double PI_D = 3.14159265358979323846;
+  std::vector<float> in;
+  for (double pole = 0.5 * PI_D; pole <= limit; pole += PI_D) {
+   for (double side : { pole, -pole }) {
+    float x = static_cast<float>(side);
+    for (int j = 0; j < 64; ++j) x = std::nextafter(x, -INFINITY);
+    for (int j = 0; j < 129; ++j, x = std::nextafter(x, INFINITY)) in.push_back(x);
+   }
+  }
+  std::vector<float> out(in.size());
+  ErrorStats e;
+  for (float x : in) e.add(fn(x), ref(static_cast<double>(x)));
+  if (batchFn) {
+   batchFn(in.data(), out.data(), in.size());
+   for (size_t i = 0; i < in.size(); ++i) e.add(out[i], ref(static_cast<double>(in[i])));
+  }
+  row(name, 0.0, 0.0, e);
+ }
+
+ double refRsqrt(double x) { return 1.0 / std::sqrt(x); }
+ double refSqrt(double x) { return std::sqrt(x); }
+ double refSin(double x) { return std::sin(x); }
+ double refCos(double x) { return std::cos(x); }
+ double refTan(double x) { return std::tan(x); }
+ double refAtan(double x) { return std::atan(x); }
+ double refAsin(double x) { return std::asin(x); }
+ double refAcos(double x) { return std::acos(x); }
+ double refExp(double x) { return std::exp(x); }
+ double refExp2(double x) { return std::exp2(x); }
+ double refLog(double x) { return std::log(x); }
+ double refLog2(double x) { return std::log2(x); }
+ double refFloor(double x) { return std::floor(x); }
+ double refCeil(double x) { return std::ceil(x); }
+ double refRound(double x) { return std::round(x); }
+ double refTrunc(double x) { return std::trunc(x); }
+ double refAtan2(double y, double x) { return std::atan2(y, x); }
+ double refPow(double b, double e) { return std::pow(b, e); }
+ double refFmod(double a, double b) { return std::fmod(a, b); }
+
+ double
+  refMod(double a, double b) {
+  double r = std::fmod(a, b);
+  return (r != 0.0 && ((r < 0.0) != (b < 0.0))) ? r + b : r;
+ }
+
+ double
+  refWrapAngle(double x) {
+  return std::remainder(x, 2.0 * 3.14159265358979323846);
+ }
+
+ void
+  scalarFunctions() {
+  using namespace EngineMath;
+  header("EngineMath scalar / batch");
+  unary("sqrt", [](float x) { return EngineMath::sqrt(x); }, refSqrt, 0.0f, 1e4f, batch::sqrt);
+  unary("sqrtFast", [](float x) { return sqrtFast(x); }, refSqrt, 1e-4f, 1e4f);
+  unary("sqrtStandard", [](float x) { return sqrtStandard(x); }, refSqrt, 1e-4f, 1e4f);
+  unary("sqrtFast denormal", [](float x) { return sqrtFast(x); }, refSqrt, 1e-45f, FLT_MIN);
+  unary("sqrtStandard denormal", [](float x) { return sqrtStandard(x); }, refSqrt, 1e-45f, FLT_MIN);
+  edges("sqrtFast edges", [](float x) { return sqrtFast(x); }, refSqrt);
+  edges("sqrtStandard edges", [](float x) { return sqrtStandard(x); }, refSqrt);
+  unary("sqrtHardware", [](float x) { return sqrtHardware(x); }, refSqrt, 0.0f, 1e4f);
+  unary("rsqrt", [](float x) { return EngineMath::rsqrt(x); }, refRsqrt, 1e-4f, 1e4f, batch::rsqrt);
+  unary("rsqrtFast", [](float x) { return rsqrtFast(x); }, refRsqrt, 1e-4f, 1e4f);
+  unary("sin", [](float x) { return EngineMath::sin(x); }, refSin, -100.0f, 100.0f, batch::sin);
+  unary("cos", [](float x) { return EngineMath::cos(x); }, refCos, -100.0f, 100.0f, batch::cos);
+  unary("TrigLUT<1024>::sin", [](float x) { return TrigLUT<1024>::sin(x); }, refSin, -100.0f, 100.0f);
+  unary("TrigLUT<1024>::cos", [](float x) { return TrigLUT<1024>::cos(x); }, refCos, -100.0f, 100.0f);
+  unary("tan", [](float x) { return EngineMath::tan(x); }, refTan, -1.5f, 1.5f, batch::tan);
+  poles("tan poles |x|<=100", [](float x) { return EngineMath::tan(x); }, refTan, 100.0f, batch::tan);
+  poles("tan poles |x|<=8192", [](float x) { return EngineMath::tan(x); }, refTan, 8192.0f, batch::tan);
+  unary("atan", [](float x) { return EngineMath::atan(x); }, refAtan, -100.0f, 100.0f, batch::atan);
+  unary("asin", [](float x) { return EngineMath::asin(x); }, refAsin, -1.0f, 1.0f, batch::asin);
+  unary("acos", [](float x) { return EngineMath::acos(x); }, refAcos, -1.0f, 1.0f, batch::acos);
+  unary("exp", [](float x) { return EngineMath::exp(x); }, refExp, -80.0f, 80.0f, batch::exp);
+  unary("exp2", [](float x) { return EngineMath::exp2(x); }, refExp2, -120.0f, 120.0f, batch::exp2);
+  unary("log", [](float x) { return EngineMath::log(x); }, refLog, 1e-3f, 1e4f);
+  unary("log2", [](float x) { return EngineMath::log2(x); }, refLog2, 1e-3f, 1e4f);
+  unary("ffloor", [](float x) { return ffloor(x); }, refFloor, -1e7f, 1e7f, batch::floor);
+  unary("fceil", [](float x) { return fceil(x); }, refCeil, -1e7f, 1e7f, batch::ceil);
+  unary("fround", [](float x) { return fround(x); }, refRound, -1e7f, 1e7f, batch::round);
+  unary("ftrunc", [](float x) { return ftrunc(x); }, refTrunc, -1e7f, 1e7f);
+  unary("wrapAngle", [](float x) { return wrapAngle(x); }, refWrapAngle, -1000.0f, 1000.0f, batch::wrapAngle);
+  binary("atan2", [](float y, float x) { return EngineMath::atan2(y, x); }, refAtan2, -10.0f, 10.0f, -10.0f, 10.0f, batch::atan2);
+  binary("pow", [](float b, float e) { return EngineMath::pow(b, e); }, refPow, 0.01f, 10.0f, -8.0f, 8.0f);
+  binary("fmod", [](float a, float b) { return EngineMath::fmod(a, b); }, refFmod, -100.0f, 100.0f, 0.5f, 10.0f, batch::fmod);
+  binary("mod", [](float a, float b) { return EngineMath::mod(a, b); }, refMod, -100.0f, 100.0f, 0.5f, 10.0f, batch::mod);
+ }
+
+ /** sqrt, rsqrt and vector length/normalize for one precision policy. */
+ template<typename Policy>
+ void
+  precisionTier() {
+  char name[64];
+  std::snprintf(name, sizeof(name), "sqrt<%s>", Policy::NAME);
+  unary(name, [](float x) { return EngineMath::sqrt<Policy>(x); }, refSqrt, 1e-4f, 1e4f);
+  std::snprintf(name, sizeof(name), "rsqrt<%s>", Policy::NAME);
+  unary(name, [](float x) { return EngineMath::rsqrt<Policy>(x); }, refRsqrt, 1e-4f, 1e4f);
+
+  std::snprintf(name, sizeof(name), "CVector3::length<%s>", Policy::NAME);
+  if (selected(name)) {
+   std::vector<float> c = samples(3 * SAMPLES, -100.0f, 100.0f, 4);
+   ErrorStats e;
+   for (size_t i = 0; i < SAMPLES; ++i) {
+    CVector3 v(c[3 * i], c[3 * i + 1], c[3 * i + 2]);
+    double x = v.x, y = v.y, z = v.z;
+    e.add(v.length<Policy>(), std::sqrt(x * x + y * y + z * z));
+   }
+   const float* p = c.data();
+   double ns = nsPerOp(BLOCK, [&] {
+    float acc = 0.0f;
+    for (size_t i = 0; i < BLOCK; ++i) acc += CVector3(p[3 * i], p[3 * i + 1], p[3 * i + 2]).length<Policy>();
+    g_sink = acc;
+   });
+   row(name, ns, 0.0, e);
+  }
+
+  std::snprintf(name, sizeof(name), "CVector3::normalized<%s>", Policy::NAME);
+  if (selected(name)) {
+   std::vector<float> c = samples(3 * SAMPLES, -100.0f, 100.0f, 5);
+   ErrorStats e;
+   for (size_t i = 0; i < SAMPLES; ++i) {
+    CVector3 n = CVector3(c[3 * i], c[3 * i + 1], c[3 * i + 2]).normalized<Policy>();
+    double x = n.x, y = n.y, z = n.z;
+    e.add(static_cast<float>(std::sqrt(x * x + y * y + z * z)), 1.0);
+   }
+   const float* p = c.data();
+   double ns = nsPerOp(BLOCK, [&] {
+    float acc = 0.0f;
+    for (size_t i = 0; i < BLOCK; ++i) acc += CVector3(p[3 * i], p[3 * i + 1], p[3 * i + 2]).normalized<Policy>().x;
+    g_sink = acc;
+   });
+   row(name, ns, 0.0, e);
+  }
+
+  std::snprintf(name, sizeof(name), "CVector3::normalized<%s> range", Policy::NAME);
+  if (selected(name)) {
+   std::vector<float> c = rangeSamples(SAMPLES, 3, 7);
+   ErrorStats e;
+   for (size_t i = 0; i < SAMPLES; ++i) {
+    const CVector3 v(c[3 * i], c[3 * i + 1], c[3 * i + 2]);
+    if (v.x == 0.0f && v.y == 0.0f && v.z == 0.0f) continue;
+    const CVector3 n = v.normalized<Policy>();
+    double x = n.x, y = n.y, z = n.z;
+    e.add(static_cast<float>(std::sqrt(x * x + y * y + z * z)), 1.0);
+   }
+   const float* p = c.data();
+   double ns = nsPerOp(BLOCK, [&] {
+    float acc = 0.0f;
+    for (size_t i = 0; i < BLOCK; ++i) acc += CVector3(p[3 * i], p[3 * i + 1], p[3 * i + 2]).normalized<Policy>().x;
+    g_sink = acc;
+   });
+   row(name, ns, 0.0, e);
+  }
+
+  std::snprintf(name, sizeof(name), "normalizeArray<%s> range", Policy::NAME);
+  if (selected(name)) {
+   std::vector<float> c = rangeSamples(SAMPLES, 3, 8);
+   std::vector<CVector3> in(SAMPLES), out(SAMPLES);
+   for (size_t i = 0; i < SAMPLES; ++i) in[i] = CVector3(c[3 * i], c[3 * i + 1], c[3 * i + 2]);
+   EU::normalizeArray<Policy>(in.data(), out.data(), SAMPLES);
+   ErrorStats e;
+   for (size_t i = 0; i < SAMPLES; ++i) {
+    if (in[i].x == 0.0f && in[i].y == 0.0f && in[i].z == 0.0f) continue;
+    double x = out[i].x, y = out[i].y, z = out[i].z;
+    e.add(static_cast<float>(std::sqrt(x * x + y * y + z * z)), 1.0);
+   }
+   double ns = nsPerOp(BLOCK, [&] {
+    EU::normalizeArray<Policy>(in.data(), out.data(), BLOCK);
+    g_sink = out[BLOCK - 1].x;
+   });
+   row(name, 0.0, ns, e);
+  }
+
+  std::snprintf(name, sizeof(name), "CVector3Packet::normalized<%s> range", Policy::NAME);
+  if (selected(name)) {
+   using Packet = CVector3Packet<EU::SIMD::FloatN>;
+   const size_t width = static_cast<size_t>(EU::SIMD::FloatN::WIDTH);
+   std::vector<float> c = rangeSamples(SAMPLES, 3, 9);
+   std::vector<CVector3> in(SAMPLES), out(SAMPLES);
+   for (size_t i = 0; i < SAMPLES; ++i) in[i] = CVector3(c[3 * i], c[3 * i + 1], c[3 * i + 2]);
+   for (size_t i = 0; i + width <= SAMPLES; i += width) Packet::load(&in[i]).normalized<Policy>().store(&out[i]);
+   ErrorStats e;
+   for (size_t i = 0; i < SAMPLES; ++i) {
+    if (in[i].x == 0.0f && in[i].y == 0.0f && in[i].z == 0.0f) continue;
+    double x = out[i].x, y = out[i].y, z = out[i].z;
+    e.add(static_cast<float>(std::sqrt(x * x + y * y + z * z)), 1.0);
+   }
+   double ns = nsPerOp(BLOCK, [&] {
+    for (size_t i = 0; i + width <= BLOCK; i += width) Packet::load(&in[i]).normalized<Policy>().store(&out[i]);
+    g_sink = out[BLOCK - 1].x;
+   });
+   row(name, 0.0, ns, e);
+  }
+ }
+
+ void
+  precisionTiers() {
+  header("Precision tiers (error of |normalized| is against 1)");
+  precisionTier<EU::Precision::Fast>();
+  precisionTier<EU::Precision::Balanced>();
+  precisionTier<EU::Precision::Exact>();
+
+  if (selected("Vector3Stream normalize range")) {
+   std::vector<float> c = rangeSamples(SAMPLES, 3, 10);
+   std::vector<CVector3> v(SAMPLES);
+   for (size_t i = 0; i < SAMPLES; ++i) v[i] = CVector3(c[3 * i], c[3 * i + 1], c[3 * i + 2]);
+   EU::Vector3Stream in(v.data(), SAMPLES), out;
+   EU::normalize(in, out);
+   ErrorStats e;
+   for (size_t i = 0; i < SAMPLES; ++i) {
+    if (in.x()[i] == 0.0f && in.y()[i] == 0.0f && in.z()[i] == 0.0f) continue;
+    double x = out.x()[i], y = out.y()[i], z = out.z()[i];
+    e.add(static_cast<float>(std::sqrt(x * x + y * y + z * z)), 1.0);
+   }
+   EU::Vector3Stream block(v.data(), BLOCK);
+   double ns = nsPerOp(BLOCK, [&] {
+    EU::normalize(block, out);
+    g_sink = out.x()[BLOCK - 1];
+   });
+   row("Vector3Stream normalize range", 0.0, ns, e);
+  }
+ }
+
+ void
+  timingRow(const char* name, double ns) {
+  std::printf("%-30s %10.3f %10s %12s %12s %12s\n", name, ns, "-", "-", "-", "-");
+ }
+
+ /** Types and operations timed over BLOCK-element arrays of random operands. */
+ void
+  geometry() {
+  using namespace EU;
+  header("Vector / matrix / quaternion ops");
+  std::vector<float> c = samples(16 * BLOCK, -2.0f, 2.0f, 6);
+  std::vector<CVector2> v2(BLOCK);
+  std::vector<CVector3> v3(BLOCK);
+  std::vector<CVector4> v4(BLOCK);
+  std::vector<Quaternion> q(BLOCK);
+  std::vector<Matrix3x3> m3(BLOCK);
+  std::vector<Matrix4x4> m4(BLOCK);
+  for (size_t i = 0; i < BLOCK; ++i) {
+   const float* p = &c[16 * i];
+   v2[i] = CVector2(p[0], p[1]);
+   v3[i] = CVector3(p[0], p[1], p[2]);
+   v4[i] = CVector4(p[0], p[1], p[2], p[3]);
+   q[i] = Quaternion(p[0], p[1], p[2], p[3]).normalized();
+   m3[i] = Matrix3x3(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], p[8]);
+   m4[i] = Matrix4x4(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7],
+                     p[8], p[9], p[10], p[11], p[12], p[13], p[14], p[15]);
+  }
+  const size_t N = BLOCK - 1;
+
+#define EU_BENCH_OP(label, expr) \
+  if (selected(label)) { \
+   timingRow(label, nsPerOp(N, [&] { \
+    float acc = 0.0f; \
+    for (size_t i = 0; i < N; ++i) acc += (expr); \
+    g_sink = acc; \
+   })); \
+  }
+
+  EU_BENCH_OP("CVector2::dot", v2[i].dot(v2[i + 1]))
+  EU_BENCH_OP("CVector2::length", v2[i].length())
+  EU_BENCH_OP("CVector2::normalized", v2[i].normalized().x)
+  EU_BENCH_OP("CVector3::dot", v3[i].dot(v3[i + 1]))
+  EU_BENCH_OP("CVector3::cross", v3[i].cross(v3[i + 1]).x)
+  EU_BENCH_OP("CVector3::length", v3[i].length())
+  EU_BENCH_OP("CVector3::normalized", v3[i].normalized().x)
+  EU_BENCH_OP("CVector3::distance", CVector3::distance(v3[i], v3[i + 1]))
+  EU_BENCH_OP("CVector4::dot", v4[i].dot(v4[i + 1]))
+  EU_BENCH_OP("CVector4::normalized", v4[i].normalized().x)
+  EU_BENCH_OP("Quaternion::operator*", (q[i] * q[i + 1]).w)
+  EU_BENCH_OP("Quaternion::rotate", q[i].rotate(v3[i + 1]).x)
+  EU_BENCH_OP("Quaternion::normalized", q[i].normalized().w)
+  EU_BENCH_OP("Quaternion::lerp", Quaternion::lerp(q[i], q[i + 1], 0.3f).w)
+  EU_BENCH_OP("Matrix3x3::operator*", (m3[i] * m3[i + 1]).m[1][1])
+  EU_BENCH_OP("Matrix3x3*CVector3", (m3[i] * v3[i + 1]).x)
+  EU_BENCH_OP("Matrix3x3::inverse", m3[i].inverse().m[0][0])
+  EU_BENCH_OP("Matrix4x4::operator*", (m4[i] * m4[i + 1]).m[2][2])
+  EU_BENCH_OP("Matrix4x4*CVector4", (m4[i] * v4[i + 1]).x)
+  EU_BENCH_OP("Matrix4x4::transpose", m4[i].transpose().m[0][1])
+
+#undef EU_BENCH_OP
+
+  if (selected("Quaternion::rotate error")) {
+   ErrorStats e;
+   for (size_t i = 0; i < N; ++i) {
+    CVector3 r = q[i].rotate(v3[i + 1]);
+    double len = std::sqrt(static_cast<double>(v3[i + 1].x) * v3[i + 1].x +
+                           static_cast<double>(v3[i + 1].y) * v3[i + 1].y +
+                           static_cast<double>(v3[i + 1].z) * v3[i + 1].z);
+    e.add(r.length(), len);
+   }
+   std::printf("%-30s %10s %10s %12.2f %12.3f %12.3g\n", "Quaternion::rotate |v|", "-", "-", e.maxUlp, e.mean(), e.maxAbs);
+  }
+
+  // The bulk decode must give the bits of toFloat(): max ulp 0 against it, FMA or not.
+  if (selected("CNormalOct::unpack")) {
+   std::vector<CNormalOct> in(SAMPLES);
+   for (size_t i = 0; i < SAMPLES; ++i) in[i].bits = static_cast<uint32_t>(i * 2654435761u);
+   std::vector<CVector3> out(SAMPLES);
+   CNormalOct::unpack(in.data(), out.data(), SAMPLES);
+   ErrorStats e;
+   for (size_t i = 0; i < SAMPLES; ++i) {
+    const CVector3 ref = in[i].toFloat();
+    for (int k = 0; k < 3; ++k) e.add(out[i][k], ref[k]);
+   }
+   double scalar = nsPerOp(BLOCK, [&] {
+    float acc = 0.0f;
+    for (size_t i = 0; i < BLOCK; ++i) acc += in[i].toFloat().x;
+    g_sink = acc;
+   });
+   double batch = nsPerOp(BLOCK, [&] {
+    CNormalOct::unpack(in.data(), out.data(), BLOCK);
+    g_sink = out[BLOCK - 1].x;
+   });
+   row("CNormalOct::unpack", scalar, batch, e);
+  }
+
+  // Same for the smallest-three decode, with Exact so both sides take the hardware sqrt.
+  if (selected("unpackQuaternionArray")) {
+   std::vector<uint64_t> in(SAMPLES);
+   for (size_t i = 0; i < SAMPLES; ++i) in[i] = (static_cast<uint64_t>(i) * 0x9e3779b97f4a7c15ull) >> 32;
+   std::vector<Quaternion> out(SAMPLES);
+   unpackQuaternionArray<Precision::Exact>(in.data(), out.data(), SAMPLES, QuaternionFormat::Bits32);
+   ErrorStats e;
+   for (size_t i = 0; i < SAMPLES; ++i) {
+    const Quaternion ref = unpackQuaternion<Precision::Exact>(in[i], QuaternionFormat::Bits32);
+    e.add(out[i].x, ref.x);
+    e.add(out[i].y, ref.y);
+    e.add(out[i].z, ref.z);
+    e.add(out[i].w, ref.w);
+   }
+   double scalar = nsPerOp(BLOCK, [&] {
+    float acc = 0.0f;
+    for (size_t i = 0; i < BLOCK; ++i) acc += unpackQuaternion<Precision::Exact>(in[i], QuaternionFormat::Bits32).w;
+    g_sink = acc;
+   });
+   double batch = nsPerOp(BLOCK, [&] {
+    unpackQuaternionArray<Precision::Exact>(in.data(), out.data(), BLOCK, QuaternionFormat::Bits32);
+    g_sink = out[BLOCK - 1].w;
+   });
+   row("unpackQuaternionArray", scalar, batch, e);
+  }
+
+  // Slabs 2 wide and 2e-5 to 0.02 thick, and 2000 wide and 0.02 thick: every input point must be behind
+  // every hull face within the hull tolerance, so max abs (the worst excess) should read 0.
+  if (selected("convexHull slab")) {
+   const float thickness[] = { 1e-5f, 1e-4f, 5e-4f, 1e-3f, 0.01f, 1e-5f };
+   double excess = 0.0;
+   std::vector<CVector3> vertices;
+   std::vector<uint32_t> triangles;
+   for (int t = 0; t < 1000; ++t) {
+    const float width = t % 6 == 5 ? 1000.f : 1.f;
+    const size_t n = 20 + t % 200;
+    std::vector<float> c = samples(3 * n, -1.0f, 1.0f, 100 + t);
+    std::vector<CVector3> p(n);
+    for (size_t i = 0; i < n; ++i) p[i] = CVector3(c[3 * i] * width, c[3 * i + 1] * thickness[t % 6] * width, c[3 * i + 2] * width);
+    if (!convexHull(p.data(), n, vertices, triangles)) continue;
+    const double tolerance = 3.0 * EU::Constants::EPSILON * EU::detail::hullScale(p.data(), n);
+    for (size_t k = 0; k < triangles.size(); k += 3) {
+     const CVector3& a = vertices[triangles[k]];
+     const CVector3& b = vertices[triangles[k + 1]];
+     const CVector3& d = vertices[triangles[k + 2]];
+     const double u[3] = { double(b.x) - a.x, double(b.y) - a.y, double(b.z) - a.z };
+     const double v[3] = { double(d.x) - a.x, double(d.y) - a.y, double(d.z) - a.z };
+     const double nx = u[1] * v[2] - u[2] * v[1], ny = u[2] * v[0] - u[0] * v[2], nz = u[0] * v[1] - u[1] * v[0];
+     const double len = std::sqrt(nx * nx + ny * ny + nz * nz);
+     if (len == 0.0) continue;
+     for (const CVector3& q : p) {
+      const double h = (nx * (q.x - a.x) + ny * (q.y - a.y) + nz * (q.z - a.z)) / len - tolerance;
+      if (h > excess) excess = h;
+     }
+    }
+   }
+   std::vector<float> c = samples(3 * BLOCK, -1.0f, 1.0f, 99);
+   std::vector<CVector3> slab(BLOCK);
+   for (size_t i = 0; i < BLOCK; ++i) slab[i] = CVector3(c[3 * i], c[3 * i + 1] * 1e-4f, c[3 * i + 2]);
+   const double ns = nsPerOp(BLOCK, [&] {
+    convexHull(slab.data(), BLOCK, vertices, triangles);
+    g_sink = vertices[0].x;
+   });
+   std::printf("%-30s %10.3f %10s %12s %12s %12.3g\n", "convexHull slab", ns, "-", "-", "-", excess);
+  }
+ }
+
+#ifdef EU_BENCHMARK_REPLICATION
+ /**
+  * One client fed BLOCK moving entities for 100 snapshots, every packet acknowledged. The
+  * first, full, snapshot arrives REPLICATION_HISTORY + 1 snapshots late, after the one that
+  * shares its slot: it must be dropped, so the client keeps decoding deltas against that one
+  * and max abs, the worst position difference from the server's, reads 0.
+  */
+ void
+  replication() {
+  using namespace EU;
+  if (!selected("replication reorder")) return;
+  header("Replication");
+  ReplicationFormat format;
+  format.bounds.minimum = CVector3(-1.f, -1.f, -1.f);
+  format.bounds.maximum = CVector3(1.f, 1.f, 1.f);
+  std::vector<float> c = samples(4 * BLOCK, -1.0f, 1.0f, 7);
+  std::vector<CVector3> positions(BLOCK);
+  for (size_t i = 0; i < BLOCK; ++i) positions[i] = CVector3(c[3 * i], c[3 * i + 1], c[3 * i + 2]);
+  const std::vector<Quaternion> rotations(BLOCK);
+  ReplicationServer server(format);
+  ReplicationClient client(format);
+  const size_t id = server.addClient();
+  const uint32_t LATE = REPLICATION_HISTORY + 1;
+  sf::Packet late;
+  uint32_t frame = 0;
+  double error = 0.0;
+  auto step = [&] {
+   // A few entities move each snapshot.
+   for (size_t i = frame % 64; i < BLOCK; i += 64) positions[i].x = 0.999f * positions[i].x + 0.001f * c[3 * BLOCK + i];
+   const uint32_t seq = server.beginSnapshot(positions.data(), rotations.data(), BLOCK);
+   sf::Packet packet;
+   server.writeSnapshot(id, packet);
+   uint32_t ack = 0;
+   if (++frame == 1) late = packet;
+   else if (client.read(packet, ack)) server.acknowledge(id, ack);
+   if (frame == LATE && client.read(late, ack)) server.acknowledge(id, ack);
+   return seq;
+  };
+  for (int k = 0; k < 100; ++k) {
+   step();
+   if (client.size() != BLOCK) continue;
+   const CVector3* shown = client.positions();
+   for (size_t i = 0; i < BLOCK; ++i) {
+    const uint32_t q = EU::detail::quantizeRange(positions[i].x, -1.f, 1.f, format.positionBits);
+    error = std::fmax(error, std::fabs(shown[i].x - EU::detail::dequantizeRange(q, -1.f, 1.f, format.positionBits)));
+   }
+  }
+  const double ns = nsPerOp(BLOCK, [&] { g_sink = static_cast<float>(step()); });
+  std::printf("%-30s %10.3f %10s %12s %12s %12.3g\n", "replication reorder", ns, "-", "-", "-", error);
+ }
+#endif
+}
+
+int
+ main(int argc, char** argv) {
+ if (argc > 1) {
+  g_filter = argv[1];
+ }
+ std::printf("EngineUtilities benchmark, SIMD width %d, default precision %s\n",
+             EU::SIMD::FloatN::WIDTH, EU::Precision::Default::NAME);
+ scalarFunctions();
+ precisionTiers();
+ geometry();
+#ifdef EU_BENCHMARK_REPLICATION
+ replication();
+#endif
+ return 0;
+}
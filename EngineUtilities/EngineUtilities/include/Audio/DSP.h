@@ -0,0 +1,798 @@
+/**
+ * @file DSP.h
+ * @brief Real FFT, windows, overlap-add and biquad filter banks for captured audio buffers,
+ * with no allocation once set up.
+ *
+ * RealFFT transforms a power-of-two frame of real samples through a complex FFT of half the
+ * length: the samples are read as size / 2 complex values, run through Stockham radix-4 stages
+ * (one radix-2 stage when log2(size / 2) is odd) on split real/imaginary arrays, and the two
+ * interleaved half spectra are separated in one final pass. The twiddles of every stage are
+ * worked out once by init() with the batch sincos kernel and kept next to the two scratch
+ * arrays, so forward() and inverse() allocate nothing; they are not reentrant, one RealFFT per
+ * thread. The spectrum is packed in size floats, in place over the samples if wanted:
+ *
+ *   spectrum[0 .. size / 2)    real parts of bins 0 .. size / 2 - 1
+ *   spectrum[size / 2]         the real Nyquist bin, which also stands for the imaginary part of
+ *                              bin 0, both of which are always zero
+ *   spectrum[size / 2 + k]     imaginary part of bin k, 1 <= k < size / 2
+ *
+ * inverse() includes the 1 / size scale, so inverse(forward(x)) is x to float rounding. The
+ * usual capture loop, noise suppression on a sf::SoundRecorder chunk, keeps every buffer across
+ * calls (processSamples() hands over sf::Int16, converted with int16ToFloat()):
+ *
+ *   applyWindow(window, frame, frame, FRAME);          // makeWindow(Hann, window, FRAME) once
+ *   fft.forward(frame, frame);
+ *   ... scale bins frame[k], frame[FRAME / 2 + k] ...
+ *   fft.inverse(frame, frame);
+ *   applyWindow(window, frame, frame, FRAME);
+ *   ola.push(frame, out);                              // HOP samples ready in out
+ *
+ * With that Hann analysis and synthesis pair the frames sum to overlapGain(window, FRAME, HOP)
+ * (1.5 at a hop of a quarter frame); dividing by it gives back the input.
+ *
+ * BiquadBank runs any number of RBJ cookbook biquads (Biquad::lowPass() and friends) in
+ * transposed direct form II, four filters per register: either one per channel of an
+ * interleaved buffer, or all of them on one mono signal as a band-splitting bank whose outputs,
+ * or just their energies for a spectrum meter, come out side by side. IIR state decays into
+ * denormals on silence; run the audio thread under a DenormalGuard (Core/FloatEnvironment.h).
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <Core/Constants.h>
+#include <Core/SIMD.h>
+#include <Core/Trace.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+
+namespace EU {
+ namespace detail {
+  /**
+   * @brief One Stockham radix-4 stage of transform length n and stride s, forward direction:
+   * y[q + s(4p + k)] = w^kp * sum_j x[q + s(p + j n / 4)] (-i)^jk. tw holds the n / 4 twiddles
+   * w^p, w^2p, w^3p as six arrays: w1 real, w1 imaginary, w2 real, ... Swapping the real and
+   * imaginary pointers of both x and y turns it into the unscaled inverse stage.
+   */
+  inline void
+   fftRadix4(const float* xr, const float* xi, float* yr, float* yi, size_t n, size_t s, const float* tw) {
+   const size_t m = n / 4;
+   const float* w1r = tw;
+   const float* w1i = tw + m;
+   const float* w2r = tw + 2 * m;
+   const float* w2i = tw + 3 * m;
+   const float* w3r = tw + 4 * m;
+   const float* w3i = tw + 5 * m;
+   size_t p = 0;
+#if defined(EU_SIMD_SSE2) || defined(EU_SIMD_NEON)
+   using EU::SIMD::Float4;
+   // Butterfly on four complex lanes; the products by the twiddles are written out so the
+   // two vector paths and the scalar tail round alike.
+   auto butterfly = [](Float4 ar, Float4 ai, Float4 br, Float4 bi, Float4 cr, Float4 ci, Float4 dr, Float4 di,
+                       Float4 v1r, Float4 v1i, Float4 v2r, Float4 v2i, Float4 v3r, Float4 v3i, Float4* o) {
+    const Float4 apcr = ar + cr, apci = ai + ci, amcr = ar - cr, amci = ai - ci;
+    const Float4 bpdr = br + dr, bpdi = bi + di, bmdr = br - dr, bmdi = bi - di;
+    const Float4 t1r = amcr + bmdi, t1i = amci - bmdr;
+    const Float4 t2r = apcr - bpdr, t2i = apci - bpdi;
+    const Float4 t3r = amcr - bmdi, t3i = amci + bmdr;
+    o[0] = apcr + bpdr;
+    o[1] = apci + bpdi;
+    o[2] = v1r * t1r - v1i * t1i;
+    o[3] = v1r * t1i + v1i * t1r;
+    o[4] = v2r * t2r - v2i * t2i;
+    o[5] = v2r * t2i + v2i * t2r;
+    o[6] = v3r * t3r - v3i * t3i;
+    o[7] = v3r * t3i + v3i * t3r;
+   };
+   Float4 o[8];
+   if (s == 1 && m >= 4) {
+    // First stage: lanes run over p, and the four outputs of each butterfly are adjacent, so
+    // one transpose per part turns four output registers into four contiguous stores.
+    for (; p + 4 <= m; p += 4) {
+     butterfly(Float4::load(xr + p), Float4::load(xi + p), Float4::load(xr + p + m), Float4::load(xi + p + m),
+               Float4::load(xr + p + 2 * m), Float4::load(xi + p + 2 * m),
+               Float4::load(xr + p + 3 * m), Float4::load(xi + p + 3 * m),
+               Float4::load(w1r + p), Float4::load(w1i + p), Float4::load(w2r + p), Float4::load(w2i + p),
+               Float4::load(w3r + p), Float4::load(w3i + p), o);
+     EU::SIMD::transpose(o[0], o[2], o[4], o[6]);
+     EU::SIMD::transpose(o[1], o[3], o[5], o[7]);
+     for (int k = 0; k < 4; ++k) {
+      o[2 * k].store(yr + 4 * (p + k));
+      o[2 * k + 1].store(yi + 4 * (p + k));
+     }
+    }
+   }
+   else if (s >= 4) {
+    // Later stages: lanes run over q with the twiddles of p broadcast.
+    for (; p < m; ++p) {
+     const Float4 v1r = Float4::set1(w1r[p]), v1i = Float4::set1(w1i[p]);
+     const Float4 v2r = Float4::set1(w2r[p]), v2i = Float4::set1(w2i[p]);
+     const Float4 v3r = Float4::set1(w3r[p]), v3i = Float4::set1(w3i[p]);
+     const float* x0r = xr + s * p;
+     const float* x0i = xi + s * p;
+     float* y0r = yr + 4 * s * p;
+     float* y0i = yi + 4 * s * p;
+     for (size_t q = 0; q < s; q += 4) {
+      butterfly(Float4::load(x0r + q), Float4::load(x0i + q), Float4::load(x0r + q + s * m), Float4::load(x0i + q + s * m),
+                Float4::load(x0r + q + 2 * s * m), Float4::load(x0i + q + 2 * s * m),
+                Float4::load(x0r + q + 3 * s * m), Float4::load(x0i + q + 3 * s * m),
+                v1r, v1i, v2r, v2i, v3r, v3i, o);
+      for (int k = 0; k < 4; ++k) {
+       o[2 * k].store(y0r + q + k * s);
+       o[2 * k + 1].store(y0i + q + k * s);
+      }
+     }
+    }
+   }
+#endif
+   for (; p < m; ++p) {
+    for (size_t q = 0; q < s; ++q) {
+     const size_t a = q + s * p;
+     const float apcr = xr[a] + xr[a + 2 * s * m], apci = xi[a] + xi[a + 2 * s * m];
+     const float amcr = xr[a] - xr[a + 2 * s * m], amci = xi[a] - xi[a + 2 * s * m];
+     const float bpdr = xr[a + s * m] + xr[a + 3 * s * m], bpdi = xi[a + s * m] + xi[a + 3 * s * m];
+     const float bmdr = xr[a + s * m] - xr[a + 3 * s * m], bmdi = xi[a + s * m] - xi[a + 3 * s * m];
+     const float t1r = amcr + bmdi, t1i = amci - bmdr;
+     const float t2r = apcr - bpdr, t2i = apci - bpdi;
+     const float t3r = amcr - bmdi, t3i = amci + bmdr;
+     const size_t y = q + 4 * s * p;
+     yr[y] = apcr + bpdr;
+     yi[y] = apci + bpdi;
+     yr[y + s] = w1r[p] * t1r - w1i[p] * t1i;
+     yi[y + s] = w1r[p] * t1i + w1i[p] * t1r;
+     yr[y + 2 * s] = w2r[p] * t2r - w2i[p] * t2i;
+     yi[y + 2 * s] = w2r[p] * t2i + w2i[p] * t2r;
+     yr[y + 3 * s] = w3r[p] * t3r - w3i[p] * t3i;
+     yi[y + 3 * s] = w3r[p] * t3i + w3i[p] * t3r;
+    }
+   }
+  }
+
+  /** @brief The closing radix-2 stage of length 2 and stride s: y[q] = x[q] + x[q + s], y[q + s] = x[q] - x[q + s]. */
+  inline void
+   fftRadix2(const float* xr, const float* xi, float* yr, float* yi, size_t s) {
+   size_t q = 0;
+#if defined(EU_SIMD_SSE2) || defined(EU_SIMD_NEON)
+   using EU::SIMD::Float4;
+   for (; q + 4 <= s; q += 4) {
+    const Float4 ar = Float4::load(xr + q), ai = Float4::load(xi + q);
+    const Float4 br = Float4::load(xr + q + s), bi = Float4::load(xi + q + s);
+    (ar + br).store(yr + q);
+    (ai + bi).store(yi + q);
+    (ar - br).store(yr + q + s);
+    (ai - bi).store(yi + q + s);
+   }
+#endif
+   for (; q < s; ++q) {
+    const float ar = xr[q], ai = xi[q], br = xr[q + s], bi = xi[q + s];
+    yr[q] = ar + br;
+    yi[q] = ai + bi;
+    yr[q + s] = ar - br;
+    yi[q + s] = ai - bi;
+   }
+  }
+ }
+
+ /**
+  * @class RealFFT
+  * @brief Forward and inverse FFT of power-of-two frames of real samples; see the file comment
+  * for the packed spectrum layout.
+  */
+ class
+  RealFFT {
+  public:
+  RealFFT() = default;
+
+  /** @brief Plan for frames of size samples; see init(). */
+  explicit RealFFT(size_t size) {
+   init(size);
+  }
+
+  /**
+   * @brief Plans for frames of size samples: the twiddles of every stage and the scratch arrays.
+   * @return false, leaving the plan empty, unless size is a power of two of at least 2.
+   */
+  bool
+   init(size_t size) {
+   m_size = 0;
+   m_stages = 0;
+   m_twiddles.clear();
+   if (size < 2 || (size & (size - 1)) != 0) return false;
+   const size_t half = size / 2;
+   std::vector<float> angles;
+   // Radix-4 stages from the full length down, storing w^p, w^2p, w^3p for each.
+   size_t n = half;
+   for (; n >= 4; n /= 4) {
+    const size_t m = n / 4;
+    const size_t base = m_twiddles.size();
+    m_twiddles.resize(base + 6 * m);
+    angles.resize(3 * m);
+    for (size_t k = 0; k < 3; ++k)
+     for (size_t p = 0; p < m; ++p)
+      angles[k * m + p] = -EU::Constants::TWO_PI * static_cast<float>((k + 1) * p) / static_cast<float>(n);
+    for (size_t k = 0; k < 3; ++k)
+     EngineMath::batch::sincos(angles.data() + k * m, m_twiddles.data() + base + (2 * k + 1) * m,
+                               m_twiddles.data() + base + 2 * k * m, m);
+    ++m_stages;
+   }
+   if (n == 2) ++m_stages;
+   // Separation twiddles w^k, w = e^(-2 PI i / size), for k in [0, size / 4].
+   m_split = m_twiddles.size();
+   const size_t quarter = half / 2 + 1;
+   m_twiddles.resize(m_split + 2 * quarter);
+   angles.resize(quarter);
+   for (size_t k = 0; k < quarter; ++k)
+    angles[k] = -EU::Constants::TWO_PI * static_cast<float>(k) / static_cast<float>(size);
+   EngineMath::batch::sincos(angles.data(), m_twiddles.data() + m_split + quarter, m_twiddles.data() + m_split, quarter);
+   m_scratch.assign(2 * size, 0.f);
+   m_size = size;
+   return true;
+  }
+
+  /**
+   * @brief Spectrum of size real samples, packed as the file comment describes. spectrum may be
+   * samples itself.
+   */
+  void
+   forward(const float* samples, float* spectrum) {
+   const size_t half = m_size / 2;
+   // With no complex stage (size 2) the samples go straight to the spectrum.
+   float* z = m_stages > 0 ? m_scratch.data() : spectrum;
+   for (size_t k = 0; k < half; ++k) {
+    z[k] = samples[2 * k];
+    z[half + k] = samples[2 * k + 1];
+   }
+   if (m_stages > 0) runStages(spectrum, false);
+   split(spectrum, spectrum + half);
+  }
+
+  /**
+   * @brief Samples of a packed spectrum, scaled by 1 / size so that inverse(forward(x)) is x.
+   * samples may be spectrum itself.
+   */
+  void
+   inverse(const float* spectrum, float* samples) {
+   const size_t half = m_size / 2;
+   float* a = m_scratch.data();
+   merge(spectrum, spectrum + half, a, a + half);
+   const float* z = runStages(nullptr, true);
+   for (size_t k = 0; k < half; ++k) {
+    samples[2 * k] = z[k];
+    samples[2 * k + 1] = z[half + k];
+   }
+  }
+
+  /** @brief Samples per frame; 0 before a successful init(). */
+  size_t
+   size() const {
+   return m_size;
+  }
+
+  /** @brief Distinct frequency bins, size / 2 + 1, of which bin k is k * sampleRate / size hertz. */
+  size_t
+   bins() const {
+   return m_size ? m_size / 2 + 1 : 0;
+  }
+
+  private:
+  /**
+   * @brief The complex FFT of length size / 2 of the first scratch array, real parts then
+   * imaginary parts, ping-ponging between the two scratch arrays. The last stage writes y, or
+   * when y is null whichever scratch array it does not read; either way the result is returned.
+   * The inverse runs the same stages with real and imaginary parts swapped.
+   */
+  float*
+   runStages(float* y, bool inverse) {
+   const size_t half = m_size / 2;
+   float* a = m_scratch.data();
+   float* b = a + m_size;
+   const size_t re = inverse ? half : 0, im = inverse ? 0 : half;
+   const float* tw = m_twiddles.data();
+   float* src = a;
+   size_t n = half, s = 1;
+   for (size_t stage = 0; stage < m_stages; ++stage) {
+    float* dst = stage + 1 == m_stages && y ? y : (src == a ? b : a);
+    if (n >= 4) {
+     detail::fftRadix4(src + re, src + im, dst + re, dst + im, n, s, tw);
+     tw += 6 * (n / 4);
+     n /= 4;
+     s *= 4;
+    }
+    else {
+     detail::fftRadix2(src + re, src + im, dst + re, dst + im, s);
+    }
+    src = dst;
+   }
+   return src;
+  }
+
+  /**
+   * @brief Turns the complex FFT Z of the even/odd sample pairs, in (re, im), into the packed
+   * real spectrum in place: X[k] = E + w^k O and X[h - k] = conj(E - w^k O), with
+   * E = (Z[k] + conj(Z[h - k])) / 2 and O = -i (Z[k] - conj(Z[h - k])) / 2.
+   */
+  void
+   split(float* re, float* im) const {
+   const size_t half = m_size / 2;
+   const size_t quarter = half / 2 + 1;
+   const float* wr = m_twiddles.data() + m_split;
+   const float* wi = wr + quarter;
+   const float z0r = re[0], z0i = im[0];
+   re[0] = z0r + z0i;
+   im[0] = z0r - z0i;
+   size_t k = 1;
+#if defined(EU_SIMD_SSE2) || defined(EU_SIMD_NEON)
+   using EU::SIMD::Float4;
+   const Float4 h = Float4::set1(0.5f);
+   // Lanes k .. k + 3 against the mirrored j = half - k - 3 .. half - k, until the blocks meet.
+   for (; 2 * k + 6 < half; k += 4) {
+    const size_t j = half - k - 3;
+    const Float4 ar = Float4::load(re + k), ai = Float4::load(im + k);
+    const Float4 br = EU::SIMD::shuffle<3, 2, 1, 0>(Float4::load(re + j));
+    const Float4 bi = EU::SIMD::shuffle<3, 2, 1, 0>(Float4::load(im + j));
+    const Float4 vr = Float4::load(wr + k), vi = Float4::load(wi + k);
+    const Float4 er = (ar + br) * h, ei = (ai - bi) * h;
+    const Float4 orr = (ai + bi) * h, oi = (br - ar) * h;
+    const Float4 tr = vr * orr - vi * oi, ti = vr * oi + vi * orr;
+    (er + tr).store(re + k);
+    (ei + ti).store(im + k);
+    EU::SIMD::shuffle<3, 2, 1, 0>(er - tr).store(re + j);
+    EU::SIMD::shuffle<3, 2, 1, 0>(ti - ei).store(im + j);
+   }
+#endif
+   for (; 2 * k <= half; ++k) {
+    const size_t j = half - k;
+    const float ar = re[k], ai = im[k], br = re[j], bi = im[j];
+    const float er = (ar + br) * 0.5f, ei = (ai - bi) * 0.5f;
+    const float orr = (ai + bi) * 0.5f, oi = (br - ar) * 0.5f;
+    const float tr = wr[k] * orr - wi[k] * oi, ti = wr[k] * oi + wi[k] * orr;
+    re[k] = er + tr;
+    im[k] = ei + ti;
+    if (j != k) {
+     re[j] = er - tr;
+     im[j] = ti - ei;
+    }
+   }
+  }
+
+  /**
+   * @brief Inverse of split() from the packed spectrum (re, im) into (zr, zi), with the 1 / size
+   * scale folded in: E = (X[k] + conj(X[h - k])) / 2, O = conj(w^k) (X[k] - conj(X[h - k])) / 2,
+   * Z[k] = E + i O and Z[h - k] = conj(E) + i conj(O).
+   */
+  void
+   merge(const float* re, const float* im, float* zr, float* zi) const {
+   const size_t half = m_size / 2;
+   const size_t quarter = half / 2 + 1;
+   const float* wr = m_twiddles.data() + m_split;
+   const float* wi = wr + quarter;
+   const float g = 1.f / static_cast<float>(m_size);
+   zr[0] = (re[0] + im[0]) * g;
+   zi[0] = (re[0] - im[0]) * g;
+   size_t k = 1;
+#if defined(EU_SIMD_SSE2) || defined(EU_SIMD_NEON)
+   using EU::SIMD::Float4;
+   const Float4 vg = Float4::set1(g);
+   for (; 2 * k + 6 < half; k += 4) {
+    const size_t j = half - k - 3;
+    const Float4 ar = Float4::load(re + k), ai = Float4::load(im + k);
+    const Float4 br = EU::SIMD::shuffle<3, 2, 1, 0>(Float4::load(re + j));
+    const Float4 bi = EU::SIMD::shuffle<3, 2, 1, 0>(Float4::load(im + j));
+    const Float4 vr = Float4::load(wr + k), vi = Float4::load(wi + k);
+    const Float4 er = (ar + br) * vg, ei = (ai - bi) * vg;
+    const Float4 tr = (ar - br) * vg, ti = (ai + bi) * vg;
+    const Float4 orr = vr * tr + vi * ti, oi = vr * ti - vi * tr;
+    (er - oi).store(zr + k);
+    (ei + orr).store(zi + k);
+    EU::SIMD::shuffle<3, 2, 1, 0>(er + oi).store(zr + j);
+    EU::SIMD::shuffle<3, 2, 1, 0>(orr - ei).store(zi + j);
+   }
+#endif
+   for (; 2 * k <= half; ++k) {
+    const size_t j = half - k;
+    const float ar = re[k], ai = im[k], br = re[j], bi = im[j];
+    const float er = (ar + br) * g, ei = (ai - bi) * g;
+    const float tr = (ar - br) * g, ti = (ai + bi) * g;
+    const float orr = wr[k] * tr + wi[k] * ti, oi = wr[k] * ti - wi[k] * tr;
+    zr[k] = er - oi;
+    zi[k] = ei + orr;
+    if (j != k) {
+     zr[j] = er + oi;
+     zi[j] = orr - ei;
+    }
+   }
+  }
+
+  size_t m_size = 0;
+  size_t m_stages = 0;             ///< Complex stages: radix-4, then radix-2 if log2(size / 2) is odd
+  size_t m_split = 0;              ///< Offset of the separation twiddles in m_twiddles
+  std::vector<float> m_twiddles;   ///< Per-stage w^p, w^2p, w^3p, then w^k for split()
+  std::vector<float> m_scratch;    ///< Two ping-pong arrays of size floats
+ };
+
+ /**
+  * @brief Power per bin of a packed spectrum of frame size size: power[k] = |X[k]|^2 for the
+  * size / 2 + 1 bins.
+  */
+ inline void
+  powerSpectrum(const float* spectrum, float* power, size_t size) {
+  const size_t half = size / 2;
+  const float* re = spectrum;
+  const float* im = spectrum + half;
+  power[0] = re[0] * re[0];
+  power[half] = im[0] * im[0];
+  size_t k = 1;
+#if defined(EU_SIMD_SSE2) || defined(EU_SIMD_NEON)
+  using EU::SIMD::Float4;
+  for (; k + 4 <= half; k += 4) {
+   const Float4 r = Float4::load(re + k), i = Float4::load(im + k);
+   (r * r + i * i).store(power + k);
+  }
+#endif
+  for (; k < half; ++k) power[k] = re[k] * re[k] + im[k] * im[k];
+ }
+
+ /** @brief Analysis / synthesis window shapes of makeWindow(). */
+ enum class WindowType {
+  Rectangular, ///< All ones
+  Hann,        ///< 0.5 - 0.5 cos; constant overlap-add at hops of size / 2
+  Hamming,     ///< 0.54 - 0.46 cos
+  Blackman     ///< 0.42 - 0.5 cos + 0.08 cos 2x
+ };
+
+ /**
+  * @brief Fills window[0..n) with a window. Periodic windows, the default, are the size n + 1
+  * window without its last sample, the form that sums evenly under overlap-add; symmetric ones
+  * end on the same value they start on, the form for filter design.
+  */
+ inline void
+  makeWindow(WindowType type, float* window, size_t n, bool periodic = true) {
+  const size_t span = periodic ? n : n - 1;
+  const float step = span > 0 ? EU::Constants::TWO_PI / static_cast<float>(span) : 0.f;
+  for (size_t i = 0; i < n; ++i) {
+   const float c = EngineMath::cos(step * static_cast<float>(i));
+   switch (type) {
+    case WindowType::Rectangular: window[i] = 1.f; break;
+    case WindowType::Hann: window[i] = 0.5f - 0.5f * c; break;
+    case WindowType::Hamming: window[i] = 0.54f - 0.46f * c; break;
+    case WindowType::Blackman: window[i] = 0.42f - 0.5f * c + 0.08f * (2.f * c * c - 1.f); break;
+   }
+  }
+ }
+
+ /**
+  * @brief Average of sum_k (window[i + k hop])^2 over i: the gain of a frame windowed twice,
+  * before the FFT and after the inverse, then overlap-added at hop. For Hann it is constant
+  * across i from a hop of size / 4 down.
+  */
+ inline float
+  overlapGain(const float* window, size_t n, size_t hop) {
+  float sum = 0.f;
+  for (size_t i = 0; i < n; ++i) sum += window[i] * window[i];
+  return sum / static_cast<float>(hop);
+ }
+
+ /** @brief out[i] = window[i] * in[i]; out may be in. */
+ inline void
+  applyWindow(const float* window, const float* in, float* out, size_t n) {
+  size_t i = 0;
+#if defined(EU_SIMD_SSE2) || defined(EU_SIMD_NEON)
+  using EU::SIMD::Float4;
+  for (const size_t body = n & ~size_t(3); i < body; i += 4) (Float4::load(window + i) * Float4::load(in + i)).store(out + i);
+#endif
+  for (; i < n; ++i) out[i] = window[i] * in[i];
+ }
+
+ /** @brief out[i] = window[i] * in[i] / 32768, windowing sf::Int16 samples on the way in. */
+ inline void
+  applyWindow(const float* window, const int16_t* in, float* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) out[i] = window[i] * (static_cast<float>(in[i]) * (1.f / 32768.f));
+ }
+
+ /** @brief out[i] = in[i] / 32768: sf::SoundRecorder samples to [-1, 1). */
+ inline void
+  int16ToFloat(const int16_t* in, float* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) out[i] = static_cast<float>(in[i]) * (1.f / 32768.f);
+ }
+
+ /** @brief out[i] = in[i] * 32768 rounded and saturated to the sf::Int16 range, for sf::SoundStream. */
+ inline void
+  floatToInt16(const float* in, int16_t* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+   const float v = std::min(std::max(in[i] * 32768.f, -32768.f), 32767.f);
+   out[i] = static_cast<int16_t>(v + (v >= 0.f ? 0.5f : -0.5f));
+  }
+ }
+
+ /**
+  * @class OverlapAdd
+  * @brief Sums frames of frameSize samples spaced hop apart and releases each hop of samples
+  * once no later frame can add to it.
+  */
+ class
+  OverlapAdd {
+  public:
+  OverlapAdd() = default;
+
+  /** @brief Accumulator for frameSize-sample frames at hop; hop is clamped to [1, frameSize]. */
+  OverlapAdd(size_t frameSize, size_t hop)
+   : m_hop(std::min(std::max<size_t>(hop, 1), frameSize)), m_sum(frameSize, 0.f) {}
+
+  /**
+   * @brief Adds frame[0..frameSize) at the current position and writes the hop samples now
+   * complete to out, then advances by hop. out may be frame.
+   */
+  void
+   push(const float* frame, float* out) {
+   const size_t n = m_sum.size();
+   float* sum = m_sum.data();
+   size_t i = 0;
+#if defined(EU_SIMD_SSE2) || defined(EU_SIMD_NEON)
+   using EU::SIMD::Float4;
+   for (const size_t body = n & ~size_t(3); i < body; i += 4) (Float4::load(sum + i) + Float4::load(frame + i)).store(sum + i);
+#endif
+   for (; i < n; ++i) sum[i] += frame[i];
+   std::memcpy(out, sum, m_hop * sizeof(float));
+   std::memmove(sum, sum + m_hop, (n - m_hop) * sizeof(float));
+   std::fill(sum + (n - m_hop), sum + n, 0.f);
+  }
+
+  /** @brief Drops the partial sums, as at the start of a stream. */
+  void
+   reset() {
+   std::fill(m_sum.begin(), m_sum.end(), 0.f);
+  }
+
+  size_t
+   frameSize() const {
+   return m_sum.size();
+  }
+
+  size_t
+   hop() const {
+   return m_hop;
+  }
+
+  private:
+  size_t m_hop = 0;
+  std::vector<float> m_sum; ///< Partial sums of the next frameSize samples
+ };
+
+ /**
+  * @brief Normalized biquad coefficients, y = b0 x + b1 x' + b2 x'' - a1 y' - a2 y''. The
+  * factories follow the RBJ audio EQ cookbook; frequencies are in hertz and must lie below
+  * sampleRate / 2.
+  */
+ struct Biquad {
+  float b0 = 1.f, b1 = 0.f, b2 = 0.f, a1 = 0.f, a2 = 0.f; ///< Defaults pass the input through
+
+  static Biquad
+   lowPass(float frequency, float sampleRate, float q = 0.70710678f) {
+   const Prototype p(frequency, sampleRate, q);
+   return normalized((1.f - p.c) * 0.5f, 1.f - p.c, (1.f - p.c) * 0.5f, 1.f + p.alpha, -2.f * p.c, 1.f - p.alpha);
+  }
+
+  static Biquad
+   highPass(float frequency, float sampleRate, float q = 0.70710678f) {
+   const Prototype p(frequency, sampleRate, q);
+   return normalized((1.f + p.c) * 0.5f, -(1.f + p.c), (1.f + p.c) * 0.5f, 1.f + p.alpha, -2.f * p.c, 1.f - p.alpha);
+  }
+
+  /** @brief Band pass with 0 dB gain at frequency, bandwidth set by q. */
+  static Biquad
+   bandPass(float frequency, float sampleRate, float q = 0.70710678f) {
+   const Prototype p(frequency, sampleRate, q);
+   return normalized(p.alpha, 0.f, -p.alpha, 1.f + p.alpha, -2.f * p.c, 1.f - p.alpha);
+  }
+
+  static Biquad
+   notch(float frequency, float sampleRate, float q = 0.70710678f) {
+   const Prototype p(frequency, sampleRate, q);
+   return normalized(1.f, -2.f * p.c, 1.f, 1.f + p.alpha, -2.f * p.c, 1.f - p.alpha);
+  }
+
+  /** @brief Bell of gainDb decibels at frequency. */
+  static Biquad
+   peaking(float frequency, float sampleRate, float q, float gainDb) {
+   const Prototype p(frequency, sampleRate, q);
+   const float a = amplitude(gainDb);
+   return normalized(1.f + p.alpha * a, -2.f * p.c, 1.f - p.alpha * a, 1.f + p.alpha / a, -2.f * p.c, 1.f - p.alpha / a);
+  }
+
+  /** @brief Shelf of gainDb decibels below frequency; q = 1/sqrt(2) is the steepest without overshoot. */
+  static Biquad
+   lowShelf(float frequency, float sampleRate, float gainDb, float q = 0.70710678f) {
+   const Prototype p(frequency, sampleRate, q);
+   const float a = amplitude(gainDb);
+   const float k = 2.f * EngineMath::sqrt(a) * p.alpha;
+   return normalized(a * ((a + 1.f) - (a - 1.f) * p.c + k), 2.f * a * ((a - 1.f) - (a + 1.f) * p.c),
+                     a * ((a + 1.f) - (a - 1.f) * p.c - k), (a + 1.f) + (a - 1.f) * p.c + k,
+                     -2.f * ((a - 1.f) + (a + 1.f) * p.c), (a + 1.f) + (a - 1.f) * p.c - k);
+  }
+
+  /** @brief Shelf of gainDb decibels above frequency. */
+  static Biquad
+   highShelf(float frequency, float sampleRate, float gainDb, float q = 0.70710678f) {
+   const Prototype p(frequency, sampleRate, q);
+   const float a = amplitude(gainDb);
+   const float k = 2.f * EngineMath::sqrt(a) * p.alpha;
+   return normalized(a * ((a + 1.f) + (a - 1.f) * p.c + k), -2.f * a * ((a - 1.f) + (a + 1.f) * p.c),
+                     a * ((a + 1.f) + (a - 1.f) * p.c - k), (a + 1.f) - (a - 1.f) * p.c + k,
+                     2.f * ((a - 1.f) - (a + 1.f) * p.c), (a + 1.f) - (a - 1.f) * p.c - k);
+  }
+
+  private:
+  /** Cookbook intermediates: cos w0 and alpha = sin w0 / 2Q. */
+  struct Prototype {
+   float c, alpha;
+   Prototype(float frequency, float sampleRate, float q) {
+    float s;
+    EngineMath::sincos(EU::Constants::TWO_PI * frequency / sampleRate, &s, &c);
+    alpha = s / (2.f * q);
+   }
+  };
+
+  /** 10^(gainDb / 40), the cookbook's A. */
+  static float
+   amplitude(float gainDb) {
+   return EngineMath::exp2(gainDb * 0.08304820f);
+  }
+
+  static Biquad
+   normalized(float b0, float b1, float b2, float a0, float a1, float a2) {
+   const float inv = 1.f / a0;
+   Biquad r;
+   r.b0 = b0 * inv;
+   r.b1 = b1 * inv;
+   r.b2 = b2 * inv;
+   r.a1 = a1 * inv;
+   r.a2 = a2 * inv;
+   return r;
+  }
+ };
+
+ /**
+  * @class BiquadBank
+  * @brief Independent biquads updated four per register, each with its own state.
+  */
+ class
+  BiquadBank {
+  public:
+  BiquadBank() = default;
+
+  /** @brief filters pass-through filters with cleared state. */
+  explicit BiquadBank(size_t filters) {
+   resize(filters);
+  }
+
+  /** @brief Sets the filter count; every filter is reset to pass-through with cleared state. */
+  void
+   resize(size_t filters) {
+   m_count = filters;
+   m_padded = (filters + 3) & ~size_t(3);
+   m_data.assign(ARRAYS * m_padded, 0.f);
+   for (size_t i = 0; i < filters; ++i) lane(B0)[i] = 1.f;
+  }
+
+  /** @brief Replaces filter i's coefficients, keeping its state so a sweep does not click. */
+  void
+   set(size_t i, const Biquad& filter) {
+   lane(B0)[i] = filter.b0;
+   lane(B1)[i] = filter.b1;
+   lane(B2)[i] = filter.b2;
+   lane(A1)[i] = filter.a1;
+   lane(A2)[i] = filter.a2;
+  }
+
+  /** @brief Clears every filter's state. */
+  void
+   reset() {
+   std::fill(lane(Z1), lane(Z1) + 2 * m_padded, 0.f);
+  }
+
+  size_t
+   size() const {
+   return m_count;
+  }
+
+  /**
+   * @brief Filter i runs on channel i of frames interleaved frames of size() channels, in to
+   * out; out may be in.
+   */
+  void
+   processChannels(const float* in, float* out, size_t frames) {
+   EU_TRACE_ZONE("BiquadBank::processChannels");
+   run<true>(in, out, nullptr, frames);
+  }
+
+  /**
+   * @brief Every filter runs on the same mono in[0..frames); out receives frames frames of
+   * size() outputs, filter i's sample t at out[t * size() + i].
+   */
+  void
+   processParallel(const float* in, float* out, size_t frames) {
+   EU_TRACE_ZONE("BiquadBank::processParallel");
+   run<false>(in, out, nullptr, frames);
+  }
+
+  /**
+   * @brief As processParallel() but keeping only each filter's output energy, the sum of its
+   * squared samples, in energy[0..size()): one band level per filter for a spectrum meter.
+   */
+  void
+   bandEnergy(const float* in, float* energy, size_t frames) {
+   EU_TRACE_ZONE("BiquadBank::bandEnergy");
+   run<false>(in, nullptr, energy, frames);
+  }
+
+  private:
+  enum Array { B0, B1, B2, A1, A2, Z1, Z2, ARRAYS };
+
+  float*
+   lane(Array a) {
+   return m_data.data() + a * m_padded;
+  }
+
+  /**
+   * @brief Four filters at a time across the whole buffer, keeping their state in registers.
+   * Channels reads lane inputs from the interleaved buffer, else broadcasts the mono sample;
+   * with energy set the outputs are squared and summed instead of stored.
+   */
+  template<bool Channels>
+  void
+   run(const float* in, float* out, float* energy, size_t frames) {
+   using EU::SIMD::Float4;
+   const size_t stride = m_count;
+   for (size_t g = 0; g < m_count; g += 4) {
+    const size_t lanes = std::min<size_t>(4, m_count - g);
+    const Float4 b0 = Float4::load(lane(B0) + g), b1 = Float4::load(lane(B1) + g), b2 = Float4::load(lane(B2) + g);
+    const Float4 a1 = Float4::load(lane(A1) + g), a2 = Float4::load(lane(A2) + g);
+    Float4 z1 = Float4::load(lane(Z1) + g), z2 = Float4::load(lane(Z2) + g);
+    Float4 sum = Float4::zero();
+    float tmp[4] = {};
+    for (size_t t = 0; t < frames; ++t) {
+     Float4 x;
+     if (Channels) {
+      if (lanes == 4) {
+       x = Float4::load(in + t * stride + g);
+      }
+      else {
+       for (size_t k = 0; k < lanes; ++k) tmp[k] = in[t * stride + g + k];
+       x = Float4::load(tmp);
+      }
+     }
+     else {
+      x = Float4::set1(in[t]);
+     }
+     const Float4 y = b0 * x + z1;
+     z1 = b1 * x - a1 * y + z2;
+     z2 = b2 * x - a2 * y;
+     if (energy) {
+      sum = sum + y * y;
+     }
+     else if (lanes == 4) {
+      y.store(out + t * stride + g);
+     }
+     else {
+      y.store(tmp);
+      for (size_t k = 0; k < lanes; ++k) out[t * stride + g + k] = tmp[k];
+     }
+    }
+    z1.store(lane(Z1) + g);
+    z2.store(lane(Z2) + g);
+    if (energy) {
+     sum.store(tmp);
+     for (size_t k = 0; k < lanes; ++k) energy[g + k] = tmp[k];
+    }
+   }
+  }
+
+  size_t m_count = 0;
+  size_t m_padded = 0;      ///< m_count rounded up to whole registers; padding lanes stay zero
+  std::vector<float> m_data; ///< ARRAYS arrays of m_padded floats: coefficients, then state
+ };
+}
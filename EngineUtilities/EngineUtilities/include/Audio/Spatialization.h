@@ -0,0 +1,239 @@
+/**
+ * @file Spatialization.h
+ * @brief Batch 3D audio spatialization: distance attenuation, cone gain, Doppler pitch and
+ * stereo pan of many sound sources for one listener, a register of sources at a time.
+ *
+ * spatializeSources() takes source positions, velocities and facing directions as SoA
+ * arrays and writes a gain, a pitch and a pan per source, in the formulas OpenAL applies
+ * behind sf::SoundSource: the inverse-clamped (SFML's), linear and exponent distance models
+ * with each source's minimum distance and attenuation, the inner/outer cone lerped by angle,
+ * and the Doppler shift from the velocities along the source-listener line, clamped to the
+ * speed of sound. The pan is the sine of the source's bearing: -1 fully left, 1 fully right.
+ * Distances come from the rsqrt kernel and the exponent model from the batch pow kernel.
+ *
+ * Sources whose final gain falls below SpatialSettings::cullGain are left out of the
+ * returned audible list, so the SFML calls (and a Sound per source at all) are only made
+ * for the few that can be heard:
+ *
+ *   const size_t count = spatializeSources(AudioListener::fromSfml(), sources, n, settings, out, audible);
+ *   for (size_t k = 0; k < count; ++k) {
+ *    const uint32_t i = audible[k];
+ *    applySpatialization(sounds[i], out.gains[i], out.pitches[i], out.pans[i]);
+ *   }
+ *
+ * applySpatialization() hands the result to SFML already worked out: the source is made
+ * relative to the listener, unattenuated, and placed on the unit circle at the pan angle,
+ * so OpenAL only pans it. Panning needs mono buffers. Needs sfml-audio at link time for
+ * applySpatialization() and AudioListener::fromSfml().
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <SFML/Audio/Listener.hpp>
+#include <SFML/Audio/SoundSource.hpp>
+#include <Core/Constants.h>
+#include <Core/SIMD.h>
+#include <Core/Trace.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Vectors/FloatScan.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+#include <Vectors/VectorSFML.h>
+
+namespace EU {
+ /** @brief How gain falls off between a source's minimum distance and maxDistance. */
+ enum class AttenuationModel {
+  Inverse,  ///< min / (min + attenuation * (d - min)), d clamped to [min, max]; SFML's
+  Linear,   ///< 1 - attenuation * (d - min) / (max - min), d clamped to [min, max]
+  Exponent  ///< (d / min)^-attenuation, d clamped to [min, max]
+ };
+
+ /** @brief Settings shared by every source of one spatializeSources() call. */
+ struct SpatialSettings {
+  AttenuationModel model = AttenuationModel::Inverse;
+  float maxDistance = EU::Constants::INF;  ///< Distances clamp here
+  float speedOfSound = 343.3f;             ///< World units per second
+  float dopplerFactor = 1.f;               ///< 0 disables the Doppler shift
+  float innerCone = EU::Constants::TWO_PI; ///< Full angle, radians, of the cone heard at full gain
+  float outerCone = EU::Constants::TWO_PI; ///< Full angle outside which outerGain applies
+  float outerGain = 0.f;
+  float cullGain = 1e-3f;                  ///< Sources with a final gain below are not audible
+ };
+
+ /** @brief Listener pose and velocity; forward and up need not be unit length. */
+ struct AudioListener {
+  CVector3 position;
+  CVector3 forward = CVector3(0.f, 0.f, -1.f);
+  CVector3 up = CVector3(0.f, 1.f, 0.f);
+  CVector3 velocity;
+
+  /** @brief The sf::Listener's pose; SFML keeps no listener velocity, so it is passed in. */
+  static AudioListener
+   fromSfml(const CVector3& velocity = CVector3()) {
+   AudioListener listener;
+   listener.position = sf::Listener::getPosition();
+   listener.forward = sf::Listener::getDirection();
+   listener.up = sf::Listener::getUpVector();
+   listener.velocity = velocity;
+   return listener;
+  }
+ };
+
+ /**
+  * @brief n sound sources, SoA. Optional arrays may be null: no velocity is at rest, no
+  * direction is omnidirectional, and a missing volume, pitch, minimum distance or
+  * attenuation is 1, SFML's default for each.
+  */
+ struct AudioSourcesSoA {
+  EngineMath::batch::ConstSoA3 positions;
+  EngineMath::batch::ConstSoA3 velocities = { nullptr, nullptr, nullptr };
+  EngineMath::batch::ConstSoA3 directions = { nullptr, nullptr, nullptr }; ///< Unit facing of directional sources
+  const float* volumes = nullptr;      ///< Gain before spatialization, 1 = full
+  const float* pitches = nullptr;      ///< Pitch before the Doppler shift
+  const float* minDistances = nullptr; ///< Must be > 0
+  const float* attenuations = nullptr;
+ };
+
+ /** @brief Per-source results; each array has room for n floats. */
+ struct SpatialOutput {
+  float* gains;
+  float* pitches;
+  float* pans;
+ };
+
+ namespace detail {
+  /** Lanes [i, i + count) of p, or fallback everywhere when p is null. */
+  inline BatchLanes
+   loadLanesOr(const float* p, size_t i, size_t count, BatchLanes fallback) {
+   return p ? loadLanes(p, i, count) : fallback;
+  }
+ }
+
+ /**
+  * @brief Spatializes sources[0..n) for listener into out and writes the indices of the
+  * audible ones, ascending, to audible (room for n).
+  * @return Number of audible sources.
+  */
+ inline size_t
+  spatializeSources(const AudioListener& listener, const AudioSourcesSoA& sources, size_t n,
+                    const SpatialSettings& settings, const SpatialOutput& out, uint32_t* audible) {
+  EU_TRACE_ZONE("spatializeSources");
+  using detail::BatchLanes;
+  namespace kernels = EngineMath::batch::kernels;
+  const BatchLanes zero = BatchLanes::zero(), one = BatchLanes::set1(1.f);
+  CVector3 right = listener.forward.cross(listener.up);
+  const float rightLength = right.length();
+  right = rightLength > 0.f ? right * (1.f / rightLength) : CVector3(1.f, 0.f, 0.f);
+
+  const BatchLanes lx = BatchLanes::set1(listener.position.x), ly = BatchLanes::set1(listener.position.y);
+  const BatchLanes lz = BatchLanes::set1(listener.position.z);
+  const BatchLanes rx = BatchLanes::set1(right.x), ry = BatchLanes::set1(right.y), rz = BatchLanes::set1(right.z);
+  const BatchLanes maxDistance = BatchLanes::set1(settings.maxDistance);
+  const BatchLanes cullGain = BatchLanes::set1(settings.cullGain);
+
+  const bool directional = sources.directions.x != nullptr;
+  const float innerHalf = settings.innerCone * 0.5f, outerHalf = settings.outerCone * 0.5f;
+  const BatchLanes inner = BatchLanes::set1(innerHalf), outer = BatchLanes::set1(outerHalf);
+  const BatchLanes coneScale = BatchLanes::set1(outerHalf > innerHalf ? (settings.outerGain - 1.f) / (outerHalf - innerHalf) : 0.f);
+  const BatchLanes outerGain = BatchLanes::set1(settings.outerGain);
+
+  // SS - DF * v with both velocities clamped to SS / DF, as OpenAL.
+  const bool doppler = settings.dopplerFactor > 0.f && settings.speedOfSound > 0.f &&
+                       (sources.velocities.x != nullptr || listener.velocity.lengthSquared() > 0.f);
+  const BatchLanes speedOfSound = BatchLanes::set1(settings.speedOfSound);
+  const BatchLanes dopplerFactor = BatchLanes::set1(settings.dopplerFactor);
+  const BatchLanes maxSpeed = BatchLanes::set1(doppler ? settings.speedOfSound / settings.dopplerFactor : 0.f);
+  const BatchLanes lvx = BatchLanes::set1(listener.velocity.x), lvy = BatchLanes::set1(listener.velocity.y);
+  const BatchLanes lvz = BatchLanes::set1(listener.velocity.z);
+
+  size_t found = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   // Listener to source; the distance and its inverse from one rsqrt, 0 at the listener.
+   const BatchLanes dx = detail::loadLanes(sources.positions.x, i, count) - lx;
+   const BatchLanes dy = detail::loadLanes(sources.positions.y, i, count) - ly;
+   const BatchLanes dz = detail::loadLanes(sources.positions.z, i, count) - lz;
+   const BatchLanes distSq = dx * dx + dy * dy + dz * dz;
+   const BatchLanes apart = distSq > BatchLanes::set1(1e-12f);
+   const BatchLanes inverse = kernels::rsqrt(EU::SIMD::select(apart, distSq, one)) & apart;
+   const BatchLanes distance = distSq * inverse;
+
+   const BatchLanes minDistance = detail::loadLanesOr(sources.minDistances, i, count, one);
+   const BatchLanes attenuation = detail::loadLanesOr(sources.attenuations, i, count, one);
+   const BatchLanes clamped = EU::SIMD::min(EU::SIMD::max(distance, minDistance), EU::SIMD::max(maxDistance, minDistance));
+   BatchLanes gain;
+   switch (settings.model) {
+   case AttenuationModel::Inverse: {
+    const BatchLanes denominator = EU::SIMD::madd(attenuation, clamped - minDistance, minDistance);
+    gain = EU::SIMD::select(denominator > zero, minDistance / EU::SIMD::select(denominator > zero, denominator, one), one);
+    break;
+   }
+   case AttenuationModel::Linear: {
+    const BatchLanes range = maxDistance - minDistance;
+    const BatchLanes fall = attenuation * (clamped - minDistance) / EU::SIMD::select(range > zero, range, one);
+    gain = EU::SIMD::min(one, EU::SIMD::max(zero, one - (fall & (range > zero))));
+    break;
+   }
+   default:
+    gain = kernels::pow(clamped / minDistance, zero - attenuation);
+    break;
+   }
+
+   if (directional) {
+    // Angle between the source's facing and the direction to the listener.
+    const BatchLanes facing = zero - (detail::loadLanes(sources.directions.x, i, count) * dx +
+                                      detail::loadLanes(sources.directions.y, i, count) * dy +
+                                      detail::loadLanes(sources.directions.z, i, count) * dz) * inverse;
+    const BatchLanes angle = kernels::acos(EU::SIMD::min(one, EU::SIMD::max(zero - one, facing)));
+    BatchLanes cone = EU::SIMD::madd(angle - inner, coneScale, one);
+    cone = EU::SIMD::select(angle <= inner, one, EU::SIMD::select(angle >= outer, outerGain, cone));
+    gain = gain * EU::SIMD::select(apart, cone, one);
+   }
+   gain = gain * detail::loadLanesOr(sources.volumes, i, count, one);
+
+   BatchLanes pitch = detail::loadLanesOr(sources.pitches, i, count, one);
+   if (doppler) {
+    // Speeds along source -> listener, positive when moving towards the other's side.
+    BatchLanes listenerSpeed = zero - (lvx * dx + lvy * dy + lvz * dz) * inverse;
+    BatchLanes sourceSpeed = zero;
+    if (sources.velocities.x) {
+     sourceSpeed = zero - (detail::loadLanes(sources.velocities.x, i, count) * dx +
+                           detail::loadLanes(sources.velocities.y, i, count) * dy +
+                           detail::loadLanes(sources.velocities.z, i, count) * dz) * inverse;
+    }
+    listenerSpeed = EU::SIMD::min(listenerSpeed, maxSpeed);
+    sourceSpeed = EU::SIMD::min(sourceSpeed, maxSpeed);
+    const BatchLanes heard = speedOfSound - dopplerFactor * listenerSpeed;
+    const BatchLanes emitted = speedOfSound - dopplerFactor * sourceSpeed;
+    pitch = pitch * EU::SIMD::select(emitted > zero, heard / EU::SIMD::select(emitted > zero, emitted, one), one);
+   }
+
+   const BatchLanes pan = EU::SIMD::min(one, EU::SIMD::max(zero - one, (dx * rx + dy * ry + dz * rz) * inverse));
+   detail::storeLanes(gain, out.gains, i, count);
+   detail::storeLanes(pitch, out.pitches, i, count);
+   detail::storeLanes(pan, out.pans, i, count);
+   found = detail::appendLanes(gain >= cullGain, count, static_cast<uint32_t>(i), audible, found);
+  }
+  EU_TRACE_COUNTER("audible sources", found);
+  EU_CHECK_FLOATS("spatialized gains", out.gains, n);
+  EU_CHECK_FLOATS("spatialized pitches", out.pitches, n);
+  return found;
+ }
+
+ /**
+  * @brief Applies one spatializeSources() result to source: volume gain * 100, the pitch,
+  * and a listener-relative unattenuated position at the pan angle in front of the
+  * listener, so OpenAL does no spatialization of its own.
+  */
+ inline void
+  applySpatialization(sf::SoundSource& source, float gain, float pitch, float pan) {
+  source.setRelativeToListener(true);
+  source.setAttenuation(0.f);
+  source.setVolume(gain < 1.f ? gain * 100.f : 100.f);
+  source.setPitch(pitch);
+  source.setPosition(pan, 0.f, -EngineMath::sqrt(1.f - pan * pan));
+ }
+}
@@ -0,0 +1,602 @@
+/**
+ * @file AssetStream.h
+ * @brief Prioritized, cancellable asset streaming: chains of IO, CPU and main-thread steps on
+ * an IO thread, the JobSystem and a per-frame main-thread budget.
+ *
+ * A request is a StreamJob, a chain of steps that each run where they belong: Io steps (file
+ * reads, or page touches of a mapped pack) on the streamer's IO thread, Cpu steps
+ * (decompression, decoding into SoA buffers) as JobSystem jobs, and Main steps (GPU staging,
+ * anything that needs the render context) inside update() on the main thread. A step returns
+ * false to fail the request. Steps share state through whatever their closures capture,
+ * usually one shared_ptr per asset.
+ *
+ * The IO thread only reads, so it moves on to the next file while the workers decode the
+ * previous ones and IO and decode overlap. Every queue hands out the highest-priority
+ * request first (ties in submission order), priorities can change while a request waits,
+ * and at most StreamSettings::maxInFlight requests are past their first step at once, which
+ * bounds the memory held by read but not yet decoded data.
+ *
+ * update(budget) is the only work the streamer does on the main thread: Main steps and the
+ * completion callbacks, highest priority first, until budget milliseconds are used. The
+ * budget is checked before every item, so a frame overshoots it by at most one step; keep
+ * Main steps short (an upload of a few hundred KB) and do the rest in Cpu steps. With a
+ * one-thread JobSystem there are no workers, and update() runs Cpu steps too, in the same
+ * budget.
+ *
+ * cancel() drops a waiting request at once; a running step finishes first and the rest of
+ * the chain is skipped. Either way the completion callback sees StreamStatus::Cancelled.
+ * Long steps can poll cancelled() to stop early. Completion callbacks run in update() and
+ * the request is forgotten after them, so status() returns StreamStatus::Unknown from then
+ * on. Destroying the streamer cancels everything, waits for running steps and drops the
+ * pending callbacks.
+ *
+ * With C++20 (EU_HAS_COROUTINES) a request can also be a coroutine returning StreamTask,
+ * where co_await streamOn(stage) moves the rest of the body onto that stage's thread:
+ *
+ *   StreamTask loadMesh(std::shared_ptr<MeshAsset> mesh) {
+ *    co_await streamOn(StreamStage::Io);
+ *    if (!readFile(mesh->path.c_str(), mesh->bytes)) co_return false;
+ *    co_await streamOn(StreamStage::Cpu);
+ *    if (!decodeMesh(mesh->bytes, mesh->positions)) co_return false;   // into a Vector3Stream
+ *    co_await streamOn(StreamStage::Main);
+ *    co_return uploadMesh(*mesh);
+ *   }
+ *   const StreamId id = streamer.submit(loadMesh(mesh), priority);
+ *
+ * The same request as a StreamJob, which needs nothing newer than C++14:
+ *
+ *   StreamJob job;
+ *   job.io([=] { return readFile(mesh->path.c_str(), mesh->bytes); })
+ *      .cpu([=] { return decodeMesh(mesh->bytes, mesh->positions); })
+ *      .main([=] { return uploadMesh(*mesh); })
+ *      .done([=](StreamStatus status) { mesh->ready = status == StreamStatus::Done; });
+ *   const StreamId id = streamer.submit(std::move(job), priority);
+ *   ...
+ *   streamer.update(2.0);                                               // once per frame
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <Core/FlatHashMap.h>
+#include <Core/JobSystem.h>
+#include <Core/PackFile.h>
+#include <Core/Platform.h>
+#include <Core/Trace.h>
+#if defined(EU_HAS_COROUTINES)
+ #include <coroutine>
+#endif
+
+namespace EU {
+ /// Stride touchPages() reads at; the smallest page size of the supported systems.
+ constexpr size_t STREAM_PAGE_SIZE = 4096;
+
+ /** @brief Where a step of a stream request runs. */
+ enum class StreamStage : uint8_t {
+  Io,  ///< The streamer's IO thread
+  Cpu, ///< A JobSystem worker
+  Main ///< The main thread, inside AssetStreamer::update()
+ };
+
+ /** @brief State of a stream request. */
+ enum class StreamStatus : uint8_t {
+  Unknown,  ///< No such request, or its completion has been delivered
+  Queued,   ///< Waiting for its next step to start
+  Running,  ///< A step is running
+  Done,     ///< Every step succeeded
+  Failed,   ///< A step returned false
+  Cancelled ///< cancel() was called before the last step finished
+ };
+
+ /// Identifies a request; never 0, never reused by one streamer.
+ using StreamId = uint64_t;
+
+ /**
+  * @struct StreamSettings
+  * @brief Limits of an AssetStreamer.
+  */
+ struct StreamSettings {
+  size_t maxInFlight = 32; ///< Requests past their first step at once; 0 means no limit
+ };
+
+ /** @brief Reads path into out, replacing its contents; false if it cannot be read. */
+ inline bool
+  readFile(const char* path, std::vector<unsigned char>& out) {
+  out.clear();
+  FILE* file = std::fopen(path, "rb");
+  if (!file) return false;
+  bool ok = std::fseek(file, 0, SEEK_END) == 0;
+  const long size = ok ? std::ftell(file) : -1;
+  ok = size >= 0 && std::fseek(file, 0, SEEK_SET) == 0;
+  if (ok) {
+   out.resize(static_cast<size_t>(size));
+   ok = std::fread(out.data(), 1, out.size(), file) == out.size();
+  }
+  std::fclose(file);
+  if (!ok) out.clear();
+  return ok;
+ }
+
+ /**
+  * @brief Reads one byte of every page of [data, data + size), so a mapped file is paged in
+  * by the caller (an Io step) rather than by whoever decodes it. Returns the pages touched.
+  */
+ inline size_t
+  touchPages(const void* data, size_t size) {
+  const volatile unsigned char* bytes = static_cast<const unsigned char*>(data);
+  size_t pages = 0;
+  unsigned char sink = 0;
+  for (size_t offset = 0; offset < size; offset += STREAM_PAGE_SIZE, ++pages) sink ^= bytes[offset];
+  if (size) sink ^= bytes[size - 1];
+  (void)sink;
+  return pages;
+ }
+
+ /** @brief touchPages() over the section tag/id of pack; false when there is no such section. */
+ inline bool
+  prefetchSection(const PackView& pack, uint32_t tag, uint32_t id) {
+  const PackSection* section = pack.find(tag, id);
+  if (!section) return false;
+  touchPages(pack.data(*section), static_cast<size_t>(section->size));
+  return true;
+ }
+
+ /**
+  * @class StreamJob
+  * @brief The steps of one stream request, in order, and its completion callback.
+  */
+ class
+  StreamJob {
+  public:
+  using Step = std::function<bool()>;
+  using Done = std::function<void(StreamStatus)>;
+
+  /** @brief One step and where it runs. */
+  struct Entry {
+   StreamStage stage;
+   Step run;
+  };
+
+  /** @brief Appends a step run on the IO thread. */
+  StreamJob&
+   io(Step step) {
+   return then(StreamStage::Io, std::move(step));
+  }
+
+  /** @brief Appends a step run on a JobSystem worker. */
+  StreamJob&
+   cpu(Step step) {
+   return then(StreamStage::Cpu, std::move(step));
+  }
+
+  /** @brief Appends a step run in AssetStreamer::update() on the main thread. */
+  StreamJob&
+   main(Step step) {
+   return then(StreamStage::Main, std::move(step));
+  }
+
+  /** @brief Appends a step run on stage. */
+  StreamJob&
+   then(StreamStage stage, Step step) {
+   m_steps.push_back({ stage, std::move(step) });
+   return *this;
+  }
+
+  /** @brief Called in AssetStreamer::update() once the request has finished, however it did. */
+  StreamJob&
+   done(Done callback) {
+   m_done = std::move(callback);
+   return *this;
+  }
+
+  private:
+  friend class AssetStreamer;
+
+  std::vector<Entry> m_steps;
+  Done m_done;
+ };
+
+#if defined(EU_HAS_COROUTINES)
+ class StreamTask;
+#endif
+
+ namespace detail {
+  /** A submitted request. Its steps are only touched by the thread running it. */
+  struct StreamRequest {
+   StreamId id = 0;
+   int priority = 0;
+   StreamStatus status = StreamStatus::Queued;
+   bool started = false;            ///< Past its first step; counts against maxInFlight
+   std::atomic<bool> cancel{ false };
+   std::vector<StreamJob::Entry> steps;
+   size_t next = 0;                 ///< Step to run next
+   StreamJob::Done done;
+   std::function<void()> release;   ///< Destroys a coroutine frame
+#if defined(EU_HAS_COROUTINES)
+   bool coroutineResult = true;     ///< co_return value of a StreamTask
+#endif
+
+   ~StreamRequest() {
+    if (release) release();
+   }
+  };
+ }
+
+ /**
+  * @class AssetStreamer
+  * @brief Runs stream requests on an IO thread, a JobSystem and the main thread.
+  */
+ class
+  AssetStreamer {
+  public:
+  /**
+   * @brief Streamer on jobs, which must outlive it. Construct and update() it on the thread
+   * that owns jobs (worker 0).
+   */
+  explicit AssetStreamer(JobSystem& jobs, const StreamSettings& settings = StreamSettings())
+   : m_jobs(jobs), m_settings(settings), m_nextId(1), m_inFlight(0), m_stop(false) {
+   m_io = std::thread([this]() { ioLoop(); });
+  }
+
+  AssetStreamer(const AssetStreamer&) = delete;
+  AssetStreamer& operator=(const AssetStreamer&) = delete;
+
+  ~AssetStreamer() {
+   {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+    m_requests.forEach([](const StreamId&, std::unique_ptr<detail::StreamRequest>& r) { r->cancel = true; });
+   }
+   m_ioWake.notify_all();
+   m_io.join();
+   m_jobs.wait(m_cpuJobs);
+  }
+
+  /** @brief Queues job at priority (higher runs first); returns its id. */
+  StreamId
+   submit(StreamJob job, int priority = 0) {
+   std::unique_ptr<detail::StreamRequest> request(new detail::StreamRequest());
+   request->priority = priority;
+   request->steps = std::move(job.m_steps);
+   request->done = std::move(job.m_done);
+   return add(std::move(request));
+  }
+
+#if defined(EU_HAS_COROUTINES)
+  /**
+   * @brief Queues a coroutine at priority. Its body runs up to the first co_await inside
+   * this call; completion reports Done or Failed by the co_return value.
+   */
+  inline StreamId submit(StreamTask task, int priority = 0, StreamJob::Done done = StreamJob::Done());
+#endif
+
+  /** @brief Cancels id; false if it is unknown or has already finished. */
+  bool
+   cancel(StreamId id) {
+   size_t launches = 0;
+   {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    detail::StreamRequest* r = find(id);
+    if (!r || r->status > StreamStatus::Running) return false;
+    r->cancel = true;
+    if (r->status == StreamStatus::Queued) {
+     std::vector<detail::StreamRequest*>& queue = m_ready[static_cast<size_t>(r->steps[r->next].stage)];
+     for (size_t i = 0; i < queue.size(); ++i) {
+      if (queue[i] != r) continue;
+      queue[i] = queue.back();
+      queue.pop_back();
+      break;
+     }
+     // A started request frees its maxInFlight slot, which may unblock a Cpu one.
+     launches = finish(r, StreamStatus::Cancelled);
+    }
+   }
+   launch(launches);
+   return true;
+  }
+
+  /** @brief True once cancel(id) was called, or when id is unknown; thread-safe, for long steps. */
+  bool
+   cancelled(StreamId id) const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   const detail::StreamRequest* r = find(id);
+   return !r || r->cancel;
+  }
+
+  /** @brief Changes the priority of id's next steps; false if it is unknown. */
+  bool
+   setPriority(StreamId id, int priority) {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   detail::StreamRequest* r = find(id);
+   if (!r) return false;
+   r->priority = priority;
+   return true;
+  }
+
+  StreamStatus
+   status(StreamId id) const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   const detail::StreamRequest* r = find(id);
+   return r ? r->status : StreamStatus::Unknown;
+  }
+
+  /** @brief Requests submitted whose completion has not been delivered yet. */
+  size_t
+   pending() const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   return m_requests.size();
+  }
+
+  /**
+   * @brief Runs Main steps and completion callbacks (and Cpu steps, with a one-thread
+   * JobSystem) until budgetMs milliseconds have passed or nothing is left.
+   * @return Steps and callbacks run.
+   */
+  size_t
+   update(double budgetMs) {
+   EU_TRACE_ZONE("AssetStreamer::update");
+   using Clock = std::chrono::steady_clock;
+   const Clock::time_point start = Clock::now();
+   const bool inlineCpu = m_jobs.threadCount() <= 1;
+   size_t ran = 0;
+   while (std::chrono::duration<double, std::milli>(Clock::now() - start).count() < budgetMs) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (detail::StreamRequest* r = pop(StreamStage::Main)) {
+     lock.unlock();
+     step(r);
+    }
+    else if (!m_finished.empty()) {
+     detail::StreamRequest* done = m_finished.front();
+     m_finished.erase(m_finished.begin());
+     std::unique_ptr<detail::StreamRequest> owned = std::move(m_requests[done->id]);
+     m_requests.erase(done->id);
+     lock.unlock();
+     if (owned->done) owned->done(owned->status);
+    }
+    else if (inlineCpu && (r = pop(StreamStage::Cpu)) != nullptr) {
+     lock.unlock();
+     step(r);
+    }
+    else break;
+    ++ran;
+   }
+   EU_TRACE_COUNTER("Streams pending", pending());
+   return ran;
+  }
+
+  private:
+  using Queue = std::vector<detail::StreamRequest*>;
+
+  detail::StreamRequest*
+   find(StreamId id) const {
+   const std::unique_ptr<detail::StreamRequest>* r = m_requests.find(id);
+   return r ? r->get() : nullptr;
+  }
+
+  StreamId
+   add(std::unique_ptr<detail::StreamRequest> request) {
+   size_t launches = 0;
+   StreamId id;
+   {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    id = m_nextId++;
+    request->id = id;
+    detail::StreamRequest* r = request.get();
+    m_requests.insert(id, std::move(request));
+    launches = enqueue(r);
+   }
+   launch(launches);
+   return id;
+  }
+
+  /**
+   * Puts r on the queue of its next step, or finishes it when there is none or it was
+   * cancelled. Returns the Cpu jobs to launch once the lock is released.
+   */
+  size_t
+   enqueue(detail::StreamRequest* r) {
+   if (r->cancel) return finish(r, StreamStatus::Cancelled);
+   if (r->next == r->steps.size()) {
+#if defined(EU_HAS_COROUTINES)
+    if (!r->coroutineResult) return finish(r, StreamStatus::Failed);
+#endif
+    return finish(r, StreamStatus::Done);
+   }
+   r->status = StreamStatus::Queued;
+   const StreamStage stage = r->steps[r->next].stage;
+   m_ready[static_cast<size_t>(stage)].push_back(r);
+   if (stage == StreamStage::Io) m_ioWake.notify_one();
+   return stage == StreamStage::Cpu ? 1 : 0;
+  }
+
+  /** Hands r's completion to update(). Returns the Cpu jobs to launch for requests it unblocks. */
+  size_t
+   finish(detail::StreamRequest* r, StreamStatus status) {
+   r->status = status;
+   m_finished.push_back(r);
+   if (!r->started) return 0;
+   r->started = false;
+   --m_inFlight;
+   // A slot opened: requests held back by maxInFlight may start now.
+   m_ioWake.notify_one();
+   return m_ready[static_cast<size_t>(StreamStage::Cpu)].empty() ? 0 : 1;
+  }
+
+  /** Removes and returns the request to run next on stage, or nullptr. */
+  detail::StreamRequest*
+   pop(StreamStage stage) {
+   Queue& queue = m_ready[static_cast<size_t>(stage)];
+   const bool full = m_settings.maxInFlight && m_inFlight >= m_settings.maxInFlight;
+   size_t best = queue.size();
+   for (size_t i = 0; i < queue.size(); ++i) {
+    const detail::StreamRequest* r = queue[i];
+    if (full && !r->started) continue;
+    if (best == queue.size() || r->priority > queue[best]->priority ||
+        (r->priority == queue[best]->priority && r->id < queue[best]->id)) best = i;
+   }
+   if (best == queue.size()) return nullptr;
+   detail::StreamRequest* r = queue[best];
+   queue.erase(queue.begin() + static_cast<std::ptrdiff_t>(best));
+   r->status = StreamStatus::Running;
+   if (!r->started) {
+    r->started = true;
+    ++m_inFlight;
+   }
+   return r;
+  }
+
+  /** Runs the next step of r, popped by this thread, and moves r on; cancelled requests skip it. */
+  void
+   step(detail::StreamRequest* r) {
+   // Taken out first: a StreamTask step appends to steps while it runs.
+   const StreamJob::Step run = std::move(r->steps[r->next].run);
+   const bool ok = !r->cancel && run();
+   size_t launches;
+   {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (ok) {
+     ++r->next;
+     launches = enqueue(r);
+    }
+    else {
+     launches = finish(r, r->cancel ? StreamStatus::Cancelled : StreamStatus::Failed);
+    }
+   }
+   launch(launches);
+  }
+
+  /** Submits count jobs that each drain the Cpu queue. */
+  void
+   launch(size_t count) {
+   if (m_jobs.threadCount() <= 1) return;
+   for (size_t i = 0; i < count; ++i) {
+    m_jobs.run([this]() {
+     for (;;) {
+      detail::StreamRequest* r;
+      {
+       std::lock_guard<std::mutex> lock(m_mutex);
+       r = pop(StreamStage::Cpu);
+      }
+      if (!r) return;
+      step(r);
+     }
+    }, m_cpuJobs);
+   }
+  }
+
+  void
+   ioLoop() {
+   EU_TRACE_THREAD_NAME("Stream IO");
+   std::unique_lock<std::mutex> lock(m_mutex);
+   for (;;) {
+    detail::StreamRequest* r = nullptr;
+    m_ioWake.wait(lock, [&]() { return m_stop || (r = pop(StreamStage::Io)) != nullptr; });
+    if (!r) return;
+    lock.unlock();
+    {
+     EU_TRACE_ZONE("Stream IO step");
+     step(r);
+    }
+    lock.lock();
+   }
+  }
+
+  JobSystem& m_jobs;
+  StreamSettings m_settings;
+  mutable std::mutex m_mutex;                 ///< Guards everything below but the IO thread itself
+  std::condition_variable m_ioWake;
+  FlatHashMap<StreamId, std::unique_ptr<detail::StreamRequest>> m_requests;
+  Queue m_ready[3];                           ///< Per StreamStage, unordered; pop() picks by priority
+  Queue m_finished;                           ///< Completions for update(), in finishing order
+  StreamId m_nextId;
+  size_t m_inFlight;
+  bool m_stop;
+  JobCounter m_cpuJobs;
+  std::thread m_io;
+ };
+
+#if defined(EU_HAS_COROUTINES)
+ /**
+  * @class StreamTask
+  * @brief Coroutine type of a stream request; co_return true on success, false on failure.
+  */
+ class
+  StreamTask {
+  public:
+  struct promise_type {
+   detail::StreamRequest* request = nullptr;
+   bool result = true;
+
+   StreamTask get_return_object() { return StreamTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+   std::suspend_always initial_suspend() noexcept { return {}; }
+   std::suspend_always final_suspend() noexcept { return {}; }
+   void return_value(bool ok) { result = ok; }
+   void unhandled_exception() { result = false; }
+  };
+
+  StreamTask(StreamTask&& other) noexcept : m_handle(other.m_handle) { other.m_handle = nullptr; }
+  StreamTask(const StreamTask&) = delete;
+  StreamTask& operator=(const StreamTask&) = delete;
+
+  ~StreamTask() {
+   if (m_handle) m_handle.destroy();
+  }
+
+  private:
+  friend class AssetStreamer;
+
+  explicit StreamTask(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+  std::coroutine_handle<promise_type> m_handle;
+ };
+
+ /** @brief Awaitable that continues a StreamTask as its next step, on stage. */
+ struct StreamSwitch {
+  StreamStage stage;
+
+  bool await_ready() const noexcept { return false; }
+  void await_resume() const noexcept {}
+
+  void
+   await_suspend(std::coroutine_handle<StreamTask::promise_type> handle) const {
+   detail::StreamRequest* request = handle.promise().request;
+   request->steps.push_back({ stage, [handle, request]() {
+    handle.resume();
+    // Suspended again: that co_await queued the next step. Finished: report the result.
+    if (handle.done()) request->coroutineResult = handle.promise().result;
+    return true;
+   } });
+  }
+ };
+
+ /** @brief co_await streamOn(stage) runs the rest of a StreamTask, up to its next co_await, on stage. */
+ inline StreamSwitch
+  streamOn(StreamStage stage) {
+  return StreamSwitch{ stage };
+ }
+
+ inline StreamId
+  AssetStreamer::submit(StreamTask task, int priority, StreamJob::Done done) {
+  std::unique_ptr<detail::StreamRequest> request(new detail::StreamRequest());
+  const std::coroutine_handle<StreamTask::promise_type> handle = task.m_handle;
+  task.m_handle = nullptr;
+  request->priority = priority;
+  request->done = std::move(done);
+  request->release = [handle]() { handle.destroy(); };
+  handle.promise().request = request.get();
+  handle.resume();
+  if (handle.done()) request->coroutineResult = handle.promise().result;
+  return add(std::move(request));
+ }
+#endif
+}
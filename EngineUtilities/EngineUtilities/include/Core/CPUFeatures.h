@@ -0,0 +1,127 @@
+/**
+ * @file CPUFeatures.h
+ * @brief Run-time detection of the instruction sets of the CPU the program is running on.
+ *
+ * SIMD.h answers what the compiler was allowed to emit; cpuFeatures() answers what this
+ * machine can execute, which is what Dispatch.h needs to pick a kernel table. On x86 it reads
+ * CPUID and, for the AVX family, checks through XGETBV that the OS saves the wider registers
+ * on context switches. ARM builds report NEON when they were compiled for it, since AArch64
+ * always has it.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+ #define EU_CPU_X86 1
+ #if defined(_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <cpuid.h>
+ #endif
+#endif
+
+namespace EU {
+ /**
+  * @brief Instruction sets the running CPU and OS support.
+  */
+ struct CpuFeatures {
+  bool sse2 = false;
+  bool sse41 = false;
+  bool avx = false;
+  bool avx2 = false;
+  bool fma = false;
+  bool f16c = false;
+  bool bmi2 = false;
+  bool avx512f = false;
+  bool neon = false;
+ };
+
+ /**
+  * @brief Kernel builds Dispatch.h can choose between, in ascending order.
+  *
+  * Baseline is whatever the project's own flags allow (SSE2 on x64, NEON on AArch64). AVX2
+  * also covers FMA, F16C and BMI2, which every AVX2 CPU has. AVX-512 machines run the AVX2
+  * tier: the math layer has no 16-lane register type.
+  */
+ enum class CpuTier : uint8_t {
+  Baseline = 0,
+  SSE41 = 1,
+  AVX2 = 2,
+ };
+
+ namespace detail {
+#if defined(EU_CPU_X86)
+  inline void
+   cpuid(uint32_t leaf, uint32_t sub, uint32_t regs[4]) {
+ #if defined(_MSC_VER)
+   int r[4];
+   __cpuidex(r, static_cast<int>(leaf), static_cast<int>(sub));
+   for (int i = 0; i < 4; ++i) regs[i] = static_cast<uint32_t>(r[i]);
+ #else
+   __cpuid_count(leaf, sub, regs[0], regs[1], regs[2], regs[3]);
+ #endif
+  }
+
+  /** XCR0: which register states the OS saves. */
+  inline uint64_t
+   xgetbv0() {
+ #if defined(_MSC_VER)
+   return _xgetbv(0);
+ #else
+   uint32_t lo, hi;
+   __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+   return (static_cast<uint64_t>(hi) << 32) | lo;
+ #endif
+  }
+#endif
+
+  inline CpuFeatures
+   detectCpuFeatures() {
+   CpuFeatures f;
+#if defined(EU_CPU_X86)
+   uint32_t r[4];
+   cpuid(0, 0, r);
+   const uint32_t maxLeaf = r[0];
+   if (maxLeaf < 1) return f;
+   cpuid(1, 0, r);
+   f.sse2 = (r[3] & (1u << 26)) != 0;
+   f.sse41 = (r[2] & (1u << 19)) != 0;
+   const bool osxsave = (r[2] & (1u << 27)) != 0;
+   const uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+   // XMM and YMM state (bits 1, 2); AVX-512 adds opmask and both ZMM halves (bits 5-7).
+   const bool ymm = (xcr0 & 0x6) == 0x6;
+   const bool zmm = (xcr0 & 0xe6) == 0xe6;
+   f.avx = ymm && (r[2] & (1u << 28)) != 0;
+   f.fma = f.avx && (r[2] & (1u << 12)) != 0;
+   f.f16c = f.avx && (r[2] & (1u << 29)) != 0;
+   if (maxLeaf >= 7) {
+    cpuid(7, 0, r);
+    f.avx2 = f.avx && (r[1] & (1u << 5)) != 0;
+    f.bmi2 = (r[1] & (1u << 8)) != 0;
+    f.avx512f = zmm && (r[1] & (1u << 16)) != 0;
+   }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+   f.neon = true;
+#endif
+   return f;
+  }
+ }
+
+ /** @brief Features of the running CPU, detected on the first call. */
+ inline const CpuFeatures&
+  cpuFeatures() {
+  static const CpuFeatures features = detail::detectCpuFeatures();
+  return features;
+ }
+
+ /** @brief Highest CpuTier the running CPU supports. */
+ inline CpuTier
+  cpuTier() {
+  const CpuFeatures& f = cpuFeatures();
+  if (f.avx2 && f.fma && f.f16c && f.bmi2) return CpuTier::AVX2;
+  if (f.sse41) return CpuTier::SSE41;
+  return CpuTier::Baseline;
+ }
+}
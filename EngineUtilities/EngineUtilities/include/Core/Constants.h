@@ -33,6 +33,15 @@ namespace EU {
   /// Radian to degree conversion
   constexpr float RAD_TO_DEG = 180.0f / PI;
 
+  /// Euler's number
+  constexpr float E = 2.71828182845904523536f;
+
+  /// Natural logarithm of 2
+  constexpr float LN_2 = 0.693147180559945309417f;
+
+  /// Base-2 logarithm of e (1 / LN_2)
+  constexpr float LOG2_E = 1.44269504088896340736f;
+
   /// Small tolerance value used in float comparisons
   constexpr float EPSILON = 1e-6f;
 
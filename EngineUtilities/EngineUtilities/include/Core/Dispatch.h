@@ -0,0 +1,180 @@
+/**
+ * @file Dispatch.h
+ * @brief Run-time selection of the batch kernels built for the best instruction set the CPU
+ * supports, so one binary runs SSE2, SSE4.1 or AVX2 code depending on the machine.
+ *
+ * The headers pick their SIMD path from the compiler flags, so a single build only ever uses
+ * one. Dispatch adds three translation units (src/Dispatch/Kernels*.cpp) that compile the
+ * trig, normalize, transform, culling and skinning kernels again under their own ISA flags
+ * and publish them as a KernelTable. On the first call kernels() reads cpuFeatures() and binds
+ * the highest tier that was really compiled and that the CPU supports; every function below
+ * then makes one indirect call into it per array. The header versions stay available and are
+ * still the right choice for code built for a known target.
+ *
+ * Define EU_DISPATCH_STATS to count which tier each call ran on (see DispatchStats.h).
+ *
+ * Tiers can change rounding: the AVX2 build contracts to FMA where the baseline does not, so
+ * results may differ in the last bit between machines unless EU_REPRODUCIBLE is defined.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <Core/CPUFeatures.h>
+#include <Core/DispatchStats.h>
+#include <Core/KernelTable.h>
+#include <Core/Trace.h>
+#include <Geometry/Frustum.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/Matrix4x4.h>
+#include <Matrices/Skinning.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ namespace Dispatch {
+  namespace detail {
+   inline std::atomic<const KernelTable*>&
+    activeTable() {
+    static std::atomic<const KernelTable*> table(nullptr);
+    return table;
+   }
+
+   /** Highest compiled table at or below maxTier; the lowest compiled one if none is. */
+   inline const KernelTable&
+    bestTable(CpuTier maxTier) {
+    const KernelTable* tables[] = { &kernelTableAVX2(), &kernelTableSSE41(), &kernelTableBaseline() };
+    const KernelTable* lowest = tables[0];
+    for (const KernelTable* table : tables) {
+     if (table->tier <= maxTier) return *table;
+     if (table->tier < lowest->tier) lowest = table;
+    }
+    // Even the baseline unit was built above this CPU, so nothing in the program can run.
+    return *lowest;
+   }
+  }
+
+  /** @brief The table in use, chosen from cpuTier() on the first call. */
+  inline const KernelTable&
+   kernels() {
+   const KernelTable* table = detail::activeTable().load(std::memory_order_acquire);
+   if (table == nullptr) {
+    table = &detail::bestTable(cpuTier());
+    detail::activeTable().store(table, std::memory_order_release);
+   }
+   return *table;
+  }
+
+  /**
+   * @brief Rebinds to the best table at or below maxTier, e.g. to compare tiers on one
+   * machine; tiers above cpuTier() are never chosen. Returns the table now in use.
+   */
+  inline const KernelTable&
+   selectKernels(CpuTier maxTier) {
+   const KernelTable& table = detail::bestTable(maxTier < cpuTier() ? maxTier : cpuTier());
+   detail::activeTable().store(&table, std::memory_order_release);
+   return table;
+  }
+
+  /** @brief EngineMath::batch::sin(). */
+  inline void
+   sin(const float* in, float* out, size_t n) {
+   const KernelTable& table = kernels();
+   EU_DISPATCH_COUNT(Sin, table, n, in, out);
+   table.sin(in, out, n);
+  }
+
+  /** @brief EngineMath::batch::cos(). */
+  inline void
+   cos(const float* in, float* out, size_t n) {
+   const KernelTable& table = kernels();
+   EU_DISPATCH_COUNT(Cos, table, n, in, out);
+   table.cos(in, out, n);
+  }
+
+  /** @brief EngineMath::batch::sincos(). */
+  inline void
+   sincos(const float* in, float* s, float* c, size_t n) {
+   const KernelTable& table = kernels();
+   EU_DISPATCH_COUNT(SinCos, table, n, in, s, c);
+   table.sincos(in, s, c, n);
+  }
+
+  /** @brief EU::normalizeArray() with the default precision tier. */
+  inline void
+   normalizeArray(const CVector3* in, CVector3* out, size_t n) {
+   const KernelTable& table = kernels();
+   EU_DISPATCH_COUNT(Normalize3, table, n, in, out);
+   table.normalize3(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n);
+  }
+
+  /** @brief SoA EU::normalizeArray() with the default precision tier. */
+  inline void
+   normalizeArray(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n) {
+   const KernelTable& table = kernels();
+   EU_DISPATCH_COUNT(Normalize3SoA, table, n, in.x, in.y, in.z, out.x, out.y, out.z);
+   table.normalize3SoA(in.x, in.y, in.z, out.x, out.y, out.z, n);
+  }
+
+  /** @brief EU::transformPoints() by an affine Matrix4x4. */
+  inline void
+   transformPoints(const CVector3* in, CVector3* out, size_t n, const Matrix4x4& matrix) {
+   const KernelTable& table = kernels();
+   EU_DISPATCH_COUNT(TransformPoints, table, n, in, out);
+   table.transformPoints(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n, &matrix.m[0][0]);
+  }
+
+  /** @brief EU::cullSpheres(), split over threads the same way. */
+  inline size_t
+   cullSpheres(const Frustum& frustum, EngineMath::batch::ConstSoA3 centers, const float* radii, size_t n,
+               uint32_t* visible, size_t threads = 0) {
+   EU_TRACE_ZONE("Dispatch::cullSpheres");
+   const KernelTable& table = kernels();
+   EU_DISPATCH_COUNT(CullSpheres, table, n, centers.x, centers.y, centers.z, radii);
+   const float* planes = &frustum.planes[0][0];
+   return EU::detail::cullChunks(n, threads, visible, [&](size_t begin, size_t end, uint32_t* out) {
+    return table.cullSpheres(planes, centers.x, centers.y, centers.z, radii, begin, end, out);
+   });
+  }
+
+  /** @brief EU::cullBoxes(), split over threads the same way. */
+  inline size_t
+   cullBoxes(const Frustum& frustum, EngineMath::batch::ConstSoA3 lo, EngineMath::batch::ConstSoA3 hi, size_t n,
+             uint32_t* visible, size_t threads = 0) {
+   EU_TRACE_ZONE("Dispatch::cullBoxes");
+   const KernelTable& table = kernels();
+   EU_DISPATCH_COUNT(CullBoxes, table, n, lo.x, lo.y, lo.z, hi.x, hi.y, hi.z);
+   const float* planes = &frustum.planes[0][0];
+   return EU::detail::cullChunks(n, threads, visible, [&](size_t begin, size_t end, uint32_t* out) {
+    return table.cullBoxes(planes, lo.x, lo.y, lo.z, hi.x, hi.y, hi.z, begin, end, out);
+   });
+  }
+
+  /** @brief EU::skinPositions() with an Affine3x4 palette. */
+  inline void
+   skinPositions(const CVector3* in, CVector3* out, size_t n, const BoneInfluences* influences,
+                 const Affine3x4* palette, AABB* bounds = nullptr) {
+   const KernelTable& table = kernels();
+   EU_DISPATCH_COUNT(SkinPositions, table, n, in, out);
+   float box[6];
+   table.skinPositions(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n, influences,
+                       &palette[0].m[0][0], bounds ? box : nullptr);
+   if (bounds) *bounds = AABB(CVector3(box[0], box[1], box[2]), CVector3(box[3], box[4], box[5]));
+  }
+
+  /** @brief EU::skinVertices() with an Affine3x4 palette and the default precision tier. */
+  inline void
+   skinVertices(const CVector3* positions, const CVector3* normals, CVector3* outPositions, CVector3* outNormals,
+                size_t n, const BoneInfluences* influences, const Affine3x4* palette, AABB* bounds = nullptr) {
+   const KernelTable& table = kernels();
+   EU_DISPATCH_COUNT(SkinVertices, table, n, positions, normals, outPositions, outNormals);
+   float box[6];
+   table.skinVertices(reinterpret_cast<const float*>(positions), reinterpret_cast<const float*>(normals),
+                      reinterpret_cast<float*>(outPositions), reinterpret_cast<float*>(outNormals), n, influences,
+                      &palette[0].m[0][0], bounds ? box : nullptr);
+   if (bounds) *bounds = AABB(CVector3(box[0], box[1], box[2]), CVector3(box[3], box[4], box[5]));
+  }
+ }
+}
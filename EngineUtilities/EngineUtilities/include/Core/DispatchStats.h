@@ -0,0 +1,317 @@
+/**
+ * @file DispatchStats.h
+ * @brief Counters of which tier every Dispatch call ran on: calls, elements and inputs not
+ * aligned to that tier's register width, per kernel, summed over all threads.
+ *
+ * The counting only happens when EU_DISPATCH_STATS is defined; otherwise EU_DISPATCH_COUNT
+ * expands to nothing and the queries below report zeros, so normal builds pay nothing. With
+ * it on, each thread bumps its own block of counters, created on its first Dispatch call and
+ * kept until exit: two relaxed loads and stores of cache lines no other thread writes, no
+ * locks. dispatchStats() sums the blocks under the registry lock, so it may run while other
+ * threads count; each counter is exact, a call counted concurrently may show up in calls
+ * before elements.
+ *
+ * Paths are the table a call went through: Scalar is the baseline unit when it was built
+ * without SSE2 or NEON, the others are the tiers of Dispatch.h. Dispatch loads are all
+ * unaligned, so a misaligned input takes the same code, but on AVX2 every other register
+ * straddles a cache line; a large misaligned count next to AVX2 is the cliff to look for.
+ *
+ *   setDispatchStatsHook([](const DispatchStats& delta, void*) { telemetry.send(formatDispatchStats(delta)); },
+ *                        nullptr, 10.0);
+ *   ...
+ *   pollDispatchStats(); // once a frame; calls the hook with the last ten seconds' counts
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <Core/KernelTable.h>
+
+namespace EU {
+ namespace Dispatch {
+  /** @brief Entry points of KernelTable, in table order. */
+  enum class DispatchKernel : uint8_t {
+   Sin,
+   Cos,
+   SinCos,
+   Normalize3,
+   Normalize3SoA,
+   TransformPoints,
+   CullSpheres,
+   CullBoxes,
+   SkinPositions,
+   SkinVertices,
+   Count,
+  };
+
+  /** @brief Code a call actually ran. */
+  enum class DispatchPath : uint8_t {
+   Scalar,
+   Baseline,
+   SSE41,
+   AVX2,
+   Count,
+  };
+
+  constexpr size_t DISPATCH_KERNELS = static_cast<size_t>(DispatchKernel::Count);
+  constexpr size_t DISPATCH_PATHS = static_cast<size_t>(DispatchPath::Count);
+
+  inline const char*
+   dispatchKernelName(DispatchKernel kernel) {
+   static const char* const names[] = { "sin", "cos", "sincos", "normalize3", "normalize3SoA", "transformPoints",
+                                        "cullSpheres", "cullBoxes", "skinPositions", "skinVertices" };
+   return kernel < DispatchKernel::Count ? names[static_cast<size_t>(kernel)] : "?";
+  }
+
+  inline const char*
+   dispatchPathName(DispatchPath path) {
+   static const char* const names[] = { "Scalar", "Baseline", "SSE4.1", "AVX2" };
+   return path < DispatchPath::Count ? names[static_cast<size_t>(path)] : "?";
+  }
+
+  /** @brief Path of a table. */
+  inline DispatchPath
+   dispatchPath(const KernelTable& table) {
+   if (!table.simd) return DispatchPath::Scalar;
+   return table.tier == CpuTier::AVX2 ? DispatchPath::AVX2
+        : table.tier == CpuTier::SSE41 ? DispatchPath::SSE41 : DispatchPath::Baseline;
+  }
+
+  /** @brief Counts of one kernel on one path. */
+  struct DispatchCounter {
+   uint64_t calls = 0;
+   uint64_t elements = 0;   ///< Sum of n over the calls
+   uint64_t misaligned = 0; ///< Calls with an array not aligned to the path's register width
+  };
+
+  /** @brief Every kernel on every path, plus the wall time the counts cover. */
+  struct DispatchStats {
+   DispatchCounter counters[DISPATCH_KERNELS][DISPATCH_PATHS];
+   double seconds = 0.0;
+
+   const DispatchCounter&
+    at(DispatchKernel kernel, DispatchPath path) const {
+    return counters[static_cast<size_t>(kernel)][static_cast<size_t>(path)];
+   }
+
+   /** @brief kernel over all paths. */
+   DispatchCounter
+    total(DispatchKernel kernel) const {
+    DispatchCounter sum;
+    for (const DispatchCounter& c : counters[static_cast<size_t>(kernel)]) {
+     sum.calls += c.calls;
+     sum.elements += c.elements;
+     sum.misaligned += c.misaligned;
+    }
+    return sum;
+   }
+  };
+
+  /** @brief Receives the counts since the previous call; see setDispatchStatsHook(). */
+  using DispatchStatsHook = void (*)(const DispatchStats& delta, void* user);
+
+  namespace detail {
+   enum : size_t {
+    DISPATCH_CALLS,
+    DISPATCH_ELEMENTS,
+    DISPATCH_MISALIGNED,
+    DISPATCH_FIELDS,
+   };
+
+   /** Single-writer counters of one thread. */
+   struct DispatchStatsBlock {
+    std::atomic<uint64_t> values[DISPATCH_KERNELS][DISPATCH_PATHS][DISPATCH_FIELDS];
+
+    DispatchStatsBlock() {
+     for (auto& kernel : values)
+      for (auto& path : kernel)
+       for (std::atomic<uint64_t>& value : path) value.store(0, std::memory_order_relaxed);
+    }
+   };
+
+   struct DispatchStatsRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<DispatchStatsBlock>> blocks;
+    DispatchStats base;     ///< Totals at the last resetDispatchStats()
+    DispatchStats lastDump; ///< Totals at the last hook call
+    std::chrono::steady_clock::time_point baseTime = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point dumpTime = baseTime;
+    DispatchStatsHook hook = nullptr;
+    void* user = nullptr;
+    double interval = 0.0;
+   };
+
+   inline DispatchStatsRegistry&
+    dispatchStatsRegistry() {
+    static DispatchStatsRegistry registry;
+    return registry;
+   }
+
+   inline DispatchStatsBlock&
+    dispatchStatsBlock() {
+    static thread_local DispatchStatsBlock* block = nullptr;
+    if (block == nullptr) {
+     DispatchStatsRegistry& registry = dispatchStatsRegistry();
+     std::lock_guard<std::mutex> lock(registry.mutex);
+     registry.blocks.emplace_back(new DispatchStatsBlock());
+     block = registry.blocks.back().get();
+    }
+    return *block;
+   }
+
+   inline void
+    bumpDispatchStat(std::atomic<uint64_t>& value, uint64_t amount) {
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+   }
+
+   /** Counts one call of kernel through table over n elements, with the arrays it touched. */
+   inline void
+    countDispatch(DispatchKernel kernel, const KernelTable& table, size_t n, std::initializer_list<const void*> arrays) {
+    const DispatchPath path = dispatchPath(table);
+    const uintptr_t mask = path == DispatchPath::AVX2 ? 31 : path == DispatchPath::Scalar ? 0 : 15;
+    bool misaligned = false;
+    for (const void* p : arrays) misaligned |= (reinterpret_cast<uintptr_t>(p) & mask) != 0;
+    std::atomic<uint64_t>(&values)[DISPATCH_FIELDS] =
+     dispatchStatsBlock().values[static_cast<size_t>(kernel)][static_cast<size_t>(path)];
+    bumpDispatchStat(values[DISPATCH_CALLS], 1);
+    bumpDispatchStat(values[DISPATCH_ELEMENTS], n);
+    if (misaligned) bumpDispatchStat(values[DISPATCH_MISALIGNED], 1);
+   }
+
+   /** Sum of every block; call with the registry locked. */
+   inline DispatchStats
+    dispatchTotals(const DispatchStatsRegistry& registry) {
+    DispatchStats sum;
+    for (const std::unique_ptr<DispatchStatsBlock>& block : registry.blocks) {
+     for (size_t k = 0; k < DISPATCH_KERNELS; ++k) {
+      for (size_t p = 0; p < DISPATCH_PATHS; ++p) {
+       const std::atomic<uint64_t>(&values)[DISPATCH_FIELDS] = block->values[k][p];
+       sum.counters[k][p].calls += values[DISPATCH_CALLS].load(std::memory_order_relaxed);
+       sum.counters[k][p].elements += values[DISPATCH_ELEMENTS].load(std::memory_order_relaxed);
+       sum.counters[k][p].misaligned += values[DISPATCH_MISALIGNED].load(std::memory_order_relaxed);
+      }
+     }
+    }
+    return sum;
+   }
+
+   inline DispatchStats
+    dispatchDelta(const DispatchStats& now, const DispatchStats& since, double seconds) {
+    DispatchStats delta;
+    for (size_t k = 0; k < DISPATCH_KERNELS; ++k) {
+     for (size_t p = 0; p < DISPATCH_PATHS; ++p) {
+      delta.counters[k][p].calls = now.counters[k][p].calls - since.counters[k][p].calls;
+      delta.counters[k][p].elements = now.counters[k][p].elements - since.counters[k][p].elements;
+      delta.counters[k][p].misaligned = now.counters[k][p].misaligned - since.counters[k][p].misaligned;
+     }
+    }
+    delta.seconds = seconds;
+    return delta;
+   }
+
+   inline double
+    secondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double>(to - from).count();
+   }
+  }
+
+  /** @brief Counts since program start or the last resetDispatchStats(). */
+  inline DispatchStats
+   dispatchStats() {
+   detail::DispatchStatsRegistry& registry = detail::dispatchStatsRegistry();
+   std::lock_guard<std::mutex> lock(registry.mutex);
+   return detail::dispatchDelta(detail::dispatchTotals(registry), registry.base,
+                                detail::secondsBetween(registry.baseTime, std::chrono::steady_clock::now()));
+  }
+
+  /** @brief Starts dispatchStats() from zero again; the hook's deltas are unaffected. */
+  inline void
+   resetDispatchStats() {
+   detail::DispatchStatsRegistry& registry = detail::dispatchStatsRegistry();
+   std::lock_guard<std::mutex> lock(registry.mutex);
+   registry.base = detail::dispatchTotals(registry);
+   registry.baseTime = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * @brief One line per kernel and path that ran, e.g.
+   * "sincos AVX2 calls=120 elements=491520 misaligned=0"; empty when nothing did.
+   */
+  inline std::string
+   formatDispatchStats(const DispatchStats& stats) {
+   std::string out;
+   char line[160];
+   for (size_t k = 0; k < DISPATCH_KERNELS; ++k) {
+    for (size_t p = 0; p < DISPATCH_PATHS; ++p) {
+     const DispatchCounter& c = stats.counters[k][p];
+     if (c.calls == 0) continue;
+     std::snprintf(line, sizeof(line), "%s %s calls=%llu elements=%llu misaligned=%llu\n",
+                   dispatchKernelName(static_cast<DispatchKernel>(k)), dispatchPathName(static_cast<DispatchPath>(p)),
+                   static_cast<unsigned long long>(c.calls), static_cast<unsigned long long>(c.elements),
+                   static_cast<unsigned long long>(c.misaligned));
+     out += line;
+    }
+   }
+   return out;
+  }
+
+  /**
+   * @brief Installs hook to receive the counts of every intervalSeconds, delivered from
+   * pollDispatchStats(); nullptr removes it. The first delta starts now.
+   */
+  inline void
+   setDispatchStatsHook(DispatchStatsHook hook, void* user, double intervalSeconds) {
+   detail::DispatchStatsRegistry& registry = detail::dispatchStatsRegistry();
+   std::lock_guard<std::mutex> lock(registry.mutex);
+   registry.hook = hook;
+   registry.user = user;
+   registry.interval = intervalSeconds;
+   registry.lastDump = detail::dispatchTotals(registry);
+   registry.dumpTime = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * @brief Calls the hook with the counts since its previous call once the interval has
+   * passed; meant for once a frame. The hook runs on the calling thread without the registry
+   * locked, so it may query. Returns whether it ran.
+   */
+  inline bool
+   pollDispatchStats() {
+   detail::DispatchStatsRegistry& registry = detail::dispatchStatsRegistry();
+   DispatchStats delta;
+   DispatchStatsHook hook = nullptr;
+   void* user = nullptr;
+   {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    const auto now = std::chrono::steady_clock::now();
+    const double elapsed = detail::secondsBetween(registry.dumpTime, now);
+    if (registry.hook == nullptr || elapsed < registry.interval) return false;
+    const DispatchStats totals = detail::dispatchTotals(registry);
+    delta = detail::dispatchDelta(totals, registry.lastDump, elapsed);
+    registry.lastDump = totals;
+    registry.dumpTime = now;
+    hook = registry.hook;
+    user = registry.user;
+   }
+   hook(delta, user);
+   return true;
+  }
+ }
+}
+
+#if defined(EU_DISPATCH_STATS)
+ /// Counts one call of kernel (a DispatchKernel) through table over n elements of the listed arrays.
+ #define EU_DISPATCH_COUNT(kernel, table, n, ...) \
+  ::EU::Dispatch::detail::countDispatch(::EU::Dispatch::DispatchKernel::kernel, table, n, { __VA_ARGS__ })
+#else
+ #define EU_DISPATCH_COUNT(kernel, table, n, ...) ((void)0)
+#endif
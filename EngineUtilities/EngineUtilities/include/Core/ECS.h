@@ -0,0 +1,750 @@
+/**
+ * @file ECS.h
+ * @brief Archetype entity-component storage: components of entities with the same set of
+ * types live in 16 KB chunks as SIMD-aligned SoA columns, iterated and processed in parallel
+ * a chunk at a time.
+ *
+ * An archetype is one set of component types. Each archetype owns chunks of ECS_CHUNK_SIZE
+ * bytes holding as many of its entities as fit, one column per component, every column
+ * starting on a cache line. Components made of floats (ComponentLanes<T> > 0) are split
+ * further into one float array per lane, so a chunk's Position column is an
+ * EngineMath::batch::SoA3 and its Rotation column a QuaternionSoA: the layout the batch
+ * kernels of this library read a register of entities at a time, with no gather first.
+ * Other components (WorldTransform, user types) are stored as plain arrays. Chunks are kept
+ * full except the last one of each archetype; destroying an entity moves the last entity of
+ * the archetype into its row.
+ *
+ * Adding or removing a component moves the entity to the archetype of the new set, copying
+ * the components both have. Archetypes are found through a map from the component mask and
+ * then through per-archetype edges, so repeated moves of the same kind do not hash. Entity
+ * handles carry a generation, so a handle whose entity was destroyed stops resolving even
+ * after its index is reused.
+ *
+ * An EntityQuery names the components an archetype must have and those it must not. It
+ * remembers the archetypes it matched and only tests the archetypes created since it was last
+ * used, so iterating is a walk over a short list of chunks. forEachChunk() calls fn with a
+ * ChunkView per non-empty chunk; given a JobSystem it runs the chunks across the workers,
+ * one job per chunk. Chunks share no rows, so a system may write any column of the chunk it
+ * is handed; it must not touch other chunks or change the world's structure (create,
+ * destroy, add, remove) while iterating.
+ *
+ *   EntityWorld world;
+ *   world.create(Position(p), Rotation(q), Scale(s), WorldTransform());
+ *   EntityQuery query = EntityQuery::of<Position, Rotation, Scale, WorldTransform>();
+ *   world.forEachChunk(query, jobs, [](const ChunkView& chunk) {
+ *    poseToAffineArray({ chunk.column<Position>(), chunk.column<Rotation>(), chunk.column<Scale>() },
+ *                      chunk.column<WorldTransform>(), chunk.size());
+ *   });
+ *
+ * At most ECS_MAX_COMPONENTS component types may be used per program; create() and add()
+ * refuse types past the limit. Components must be trivially copyable.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <Core/FlatHashMap.h>
+#include <Core/JobSystem.h>
+#include <Core/Trace.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/PoseBlend.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /// Bytes per archetype chunk; archetypes whose single entity is larger get chunks of one.
+ constexpr size_t ECS_CHUNK_SIZE = 16384;
+ /// Distinct component types a program may use; one bit each in an archetype mask.
+ constexpr uint32_t ECS_MAX_COMPONENTS = 64;
+ constexpr uint32_t ECS_NONE = 0xffffffffu;
+
+ /**
+  * @brief Number of floats a component is split into, one SoA column each; 0 stores it as
+  * an array of T. Specialize for float-only components to get SoA columns.
+  */
+ template<typename T>
+ struct ComponentLanes : std::integral_constant<uint32_t, 0> {};
+
+ /** @brief World-space position; a SoA3 column. */
+ struct Position : CVector3 {
+  Position() = default;
+  Position(const CVector3& v) : CVector3(v) {}
+ };
+
+ /** @brief Orientation; a QuaternionSoA column. */
+ struct Rotation : Quaternion {
+  Rotation() = default;
+  Rotation(const Quaternion& q) : Quaternion(q) {}
+ };
+
+ /** @brief Per-axis scale, 1 by default; a SoA3 column. */
+ struct Scale : CVector3 {
+  Scale() : CVector3(1.f, 1.f, 1.f) {}
+  Scale(const CVector3& v) : CVector3(v) {}
+ };
+
+ /**
+  * @brief World transform, e.g. poseToAffineArray() of Position, Rotation and Scale; an
+  * array whose column passes as Affine3x4*.
+  */
+ struct WorldTransform : Affine3x4 {
+  WorldTransform() = default;
+  WorldTransform(const Affine3x4& m) : Affine3x4(m) {}
+ };
+
+ template<> struct ComponentLanes<Position> : std::integral_constant<uint32_t, 3> {};
+ template<> struct ComponentLanes<Rotation> : std::integral_constant<uint32_t, 4> {};
+ template<> struct ComponentLanes<Scale> : std::integral_constant<uint32_t, 3> {};
+
+ namespace detail {
+  /** What a chunk needs to know of a component type to lay out and copy its column. */
+  struct ComponentInfo {
+   uint32_t size = 0;
+   uint32_t lanes = 0;
+  };
+
+  inline ComponentInfo*
+   componentInfos() {
+   static ComponentInfo infos[ECS_MAX_COMPONENTS];
+   return infos;
+  }
+
+  inline uint32_t
+   registerComponent(uint32_t size, uint32_t lanes) {
+   static std::atomic<uint32_t> next(0);
+   const uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+   if (id < ECS_MAX_COMPONENTS) componentInfos()[id] = { size, lanes };
+   return id;
+  }
+
+  /** Column view of a component with Lanes float lanes. */
+  template<uint32_t Lanes, typename T> struct ComponentColumnOf { using type = T*; };
+  template<typename T> struct ComponentColumnOf<1, T> { using type = float*; };
+  template<typename T> struct ComponentColumnOf<2, T> { using type = EngineMath::batch::SoA2; };
+  template<typename T> struct ComponentColumnOf<3, T> { using type = EngineMath::batch::SoA3; };
+  template<typename T> struct ComponentColumnOf<4, T> { using type = QuaternionSoA; };
+
+  inline size_t
+   alignColumn(size_t bytes) {
+   return (bytes + 63) & ~size_t(63);
+  }
+ }
+
+ /**
+  * @brief Program-wide id of component type T, assigned on first use; ECS_MAX_COMPONENTS or
+  * more once the limit is exhausted.
+  */
+ template<typename T>
+ inline uint32_t
+  componentId() {
+  static_assert(std::is_trivially_copyable<T>::value, "components are copied bytewise");
+  static_assert(ComponentLanes<T>::value == 0 || sizeof(T) == ComponentLanes<T>::value * sizeof(float),
+                "a split component must be exactly its float lanes");
+  static const uint32_t id = detail::registerComponent(static_cast<uint32_t>(sizeof(T)), ComponentLanes<T>::value);
+  return id;
+ }
+
+ /** @brief SoA3, QuaternionSoA, float* or T*: how ChunkView::column<T>() hands out T. */
+ template<typename T>
+ using ComponentColumn = typename detail::ComponentColumnOf<ComponentLanes<T>::value, T>::type;
+
+ /** @brief Index and generation of an entity; the default handle refers to nothing. */
+ struct Entity {
+  uint32_t index = ECS_NONE;
+  uint32_t generation = 0;
+
+  bool
+   valid() const {
+   return index != ECS_NONE;
+  }
+
+  bool
+   operator==(const Entity& other) const {
+   return index == other.index && generation == other.generation;
+  }
+
+  bool
+   operator!=(const Entity& other) const {
+   return !(*this == other);
+  }
+ };
+
+ /**
+  * @class EntityQuery
+  * @brief Component types an archetype must have (all) and must not have (none), with the
+  * archetypes of one EntityWorld found to match so far.
+  */
+ class
+  EntityQuery {
+  public:
+  EntityQuery() : m_all(0), m_none(0), m_valid(true), m_scanned(0), m_world(nullptr) {}
+
+  /** @brief Archetypes with every one of Ts. */
+  template<typename... Ts>
+  static EntityQuery
+   of() {
+   EntityQuery query;
+   query.m_valid = maskOf<Ts...>(query.m_all);
+   return query;
+  }
+
+  /** @brief Also excludes archetypes with any of Ts. */
+  template<typename... Ts>
+  EntityQuery&
+   without() {
+   uint64_t mask = 0;
+   maskOf<Ts...>(mask);
+   m_none |= mask;
+   reset();
+   return *this;
+  }
+
+  /** @brief Bitmask of the component ids in Ts; false if one of them is past the limit. */
+  template<typename... Ts>
+  static bool
+   maskOf(uint64_t& mask) {
+   const uint32_t ids[] = { ECS_NONE, componentId<Ts>()... };
+   bool ok = true;
+   for (size_t i = 1; i < sizeof(ids) / sizeof(ids[0]); ++i) {
+    if (ids[i] < ECS_MAX_COMPONENTS) mask |= uint64_t(1) << ids[i];
+    else ok = false;
+   }
+   return ok;
+  }
+
+  uint64_t
+   all() const {
+   return m_all;
+  }
+
+  uint64_t
+   none() const {
+   return m_none;
+  }
+
+  /** @brief Forgets the matched archetypes, e.g. before using the query on another world. */
+  void
+   reset() {
+   m_archetypes.clear();
+   m_scanned = 0;
+   m_world = nullptr;
+  }
+
+  private:
+  friend class EntityWorld;
+
+  uint64_t m_all;
+  uint64_t m_none;
+  bool m_valid;                       ///< False when a required type is past ECS_MAX_COMPONENTS: matches nothing
+  std::vector<uint32_t> m_archetypes; ///< Matching archetypes of m_world, in creation order
+  uint32_t m_scanned;                 ///< Archetypes of m_world tested so far
+  const void* m_world;
+  std::vector<std::pair<uint32_t, uint32_t>> m_tasks; ///< (archetype, chunk) scratch of the parallel forEachChunk()
+ };
+
+ /**
+  * @class ChunkView
+  * @brief The columns of one chunk, as handed to forEachChunk() callbacks.
+  */
+ class
+  ChunkView {
+  public:
+  /** @brief Entities in the chunk; the columns have this many valid rows. */
+  size_t
+   size() const {
+   return m_count;
+  }
+
+  /** @brief Handles of the entities, row by row. */
+  const Entity*
+   entities() const {
+   return reinterpret_cast<const Entity*>(m_data);
+  }
+
+  /** @brief True when the chunk's archetype has T, for components a query does not require. */
+  template<typename T>
+  bool
+   has() const {
+   const uint32_t id = componentId<T>();
+   return id < ECS_MAX_COMPONENTS && m_offsets[id] != ECS_NONE;
+  }
+
+  /** @brief Column of T; null pointers if the chunk's archetype lacks it. */
+  template<typename T>
+  ComponentColumn<T>
+   column() const {
+   return columnOf<T>(std::integral_constant<uint32_t, ComponentLanes<T>::value>());
+  }
+
+  private:
+  friend class EntityWorld;
+
+  ChunkView(unsigned char* data, size_t count, const uint32_t* offsets, size_t laneStride)
+   : m_data(data), m_count(count), m_offsets(offsets), m_laneStride(laneStride) {}
+
+  float*
+   lane(uint32_t id, uint32_t l) const {
+   if (id >= ECS_MAX_COMPONENTS || m_offsets[id] == ECS_NONE) return nullptr;
+   return reinterpret_cast<float*>(m_data + m_offsets[id] + l * m_laneStride);
+  }
+
+  template<typename T>
+  T*
+   columnOf(std::integral_constant<uint32_t, 0>) const {
+   const uint32_t id = componentId<T>();
+   if (id >= ECS_MAX_COMPONENTS || m_offsets[id] == ECS_NONE) return nullptr;
+   return reinterpret_cast<T*>(m_data + m_offsets[id]);
+  }
+
+  template<typename T>
+  float*
+   columnOf(std::integral_constant<uint32_t, 1>) const {
+   return lane(componentId<T>(), 0);
+  }
+
+  template<typename T>
+  EngineMath::batch::SoA2
+   columnOf(std::integral_constant<uint32_t, 2>) const {
+   const uint32_t id = componentId<T>();
+   return { lane(id, 0), lane(id, 1) };
+  }
+
+  template<typename T>
+  EngineMath::batch::SoA3
+   columnOf(std::integral_constant<uint32_t, 3>) const {
+   const uint32_t id = componentId<T>();
+   return { lane(id, 0), lane(id, 1), lane(id, 2) };
+  }
+
+  template<typename T>
+  QuaternionSoA
+   columnOf(std::integral_constant<uint32_t, 4>) const {
+   const uint32_t id = componentId<T>();
+   return { lane(id, 0), lane(id, 1), lane(id, 2), lane(id, 3) };
+  }
+
+  unsigned char* m_data;
+  size_t m_count;
+  const uint32_t* m_offsets;
+  size_t m_laneStride;
+ };
+
+ /**
+  * @class EntityWorld
+  * @brief Entities and their components, grouped by archetype into SoA chunks.
+  */
+ class
+  EntityWorld {
+  public:
+  EntityWorld() : m_size(0) {
+   archetype(0);
+  }
+
+  EntityWorld(const EntityWorld&) = delete;
+  EntityWorld& operator=(const EntityWorld&) = delete;
+
+  /** @brief New entity with the given components; an invalid handle if a type is past the limit. */
+  template<typename... Ts>
+  Entity
+   create(const Ts&... components) {
+   uint64_t mask = 0;
+   if (!EntityQuery::maskOf<Ts...>(mask)) return Entity();
+   uint32_t index;
+   if (!m_free.empty()) {
+    index = m_free.back();
+    m_free.pop_back();
+   }
+   else {
+    index = static_cast<uint32_t>(m_records.size());
+    m_records.push_back(Record());
+   }
+   Record& record = m_records[index];
+   const Entity entity = { index, record.generation };
+   place(entity, archetype(mask));
+   const int expand[] = { 0, (write(record, componentId<Ts>(), &components), 0)... };
+   (void)expand;
+   ++m_size;
+   return entity;
+  }
+
+  /** @brief Destroys entity and its components; false if it was already gone. */
+  bool
+   destroy(Entity entity) {
+   if (!alive(entity)) return false;
+   Record& record = m_records[entity.index];
+   vacate(record);
+   record.archetype = ECS_NONE;
+   ++record.generation;
+   m_free.push_back(entity.index);
+   --m_size;
+   return true;
+  }
+
+  bool
+   alive(Entity entity) const {
+   return entity.index < m_records.size() && m_records[entity.index].generation == entity.generation &&
+          m_records[entity.index].archetype != ECS_NONE;
+  }
+
+  template<typename T>
+  bool
+   has(Entity entity) const {
+   const uint32_t id = componentId<T>();
+   return alive(entity) && id < ECS_MAX_COMPONENTS && (m_archetypes[m_records[entity.index].archetype]->mask >> id & 1);
+  }
+
+  /** @brief Copies entity's T to out; false if the entity is gone or has no T. */
+  template<typename T>
+  bool
+   get(Entity entity, T& out) const {
+   if (!has<T>(entity)) return false;
+   read(m_records[entity.index], componentId<T>(), &out);
+   return true;
+  }
+
+  /** @brief Overwrites entity's T; false if the entity is gone or has no T. */
+  template<typename T>
+  bool
+   set(Entity entity, const T& value) {
+   if (!has<T>(entity)) return false;
+   write(m_records[entity.index], componentId<T>(), &value);
+   return true;
+  }
+
+  /**
+   * @brief Gives entity a T, moving it to the archetype with T, or overwrites the T it has.
+   * False if the entity is gone or T is past the component limit.
+   */
+  template<typename T>
+  bool
+   add(Entity entity, const T& value) {
+   const uint32_t id = componentId<T>();
+   if (!alive(entity) || id >= ECS_MAX_COMPONENTS) return false;
+   Record& record = m_records[entity.index];
+   if (!(m_archetypes[record.archetype]->mask >> id & 1)) move(entity, edge(record.archetype, id, true));
+   write(record, id, &value);
+   return true;
+  }
+
+  /** @brief Takes T from entity, moving it to the archetype without T; false if it had none. */
+  template<typename T>
+  bool
+   remove(Entity entity) {
+   if (!has<T>(entity)) return false;
+   move(entity, edge(m_records[entity.index].archetype, componentId<T>(), false));
+   return true;
+  }
+
+  /** @brief Calls fn(const ChunkView&) for every non-empty chunk query matches. */
+  template<typename Fn>
+  void
+   forEachChunk(EntityQuery& query, const Fn& fn) {
+   EU_TRACE_ZONE("EntityWorld::forEachChunk");
+   match(query);
+   for (uint32_t a : query.m_archetypes) {
+    Archetype& arch = *m_archetypes[a];
+    for (size_t c = 0; c < arch.chunks.size(); ++c) fn(view(arch, c));
+   }
+  }
+
+  /**
+   * @brief forEachChunk() with the chunks run as jobs on jobs, one chunk per job; returns when
+   * all are done. fn is called concurrently, each call with a different chunk.
+   */
+  template<typename Fn>
+  void
+   forEachChunk(EntityQuery& query, JobSystem& jobs, const Fn& fn) {
+   EU_TRACE_ZONE("EntityWorld::forEachChunk");
+   match(query);
+   std::vector<std::pair<uint32_t, uint32_t>>& tasks = query.m_tasks;
+   tasks.clear();
+   for (uint32_t a : query.m_archetypes) {
+    for (uint32_t c = 0; c < m_archetypes[a]->chunks.size(); ++c) tasks.emplace_back(a, c);
+   }
+   EU_TRACE_COUNTER("ECS chunks", tasks.size());
+   jobs.parallelFor(0, tasks.size(), 1, [&](size_t first, size_t last) {
+    for (size_t t = first; t < last; ++t) fn(view(*m_archetypes[tasks[t].first], tasks[t].second));
+   });
+  }
+
+  /** @brief forEachChunk() over the archetypes with every one of Ts, through a query kept per Ts. */
+  template<typename... Ts, typename Fn>
+  void
+   each(const Fn& fn) {
+   forEachChunk(cachedQuery<Ts...>(), fn);
+  }
+
+  /** @brief Parallel each(). */
+  template<typename... Ts, typename Fn>
+  void
+   each(JobSystem& jobs, const Fn& fn) {
+   forEachChunk(cachedQuery<Ts...>(), jobs, fn);
+  }
+
+  /** @brief Live entities. */
+  size_t
+   size() const {
+   return m_size;
+  }
+
+  /** @brief Archetypes created so far, the empty one included; they are never removed. */
+  size_t
+   archetypeCount() const {
+   return m_archetypes.size();
+  }
+
+  /** @brief Chunks in use across all archetypes. */
+  size_t
+   chunkCount() const {
+   size_t chunks = 0;
+   for (const std::unique_ptr<Archetype>& arch : m_archetypes) chunks += arch->chunks.size();
+   return chunks;
+  }
+
+  private:
+  struct Record {
+   uint32_t archetype = ECS_NONE;
+   uint32_t chunk = 0;
+   uint32_t row = 0;
+   uint32_t generation = 1;
+  };
+
+  struct Chunk {
+   std::unique_ptr<unsigned char[]> storage; ///< Allocation behind data, before alignment
+   unsigned char* data;
+   uint32_t count;
+  };
+
+  struct Archetype {
+   uint64_t mask;
+   std::vector<uint32_t> components;      ///< Ids in the mask, ascending
+   uint32_t offsets[ECS_MAX_COMPONENTS];  ///< Column offset in a chunk, or ECS_NONE
+   uint32_t add[ECS_MAX_COMPONENTS];      ///< Archetype with one more component, or ECS_NONE until looked up
+   uint32_t remove[ECS_MAX_COMPONENTS];   ///< Archetype with one component fewer
+   size_t laneStride;                     ///< Bytes between the lanes of a split column
+   size_t chunkBytes;
+   uint32_t capacity;                     ///< Entities per chunk
+   std::vector<Chunk> chunks;             ///< All full but the last
+  };
+
+  /** Bytes a chunk of capacity entities of archetype needs, filling in the column offsets. */
+  static size_t
+   layout(Archetype& arch, uint32_t capacity) {
+   const detail::ComponentInfo* infos = detail::componentInfos();
+   arch.laneStride = detail::alignColumn(capacity * sizeof(float));
+   size_t offset = detail::alignColumn(capacity * sizeof(Entity));
+   for (uint32_t id : arch.components) {
+    arch.offsets[id] = static_cast<uint32_t>(offset);
+    offset += infos[id].lanes ? infos[id].lanes * arch.laneStride : detail::alignColumn(size_t(capacity) * infos[id].size);
+   }
+   return offset;
+  }
+
+  /** Archetype of mask, created with its chunk layout the first time. */
+  uint32_t
+   archetype(uint64_t mask) {
+   if (const uint32_t* found = m_byMask.find(mask)) return *found;
+
+   std::unique_ptr<Archetype> arch(new Archetype());
+   arch->mask = mask;
+   size_t rowBytes = sizeof(Entity);
+   for (uint32_t id = 0; id < ECS_MAX_COMPONENTS; ++id) {
+    arch->offsets[id] = ECS_NONE;
+    arch->add[id] = ECS_NONE;
+    arch->remove[id] = ECS_NONE;
+    if (mask >> id & 1) {
+     arch->components.push_back(id);
+     rowBytes += detail::componentInfos()[id].size;
+    }
+   }
+   uint32_t capacity = static_cast<uint32_t>(ECS_CHUNK_SIZE / rowBytes);
+   while (capacity > 1 && layout(*arch, capacity) > ECS_CHUNK_SIZE) --capacity;
+   if (capacity == 0) capacity = 1;
+   arch->capacity = capacity;
+   arch->chunkBytes = layout(*arch, capacity);
+
+   const uint32_t index = static_cast<uint32_t>(m_archetypes.size());
+   m_archetypes.push_back(std::move(arch));
+   m_byMask.insert(mask, index);
+   return index;
+  }
+
+  /** Archetype of from with component id added or removed, through the cached edge. */
+  uint32_t
+   edge(uint32_t from, uint32_t id, bool adding) {
+   uint32_t& cached = adding ? m_archetypes[from]->add[id] : m_archetypes[from]->remove[id];
+   if (cached == ECS_NONE) {
+    const uint64_t bit = uint64_t(1) << id;
+    const uint32_t to = archetype(adding ? m_archetypes[from]->mask | bit : m_archetypes[from]->mask & ~bit);
+    (adding ? m_archetypes[from]->add[id] : m_archetypes[from]->remove[id]) = to;
+    return to;
+   }
+   return cached;
+  }
+
+  /** Appends entity as the last row of archetype a and points its record there. */
+  void
+   place(Entity entity, uint32_t a) {
+   Archetype& arch = *m_archetypes[a];
+   if (arch.chunks.empty() || arch.chunks.back().count == arch.capacity) {
+    Chunk chunk;
+    if (arch.chunkBytes <= ECS_CHUNK_SIZE && !m_spare.empty()) {
+     chunk.storage = std::move(m_spare.back());
+     m_spare.pop_back();
+    }
+    else {
+     chunk.storage.reset(new unsigned char[(arch.chunkBytes > ECS_CHUNK_SIZE ? arch.chunkBytes : ECS_CHUNK_SIZE) + 64]);
+    }
+    const uintptr_t aligned = (reinterpret_cast<uintptr_t>(chunk.storage.get()) + 63) & ~uintptr_t(63);
+    chunk.data = reinterpret_cast<unsigned char*>(aligned);
+    chunk.count = 0;
+    arch.chunks.push_back(std::move(chunk));
+   }
+   Chunk& chunk = arch.chunks.back();
+   Record& record = m_records[entity.index];
+   record.archetype = a;
+   record.chunk = static_cast<uint32_t>(arch.chunks.size() - 1);
+   record.row = chunk.count++;
+   reinterpret_cast<Entity*>(chunk.data)[record.row] = entity;
+  }
+
+  /** Fills record's row with the last row of its archetype and drops that last row. */
+  void
+   vacate(const Record& record) {
+   Archetype& arch = *m_archetypes[record.archetype];
+   Chunk& last = arch.chunks.back();
+   const uint32_t lastRow = last.count - 1;
+   Chunk& chunk = arch.chunks[record.chunk];
+   if (&chunk != &last || record.row != lastRow) {
+    const Entity moved = reinterpret_cast<Entity*>(last.data)[lastRow];
+    copyRow(arch, last, lastRow, arch, chunk, record.row);
+    reinterpret_cast<Entity*>(chunk.data)[record.row] = moved;
+    m_records[moved.index].chunk = record.chunk;
+    m_records[moved.index].row = record.row;
+   }
+   if (--last.count == 0) {
+    if (arch.chunkBytes <= ECS_CHUNK_SIZE) m_spare.push_back(std::move(last.storage));
+    arch.chunks.pop_back();
+   }
+  }
+
+  /** Moves entity to archetype to, keeping the components both archetypes have. */
+  void
+   move(Entity entity, uint32_t to) {
+   Record& record = m_records[entity.index];
+   const Record from = record;
+   place(entity, to);
+   Archetype& src = *m_archetypes[from.archetype];
+   Archetype& dst = *m_archetypes[to];
+   copyRow(src, src.chunks[from.chunk], from.row, dst, dst.chunks[record.chunk], record.row);
+   vacate(from);
+  }
+
+  /** Copies the components dst has of row srcRow of src into row dstRow of dst. */
+  static void
+   copyRow(const Archetype& srcArch, const Chunk& src, uint32_t srcRow, const Archetype& dstArch, Chunk& dst, uint32_t dstRow) {
+   const detail::ComponentInfo* infos = detail::componentInfos();
+   for (uint32_t id : dstArch.components) {
+    if (srcArch.offsets[id] == ECS_NONE) continue;
+    const detail::ComponentInfo& info = infos[id];
+    if (info.lanes) {
+     for (uint32_t l = 0; l < info.lanes; ++l) {
+      reinterpret_cast<float*>(dst.data + dstArch.offsets[id] + l * dstArch.laneStride)[dstRow] =
+       reinterpret_cast<const float*>(src.data + srcArch.offsets[id] + l * srcArch.laneStride)[srcRow];
+     }
+    }
+    else {
+     std::memcpy(dst.data + dstArch.offsets[id] + size_t(dstRow) * info.size,
+                 src.data + srcArch.offsets[id] + size_t(srcRow) * info.size, info.size);
+    }
+   }
+  }
+
+  /** Stores the component id at value into record's row. */
+  void
+   write(const Record& record, uint32_t id, const void* value) {
+   const Archetype& arch = *m_archetypes[record.archetype];
+   unsigned char* column = arch.chunks[record.chunk].data + arch.offsets[id];
+   const detail::ComponentInfo& info = detail::componentInfos()[id];
+   if (info.lanes) {
+    for (uint32_t l = 0; l < info.lanes; ++l) {
+     std::memcpy(column + l * arch.laneStride + record.row * sizeof(float), static_cast<const unsigned char*>(value) + l * sizeof(float),
+                 sizeof(float));
+    }
+   }
+   else {
+    std::memcpy(column + size_t(record.row) * info.size, value, info.size);
+   }
+  }
+
+  /** Loads the component id of record's row into out. */
+  void
+   read(const Record& record, uint32_t id, void* out) const {
+   const Archetype& arch = *m_archetypes[record.archetype];
+   const unsigned char* column = arch.chunks[record.chunk].data + arch.offsets[id];
+   const detail::ComponentInfo& info = detail::componentInfos()[id];
+   if (info.lanes) {
+    for (uint32_t l = 0; l < info.lanes; ++l) {
+     std::memcpy(static_cast<unsigned char*>(out) + l * sizeof(float), column + l * arch.laneStride + record.row * sizeof(float),
+                 sizeof(float));
+    }
+   }
+   else {
+    std::memcpy(out, column + size_t(record.row) * info.size, info.size);
+   }
+  }
+
+  /** Adds the archetypes created since query last ran that it matches. */
+  void
+   match(EntityQuery& query) const {
+   if (query.m_world != this) {
+    query.reset();
+    query.m_world = this;
+   }
+   if (!query.m_valid) {
+    query.m_scanned = static_cast<uint32_t>(m_archetypes.size());
+    return;
+   }
+   for (; query.m_scanned < m_archetypes.size(); ++query.m_scanned) {
+    const uint64_t mask = m_archetypes[query.m_scanned]->mask;
+    if ((mask & query.m_all) == query.m_all && !(mask & query.m_none)) query.m_archetypes.push_back(query.m_scanned);
+   }
+  }
+
+  ChunkView
+   view(Archetype& arch, size_t c) const {
+   return ChunkView(arch.chunks[c].data, arch.chunks[c].count, arch.offsets, arch.laneStride);
+  }
+
+  template<typename... Ts>
+  EntityQuery&
+   cachedQuery() {
+   uint64_t mask = 0;
+   const bool valid = EntityQuery::maskOf<Ts...>(mask);
+   EntityQuery& query = m_queries[mask];
+   if (query.m_all != mask || query.m_valid != valid) {
+    query = EntityQuery();
+    query.m_all = mask;
+    query.m_valid = valid;
+   }
+   return query;
+  }
+
+  std::vector<std::unique_ptr<Archetype>> m_archetypes;
+  FlatHashMap<uint64_t, uint32_t> m_byMask;
+  std::unordered_map<uint64_t, EntityQuery> m_queries; ///< Queries behind each<Ts...>(), by required mask
+  std::vector<Record> m_records;
+  std::vector<uint32_t> m_free;
+  std::vector<std::unique_ptr<unsigned char[]>> m_spare; ///< Emptied ECS_CHUNK_SIZE chunks, for reuse
+  size_t m_size;
+ };
+}
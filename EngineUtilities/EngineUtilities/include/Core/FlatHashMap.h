@@ -0,0 +1,272 @@
+/**
+ * @file FlatHashMap.h
+ * @brief Open-addressing Robin Hood hash map for small POD keys (integers, packed cells,
+ * vectors, quaternions).
+ *
+ * FlatHashMap<K, V> keeps its entries in one power-of-two array with linear probing, next to
+ * a byte per slot holding how far the entry sits from its home slot (0 = empty). Inserting
+ * follows the Robin Hood rule: an entry that has probed further than the resident of a slot
+ * takes the slot and the resident moves on, so probe lengths stay short and even. Lookups
+ * stop as soon as they meet a resident closer to home than the probe, found or not, and
+ * erase shifts the following entries back a slot, so there are no tombstones and a table
+ * that sees many inserts and erases does not degrade. A hit is usually one cache line of
+ * entries and one of distances, where std::unordered_map chases a node pointer per lookup.
+ *
+ * The home slot is the top bits of the hash times the 64-bit golden ratio, so weak hashers
+ * (identity std::hash of integers) still spread. The default hasher is EU::Hash (Math/Hash.h).
+ * The table grows to twice its size beyond FLAT_MAP_MAX_LOAD, or if a probe would run past
+ * 254 slots, and allocates nothing until the first insert.
+ *
+ * Keys must be trivially copyable; values only need to be default constructible and movable.
+ * Inserting or erasing moves entries, so pointers returned by find(), insert() and operator[]
+ * are valid only until the next insert or erase, and no iteration order is guaranteed.
+ *
+ *   FlatHashMap<CVector3, uint32_t> unique;               // vertex deduplication
+ *   const auto slot = unique.insert(position, uint32_t(vertices.size()));
+ *   if (slot.second) vertices.push_back(position);
+ *   indices.push_back(*slot.first);
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <Math/Hash.h>
+
+namespace EU {
+ /// Smallest table allocated, in slots.
+ constexpr size_t FLAT_MAP_MIN_CAPACITY = 16;
+ /// Fraction of the slots that may be full before the table grows, as FLAT_MAP_MAX_LOAD / 8.
+ constexpr size_t FLAT_MAP_MAX_LOAD = 7;
+
+ /**
+  * @class FlatHashMap
+  * @brief Robin Hood hash map with entries stored inline.
+  */
+ template<typename K, typename V, typename H = Hash<K>, typename Eq = std::equal_to<K>>
+ class
+  FlatHashMap {
+  static_assert(std::is_trivially_copyable<K>::value, "FlatHashMap keys must be trivially copyable");
+
+  public:
+  explicit FlatHashMap(size_t capacity = 0, const H& hash = H(), const Eq& equal = Eq())
+   : m_size(0), m_shift(64), m_hash(hash), m_equal(equal) {
+   if (capacity) reserve(capacity);
+  }
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  /** @brief Slots in the table; entries fit up to capacity() * FLAT_MAP_MAX_LOAD / 8. */
+  size_t capacity() const { return m_distance.size(); }
+
+  /** @brief Value of key, or nullptr when it is not in the map. */
+  V*
+   find(const K& key) {
+   const size_t slot = locate(key);
+   return slot == NONE ? nullptr : &m_entries[slot].value;
+  }
+
+  const V*
+   find(const K& key) const {
+   const size_t slot = locate(key);
+   return slot == NONE ? nullptr : &m_entries[slot].value;
+  }
+
+  bool
+   contains(const K& key) const {
+   return locate(key) != NONE;
+  }
+
+  /**
+   * @brief Adds key with value unless key is already there.
+   * @return The value stored under key, and true if it was just inserted.
+   */
+  std::pair<V*, bool>
+   insert(const K& key, V value) {
+   const size_t slot = locate(key);
+   if (slot != NONE) return std::make_pair(&m_entries[slot].value, false);
+   return std::make_pair(&m_entries[add(key, std::move(value))].value, true);
+  }
+
+  /** @brief Value of key, default constructed first if key is not in the map. */
+  V&
+   operator[](const K& key) {
+   const size_t slot = locate(key);
+   return m_entries[slot != NONE ? slot : add(key, V())].value;
+  }
+
+  /** @brief Removes key; returns false if it was not in the map. */
+  bool
+   erase(const K& key) {
+   size_t slot = locate(key);
+   if (slot == NONE) return false;
+   const size_t mask = capacity() - 1;
+   // Backward shift: pull every following displaced entry one slot towards home.
+   for (size_t next = (slot + 1) & mask; m_distance[next] > 1; slot = next, next = (next + 1) & mask) {
+    m_entries[slot] = std::move(m_entries[next]);
+    m_distance[slot] = static_cast<uint8_t>(m_distance[next] - 1);
+   }
+   m_entries[slot] = Entry();
+   m_distance[slot] = 0;
+   --m_size;
+   return true;
+  }
+
+  /** @brief Removes every entry, keeping the table. */
+  void
+   clear() {
+   for (size_t i = 0; i < m_distance.size(); ++i) {
+    if (m_distance[i]) m_entries[i] = Entry();
+    m_distance[i] = 0;
+   }
+   m_size = 0;
+  }
+
+  /** @brief Grows the table so count entries fit without rehashing. */
+  void
+   reserve(size_t count) {
+   size_t slots = FLAT_MAP_MIN_CAPACITY;
+   while (slots * FLAT_MAP_MAX_LOAD / 8 < count) slots *= 2;
+   if (slots > capacity()) rehash(slots);
+  }
+
+  /** @brief Calls fn(key, value) for every entry, in table order. */
+  template<typename Fn>
+  void
+   forEach(Fn fn) {
+   for (size_t i = 0; i < m_distance.size(); ++i) {
+    if (m_distance[i]) fn(static_cast<const K&>(m_entries[i].key), m_entries[i].value);
+   }
+  }
+
+  template<typename Fn>
+  void
+   forEach(Fn fn) const {
+   for (size_t i = 0; i < m_distance.size(); ++i) {
+    if (m_distance[i]) fn(m_entries[i].key, m_entries[i].value);
+   }
+  }
+
+  private:
+  static constexpr size_t NONE = ~size_t(0);
+  /// Largest distance byte; a probe that would go further grows the table instead.
+  static constexpr uint8_t MAX_DISTANCE = 255;
+
+  struct Entry {
+   K key;
+   V value;
+   Entry() : key(), value() {}
+   Entry(const K& key, V&& value) : key(key), value(std::move(value)) {}
+  };
+
+  size_t
+   home(const K& key) const {
+   return static_cast<size_t>((static_cast<uint64_t>(m_hash(key)) * 0x9e3779b97f4a7c15ull) >> m_shift);
+  }
+
+  /** Slot holding key, or NONE. */
+  size_t
+   locate(const K& key) const {
+   if (m_size == 0) return NONE;
+   const size_t mask = capacity() - 1;
+   size_t slot = home(key);
+   for (uint32_t distance = 1;; ++distance, slot = (slot + 1) & mask) {
+    const uint32_t resident = m_distance[slot];
+    if (resident < distance) return NONE;
+    if (resident == distance && m_equal(m_entries[slot].key, key)) return slot;
+   }
+  }
+
+  /** Inserts key, known to be absent; returns its slot. */
+  size_t
+   add(const K& key, V&& value) {
+   if ((m_size + 1) * 8 > capacity() * FLAT_MAP_MAX_LOAD) rehash(capacity() ? capacity() * 2 : FLAT_MAP_MIN_CAPACITY);
+   Entry entry(key, std::move(value));
+   for (;;) {
+    const size_t slot = place(std::move(entry));
+    if (slot != NONE) return slot;
+    rehash(capacity() * 2);
+   }
+  }
+
+  /**
+   * Robin Hood insertion of entry; returns where it landed, or NONE (with entry and the table
+   * untouched) when some probe would exceed MAX_DISTANCE.
+   */
+  size_t
+   place(Entry&& entry) {
+   const size_t mask = capacity() - 1;
+   size_t slot = home(entry.key);
+   uint32_t distance = 1;
+   for (;; ++distance, slot = (slot + 1) & mask) {
+    if (distance == MAX_DISTANCE) return NONE;
+    if (m_distance[slot] < distance) break;
+   }
+   // Check the displacement chain fits before moving anything.
+   if (m_distance[slot]) {
+    uint32_t carried = m_distance[slot];
+    for (size_t s = (slot + 1) & mask;; s = (s + 1) & mask) {
+     if (++carried == MAX_DISTANCE) return NONE;
+     if (m_distance[s] == 0) break;
+     if (m_distance[s] < carried) carried = m_distance[s];
+    }
+   }
+   const size_t landed = slot;
+   Entry carry = std::move(entry);
+   for (;; ++distance, slot = (slot + 1) & mask) {
+    if (m_distance[slot] == 0) {
+     m_entries[slot] = std::move(carry);
+     m_distance[slot] = static_cast<uint8_t>(distance);
+     break;
+    }
+    if (m_distance[slot] < distance) {
+     std::swap(m_entries[slot], carry);
+     const uint32_t resident = m_distance[slot];
+     m_distance[slot] = static_cast<uint8_t>(distance);
+     distance = resident;
+    }
+   }
+   ++m_size;
+   return landed;
+  }
+
+  void
+   rehash(size_t slots) {
+   std::vector<Entry> entries;
+   std::vector<uint8_t> distance;
+   entries.swap(m_entries);
+   distance.swap(m_distance);
+   for (;; slots *= 2) {
+    m_entries = std::vector<Entry>(slots);
+    m_distance.assign(slots, 0);
+    m_shift = 64;
+    for (size_t s = slots; s > 1; s >>= 1) --m_shift;
+    m_size = 0;
+    size_t i = 0;
+    for (; i < distance.size(); ++i) {
+     if (!distance[i]) continue;
+     if (place(std::move(entries[i])) == NONE) break;
+     distance[i] = 0;
+    }
+    if (i == distance.size()) return;
+    // Pathological clustering even at this size: take everything back and go one size up.
+    for (size_t j = 0; j < slots; ++j) {
+     if (!m_distance[j]) continue;
+     entries.push_back(std::move(m_entries[j]));
+     distance.push_back(1);
+    }
+   }
+  }
+
+  std::vector<Entry> m_entries;
+  std::vector<uint8_t> m_distance; ///< Probe distance + 1 of each slot's entry, 0 when empty
+  size_t m_size;
+  int m_shift;                     ///< 64 - log2(capacity()), so home() keeps the top bits
+  H m_hash;
+  Eq m_equal;
+ };
+}
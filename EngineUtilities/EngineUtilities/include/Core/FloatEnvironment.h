@@ -0,0 +1,128 @@
+/**
+ * @file FloatEnvironment.h
+ * @brief Scoped flush-to-zero / denormals-are-zero control of the calling thread's float unit.
+ *
+ * Denormal (subnormal) floats, the values below FLT_MIN that decaying velocities, falloff
+ * terms and IIR filters drift into, take a microcode assist on x86 that makes each operation
+ * touching one 10-100 times slower. Flush-to-zero (FTZ) makes results that would be denormal
+ * zero; denormals-are-zero (DAZ) reads denormal inputs as zero. Both are bits of the
+ * per-thread float control register (MXCSR on x86, FPCR.FZ on AArch64, which covers both),
+ * so they have to be set on every thread that does the math.
+ *
+ * DenormalGuard sets both for the rest of a scope and puts the register back as it found it;
+ * on a thread that already flushes it changes nothing. JobSystem workers run under one for
+ * their whole life, and the threads that run jobs while waiting take one for the wait, so
+ * every job sees the same mode whichever thread runs it (JobSystem(threads, false) opts
+ * out). Platforms without a known control register report denormalControlSupported() false
+ * and the guard does nothing.
+ *
+ * Flushing changes results only for values below FLT_MIN (about 1.2e-38), but it does change
+ * them: EU_REPRODUCIBLE builds get the same bits everywhere only if every platform flushes
+ * or none does.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <Core/SIMD.h>
+
+#if defined(EU_SIMD_SSE2)
+ #include <xmmintrin.h>
+#endif
+
+namespace EU {
+ namespace detail {
+#if defined(EU_SIMD_SSE2)
+  /// MXCSR flush-to-zero (bit 15) and denormals-are-zero (bit 6).
+  constexpr uint64_t FLOAT_FLUSH_BITS = 0x8040u;
+
+  inline uint64_t
+   readFloatControl() {
+   return _mm_getcsr();
+  }
+
+  inline void
+   writeFloatControl(uint64_t value) {
+   _mm_setcsr(static_cast<unsigned int>(value));
+  }
+#elif (defined(__aarch64__) || defined(__arm64__)) && (defined(__GNUC__) || defined(__clang__))
+  /// FPCR.FZ (bit 24): flushes denormal inputs and outputs alike.
+  constexpr uint64_t FLOAT_FLUSH_BITS = uint64_t(1) << 24;
+
+  inline uint64_t
+   readFloatControl() {
+   uint64_t value;
+   __asm__ __volatile__("mrs %0, fpcr" : "=r"(value));
+   return value;
+  }
+
+  inline void
+   writeFloatControl(uint64_t value) {
+   __asm__ __volatile__("msr fpcr, %0" : : "r"(value));
+  }
+#else
+  constexpr uint64_t FLOAT_FLUSH_BITS = 0;
+
+  inline uint64_t
+   readFloatControl() {
+   return 0;
+  }
+
+  inline void
+   writeFloatControl(uint64_t) {}
+#endif
+ }
+
+ /** @brief True when this build can switch FTZ/DAZ; otherwise the functions below do nothing. */
+ constexpr bool
+  denormalControlSupported() {
+  return detail::FLOAT_FLUSH_BITS != 0;
+ }
+
+ /** @brief True when the calling thread flushes denormals (FTZ and DAZ both set). */
+ inline bool
+  denormalsFlushed() {
+  return denormalControlSupported() && (detail::readFloatControl() & detail::FLOAT_FLUSH_BITS) == detail::FLOAT_FLUSH_BITS;
+ }
+
+ /** @brief Sets or clears FTZ and DAZ on the calling thread; returns whether they were set. */
+ inline bool
+  setDenormalsFlushed(bool flush) {
+  const uint64_t control = detail::readFloatControl();
+  const bool was = denormalControlSupported() && (control & detail::FLOAT_FLUSH_BITS) == detail::FLOAT_FLUSH_BITS;
+  if (was != flush && denormalControlSupported()) {
+   detail::writeFloatControl(flush ? control | detail::FLOAT_FLUSH_BITS : control & ~uint64_t(detail::FLOAT_FLUSH_BITS));
+  }
+  return was;
+ }
+
+ /**
+  * @class DenormalGuard
+  * @brief Flushes denormals on the calling thread until destroyed, then restores the float
+  * control register exactly.
+  */
+ class
+  DenormalGuard {
+  public:
+  /** @param flush false makes the guard do nothing, for code that chooses at run time. */
+  explicit DenormalGuard(bool flush = true) : m_saved(0), m_changed(false) {
+   if (!flush || !denormalControlSupported()) return;
+   m_saved = detail::readFloatControl();
+   if ((m_saved & detail::FLOAT_FLUSH_BITS) != detail::FLOAT_FLUSH_BITS) {
+    detail::writeFloatControl(m_saved | detail::FLOAT_FLUSH_BITS);
+    m_changed = true;
+   }
+  }
+
+  ~DenormalGuard() {
+   if (m_changed) detail::writeFloatControl(m_saved);
+  }
+
+  DenormalGuard(const DenormalGuard&) = delete;
+  DenormalGuard& operator=(const DenormalGuard&) = delete;
+
+  private:
+  uint64_t m_saved;
+  bool m_changed;
+ };
+}
@@ -0,0 +1,282 @@
+/**
+ * @file FrameArena.h
+ * @brief Bump-pointer scratch memory for buffers that only live until the end of a frame.
+ *
+ * FrameArena hands out memory by advancing a pointer inside a block it owns; nothing is
+ * freed individually and reset() makes the whole arena reusable at once. If a frame
+ * outgrows the block, another one is chained on; the next reset() merges them into one
+ * block of the combined size, so after the first few frames the arena allocates nothing.
+ * Memory comes back uninitialized, which pairs with the NoInit constructors of the vector
+ * and matrix types. Arenas never run destructors, so only trivially destructible types go
+ * in them.
+ *
+ * ArenaAllocator<T> adapts an arena to the standard allocator interface, e.g.
+ * FrameVector<Matrix4x4> for a per-frame std::vector. A growing vector leaves its old
+ * buffer behind in the arena until reset(), so reserve() first where the size is known.
+ *
+ * A FrameArena is not thread-safe. FrameArenaPool gives each thread its own sub-arena: a
+ * Lease checks one out for the duration of a task and every allocation through it is
+ * lock-free. The pool keeps only as many sub-arenas as were ever in use at once.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace EU {
+ /**
+  * @class FrameArena
+  * @brief Single-threaded bump allocator reset once per frame.
+  */
+ class
+  FrameArena {
+  public:
+  /// Default alignment of allocate(): a full AVX register.
+  static constexpr size_t DEFAULT_ALIGNMENT = 32;
+
+  /**
+   * @param blockSize Bytes of the first block, allocated on first use.
+   */
+  explicit FrameArena(size_t blockSize = 64 * 1024) : m_blockSize(blockSize), m_current(0), m_offset(0) {}
+
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  ~FrameArena() {
+   release();
+  }
+
+  /**
+   * @brief Returns bytes of uninitialized memory aligned to alignment (a power of two),
+   * valid until the next reset().
+   */
+  void*
+   allocate(size_t bytes, size_t alignment = DEFAULT_ALIGNMENT) {
+   if (!m_blocks.empty()) {
+    void* p = bump(m_blocks[m_current], bytes, alignment);
+    if (p != nullptr) return p;
+   }
+   const size_t last = m_blocks.empty() ? m_blockSize : m_blocks.back().size * 2;
+   const size_t size = last > bytes + alignment ? last : bytes + alignment;
+   m_blocks.push_back(Block{ static_cast<char*>(::operator new(size)), size });
+   m_current = m_blocks.size() - 1;
+   m_offset = 0;
+   return bump(m_blocks[m_current], bytes, alignment);
+  }
+
+  /**
+   * @brief Uninitialized storage for n objects of T, aligned to at least DEFAULT_ALIGNMENT.
+   */
+  template<typename T>
+  T*
+   allocateArray(size_t n) {
+   static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+   const size_t alignment = alignof(T) > DEFAULT_ALIGNMENT ? alignof(T) : DEFAULT_ALIGNMENT;
+   return static_cast<T*>(allocate(n * sizeof(T), alignment));
+  }
+
+  /**
+   * @brief Invalidates every allocation and makes the memory reusable. When the last frame
+   * needed several blocks, they are replaced by one block of their combined size.
+   */
+  void
+   reset() {
+   if (m_blocks.size() > 1) {
+    const size_t total = capacity();
+    release();
+    try {
+     m_blocks.push_back(Block{ static_cast<char*>(::operator new(total)), total });
+    }
+    catch (...) {
+     // Leave the arena empty; the next allocate() starts over with smaller blocks.
+    }
+   }
+   m_current = 0;
+   m_offset = 0;
+  }
+
+  /** @brief Bytes consumed since the last reset(), counting padding and the unused tails of filled blocks. */
+  size_t
+   used() const {
+   size_t total = 0;
+   for (size_t b = 0; b < m_current; ++b) total += m_blocks[b].size;
+   return total + m_offset;
+  }
+
+  /** @brief Bytes owned by the arena. */
+  size_t
+   capacity() const {
+   size_t total = 0;
+   for (const Block& block : m_blocks) total += block.size;
+   return total;
+  }
+
+  private:
+  struct Block {
+   char* data;
+   size_t size;
+  };
+
+  /** Carves bytes out of block at m_offset, or returns nullptr when they do not fit. */
+  void*
+   bump(const Block& block, size_t bytes, size_t alignment) {
+   const uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+   const uintptr_t start = (base + m_offset + alignment - 1) & ~uintptr_t(alignment - 1);
+   const size_t offset = static_cast<size_t>(start - base);
+   if (offset > block.size || block.size - offset < bytes) {
+    return nullptr;
+   }
+   m_offset = offset + bytes;
+   return block.data + offset;
+  }
+
+  void
+   release() {
+   for (const Block& block : m_blocks) ::operator delete(block.data);
+   m_blocks.clear();
+  }
+
+  std::vector<Block> m_blocks;
+  size_t m_blockSize; ///< Size of the first block
+  size_t m_current;   ///< Block allocations come from, always the last one
+  size_t m_offset;    ///< Bytes used in the current block
+ };
+
+ /**
+  * @class ArenaAllocator
+  * @brief Standard allocator drawing from a FrameArena; deallocate() does nothing.
+  */
+ template<typename T>
+ class
+  ArenaAllocator {
+  public:
+  using value_type = T;
+
+  explicit ArenaAllocator(FrameArena& arena) noexcept : m_arena(&arena) {}
+
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U>& otro) noexcept : m_arena(otro.arena()) {}
+
+  T*
+   allocate(size_t n) {
+   return m_arena->allocateArray<T>(n);
+  }
+
+  void
+   deallocate(T*, size_t) noexcept {}
+
+  FrameArena*
+   arena() const noexcept {
+   return m_arena;
+  }
+
+  private:
+  FrameArena* m_arena;
+ };
+
+ template<typename T, typename U>
+ inline bool
+  operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+  return a.arena() == b.arena();
+ }
+
+ template<typename T, typename U>
+ inline bool
+  operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept {
+  return a.arena() != b.arena();
+ }
+
+ /// std::vector whose storage lives in a FrameArena: FrameVector<T> v{ ArenaAllocator<T>(arena) }.
+ template<typename T>
+ using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+ /**
+  * @class FrameArenaPool
+  * @brief Per-thread sub-arenas handed out through leases and reset together.
+  */
+ class
+  FrameArenaPool {
+  public:
+  /**
+   * @class Lease
+   * @brief Exclusive use of one sub-arena for the lifetime of the lease. Memory allocated
+   * through it stays valid after the lease ends, until the pool's reset().
+   */
+  class
+   Lease {
+   public:
+   explicit Lease(FrameArenaPool& pool) : m_pool(pool), m_arena(pool.acquire()) {}
+
+   Lease(const Lease&) = delete;
+   Lease& operator=(const Lease&) = delete;
+
+   ~Lease() {
+    m_pool.release(m_arena);
+   }
+
+   FrameArena&
+    arena() const {
+    return *m_arena;
+   }
+
+   private:
+   FrameArenaPool& m_pool;
+   FrameArena* m_arena;
+  };
+
+  /**
+   * @param blockSize First block size of every sub-arena.
+   */
+  explicit FrameArenaPool(size_t blockSize = 64 * 1024) : m_blockSize(blockSize) {}
+
+  FrameArenaPool(const FrameArenaPool&) = delete;
+  FrameArenaPool& operator=(const FrameArenaPool&) = delete;
+
+  /**
+   * @brief Resets every sub-arena. Call between frames, with no lease alive.
+   */
+  void
+   reset() {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   for (const std::unique_ptr<FrameArena>& arena : m_arenas) arena->reset();
+  }
+
+  /** @brief Number of sub-arenas created so far. */
+  size_t
+   size() const {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   return m_arenas.size();
+  }
+
+  private:
+  FrameArena*
+   acquire() {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   if (!m_free.empty()) {
+    FrameArena* arena = m_free.back();
+    m_free.pop_back();
+    return arena;
+   }
+   m_arenas.emplace_back(new FrameArena(m_blockSize));
+   m_free.reserve(m_arenas.size());
+   return m_arenas.back().get();
+  }
+
+  void
+   release(FrameArena* arena) {
+   std::lock_guard<std::mutex> lock(m_mutex);
+   m_free.push_back(arena);
+  }
+
+  mutable std::mutex m_mutex;
+  std::vector<std::unique_ptr<FrameArena>> m_arenas;
+  std::vector<FrameArena*> m_free; ///< Sub-arenas not leased right now
+  size_t m_blockSize;
+ };
+}
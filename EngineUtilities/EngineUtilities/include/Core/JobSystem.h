@@ -0,0 +1,482 @@
+/**
+ * @file JobSystem.h
+ * @brief Work-stealing job system: persistent workers with Chase-Lev deques, pooled jobs,
+ * counters to wait on, and parallelFor over index ranges.
+ *
+ * A job is a callable of up to JOB_DATA_SIZE bytes (typically a lambda capturing a few
+ * pointers and indices), stored inline in a 64-byte slot of the submitting thread's pool, so
+ * submitting never allocates. Each worker pushes and pops its own jobs at the bottom of its
+ * deque (Chase and Lev, "Dynamic Circular Work-Stealing Deque", in the fixed-size form of Le
+ * et al.), and idle workers steal from the top of the others' deques. Workers that find
+ * nothing spin briefly, then sleep until the next submission.
+ *
+ * Every job counts itself into a JobCounter, and wait() returns once the counter is back to
+ * zero. Instead of blocking, a waiting thread runs pending jobs (its own first, then stolen
+ * ones), which gives the nesting fiber-based waits allow without switching stacks: a job
+ * can submit children and wait for them from inside a worker without stalling that worker.
+ *
+ * The thread that constructs the JobSystem is worker 0 and should be the one submitting
+ * outside work; other threads submit through a locked queue. useForParallelTasks() routes
+ * detail::parallelTasks(), and with it every batch kernel of the library, onto the workers
+ * instead of starting threads per call.
+ *
+ * Jobs run with denormals flushed (DenormalGuard, FloatEnvironment.h): workers set FTZ/DAZ
+ * once at start, and a thread running jobs inside wait(), parallelFor() or a parallelTasks()
+ * call holds a guard for that call, so results do not depend on which thread ran a job.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <Core/FloatEnvironment.h>
+#include <Core/Parallel.h>
+#include <Core/Trace.h>
+
+namespace EU {
+ /// Bytes of callable a job stores inline.
+ constexpr size_t JOB_DATA_SIZE = 40;
+ /// Job slots per thread pool and entries per deque; a power of two.
+ constexpr size_t JOB_QUEUE_SIZE = 4096;
+
+ class JobSystem;
+
+ /**
+  * @brief Number of unfinished jobs submitted against it; see JobSystem::wait().
+  */
+ class
+  JobCounter {
+  public:
+  JobCounter() : m_value(0) {}
+  JobCounter(const JobCounter&) = delete;
+  JobCounter& operator=(const JobCounter&) = delete;
+
+  /** @brief True once every job submitted against it has finished. */
+  bool
+   done() const {
+   return m_value.load(std::memory_order_acquire) == 0;
+  }
+
+  private:
+  friend class JobSystem;
+  std::atomic<uint32_t> m_value;
+ };
+
+ namespace detail {
+  /// Empty polls before a worker goes to sleep.
+  constexpr uint32_t JOB_SPIN = 64;
+  /// Busy pool slots skipped before a submission gives up and runs its job inline.
+  constexpr size_t JOB_ALLOCATE_TRIES = 16;
+
+  /** One pooled job: the callable inline, its type-erased runner and its counter. */
+  struct Job {
+   void (*invoke)(Job&);
+   JobCounter* counter;
+   std::atomic<bool> busy;
+   alignas(8) unsigned char data[JOB_DATA_SIZE];
+  };
+
+  static_assert(sizeof(Job) == 64, "a job should fill one cache line");
+
+  /** JOB_QUEUE_SIZE jobs on cache-line boundaries, handed out round-robin. */
+  class
+   JobPool {
+   public:
+   JobPool() : m_storage(new unsigned char[JOB_QUEUE_SIZE * sizeof(Job) + 64]), m_cursor(0) {
+    const uintptr_t base = reinterpret_cast<uintptr_t>(m_storage.get());
+    m_jobs = reinterpret_cast<Job*>((base + 63) & ~uintptr_t(63));
+    for (size_t i = 0; i < JOB_QUEUE_SIZE; ++i) new (&m_jobs[i]) Job();
+   }
+
+   /**
+    * Next free job, marked busy, or nullptr when the next JOB_ALLOCATE_TRIES are all busy
+    * (the pool is saturated); one thread at a time.
+    */
+   Job*
+    allocate() {
+    for (size_t tries = 0; tries < JOB_ALLOCATE_TRIES; ++tries) {
+     Job& job = m_jobs[m_cursor++ & (JOB_QUEUE_SIZE - 1)];
+     if (!job.busy.load(std::memory_order_acquire)) {
+      job.busy.store(true, std::memory_order_relaxed);
+      return &job;
+     }
+    }
+    return nullptr;
+   }
+
+   private:
+   std::unique_ptr<unsigned char[]> m_storage;
+   Job* m_jobs;
+   size_t m_cursor;
+  };
+
+  template<typename Fn>
+  inline void
+   invokeJob(Job& job) {
+   Fn& fn = *reinterpret_cast<Fn*>(job.data);
+   fn();
+   fn.~Fn();
+  }
+
+  /**
+   * Fixed-capacity Chase-Lev deque: the owner pushes and pops at the bottom, any thread
+   * steals from the top.
+   */
+  class
+   JobDeque {
+   public:
+   JobDeque() : m_top(0), m_bottom(0) {
+    for (std::atomic<Job*>& slot : m_slots) slot.store(nullptr, std::memory_order_relaxed);
+   }
+
+   /** Owner only; false when full. */
+   bool
+    push(Job* job) {
+    const int64_t b = m_bottom.load(std::memory_order_relaxed);
+    const int64_t t = m_top.load(std::memory_order_acquire);
+    if (b - t >= static_cast<int64_t>(JOB_QUEUE_SIZE)) return false;
+    m_slots[static_cast<size_t>(b) & (JOB_QUEUE_SIZE - 1)].store(job, std::memory_order_relaxed);
+    m_bottom.store(b + 1, std::memory_order_release);
+    return true;
+   }
+
+   /** Owner only; newest job, or nullptr. */
+   Job*
+    pop() {
+    const int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = m_top.load(std::memory_order_relaxed);
+    if (t > b) {
+     m_bottom.store(b + 1, std::memory_order_relaxed);
+     return nullptr;
+    }
+    Job* job = m_slots[static_cast<size_t>(b) & (JOB_QUEUE_SIZE - 1)].load(std::memory_order_relaxed);
+    if (t == b) {
+     // Last job: race the thieves for it.
+     if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+     m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+   }
+
+   /** Any thread; oldest job, or nullptr when empty or lost to another thief. */
+   Job*
+    steal() {
+    int64_t t = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = m_bottom.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+    Job* job = m_slots[static_cast<size_t>(t) & (JOB_QUEUE_SIZE - 1)].load(std::memory_order_relaxed);
+    if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+    return job;
+   }
+
+   private:
+   // Padded apart so thieves hitting m_top do not invalidate the owner's m_bottom.
+   std::atomic<int64_t> m_top;
+   unsigned char m_padTop[64];
+   std::atomic<int64_t> m_bottom;
+   unsigned char m_padBottom[64];
+   std::atomic<Job*> m_slots[JOB_QUEUE_SIZE];
+  };
+
+  /** Worker index of the calling thread within system, or SIZE_MAX outside it. */
+  struct JobThread {
+   const JobSystem* system;
+   size_t index;
+  };
+
+  inline JobThread&
+   currentJobThread() {
+   static thread_local JobThread thread = { nullptr, ~size_t(0) };
+   return thread;
+  }
+ }
+
+ /**
+  * @class JobSystem
+  * @brief Pool of worker threads running jobs from per-thread work-stealing deques.
+  */
+ class
+  JobSystem {
+  public:
+  /**
+   * @brief Starts threads - 1 workers (0 for every hardware thread); the calling thread is
+   * worker 0.
+   * @param flushDenormals Run jobs with FTZ/DAZ set; false leaves every thread's float mode alone.
+   */
+  explicit JobSystem(size_t threads = 0, bool flushDenormals = true)
+   : m_stop(false), m_epoch(0), m_sleepers(0), m_externalTop(0), m_externalBottom(0), m_externalCount(0),
+     m_flushDenormals(flushDenormals) {
+   const size_t count = detail::resolveThreads(threads, ~size_t(0));
+   m_workers.reserve(count);
+   for (size_t i = 0; i < count; ++i) m_workers.emplace_back(new Worker());
+   m_externalQueue.resize(JOB_QUEUE_SIZE);
+   m_previousThread = detail::currentJobThread();
+   detail::currentJobThread() = { this, 0 };
+   for (size_t i = 1; i < count; ++i) {
+    try {
+     m_threads.emplace_back([this, i]() { workerLoop(i); });
+    }
+    catch (...) {
+     break;
+    }
+   }
+  }
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  /** @brief Runs what is still queued, then joins the workers. */
+  ~JobSystem() {
+   if (detail::taskBackend().context == this) detail::taskBackend() = detail::TaskBackend();
+   for (detail::Job* job = findJob(0); job; job = findJob(0)) execute(job);
+   m_stop.store(true);
+   wakeAll();
+   for (std::thread& thread : m_threads) thread.join();
+   if (detail::currentJobThread().system == this) detail::currentJobThread() = m_previousThread;
+  }
+
+  /** @brief Workers, worker 0 (the constructing thread) included. */
+  size_t
+   threadCount() const {
+   return m_threads.size() + 1;
+  }
+
+  /**
+   * @brief Queues fn() to run on some worker, counted into counter until it finishes.
+   *
+   * fn must fit in JOB_DATA_SIZE bytes; capture by reference or pointer. When the pool or
+   * the deque is full, fn runs right away on the calling thread.
+   */
+  template<typename Fn>
+  void
+   run(Fn fn, JobCounter& counter) {
+   static_assert(sizeof(Fn) <= JOB_DATA_SIZE, "job callable too large; capture less or by pointer");
+   static_assert(alignof(Fn) <= 8, "job callable over-aligned");
+   counter.m_value.fetch_add(1, std::memory_order_relaxed);
+   const size_t self = workerIndex();
+   detail::Job* job = self < m_workers.size() ? m_workers[self]->jobs.allocate() : allocateExternal();
+   if (!job) {
+    const DenormalGuard guard(m_flushDenormals);
+    fn();
+    counter.m_value.fetch_sub(1, std::memory_order_release);
+    return;
+   }
+   new (job->data) Fn(std::move(fn));
+   job->invoke = &detail::invokeJob<Fn>;
+   job->counter = &counter;
+   const bool queued = self < m_workers.size() ? m_workers[self]->deque.push(job) : pushExternal(job);
+   if (!queued) {
+    const DenormalGuard guard(m_flushDenormals);
+    execute(job);
+    return;
+   }
+   m_epoch.fetch_add(1);
+   if (m_sleepers.load() > 0) {
+    std::lock_guard<std::mutex> lock(m_sleepMutex);
+    m_wake.notify_one();
+   }
+  }
+
+  /**
+   * @brief Returns once every job counted into counter has finished, running pending jobs
+   * on the calling thread in the meantime.
+   */
+  void
+   wait(const JobCounter& counter) {
+   EU_TRACE_ZONE("JobSystem::wait");
+   const DenormalGuard guard(m_flushDenormals);
+   const size_t self = workerIndex();
+   uint32_t idle = 0;
+   while (!counter.done()) {
+    if (detail::Job* job = findJob(self)) {
+     execute(job);
+     idle = 0;
+    }
+    else if (++idle > detail::JOB_SPIN) {
+     std::this_thread::yield();
+    }
+   }
+  }
+
+  /**
+   * @brief Calls fn(first, last) over [begin, end) in pieces of grain indices, across the
+   * workers, and returns when all are done.
+   * @param grain Indices per job; 0 picks about four jobs per worker. A fixed grain keeps
+   * the split independent of the thread count.
+   */
+  template<typename Fn>
+  void
+   parallelFor(size_t begin, size_t end, size_t grain, const Fn& fn) {
+   if (begin >= end) return;
+   const size_t count = end - begin;
+   if (grain == 0) grain = std::max<size_t>(1, count / (4 * threadCount()));
+   const DenormalGuard guard(m_flushDenormals);
+   if (count <= grain) {
+    fn(begin, end);
+    return;
+   }
+   JobCounter counter;
+   const Fn* body = &fn;
+   for (size_t first = begin + grain; first < end; first += grain) {
+    const size_t last = std::min(first + grain, end);
+    run([body, first, last]() { (*body)(first, last); }, counter);
+   }
+   fn(begin, begin + grain);
+   wait(counter);
+  }
+
+  /**
+   * @brief Makes detail::parallelTasks() run on these workers instead of starting threads,
+   * until the JobSystem is destroyed or another one takes over.
+   */
+  void
+   useForParallelTasks() {
+   detail::TaskBackend backend;
+   backend.context = this;
+   backend.run = &JobSystem::runTasks;
+   detail::taskBackend() = backend;
+  }
+
+  private:
+  struct Worker {
+   detail::JobDeque deque;
+   detail::JobPool jobs;
+  };
+
+  size_t
+   workerIndex() const {
+   const detail::JobThread& thread = detail::currentJobThread();
+   return thread.system == this ? thread.index : ~size_t(0);
+  }
+
+  detail::Job*
+   allocateExternal() {
+   std::lock_guard<std::mutex> lock(m_externalMutex);
+   return m_external.allocate();
+  }
+
+  bool
+   pushExternal(detail::Job* job) {
+   std::lock_guard<std::mutex> lock(m_externalMutex);
+   if (m_externalBottom - m_externalTop >= JOB_QUEUE_SIZE) return false;
+   m_externalQueue[m_externalBottom++ & (JOB_QUEUE_SIZE - 1)] = job;
+   m_externalCount.store(m_externalBottom - m_externalTop, std::memory_order_release);
+   return true;
+  }
+
+  detail::Job*
+   popExternal() {
+   if (m_externalCount.load(std::memory_order_acquire) == 0) return nullptr;
+   std::lock_guard<std::mutex> lock(m_externalMutex);
+   if (m_externalTop == m_externalBottom) return nullptr;
+   detail::Job* job = m_externalQueue[m_externalTop++ & (JOB_QUEUE_SIZE - 1)];
+   m_externalCount.store(m_externalBottom - m_externalTop, std::memory_order_release);
+   return job;
+  }
+
+  /** Own deque first, then the external queue, then the other workers from self + 1 on. */
+  detail::Job*
+   findJob(size_t self) {
+   const size_t count = m_workers.size();
+   if (self < count) {
+    if (detail::Job* job = m_workers[self]->deque.pop()) return job;
+   }
+   if (detail::Job* job = popExternal()) return job;
+   const size_t start = self < count ? self + 1 : 0;
+   for (size_t i = 0; i < count; ++i) {
+    const size_t victim = (start + i) % count;
+    if (victim == self) continue;
+    if (detail::Job* job = m_workers[victim]->deque.steal()) return job;
+   }
+   return nullptr;
+  }
+
+  static void
+   execute(detail::Job* job) {
+   {
+    EU_TRACE_ZONE("Job");
+    job->invoke(*job);
+   }
+   JobCounter* counter = job->counter;
+   job->busy.store(false, std::memory_order_release);
+   counter->m_value.fetch_sub(1, std::memory_order_acq_rel);
+  }
+
+  void
+   workerLoop(size_t index) {
+   detail::currentJobThread() = { this, index };
+   EU_TRACE_THREAD_NAME("Job worker");
+   const DenormalGuard guard(m_flushDenormals);
+   for (;;) {
+    detail::Job* job = nullptr;
+    for (uint32_t spin = 0; spin < detail::JOB_SPIN && !job; ++spin) {
+     job = findJob(index);
+     if (!job) std::this_thread::yield();
+    }
+    if (job) {
+     execute(job);
+     continue;
+    }
+    // Sleep until a submission moves the epoch past the last empty search.
+    const uint64_t epoch = m_epoch.load();
+    if ((job = findJob(index)) != nullptr) {
+     execute(job);
+     continue;
+    }
+    if (m_stop.load()) return;
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_sleepers.fetch_add(1);
+    while (m_epoch.load() == epoch && !m_stop.load()) m_wake.wait(lock);
+    m_sleepers.fetch_sub(1);
+   }
+  }
+
+  void
+   wakeAll() {
+   m_epoch.fetch_add(1);
+   std::lock_guard<std::mutex> lock(m_sleepMutex);
+   m_wake.notify_all();
+  }
+
+  /** detail::TaskBackend::run: work() on up to helpers workers and the caller. */
+  static void
+   runTasks(void* context, size_t helpers, void (*work)(void*), void* data) {
+   JobSystem& system = *static_cast<JobSystem*>(context);
+   JobCounter counter;
+   helpers = std::min(helpers, system.threadCount() - 1);
+   const DenormalGuard guard(system.m_flushDenormals);
+   for (size_t i = 0; i < helpers; ++i) system.run([work, data]() { work(data); }, counter);
+   work(data);
+   system.wait(counter);
+  }
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::vector<std::thread> m_threads;
+  std::atomic<bool> m_stop;
+  std::atomic<uint64_t> m_epoch;   ///< Bumped by every submission; sleepers wait for it to move
+  std::atomic<int> m_sleepers;
+  std::mutex m_sleepMutex;
+  std::condition_variable m_wake;
+  std::mutex m_externalMutex;      ///< Guards the external pool and queue
+  detail::JobPool m_external;
+  std::vector<detail::Job*> m_externalQueue;
+  size_t m_externalTop;
+  size_t m_externalBottom;
+  std::atomic<size_t> m_externalCount;
+  detail::JobThread m_previousThread;
+  bool m_flushDenormals;           ///< Jobs run under a DenormalGuard
+ };
+}
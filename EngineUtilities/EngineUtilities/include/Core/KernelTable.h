@@ -0,0 +1,57 @@
+/**
+ * @file KernelTable.h
+ * @brief Function-pointer table of the batch kernels, one instance per compiled ISA tier.
+ *
+ * The table only speaks plain float and index arrays, so it can be filled by a translation
+ * unit that sees the math headers built for a different instruction set than the rest of the
+ * program (see src/Dispatch/Kernels.inl). Use the typed front end in Dispatch.h.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/CPUFeatures.h>
+
+namespace EU {
+ namespace Dispatch {
+  /**
+   * @brief Entry points of one kernel build. Vectors are packed xyz floats unless split into
+   * x, y and z arrays; matrices are row-major (16 floats for a Matrix4x4, 12 for an Affine3x4);
+   * planes are Frustum::planes, 24 floats.
+   */
+  struct KernelTable {
+   const char* name; ///< "Scalar", "Baseline", "SSE4.1" or "AVX2"
+   CpuTier tier;     ///< Instruction set the table was actually compiled for
+   bool simd;        ///< False when the unit had neither SSE2 nor NEON and runs the scalar fallback
+
+   void (*sin)(const float* in, float* out, size_t n);
+   void (*cos)(const float* in, float* out, size_t n);
+   void (*sincos)(const float* in, float* s, float* c, size_t n);
+
+   void (*normalize3)(const float* in, float* out, size_t n);
+   void (*normalize3SoA)(const float* x, const float* y, const float* z, float* ox, float* oy, float* oz, size_t n);
+
+   void (*transformPoints)(const float* in, float* out, size_t n, const float* matrix);
+
+   size_t (*cullSpheres)(const float* planes, const float* x, const float* y, const float* z, const float* radii,
+                         size_t begin, size_t end, uint32_t* out);
+   size_t (*cullBoxes)(const float* planes, const float* lx, const float* ly, const float* lz, const float* hx,
+                       const float* hy, const float* hz, size_t begin, size_t end, uint32_t* out);
+
+   /// influences points to BoneInfluences, palette to Affine3x4 matrices; bounds, when not null,
+   /// receives the AABB of the skinned positions as min xyz, max xyz.
+   void (*skinPositions)(const float* in, float* out, size_t n, const void* influences, const float* palette,
+                         float* bounds);
+   void (*skinVertices)(const float* positions, const float* normals, float* outPositions, float* outNormals,
+                        size_t n, const void* influences, const float* palette, float* bounds);
+  };
+
+  namespace detail {
+   /// Defined in src/Dispatch/KernelsBaseline.cpp, KernelsSSE41.cpp and KernelsAVX2.cpp.
+   const KernelTable& kernelTableBaseline();
+   const KernelTable& kernelTableSSE41();
+   const KernelTable& kernelTableAVX2();
+  }
+ }
+}
@@ -0,0 +1,375 @@
+/**
+ * @file PackFile.h
+ * @brief Versioned binary container whose sections are used in place from a memory mapping.
+ *
+ * A pack is a PackHeader, the section payloads, and a table of PackSection entries at the
+ * end. Every payload starts on a PACK_ALIGNMENT boundary and everything is addressed by
+ * offsets from the start of the file (or, inside a section, from the start of the section),
+ * so a mapped file needs no pointer fix-ups: PackView checks the header and the table once
+ * and then hands out pointers straight into the mapping. Loading costs the page faults of
+ * the data actually touched.
+ *
+ * Sections are identified by a four-character tag and a caller-chosen id, e.g. the mesh or
+ * clip number. A plain section is an array of trivially copyable elements; composite
+ * sections (see PackTypes.h) start with a small header of offsets to their sub-arrays.
+ *
+ * Files are written in the byte order of the machine that writes them and rejected by
+ * readers of the other order. PACK_VERSION changes whenever the layout of a header or of a
+ * PackTypes.h section does; older files are rejected rather than migrated.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#if defined(_WIN32)
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+namespace EU {
+ /// Layout version written to and required of every pack.
+ constexpr uint32_t PACK_VERSION = 1;
+ /// Alignment of every section and sub-array: a cache line, and enough for any SIMD load.
+ constexpr size_t PACK_ALIGNMENT = 64;
+ /// Byte-order marker as the writer stored it.
+ constexpr uint32_t PACK_BYTE_ORDER = 0x01020304u;
+
+ /** @brief Four-character section tag, first character in the lowest byte. */
+ constexpr uint32_t
+  packTag(char a, char b, char c, char d) {
+  return uint32_t(uint8_t(a)) | uint32_t(uint8_t(b)) << 8 | uint32_t(uint8_t(c)) << 16 | uint32_t(uint8_t(d)) << 24;
+ }
+
+ /**
+  * @brief First 40 bytes of a pack.
+  */
+ struct PackHeader {
+  char magic[4];         ///< "EUPK"
+  uint32_t version;      ///< PACK_VERSION
+  uint32_t byteOrder;    ///< PACK_BYTE_ORDER
+  uint32_t sectionCount;
+  uint64_t fileSize;
+  uint64_t tableOffset;  ///< Offset of the PackSection table
+  uint64_t reserved;
+ };
+
+ /**
+  * @brief Table entry of one section.
+  */
+ struct PackSection {
+  uint32_t tag;
+  uint32_t id;
+  uint64_t offset;      ///< From the start of the file; a multiple of PACK_ALIGNMENT
+  uint64_t size;        ///< Bytes
+  uint64_t count;       ///< Elements of a plain section; meaning set by a composite one
+  uint32_t elementSize; ///< sizeof the element of a plain section, 0 for a composite one
+  uint32_t reserved;
+ };
+
+ static_assert(sizeof(PackHeader) == 40 && sizeof(PackSection) == 40, "pack headers have a fixed layout");
+
+ /**
+  * @class PackWriter
+  * @brief Builds a pack in memory, section by section.
+  */
+ class
+  PackWriter {
+  public:
+  PackWriter() : m_open(false) {
+   m_bytes.resize(sizeof(PackHeader));
+  }
+
+  /** @brief Appends a plain section holding count elements of T. */
+  template<typename T>
+  void
+   addArray(uint32_t tag, uint32_t id, const T* data, size_t count) {
+   static_assert(std::is_trivially_copyable<T>::value, "pack sections hold raw bytes");
+   beginSection(tag, id, sizeof(T));
+   append(data, count * sizeof(T));
+   endSection(count);
+  }
+
+  /**
+   * @brief Starts a section; append() its contents, then endSection(). elementSize is 0 for
+   * composite sections.
+   */
+  void
+   beginSection(uint32_t tag, uint32_t id, uint32_t elementSize = 0) {
+   pad();
+   m_section = PackSection{ tag, id, m_bytes.size(), 0, 0, elementSize, 0 };
+   m_open = true;
+  }
+
+  /**
+   * @brief Appends bytes to the open section at the next PACK_ALIGNMENT boundary; returns
+   * their offset from the start of the section.
+   */
+  size_t
+   append(const void* data, size_t bytes) {
+   pad();
+   const size_t at = m_bytes.size();
+   m_bytes.resize(at + bytes);
+   if (bytes) std::memcpy(m_bytes.data() + at, data, bytes);
+   return at - static_cast<size_t>(m_section.offset);
+  }
+
+  /** @brief Overwrites bytes at offset within the open section, e.g. a header appended first. */
+  void
+   patch(size_t offset, const void* data, size_t bytes) {
+   std::memcpy(m_bytes.data() + m_section.offset + offset, data, bytes);
+  }
+
+  void
+   endSection(uint64_t count) {
+   m_section.size = m_bytes.size() - m_section.offset;
+   m_section.count = count;
+   m_sections.push_back(m_section);
+   m_open = false;
+  }
+
+  /** @brief The complete pack; further sections may still be added afterwards. */
+  std::vector<unsigned char>
+   finish() const {
+   std::vector<unsigned char> out(m_bytes);
+   out.resize((out.size() + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1), 0);
+   PackHeader header = {};
+   std::memcpy(header.magic, "EUPK", 4);
+   header.version = PACK_VERSION;
+   header.byteOrder = PACK_BYTE_ORDER;
+   header.sectionCount = static_cast<uint32_t>(m_sections.size());
+   header.tableOffset = out.size();
+   header.fileSize = out.size() + m_sections.size() * sizeof(PackSection);
+   out.resize(static_cast<size_t>(header.fileSize));
+   if (!m_sections.empty()) {
+    std::memcpy(out.data() + header.tableOffset, m_sections.data(), m_sections.size() * sizeof(PackSection));
+   }
+   std::memcpy(out.data(), &header, sizeof(header));
+   return out;
+  }
+
+  /** @brief Writes finish() to path; false if the file cannot be written. */
+  bool
+   save(const char* path) const {
+   const std::vector<unsigned char> bytes = finish();
+   std::FILE* file = std::fopen(path, "wb");
+   if (file == nullptr) return false;
+   const bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+   return std::fclose(file) == 0 && written;
+  }
+
+  private:
+  void
+   pad() {
+   m_bytes.resize((m_bytes.size() + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1), 0);
+  }
+
+  std::vector<unsigned char> m_bytes;
+  std::vector<PackSection> m_sections;
+  PackSection m_section = {};
+  bool m_open;
+ };
+
+ /**
+  * @class PackView
+  * @brief Validated read-only view of a pack in memory; the memory must outlive the view.
+  */
+ class
+  PackView {
+  public:
+  PackView() : m_data(nullptr), m_size(0), m_sections(nullptr), m_count(0) {}
+
+  /**
+   * @brief Checks the header, the table and every section's bounds and alignment. Returns
+   * false (and leaves the view empty) for anything that is not a PACK_VERSION pack of this
+   * byte order, wholly inside [data, data + size). data must be PACK_ALIGNMENT-aligned, as a
+   * mapping always is.
+   */
+  bool
+   open(const void* data, size_t size) {
+   *this = PackView();
+   const unsigned char* bytes = static_cast<const unsigned char*>(data);
+   if (bytes == nullptr || size < sizeof(PackHeader) || reinterpret_cast<uintptr_t>(bytes) % PACK_ALIGNMENT) {
+    return false;
+   }
+   PackHeader header;
+   std::memcpy(&header, bytes, sizeof(header));
+   if (std::memcmp(header.magic, "EUPK", 4) != 0 || header.version != PACK_VERSION ||
+       header.byteOrder != PACK_BYTE_ORDER || header.fileSize > size || header.tableOffset % 8 != 0 ||
+       header.tableOffset > header.fileSize ||
+       (header.fileSize - header.tableOffset) / sizeof(PackSection) < header.sectionCount) {
+    return false;
+   }
+   const PackSection* sections = reinterpret_cast<const PackSection*>(bytes + header.tableOffset);
+   for (uint32_t i = 0; i < header.sectionCount; ++i) {
+    const PackSection& s = sections[i];
+    if (s.offset % PACK_ALIGNMENT != 0 || s.offset > header.tableOffset || s.size > header.tableOffset - s.offset) {
+     return false;
+    }
+    if (s.elementSize != 0 && s.count > s.size / s.elementSize) return false;
+   }
+   m_data = bytes;
+   m_size = static_cast<size_t>(header.fileSize);
+   m_sections = sections;
+   m_count = header.sectionCount;
+   return true;
+  }
+
+  /** @brief True once open() has succeeded. */
+  bool
+   valid() const {
+   return m_data != nullptr;
+  }
+
+  size_t
+   sectionCount() const {
+   return m_count;
+  }
+
+  const PackSection&
+   section(size_t i) const {
+   return m_sections[i];
+  }
+
+  /** @brief The section with tag and id, or nullptr. */
+  const PackSection*
+   find(uint32_t tag, uint32_t id) const {
+   for (size_t i = 0; i < m_count; ++i) {
+    if (m_sections[i].tag == tag && m_sections[i].id == id) return &m_sections[i];
+   }
+   return nullptr;
+  }
+
+  /** @brief First byte of section. */
+  const unsigned char*
+   data(const PackSection& section) const {
+   return m_data + section.offset;
+  }
+
+  /**
+   * @brief Elements of the plain section tag/id in place, with count set; nullptr (count 0)
+   * when it is missing or does not hold T-sized elements.
+   */
+  template<typename T>
+  const T*
+   array(uint32_t tag, uint32_t id, size_t& count) const {
+   static_assert(std::is_trivially_copyable<T>::value, "pack sections hold raw bytes");
+   static_assert(alignof(T) <= PACK_ALIGNMENT, "sections are only PACK_ALIGNMENT-aligned");
+   count = 0;
+   const PackSection* s = find(tag, id);
+   if (s == nullptr || s->elementSize != sizeof(T)) return nullptr;
+   count = static_cast<size_t>(s->count);
+   return reinterpret_cast<const T*>(data(*s));
+  }
+
+  /**
+   * @brief Sub-array of count Ts at offset within section, or nullptr when it would not
+   * lie inside the section or is misaligned; for reading composite sections.
+   */
+  template<typename T>
+  const T*
+   subArray(const PackSection& section, uint64_t offset, uint64_t count) const {
+   if (offset % alignof(T) != 0 || offset > section.size || count > (section.size - offset) / sizeof(T)) {
+    return nullptr;
+   }
+   return reinterpret_cast<const T*>(data(section) + offset);
+  }
+
+  private:
+  const unsigned char* m_data;
+  size_t m_size;
+  const PackSection* m_sections;
+  size_t m_count;
+ };
+
+ /**
+  * @class MappedFile
+  * @brief Read-only memory mapping of a whole file.
+  */
+ class
+  MappedFile {
+  public:
+  MappedFile() : m_data(nullptr), m_size(0) {}
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile() {
+   close();
+  }
+
+  /** @brief Maps path; false if it cannot be opened, is empty or cannot be mapped. */
+  bool
+   open(const char* path) {
+   close();
+#if defined(_WIN32)
+   HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+   if (file == INVALID_HANDLE_VALUE) return false;
+   LARGE_INTEGER size;
+   HANDLE mapping = nullptr;
+   if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+   }
+   CloseHandle(file);
+   if (mapping == nullptr) return false;
+   m_data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+   CloseHandle(mapping);
+   if (m_data == nullptr) return false;
+   m_size = static_cast<size_t>(size.QuadPart);
+#else
+   const int fd = ::open(path, O_RDONLY);
+   if (fd < 0) return false;
+   struct stat info;
+   void* data = MAP_FAILED;
+   if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+   }
+   ::close(fd);
+   if (data == MAP_FAILED) return false;
+   m_data = data;
+   m_size = static_cast<size_t>(info.st_size);
+#endif
+   return true;
+  }
+
+  void
+   close() {
+   if (m_data == nullptr) return;
+#if defined(_WIN32)
+   UnmapViewOfFile(m_data);
+#else
+   munmap(m_data, m_size);
+#endif
+   m_data = nullptr;
+   m_size = 0;
+  }
+
+  const void*
+   data() const {
+   return m_data;
+  }
+
+  size_t
+   size() const {
+   return m_size;
+  }
+
+  private:
+  void* m_data;
+  size_t m_size;
+ };
+}
@@ -0,0 +1,173 @@
+/**
+ * @file PackTypes.h
+ * @brief Pack file sections for the in-place data types: SoA position streams, Affine3x4
+ * arrays, compressed animation clips and BVHs.
+ *
+ * Each addX() writes one section through a PackWriter and the matching findX() returns a
+ * view straight into a PackView, with no copy. Composite sections begin with a header of
+ * offsets, relative to the section, to their sub-arrays; the readers check every sub-array
+ * against the section bounds before handing out a view and return an empty one otherwise.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/PackFile.h>
+#include <Core/Platform.h>
+#include <Geometry/BVH.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/AnimationClip.h>
+
+namespace EU {
+ /// Default section tags; any other tag works as well.
+ constexpr uint32_t PACK_POSITIONS = packTag('P', 'O', 'S', '3');
+ constexpr uint32_t PACK_TRANSFORMS = packTag('A', 'F', 'F', '4');
+ constexpr uint32_t PACK_CLIP = packTag('C', 'L', 'I', 'P');
+ constexpr uint32_t PACK_BVH = packTag('B', 'V', 'H', '2');
+
+ /** @brief Header of a position section: count points as x, y and z float arrays. */
+ struct PackStreamHeader {
+  uint64_t count;
+  uint64_t offset[3];
+ };
+
+ /** @brief Header of a clip section. */
+ struct PackClipHeader {
+  AnimationClipLayout layout;
+  uint32_t reserved;
+  uint64_t keyOffset;
+  uint64_t rangeOffset;
+ };
+
+ /** @brief Header of a BVH section; corners are [corner][axis] float arrays. */
+ struct PackBVHHeader {
+  uint64_t nodeCount;
+  uint64_t triangleCount;
+  uint64_t nodeOffset;
+  uint64_t cornerOffset[9];
+  uint64_t idOffset;
+ };
+
+ EU_ASSERT_VALUE_TYPE(PackStreamHeader);
+ EU_ASSERT_VALUE_TYPE(PackClipHeader);
+ EU_ASSERT_VALUE_TYPE(PackBVHHeader);
+
+ /** @brief Writes count points, e.g. Vector3Stream::soa(), as SoA arrays. */
+ inline void
+  addPositions(PackWriter& writer, uint32_t id, EngineMath::batch::ConstSoA3 points, size_t count,
+               uint32_t tag = PACK_POSITIONS) {
+  PackStreamHeader header = {};
+  header.count = count;
+  writer.beginSection(tag, id);
+  writer.append(&header, sizeof(header));
+  header.offset[0] = writer.append(points.x, count * sizeof(float));
+  header.offset[1] = writer.append(points.y, count * sizeof(float));
+  header.offset[2] = writer.append(points.z, count * sizeof(float));
+  writer.patch(0, &header, sizeof(header));
+  writer.endSection(count);
+ }
+
+ /** @brief Positions of section tag/id in place, each array PACK_ALIGNMENT-aligned; false if absent or invalid. */
+ inline bool
+  findPositions(const PackView& pack, uint32_t id, EngineMath::batch::ConstSoA3& points, size_t& count,
+                uint32_t tag = PACK_POSITIONS) {
+  count = 0;
+  const PackSection* section = pack.find(tag, id);
+  const PackStreamHeader* header = section ? pack.subArray<PackStreamHeader>(*section, 0, 1) : nullptr;
+  if (header == nullptr) return false;
+  const float* axes[3];
+  for (size_t a = 0; a < 3; ++a) {
+   axes[a] = pack.subArray<float>(*section, header->offset[a], header->count);
+   if (axes[a] == nullptr) return false;
+  }
+  points = { axes[0], axes[1], axes[2] };
+  count = static_cast<size_t>(header->count);
+  return true;
+ }
+
+ /** @brief Writes count transforms as a plain section. */
+ inline void
+  addTransforms(PackWriter& writer, uint32_t id, const Affine3x4* transforms, size_t count,
+                uint32_t tag = PACK_TRANSFORMS) {
+  writer.addArray(tag, id, transforms, count);
+ }
+
+ /** @brief Transforms of section tag/id in place, or nullptr. */
+ inline const Affine3x4*
+  findTransforms(const PackView& pack, uint32_t id, size_t& count, uint32_t tag = PACK_TRANSFORMS) {
+  return pack.array<Affine3x4>(tag, id, count);
+ }
+
+ /** @brief Writes a compressed clip, e.g. AnimationClip::view(). */
+ inline void
+  addClip(PackWriter& writer, uint32_t id, const AnimationClipView& clip, uint32_t tag = PACK_CLIP) {
+  const AnimationClipLayout& layout = clip.layout();
+  PackClipHeader header = {};
+  header.layout = layout;
+  writer.beginSection(tag, id);
+  writer.append(&header, sizeof(header));
+  header.keyOffset = writer.append(clip.keys(), layout.keyWords() * sizeof(uint16_t));
+  header.rangeOffset = writer.append(clip.ranges(), layout.rangeFloats() * sizeof(float));
+  writer.patch(0, &header, sizeof(header));
+  writer.endSection(layout.boneCount);
+ }
+
+ /** @brief Clip of section tag/id, sampling straight from the pack; false if absent or invalid. */
+ inline bool
+  findClip(const PackView& pack, uint32_t id, AnimationClipView& clip, uint32_t tag = PACK_CLIP) {
+  const PackSection* section = pack.find(tag, id);
+  const PackClipHeader* header = section ? pack.subArray<PackClipHeader>(*section, 0, 1) : nullptr;
+  if (header == nullptr) return false;
+  const AnimationClipLayout& layout = header->layout;
+  if (layout.segmentFrames == 0 || layout.frameCount > (1u << 24) || layout.boneCount > (1u << 16)) return false;
+  const uint16_t* keys = pack.subArray<uint16_t>(*section, header->keyOffset, layout.keyWords());
+  const float* ranges = pack.subArray<float>(*section, header->rangeOffset, layout.rangeFloats());
+  if (keys == nullptr || ranges == nullptr) return false;
+  clip = AnimationClipView(layout, keys, ranges);
+  return true;
+ }
+
+ /** @brief Writes a built BVH, e.g. BVH::view(). */
+ inline void
+  addBVH(PackWriter& writer, uint32_t id, const BVHView& bvh, uint32_t tag = PACK_BVH) {
+  const detail::BVHTriangleView& triangles = bvh.triangles();
+  PackBVHHeader header = {};
+  header.nodeCount = bvh.nodeCount();
+  header.triangleCount = triangles.count;
+  writer.beginSection(tag, id);
+  writer.append(&header, sizeof(header));
+  header.nodeOffset = writer.append(bvh.nodes(), bvh.nodeCount() * sizeof(BVHNode));
+  for (size_t c = 0; c < 3; ++c)
+   for (size_t a = 0; a < 3; ++a)
+    header.cornerOffset[3 * c + a] = writer.append(triangles.corner[c][a], triangles.count * sizeof(float));
+  header.idOffset = writer.append(triangles.ids, triangles.count * sizeof(uint32_t));
+  writer.patch(0, &header, sizeof(header));
+  writer.endSection(header.nodeCount);
+ }
+
+ /**
+  * @brief BVH of section tag/id, queried straight from the pack; false if absent or
+  * invalid. Node contents are trusted: a pack must come from addBVH().
+  */
+ inline bool
+  findBVH(const PackView& pack, uint32_t id, BVHView& bvh, uint32_t tag = PACK_BVH) {
+  const PackSection* section = pack.find(tag, id);
+  const PackBVHHeader* header = section ? pack.subArray<PackBVHHeader>(*section, 0, 1) : nullptr;
+  if (header == nullptr) return false;
+  const BVHNode* nodes = pack.subArray<BVHNode>(*section, header->nodeOffset, header->nodeCount);
+  detail::BVHTriangleView triangles;
+  triangles.ids = pack.subArray<uint32_t>(*section, header->idOffset, header->triangleCount);
+  triangles.count = static_cast<size_t>(header->triangleCount);
+  if (nodes == nullptr || triangles.ids == nullptr) return false;
+  for (size_t c = 0; c < 3; ++c) {
+   for (size_t a = 0; a < 3; ++a) {
+    triangles.corner[c][a] = pack.subArray<float>(*section, header->cornerOffset[3 * c + a], header->triangleCount);
+    if (triangles.corner[c][a] == nullptr) return false;
+   }
+  }
+  bvh = BVHView(nodes, static_cast<size_t>(header->nodeCount), triangles);
+  return true;
+ }
+}
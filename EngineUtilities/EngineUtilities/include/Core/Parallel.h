@@ -0,0 +1,77 @@
+/**
+ * @file Parallel.h
+ * @brief Minimal fork-join helper for the batch kernels that split large inputs across threads.
+ *
+ * Work is described as a number of independent tasks. Callers size the tasks themselves
+ * (usually fixed-size chunks of the input), so the split never depends on the thread count.
+ * Threads are started per call unless a TaskBackend is installed (see
+ * JobSystem::useForParallelTasks()), which lends its workers instead.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace EU {
+ namespace detail {
+  /** threads, with 0 meaning std::thread::hardware_concurrency(), capped to tasks and at least 1. */
+  inline size_t
+   resolveThreads(size_t threads, size_t tasks) {
+   if (threads == 0) threads = std::thread::hardware_concurrency();
+   if (threads > tasks) threads = tasks;
+   return threads == 0 ? 1 : threads;
+  }
+
+  /**
+   * Pool parallelTasks() runs on when run is set: run(context, helpers, work, data) calls
+   * work(data) on up to helpers threads of the pool as well as on the calling thread, and
+   * returns once every call has returned.
+   */
+  struct TaskBackend {
+   void* context = nullptr;
+   void (*run)(void* context, size_t helpers, void (*work)(void*), void* data) = nullptr;
+  };
+
+  /** The installed backend; set it once, before any thread calls parallelTasks(). */
+  inline TaskBackend&
+   taskBackend() {
+   static TaskBackend backend;
+   return backend;
+  }
+
+  /**
+   * Runs fn(task) once for every task in [0, tasks) on up to threads threads, the caller
+   * included. If a worker cannot be started, the remaining threads pick up its share.
+   * Tasks are claimed in ascending order, so a task may wait for lower-numbered ones.
+   */
+  template<typename Fn>
+  inline void
+   parallelTasks(size_t tasks, size_t threads, Fn fn) {
+   std::atomic<size_t> next(0);
+   auto work = [&]() {
+    for (size_t t = next.fetch_add(1); t < tasks; t = next.fetch_add(1)) fn(t);
+   };
+   const TaskBackend& backend = taskBackend();
+   if (backend.run && threads > 1) {
+    using Work = decltype(work);
+    backend.run(backend.context, threads - 1, [](void* data) { (*static_cast<Work*>(data))(); }, &work);
+    return;
+   }
+   std::vector<std::thread> workers;
+   workers.reserve(threads - 1);
+   for (size_t i = 1; i < threads; ++i) {
+    try {
+     workers.emplace_back(work);
+    }
+    catch (...) {
+     break;
+    }
+   }
+   work();
+   for (std::thread& worker : workers) worker.join();
+  }
+ }
+}
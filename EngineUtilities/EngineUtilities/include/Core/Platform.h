@@ -0,0 +1,74 @@
+/**
+ * @file Platform.h
+ * @brief Language-level configuration macros shared by the whole library.
+ *
+ * Keeps the C++ standard detection in one place, so headers can opt into newer features
+ * (std::bit_cast, std::is_constant_evaluated, coroutines) while still building as C++14.
+ *
+ * Defining EU_REPRODUCIBLE selects the bit-reproducible float mode: every kernel sticks to
+ * IEEE add/sub/mul/div/sqrt in a fixed order, with no FMA contraction and no hardware
+ * estimate instructions, so MSVC, Clang and GCC on SSE, AVX and NEON produce identical bits.
+ * GCC cannot switch contraction off from source; build with -ffp-contract=off there.
+ */
+
+#pragma once
+
+#include <type_traits>
+#if (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L) || __cplusplus >= 202002L
+ #include <bit>
+#endif
+
+#if defined(EU_REPRODUCIBLE)
+ #if defined(__FAST_MATH__) || defined(_M_FP_FAST)
+  #error "EU_REPRODUCIBLE needs IEEE float semantics: build without -ffast-math or /fp:fast"
+ #endif
+ #if (defined(_M_IX86) && !(defined(_M_IX86_FP) && _M_IX86_FP >= 2)) || (defined(__i386__) && !defined(__SSE2_MATH__))
+  #error "EU_REPRODUCIBLE needs SSE2 float math on 32-bit x86 (x87 keeps excess precision)"
+ #endif
+ #if defined(_MSC_VER) && !defined(__clang__)
+  #pragma fp_contract(off)
+ #elif defined(__clang__)
+  #pragma STDC FP_CONTRACT OFF
+ #endif
+#endif
+
+#if defined(__cpp_lib_bit_cast) && defined(__cpp_lib_is_constant_evaluated)
+ /// Float bit manipulation and intrinsic fallbacks can run in constant expressions (C++20).
+ #define EU_HAS_CONSTEXPR_BITS 1
+ /// constexpr when float bit casts are usable at compile time, inline otherwise.
+ #define EU_CONSTEXPR20 constexpr
+#else
+ /// constexpr when float bit casts are usable at compile time, inline otherwise.
+ #define EU_CONSTEXPR20 inline
+#endif
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+ /// C++20 coroutines are available (StreamTask, AssetStream.h).
+ #define EU_HAS_COROUTINES 1
+#endif
+
+/**
+ * Checks that a vector, matrix or quaternion type stays trivially copyable and
+ * standard-layout, so arrays of it can be memcpy'd, uploaded and bulk-resized as raw bytes.
+ */
+#define EU_ASSERT_VALUE_TYPE(...)                                                            \
+ static_assert(std::is_trivially_copyable<__VA_ARGS__>::value && std::is_standard_layout<__VA_ARGS__>::value, \
+               #__VA_ARGS__ " must stay trivially copyable and standard-layout")
+
+namespace EU {
+ /**
+  * @brief Type of NoInit.
+  */
+ struct NoInitTag {
+  explicit NoInitTag() = default;
+ };
+
+ /**
+  * @brief Constructor tag that leaves a math type's components uninitialized, e.g.
+  * `Matrix4x4 m(EU::NoInit);` before every element is written anyway.
+  *
+  * Reading a component before writing it is undefined behavior. The default constructors
+  * keep initializing (zero vectors, identity matrices and quaternions).
+  */
+ constexpr NoInitTag NoInit{};
+}
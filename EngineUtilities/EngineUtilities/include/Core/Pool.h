@@ -0,0 +1,382 @@
+/**
+ * @file Pool.h
+ * @brief Typed fixed-size object pool: cache-line-aligned blocks, an index free list,
+ * generation-checked handles and per-thread caches.
+ *
+ * Pool<T> stores objects in blocks of POOL_BLOCK_SIZE slots, each block starting on a cache
+ * line, so objects never move once created and objects created together sit next to each
+ * other. A slot is named by a 32-bit index; freed indices go on a LIFO free list, so the slot
+ * just released (still in cache) is the next one handed out, and once the pool has grown to
+ * its working size nothing is allocated.
+ *
+ * Every slot carries a generation that changes when its object is destroyed. A PoolHandle
+ * records the index together with the generation it was created with, so get() returns
+ * nullptr for a handle whose object is gone, even after the slot has been reused. Code that
+ * manages lifetimes itself (intrusive trees and lists) can use the raw index interface,
+ * allocate()/release()/operator[], and skip the check.
+ *
+ * The free list is guarded by a spin lock, which costs one uncontended atomic exchange per
+ * call. Threads that create and destroy many objects at once use a Pool::Cache: it moves
+ * indices to and from the pool POOL_CACHE_BATCH at a time, so most of its calls touch no
+ * shared state. get() and operator[] never lock; a thread may read an object as long as it
+ * was created before (in the happens-before sense) and is not destroyed concurrently.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace EU {
+ /// Slots per pool block; a power of two.
+ constexpr uint32_t POOL_BLOCK_SIZE = 256;
+ /// Most blocks one pool can own, which caps it at POOL_BLOCK_SIZE * POOL_MAX_BLOCKS objects.
+ constexpr uint32_t POOL_MAX_BLOCKS = 4096;
+ /// Indices a Pool::Cache takes from or gives back to its pool at once.
+ constexpr uint32_t POOL_CACHE_BATCH = 32;
+ constexpr uint32_t POOL_NONE = 0xffffffffu;
+
+ /**
+  * @brief Index and generation of a pooled object; the default handle refers to nothing.
+  */
+ template<typename T>
+ struct PoolHandle {
+  uint32_t index = POOL_NONE;
+  uint32_t generation = 0;
+
+  bool
+   valid() const {
+   return index != POOL_NONE;
+  }
+
+  bool
+   operator==(const PoolHandle& other) const {
+   return index == other.index && generation == other.generation;
+  }
+
+  bool
+   operator!=(const PoolHandle& other) const {
+   return !(*this == other);
+  }
+ };
+
+ namespace detail {
+  /** Test-and-set lock for critical sections a few instructions long. */
+  class
+   SpinLock {
+   public:
+   void
+    lock() {
+    while (m_flag.exchange(true, std::memory_order_acquire)) {
+     while (m_flag.load(std::memory_order_relaxed)) {
+     }
+    }
+   }
+
+   void
+    unlock() {
+    m_flag.store(false, std::memory_order_release);
+   }
+
+   private:
+   std::atomic<bool> m_flag{ false };
+  };
+
+  struct SpinGuard {
+   explicit SpinGuard(SpinLock& lock) : m_lock(lock) {
+    m_lock.lock();
+   }
+   ~SpinGuard() {
+    m_lock.unlock();
+   }
+   SpinGuard(const SpinGuard&) = delete;
+   SpinGuard& operator=(const SpinGuard&) = delete;
+
+   private:
+   SpinLock& m_lock;
+  };
+ }
+
+ /**
+  * @class Pool
+  * @brief Pool of T with stable addresses and generation-checked handles; see the file comment.
+  */
+ template<typename T>
+ class
+  Pool {
+  public:
+  using Handle = PoolHandle<T>;
+
+  /**
+   * @class Cache
+   * @brief One thread's stash of free indices in a pool. Objects it creates may be destroyed
+   * through any cache or the pool itself; whatever it still holds goes back on destruction.
+   */
+  class
+   Cache {
+   public:
+   explicit Cache(Pool& pool) : m_pool(pool), m_count(0) {}
+
+   Cache(const Cache&) = delete;
+   Cache& operator=(const Cache&) = delete;
+
+   ~Cache() {
+    flush();
+   }
+
+   /** @brief Constructs a T from args; see Pool::create(). */
+   template<typename... Args>
+   Handle
+    create(Args&&... args) {
+    if (m_count == 0) m_count = m_pool.take(m_free, POOL_CACHE_BATCH / 2);
+    if (m_count == 0) return Handle{};
+    const uint32_t index = m_free[--m_count];
+    return m_pool.construct(index, std::forward<Args>(args)...);
+   }
+
+   /** @brief Destroys the object of handle; see Pool::destroy(). */
+   bool
+    destroy(Handle handle) {
+    if (!m_pool.destruct(handle)) return false;
+    if (m_count == POOL_CACHE_BATCH) {
+     m_pool.give(m_free + POOL_CACHE_BATCH / 2, POOL_CACHE_BATCH / 2);
+     m_count = POOL_CACHE_BATCH / 2;
+    }
+    m_free[m_count++] = handle.index;
+    return true;
+   }
+
+   /** @brief Returns every held index to the pool. */
+   void
+    flush() {
+    m_pool.give(m_free, m_count);
+    m_count = 0;
+   }
+
+   private:
+   Pool& m_pool;
+   uint32_t m_free[POOL_CACHE_BATCH];
+   uint32_t m_count;
+  };
+
+  Pool()
+   : m_blocks(new Block*[POOL_MAX_BLOCKS]), m_storage(new unsigned char*[POOL_MAX_BLOCKS]), m_blockCount(0),
+     m_capacity(0), m_freeHead(POOL_NONE), m_live(0) {}
+
+  Pool(const Pool&) = delete;
+  Pool& operator=(const Pool&) = delete;
+
+  ~Pool() {
+   clear();
+   for (uint32_t b = 0; b < m_blockCount; ++b) delete[] m_storage[b];
+  }
+
+  /**
+   * @brief Constructs a T from args in a free slot; an invalid handle when the pool is at
+   * POOL_BLOCK_SIZE * POOL_MAX_BLOCKS objects.
+   */
+  template<typename... Args>
+  Handle
+   create(Args&&... args) {
+   uint32_t index;
+   if (take(&index, 1) == 0) return Handle{};
+   return construct(index, std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Destroys the object of handle and frees its slot; false (and nothing happens)
+   * when the handle is stale or invalid.
+   */
+  bool
+   destroy(Handle handle) {
+   if (!destruct(handle)) return false;
+   give(&handle.index, 1);
+   return true;
+  }
+
+  /** @brief The object of handle, or nullptr once it has been destroyed. */
+  T*
+   get(Handle handle) {
+   return alive(handle) ? &(*this)[handle.index] : nullptr;
+  }
+
+  const T*
+   get(Handle handle) const {
+   return alive(handle) ? &(*this)[handle.index] : nullptr;
+  }
+
+  /** @brief True while the object handle was created for exists. */
+  bool
+   alive(Handle handle) const {
+   return handle.index < m_capacity.load(std::memory_order_acquire) &&
+          generation(handle.index) == handle.generation && (handle.generation & 1u) != 0;
+  }
+
+  /**
+   * @brief Index of a free slot holding a default-constructed T, without a handle; POOL_NONE
+   * when the pool is full. Pair with release().
+   */
+  uint32_t
+   allocate() {
+   uint32_t index;
+   if (take(&index, 1) == 0) return POOL_NONE;
+   construct(index);
+   return index;
+  }
+
+  /** @brief Destroys the object at index, which must be alive, and frees its slot. */
+  void
+   release(uint32_t index) {
+   destruct(Handle{ index, generation(index) });
+   give(&index, 1);
+  }
+
+  /** @brief The object at index, unchecked. */
+  T&
+   operator[](uint32_t index) {
+   return *m_blocks[index / POOL_BLOCK_SIZE]->object(index % POOL_BLOCK_SIZE);
+  }
+
+  const T&
+   operator[](uint32_t index) const {
+   return *m_blocks[index / POOL_BLOCK_SIZE]->object(index % POOL_BLOCK_SIZE);
+  }
+
+  /**
+   * @brief Destroys every live object, keeping the blocks; every outstanding handle goes
+   * stale. Not safe while other threads use the pool or hold caches with indices in them.
+   */
+  void
+   clear() {
+   detail::SpinGuard guard(m_lock);
+   m_freeHead = POOL_NONE;
+   // Rebuilt in descending order so allocation restarts at index 0 and walks forward.
+   for (uint32_t i = m_capacity.load(std::memory_order_relaxed); i-- > 0;) {
+    uint32_t& gen = generation(i);
+    if ((gen & 1u) != 0) {
+     (*this)[i].~T();
+     ++gen;
+    }
+    next(i) = m_freeHead;
+    m_freeHead = i;
+   }
+   m_live.store(0, std::memory_order_relaxed);
+  }
+
+  /** @brief Number of live objects. */
+  size_t
+   size() const {
+   return m_live.load(std::memory_order_relaxed);
+  }
+
+  /** @brief Number of slots in the pool's blocks. */
+  size_t
+   capacity() const {
+   return m_capacity.load(std::memory_order_relaxed);
+  }
+
+  private:
+  struct Block {
+   unsigned char storage[POOL_BLOCK_SIZE * sizeof(T)];
+   uint32_t generation[POOL_BLOCK_SIZE]; ///< Odd while the slot holds an object
+   uint32_t next[POOL_BLOCK_SIZE];       ///< Free-list link of a free slot
+
+   T*
+    object(uint32_t slot) {
+    return reinterpret_cast<T*>(storage + slot * sizeof(T));
+   }
+  };
+
+  static_assert(alignof(T) <= 64, "Pool aligns blocks to a cache line");
+
+  uint32_t&
+   generation(uint32_t index) const {
+   return m_blocks[index / POOL_BLOCK_SIZE]->generation[index % POOL_BLOCK_SIZE];
+  }
+
+  uint32_t&
+   next(uint32_t index) const {
+   return m_blocks[index / POOL_BLOCK_SIZE]->next[index % POOL_BLOCK_SIZE];
+  }
+
+  template<typename... Args>
+  Handle
+   construct(uint32_t index, Args&&... args) {
+   try {
+    new (&(*this)[index]) T(std::forward<Args>(args)...);
+   }
+   catch (...) {
+    give(&index, 1);
+    throw;
+   }
+   uint32_t& gen = generation(index);
+   ++gen;
+   m_live.fetch_add(1, std::memory_order_relaxed);
+   return Handle{ index, gen };
+  }
+
+  bool
+   destruct(Handle handle) {
+   if (!alive(handle)) return false;
+   (*this)[handle.index].~T();
+   ++generation(handle.index);
+   m_live.fetch_sub(1, std::memory_order_relaxed);
+   return true;
+  }
+
+  /** Pops up to count free indices into out, growing by a block when the list runs dry. */
+  uint32_t
+   take(uint32_t* out, uint32_t count) {
+   detail::SpinGuard guard(m_lock);
+   uint32_t taken = 0;
+   while (taken < count) {
+    if (m_freeHead == POOL_NONE && !grow()) break;
+    out[taken++] = m_freeHead;
+    m_freeHead = next(m_freeHead);
+   }
+   return taken;
+  }
+
+  /** Pushes count free indices; the last one given is the first taken again. */
+  void
+   give(const uint32_t* indices, uint32_t count) {
+   if (count == 0) return;
+   detail::SpinGuard guard(m_lock);
+   for (uint32_t i = 0; i < count; ++i) {
+    next(indices[i]) = m_freeHead;
+    m_freeHead = indices[i];
+   }
+  }
+
+  /** Adds a block and threads its slots onto the empty free list; under m_lock. */
+  bool
+   grow() {
+   if (m_blockCount == POOL_MAX_BLOCKS) return false;
+   unsigned char* storage = new unsigned char[sizeof(Block) + 64];
+   const uintptr_t aligned = (reinterpret_cast<uintptr_t>(storage) + 63) & ~uintptr_t(63);
+   Block* block = new (reinterpret_cast<void*>(aligned)) Block;
+   const uint32_t base = m_blockCount * POOL_BLOCK_SIZE;
+   for (uint32_t s = 0; s < POOL_BLOCK_SIZE; ++s) {
+    block->generation[s] = 0;
+    block->next[s] = s + 1 < POOL_BLOCK_SIZE ? base + s + 1 : POOL_NONE;
+   }
+   m_storage[m_blockCount] = storage;
+   m_blocks[m_blockCount++] = block;
+   m_freeHead = base;
+   m_capacity.store(base + POOL_BLOCK_SIZE, std::memory_order_release);
+   return true;
+  }
+
+  std::unique_ptr<Block*[]> m_blocks;           ///< Fixed table, so readers never see it move
+  std::unique_ptr<unsigned char*[]> m_storage;   ///< Allocation behind each block, before alignment
+  uint32_t m_blockCount;
+  std::atomic<uint32_t> m_capacity;
+  uint32_t m_freeHead;
+  std::atomic<size_t> m_live;
+  detail::SpinLock m_lock;
+ };
+}
@@ -0,0 +1,790 @@
+/**
+ * @file SIMD.h
+ * @brief Compile-time detection of the SIMD instruction sets available to the math layer.
+ *
+ * Defines EU_SIMD_* macros from the compiler's target flags and includes the matching
+ * intrinsic headers, so kernels can pick a vector path with a plain #if.
+ */
+
+#pragma once
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ /// SSE and SSE2 are available (always true on x64).
+ #define EU_SIMD_SSE2 1
+ #include <emmintrin.h>
+#endif
+
+#if defined(__SSE4_1__) || defined(__AVX__) || (defined(EU_TARGET_SSE41) && defined(_MSC_VER))
+ /// SSE4.1 is available (roundps, blendvps, dpps). MSVC has no flag for it, so a unit that
+ /// may use it anyway (a dispatch target) defines EU_TARGET_SSE41.
+ #define EU_SIMD_SSE41 1
+ #include <smmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+ /// AVX2 is available (8-wide float lanes).
+ #define EU_SIMD_AVX2 1
+ #include <immintrin.h>
+#endif
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+ /// F16C half-precision conversions are available on x86 (vcvtps2ph / vcvtph2ps).
+ #define EU_SIMD_F16C 1
+ #include <immintrin.h>
+#endif
+
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+ /// Fused multiply-add is available on x86.
+ #define EU_SIMD_FMA 1
+#endif
+
+#if (defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))) && !defined(EU_NO_BMI2)
+ /// BMI2 bit deposit/extract (pdep / pext) is available; define EU_NO_BMI2 to skip it on
+ /// AMD Zen 1/2, where both are microcoded and slower than the table fallbacks.
+ #define EU_SIMD_BMI2 1
+ #include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+ /// NEON is available (4-wide float lanes, native FMA on AArch64).
+ #define EU_SIMD_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#if defined(EU_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+ /// AArch64 NEON converts between float and IEEE half natively (fcvtn / fcvtl).
+ #define EU_SIMD_NEON_FP16 1
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace EU {
+ /**
+  * @namespace SIMD
+  * @brief Thin value wrappers over the native float/int lane registers.
+  *
+  * Float4/Int4 (SSE2, NEON or a scalar array) and Float8/Int8 (AVX2) expose the same operator
+  * set, so one kernel template compiles to every instruction set. Comparisons return lane masks
+  * (all bits set or clear) stored in the float type, consumed by select() and movemask().
+  */
+ namespace SIMD {
+
+#if defined(EU_SIMD_SSE2)
+  /** @brief Four 32-bit integer lanes (SSE2). */
+  struct Int4 {
+   __m128i v;
+   static Int4 set1(int value) { return { _mm_set1_epi32(value) }; }
+   static Int4 load(const int32_t* p) { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) }; }
+   void store(int32_t* p) const { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+  };
+
+  /** @brief Four float lanes (SSE2). */
+  struct Float4 {
+   using Int = Int4;
+   static constexpr int WIDTH = 4;
+   __m128 v;
+   static Float4 set1(float value) { return { _mm_set1_ps(value) }; }
+   static Float4 zero() { return { _mm_setzero_ps() }; }
+   static Float4 load(const float* p) { return { _mm_loadu_ps(p) }; }
+   static Float4 loadAligned(const float* p) { return { _mm_load_ps(p) }; }
+   void store(float* p) const { _mm_storeu_ps(p, v); }
+   void storeAligned(float* p) const { _mm_store_ps(p, v); }
+  };
+
+  inline Float4 operator+(Float4 a, Float4 b) { return { _mm_add_ps(a.v, b.v) }; }
+  inline Float4 operator-(Float4 a, Float4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+  inline Float4 operator*(Float4 a, Float4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+  inline Float4 operator/(Float4 a, Float4 b) { return { _mm_div_ps(a.v, b.v) }; }
+  inline Float4 operator-(Float4 a) { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)) }; }
+  inline Float4 operator&(Float4 a, Float4 b) { return { _mm_and_ps(a.v, b.v) }; }
+  inline Float4 operator|(Float4 a, Float4 b) { return { _mm_or_ps(a.v, b.v) }; }
+  inline Float4 operator^(Float4 a, Float4 b) { return { _mm_xor_ps(a.v, b.v) }; }
+  inline Float4 operator<(Float4 a, Float4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+  inline Float4 operator>(Float4 a, Float4 b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+  inline Float4 operator<=(Float4 a, Float4 b) { return { _mm_cmple_ps(a.v, b.v) }; }
+  inline Float4 operator>=(Float4 a, Float4 b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+  inline Float4 operator==(Float4 a, Float4 b) { return { _mm_cmpeq_ps(a.v, b.v) }; }
+  inline Float4 operator!=(Float4 a, Float4 b) { return { _mm_cmpneq_ps(a.v, b.v) }; }
+  inline Float4 min(Float4 a, Float4 b) { return { _mm_min_ps(a.v, b.v) }; }
+  inline Float4 max(Float4 a, Float4 b) { return { _mm_max_ps(a.v, b.v) }; }
+  inline Float4 sqrt(Float4 a) { return { _mm_sqrt_ps(a.v) }; }
+  /** ~12-bit estimate of 1/sqrt(a): rsqrtps, or the portable bit seed plus one Newton step under EU_REPRODUCIBLE. */
+  inline Float4 rsqrtEstimate(Float4 a) {
+#if defined(EU_REPRODUCIBLE)
+   __m128 y = _mm_castsi128_ps(_mm_sub_epi32(_mm_set1_epi32(0x5f375a86), _mm_srli_epi32(_mm_castps_si128(a.v), 1)));
+   __m128 t = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), a.v), y), y);
+   return { _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), t)) };
+#else
+   return { _mm_rsqrt_ps(a.v) };
+#endif
+  }
+  /** Lane-wise mask ? a : b. */
+  inline Float4 select(Float4 mask, Float4 a, Float4 b) {
+#if defined(EU_SIMD_SSE41)
+   return { _mm_blendv_ps(b.v, a.v, mask.v) };
+#else
+   return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) };
+#endif
+  }
+  /** Bit i is set when lane i of the mask is set. */
+  inline int movemask(Float4 mask) { return _mm_movemask_ps(mask.v); }
+
+  inline Int4 operator+(Int4 a, Int4 b) { return { _mm_add_epi32(a.v, b.v) }; }
+  inline Int4 operator-(Int4 a, Int4 b) { return { _mm_sub_epi32(a.v, b.v) }; }
+  inline Int4 operator&(Int4 a, Int4 b) { return { _mm_and_si128(a.v, b.v) }; }
+  inline Int4 operator|(Int4 a, Int4 b) { return { _mm_or_si128(a.v, b.v) }; }
+  inline Int4 operator^(Int4 a, Int4 b) { return { _mm_xor_si128(a.v, b.v) }; }
+  inline Int4 operator==(Int4 a, Int4 b) { return { _mm_cmpeq_epi32(a.v, b.v) }; }
+  inline Int4 operator>(Int4 a, Int4 b) { return { _mm_cmpgt_epi32(a.v, b.v) }; }
+  /** Low 32 bits of the lane-wise product (pmulld on SSE4.1, two pmuludq otherwise). */
+  inline Int4 operator*(Int4 a, Int4 b) {
+#if defined(EU_SIMD_SSE41)
+   return { _mm_mullo_epi32(a.v, b.v) };
+#else
+   __m128i even = _mm_mul_epu32(a.v, b.v);
+   __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a.v, 32), _mm_srli_epi64(b.v, 32));
+   return { _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                               _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))) };
+#endif
+  }
+  template<int N> inline Int4 shiftLeft(Int4 a) { return { _mm_slli_epi32(a.v, N) }; }
+  template<int N> inline Int4 shiftRight(Int4 a) { return { _mm_srli_epi32(a.v, N) }; }
+  /** Converts to int rounding to nearest (even on ties). */
+  inline Int4 roundToInt(Float4 a) { return { _mm_cvtps_epi32(a.v) }; }
+  /** Converts to int truncating toward zero. */
+  inline Int4 truncToInt(Float4 a) { return { _mm_cvttps_epi32(a.v) }; }
+  inline Float4 toFloat(Int4 a) { return { _mm_cvtepi32_ps(a.v) }; }
+  inline Int4 asInt(Float4 a) { return { _mm_castps_si128(a.v) }; }
+  inline Float4 asFloat(Int4 a) { return { _mm_castsi128_ps(a.v) }; }
+
+#elif defined(EU_SIMD_NEON)
+  /** @brief Four 32-bit integer lanes (NEON). */
+  struct Int4 {
+   int32x4_t v;
+   static Int4 set1(int value) { return { vdupq_n_s32(value) }; }
+   static Int4 load(const int32_t* p) { return { vld1q_s32(p) }; }
+   void store(int32_t* p) const { vst1q_s32(p, v); }
+  };
+
+  /** @brief Four float lanes (NEON). */
+  struct Float4 {
+   using Int = Int4;
+   static constexpr int WIDTH = 4;
+   float32x4_t v;
+   static Float4 set1(float value) { return { vdupq_n_f32(value) }; }
+   static Float4 zero() { return { vdupq_n_f32(0.0f) }; }
+   static Float4 load(const float* p) { return { vld1q_f32(p) }; }
+   static Float4 loadAligned(const float* p) { return { vld1q_f32(p) }; }
+   void store(float* p) const { vst1q_f32(p, v); }
+   void storeAligned(float* p) const { vst1q_f32(p, v); }
+  };
+
+  inline Float4 fromMask(uint32x4_t m) { return { vreinterpretq_f32_u32(m) }; }
+  inline uint32x4_t toMask(Float4 a) { return vreinterpretq_u32_f32(a.v); }
+  inline Float4 operator+(Float4 a, Float4 b) { return { vaddq_f32(a.v, b.v) }; }
+  inline Float4 operator-(Float4 a, Float4 b) { return { vsubq_f32(a.v, b.v) }; }
+  inline Float4 operator*(Float4 a, Float4 b) { return { vmulq_f32(a.v, b.v) }; }
+  inline Float4 operator/(Float4 a, Float4 b) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+   return { vdivq_f32(a.v, b.v) };
+#else
+   float32x4_t r = vrecpeq_f32(b.v);
+   r = vmulq_f32(r, vrecpsq_f32(b.v, r));
+   r = vmulq_f32(r, vrecpsq_f32(b.v, r));
+   return { vmulq_f32(a.v, r) };
+#endif
+  }
+  inline Float4 operator-(Float4 a) { return { vnegq_f32(a.v) }; }
+  inline Float4 operator&(Float4 a, Float4 b) { return fromMask(vandq_u32(toMask(a), toMask(b))); }
+  inline Float4 operator|(Float4 a, Float4 b) { return fromMask(vorrq_u32(toMask(a), toMask(b))); }
+  inline Float4 operator^(Float4 a, Float4 b) { return fromMask(veorq_u32(toMask(a), toMask(b))); }
+  inline Float4 operator<(Float4 a, Float4 b) { return fromMask(vcltq_f32(a.v, b.v)); }
+  inline Float4 operator>(Float4 a, Float4 b) { return fromMask(vcgtq_f32(a.v, b.v)); }
+  inline Float4 operator<=(Float4 a, Float4 b) { return fromMask(vcleq_f32(a.v, b.v)); }
+  inline Float4 operator>=(Float4 a, Float4 b) { return fromMask(vcgeq_f32(a.v, b.v)); }
+  inline Float4 operator==(Float4 a, Float4 b) { return fromMask(vceqq_f32(a.v, b.v)); }
+  inline Float4 operator!=(Float4 a, Float4 b) { return fromMask(vmvnq_u32(vceqq_f32(a.v, b.v))); }
+  inline Float4 min(Float4 a, Float4 b) { return { vminq_f32(a.v, b.v) }; }
+  inline Float4 max(Float4 a, Float4 b) { return { vmaxq_f32(a.v, b.v) }; }
+  /** ~12-bit estimate of 1/sqrt(a) (vrsqrte refined once, vrsqrte alone is only 8 bits). */
+  inline Float4 rsqrtEstimate(Float4 a) {
+#if defined(EU_REPRODUCIBLE)
+   float32x4_t y = vreinterpretq_f32_u32(vsubq_u32(vdupq_n_u32(0x5f375a86u), vshrq_n_u32(vreinterpretq_u32_f32(a.v), 1)));
+   float32x4_t t = vmulq_f32(vmulq_f32(vmulq_f32(vdupq_n_f32(0.5f), a.v), y), y);
+   return { vmulq_f32(y, vsubq_f32(vdupq_n_f32(1.5f), t)) };
+#else
+   float32x4_t y = vrsqrteq_f32(a.v);
+   return { vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(a.v, y), y)) };
+#endif
+  }
+  inline Float4 select(Float4 mask, Float4 a, Float4 b) { return { vbslq_f32(toMask(mask), a.v, b.v) }; }
+  inline Float4 sqrt(Float4 a) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+   return { vsqrtq_f32(a.v) };
+#elif defined(EU_REPRODUCIBLE) && defined(__GNUC__)
+   float lanes[4];
+   vst1q_f32(lanes, a.v);
+   for (int i = 0; i < 4; ++i) lanes[i] = lanes[i] > 0.0f ? __builtin_sqrtf(lanes[i]) : 0.0f;
+   return { vld1q_f32(lanes) };
+#else
+   Float4 y = rsqrtEstimate(a);
+   y = y * (Float4::set1(1.5f) - Float4::set1(0.5f) * a * y * y);
+   return select(a > Float4::zero(), a * y, Float4::zero());
+#endif
+  }
+  inline int movemask(Float4 mask) {
+   uint32x4_t bits = vshrq_n_u32(toMask(mask), 31);
+   return static_cast<int>(vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) |
+                           (vgetq_lane_u32(bits, 2) << 2) | (vgetq_lane_u32(bits, 3) << 3));
+  }
+
+  inline Int4 operator+(Int4 a, Int4 b) { return { vaddq_s32(a.v, b.v) }; }
+  inline Int4 operator-(Int4 a, Int4 b) { return { vsubq_s32(a.v, b.v) }; }
+  inline Int4 operator&(Int4 a, Int4 b) { return { vandq_s32(a.v, b.v) }; }
+  inline Int4 operator|(Int4 a, Int4 b) { return { vorrq_s32(a.v, b.v) }; }
+  inline Int4 operator^(Int4 a, Int4 b) { return { veorq_s32(a.v, b.v) }; }
+  inline Int4 operator==(Int4 a, Int4 b) { return { vreinterpretq_s32_u32(vceqq_s32(a.v, b.v)) }; }
+  inline Int4 operator>(Int4 a, Int4 b) { return { vreinterpretq_s32_u32(vcgtq_s32(a.v, b.v)) }; }
+  inline Int4 operator*(Int4 a, Int4 b) { return { vmulq_s32(a.v, b.v) }; }
+  template<int N> inline Int4 shiftLeft(Int4 a) { return { vshlq_n_s32(a.v, N) }; }
+  template<int N> inline Int4 shiftRight(Int4 a) {
+   return { vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a.v), N)) };
+  }
+  inline Int4 roundToInt(Float4 a) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+   return { vcvtnq_s32_f32(a.v) };
+#elif defined(EU_REPRODUCIBLE)
+   // Ties to even like cvtps2dq/vcvtn: adding 2^23 leaves no fractional bits.
+   float32x4_t mag = vabsq_f32(a.v);
+   float32x4_t big = vdupq_n_f32(8388608.0f);
+   float32x4_t r = vbslq_f32(vcltq_f32(mag, big), vsubq_f32(vaddq_f32(mag, big), big), mag);
+   return { vcvtq_s32_f32(vbslq_f32(vdupq_n_u32(0x80000000u), a.v, r)) };
+#else
+   float32x4_t half = vbslq_f32(vcltq_f32(a.v, vdupq_n_f32(0.0f)), vdupq_n_f32(-0.5f), vdupq_n_f32(0.5f));
+   return { vcvtq_s32_f32(vaddq_f32(a.v, half)) };
+#endif
+  }
+  inline Int4 truncToInt(Float4 a) { return { vcvtq_s32_f32(a.v) }; }
+  inline Float4 toFloat(Int4 a) { return { vcvtq_f32_s32(a.v) }; }
+  inline Int4 asInt(Float4 a) { return { vreinterpretq_s32_f32(a.v) }; }
+  inline Float4 asFloat(Int4 a) { return { vreinterpretq_f32_s32(a.v) }; }
+
+#else
+  /** @brief Four 32-bit integer lanes (portable scalar fallback). */
+  struct Int4 {
+   int v[4];
+   static Int4 set1(int value) { return { { value, value, value, value } }; }
+   static Int4 load(const int32_t* p) { return { { p[0], p[1], p[2], p[3] } }; }
+   void store(int32_t* p) const { for (int i = 0; i < 4; ++i) p[i] = v[i]; }
+  };
+
+  /** @brief Four float lanes (portable scalar fallback). */
+  struct Float4 {
+   using Int = Int4;
+   static constexpr int WIDTH = 4;
+   float v[4];
+   static Float4 set1(float value) { return { { value, value, value, value } }; }
+   static Float4 zero() { return set1(0.0f); }
+   static Float4 load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+   static Float4 loadAligned(const float* p) { return load(p); }
+   void store(float* p) const { for (int i = 0; i < 4; ++i) p[i] = v[i]; }
+   void storeAligned(float* p) const { store(p); }
+  };
+
+  namespace detail {
+   inline unsigned int bits(float f) { unsigned int u; std::memcpy(&u, &f, 4); return u; }
+   inline float fromBits(unsigned int u) { float f; std::memcpy(&f, &u, 4); return f; }
+   inline float maskOf(bool b) { return fromBits(b ? 0xffffffffu : 0u); }
+  }
+
+#define EU_SIMD_SCALAR_OP4(OP, EXPR) \
+  inline Float4 OP(Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = EXPR; return r; }
+  EU_SIMD_SCALAR_OP4(operator+, a.v[i] + b.v[i])
+  EU_SIMD_SCALAR_OP4(operator-, a.v[i] - b.v[i])
+  EU_SIMD_SCALAR_OP4(operator*, a.v[i] * b.v[i])
+  EU_SIMD_SCALAR_OP4(operator/, a.v[i] / b.v[i])
+  EU_SIMD_SCALAR_OP4(operator&, detail::fromBits(detail::bits(a.v[i]) & detail::bits(b.v[i])))
+  EU_SIMD_SCALAR_OP4(operator|, detail::fromBits(detail::bits(a.v[i]) | detail::bits(b.v[i])))
+  EU_SIMD_SCALAR_OP4(operator^, detail::fromBits(detail::bits(a.v[i]) ^ detail::bits(b.v[i])))
+  EU_SIMD_SCALAR_OP4(operator<, detail::maskOf(a.v[i] < b.v[i]))
+  EU_SIMD_SCALAR_OP4(operator>, detail::maskOf(a.v[i] > b.v[i]))
+  EU_SIMD_SCALAR_OP4(operator<=, detail::maskOf(a.v[i] <= b.v[i]))
+  EU_SIMD_SCALAR_OP4(operator>=, detail::maskOf(a.v[i] >= b.v[i]))
+  EU_SIMD_SCALAR_OP4(operator==, detail::maskOf(a.v[i] == b.v[i]))
+  EU_SIMD_SCALAR_OP4(operator!=, detail::maskOf(a.v[i] != b.v[i]))
+  EU_SIMD_SCALAR_OP4(min, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+  EU_SIMD_SCALAR_OP4(max, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+#undef EU_SIMD_SCALAR_OP4
+  inline Float4 operator-(Float4 a) { return Float4::zero() - a; }
+  inline Float4 sqrt(Float4 a) {
+   Float4 r;
+   for (int i = 0; i < 4; ++i) {
+    float x = a.v[i] > 0.0f ? a.v[i] : 0.0f;
+#if defined(EU_REPRODUCIBLE) && defined(__GNUC__)
+    r.v[i] = __builtin_sqrtf(x);
+#else
+    float y = detail::fromBits(0x5f375a86u - (detail::bits(x) >> 1));
+    y = y * (1.5f - 0.5f * x * y * y);
+    y = y * (1.5f - 0.5f * x * y * y);
+    float root = x * y;
+    r.v[i] = x > 0.0f ? root + 0.5f * y * (x - root * root) : 0.0f;
+#endif
+   }
+   return r;
+  }
+  inline Float4 rsqrtEstimate(Float4 a) {
+   Float4 r;
+   for (int i = 0; i < 4; ++i) {
+    float y = detail::fromBits(0x5f375a86u - (detail::bits(a.v[i]) >> 1));
+    r.v[i] = y * (1.5f - 0.5f * a.v[i] * y * y);
+   }
+   return r;
+  }
+  inline Float4 select(Float4 mask, Float4 a, Float4 b) {
+   Float4 r;
+   for (int i = 0; i < 4; ++i) r.v[i] = detail::bits(mask.v[i]) ? a.v[i] : b.v[i];
+   return r;
+  }
+  inline int movemask(Float4 mask) {
+   int m = 0;
+   for (int i = 0; i < 4; ++i) m |= static_cast<int>(detail::bits(mask.v[i]) >> 31) << i;
+   return m;
+  }
+
+#define EU_SIMD_SCALAR_IOP4(OP, EXPR) \
+  inline Int4 OP(Int4 a, Int4 b) { Int4 r; for (int i = 0; i < 4; ++i) r.v[i] = EXPR; return r; }
+  EU_SIMD_SCALAR_IOP4(operator+, static_cast<int>(static_cast<unsigned int>(a.v[i]) + static_cast<unsigned int>(b.v[i])))
+  EU_SIMD_SCALAR_IOP4(operator-, static_cast<int>(static_cast<unsigned int>(a.v[i]) - static_cast<unsigned int>(b.v[i])))
+  EU_SIMD_SCALAR_IOP4(operator&, a.v[i] & b.v[i])
+  EU_SIMD_SCALAR_IOP4(operator|, a.v[i] | b.v[i])
+  EU_SIMD_SCALAR_IOP4(operator^, a.v[i] ^ b.v[i])
+  EU_SIMD_SCALAR_IOP4(operator==, a.v[i] == b.v[i] ? -1 : 0)
+  EU_SIMD_SCALAR_IOP4(operator>, a.v[i] > b.v[i] ? -1 : 0)
+  EU_SIMD_SCALAR_IOP4(operator*, static_cast<int>(static_cast<unsigned int>(a.v[i]) * static_cast<unsigned int>(b.v[i])))
+#undef EU_SIMD_SCALAR_IOP4
+  template<int N> inline Int4 shiftLeft(Int4 a) {
+   Int4 r;
+   for (int i = 0; i < 4; ++i) r.v[i] = static_cast<int>(static_cast<unsigned int>(a.v[i]) << N);
+   return r;
+  }
+  template<int N> inline Int4 shiftRight(Int4 a) {
+   Int4 r;
+   for (int i = 0; i < 4; ++i) r.v[i] = static_cast<int>(static_cast<unsigned int>(a.v[i]) >> N);
+   return r;
+  }
+  inline Int4 roundToInt(Float4 a) {
+   Int4 r;
+#if defined(EU_REPRODUCIBLE)
+   // Ties to even like cvtps2dq/vcvtn: adding 2^23 leaves no fractional bits.
+   for (int i = 0; i < 4; ++i) {
+    float m = a.v[i] < 0.0f ? -a.v[i] : a.v[i];
+    float t = m < 8388608.0f ? (m + 8388608.0f) - 8388608.0f : m;
+    r.v[i] = static_cast<int>(a.v[i] < 0.0f ? -t : t);
+   }
+#else
+   for (int i = 0; i < 4; ++i) r.v[i] = static_cast<int>(a.v[i] + (a.v[i] < 0.0f ? -0.5f : 0.5f));
+#endif
+   return r;
+  }
+  inline Int4 truncToInt(Float4 a) {
+   Int4 r;
+   for (int i = 0; i < 4; ++i) r.v[i] = static_cast<int>(a.v[i]);
+   return r;
+  }
+  inline Float4 toFloat(Int4 a) {
+   Float4 r;
+   for (int i = 0; i < 4; ++i) r.v[i] = static_cast<float>(a.v[i]);
+   return r;
+  }
+  inline Int4 asInt(Float4 a) {
+   Int4 r;
+   std::memcpy(r.v, a.v, sizeof(r.v));
+   return r;
+  }
+  inline Float4 asFloat(Int4 a) {
+   Float4 r;
+   std::memcpy(r.v, a.v, sizeof(r.v));
+   return r;
+  }
+#endif
+
+  /** Lane-wise rounding toward zero, -inf and +inf, results kept as floats. */
+#if defined(EU_SIMD_SSE41)
+  inline Float4 truncate(Float4 a) { return { _mm_round_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC) }; }
+  inline Float4 floor(Float4 a) { return { _mm_floor_ps(a.v) }; }
+  inline Float4 ceil(Float4 a) { return { _mm_ceil_ps(a.v) }; }
+#elif defined(EU_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+  inline Float4 truncate(Float4 a) { return { vrndq_f32(a.v) }; }
+  inline Float4 floor(Float4 a) { return { vrndmq_f32(a.v) }; }
+  inline Float4 ceil(Float4 a) { return { vrndpq_f32(a.v) }; }
+#else
+  /** Magnitudes of 2^23 and above are already integral and are passed through unconverted. */
+  inline Float4 truncate(Float4 a) {
+   Float4 magnitude = a & asFloat(Int4::set1(0x7fffffff));
+   return select(magnitude < Float4::set1(8388608.0f), toFloat(truncToInt(a)), a);
+  }
+  inline Float4 floor(Float4 a) {
+   Float4 t = truncate(a);
+   return t - ((t > a) & Float4::set1(1.0f));
+  }
+  inline Float4 ceil(Float4 a) {
+   Float4 t = truncate(a);
+   return t + ((t < a) & Float4::set1(1.0f));
+  }
+#endif
+
+  /**
+   * Whole-register helpers for 4-component vector types: first() reads lane 0, dot4() broadcasts
+   * the dot product summed pairwise as (x + y) + (z + w) on every backend, transpose() turns
+   * four rows into four columns in place, and shuffle<A, B, C, D>() returns lanes (a[A], a[B],
+   * a[C], a[D]) with one shuffle instruction; shuffle2<A, B, C, D>() takes its upper two lanes
+   * from a second register, (a[A], a[B], b[C], b[D]), like shufps.
+   */
+#if defined(EU_SIMD_SSE2)
+  inline float first(Float4 a) { return _mm_cvtss_f32(a.v); }
+  inline Float4 dot4(Float4 a, Float4 b) {
+#if defined(EU_SIMD_SSE41)
+   return { _mm_dp_ps(a.v, b.v, 0xff) };
+#else
+   __m128 p = _mm_mul_ps(a.v, b.v);
+   __m128 s = _mm_add_ps(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1)));
+   return { _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2))) };
+#endif
+  }
+  inline void transpose(Float4& r0, Float4& r1, Float4& r2, Float4& r3) { _MM_TRANSPOSE4_PS(r0.v, r1.v, r2.v, r3.v); }
+  template<int A, int B, int C, int D> inline Float4 shuffle(Float4 a) { return { _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(D, C, B, A)) }; }
+  template<int A, int B, int C, int D> inline Float4 shuffle2(Float4 a, Float4 b) { return { _mm_shuffle_ps(a.v, b.v, _MM_SHUFFLE(D, C, B, A)) }; }
+#elif defined(EU_SIMD_NEON)
+  inline float first(Float4 a) { return vgetq_lane_f32(a.v, 0); }
+  inline Float4 dot4(Float4 a, Float4 b) {
+   float32x4_t p = vmulq_f32(a.v, b.v);
+   float32x2_t s = vpadd_f32(vget_low_f32(p), vget_high_f32(p));
+   return { vdupq_lane_f32(vpadd_f32(s, s), 0) };
+  }
+  inline void transpose(Float4& r0, Float4& r1, Float4& r2, Float4& r3) {
+   float32x4x2_t t01 = vtrnq_f32(r0.v, r1.v);
+   float32x4x2_t t23 = vtrnq_f32(r2.v, r3.v);
+   r0.v = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+   r1.v = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+   r2.v = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+   r3.v = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+  }
+  template<int A, int B, int C, int D> inline Float4 shuffle(Float4 a) {
+#if defined(__clang__)
+   return { __builtin_shufflevector(a.v, a.v, A, B, C, D) };
+#elif defined(__GNUC__)
+   return { __builtin_shuffle(a.v, uint32x4_t{ A, B, C, D }) };
+#else
+   float t[4];
+   vst1q_f32(t, a.v);
+   const float r[4] = { t[A], t[B], t[C], t[D] };
+   return { vld1q_f32(r) };
+#endif
+  }
+  template<int A, int B, int C, int D> inline Float4 shuffle2(Float4 a, Float4 b) {
+#if defined(__clang__)
+   return { __builtin_shufflevector(a.v, b.v, A, B, C + 4, D + 4) };
+#elif defined(__GNUC__)
+   return { __builtin_shuffle(a.v, b.v, uint32x4_t{ A, B, C + 4, D + 4 }) };
+#else
+   float ta[4], tb[4];
+   vst1q_f32(ta, a.v);
+   vst1q_f32(tb, b.v);
+   const float r[4] = { ta[A], ta[B], tb[C], tb[D] };
+   return { vld1q_f32(r) };
+#endif
+  }
+#else
+  inline float first(Float4 a) { return a.v[0]; }
+  inline Float4 dot4(Float4 a, Float4 b) {
+   return Float4::set1((a.v[0] * b.v[0] + a.v[1] * b.v[1]) + (a.v[2] * b.v[2] + a.v[3] * b.v[3]));
+  }
+  inline void transpose(Float4& r0, Float4& r1, Float4& r2, Float4& r3) {
+   Float4* rows[4] = { &r0, &r1, &r2, &r3 };
+   for (int i = 0; i < 4; ++i) {
+    for (int j = i + 1; j < 4; ++j) {
+     float t = rows[i]->v[j];
+     rows[i]->v[j] = rows[j]->v[i];
+     rows[j]->v[i] = t;
+    }
+   }
+  }
+  template<int A, int B, int C, int D> inline Float4 shuffle(Float4 a) { return { { a.v[A], a.v[B], a.v[C], a.v[D] } }; }
+  template<int A, int B, int C, int D> inline Float4 shuffle2(Float4 a, Float4 b) { return { { a.v[A], a.v[B], b.v[C], b.v[D] } }; }
+#endif
+
+  /**
+   * Interleaved access for arrays of 2- and 3-component vectors: loadInterleaved*() splits
+   * WIDTH consecutive (x, y[, z]) records into one register per component, and
+   * storeInterleaved*() writes them back in the same layout.
+   */
+#if defined(EU_SIMD_SSE2)
+  inline void loadInterleaved2(const float* p, Float4& x, Float4& y) {
+   __m128 a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 4);
+   x.v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+   y.v = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+  }
+  inline void storeInterleaved2(float* p, Float4 x, Float4 y) {
+   _mm_storeu_ps(p, _mm_unpacklo_ps(x.v, y.v));
+   _mm_storeu_ps(p + 4, _mm_unpackhi_ps(x.v, y.v));
+  }
+  inline void loadInterleaved3(const float* p, Float4& x, Float4& y, Float4& z) {
+   // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+   __m128 a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 4), c = _mm_loadu_ps(p + 8);
+   x.v = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 3, 2)), _MM_SHUFFLE(3, 0, 3, 0));
+   y.v = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+                        _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+   z.v = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+                        _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+  }
+  inline void storeInterleaved3(float* p, Float4 x, Float4 y, Float4 z) {
+   _mm_storeu_ps(p, _mm_shuffle_ps(_mm_shuffle_ps(x.v, y.v, _MM_SHUFFLE(0, 0, 0, 0)),
+                                   _mm_shuffle_ps(z.v, x.v, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+   _mm_storeu_ps(p + 4, _mm_shuffle_ps(_mm_shuffle_ps(y.v, z.v, _MM_SHUFFLE(1, 1, 1, 1)),
+                                       _mm_shuffle_ps(x.v, y.v, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+   _mm_storeu_ps(p + 8, _mm_shuffle_ps(_mm_shuffle_ps(z.v, x.v, _MM_SHUFFLE(3, 3, 2, 2)),
+                                       _mm_shuffle_ps(y.v, z.v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+  }
+#elif defined(EU_SIMD_NEON)
+  inline void loadInterleaved2(const float* p, Float4& x, Float4& y) {
+   float32x4x2_t r = vld2q_f32(p);
+   x.v = r.val[0];
+   y.v = r.val[1];
+  }
+  inline void storeInterleaved2(float* p, Float4 x, Float4 y) {
+   float32x4x2_t r = { { x.v, y.v } };
+   vst2q_f32(p, r);
+  }
+  inline void loadInterleaved3(const float* p, Float4& x, Float4& y, Float4& z) {
+   float32x4x3_t r = vld3q_f32(p);
+   x.v = r.val[0];
+   y.v = r.val[1];
+   z.v = r.val[2];
+  }
+  inline void storeInterleaved3(float* p, Float4 x, Float4 y, Float4 z) {
+   float32x4x3_t r = { { x.v, y.v, z.v } };
+   vst3q_f32(p, r);
+  }
+#else
+  inline void loadInterleaved2(const float* p, Float4& x, Float4& y) {
+   for (int i = 0; i < 4; ++i) {
+    x.v[i] = p[2 * i];
+    y.v[i] = p[2 * i + 1];
+   }
+  }
+  inline void storeInterleaved2(float* p, Float4 x, Float4 y) {
+   for (int i = 0; i < 4; ++i) {
+    p[2 * i] = x.v[i];
+    p[2 * i + 1] = y.v[i];
+   }
+  }
+  inline void loadInterleaved3(const float* p, Float4& x, Float4& y, Float4& z) {
+   for (int i = 0; i < 4; ++i) {
+    x.v[i] = p[3 * i];
+    y.v[i] = p[3 * i + 1];
+    z.v[i] = p[3 * i + 2];
+   }
+  }
+  inline void storeInterleaved3(float* p, Float4 x, Float4 y, Float4 z) {
+   for (int i = 0; i < 4; ++i) {
+    p[3 * i] = x.v[i];
+    p[3 * i + 1] = y.v[i];
+    p[3 * i + 2] = z.v[i];
+   }
+  }
+#endif
+
+  /**
+   * Byte access for 8-bit pixel and color data: loadBytes() widens four unsigned bytes to float
+   * lanes, and storeBytes() narrows integer lanes to four bytes, saturating to [0, 255].
+   */
+#if defined(EU_SIMD_SSE2)
+  inline Float4 loadBytes(const uint8_t* p) {
+   int32_t word;
+   std::memcpy(&word, p, 4);
+   const __m128i zero = _mm_setzero_si128();
+   return { _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(word), zero), zero)) };
+  }
+  inline void storeBytes(Int4 a, uint8_t* p) {
+   const __m128i words = _mm_packs_epi32(a.v, a.v);
+   const int32_t word = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+   std::memcpy(p, &word, 4);
+  }
+#elif defined(EU_SIMD_NEON)
+  inline Float4 loadBytes(const uint8_t* p) {
+   uint32_t word;
+   std::memcpy(&word, p, 4);
+   const uint16x8_t words = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(word)));
+   return { vcvtq_f32_u32(vmovl_u16(vget_low_u16(words))) };
+  }
+  inline void storeBytes(Int4 a, uint8_t* p) {
+   const uint16x4_t words = vqmovun_s32(a.v);
+   const uint32_t word = vget_lane_u32(vreinterpret_u32_u8(vqmovn_u16(vcombine_u16(words, words))), 0);
+   std::memcpy(p, &word, 4);
+  }
+#else
+  inline Float4 loadBytes(const uint8_t* p) {
+   return { { static_cast<float>(p[0]), static_cast<float>(p[1]), static_cast<float>(p[2]), static_cast<float>(p[3]) } };
+  }
+  inline void storeBytes(Int4 a, uint8_t* p) {
+   for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(a.v[i] < 0 ? 0 : (a.v[i] > 255 ? 255 : a.v[i]));
+  }
+#endif
+
+#if defined(EU_SIMD_AVX2)
+  /** @brief Eight 32-bit integer lanes (AVX2). */
+  struct Int8 {
+   __m256i v;
+   static Int8 set1(int value) { return { _mm256_set1_epi32(value) }; }
+   static Int8 load(const int32_t* p) { return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)) }; }
+   void store(int32_t* p) const { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+  };
+
+  /** @brief Eight float lanes (AVX2). */
+  struct Float8 {
+   using Int = Int8;
+   static constexpr int WIDTH = 8;
+   __m256 v;
+   static Float8 set1(float value) { return { _mm256_set1_ps(value) }; }
+   static Float8 zero() { return { _mm256_setzero_ps() }; }
+   static Float8 load(const float* p) { return { _mm256_loadu_ps(p) }; }
+   static Float8 loadAligned(const float* p) { return { _mm256_load_ps(p) }; }
+   void store(float* p) const { _mm256_storeu_ps(p, v); }
+   void storeAligned(float* p) const { _mm256_store_ps(p, v); }
+  };
+
+  inline Float8 operator+(Float8 a, Float8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+  inline Float8 operator-(Float8 a, Float8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+  inline Float8 operator*(Float8 a, Float8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+  inline Float8 operator/(Float8 a, Float8 b) { return { _mm256_div_ps(a.v, b.v) }; }
+  inline Float8 operator-(Float8 a) { return { _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)) }; }
+  inline Float8 operator&(Float8 a, Float8 b) { return { _mm256_and_ps(a.v, b.v) }; }
+  inline Float8 operator|(Float8 a, Float8 b) { return { _mm256_or_ps(a.v, b.v) }; }
+  inline Float8 operator^(Float8 a, Float8 b) { return { _mm256_xor_ps(a.v, b.v) }; }
+  inline Float8 operator<(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+  inline Float8 operator>(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+  inline Float8 operator<=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+  inline Float8 operator>=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+  inline Float8 operator==(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+  inline Float8 operator!=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ) }; }
+  inline Float8 min(Float8 a, Float8 b) { return { _mm256_min_ps(a.v, b.v) }; }
+  inline Float8 max(Float8 a, Float8 b) { return { _mm256_max_ps(a.v, b.v) }; }
+  inline Float8 sqrt(Float8 a) { return { _mm256_sqrt_ps(a.v) }; }
+  inline Float8 rsqrtEstimate(Float8 a) {
+#if defined(EU_REPRODUCIBLE)
+   __m256 y = _mm256_castsi256_ps(_mm256_sub_epi32(_mm256_set1_epi32(0x5f375a86), _mm256_srli_epi32(_mm256_castps_si256(a.v), 1)));
+   __m256 t = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), a.v), y), y);
+   return { _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), t)) };
+#else
+   return { _mm256_rsqrt_ps(a.v) };
+#endif
+  }
+  inline Float8 select(Float8 mask, Float8 a, Float8 b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+  inline int movemask(Float8 mask) { return _mm256_movemask_ps(mask.v); }
+
+  inline Int8 operator+(Int8 a, Int8 b) { return { _mm256_add_epi32(a.v, b.v) }; }
+  inline Int8 operator-(Int8 a, Int8 b) { return { _mm256_sub_epi32(a.v, b.v) }; }
+  inline Int8 operator&(Int8 a, Int8 b) { return { _mm256_and_si256(a.v, b.v) }; }
+  inline Int8 operator|(Int8 a, Int8 b) { return { _mm256_or_si256(a.v, b.v) }; }
+  inline Int8 operator^(Int8 a, Int8 b) { return { _mm256_xor_si256(a.v, b.v) }; }
+  inline Int8 operator==(Int8 a, Int8 b) { return { _mm256_cmpeq_epi32(a.v, b.v) }; }
+  inline Int8 operator>(Int8 a, Int8 b) { return { _mm256_cmpgt_epi32(a.v, b.v) }; }
+  inline Int8 operator*(Int8 a, Int8 b) { return { _mm256_mullo_epi32(a.v, b.v) }; }
+  template<int N> inline Int8 shiftLeft(Int8 a) { return { _mm256_slli_epi32(a.v, N) }; }
+  template<int N> inline Int8 shiftRight(Int8 a) { return { _mm256_srli_epi32(a.v, N) }; }
+  inline Int8 roundToInt(Float8 a) { return { _mm256_cvtps_epi32(a.v) }; }
+  inline Int8 truncToInt(Float8 a) { return { _mm256_cvttps_epi32(a.v) }; }
+  inline Float8 toFloat(Int8 a) { return { _mm256_cvtepi32_ps(a.v) }; }
+  inline Int8 asInt(Float8 a) { return { _mm256_castps_si256(a.v) }; }
+  inline Float8 asFloat(Int8 a) { return { _mm256_castsi256_ps(a.v) }; }
+  inline Float8 truncate(Float8 a) { return { _mm256_round_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC) }; }
+  inline Float8 floor(Float8 a) { return { _mm256_floor_ps(a.v) }; }
+  inline Float8 ceil(Float8 a) { return { _mm256_ceil_ps(a.v) }; }
+
+  /** Interleaved access in two 4-lane halves (see the Float4 overloads). */
+  inline Float8 combine(Float4 lo, Float4 hi) { return { _mm256_insertf128_ps(_mm256_castps128_ps256(lo.v), hi.v, 1) }; }
+  inline Float4 lowHalf(Float8 a) { return { _mm256_castps256_ps128(a.v) }; }
+  inline Float4 highHalf(Float8 a) { return { _mm256_extractf128_ps(a.v, 1) }; }
+  inline void loadInterleaved2(const float* p, Float8& x, Float8& y) {
+   Float4 x0, y0, x1, y1;
+   loadInterleaved2(p, x0, y0);
+   loadInterleaved2(p + 8, x1, y1);
+   x = combine(x0, x1);
+   y = combine(y0, y1);
+  }
+  inline void storeInterleaved2(float* p, Float8 x, Float8 y) {
+   storeInterleaved2(p, lowHalf(x), lowHalf(y));
+   storeInterleaved2(p + 8, highHalf(x), highHalf(y));
+  }
+  inline void loadInterleaved3(const float* p, Float8& x, Float8& y, Float8& z) {
+   Float4 x0, y0, z0, x1, y1, z1;
+   loadInterleaved3(p, x0, y0, z0);
+   loadInterleaved3(p + 12, x1, y1, z1);
+   x = combine(x0, x1);
+   y = combine(y0, y1);
+   z = combine(z0, z1);
+  }
+  inline void storeInterleaved3(float* p, Float8 x, Float8 y, Float8 z) {
+   storeInterleaved3(p, lowHalf(x), lowHalf(y), lowHalf(z));
+   storeInterleaved3(p + 12, highHalf(x), highHalf(y), highHalf(z));
+  }
+
+  /** Eight-byte versions of loadBytes() and storeBytes(). */
+  inline Float8 loadBytes8(const uint8_t* p) {
+   return { _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)))) };
+  }
+  inline void storeBytes(Int8 a, uint8_t* p) {
+   const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(a.v), _mm256_extracti128_si256(a.v, 1));
+   _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(words, words));
+  }
+
+  /// Widest float register available to batch kernels.
+  using FloatN = Float8;
+#else
+  /// Widest float register available to batch kernels.
+  using FloatN = Float4;
+#endif
+
+  /**
+   * Multiply-add a * b + c and multiply-subtract a * b - c, fused only when the target has FMA
+   * (EU_SIMD_FMA on x86, always on AArch64) and EU_REPRODUCIBLE is off.
+   */
+  template<typename V>
+  inline V
+   madd(V a, V b, V c) {
+   return a * b + c;
+  }
+
+  template<typename V>
+  inline V
+   msub(V a, V b, V c) {
+   return a * b - c;
+  }
+
+#if defined(EU_SIMD_FMA) && defined(EU_SIMD_SSE2) && !defined(EU_REPRODUCIBLE)
+  template<> inline Float4 madd(Float4 a, Float4 b, Float4 c) { return { _mm_fmadd_ps(a.v, b.v, c.v) }; }
+  template<> inline Float4 msub(Float4 a, Float4 b, Float4 c) { return { _mm_fmsub_ps(a.v, b.v, c.v) }; }
+#endif
+#if defined(EU_SIMD_FMA) && defined(EU_SIMD_AVX2) && !defined(EU_REPRODUCIBLE)
+  template<> inline Float8 madd(Float8 a, Float8 b, Float8 c) { return { _mm256_fmadd_ps(a.v, b.v, c.v) }; }
+  template<> inline Float8 msub(Float8 a, Float8 b, Float8 c) { return { _mm256_fmsub_ps(a.v, b.v, c.v) }; }
+#endif
+#if defined(EU_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64)) && !defined(EU_REPRODUCIBLE)
+  template<> inline Float4 madd(Float4 a, Float4 b, Float4 c) { return { vfmaq_f32(c.v, a.v, b.v) }; }
+  template<> inline Float4 msub(Float4 a, Float4 b, Float4 c) { return { vfmaq_f32(vnegq_f32(c.v), a.v, b.v) }; }
+#endif
+
+  /** Comparison mask reductions: whether any, every or no lane is set. */
+  template<typename V> inline bool any(V mask) { return movemask(mask) != 0; }
+  template<typename V> inline bool all(V mask) { return movemask(mask) == (1 << V::WIDTH) - 1; }
+  template<typename V> inline bool none(V mask) { return movemask(mask) == 0; }
+
+  /** Lane-wise |a|, clearing the sign bit. */
+  template<typename V> inline V abs(V a) { return a & asFloat(V::Int::set1(0x7fffffff)); }
+
+  /** Lanes where a and b are equal or differ by at most epsilon, as EngineMath::approxEqual(). */
+  template<typename V> inline V approxEqual(V a, V b, V epsilon) { return (a == b) | (abs(a - b) <= epsilon); }
+ }
+}
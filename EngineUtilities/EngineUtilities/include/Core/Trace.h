@@ -0,0 +1,265 @@
+/**
+ * @file Trace.h
+ * @brief In-process instrumentation: scoped zones, counters and frame markers recorded into
+ * per-thread ring buffers, exported as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+ *
+ * The macros only do something when EU_TRACE is defined; otherwise they expand to nothing,
+ * so instrumented code costs nothing in normal builds.
+ *
+ *   EU_TRACE_ZONE("Cull");              // begin here, end at the end of the scope
+ *   EU_TRACE_COUNTER("Contacts", n);    // one sample of a named value
+ *   EU_TRACE_FRAME();                   // frame boundary marker
+ *   EU_TRACE_THREAD_NAME("Render");     // label for the calling thread's track
+ *
+ * Names must be string literals (or otherwise outlive the trace): events store the pointer.
+ * Every thread writes to its own ring of TRACE_BUFFER_EVENTS events, created on its first
+ * event and kept until exit, so recording is a timestamp read plus two plain stores and a
+ * release store of the ring's head, with no locks and no shared cache lines. A full ring
+ * overwrites its oldest events. Timestamps are raw rdtsc on x86 (steady_clock elsewhere),
+ * converted to microseconds at export against a steady_clock reading taken at the first
+ * event.
+ *
+ * writeChromeTrace() may run while other threads record: it copies each ring and keeps only
+ * the events the writer cannot have overwritten during the copy.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+ #define EU_TRACE_RDTSC 1
+ #if defined(_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+namespace EU {
+ /// Events per thread ring; a power of two.
+ constexpr size_t TRACE_BUFFER_EVENTS = 1 << 14;
+
+ namespace detail {
+  enum class TraceKind : uint32_t {
+   Begin,
+   End,
+   Counter,
+   Frame,
+  };
+
+  struct TraceEvent {
+   uint64_t time;
+   const char* name;
+   double value;
+   TraceKind kind;
+  };
+
+  /** Single-writer ring of one thread's events. */
+  struct TraceBuffer {
+   std::atomic<uint64_t> head{ 0 }; ///< Events ever written
+   uint64_t start = 0;              ///< First event still wanted, moved by clearTrace()
+   uint32_t thread = 0;
+   const char* name = nullptr;
+   TraceEvent events[TRACE_BUFFER_EVENTS];
+  };
+
+  inline uint64_t
+   traceTicks() {
+#if defined(EU_TRACE_RDTSC)
+   return __rdtsc();
+#else
+   return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+  }
+
+  /** Every thread's buffer, plus the tick/clock pair the export calibrates against. */
+  struct TraceRegistry {
+   std::mutex mutex;
+   std::vector<std::unique_ptr<TraceBuffer>> buffers;
+   uint64_t originTicks = traceTicks();
+   std::chrono::steady_clock::time_point originClock = std::chrono::steady_clock::now();
+  };
+
+  inline TraceRegistry&
+   traceRegistry() {
+   static TraceRegistry registry;
+   return registry;
+  }
+
+  inline TraceBuffer&
+   traceBuffer() {
+   static thread_local TraceBuffer* buffer = nullptr;
+   if (buffer == nullptr) {
+    TraceRegistry& registry = traceRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.buffers.emplace_back(new TraceBuffer());
+    buffer = registry.buffers.back().get();
+    buffer->thread = static_cast<uint32_t>(registry.buffers.size());
+   }
+   return *buffer;
+  }
+
+  inline void
+   traceRecord(TraceKind kind, const char* name, double value = 0.0) {
+   TraceBuffer& buffer = traceBuffer();
+   const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+   TraceEvent& event = buffer.events[head & (TRACE_BUFFER_EVENTS - 1)];
+   event.time = traceTicks();
+   event.name = name;
+   event.value = value;
+   event.kind = kind;
+   buffer.head.store(head + 1, std::memory_order_release);
+  }
+
+  /** Records a Begin event now and the matching End when it leaves scope. */
+  class
+   TraceZone {
+   public:
+   explicit TraceZone(const char* name) : m_name(name) {
+    traceRecord(TraceKind::Begin, name);
+   }
+
+   ~TraceZone() {
+    traceRecord(TraceKind::End, m_name);
+   }
+
+   TraceZone(const TraceZone&) = delete;
+   TraceZone& operator=(const TraceZone&) = delete;
+
+   private:
+   const char* m_name;
+  };
+
+  inline void
+   appendJsonString(std::string& out, const char* text) {
+   out += '"';
+   for (const char* c = text ? text : ""; *c; ++c) {
+    if (*c == '"' || *c == '\\') out += '\\';
+    if (static_cast<unsigned char>(*c) >= 0x20) out += *c;
+   }
+   out += '"';
+  }
+ }
+
+ /** @brief Labels the calling thread's track in the exported trace; name must outlive it. */
+ inline void
+  setTraceThreadName(const char* name) {
+  detail::traceBuffer().name = name;
+ }
+
+ /**
+  * @brief Drops every event recorded so far, e.g. to capture only the frames after a
+  * warm-up. Events recorded concurrently with the call may or may not survive.
+  */
+ inline void
+  clearTrace() {
+  detail::TraceRegistry& registry = detail::traceRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const std::unique_ptr<detail::TraceBuffer>& buffer : registry.buffers) {
+   buffer->start = buffer->head.load(std::memory_order_acquire);
+  }
+ }
+
+ /**
+  * @brief The recorded events as a Chrome trace JSON document, oldest first per thread.
+  * Zones whose Begin was overwritten export their End alone, which viewers ignore.
+  */
+ inline std::string
+  chromeTraceJson() {
+  using namespace detail;
+  TraceRegistry& registry = traceRegistry();
+  const uint64_t nowTicks = traceTicks();
+  const auto nowClock = std::chrono::steady_clock::now();
+  const double elapsedUs = std::chrono::duration<double, std::micro>(nowClock - registry.originClock).count();
+  const double ticks = static_cast<double>(nowTicks - registry.originTicks);
+  const double usPerTick = ticks > 0.0 && elapsedUs > 0.0 ? elapsedUs / ticks : 1e-3;
+
+  std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  char number[64];
+  std::vector<TraceEvent> copy;
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const std::unique_ptr<TraceBuffer>& buffer : registry.buffers) {
+   const uint64_t head = buffer->head.load(std::memory_order_acquire);
+   uint64_t begin = head > TRACE_BUFFER_EVENTS ? head - TRACE_BUFFER_EVENTS : 0;
+   if (begin < buffer->start) begin = buffer->start;
+   copy.clear();
+   for (uint64_t i = begin; i < head; ++i) copy.push_back(buffer->events[i & (TRACE_BUFFER_EVENTS - 1)]);
+   // Slots the writer reached again while they were copied hold newer events: drop them.
+   const uint64_t after = buffer->head.load(std::memory_order_acquire);
+   const uint64_t valid = after > TRACE_BUFFER_EVENTS ? after - TRACE_BUFFER_EVENTS : 0;
+   const size_t skip = valid > begin ? static_cast<size_t>(valid - begin) : 0;
+
+   if (buffer->name != nullptr) {
+    std::snprintf(number, sizeof(number), "%u", buffer->thread);
+    out += first ? "" : ",";
+    out += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":";
+    out += number;
+    out += ",\"args\":{\"name\":";
+    appendJsonString(out, buffer->name);
+    out += "}}";
+    first = false;
+   }
+   for (size_t e = skip; e < copy.size(); ++e) {
+    const TraceEvent& event = copy[e];
+    static const char* const phases[] = { "B", "E", "C", "i" };
+    const double us = static_cast<double>(event.time - registry.originTicks) * usPerTick;
+    out += first ? "{\"ph\":\"" : ",{\"ph\":\"";
+    first = false;
+    out += phases[static_cast<uint32_t>(event.kind)];
+    out += "\",\"name\":";
+    appendJsonString(out, event.name);
+    std::snprintf(number, sizeof(number), ",\"pid\":1,\"tid\":%u,\"ts\":%.3f", buffer->thread, us);
+    out += number;
+    if (event.kind == TraceKind::Counter) {
+     std::snprintf(number, sizeof(number), ",\"args\":{\"value\":%.17g}", event.value);
+     out += number;
+    }
+    else if (event.kind == TraceKind::Frame) {
+     out += ",\"s\":\"g\"";
+    }
+    out += '}';
+   }
+  }
+  out += "]}";
+  return out;
+ }
+
+ /** @brief Writes chromeTraceJson() to path; false if the file cannot be written. */
+ inline bool
+  writeChromeTrace(const char* path) {
+  const std::string json = chromeTraceJson();
+  std::FILE* file = std::fopen(path, "wb");
+  if (file == nullptr) return false;
+  const bool written = std::fwrite(json.data(), 1, json.size(), file) == json.size();
+  return std::fclose(file) == 0 && written;
+ }
+}
+
+#define EU_TRACE_CONCAT_(a, b) a##b
+#define EU_TRACE_CONCAT(a, b) EU_TRACE_CONCAT_(a, b)
+
+#if defined(EU_TRACE)
+ /// Times the rest of the enclosing scope as a zone called name (a string literal).
+ #define EU_TRACE_ZONE(name) const ::EU::detail::TraceZone EU_TRACE_CONCAT(euTraceZone, __LINE__)(name)
+ /// Records one sample of counter name.
+ #define EU_TRACE_COUNTER(name, value) \
+  ::EU::detail::traceRecord(::EU::detail::TraceKind::Counter, name, static_cast<double>(value))
+ /// Marks a frame boundary on every track.
+ #define EU_TRACE_FRAME() ::EU::detail::traceRecord(::EU::detail::TraceKind::Frame, "Frame")
+ /// Names the calling thread's track.
+ #define EU_TRACE_THREAD_NAME(name) ::EU::setTraceThreadName(name)
+#else
+ #define EU_TRACE_ZONE(name) ((void)0)
+ #define EU_TRACE_COUNTER(name, value) ((void)0)
+ #define EU_TRACE_FRAME() ((void)0)
+ #define EU_TRACE_THREAD_NAME(name) ((void)0)
+#endif
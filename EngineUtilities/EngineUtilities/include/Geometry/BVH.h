@@ -0,0 +1,946 @@
+/**
+ * @file BVH.h
+ * @brief Bounding volume hierarchies over triangle meshes: binned-SAH build, refit, and
+ * closest-hit, any-hit and box-overlap queries.
+ *
+ * BVH::build() sorts triangle references by the centroid of their bounds into BVH_BINS bins
+ * per axis and takes the split plane with the lowest surface area heuristic cost, with one
+ * traversal step costing as much as one triangle test. Ranges larger than
+ * detail::BVH_TASK_SIZE are split on the calling thread, their bounds and bins gathered in
+ * chunks across threads; once every open range is below that size, the ranges are built as
+ * independent tasks and stitched together in depth-first order. Bounds and bin counts merge
+ * exactly in any order, so the tree only depends on the input, never on the thread count.
+ * After detail::BVH_MEDIAN_DEPTH levels the builder falls back to median splits, which keeps
+ * every path within detail::BVH_STACK_DEPTH nodes and the traversal stacks fixed-size.
+ *
+ * Nodes are 32 bytes and stored depth-first: an inner node's first child is the next node
+ * and only the second needs an index, so a descent mostly walks forward through memory.
+ * Leaves reference a copy of their triangles' corners kept in leaf order as SoA lanes, so a
+ * leaf costs one packet test of RayTriangle.h per register of triangles. refit() reloads the
+ * corners from the mesh and recomputes every bound bottom-up in one backwards pass, for
+ * meshes that deform without changing topology; the tree quality degrades as the mesh moves
+ * away from its shape at build time.
+ *
+ * A BVH answers its queries through a BVHView, which reads node and triangle arrays it does
+ * not own, so a tree stored in a mapped pack file (PackTypes.h) is traced in place.
+ *
+ * WideBVH<4> and WideBVH<8> collapse a built BVH into nodes of four or eight children whose
+ * bounds are stored as SoA lanes, so one node visit is one SIMD slab test (see Primitives.h)
+ * of all children. Which to use is a measurement; Width 8 suits AVX2, Width 4 SSE and NEON.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Geometry/Primitives.h>
+#include <Geometry/RayTriangle.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Centroid bins per axis of the SAH sweep.
+ constexpr size_t BVH_BINS = 16;
+ /// Default largest leaf; larger ranges are always split.
+ constexpr uint32_t BVH_MAX_LEAF = 4;
+
+ /**
+  * @brief Node of a BVH: 32 bytes, depth-first order.
+  */
+ struct BVHNode {
+  AABB bounds;    ///< Bounds of everything below
+  uint32_t first; ///< Leaf: first triangle slot; inner: index of the second child (the first is the next node)
+  uint32_t count; ///< Triangles in a leaf, 0 for an inner node
+ };
+
+ EU_ASSERT_VALUE_TYPE(BVHNode);
+
+ namespace detail {
+  /// Ranges up to this many triangles are built as one task; larger ones are split first.
+  constexpr size_t BVH_TASK_SIZE = 8192;
+  /// Depth after which SAH splits give way to median splits.
+  constexpr int BVH_MEDIAN_DEPTH = 32;
+  /// Longest root-to-leaf path: BVH_MEDIAN_DEPTH SAH levels, then halving at most 32 times.
+  constexpr size_t BVH_STACK_DEPTH = 64;
+
+  /** One triangle during the build. */
+  struct BVHRef {
+   AABB bounds;
+   CVector3 centroid;
+   uint32_t triangle;
+  };
+
+  struct BVHBin {
+   AABB bounds;
+   uint32_t count = 0;
+  };
+
+  /** Bins along all three axes. */
+  struct BVHBins {
+   BVHBin bin[3][BVH_BINS];
+
+   void
+    merge(const BVHBins& otro) {
+    for (int a = 0; a < 3; ++a)
+     for (size_t b = 0; b < BVH_BINS; ++b) {
+      bin[a][b].bounds.merge(otro.bin[a][b].bounds);
+      bin[a][b].count += otro.bin[a][b].count;
+     }
+   }
+  };
+
+  /** Bin of centroid component c, for bins starting at lo with scale = BVH_BINS / extent. */
+  inline size_t
+   bvhBin(float c, float lo, float scale) {
+   const float f = (c - lo) * scale;
+   return f <= 0.f ? 0 : (f >= static_cast<float>(BVH_BINS - 1) ? BVH_BINS - 1 : static_cast<size_t>(f));
+  }
+
+  /**
+   * Leaf-order triangles over arrays the view does not own: corners as SoA lanes, for the
+   * packet tests of RayTriangle.h, and the mesh triangle index of each slot.
+   */
+  struct BVHTriangleView {
+   const float* corner[3][3] = {}; ///< [corner][axis], one float per slot
+   const uint32_t* ids = nullptr;  ///< Mesh triangle index per slot
+   size_t count = 0;
+
+   /** Corner c of the slots from first on. */
+   EngineMath::batch::ConstSoA3
+    soa(size_t c, uint32_t first) const {
+    return { corner[c][0] + first, corner[c][1] + first, corner[c][2] + first };
+   }
+
+   AABB
+    bounds(uint32_t first, uint32_t slots) const {
+    AABB box;
+    for (size_t s = first; s < size_t(first) + slots; ++s)
+     for (size_t c = 0; c < 3; ++c) box.merge(CVector3(corner[c][0][s], corner[c][1][s], corner[c][2][s]));
+    return box;
+   }
+
+   /** Closest hit among slots [first, first + slots), shrinking tMax; true if any. */
+   bool
+    closest(uint32_t first, uint32_t slots, const Ray& ray, float& tMax, RayHit& hit) const {
+    RayHit leaf;
+    if (!closestRayTriangle(ray, soa(0, first), soa(1, first), soa(2, first), slots, tMax, leaf)) return false;
+    tMax = leaf.t;
+    hit = RayHit{ ids[first + leaf.triangle], leaf.t, leaf.u, leaf.v };
+    return true;
+   }
+
+   bool
+    any(uint32_t first, uint32_t slots, const Ray& ray, float tMax) const {
+    return anyRayTriangle(ray, soa(0, first), soa(1, first), soa(2, first), slots, tMax);
+   }
+
+   /** Appends the ids of the slots whose bounds overlap box. */
+   size_t
+    overlap(uint32_t first, uint32_t slots, const AABB& box, std::vector<uint32_t>& out) const {
+    size_t found = 0;
+    for (uint32_t s = first; s < first + slots; ++s) {
+     if (bounds(s, 1).intersects(box)) {
+      out.push_back(ids[s]);
+      ++found;
+     }
+    }
+    return found;
+   }
+  };
+
+  /**
+   * Owned leaf-order triangles: the arrays of a BVHTriangleView, plus the mesh indices of
+   * the corners, for refit().
+   */
+  struct BVHTriangles {
+   std::vector<float> corner[3][3]; ///< [corner][axis], one float per slot
+   std::vector<uint32_t> vertices;  ///< Mesh vertex index of each corner, three per slot
+   std::vector<uint32_t> ids;       ///< Mesh triangle index per slot
+
+   void
+    assign(const CVector3* mesh, const uint32_t* indices, const std::vector<BVHRef>& refs) {
+    const size_t n = refs.size();
+    vertices.resize(3 * n);
+    ids.resize(n);
+    for (size_t s = 0; s < n; ++s) {
+     const uint32_t tri = refs[s].triangle;
+     ids[s] = tri;
+     for (size_t c = 0; c < 3; ++c) vertices[3 * s + c] = indices[3 * tri + c];
+    }
+    for (auto& c : corner)
+     for (std::vector<float>& axis : c) axis.resize(n);
+    refit(mesh);
+   }
+
+   void
+    refit(const CVector3* mesh) {
+    for (size_t s = 0; s < ids.size(); ++s) {
+     for (size_t c = 0; c < 3; ++c) {
+      const CVector3& p = mesh[vertices[3 * s + c]];
+      corner[c][0][s] = p.x;
+      corner[c][1][s] = p.y;
+      corner[c][2][s] = p.z;
+     }
+    }
+   }
+
+   void
+    clear() {
+    for (auto& c : corner)
+     for (std::vector<float>& axis : c) axis.clear();
+    vertices.clear();
+    ids.clear();
+   }
+
+   BVHTriangleView
+    view() const {
+    BVHTriangleView v;
+    for (size_t c = 0; c < 3; ++c)
+     for (size_t a = 0; a < 3; ++a) v.corner[c][a] = corner[c][a].data();
+    v.ids = ids.data();
+    v.count = ids.size();
+    return v;
+   }
+
+   AABB
+    bounds(uint32_t first, uint32_t count) const {
+    return view().bounds(first, count);
+   }
+
+   bool
+    closest(uint32_t first, uint32_t count, const Ray& ray, float& tMax, RayHit& hit) const {
+    return view().closest(first, count, ray, tMax, hit);
+   }
+
+   bool
+    any(uint32_t first, uint32_t count, const Ray& ray, float tMax) const {
+    return view().any(first, count, ray, tMax);
+   }
+
+   size_t
+    overlap(uint32_t first, uint32_t count, const AABB& box, std::vector<uint32_t>& out) const {
+    return view().overlap(first, count, box, out);
+   }
+  };
+
+  /**
+   * Binned-SAH builder. Works on refs in place: every node owns a contiguous range, which
+   * becomes the leaf order of the triangles.
+   */
+  class
+   BVHBuilder {
+   public:
+   BVHBuilder(std::vector<BVHRef>& refs, uint32_t maxLeaf, size_t threads)
+    : m_refs(refs), m_maxLeaf(maxLeaf < 1 ? 1 : maxLeaf), m_threads(threads) {}
+
+   void
+    build(std::vector<BVHNode>& nodes) {
+    nodes.clear();
+    if (m_refs.empty()) return;
+    m_top.clear();
+    m_tasks.clear();
+    const uint32_t root = top(0, m_refs.size(), 0);
+    std::vector<std::vector<BVHNode>> built(m_tasks.size());
+    parallelTasks(m_tasks.size(), resolveThreads(m_threads, m_tasks.size()), [&](size_t t) {
+     const Top& task = m_top[m_tasks[t]];
+     subtree(task.begin, task.end, task.depth, built[t]);
+    });
+    emit(root, built, nodes);
+   }
+
+   private:
+   /** Node above the task ranges: either two children or the task that builds the range. */
+   struct Top {
+    size_t begin, end;
+    int depth;
+    uint32_t left, right, task;
+   };
+   static constexpr uint32_t NONE = 0xffffffffu;
+
+   /** Bounds and centroid bounds of [begin, end), in chunks across threads for large ranges. */
+   void
+    rangeBounds(size_t begin, size_t end, AABB& bounds, AABB& centroids) const {
+    const size_t chunks = (end - begin + BVH_TASK_SIZE - 1) / BVH_TASK_SIZE;
+    std::vector<AABB> b(chunks), c(chunks);
+    auto run = [&](size_t k) {
+     const size_t lo = begin + k * BVH_TASK_SIZE, hi = end - lo < BVH_TASK_SIZE ? end : lo + BVH_TASK_SIZE;
+     for (size_t i = lo; i < hi; ++i) {
+      b[k].merge(m_refs[i].bounds);
+      c[k].merge(m_refs[i].centroid);
+     }
+    };
+    if (chunks > 1) parallelTasks(chunks, resolveThreads(m_threads, chunks), run);
+    else run(0);
+    bounds = AABB();
+    centroids = AABB();
+    for (size_t k = 0; k < chunks; ++k) {
+     bounds.merge(b[k]);
+     centroids.merge(c[k]);
+    }
+   }
+
+   /** Bins of [begin, end) along every axis of centroids. */
+   void
+    rangeBins(size_t begin, size_t end, const AABB& centroids, const float (&scale)[3], BVHBins& bins) const {
+    const size_t chunks = (end - begin + BVH_TASK_SIZE - 1) / BVH_TASK_SIZE;
+    std::vector<BVHBins> partial(chunks);
+    const float lo[3] = { centroids.min.x, centroids.min.y, centroids.min.z };
+    auto run = [&](size_t k) {
+     const size_t first = begin + k * BVH_TASK_SIZE, last = end - first < BVH_TASK_SIZE ? end : first + BVH_TASK_SIZE;
+     for (size_t i = first; i < last; ++i) {
+      const BVHRef& r = m_refs[i];
+      for (int a = 0; a < 3; ++a) {
+       BVHBin& bin = partial[k].bin[a][bvhBin(r.centroid[a], lo[a], scale[a])];
+       bin.bounds.merge(r.bounds);
+       ++bin.count;
+      }
+     }
+    };
+    if (chunks > 1) parallelTasks(chunks, resolveThreads(m_threads, chunks), run);
+    else run(0);
+    bins = BVHBins();
+    for (size_t k = 0; k < chunks; ++k) bins.merge(partial[k]);
+   }
+
+   /** Where [begin, end) splits (refs partitioned around it), or begin for a leaf. */
+   size_t
+    split(size_t begin, size_t end, const AABB& bounds, const AABB& centroids, int depth) {
+    const size_t n = end - begin;
+    if (n <= 1) return begin;
+    const CVector3 extent = centroids.size();
+    int axis = extent.y > extent.x ? 1 : 0;
+    axis = extent.z > extent[axis] ? 2 : axis;
+    if (extent[axis] <= 0.f) {
+     // Identical centroids: no plane separates them, and any halving is as good as another.
+     return n <= m_maxLeaf ? begin : begin + n / 2;
+    }
+    if (depth >= BVH_MEDIAN_DEPTH) {
+     const size_t mid = begin + n / 2;
+     std::nth_element(m_refs.begin() + begin, m_refs.begin() + mid, m_refs.begin() + end,
+                      [axis](const BVHRef& a, const BVHRef& b) { return a.centroid[axis] < b.centroid[axis]; });
+     return mid;
+    }
+    float scale[3];
+    for (int a = 0; a < 3; ++a) scale[a] = extent[a] > 0.f ? static_cast<float>(BVH_BINS) / extent[a] : 0.f;
+    BVHBins bins;
+    rangeBins(begin, end, centroids, scale, bins);
+    float bestCost = 0.f;
+    int bestAxis = -1;
+    size_t bestBin = 0;
+    for (int a = 0; a < 3; ++a) {
+     if (scale[a] == 0.f) continue;
+     // Right-to-left prefix of area * count, then sweep left to right.
+     float rightCost[BVH_BINS] = {};
+     AABB box;
+     uint32_t count = 0;
+     for (size_t b = BVH_BINS - 1; b > 0; --b) {
+      box.merge(bins.bin[a][b].bounds);
+      count += bins.bin[a][b].count;
+      rightCost[b] = count ? box.surfaceArea() * static_cast<float>(count) : -1.f;
+     }
+     box = AABB();
+     count = 0;
+     for (size_t b = 0; b + 1 < BVH_BINS; ++b) {
+      box.merge(bins.bin[a][b].bounds);
+      count += bins.bin[a][b].count;
+      if (count == 0 || rightCost[b + 1] < 0.f) continue;
+      const float cost = box.surfaceArea() * static_cast<float>(count) + rightCost[b + 1];
+      if (bestAxis < 0 || cost < bestCost) {
+       bestCost = cost;
+       bestAxis = a;
+       bestBin = b;
+      }
+     }
+    }
+    // Leaf cost n against 1 + cost / area: keep small ranges whole unless splitting pays.
+    if (bestAxis < 0 || (n <= m_maxLeaf && bestCost >= static_cast<float>(n - 1) * bounds.surfaceArea())) {
+     if (n <= m_maxLeaf) return begin;
+     if (bestAxis < 0) return begin + n / 2;
+    }
+    const float lo = centroids.min[bestAxis], s = scale[bestAxis];
+    const auto mid = std::partition(m_refs.begin() + begin, m_refs.begin() + end, [&](const BVHRef& r) {
+     return bvhBin(r.centroid[bestAxis], lo, s) <= bestBin;
+    });
+    return static_cast<size_t>(mid - m_refs.begin());
+   }
+
+   /** Builds [begin, end) depth-first into nodes, root first. */
+   void
+    subtree(size_t begin, size_t end, int depth, std::vector<BVHNode>& nodes) {
+    AABB bounds, centroids;
+    rangeBounds(begin, end, bounds, centroids);
+    const size_t index = nodes.size();
+    nodes.push_back(BVHNode{ bounds, static_cast<uint32_t>(begin), static_cast<uint32_t>(end - begin) });
+    const size_t mid = split(begin, end, bounds, centroids, depth);
+    if (mid == begin) return;
+    nodes[index].count = 0;
+    subtree(begin, mid, depth + 1, nodes);
+    nodes[index].first = static_cast<uint32_t>(nodes.size());
+    subtree(mid, end, depth + 1, nodes);
+   }
+
+   /** Splits [begin, end) on this thread until every range fits one task. */
+   uint32_t
+    top(size_t begin, size_t end, int depth) {
+    const uint32_t index = static_cast<uint32_t>(m_top.size());
+    m_top.push_back(Top{ begin, end, depth, NONE, NONE, NONE });
+    size_t mid = begin;
+    if (end - begin > BVH_TASK_SIZE) {
+     AABB bounds, centroids;
+     rangeBounds(begin, end, bounds, centroids);
+     mid = split(begin, end, bounds, centroids, depth);
+    }
+    if (mid == begin) {
+     m_top[index].task = static_cast<uint32_t>(m_tasks.size());
+     m_tasks.push_back(index);
+     return index;
+    }
+    const uint32_t left = top(begin, mid, depth + 1);
+    const uint32_t right = top(mid, end, depth + 1);
+    m_top[index].left = left;
+    m_top[index].right = right;
+    return index;
+   }
+
+   /** Appends the subtree of top node t to nodes in depth-first order. */
+   void
+    emit(uint32_t t, const std::vector<std::vector<BVHNode>>& built, std::vector<BVHNode>& nodes) const {
+    const Top& node = m_top[t];
+    if (node.task != NONE) {
+     const uint32_t offset = static_cast<uint32_t>(nodes.size());
+     for (BVHNode n : built[node.task]) {
+      if (n.count == 0) n.first += offset;
+      nodes.push_back(n);
+     }
+     return;
+    }
+    const size_t index = nodes.size();
+    nodes.push_back(BVHNode{ AABB(), 0, 0 });
+    emit(node.left, built, nodes);
+    const uint32_t second = static_cast<uint32_t>(nodes.size());
+    emit(node.right, built, nodes);
+    nodes[index].first = second;
+    nodes[index].bounds = nodes[index + 1].bounds.merged(nodes[second].bounds);
+   }
+
+   std::vector<BVHRef>& m_refs;
+   uint32_t m_maxLeaf;
+   size_t m_threads;
+   std::vector<Top> m_top;
+   std::vector<uint32_t> m_tasks; ///< Top node of each task
+  };
+
+  /** Traversal stack entry: a node and the entry t of its bounds. */
+  struct BVHStackEntry {
+   uint32_t node;
+   float t;
+  };
+ }
+
+ /**
+  * @class BVHView
+  * @brief Queries of a built BVH over node and triangle arrays it does not own, e.g. inside a
+  * mapped pack file (PackTypes.h); a BVH answers its queries through one.
+  */
+ class
+  BVHView {
+  public:
+  BVHView() : m_nodes(nullptr), m_nodeCount(0) {}
+
+  BVHView(const BVHNode* nodes, size_t nodeCount, const detail::BVHTriangleView& triangles)
+   : m_nodes(nodes), m_nodeCount(nodeCount), m_triangles(triangles) {}
+
+  /**
+   * @brief Nearest triangle ray hits within [0, tMax], from either side; hit is left
+   * unchanged on a miss.
+   */
+  bool
+   closestHit(const Ray& ray, float tMax, RayHit& hit) const {
+   if (m_nodeCount == 0) return false;
+   const CVector3 inv = ray.inverseDirection();
+   float t = 0.f;
+   if (!m_nodes[0].bounds.intersectsRay(ray.origin, inv, tMax, t)) return false;
+   detail::BVHStackEntry stack[detail::BVH_STACK_DEPTH + 1];
+   size_t top = 0;
+   stack[top++] = { 0, t };
+   bool found = false;
+   while (top > 0) {
+    const detail::BVHStackEntry entry = stack[--top];
+    if (entry.t > tMax) continue;
+    const BVHNode& node = m_nodes[entry.node];
+    if (node.count) {
+     found |= m_triangles.closest(node.first, node.count, ray, tMax, hit);
+     continue;
+    }
+    const uint32_t a = entry.node + 1, b = node.first;
+    float ta = 0.f, tb = 0.f;
+    const bool hitA = m_nodes[a].bounds.intersectsRay(ray.origin, inv, tMax, ta);
+    const bool hitB = m_nodes[b].bounds.intersectsRay(ray.origin, inv, tMax, tb);
+    // Push the farther child first so the nearer one is visited next.
+    if (hitA && hitB) {
+     const bool aFirst = ta <= tb;
+     stack[top++] = aFirst ? detail::BVHStackEntry{ b, tb } : detail::BVHStackEntry{ a, ta };
+     stack[top++] = aFirst ? detail::BVHStackEntry{ a, ta } : detail::BVHStackEntry{ b, tb };
+    }
+    else if (hitA) stack[top++] = { a, ta };
+    else if (hitB) stack[top++] = { b, tb };
+   }
+   return found;
+  }
+
+  /**
+   * @brief True when ray hits any triangle within [0, tMax]; stops at the first one found,
+   * for occlusion and line-of-sight rays.
+   */
+  bool
+   anyHit(const Ray& ray, float tMax) const {
+   if (m_nodeCount == 0) return false;
+   const CVector3 inv = ray.inverseDirection();
+   uint32_t stack[detail::BVH_STACK_DEPTH + 1];
+   size_t top = 0;
+   stack[top++] = 0;
+   while (top > 0) {
+    const BVHNode& node = m_nodes[stack[--top]];
+    float t = 0.f;
+    if (!node.bounds.intersectsRay(ray.origin, inv, tMax, t)) continue;
+    if (node.count) {
+     if (m_triangles.any(node.first, node.count, ray, tMax)) return true;
+     continue;
+    }
+    stack[top++] = node.first;
+    stack[top++] = static_cast<uint32_t>(&node - m_nodes) + 1;
+   }
+   return false;
+  }
+
+  /**
+   * @brief Appends to triangles the indices of the triangles whose bounds overlap box, a
+   * conservative candidate set; returns how many were appended.
+   */
+  size_t
+   overlap(const AABB& box, std::vector<uint32_t>& triangles) const {
+   if (m_nodeCount == 0) return 0;
+   size_t found = 0;
+   uint32_t stack[detail::BVH_STACK_DEPTH + 1];
+   size_t top = 0;
+   stack[top++] = 0;
+   while (top > 0) {
+    const uint32_t index = stack[--top];
+    const BVHNode& node = m_nodes[index];
+    if (!node.bounds.intersects(box)) continue;
+    if (node.count) {
+     found += m_triangles.overlap(node.first, node.count, box, triangles);
+     continue;
+    }
+    stack[top++] = node.first;
+    stack[top++] = index + 1;
+   }
+   return found;
+  }
+
+  /** @brief True when nothing has been built. */
+  bool
+   empty() const {
+   return m_nodeCount == 0;
+  }
+
+  /** @brief Bounds of the whole mesh; empty when nothing has been built. */
+  AABB
+   bounds() const {
+   return m_nodeCount == 0 ? AABB() : m_nodes[0].bounds;
+  }
+
+  const BVHNode*
+   nodes() const {
+   return m_nodes;
+  }
+
+  size_t
+   nodeCount() const {
+   return m_nodeCount;
+  }
+
+  size_t
+   triangleCount() const {
+   return m_triangles.count;
+  }
+
+  const detail::BVHTriangleView&
+   triangles() const {
+   return m_triangles;
+  }
+
+  private:
+  const BVHNode* m_nodes;
+  size_t m_nodeCount;
+  detail::BVHTriangleView m_triangles;
+ };
+
+ /**
+  * @class BVH
+  * @brief Binary bounding volume hierarchy over the triangles of an indexed mesh.
+  */
+ class
+  BVH {
+  public:
+  BVH() {}
+
+  /**
+   * @brief Builds over triangleCount triangles, triangle i being the corners
+   * vertices[indices[3i]], vertices[indices[3i + 1]] and vertices[indices[3i + 2]].
+   * @param maxLeafSize Largest leaf; smaller ranges become leaves when SAH says splitting
+   * does not pay.
+   * @param threads Worker threads, 0 for hardware_concurrency(); meshes up to
+   * detail::BVH_TASK_SIZE triangles build on the calling thread.
+   */
+  void
+   build(const CVector3* vertices, const uint32_t* indices, size_t triangleCount, uint32_t maxLeafSize = BVH_MAX_LEAF,
+         size_t threads = 0) {
+   std::vector<detail::BVHRef> refs(triangleCount);
+   for (size_t i = 0; i < triangleCount; ++i) {
+    AABB box;
+    for (size_t c = 0; c < 3; ++c) box.merge(vertices[indices[3 * i + c]]);
+    refs[i] = detail::BVHRef{ box, box.center(), static_cast<uint32_t>(i) };
+   }
+   detail::BVHBuilder(refs, maxLeafSize, threads).build(m_nodes);
+   m_triangles.assign(vertices, indices, refs);
+  }
+
+  /**
+   * @brief Recomputes every bound after the mesh vertices moved; vertices must be indexed
+   * as at build().
+   */
+  void
+   refit(const CVector3* vertices) {
+   m_triangles.refit(vertices);
+   for (size_t i = m_nodes.size(); i-- > 0;) {
+    BVHNode& node = m_nodes[i];
+    node.bounds = node.count ? m_triangles.bounds(node.first, node.count)
+                             : m_nodes[i + 1].bounds.merged(m_nodes[node.first].bounds);
+   }
+  }
+
+  /** @brief Drops the tree and the triangle copy. */
+  void
+   clear() {
+   m_nodes.clear();
+   m_triangles.clear();
+  }
+
+  /**
+   * @brief Nearest triangle ray hits within [0, tMax], from either side; hit is left
+   * unchanged on a miss.
+   */
+  bool
+   closestHit(const Ray& ray, float tMax, RayHit& hit) const {
+   return view().closestHit(ray, tMax, hit);
+  }
+
+  /**
+   * @brief True when ray hits any triangle within [0, tMax]; stops at the first one found,
+   * for occlusion and line-of-sight rays.
+   */
+  bool
+   anyHit(const Ray& ray, float tMax) const {
+   return view().anyHit(ray, tMax);
+  }
+
+  /**
+   * @brief Appends to triangles the indices of the triangles whose bounds overlap box, a
+   * conservative candidate set; returns how many were appended.
+   */
+  size_t
+   overlap(const AABB& box, std::vector<uint32_t>& triangles) const {
+   return view().overlap(box, triangles);
+  }
+
+  /** @brief True when nothing has been built. */
+  bool
+   empty() const {
+   return m_nodes.empty();
+  }
+
+  /** @brief Bounds of the whole mesh; empty when nothing has been built. */
+  AABB
+   bounds() const {
+   return m_nodes.empty() ? AABB() : m_nodes[0].bounds;
+  }
+
+  /** @brief Non-owning view, valid until the tree is rebuilt, cleared or destroyed. */
+  BVHView
+   view() const {
+   return BVHView(m_nodes.data(), m_nodes.size(), m_triangles.view());
+  }
+
+  /** @brief The nodes, root first in depth-first order. */
+  const std::vector<BVHNode>&
+   nodes() const {
+   return m_nodes;
+  }
+
+  size_t
+   triangleCount() const {
+   return m_triangles.ids.size();
+  }
+
+  /** @brief Leaf-order triangle storage, shared with WideBVH. */
+  const detail::BVHTriangles&
+   triangles() const {
+   return m_triangles;
+  }
+
+  private:
+  std::vector<BVHNode> m_nodes;
+  detail::BVHTriangles m_triangles;
+ };
+
+ /**
+  * @class WideBVH
+  * @brief BVH collapsed to Width (4 or 8) children per node, tested with one SIMD slab test
+  * per node.
+  */
+ template<size_t Width>
+ class
+  WideBVH {
+  static_assert(Width == 4 || Width == 8, "WideBVH supports 4 or 8 children per node");
+
+  public:
+  /** Child bounds as SoA lanes; an unused slot has empty bounds, which never hit or overlap. */
+  struct Node {
+   float lo[3][Width];
+   float hi[3][Width];
+   uint32_t child[Width]; ///< Inner slot: node index; leaf slot: first triangle slot
+   uint32_t count[Width]; ///< Triangles of a leaf slot, 0 for an inner or unused one
+  };
+
+  WideBVH() {}
+
+  /**
+   * @brief Collapses binary: each wide node keeps opening its inner child of largest surface
+   * area until it has Width children or only leaves.
+   */
+  void
+   build(const BVH& binary) {
+   m_nodes.clear();
+   m_triangles = binary.triangles();
+   if (binary.empty()) return;
+   const std::vector<BVHNode>& nodes = binary.nodes();
+   if (nodes[0].count) {
+    Node root = emptyNode();
+    setSlot(root, 0, nodes[0].bounds, nodes[0].first, nodes[0].count);
+    m_nodes.push_back(root);
+    return;
+   }
+   collapse(nodes, 0);
+  }
+
+  /**
+   * @brief Recomputes every bound after the mesh vertices moved; vertices must be indexed
+   * as at BVH::build().
+   */
+  void
+   refit(const CVector3* vertices) {
+   m_triangles.refit(vertices);
+   for (size_t i = m_nodes.size(); i-- > 0;) {
+    Node& node = m_nodes[i];
+    for (size_t s = 0; s < Width; ++s) {
+     if (node.count[s]) setBounds(node, s, m_triangles.bounds(node.child[s], node.count[s]));
+     else if (node.child[s] != UNUSED) setBounds(node, s, nodeBounds(m_nodes[node.child[s]]));
+    }
+   }
+  }
+
+  /** @brief Nearest hit as BVH::closestHit(). */
+  bool
+   closestHit(const Ray& ray, float tMax, RayHit& hit) const {
+   using detail::BatchLanes;
+   if (m_nodes.empty()) return false;
+   const detail::RayBoxLanes lanes(ray);
+   detail::BVHStackEntry stack[detail::BVH_STACK_DEPTH * Width + 1];
+   size_t top = 0;
+   stack[top++] = { 0, 0.f };
+   bool found = false;
+   while (top > 0) {
+    const detail::BVHStackEntry entry = stack[--top];
+    if (entry.t > tMax) continue;
+    const Node& node = m_nodes[entry.node];
+    float t[Width];
+    unsigned hits = test(lanes, node, tMax, t);
+    // Leaves first (they may shrink tMax), then inner children farthest first.
+    detail::BVHStackEntry inner[Width];
+    size_t innerCount = 0;
+    for (size_t s = 0; hits != 0; ++s, hits >>= 1) {
+     if (!(hits & 1)) continue;
+     if (node.count[s]) found |= m_triangles.closest(node.child[s], node.count[s], ray, tMax, hit);
+     else inner[innerCount++] = { node.child[s], t[s] };
+    }
+    for (size_t k = 1; k < innerCount; ++k)
+     for (size_t j = k; j > 0 && inner[j - 1].t < inner[j].t; --j) std::swap(inner[j - 1], inner[j]);
+    for (size_t k = 0; k < innerCount; ++k)
+     if (inner[k].t <= tMax) stack[top++] = inner[k];
+   }
+   return found;
+  }
+
+  /** @brief Occlusion test as BVH::anyHit(). */
+  bool
+   anyHit(const Ray& ray, float tMax) const {
+   if (m_nodes.empty()) return false;
+   const detail::RayBoxLanes lanes(ray);
+   uint32_t stack[detail::BVH_STACK_DEPTH * Width + 1];
+   size_t top = 0;
+   stack[top++] = 0;
+   while (top > 0) {
+    const Node& node = m_nodes[stack[--top]];
+    float t[Width];
+    unsigned hits = test(lanes, node, tMax, t);
+    for (size_t s = 0; hits != 0; ++s, hits >>= 1) {
+     if (!(hits & 1)) continue;
+     if (!node.count[s]) stack[top++] = node.child[s];
+     else if (m_triangles.any(node.child[s], node.count[s], ray, tMax)) return true;
+    }
+   }
+   return false;
+  }
+
+  /** @brief Candidate triangles as BVH::overlap(). */
+  size_t
+   overlap(const AABB& box, std::vector<uint32_t>& triangles) const {
+   using detail::BatchLanes;
+   if (m_nodes.empty()) return 0;
+   const BatchLanes qlo[3] = { BatchLanes::set1(box.min.x), BatchLanes::set1(box.min.y), BatchLanes::set1(box.min.z) };
+   const BatchLanes qhi[3] = { BatchLanes::set1(box.max.x), BatchLanes::set1(box.max.y), BatchLanes::set1(box.max.z) };
+   size_t found = 0;
+   uint32_t stack[detail::BVH_STACK_DEPTH * Width + 1];
+   size_t top = 0;
+   stack[top++] = 0;
+   while (top > 0) {
+    const Node& node = m_nodes[stack[--top]];
+    unsigned hits = 0;
+    for (size_t i = 0; i < Width; i += detail::BATCH_WIDTH) {
+     const size_t count = Width - i < detail::BATCH_WIDTH ? Width - i : detail::BATCH_WIDTH;
+     BatchLanes inside = detail::firstLanes(count);
+     for (int a = 0; a < 3; ++a) {
+      inside = inside & (detail::loadLanes(node.lo[a], i, count) <= qhi[a]) & (qlo[a] <= detail::loadLanes(node.hi[a], i, count));
+     }
+     hits |= static_cast<unsigned>(EU::SIMD::movemask(inside)) << i;
+    }
+    for (size_t s = 0; hits != 0; ++s, hits >>= 1) {
+     if (!(hits & 1)) continue;
+     if (node.count[s]) found += m_triangles.overlap(node.child[s], node.count[s], box, triangles);
+     else stack[top++] = node.child[s];
+    }
+   }
+   return found;
+  }
+
+  /** @brief True when nothing has been built. */
+  bool
+   empty() const {
+   return m_nodes.empty();
+  }
+
+  /** @brief The nodes, root first in depth-first order. */
+  const std::vector<Node>&
+   nodes() const {
+   return m_nodes;
+  }
+
+  private:
+  static constexpr uint32_t UNUSED = 0xffffffffu;
+
+  static Node
+   emptyNode() {
+   Node node;
+   for (size_t s = 0; s < Width; ++s) {
+    setBounds(node, s, AABB());
+    node.child[s] = UNUSED;
+    node.count[s] = 0;
+   }
+   return node;
+  }
+
+  static void
+   setBounds(Node& node, size_t s, const AABB& box) {
+   node.lo[0][s] = box.min.x;
+   node.lo[1][s] = box.min.y;
+   node.lo[2][s] = box.min.z;
+   node.hi[0][s] = box.max.x;
+   node.hi[1][s] = box.max.y;
+   node.hi[2][s] = box.max.z;
+  }
+
+  static void
+   setSlot(Node& node, size_t s, const AABB& box, uint32_t child, uint32_t count) {
+   setBounds(node, s, box);
+   node.child[s] = child;
+   node.count[s] = count;
+  }
+
+  static AABB
+   nodeBounds(const Node& node) {
+   AABB box;
+   for (size_t s = 0; s < Width; ++s) {
+    box.merge(AABB(CVector3(node.lo[0][s], node.lo[1][s], node.lo[2][s]), CVector3(node.hi[0][s], node.hi[1][s], node.hi[2][s])));
+   }
+   return box;
+  }
+
+  /** Appends the wide node of the inner binary node b and everything below it; returns its index. */
+  uint32_t
+   collapse(const std::vector<BVHNode>& nodes, uint32_t b) {
+   uint32_t children[Width] = { b + 1, nodes[b].first };
+   size_t count = 2;
+   while (count < Width) {
+    size_t open = Width;
+    float area = -1.f;
+    for (size_t k = 0; k < count; ++k) {
+     const BVHNode& c = nodes[children[k]];
+     if (c.count == 0 && c.bounds.surfaceArea() > area) {
+      area = c.bounds.surfaceArea();
+      open = k;
+     }
+    }
+    if (open == Width) break;
+    const uint32_t opened = children[open];
+    children[open] = opened + 1;
+    children[count++] = nodes[opened].first;
+   }
+   const uint32_t index = static_cast<uint32_t>(m_nodes.size());
+   m_nodes.push_back(emptyNode());
+   for (size_t k = 0; k < count; ++k) {
+    const BVHNode& c = nodes[children[k]];
+    const uint32_t child = c.count ? c.first : collapse(nodes, children[k]);
+    setSlot(m_nodes[index], k, c.bounds, child, c.count);
+   }
+   return index;
+  }
+
+  /** Slab test of every slot of node; bit s of the result is set when slot s is hit, t[s] its entry. */
+  static unsigned
+   test(const detail::RayBoxLanes& lanes, const Node& node, float tMax, float (&t)[Width]) {
+   using detail::BatchLanes;
+   const BatchLanes limit = BatchLanes::set1(tMax);
+   unsigned hits = 0;
+   for (size_t i = 0; i < Width; i += detail::BATCH_WIDTH) {
+    const size_t count = Width - i < detail::BATCH_WIDTH ? Width - i : detail::BATCH_WIDTH;
+    BatchLanes tNear;
+    const BatchLanes hit = lanes.test({ node.lo[0], node.lo[1], node.lo[2] }, { node.hi[0], node.hi[1], node.hi[2] },
+                                      i, count, limit, tNear) & detail::firstLanes(count);
+    float lane[detail::BATCH_WIDTH];
+    tNear.store(lane);
+    for (size_t k = 0; k < count; ++k) t[i + k] = lane[k];
+    hits |= static_cast<unsigned>(EU::SIMD::movemask(hit)) << i;
+   }
+   return hits;
+  }
+
+  std::vector<Node> m_nodes;
+  detail::BVHTriangles m_triangles;
+ };
+}
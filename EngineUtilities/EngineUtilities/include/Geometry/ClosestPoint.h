@@ -0,0 +1,351 @@
+/**
+ * @file ClosestPoint.h
+ * @brief Closest points on segments and triangles for CVector2 and CVector3, and batch
+ * queries of one point or segment against SoA arrays of them that return the nearest.
+ *
+ * The triangle test is Ericson's (Real-Time Collision Detection 5.1.5): six dot products
+ * classify the point into a vertex, edge or face Voronoi region of the triangle. It uses
+ * dot products only, so one template serves 2D and 3D. Point-segment and segment-segment
+ * reuse the Overlap.h routines, also for 2D.
+ *
+ * The batch versions compute a register (4 or 8) of primitives per step without branching:
+ * every region's answer is computed and the right one selected per lane, and degenerate
+ * primitives divide by 1 in the lanes that discard the quotient. A register is only
+ * scanned lane by lane when one of its distances beats the best so far, so the running
+ * minimum costs one compare per register. Ties go to the lowest index. They report the
+ * index and squared distance of the nearest primitive; the scalar routine then gives the
+ * point on it.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <Core/Constants.h>
+#include <Core/SIMD.h>
+#include <Geometry/Overlap.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /** @brief Squared distance from point to the 2D segment [a, b]; t receives its parameter. */
+ constexpr float
+  distanceSquaredPointSegment(const CVector2& point, const CVector2& a, const CVector2& b, float& t) {
+  const CVector2 d = b - a, r = point - a;
+  const float lenSq = d.dot(d);
+  t = lenSq > EU::Constants::EPSILON ? EngineMath::clamp(r.dot(d) / lenSq, 0.f, 1.f) : 0.f;
+  return (r - d * t).lengthSquared();
+ }
+
+ namespace detail {
+  /**
+   * Weights (v, w) of the point a + v (b - a) + w (c - a) of triangle abc closest to p
+   * (Ericson 5.1.5). A degenerate triangle falls back to its nearest edge.
+   */
+  template<typename Vector>
+  inline void
+   triangleWeights(const Vector& p, const Vector& a, const Vector& b, const Vector& c, float& v, float& w) {
+   const Vector ab = b - a, ac = c - a, ap = p - a;
+   const float d1 = ab.dot(ap), d2 = ac.dot(ap);
+   v = w = 0.f;
+   if (d1 <= 0.f && d2 <= 0.f) return;
+   const Vector bp = p - b;
+   const float d3 = ab.dot(bp), d4 = ac.dot(bp);
+   if (d3 >= 0.f && d4 <= d3) {
+    v = 1.f;
+    return;
+   }
+   const float vc = d1 * d4 - d3 * d2;
+   if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) {
+    v = d1 / (d1 - d3);
+    return;
+   }
+   const Vector cp = p - c;
+   const float d5 = ab.dot(cp), d6 = ac.dot(cp);
+   if (d6 >= 0.f && d5 <= d6) {
+    w = 1.f;
+    return;
+   }
+   const float vb = d5 * d2 - d1 * d6;
+   if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) {
+    w = d2 / (d2 - d6);
+    return;
+   }
+   const float va = d3 * d6 - d5 * d4;
+   if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f) {
+    w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+    v = 1.f - w;
+    return;
+   }
+   const float sum = va + vb + vc;
+   if (sum > 0.f) {
+    v = vb / sum;
+    w = vc / sum;
+    return;
+   }
+   // Collinear corners: the nearest of the three edges.
+   float t = 0.f;
+   float best = distanceSquaredPointSegment(p, a, b, t);
+   v = t;
+   float d = distanceSquaredPointSegment(p, a, c, t);
+   if (d < best) {
+    best = d;
+    v = 0.f;
+    w = t;
+   }
+   if (distanceSquaredPointSegment(p, b, c, t) < best) {
+    v = 1.f - t;
+    w = t;
+   }
+  }
+
+  /**
+   * Lane-wise triangleWeights(): every region's weights, selected from the lowest priority
+   * up so the first region Ericson's order would accept wins. Degenerate (collinear) lanes
+   * fall back to the edge regions only.
+   */
+  inline void
+   triangleWeightsLanes(const BatchLanes (&p)[3], const BatchLanes (&a)[3], const BatchLanes (&b)[3],
+                        const BatchLanes (&c)[3], BatchLanes& v, BatchLanes& w) {
+   const BatchLanes zero = BatchLanes::zero(), one = BatchLanes::set1(1.f);
+   BatchLanes ab[3], ac[3], ap[3], bp[3], cp[3];
+   for (int k = 0; k < 3; ++k) {
+    ab[k] = b[k] - a[k];
+    ac[k] = c[k] - a[k];
+    ap[k] = p[k] - a[k];
+    bp[k] = p[k] - b[k];
+    cp[k] = p[k] - c[k];
+   }
+   auto dot = [](const BatchLanes (&x)[3], const BatchLanes (&y)[3]) { return x[0] * y[0] + x[1] * y[1] + x[2] * y[2]; };
+   const BatchLanes d1 = dot(ab, ap), d2 = dot(ac, ap), d3 = dot(ab, bp), d4 = dot(ac, bp);
+   const BatchLanes d5 = dot(ab, cp), d6 = dot(ac, cp);
+   const BatchLanes va = d3 * d6 - d5 * d4, vb = d5 * d2 - d1 * d6, vc = d1 * d4 - d3 * d2;
+   auto safe = [&](BatchLanes x) { return EU::SIMD::select(x != zero, x, one); };
+
+   // Face region.
+   const BatchLanes sum = safe(va + vb + vc);
+   v = vb / sum;
+   w = vc / sum;
+   // Edge BC.
+   const BatchLanes e4 = d4 - d3, e5 = d5 - d6;
+   const BatchLanes onBC = (va <= zero) & (e4 >= zero) & (e5 >= zero);
+   const BatchLanes wBC = e4 / safe(e4 + e5);
+   v = EU::SIMD::select(onBC, one - wBC, v);
+   w = EU::SIMD::select(onBC, wBC, w);
+   // Edge AC.
+   const BatchLanes onAC = (vb <= zero) & (d2 >= zero) & (d6 <= zero);
+   v = EU::SIMD::select(onAC, zero, v);
+   w = EU::SIMD::select(onAC, d2 / safe(d2 - d6), w);
+   // Vertex C.
+   const BatchLanes atC = (d6 >= zero) & (d5 <= d6);
+   v = EU::SIMD::select(atC, zero, v);
+   w = EU::SIMD::select(atC, one, w);
+   // Edge AB.
+   const BatchLanes onAB = (vc <= zero) & (d1 >= zero) & (d3 <= zero);
+   v = EU::SIMD::select(onAB, d1 / safe(d1 - d3), v);
+   w = EU::SIMD::select(onAB, zero, w);
+   // Vertex B.
+   const BatchLanes atB = (d3 >= zero) & (d4 <= d3);
+   v = EU::SIMD::select(atB, one, v);
+   w = EU::SIMD::select(atB, zero, w);
+   // Vertex A.
+   const BatchLanes atA = (d1 <= zero) & (d2 <= zero);
+   v = EU::SIMD::select(atA, zero, v);
+   w = EU::SIMD::select(atA, zero, w);
+  }
+
+  /**
+   * Folds a register of squared distances into the running minimum (best, index): the lanes
+   * are only scanned when one of them is below best.
+   */
+  inline void
+   keepNearest(BatchLanes distSq, size_t i, size_t count, float& best, uint32_t& index) {
+   int bits = EU::SIMD::movemask((distSq < BatchLanes::set1(best)) & firstLanes(count));
+   if (bits == 0) return;
+   float d[BATCH_WIDTH];
+   distSq.store(d);
+   for (uint32_t j = 0; bits != 0; ++j, bits >>= 1) {
+    if ((bits & 1) && d[j] < best) {
+     best = d[j];
+     index = static_cast<uint32_t>(i) + j;
+    }
+   }
+  }
+ }
+
+ /** @brief Point of the segment [a, b] closest to point. */
+ inline CVector3
+  closestPointSegment(const CVector3& point, const CVector3& a, const CVector3& b) {
+  float t = 0.f;
+  distanceSquaredPointSegment(point, a, b, t);
+  return a + (b - a) * t;
+ }
+
+ inline CVector2
+  closestPointSegment(const CVector2& point, const CVector2& a, const CVector2& b) {
+  float t = 0.f;
+  distanceSquaredPointSegment(point, a, b, t);
+  return a + (b - a) * t;
+ }
+
+ /** @brief Point of the triangle abc (its surface, in 3D) closest to point. */
+ inline CVector3
+  closestPointTriangle(const CVector3& point, const CVector3& a, const CVector3& b, const CVector3& c) {
+  float v = 0.f, w = 0.f;
+  detail::triangleWeights(point, a, b, c, v, w);
+  return a + (b - a) * v + (c - a) * w;
+ }
+
+ /** @brief Point of the filled triangle abc closest to point: point itself when inside. */
+ inline CVector2
+  closestPointTriangle(const CVector2& point, const CVector2& a, const CVector2& b, const CVector2& c) {
+  float v = 0.f, w = 0.f;
+  detail::triangleWeights(point, a, b, c, v, w);
+  return a + (b - a) * v + (c - a) * w;
+ }
+
+ inline float
+  distanceSquaredPointTriangle(const CVector3& point, const CVector3& a, const CVector3& b, const CVector3& c) {
+  return (closestPointTriangle(point, a, b, c) - point).lengthSquared();
+ }
+
+ inline float
+  distanceSquaredPointTriangle(const CVector2& point, const CVector2& a, const CVector2& b, const CVector2& c) {
+  return (closestPointTriangle(point, a, b, c) - point).lengthSquared();
+ }
+
+ /** @brief 2D closestPointsSegmentSegment(); 0 when the segments cross. */
+ constexpr float
+  closestPointsSegmentSegment(const CVector2& p1, const CVector2& q1, const CVector2& p2, const CVector2& q2, float& s,
+                              float& t) {
+  return detail::segmentSegment(p1, q1, p2, q2, s, t);
+ }
+
+ /**
+  * @brief Nearest of the segments [a[i], b[i]] to point.
+  * @param index Receives its index; left unchanged when n is 0, as is distanceSq.
+  * @param distanceSq Receives its squared distance.
+  * @return False when n is 0.
+  */
+ inline bool
+  nearestSegment(const CVector3& point, EngineMath::batch::ConstSoA3 a, EngineMath::batch::ConstSoA3 b, size_t n,
+                 uint32_t& index, float& distanceSq) {
+  using detail::BatchLanes;
+  if (n == 0) return false;
+  const BatchLanes zero = BatchLanes::zero(), one = BatchLanes::set1(1.f), eps = BatchLanes::set1(EU::Constants::EPSILON);
+  BatchLanes p[3];
+  detail::splatLanes3(point, p);
+  float best = std::numeric_limits<float>::infinity();
+  uint32_t bestIndex = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes la[3], lb[3], d[3], r[3];
+   detail::loadLanes3(a, i, count, la);
+   detail::loadLanes3(b, i, count, lb);
+   for (int k = 0; k < 3; ++k) {
+    d[k] = lb[k] - la[k];
+    r[k] = p[k] - la[k];
+   }
+   const BatchLanes lenSq = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+   const BatchLanes line = lenSq > eps;
+   const BatchLanes t = EU::SIMD::select(line, detail::clampUnitLanes((r[0] * d[0] + r[1] * d[1] + r[2] * d[2]) /
+                                                                      EU::SIMD::select(line, lenSq, one)), zero);
+   BatchLanes distSq = zero;
+   for (int k = 0; k < 3; ++k) {
+    const BatchLanes g = r[k] - d[k] * t;
+    distSq = distSq + g * g;
+   }
+   detail::keepNearest(distSq, i, count, best, bestIndex);
+  }
+  index = bestIndex;
+  distanceSq = best;
+  return true;
+ }
+
+ /** @brief nearestSegment() for 2D segments. */
+ inline bool
+  nearestSegment(const CVector2& point, EngineMath::batch::ConstSoA2 a, EngineMath::batch::ConstSoA2 b, size_t n,
+                 uint32_t& index, float& distanceSq) {
+  using detail::BatchLanes;
+  if (n == 0) return false;
+  const BatchLanes zero = BatchLanes::zero(), one = BatchLanes::set1(1.f), eps = BatchLanes::set1(EU::Constants::EPSILON);
+  const BatchLanes px = BatchLanes::set1(point.x), py = BatchLanes::set1(point.y);
+  float best = std::numeric_limits<float>::infinity();
+  uint32_t bestIndex = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   const BatchLanes ax = detail::loadLanes(a.x, i, count), ay = detail::loadLanes(a.y, i, count);
+   const BatchLanes dx = detail::loadLanes(b.x, i, count) - ax, dy = detail::loadLanes(b.y, i, count) - ay;
+   const BatchLanes rx = px - ax, ry = py - ay;
+   const BatchLanes lenSq = dx * dx + dy * dy;
+   const BatchLanes line = lenSq > eps;
+   const BatchLanes t = EU::SIMD::select(line, detail::clampUnitLanes((rx * dx + ry * dy) / EU::SIMD::select(line, lenSq, one)), zero);
+   const BatchLanes gx = rx - dx * t, gy = ry - dy * t;
+   detail::keepNearest(gx * gx + gy * gy, i, count, best, bestIndex);
+  }
+  index = bestIndex;
+  distanceSq = best;
+  return true;
+ }
+
+ /**
+  * @brief Nearest of the triangles (a[i], b[i], c[i]) to point; see nearestSegment().
+  */
+ inline bool
+  nearestTriangle(const CVector3& point, EngineMath::batch::ConstSoA3 a, EngineMath::batch::ConstSoA3 b,
+                  EngineMath::batch::ConstSoA3 c, size_t n, uint32_t& index, float& distanceSq) {
+  using detail::BatchLanes;
+  if (n == 0) return false;
+  BatchLanes p[3];
+  detail::splatLanes3(point, p);
+  float best = std::numeric_limits<float>::infinity();
+  uint32_t bestIndex = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes la[3], lb[3], lc[3], v, w;
+   detail::loadLanes3(a, i, count, la);
+   detail::loadLanes3(b, i, count, lb);
+   detail::loadLanes3(c, i, count, lc);
+   detail::triangleWeightsLanes(p, la, lb, lc, v, w);
+   BatchLanes distSq = BatchLanes::zero();
+   for (int k = 0; k < 3; ++k) {
+    const BatchLanes g = la[k] + (lb[k] - la[k]) * v + (lc[k] - la[k]) * w - p[k];
+    distSq = distSq + g * g;
+   }
+   detail::keepNearest(distSq, i, count, best, bestIndex);
+  }
+  index = bestIndex;
+  distanceSq = best;
+  return true;
+ }
+
+ /**
+  * @brief Nearest of the segments [a[i], b[i]] to the segment [p, q]; see nearestSegment().
+  * closestPointsSegmentSegment() on the winner gives the two closest points.
+  */
+ inline bool
+  nearestSegmentToSegment(const CVector3& p, const CVector3& q, EngineMath::batch::ConstSoA3 a,
+                          EngineMath::batch::ConstSoA3 b, size_t n, uint32_t& index, float& distanceSq) {
+  using detail::BatchLanes;
+  if (n == 0) return false;
+  BatchLanes lp[3], lq[3];
+  detail::splatLanes3(p, lp);
+  detail::splatLanes3(q, lq);
+  float best = std::numeric_limits<float>::infinity();
+  uint32_t bestIndex = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes la[3], lb[3];
+   detail::loadLanes3(a, i, count, la);
+   detail::loadLanes3(b, i, count, lb);
+   detail::keepNearest(detail::segmentDistanceSquaredLanes(lp, lq, la, lb), i, count, best, bestIndex);
+  }
+  index = bestIndex;
+  distanceSq = best;
+  return true;
+ }
+}
@@ -0,0 +1,689 @@
+/**
+ * @file ConvexHull.h
+ * @brief Quickhull convex hulls of CVector2 and CVector3 point sets, optionally stopped at a
+ * maximum vertex count.
+ *
+ * Both versions start from the extreme points (a segment in 2D, a tetrahedron in 3D) and
+ * hand every other point to the one edge or face it lies in front of: its outside set. Each
+ * step takes the point farthest in front of any edge or face, removes what it can see and
+ * closes the hole with new edges or faces to it, handing the points of the removed ones to
+ * the new ones and dropping those now inside. Points are mostly discarded in the first few
+ * steps, so a cloud costs close to O(n log n).
+ *
+ * Points always come off in order of distance, so stopping at maxVertices leaves the hull
+ * of the most extreme points, the usual way to cap a collision hull. That hull is inside the
+ * exact one, by at most the distance of the first point left out.
+ *
+ * A point counts as in front only beyond a tolerance of 3 EPSILON times the sum of the largest
+ * absolute coordinates, so points within rounding of an edge or face (collinear or coplanar
+ * ones) never become vertices. In 3D the tolerance is a distance from the hull, not from a
+ * plane: the sliver faces a thin slab starts from can have a point within it of every plane
+ * and still far beyond their shared edge, so a point near a plane is dropped only when it is
+ * near the triangle as well, and otherwise ranks by its distance from the triangle. Every
+ * input point ends up within the tolerance of the hull. Which faces a new point sees, and the
+ * distance from a triangle, come from the corners in double, not from the rounded normals;
+ * that is not exact, but its error is some 1e-16 of the squared scale, far inside the
+ * tolerance, so it does not fold the hull inward. A point left behind every new face by less
+ * than the tolerance is checked against the rest of the hull before it is dropped. The 3D
+ * hull is a closed triangle mesh, short of the triangles of exactly collinear corners that
+ * points on a grid can leave, which are dropped; coplanar faces are not merged into polygons.
+ *
+ * The outside sets are links through one index per point and the 2D edge ring and 3D
+ * half-edge mesh come from a FrameArena, as does the scratch of every step. The overloads
+ * without an arena make one for the call.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+#include <Core/Constants.h>
+#include <Core/FrameArena.h>
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ namespace detail {
+  constexpr uint32_t HULL_NONE = 0xffffffffu;
+
+  /** Outside-set entry of the hull work queue, farthest first and oldest first among equals. */
+  template<typename T>
+  struct HullCandidate {
+   float distance;
+   uint32_t serial;
+   T* item;
+
+   bool
+    operator<(const HullCandidate& otro) const {
+    return distance < otro.distance || (distance == otro.distance && serial > otro.serial);
+   }
+  };
+
+  template<typename T>
+  using HullQueue = std::priority_queue<HullCandidate<T>, FrameVector<HullCandidate<T>>>;
+
+  template<typename T>
+  inline HullQueue<T>
+   makeHullQueue(FrameArena& arena) {
+   return HullQueue<T>(std::less<HullCandidate<T>>(),
+                       FrameVector<HullCandidate<T>>(ArenaAllocator<HullCandidate<T>>(arena)));
+  }
+
+  /** Edge tail -> head of a counter-clockwise 2D hull ring. */
+  struct HullEdge2 {
+   uint32_t tail;
+   uint32_t head;
+   HullEdge2* prev;
+   HullEdge2* next;
+   CVector2 normal; ///< Unit, pointing out
+   float offset;    ///< normal . tail
+   uint32_t outside;
+   uint32_t farthest;
+   float distance;
+   bool dead;
+  };
+
+  struct HullFace;
+
+  /** Half-edge of a triangle, running from the head of the previous edge of its face to head. */
+  struct HullHalfEdge {
+   uint32_t head;
+   HullHalfEdge* twin;
+   HullFace* face;
+  };
+
+  /** Triangle of the 3D hull, counter-clockwise seen from outside. */
+  struct HullFace {
+   HullHalfEdge edge[3];
+   CVector3 normal; ///< Unit, pointing out
+   float offset;    ///< normal . first corner
+   uint32_t outside;
+   uint32_t farthest;
+   float distance;
+   uint32_t visit; ///< Last step that found it visible
+   bool dead;
+   HullFace* created; ///< Face created before this one, to walk them all when done
+  };
+
+  inline uint32_t
+   hullTail(const HullHalfEdge* e) {
+   const HullFace* f = e->face;
+   return f->edge[(e - f->edge + 2) % 3].head;
+  }
+
+  /** Sum over the axes of the largest absolute coordinate, the scale of the hull tolerance. */
+  inline float
+   hullScale(const CVector2* points, size_t n) {
+   float mx = 0.f, my = 0.f;
+   for (size_t i = 0; i < n; ++i) {
+    mx = EngineMath::fabs(points[i].x) > mx ? EngineMath::fabs(points[i].x) : mx;
+    my = EngineMath::fabs(points[i].y) > my ? EngineMath::fabs(points[i].y) : my;
+   }
+   return mx + my;
+  }
+
+  inline float
+   hullScale(const CVector3* points, size_t n) {
+   float m[3] = {};
+   for (size_t i = 0; i < n; ++i)
+    for (int k = 0; k < 3; ++k) m[k] = EngineMath::fabs(points[i][k]) > m[k] ? EngineMath::fabs(points[i][k]) : m[k];
+   return m[0] + m[1] + m[2];
+  }
+
+  class
+   Quickhull2 {
+   public:
+   Quickhull2(const CVector2* points, size_t n, FrameArena& arena)
+    : m_points(points), m_n(n), m_arena(arena), m_next(arena.allocateArray<uint32_t>(n)) {
+    m_tolerance = 3.f * EU::Constants::EPSILON * hullScale(points, n);
+   }
+
+   bool
+    run(std::vector<CVector2>& hull, size_t maxVertices) {
+    hull.clear();
+    if (m_n == 0) return false;
+    uint32_t a = 0, b = 0;
+    for (uint32_t i = 1; i < m_n; ++i) {
+     const CVector2& p = m_points[i];
+     if (p.x < m_points[a].x || (p.x == m_points[a].x && p.y < m_points[a].y)) a = i;
+     if (p.x > m_points[b].x || (p.x == m_points[b].x && p.y > m_points[b].y)) b = i;
+    }
+    hull.push_back(m_points[a]);
+    if ((m_points[b] - m_points[a]).length<EU::Precision::Exact>() <= m_tolerance) return false;
+    HullEdge2* lower = edge(a, b);
+    HullEdge2* upper = edge(b, a);
+    lower->prev = lower->next = upper;
+    upper->prev = upper->next = lower;
+    for (uint32_t i = 0; i < m_n; ++i) {
+     if (i != a && i != b && !assign(lower, i)) assign(upper, i);
+    }
+    HullQueue<HullEdge2> queue = makeHullQueue<HullEdge2>(m_arena);
+    push(queue, lower);
+    push(queue, upper);
+    FrameVector<uint32_t> orphans{ ArenaAllocator<uint32_t>(m_arena) };
+    size_t vertices = 2;
+    HullEdge2* start = lower;
+    const size_t limit = maxVertices == 0 ? m_n : (maxVertices < 3 ? 3 : maxVertices);
+    while (!queue.empty() && vertices < limit) {
+     HullEdge2* seen = queue.top().item;
+     queue.pop();
+     if (seen->dead) continue;
+     const uint32_t eye = seen->farthest;
+     const CVector2& p = m_points[eye];
+     // The eye sees a run of edges around the one it was outside of.
+     HullEdge2* first = seen;
+     HullEdge2* last = seen;
+     size_t removed = 1;
+     while (first->prev != last && distance(first->prev, p) >= 0.f) {
+      first = first->prev;
+      ++removed;
+     }
+     while (last->next != first && distance(last->next, p) >= 0.f) {
+      last = last->next;
+      ++removed;
+     }
+     orphans.clear();
+     for (HullEdge2* e = first;; e = e->next) {
+      for (uint32_t i = e->outside; i != HULL_NONE; i = m_next[i]) orphans.push_back(i);
+      e->dead = true;
+      if (e == last) break;
+     }
+     HullEdge2* left = edge(first->tail, eye);
+     HullEdge2* right = edge(eye, last->head);
+     left->prev = first->prev;
+     first->prev->next = left;
+     left->next = right;
+     right->prev = left;
+     right->next = last->next;
+     last->next->prev = right;
+     for (uint32_t i : orphans) {
+      if (i != eye && !assign(left, i)) assign(right, i);
+     }
+     push(queue, left);
+     push(queue, right);
+     vertices = vertices + 2 - removed;
+     start = left;
+    }
+    hull.clear();
+    HullEdge2* e = start;
+    do {
+     hull.push_back(m_points[e->tail]);
+     e = e->next;
+    } while (e != start);
+    std::rotate(hull.begin(), std::min_element(hull.begin(), hull.end(), [](const CVector2& l, const CVector2& r) {
+                 return l.x < r.x || (l.x == r.x && l.y < r.y);
+                }),
+                hull.end());
+    return hull.size() >= 3;
+   }
+
+   private:
+   HullEdge2*
+    edge(uint32_t tail, uint32_t head) {
+    HullEdge2* e = m_arena.allocateArray<HullEdge2>(1);
+    const CVector2 d = m_points[head] - m_points[tail];
+    e->tail = tail;
+    e->head = head;
+    e->prev = e->next = nullptr;
+    e->normal = CVector2(d.y, -d.x).normalized<EU::Precision::Exact>();
+    e->offset = e->normal.dot(m_points[tail]);
+    e->outside = HULL_NONE;
+    e->farthest = HULL_NONE;
+    e->distance = 0.f;
+    e->dead = false;
+    return e;
+   }
+
+   float
+    distance(const HullEdge2* e, const CVector2& p) const {
+    return e->normal.dot(p) - e->offset;
+   }
+
+   bool
+    assign(HullEdge2* e, uint32_t i) {
+    const float d = distance(e, m_points[i]);
+    if (!(d > m_tolerance)) return false;
+    m_next[i] = e->outside;
+    e->outside = i;
+    if (e->farthest == HULL_NONE || d > e->distance) {
+     e->farthest = i;
+     e->distance = d;
+    }
+    return true;
+   }
+
+   void
+    push(HullQueue<HullEdge2>& queue, HullEdge2* e) {
+    if (e->outside != HULL_NONE) queue.push(HullCandidate<HullEdge2>{ e->distance, m_serial++, e });
+   }
+
+   const CVector2* m_points;
+   size_t m_n;
+   FrameArena& m_arena;
+   uint32_t* m_next; ///< Outside-set links
+   float m_tolerance;
+   uint32_t m_serial = 0;
+  };
+
+  class
+   Quickhull3 {
+   public:
+   Quickhull3(const CVector3* points, size_t n, FrameArena& arena)
+    : m_source(points), m_n(n), m_arena(arena), m_next(arena.allocateArray<uint32_t>(n)),
+      m_stack{ ArenaAllocator<HorizonFrame>(arena) } {
+    // Centered on the bounds, far-off clouds keep the digits their thin faces need.
+    CVector3 lo = n ? points[0] : CVector3(), hi = lo;
+    for (size_t i = 1; i < n; ++i) {
+     for (int k = 0; k < 3; ++k) {
+      lo[k] = points[i][k] < lo[k] ? points[i][k] : lo[k];
+      hi[k] = points[i][k] > hi[k] ? points[i][k] : hi[k];
+     }
+    }
+    const CVector3 center = (lo + hi) * 0.5f;
+    CVector3* local = arena.allocateArray<CVector3>(n);
+    for (size_t i = 0; i < n; ++i) local[i] = points[i] - center;
+    m_points = local;
+    m_tolerance = 3.f * EU::Constants::EPSILON * hullScale(local, n);
+   }
+
+   bool
+    run(std::vector<CVector3>& vertices, std::vector<uint32_t>& triangles, size_t maxVertices) {
+    vertices.clear();
+    triangles.clear();
+    uint32_t simplex[4];
+    if (!initialSimplex(simplex)) return false;
+    HullQueue<HullFace> queue = makeHullQueue<HullFace>(m_arena);
+    for (HullFace* f = m_last; f != nullptr; f = f->created) push(queue, f);
+    FrameVector<HullFace*> visible{ ArenaAllocator<HullFace*>(m_arena) };
+    FrameVector<HullHalfEdge*> horizon{ ArenaAllocator<HullHalfEdge*>(m_arena) };
+    FrameVector<HullFace*> added{ ArenaAllocator<HullFace*>(m_arena) };
+    FrameVector<uint32_t> orphans{ ArenaAllocator<uint32_t>(m_arena) };
+    // A closed triangle mesh has F = 2 V - 4.
+    size_t faces = 4;
+    const size_t limit = maxVertices == 0 ? m_n : (maxVertices < 4 ? 4 : maxVertices);
+    for (uint32_t step = 1; !queue.empty() && (faces + 4) / 2 < limit; ++step) {
+     HullFace* seen = queue.top().item;
+     queue.pop();
+     if (seen->dead) continue;
+     const uint32_t eye = seen->farthest;
+     findHorizon(seen, m_points[eye], step, visible, horizon);
+     orphans.clear();
+     for (HullFace* f : visible) {
+      for (uint32_t i = f->outside; i != HULL_NONE; i = m_next[i]) orphans.push_back(i);
+      f->dead = true;
+     }
+     // The horizon runs counter-clockwise around the eye, so the fan closing it links up in order.
+     added.clear();
+     for (HullHalfEdge* e : horizon) {
+      HullFace* f = face(hullTail(e), e->head, eye);
+      f->edge[0].twin = e->twin;
+      e->twin->twin = &f->edge[0];
+      added.push_back(f);
+     }
+     for (size_t k = 0; k < added.size(); ++k) {
+      HullFace* next = added[(k + 1) % added.size()];
+      added[k]->edge[1].twin = &next->edge[2];
+      next->edge[2].twin = &added[k]->edge[1];
+     }
+     for (uint32_t i : orphans) {
+      if (i == eye) continue;
+      Placement place{ nullptr, -m_tolerance, false };
+      for (size_t k = 0; k < added.size() && !consider(added[k], i, place); ++k) {}
+      // Behind every new face by more than the tolerance, the point is inside. Closer than that,
+      // rounding can leave it in front of a face of the hull the cone did not replace.
+      const bool behind = place.face == nullptr;
+      if (behind && place.distance > -m_tolerance) {
+       for (HullFace* f = added.front()->created; f != nullptr; f = f->created) {
+        if (!f->dead && consider(f, i, place)) break;
+       }
+      }
+      HullFace* to = assign(place, i);
+      if (behind && to != nullptr) push(queue, to);
+     }
+     for (HullFace* f : added) push(queue, f);
+     faces = faces + added.size() - visible.size();
+    }
+    uint32_t* remap = m_arena.allocateArray<uint32_t>(m_n);
+    for (size_t i = 0; i < m_n; ++i) remap[i] = HULL_NONE;
+    for (HullFace* f = m_last; f != nullptr; f = f->created) {
+     // Faces with collinear corners have no normal; the two on either side cover them.
+     if (f->dead || f->normal.lengthSquared() == 0.f) continue;
+     for (const HullHalfEdge& e : f->edge) {
+      const uint32_t corner = hullTail(&e);
+      if (remap[corner] == HULL_NONE) {
+       remap[corner] = static_cast<uint32_t>(vertices.size());
+       vertices.push_back(m_source[corner]);
+      }
+      triangles.push_back(remap[corner]);
+     }
+    }
+    return true;
+   }
+
+   private:
+   /** Tetrahedron of extreme points, its faces and the outside sets; false when the points are flat. */
+   bool
+    initialSimplex(uint32_t (&simplex)[4]) {
+    if (m_n < 4) return false;
+    uint32_t lo[3] = { 0, 0, 0 }, hi[3] = { 0, 0, 0 };
+    for (uint32_t i = 1; i < m_n; ++i) {
+     for (int k = 0; k < 3; ++k) {
+      if (m_points[i][k] < m_points[lo[k]][k]) lo[k] = i;
+      if (m_points[i][k] > m_points[hi[k]][k]) hi[k] = i;
+     }
+    }
+    int axis = 0;
+    for (int k = 1; k < 3; ++k) {
+     if (m_points[hi[k]][k] - m_points[lo[k]][k] > m_points[hi[axis]][axis] - m_points[lo[axis]][axis]) axis = k;
+    }
+    const uint32_t a = lo[axis], b = hi[axis];
+    if (!(m_points[b][axis] - m_points[a][axis] > m_tolerance)) return false;
+    const CVector3 pa = m_points[a];
+    const CVector3 ab = (m_points[b] - pa).normalized<EU::Precision::Exact>();
+    uint32_t c = a;
+    float best = m_tolerance * m_tolerance;
+    for (uint32_t i = 0; i < m_n; ++i) {
+     const float d = (m_points[i] - pa).cross(ab).lengthSquared();
+     if (d > best) {
+      best = d;
+      c = i;
+     }
+    }
+    if (c == a) return false;
+    const CVector3 normal = (m_points[b] - pa).cross(m_points[c] - pa).normalized<EU::Precision::Exact>();
+    uint32_t d = a;
+    best = m_tolerance;
+    for (uint32_t i = 0; i < m_n; ++i) {
+     const float h = EngineMath::fabs(normal.dot(m_points[i] - pa));
+     if (h > best) {
+      best = h;
+      d = i;
+     }
+    }
+    if (d == a) return false;
+    // Base (a, b, c) faces away from d, and each side takes a base edge reversed.
+    simplex[0] = a;
+    simplex[1] = b;
+    simplex[2] = c;
+    simplex[3] = d;
+    if (normal.dot(m_points[d] - pa) > 0.f) {
+     simplex[1] = c;
+     simplex[2] = b;
+    }
+    HullFace* f[4] = {
+     face(simplex[0], simplex[1], simplex[2]),
+     face(simplex[1], simplex[0], simplex[3]),
+     face(simplex[2], simplex[1], simplex[3]),
+     face(simplex[0], simplex[2], simplex[3])
+    };
+    for (HullFace* x : f) {
+     for (HullHalfEdge& e : x->edge) {
+      for (HullFace* y : f) {
+       for (HullHalfEdge& o : y->edge) {
+        if (o.head == hullTail(&e) && hullTail(&o) == e.head) e.twin = &o;
+       }
+      }
+     }
+    }
+    for (uint32_t i = 0; i < m_n; ++i) {
+     if (i == simplex[0] || i == simplex[1] || i == simplex[2] || i == simplex[3]) continue;
+     Placement place{ nullptr, -m_tolerance, false };
+     for (int k = 0; k < 4 && !consider(f[k], i, place); ++k) {}
+     assign(place, i);
+    }
+    return true;
+   }
+
+   /**
+    * Faces visible from p, depth first from seen, and the edges of theirs whose twins are not
+    * visible, counter-clockwise around p: each visible face is entered through an edge and
+    * left through its next two in order.
+    */
+   void
+    findHorizon(HullFace* seen, const CVector3& p, uint32_t step, FrameVector<HullFace*>& visible,
+                FrameVector<HullHalfEdge*>& horizon) {
+    visible.clear();
+    horizon.clear();
+    m_stack.clear();
+    seen->visit = step;
+    visible.push_back(seen);
+    m_stack.push_back(HorizonFrame{ seen, 0, 3 });
+    while (!m_stack.empty()) {
+     HorizonFrame& top = m_stack.back();
+     if (top.left == 0) {
+      m_stack.pop_back();
+      continue;
+     }
+     HullHalfEdge* e = &top.face->edge[top.first];
+     top.first = (top.first + 1) % 3;
+     --top.left;
+     HullFace* other = e->twin->face;
+     if (other->visit == step) continue;
+     if (orientation(other, p) >= 0.0) {
+      other->visit = step;
+      visible.push_back(other);
+      m_stack.push_back(HorizonFrame{ other, static_cast<int>((e->twin - other->edge + 1) % 3), 2 });
+     }
+     else horizon.push_back(e);
+    }
+   }
+
+   HullFace*
+    face(uint32_t a, uint32_t b, uint32_t c) {
+    HullFace* f = m_arena.allocateArray<HullFace>(1);
+    const uint32_t corner[3] = { a, b, c };
+    for (int k = 0; k < 3; ++k) f->edge[k] = HullHalfEdge{ corner[(k + 1) % 3], nullptr, f };
+    // In double: the edges of a thin face far from the origin lose most of their digits in float.
+    const CVector3& pa = m_points[a];
+    const CVector3& pb = m_points[b];
+    const CVector3& pc = m_points[c];
+    const double u[3] = { double(pb.x) - pa.x, double(pb.y) - pa.y, double(pb.z) - pa.z };
+    const double v[3] = { double(pc.x) - pa.x, double(pc.y) - pa.y, double(pc.z) - pa.z };
+    const double n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+    double scale = n[0] < 0 ? -n[0] : n[0];
+    for (int k = 1; k < 3; ++k) scale = (n[k] < 0 ? -n[k] : n[k]) > scale ? (n[k] < 0 ? -n[k] : n[k]) : scale;
+    const double inv = scale > 0.0 ? 1.0 / scale : 0.0;
+    f->normal = CVector3(float(n[0] * inv), float(n[1] * inv), float(n[2] * inv)).normalized<EU::Precision::Exact>();
+    f->offset = float(double(f->normal.x) * pa.x + double(f->normal.y) * pa.y + double(f->normal.z) * pa.z);
+    f->outside = HULL_NONE;
+    f->farthest = HULL_NONE;
+    f->distance = 0.f;
+    f->visit = 0;
+    f->dead = false;
+    f->created = m_last;
+    m_last = f;
+    return f;
+   }
+
+   float
+    distance(const HullFace* f, const CVector3& p) const {
+    return f->normal.dot(p) - f->offset;
+   }
+
+   /**
+    * Six times the volume of the tetrahedron of f and p, positive with p in front, in double
+    * from the corners. The rounded unit normal of a thin face can tilt by more than the face is
+    * wide, and visibility must agree with the faces around it or the cone folds inward.
+    */
+   double
+    orientation(const HullFace* f, const CVector3& p) const {
+    const CVector3& pa = m_points[f->edge[2].head];
+    const CVector3& pb = m_points[f->edge[0].head];
+    const CVector3& pc = m_points[f->edge[1].head];
+    const double u[3] = { double(pb.x) - pa.x, double(pb.y) - pa.y, double(pb.z) - pa.z };
+    const double v[3] = { double(pc.x) - pa.x, double(pc.y) - pa.y, double(pc.z) - pa.z };
+    const double w[3] = { double(p.x) - pa.x, double(p.y) - pa.y, double(p.z) - pa.z };
+    return w[0] * (u[1] * v[2] - u[2] * v[1]) + w[1] * (u[2] * v[0] - u[0] * v[2]) + w[2] * (u[0] * v[1] - u[1] * v[0]);
+   }
+
+   /** Face a point goes to, while choosing among faces. */
+   struct Placement {
+    HullFace* face; ///< Face the point is farthest in front of
+    float distance; ///< Its distance, or the largest behind while there is none
+    bool surface;   ///< Within the tolerance of one of the triangles
+   };
+
+   /**
+    * Keeps f in place if point i is farther in front of it; true once that is beyond the
+    * tolerance, which ends the search. Closer than that the test is redone in double, and
+    * the point is on the surface, which ends it too, when it is within the tolerance of the
+    * triangle as well: then it is within the tolerance of every plane of the hull.
+    */
+   bool
+    consider(HullFace* f, uint32_t i, Placement& place) const {
+    float d = distance(f, m_points[i]);
+    if (d > 0.f && !(d > m_tolerance)) {
+     if (orientation(f, m_points[i]) <= 0.0) d = 0.f;
+     else if (!place.surface) place.surface = triangleDistanceSquared(f, m_points[i]) <= double(m_tolerance) * m_tolerance;
+    }
+    if (d > place.distance) {
+     place.distance = d;
+     if (d > 0.f) place.face = f;
+    }
+    return d > m_tolerance || place.surface;
+   }
+
+   /**
+    * Squared distance from p to the triangle f, in double like orientation(): the plane when
+    * p is over the triangle, else the nearest edge. In float a thin face far from the origin
+    * would lose the digits that tell the two apart.
+    */
+   double
+    triangleDistanceSquared(const HullFace* f, const CVector3& p) const {
+    double corner[3][3];
+    for (int k = 0; k < 3; ++k) {
+     const CVector3& c = m_points[f->edge[(k + 2) % 3].head];
+     corner[k][0] = c.x;
+     corner[k][1] = c.y;
+     corner[k][2] = c.z;
+    }
+    const double q[3] = { p.x, p.y, p.z };
+    double u[3], v[3], w[3];
+    for (int k = 0; k < 3; ++k) {
+     u[k] = corner[1][k] - corner[0][k];
+     v[k] = corner[2][k] - corner[0][k];
+     w[k] = q[k] - corner[0][k];
+    }
+    const double n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+    const double nn = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+    bool over = nn > 0.0;
+    double best = -1.0;
+    for (int k = 0; k < 3; ++k) {
+     const double* a = corner[k];
+     const double* b = corner[(k + 1) % 3];
+     const double e[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+     const double r[3] = { q[0] - a[0], q[1] - a[1], q[2] - a[2] };
+     // e x n points out of the triangle across this edge.
+     const double out = r[0] * (e[1] * n[2] - e[2] * n[1]) + r[1] * (e[2] * n[0] - e[0] * n[2]) + r[2] * (e[0] * n[1] - e[1] * n[0]);
+     over = over && out <= 0.0;
+     const double ee = e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
+     double t = ee > 0.0 ? (r[0] * e[0] + r[1] * e[1] + r[2] * e[2]) / ee : 0.0;
+     t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+     double dd = 0.0;
+     for (int j = 0; j < 3; ++j) dd += (r[j] - e[j] * t) * (r[j] - e[j] * t);
+     best = best < 0.0 || dd < best ? dd : best;
+    }
+    if (!over) return best;
+    const double h = w[0] * n[0] + w[1] * n[1] + w[2] * n[2];
+    return h * h / nn;
+   }
+
+   /**
+    * Puts point i in the outside set of place.face and returns that face, or drops the point
+    * and returns null when it is within the tolerance of the hull: behind every face, or near
+    * a triangle. Hulls only grow, so a dropped point stays within it. A point within the
+    * tolerance of the plane but beyond an edge (the sliver faces of a thin slab leave many,
+    * near every plane and far outside) ranks by its distance from the triangle instead.
+    */
+   HullFace*
+    assign(const Placement& place, uint32_t i) {
+    HullFace* f = place.face;
+    if (f == nullptr) return nullptr;
+    float d = place.distance;
+    if (!(d > m_tolerance)) {
+     if (place.surface) return nullptr;
+     d = EngineMath::sqrtHardware(float(triangleDistanceSquared(f, m_points[i])));
+    }
+    m_next[i] = f->outside;
+    f->outside = i;
+    if (f->farthest == HULL_NONE || d > f->distance) {
+     f->farthest = i;
+     f->distance = d;
+    }
+    return f;
+   }
+
+   void
+    push(HullQueue<HullFace>& queue, HullFace* f) {
+    if (f->outside != HULL_NONE && f->distance > m_tolerance) {
+     queue.push(HullCandidate<HullFace>{ f->distance, m_serial++, f });
+    }
+   }
+
+   /** Visible face of findHorizon() and the edges of it still to cross, from first on. */
+   struct HorizonFrame {
+    HullFace* face;
+    int first;
+    int left;
+   };
+
+   const CVector3* m_source;
+   size_t m_n;
+   FrameArena& m_arena;
+   uint32_t* m_next; ///< Outside-set links
+   FrameVector<HorizonFrame> m_stack;
+   const CVector3* m_points; ///< m_source less the center of its bounds
+   float m_tolerance;
+   uint32_t m_serial = 0;
+   HullFace* m_last = nullptr; ///< Newest face, head of the created chain
+  };
+ }
+
+ /**
+  * @brief Convex hull of points[0..n), counter-clockwise (y up), starting at the point of
+  * lowest x. With maxVertices > 0 (at least 3), the hull of the maxVertices most extreme
+  * points, found first.
+  * @param arena Scratch for the call, left allocated until its next reset().
+  * @return True when the hull has an area; otherwise hull holds the one or two extreme
+  * points (none for n = 0).
+  */
+ inline bool
+  convexHull(const CVector2* points, size_t n, std::vector<CVector2>& hull, FrameArena& arena, size_t maxVertices = 0) {
+  return detail::Quickhull2(points, n, arena).run(hull, maxVertices);
+ }
+
+ /** @brief convexHull() with scratch from an arena of its own. */
+ inline bool
+  convexHull(const CVector2* points, size_t n, std::vector<CVector2>& hull, size_t maxVertices = 0) {
+  FrameArena arena(64 * 1024 + n * sizeof(uint32_t));
+  return convexHull(points, n, hull, arena, maxVertices);
+ }
+
+ /**
+  * @brief Convex hull of points[0..n) as a closed triangle mesh: the hull vertices, and three
+  * indices into them per triangle, counter-clockwise seen from outside. With maxVertices > 0
+  * (at least 4), the hull of the maxVertices most extreme points, found first.
+  * @param arena Scratch for the call, left allocated until its next reset().
+  * @return False, with vertices and triangles empty, when the points are within tolerance of
+  * a plane (or n < 4).
+  */
+ inline bool
+  convexHull(const CVector3* points, size_t n, std::vector<CVector3>& vertices, std::vector<uint32_t>& triangles,
+             FrameArena& arena, size_t maxVertices = 0) {
+  return detail::Quickhull3(points, n, arena).run(vertices, triangles, maxVertices);
+ }
+
+ /** @brief convexHull() with scratch from an arena of its own. */
+ inline bool
+  convexHull(const CVector3* points, size_t n, std::vector<CVector3>& vertices, std::vector<uint32_t>& triangles,
+             size_t maxVertices = 0) {
+  FrameArena arena(64 * 1024 + n * 2 * sizeof(uint32_t));
+  return convexHull(points, n, vertices, triangles, arena, maxVertices);
+ }
+}
@@ -0,0 +1,290 @@
+/**
+ * @file Curves.h
+ * @brief Cubic curves of CVector2/CVector3: Bezier segments, Catmull-Rom and B-spline
+ * conversion, uniform and adaptive tessellation, SIMD evaluation and arc-length tables.
+ *
+ * Every curve is handled as a cubic Bezier segment. A uniform Catmull-Rom or B-spline span
+ * converts to one exactly (bezierFromCatmullRom(), bezierFromBSpline()), so the same
+ * tessellators serve all three and no point costs a power() or a factorial().
+ *
+ * Uniform tessellation uses forward differencing: after the three initial differences, each
+ * point costs three vector additions. The differences accumulate rounding, which stays well
+ * below a pixel for the segment counts a single cubic needs (thousands); the last point is set
+ * to the end point exactly. Adaptive tessellation halves the segment (de Casteljau) until it is
+ * flat to within a tolerance: the distance of the curve from its chord, bounded through the
+ * control points (Willcocks' criterion), so straight parts get one segment and tight bends
+ * get many.
+ *
+ * The point producers take an emit(point) callback, so points go straight into any vertex
+ * buffer; VectorSFML.h builds its sf::Vertex and sf::VertexArray overloads on them. Both
+ * emit the points after p0 only, which lets consecutive segments share their joints.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/SIMD.h>
+#include <Math/Precision.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Deepest halving of adaptive tessellation: at most 2^CURVE_MAX_DEPTH segments per curve.
+ constexpr uint32_t CURVE_MAX_DEPTH = 16;
+
+ /**
+  * @brief Cubic Bezier segment from p0 to p3 with control points p1 and p2.
+  */
+ template<typename Vector>
+ struct CubicBezier {
+  Vector p0;
+  Vector p1;
+  Vector p2;
+  Vector p3;
+
+  /** @brief Point at t in [0, 1], in power form: ((a t + b) t + c) t + p0. */
+  Vector
+   evaluate(float t) const {
+   const Vector c = (p1 - p0) * 3.f, b = (p2 - p1 * 2.f + p0) * 3.f, a = p3 - p0 + (p1 - p2) * 3.f;
+   return ((a * t + b) * t + c) * t + p0;
+  }
+
+  /** @brief Tangent (first derivative) at t. */
+  Vector
+   derivative(float t) const {
+   const float s = 1.f - t;
+   return ((p1 - p0) * (s * s) + (p2 - p1) * (2.f * s * t) + (p3 - p2) * (t * t)) * 3.f;
+  }
+
+  /** @brief Splits at t into the segments covering [0, t] and [t, 1] (de Casteljau). */
+  void
+   split(float t, CubicBezier& left, CubicBezier& right) const {
+   const Vector a = p0 + (p1 - p0) * t, b = p1 + (p2 - p1) * t, c = p2 + (p3 - p2) * t;
+   const Vector ab = a + (b - a) * t, bc = b + (c - b) * t;
+   const Vector mid = ab + (bc - ab) * t;
+   left = CubicBezier{ p0, a, ab, mid };
+   right = CubicBezier{ mid, bc, c, p3 };
+  }
+
+  /**
+   * @brief Sixteen times an upper bound on the squared distance between the curve and its
+   * chord p0-p3: the segment is within tolerance of the chord when this is <= 16 tolerance^2.
+   */
+  float
+   flatness() const {
+   const Vector u = p1 * 3.f - p0 * 2.f - p3, v = p2 * 3.f - p0 - p3 * 2.f;
+   float sum = 0.f;
+   for (int i = 0; i < static_cast<int>(sizeof(Vector) / sizeof(float)); ++i) {
+    sum += u[i] * u[i] > v[i] * v[i] ? u[i] * u[i] : v[i] * v[i];
+   }
+   return sum;
+  }
+ };
+
+ using CubicBezier2 = CubicBezier<CVector2>;
+ using CubicBezier3 = CubicBezier<CVector3>;
+
+ /**
+  * @brief The span p1 to p2 of the uniform Catmull-Rom spline through p0, p1, p2, p3.
+  */
+ template<typename Vector>
+ inline CubicBezier<Vector>
+  bezierFromCatmullRom(const Vector& p0, const Vector& p1, const Vector& p2, const Vector& p3) {
+  return CubicBezier<Vector>{ p1, p1 + (p2 - p0) * (1.f / 6.f), p2 - (p3 - p1) * (1.f / 6.f), p2 };
+ }
+
+ /**
+  * @brief The span of the uniform cubic B-spline with control points p0, p1, p2, p3, which
+  * passes near, not through, p1 and p2.
+  */
+ template<typename Vector>
+ inline CubicBezier<Vector>
+  bezierFromBSpline(const Vector& p0, const Vector& p1, const Vector& p2, const Vector& p3) {
+  return CubicBezier<Vector>{ (p0 + p1 * 4.f + p2) * (1.f / 6.f), (p1 * 2.f + p2) * (1.f / 3.f),
+                              (p1 + p2 * 2.f) * (1.f / 3.f), (p1 + p2 * 4.f + p3) * (1.f / 6.f) };
+ }
+
+ /**
+  * @brief Calls emit(point) for the points at t = 1/segments, 2/segments, ..., 1 by forward
+  * differencing; p0 itself is not emitted.
+  */
+ template<typename Vector, typename Fn>
+ inline void
+  forEachUniformPoint(const CubicBezier<Vector>& curve, size_t segments, Fn emit) {
+  if (segments == 0) return;
+  const float h = 1.f / static_cast<float>(segments), h2 = h * h, h3 = h2 * h;
+  const Vector c = (curve.p1 - curve.p0) * 3.f, b = (curve.p2 - curve.p1 * 2.f + curve.p0) * 3.f;
+  const Vector a = curve.p3 - curve.p0 + (curve.p1 - curve.p2) * 3.f;
+  Vector point = curve.p0;
+  Vector d1 = a * h3 + b * h2 + c * h, d2 = a * (6.f * h3) + b * (2.f * h2);
+  const Vector d3 = a * (6.f * h3);
+  for (size_t i = 1; i < segments; ++i) {
+   point += d1;
+   d1 += d2;
+   d2 += d3;
+   emit(point);
+  }
+  emit(curve.p3);
+ }
+
+ /**
+  * @brief Calls emit(point) for the end points of an adaptive subdivision of curve into
+  * segments that stay within tolerance of the curve, in order; p0 itself is not emitted.
+  */
+ template<typename Vector, typename Fn>
+ inline void
+  forEachAdaptivePoint(const CubicBezier<Vector>& curve, float tolerance, Fn emit) {
+  const float limit = 16.f * tolerance * tolerance;
+  // Right halves wait on the stack while the left ones are refined, so points come out in order.
+  CubicBezier<Vector> stack[CURVE_MAX_DEPTH + 1];
+  uint32_t depth[CURVE_MAX_DEPTH + 1];
+  size_t top = 0;
+  stack[top] = curve;
+  depth[top++] = 0;
+  while (top > 0) {
+   const CubicBezier<Vector> segment = stack[--top];
+   const uint32_t level = depth[top];
+   if (level >= CURVE_MAX_DEPTH || segment.flatness() <= limit) {
+    emit(segment.p3);
+    continue;
+   }
+   CubicBezier<Vector> left, right;
+   segment.split(0.5f, left, right);
+   stack[top] = right;
+   depth[top++] = level + 1;
+   stack[top] = left;
+   depth[top++] = level + 1;
+  }
+ }
+
+ /**
+  * @brief Writes the segments + 1 points of a uniform tessellation, p0 first, to out.
+  */
+ template<typename Vector>
+ inline void
+  tessellateUniform(const CubicBezier<Vector>& curve, size_t segments, Vector* out) {
+  *out++ = curve.p0;
+  forEachUniformPoint(curve, segments, [&](const Vector& p) { *out++ = p; });
+ }
+
+ /**
+  * @brief Appends an adaptive tessellation within tolerance to out, without p0 (push it first,
+  * or chain segments that share their ends); returns the number of points appended.
+  */
+ template<typename Vector>
+ inline size_t
+  tessellateAdaptive(const CubicBezier<Vector>& curve, float tolerance, std::vector<Vector>& out) {
+  const size_t before = out.size();
+  forEachAdaptivePoint(curve, tolerance, [&](const Vector& p) { out.push_back(p); });
+  return out.size() - before;
+ }
+
+ /**
+  * @brief Points of curve at t[0..n), one register of parameters per step.
+  */
+ template<typename Vector>
+ inline void
+  evaluateArray(const CubicBezier<Vector>& curve, const float* t, size_t n, Vector* out) {
+  using detail::BatchLanes;
+  constexpr int DIM = static_cast<int>(sizeof(Vector) / sizeof(float));
+  const Vector c = (curve.p1 - curve.p0) * 3.f, b = (curve.p2 - curve.p1 * 2.f + curve.p0) * 3.f;
+  const Vector a = curve.p3 - curve.p0 + (curve.p1 - curve.p2) * 3.f;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   const BatchLanes s = detail::loadLanes(t, i, count);
+   float lanes[DIM][detail::BATCH_WIDTH];
+   for (int k = 0; k < DIM; ++k) {
+    const BatchLanes v = EU::SIMD::madd(
+     EU::SIMD::madd(EU::SIMD::madd(BatchLanes::set1(a[k]), s, BatchLanes::set1(b[k])), s, BatchLanes::set1(c[k])), s,
+     BatchLanes::set1(curve.p0[k]));
+    v.store(lanes[k]);
+   }
+   for (size_t j = 0; j < count; ++j) {
+    for (int k = 0; k < DIM; ++k) out[i + j][k] = lanes[k][j];
+   }
+  }
+ }
+
+ /**
+  * @class ArcLengthTable
+  * @brief Cumulative arc length of a curve at uniform parameter steps, for moving along it
+  * at constant speed or spacing points evenly.
+  *
+  * The table holds the arc length at t = i / samples, each step integrated with three-point
+  * Gauss-Legendre quadrature of |derivative|: a few parts in 10^5 of the length at 64 samples
+  * of a typical UI or road curve. parameter() inverts it by binary search and linear
+  * interpolation within a step. build() reuses the storage.
+  */
+ class
+  ArcLengthTable {
+  public:
+  template<typename Vector>
+  void
+   build(const CubicBezier<Vector>& curve, size_t samples = 64) {
+   if (samples == 0) samples = 1;
+   m_length.resize(samples + 1);
+   m_length[0] = 0.f;
+   const float h = 1.f / static_cast<float>(samples), node = 0.3872983346f * h; // sqrt(3/5) h / 2
+   for (size_t i = 0; i < samples; ++i) {
+    const float mid = (static_cast<float>(i) + 0.5f) * h;
+    const float step = (5.f / 18.f) * curve.derivative(mid - node).template length<EU::Precision::Exact>() +
+                       (8.f / 18.f) * curve.derivative(mid).template length<EU::Precision::Exact>() +
+                       (5.f / 18.f) * curve.derivative(mid + node).template length<EU::Precision::Exact>();
+    m_length[i + 1] = m_length[i] + step * h;
+   }
+  }
+
+  /** @brief Length of the curve; 0 before build(). */
+  float
+   length() const {
+   return m_length.empty() ? 0.f : m_length.back();
+  }
+
+  /** @brief Parameter t at arc length s, clamped to [0, length()]. */
+  float
+   parameter(float s) const {
+   if (m_length.size() < 2 || !(s > 0.f)) return 0.f;
+   if (s >= m_length.back()) return 1.f;
+   size_t lo = 0, hi = m_length.size() - 1;
+   while (hi - lo > 1) {
+    const size_t mid = (lo + hi) / 2;
+    if (m_length[mid] <= s) {
+     lo = mid;
+    }
+    else {
+     hi = mid;
+    }
+   }
+   const float span = m_length[hi] - m_length[lo];
+   const float f = span > 0.f ? (s - m_length[lo]) / span : 0.f;
+   return (static_cast<float>(lo) + f) / static_cast<float>(m_length.size() - 1);
+  }
+
+  /** @brief parameter() of s[0..n) into t. */
+  void
+   parameters(const float* s, size_t n, float* t) const {
+   for (size_t i = 0; i < n; ++i) t[i] = parameter(s[i]);
+  }
+
+  private:
+  std::vector<float> m_length;
+ };
+
+ /**
+  * @brief count (>= 2) points of curve evenly spaced in arc length, p0 and p3 included,
+  * through table (which must have been built from curve), into out; t receives their
+  * parameters and must hold count floats.
+  */
+ template<typename Vector>
+ inline void
+  tessellateEvenly(const CubicBezier<Vector>& curve, const ArcLengthTable& table, size_t count, float* t, Vector* out) {
+  if (count < 2) return;
+  const float step = table.length() / static_cast<float>(count - 1);
+  for (size_t i = 0; i < count; ++i) t[i] = table.parameter(step * static_cast<float>(i));
+  t[count - 1] = 1.f;
+  evaluateArray(curve, t, count, out);
+ }
+}
@@ -0,0 +1,258 @@
+/**
+ * @file Frustum.h
+ * @brief View frustum planes and SIMD culling of sphere and AABB sets.
+ *
+ * Frustum::fromMatrix() extracts the six planes of a view-projection matrix (Gribb and
+ * Hartmann) and normalizes them, so a plane test is a signed distance. cullSpheres() and
+ * cullBoxes() test a register of objects (8 with AVX) against every plane without branching
+ * and write the indices of the ones that may be visible, in ascending order, to a compacted
+ * list. Both tests are conservative: objects near a frustum corner can pass while lying
+ * just outside.
+ *
+ * Boxes use the positive-vertex test. Each plane's normal picks the min or max corner per
+ * axis once per call, so the inner loop reads the right SoA arrays directly, with no select.
+ *
+ * Large sets are cut into fixed CULL_CHUNK-sized chunks over threads (0 = hardware_concurrency(),
+ * 1 = caller only). Each chunk writes into its own slice of the output without any locking,
+ * and the slices are then packed in order. The result is the same for any thread count.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Core/Trace.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Matrix4x4.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /**
+  * @brief Clip-space depth range of the projection a frustum is extracted from.
+  */
+ enum class DepthRange {
+  NegativeOneToOne, ///< OpenGL: -w <= z <= w (perspective(), orthographic())
+  ZeroToOne         ///< D3D/Vulkan and the reversed-Z projections: 0 <= z <= w
+ };
+
+ /**
+  * @class Frustum
+  * @brief Six inward-facing planes; a point p is inside when dot(n, p) + d >= 0 for all.
+  */
+ class
+  Frustum {
+  public:
+  enum PlaneIndex { LEFT, RIGHT, BOTTOM, TOP, ZNEAR, ZFAR }; // NEAR and FAR are windows.h macros
+
+  float planes[6][4]; ///< (nx, ny, nz, d) per PlaneIndex, unit normal pointing inside
+
+  /**
+   * @brief Default constructor. Every plane accepts everything.
+   */
+  constexpr Frustum()
+   : planes{ { 0.f, 0.f, 0.f, 1.f }, { 0.f, 0.f, 0.f, 1.f }, { 0.f, 0.f, 0.f, 1.f },
+             { 0.f, 0.f, 0.f, 1.f }, { 0.f, 0.f, 0.f, 1.f }, { 0.f, 0.f, 0.f, 1.f } } {}
+
+  /**
+   * @brief Planes of a view-projection matrix, in the space its input points live in.
+   *
+   * A far plane at infinity (perspectiveInfiniteReversedZ()) has no normal; it is kept as a
+   * plane that accepts everything.
+   */
+  static EU_CONSTEXPR20 Frustum
+   fromMatrix(const Matrix4x4& viewProjection, DepthRange depth = DepthRange::NegativeOneToOne) {
+   const float (&m)[4][4] = viewProjection.m;
+   Frustum f;
+   for (int c = 0; c < 4; ++c) {
+    f.planes[LEFT][c] = m[3][c] + m[0][c];
+    f.planes[RIGHT][c] = m[3][c] - m[0][c];
+    f.planes[BOTTOM][c] = m[3][c] + m[1][c];
+    f.planes[TOP][c] = m[3][c] - m[1][c];
+    f.planes[ZNEAR][c] = depth == DepthRange::ZeroToOne ? m[2][c] : m[3][c] + m[2][c];
+    f.planes[ZFAR][c] = m[3][c] - m[2][c];
+   }
+   for (int p = 0; p < 6; ++p) {
+    float* plane = f.planes[p];
+    const float lenSq = plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2];
+    if (lenSq == 0.f) {
+     plane[0] = plane[1] = plane[2] = 0.f;
+     plane[3] = 1.f;
+     continue;
+    }
+    const float inv = 1.f / EngineMath::sqrtHardware(lenSq);
+    for (int c = 0; c < 4; ++c) plane[c] *= inv;
+   }
+   return f;
+  }
+
+  /**
+   * @brief Signed distance from point to plane p, positive inside.
+   */
+  constexpr float
+   distance(int p, const CVector3& point) const {
+   return planes[p][0] * point.x + planes[p][1] * point.y + planes[p][2] * point.z + planes[p][3];
+  }
+
+  /**
+   * @brief True when point is inside or on every plane.
+   */
+  constexpr bool
+   containsPoint(const CVector3& point) const {
+   for (int p = 0; p < 6; ++p)
+    if (distance(p, point) < 0.f) return false;
+   return true;
+  }
+
+  /**
+   * @brief True unless the sphere is entirely behind some plane.
+   */
+  constexpr bool
+   intersectsSphere(const CVector3& center, float radius) const {
+   for (int p = 0; p < 6; ++p)
+    if (distance(p, center) < -radius) return false;
+   return true;
+  }
+
+  /**
+   * @brief True unless the box [lo, hi] is entirely behind some plane.
+   */
+  constexpr bool
+   intersectsBox(const CVector3& lo, const CVector3& hi) const {
+   for (int p = 0; p < 6; ++p) {
+    const CVector3 corner(planes[p][0] > 0.f ? hi.x : lo.x, planes[p][1] > 0.f ? hi.y : lo.y,
+                          planes[p][2] > 0.f ? hi.z : lo.z);
+    if (distance(p, corner) < 0.f) return false;
+   }
+   return true;
+  }
+ };
+
+ namespace detail {
+  /// Objects per culling task; fixes the work split.
+  constexpr size_t CULL_CHUNK = 16384;
+  /// Sets smaller than this stay on the calling thread.
+  constexpr size_t PARALLEL_CULL_MIN = 1 << 17;
+
+  /** Broadcast plane coefficients. */
+  struct CullPlanes {
+   BatchLanes n[6][4];
+
+   explicit CullPlanes(const Frustum& frustum) {
+    for (int p = 0; p < 6; ++p)
+     for (int c = 0; c < 4; ++c) n[p][c] = BatchLanes::set1(frustum.planes[p][c]);
+   }
+
+   BatchLanes
+    distance(int p, BatchLanes x, BatchLanes y, BatchLanes z) const {
+    return EU::SIMD::madd(n[p][2], z, EU::SIMD::madd(n[p][1], y, n[p][0] * x)) + n[p][3];
+   }
+  };
+
+  /** Visible spheres among [begin, end), written to out from out[0]. */
+  inline size_t
+   cullSpheresRange(const CullPlanes& planes, EngineMath::batch::ConstSoA3 centers, const float* radii,
+                    size_t begin, size_t end, uint32_t* out) {
+   size_t found = 0;
+   for (size_t i = begin; i < end; i += BATCH_WIDTH) {
+    const size_t count = end - i < BATCH_WIDTH ? end - i : BATCH_WIDTH;
+    const BatchLanes x = loadLanes(centers.x, i, count), y = loadLanes(centers.y, i, count);
+    const BatchLanes z = loadLanes(centers.z, i, count);
+    const BatchLanes negRadius = BatchLanes::zero() - loadLanes(radii, i, count);
+    BatchLanes inside = planes.distance(0, x, y, z) >= negRadius;
+    for (int p = 1; p < 6; ++p) inside = inside & (planes.distance(p, x, y, z) >= negRadius);
+    found = appendLanes(inside, count, static_cast<uint32_t>(i), out, found);
+   }
+   return found;
+  }
+
+  /** Visible boxes among [begin, end), written to out from out[0]. */
+  inline size_t
+   cullBoxesRange(const Frustum& frustum, const CullPlanes& planes, EngineMath::batch::ConstSoA3 lo,
+                  EngineMath::batch::ConstSoA3 hi, size_t begin, size_t end, uint32_t* out) {
+   // Positive vertex per plane: the corner furthest along its normal.
+   const float* corner[6][3];
+   for (int p = 0; p < 6; ++p) {
+    corner[p][0] = frustum.planes[p][0] > 0.f ? hi.x : lo.x;
+    corner[p][1] = frustum.planes[p][1] > 0.f ? hi.y : lo.y;
+    corner[p][2] = frustum.planes[p][2] > 0.f ? hi.z : lo.z;
+   }
+   const BatchLanes zero = BatchLanes::zero();
+   size_t found = 0;
+   for (size_t i = begin; i < end; i += BATCH_WIDTH) {
+    const size_t count = end - i < BATCH_WIDTH ? end - i : BATCH_WIDTH;
+    BatchLanes inside = EU::SIMD::asFloat(BatchInt::set1(-1));
+    for (int p = 0; p < 6; ++p) {
+     const BatchLanes x = loadLanes(corner[p][0], i, count), y = loadLanes(corner[p][1], i, count);
+     const BatchLanes z = loadLanes(corner[p][2], i, count);
+     inside = inside & (planes.distance(p, x, y, z) >= zero);
+    }
+    found = appendLanes(inside, count, static_cast<uint32_t>(i), out, found);
+   }
+   return found;
+  }
+
+  /**
+   * Runs range(begin, end, out + begin) over CULL_CHUNK chunks, each chunk filling its own
+   * slice of out, then packs the slices to the front in chunk order.
+   */
+  template<typename Range>
+  inline size_t
+   cullChunks(size_t n, size_t threads, uint32_t* out, Range range) {
+   const size_t chunks = (n + CULL_CHUNK - 1) / CULL_CHUNK;
+   threads = n < PARALLEL_CULL_MIN ? 1 : resolveThreads(threads, chunks);
+   if (threads <= 1) {
+    return range(0, n, out);
+   }
+   std::vector<size_t> found(chunks);
+   parallelTasks(chunks, threads, [&](size_t c) {
+    const size_t begin = c * CULL_CHUNK;
+    found[c] = range(begin, n - begin < CULL_CHUNK ? n : begin + CULL_CHUNK, out + begin);
+   });
+   size_t total = found[0];
+   for (size_t c = 1; c < chunks; ++c) {
+    const uint32_t* slice = out + c * CULL_CHUNK;
+    for (size_t j = 0; j < found[c]; ++j) out[total + j] = slice[j];
+    total += found[c];
+   }
+   return total;
+  }
+ }
+
+ /**
+  * @brief Writes the indices of the spheres that may be visible to visible, ascending.
+  * @param visible Room for n indices; also used as per-chunk scratch.
+  * @param threads Worker threads for large sets, 0 for hardware_concurrency().
+  * @return Number of indices written.
+  */
+ inline size_t
+  cullSpheres(const Frustum& frustum, EngineMath::batch::ConstSoA3 centers, const float* radii, size_t n,
+              uint32_t* visible, size_t threads = 0) {
+  EU_TRACE_ZONE("cullSpheres");
+  const detail::CullPlanes planes(frustum);
+  return detail::cullChunks(n, threads, visible, [&](size_t begin, size_t end, uint32_t* out) {
+   return detail::cullSpheresRange(planes, centers, radii, begin, end, out);
+  });
+ }
+
+ /**
+  * @brief Writes the indices of the boxes [lo[i], hi[i]] that may be visible to visible,
+  * ascending.
+  * @param visible Room for n indices; also used as per-chunk scratch.
+  * @param threads Worker threads for large sets, 0 for hardware_concurrency().
+  * @return Number of indices written.
+  */
+ inline size_t
+  cullBoxes(const Frustum& frustum, EngineMath::batch::ConstSoA3 lo, EngineMath::batch::ConstSoA3 hi, size_t n,
+            uint32_t* visible, size_t threads = 0) {
+  EU_TRACE_ZONE("cullBoxes");
+  const detail::CullPlanes planes(frustum);
+  return detail::cullChunks(n, threads, visible, [&](size_t begin, size_t end, uint32_t* out) {
+   return detail::cullBoxesRange(frustum, planes, lo, hi, begin, end, out);
+  });
+ }
+}
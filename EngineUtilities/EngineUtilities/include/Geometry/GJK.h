@@ -0,0 +1,825 @@
+/**
+ * @file GJK.h
+ * @brief GJK distance and intersection and EPA penetration depth between convex shapes given
+ * by support functions, with the simplex warm-started from the previous frame.
+ *
+ * A shape is anything with supportPoint(shape, direction), its farthest point along
+ * direction, and supportMargin(shape), a radius rounding it off (0 unless overloaded). Both
+ * are found by overload or argument-dependent lookup, so a new shape only needs the two free
+ * functions. Overloads are provided for Sphere and Capsule (a point and a segment with their
+ * radius as margin), AABB, OrientedBox and ConvexPoints, the vertices of a convexHull() under
+ * a rotation and translation.
+ *
+ * GJK runs on the margin-less cores and takes the margins off the distance afterwards, which
+ * is exact for spheres and capsules and converges in a few steps instead of crawling along
+ * a curved surface. Only when the cores themselves overlap does EPA run, on the full shapes.
+ *
+ * GJKCache keeps the directions the last simplex was found along; the next query rebuilds
+ * the simplex from them on the shapes as they are now, so a pair that moved a little is
+ * often settled in one or two steps. Keep one per pair, e.g. in a GJKPairCache keyed by the
+ * broadphase ids; a default GJKCache just starts cold.
+ *
+ * EPA's polytope lives in fixed arrays on the stack, enough for EPA_STACK_ITERATIONS
+ * expansions. An arena lets it continue up to maxIterations in arena memory; without one it
+ * stops there and reports the best face found, as it does when rounding makes an expansion
+ * need more faces than the polytope has room for.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <Core/Constants.h>
+#include <Core/FrameArena.h>
+#include <Geometry/OrientedBox.h>
+#include <Geometry/Overlap.h>
+#include <Geometry/Primitives.h>
+#include <Math/EngineMath.h>
+#include <Matrices/Matrix3x3.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /// GJK steps before giving up with the best simplex so far.
+ constexpr uint32_t GJK_MAX_ITERATIONS = 64;
+ /// GJK stops once a step improves the squared distance by less than this fraction.
+ constexpr float GJK_TOLERANCE = 1e-5f;
+ /// ... or by less than this fraction of the largest squared vertex of A - B, the float rounding of a step.
+ constexpr float GJK_ABSOLUTE_TOLERANCE = 1e-7f;
+ /// Default EPA expansions.
+ constexpr uint32_t EPA_MAX_ITERATIONS = 64;
+ /// EPA expansions that fit in the polytope on the stack.
+ constexpr uint32_t EPA_STACK_ITERATIONS = 32;
+ /// EPA stops once the support along the closest face gains less than this fraction of its distance.
+ constexpr float EPA_TOLERANCE = 1e-4f;
+
+ /**
+  * @class ConvexPoints
+  * @brief Convex hull of points[0..count), e.g. convexHull() vertices, rotated by rotation
+  * and then moved by position. The points are not copied.
+  */
+ class
+  ConvexPoints {
+  public:
+  const CVector3* points; ///< Local-space points
+  size_t count;           ///< Number of points, > 0
+  Matrix3x3 rotation;     ///< Rotation to world space
+  CVector3 position;      ///< Translation to world space
+
+  constexpr ConvexPoints(const CVector3* points, size_t count) : points(points), count(count), rotation(), position() {}
+
+  constexpr ConvexPoints(const CVector3* points, size_t count, const Matrix3x3& rotation, const CVector3& position)
+   : points(points), count(count), rotation(rotation), position(position) {}
+ };
+
+ /** @brief Margin of a shape without one. */
+ template<typename Shape>
+ constexpr float
+  supportMargin(const Shape&) {
+  return 0.f;
+ }
+
+ /** @brief Core of a sphere: its center; the radius is the margin. */
+ constexpr CVector3
+  supportPoint(const Sphere& sphere, const CVector3&) {
+  return sphere.center;
+ }
+
+ constexpr float
+  supportMargin(const Sphere& sphere) {
+  return sphere.radius;
+ }
+
+ /** @brief Core of a capsule: the end of its segment farthest along direction. */
+ constexpr CVector3
+  supportPoint(const Capsule& capsule, const CVector3& direction) {
+  return direction.dot(capsule.b - capsule.a) > 0.f ? capsule.b : capsule.a;
+ }
+
+ constexpr float
+  supportMargin(const Capsule& capsule) {
+  return capsule.radius;
+ }
+
+ constexpr CVector3
+  supportPoint(const AABB& box, const CVector3& direction) {
+  return CVector3(direction.x >= 0.f ? box.max.x : box.min.x, direction.y >= 0.f ? box.max.y : box.min.y,
+                  direction.z >= 0.f ? box.max.z : box.min.z);
+ }
+
+ constexpr CVector3
+  supportPoint(const OrientedBox& box, const CVector3& direction) {
+  CVector3 p = box.center;
+  for (int i = 0; i < 3; ++i) {
+   const CVector3 axis(box.axes.m[0][i], box.axes.m[1][i], box.axes.m[2][i]);
+   p = p + axis * (direction.dot(axis) >= 0.f ? box.halfExtents[i] : -box.halfExtents[i]);
+  }
+  return p;
+ }
+
+ inline CVector3
+  supportPoint(const ConvexPoints& hull, const CVector3& direction) {
+  const Matrix3x3& r = hull.rotation;
+  const CVector3 local(r.m[0][0] * direction.x + r.m[1][0] * direction.y + r.m[2][0] * direction.z,
+                       r.m[0][1] * direction.x + r.m[1][1] * direction.y + r.m[2][1] * direction.z,
+                       r.m[0][2] * direction.x + r.m[1][2] * direction.y + r.m[2][2] * direction.z);
+  size_t best = 0;
+  float bestDot = local.dot(hull.points[0]);
+  for (size_t i = 1; i < hull.count; ++i) {
+   const float d = local.dot(hull.points[i]);
+   if (d > bestDot) {
+    bestDot = d;
+    best = i;
+   }
+  }
+  return r * hull.points[best] + hull.position;
+ }
+
+ /**
+  * @brief Directions the last GJK simplex of a pair was built along.
+  */
+ struct GJKCache {
+  CVector3 direction[4]; ///< Search directions of the simplex vertices
+  uint32_t count;        ///< Vertices cached, 0 for a cold start
+ };
+
+ EU_ASSERT_VALUE_TYPE(GJKCache);
+
+ /**
+  * @brief Closest points of two shapes, or their deepest points when they overlap.
+  */
+ struct GJKResult {
+  CVector3 pointA;     ///< Point of the first shape, on its surface
+  CVector3 pointB;     ///< Point of the second shape, on its surface
+  CVector3 normal;     ///< Unit, from the first shape toward the second; moving the second along it separates them
+  float distance;      ///< Gap between the shapes, minus the penetration depth when they overlap
+  uint32_t iterations; ///< GJK steps, plus EPA expansions
+ };
+
+ EU_ASSERT_VALUE_TYPE(GJKResult);
+
+ namespace detail {
+  /** Vertex of the Minkowski difference A - B with the points of A and B it came from. */
+  struct GJKVertex {
+   CVector3 w;
+   CVector3 a;
+   CVector3 b;
+   CVector3 direction;
+  };
+
+  template<typename ShapeA, typename ShapeB>
+  inline GJKVertex
+   gjkSupport(const ShapeA& a, const ShapeB& b, const CVector3& direction) {
+   const CVector3 pa = supportPoint(a, direction);
+   const CVector3 pb = supportPoint(b, direction * -1.f);
+   return GJKVertex{ pa - pb, pa, pb, direction };
+  }
+
+  /** Support of the full shapes, margins included; direction is unit. */
+  template<typename ShapeA, typename ShapeB>
+  inline GJKVertex
+   epaSupport(const ShapeA& a, const ShapeB& b, const CVector3& direction) {
+   const CVector3 pa = supportPoint(a, direction) + direction * supportMargin(a);
+   const CVector3 pb = supportPoint(b, direction * -1.f) - direction * supportMargin(b);
+   return GJKVertex{ pa - pb, pa, pb, direction };
+  }
+
+  /** Barycentric weights of the point of segment (a, b) closest to the origin. */
+  inline void
+   closestOnSegment(const CVector3& a, const CVector3& b, float (&weight)[3]) {
+   const CVector3 ab = b - a;
+   const float lenSq = ab.lengthSquared();
+   const float t = lenSq > 0.f ? EngineMath::clamp(-a.dot(ab) / lenSq, 0.f, 1.f) : 0.f;
+   weight[0] = 1.f - t;
+   weight[1] = t;
+   weight[2] = 0.f;
+  }
+
+  /** Barycentric weights of the point of triangle (a, b, c) closest to the origin (Ericson 5.1.5). */
+  inline void
+   closestOnTriangle(const CVector3& a, const CVector3& b, const CVector3& c, float (&weight)[3]) {
+   const CVector3 ab = b - a, ac = c - a;
+   const float d1 = -ab.dot(a), d2 = -ac.dot(a);
+   weight[0] = weight[1] = weight[2] = 0.f;
+   if (d1 <= 0.f && d2 <= 0.f) {
+    weight[0] = 1.f;
+    return;
+   }
+   const float d3 = -ab.dot(b), d4 = -ac.dot(b);
+   if (d3 >= 0.f && d4 <= d3) {
+    weight[1] = 1.f;
+    return;
+   }
+   const float vc = d1 * d4 - d3 * d2;
+   if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) {
+    weight[1] = d1 / (d1 - d3);
+    weight[0] = 1.f - weight[1];
+    return;
+   }
+   const float d5 = -ab.dot(c), d6 = -ac.dot(c);
+   if (d6 >= 0.f && d5 <= d6) {
+    weight[2] = 1.f;
+    return;
+   }
+   const float vb = d5 * d2 - d1 * d6;
+   if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) {
+    weight[2] = d2 / (d2 - d6);
+    weight[0] = 1.f - weight[2];
+    return;
+   }
+   const float va = d3 * d6 - d5 * d4;
+   if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f) {
+    weight[2] = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+    weight[1] = 1.f - weight[2];
+    return;
+   }
+   const float sum = va + vb + vc;
+   if (!(sum > 0.f)) {
+    // Collinear corners: the nearest of the edges.
+    float best = EU::Constants::INF;
+    const CVector3* corner[3] = { &a, &b, &c };
+    for (int e = 0; e < 3; ++e) {
+     float w[3];
+     closestOnSegment(*corner[e], *corner[(e + 1) % 3], w);
+     const float d = (*corner[e] * w[0] + *corner[(e + 1) % 3] * w[1]).lengthSquared();
+     if (d < best) {
+      best = d;
+      weight[0] = weight[1] = weight[2] = 0.f;
+      weight[e] = w[0];
+      weight[(e + 1) % 3] = w[1];
+     }
+    }
+    return;
+   }
+   weight[1] = vb / sum;
+   weight[2] = vc / sum;
+   weight[0] = 1.f - weight[1] - weight[2];
+  }
+
+  /**
+   * @class GJKSimplex
+   * @brief Up to four vertices of A - B, reduced after each solve() to the ones spanning the
+   * point closest to the origin.
+   */
+  class
+   GJKSimplex {
+   public:
+   GJKVertex vertex[4];
+   float weight[4];
+   uint32_t count = 0;
+
+   void
+    add(const GJKVertex& v) {
+    vertex[count] = v;
+    weight[count] = 0.f;
+    ++count;
+   }
+
+   /** Closest point to the origin; false when the simplex is a tetrahedron holding the origin. */
+   bool
+    solve(CVector3& closest) {
+    if (count == 4 && !solveTetrahedron()) return false;
+    if (count == 3) {
+     float w[3];
+     closestOnTriangle(vertex[0].w, vertex[1].w, vertex[2].w, w);
+     setWeights(w, 3);
+    }
+    else if (count == 2) {
+     float w[3];
+     closestOnSegment(vertex[0].w, vertex[1].w, w);
+     setWeights(w, 2);
+    }
+    else if (count == 1) weight[0] = 1.f;
+    compact();
+    closest = CVector3(0.f, 0.f, 0.f);
+    for (uint32_t i = 0; i < count; ++i) closest = closest + vertex[i].w * weight[i];
+    return true;
+   }
+
+   void
+    points(CVector3& a, CVector3& b) const {
+    a = b = CVector3(0.f, 0.f, 0.f);
+    for (uint32_t i = 0; i < count; ++i) {
+     a = a + vertex[i].a * weight[i];
+     b = b + vertex[i].b * weight[i];
+    }
+   }
+
+   bool
+    contains(const CVector3& w) const {
+    for (uint32_t i = 0; i < count; ++i) {
+     if (vertex[i].w == w) return true;
+    }
+    return false;
+   }
+
+   private:
+   void
+    setWeights(const float (&w)[3], uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) weight[i] = w[i];
+   }
+
+   void
+    compact() {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+     if (weight[i] > 0.f) {
+      vertex[kept] = vertex[i];
+      weight[kept] = weight[i];
+      ++kept;
+     }
+    }
+    if (kept == 0) {
+     weight[0] = 1.f;
+     kept = 1;
+    }
+    count = kept;
+   }
+
+   /**
+    * Reduces the tetrahedron to its face nearest the origin among those the origin is
+    * beyond; false when it is beyond none, i.e. inside. A flat tetrahedron has no inside.
+    */
+   bool
+    solveTetrahedron() {
+    const CVector3& p0 = vertex[0].w;
+    const CVector3 e1 = vertex[1].w - p0, e2 = vertex[2].w - p0, e3 = vertex[3].w - p0;
+    const float volume = e1.dot(e2.cross(e3));
+    const float scale = e1.lengthSquared() * e2.lengthSquared() * e3.lengthSquared();
+    const bool flat = volume * volume <= EU::Constants::EPSILON * EU::Constants::EPSILON * scale;
+    float best = EU::Constants::INF;
+    int bestFace = -1;
+    float bestWeight[3] = {};
+    for (int skip = 0; skip < 4; ++skip) {
+     const CVector3& a = vertex[(skip + 1) % 4].w;
+     const CVector3& b = vertex[(skip + 2) % 4].w;
+     const CVector3& c = vertex[(skip + 3) % 4].w;
+     const CVector3 n = (b - a).cross(c - a);
+     // The origin is beyond this face when it and the skipped vertex are on opposite sides.
+     const float origin = -n.dot(a), opposite = n.dot(vertex[skip].w - a);
+     if (!flat && origin * opposite >= 0.f) continue;
+     float w[3];
+     closestOnTriangle(a, b, c, w);
+     const float d = (a * w[0] + b * w[1] + c * w[2]).lengthSquared();
+     if (d < best) {
+      best = d;
+      bestFace = skip;
+      bestWeight[0] = w[0];
+      bestWeight[1] = w[1];
+      bestWeight[2] = w[2];
+     }
+    }
+    if (bestFace < 0) return false;
+    const GJKVertex face[3] = { vertex[(bestFace + 1) % 4], vertex[(bestFace + 2) % 4], vertex[(bestFace + 3) % 4] };
+    for (int i = 0; i < 3; ++i) {
+     vertex[i] = face[i];
+     weight[i] = bestWeight[i];
+    }
+    count = 3;
+    compact();
+    return true;
+   }
+  };
+
+  /** Largest squared vertex of the simplex, the size of A - B its rounding scales with. */
+  inline float
+   simplexScale(const GJKSimplex& simplex) {
+   float scale = 0.f;
+   for (uint32_t i = 0; i < simplex.count; ++i) scale = std::max(scale, simplex.vertex[i].w.lengthSquared());
+   return scale;
+  }
+
+  /**
+   * True when a support with closest . w = reach improves on distSq by too little to go on.
+   * The absolute term keeps small gaps, whose relative step drowns in the rounding of
+   * vertices scale away, from spinning to GJK_MAX_ITERATIONS.
+   */
+  inline bool
+   converged(float distSq, float reach, float scale) {
+   return distSq - reach <= GJK_TOLERANCE * distSq + GJK_ABSOLUTE_TOLERANCE * scale;
+  }
+
+  /**
+   * GJK on the cores of a and b. Leaves the reduced simplex in simplex and its closest point
+   * in closest; false when the cores overlap (closest is then zero).
+   */
+  template<typename ShapeA, typename ShapeB>
+  inline bool
+   gjkCore(const ShapeA& a, const ShapeB& b, GJKCache& cache, GJKSimplex& simplex, CVector3& closest,
+           uint32_t& iterations) {
+   simplex.count = 0;
+   for (uint32_t i = 0; i < cache.count && i < 4; ++i) {
+    const GJKVertex v = gjkSupport(a, b, cache.direction[i]);
+    if (!simplex.contains(v.w)) simplex.add(v);
+   }
+   if (simplex.count == 0) simplex.add(gjkSupport(a, b, CVector3(1.f, 0.f, 0.f)));
+   bool separated = true;
+   iterations = 0;
+   while (iterations < GJK_MAX_ITERATIONS) {
+    ++iterations;
+    if (!simplex.solve(closest)) {
+     separated = false;
+     break;
+    }
+    const float distSq = closest.lengthSquared();
+    const float scale = simplexScale(simplex);
+    if (distSq <= EU::Constants::EPSILON * EU::Constants::EPSILON * scale) {
+     separated = false;
+     break;
+    }
+    const GJKVertex v = gjkSupport(a, b, closest * -1.f);
+    // No vertex of A - B comes closer to the origin than the simplex already does.
+    if (simplex.contains(v.w) || converged(distSq, closest.dot(v.w), std::max(scale, v.w.lengthSquared()))) break;
+    simplex.add(v);
+   }
+   cache.count = simplex.count;
+   for (uint32_t i = 0; i < simplex.count; ++i) cache.direction[i] = simplex.vertex[i].direction;
+   if (!separated) closest = CVector3(0.f, 0.f, 0.f);
+   return separated;
+  }
+
+  /** Closest or deepest points from the core simplex and the margins; false when the cores overlap. */
+  template<typename ShapeA, typename ShapeB>
+  inline bool
+   marginResult(const ShapeA& a, const ShapeB& b, const GJKSimplex& simplex, const CVector3& closest, GJKResult& result) {
+   const float length = closest.length<EU::Precision::Exact>();
+   if (!(length > 0.f)) return false;
+   CVector3 pa, pb;
+   simplex.points(pa, pb);
+   result.normal = closest * (-1.f / length);
+   result.pointA = pa + result.normal * supportMargin(a);
+   result.pointB = pb - result.normal * supportMargin(b);
+   result.distance = length - supportMargin(a) - supportMargin(b);
+   return true;
+  }
+
+  struct EPAFace {
+   uint32_t v[3];
+   CVector3 normal;
+   float distance;
+  };
+
+  struct EPAEdge {
+   uint32_t a;
+   uint32_t b;
+  };
+
+  /**
+   * @class EPAPolytope
+   * @brief Expanding polytope, in arrays on the stack for EPA_STACK_ITERATIONS expansions and
+   * moved to the arena, if there is one, to go further.
+   */
+  class
+   EPAPolytope {
+   public:
+   static constexpr uint32_t STACK_VERTICES = EPA_STACK_ITERATIONS + 4;
+   static constexpr uint32_t STACK_FACES = 2 * STACK_VERTICES - 4;
+
+   GJKVertex* vertices = m_stackVertices;
+   EPAFace* faces = m_stackFaces;
+   EPAEdge* edges = m_stackEdges; ///< Horizon scratch, one per vertex at most
+   uint32_t vertexCount = 0;
+   uint32_t faceCount = 0;
+
+   /** Room for one more expansion; false when the stack is full and there is no arena. */
+   bool
+    reserve(FrameArena* arena, uint32_t maxIterations) {
+    if (vertexCount < m_vertexCapacity) return true;
+    if (arena == nullptr || vertices != m_stackVertices || maxIterations <= EPA_STACK_ITERATIONS) return false;
+    // The closed triangle mesh over V vertices has 2 V - 4 faces; a step keeps to that.
+    const uint32_t v = maxIterations + 4, f = 2 * v - 4;
+    GJKVertex* nv = arena->allocateArray<GJKVertex>(v);
+    EPAFace* nf = arena->allocateArray<EPAFace>(f);
+    EPAEdge* ne = arena->allocateArray<EPAEdge>(v);
+    std::memcpy(nv, vertices, vertexCount * sizeof(GJKVertex));
+    std::memcpy(nf, faces, faceCount * sizeof(EPAFace));
+    vertices = nv;
+    faces = nf;
+    edges = ne;
+    m_vertexCapacity = v;
+    m_faceCapacity = f;
+    return true;
+   }
+
+   uint32_t
+    faceCapacity() const {
+    return m_faceCapacity;
+   }
+
+   /** Room in edges, which holds up to one horizon edge per vertex. */
+   uint32_t
+    edgeCapacity() const {
+    return m_vertexCapacity;
+   }
+
+   /** Adds face (i, j, k), counter-clockwise seen from outside; the caller has checked faceCapacity(). */
+   void
+    addFace(uint32_t i, uint32_t j, uint32_t k) {
+    EPAFace& f = faces[faceCount++];
+    f.v[0] = i;
+    f.v[1] = j;
+    f.v[2] = k;
+    const CVector3& a = vertices[i].w;
+    f.normal = (vertices[j].w - a).cross(vertices[k].w - a).normalized<EU::Precision::Exact>();
+    // A sliver has no normal to expand along; it is never the closest face.
+    f.distance = f.normal.lengthSquared() > 0.f ? f.normal.dot(a) : EU::Constants::INF;
+   }
+
+   private:
+   GJKVertex m_stackVertices[STACK_VERTICES];
+   EPAFace m_stackFaces[STACK_FACES];
+   EPAEdge m_stackEdges[STACK_VERTICES];
+   uint32_t m_vertexCapacity = STACK_VERTICES;
+   uint32_t m_faceCapacity = STACK_FACES;
+  };
+
+  /**
+   * Grows the overlapping core simplex into a tetrahedron of the full shapes around the
+   * origin; false when A - B is flat or the origin is on its surface.
+   */
+  template<typename ShapeA, typename ShapeB>
+  inline bool
+   epaSeed(const ShapeA& a, const ShapeB& b, const GJKSimplex& simplex, EPAPolytope& poly) {
+   for (uint32_t i = 0; i < simplex.count; ++i) poly.vertices[poly.vertexCount++] = simplex.vertex[i];
+   const CVector3 axes[6] = { CVector3(1.f, 0.f, 0.f), CVector3(-1.f, 0.f, 0.f), CVector3(0.f, 1.f, 0.f),
+                              CVector3(0.f, -1.f, 0.f), CVector3(0.f, 0.f, 1.f), CVector3(0.f, 0.f, -1.f) };
+   float scale = 0.f;
+   for (const CVector3& d : axes) scale = std::max(scale, epaSupport(a, b, d).w.lengthSquared());
+   const float tolSq = EU::Constants::EPSILON * EU::Constants::EPSILON * scale;
+   while (poly.vertexCount < 4) {
+    const GJKVertex* v = poly.vertices;
+    CVector3 candidates[8];
+    int n = 0;
+    if (poly.vertexCount == 3) {
+     const CVector3 normal = (v[1].w - v[0].w).cross(v[2].w - v[0].w).normalized<EU::Precision::Exact>();
+     candidates[n++] = normal;
+     candidates[n++] = normal * -1.f;
+    }
+    for (const CVector3& d : axes) candidates[n++] = d;
+    bool grown = false;
+    for (int c = 0; c < n && !grown; ++c) {
+     const GJKVertex s = epaSupport(a, b, candidates[c]);
+     float spread = 0.f;
+     if (poly.vertexCount == 0) spread = EU::Constants::INF;
+     else if (poly.vertexCount == 1) spread = (s.w - v[0].w).lengthSquared();
+     else if (poly.vertexCount == 2) spread = (v[1].w - v[0].w).cross(s.w - v[0].w).lengthSquared() / std::max((v[1].w - v[0].w).lengthSquared(), tolSq);
+     else {
+      const float h = (v[1].w - v[0].w).cross(v[2].w - v[0].w).normalized<EU::Precision::Exact>().dot(s.w - v[0].w);
+      spread = h * h;
+     }
+     if (spread > tolSq) {
+      poly.vertices[poly.vertexCount++] = s;
+      grown = true;
+     }
+    }
+    if (!grown) return false;
+   }
+   // The axes and the core simplex need not surround the origin. While a face has it in
+   // front, that face is kept and the vertex behind swapped for the support past it, as in
+   // GJK; the expansion would otherwise start from faces at negative distance.
+   static constexpr uint32_t OPPOSITE[4] = { 3, 2, 0, 1 };
+   const float tol = EU::Constants::EPSILON * std::sqrt(scale);
+   GJKVertex* v = poly.vertices;
+   for (uint32_t step = 0;; ++step) {
+    if ((v[1].w - v[0].w).cross(v[2].w - v[0].w).dot(v[3].w - v[0].w) > 0.f) std::swap(v[1], v[2]);
+    // (0, 1, 2) now faces away from 3; every side takes a base edge reversed.
+    poly.faceCount = 0;
+    poly.addFace(0, 1, 2);
+    poly.addFace(1, 0, 3);
+    poly.addFace(2, 1, 3);
+    poly.addFace(0, 2, 3);
+    uint32_t front = 0;
+    for (uint32_t f = 1; f < 4; ++f) {
+     if (poly.faces[f].distance < poly.faces[front].distance) front = f;
+    }
+    const EPAFace& face = poly.faces[front];
+    if (face.distance >= -tol) return true;
+    if (step == GJK_MAX_ITERATIONS) return false;
+    const GJKVertex s = epaSupport(a, b, face.normal);
+    if (face.normal.dot(s.w) - face.distance <= tol) return false;
+    v[OPPOSITE[front]] = s;
+   }
+  }
+
+  /** Barycentric weights of point p on the plane of triangle (a, b, c). */
+  inline void
+   planeWeights(const CVector3& a, const CVector3& b, const CVector3& c, const CVector3& p, float (&weight)[3]) {
+   const CVector3 v0 = b - a, v1 = c - a, v2 = p - a;
+   const float d00 = v0.dot(v0), d01 = v0.dot(v1), d11 = v1.dot(v1), d20 = v2.dot(v0), d21 = v2.dot(v1);
+   const float denom = d00 * d11 - d01 * d01;
+   if (!(denom > 0.f)) {
+    weight[0] = 1.f;
+    weight[1] = weight[2] = 0.f;
+    return;
+   }
+   weight[1] = (d11 * d20 - d01 * d21) / denom;
+   weight[2] = (d00 * d21 - d01 * d20) / denom;
+   weight[0] = 1.f - weight[1] - weight[2];
+  }
+ }
+
+ /**
+  * @brief True when a and b overlap, margins included; stops at the first separating
+  * direction, so it is cheaper than gjkDistance().
+  */
+ template<typename ShapeA, typename ShapeB>
+ inline bool
+  gjkIntersects(const ShapeA& a, const ShapeB& b, GJKCache& cache) {
+  detail::GJKSimplex simplex;
+  CVector3 closest;
+  const float margin = supportMargin(a) + supportMargin(b);
+  simplex.count = 0;
+  for (uint32_t i = 0; i < cache.count && i < 4; ++i) {
+   const detail::GJKVertex v = detail::gjkSupport(a, b, cache.direction[i]);
+   if (!simplex.contains(v.w)) simplex.add(v);
+  }
+  if (simplex.count == 0) simplex.add(detail::gjkSupport(a, b, CVector3(1.f, 0.f, 0.f)));
+  bool overlap = true;
+  float distSq = 0.f;
+  for (uint32_t iteration = 0; iteration < GJK_MAX_ITERATIONS; ++iteration) {
+   if (!simplex.solve(closest)) {
+    distSq = 0.f;
+    break;
+   }
+   distSq = closest.lengthSquared();
+   if (distSq <= margin * margin) break;
+   const detail::GJKVertex v = detail::gjkSupport(a, b, closest * -1.f);
+   // A plane through v normal to closest has all of A - B behind it; separated if that
+   // leaves the origin (or, with margins, a ball of their sum around it) in front.
+   const float reach = -closest.dot(v.w);
+   if (reach < 0.f && reach * reach > margin * margin * distSq) {
+    overlap = false;
+    break;
+   }
+   if (simplex.contains(v.w) ||
+       detail::converged(distSq, closest.dot(v.w), std::max(detail::simplexScale(simplex), v.w.lengthSquared())))
+    break;
+   simplex.add(v);
+  }
+  // Converged or out of steps, the simplex still holds a point of A - B as close as distSq.
+  if (overlap) overlap = distSq <= margin * margin;
+  cache.count = simplex.count;
+  for (uint32_t i = 0; i < simplex.count; ++i) cache.direction[i] = simplex.vertex[i].direction;
+  return overlap;
+ }
+
+ /**
+  * @brief Distance between a and b with their closest points.
+  * @return True when they are apart (result.distance > 0). When they overlap, result is
+  * filled as by epaPenetration() if only the margins overlap; if the cores do, only
+  * result.distance is set, to 0.
+  */
+ template<typename ShapeA, typename ShapeB>
+ inline bool
+  gjkDistance(const ShapeA& a, const ShapeB& b, GJKCache& cache, GJKResult& result) {
+  detail::GJKSimplex simplex;
+  CVector3 closest;
+  detail::gjkCore(a, b, cache, simplex, closest, result.iterations);
+  if (!detail::marginResult(a, b, simplex, closest, result)) {
+   result.distance = 0.f;
+   return false;
+  }
+  return result.distance > 0.f;
+ }
+
+ /**
+  * @brief Penetration depth of a and b, with the deepest points and the direction that
+  * separates them fastest; GJK first, then EPA when the cores overlap.
+  * @param arena Memory for EPA beyond EPA_STACK_ITERATIONS expansions; may be null.
+  * @return True when they overlap: result.distance is minus the depth. Otherwise result
+  * holds the closest points as from gjkDistance().
+  */
+ template<typename ShapeA, typename ShapeB>
+ inline bool
+  epaPenetration(const ShapeA& a, const ShapeB& b, GJKCache& cache, GJKResult& result, FrameArena* arena = nullptr,
+                 uint32_t maxIterations = EPA_MAX_ITERATIONS) {
+  detail::GJKSimplex simplex;
+  CVector3 closest;
+  detail::gjkCore(a, b, cache, simplex, closest, result.iterations);
+  if (detail::marginResult(a, b, simplex, closest, result)) return result.distance <= 0.f;
+  detail::EPAPolytope poly;
+  if (!detail::epaSeed(a, b, simplex, poly)) {
+   // A - B is flat: the shapes just touch.
+   CVector3 pa, pb;
+   simplex.points(pa, pb);
+   result.pointA = pa;
+   result.pointB = pb;
+   result.normal = CVector3(0.f, 0.f, 0.f);
+   result.distance = 0.f;
+   return true;
+  }
+  const auto closestFace = [&poly]() {
+   uint32_t closest = 0;
+   for (uint32_t f = 1; f < poly.faceCount; ++f) {
+    if (poly.faces[f].distance < poly.faces[closest].distance) closest = f;
+   }
+   return closest;
+  };
+  for (uint32_t iteration = 0; iteration < maxIterations; ++iteration) {
+   const detail::EPAFace face = poly.faces[closestFace()];
+   const detail::GJKVertex v = detail::epaSupport(a, b, face.normal);
+   const float gain = face.normal.dot(v.w) - face.distance;
+   if (gain <= EPA_TOLERANCE * std::max(face.distance, EU::Constants::EPSILON)) break;
+   if (!poly.reserve(arena, maxIterations)) break;
+   // Faces v sees go to the back, and their edges not shared between two of them form the
+   // horizon. Rounding can make that more than the arrays hold; the polytope is then left
+   // as it was and its best face reported.
+   uint32_t kept = 0;
+   for (uint32_t f = 0; f < poly.faceCount; ++f) {
+    const detail::EPAFace& seen = poly.faces[f];
+    if (seen.normal.dot(v.w - poly.vertices[seen.v[0]].w) <= 0.f) std::swap(poly.faces[kept++], poly.faces[f]);
+   }
+   uint32_t edgeCount = 0;
+   bool fits = true;
+   for (uint32_t f = kept; f < poly.faceCount && fits; ++f) {
+    const detail::EPAFace& seen = poly.faces[f];
+    for (int e = 0; e < 3; ++e) {
+     const uint32_t ea = seen.v[e], eb = seen.v[(e + 1) % 3];
+     uint32_t k = 0;
+     while (k < edgeCount && !(poly.edges[k].a == eb && poly.edges[k].b == ea)) ++k;
+     if (k < edgeCount) poly.edges[k] = poly.edges[--edgeCount];
+     else if (edgeCount < poly.edgeCapacity()) poly.edges[edgeCount++] = detail::EPAEdge{ ea, eb };
+     else fits = false;
+    }
+   }
+   if (!fits || kept == poly.faceCount || kept + edgeCount > poly.faceCapacity()) break;
+   ++result.iterations;
+   const uint32_t index = poly.vertexCount++;
+   poly.vertices[index] = v;
+   poly.faceCount = kept;
+   for (uint32_t k = 0; k < edgeCount; ++k) poly.addFace(poly.edges[k].a, poly.edges[k].b, index);
+  }
+  // Out of iterations, the last expansion has replaced the face it started from.
+  const detail::EPAFace& face = poly.faces[closestFace()];
+  const detail::GJKVertex* v = poly.vertices;
+  float w[3];
+  detail::planeWeights(v[face.v[0]].w, v[face.v[1]].w, v[face.v[2]].w, face.normal * face.distance, w);
+  result.pointA = v[face.v[0]].a * w[0] + v[face.v[1]].a * w[1] + v[face.v[2]].a * w[2];
+  result.pointB = v[face.v[0]].b * w[0] + v[face.v[1]].b * w[1] + v[face.v[2]].b * w[2];
+  result.normal = face.normal;
+  result.distance = -face.distance;
+  return true;
+ }
+
+ /**
+  * @class GJKPairCache
+  * @brief GJKCache per pair of ids, e.g. the pairs of a broadphase, sorted by pair.
+  */
+ class
+  GJKPairCache {
+  public:
+  /** @brief Cache of pair (a, b), in either order; a cold one the first time. */
+  GJKCache&
+   get(uint32_t a, uint32_t b) {
+   const uint64_t k = key(a, b);
+   auto it = std::lower_bound(m_entries.begin(), m_entries.end(), k,
+                              [](const Entry& e, uint64_t value) { return e.first < value; });
+   if (it == m_entries.end() || it->first != k) it = m_entries.insert(it, Entry(k, GJKCache{}));
+   return it->second;
+  }
+
+  void
+   erase(uint32_t a, uint32_t b) {
+   const uint64_t k = key(a, b);
+   auto it = std::lower_bound(m_entries.begin(), m_entries.end(), k,
+                              [](const Entry& e, uint64_t value) { return e.first < value; });
+   if (it != m_entries.end() && it->first == k) m_entries.erase(it);
+  }
+
+  /** @brief Drops the caches of pairs, e.g. the ones a broadphase reports removed, in one pass. */
+  void
+   erase(const std::vector<std::pair<uint32_t, uint32_t>>& pairs) {
+   std::vector<uint64_t> keys;
+   keys.reserve(pairs.size());
+   for (const std::pair<uint32_t, uint32_t>& p : pairs) keys.push_back(key(p.first, p.second));
+   std::sort(keys.begin(), keys.end());
+   m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+                                  [&keys](const Entry& e) { return std::binary_search(keys.begin(), keys.end(), e.first); }),
+                   m_entries.end());
+  }
+
+  void
+   clear() {
+   m_entries.clear();
+  }
+
+  size_t
+   size() const {
+   return m_entries.size();
+  }
+
+  private:
+  using Entry = std::pair<uint64_t, GJKCache>;
+
+  static uint64_t
+   key(uint32_t a, uint32_t b) {
+   return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+  }
+
+  std::vector<Entry> m_entries;
+ };
+}
@@ -0,0 +1,630 @@
+/**
+ * @file GridRaycast.h
+ * @brief Amanatides-Woo grid traversal for 2D tile maps and 3D voxel grids: step iterators,
+ * occupancy grids with ray casts, batch casts over threads and a brick map for empty space.
+ *
+ * GridWalk2D and GridWalk3D visit, in order, every cell a ray passes through between tMin and
+ * tMax. Each step adds one precomputed delta to the t of the next boundary on the axis whose
+ * boundary comes first, so the walk never accumulates the position error of float stepping
+ * and no cell is skipped at any angle. They are plain iterators without callbacks, so the
+ * caller's test sits in the loop body and inlines:
+ *
+ *   for (GridWalk2D walk(from, to - from, 0.f, 1.f, 16.f); walk.valid(); walk.next()) {
+ *    if (tiles.blocked(walk.x(), walk.y())) return false;   // line of sight broken
+ *   }
+ *
+ * t() is where the ray enters the current cell, exitT() where it leaves, and axis() / normal()
+ * give the face it came in through (none for the first cell). A ray through a corner steps
+ * one axis at a time and visits one of the cells beside the corner as well. Rays are not
+ * normalized: t measures multiples of direction, as with Ray.
+ *
+ * OccupancyGrid2D and OccupancyGrid3D store one solid byte per cell over [0, size * cellSize)
+ * from the origin, clip each ray to that box and walk it to the first solid cell. The 3D grid
+ * also counts the solid voxels of every VOXEL_BRICK^3 brick; cast() walks the bricks first and
+ * runs the voxel walk only inside bricks that hold something, so open space costs one step
+ * per brick instead of VOXEL_BRICK. castFlat() walks voxels only, for dense grids.
+ *
+ * castBatch() splits the rays into fixed GRID_RAY_CHUNK-sized chunks over threads (0 =
+ * hardware_concurrency(), 1 = caller only); results do not depend on the thread count. The
+ * grid must not change while a cast runs.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Constants.h>
+#include <Core/Parallel.h>
+#include <Core/Trace.h>
+#include <Geometry/Primitives.h>
+#include <Math/EngineMath.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /// Log2 of the side of one OccupancyGrid3D brick, in voxels.
+ constexpr int VOXEL_BRICK_SHIFT = 3;
+ /// Side of one OccupancyGrid3D brick, in voxels.
+ constexpr int32_t VOXEL_BRICK = int32_t(1) << VOXEL_BRICK_SHIFT;
+
+ namespace detail {
+  /// Rays per castBatch() task; fixes the work split.
+  constexpr size_t GRID_RAY_CHUNK = 256;
+
+  /** Step, first boundary t and boundary spacing along one axis for a walk from cell. */
+  inline void
+   gridAxis(float origin, float direction, float tMin, float cellSize, int32_t cell, int32_t& step, float& next,
+            float& delta) {
+   if (direction > 0.f) {
+    step = 1;
+    delta = cellSize / direction;
+    next = (static_cast<float>(cell + 1) * cellSize - origin) / direction;
+   }
+   else if (direction < 0.f) {
+    step = -1;
+    delta = -cellSize / direction;
+    next = (static_cast<float>(cell) * cellSize - origin) / direction;
+   }
+   else {
+    step = 0;
+    delta = Constants::INF;
+    next = Constants::INF;
+   }
+   next = std::max(next, tMin);
+  }
+
+  /** Cell of the point origin + direction * t along one axis. */
+  inline int32_t
+   gridCell(float origin, float direction, float t, float cellSize) {
+   return static_cast<int32_t>(EngineMath::floor((origin + direction * t) / cellSize));
+  }
+
+  /**
+   * Clips [tMin, tMax] of a ray to the box [0, extent) on n axes. axis receives the axis
+   * whose face the clipped ray enters through, -1 when it starts inside.
+   */
+  inline bool
+   gridClip(const float* origin, const float* direction, const float* extent, int n, float& tMin, float& tMax,
+            int& axis) {
+   axis = -1;
+   for (int a = 0; a < n; ++a) {
+    if (direction[a] == 0.f) {
+     if (origin[a] < 0.f || origin[a] >= extent[a]) return false;
+     continue;
+    }
+    const float inv = 1.f / direction[a];
+    float t0 = -origin[a] * inv, t1 = (extent[a] - origin[a]) * inv;
+    if (t0 > t1) std::swap(t0, t1);
+    if (t0 > tMin) {
+     tMin = t0;
+     axis = a;
+    }
+    tMax = std::min(tMax, t1);
+   }
+   return tMin <= tMax;
+  }
+
+  /** Calls castOne(ray) for every GRID_RAY_CHUNK-sized chunk of [0, count) over threads. */
+  template<typename Fn>
+  inline void
+   gridCastChunks(size_t count, size_t threads, Fn castOne) {
+   const size_t chunks = (count + GRID_RAY_CHUNK - 1) / GRID_RAY_CHUNK;
+   parallelTasks(chunks, resolveThreads(threads, chunks), [&](size_t c) {
+    const size_t end = std::min(count, (c + 1) * GRID_RAY_CHUNK);
+    for (size_t i = c * GRID_RAY_CHUNK; i < end; ++i) castOne(i);
+   });
+  }
+ }
+
+ /**
+  * @class GridWalk2D
+  * @brief The square cells of side cellSize a 2D ray crosses between tMin and tMax, in order.
+  */
+ class
+  GridWalk2D {
+  public:
+  GridWalk2D(const CVector2& origin, const CVector2& direction, float tMin, float tMax, float cellSize = 1.f)
+   : GridWalk2D(origin, direction, tMin, tMax, cellSize, detail::gridCell(origin.x, direction.x, tMin, cellSize),
+                detail::gridCell(origin.y, direction.y, tMin, cellSize)) {}
+
+  /**
+   * @brief Walk starting from cell (x, y), which should contain origin + direction * tMin;
+   * lets a caller that clamps the first cell keep the float rounding of a boundary in check.
+   */
+  GridWalk2D(const CVector2& origin, const CVector2& direction, float tMin, float tMax, float cellSize, int32_t x,
+             int32_t y)
+   : m_t(tMin), m_end(tMax) {
+   m_cell[0] = x;
+   m_cell[1] = y;
+   detail::gridAxis(origin.x, direction.x, tMin, cellSize, x, m_step[0], m_next[0], m_delta[0]);
+   detail::gridAxis(origin.y, direction.y, tMin, cellSize, y, m_step[1], m_next[1], m_delta[1]);
+  }
+
+  /** @brief True while the current cell starts within [tMin, tMax]. */
+  bool
+   valid() const {
+   return m_t <= m_end;
+  }
+
+  /** @brief Moves to the next cell along the ray. */
+  void
+   next() {
+   const int a = m_next[1] < m_next[0] ? 1 : 0;
+   m_t = m_next[a];
+   m_cell[a] += m_step[a];
+   m_next[a] += m_delta[a];
+   m_axis = a;
+  }
+
+  int32_t
+   x() const {
+   return m_cell[0];
+  }
+
+  int32_t
+   y() const {
+   return m_cell[1];
+  }
+
+  /** @brief t where the ray enters the current cell (tMin for the first). */
+  float
+   t() const {
+   return m_t;
+  }
+
+  /** @brief t where the ray leaves the current cell, at most tMax. */
+  float
+   exitT() const {
+   return std::min(std::min(m_next[0], m_next[1]), m_end);
+  }
+
+  /** @brief Axis (0 = x, 1 = y) of the face the ray entered the current cell through; -1 for the first. */
+  int
+   axis() const {
+   return m_axis;
+  }
+
+  /** @brief Outward unit normal of that face; zero for the first cell. */
+  CVector2
+   normal() const {
+   if (m_axis < 0) return CVector2(0.f, 0.f);
+   const float n = -static_cast<float>(m_step[m_axis]);
+   return m_axis == 0 ? CVector2(n, 0.f) : CVector2(0.f, n);
+  }
+
+  private:
+  int32_t m_cell[2];
+  int32_t m_step[2];
+  float m_next[2];  ///< t of the next boundary per axis
+  float m_delta[2]; ///< t between boundaries per axis
+  float m_t;
+  float m_end;
+  int m_axis = -1;
+ };
+
+ /**
+  * @class GridWalk3D
+  * @brief The cubic cells of side cellSize a ray crosses between tMin and tMax, in order.
+  */
+ class
+  GridWalk3D {
+  public:
+  GridWalk3D(const CVector3& origin, const CVector3& direction, float tMin, float tMax, float cellSize = 1.f)
+   : GridWalk3D(origin, direction, tMin, tMax, cellSize, detail::gridCell(origin.x, direction.x, tMin, cellSize),
+                detail::gridCell(origin.y, direction.y, tMin, cellSize),
+                detail::gridCell(origin.z, direction.z, tMin, cellSize)) {}
+
+  /** @brief Walk starting from cell (x, y, z), as GridWalk2D's. */
+  GridWalk3D(const CVector3& origin, const CVector3& direction, float tMin, float tMax, float cellSize, int32_t x,
+             int32_t y, int32_t z)
+   : m_t(tMin), m_end(tMax) {
+   m_cell[0] = x;
+   m_cell[1] = y;
+   m_cell[2] = z;
+   detail::gridAxis(origin.x, direction.x, tMin, cellSize, x, m_step[0], m_next[0], m_delta[0]);
+   detail::gridAxis(origin.y, direction.y, tMin, cellSize, y, m_step[1], m_next[1], m_delta[1]);
+   detail::gridAxis(origin.z, direction.z, tMin, cellSize, z, m_step[2], m_next[2], m_delta[2]);
+  }
+
+  GridWalk3D(const Ray& ray, float tMin, float tMax, float cellSize = 1.f)
+   : GridWalk3D(ray.origin, ray.direction, tMin, tMax, cellSize) {}
+
+  bool
+   valid() const {
+   return m_t <= m_end;
+  }
+
+  void
+   next() {
+   int a = m_next[1] < m_next[0] ? 1 : 0;
+   a = m_next[2] < m_next[a] ? 2 : a;
+   m_t = m_next[a];
+   m_cell[a] += m_step[a];
+   m_next[a] += m_delta[a];
+   m_axis = a;
+  }
+
+  int32_t
+   x() const {
+   return m_cell[0];
+  }
+
+  int32_t
+   y() const {
+   return m_cell[1];
+  }
+
+  int32_t
+   z() const {
+   return m_cell[2];
+  }
+
+  float
+   t() const {
+   return m_t;
+  }
+
+  float
+   exitT() const {
+   return std::min(std::min(std::min(m_next[0], m_next[1]), m_next[2]), m_end);
+  }
+
+  /** @brief Axis (0 = x, 1 = y, 2 = z) of the entry face of the current cell; -1 for the first. */
+  int
+   axis() const {
+   return m_axis;
+  }
+
+  CVector3
+   normal() const {
+   return faceNormal(m_axis, m_axis < 0 ? 0 : m_step[m_axis]);
+  }
+
+  /** @brief Unit normal facing against step on axis; zero for axis -1. */
+  static CVector3
+   faceNormal(int axis, int32_t step) {
+   const float n = -static_cast<float>(step);
+   return CVector3(axis == 0 ? n : 0.f, axis == 1 ? n : 0.f, axis == 2 ? n : 0.f);
+  }
+
+  private:
+  int32_t m_cell[3];
+  int32_t m_step[3];
+  float m_next[3];
+  float m_delta[3];
+  float m_t;
+  float m_end;
+  int m_axis = -1;
+ };
+
+ /**
+  * @struct GridHit2D
+  * @brief First solid cell along a ray; hit is false and the rest unspecified on a miss.
+  */
+ struct GridHit2D {
+  int32_t x = -1;
+  int32_t y = -1;
+  float t = Constants::INF; ///< Where the ray enters the cell
+  CVector2 normal;          ///< Entry face; zero when the ray starts inside the cell
+  bool hit = false;
+ };
+
+ /**
+  * @struct GridHit3D
+  * @brief GridHit2D for voxels.
+  */
+ struct GridHit3D {
+  int32_t x = -1;
+  int32_t y = -1;
+  int32_t z = -1;
+  float t = Constants::INF;
+  CVector3 normal;
+  bool hit = false;
+ };
+
+ /**
+  * @class OccupancyGrid2D
+  * @brief Solid or empty tiles over [0, width * cellSize) x [0, height * cellSize), row-major.
+  */
+ class
+  OccupancyGrid2D {
+  public:
+  explicit OccupancyGrid2D(int32_t width = 0, int32_t height = 0, float cellSize = 1.f)
+   : m_cells(static_cast<size_t>(std::max(width, 0)) * static_cast<size_t>(std::max(height, 0)), 0),
+     m_width(std::max(width, 0)), m_height(std::max(height, 0)), m_cellSize(cellSize) {}
+
+  int32_t
+   width() const {
+   return m_width;
+  }
+
+  int32_t
+   height() const {
+   return m_height;
+  }
+
+  float
+   cellSize() const {
+   return m_cellSize;
+  }
+
+  /** @brief Whether tile (x, y) is solid; tiles outside the grid are empty. */
+  bool
+   solid(int32_t x, int32_t y) const {
+   return inside(x, y) && m_cells[index(x, y)] != 0;
+  }
+
+  void
+   set(int32_t x, int32_t y, bool solid) {
+   if (inside(x, y)) m_cells[index(x, y)] = solid ? 1 : 0;
+  }
+
+  /** @brief Row-major solid bytes (non-zero = solid), for bulk loading a tile map. */
+  uint8_t*
+   data() {
+   return m_cells.data();
+  }
+
+  const uint8_t*
+   data() const {
+   return m_cells.data();
+  }
+
+  /**
+   * @brief First solid tile along origin + t * direction for t in [0, tMax].
+   * @return hit.hit.
+   */
+  bool
+   cast(const CVector2& origin, const CVector2& direction, float tMax, GridHit2D& hit) const {
+   hit = GridHit2D();
+   const float o[2] = { origin.x, origin.y }, d[2] = { direction.x, direction.y };
+   const float extent[2] = { static_cast<float>(m_width) * m_cellSize, static_cast<float>(m_height) * m_cellSize };
+   float t0 = 0.f, t1 = tMax;
+   int entry;
+   if (!detail::gridClip(o, d, extent, 2, t0, t1, entry)) return false;
+   const int32_t x = std::min(std::max(detail::gridCell(o[0], d[0], t0, m_cellSize), 0), m_width - 1);
+   const int32_t y = std::min(std::max(detail::gridCell(o[1], d[1], t0, m_cellSize), 0), m_height - 1);
+   for (GridWalk2D walk(origin, direction, t0, t1, m_cellSize, x, y); walk.valid(); walk.next()) {
+    if (!inside(walk.x(), walk.y())) break;
+    if (m_cells[index(walk.x(), walk.y())] == 0) continue;
+    hit.x = walk.x();
+    hit.y = walk.y();
+    hit.t = walk.t();
+    hit.normal = walk.normal();
+    if (walk.axis() < 0 && entry >= 0) {
+     const float n = d[entry] > 0.f ? -1.f : 1.f;
+     hit.normal = entry == 0 ? CVector2(n, 0.f) : CVector2(0.f, n);
+    }
+    hit.hit = true;
+    return true;
+   }
+   return false;
+  }
+
+  /** @brief True when no solid tile lies on the segment from from to to. */
+  bool
+   lineOfSight(const CVector2& from, const CVector2& to) const {
+   GridHit2D hit;
+   return !cast(from, to - from, 1.f, hit);
+  }
+
+  /** @brief cast() of ray i (origins[i], directions[i]) into hits[i] for i in [0, count). */
+  void
+   castBatch(const CVector2* origins, const CVector2* directions, size_t count, float tMax, GridHit2D* hits,
+             size_t threads = 0) const {
+   EU_TRACE_ZONE("OccupancyGrid2D::castBatch");
+   detail::gridCastChunks(count, threads, [&](size_t i) { cast(origins[i], directions[i], tMax, hits[i]); });
+  }
+
+  private:
+  bool
+   inside(int32_t x, int32_t y) const {
+   return static_cast<uint32_t>(x) < static_cast<uint32_t>(m_width) && static_cast<uint32_t>(y) < static_cast<uint32_t>(m_height);
+  }
+
+  size_t
+   index(int32_t x, int32_t y) const {
+   return static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x);
+  }
+
+  std::vector<uint8_t> m_cells;
+  int32_t m_width;
+  int32_t m_height;
+  float m_cellSize;
+ };
+
+ /**
+  * @class OccupancyGrid3D
+  * @brief Solid or empty voxels over [0, size * cellSize) on each axis, x fastest, with a
+  * count of solid voxels per VOXEL_BRICK^3 brick kept up to date by set().
+  */
+ class
+  OccupancyGrid3D {
+  public:
+  explicit OccupancyGrid3D(int32_t width = 0, int32_t height = 0, int32_t depth = 0, float cellSize = 1.f)
+   : m_cellSize(cellSize) {
+   m_size[0] = std::max(width, 0);
+   m_size[1] = std::max(height, 0);
+   m_size[2] = std::max(depth, 0);
+   for (int a = 0; a < 3; ++a) m_bricks[a] = (m_size[a] + VOXEL_BRICK - 1) >> VOXEL_BRICK_SHIFT;
+   m_voxels.assign(static_cast<size_t>(m_size[0]) * static_cast<size_t>(m_size[1]) * static_cast<size_t>(m_size[2]), 0);
+   m_counts.assign(static_cast<size_t>(m_bricks[0]) * static_cast<size_t>(m_bricks[1]) * static_cast<size_t>(m_bricks[2]), 0);
+  }
+
+  int32_t
+   width() const {
+   return m_size[0];
+  }
+
+  int32_t
+   height() const {
+   return m_size[1];
+  }
+
+  int32_t
+   depth() const {
+   return m_size[2];
+  }
+
+  float
+   cellSize() const {
+   return m_cellSize;
+  }
+
+  /** @brief Whether voxel (x, y, z) is solid; voxels outside the grid are empty. */
+  bool
+   solid(int32_t x, int32_t y, int32_t z) const {
+   return inside(x, y, z) && m_voxels[index(x, y, z)] != 0;
+  }
+
+  void
+   set(int32_t x, int32_t y, int32_t z, bool solid) {
+   if (!inside(x, y, z)) return;
+   uint8_t& voxel = m_voxels[index(x, y, z)];
+   const uint8_t value = solid ? 1 : 0;
+   if (voxel == value) return;
+   voxel = value;
+   uint16_t& count = m_counts[brickIndex(x >> VOXEL_BRICK_SHIFT, y >> VOXEL_BRICK_SHIFT, z >> VOXEL_BRICK_SHIFT)];
+   count = static_cast<uint16_t>(solid ? count + 1 : count - 1);
+  }
+
+  /** @brief Solid voxels in brick (bx, by, bz); 0 outside the grid. */
+  uint32_t
+   brickCount(int32_t bx, int32_t by, int32_t bz) const {
+   return insideBricks(bx, by, bz) ? m_counts[brickIndex(bx, by, bz)] : 0;
+  }
+
+  /**
+   * @brief First solid voxel along ray for t in [0, tMax], skipping empty bricks.
+   * @return hit.hit.
+   */
+  bool
+   cast(const Ray& ray, float tMax, GridHit3D& hit) const {
+   hit = GridHit3D();
+   float t0, t1;
+   int entry;
+   if (!clip(ray, tMax, t0, t1, entry)) return false;
+   const float brickSize = m_cellSize * static_cast<float>(VOXEL_BRICK);
+   int32_t b[3];
+   startCell(ray, t0, brickSize, m_bricks, b);
+   for (GridWalk3D bricks(ray.origin, ray.direction, t0, t1, brickSize, b[0], b[1], b[2]); bricks.valid(); bricks.next()) {
+    if (!insideBricks(bricks.x(), bricks.y(), bricks.z())) break;
+    if (m_counts[brickIndex(bricks.x(), bricks.y(), bricks.z())] == 0) continue;
+    const int32_t lo[3] = { bricks.x() << VOXEL_BRICK_SHIFT, bricks.y() << VOXEL_BRICK_SHIFT, bricks.z() << VOXEL_BRICK_SHIFT };
+    int32_t hi[3], v[3];
+    for (int a = 0; a < 3; ++a) hi[a] = std::min(lo[a] + VOXEL_BRICK, m_size[a]);
+    const float enter = bricks.t();
+    startCell(ray, enter, m_cellSize, hi, v);
+    for (int a = 0; a < 3; ++a) v[a] = std::max(v[a], lo[a]);
+    for (GridWalk3D voxels(ray.origin, ray.direction, enter, bricks.exitT(), m_cellSize, v[0], v[1], v[2]); voxels.valid();
+         voxels.next()) {
+     if (static_cast<uint32_t>(voxels.x() - lo[0]) >= static_cast<uint32_t>(hi[0] - lo[0])
+         || static_cast<uint32_t>(voxels.y() - lo[1]) >= static_cast<uint32_t>(hi[1] - lo[1])
+         || static_cast<uint32_t>(voxels.z() - lo[2]) >= static_cast<uint32_t>(hi[2] - lo[2])) {
+      break;
+     }
+     if (m_voxels[index(voxels.x(), voxels.y(), voxels.z())] == 0) continue;
+     const int axis = voxels.axis() >= 0 ? voxels.axis() : bricks.axis() >= 0 ? bricks.axis() : entry;
+     report(ray, voxels.x(), voxels.y(), voxels.z(), voxels.t(), axis, hit);
+     return true;
+    }
+   }
+   return false;
+  }
+
+  /** @brief cast() without the brick level: one step per voxel. */
+  bool
+   castFlat(const Ray& ray, float tMax, GridHit3D& hit) const {
+   hit = GridHit3D();
+   float t0, t1;
+   int entry;
+   if (!clip(ray, tMax, t0, t1, entry)) return false;
+   int32_t v[3];
+   startCell(ray, t0, m_cellSize, m_size, v);
+   for (GridWalk3D voxels(ray.origin, ray.direction, t0, t1, m_cellSize, v[0], v[1], v[2]); voxels.valid(); voxels.next()) {
+    if (!inside(voxels.x(), voxels.y(), voxels.z())) break;
+    if (m_voxels[index(voxels.x(), voxels.y(), voxels.z())] == 0) continue;
+    report(ray, voxels.x(), voxels.y(), voxels.z(), voxels.t(), voxels.axis() >= 0 ? voxels.axis() : entry, hit);
+    return true;
+   }
+   return false;
+  }
+
+  /** @brief True when no solid voxel lies on the segment from from to to. */
+  bool
+   lineOfSight(const CVector3& from, const CVector3& to) const {
+   GridHit3D hit;
+   return !cast(Ray::fromPoints(from, to), 1.f, hit);
+  }
+
+  /** @brief cast() of rays[i] into hits[i] for i in [0, count). */
+  void
+   castBatch(const Ray* rays, size_t count, float tMax, GridHit3D* hits, size_t threads = 0) const {
+   EU_TRACE_ZONE("OccupancyGrid3D::castBatch");
+   detail::gridCastChunks(count, threads, [&](size_t i) { cast(rays[i], tMax, hits[i]); });
+  }
+
+  private:
+  bool
+   clip(const Ray& ray, float tMax, float& t0, float& t1, int& entry) const {
+   const float o[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+   const float d[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+   const float extent[3] = { static_cast<float>(m_size[0]) * m_cellSize, static_cast<float>(m_size[1]) * m_cellSize,
+                             static_cast<float>(m_size[2]) * m_cellSize };
+   t0 = 0.f;
+   t1 = tMax;
+   return detail::gridClip(o, d, extent, 3, t0, t1, entry);
+  }
+
+  /** Cell of side cellSize holding ray.at(t), clamped below limit on each axis. */
+  static void
+   startCell(const Ray& ray, float t, float cellSize, const int32_t* limit, int32_t* cell) {
+   cell[0] = std::min(std::max(detail::gridCell(ray.origin.x, ray.direction.x, t, cellSize), 0), limit[0] - 1);
+   cell[1] = std::min(std::max(detail::gridCell(ray.origin.y, ray.direction.y, t, cellSize), 0), limit[1] - 1);
+   cell[2] = std::min(std::max(detail::gridCell(ray.origin.z, ray.direction.z, t, cellSize), 0), limit[2] - 1);
+  }
+
+  static void
+   report(const Ray& ray, int32_t x, int32_t y, int32_t z, float t, int axis, GridHit3D& hit) {
+   const float d[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+   hit.x = x;
+   hit.y = y;
+   hit.z = z;
+   hit.t = t;
+   hit.normal = GridWalk3D::faceNormal(axis, axis < 0 ? 0 : (d[axis] > 0.f ? 1 : -1));
+   hit.hit = true;
+  }
+
+  bool
+   inside(int32_t x, int32_t y, int32_t z) const {
+   return static_cast<uint32_t>(x) < static_cast<uint32_t>(m_size[0]) && static_cast<uint32_t>(y) < static_cast<uint32_t>(m_size[1])
+          && static_cast<uint32_t>(z) < static_cast<uint32_t>(m_size[2]);
+  }
+
+  bool
+   insideBricks(int32_t x, int32_t y, int32_t z) const {
+   return static_cast<uint32_t>(x) < static_cast<uint32_t>(m_bricks[0]) && static_cast<uint32_t>(y) < static_cast<uint32_t>(m_bricks[1])
+          && static_cast<uint32_t>(z) < static_cast<uint32_t>(m_bricks[2]);
+  }
+
+  size_t
+   index(int32_t x, int32_t y, int32_t z) const {
+   return (static_cast<size_t>(z) * static_cast<size_t>(m_size[1]) + static_cast<size_t>(y)) * static_cast<size_t>(m_size[0])
+          + static_cast<size_t>(x);
+  }
+
+  size_t
+   brickIndex(int32_t x, int32_t y, int32_t z) const {
+   return (static_cast<size_t>(z) * static_cast<size_t>(m_bricks[1]) + static_cast<size_t>(y)) * static_cast<size_t>(m_bricks[0])
+          + static_cast<size_t>(x);
+  }
+
+  std::vector<uint8_t> m_voxels;   ///< One byte per voxel, non-zero = solid
+  std::vector<uint16_t> m_counts;  ///< Solid voxels per brick
+  int32_t m_size[3];               ///< Voxels per axis
+  int32_t m_bricks[3];             ///< Bricks per axis
+  float m_cellSize;
+ };
+}
@@ -0,0 +1,752 @@
+/**
+ * @file IsoSurface.h
+ * @brief Isolines and isosurfaces of sampled scalar fields (SDF volumes, metaballs, density
+ * grids): marching squares in 2D and surface nets in 3D, parallel over slabs of blocks that
+ * a min/max pyramid has not ruled out.
+ *
+ * A field is a dense grid of samples, x fastest, spacing apart from origin; SDFScene::distance()
+ * or any density function fills one. The iso level splits it into inside (value < iso, the
+ * SDF convention) and outside; for densities that grow inward pass the negated field or
+ * read the output with the winding reversed.
+ *
+ * Both extractors cut the cell grid into square or cubic blocks (ISO_BLOCK_2D, ISO_BLOCK_3D
+ * cells per side) and take each block's min and max sample (sample rows reduced a register at
+ * a time into column ranges, then per block), then reduce those 2x2(x2) at a time into a
+ * pyramid. Descending it from the top finds the blocks whose range contains the
+ * iso level without touching the others, which in a sparse field is most of them. Work is
+ * split by block row (2D) or block slab (3D), a fixed split, so the output is identical for
+ * every thread count. Pass one gives every crossing its vertex; pass two joins them, and
+ * looks the neighbours' vertices up in per-block caches, with no hash map: whatever a
+ * crossing touches lies in a block whose range spans it, which is active by construction.
+ *
+ * MarchingSquares puts a vertex on every crossed cell edge (shared by the two cells beside
+ * it) and emits segments with the inside on their left. Saddle cells take the connection
+ * of the cell-centre average.
+ *
+ * SurfaceNets puts one vertex in every cell with a sign change, at the mean of its edge
+ * crossings, with the normal of the trilinear field there, and joins the four cells around
+ * every crossed edge into a quad (two triangles, counter-clockwise seen from outside). It is
+ * the dual of marching cubes: no case tables, fewer and better-shaped triangles, and each
+ * vertex is naturally shared by every face using it. Like any dual method it can leave a few
+ * non-manifold edges where a cell is ambiguous (features thinner than a cell, CSG creases).
+ *
+ * Extractors keep their buffers, so re-extracting an animated field allocates nothing once
+ * they have grown to its size.
+ *
+ *   SurfaceNets nets;
+ *   nets.extract(IsoField3D{ samples.data(), 128, 128, 128, origin, voxelSize });
+ *   upload(nets.positions(), nets.normals(), nets.indices());
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Constants.h>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Core/Trace.h>
+#include <Math/EngineMath.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector3Stream.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Cells along each side of a MarchingSquares block.
+ constexpr uint32_t ISO_BLOCK_2D = 16;
+ /// Cells along each side of a SurfaceNets block.
+ constexpr uint32_t ISO_BLOCK_3D = 8;
+
+ /** @brief width x height samples; value (x, y) is values[y * width + x]. */
+ struct IsoField2D {
+  const float* values;
+  uint32_t width;
+  uint32_t height;
+  CVector2 origin;
+  float spacing;
+ };
+
+ /** @brief width x height x depth samples; value (x, y, z) is values[(z * height + y) * width + x]. */
+ struct IsoField3D {
+  const float* values;
+  uint32_t width;
+  uint32_t height;
+  uint32_t depth;
+  CVector3 origin;
+  float spacing;
+ };
+
+ namespace detail {
+  constexpr uint32_t ISO_NO_VERTEX = 0xffffffffu;
+
+  /**
+   * Min/max pyramid over a grid of blocks: level 0 is one entry per block, each level above
+   * halves every axis (rounding up) until one entry is left.
+   */
+  class
+   IsoPyramid {
+   public:
+   /** Sizes level 0 to bx x by x bz blocks; fill it with set(), then call reduce(). */
+   void
+    reset(uint32_t bx, uint32_t by, uint32_t bz) {
+    m_dims.clear();
+    m_dims.push_back({ bx, by, bz });
+    while (bx > 1 || by > 1 || bz > 1) {
+     bx = (bx + 1) / 2;
+     by = (by + 1) / 2;
+     bz = (bz + 1) / 2;
+     m_dims.push_back({ bx, by, bz });
+    }
+    m_levels.resize(m_dims.size());
+    for (size_t l = 0; l < m_dims.size(); ++l) m_levels[l].resize(2 * count(l));
+   }
+
+   void
+    set(uint32_t x, uint32_t y, uint32_t z, float lo, float hi) {
+    float* entry = &m_levels[0][2 * index(0, x, y, z)];
+    entry[0] = lo;
+    entry[1] = hi;
+   }
+
+   void
+    reduce() {
+    for (size_t l = 1; l < m_dims.size(); ++l) {
+     const Dims& below = m_dims[l - 1];
+     const Dims& here = m_dims[l];
+     for (uint32_t z = 0; z < here.z; ++z) {
+      for (uint32_t y = 0; y < here.y; ++y) {
+       for (uint32_t x = 0; x < here.x; ++x) {
+        float lo = Constants::INF, hi = Constants::NEG_INF;
+        for (uint32_t c = 0; c < 8; ++c) {
+         const uint32_t cx = 2 * x + (c & 1), cy = 2 * y + (c >> 1 & 1), cz = 2 * z + (c >> 2);
+         if (cx >= below.x || cy >= below.y || cz >= below.z) continue;
+         const float* child = &m_levels[l - 1][2 * index(l - 1, cx, cy, cz)];
+         lo = child[0] < lo ? child[0] : lo;
+         hi = child[1] > hi ? child[1] : hi;
+        }
+        float* entry = &m_levels[l][2 * index(l, x, y, z)];
+        entry[0] = lo;
+        entry[1] = hi;
+       }
+      }
+     }
+    }
+   }
+
+   /**
+    * Appends to active the level-0 blocks with lo < iso <= hi (some sample inside and some
+    * not), as x + bx * (y + by * z), in a fixed order.
+    */
+   void
+    collect(float iso, std::vector<uint32_t>& active, std::vector<uint32_t>& stack) const {
+    active.clear();
+    stack.clear();
+    // Entries are packed as level << 28 | index within the level.
+    stack.push_back(static_cast<uint32_t>(m_dims.size() - 1) << 28);
+    while (!stack.empty()) {
+     const uint32_t packed = stack.back();
+     stack.pop_back();
+     const uint32_t l = packed >> 28, i = packed & 0x0fffffffu;
+     const float* entry = &m_levels[l][2 * i];
+     if (!(entry[0] < iso && iso <= entry[1])) continue;
+     if (l == 0) {
+      active.push_back(i);
+      continue;
+     }
+     const Dims& here = m_dims[l];
+     const Dims& below = m_dims[l - 1];
+     const uint32_t x = i % here.x, y = i / here.x % here.y, z = i / (here.x * here.y);
+     for (uint32_t c = 8; c-- > 0;) {
+      const uint32_t cx = 2 * x + (c & 1), cy = 2 * y + (c >> 1 & 1), cz = 2 * z + (c >> 2);
+      if (cx >= below.x || cy >= below.y || cz >= below.z) continue;
+      stack.push_back((l - 1) << 28 | static_cast<uint32_t>(index(l - 1, cx, cy, cz)));
+     }
+    }
+   }
+
+   private:
+   struct Dims {
+    uint32_t x, y, z;
+   };
+
+   size_t
+    count(size_t l) const {
+    return static_cast<size_t>(m_dims[l].x) * m_dims[l].y * m_dims[l].z;
+   }
+
+   size_t
+    index(size_t l, uint32_t x, uint32_t y, uint32_t z) const {
+    return (static_cast<size_t>(z) * m_dims[l].y + y) * m_dims[l].x + x;
+   }
+
+   std::vector<Dims> m_dims;
+   std::vector<std::vector<float>> m_levels; ///< Per level: (min, max) per entry
+  };
+
+  /** Splits the active block list into per-slab lists by the slab coordinate of each block. */
+  inline void
+   bucketIsoBlocks(const std::vector<uint32_t>& active, uint32_t perSlab, std::vector<uint32_t>& slabStart,
+                   std::vector<uint32_t>& ordered, size_t slabs) {
+   slabStart.assign(slabs + 1, 0);
+   for (uint32_t b : active) ++slabStart[b / perSlab + 1];
+   for (size_t s = 0; s < slabs; ++s) slabStart[s + 1] += slabStart[s];
+   ordered.resize(active.size());
+   std::vector<uint32_t> cursor(slabStart.begin(), slabStart.end() - 1);
+   for (uint32_t b : active) ordered[cursor[b / perSlab]++] = b;
+  }
+
+  /** lo[i] = min(lo[i], row[i]) and hi[i] = max(hi[i], row[i]) for i in [0, n), a register at a time. */
+  inline void
+   isoRowRange(const float* row, float* lo, float* hi, size_t n) {
+   size_t i = 0;
+   for (; i + BATCH_WIDTH <= n; i += BATCH_WIDTH) {
+    const BatchLanes v = BatchLanes::load(row + i);
+    EU::SIMD::min(BatchLanes::load(lo + i), v).store(lo + i);
+    EU::SIMD::max(BatchLanes::load(hi + i), v).store(hi + i);
+   }
+   for (; i < n; ++i) {
+    lo[i] = row[i] < lo[i] ? row[i] : lo[i];
+    hi[i] = row[i] > hi[i] ? row[i] : hi[i];
+   }
+  }
+
+  /**
+   * Ranges of the blocks along one row from per-sample column ranges: block b spans samples
+   * [b * size, min((b + 1) * size, samples - 1)], sharing its border sample with the next.
+   */
+  template<typename Fn>
+  inline void
+   isoBlockRanges(const float* lo, const float* hi, uint32_t samples, uint32_t blocks, uint32_t size, Fn fn) {
+   for (uint32_t b = 0; b < blocks; ++b) {
+    const uint32_t end = (b + 1) * size < samples - 1 ? (b + 1) * size : samples - 1;
+    float mn = Constants::INF, mx = Constants::NEG_INF;
+    for (uint32_t i = b * size; i <= end; ++i) {
+     mn = lo[i] < mn ? lo[i] : mn;
+     mx = hi[i] > mx ? hi[i] : mx;
+    }
+    fn(b, mn, mx);
+   }
+  }
+
+  inline float
+   isoCrossing(float a, float b, float iso) {
+   const float d = b - a;
+   return d != 0.f ? (iso - a) / d : 0.5f;
+  }
+ }
+
+ /**
+  * @class MarchingSquares
+  * @brief Isolines of an IsoField2D as shared vertices and index pairs.
+  */
+ class
+  MarchingSquares {
+  public:
+  /**
+   * @brief Extracts the lines where the field crosses iso. Replaces the previous result.
+   * @return False (and an empty result) for a field under 2 x 2 samples.
+   */
+  bool
+   extract(const IsoField2D& field, float iso = 0.f, size_t threads = 0) {
+   EU_TRACE_ZONE("MarchingSquares::extract");
+   m_points.clear();
+   m_indices.clear();
+   if (field.values == nullptr || field.width < 2 || field.height < 2) return false;
+   m_field = field;
+   m_iso = iso;
+   const uint32_t bx = (field.width - 2) / ISO_BLOCK_2D + 1, by = (field.height - 2) / ISO_BLOCK_2D + 1;
+   m_blocksX = bx;
+   m_blocksY = by;
+
+   // Block ranges, a row of blocks per task: rows reduce into column ranges, then per block.
+   if (m_rows.size() < by) m_rows.resize(by);
+   m_pyramid.reset(bx, by, 1);
+   detail::parallelTasks(by, detail::resolveThreads(threads, by), [&](size_t row) {
+    Row& scratch = m_rows[row];
+    scratch.lo.assign(field.width, Constants::INF);
+    scratch.hi.assign(field.width, Constants::NEG_INF);
+    const uint32_t y1 = sampleEnd(static_cast<uint32_t>(row), by, field.height);
+    for (uint32_t y = static_cast<uint32_t>(row) * ISO_BLOCK_2D; y <= y1; ++y) {
+     detail::isoRowRange(field.values + static_cast<size_t>(y) * field.width, scratch.lo.data(), scratch.hi.data(), field.width);
+    }
+    detail::isoBlockRanges(scratch.lo.data(), scratch.hi.data(), field.width, bx, ISO_BLOCK_2D,
+                           [&](uint32_t b, float lo, float hi) { m_pyramid.set(b, static_cast<uint32_t>(row), 0, lo, hi); });
+   });
+   m_pyramid.reduce();
+   m_pyramid.collect(iso, m_active, m_stack);
+   detail::bucketIsoBlocks(m_active, bx, m_rowStart, m_ordered, by);
+   m_slot.assign(static_cast<size_t>(bx) * by, detail::ISO_NO_VERTEX);
+   for (size_t k = 0; k < m_ordered.size(); ++k) m_slot[m_ordered[k]] = static_cast<uint32_t>(k);
+   m_edges.resize(m_ordered.size() * EDGE_SLOTS);
+
+   // Pass one: a vertex on every crossed edge an active block owns.
+   const size_t rowThreads = detail::resolveThreads(threads, by);
+   detail::parallelTasks(by, rowThreads, [&](size_t row) {
+    Row& out = m_rows[row];
+    out.points.clear();
+    out.indices.clear();
+    for (uint32_t k = m_rowStart[row]; k < m_rowStart[row + 1]; ++k) placeVertices(k, out);
+   });
+   m_bases.assign(by + 1, 0);
+   for (uint32_t r = 0; r < by; ++r) m_bases[r + 1] = m_bases[r] + static_cast<uint32_t>(m_rows[r].points.size());
+
+   // Pass two: segments per active cell.
+   detail::parallelTasks(by, rowThreads, [&](size_t row) {
+    for (uint32_t k = m_rowStart[row]; k < m_rowStart[row + 1]; ++k) joinCells(k, m_rows[row]);
+   });
+
+   size_t segments = 0;
+   for (uint32_t r = 0; r < by; ++r) segments += m_rows[r].indices.size();
+   m_points.resize(m_bases[by]);
+   m_indices.resize(segments);
+   size_t offset = 0;
+   for (uint32_t r = 0; r < by; ++r) {
+    const Row& row = m_rows[r];
+    for (size_t i = 0; i < row.points.size(); ++i) m_points[m_bases[r] + i] = row.points[i];
+    for (size_t i = 0; i < row.indices.size(); ++i) m_indices[offset + i] = row.indices[i];
+    offset += row.indices.size();
+   }
+   EU_TRACE_COUNTER("iso blocks active", m_active.size());
+   return true;
+  }
+
+  /** @brief Line vertices, each shared by the segments meeting there. */
+  const std::vector<CVector2>&
+   points() const {
+   return m_points;
+  }
+
+  /** @brief Two indices per segment, inside on the left going from the first to the second. */
+  const std::vector<uint32_t>&
+   indices() const {
+   return m_indices;
+  }
+
+  /** @brief Segments of the last extract(). */
+  size_t
+   segmentCount() const {
+   return m_indices.size() / 2;
+  }
+
+  /** @brief Blocks the last extract() visited. */
+  size_t
+   activeBlocks() const {
+   return m_active.size();
+  }
+
+  private:
+  /// Owned edges per block: horizontal and vertical, over up to (block + 1)^2 samples.
+  static constexpr size_t EDGE_SIDE = ISO_BLOCK_2D + 1;
+  static constexpr size_t EDGE_SLOTS = 2 * EDGE_SIDE * EDGE_SIDE;
+
+  struct Row {
+   std::vector<CVector2> points;
+   std::vector<uint32_t> indices;
+   std::vector<float> lo, hi; ///< Column ranges of the row's samples
+  };
+
+  /** Last sample of block b along an axis; the last block also owns the final sample. */
+  static uint32_t
+   sampleEnd(uint32_t b, uint32_t blocks, uint32_t samples) {
+   return b + 1 == blocks ? samples - 1 : (b + 1) * ISO_BLOCK_2D;
+  }
+
+  float
+   value(uint32_t x, uint32_t y) const {
+   return m_field.values[static_cast<size_t>(y) * m_field.width + x];
+  }
+
+  /** Cache slot of the edge from sample (x, y) along axis (0 = +x, 1 = +y). */
+  uint32_t&
+   edge(uint32_t axis, uint32_t x, uint32_t y) {
+   const uint32_t bx = x / ISO_BLOCK_2D < m_blocksX ? x / ISO_BLOCK_2D : m_blocksX - 1;
+   const uint32_t by = y / ISO_BLOCK_2D < m_blocksY ? y / ISO_BLOCK_2D : m_blocksY - 1;
+   const uint32_t slot = m_slot[static_cast<size_t>(by) * m_blocksX + bx];
+   const size_t local = (axis * EDGE_SIDE + (y - by * ISO_BLOCK_2D)) * EDGE_SIDE + (x - bx * ISO_BLOCK_2D);
+   return m_edges[static_cast<size_t>(slot) * EDGE_SLOTS + local];
+  }
+
+  void
+   placeVertices(uint32_t k, Row& out) {
+   const uint32_t block = m_ordered[k];
+   const uint32_t bx = block % m_blocksX, by = block / m_blocksX;
+   const uint32_t x0 = bx * ISO_BLOCK_2D, y0 = by * ISO_BLOCK_2D;
+   // Samples owned: up to the next block's first, or the last sample for the last block.
+   const uint32_t x1 = bx + 1 == m_blocksX ? m_field.width - 1 : x0 + ISO_BLOCK_2D - 1;
+   const uint32_t y1 = by + 1 == m_blocksY ? m_field.height - 1 : y0 + ISO_BLOCK_2D - 1;
+   for (uint32_t y = y0; y <= y1; ++y) {
+    for (uint32_t x = x0; x <= x1; ++x) {
+     const float a = value(x, y);
+     const bool inside = a < m_iso;
+     for (uint32_t axis = 0; axis < 2; ++axis) {
+      const uint32_t nx = x + (axis == 0), ny = y + (axis == 1);
+      if (nx >= m_field.width || ny >= m_field.height) continue;
+      const float b = value(nx, ny);
+      if ((b < m_iso) == inside) continue;
+      const float t = detail::isoCrossing(a, b, m_iso);
+      edge(axis, x, y) = static_cast<uint32_t>(out.points.size());
+      out.points.push_back(CVector2(m_field.origin.x + (static_cast<float>(x) + (axis == 0 ? t : 0.f)) * m_field.spacing,
+                                    m_field.origin.y + (static_cast<float>(y) + (axis == 1 ? t : 0.f)) * m_field.spacing));
+     }
+    }
+   }
+  }
+
+  /** Global index of the vertex on an edge; the block owning it has finished pass one. */
+  uint32_t
+   vertex(uint32_t axis, uint32_t x, uint32_t y) {
+   const uint32_t by = y / ISO_BLOCK_2D < m_blocksY ? y / ISO_BLOCK_2D : m_blocksY - 1;
+   return m_bases[by] + edge(axis, x, y);
+  }
+
+  void
+   joinCells(uint32_t k, Row& out) {
+   const uint32_t block = m_ordered[k];
+   const uint32_t bx = block % m_blocksX, by = block / m_blocksX;
+   const uint32_t x0 = bx * ISO_BLOCK_2D, y0 = by * ISO_BLOCK_2D;
+   const uint32_t x1 = x0 + ISO_BLOCK_2D < m_field.width - 1 ? x0 + ISO_BLOCK_2D : m_field.width - 1;
+   const uint32_t y1 = y0 + ISO_BLOCK_2D < m_field.height - 1 ? y0 + ISO_BLOCK_2D : m_field.height - 1;
+   for (uint32_t y = y0; y < y1; ++y) {
+    for (uint32_t x = x0; x < x1; ++x) {
+     // Corners counter-clockwise from (x, y); edge e runs from corner e to corner e + 1.
+     const float v[4] = { value(x, y), value(x + 1, y), value(x + 1, y + 1), value(x, y + 1) };
+     uint32_t inside = 0;
+     for (uint32_t c = 0; c < 4; ++c) inside |= static_cast<uint32_t>(v[c] < m_iso) << c;
+     if (inside == 0 || inside == 15) continue;
+     uint32_t ids[4];
+     ids[0] = vertex(0, x, y);
+     ids[1] = vertex(1, x + 1, y);
+     ids[2] = vertex(0, x, y + 1);
+     ids[3] = vertex(1, x, y);
+     // A line starts where an edge leaves the inside and ends where one enters it.
+     uint32_t starts[2], ends[2], startCount = 0, endCount = 0;
+     for (uint32_t e = 0; e < 4; ++e) {
+      const bool from = (inside >> e & 1) != 0, to = (inside >> ((e + 1) & 3) & 1) != 0;
+      if (from && !to) starts[startCount++] = e;
+      else if (!from && to) ends[endCount++] = e;
+     }
+     if (startCount == 1) {
+      out.indices.push_back(ids[starts[0]]);
+      out.indices.push_back(ids[ends[0]]);
+      continue;
+     }
+     // Saddle: a centre inside joins the two inside corners, so each start meets the next
+     // end counter-clockwise; otherwise the previous one.
+     const bool centre = 0.25f * (v[0] + v[1] + v[2] + v[3]) < m_iso;
+     for (uint32_t s = 0; s < 2; ++s) {
+      const uint32_t e = starts[s];
+      uint32_t match = ends[0];
+      if (centre) match = ((ends[0] - e) & 3) < ((ends[1] - e) & 3) ? ends[0] : ends[1];
+      else match = ((e - ends[0]) & 3) < ((e - ends[1]) & 3) ? ends[0] : ends[1];
+      out.indices.push_back(ids[e]);
+      out.indices.push_back(ids[match]);
+     }
+    }
+   }
+  }
+
+  IsoField2D m_field{};
+  float m_iso = 0.f;
+  uint32_t m_blocksX = 0;
+  uint32_t m_blocksY = 0;
+  detail::IsoPyramid m_pyramid;
+  std::vector<uint32_t> m_active;   ///< Active blocks in pyramid order
+  std::vector<uint32_t> m_stack;
+  std::vector<uint32_t> m_ordered;  ///< Active blocks by row
+  std::vector<uint32_t> m_rowStart; ///< First entry of m_ordered per block row
+  std::vector<uint32_t> m_slot;     ///< Per block: position in m_ordered, or ISO_NO_VERTEX
+  std::vector<uint32_t> m_edges;    ///< EDGE_SLOTS per active block: row-local vertex index
+  std::vector<uint32_t> m_bases;    ///< First vertex of each block row
+  std::vector<Row> m_rows;
+  std::vector<CVector2> m_points;
+  std::vector<uint32_t> m_indices;
+ };
+
+ /**
+  * @class SurfaceNets
+  * @brief Isosurface of an IsoField3D as indexed triangles over SoA positions and normals.
+  */
+ class
+  SurfaceNets {
+  public:
+  /**
+   * @brief Extracts the surface where the field crosses iso. Replaces the previous result.
+   * @return False (and an empty result) for a field under 2 x 2 x 2 samples.
+   */
+  bool
+   extract(const IsoField3D& field, float iso = 0.f, size_t threads = 0) {
+   EU_TRACE_ZONE("SurfaceNets::extract");
+   m_positions.clear();
+   m_normals.clear();
+   m_indices.clear();
+   if (field.values == nullptr || field.width < 2 || field.height < 2 || field.depth < 2) return false;
+   m_field = field;
+   m_iso = iso;
+   m_blocks[0] = (field.width - 2) / ISO_BLOCK_3D + 1;
+   m_blocks[1] = (field.height - 2) / ISO_BLOCK_3D + 1;
+   m_blocks[2] = (field.depth - 2) / ISO_BLOCK_3D + 1;
+   const uint32_t bx = m_blocks[0], by = m_blocks[1], bz = m_blocks[2];
+   const size_t threadCount = detail::resolveThreads(threads, bz);
+
+   // Block ranges over their cells' samples, a slab of blocks per task.
+   if (m_slabs.size() < bz) m_slabs.resize(bz);
+   m_pyramid.reset(bx, by, bz);
+   detail::parallelTasks(bz, threadCount, [&](size_t slab) {
+    Slab& scratch = m_slabs[slab];
+    const uint32_t z = static_cast<uint32_t>(slab);
+    for (uint32_t y = 0; y < by; ++y) {
+     uint32_t lo[3], hi[3];
+     blockCells(0, y, z, lo, hi);
+     scratch.lo.assign(field.width, Constants::INF);
+     scratch.hi.assign(field.width, Constants::NEG_INF);
+     for (uint32_t k = lo[2]; k <= hi[2]; ++k) {
+      for (uint32_t j = lo[1]; j <= hi[1]; ++j) detail::isoRowRange(sample(0, j, k), scratch.lo.data(), scratch.hi.data(), field.width);
+     }
+     detail::isoBlockRanges(scratch.lo.data(), scratch.hi.data(), field.width, bx, ISO_BLOCK_3D,
+                            [&](uint32_t x, float mn, float mx) { m_pyramid.set(x, y, z, mn, mx); });
+    }
+   });
+   m_pyramid.reduce();
+   m_pyramid.collect(iso, m_active, m_stack);
+   detail::bucketIsoBlocks(m_active, bx * by, m_slabStart, m_ordered, bz);
+   m_slot.assign(static_cast<size_t>(bx) * by * bz, detail::ISO_NO_VERTEX);
+   for (size_t k = 0; k < m_ordered.size(); ++k) m_slot[m_ordered[k]] = static_cast<uint32_t>(k);
+   m_cells.resize(m_ordered.size() * BLOCK_CELLS);
+
+   // Pass one: a vertex per cell with a sign change.
+   detail::parallelTasks(bz, threadCount, [&](size_t slab) {
+    Slab& out = m_slabs[slab];
+    out.clearVertices();
+    for (uint32_t k = m_slabStart[slab]; k < m_slabStart[slab + 1]; ++k) placeVertices(k, out);
+   });
+   m_bases.assign(bz + 1, 0);
+   for (uint32_t s = 0; s < bz; ++s) m_bases[s + 1] = m_bases[s] + static_cast<uint32_t>(m_slabs[s].px.size());
+
+   // Pass two: a quad per crossed edge, from the cells that got a vertex.
+   detail::parallelTasks(bz, threadCount, [&](size_t slab) { joinCells(m_slabs[slab]); });
+
+   m_indexBases.assign(bz + 1, 0);
+   for (uint32_t s = 0; s < bz; ++s) m_indexBases[s + 1] = m_indexBases[s] + m_slabs[s].indices.size();
+   m_positions.resize(m_bases[bz]);
+   m_normals.resize(m_bases[bz]);
+   m_indices.resize(m_indexBases[bz]);
+   detail::parallelTasks(bz, threadCount, [&](size_t slab) {
+    const Slab& in = m_slabs[slab];
+    const size_t base = m_bases[slab];
+    for (size_t i = 0; i < in.px.size(); ++i) {
+     m_positions.x()[base + i] = in.px[i];
+     m_positions.y()[base + i] = in.py[i];
+     m_positions.z()[base + i] = in.pz[i];
+     m_normals.x()[base + i] = in.nx[i];
+     m_normals.y()[base + i] = in.ny[i];
+     m_normals.z()[base + i] = in.nz[i];
+    }
+    for (size_t i = 0; i < in.indices.size(); ++i) m_indices[m_indexBases[slab] + i] = in.indices[i];
+   });
+   EU_TRACE_COUNTER("iso blocks active", m_active.size());
+   return true;
+  }
+
+  /** @brief Vertex positions. */
+  const Vector3Stream&
+   positions() const {
+   return m_positions;
+  }
+
+  /** @brief Unit normals pointing outside (toward larger values). */
+  const Vector3Stream&
+   normals() const {
+   return m_normals;
+  }
+
+  /** @brief Three indices per triangle. */
+  const std::vector<uint32_t>&
+   indices() const {
+   return m_indices;
+  }
+
+  /** @brief Triangles of the last extract(). */
+  size_t
+   triangleCount() const {
+   return m_indices.size() / 3;
+  }
+
+  /** @brief Blocks the last extract() visited. */
+  size_t
+   activeBlocks() const {
+   return m_active.size();
+  }
+
+  private:
+  static constexpr size_t BLOCK_CELLS = ISO_BLOCK_3D * ISO_BLOCK_3D * ISO_BLOCK_3D;
+
+  struct Slab {
+   std::vector<float> px, py, pz, nx, ny, nz;
+   std::vector<uint64_t> cells; ///< Cell of each vertex, x | y << 21 | z << 42
+   std::vector<uint32_t> indices;
+   std::vector<float> lo, hi;   ///< Column ranges of one block row's samples
+
+   void
+    clearVertices() {
+    cells.clear();
+    px.clear();
+    py.clear();
+    pz.clear();
+    nx.clear();
+    ny.clear();
+    nz.clear();
+   }
+  };
+
+  const float*
+   sample(uint32_t x, uint32_t y, uint32_t z) const {
+   return m_field.values + (static_cast<size_t>(z) * m_field.height + y) * m_field.width + x;
+  }
+
+  /** Cells of a block [lo, hi) per axis, as the inclusive sample range [lo, hi]. */
+  void
+   blockCells(uint32_t x, uint32_t y, uint32_t z, uint32_t (&lo)[3], uint32_t (&hi)[3]) const {
+   const uint32_t b[3] = { x, y, z };
+   const uint32_t samples[3] = { m_field.width, m_field.height, m_field.depth };
+   for (int a = 0; a < 3; ++a) {
+    lo[a] = b[a] * ISO_BLOCK_3D;
+    hi[a] = lo[a] + ISO_BLOCK_3D < samples[a] - 1 ? lo[a] + ISO_BLOCK_3D : samples[a] - 1;
+   }
+  }
+
+  /** Cache entry of cell (x, y, z): slab-local vertex index. */
+  uint32_t&
+   cell(uint32_t x, uint32_t y, uint32_t z) {
+   const uint32_t b = ((z / ISO_BLOCK_3D) * m_blocks[1] + y / ISO_BLOCK_3D) * m_blocks[0] + x / ISO_BLOCK_3D;
+   const size_t local = ((z % ISO_BLOCK_3D) * ISO_BLOCK_3D + y % ISO_BLOCK_3D) * ISO_BLOCK_3D + x % ISO_BLOCK_3D;
+   return m_cells[static_cast<size_t>(m_slot[b]) * BLOCK_CELLS + local];
+  }
+
+  void
+   placeVertices(uint32_t k, Slab& out) {
+   const uint32_t block = m_ordered[k];
+   const uint32_t bx = block % m_blocks[0], by = block / m_blocks[0] % m_blocks[1], bz = block / (m_blocks[0] * m_blocks[1]);
+   uint32_t lo[3], hi[3];
+   blockCells(bx, by, bz, lo, hi);
+   // Corner c is at offset (c & 1, c >> 1 & 1, c >> 2); the 12 edges as corner pairs.
+   static const uint8_t edges[12][2] = { { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 }, { 0, 2 }, { 1, 3 },
+                                         { 4, 6 }, { 5, 7 }, { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } };
+   const size_t row = m_field.width, layer = static_cast<size_t>(m_field.width) * m_field.height;
+   for (uint32_t z = lo[2]; z < hi[2]; ++z) {
+    for (uint32_t y = lo[1]; y < hi[1]; ++y) {
+     // Corners slide along x: the +x face of one cell is the -x face of the next.
+     const float* p = sample(lo[0], y, z);
+     float v[8];
+     v[1] = p[0];
+     v[3] = p[row];
+     v[5] = p[layer];
+     v[7] = p[layer + row];
+     for (uint32_t x = lo[0]; x < hi[0]; ++x, ++p) {
+      v[0] = v[1];
+      v[2] = v[3];
+      v[4] = v[5];
+      v[6] = v[7];
+      v[1] = p[1];
+      v[3] = p[row + 1];
+      v[5] = p[layer + 1];
+      v[7] = p[layer + row + 1];
+      uint32_t inside = 0;
+      for (uint32_t c = 0; c < 8; ++c) inside |= static_cast<uint32_t>(v[c] < m_iso) << c;
+      if (inside == 0 || inside == 0xff) continue;
+      float sx = 0.f, sy = 0.f, sz = 0.f, crossings = 0.f;
+      for (const uint8_t(&e)[2] : edges) {
+       if ((inside >> e[0] & 1) == (inside >> e[1] & 1)) continue;
+       const float t = detail::isoCrossing(v[e[0]], v[e[1]], m_iso);
+       const float ax = static_cast<float>(e[0] & 1), ay = static_cast<float>(e[0] >> 1 & 1), az = static_cast<float>(e[0] >> 2);
+       sx += ax + t * (static_cast<float>(e[1] & 1) - ax);
+       sy += ay + t * (static_cast<float>(e[1] >> 1 & 1) - ay);
+       sz += az + t * (static_cast<float>(e[1] >> 2) - az);
+       crossings += 1.f;
+      }
+      const float u = sx / crossings, w = sy / crossings, s = sz / crossings;
+      // Gradient of the trilinear interpolant at (u, w, s).
+      const float x00 = v[1] - v[0], x10 = v[3] - v[2], x01 = v[5] - v[4], x11 = v[7] - v[6];
+      const float y00 = v[2] - v[0], y10 = v[3] - v[1], y01 = v[6] - v[4], y11 = v[7] - v[5];
+      const float z00 = v[4] - v[0], z10 = v[5] - v[1], z01 = v[6] - v[2], z11 = v[7] - v[3];
+      float gx = (1.f - s) * ((1.f - w) * x00 + w * x10) + s * ((1.f - w) * x01 + w * x11);
+      float gy = (1.f - s) * ((1.f - u) * y00 + u * y10) + s * ((1.f - u) * y01 + u * y11);
+      float gz = (1.f - w) * ((1.f - u) * z00 + u * z10) + w * ((1.f - u) * z01 + u * z11);
+      const float length = EngineMath::sqrtHardware(gx * gx + gy * gy + gz * gz);
+      const float inv = length > 0.f ? 1.f / length : 0.f;
+      cell(x, y, z) = static_cast<uint32_t>(out.px.size());
+      out.cells.push_back(x | static_cast<uint64_t>(y) << 21 | static_cast<uint64_t>(z) << 42);
+      out.px.push_back(m_field.origin.x + (static_cast<float>(x) + u) * m_field.spacing);
+      out.py.push_back(m_field.origin.y + (static_cast<float>(y) + w) * m_field.spacing);
+      out.pz.push_back(m_field.origin.z + (static_cast<float>(z) + s) * m_field.spacing);
+      out.nx.push_back(gx * inv);
+      out.ny.push_back(gy * inv);
+      out.nz.push_back(gz * inv);
+     }
+    }
+   }
+  }
+
+  uint32_t
+   vertex(uint32_t x, uint32_t y, uint32_t z) {
+   return m_bases[z / ISO_BLOCK_3D] + cell(x, y, z);
+  }
+
+  void
+   joinCells(Slab& out) {
+   out.indices.clear();
+   const size_t steps[3] = { 1, m_field.width, static_cast<size_t>(m_field.width) * m_field.height };
+   for (const uint64_t packed : out.cells) {
+    // Edges leaving the cell's first sample toward +axis, shared by this cell and the three
+    // behind it on the other two axes; a crossed one means all four have a vertex.
+    const uint32_t p[3] = { static_cast<uint32_t>(packed & 0x1fffff), static_cast<uint32_t>(packed >> 21 & 0x1fffff),
+                            static_cast<uint32_t>(packed >> 42) };
+    const float* origin = sample(p[0], p[1], p[2]);
+    const bool inside = origin[0] < m_iso;
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+     const uint32_t ua = (axis + 1) % 3, va = (axis + 2) % 3;
+     if (p[ua] == 0 || p[va] == 0) continue;
+     if ((origin[steps[axis]] < m_iso) == inside) continue;
+     uint32_t q[4][3];
+     for (uint32_t c = 0; c < 4; ++c) {
+      q[c][axis] = p[axis];
+      q[c][ua] = p[ua] - (c == 0 || c == 3);
+      q[c][va] = p[va] - (c < 2);
+     }
+     uint32_t ids[4];
+     for (uint32_t c = 0; c < 4; ++c) ids[c] = vertex(q[c][0], q[c][1], q[c][2]);
+     // Around +axis the corners are counter-clockwise; flip when the field falls along it.
+     if (!inside) {
+      const uint32_t t = ids[1];
+      ids[1] = ids[3];
+      ids[3] = t;
+     }
+     out.indices.push_back(ids[0]);
+     out.indices.push_back(ids[1]);
+     out.indices.push_back(ids[2]);
+     out.indices.push_back(ids[0]);
+     out.indices.push_back(ids[2]);
+     out.indices.push_back(ids[3]);
+    }
+   }
+  }
+
+  IsoField3D m_field{};
+  float m_iso = 0.f;
+  uint32_t m_blocks[3] = {};
+  detail::IsoPyramid m_pyramid;
+  std::vector<uint32_t> m_active;     ///< Active blocks in pyramid order
+  std::vector<uint32_t> m_stack;
+  std::vector<uint32_t> m_ordered;    ///< Active blocks by slab
+  std::vector<uint32_t> m_slabStart;  ///< First entry of m_ordered per slab
+  std::vector<uint32_t> m_slot;       ///< Per block: position in m_ordered, or ISO_NO_VERTEX
+  std::vector<uint32_t> m_cells;      ///< BLOCK_CELLS per active block: slab-local vertex index
+  std::vector<uint32_t> m_bases;      ///< First vertex of each slab
+  std::vector<size_t> m_indexBases;   ///< First index of each slab
+  std::vector<Slab> m_slabs;
+  Vector3Stream m_positions;
+  Vector3Stream m_normals;
+  std::vector<uint32_t> m_indices;
+ };
+}
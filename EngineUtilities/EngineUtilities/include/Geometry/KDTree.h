@@ -0,0 +1,394 @@
+/**
+ * @file KDTree.h
+ * @brief Implicit k-d trees over static CVector2/CVector3 point sets: k-nearest and radius
+ * queries, one at a time or in parallel batches.
+ *
+ * The tree has no pointers. Its leaves are a power of two, each holding an equal share (within
+ * one point) of the input and at most KD_LEAF_SIZE points, and the inner nodes form a complete
+ * binary tree stored in breadth-first order: node i has children 2i + 1 and 2i + 2, and the point
+ * range of any node follows from its position alone. An inner node stores only its split axis
+ * (the widest extent of its range) and its split value. build() applies median selection level by
+ * level, the nodes of a level being independent tasks across threads; selection depends on the
+ * input only, so the tree is identical for any thread count.
+ *
+ * The points are then kept in leaf order as SoA lanes, so a leaf scan computes the distances of
+ * one register of points per step. Queries descend nearest child first and skip the far child
+ * when the query's distance to the split plane already exceeds the current k-th distance.
+ *
+ * nearest() returns neighbours by ascending squared distance, ties by lower point index, so the
+ * results are reproducible. within() is inclusive, |p - q| <= radius, and reports matches in
+ * leaf order.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Constants.h>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Largest leaf; a multiple of the widest SIMD register.
+ constexpr size_t KD_LEAF_SIZE = 16;
+ /// Index reported in nearestBatch() slots beyond the point count.
+ constexpr uint32_t KD_NONE = 0xffffffffu;
+
+ namespace detail {
+  /// Point sets smaller than this are built on the calling thread.
+  constexpr size_t PARALLEL_KD_MIN = 16384;
+  /// Queries per task of the batch queries; fixes the work split.
+  constexpr size_t KD_QUERY_CHUNK = 256;
+  /// Longest root-to-leaf path plus one; the point count is a uint32_t.
+  constexpr size_t KD_STACK_DEPTH = 33;
+
+  template<typename Vector>
+  struct KDDimension;
+
+  template<>
+  struct KDDimension<CVector2> {
+   enum { VALUE = 2 };
+  };
+
+  template<>
+  struct KDDimension<CVector3> {
+   enum { VALUE = 3 };
+  };
+
+  /** One input point during the build. */
+  template<typename Vector>
+  struct KDEntry {
+   Vector point;
+   uint32_t index;
+  };
+
+  /**
+   * Max-heap of the best candidates so far over the caller's arrays, ordered by (distance,
+   * index): the root is the worst neighbour kept.
+   */
+  struct KDHeap {
+   uint32_t* index;
+   float* distance;
+   size_t size;
+   size_t capacity;
+
+   bool
+    worse(size_t a, size_t b) const {
+    return distance[a] > distance[b] || (distance[a] == distance[b] && index[a] > index[b]);
+   }
+
+   void
+    swap(size_t a, size_t b) {
+    std::swap(index[a], index[b]);
+    std::swap(distance[a], distance[b]);
+   }
+
+   void
+    siftDown(size_t i, size_t n) {
+    for (size_t c = 2 * i + 1; c < n; i = c, c = 2 * i + 1) {
+     if (c + 1 < n && worse(c + 1, c)) ++c;
+     if (!worse(c, i)) return;
+     swap(i, c);
+    }
+   }
+
+   /** Squared distance a candidate must beat, INF until the heap is full. */
+   float
+    bound() const {
+    return size < capacity ? Constants::INF : distance[0];
+   }
+
+   void
+    push(float d, uint32_t i) {
+    if (size < capacity) {
+     size_t c = size++;
+     index[c] = i;
+     distance[c] = d;
+     while (c > 0 && worse(c, (c - 1) / 2)) {
+      swap(c, (c - 1) / 2);
+      c = (c - 1) / 2;
+     }
+    }
+    else if (d < distance[0] || (d == distance[0] && i < index[0])) {
+     index[0] = i;
+     distance[0] = d;
+     siftDown(0, size);
+    }
+   }
+
+   /** Heap sort in place: ascending (distance, index). */
+   void
+    sort() {
+    for (size_t n = size; n > 1; --n) {
+     swap(0, n - 1);
+     siftDown(0, n - 1);
+    }
+   }
+  };
+ }
+
+ /**
+  * @class KDTree
+  * @brief Static k-d tree over CVector2 or CVector3 points; see KDTree2 and KDTree3.
+  */
+ template<typename Vector>
+ class
+  KDTree {
+  static constexpr int DIM = detail::KDDimension<Vector>::VALUE;
+
+  public:
+  KDTree() {}
+
+  /**
+   * @brief Builds over points[0..n); query results refer to these indices.
+   * @param threads Worker threads, 0 for hardware_concurrency(); sets of fewer than
+   * detail::PARALLEL_KD_MIN points build on the calling thread.
+   */
+  void
+   build(const Vector* points, size_t n, size_t threads = 0) {
+   m_count = n;
+   m_leaves = 1;
+   m_depth = 0;
+   while (m_leaves * KD_LEAF_SIZE < n) {
+    m_leaves *= 2;
+    ++m_depth;
+   }
+   m_axis.assign(m_leaves - 1, 0);
+   m_split.assign(m_leaves - 1, 0.f);
+   std::vector<detail::KDEntry<Vector>> entries(n);
+   for (size_t i = 0; i < n; ++i) entries[i] = detail::KDEntry<Vector>{ points[i], static_cast<uint32_t>(i) };
+
+   for (uint32_t level = 0; level < m_depth; ++level) {
+    const size_t first = (size_t(1) << level) - 1, nodes = size_t(1) << level;
+    const size_t workers = n < detail::PARALLEL_KD_MIN ? 1 : detail::resolveThreads(threads, nodes);
+    detail::parallelTasks(nodes, workers, [&](size_t k) {
+     const size_t node = first + k;
+     const size_t begin = nodeBegin(node), end = nodeEnd(node), middle = nodeBegin(2 * node + 2);
+     Vector lo = entries[begin].point, hi = lo;
+     for (size_t i = begin + 1; i < end; ++i) {
+      for (int a = 0; a < DIM; ++a) {
+       lo[a] = std::min(lo[a], entries[i].point[a]);
+       hi[a] = std::max(hi[a], entries[i].point[a]);
+      }
+     }
+     int axis = 0;
+     for (int a = 1; a < DIM; ++a) {
+      if (hi[a] - lo[a] > hi[axis] - lo[axis]) axis = a;
+     }
+     std::nth_element(entries.begin() + begin, entries.begin() + middle, entries.begin() + end,
+                      [axis](const detail::KDEntry<Vector>& a, const detail::KDEntry<Vector>& b) {
+                       return a.point[axis] < b.point[axis] || (a.point[axis] == b.point[axis] && a.index < b.index);
+                      });
+     m_axis[node] = static_cast<uint8_t>(axis);
+     m_split[node] = entries[middle].point[axis];
+    });
+   }
+
+   for (int a = 0; a < DIM; ++a) m_coord[a].resize(n);
+   m_index.resize(n);
+   for (size_t i = 0; i < n; ++i) {
+    for (int a = 0; a < DIM; ++a) m_coord[a][i] = entries[i].point[a];
+    m_index[i] = entries[i].index;
+   }
+  }
+
+  /** @brief Drops the tree. */
+  void
+   clear() {
+   for (int a = 0; a < DIM; ++a) m_coord[a].clear();
+   m_index.clear();
+   m_axis.clear();
+   m_split.clear();
+   m_count = 0;
+   m_leaves = 1;
+   m_depth = 0;
+  }
+
+  size_t
+   size() const {
+   return m_count;
+  }
+
+  bool
+   empty() const {
+   return m_count == 0;
+  }
+
+  /**
+   * @brief The min(k, size()) points nearest to query, by ascending squared distance (ties by
+   * lower index), into indices[0..) and distancesSq[0..).
+   * @return Number of neighbours written.
+   */
+  size_t
+   nearest(const Vector& query, size_t k, uint32_t* indices, float* distancesSq) const {
+   if (k == 0 || m_count == 0) return 0;
+   detail::KDHeap heap{ indices, distancesSq, 0, k < m_count ? k : m_count };
+   Entry stack[detail::KD_STACK_DEPTH + 1];
+   size_t top = 0;
+   stack[top++] = Entry{ 0, 0.f };
+   while (top > 0) {
+    const Entry entry = stack[--top];
+    if (entry.distance > heap.bound()) continue;
+    if (visitLeaf(entry.node, query, heap)) continue;
+    descend(entry, query, stack, top);
+   }
+   heap.sort();
+   return heap.size;
+  }
+
+  /**
+   * @brief Appends to out the indices of the points within radius of query, in leaf order.
+   * @return Number of indices appended.
+   */
+  size_t
+   within(const Vector& query, float radius, std::vector<uint32_t>& out) const {
+   if (m_count == 0 || !(radius >= 0.f)) return 0;
+   const float limit = radius * radius;
+   const size_t before = out.size();
+   Entry stack[detail::KD_STACK_DEPTH + 1];
+   size_t top = 0;
+   stack[top++] = Entry{ 0, 0.f };
+   while (top > 0) {
+    const Entry entry = stack[--top];
+    if (entry.distance > limit) continue;
+    if (entry.node >= m_leaves - 1) {
+     const size_t leaf = entry.node - (m_leaves - 1);
+     scanLeaf(leafBegin(leaf), leafBegin(leaf + 1), query, [&](size_t i, float d) {
+      if (d <= limit) out.push_back(m_index[i]);
+     });
+     continue;
+    }
+    descend(entry, query, stack, top);
+   }
+   return out.size() - before;
+  }
+
+  /**
+   * @brief nearest() for queries[0..count), in parallel: query q fills the k slots from q * k
+   * of indices and distancesSq, slots past size() holding KD_NONE and Constants::INF.
+   * @param threads Worker threads, 0 for hardware_concurrency(); the split into
+   * detail::KD_QUERY_CHUNK queries is fixed, so results match the single-query calls.
+   */
+  void
+   nearestBatch(const Vector* queries, size_t count, size_t k, uint32_t* indices, float* distancesSq,
+                size_t threads = 0) const {
+   const size_t chunks = (count + detail::KD_QUERY_CHUNK - 1) / detail::KD_QUERY_CHUNK;
+   detail::parallelTasks(chunks, detail::resolveThreads(threads, chunks), [&](size_t c) {
+    const size_t end = std::min(count, (c + 1) * detail::KD_QUERY_CHUNK);
+    for (size_t q = c * detail::KD_QUERY_CHUNK; q < end; ++q) {
+     for (size_t j = nearest(queries[q], k, indices + q * k, distancesSq + q * k); j < k; ++j) {
+      indices[q * k + j] = KD_NONE;
+      distancesSq[q * k + j] = Constants::INF;
+     }
+    }
+   });
+  }
+
+  /**
+   * @brief within() for queries[0..count), in parallel, as CSR: the matches of query q are
+   * indices[offsets[q]..offsets[q + 1]). Both vectors are replaced.
+   */
+  void
+   withinBatch(const Vector* queries, size_t count, float radius, std::vector<uint32_t>& indices,
+               std::vector<uint32_t>& offsets, size_t threads = 0) const {
+   const size_t chunks = (count + detail::KD_QUERY_CHUNK - 1) / detail::KD_QUERY_CHUNK;
+   std::vector<std::vector<uint32_t>> found(chunks);
+   offsets.assign(count + 1, 0);
+   detail::parallelTasks(chunks, detail::resolveThreads(threads, chunks), [&](size_t c) {
+    const size_t end = std::min(count, (c + 1) * detail::KD_QUERY_CHUNK);
+    for (size_t q = c * detail::KD_QUERY_CHUNK; q < end; ++q) {
+     offsets[q + 1] = static_cast<uint32_t>(within(queries[q], radius, found[c]));
+    }
+   });
+   for (size_t q = 0; q < count; ++q) offsets[q + 1] += offsets[q];
+   indices.clear();
+   indices.reserve(offsets[count]);
+   for (const std::vector<uint32_t>& chunk : found) indices.insert(indices.end(), chunk.begin(), chunk.end());
+  }
+
+  private:
+  /** Node to visit and the lower bound of its squared distance to the query. */
+  struct Entry {
+   uint32_t node;
+   float distance;
+  };
+
+  /** First point of leaf j, leaves sharing the points as evenly as possible. */
+  size_t
+   leafBegin(size_t leaf) const {
+   return static_cast<size_t>(static_cast<uint64_t>(leaf) * m_count / m_leaves);
+  }
+
+  /** First point under node: the first leaf of its subtree. */
+  size_t
+   nodeBegin(size_t node) const {
+   uint32_t level = 0;
+   while ((size_t(2) << level) - 1 <= node) ++level;
+   const size_t position = node + 1 - (size_t(1) << level);
+   return leafBegin(position << (m_depth - level));
+  }
+
+  size_t
+   nodeEnd(size_t node) const {
+   uint32_t level = 0;
+   while ((size_t(2) << level) - 1 <= node) ++level;
+   const size_t position = node + 1 - (size_t(1) << level);
+   return leafBegin((position + 1) << (m_depth - level));
+  }
+
+  /** Pushes the far child (with its plane distance) and then the near child. */
+  void
+   descend(const Entry& entry, const Vector& query, Entry* stack, size_t& top) const {
+   const float diff = query[m_axis[entry.node]] - m_split[entry.node];
+   const uint32_t left = 2 * entry.node + 1;
+   const float plane = std::max(entry.distance, diff * diff);
+   stack[top++] = diff < 0.f ? Entry{ left + 1, plane } : Entry{ left, plane };
+   stack[top++] = diff < 0.f ? Entry{ left, entry.distance } : Entry{ left + 1, entry.distance };
+  }
+
+  /** Scans node into heap when it is a leaf. */
+  bool
+   visitLeaf(uint32_t node, const Vector& query, detail::KDHeap& heap) const {
+   if (node < m_leaves - 1) return false;
+   const size_t leaf = node - (m_leaves - 1);
+   scanLeaf(leafBegin(leaf), leafBegin(leaf + 1), query, [&](size_t i, float d) {
+    if (d <= heap.bound()) heap.push(d, m_index[i]);
+   });
+   return true;
+  }
+
+  /** Calls fn(slot, squared distance) for every point of [begin, end), one register at a time. */
+  template<typename Fn>
+  void
+   scanLeaf(size_t begin, size_t end, const Vector& query, Fn fn) const {
+   using detail::BatchLanes;
+   for (size_t i = begin; i < end; i += detail::BATCH_WIDTH) {
+    const size_t count = end - i < detail::BATCH_WIDTH ? end - i : detail::BATCH_WIDTH;
+    BatchLanes d = BatchLanes::zero();
+    for (int a = 0; a < DIM; ++a) {
+     const BatchLanes diff = detail::loadLanes(m_coord[a].data(), i, count) - BatchLanes::set1(query[a]);
+     d = d + diff * diff;
+    }
+    float distance[detail::BATCH_WIDTH];
+    d.store(distance);
+    for (size_t j = 0; j < count; ++j) fn(i + j, distance[j]);
+   }
+  }
+
+  std::vector<float> m_coord[DIM];
+  std::vector<uint32_t> m_index;
+  std::vector<uint8_t> m_axis;
+  std::vector<float> m_split;
+  size_t m_count = 0;
+  size_t m_leaves = 1;
+  uint32_t m_depth = 0;
+ };
+
+ using KDTree2 = KDTree<CVector2>;
+ using KDTree3 = KDTree<CVector3>;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file LodSelect.h
+ * @brief Screen-space-size LOD selection of bounding sphere sets, with hysteresis, fused with
+ * frustum culling.
+ *
+ * An object's projected size is the height in pixels its bounding sphere covers: r * scale / d
+ * for a perspective camera, where scale is the projection's y focal length times half the
+ * viewport height and d is the distance from the eye, or r * scale for an orthographic one.
+ * selectLods() computes it for a register of objects at once with one rsqrt, no matrix
+ * multiply and no sqrt, and compares it against each object's thresholds: an object whose
+ * size is below thresholds[k][i] uses at least level k + 1, so the level is the number of
+ * thresholds the size falls below. Thresholds must decrease with k; objects with fewer levels
+ * pad their arrays with 0.
+ *
+ * Hysteresis keeps objects near a threshold from popping every frame. lods holds each
+ * object's previous level on entry: to switch to a coarser level than before, the size has to
+ * fall below threshold * (1 - hysteresis), and to come back it has to exceed
+ * threshold * (1 + hysteresis). Every object's level is updated, visible or not, so objects
+ * entering the view already have a settled level.
+ *
+ * The same pass tests each sphere against an optional frustum, drops objects smaller than
+ * LodSettings::minScreenSize (detail culling), and writes the indices of the rest to a draw
+ * list, ascending, chunked over threads like cullSpheres().
+ *
+ *   const LodView view = LodView::fromProjection(projection, eye, viewportHeight);
+ *   const float* thresholds[] = { lod1Pixels, lod2Pixels, lod3Pixels };      // n each
+ *   const LodObjects objects{ centers, radii, thresholds, 3 };
+ *   const size_t drawn = selectLods(view, &frustum, objects, n, lods, drawList);
+ *   for (size_t k = 0; k < drawn; ++k) draw(drawList[k], lods[drawList[k]]);
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/SIMD.h>
+#include <Core/Trace.h>
+#include <Geometry/Frustum.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Matrix4x4.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Most thresholds per object, so at most LOD_MAX_THRESHOLDS + 1 levels.
+ constexpr size_t LOD_MAX_THRESHOLDS = 7;
+
+ /**
+  * @struct LodView
+  * @brief What selectLods() needs from the camera.
+  */
+ struct LodView {
+  CVector3 eye;              ///< Camera position, in the space of the sphere centers
+  float scale = 1.f;         ///< Pixels covered by one unit at distance one (or at any distance when orthographic)
+  bool orthographic = false;
+
+  /**
+   * @brief View of a projection matrix from CameraMatrices.h (or any with w = -z for
+   * perspective and w = 1 for orthographic) seen from eye.
+   * @param viewportHeight Height of the render target in pixels.
+   */
+  static LodView
+   fromProjection(const Matrix4x4& projection, const CVector3& eye, float viewportHeight) {
+   LodView view;
+   view.eye = eye;
+   view.scale = projection.m[1][1] * viewportHeight * 0.5f;
+   view.orthographic = projection.m[3][3] != 0.f;
+   return view;
+  }
+ };
+
+ /**
+  * @struct LodObjects
+  * @brief SoA bounding spheres and LOD thresholds of the objects to select for.
+  */
+ struct LodObjects {
+  EngineMath::batch::ConstSoA3 centers;
+  const float* radii;
+  const float* const* thresholds; ///< thresholdCount arrays of n pixel sizes, decreasing with the level
+  size_t thresholdCount;          ///< At most LOD_MAX_THRESHOLDS are used
+ };
+
+ /**
+  * @struct LodSettings
+  * @brief Knobs shared by every object of one selectLods() call.
+  */
+ struct LodSettings {
+  float hysteresis = 0.1f;   ///< Half-width of the dead band around each threshold, as a fraction
+  float bias = 1.f;          ///< Multiplies every projected size; below 1 prefers coarser levels
+  float minScreenSize = 0.f; ///< Objects smaller than this many pixels are left out of the draw list
+ };
+
+ namespace detail {
+  /** Levels and draw list of the objects [begin, end), written to lods and out from out[0]. */
+  inline size_t
+   selectLodsRange(const LodView& view, const CullPlanes* planes, const LodObjects& objects,
+                   const LodSettings& settings, size_t begin, size_t end, uint8_t* lods, uint32_t* out) {
+   const BatchLanes ex = BatchLanes::set1(view.eye.x), ey = BatchLanes::set1(view.eye.y);
+   const BatchLanes ez = BatchLanes::set1(view.eye.z);
+   const BatchLanes scale = BatchLanes::set1(view.scale * settings.bias);
+   const BatchLanes down = BatchLanes::set1(1.f - settings.hysteresis), up = BatchLanes::set1(1.f + settings.hysteresis);
+   const BatchLanes minSize = BatchLanes::set1(settings.minScreenSize);
+   const BatchLanes nearest = BatchLanes::set1(1e-12f);
+   const BatchInt one = BatchInt::set1(1);
+   const size_t levelsUsed = objects.thresholdCount < LOD_MAX_THRESHOLDS ? objects.thresholdCount : LOD_MAX_THRESHOLDS;
+   size_t found = 0;
+   for (size_t i = begin; i < end; i += BATCH_WIDTH) {
+    const size_t count = end - i < BATCH_WIDTH ? end - i : BATCH_WIDTH;
+    const BatchLanes x = loadLanes(objects.centers.x, i, count), y = loadLanes(objects.centers.y, i, count);
+    const BatchLanes z = loadLanes(objects.centers.z, i, count);
+    const BatchLanes r = loadLanes(objects.radii, i, count);
+
+    BatchLanes size = r * scale;
+    if (!view.orthographic) {
+     const BatchLanes dx = x - ex, dy = y - ey, dz = z - ez;
+     const BatchLanes distSq = EU::SIMD::madd(dz, dz, EU::SIMD::madd(dy, dy, dx * dx));
+     size = size * EngineMath::batch::kernels::rsqrt(EU::SIMD::max(distSq, nearest));
+    }
+
+    int32_t previous[BATCH_WIDTH];
+    for (size_t k = 0; k < count; ++k) previous[k] = lods[i + k];
+    for (size_t k = count; k < BATCH_WIDTH; ++k) previous[k] = 0;
+    const BatchInt was = BatchInt::load(previous);
+    BatchInt level = BatchInt::set1(0);
+    for (size_t t = 0; t < levelsUsed; ++t) {
+     // Coarser than t last frame: stay there until the size clearly exceeds the threshold.
+     const BatchLanes threshold = loadLanes(objects.thresholds[t], i, count);
+     const BatchLanes coarser = EU::SIMD::asFloat(was > BatchInt::set1(int(t)));
+     const BatchLanes below = size < threshold * EU::SIMD::select(coarser, up, down);
+     level = level + (EU::SIMD::asInt(below) & one);
+    }
+    int32_t levels[BATCH_WIDTH];
+    level.store(levels);
+    for (size_t k = 0; k < count; ++k) lods[i + k] = static_cast<uint8_t>(levels[k]);
+
+    BatchLanes keep = size >= minSize;
+    if (planes) {
+     const BatchLanes negRadius = BatchLanes::zero() - r;
+     for (int p = 0; p < 6; ++p) keep = keep & (planes->distance(p, x, y, z) >= negRadius);
+    }
+    found = appendLanes(keep, count, static_cast<uint32_t>(i), out, found);
+   }
+   return found;
+  }
+ }
+
+ /**
+  * @brief Updates the LOD level of every object and lists the ones to draw.
+  * @param frustum Planes to cull against, or nullptr to keep every object on screen.
+  * @param lods Previous level of each object on entry (0 the first time), new level on return.
+  * @param drawList Room for n indices; also used as per-chunk scratch.
+  * @param threads Worker threads for large sets, 0 for hardware_concurrency().
+  * @return Number of indices written to drawList, ascending.
+  */
+ inline size_t
+  selectLods(const LodView& view, const Frustum* frustum, const LodObjects& objects, size_t n, uint8_t* lods,
+             uint32_t* drawList, const LodSettings& settings = LodSettings(), size_t threads = 0) {
+  EU_TRACE_ZONE("selectLods");
+  const detail::CullPlanes planes(frustum ? *frustum : Frustum());
+  const detail::CullPlanes* cull = frustum ? &planes : nullptr;
+  const size_t found = detail::cullChunks(n, threads, drawList, [&](size_t begin, size_t end, uint32_t* out) {
+   return detail::selectLodsRange(view, cull, objects, settings, begin, end, lods, out);
+  });
+  EU_TRACE_COUNTER("LOD objects drawn", found);
+  return found;
+ }
+}
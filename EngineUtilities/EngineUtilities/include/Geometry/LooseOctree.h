@@ -0,0 +1,480 @@
+/**
+ * @file LooseOctree.h
+ * @brief Dynamic loose octree over AABBs: O(1) updates for objects that stay in their node,
+ * and frustum, sphere and ray queries.
+ *
+ * The root is the cube around the world box given at construction; a node at depth d is one
+ * of the 8^d cells of half-size h = rootHalf / 2^d, and its loose bounds are the cell grown by
+ * h on every side. An object is filed at the deepest depth whose h is at least its largest
+ * half-extent, in the cell containing its center, so its box always lies inside that node's
+ * loose bounds. Queries prune by the loose bounds and test the object boxes, so they never
+ * miss an object; a subtree wholly inside the frustum is taken without further tests.
+ *
+ * Nodes are identified by their locational code, 1 followed by the 3d bits of the cell's
+ * Morton code, and found through an open-addressing hash table, so an insert goes straight to
+ * its node and only creates the missing ancestors. Only nodes with objects below them exist:
+ * a node left empty is returned to the pool along with its empty ancestors. Objects chain
+ * through their node in an intrusive list, and objects, nodes and the table recycle their
+ * slots, so once the pools have grown to the scene size nothing is allocated. Nodes live in
+ * a Pool, whose fixed blocks keep a subtree created together on neighbouring cache lines and
+ * never copy the nodes as the tree grows.
+ *
+ * update() keeps an object in place when its new box still lies inside its node's loose
+ * bounds and would not fit one level deeper, which is O(1); otherwise it is moved. Objects
+ * that stick out of the world cube are kept at the root, which every query tests in full.
+ *
+ * Queries append the ids they find in traversal order.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Constants.h>
+#include <Core/Pool.h>
+#include <Geometry/Frustum.h>
+#include <Geometry/Primitives.h>
+#include <Math/EngineMath.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /// Deepest level a LooseOctree may use; locational codes take 3 bits per level.
+ constexpr uint32_t OCTREE_MAX_DEPTH = 20;
+ constexpr uint32_t OCTREE_NONE = 0xffffffffu;
+
+ namespace detail {
+  /** Spreads the low 21 bits of v three bits apart. */
+  inline uint64_t
+   spreadBits3(uint64_t v) {
+   v &= 0x1fffffu;
+   v = (v | (v << 32)) & 0x1f00000000ffffull;
+   v = (v | (v << 16)) & 0x1f0000ff0000ffull;
+   v = (v | (v << 8)) & 0x100f00f00f00f00full;
+   v = (v | (v << 4)) & 0x10c30c30c30c30c3ull;
+   v = (v | (v << 2)) & 0x1249249249249249ull;
+   return v;
+  }
+
+  /** True when every plane has the whole box [lo, hi] on its inner side. */
+  inline bool
+   frustumContainsBox(const Frustum& frustum, const CVector3& lo, const CVector3& hi) {
+   for (int p = 0; p < 6; ++p) {
+    const float* plane = frustum.planes[p];
+    const CVector3 corner(plane[0] > 0.f ? lo.x : hi.x, plane[1] > 0.f ? lo.y : hi.y, plane[2] > 0.f ? lo.z : hi.z);
+    if (frustum.distance(p, corner) < 0.f) return false;
+   }
+   return true;
+  }
+ }
+
+ /**
+  * @class LooseOctree
+  * @brief Loose octree of AABBs with stable ids; see the file comment.
+  */
+ class
+  LooseOctree {
+  public:
+  /**
+   * @brief Octree over the cube around world, at most maxDepth (<= OCTREE_MAX_DEPTH) levels
+   * below the root.
+   */
+  explicit LooseOctree(const AABB& world = AABB(CVector3(-1024.f, -1024.f, -1024.f), CVector3(1024.f, 1024.f, 1024.f)),
+                       uint32_t maxDepth = 10) {
+   const CVector3 half = world.halfExtents();
+   m_center = world.center();
+   m_half = std::max(half.x, std::max(half.y, half.z));
+   if (!(m_half > 0.f)) m_half = 1.f;
+   m_maxDepth = maxDepth < OCTREE_MAX_DEPTH ? maxDepth : OCTREE_MAX_DEPTH;
+   clear();
+  }
+
+  /** @brief Removes every object and node, keeping the pools' storage. */
+  void
+   clear() {
+   m_objects.clear();
+   m_freeObjects.clear();
+   m_nodes.clear();
+   m_keys.assign(m_keys.empty() ? 64 : m_keys.size(), 0);
+   m_slots.assign(m_keys.size(), OCTREE_NONE);
+   m_live = 0;
+   m_root = createNode(1, OCTREE_NONE, m_center, m_half);
+  }
+
+  /** @brief Adds an object and returns its id; ids of removed objects are reused. */
+  uint32_t
+   insert(const AABB& box) {
+   uint32_t id;
+   if (!m_freeObjects.empty()) {
+    id = m_freeObjects.back();
+    m_freeObjects.pop_back();
+   }
+   else {
+    id = static_cast<uint32_t>(m_objects.size());
+    m_objects.push_back(Object{});
+   }
+   m_objects[id].box = box;
+   link(id, place(box));
+   ++m_live;
+   return id;
+  }
+
+  /** @brief Moves object id to box; an id that is not alive is ignored. */
+  void
+   update(uint32_t id, const AABB& box) {
+   if (!alive(id)) return;
+   Object& object = m_objects[id];
+   const Node& node = m_nodes[object.node];
+   const CVector3 half = box.halfExtents();
+   const float extent = std::max(half.x, std::max(half.y, half.z));
+   const bool deeper = node.depth < m_maxDepth && extent <= node.half * 0.5f;
+   if (!deeper && looseBounds(node).contains(box)) {
+    object.box = box;
+    return;
+   }
+   unlink(id);
+   object.box = box;
+   link(id, place(box));
+  }
+
+  /** @brief Removes object id; an id that is not alive is ignored. */
+  void
+   remove(uint32_t id) {
+   if (!alive(id)) return;
+   unlink(id);
+   m_objects[id].node = OCTREE_NONE;
+   m_freeObjects.push_back(id);
+   --m_live;
+  }
+
+  bool
+   alive(uint32_t id) const {
+   return id < m_objects.size() && m_objects[id].node != OCTREE_NONE;
+  }
+
+  /** @brief Box of object id as last inserted or updated. */
+  const AABB&
+   bounds(uint32_t id) const {
+   return m_objects[id].box;
+  }
+
+  /** @brief Number of live objects. */
+  size_t
+   size() const {
+   return m_live;
+  }
+
+  /** @brief Number of live nodes, the root included. */
+  size_t
+   nodeCount() const {
+   return m_nodes.size();
+  }
+
+  /**
+   * @brief Appends the ids of the objects whose box may be visible in frustum (see
+   * Frustum::intersectsBox()); returns how many were appended.
+   */
+  size_t
+   query(const Frustum& frustum, std::vector<uint32_t>& out) const {
+   const size_t before = out.size();
+   Visit stack[STACK_SIZE];
+   size_t top = 0;
+   stack[top++] = Visit{ m_root, false };
+   while (top > 0) {
+    const Visit visit = stack[--top];
+    const Node& node = m_nodes[visit.node];
+    bool inside = visit.inside;
+    if (!inside && visit.node != m_root) {
+     const AABB loose = looseBounds(node);
+     if (!frustum.intersectsBox(loose.min, loose.max)) continue;
+     inside = detail::frustumContainsBox(frustum, loose.min, loose.max);
+    }
+    for (uint32_t o = node.first; o != OCTREE_NONE; o = m_objects[o].next) {
+     const AABB& box = m_objects[o].box;
+     if (inside || frustum.intersectsBox(box.min, box.max)) out.push_back(o);
+    }
+    pushChildren(node, inside, stack, top);
+   }
+   return out.size() - before;
+  }
+
+  /** @brief Appends the ids of the objects whose box touches sphere; returns how many. */
+  size_t
+   query(const Sphere& sphere, std::vector<uint32_t>& out) const {
+   const size_t before = out.size();
+   Visit stack[STACK_SIZE];
+   size_t top = 0;
+   stack[top++] = Visit{ m_root, false };
+   while (top > 0) {
+    const Visit visit = stack[--top];
+    const Node& node = m_nodes[visit.node];
+    if (visit.node != m_root && !looseBounds(node).intersects(sphere)) continue;
+    for (uint32_t o = node.first; o != OCTREE_NONE; o = m_objects[o].next) {
+     if (m_objects[o].box.intersects(sphere)) out.push_back(o);
+    }
+    pushChildren(node, false, stack, top);
+   }
+   return out.size() - before;
+  }
+
+  /**
+   * @brief Appends the ids of the objects whose box ray enters within [0, tMax]; returns how
+   * many were appended.
+   */
+  size_t
+   query(const Ray& ray, float tMax, std::vector<uint32_t>& out) const {
+   const size_t before = out.size();
+   const CVector3 inv = ray.inverseDirection();
+   Visit stack[STACK_SIZE];
+   size_t top = 0;
+   stack[top++] = Visit{ m_root, false };
+   while (top > 0) {
+    const Visit visit = stack[--top];
+    const Node& node = m_nodes[visit.node];
+    float t = 0.f;
+    if (visit.node != m_root && !looseBounds(node).intersectsRay(ray.origin, inv, tMax, t)) continue;
+    for (uint32_t o = node.first; o != OCTREE_NONE; o = m_objects[o].next) {
+     if (m_objects[o].box.intersectsRay(ray.origin, inv, tMax, t)) out.push_back(o);
+    }
+    pushChildren(node, false, stack, top);
+   }
+   return out.size() - before;
+  }
+
+  /**
+   * @brief Object whose box ray enters first within [0, tMax], for picking; ties go to the
+   * first found. id and t are left unchanged on a miss.
+   */
+  bool
+   raycast(const Ray& ray, float tMax, uint32_t& id, float& t) const {
+   const CVector3 inv = ray.inverseDirection();
+   Visit stack[STACK_SIZE];
+   size_t top = 0;
+   stack[top++] = Visit{ m_root, false };
+   bool found = false;
+   while (top > 0) {
+    const Visit visit = stack[--top];
+    const Node& node = m_nodes[visit.node];
+    float hit = 0.f;
+    if (visit.node != m_root && !looseBounds(node).intersectsRay(ray.origin, inv, tMax, hit)) continue;
+    for (uint32_t o = node.first; o != OCTREE_NONE; o = m_objects[o].next) {
+     if (m_objects[o].box.intersectsRay(ray.origin, inv, tMax, hit) && (!found || hit < tMax)) {
+      tMax = hit;
+      id = o;
+      t = hit;
+      found = true;
+     }
+    }
+    pushChildren(node, false, stack, top);
+   }
+   return found;
+  }
+
+  private:
+  struct Object {
+   AABB box;
+   uint32_t node = OCTREE_NONE;
+   uint32_t prev = OCTREE_NONE;
+   uint32_t next = OCTREE_NONE;
+  };
+
+  struct Node {
+   CVector3 center;  ///< Cell center
+   float half;       ///< Cell half-size; the loose bounds reach twice as far
+   uint64_t key;     ///< Locational code
+   uint32_t parent;  ///< OCTREE_NONE for the root
+   uint32_t depth;
+   uint32_t first;   ///< Head of the node's object list
+   uint32_t count;   ///< Objects in the list
+   uint32_t children;///< Live children
+   uint32_t child[8];
+  };
+
+  struct Visit {
+   uint32_t node;
+   bool inside; ///< Already known to lie wholly inside the frustum
+  };
+
+  /// A depth-first walk keeps at most 7 pending siblings per level plus the current node.
+  static constexpr size_t STACK_SIZE = 8 * (OCTREE_MAX_DEPTH + 1);
+
+  static AABB
+   looseBounds(const Node& node) {
+   const float r = 2.f * node.half;
+   return AABB(node.center - CVector3(r, r, r), node.center + CVector3(r, r, r));
+  }
+
+  void
+   pushChildren(const Node& node, bool inside, Visit* stack, size_t& top) const {
+   if (node.children == 0) return;
+   for (int c = 0; c < 8; ++c) {
+    if (node.child[c] != OCTREE_NONE) stack[top++] = Visit{ node.child[c], inside };
+   }
+  }
+
+  /** Node for box: the deepest whose cell half-size covers the box, creating it as needed. */
+  uint32_t
+   place(const AABB& box) {
+   const CVector3 half = box.halfExtents(), center = box.center();
+   const float extent = std::max(half.x, std::max(half.y, half.z));
+   uint32_t depth = 0;
+   float h = m_half;
+   while (depth < m_maxDepth && extent <= h * 0.5f) {
+    h *= 0.5f;
+    ++depth;
+   }
+   if (depth == 0) return m_root;
+   const float cells = static_cast<float>(1u << depth), scale = cells / (2.f * m_half);
+   const float limit = cells - 1.f;
+   const CVector3 corner = m_center - CVector3(m_half, m_half, m_half);
+   const float fx = (center.x - corner.x) * scale, fy = (center.y - corner.y) * scale, fz = (center.z - corner.z) * scale;
+   // Outside the world cube the cell would not contain the box's center, nor its loose bounds the box.
+   if (!(fx >= 0.f && fx < cells && fy >= 0.f && fy < cells && fz >= 0.f && fz < cells)) return m_root;
+   const uint32_t ix = static_cast<uint32_t>(std::min(fx, limit));
+   const uint32_t iy = static_cast<uint32_t>(std::min(fy, limit));
+   const uint32_t iz = static_cast<uint32_t>(std::min(fz, limit));
+   const uint64_t key = (uint64_t(1) << (3 * depth)) | detail::spreadBits3(ix) | (detail::spreadBits3(iy) << 1) |
+                        (detail::spreadBits3(iz) << 2);
+   return findOrCreate(key, depth);
+  }
+
+  /** Finds the node with key, creating it and any missing ancestors. */
+  uint32_t
+   findOrCreate(uint64_t key, uint32_t depth) {
+   const uint32_t found = find(key);
+   if (found != OCTREE_NONE) return found;
+   const uint32_t parent = findOrCreate(key >> 3, depth - 1);
+   const int octant = static_cast<int>(key & 7u);
+   const Node& p = m_nodes[parent];
+   const float h = p.half * 0.5f;
+   const CVector3 center(p.center.x + ((octant & 1) ? h : -h), p.center.y + ((octant & 2) ? h : -h),
+                         p.center.z + ((octant & 4) ? h : -h));
+   const uint32_t node = createNode(key, parent, center, h);
+   m_nodes[node].depth = depth;
+   m_nodes[parent].child[octant] = node;
+   ++m_nodes[parent].children;
+   return node;
+  }
+
+  uint32_t
+   createNode(uint64_t key, uint32_t parent, const CVector3& center, float half) {
+   const uint32_t index = m_nodes.allocate();
+   Node& node = m_nodes[index];
+   node.center = center;
+   node.half = half;
+   node.key = key;
+   node.parent = parent;
+   node.depth = 0;
+   node.first = OCTREE_NONE;
+   node.count = 0;
+   node.children = 0;
+   for (uint32_t& c : node.child) c = OCTREE_NONE;
+   tableInsert(key, index);
+   return index;
+  }
+
+  void
+   link(uint32_t id, uint32_t node) {
+   Object& object = m_objects[id];
+   Node& n = m_nodes[node];
+   object.node = node;
+   object.prev = OCTREE_NONE;
+   object.next = n.first;
+   if (n.first != OCTREE_NONE) m_objects[n.first].prev = id;
+   n.first = id;
+   ++n.count;
+  }
+
+  /** Takes id off its node's list and releases the node and its ancestors once empty. */
+  void
+   unlink(uint32_t id) {
+   const Object& object = m_objects[id];
+   uint32_t node = object.node;
+   if (object.prev != OCTREE_NONE) {
+    m_objects[object.prev].next = object.next;
+   }
+   else {
+    m_nodes[node].first = object.next;
+   }
+   if (object.next != OCTREE_NONE) m_objects[object.next].prev = object.prev;
+   --m_nodes[node].count;
+   while (node != m_root && m_nodes[node].count == 0 && m_nodes[node].children == 0) {
+    const Node& n = m_nodes[node];
+    const uint32_t up = n.parent;
+    Node& parent = m_nodes[up];
+    parent.child[n.key & 7u] = OCTREE_NONE;
+    --parent.children;
+    tableErase(n.key);
+    m_nodes.release(node);
+    node = up;
+   }
+  }
+
+  size_t
+   bucket(uint64_t key) const {
+   return static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> 32) & (m_keys.size() - 1);
+  }
+
+  uint32_t
+   find(uint64_t key) const {
+   for (size_t i = bucket(key);; i = (i + 1) & (m_keys.size() - 1)) {
+    if (m_keys[i] == key) return m_slots[i];
+    if (m_keys[i] == 0) return OCTREE_NONE;
+   }
+  }
+
+  void
+   tableInsert(uint64_t key, uint32_t node) {
+   if (2 * (nodeCount() + 1) > m_keys.size()) {
+    // Rehash into a table twice the size; stays at most half full.
+    std::vector<uint64_t> keys(m_keys.size() * 2, 0);
+    std::vector<uint32_t> slots(keys.size(), OCTREE_NONE);
+    keys.swap(m_keys);
+    slots.swap(m_slots);
+    for (size_t i = 0; i < keys.size(); ++i) {
+     if (keys[i] != 0) tablePlace(keys[i], slots[i]);
+    }
+   }
+   tablePlace(key, node);
+  }
+
+  void
+   tablePlace(uint64_t key, uint32_t node) {
+   size_t i = bucket(key);
+   while (m_keys[i] != 0) i = (i + 1) & (m_keys.size() - 1);
+   m_keys[i] = key;
+   m_slots[i] = node;
+  }
+
+  /** Linear-probing delete by backward shift, so lookups need no tombstones. */
+  void
+   tableErase(uint64_t key) {
+   const size_t mask = m_keys.size() - 1;
+   size_t i = bucket(key);
+   while (m_keys[i] != key) i = (i + 1) & mask;
+   for (size_t j = (i + 1) & mask; m_keys[j] != 0; j = (j + 1) & mask) {
+    const size_t home = bucket(m_keys[j]);
+    // Entry j may move into the hole at i unless its home lies cyclically in (i, j].
+    if (((j - home) & mask) >= ((j - i) & mask)) {
+     m_keys[i] = m_keys[j];
+     m_slots[i] = m_slots[j];
+     i = j;
+    }
+   }
+   m_keys[i] = 0;
+   m_slots[i] = OCTREE_NONE;
+  }
+
+  std::vector<Object> m_objects;
+  std::vector<uint32_t> m_freeObjects;
+  Pool<Node> m_nodes;
+  std::vector<uint64_t> m_keys;  ///< Locational codes, 0 for an empty bucket
+  std::vector<uint32_t> m_slots; ///< Node of each bucket
+  CVector3 m_center;
+  float m_half = 1.f;
+  uint32_t m_maxDepth = 10;
+  uint32_t m_root = 0;
+  size_t m_live = 0;
+ };
+}
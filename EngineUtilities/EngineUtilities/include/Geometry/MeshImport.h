@@ -0,0 +1,1000 @@
+/**
+ * @file MeshImport.h
+ * @brief Parallel OBJ and PLY import into SoA position, normal and UV streams with a
+ * triangle-list index buffer.
+ *
+ * loadMesh() memory-maps the file (MappedFile, PackFile.h) and parses it in place; the
+ * import functions take text already in memory. Text is cut into chunks of about
+ * MESH_IMPORT_CHUNK bytes at line breaks and the chunks are parsed as detail::parallelTasks().
+ * Numbers go through a hand-written parser (no locale, no per-token allocation); decimals
+ * with up to 15 significant digits and exponents within 1e+-22, which covers what exporters
+ * write, convert exactly, anything else through std::pow.
+ *
+ * OBJ takes two passes. The first counts the v, vt and vn lines and the triangles of every
+ * chunk, so the second knows where each chunk's attributes and triangles go and writes them
+ * straight into shared arrays, also resolving negative (relative) indices. Polygons are
+ * triangulated as fans. An OBJ corner indexes position, UV and normal separately, so corners
+ * are then welded into vertices: each distinct (position, UV, normal) triple becomes one
+ * output vertex, numbered in order of first use. The weld is a single pass over a chain per
+ * position rather than a hash table, and is skipped when no corner has a UV or normal.
+ * Only v, vt, vn and f are read; groups, materials, lines and free-form geometry are skipped.
+ *
+ * PLY vertices are already unique. The ASCII body is chunked the same way; each record's
+ * element follows from its line number. In binary files vertex records of fixed size are
+ * decoded in parallel batches of MESH_IMPORT_RECORDS, and faces, whose records vary in
+ * length, are read in one pass. Vertex properties x/y/z, nx/ny/nz and u/v (or s/t,
+ * texture_u/texture_v) are read; faces need a vertex_indices (or vertex_index) list.
+ *
+ * Files that do not parse, and indices outside the attribute arrays, make the import return
+ * false with an empty mesh.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <Core/PackFile.h>
+#include <Core/Parallel.h>
+#include <Core/Trace.h>
+#include <Vectors/Vector3Stream.h>
+
+namespace EU {
+ /// Bytes of text one parser task handles; every chunk ends at a line break.
+ constexpr size_t MESH_IMPORT_CHUNK = size_t(1) << 20;
+ /// Fixed-size binary PLY records one task decodes, and vertices one gather task writes.
+ constexpr size_t MESH_IMPORT_RECORDS = size_t(1) << 16;
+
+ /**
+  * @brief Mesh read by importOBJ(), importPLY() or loadMesh(): one entry per vertex in each
+  * attribute stream, three indices per triangle.
+  */
+ struct ImportedMesh {
+  Vector3Stream positions;
+  Vector3Stream normals;         ///< Empty when the file has none
+  std::vector<float> u;          ///< Empty when the file has no texture coordinates
+  std::vector<float> v;
+  std::vector<uint32_t> indices; ///< Triangle list
+
+  size_t
+   vertexCount() const {
+   return positions.size();
+  }
+
+  size_t
+   triangleCount() const {
+   return indices.size() / 3;
+  }
+
+  void
+   clear() {
+   positions.clear();
+   normals.clear();
+   u.clear();
+   v.clear();
+   indices.clear();
+  }
+ };
+
+ namespace detail {
+  constexpr uint32_t MESH_IMPORT_NONE = 0xffffffffu;
+
+  inline bool
+   meshSpace(char c) {
+   return c == ' ' || c == '\t' || c == '\r';
+  }
+
+  inline bool
+   meshDigit(char c) {
+   return static_cast<unsigned>(c - '0') < 10;
+  }
+
+  inline const char*
+   skipMeshSpace(const char* p, const char* end) {
+   while (p < end && meshSpace(*p)) ++p;
+   return p;
+  }
+
+  /** The '\n' ending the line at p, or end. */
+  inline const char*
+   meshLineEnd(const char* p, const char* end) {
+   const void* found = std::memchr(p, '\n', static_cast<size_t>(end - p));
+   return found ? static_cast<const char*>(found) : end;
+  }
+
+  /** Chunk boundaries of [begin, end): about chunk bytes each, cut after a line break. */
+  inline std::vector<const char*>
+   splitMeshLines(const char* begin, const char* end, size_t chunk) {
+   std::vector<const char*> cuts(1, begin);
+   const char* p = begin;
+   while (static_cast<size_t>(end - p) > chunk) {
+    p = meshLineEnd(p + chunk, end);
+    if (p == end) break;
+    cuts.push_back(++p);
+   }
+   if (cuts.back() != end) cuts.push_back(end);
+   return cuts;
+  }
+
+  /** Case-insensitive match of word at p, e.g. for "nan" and "inf". */
+  inline bool
+   meshWord(const char* p, const char* end, const char* word) {
+   for (; *word; ++word, ++p) {
+    if (p == end || (*p | 0x20) != *word) return false;
+   }
+   return true;
+  }
+
+  /**
+   * Parses a decimal float at p; returns the first character after it, or nullptr if there
+   * is none.
+   */
+  inline const char*
+   parseMeshFloat(const char* p, const char* end, float& out) {
+   static const double powers[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+   const bool negative = p < end && *p == '-';
+   if (p < end && (*p == '-' || *p == '+')) ++p;
+   uint64_t mantissa = 0;
+   int digits = 0, exponent = 0;
+   bool any = false;
+   for (; p < end && meshDigit(*p); ++p, any = true) {
+    if (digits < 19) {
+     mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+     digits += mantissa != 0;
+    }
+    else {
+     ++exponent;
+    }
+   }
+   if (p < end && *p == '.') {
+    for (++p; p < end && meshDigit(*p); ++p, any = true) {
+     if (digits < 19) {
+      mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+      digits += mantissa != 0;
+      --exponent;
+     }
+    }
+   }
+   if (!any) {
+    const float special = meshWord(p, end, "nan") ? std::numeric_limits<float>::quiet_NaN()
+                        : meshWord(p, end, "inf") ? std::numeric_limits<float>::infinity()
+                                                  : 0.f;
+    if (special == 0.f) return nullptr;
+    while (p < end && ((*p | 0x20) >= 'a' && (*p | 0x20) <= 'z')) ++p;
+    out = negative ? -special : special;
+    return p;
+   }
+   if (p < end && (*p == 'e' || *p == 'E')) {
+    const char* q = p + 1;
+    const bool negativeExponent = q < end && *q == '-';
+    if (q < end && (*q == '-' || *q == '+')) ++q;
+    if (q < end && meshDigit(*q)) {
+     int e = 0;
+     for (; q < end && meshDigit(*q); ++q) {
+      if (e < 10000) e = e * 10 + (*q - '0');
+     }
+     exponent += negativeExponent ? -e : e;
+     p = q;
+    }
+   }
+   double value = static_cast<double>(mantissa);
+   if (mantissa != 0 && exponent != 0) {
+    // Both factors exact in a double: the quotient or product is correctly rounded.
+    if (exponent >= -22 && exponent <= 22 && mantissa <= (uint64_t(1) << 53)) {
+     value = exponent < 0 ? value / powers[-exponent] : value * powers[exponent];
+    }
+    else {
+     value *= std::pow(10.0, static_cast<double>(std::max(-400, std::min(400, exponent))));
+    }
+   }
+   out = static_cast<float>(negative ? -value : value);
+   return p;
+  }
+
+  /** Parses a decimal integer at p; nullptr if there is none. */
+  inline const char*
+   parseMeshInt(const char* p, const char* end, int64_t& out) {
+   const bool negative = p < end && *p == '-';
+   if (p < end && (*p == '-' || *p == '+')) ++p;
+   if (p == end || !meshDigit(*p)) return nullptr;
+   int64_t value = 0;
+   for (; p < end && meshDigit(*p); ++p) {
+    if (value < (int64_t(1) << 40)) value = value * 10 + (*p - '0');
+   }
+   out = negative ? -value : value;
+   return p;
+  }
+
+  /** Indices of one OBJ corner, MESH_IMPORT_NONE for a missing UV or normal. */
+  struct ObjCorner {
+   uint32_t p, t, n;
+  };
+
+  /** Per-chunk OBJ counts from the first pass, turned into start offsets before the second. */
+  struct ObjChunk {
+   size_t positions = 0;
+   size_t uvs = 0;
+   size_t normals = 0;
+   size_t triangles = 0;
+   bool usesUV = false;
+   bool usesNormal = false;
+   bool ok = true;
+  };
+
+  enum ObjLine {
+   OBJ_OTHER,
+   OBJ_POSITION,
+   OBJ_UV,
+   OBJ_NORMAL,
+   OBJ_FACE,
+  };
+
+  /** Kind of the line [p, lineEnd); moves p past the keyword. */
+  inline ObjLine
+   objLineKind(const char*& p, const char* lineEnd) {
+   p = skipMeshSpace(p, lineEnd);
+   if (lineEnd - p < 2) return OBJ_OTHER;
+   if (p[0] == 'v') {
+    if (meshSpace(p[1])) {
+     p += 1;
+     return OBJ_POSITION;
+    }
+    if (lineEnd - p >= 3 && meshSpace(p[2])) {
+     if (p[1] == 't') {
+      p += 2;
+      return OBJ_UV;
+     }
+     if (p[1] == 'n') {
+      p += 2;
+      return OBJ_NORMAL;
+     }
+    }
+    return OBJ_OTHER;
+   }
+   if (p[0] == 'f' && meshSpace(p[1])) {
+    p += 1;
+    return OBJ_FACE;
+   }
+   return OBJ_OTHER;
+  }
+
+  /** Corners on the rest of a face line; a '#' starting a token ends it. */
+  inline size_t
+   objFaceCorners(const char* p, const char* lineEnd) {
+   size_t corners = 0;
+   for (;;) {
+    p = skipMeshSpace(p, lineEnd);
+    if (p == lineEnd || *p == '#') return corners;
+    ++corners;
+    while (p < lineEnd && !meshSpace(*p)) ++p;
+   }
+  }
+
+  /**
+   * 0-based index of the OBJ reference at p: 1-based from the start when positive, back
+   * from seen (the elements defined so far) when negative. nullptr when malformed or outside
+   * [0, total).
+   */
+  inline const char*
+   parseObjIndex(const char* p, const char* end, size_t seen, size_t total, uint32_t& out) {
+   int64_t value;
+   p = parseMeshInt(p, end, value);
+   if (p == nullptr || value == 0) return nullptr;
+   const int64_t index = value > 0 ? value - 1 : static_cast<int64_t>(seen) + value;
+   if (index < 0 || static_cast<uint64_t>(index) >= total) return nullptr;
+   out = static_cast<uint32_t>(index);
+   return p;
+  }
+
+  /** Counts of one chunk: attribute lines and fan triangles. */
+  inline void
+   countObjChunk(const char* p, const char* end, ObjChunk& chunk) {
+   while (p < end) {
+    const char* lineEnd = meshLineEnd(p, end);
+    switch (objLineKind(p, lineEnd)) {
+     case OBJ_POSITION: ++chunk.positions; break;
+     case OBJ_UV: ++chunk.uvs; break;
+     case OBJ_NORMAL: ++chunk.normals; break;
+     case OBJ_FACE: {
+      const size_t corners = objFaceCorners(p, lineEnd);
+      chunk.triangles += corners >= 3 ? corners - 2 : 0;
+      break;
+     }
+     default: break;
+    }
+    p = lineEnd + 1;
+   }
+  }
+
+  /** Shared output arrays of the OBJ second pass. */
+  struct ObjTarget {
+   Vector3Stream positions;
+   std::vector<float> u, v;
+   Vector3Stream normals;
+   std::unique_ptr<ObjCorner[]> corners;
+   size_t positionCount, uvCount, normalCount;
+  };
+
+  /** Second pass over one chunk; chunk holds its start offsets. */
+  inline void
+   parseObjChunk(const char* p, const char* end, ObjChunk& chunk, ObjTarget& target) {
+   size_t position = chunk.positions, uv = chunk.uvs, normal = chunk.normals, triangle = chunk.triangles;
+   float* px = target.positions.x();
+   float* py = target.positions.y();
+   float* pz = target.positions.z();
+   while (p < end) {
+    const char* lineEnd = meshLineEnd(p, end);
+    const ObjLine kind = objLineKind(p, lineEnd);
+    if (kind == OBJ_POSITION || kind == OBJ_NORMAL) {
+     float xyz[3];
+     for (float& c : xyz) {
+      p = parseMeshFloat(skipMeshSpace(p, lineEnd), lineEnd, c);
+      if (p == nullptr) {
+       chunk.ok = false;
+       return;
+      }
+     }
+     if (kind == OBJ_POSITION) {
+      px[position] = xyz[0];
+      py[position] = xyz[1];
+      pz[position] = xyz[2];
+      ++position;
+     }
+     else {
+      target.normals.x()[normal] = xyz[0];
+      target.normals.y()[normal] = xyz[1];
+      target.normals.z()[normal] = xyz[2];
+      ++normal;
+     }
+    }
+    else if (kind == OBJ_UV) {
+     float s = 0.f, t = 0.f;
+     p = parseMeshFloat(skipMeshSpace(p, lineEnd), lineEnd, s);
+     if (p == nullptr) {
+      chunk.ok = false;
+      return;
+     }
+     // The second coordinate is optional and defaults to 0.
+     const char* q = skipMeshSpace(p, lineEnd);
+     if (q < lineEnd && *q != '#' && parseMeshFloat(q, lineEnd, t) == nullptr) {
+      chunk.ok = false;
+      return;
+     }
+     target.u[uv] = s;
+     target.v[uv] = t;
+     ++uv;
+    }
+    else if (kind == OBJ_FACE) {
+     ObjCorner first = {}, previous = {};
+     for (size_t corner = 0;; ++corner) {
+      p = skipMeshSpace(p, lineEnd);
+      if (p == lineEnd || *p == '#') break;
+      ObjCorner c = { 0, MESH_IMPORT_NONE, MESH_IMPORT_NONE };
+      p = parseObjIndex(p, lineEnd, position, target.positionCount, c.p);
+      if (p != nullptr && p < lineEnd && *p == '/') {
+       ++p;
+       if (p < lineEnd && *p != '/') {
+        p = parseObjIndex(p, lineEnd, uv, target.uvCount, c.t);
+        chunk.usesUV = true;
+       }
+       if (p != nullptr && p < lineEnd && *p == '/') {
+        p = parseObjIndex(p + 1, lineEnd, normal, target.normalCount, c.n);
+        chunk.usesNormal = true;
+       }
+      }
+      if (p == nullptr || (p < lineEnd && !meshSpace(*p))) {
+       chunk.ok = false;
+       return;
+      }
+      if (corner == 0) {
+       first = c;
+      }
+      else if (corner >= 2) {
+       ObjCorner* out = &target.corners[3 * triangle++];
+       out[0] = first;
+       out[1] = previous;
+       out[2] = c;
+      }
+      previous = c;
+     }
+    }
+    p = lineEnd + 1;
+   }
+  }
+
+  enum class PlyType : uint8_t {
+   None,
+   Int8,
+   UInt8,
+   Int16,
+   UInt16,
+   Int32,
+   UInt32,
+   Float32,
+   Float64,
+  };
+
+  /** What the reader does with a PLY property. */
+  enum PlyRole {
+   PLY_SKIP,
+   PLY_X,
+   PLY_Y,
+   PLY_Z,
+   PLY_NX,
+   PLY_NY,
+   PLY_NZ,
+   PLY_U,
+   PLY_V,
+   PLY_INDICES,
+  };
+
+  struct PlyProperty {
+   PlyType type;      ///< Scalar type, or item type of a list
+   PlyType countType; ///< None for a scalar
+   PlyRole role;
+  };
+
+  struct PlyElement {
+   std::string name;
+   size_t count = 0;
+   std::vector<PlyProperty> properties;
+
+   /** Record size in bytes, or 0 if the element has lists. */
+   size_t
+    stride() const;
+
+   /** Smallest record size in bytes, every list empty. */
+   size_t
+    minimumSize() const;
+  };
+
+  inline size_t
+   plySize(PlyType type) {
+   static const size_t sizes[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+   return sizes[static_cast<size_t>(type)];
+  }
+
+  inline size_t
+   PlyElement::stride() const {
+   size_t bytes = 0;
+   for (const PlyProperty& property : properties) {
+    if (property.countType != PlyType::None) return 0;
+    bytes += plySize(property.type);
+   }
+   return bytes;
+  }
+
+  inline size_t
+   PlyElement::minimumSize() const {
+   size_t bytes = 0;
+   for (const PlyProperty& property : properties) {
+    bytes += plySize(property.countType != PlyType::None ? property.countType : property.type);
+   }
+   return bytes;
+  }
+
+  inline PlyType
+   plyType(const std::string& name) {
+   static const char* const names[][2] = { { "char", "int8" },   { "uchar", "uint8" },   { "short", "int16" },
+                                           { "ushort", "uint16" }, { "int", "int32" },   { "uint", "uint32" },
+                                           { "float", "float32" }, { "double", "float64" } };
+   for (size_t i = 0; i < 8; ++i) {
+    if (name == names[i][0] || name == names[i][1]) return static_cast<PlyType>(i + 1);
+   }
+   return PlyType::None;
+  }
+
+  inline PlyRole
+   plyVertexRole(const std::string& name) {
+   if (name == "x") return PLY_X;
+   if (name == "y") return PLY_Y;
+   if (name == "z") return PLY_Z;
+   if (name == "nx") return PLY_NX;
+   if (name == "ny") return PLY_NY;
+   if (name == "nz") return PLY_NZ;
+   if (name == "u" || name == "s" || name == "texture_u" || name == "texture_s") return PLY_U;
+   if (name == "v" || name == "t" || name == "texture_v" || name == "texture_t") return PLY_V;
+   return PLY_SKIP;
+  }
+
+  enum PlyFormat {
+   PLY_ASCII,
+   PLY_LITTLE_ENDIAN,
+   PLY_BIG_ENDIAN,
+  };
+
+  struct PlyHeader {
+   PlyFormat format = PLY_ASCII;
+   std::vector<PlyElement> elements;
+   size_t vertexElement = MESH_IMPORT_NONE;
+   size_t vertexCount = 0;
+   bool normals = false;
+   bool uvs = false;
+  };
+
+  /** Parses the header; returns the first byte of the body, or nullptr. */
+  inline const char*
+   parsePlyHeader(const char* p, const char* end, PlyHeader& header) {
+   bool formatSeen = false, roles[PLY_INDICES + 1] = {};
+   std::vector<std::string> words;
+   for (size_t line = 0; p < end; ++line) {
+    const char* lineEnd = meshLineEnd(p, end);
+    words.clear();
+    for (const char* q = skipMeshSpace(p, lineEnd); q < lineEnd; q = skipMeshSpace(q, lineEnd)) {
+     const char* word = q;
+     while (q < lineEnd && !meshSpace(*q)) ++q;
+     words.emplace_back(word, q);
+    }
+    p = lineEnd < end ? lineEnd + 1 : end;
+    if (line == 0) {
+     if (words.size() != 1 || words[0] != "ply") return nullptr;
+     continue;
+    }
+    if (words.empty() || words[0] == "comment" || words[0] == "obj_info") continue;
+    if (words[0] == "end_header") {
+     if (!formatSeen) return nullptr;
+     header.normals = roles[PLY_NX] && roles[PLY_NY] && roles[PLY_NZ];
+     header.uvs = roles[PLY_U] && roles[PLY_V];
+     return roles[PLY_X] && roles[PLY_Y] && roles[PLY_Z] ? p : nullptr;
+    }
+    if (words[0] == "format" && words.size() >= 2) {
+     formatSeen = true;
+     if (words[1] == "ascii") header.format = PLY_ASCII;
+     else if (words[1] == "binary_little_endian") header.format = PLY_LITTLE_ENDIAN;
+     else if (words[1] == "binary_big_endian") header.format = PLY_BIG_ENDIAN;
+     else return nullptr;
+    }
+    else if (words[0] == "element" && words.size() == 3) {
+     PlyElement element;
+     element.name = words[1];
+     element.count = static_cast<size_t>(std::strtoull(words[2].c_str(), nullptr, 10));
+     if (element.name == "vertex") {
+      if (header.vertexElement != MESH_IMPORT_NONE) return nullptr;
+      header.vertexElement = header.elements.size();
+      header.vertexCount = element.count;
+      if (element.count >= MESH_IMPORT_NONE) return nullptr;
+     }
+     header.elements.push_back(element);
+    }
+    else if (words[0] == "property" && !header.elements.empty()) {
+     PlyElement& element = header.elements.back();
+     PlyProperty property = { PlyType::None, PlyType::None, PLY_SKIP };
+     if (words.size() == 5 && words[1] == "list") {
+      property.countType = plyType(words[2]);
+      property.type = plyType(words[3]);
+      if (property.countType == PlyType::None) return nullptr;
+      if (element.name == "face" && (words[4] == "vertex_indices" || words[4] == "vertex_index")) {
+       property.role = PLY_INDICES;
+      }
+     }
+     else if (words.size() == 3) {
+      property.type = plyType(words[1]);
+      if (element.name == "vertex") property.role = plyVertexRole(words[2]);
+     }
+     if (property.type == PlyType::None) return nullptr;
+     roles[property.role] = true;
+     element.properties.push_back(property);
+    }
+    else {
+     return nullptr;
+    }
+   }
+   return nullptr;
+  }
+
+  /** Stores one PLY vertex property of vertex i. */
+  inline void
+   setPlyVertex(ImportedMesh& mesh, PlyRole role, size_t i, float value) {
+   switch (role) {
+    case PLY_X: mesh.positions.x()[i] = value; break;
+    case PLY_Y: mesh.positions.y()[i] = value; break;
+    case PLY_Z: mesh.positions.z()[i] = value; break;
+    case PLY_NX: mesh.normals.x()[i] = value; break;
+    case PLY_NY: mesh.normals.y()[i] = value; break;
+    case PLY_NZ: mesh.normals.z()[i] = value; break;
+    case PLY_U: mesh.u[i] = value; break;
+    case PLY_V: mesh.v[i] = value; break;
+    default: break;
+   }
+  }
+
+  /** Fan-triangulates a polygon of count vertices; false if an index is out of range. */
+  template<typename Index>
+  inline bool
+   appendPlyPolygon(std::vector<uint32_t>& out, size_t count, size_t vertexCount, Index index) {
+   uint32_t first = 0, previous = 0;
+   for (size_t k = 0; k < count; ++k) {
+    const int64_t value = index(k);
+    if (value < 0 || static_cast<uint64_t>(value) >= vertexCount) return false;
+    const uint32_t current = static_cast<uint32_t>(value);
+    if (k == 0) {
+     first = current;
+    }
+    else if (k >= 2) {
+     out.push_back(first);
+     out.push_back(previous);
+     out.push_back(current);
+    }
+    previous = current;
+   }
+   return true;
+  }
+
+  /** Value of a binary PLY scalar; swap reverses its bytes first. */
+  inline double
+   readPlyScalar(const unsigned char* p, PlyType type, bool swap) {
+   unsigned char b[8];
+   const size_t size = plySize(type);
+   std::memcpy(b, p, size);
+   if (swap) std::reverse(b, b + size);
+   switch (type) {
+    case PlyType::Int8: return static_cast<int8_t>(b[0]);
+    case PlyType::UInt8: return b[0];
+    case PlyType::Int16: { int16_t v; std::memcpy(&v, b, 2); return v; }
+    case PlyType::UInt16: { uint16_t v; std::memcpy(&v, b, 2); return v; }
+    case PlyType::Int32: { int32_t v; std::memcpy(&v, b, 4); return v; }
+    case PlyType::UInt32: { uint32_t v; std::memcpy(&v, b, 4); return v; }
+    case PlyType::Float32: { float v; std::memcpy(&v, b, 4); return v; }
+    case PlyType::Float64: { double v; std::memcpy(&v, b, 8); return v; }
+    default: return 0.0;
+   }
+  }
+
+  /** Sizes the vertex streams of mesh, once the body is known to hold the vertex records. */
+  inline void
+   resizePlyVertices(const PlyHeader& header, ImportedMesh& mesh) {
+   mesh.positions.resize(header.vertexCount);
+   if (header.normals) mesh.normals.resize(header.vertexCount);
+   if (header.uvs) {
+    mesh.u.resize(header.vertexCount);
+    mesh.v.resize(header.vertexCount);
+   }
+  }
+
+  /**
+   * Reads one binary record at p: vertex properties into vertex i of vertices, if not null,
+   * polygons into triangles. Returns the byte after the record, or nullptr if it runs past
+   * end or is malformed.
+   */
+  inline const unsigned char*
+   readPlyRecord(const unsigned char* p, const unsigned char* end, const PlyElement& element, bool swap,
+                 ImportedMesh* vertices, size_t i, std::vector<uint32_t>& triangles, size_t vertexCount) {
+   for (const PlyProperty& property : element.properties) {
+    const size_t size = plySize(property.type);
+    if (property.countType == PlyType::None) {
+     if (static_cast<size_t>(end - p) < size) return nullptr;
+     if (vertices != nullptr && property.role != PLY_SKIP) {
+      setPlyVertex(*vertices, property.role, i, static_cast<float>(readPlyScalar(p, property.type, swap)));
+     }
+     p += size;
+     continue;
+    }
+    const size_t countSize = plySize(property.countType);
+    if (static_cast<size_t>(end - p) < countSize) return nullptr;
+    const double count = readPlyScalar(p, property.countType, swap);
+    p += countSize;
+    if (!(count >= 0.0) || count > static_cast<double>(static_cast<size_t>(end - p) / size)) return nullptr;
+    const size_t n = static_cast<size_t>(count);
+    if (property.role == PLY_INDICES &&
+        !appendPlyPolygon(triangles, n, vertexCount, [&](size_t k) {
+         const double value = readPlyScalar(p + k * size, property.type, swap);
+         return value >= 0.0 ? static_cast<int64_t>(value) : int64_t(-1);
+        })) {
+     return nullptr;
+    }
+    p += n * size;
+   }
+   return p;
+  }
+
+  /**
+   * Reads one ASCII record: vertex properties into vertex i of vertices, if not null,
+   * polygons into triangles. false if a number is missing or malformed.
+   */
+  inline bool
+   readPlyLine(const char* p, const char* lineEnd, const PlyElement& element, ImportedMesh* vertices, size_t i,
+               std::vector<uint32_t>& triangles, size_t vertexCount) {
+   for (const PlyProperty& property : element.properties) {
+    float value;
+    if (property.countType == PlyType::None) {
+     p = parseMeshFloat(skipMeshSpace(p, lineEnd), lineEnd, value);
+     if (p == nullptr) return false;
+     if (vertices != nullptr) setPlyVertex(*vertices, property.role, i, value);
+     continue;
+    }
+    int64_t count;
+    p = parseMeshInt(skipMeshSpace(p, lineEnd), lineEnd, count);
+    if (p == nullptr || count < 0) return false;
+    if (property.role == PLY_INDICES) {
+     bool ok = true;
+     if (!appendPlyPolygon(triangles, static_cast<size_t>(count), vertexCount, [&](size_t) {
+          int64_t index = -1;
+          const char* next = ok ? parseMeshInt(skipMeshSpace(p, lineEnd), lineEnd, index) : nullptr;
+          ok = next != nullptr;
+          if (ok) p = next;
+          return ok ? index : int64_t(-1);
+         }) ||
+         !ok) {
+      return false;
+     }
+    }
+    else {
+     for (int64_t k = 0; k < count; ++k) {
+      p = parseMeshFloat(skipMeshSpace(p, lineEnd), lineEnd, value);
+      if (p == nullptr) return false;
+     }
+    }
+   }
+   return true;
+  }
+
+  inline bool
+   hostBigEndian() {
+   const uint16_t one = 1;
+   unsigned char first;
+   std::memcpy(&first, &one, 1);
+   return first == 0;
+  }
+
+  /** Concatenates per-chunk triangle lists into out, in chunk order. */
+  inline void
+   joinMeshTriangles(const std::vector<std::vector<uint32_t>>& parts, std::vector<uint32_t>& out, size_t threads) {
+   std::vector<size_t> starts(parts.size() + 1, 0);
+   for (size_t c = 0; c < parts.size(); ++c) starts[c + 1] = starts[c] + parts[c].size();
+   out.resize(starts.back());
+   parallelTasks(parts.size(), resolveThreads(threads, parts.size()), [&](size_t c) {
+    if (!parts[c].empty()) std::memcpy(out.data() + starts[c], parts[c].data(), parts[c].size() * sizeof(uint32_t));
+   });
+  }
+
+  inline bool
+   importPLYAscii(const char* body, const char* end, const PlyHeader& header, ImportedMesh& mesh, size_t threads) {
+   const std::vector<const char*> cuts = splitMeshLines(body, end, MESH_IMPORT_CHUNK);
+   const size_t chunks = cuts.size() - 1;
+   const size_t workers = resolveThreads(threads, chunks);
+   // First pass: records (non-blank lines) per chunk, turned into the first record of each.
+   std::vector<size_t> first(chunks + 1, 0);
+   parallelTasks(chunks, workers, [&](size_t c) {
+    size_t records = 0;
+    for (const char* p = cuts[c]; p < cuts[c + 1];) {
+     const char* lineEnd = meshLineEnd(p, cuts[c + 1]);
+     records += skipMeshSpace(p, lineEnd) < lineEnd;
+     p = lineEnd + 1;
+    }
+    first[c + 1] = records;
+   });
+   for (size_t c = 0; c < chunks; ++c) first[c + 1] += first[c];
+   // Every record is a line: counts past the lines left are malformed, checked before allocating.
+   std::vector<size_t> elementStart(header.elements.size() + 1, 0);
+   for (size_t e = 0; e < header.elements.size(); ++e) {
+    if (header.elements[e].count > first.back() - elementStart[e]) return false;
+    elementStart[e + 1] = elementStart[e] + header.elements[e].count;
+   }
+   resizePlyVertices(header, mesh);
+
+   std::vector<std::vector<uint32_t>> triangles(chunks);
+   std::vector<uint8_t> ok(chunks, 1);
+   parallelTasks(chunks, workers, [&](size_t c) {
+    size_t record = first[c], element = 0;
+    for (const char* p = cuts[c]; p < cuts[c + 1] && record < elementStart.back();) {
+     const char* lineEnd = meshLineEnd(p, cuts[c + 1]);
+     const char* text = skipMeshSpace(p, lineEnd);
+     p = lineEnd + 1;
+     if (text == lineEnd) continue;
+     while (record >= elementStart[element + 1]) ++element;
+     const PlyElement& e = header.elements[element];
+     const bool vertex = element == header.vertexElement;
+     if ((vertex || e.name == "face") && !readPlyLine(text, lineEnd, e, vertex ? &mesh : nullptr,
+                                                      record - elementStart[element], triangles[c], header.vertexCount)) {
+      ok[c] = 0;
+      return;
+     }
+     ++record;
+    }
+   });
+   if (std::find(ok.begin(), ok.end(), 0) != ok.end()) return false;
+   joinMeshTriangles(triangles, mesh.indices, threads);
+   return true;
+  }
+
+  inline bool
+   importPLYBinary(const char* body, const char* end, const PlyHeader& header, ImportedMesh& mesh, size_t threads) {
+   const bool swap = (header.format == PLY_BIG_ENDIAN) != hostBigEndian();
+   const unsigned char* p = reinterpret_cast<const unsigned char*>(body);
+   const unsigned char* last = reinterpret_cast<const unsigned char*>(end);
+   // Counts past what the bytes left could hold, lists empty, are malformed; checked before allocating.
+   size_t bytes = static_cast<size_t>(last - p);
+   for (const PlyElement& element : header.elements) {
+    const size_t size = element.minimumSize();
+    if (size == 0) continue;
+    if (element.count > bytes / size) return false;
+    bytes -= element.count * size;
+   }
+   resizePlyVertices(header, mesh);
+   std::vector<uint32_t> scratch;
+   for (size_t e = 0; e < header.elements.size(); ++e) {
+    const PlyElement& element = header.elements[e];
+    if (element.properties.empty()) continue;
+    const size_t stride = element.stride();
+    if (stride != 0) {
+     if (element.count > static_cast<size_t>(last - p) / stride) return false;
+     if (e == header.vertexElement) {
+      const size_t tasks = (element.count + MESH_IMPORT_RECORDS - 1) / MESH_IMPORT_RECORDS;
+      parallelTasks(tasks, resolveThreads(threads, tasks), [&](size_t t) {
+       const size_t begin = t * MESH_IMPORT_RECORDS;
+       const size_t stop = std::min(element.count, begin + MESH_IMPORT_RECORDS);
+       for (size_t i = begin; i < stop; ++i) {
+        readPlyRecord(p + i * stride, last, element, swap, &mesh, i, scratch, 0);
+       }
+      });
+     }
+     p += element.count * stride;
+     continue;
+    }
+    std::vector<uint32_t>& triangles = element.name == "face" ? mesh.indices : scratch;
+    if (element.name == "face") {
+     // As many triangles as the bytes left hold, so a count that lies cannot outgrow the file.
+     size_t triangleSize = element.minimumSize();
+     for (const PlyProperty& property : element.properties) {
+      if (property.role == PLY_INDICES) triangleSize += 3 * plySize(property.type);
+     }
+     triangles.reserve(std::min(element.count, static_cast<size_t>(last - p) / triangleSize) * 3);
+    }
+    ImportedMesh* vertices = e == header.vertexElement ? &mesh : nullptr;
+    for (size_t i = 0; i < element.count; ++i) {
+     p = readPlyRecord(p, last, element, swap, vertices, i, triangles, header.vertexCount);
+     if (p == nullptr) return false;
+    }
+    scratch.clear();
+   }
+   return true;
+  }
+ }
+
+ /**
+  * @brief Parses Wavefront OBJ text; false (and an empty mesh) if it is malformed or a face
+  * references a missing attribute.
+  * @param threads Worker threads, 0 for hardware_concurrency().
+  */
+ inline bool
+  importOBJ(const char* data, size_t size, ImportedMesh& mesh, size_t threads = 0) {
+  using namespace detail;
+  EU_TRACE_ZONE("importOBJ");
+  mesh.clear();
+  const char* end = data + size;
+  const std::vector<const char*> cuts = splitMeshLines(data, end, MESH_IMPORT_CHUNK);
+  const size_t chunks = cuts.size() - 1;
+  const size_t workers = resolveThreads(threads, chunks);
+  std::vector<ObjChunk> counts(chunks);
+  parallelTasks(chunks, workers, [&](size_t c) { countObjChunk(cuts[c], cuts[c + 1], counts[c]); });
+
+  ObjChunk total;
+  for (ObjChunk& chunk : counts) {
+   const ObjChunk here = chunk;
+   chunk.positions = total.positions;
+   chunk.uvs = total.uvs;
+   chunk.normals = total.normals;
+   chunk.triangles = total.triangles;
+   total.positions += here.positions;
+   total.uvs += here.uvs;
+   total.normals += here.normals;
+   total.triangles += here.triangles;
+  }
+  if (total.positions >= MESH_IMPORT_NONE || total.uvs >= MESH_IMPORT_NONE || total.normals >= MESH_IMPORT_NONE ||
+      total.triangles > MESH_IMPORT_NONE / 3) {
+   return false;
+  }
+  ObjTarget target;
+  target.positions.resize(total.positions);
+  target.normals.resize(total.normals);
+  target.u.resize(total.uvs);
+  target.v.resize(total.uvs);
+  target.corners.reset(new ObjCorner[3 * total.triangles]);
+  target.positionCount = total.positions;
+  target.uvCount = total.uvs;
+  target.normalCount = total.normals;
+  parallelTasks(chunks, workers, [&](size_t c) { parseObjChunk(cuts[c], cuts[c + 1], counts[c], target); });
+
+  bool usesUV = false, usesNormal = false;
+  for (const ObjChunk& chunk : counts) {
+   if (!chunk.ok) return false;
+   usesUV |= chunk.usesUV;
+   usesNormal |= chunk.usesNormal;
+  }
+  const size_t corners = 3 * total.triangles;
+  mesh.indices.resize(corners);
+  if (!usesUV && !usesNormal) {
+   for (size_t i = 0; i < corners; ++i) mesh.indices[i] = target.corners[i].p;
+   mesh.positions = std::move(target.positions);
+   return true;
+  }
+
+  // Weld: the output vertices with position p form a chain from head[p] through next[].
+  std::vector<uint32_t> head(total.positions, MESH_IMPORT_NONE), next;
+  std::vector<ObjCorner> unique;
+  unique.reserve(total.positions);
+  next.reserve(total.positions);
+  for (size_t i = 0; i < corners; ++i) {
+   const ObjCorner& c = target.corners[i];
+   uint32_t vertex = head[c.p];
+   while (vertex != MESH_IMPORT_NONE && (unique[vertex].t != c.t || unique[vertex].n != c.n)) vertex = next[vertex];
+   if (vertex == MESH_IMPORT_NONE) {
+    vertex = static_cast<uint32_t>(unique.size());
+    unique.push_back(c);
+    next.push_back(head[c.p]);
+    head[c.p] = vertex;
+   }
+   mesh.indices[i] = vertex;
+  }
+
+  const size_t vertices = unique.size();
+  mesh.positions.resize(vertices);
+  if (usesNormal) mesh.normals.resize(vertices);
+  if (usesUV) {
+   mesh.u.resize(vertices);
+   mesh.v.resize(vertices);
+  }
+  const size_t tasks = (vertices + MESH_IMPORT_RECORDS - 1) / MESH_IMPORT_RECORDS;
+  parallelTasks(tasks, resolveThreads(threads, tasks), [&](size_t t) {
+   const size_t stop = std::min(vertices, (t + 1) * MESH_IMPORT_RECORDS);
+   for (size_t i = t * MESH_IMPORT_RECORDS; i < stop; ++i) {
+    const ObjCorner& c = unique[i];
+    mesh.positions.set(i, target.positions.get(c.p));
+    if (usesNormal) mesh.normals.set(i, c.n != MESH_IMPORT_NONE ? target.normals.get(c.n) : CVector3(0.f, 0.f, 0.f));
+    if (usesUV) {
+     mesh.u[i] = c.t != MESH_IMPORT_NONE ? target.u[c.t] : 0.f;
+     mesh.v[i] = c.t != MESH_IMPORT_NONE ? target.v[c.t] : 0.f;
+    }
+   }
+  });
+  return true;
+ }
+
+ /**
+  * @brief Parses a PLY file (ASCII or binary, either byte order); false (and an empty mesh)
+  * if it is malformed, has no x/y/z vertex properties or a face references a missing vertex.
+  * @param threads Worker threads, 0 for hardware_concurrency().
+  */
+ inline bool
+  importPLY(const char* data, size_t size, ImportedMesh& mesh, size_t threads = 0) {
+  using namespace detail;
+  EU_TRACE_ZONE("importPLY");
+  mesh.clear();
+  const char* end = data + size;
+  PlyHeader header;
+  const char* body = parsePlyHeader(data, end, header);
+  if (body == nullptr) return false;
+  const bool ok = header.format == PLY_ASCII ? importPLYAscii(body, end, header, mesh, threads)
+                                             : importPLYBinary(body, end, header, mesh, threads);
+  if (!ok || mesh.indices.size() > MESH_IMPORT_NONE) {
+   mesh.clear();
+   return false;
+  }
+  return true;
+ }
+
+ /** @brief importPLY() if data starts with the PLY magic, importOBJ() otherwise. */
+ inline bool
+  importMesh(const char* data, size_t size, ImportedMesh& mesh, size_t threads = 0) {
+  if (size >= 3 && std::memcmp(data, "ply", 3) == 0) return importPLY(data, size, mesh, threads);
+  return importOBJ(data, size, mesh, threads);
+ }
+
+ /** @brief Maps the OBJ or PLY file at path and imports it; false if it cannot be read or parsed. */
+ inline bool
+  loadMesh(const char* path, ImportedMesh& mesh, size_t threads = 0) {
+  MappedFile file;
+  if (!file.open(path)) {
+   mesh.clear();
+   return false;
+  }
+  return importMesh(static_cast<const char*>(file.data()), file.size(), mesh, threads);
+ }
+}
@@ -0,0 +1,264 @@
+/**
+ * @file MeshNormals.h
+ * @brief Smooth vertex normals and MikkTSpace-style tangents for indexed triangle meshes.
+ *
+ * setTopology() copies the index buffer and counting-sorts its corners by vertex into a CSR
+ * adjacency (offsets plus triangle * 3 + corner entries, ascending). Every vertex then gathers
+ * its own faces instead of faces scattering into vertices, so chunks of vertices run on
+ * separate threads without atomics, and each sum is taken in ascending triangle order, so the
+ * results are identical for any thread count.
+ *
+ * computeNormals() weights each face by its area: face normals (the unnormalized cross of two
+ * edges) are computed one register of triangles at a time, summed per vertex and normalized.
+ * computeTangents() follows MikkTSpace: each face contributes the directions of increasing u
+ * and v, projected onto the vertex's tangent plane and weighted by the face's angle at that
+ * corner, and the summed u direction is orthonormalized against the normal. w is the
+ * bitangent sign, so bitangent = w * cross(normal, tangent.xyz). Unlike the reference
+ * implementation, vertices are never split, so a vertex shared by mirrored and unmirrored
+ * faces gets one averaged frame.
+ *
+ * The adjacency and the per-face scratch stay in the object, so recomputing every frame for
+ * the same topology allocates nothing. Large meshes are cut into fixed MESH_CHUNK-sized chunks
+ * over threads (0 = hardware_concurrency(), 1 = caller only).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector4.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ namespace detail {
+  /// Triangles or vertices per task; fixes the work split.
+  constexpr size_t MESH_CHUNK = 4096;
+  /// Meshes with fewer triangles and vertices than this are processed on the calling thread.
+  constexpr size_t PARALLEL_MESH_MIN = 16384;
+
+  /** Calls fn(begin, end) for every MESH_CHUNK-sized chunk of [0, n). */
+  template<typename Fn>
+  inline void
+   forEachMeshChunk(size_t n, size_t threads, Fn fn) {
+   const size_t chunks = (n + MESH_CHUNK - 1) / MESH_CHUNK;
+   parallelTasks(chunks, n < PARALLEL_MESH_MIN ? 1 : resolveThreads(threads, chunks), [&](size_t c) {
+    const size_t begin = c * MESH_CHUNK;
+    fn(begin, n - begin < MESH_CHUNK ? n : begin + MESH_CHUNK);
+   });
+  }
+
+  /** Unit vector perpendicular to the unit vector n, for frames with no usable tangent. */
+  inline CVector3
+   perpendicularTo(const CVector3& n) {
+   const CVector3 axis = EngineMath::fabs(n.x) < 0.57735f ? CVector3(1.f, 0.f, 0.f) : CVector3(0.f, 1.f, 0.f);
+   return (axis - n * n.dot(axis)).normalized<EU::Precision::Exact>();
+  }
+ }
+
+ /**
+  * @class MeshNormals
+  * @brief Vertex adjacency of one triangle mesh, reused to compute its normals and tangents.
+  */
+ class
+  MeshNormals {
+  public:
+  /**
+   * @brief Sets the mesh: triangle t is (indices[3t], indices[3t + 1], indices[3t + 2]).
+   * @return False, leaving the object empty, when an index is not below vertexCount.
+   */
+  bool
+   setTopology(const uint32_t* indices, size_t triangleCount, size_t vertexCount) {
+   const size_t corners = triangleCount * 3;
+   m_indices.assign(indices, indices + corners);
+   m_offsets.assign(vertexCount + 1, 0);
+   for (size_t i = 0; i < corners; ++i) {
+    if (m_indices[i] >= vertexCount) {
+     clear();
+     return false;
+    }
+    ++m_offsets[m_indices[i] + 1];
+   }
+   for (size_t v = 0; v < vertexCount; ++v) m_offsets[v + 1] += m_offsets[v];
+   m_corners.resize(corners);
+   m_fill.assign(m_offsets.begin(), m_offsets.end() - 1);
+   for (size_t i = 0; i < corners; ++i) m_corners[m_fill[m_indices[i]]++] = static_cast<uint32_t>(i);
+   m_triangles = triangleCount;
+   m_vertices = vertexCount;
+   return true;
+  }
+
+  /** @brief Forgets the mesh, keeping the allocations. */
+  void
+   clear() {
+   m_indices.clear();
+   m_offsets.assign(1, 0);
+   m_corners.clear();
+   m_triangles = 0;
+   m_vertices = 0;
+  }
+
+  size_t
+   triangleCount() const {
+   return m_triangles;
+  }
+
+  size_t
+   vertexCount() const {
+   return m_vertices;
+  }
+
+  /** @brief Number of triangles using vertex v, counted once per corner. */
+  size_t
+   valence(uint32_t v) const {
+   return v < m_vertices ? m_offsets[v + 1] - m_offsets[v] : 0;
+  }
+
+  /**
+   * @brief Area-weighted smooth normals: normals[v] for every vertex, zero for vertices no
+   * triangle uses and for vertices whose faces are all degenerate.
+   */
+  template<typename Policy = EU::Precision::Default>
+  void
+   computeNormals(const CVector3* positions, CVector3* normals, size_t threads = 0) {
+   computeFaces(positions, nullptr, threads);
+   detail::forEachMeshChunk(m_vertices, threads, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; ++v) {
+     CVector3 sum;
+     for (uint32_t k = m_offsets[v]; k < m_offsets[v + 1]; ++k) {
+      const uint32_t face = m_corners[k] / 3;
+      sum += CVector3(m_faceX[face], m_faceY[face], m_faceZ[face]);
+     }
+     normals[v] = sum;
+    }
+    normalizeArray<Policy>(normals + begin, end - begin);
+   });
+  }
+
+  /**
+   * @brief Tangent frames for unit vertex normals (e.g. from computeNormals()) and texture
+   * coordinates uvs: tangents[v].xyz is a unit vector orthogonal to normals[v] along increasing
+   * u, and tangents[v].w = +-1 gives the bitangent as w * cross(normal, tangent.xyz).
+   *
+   * Vertices whose faces all have degenerate texture coordinates get an arbitrary tangent
+   * orthogonal to the normal and w = 1.
+   */
+  template<typename Policy = EU::Precision::Default>
+  void
+   computeTangents(const CVector3* positions, const CVector3* normals, const CVector2* uvs, CVector4* tangents,
+                   size_t threads = 0) {
+   computeFaces(positions, uvs, threads);
+   detail::forEachMeshChunk(m_vertices, threads, [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; ++v) {
+     const CVector3 n = normals[v];
+     CVector3 tangent, bitangent;
+     for (uint32_t k = m_offsets[v]; k < m_offsets[v + 1]; ++k) {
+      const uint32_t corner = m_corners[k];
+      const uint32_t face = corner / 3, first = face * 3;
+      const CVector3 s(m_faceX[face], m_faceY[face], m_faceZ[face]);
+      const CVector3 t(m_faceTX[face], m_faceTY[face], m_faceTZ[face]);
+      if (s.lengthSquared() == 0.f && t.lengthSquared() == 0.f) continue;
+      // The face's angle at this corner, measured in the tangent plane as MikkTSpace does.
+      const CVector3 p = positions[v];
+      const CVector3 a = positions[m_indices[first + (corner - first + 1) % 3]] - p;
+      const CVector3 b = positions[m_indices[first + (corner - first + 2) % 3]] - p;
+      const CVector3 ea = (a - n * n.dot(a)).normalized<Policy>();
+      const CVector3 eb = (b - n * n.dot(b)).normalized<Policy>();
+      const float angle = EngineMath::acos(ea.dot(eb));
+      tangent += (s - n * n.dot(s)).normalized<Policy>() * angle;
+      bitangent += (t - n * n.dot(t)).normalized<Policy>() * angle;
+     }
+     CVector3 axis = (tangent - n * n.dot(tangent)).normalized<Policy>();
+     if (axis.lengthSquared() == 0.f) axis = detail::perpendicularTo(n);
+     const float w = n.cross(axis).dot(bitangent) < 0.f ? -1.f : 1.f;
+     tangents[v] = CVector4(axis.x, axis.y, axis.z, w);
+    }
+   });
+  }
+
+  private:
+  /**
+   * Per-face pass, one register of triangles at a time: the face normal into m_face*, or with
+   * uvs the unit u and v directions into m_face* and m_faceT*, zero for degenerate mappings.
+   */
+  void
+   computeFaces(const CVector3* positions, const CVector2* uvs, size_t threads) {
+   using detail::BatchLanes;
+   using detail::BATCH_WIDTH;
+   m_faceX.resize(m_triangles);
+   m_faceY.resize(m_triangles);
+   m_faceZ.resize(m_triangles);
+   if (uvs) {
+    m_faceTX.resize(m_triangles);
+    m_faceTY.resize(m_triangles);
+    m_faceTZ.resize(m_triangles);
+   }
+   detail::forEachMeshChunk(m_triangles, threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i += BATCH_WIDTH) {
+     const size_t count = end - i < BATCH_WIDTH ? end - i : BATCH_WIDTH;
+     float corner[9][BATCH_WIDTH] = {}, uv[6][BATCH_WIDTH] = {};
+     for (size_t k = 0; k < count; ++k) {
+      for (size_t c = 0; c < 3; ++c) {
+       const uint32_t index = m_indices[(i + k) * 3 + c];
+       corner[c * 3][k] = positions[index].x;
+       corner[c * 3 + 1][k] = positions[index].y;
+       corner[c * 3 + 2][k] = positions[index].z;
+       if (uvs) {
+        uv[c * 2][k] = uvs[index].x;
+        uv[c * 2 + 1][k] = uvs[index].y;
+       }
+      }
+     }
+     BatchLanes e1[3], e2[3];
+     for (size_t d = 0; d < 3; ++d) {
+      const BatchLanes a = BatchLanes::load(corner[d]);
+      e1[d] = BatchLanes::load(corner[3 + d]) - a;
+      e2[d] = BatchLanes::load(corner[6 + d]) - a;
+     }
+     if (!uvs) {
+      detail::storeLanes(e1[1] * e2[2] - e1[2] * e2[1], m_faceX.data(), i, count);
+      detail::storeLanes(e1[2] * e2[0] - e1[0] * e2[2], m_faceY.data(), i, count);
+      detail::storeLanes(e1[0] * e2[1] - e1[1] * e2[0], m_faceZ.data(), i, count);
+      continue;
+     }
+     const BatchLanes s0 = BatchLanes::load(uv[0]), t0 = BatchLanes::load(uv[1]);
+     const BatchLanes s1 = BatchLanes::load(uv[2]) - s0, t1 = BatchLanes::load(uv[3]) - t0;
+     const BatchLanes s2 = BatchLanes::load(uv[4]) - s0, t2 = BatchLanes::load(uv[5]) - t0;
+     // Twice the signed uv area; the scaled edge sums below are its multiples of dP/du and dP/dv.
+     const BatchLanes area = s1 * t2 - s2 * t1;
+     const BatchLanes zero = BatchLanes::zero();
+     const BatchLanes valid = (area != zero);
+     const BatchLanes sign = (BatchLanes::set1(1.f) & (area > zero)) | (BatchLanes::set1(-1.f) & (area < zero));
+     BatchLanes s[3], t[3];
+     for (size_t d = 0; d < 3; ++d) {
+      s[d] = t2 * e1[d] - t1 * e2[d];
+      t[d] = s1 * e2[d] - s2 * e1[d];
+     }
+     const BatchLanes invS = detail::safeInvLength<EU::Precision::Exact>(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]) * sign;
+     const BatchLanes invT = detail::safeInvLength<EU::Precision::Exact>(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]) * sign;
+     detail::storeLanes((s[0] * invS) & valid, m_faceX.data(), i, count);
+     detail::storeLanes((s[1] * invS) & valid, m_faceY.data(), i, count);
+     detail::storeLanes((s[2] * invS) & valid, m_faceZ.data(), i, count);
+     detail::storeLanes((t[0] * invT) & valid, m_faceTX.data(), i, count);
+     detail::storeLanes((t[1] * invT) & valid, m_faceTY.data(), i, count);
+     detail::storeLanes((t[2] * invT) & valid, m_faceTZ.data(), i, count);
+    }
+   });
+  }
+
+  std::vector<uint32_t> m_indices;
+  std::vector<uint32_t> m_offsets = std::vector<uint32_t>(1, 0);
+  std::vector<uint32_t> m_corners;
+  std::vector<uint32_t> m_fill;
+  std::vector<float> m_faceX, m_faceY, m_faceZ;
+  std::vector<float> m_faceTX, m_faceTY, m_faceTZ;
+  size_t m_triangles = 0;
+  size_t m_vertices = 0;
+ };
+}
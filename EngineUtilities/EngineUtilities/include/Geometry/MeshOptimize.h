@@ -0,0 +1,387 @@
+/**
+ * @file MeshOptimize.h
+ * @brief Index and vertex buffer reordering for the GPU: post-transform vertex cache
+ * optimization (Forsyth), overdraw ordering and vertex fetch reordering.
+ *
+ * optimizeVertexCache() is Tom Forsyth's linear-speed algorithm. The first three cache slots
+ * score 0.75, later ones fall off as (1 - (slot - 3) / (MESH_CACHE_SIZE - 3))^1.5, and a vertex
+ * with n unemitted triangles gets a 2 / sqrt(n) bonus, so nearly finished vertices are
+ * finished first. Each step emits the best-scoring triangle that touches the simulated LRU
+ * cache, and rescoring is limited to the triangles of the vertices in the cache. When no
+ * cached vertex has a triangle left, the next unemitted triangle in input order restarts it.
+ *
+ * optimizeOverdraw() keeps most of that cache order. Following Sander et al., "Fast
+ * triangle reordering for vertex locality and reduced overdraw", it cuts the buffer into
+ * clusters, ordered so that outward-facing clusters draw first:
+ * - a hard boundary falls wherever all three vertices of a triangle miss a FIFO cache of
+ *   MESH_FIFO_SIZE entries
+ * - a soft boundary falls wherever a cluster's running miss rate stays within threshold of
+ *   its own average
+ * Clusters are sorted by how far their centroid lies out along their normal.
+ *
+ * optimizeVertexFetch() renumbers vertices in first-use order, so the vertex fetches of
+ * consecutive triangles stay close in memory; remapVertices() applies its table to any
+ * vertex attribute array.
+ *
+ * Every index buffer is a triangle list of uint32_t. The scratch stays in the MeshOptimizer,
+ * so optimizing many meshes allocates only when a mesh is larger than every earlier one.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /// Slots of the LRU cache optimizeVertexCache() simulates. Forsyth uses 32; 16 halves the
+ /// rescoring per triangle and costs a few percent of ACMR.
+ constexpr size_t MESH_CACHE_SIZE = 16;
+ /// Entries of the FIFO cache analyzeVertexCache() and optimizeOverdraw() simulate by default.
+ constexpr size_t MESH_FIFO_SIZE = 16;
+ /// optimizeVertexFetch() remap entry of a vertex no triangle uses.
+ constexpr uint32_t MESH_UNUSED = 0xffffffffu;
+
+ /**
+  * @brief Post-transform cache efficiency of an index buffer under a FIFO cache.
+  */
+ struct VertexCacheStats {
+  size_t misses = 0;  ///< Vertices transformed
+  float acmr = 0.f;   ///< Average misses per triangle: 0.5 is ideal for a large grid, 3 the worst
+  float atvr = 0.f;   ///< Misses per referenced vertex: 1 is ideal
+ };
+
+ /**
+  * @brief Simulates a FIFO post-transform cache of cacheSize entries over indices.
+  */
+ inline VertexCacheStats
+  analyzeVertexCache(const uint32_t* indices, size_t triangleCount, size_t vertexCount,
+                     size_t cacheSize = MESH_FIFO_SIZE) {
+  VertexCacheStats stats;
+  if (triangleCount == 0 || cacheSize == 0) return stats;
+  // A vertex is cached while fewer than cacheSize misses happened since it was loaded.
+  std::vector<size_t> loaded(vertexCount, 0);
+  std::vector<uint8_t> used(vertexCount, 0);
+  size_t referenced = 0;
+  for (size_t i = 0; i < triangleCount * 3; ++i) {
+   const uint32_t v = indices[i];
+   if (v >= vertexCount) continue;
+   if (!used[v]) {
+    used[v] = 1;
+    ++referenced;
+   }
+   if (loaded[v] == 0 || stats.misses + 1 - loaded[v] >= cacheSize) {
+    ++stats.misses;
+    loaded[v] = stats.misses;
+   }
+  }
+  stats.acmr = static_cast<float>(stats.misses) / static_cast<float>(triangleCount);
+  stats.atvr = referenced ? static_cast<float>(stats.misses) / static_cast<float>(referenced) : 0.f;
+  return stats;
+ }
+
+ /**
+  * @brief out[remap[v]] = in[v] for every used vertex v; see MeshOptimizer::optimizeVertexFetch().
+  */
+ template<typename Vertex>
+ inline void
+  remapVertices(const Vertex* in, size_t vertexCount, const uint32_t* remap, Vertex* out) {
+  for (size_t v = 0; v < vertexCount; ++v) {
+   if (remap[v] != MESH_UNUSED) out[remap[v]] = in[v];
+  }
+ }
+
+ namespace detail {
+  constexpr uint32_t MESH_NONE = 0xffffffffu;
+  /// Unemitted triangles counted by the valence bonus table; more score as this many.
+  constexpr size_t MESH_VALENCE_MAX = 32;
+ }
+
+ /**
+  * @class MeshOptimizer
+  * @brief Reorders index and vertex buffers for the GPU, keeping its scratch between meshes.
+  */
+ class
+  MeshOptimizer {
+  public:
+  MeshOptimizer() {
+   for (size_t i = 0; i < MESH_CACHE_SIZE; ++i) {
+    if (i < 3) {
+     m_cacheScore[i] = 0.75f;
+    }
+    else {
+     const float x = 1.f - static_cast<float>(i - 3) / static_cast<float>(MESH_CACHE_SIZE - 3);
+     m_cacheScore[i] = x * EngineMath::sqrtHardware(x);
+    }
+   }
+   m_valenceScore[0] = 0.f;
+   for (size_t n = 1; n <= detail::MESH_VALENCE_MAX; ++n) {
+    m_valenceScore[n] = 2.f / EngineMath::sqrtHardware(static_cast<float>(n));
+   }
+  }
+
+  /**
+   * @brief Reorders the triangles of indices, in place, for the post-transform vertex cache.
+   * Triangles keep their corner order, so winding is preserved.
+   * @return False, leaving indices untouched, when an index is not below vertexCount.
+   */
+  bool
+   optimizeVertexCache(uint32_t* indices, size_t triangleCount, size_t vertexCount) {
+   if (!buildAdjacency(indices, triangleCount, vertexCount)) return false;
+   m_position.assign(vertexCount, -1);
+   m_vertexScore.resize(vertexCount);
+   for (size_t v = 0; v < vertexCount; ++v) m_vertexScore[v] = vertexScore(static_cast<uint32_t>(v));
+   m_triangleScore.resize(triangleCount);
+   m_emitted.assign(triangleCount, 0);
+   for (size_t t = 0; t < triangleCount; ++t) {
+    const uint32_t* c = &m_source[3 * t];
+    m_triangleScore[t] = m_vertexScore[c[0]] + m_vertexScore[c[1]] + m_vertexScore[c[2]];
+   }
+
+   uint32_t cache[2][MESH_CACHE_SIZE + 3];
+   size_t cacheCount = 0;
+   int current = 0;
+   size_t cursor = 0;
+   uint32_t best = detail::MESH_NONE;
+   for (size_t emitted = 0; emitted < triangleCount; ++emitted) {
+    if (best == detail::MESH_NONE) {
+     while (m_emitted[cursor]) ++cursor;
+     best = static_cast<uint32_t>(cursor);
+    }
+    const uint32_t* c = &m_source[3 * best];
+    std::copy(c, c + 3, indices + 3 * emitted);
+    m_emitted[best] = 1;
+    for (int k = 0; k < 3; ++k) removeTriangle(c[k], best);
+
+    // New LRU order: the triangle's vertices, then the old cache without them.
+    uint32_t* next = cache[1 - current];
+    size_t nextCount = 0;
+    for (int k = 0; k < 3; ++k) {
+     if (std::find(next, next + nextCount, c[k]) == next + nextCount) next[nextCount++] = c[k];
+    }
+    for (size_t i = 0; i < cacheCount; ++i) {
+     const uint32_t v = cache[current][i];
+     if (v != c[0] && v != c[1] && v != c[2]) next[nextCount++] = v;
+    }
+    current = 1 - current;
+
+    // Rescore the vertices whose slot changed, including those pushed out, and pick the
+    // best live triangle of the cache as the scores settle.
+    best = detail::MESH_NONE;
+    float bestScore = -1.f;
+    for (size_t i = 0; i < nextCount; ++i) {
+     const uint32_t v = next[i];
+     m_position[v] = i < MESH_CACHE_SIZE ? static_cast<int>(i) : -1;
+     const float score = vertexScore(v);
+     const float delta = score - m_vertexScore[v];
+     m_vertexScore[v] = score;
+     for (uint32_t j = m_offsets[v]; j < m_offsets[v] + m_live[v]; ++j) {
+      const uint32_t t = m_triangles[j];
+      const float triangleScore = m_triangleScore[t] += delta;
+      if (triangleScore > bestScore) {
+       bestScore = triangleScore;
+       best = t;
+      }
+     }
+    }
+    cacheCount = std::min(nextCount, MESH_CACHE_SIZE);
+   }
+   return true;
+  }
+
+  /**
+   * @brief Reorders clusters of the (already cache-optimized) triangles of indices, in
+   * place, so outward-facing ones draw first.
+   * @param threshold How much worse than a hard cluster's average miss rate a soft cluster
+   * may run: 1 keeps the cache order, 1.05 costs about 5% of ACMR.
+   * @return False, leaving indices untouched, when an index is not below vertexCount.
+   */
+  bool
+   optimizeOverdraw(uint32_t* indices, size_t triangleCount, const CVector3* positions, size_t vertexCount,
+                    float threshold = 1.05f) {
+   const size_t corners = triangleCount * 3;
+   for (size_t i = 0; i < corners; ++i) {
+    if (indices[i] >= vertexCount) return false;
+   }
+   if (triangleCount == 0) return true;
+   m_source.assign(indices, indices + corners);
+
+   // Hard boundaries: triangles whose three vertices all miss the FIFO cache.
+   m_clusters.clear();
+   m_loaded.assign(vertexCount, 0);
+   size_t misses = 0;
+   for (size_t t = 0; t < triangleCount; ++t) {
+    if (fifoMisses(&m_source[3 * t], misses, 0) == 3 || t == 0) m_clusters.push_back(static_cast<uint32_t>(t));
+   }
+   m_clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+   // Soft boundaries inside each hard cluster, each soft cluster measured from a cold cache
+   // since the sort will separate it from its neighbours.
+   m_softClusters.clear();
+   for (size_t c = 0; c + 1 < m_clusters.size(); ++c) {
+    const uint32_t begin = m_clusters[c], end = m_clusters[c + 1];
+    size_t since = misses;
+    for (uint32_t t = begin; t < end; ++t) fifoMisses(&m_source[3 * t], misses, since);
+    const float limit = threshold * static_cast<float>(misses - since) / static_cast<float>(end - begin);
+    since = misses;
+    uint32_t start = begin;
+    m_softClusters.push_back(begin);
+    for (uint32_t t = begin; t + 1 < end; ++t) {
+     fifoMisses(&m_source[3 * t], misses, since);
+     if (static_cast<float>(misses - since) <= limit * static_cast<float>(t + 1 - start)) {
+      m_softClusters.push_back(t + 1);
+      start = t + 1;
+      since = misses;
+     }
+    }
+   }
+   m_softClusters.push_back(static_cast<uint32_t>(triangleCount));
+
+   // Sort key: distance of the cluster's centroid from the mesh centroid along its normal.
+   const size_t clusters = m_softClusters.size() - 1;
+   CVector3 meshCentroid(0.f, 0.f, 0.f);
+   float meshArea = 0.f;
+   m_keys.resize(clusters);
+   m_order.resize(clusters);
+   m_centroids.resize(clusters);
+   m_normals.resize(clusters);
+   for (size_t c = 0; c < clusters; ++c) {
+    CVector3 centroid(0.f, 0.f, 0.f), normal(0.f, 0.f, 0.f);
+    float area = 0.f;
+    for (uint32_t t = m_softClusters[c]; t < m_softClusters[c + 1]; ++t) {
+     const CVector3& a = positions[m_source[3 * t]];
+     const CVector3& b = positions[m_source[3 * t + 1]];
+     const CVector3& d = positions[m_source[3 * t + 2]];
+     const CVector3 n = (b - a).cross(d - a);
+     const float weight = n.length<EU::Precision::Exact>();
+     centroid += (a + b + d) * (weight / 3.f);
+     normal += n;
+     area += weight;
+    }
+    meshCentroid += centroid;
+    meshArea += area;
+    m_centroids[c] = area > 0.f ? centroid * (1.f / area) : positions[m_source[3 * m_softClusters[c]]];
+    m_normals[c] = normal.normalized<EU::Precision::Exact>();
+    m_order[c] = static_cast<uint32_t>(c);
+   }
+   if (meshArea > 0.f) meshCentroid = meshCentroid * (1.f / meshArea);
+   for (size_t c = 0; c < clusters; ++c) m_keys[c] = (m_centroids[c] - meshCentroid).dot(m_normals[c]);
+   std::stable_sort(m_order.begin(), m_order.end(), [&](uint32_t a, uint32_t b) { return m_keys[a] > m_keys[b]; });
+
+   size_t out = 0;
+   for (uint32_t c : m_order) {
+    const uint32_t begin = m_softClusters[c], end = m_softClusters[c + 1];
+    std::copy(&m_source[3 * begin], &m_source[3 * begin] + 3 * (end - begin), indices + out);
+    out += 3 * (end - begin);
+   }
+   return true;
+  }
+
+  /**
+   * @brief Renumbers vertices in the order indices first use them and rewrites indices.
+   * @param remap Receives, for each of the vertexCount old vertices, its new index or
+   * MESH_UNUSED; pass it to remapVertices() for every vertex attribute.
+   * @return Vertices used (the new vertex count), or 0 when an index is not below
+   * vertexCount, leaving indices untouched.
+   */
+  size_t
+   optimizeVertexFetch(uint32_t* indices, size_t triangleCount, size_t vertexCount, uint32_t* remap) {
+   const size_t corners = triangleCount * 3;
+   for (size_t i = 0; i < corners; ++i) {
+    if (indices[i] >= vertexCount) return 0;
+   }
+   std::fill(remap, remap + vertexCount, MESH_UNUSED);
+   uint32_t next = 0;
+   for (size_t i = 0; i < corners; ++i) {
+    uint32_t& slot = remap[indices[i]];
+    if (slot == MESH_UNUSED) slot = next++;
+    indices[i] = slot;
+   }
+   return next;
+  }
+
+  private:
+  /** Copies indices and counting-sorts triangles by vertex; false on an out-of-range index. */
+  bool
+   buildAdjacency(const uint32_t* indices, size_t triangleCount, size_t vertexCount) {
+   const size_t corners = triangleCount * 3;
+   for (size_t i = 0; i < corners; ++i) {
+    if (indices[i] >= vertexCount) return false;
+   }
+   m_source.assign(indices, indices + corners);
+   m_offsets.assign(vertexCount + 1, 0);
+   for (size_t i = 0; i < corners; ++i) ++m_offsets[m_source[i] + 1];
+   for (size_t v = 0; v < vertexCount; ++v) m_offsets[v + 1] += m_offsets[v];
+   m_live.resize(vertexCount);
+   for (size_t v = 0; v < vertexCount; ++v) m_live[v] = 0;
+   m_triangles.resize(corners);
+   for (size_t i = 0; i < corners; ++i) {
+    const uint32_t v = m_source[i];
+    m_triangles[m_offsets[v] + m_live[v]++] = static_cast<uint32_t>(i / 3);
+   }
+   return true;
+  }
+
+  /** Drops emitted triangle t from the live triangles of v (swap with the last live one). */
+  void
+   removeTriangle(uint32_t v, uint32_t t) {
+   uint32_t* list = &m_triangles[m_offsets[v]];
+   const uint32_t live = m_live[v];
+   for (uint32_t j = 0; j < live; ++j) {
+    if (list[j] == t) {
+     list[j] = list[live - 1];
+     list[live - 1] = t;
+     --m_live[v];
+     return;
+    }
+   }
+  }
+
+  float
+   vertexScore(uint32_t v) const {
+   const uint32_t live = m_live[v];
+   if (live == 0) return -1.f;
+   const float valence = m_valenceScore[live < detail::MESH_VALENCE_MAX ? live : detail::MESH_VALENCE_MAX];
+   return (m_position[v] < 0 ? 0.f : m_cacheScore[m_position[v]]) + valence;
+  }
+
+  /**
+   * Misses of one triangle under a MESH_FIFO_SIZE FIFO cache, counted into misses; vertices
+   * loaded before misses reached since count as evicted.
+   */
+  size_t
+   fifoMisses(const uint32_t* c, size_t& misses, size_t since) {
+   size_t found = 0;
+   for (int k = 0; k < 3; ++k) {
+    size_t& loaded = m_loaded[c[k]];
+    if (loaded <= since || misses + 1 - loaded >= MESH_FIFO_SIZE) {
+     loaded = ++misses;
+     ++found;
+    }
+   }
+   return found;
+  }
+
+  float m_cacheScore[MESH_CACHE_SIZE];
+  float m_valenceScore[detail::MESH_VALENCE_MAX + 1];
+  std::vector<uint32_t> m_source;       ///< Copy of the input triangles
+  std::vector<uint32_t> m_offsets;      ///< Per vertex: first entry in m_triangles
+  std::vector<uint32_t> m_live;         ///< Per vertex: unemitted triangles, at the front of its run
+  std::vector<uint32_t> m_triangles;    ///< Triangles of each vertex
+  std::vector<int> m_position;          ///< Per vertex: LRU slot, or -1
+  std::vector<float> m_vertexScore;
+  std::vector<float> m_triangleScore;
+  std::vector<uint8_t> m_emitted;
+  std::vector<size_t> m_loaded;         ///< Per vertex: FIFO miss count when it was loaded, 0 if never
+  std::vector<uint32_t> m_clusters;     ///< First triangle of each hard cluster, then triangleCount
+  std::vector<uint32_t> m_softClusters; ///< First triangle of each soft cluster, then triangleCount
+  std::vector<float> m_keys;
+  std::vector<uint32_t> m_order;
+  std::vector<CVector3> m_centroids;
+  std::vector<CVector3> m_normals;
+ };
+}
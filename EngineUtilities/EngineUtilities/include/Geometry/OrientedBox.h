@@ -0,0 +1,155 @@
+/**
+ * @file OrientedBox.h
+ * @brief Oriented bounding boxes and their PCA fit to point sets.
+ *
+ * OrientedBox::fromPoints() takes the box axes from the eigenvectors of the points'
+ * covariance (symmetricEigen()), then projects every point on them for the extents. That is
+ * two passes over the points: the covariance is accumulated in one pass relative to the
+ * first point, which keeps the sums small for meshes far from the origin without a separate
+ * pass for the mean. The fit is not the minimum-volume box, but it is tight for elongated
+ * shapes and cheap enough to refit dynamic meshes every frame.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/Matrix3x3.h>
+#include <Matrices/MatrixEigen.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /**
+  * @brief Covariance matrix of points[0..n) with their mean; both zero when n == 0.
+  */
+ inline Matrix3x3
+  pointCovariance(const CVector3* points, size_t n, CVector3& mean) {
+  if (n == 0) {
+   mean = CVector3(0.f, 0.f, 0.f);
+   return Matrix3x3::zero();
+  }
+  const CVector3 origin = points[0];
+  float sx = 0.f, sy = 0.f, sz = 0.f;
+  float sxx = 0.f, sxy = 0.f, sxz = 0.f, syy = 0.f, syz = 0.f, szz = 0.f;
+  for (size_t i = 0; i < n; ++i) {
+   const float x = points[i].x - origin.x, y = points[i].y - origin.y, z = points[i].z - origin.z;
+   sx += x;
+   sy += y;
+   sz += z;
+   sxx += x * x;
+   sxy += x * y;
+   sxz += x * z;
+   syy += y * y;
+   syz += y * z;
+   szz += z * z;
+  }
+  const float inv = 1.f / static_cast<float>(n);
+  const float mx = sx * inv, my = sy * inv, mz = sz * inv;
+  mean = CVector3(origin.x + mx, origin.y + my, origin.z + mz);
+  const float cxx = sxx * inv - mx * mx, cxy = sxy * inv - mx * my, cxz = sxz * inv - mx * mz;
+  const float cyy = syy * inv - my * my, cyz = syz * inv - my * mz, czz = szz * inv - mz * mz;
+  return Matrix3x3(cxx, cxy, cxz,
+                   cxy, cyy, cyz,
+                   cxz, cyz, czz);
+ }
+
+ /**
+  * @class OrientedBox
+  * @brief Box centered at center, with half extents along the columns of axes.
+  */
+ class
+  OrientedBox {
+  public:
+  CVector3 center;      ///< World-space center
+  Matrix3x3 axes;       ///< Unit box axes as columns, a rotation
+  CVector3 halfExtents; ///< Half size along each axis
+
+  /**
+   * @brief Default constructor. An empty box at the origin.
+   */
+  constexpr OrientedBox() : center(0.f, 0.f, 0.f), axes(), halfExtents(0.f, 0.f, 0.f) {}
+
+  constexpr OrientedBox(const CVector3& center, const Matrix3x3& axes, const CVector3& halfExtents)
+   : center(center), axes(axes), halfExtents(halfExtents) {}
+
+  /**
+   * @brief Box rotated by rotation, which need not be unit length (see Quaternion::toMatrix3()).
+   */
+  constexpr OrientedBox(const CVector3& center, const Quaternion& rotation, const CVector3& halfExtents)
+   : center(center), axes(rotation.toMatrix3()), halfExtents(halfExtents) {}
+
+  /**
+   * @brief PCA fit to points[0..n): axes in decreasing order of spread, extents the
+   * furthest projection on each. An empty set gives the default box.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static OrientedBox
+   fromPoints(const CVector3* points, size_t n) {
+   if (n == 0) return OrientedBox();
+   CVector3 mean(0.f, 0.f, 0.f), spread(0.f, 0.f, 0.f);
+   Matrix3x3 axes;
+   symmetricEigen<Policy>(pointCovariance(points, n, mean), spread, axes);
+   const float (&a)[3][3] = axes.m;
+   float lo[3] = {}, hi[3] = {};
+   for (int c = 0; c < 3; ++c) {
+    lo[c] = hi[c] = (points[0].x - mean.x) * a[0][c] + (points[0].y - mean.y) * a[1][c]
+                    + (points[0].z - mean.z) * a[2][c];
+   }
+   for (size_t i = 1; i < n; ++i) {
+    const float x = points[i].x - mean.x, y = points[i].y - mean.y, z = points[i].z - mean.z;
+    for (int c = 0; c < 3; ++c) {
+     const float d = x * a[0][c] + y * a[1][c] + z * a[2][c];
+     lo[c] = d < lo[c] ? d : lo[c];
+     hi[c] = d > hi[c] ? d : hi[c];
+    }
+   }
+   CVector3 center = mean;
+   for (int c = 0; c < 3; ++c) {
+    const float mid = 0.5f * (lo[c] + hi[c]);
+    center.x += a[0][c] * mid;
+    center.y += a[1][c] * mid;
+    center.z += a[2][c] * mid;
+   }
+   return OrientedBox(center, axes, CVector3(0.5f * (hi[0] - lo[0]), 0.5f * (hi[1] - lo[1]), 0.5f * (hi[2] - lo[2])));
+  }
+
+  /**
+   * @brief point expressed in box coordinates: its offset from center along each axis.
+   */
+  constexpr CVector3
+   toLocal(const CVector3& point) const {
+   const CVector3 d = point - center;
+   return CVector3(d.x * axes.m[0][0] + d.y * axes.m[1][0] + d.z * axes.m[2][0],
+                   d.x * axes.m[0][1] + d.y * axes.m[1][1] + d.z * axes.m[2][1],
+                   d.x * axes.m[0][2] + d.y * axes.m[1][2] + d.z * axes.m[2][2]);
+  }
+
+  /**
+   * @brief True when point is inside or on the box.
+   */
+  constexpr bool
+   containsPoint(const CVector3& point) const {
+   const CVector3 l = toLocal(point);
+   return EngineMath::fabs(l.x) <= halfExtents.x && EngineMath::fabs(l.y) <= halfExtents.y
+          && EngineMath::fabs(l.z) <= halfExtents.z;
+  }
+
+  /**
+   * @brief Transform mapping the unit cube [-1, 1]^3 onto the box, e.g. for debug drawing.
+   */
+  constexpr Affine3x4
+   toAffine3x4() const {
+   Affine3x4 r;
+   const float h[3] = { halfExtents.x, halfExtents.y, halfExtents.z };
+   const float t[3] = { center.x, center.y, center.z };
+   for (int i = 0; i < 3; ++i) {
+    for (int c = 0; c < 3; ++c) r.m[i][c] = axes.m[i][c] * h[c];
+    r.m[i][3] = t[i];
+   }
+   return r;
+  }
+ };
+}
@@ -0,0 +1,445 @@
+/**
+ * @file Overlap.h
+ * @brief Narrowphase overlap tests: oriented box pairs, capsules against capsules and
+ * spheres, and triangles against axis-aligned boxes, each scalar and one-against-SoA.
+ *
+ * Boxes use the separating axis test: 15 axes for two oriented boxes (Gottschalk; the
+ * absolute rotation terms get EPSILON added so near-parallel edges, whose cross product
+ * degenerates, cannot produce a false separation) and 13 for a triangle against an AABB
+ * (Akenine-Moller: the box faces, the triangle plane and the nine edge cross products). The
+ * scalar versions return at the first separating axis. Capsules reduce to the closest points
+ * of their core segments (Ericson, Real-Time Collision Detection 5.1.9), compared squared
+ * against the summed radii, so no square root is taken.
+ *
+ * The batch versions test one shape against a register (4 or 8) of SoA shapes per step and
+ * write the indices of the ones that overlap, ascending, like intersectRayBoxes(). They
+ * evaluate every axis branch-free, apart from one early out per register once the face axes
+ * separate all of its lanes. All tests are inclusive: touching shapes overlap.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/Constants.h>
+#include <Core/SIMD.h>
+#include <Geometry/OrientedBox.h>
+#include <Geometry/Primitives.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /**
+  * @class Capsule
+  * @brief Points within radius of the segment [a, b]; a sphere when a == b.
+  */
+ class
+  Capsule {
+  public:
+  CVector3 a;   ///< First end of the core segment
+  CVector3 b;   ///< Second end of the core segment
+  float radius; ///< Radius, >= 0
+
+  /**
+   * @brief Default constructor. A point at the origin.
+   */
+  constexpr Capsule() : a(0.f, 0.f, 0.f), b(0.f, 0.f, 0.f), radius(0.f) {}
+
+  constexpr Capsule(const CVector3& a, const CVector3& b, float radius) : a(a), b(b), radius(radius) {}
+
+  /** @brief Smallest AABB holding the capsule. */
+  constexpr AABB
+   bounds() const {
+   return AABB(CVector3((a.x < b.x ? a.x : b.x) - radius, (a.y < b.y ? a.y : b.y) - radius, (a.z < b.z ? a.z : b.z) - radius),
+               CVector3((a.x > b.x ? a.x : b.x) + radius, (a.y > b.y ? a.y : b.y) + radius, (a.z > b.z ? a.z : b.z) + radius));
+  }
+ };
+
+ EU_ASSERT_VALUE_TYPE(Capsule);
+
+ /**
+  * @brief SoA view of n oriented boxes: axes[r][c][i] is axes.m[r][c] of box i.
+  */
+ struct ConstOrientedBoxSoA {
+  EngineMath::batch::ConstSoA3 center;
+  const float* axes[3][3];
+  EngineMath::batch::ConstSoA3 halfExtents;
+ };
+
+ /**
+  * @brief Squared distance from point to the segment [a, b]; t receives the parameter of the
+  * closest point a + t (b - a), in [0, 1].
+  */
+ constexpr float
+  distanceSquaredPointSegment(const CVector3& point, const CVector3& a, const CVector3& b, float& t) {
+  const CVector3 d = b - a, r = point - a;
+  const float lenSq = d.dot(d);
+  t = lenSq > EU::Constants::EPSILON ? EngineMath::clamp(r.dot(d) / lenSq, 0.f, 1.f) : 0.f;
+  return (r - d * t).lengthSquared();
+ }
+
+ namespace detail {
+  /** closestPointsSegmentSegment() for any vector type with dot() and lengthSquared(). */
+  template<typename Vector>
+  constexpr float
+   segmentSegment(const Vector& p1, const Vector& q1, const Vector& p2, const Vector& q2, float& s, float& t) {
+   const Vector d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+   const float a = d1.dot(d1), e = d2.dot(d2), f = d2.dot(r);
+   s = 0.f;
+   t = 0.f;
+   if (a <= EU::Constants::EPSILON) {
+    if (e > EU::Constants::EPSILON) t = EngineMath::clamp(f / e, 0.f, 1.f);
+   }
+   else {
+    const float c = d1.dot(r);
+    if (e <= EU::Constants::EPSILON) {
+     s = EngineMath::clamp(-c / a, 0.f, 1.f);
+    }
+    else {
+     const float b = d1.dot(d2);
+     const float denom = a * e - b * b;
+     // Parallel segments (denom 0): any s works, pick the start and clamp t from it.
+     s = denom > 0.f ? EngineMath::clamp((b * f - c * e) / denom, 0.f, 1.f) : 0.f;
+     t = (b * s + f) / e;
+     if (t < 0.f) {
+      t = 0.f;
+      s = EngineMath::clamp(-c / a, 0.f, 1.f);
+     }
+     else if (t > 1.f) {
+      t = 1.f;
+      s = EngineMath::clamp((b - c) / a, 0.f, 1.f);
+     }
+    }
+   }
+   return (r + d1 * s - d2 * t).lengthSquared();
+  }
+ }
+
+ /**
+  * @brief Squared distance between the segments [p1, q1] and [p2, q2]; s and t receive the
+  * parameters of the closest points p1 + s (q1 - p1) and p2 + t (q2 - p2). Segments shorter
+  * than sqrt(EPSILON) count as points.
+  */
+ constexpr float
+  closestPointsSegmentSegment(const CVector3& p1, const CVector3& q1, const CVector3& p2, const CVector3& q2, float& s,
+                              float& t) {
+  return detail::segmentSegment(p1, q1, p2, q2, s, t);
+ }
+
+ /** @brief True when the capsules overlap. */
+ constexpr bool
+  intersects(const Capsule& a, const Capsule& b) {
+  float s = 0.f, t = 0.f;
+  const float r = a.radius + b.radius;
+  return closestPointsSegmentSegment(a.a, a.b, b.a, b.b, s, t) <= r * r;
+ }
+
+ /** @brief True when capsule and sphere overlap. */
+ constexpr bool
+  intersects(const Capsule& capsule, const Sphere& sphere) {
+  float t = 0.f;
+  const float r = capsule.radius + sphere.radius;
+  return distanceSquaredPointSegment(sphere.center, capsule.a, capsule.b, t) <= r * r;
+ }
+
+ /** @brief True when sphere and capsule overlap. */
+ constexpr bool
+  intersects(const Sphere& sphere, const Capsule& capsule) {
+  return intersects(capsule, sphere);
+ }
+
+ /**
+  * @brief Separating axis test of two oriented boxes; false at the first of the 15 axes that
+  * separates them.
+  */
+ constexpr bool
+  intersects(const OrientedBox& a, const OrientedBox& b) {
+  const float ea[3] = { a.halfExtents.x, a.halfExtents.y, a.halfExtents.z };
+  const float eb[3] = { b.halfExtents.x, b.halfExtents.y, b.halfExtents.z };
+  const CVector3 d = b.center - a.center;
+  float R[3][3] = {}, absR[3][3] = {}, t[3] = {};
+  for (int i = 0; i < 3; ++i) {
+   t[i] = d.x * a.axes.m[0][i] + d.y * a.axes.m[1][i] + d.z * a.axes.m[2][i];
+   for (int j = 0; j < 3; ++j) {
+    R[i][j] = a.axes.m[0][i] * b.axes.m[0][j] + a.axes.m[1][i] * b.axes.m[1][j] + a.axes.m[2][i] * b.axes.m[2][j];
+    absR[i][j] = EngineMath::fabs(R[i][j]) + EU::Constants::EPSILON;
+   }
+  }
+  for (int i = 0; i < 3; ++i) {
+   if (EngineMath::fabs(t[i]) > ea[i] + eb[0] * absR[i][0] + eb[1] * absR[i][1] + eb[2] * absR[i][2]) return false;
+  }
+  for (int j = 0; j < 3; ++j) {
+   const float proj = t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j];
+   if (EngineMath::fabs(proj) > ea[0] * absR[0][j] + ea[1] * absR[1][j] + ea[2] * absR[2][j] + eb[j]) return false;
+  }
+  for (int i = 0; i < 3; ++i) {
+   const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+   for (int j = 0; j < 3; ++j) {
+    const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+    const float ra = ea[i1] * absR[i2][j] + ea[i2] * absR[i1][j];
+    const float rb = eb[j1] * absR[i][j2] + eb[j2] * absR[i][j1];
+    if (EngineMath::fabs(t[i2] * R[i1][j] - t[i1] * R[i2][j]) > ra + rb) return false;
+   }
+  }
+  return true;
+ }
+
+ /**
+  * @brief Triangle (v0, v1, v2) against box (Akenine-Moller); false for an empty box.
+  */
+ constexpr bool
+  intersectsTriangle(const AABB& box, const CVector3& v0, const CVector3& v1, const CVector3& v2) {
+  if (box.empty()) return false;
+  const CVector3 c = box.center(), h = box.halfExtents();
+  const CVector3 p[3] = { v0 - c, v1 - c, v2 - c };
+  const CVector3 f[3] = { p[1] - p[0], p[2] - p[1], p[0] - p[2] };
+  for (int k = 0; k < 3; ++k) {
+   const float a = p[0][k], b = p[1][k], e = p[2][k];
+   const float lo = a < b ? (a < e ? a : e) : (b < e ? b : e);
+   const float hi = a > b ? (a > e ? a : e) : (b > e ? b : e);
+   if (lo > h[k] || hi < -h[k]) return false;
+  }
+  const CVector3 n = f[0].cross(f[1]);
+  const float r = h.x * EngineMath::fabs(n.x) + h.y * EngineMath::fabs(n.y) + h.z * EngineMath::fabs(n.z);
+  if (EngineMath::fabs(n.dot(p[0])) > r) return false;
+  // Edge axes e_x x f = (0, -f.z, f.y), e_y x f = (f.z, 0, -f.x), e_z x f = (-f.y, f.x, 0).
+  for (int j = 0; j < 3; ++j) {
+   const CVector3 axes[3] = { CVector3(0.f, -f[j].z, f[j].y), CVector3(f[j].z, 0.f, -f[j].x), CVector3(-f[j].y, f[j].x, 0.f) };
+   for (const CVector3& axis : axes) {
+    const float d0 = p[0].dot(axis), d1 = p[1].dot(axis), d2 = p[2].dot(axis);
+    const float reach = h.x * EngineMath::fabs(axis.x) + h.y * EngineMath::fabs(axis.y) + h.z * EngineMath::fabs(axis.z);
+    const float lo = d0 < d1 ? (d0 < d2 ? d0 : d2) : (d1 < d2 ? d1 : d2);
+    const float hi = d0 > d1 ? (d0 > d2 ? d0 : d2) : (d1 > d2 ? d1 : d2);
+    if (lo > reach || hi < -reach) return false;
+   }
+  }
+  return true;
+ }
+
+ namespace detail {
+  /** Lane-wise clamp of x to [0, 1]. */
+  inline BatchLanes
+   clampUnitLanes(BatchLanes x) {
+   return EU::SIMD::min(EU::SIMD::max(x, BatchLanes::zero()), BatchLanes::set1(1.f));
+  }
+
+  /**
+   * Lane-wise closestPointsSegmentSegment() with the same cases, selected instead of
+   * branched; the zero-length guards divide by 1 in the lanes that discard the quotient.
+   */
+  inline BatchLanes
+   segmentDistanceSquaredLanes(const BatchLanes (&p1)[3], const BatchLanes (&q1)[3], const BatchLanes (&p2)[3],
+                               const BatchLanes (&q2)[3]) {
+   const BatchLanes one = BatchLanes::set1(1.f), zero = BatchLanes::zero(), eps = BatchLanes::set1(EU::Constants::EPSILON);
+   BatchLanes d1[3], d2[3], r[3];
+   for (int k = 0; k < 3; ++k) {
+    d1[k] = q1[k] - p1[k];
+    d2[k] = q2[k] - p2[k];
+    r[k] = p1[k] - p2[k];
+   }
+   const BatchLanes a = d1[0] * d1[0] + d1[1] * d1[1] + d1[2] * d1[2];
+   const BatchLanes e = d2[0] * d2[0] + d2[1] * d2[1] + d2[2] * d2[2];
+   const BatchLanes f = d2[0] * r[0] + d2[1] * r[1] + d2[2] * r[2];
+   const BatchLanes c = d1[0] * r[0] + d1[1] * r[1] + d1[2] * r[2];
+   const BatchLanes b = d1[0] * d2[0] + d1[1] * d2[1] + d1[2] * d2[2];
+   const BatchLanes aPoint = a <= eps, ePoint = e <= eps;
+   const BatchLanes aSafe = EU::SIMD::select(aPoint, one, a), eSafe = EU::SIMD::select(ePoint, one, e);
+   const BatchLanes denom = a * e - b * b;
+   const BatchLanes positive = denom > zero;
+   const BatchLanes sLine = EU::SIMD::select(positive, clampUnitLanes((b * f - c * e) / EU::SIMD::select(positive, denom, one)), zero);
+   const BatchLanes tLine = (b * sLine + f) / eSafe;
+   const BatchLanes sStart = clampUnitLanes(-c / aSafe);
+   BatchLanes s = EU::SIMD::select(tLine < zero, sStart, EU::SIMD::select(tLine > one, clampUnitLanes((b - c) / aSafe), sLine));
+   BatchLanes t = clampUnitLanes(tLine);
+   // Degenerate segments: s = 0 for a point first segment, t = 0 for a point second one.
+   s = EU::SIMD::select(aPoint, zero, EU::SIMD::select(ePoint, sStart, s));
+   t = EU::SIMD::select(ePoint, zero, EU::SIMD::select(aPoint, clampUnitLanes(f / eSafe), t));
+   BatchLanes distSq = zero;
+   for (int k = 0; k < 3; ++k) {
+    const BatchLanes g = r[k] + d1[k] * s - d2[k] * t;
+    distSq = distSq + g * g;
+   }
+   return distSq;
+  }
+ }
+
+ /**
+  * @brief Writes the indices of the capsules (a[i], b[i], radius[i]) that overlap sphere to
+  * hits, ascending; hits needs room for n.
+  * @return Number of indices written.
+  */
+ inline size_t
+  intersectSphereCapsules(const Sphere& sphere, EngineMath::batch::ConstSoA3 a, EngineMath::batch::ConstSoA3 b,
+                          const float* radius, size_t n, uint32_t* hits) {
+  using detail::BatchLanes;
+  const BatchLanes zero = BatchLanes::zero(), one = BatchLanes::set1(1.f), eps = BatchLanes::set1(EU::Constants::EPSILON);
+  BatchLanes p[3];
+  detail::splatLanes3(sphere.center, p);
+  const BatchLanes r0 = BatchLanes::set1(sphere.radius);
+  size_t found = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes la[3], lb[3], d[3], r[3];
+   detail::loadLanes3(a, i, count, la);
+   detail::loadLanes3(b, i, count, lb);
+   for (int k = 0; k < 3; ++k) {
+    d[k] = lb[k] - la[k];
+    r[k] = p[k] - la[k];
+   }
+   const BatchLanes lenSq = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+   const BatchLanes line = lenSq > eps;
+   const BatchLanes t = EU::SIMD::select(line, detail::clampUnitLanes((r[0] * d[0] + r[1] * d[1] + r[2] * d[2]) /
+                                                                      EU::SIMD::select(line, lenSq, one)), zero);
+   BatchLanes distSq = zero;
+   for (int k = 0; k < 3; ++k) {
+    const BatchLanes g = r[k] - d[k] * t;
+    distSq = distSq + g * g;
+   }
+   const BatchLanes sum = r0 + detail::loadLanes(radius, i, count);
+   found = detail::appendLanes(distSq <= sum * sum, count, static_cast<uint32_t>(i), hits, found);
+  }
+  return found;
+ }
+
+ /**
+  * @brief Writes the indices of the capsules (a[i], b[i], radius[i]) that overlap capsule to
+  * hits, ascending; hits needs room for n.
+  * @return Number of indices written.
+  */
+ inline size_t
+  intersectCapsuleCapsules(const Capsule& capsule, EngineMath::batch::ConstSoA3 a, EngineMath::batch::ConstSoA3 b,
+                           const float* radius, size_t n, uint32_t* hits) {
+  using detail::BatchLanes;
+  BatchLanes p[3], q[3];
+  detail::splatLanes3(capsule.a, p);
+  detail::splatLanes3(capsule.b, q);
+  const BatchLanes r0 = BatchLanes::set1(capsule.radius);
+  size_t found = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes la[3], lb[3];
+   detail::loadLanes3(a, i, count, la);
+   detail::loadLanes3(b, i, count, lb);
+   const BatchLanes sum = r0 + detail::loadLanes(radius, i, count);
+   const BatchLanes distSq = detail::segmentDistanceSquaredLanes(p, q, la, lb);
+   found = detail::appendLanes(distSq <= sum * sum, count, static_cast<uint32_t>(i), hits, found);
+  }
+  return found;
+ }
+
+ /**
+  * @brief Writes the indices of the boxes of boxes that overlap box to hits, ascending; hits
+  * needs room for n.
+  * @return Number of indices written.
+  */
+ inline size_t
+  intersectOrientedBoxes(const OrientedBox& box, const ConstOrientedBoxSoA& boxes, size_t n, uint32_t* hits) {
+  using detail::BatchLanes;
+  const float ea[3] = { box.halfExtents.x, box.halfExtents.y, box.halfExtents.z };
+  const BatchLanes eps = BatchLanes::set1(EU::Constants::EPSILON);
+  size_t found = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes c[3], eb[3], axes[3][3];
+   detail::loadLanes3(boxes.center, i, count, c);
+   detail::loadLanes3(boxes.halfExtents, i, count, eb);
+   for (int r = 0; r < 3; ++r)
+    for (int k = 0; k < 3; ++k) axes[r][k] = detail::loadLanes(boxes.axes[r][k], i, count);
+   const BatchLanes d[3] = { c[0] - BatchLanes::set1(box.center.x), c[1] - BatchLanes::set1(box.center.y),
+                             c[2] - BatchLanes::set1(box.center.z) };
+   BatchLanes R[3][3], absR[3][3], t[3];
+   for (int k = 0; k < 3; ++k) {
+    const BatchLanes a0 = BatchLanes::set1(box.axes.m[0][k]), a1 = BatchLanes::set1(box.axes.m[1][k]),
+                     a2 = BatchLanes::set1(box.axes.m[2][k]);
+    t[k] = d[0] * a0 + d[1] * a1 + d[2] * a2;
+    for (int j = 0; j < 3; ++j) {
+     R[k][j] = a0 * axes[0][j] + a1 * axes[1][j] + a2 * axes[2][j];
+     absR[k][j] = EU::SIMD::abs(R[k][j]) + eps;
+    }
+   }
+   BatchLanes overlap = detail::firstLanes(count);
+   for (int k = 0; k < 3; ++k) {
+    overlap = overlap & (EU::SIMD::abs(t[k]) <= BatchLanes::set1(ea[k]) + eb[0] * absR[k][0] + eb[1] * absR[k][1] + eb[2] * absR[k][2]);
+   }
+   for (int j = 0; j < 3; ++j) {
+    const BatchLanes proj = t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j];
+    const BatchLanes ra = BatchLanes::set1(ea[0]) * absR[0][j] + BatchLanes::set1(ea[1]) * absR[1][j] +
+                          BatchLanes::set1(ea[2]) * absR[2][j];
+    overlap = overlap & (EU::SIMD::abs(proj) <= ra + eb[j]);
+   }
+   if (EU::SIMD::movemask(overlap) == 0) continue;
+   for (int k = 0; k < 3; ++k) {
+    const int k1 = (k + 1) % 3, k2 = (k + 2) % 3;
+    for (int j = 0; j < 3; ++j) {
+     const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+     const BatchLanes ra = BatchLanes::set1(ea[k1]) * absR[k2][j] + BatchLanes::set1(ea[k2]) * absR[k1][j];
+     const BatchLanes rb = eb[j1] * absR[k][j2] + eb[j2] * absR[k][j1];
+     overlap = overlap & (EU::SIMD::abs(t[k2] * R[k1][j] - t[k1] * R[k2][j]) <= ra + rb);
+    }
+   }
+   found = detail::appendLanes(overlap, count, static_cast<uint32_t>(i), hits, found);
+  }
+  return found;
+ }
+
+ /**
+  * @brief Writes the indices of the boxes [lo[i], hi[i]] that triangle (v0, v1, v2) overlaps
+  * to hits, ascending, e.g. the voxels of a triangle's footprint; hits needs room for n.
+  * Empty boxes never overlap.
+  * @return Number of indices written.
+  */
+ inline size_t
+  intersectTriangleBoxes(const CVector3& v0, const CVector3& v1, const CVector3& v2, EngineMath::batch::ConstSoA3 lo,
+                         EngineMath::batch::ConstSoA3 hi, size_t n, uint32_t* hits) {
+  using detail::BatchLanes;
+  const CVector3 f[3] = { v1 - v0, v2 - v1, v0 - v2 };
+  const CVector3 normal = f[0].cross(f[1]);
+  // Edge axes as in intersectsTriangle(), fixed for the whole call.
+  CVector3 axes[9];
+  for (int j = 0; j < 3; ++j) {
+   axes[3 * j] = CVector3(0.f, -f[j].z, f[j].y);
+   axes[3 * j + 1] = CVector3(f[j].z, 0.f, -f[j].x);
+   axes[3 * j + 2] = CVector3(-f[j].y, f[j].x, 0.f);
+  }
+  const BatchLanes half = BatchLanes::set1(0.5f);
+  BatchLanes tri[3][3];
+  detail::splatLanes3(v0, tri[0]);
+  detail::splatLanes3(v1, tri[1]);
+  detail::splatLanes3(v2, tri[2]);
+  size_t found = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes l[3], u[3], h[3], p[3][3];
+   detail::loadLanes3(lo, i, count, l);
+   detail::loadLanes3(hi, i, count, u);
+   BatchLanes overlap = detail::firstLanes(count);
+   for (int k = 0; k < 3; ++k) {
+    overlap = overlap & (l[k] <= u[k]);
+    h[k] = (u[k] - l[k]) * half;
+    const BatchLanes c = (u[k] + l[k]) * half;
+    for (int v = 0; v < 3; ++v) p[v][k] = tri[v][k] - c;
+    const BatchLanes mn = EU::SIMD::min(p[0][k], EU::SIMD::min(p[1][k], p[2][k]));
+    const BatchLanes mx = EU::SIMD::max(p[0][k], EU::SIMD::max(p[1][k], p[2][k]));
+    overlap = overlap & (mn <= h[k]) & (-h[k] <= mx);
+   }
+   if (EU::SIMD::movemask(overlap) == 0) continue;
+   {
+    const BatchLanes nx = BatchLanes::set1(normal.x), ny = BatchLanes::set1(normal.y), nz = BatchLanes::set1(normal.z);
+    const BatchLanes r = h[0] * EU::SIMD::abs(nx) + h[1] * EU::SIMD::abs(ny) + h[2] * EU::SIMD::abs(nz);
+    overlap = overlap & (EU::SIMD::abs(p[0][0] * nx + p[0][1] * ny + p[0][2] * nz) <= r);
+   }
+   for (const CVector3& axis : axes) {
+    const BatchLanes ax = BatchLanes::set1(axis.x), ay = BatchLanes::set1(axis.y), az = BatchLanes::set1(axis.z);
+    const BatchLanes d0 = p[0][0] * ax + p[0][1] * ay + p[0][2] * az;
+    const BatchLanes d1 = p[1][0] * ax + p[1][1] * ay + p[1][2] * az;
+    const BatchLanes d2 = p[2][0] * ax + p[2][1] * ay + p[2][2] * az;
+    const BatchLanes r = h[0] * EU::SIMD::abs(ax) + h[1] * EU::SIMD::abs(ay) + h[2] * EU::SIMD::abs(az);
+    overlap = overlap & (EU::SIMD::min(d0, EU::SIMD::min(d1, d2)) <= r) & (-r <= EU::SIMD::max(d0, EU::SIMD::max(d1, d2)));
+   }
+   found = detail::appendLanes(overlap, count, static_cast<uint32_t>(i), hits, found);
+  }
+  return found;
+ }
+}
@@ -0,0 +1,737 @@
+/**
+ * @file Primitives.h
+ * @brief Rays, spheres, axis-aligned boxes and planes, with a SIMD ray-versus-boxes slab test.
+ *
+ * Everything here is a plain value type with constexpr tests; the ones that need a square
+ * root are EU_CONSTEXPR20. Rays are not normalized: a ray hits at origin + t * direction, t
+ * counted in units of its direction, and every intersection reports the first t >= 0 up to a
+ * caller's tMax. A ray starting inside a solid reports t = 0.
+ *
+ * The slab tests divide once per ray. Ray::inverseDirection() replaces the reciprocal of a
+ * zero component with +-RAY_PARALLEL_INVERSE, so a ray parallel to a slab misses it by any
+ * offset above 1e-8 (at the default tMax) instead of producing 0 * inf = NaN; rays running
+ * exactly along a box face count as hits. intersectRayBoxes() and closestRayBox() test one
+ * ray against a register of boxes (4 or 8) per step: the sign of each direction component
+ * picks which of the lo/hi SoA arrays holds the entry face once per call, so the inner loop
+ * is two multiply-subtracts per axis and no min/max swap, and an empty box (min > max) never
+ * hits.
+ *
+ * Transforms take affine Matrix4x4/Affine3x4 (the bottom row of a Matrix4x4 is ignored).
+ * Boxes go through Arvo's method: each output interval is the translation plus, per input
+ * axis, the smaller and larger of the two scaled bounds, which is exact for the box of the
+ * transformed box and needs no corners.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/Matrix4x4.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Stand-in reciprocal Ray::inverseDirection() gives components below 1 / RAY_PARALLEL_INVERSE.
+ constexpr float RAY_PARALLEL_INVERSE = 3e38f;
+
+ namespace detail {
+  /** 1 / d, or +-RAY_PARALLEL_INVERSE when that would overflow (the sign of -0 is +). */
+  constexpr float
+   safeInverse(float d) {
+   return EngineMath::fabs(d) * RAY_PARALLEL_INVERSE < 1.f ? (d < 0.f ? -RAY_PARALLEL_INVERSE : RAY_PARALLEL_INVERSE)
+                                                           : 1.f / d;
+  }
+
+  /** Box of the row-major affine block m[0..3)[0..4) applied to [lo, hi] (Arvo). */
+  template<typename Matrix>
+  constexpr void
+   transformBounds(const Matrix& matrix, const CVector3& lo, const CVector3& hi, CVector3& outLo, CVector3& outHi) {
+   const float l[3] = { lo.x, lo.y, lo.z }, h[3] = { hi.x, hi.y, hi.z };
+   float rl[3] = {}, rh[3] = {};
+   for (int fil = 0; fil < 3; ++fil) {
+    rl[fil] = rh[fil] = matrix.m[fil][3];
+    for (int col = 0; col < 3; ++col) {
+     const float a = matrix.m[fil][col] * l[col], b = matrix.m[fil][col] * h[col];
+     rl[fil] += a < b ? a : b;
+     rh[fil] += a < b ? b : a;
+    }
+   }
+   outLo = CVector3(rl[0], rl[1], rl[2]);
+   outHi = CVector3(rh[0], rh[1], rh[2]);
+  }
+
+  /** Largest squared column length of the upper 3x3 block: the squared maximum scale. */
+  template<typename Matrix>
+  constexpr float
+   maxScaleSquared(const Matrix& matrix) {
+   float best = 0.f;
+   for (int col = 0; col < 3; ++col) {
+    const float s = matrix.m[0][col] * matrix.m[0][col] + matrix.m[1][col] * matrix.m[1][col]
+                    + matrix.m[2][col] * matrix.m[2][col];
+    best = s > best ? s : best;
+   }
+   return best;
+  }
+
+  /** The affine block applied to a point. */
+  template<typename Matrix>
+  constexpr CVector3
+   affinePoint(const Matrix& matrix, const CVector3& p) {
+   const auto& m = matrix.m;
+   return CVector3(m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+                   m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+                   m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]);
+  }
+
+  /** The linear block applied to a direction. */
+  template<typename Matrix>
+  constexpr CVector3
+   affineVector(const Matrix& matrix, const CVector3& v) {
+   const auto& m = matrix.m;
+   return CVector3(m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+                   m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+                   m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+  }
+ }
+
+ /**
+  * @class Ray
+  * @brief Half-line origin + t * direction for t >= 0; direction need not be unit length.
+  */
+ class
+  Ray {
+  public:
+  CVector3 origin;    ///< Start point
+  CVector3 direction; ///< Step per unit of t
+
+  /**
+   * @brief Default constructor. From the origin along +Z.
+   */
+  constexpr Ray() : origin(0.f, 0.f, 0.f), direction(0.f, 0.f, 1.f) {}
+
+  constexpr Ray(const CVector3& origin, const CVector3& direction) : origin(origin), direction(direction) {}
+
+  /**
+   * @brief Ray from from through to, with t = 1 at to.
+   */
+  static constexpr Ray
+   fromPoints(const CVector3& from, const CVector3& to) {
+   return Ray(from, to - from);
+  }
+
+  /**
+   * @brief Point at parameter t.
+   */
+  constexpr CVector3
+   at(float t) const {
+   return CVector3(origin.x + direction.x * t, origin.y + direction.y * t, origin.z + direction.z * t);
+  }
+
+  /**
+   * @brief Per-component reciprocal of direction for slab tests; see the file notes.
+   */
+  constexpr CVector3
+   inverseDirection() const {
+   return CVector3(detail::safeInverse(direction.x), detail::safeInverse(direction.y), detail::safeInverse(direction.z));
+  }
+
+  /**
+   * @brief The ray under an affine transform; t keeps its meaning, hits map to hits.
+   */
+  constexpr Ray
+   transformed(const Matrix4x4& transform) const {
+   return Ray(detail::affinePoint(transform, origin), detail::affineVector(transform, direction));
+  }
+
+  constexpr Ray
+   transformed(const Affine3x4& transform) const {
+   return Ray(detail::affinePoint(transform, origin), detail::affineVector(transform, direction));
+  }
+ };
+
+ EU_ASSERT_VALUE_TYPE(Ray);
+
+ /**
+  * @class Sphere
+  * @brief Solid ball of radius around center.
+  */
+ class
+  Sphere {
+  public:
+  CVector3 center; ///< Center
+  float radius;    ///< Radius, >= 0
+
+  /**
+   * @brief Default constructor. A point at the origin.
+   */
+  constexpr Sphere() : center(0.f, 0.f, 0.f), radius(0.f) {}
+
+  constexpr Sphere(const CVector3& center, float radius) : center(center), radius(radius) {}
+
+  /**
+   * @brief Sphere around the bounding-box center of points[0..n) through the furthest one;
+   * not the minimal sphere, but within a factor sqrt(3) of it and one pass plus one sqrt.
+   */
+  static EU_CONSTEXPR20 Sphere
+   fromPoints(const CVector3* points, size_t n) {
+   if (n == 0) return Sphere();
+   CVector3 lo = points[0], hi = points[0];
+   for (size_t i = 1; i < n; ++i) {
+    lo = CVector3(points[i].x < lo.x ? points[i].x : lo.x, points[i].y < lo.y ? points[i].y : lo.y,
+                  points[i].z < lo.z ? points[i].z : lo.z);
+    hi = CVector3(points[i].x > hi.x ? points[i].x : hi.x, points[i].y > hi.y ? points[i].y : hi.y,
+                  points[i].z > hi.z ? points[i].z : hi.z);
+   }
+   const CVector3 c((lo.x + hi.x) * 0.5f, (lo.y + hi.y) * 0.5f, (lo.z + hi.z) * 0.5f);
+   float best = 0.f;
+   for (size_t i = 0; i < n; ++i) {
+    const float d = (points[i] - c).lengthSquared();
+    best = d > best ? d : best;
+   }
+   return Sphere(c, EngineMath::sqrtHardware(best));
+  }
+
+  /**
+   * @brief True when point is inside or on the sphere.
+   */
+  constexpr bool
+   containsPoint(const CVector3& point) const {
+   return (point - center).lengthSquared() <= radius * radius;
+  }
+
+  /**
+   * @brief True when otro lies entirely inside this sphere.
+   */
+  constexpr bool
+   contains(const Sphere& otro) const {
+   if (otro.radius > radius) return false;
+   const float slack = radius - otro.radius;
+   return (otro.center - center).lengthSquared() <= slack * slack;
+  }
+
+  /**
+   * @brief True when the two spheres overlap or touch.
+   */
+  constexpr bool
+   intersects(const Sphere& otro) const {
+   const float r = radius + otro.radius;
+   return (otro.center - center).lengthSquared() <= r * r;
+  }
+
+  /**
+   * @brief Smallest sphere enclosing both.
+   */
+  EU_CONSTEXPR20 Sphere
+   merged(const Sphere& otro) const {
+   const CVector3 offset = otro.center - center;
+   const float dist = EngineMath::sqrtHardware(offset.lengthSquared());
+   if (dist + otro.radius <= radius) return *this;
+   if (dist + radius <= otro.radius) return otro;
+   const float r = 0.5f * (dist + radius + otro.radius);
+   const float k = (r - radius) / dist; // dist > 0: equal centers return above
+   return Sphere(CVector3(center.x + offset.x * k, center.y + offset.y * k, center.z + offset.z * k), r);
+  }
+
+  /**
+   * @brief Sphere enclosing the transformed sphere: radius scaled by the largest axis scale.
+   */
+  EU_CONSTEXPR20 Sphere
+   transformed(const Matrix4x4& transform) const {
+   return Sphere(detail::affinePoint(transform, center), radius * EngineMath::sqrtHardware(detail::maxScaleSquared(transform)));
+  }
+
+  EU_CONSTEXPR20 Sphere
+   transformed(const Affine3x4& transform) const {
+   return Sphere(detail::affinePoint(transform, center), radius * EngineMath::sqrtHardware(detail::maxScaleSquared(transform)));
+  }
+
+  /**
+   * @brief First hit of ray in [0, tMax]; t is left unchanged on a miss.
+   */
+  EU_CONSTEXPR20 bool
+   intersectsRay(const Ray& ray, float tMax, float& t) const {
+   const CVector3 oc = ray.origin - center;
+   const float c = oc.lengthSquared() - radius * radius;
+   if (c <= 0.f) {
+    t = 0.f;
+    return true;
+   }
+   const float b = oc.dot(ray.direction);
+   if (b >= 0.f) return false; // outside and pointing away
+   const float a = ray.direction.lengthSquared();
+   const float disc = b * b - a * c;
+   if (disc < 0.f) return false;
+   const float hit = c / (-b + EngineMath::sqrtHardware(disc)); // (-b - sqrt(disc)) / a without cancellation
+   if (hit > tMax) return false;
+   t = hit;
+   return true;
+  }
+ };
+
+ EU_ASSERT_VALUE_TYPE(Sphere);
+
+ /**
+  * @class AABB
+  * @brief Axis-aligned box [min, max]; empty when any min component exceeds its max.
+  */
+ class
+  AABB {
+  public:
+  CVector3 min; ///< Lowest corner
+  CVector3 max; ///< Highest corner
+
+  /**
+   * @brief Default constructor. The empty box, which merge() replaces by what it adds.
+   */
+  constexpr AABB()
+   : min(EU::Constants::INF, EU::Constants::INF, EU::Constants::INF),
+     max(EU::Constants::NEG_INF, EU::Constants::NEG_INF, EU::Constants::NEG_INF) {}
+
+  constexpr AABB(const CVector3& min, const CVector3& max) : min(min), max(max) {}
+
+  /**
+   * @brief Box of center +- halfExtents.
+   */
+  static constexpr AABB
+   fromCenterExtents(const CVector3& center, const CVector3& halfExtents) {
+   return AABB(center - halfExtents, center + halfExtents);
+  }
+
+  /**
+   * @brief Bounding box of points[0..n); empty for n == 0.
+   */
+  static constexpr AABB
+   fromPoints(const CVector3* points, size_t n) {
+   AABB box;
+   for (size_t i = 0; i < n; ++i) box.merge(points[i]);
+   return box;
+  }
+
+  /**
+   * @brief Bounding box of a sphere.
+   */
+  static constexpr AABB
+   fromSphere(const Sphere& sphere) {
+   const CVector3 r(sphere.radius, sphere.radius, sphere.radius);
+   return AABB(sphere.center - r, sphere.center + r);
+  }
+
+  /**
+   * @brief True when the box holds no point.
+   */
+  constexpr bool
+   empty() const {
+   return min.x > max.x || min.y > max.y || min.z > max.z;
+  }
+
+  constexpr CVector3
+   center() const {
+   return CVector3((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+  }
+
+  constexpr CVector3
+   halfExtents() const {
+   return CVector3((max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f, (max.z - min.z) * 0.5f);
+  }
+
+  constexpr CVector3
+   size() const {
+   return max - min;
+  }
+
+  /**
+   * @brief Total area of the six faces, the SAH cost weight; 0 for an empty box.
+   */
+  constexpr float
+   surfaceArea() const {
+   if (empty()) return 0.f;
+   const CVector3 s = size();
+   return 2.f * (s.x * s.y + s.y * s.z + s.z * s.x);
+  }
+
+  constexpr float
+   volume() const {
+   if (empty()) return 0.f;
+   const CVector3 s = size();
+   return s.x * s.y * s.z;
+  }
+
+  /**
+   * @brief Grows the box to include point.
+   */
+  constexpr void
+   merge(const CVector3& point) {
+   min = CVector3(point.x < min.x ? point.x : min.x, point.y < min.y ? point.y : min.y, point.z < min.z ? point.z : min.z);
+   max = CVector3(point.x > max.x ? point.x : max.x, point.y > max.y ? point.y : max.y, point.z > max.z ? point.z : max.z);
+  }
+
+  /**
+   * @brief Grows the box to include otro; merging an empty box changes nothing.
+   */
+  constexpr void
+   merge(const AABB& otro) {
+   min = CVector3(otro.min.x < min.x ? otro.min.x : min.x, otro.min.y < min.y ? otro.min.y : min.y,
+                  otro.min.z < min.z ? otro.min.z : min.z);
+   max = CVector3(otro.max.x > max.x ? otro.max.x : max.x, otro.max.y > max.y ? otro.max.y : max.y,
+                  otro.max.z > max.z ? otro.max.z : max.z);
+  }
+
+  /**
+   * @brief Smallest box holding both.
+   */
+  constexpr AABB
+   merged(const AABB& otro) const {
+   AABB r = *this;
+   r.merge(otro);
+   return r;
+  }
+
+  /**
+   * @brief True when point is inside or on the box.
+   */
+  constexpr bool
+   containsPoint(const CVector3& point) const {
+   return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y
+          && point.z >= min.z && point.z <= max.z;
+  }
+
+  /**
+   * @brief True when otro (non-empty) lies entirely inside this box.
+   */
+  constexpr bool
+   contains(const AABB& otro) const {
+   return otro.min.x >= min.x && otro.max.x <= max.x && otro.min.y >= min.y && otro.max.y <= max.y
+          && otro.min.z >= min.z && otro.max.z <= max.z;
+  }
+
+  /**
+   * @brief True when sphere lies entirely inside this box.
+   */
+  constexpr bool
+   contains(const Sphere& sphere) const {
+   return sphere.center.x - sphere.radius >= min.x && sphere.center.x + sphere.radius <= max.x
+          && sphere.center.y - sphere.radius >= min.y && sphere.center.y + sphere.radius <= max.y
+          && sphere.center.z - sphere.radius >= min.z && sphere.center.z + sphere.radius <= max.z;
+  }
+
+  /**
+   * @brief True when the boxes overlap or touch; never for an empty box.
+   */
+  constexpr bool
+   intersects(const AABB& otro) const {
+   return min.x <= otro.max.x && otro.min.x <= max.x && min.y <= otro.max.y && otro.min.y <= max.y
+          && min.z <= otro.max.z && otro.min.z <= max.z;
+  }
+
+  /**
+   * @brief True when the sphere overlaps or touches the box.
+   */
+  constexpr bool
+   intersects(const Sphere& sphere) const {
+   return distanceSquared(sphere.center) <= sphere.radius * sphere.radius;
+  }
+
+  /**
+   * @brief Point of the box nearest to point (point itself when inside).
+   */
+  constexpr CVector3
+   closestPoint(const CVector3& point) const {
+   return CVector3(EngineMath::clamp(point.x, min.x, max.x), EngineMath::clamp(point.y, min.y, max.y),
+                   EngineMath::clamp(point.z, min.z, max.z));
+  }
+
+  /**
+   * @brief Squared distance from point to the box, 0 inside.
+   */
+  constexpr float
+   distanceSquared(const CVector3& point) const {
+   return (closestPoint(point) - point).lengthSquared();
+  }
+
+  /**
+   * @brief Bounding box of the transformed box (Arvo); an empty box stays empty.
+   */
+  constexpr AABB
+   transformed(const Matrix4x4& transform) const {
+   if (empty()) return *this;
+   AABB r;
+   detail::transformBounds(transform, min, max, r.min, r.max);
+   return r;
+  }
+
+  constexpr AABB
+   transformed(const Affine3x4& transform) const {
+   if (empty()) return *this;
+   AABB r;
+   detail::transformBounds(transform, min, max, r.min, r.max);
+   return r;
+  }
+
+  /**
+   * @brief First hit of ray in [0, tMax] by the slab test; t is left unchanged on a miss.
+   */
+  constexpr bool
+   intersectsRay(const Ray& ray, float tMax, float& t) const {
+   return intersectsRay(ray.origin, ray.inverseDirection(), tMax, t);
+  }
+
+  /**
+   * @brief intersectsRay() with the ray's inverseDirection() computed once by the caller,
+   * for testing one ray against many boxes.
+   */
+  constexpr bool
+   intersectsRay(const CVector3& origin, const CVector3& inverseDirection, float tMax, float& t) const {
+   const float o[3] = { origin.x, origin.y, origin.z };
+   const float d[3] = { inverseDirection.x, inverseDirection.y, inverseDirection.z };
+   const float lo[3] = { min.x, min.y, min.z }, hi[3] = { max.x, max.y, max.z };
+   float tNear = 0.f, tFar = tMax;
+   for (int a = 0; a < 3; ++a) {
+    const float enter = ((d[a] < 0.f ? hi[a] : lo[a]) - o[a]) * d[a];
+    const float leave = ((d[a] < 0.f ? lo[a] : hi[a]) - o[a]) * d[a];
+    tNear = enter > tNear ? enter : tNear;
+    tFar = leave < tFar ? leave : tFar;
+   }
+   if (tNear > tFar) return false;
+   t = tNear;
+   return true;
+  }
+ };
+
+ EU_ASSERT_VALUE_TYPE(AABB);
+
+ /**
+  * @class Plane
+  * @brief Points p with dot(normal, p) + d = 0; the positive side is the one normal points to.
+  *
+  * Same convention as the Frustum planes. With a unit normal, distance() is the signed
+  * Euclidean distance; every constructor below produces one.
+  */
+ class
+  Plane {
+  public:
+  CVector3 normal; ///< Unit normal
+  float d;         ///< Offset: minus the distance from the origin along normal
+
+  /**
+   * @brief Default constructor. The XZ plane, facing +Y.
+   */
+  constexpr Plane() : normal(0.f, 1.f, 0.f), d(0.f) {}
+
+  constexpr Plane(const CVector3& normal, float d) : normal(normal), d(d) {}
+
+  /**
+   * @brief Plane through point with the given unit normal.
+   */
+  static constexpr Plane
+   fromPointNormal(const CVector3& point, const CVector3& normal) {
+   return Plane(normal, -normal.dot(point));
+  }
+
+  /**
+   * @brief Plane through a, b and c, facing the side from which they run counter-clockwise.
+   * Collinear points give the default plane.
+   */
+  static EU_CONSTEXPR20 Plane
+   fromPoints(const CVector3& a, const CVector3& b, const CVector3& c) {
+   const CVector3 n = (b - a).cross(c - a);
+   const float lenSq = n.lengthSquared();
+   if (lenSq == 0.f) return Plane();
+   const float inv = 1.f / EngineMath::sqrtHardware(lenSq);
+   return fromPointNormal(a, CVector3(n.x * inv, n.y * inv, n.z * inv));
+  }
+
+  /**
+   * @brief Signed distance from point, positive on the normal side.
+   */
+  constexpr float
+   distance(const CVector3& point) const {
+   return normal.dot(point) + d;
+  }
+
+  /**
+   * @brief Orthogonal projection of point onto the plane.
+   */
+  constexpr CVector3
+   closestPoint(const CVector3& point) const {
+   const float s = distance(point);
+   return CVector3(point.x - normal.x * s, point.y - normal.y * s, point.z - normal.z * s);
+  }
+
+  /**
+   * @brief True when the sphere touches or crosses the plane.
+   */
+  constexpr bool
+   intersects(const Sphere& sphere) const {
+   return EngineMath::fabs(distance(sphere.center)) <= sphere.radius;
+  }
+
+  /**
+   * @brief True when the box touches or crosses the plane: its center is no further than
+   * the box's projected half-extent.
+   */
+  constexpr bool
+   intersects(const AABB& box) const {
+   const CVector3 e = box.halfExtents();
+   const float r = EngineMath::fabs(normal.x) * e.x + EngineMath::fabs(normal.y) * e.y + EngineMath::fabs(normal.z) * e.z;
+   return !box.empty() && EngineMath::fabs(distance(box.center())) <= r;
+  }
+
+  /**
+   * @brief Hit of ray with the plane (either side) in [0, tMax]; a parallel ray misses, even
+   * in the plane. t is left unchanged on a miss.
+   */
+  constexpr bool
+   intersectsRay(const Ray& ray, float tMax, float& t) const {
+   const float denom = normal.dot(ray.direction);
+   if (denom == 0.f) return false;
+   const float hit = -distance(ray.origin) / denom;
+   if (!(hit >= 0.f && hit <= tMax)) return false;
+   t = hit;
+   return true;
+  }
+
+  /**
+   * @brief The plane under an affine transform: (normal, d) times the inverse transform,
+   * renormalized; a singular transform maps through the identity, as inverseAffine().
+   */
+  EU_CONSTEXPR20 Plane
+   transformed(const Matrix4x4& transform) const {
+   return fromInverse(transform.inverseAffine());
+  }
+
+  EU_CONSTEXPR20 Plane
+   transformed(const Affine3x4& transform) const {
+   return fromInverse(transform.inverse());
+  }
+
+  private:
+  template<typename Matrix>
+  EU_CONSTEXPR20 Plane
+   fromInverse(const Matrix& inv) const {
+   const float n[3] = { normal.x, normal.y, normal.z };
+   float r[4] = { 0.f, 0.f, 0.f, d };
+   for (int col = 0; col < 4; ++col)
+    for (int fil = 0; fil < 3; ++fil) r[col] += n[fil] * inv.m[fil][col];
+   const float lenSq = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+   if (lenSq == 0.f) return *this;
+   const float s = 1.f / EngineMath::sqrtHardware(lenSq);
+   return Plane(CVector3(r[0] * s, r[1] * s, r[2] * s), r[3] * s);
+  }
+ };
+
+ EU_ASSERT_VALUE_TYPE(Plane);
+
+ namespace detail {
+  /**
+   * One ray broadcast across lanes; the sign of each direction component says whether the
+   * lo or the hi array of an axis holds the faces it enters through.
+   */
+  struct RayBoxLanes {
+   BatchLanes origin[3];
+   BatchLanes inverse[3];
+   bool negative[3];
+
+   explicit RayBoxLanes(const Ray& ray) {
+    const CVector3 inv = ray.inverseDirection();
+    const float o[3] = { ray.origin.x, ray.origin.y, ray.origin.z }, d[3] = { inv.x, inv.y, inv.z };
+    for (int a = 0; a < 3; ++a) {
+     origin[a] = BatchLanes::set1(o[a]);
+     inverse[a] = BatchLanes::set1(d[a]);
+     negative[a] = d[a] < 0.f;
+    }
+   }
+
+   /**
+    * Hit mask of the boxes [i, i + count) of lo/hi within [0, tMax]; tNear receives each
+    * entry t. Padding lanes past count test a point box at the origin: mask them.
+    */
+   BatchLanes
+    test(EngineMath::batch::ConstSoA3 lo, EngineMath::batch::ConstSoA3 hi, size_t i, size_t count, BatchLanes tMax,
+         BatchLanes& tNear) const {
+    const float* const l[3] = { lo.x, lo.y, lo.z };
+    const float* const h[3] = { hi.x, hi.y, hi.z };
+    tNear = BatchLanes::zero();
+    BatchLanes tFar = tMax;
+    for (int a = 0; a < 3; ++a) {
+     const BatchLanes enter = loadLanes(negative[a] ? h[a] : l[a], i, count);
+     const BatchLanes leave = loadLanes(negative[a] ? l[a] : h[a], i, count);
+     tNear = EU::SIMD::max(tNear, (enter - origin[a]) * inverse[a]);
+     tFar = EU::SIMD::min(tFar, (leave - origin[a]) * inverse[a]);
+    }
+    return tNear <= tFar;
+   }
+  };
+ }
+
+ /**
+  * @brief Writes the indices of the boxes [lo[i], hi[i]] that ray hits within [0, tMax] to
+  * hits, ascending, one register of boxes per step.
+  * @param hits Room for n indices.
+  * @param tEntry Optional, room for n floats: tEntry[k] is the entry t of box hits[k].
+  * @return Number of indices written.
+  */
+ inline size_t
+  intersectRayBoxes(const Ray& ray, EngineMath::batch::ConstSoA3 lo, EngineMath::batch::ConstSoA3 hi, size_t n,
+                    uint32_t* hits, float tMax = EU::Constants::INF, float* tEntry = nullptr) {
+  using detail::BatchLanes;
+  const detail::RayBoxLanes lanes(ray);
+  const BatchLanes limit = BatchLanes::set1(tMax);
+  size_t found = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes tNear;
+   const BatchLanes hit = lanes.test(lo, hi, i, count, limit, tNear);
+   const size_t before = found;
+   found = detail::appendLanes(hit, count, static_cast<uint32_t>(i), hits, found);
+   if (tEntry && found != before) {
+    float t[detail::BATCH_WIDTH];
+    tNear.store(t);
+    for (size_t k = before; k < found; ++k) tEntry[k] = t[hits[k] - i];
+   }
+  }
+  return found;
+ }
+
+ /**
+  * @brief Nearest box ray hits within [0, tMax], the lowest index on ties.
+  * @param index Receives the box index; left unchanged on a miss, as is t.
+  * @param t Receives its entry t.
+  * @return True on a hit.
+  */
+ inline bool
+  closestRayBox(const Ray& ray, EngineMath::batch::ConstSoA3 lo, EngineMath::batch::ConstSoA3 hi, size_t n,
+                uint32_t& index, float& t, float tMax = EU::Constants::INF) {
+  using detail::BatchLanes;
+  const detail::RayBoxLanes lanes(ray);
+  BatchLanes best = BatchLanes::set1(tMax);
+  bool found = false;
+  uint32_t bestIndex = 0;
+  float bestT = tMax;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes tNear;
+   // Shrinking tMax to the best hit so far lets later packets fail the slab test early.
+   const BatchLanes hit = lanes.test(lo, hi, i, count, best, tNear) & detail::firstLanes(count);
+   int bits = EU::SIMD::movemask(hit);
+   if (bits == 0) continue;
+   float tl[detail::BATCH_WIDTH];
+   tNear.store(tl);
+   for (uint32_t j = 0; bits != 0; ++j, bits >>= 1) {
+    if ((bits & 1) && (!found || tl[j] < bestT)) {
+     found = true;
+     bestT = tl[j];
+     bestIndex = static_cast<uint32_t>(i) + j;
+    }
+   }
+   best = BatchLanes::set1(bestT);
+  }
+  if (!found) return false;
+  index = bestIndex;
+  t = bestT;
+  return true;
+ }
+}
@@ -0,0 +1,208 @@
+/**
+ * @file RayTriangle.h
+ * @brief Moller-Trumbore ray-triangle tests: scalar, one ray against a register of triangles,
+ * and a register of rays against one triangle.
+ *
+ * Triangles have no facing: both sides hit, and only degenerate triangles (or rays in their
+ * plane) never do. A hit reports its ray parameter t in [0, tMax] and the barycentric weights
+ * u, v of the second and third corners. Edges are inclusive, so a ray through an edge shared
+ * by two triangles hits both and the lower index wins.
+ *
+ * The packet versions run on the SIMD backend's FloatN, 4 lanes with SSE or NEON and 8 with
+ * AVX, over SoA corners (or SoA rays), as in intersectRayBoxes(). They evaluate the same
+ * expressions as intersectRayTriangle(), so they agree with it up to FMA contraction.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/SIMD.h>
+#include <Math/EngineMathBatch.h>
+#include <Geometry/Primitives.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /**
+  * @brief Ray-triangle hit: the hit point is (1 - u - v) a + u b + v c of the triangle (a, b, c).
+  */
+ struct RayHit {
+  uint32_t triangle; ///< Index of the triangle hit
+  float t;           ///< Ray parameter of the hit
+  float u;           ///< Barycentric weight of the second corner
+  float v;           ///< Barycentric weight of the third corner
+ };
+
+ EU_ASSERT_VALUE_TYPE(RayHit);
+
+ /**
+  * @brief Two-sided test of ray against triangle (a, b, c) within [0, tMax].
+  * @return True on a hit; t, u and v are left unchanged on a miss.
+  */
+ constexpr bool
+  intersectRayTriangle(const Ray& ray, const CVector3& a, const CVector3& b, const CVector3& c, float tMax, float& t,
+                       float& u, float& v) {
+  const CVector3 e1 = b - a, e2 = c - a;
+  const CVector3 p = ray.direction.cross(e2);
+  const float det = e1.dot(p);
+  if (det == 0.f) return false; // parallel to the plane, or degenerate
+  const float inv = 1.f / det;
+  const CVector3 o = ray.origin - a;
+  const float hu = o.dot(p) * inv;
+  if (!(hu >= 0.f)) return false;
+  const CVector3 q = o.cross(e1);
+  const float hv = ray.direction.dot(q) * inv;
+  if (!(hv >= 0.f && hu + hv <= 1.f)) return false;
+  const float ht = e2.dot(q) * inv;
+  if (!(ht >= 0.f && ht <= tMax)) return false;
+  t = ht;
+  u = hu;
+  v = hv;
+  return true;
+ }
+
+ namespace detail {
+  inline BatchLanes
+   dotLanes(const BatchLanes (&a)[3], const BatchLanes (&b)[3]) {
+   return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  }
+
+  inline void
+   crossLanes(const BatchLanes (&a)[3], const BatchLanes (&b)[3], BatchLanes (&out)[3]) {
+   out[0] = a[1] * b[2] - a[2] * b[1];
+   out[1] = a[2] * b[0] - a[0] * b[2];
+   out[2] = a[0] * b[1] - a[1] * b[0];
+  }
+
+  /**
+   * Lane-wise intersectRayTriangle(): hit mask within [0, tMax], with t, u and v of every lane
+   * (meaningless where the mask is clear).
+   */
+  inline BatchLanes
+   rayTriangleLanes(const BatchLanes (&origin)[3], const BatchLanes (&direction)[3], const BatchLanes (&a)[3],
+                    const BatchLanes (&b)[3], const BatchLanes (&c)[3], BatchLanes tMax, BatchLanes& t, BatchLanes& u,
+                    BatchLanes& v) {
+   const BatchLanes e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+   const BatchLanes e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+   BatchLanes p[3], q[3];
+   crossLanes(direction, e2, p);
+   const BatchLanes det = dotLanes(e1, p);
+   // 1 / 0 is inf and the products below turn NaN or inf; the det mask discards them.
+   const BatchLanes inv = BatchLanes::set1(1.f) / det;
+   const BatchLanes o[3] = { origin[0] - a[0], origin[1] - a[1], origin[2] - a[2] };
+   u = dotLanes(o, p) * inv;
+   crossLanes(o, e1, q);
+   v = dotLanes(direction, q) * inv;
+   t = dotLanes(e2, q) * inv;
+   const BatchLanes zero = BatchLanes::zero();
+   return (det != zero) & (u >= zero) & (v >= zero) & (u + v <= BatchLanes::set1(1.f)) & (t >= zero) & (t <= tMax);
+  }
+ }
+
+ /**
+  * @brief Nearest of the triangles (a[i], b[i], c[i]), i < n, that ray hits within [0, tMax],
+  * one register of triangles per step; ties go to the lower index.
+  * @param hit Receives the triangle index i, t, u and v; left unchanged on a miss.
+  * @return True on a hit.
+  */
+ inline bool
+  closestRayTriangle(const Ray& ray, EngineMath::batch::ConstSoA3 a, EngineMath::batch::ConstSoA3 b,
+                     EngineMath::batch::ConstSoA3 c, size_t n, float tMax, RayHit& hit) {
+  using detail::BatchLanes;
+  BatchLanes origin[3], direction[3];
+  detail::splatLanes3(ray.origin, origin);
+  detail::splatLanes3(ray.direction, direction);
+  bool found = false;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes la[3], lb[3], lc[3], t, u, v;
+   detail::loadLanes3(a, i, count, la);
+   detail::loadLanes3(b, i, count, lb);
+   detail::loadLanes3(c, i, count, lc);
+   const BatchLanes mask =
+    detail::rayTriangleLanes(origin, direction, la, lb, lc, BatchLanes::set1(tMax), t, u, v) & detail::firstLanes(count);
+   int bits = EU::SIMD::movemask(mask);
+   if (bits == 0) continue;
+   float ts[detail::BATCH_WIDTH], us[detail::BATCH_WIDTH], vs[detail::BATCH_WIDTH];
+   t.store(ts);
+   u.store(us);
+   v.store(vs);
+   for (size_t k = 0; bits != 0; ++k, bits >>= 1) {
+    if ((bits & 1) && (!found || ts[k] < tMax)) {
+     tMax = ts[k];
+     hit = RayHit{ static_cast<uint32_t>(i + k), ts[k], us[k], vs[k] };
+     found = true;
+    }
+   }
+  }
+  return found;
+ }
+
+ /**
+  * @brief True when ray hits any of the triangles (a[i], b[i], c[i]), i < n, within [0, tMax];
+  * stops at the first register with a hit.
+  */
+ inline bool
+  anyRayTriangle(const Ray& ray, EngineMath::batch::ConstSoA3 a, EngineMath::batch::ConstSoA3 b,
+                 EngineMath::batch::ConstSoA3 c, size_t n, float tMax) {
+  using detail::BatchLanes;
+  BatchLanes origin[3], direction[3];
+  detail::splatLanes3(ray.origin, origin);
+  detail::splatLanes3(ray.direction, direction);
+  const BatchLanes limit = BatchLanes::set1(tMax);
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes la[3], lb[3], lc[3], t, u, v;
+   detail::loadLanes3(a, i, count, la);
+   detail::loadLanes3(b, i, count, lb);
+   detail::loadLanes3(c, i, count, lc);
+   const BatchLanes mask = detail::rayTriangleLanes(origin, direction, la, lb, lc, limit, t, u, v) & detail::firstLanes(count);
+   if (EU::SIMD::movemask(mask) != 0) return true;
+  }
+  return false;
+ }
+
+ /**
+  * @brief Tests the rays (origins[i], directions[i]), i < n, against triangle (a, b, c), one
+  * register of rays per step.
+  *
+  * hits[i].t is ray i's current tMax: a hit nearer than it overwrites hits[i] with triangle,
+  * t, u and v, and every other entry is left unchanged. Running this over a triangle list
+  * leaves each ray's nearest hit in hits.
+  * @return Number of entries overwritten.
+  */
+ inline size_t
+  intersectRaysTriangle(EngineMath::batch::ConstSoA3 origins, EngineMath::batch::ConstSoA3 directions, size_t n,
+                        const CVector3& a, const CVector3& b, const CVector3& c, uint32_t triangle, RayHit* hits) {
+  using detail::BatchLanes;
+  BatchLanes la[3], lb[3], lc[3];
+  detail::splatLanes3(a, la);
+  detail::splatLanes3(b, lb);
+  detail::splatLanes3(c, lc);
+  size_t updated = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   float limit[detail::BATCH_WIDTH] = {};
+   for (size_t k = 0; k < count; ++k) limit[k] = hits[i + k].t;
+   BatchLanes origin[3], direction[3], t, u, v;
+   detail::loadLanes3(origins, i, count, origin);
+   detail::loadLanes3(directions, i, count, direction);
+   const BatchLanes tMax = BatchLanes::load(limit);
+   const BatchLanes hit = detail::rayTriangleLanes(origin, direction, la, lb, lc, tMax, t, u, v);
+   int bits = EU::SIMD::movemask(hit & (t < tMax) & detail::firstLanes(count));
+   if (bits == 0) continue;
+   float ts[detail::BATCH_WIDTH], us[detail::BATCH_WIDTH], vs[detail::BATCH_WIDTH];
+   t.store(ts);
+   u.store(us);
+   v.store(vs);
+   for (size_t k = 0; bits != 0; ++k, bits >>= 1) {
+    if (bits & 1) {
+     hits[i + k] = RayHit{ triangle, ts[k], us[k], vs[k] };
+     ++updated;
+    }
+   }
+  }
+  return updated;
+ }
+}
@@ -0,0 +1,528 @@
+/**
+ * @file SDF.h
+ * @brief Signed distance functions (sphere, rounded box, capsule, smooth union), SoA batch
+ * evaluation, and a sparse volume of 8^3 bricks baked with Lipschitz skipping.
+ *
+ * Every distance is negative inside. The scalar functions and the register kernels share one
+ * template per primitive, so a batch evaluation gives the same values as a loop of scalar
+ * calls up to the rounding of sqrt. The smooth union is the polynomial smooth minimum:
+ * within k of each other the two distances blend with a round, everywhere else it is min().
+ *
+ * All primitives are exact distances, and min() and the polynomial smooth minimum never
+ * grow faster than their inputs, so an SDFScene is 1-Lipschitz: moving a point by r changes
+ * its distance by at most r. SDFVolume::bake() uses that to classify each brick from a single
+ * sample at its center. A brick whose center is farther than its half diagonal plus the
+ * narrow band from the surface cannot contain a band sample, so it is skipped and only its
+ * sign is kept. Bricks overlap by one sample (a stride of seven voxels), so trilinear
+ * sampling never needs a neighbour brick.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Geometry/Primitives.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Samples along each edge of an SDFVolume brick.
+ constexpr size_t SDF_BRICK = 8;
+ /// Samples per brick.
+ constexpr size_t SDF_BRICK_SAMPLES = SDF_BRICK * SDF_BRICK * SDF_BRICK;
+
+ namespace detail {
+  /// Points per evaluation task; fixes the work split.
+  constexpr size_t SDF_CHUNK = 4096;
+  /// Batches smaller than this are evaluated on the calling thread.
+  constexpr size_t PARALLEL_SDF_MIN = 1 << 14;
+  /// Bricks per baking task.
+  constexpr size_t SDF_BRICK_CHUNK = 16;
+  /// Brick table entries of skipped bricks, by sign.
+  constexpr uint32_t SDF_BRICK_OUTSIDE = 0xffffffffu;
+  constexpr uint32_t SDF_BRICK_INSIDE = 0xfffffffeu;
+  /// Bricks along one axis at most, so the table index fits comfortably in size_t.
+  constexpr size_t SDF_MAX_BRICKS_AXIS = 4096;
+
+  // The kernels below are written once for float and for BatchLanes through these.
+  inline float sdfMin(float a, float b) { return a < b ? a : b; }
+  inline float sdfMax(float a, float b) { return a > b ? a : b; }
+  inline float sdfAbs(float a) { return EngineMath::fabs(a); }
+  inline float sdfSqrt(float a) { return EngineMath::sqrtHardware(a); }
+  inline float sdfSplat(float a, float) { return a; }
+  inline BatchLanes sdfMin(BatchLanes a, BatchLanes b) { return EU::SIMD::min(a, b); }
+  inline BatchLanes sdfMax(BatchLanes a, BatchLanes b) { return EU::SIMD::max(a, b); }
+  inline BatchLanes sdfAbs(BatchLanes a) { return EU::SIMD::abs(a); }
+  inline BatchLanes sdfSqrt(BatchLanes a) { return EU::SIMD::sqrt(a); }
+  inline BatchLanes sdfSplat(float a, BatchLanes) { return BatchLanes::set1(a); }
+
+  template<typename T>
+  inline T
+   sdfLength(T x, T y, T z) {
+   return sdfSqrt(x * x + y * y + z * z);
+  }
+
+  template<typename T>
+  inline T
+   sdfSphere(T x, T y, T z, const CVector3& center, float radius) {
+   return sdfLength(x - sdfSplat(center.x, x), y - sdfSplat(center.y, x), z - sdfSplat(center.z, x)) -
+          sdfSplat(radius, x);
+  }
+
+  /** Box with half extents half, its edges rounded by rounding (<= the smallest half extent). */
+  template<typename T>
+  inline T
+   sdfBox(T x, T y, T z, const CVector3& center, const CVector3& half, float rounding) {
+   const T zero = sdfSplat(0.f, x);
+   const T qx = sdfAbs(x - sdfSplat(center.x, x)) - sdfSplat(half.x - rounding, x);
+   const T qy = sdfAbs(y - sdfSplat(center.y, x)) - sdfSplat(half.y - rounding, x);
+   const T qz = sdfAbs(z - sdfSplat(center.z, x)) - sdfSplat(half.z - rounding, x);
+   const T outside = sdfLength(sdfMax(qx, zero), sdfMax(qy, zero), sdfMax(qz, zero));
+   return outside + sdfMin(sdfMax(qx, sdfMax(qy, qz)), zero) - sdfSplat(rounding, x);
+  }
+
+  /** Capsule around segment a + t ab; inverseLengthSq is 1 / |ab|^2, or 0 for a sphere. */
+  template<typename T>
+  inline T
+   sdfCapsule(T x, T y, T z, const CVector3& a, const CVector3& ab, float inverseLengthSq, float radius) {
+   const T px = x - sdfSplat(a.x, x), py = y - sdfSplat(a.y, x), pz = z - sdfSplat(a.z, x);
+   const T bx = sdfSplat(ab.x, x), by = sdfSplat(ab.y, x), bz = sdfSplat(ab.z, x);
+   const T t = sdfMin(sdfSplat(1.f, x),
+                      sdfMax(sdfSplat(0.f, x), (px * bx + py * by + pz * bz) * sdfSplat(inverseLengthSq, x)));
+   return sdfLength(px - bx * t, py - by * t, pz - bz * t) - sdfSplat(radius, x);
+  }
+
+  template<typename T>
+  inline T
+   sdfSmoothUnion(T a, T b, float k) {
+   if (!(k > 0.f)) return sdfMin(a, b);
+   const T h = sdfMin(sdfSplat(1.f, a), sdfMax(sdfSplat(0.f, a), sdfSplat(0.5f, a) + (b - a) * sdfSplat(0.5f / k, a)));
+   return b + (a - b) * h - sdfSplat(k, a) * h * (sdfSplat(1.f, a) - h);
+  }
+ }
+
+ /** @brief Distance to the sphere of the given center and radius. */
+ inline float
+  sdfSphere(const CVector3& p, const CVector3& center, float radius) {
+  return detail::sdfSphere(p.x, p.y, p.z, center, radius);
+ }
+
+ /**
+  * @brief Distance to a box of half extents halfExtents around center, with its edges and
+  * corners rounded by rounding (0 for a sharp box, at most the smallest half extent).
+  */
+ inline float
+  sdfBox(const CVector3& p, const CVector3& center, const CVector3& halfExtents, float rounding = 0.f) {
+  return detail::sdfBox(p.x, p.y, p.z, center, halfExtents, rounding);
+ }
+
+ /** @brief Distance to the capsule of the given radius around segment [a, b]. */
+ inline float
+  sdfCapsule(const CVector3& p, const CVector3& a, const CVector3& b, float radius) {
+  const CVector3 ab = b - a;
+  const float lengthSq = ab.lengthSquared();
+  return detail::sdfCapsule(p.x, p.y, p.z, a, ab, lengthSq > 0.f ? 1.f / lengthSq : 0.f, radius);
+ }
+
+ /** @brief Union of two shapes: the nearer distance. */
+ inline float
+  sdfUnion(float a, float b) {
+  return a < b ? a : b;
+ }
+
+ /** @brief Where both shapes are. */
+ inline float
+  sdfIntersection(float a, float b) {
+  return a > b ? a : b;
+ }
+
+ /** @brief Shape a with shape b carved out. */
+ inline float
+  sdfSubtraction(float a, float b) {
+  return a > -b ? a : -b;
+ }
+
+ /**
+  * @brief Union blended with a fillet of radius about k where the shapes meet; k <= 0 is
+  * sdfUnion(). Never exceeds min(a, b), and equals it wherever |a - b| >= k.
+  */
+ inline float
+  sdfSmoothUnion(float a, float b, float k) {
+  return detail::sdfSmoothUnion(a, b, k);
+ }
+
+ /** @brief out[i] = sdfSphere(points[i], center, radius). */
+ inline void
+  sdfSphere(EngineMath::batch::ConstSoA3 points, size_t n, const CVector3& center, float radius, float* out) {
+  using detail::BATCH_WIDTH;
+  for (size_t i = 0; i < n; i += BATCH_WIDTH) {
+   const size_t count = n - i < BATCH_WIDTH ? n - i : BATCH_WIDTH;
+   detail::BatchLanes p[3];
+   detail::loadLanes3(points, i, count, p);
+   detail::storeLanes(detail::sdfSphere(p[0], p[1], p[2], center, radius), out, i, count);
+  }
+ }
+
+ /** @brief out[i] = sdfBox(points[i], center, halfExtents, rounding). */
+ inline void
+  sdfBox(EngineMath::batch::ConstSoA3 points, size_t n, const CVector3& center, const CVector3& halfExtents,
+         float rounding, float* out) {
+  using detail::BATCH_WIDTH;
+  for (size_t i = 0; i < n; i += BATCH_WIDTH) {
+   const size_t count = n - i < BATCH_WIDTH ? n - i : BATCH_WIDTH;
+   detail::BatchLanes p[3];
+   detail::loadLanes3(points, i, count, p);
+   detail::storeLanes(detail::sdfBox(p[0], p[1], p[2], center, halfExtents, rounding), out, i, count);
+  }
+ }
+
+ /** @brief out[i] = sdfCapsule(points[i], a, b, radius). */
+ inline void
+  sdfCapsule(EngineMath::batch::ConstSoA3 points, size_t n, const CVector3& a, const CVector3& b, float radius,
+             float* out) {
+  using detail::BATCH_WIDTH;
+  const CVector3 ab = b - a;
+  const float lengthSq = ab.lengthSquared(), inverse = lengthSq > 0.f ? 1.f / lengthSq : 0.f;
+  for (size_t i = 0; i < n; i += BATCH_WIDTH) {
+   const size_t count = n - i < BATCH_WIDTH ? n - i : BATCH_WIDTH;
+   detail::BatchLanes p[3];
+   detail::loadLanes3(points, i, count, p);
+   detail::storeLanes(detail::sdfCapsule(p[0], p[1], p[2], a, ab, inverse, radius), out, i, count);
+  }
+ }
+
+ /** @brief Kind of an SDFScene primitive. */
+ enum class SDFShape : uint8_t {
+  Sphere,
+  Box,
+  Capsule
+ };
+
+ /**
+  * @brief One primitive of an SDFScene. Sphere: a center. Box: a center, b half extents.
+  * Capsule: segment [a, b]. radius is the sphere or capsule radius, or the box rounding.
+  */
+ struct SDFPrimitive {
+  SDFShape shape;
+  CVector3 a;
+  CVector3 b;
+  float radius;
+ };
+
+ /**
+  * @class SDFScene
+  * @brief Smooth union of primitives, evaluated one point or a register of points at a time.
+  */
+ class
+  SDFScene {
+  public:
+  /**
+   * @param blend Smooth union radius k between every pair of primitives; 0 for a hard union.
+   */
+  explicit SDFScene(float blend = 0.f) : m_blend(blend) {}
+
+  /** @brief Adds a primitive and returns its index. */
+  size_t
+   add(const SDFPrimitive& primitive) {
+   m_primitives.push_back(primitive);
+   if (primitive.shape == SDFShape::Capsule) {
+    // Capsules keep a and b - a; 1 / |b - a|^2 goes to m_inverse.
+    m_primitives.back().b = primitive.b - primitive.a;
+   }
+   const float lengthSq = m_primitives.back().b.lengthSquared();
+   m_inverse.push_back(primitive.shape == SDFShape::Capsule && lengthSq > 0.f ? 1.f / lengthSq : 0.f);
+   return m_primitives.size() - 1;
+  }
+
+  size_t
+   addSphere(const CVector3& center, float radius) {
+   return add(SDFPrimitive{ SDFShape::Sphere, center, CVector3(), radius });
+  }
+
+  size_t
+   addBox(const CVector3& center, const CVector3& halfExtents, float rounding = 0.f) {
+   return add(SDFPrimitive{ SDFShape::Box, center, halfExtents, rounding });
+  }
+
+  size_t
+   addCapsule(const CVector3& a, const CVector3& b, float radius) {
+   return add(SDFPrimitive{ SDFShape::Capsule, a, b, radius });
+  }
+
+  void
+   clear() {
+   m_primitives.clear();
+   m_inverse.clear();
+  }
+
+  size_t
+   size() const {
+   return m_primitives.size();
+  }
+
+  void
+   setBlend(float blend) {
+   m_blend = blend;
+  }
+
+  float
+   blend() const {
+   return m_blend;
+  }
+
+  /** @brief Signed distance at p; Constants::INF for an empty scene. */
+  float
+   distance(const CVector3& p) const {
+   return evaluate(p.x, p.y, p.z);
+  }
+
+  /**
+   * @brief out[i] = distance(points[i]) for n points.
+   *
+   * Batches of PARALLEL_SDF_MIN points and more are split into SDF_CHUNK-sized tasks over
+   * threads (0 = hardware_concurrency(), 1 = caller only).
+   */
+  void
+   distance(EngineMath::batch::ConstSoA3 points, size_t n, float* out, size_t threads = 0) const {
+   const size_t chunks = (n + detail::SDF_CHUNK - 1) / detail::SDF_CHUNK;
+   auto run = [&](size_t chunk) {
+    using detail::BATCH_WIDTH;
+    const size_t begin = chunk * detail::SDF_CHUNK;
+    const size_t end = n - begin < detail::SDF_CHUNK ? n : begin + detail::SDF_CHUNK;
+    for (size_t i = begin; i < end; i += BATCH_WIDTH) {
+     const size_t count = end - i < BATCH_WIDTH ? end - i : BATCH_WIDTH;
+     detail::BatchLanes p[3];
+     detail::loadLanes3(points, i, count, p);
+     detail::storeLanes(evaluate(p[0], p[1], p[2]), out, i, count);
+    }
+   };
+   threads = detail::resolveThreads(threads, chunks);
+   if (n < detail::PARALLEL_SDF_MIN || threads <= 1) {
+    for (size_t chunk = 0; chunk < chunks; ++chunk) run(chunk);
+    return;
+   }
+   detail::parallelTasks(chunks, threads, run);
+  }
+
+  /** @brief Distance of a register of points, for callers with their own sample layout. */
+  template<typename T>
+  T
+   evaluate(T x, T y, T z) const {
+   T d = detail::sdfSplat(Constants::INF, x);
+   for (size_t i = 0; i < m_primitives.size(); ++i) {
+    const SDFPrimitive& p = m_primitives[i];
+    T s;
+    switch (p.shape) {
+     case SDFShape::Sphere: s = detail::sdfSphere(x, y, z, p.a, p.radius); break;
+     case SDFShape::Box: s = detail::sdfBox(x, y, z, p.a, p.b, p.radius); break;
+     default: s = detail::sdfCapsule(x, y, z, p.a, p.b, m_inverse[i], p.radius); break;
+    }
+    d = i == 0 ? s : detail::sdfSmoothUnion(d, s, m_blend);
+   }
+   return d;
+  }
+
+  private:
+  std::vector<SDFPrimitive> m_primitives; ///< Capsules store b - a in b
+  std::vector<float> m_inverse;           ///< 1 / |b - a|^2 of capsules
+  float m_blend;
+ };
+
+ /**
+  * @class SDFVolume
+  * @brief Narrow-band distance samples of an SDFScene on a grid, stored as sparse 8^3 bricks.
+  */
+ class
+  SDFVolume {
+  public:
+  SDFVolume() : m_origin(), m_voxel(0.f), m_inverseVoxel(0.f), m_band(0.f), m_bricksX(0), m_bricksY(0), m_bricksZ(0) {}
+
+  /**
+   * @brief Samples scene over bounds on a grid of spacing voxelSize, keeping the bricks
+   * that may hold a sample within band of the surface.
+   *
+   * Brick classification and baking run over threads (0 = hardware_concurrency(), 1 =
+   * caller only); the result does not depend on it.
+   * @return False (and an empty volume) for an empty box, a non-positive voxel size or
+   * more than SDF_MAX_BRICKS_AXIS bricks along an axis.
+   */
+  bool
+   bake(const SDFScene& scene, const AABB& bounds, float voxelSize, float band, size_t threads = 0) {
+   clear();
+   if (!(voxelSize > 0.f) || !(bounds.min.x <= bounds.max.x && bounds.min.y <= bounds.max.y && bounds.min.z <= bounds.max.z)) {
+    return false;
+   }
+   const float stride = static_cast<float>(SDF_BRICK - 1) * voxelSize;
+   const CVector3 extent = bounds.max - bounds.min;
+   size_t counts[3];
+   for (int k = 0; k < 3; ++k) {
+    const float bricks = extent[k] / stride;
+    if (!(bricks < static_cast<float>(detail::SDF_MAX_BRICKS_AXIS))) return false;
+    counts[k] = static_cast<size_t>(bricks) + 1;
+   }
+   m_origin = bounds.min;
+   m_voxel = voxelSize;
+   m_inverseVoxel = 1.f / voxelSize;
+   m_band = band > 0.f ? band : 0.f;
+   m_bricksX = counts[0];
+   m_bricksY = counts[1];
+   m_bricksZ = counts[2];
+   const size_t total = m_bricksX * m_bricksY * m_bricksZ;
+
+   // Brick centers, evaluated as one SoA batch: a kept brick is marked 0 for now.
+   const float halfSpan = 0.5f * stride;
+   m_centers.resize(4 * total);
+   float* cx = m_centers.data();
+   float* cy = cx + total;
+   float* cz = cy + total;
+   float* cd = cz + total;
+   for (size_t b = 0; b < total; ++b) {
+    const CVector3 center = brickOrigin(b) + CVector3(halfSpan, halfSpan, halfSpan);
+    cx[b] = center.x;
+    cy[b] = center.y;
+    cz[b] = center.z;
+   }
+   scene.distance(EngineMath::batch::ConstSoA3{ cx, cy, cz }, total, cd, threads);
+   const float reach = halfSpan * EngineMath::sqrtHardware(3.f) + m_band;
+   m_table.resize(total);
+   size_t kept = 0;
+   for (size_t b = 0; b < total; ++b) {
+    if (EngineMath::fabs(cd[b]) > reach) {
+     m_table[b] = cd[b] < 0.f ? detail::SDF_BRICK_INSIDE : detail::SDF_BRICK_OUTSIDE;
+    }
+    else {
+     m_table[b] = static_cast<uint32_t>(kept);
+     m_bricks.push_back(static_cast<uint32_t>(b));
+     ++kept;
+    }
+   }
+
+   m_samples.resize(kept * SDF_BRICK_SAMPLES);
+   const size_t chunks = (kept + detail::SDF_BRICK_CHUNK - 1) / detail::SDF_BRICK_CHUNK;
+   auto run = [&](size_t chunk) {
+    const size_t end = std::min(kept, (chunk + 1) * detail::SDF_BRICK_CHUNK);
+    for (size_t k = chunk * detail::SDF_BRICK_CHUNK; k < end; ++k) bakeBrick(scene, k);
+   };
+   const size_t workers = detail::resolveThreads(threads, chunks);
+   if (chunks < 2 || workers <= 1) {
+    for (size_t chunk = 0; chunk < chunks; ++chunk) run(chunk);
+   }
+   else {
+    detail::parallelTasks(chunks, workers, run);
+   }
+   return true;
+  }
+
+  /** @brief Forgets every brick; storage is kept for the next bake(). */
+  void
+   clear() {
+   m_table.clear();
+   m_bricks.clear();
+   m_samples.clear();
+   m_bricksX = m_bricksY = m_bricksZ = 0;
+  }
+
+  /** @brief Bricks in the grid, stored or skipped. */
+  size_t
+   brickCount() const {
+   return m_table.size();
+  }
+
+  /** @brief Bricks holding samples. */
+  size_t
+   storedBrickCount() const {
+   return m_bricks.size();
+  }
+
+  /** @brief The samples of stored brick k, x fastest, then y, then z. */
+  const float*
+   brickSamples(size_t k) const {
+   return m_samples.data() + k * SDF_BRICK_SAMPLES;
+  }
+
+  /** @brief Lowest corner of stored brick k: its sample (0, 0, 0). */
+  CVector3
+   storedBrickOrigin(size_t k) const {
+   return brickOrigin(m_bricks[k]);
+  }
+
+  /**
+   * @brief Trilinear distance at p, clamped to the baked bounds. Skipped bricks read as
+   * +-band by their sign, so the result is exact only within the band.
+   */
+  float
+   sample(const CVector3& p) const {
+   if (m_table.empty()) return m_band;
+   const float g[3] = { (p.x - m_origin.x) * m_inverseVoxel, (p.y - m_origin.y) * m_inverseVoxel,
+                        (p.z - m_origin.z) * m_inverseVoxel };
+   const size_t limits[3] = { m_bricksX, m_bricksY, m_bricksZ };
+   size_t brick[3], cell[3];
+   float t[3];
+   for (int k = 0; k < 3; ++k) {
+    const float top = static_cast<float>(limits[k] * (SDF_BRICK - 1));
+    const float v = EngineMath::clamp(g[k], 0.f, top);
+    size_t index = static_cast<size_t>(v);
+    if (index >= limits[k] * (SDF_BRICK - 1)) index = limits[k] * (SDF_BRICK - 1) - 1;
+    brick[k] = index / (SDF_BRICK - 1);
+    cell[k] = index - brick[k] * (SDF_BRICK - 1);
+    t[k] = v - static_cast<float>(index);
+   }
+   const uint32_t entry = m_table[(brick[2] * m_bricksY + brick[1]) * m_bricksX + brick[0]];
+   if (entry == detail::SDF_BRICK_OUTSIDE) return m_band;
+   if (entry == detail::SDF_BRICK_INSIDE) return -m_band;
+   const float* s = brickSamples(entry) + (cell[2] * SDF_BRICK + cell[1]) * SDF_BRICK + cell[0];
+   const size_t dy = SDF_BRICK, dz = SDF_BRICK * SDF_BRICK;
+   auto lerp = [](float a, float b, float f) { return a + (b - a) * f; };
+   const float x00 = lerp(s[0], s[1], t[0]), x10 = lerp(s[dy], s[dy + 1], t[0]);
+   const float x01 = lerp(s[dz], s[dz + 1], t[0]), x11 = lerp(s[dz + dy], s[dz + dy + 1], t[0]);
+   return lerp(lerp(x00, x10, t[1]), lerp(x01, x11, t[1]), t[2]);
+  }
+
+  private:
+  CVector3
+   brickOrigin(size_t b) const {
+   const size_t x = b % m_bricksX, y = (b / m_bricksX) % m_bricksY, z = b / (m_bricksX * m_bricksY);
+   const float stride = static_cast<float>(SDF_BRICK - 1) * m_voxel;
+   return m_origin + CVector3(static_cast<float>(x) * stride, static_cast<float>(y) * stride, static_cast<float>(z) * stride);
+  }
+
+  /** Every sample of stored brick k, one register of x samples at a time. */
+  void
+   bakeBrick(const SDFScene& scene, size_t k) {
+   using detail::BatchLanes;
+   using detail::BATCH_WIDTH;
+   static_assert(SDF_BRICK % BATCH_WIDTH == 0, "brick rows must be whole registers");
+   const CVector3 origin = brickOrigin(m_bricks[k]);
+   float ramp[BATCH_WIDTH];
+   for (size_t j = 0; j < BATCH_WIDTH; ++j) ramp[j] = static_cast<float>(j) * m_voxel;
+   const BatchLanes offsets = BatchLanes::load(ramp);
+   float* out = m_samples.data() + k * SDF_BRICK_SAMPLES;
+   for (size_t w = 0; w < SDF_BRICK; ++w) {
+    const BatchLanes z = BatchLanes::set1(origin.z + static_cast<float>(w) * m_voxel);
+    for (size_t v = 0; v < SDF_BRICK; ++v) {
+     const BatchLanes y = BatchLanes::set1(origin.y + static_cast<float>(v) * m_voxel);
+     for (size_t u = 0; u < SDF_BRICK; u += BATCH_WIDTH) {
+      const BatchLanes x = BatchLanes::set1(origin.x + static_cast<float>(u) * m_voxel) + offsets;
+      scene.evaluate(x, y, z).store(out + (w * SDF_BRICK + v) * SDF_BRICK + u);
+     }
+    }
+   }
+  }
+
+  CVector3 m_origin;
+  float m_voxel;
+  float m_inverseVoxel;
+  float m_band;
+  size_t m_bricksX, m_bricksY, m_bricksZ;
+  std::vector<uint32_t> m_table;   ///< Per brick: stored index, or SDF_BRICK_INSIDE/OUTSIDE
+  std::vector<uint32_t> m_bricks;  ///< Grid index of each stored brick
+  std::vector<float> m_samples;    ///< SDF_BRICK_SAMPLES per stored brick
+  std::vector<float> m_centers;    ///< Bake scratch: brick centers and their distances
+ };
+}
@@ -0,0 +1,422 @@
+/**
+ * @file SpatialHash2D.h
+ * @brief Uniform-grid broadphase for 2D circles: radius and box queries and overlapping pairs.
+ *
+ * Every entity is a circle filed under the grid cell of its center. Cells are hashed into a
+ * power-of-two table of at least twice the entity count, so the world needs no bounds. rebuild()
+ * counting-sorts the entities by hash bucket into SoA slots (x, y, radius, cell, id), which
+ * puts each cell's entities next to each other in memory. If no entity changed cell since the
+ * last rebuild, the order is kept and only the slot positions and radii are refreshed.
+ *
+ * Queries visit the cells the query shape can reach, widened by the largest radius in the
+ * grid, and skip any slot that belongs to another cell hashed to the same bucket. pairs()
+ * visits only the forward half of each entity's neighbourhood, so every overlapping pair is
+ * reported once. Overlap is inclusive: |a - b| <= ra + rb.
+ *
+ * A cell size around the typical entity diameter works best. Much smaller cells make every
+ * entity visit many empty cells; much larger ones put many entities into each cell. Entities
+ * whose radius exceeds the cell size are kept on a separate list and tested against the grid
+ * one by one, so a few big ones do not widen everyone else's search.
+ *
+ * Queries see the entities as of the last rebuild(). Large sets are cut into fixed
+ * GRID_CHUNK-sized chunks over threads (0 = hardware_concurrency(), 1 = caller only), and the
+ * results are identical for any thread count.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Math/EngineMath.h>
+#include <Math/IntMath.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/VectorReduce.h>
+
+namespace EU {
+ namespace detail {
+  /// Entities or slots per task; fixes the work split.
+  constexpr size_t GRID_CHUNK = 4096;
+  /// Sets smaller than this are processed on the calling thread.
+  constexpr size_t PARALLEL_GRID_MIN = 16384;
+  /// Cell coordinates are clamped to +-GRID_CELL_LIMIT, far enough for any sane world.
+  constexpr float GRID_CELL_LIMIT = 1073741824.f;
+
+  /** One cell of the grid. */
+  struct GridCell {
+   int32_t x;
+   int32_t y;
+
+   constexpr bool
+    operator==(const GridCell& otro) const {
+    return x == otro.x && y == otro.y;
+   }
+  };
+
+  inline int32_t
+   gridCoordinate(float v, float inverseCell) {
+   return EngineMath::floor(EngineMath::clamp(v * inverseCell, -GRID_CELL_LIMIT, GRID_CELL_LIMIT));
+  }
+
+  /** Bucket of cell in a table of mask + 1 buckets. */
+  constexpr uint32_t
+   gridBucket(GridCell cell, uint32_t mask) {
+   return ((static_cast<uint32_t>(cell.x) * 73856093u) ^ (static_cast<uint32_t>(cell.y) * 19349663u)) & mask;
+  }
+
+  /** Calls fn(chunk, begin, end) for every GRID_CHUNK-sized chunk of [0, n). */
+  template<typename Fn>
+  inline void
+   forEachGridChunk(size_t n, size_t threads, Fn fn) {
+   const size_t chunks = (n + GRID_CHUNK - 1) / GRID_CHUNK;
+   parallelTasks(chunks, n < PARALLEL_GRID_MIN ? 1 : resolveThreads(threads, chunks), [&](size_t c) {
+    const size_t begin = c * GRID_CHUNK;
+    fn(c, begin, n - begin < GRID_CHUNK ? n : begin + GRID_CHUNK);
+   });
+  }
+ }
+
+ /**
+  * @class SpatialHash2D
+  * @brief Broadphase over circles on a hashed uniform grid.
+  */
+ class
+  SpatialHash2D {
+  public:
+  /**
+   * @brief Grid of cellSize by cellSize cells; a non-positive size is replaced by 1.
+   */
+  explicit SpatialHash2D(float cellSize = 1.f) {
+   setCellSize(cellSize);
+  }
+
+  /** @brief Changes the cell size; takes effect at the next rebuild(). */
+  void
+   setCellSize(float cellSize) {
+   m_cellSize = cellSize > 0.f ? cellSize : 1.f;
+   m_sorted = false;
+  }
+
+  float
+   cellSize() const {
+   return m_cellSize;
+  }
+
+  /** @brief Adds a circle and returns its id, the number of entities before the call. */
+  uint32_t
+   insert(const CVector2& position, float radius = 0.f) {
+   m_position.push_back(position);
+   m_radius.push_back(radius > 0.f ? radius : 0.f);
+   return static_cast<uint32_t>(m_position.size() - 1);
+  }
+
+  /** @brief Moves entity id; an id out of range is ignored. */
+  void
+   update(uint32_t id, const CVector2& position) {
+   if (id < m_position.size()) m_position[id] = position;
+  }
+
+  /** @brief Moves and resizes entity id; an id out of range is ignored. */
+  void
+   update(uint32_t id, const CVector2& position, float radius) {
+   if (id < m_position.size()) {
+    m_position[id] = position;
+    m_radius[id] = radius > 0.f ? radius : 0.f;
+   }
+  }
+
+  /**
+   * @brief Replaces every entity: entity i is positions[i] with radius radii[i], or 0 when
+   * radii is null.
+   */
+  void
+   assign(const CVector2* positions, const float* radii, size_t n) {
+   m_position.assign(positions, positions + n);
+   m_radius.assign(n, 0.f);
+   if (radii) {
+    for (size_t i = 0; i < n; ++i) m_radius[i] = radii[i] > 0.f ? radii[i] : 0.f;
+   }
+  }
+
+  /** @brief Removes every entity. */
+  void
+   clear() {
+   m_position.clear();
+   m_radius.clear();
+   m_cell.clear();
+   m_ids.clear();
+   m_x.clear();
+   m_y.clear();
+   m_r.clear();
+   m_slotCell.clear();
+   m_large.clear();
+   m_largePosition.clear();
+   m_largeRadius.clear();
+   m_bucketStart.assign(1, 0);
+   m_mask = 0;
+   m_maxRadius = 0.f;
+   m_sorted = false;
+  }
+
+  /**
+   * @brief Files every entity under its current cell; call once per frame after the updates
+   * and before the queries.
+   */
+  void
+   rebuild(size_t threads = 0) {
+   const size_t n = m_position.size();
+   const uint32_t buckets = EngineMath::nextPow2(static_cast<uint32_t>(n < 8 ? 16 : 2 * n));
+   const bool resized = m_cell.size() != n || m_mask != buckets - 1;
+   m_cell.resize(n);
+   const float inverseCell = 1.f / m_cellSize;
+   const size_t chunks = (n + detail::GRID_CHUNK - 1) / detail::GRID_CHUNK;
+   std::vector<unsigned char> moved(chunks, 0);
+   detail::forEachGridChunk(n, threads, [&](size_t c, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+     const detail::GridCell cell = { detail::gridCoordinate(m_position[i].x, inverseCell),
+                                     detail::gridCoordinate(m_position[i].y, inverseCell) };
+     if (!(cell == m_cell[i])) {
+      m_cell[i] = cell;
+      moved[c] = 1;
+     }
+    }
+   });
+   std::vector<uint32_t> large;
+   m_maxRadius = 0.f;
+   for (size_t i = 0; i < n; ++i) {
+    const float r = m_radius[i];
+    if (r > m_cellSize) large.push_back(static_cast<uint32_t>(i));
+    else m_maxRadius = r > m_maxRadius ? r : m_maxRadius;
+   }
+   bool changed = resized || !m_sorted || large != m_large;
+   for (unsigned char m : moved) changed = changed || m != 0;
+   if (changed) {
+    m_large.swap(large);
+    sortSlots(buckets);
+   }
+   m_largePosition.resize(m_large.size());
+   m_largeRadius.resize(m_large.size());
+   for (size_t k = 0; k < m_large.size(); ++k) {
+    m_largePosition[k] = m_position[m_large[k]];
+    m_largeRadius[k] = m_radius[m_large[k]];
+   }
+   detail::forEachGridChunk(m_ids.size(), threads, [&](size_t, size_t begin, size_t end) {
+    for (size_t s = begin; s < end; ++s) {
+     const uint32_t id = m_ids[s];
+     m_x[s] = m_position[id].x;
+     m_y[s] = m_position[id].y;
+     m_r[s] = m_radius[id];
+     m_slotCell[s] = m_cell[id];
+    }
+   });
+   m_sorted = true;
+  }
+
+  /**
+   * @brief Appends the ids of the entities overlapping the circle (center, radius) to out, in
+   * grid order and then the entities larger than a cell; returns how many were appended.
+   */
+  size_t
+   queryRadius(const CVector2& center, float radius, std::vector<uint32_t>& out) const {
+   const size_t before = out.size();
+   const float reach = radius + m_maxRadius;
+   visitSlots(center.x - reach, center.y - reach, center.x + reach, center.y + reach, [&](size_t s) {
+    const float dx = m_x[s] - center.x, dy = m_y[s] - center.y, r = radius + m_r[s];
+    if (dx * dx + dy * dy <= r * r) out.push_back(m_ids[s]);
+   });
+   for (size_t k = 0; k < m_large.size(); ++k) {
+    const CVector2 d = m_largePosition[k] - center;
+    const float r = radius + m_largeRadius[k];
+    if (d.x * d.x + d.y * d.y <= r * r) out.push_back(m_large[k]);
+   }
+   return out.size() - before;
+  }
+
+  /** @brief Appends the ids of the entities overlapping box to out, ordered as queryRadius(). */
+  size_t
+   queryBox(const Bounds2& box, std::vector<uint32_t>& out) const {
+   const size_t before = out.size();
+   const float reach = m_maxRadius;
+   visitSlots(box.minimum.x - reach, box.minimum.y - reach, box.maximum.x + reach, box.maximum.y + reach, [&](size_t s) {
+    const float dx = m_x[s] - EngineMath::clamp(m_x[s], box.minimum.x, box.maximum.x);
+    const float dy = m_y[s] - EngineMath::clamp(m_y[s], box.minimum.y, box.maximum.y);
+    if (dx * dx + dy * dy <= m_r[s] * m_r[s]) out.push_back(m_ids[s]);
+   });
+   for (size_t k = 0; k < m_large.size(); ++k) {
+    const CVector2& c = m_largePosition[k];
+    const float dx = c.x - EngineMath::clamp(c.x, box.minimum.x, box.maximum.x);
+    const float dy = c.y - EngineMath::clamp(c.y, box.minimum.y, box.maximum.y);
+    if (dx * dx + dy * dy <= m_largeRadius[k] * m_largeRadius[k]) out.push_back(m_large[k]);
+   }
+   return out.size() - before;
+  }
+
+  /**
+   * @brief Appends every overlapping pair once, as (lower id, higher id) in grid order, to out;
+   * returns how many were appended.
+   */
+  size_t
+   pairs(std::vector<std::pair<uint32_t, uint32_t>>& out, size_t threads = 0) const {
+   const size_t n = m_ids.size();
+   const size_t chunks = (n + detail::GRID_CHUNK - 1) / detail::GRID_CHUNK;
+   // One task per chunk of grid slots, then one per large entity.
+   const size_t tasks = chunks + m_large.size();
+   std::vector<std::vector<std::pair<uint32_t, uint32_t>>> found(tasks);
+   const size_t workers = n + m_large.size() < detail::PARALLEL_GRID_MIN ? 1 : detail::resolveThreads(threads, tasks);
+   detail::parallelTasks(tasks, workers, [&](size_t t) {
+    if (t < chunks) {
+     const size_t begin = t * detail::GRID_CHUNK, end = n - begin < detail::GRID_CHUNK ? n : begin + detail::GRID_CHUNK;
+     for (size_t s = begin; s < end; ++s) slotPairs(s, found[t]);
+    }
+    else largePairs(t - chunks, found[t]);
+   });
+   const size_t before = out.size();
+   for (const auto& chunk : found) out.insert(out.end(), chunk.begin(), chunk.end());
+   return out.size() - before;
+  }
+
+  /** @brief Number of entities. */
+  size_t
+   size() const {
+   return m_position.size();
+  }
+
+  /** @brief Number of entities larger than a cell, as of the last rebuild(). */
+  size_t
+   largeCount() const {
+   return m_large.size();
+  }
+
+  private:
+  /** Stable counting sort by bucket of the ids of the entities not on the large list. */
+  void
+   sortSlots(uint32_t buckets) {
+   size_t n = m_position.size();
+   std::vector<unsigned char> large(n, 0);
+   for (uint32_t id : m_large) large[id] = 1;
+   m_mask = buckets - 1;
+   m_bucketStart.assign(size_t(buckets) + 1, 0);
+   for (size_t i = 0; i < n; ++i) {
+    if (!large[i]) ++m_bucketStart[detail::gridBucket(m_cell[i], m_mask) + 1];
+   }
+   for (size_t b = 0; b < buckets; ++b) m_bucketStart[b + 1] += m_bucketStart[b];
+   std::vector<uint32_t> next(m_bucketStart.begin(), m_bucketStart.end() - 1);
+   n = m_bucketStart[buckets];
+   m_ids.resize(n);
+   for (size_t i = 0; i < large.size(); ++i) {
+    if (!large[i]) m_ids[next[detail::gridBucket(m_cell[i], m_mask)]++] = static_cast<uint32_t>(i);
+   }
+   m_x.resize(n);
+   m_y.resize(n);
+   m_r.resize(n);
+   m_slotCell.resize(n);
+  }
+
+  /** Calls fn(slot) for every slot of cell, whatever else shares its bucket. */
+  template<typename Fn>
+  void
+   visitCell(detail::GridCell cell, Fn&& fn) const {
+   const uint32_t b = detail::gridBucket(cell, m_mask);
+   for (uint32_t s = m_bucketStart[b]; s < m_bucketStart[b + 1]; ++s) {
+    if (m_slotCell[s] == cell) fn(s);
+   }
+  }
+
+  /** Calls fn(slot) for every slot whose cell lies in the cells spanning [x0, x1] x [y0, y1]. */
+  template<typename Fn>
+  void
+   visitSlots(float x0, float y0, float x1, float y1, Fn&& fn) const {
+   if (m_ids.empty()) return;
+   const float inverseCell = 1.f / m_cellSize;
+   const int32_t cx0 = detail::gridCoordinate(x0, inverseCell), cy0 = detail::gridCoordinate(y0, inverseCell);
+   const int32_t cx1 = detail::gridCoordinate(x1, inverseCell), cy1 = detail::gridCoordinate(y1, inverseCell);
+   if (cx1 < cx0 || cy1 < cy0) return;
+   const uint64_t cells = (uint64_t(int64_t(cx1) - cx0) + 1) * (uint64_t(int64_t(cy1) - cy0) + 1);
+   if (cells > m_ids.size()) {
+    // More cells than entities: one pass over the slots is cheaper than the bucket lookups.
+    for (size_t s = 0; s < m_ids.size(); ++s) {
+     const detail::GridCell c = m_slotCell[s];
+     if (c.x >= cx0 && c.x <= cx1 && c.y >= cy0 && c.y <= cy1) fn(s);
+    }
+    return;
+   }
+   for (int32_t y = cy0; y <= cy1; ++y)
+    for (int32_t x = cx0; x <= cx1; ++x) visitCell(detail::GridCell{ x, y }, fn);
+  }
+
+  /**
+   * Pairs of slot s with the later slots of its own cell and with the forward half of the
+   * cells within its reach. A pair (a, b) is found from whichever of the two sees the other
+   * in its forward half, and each reach covers ra + rb, so that side always looks far enough.
+   */
+  void
+   slotPairs(size_t s, std::vector<std::pair<uint32_t, uint32_t>>& out) const {
+   const float x = m_x[s], y = m_y[s], r = m_r[s];
+   const uint32_t id = m_ids[s];
+   auto test = [&](size_t o) {
+    const float dx = m_x[o] - x, dy = m_y[o] - y, sum = r + m_r[o];
+    if (dx * dx + dy * dy <= sum * sum) out.emplace_back(id < m_ids[o] ? id : m_ids[o], id < m_ids[o] ? m_ids[o] : id);
+   };
+   const detail::GridCell cell = m_slotCell[s];
+   const uint32_t b = detail::gridBucket(cell, m_mask);
+   for (size_t o = s + 1; o < m_bucketStart[b + 1]; ++o) {
+    if (m_slotCell[o] == cell) test(o);
+   }
+   const float span = (r + m_maxRadius) / m_cellSize;
+   const size_t n = m_ids.size();
+   if (span * (span + 1.f) > static_cast<float>(n)) {
+    // The forward half holds more cells than there are entities: test every slot that lies
+    // in it instead.
+    for (size_t o = 0; o < n; ++o) {
+     const detail::GridCell c = m_slotCell[o];
+     if (c.y > cell.y || (c.y == cell.y && c.x > cell.x)) test(o);
+    }
+    return;
+   }
+   const int32_t reach = EngineMath::ceil(span);
+   for (int32_t dy = 0; dy <= reach; ++dy) {
+    for (int32_t dx = dy == 0 ? 1 : -reach; dx <= reach; ++dx) {
+     visitCell(detail::GridCell{ cell.x + dx, cell.y + dy }, test);
+    }
+   }
+  }
+
+  /** Pairs of large entity k with the grid and with the large entities after it. */
+  void
+   largePairs(size_t k, std::vector<std::pair<uint32_t, uint32_t>>& out) const {
+   const CVector2 c = m_largePosition[k];
+   const float r = m_largeRadius[k];
+   const uint32_t id = m_large[k];
+   auto emit = [&](uint32_t other) { out.emplace_back(id < other ? id : other, id < other ? other : id); };
+   const float reach = r + m_maxRadius;
+   visitSlots(c.x - reach, c.y - reach, c.x + reach, c.y + reach, [&](size_t s) {
+    const float dx = m_x[s] - c.x, dy = m_y[s] - c.y, sum = r + m_r[s];
+    if (dx * dx + dy * dy <= sum * sum) emit(m_ids[s]);
+   });
+   for (size_t o = k + 1; o < m_large.size(); ++o) {
+    const CVector2 d = m_largePosition[o] - c;
+    const float sum = r + m_largeRadius[o];
+    if (d.x * d.x + d.y * d.y <= sum * sum) emit(m_large[o]);
+   }
+  }
+
+  float m_cellSize = 1.f;
+  float m_maxRadius = 0.f; ///< Largest radius among the grid slots
+  bool m_sorted = false;
+  uint32_t m_mask = 0;
+  std::vector<CVector2> m_position;            ///< Per entity id
+  std::vector<float> m_radius;                 ///< Per entity id
+  std::vector<detail::GridCell> m_cell;        ///< Per entity id, as of the last rebuild()
+  std::vector<uint32_t> m_bucketStart{ 0 };    ///< First slot of each bucket, then the slot count
+  std::vector<uint32_t> m_ids;                 ///< Per slot: entity id
+  std::vector<float> m_x;                      ///< Per slot
+  std::vector<float> m_y;                      ///< Per slot
+  std::vector<float> m_r;                      ///< Per slot
+  std::vector<detail::GridCell> m_slotCell;    ///< Per slot
+  std::vector<uint32_t> m_large;               ///< Ids of the entities larger than a cell, ascending
+  std::vector<CVector2> m_largePosition;       ///< Per large entity
+  std::vector<float> m_largeRadius;            ///< Per large entity
+ };
+}
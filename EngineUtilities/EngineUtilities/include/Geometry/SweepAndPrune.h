@@ -0,0 +1,452 @@
+/**
+ * @file SweepAndPrune.h
+ * @brief Incremental sweep-and-prune broadphase over AABBs that reports the pairs that began
+ * and stopped overlapping since the last call.
+ *
+ * Every box contributes a min and a max endpoint to a sorted array per axis. Boxes move a
+ * little from one frame to the next, so re-sorting is an insertion sort that only moves each
+ * endpoint past the few it crossed, close to O(n) for a coherent scene. Two layouts:
+ *
+ * - SweepAxes::All keeps the three axes sorted on every update(). An endpoint moving left
+ *   past another box's max (or right past its min) may start an overlap, which the full box
+ *   test confirms; passing the other way ends one. Pairs are tracked by these crossings only,
+ *   so a frame costs the endpoints moved, not the pairs.
+ * - SweepAxes::Best keeps one axis, the one along which the box centers spread the most, and
+ *   re-sorts it in collect(), which then sweeps it for the full pair list and compares that
+ *   against the previous one. Less memory and no per-update work, but the sweep visits every
+ *   pair overlapping on that axis each frame. The axis changes only when another one spreads
+ *   half again as much, so a flat scene does not flip between two.
+ *
+ * Boxes must have min <= max on every axis. At equal values a min sorts before a max, so
+ * touching boxes overlap, as in AABB::intersects(). Pairs are (lower id, higher id), and
+ * collect() returns them in ascending order. Ids of removed boxes are only reused after the
+ * next collect(), so a removal is always reported before the id names another box. Insertions
+ * and removals cost O(n).
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+#include <Geometry/Primitives.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /**
+  * @brief Which axes a SweepAndPrune keeps sorted.
+  */
+ enum class SweepAxes {
+  Best, ///< The axis of largest center variance, swept in collect()
+  All   ///< All three, pairs tracked by endpoint crossings in update()
+ };
+
+ namespace detail {
+  /** Endpoint of a box on one axis: data is id << 1, plus 1 for the max. */
+  struct SweepEndpoint {
+   float value;
+   uint32_t data;
+  };
+
+  /** Min endpoints sort before max endpoints of the same value. */
+  constexpr bool
+   sweepBefore(const SweepEndpoint& a, const SweepEndpoint& b) {
+   return a.value < b.value || (a.value == b.value && (a.data & 1u) < (b.data & 1u));
+  }
+
+  constexpr uint64_t
+   sweepPairKey(uint32_t a, uint32_t b) {
+   return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+  }
+
+  /** One pair change of a SweepAxes::All frame. */
+  struct SweepEvent {
+   uint64_t key;
+   bool added;
+  };
+ }
+
+ /**
+  * @class SweepAndPrune
+  * @brief Sort-and-sweep broadphase for scenes with high temporal coherence.
+  */
+ class
+  SweepAndPrune {
+  public:
+  using Pair = std::pair<uint32_t, uint32_t>;
+
+  explicit SweepAndPrune(SweepAxes axes = SweepAxes::All) : m_mode(axes) {}
+
+  /** @brief Adds box and returns its id. */
+  uint32_t
+   insert(const AABB& box) {
+   uint32_t id;
+   if (!m_free.empty()) {
+    id = m_free.back();
+    m_free.pop_back();
+    m_boxes[id] = box;
+    m_alive[id] = 1;
+   }
+   else {
+    id = static_cast<uint32_t>(m_boxes.size());
+    m_boxes.push_back(box);
+    m_alive.push_back(1);
+    m_neighbours.emplace_back();
+    if (m_mode == SweepAxes::All)
+     for (std::vector<uint32_t>& slot : m_slot) slot.resize(2 * m_boxes.size());
+   }
+   ++m_count;
+   for (int axis = 0; axis < axisCount(); ++axis) {
+    // Enter past the top end and sink: the min crosses every max at or above it, which finds
+    // the overlaps, and the max behind it only passes boxes it does not reach.
+    for (uint32_t data : { id << 1, (id << 1) | 1u }) {
+     const uint32_t pos = static_cast<uint32_t>(m_end[axis].size());
+     m_end[axis].push_back(detail::SweepEndpoint{ value(id, axis, (data & 1u) != 0), data });
+     if (m_mode == SweepAxes::All) moveDown(axis, pos);
+    }
+   }
+   return id;
+  }
+
+  /** @brief Moves box id; an id that is not alive is ignored. */
+  void
+   update(uint32_t id, const AABB& box) {
+   if (!alive(id)) return;
+   const AABB old = m_boxes[id];
+   m_boxes[id] = box;
+   if (m_mode != SweepAxes::All) return;
+   for (int axis = 0; axis < 3; ++axis) {
+    const float oldMin = old.min[axis], oldMax = old.max[axis];
+    const float newMin = box.min[axis], newMax = box.max[axis];
+    // Growing ends first, so the min never has to pass its own max.
+    if (newMin < oldMin) moveEndpoint(id, axis, false, newMin);
+    if (newMax > oldMax) moveEndpoint(id, axis, true, newMax);
+    if (newMin > oldMin) moveEndpoint(id, axis, false, newMin);
+    if (newMax < oldMax) moveEndpoint(id, axis, true, newMax);
+   }
+  }
+
+  /** @brief Removes box id; its pairs end. An id that is not alive is ignored. */
+  void
+   remove(uint32_t id) {
+   if (!alive(id)) return;
+   if (m_mode == SweepAxes::All) {
+    while (!m_neighbours[id].empty()) removePair(id, m_neighbours[id].back());
+   }
+   for (int axis = 0; axis < axisCount(); ++axis) {
+    std::vector<detail::SweepEndpoint>& end = m_end[axis];
+    end.erase(std::remove_if(end.begin(), end.end(), [id](const detail::SweepEndpoint& e) { return e.data >> 1 == id; }),
+              end.end());
+    if (m_mode == SweepAxes::All) {
+     for (size_t i = 0; i < end.size(); ++i) m_slot[axis][end[i].data] = static_cast<uint32_t>(i);
+    }
+   }
+   m_alive[id] = 0;
+   m_retired.push_back(id);
+   --m_count;
+  }
+
+  /**
+   * @brief Replaces every box by boxes[0..n), with ids 0..n-1, sorting once instead of
+   * inserting one by one; collect() then reports the old pairs ended and the new ones begun.
+   */
+  void
+   assign(const AABB* boxes, size_t n) {
+   const std::vector<Pair> before = currentPairs();
+   m_boxes.assign(boxes, boxes + n);
+   m_alive.assign(n, 1);
+   m_neighbours.assign(n, std::vector<uint32_t>());
+   m_free.clear();
+   m_retired.clear();
+   m_count = n;
+   for (int axis = 0; axis < 3; ++axis) {
+    m_end[axis].clear();
+    m_slot[axis].assign(2 * n, 0);
+   }
+   if (m_mode == SweepAxes::Best) {
+    // The pairs of the last collect() are what collect() reports the changes against.
+    m_axis = -1;
+    for (uint32_t id = 0; id < n; ++id) {
+     m_end[0].push_back(detail::SweepEndpoint{ 0.f, id << 1 });
+     m_end[0].push_back(detail::SweepEndpoint{ 0.f, (id << 1) | 1u });
+    }
+    return;
+   }
+   for (int axis = 0; axis < 3; ++axis) {
+    std::vector<detail::SweepEndpoint>& end = m_end[axis];
+    for (uint32_t id = 0; id < n; ++id) {
+     end.push_back(detail::SweepEndpoint{ value(id, axis, false), id << 1 });
+     end.push_back(detail::SweepEndpoint{ value(id, axis, true), (id << 1) | 1u });
+    }
+    std::sort(end.begin(), end.end(), detail::sweepBefore);
+    for (size_t i = 0; i < end.size(); ++i) m_slot[axis][end[i].data] = static_cast<uint32_t>(i);
+   }
+   std::vector<Pair> after;
+   sweep(0, after);
+   for (const Pair& p : before) m_events.push_back(detail::SweepEvent{ detail::sweepPairKey(p.first, p.second), false });
+   for (const Pair& p : after) {
+    m_neighbours[p.first].push_back(p.second);
+    m_neighbours[p.second].push_back(p.first);
+    m_events.push_back(detail::SweepEvent{ detail::sweepPairKey(p.first, p.second), true });
+   }
+  }
+
+  /**
+   * @brief Appends to added the pairs that overlap now but did not at the last collect(), and
+   * to removed the ones that no longer do, both ascending. SweepAxes::Best re-sorts and
+   * sweeps here.
+   */
+  void
+   collect(std::vector<Pair>& added, std::vector<Pair>& removed) {
+   if (m_mode == SweepAxes::Best) {
+    std::vector<Pair> now;
+    resortBest();
+    sweep(0, now);
+    std::sort(now.begin(), now.end());
+    size_t i = 0, j = 0;
+    while (i < now.size() || j < m_pairs.size()) {
+     if (j == m_pairs.size() || (i < now.size() && now[i] < m_pairs[j])) added.push_back(now[i++]);
+     else if (i == now.size() || m_pairs[j] < now[i]) removed.push_back(m_pairs[j++]);
+     else {
+      ++i;
+      ++j;
+     }
+    }
+    m_pairs.swap(now);
+   }
+   else {
+    // Changes alternate per pair, so its net change is its first one if its last one agrees.
+    std::stable_sort(m_events.begin(), m_events.end(),
+                     [](const detail::SweepEvent& a, const detail::SweepEvent& b) { return a.key < b.key; });
+    for (size_t i = 0; i < m_events.size();) {
+     size_t j = i;
+     while (j + 1 < m_events.size() && m_events[j + 1].key == m_events[i].key) ++j;
+     if (m_events[i].added == m_events[j].added) {
+      const Pair p(static_cast<uint32_t>(m_events[i].key >> 32), static_cast<uint32_t>(m_events[i].key));
+      (m_events[i].added ? added : removed).push_back(p);
+     }
+     i = j + 1;
+    }
+    m_events.clear();
+   }
+   m_free.insert(m_free.end(), m_retired.begin(), m_retired.end());
+   m_retired.clear();
+  }
+
+  /**
+   * @brief Appends every overlapping pair to out, ascending: the current ones for
+   * SweepAxes::All, the ones of the last collect() for SweepAxes::Best.
+   */
+  size_t
+   pairs(std::vector<Pair>& out) const {
+   const std::vector<Pair> current = currentPairs();
+   out.insert(out.end(), current.begin(), current.end());
+   return current.size();
+  }
+
+  /** @brief Number of boxes alive. */
+  size_t
+   size() const {
+   return m_count;
+  }
+
+  bool
+   alive(uint32_t id) const {
+   return id < m_alive.size() && m_alive[id] != 0;
+  }
+
+  /** @brief Box id as last inserted or updated. */
+  const AABB&
+   bounds(uint32_t id) const {
+   return m_boxes[id];
+  }
+
+  /** @brief Axis swept by SweepAxes::Best as of the last collect(), -1 before the first. */
+  int
+   sweepAxis() const {
+   return m_mode == SweepAxes::Best ? m_axis : 0;
+  }
+
+  private:
+  /// Variance ratio another axis needs before SweepAxes::Best switches to it.
+  static constexpr float AXIS_HYSTERESIS = 1.5f;
+
+  int
+   axisCount() const {
+   return m_mode == SweepAxes::All ? 3 : 1;
+  }
+
+  float
+   value(uint32_t id, int axis, bool max) const {
+   return max ? m_boxes[id].max[axis] : m_boxes[id].min[axis];
+  }
+
+  std::vector<Pair>
+   currentPairs() const {
+   if (m_mode == SweepAxes::Best) return m_pairs;
+   std::vector<Pair> out;
+   for (uint32_t id = 0; id < m_neighbours.size(); ++id)
+    for (uint32_t other : m_neighbours[id])
+     if (other > id) out.emplace_back(id, other);
+   std::sort(out.begin(), out.end());
+   return out;
+  }
+
+  void
+   addPair(uint32_t a, uint32_t b) {
+   std::vector<uint32_t>& na = m_neighbours[a];
+   if (std::find(na.begin(), na.end(), b) != na.end()) return;
+   na.push_back(b);
+   m_neighbours[b].push_back(a);
+   m_events.push_back(detail::SweepEvent{ detail::sweepPairKey(a, b), true });
+  }
+
+  void
+   removePair(uint32_t a, uint32_t b) {
+   std::vector<uint32_t>& na = m_neighbours[a];
+   const auto it = std::find(na.begin(), na.end(), b);
+   if (it == na.end()) return;
+   *it = na.back();
+   na.pop_back();
+   std::vector<uint32_t>& nb = m_neighbours[b];
+   *std::find(nb.begin(), nb.end(), a) = nb.back();
+   nb.pop_back();
+   m_events.push_back(detail::SweepEvent{ detail::sweepPairKey(a, b), false });
+  }
+
+  /** Sets an endpoint of box id on axis and sorts it into place. */
+  void
+   moveEndpoint(uint32_t id, int axis, bool max, float v) {
+   const uint32_t pos = m_slot[axis][2 * size_t(id) + (max ? 1 : 0)];
+   m_end[axis][pos].value = v;
+   if (pos > 0 && detail::sweepBefore(m_end[axis][pos], m_end[axis][pos - 1])) moveDown(axis, pos);
+   else moveUp(axis, pos);
+  }
+
+  /** Crossing of endpoint e (of box a) past endpoint o (of box b), e moving toward lower values. */
+  void
+   crossDown(const detail::SweepEndpoint& e, const detail::SweepEndpoint& o) {
+   const uint32_t a = e.data >> 1, b = o.data >> 1;
+   if (a == b) return;
+   const bool eMax = (e.data & 1u) != 0, oMax = (o.data & 1u) != 0;
+   if (!eMax && oMax) {
+    if (m_boxes[a].intersects(m_boxes[b])) addPair(a, b);
+   }
+   else if (eMax && !oMax) removePair(a, b);
+  }
+
+  /** Crossing of endpoint e past o with e moving toward higher values. */
+  void
+   crossUp(const detail::SweepEndpoint& e, const detail::SweepEndpoint& o) {
+   const uint32_t a = e.data >> 1, b = o.data >> 1;
+   if (a == b) return;
+   const bool eMax = (e.data & 1u) != 0, oMax = (o.data & 1u) != 0;
+   if (eMax && !oMax) {
+    if (m_boxes[a].intersects(m_boxes[b])) addPair(a, b);
+   }
+   else if (!eMax && oMax) removePair(a, b);
+  }
+
+  void
+   moveDown(int axis, uint32_t pos) {
+   std::vector<detail::SweepEndpoint>& end = m_end[axis];
+   std::vector<uint32_t>& slot = m_slot[axis];
+   const detail::SweepEndpoint e = end[pos];
+   while (pos > 0 && detail::sweepBefore(e, end[pos - 1])) {
+    crossDown(e, end[pos - 1]);
+    end[pos] = end[pos - 1];
+    slot[end[pos].data] = pos;
+    --pos;
+   }
+   end[pos] = e;
+   slot[e.data] = pos;
+  }
+
+  void
+   moveUp(int axis, uint32_t pos) {
+   std::vector<detail::SweepEndpoint>& end = m_end[axis];
+   std::vector<uint32_t>& slot = m_slot[axis];
+   const detail::SweepEndpoint e = end[pos];
+   while (pos + 1 < end.size() && detail::sweepBefore(end[pos + 1], e)) {
+    crossUp(e, end[pos + 1]);
+    end[pos] = end[pos + 1];
+    slot[end[pos].data] = pos;
+    ++pos;
+   }
+   end[pos] = e;
+   slot[e.data] = pos;
+  }
+
+  /** SweepAxes::Best: picks the axis, refreshes the endpoint values and sorts them. */
+  void
+   resortBest() {
+   double sum[3] = {}, sumSq[3] = {};
+   for (uint32_t id = 0; id < m_boxes.size(); ++id) {
+    if (!m_alive[id]) continue;
+    for (int k = 0; k < 3; ++k) {
+     const double c = 0.5 * (double(m_boxes[id].min[k]) + double(m_boxes[id].max[k]));
+     sum[k] += c;
+     sumSq[k] += c * c;
+    }
+   }
+   double spread[3] = {};
+   const double inv = m_count ? 1.0 / double(m_count) : 0.0;
+   for (int k = 0; k < 3; ++k) spread[k] = sumSq[k] * inv - sum[k] * inv * sum[k] * inv;
+   int best = spread[1] > spread[0] ? 1 : 0;
+   best = spread[2] > spread[best] ? 2 : best;
+   const bool switchAxis = m_axis < 0 || (best != m_axis && spread[best] > AXIS_HYSTERESIS * spread[m_axis]);
+   if (switchAxis) m_axis = best;
+   std::vector<detail::SweepEndpoint>& end = m_end[0];
+   for (detail::SweepEndpoint& e : end) e.value = value(e.data >> 1, m_axis, (e.data & 1u) != 0);
+   if (switchAxis) {
+    std::sort(end.begin(), end.end(), detail::sweepBefore);
+    return;
+   }
+   for (size_t i = 1; i < end.size(); ++i) {
+    const detail::SweepEndpoint e = end[i];
+    size_t j = i;
+    for (; j > 0 && detail::sweepBefore(e, end[j - 1]); --j) end[j] = end[j - 1];
+    end[j] = e;
+   }
+  }
+
+  /** Overlapping pairs by one sweep of the sorted endpoints m_end[axis]. */
+  void
+   sweep(int axis, std::vector<Pair>& out) const {
+   std::vector<uint32_t> active;
+   std::vector<uint32_t> where(m_boxes.size(), 0);
+   for (const detail::SweepEndpoint& e : m_end[axis]) {
+    const uint32_t id = e.data >> 1;
+    if (e.data & 1u) {
+     const uint32_t last = active.back();
+     active[where[id]] = last;
+     where[last] = where[id];
+     active.pop_back();
+     continue;
+    }
+    const AABB& box = m_boxes[id];
+    for (uint32_t other : active) {
+     if (box.intersects(m_boxes[other])) out.emplace_back(id < other ? id : other, id < other ? other : id);
+    }
+    where[id] = static_cast<uint32_t>(active.size());
+    active.push_back(id);
+   }
+  }
+
+  SweepAxes m_mode;
+  int m_axis = -1;                           ///< SweepAxes::Best: axis of m_end[0]
+  size_t m_count = 0;                        ///< Boxes alive
+  std::vector<AABB> m_boxes;                 ///< Per id
+  std::vector<unsigned char> m_alive;        ///< Per id
+  std::vector<uint32_t> m_free;              ///< Ids to reuse
+  std::vector<uint32_t> m_retired;           ///< Ids removed since the last collect()
+  std::vector<detail::SweepEndpoint> m_end[3]; ///< Sorted endpoints per axis
+  std::vector<uint32_t> m_slot[3];           ///< SweepAxes::All: index in m_end of each endpoint (id << 1 | max)
+  std::vector<std::vector<uint32_t>> m_neighbours; ///< SweepAxes::All: overlapping ids per id
+  std::vector<detail::SweepEvent> m_events;  ///< SweepAxes::All: pair changes since the last collect()
+  std::vector<Pair> m_pairs;                 ///< SweepAxes::Best: pairs of the last collect(), ascending
+ };
+}
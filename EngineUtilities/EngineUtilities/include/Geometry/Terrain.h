@@ -0,0 +1,529 @@
+/**
+ * @file Terrain.h
+ * @brief Heightmap terrain: parallel noise generation, precomputed normals, geomipmapped
+ * chunk meshes stitched without cracks, and incremental rebuilds after edits.
+ *
+ * The terrain is one heightmap of (chunksX * chunkCells + 1) x (chunksZ * chunkCells + 1)
+ * samples cut into chunks of chunkCells x chunkCells cells; neighbouring chunks share their
+ * border samples. generate() fills it from fractal simplex noise (generateFrom(): from any
+ * row function), one batch of rows per task, so every sample comes from the same SIMD kernel
+ * call whatever the thread count. Normals are taken from central differences of the full-resolution heights,
+ * a register of samples at a time, and stored per sample; every LOD reuses them.
+ *
+ * Each chunk keeps one vertex grid per LOD, level l taking every 2^l-th sample. Index
+ * buffers depend only on the topology, so they are shared by all chunks: one per LOD and
+ * combination of neighbour LOD differences, built on first use. Where a neighbour is d
+ * levels coarser, the chunk keeps its interior at full resolution and fills the ring of
+ * cells along that edge with a strip that only uses every 2^d-th edge vertex, the ones the
+ * neighbour has, so both sides trace the same edge and no crack or T-junction opens
+ * (geomipmapping with stitched borders; neighbours may differ by any number of levels).
+ * selectLods() picks each chunk's level from its distance to the eye and resolves the
+ * index buffer it needs.
+ *
+ * edit() changes heights in a rectangle of samples and remembers it. rebuild() then
+ * recomputes the normals of the rectangle plus one sample around it and re-meshes only the
+ * chunks those samples belong to, in parallel.
+ *
+ *   Terrain terrain(settings);
+ *   terrain.generate();
+ *   terrain.raise(CVector3(100.f, 0.f, 80.f), 12.f, 4.f);
+ *   terrain.rebuild();
+ *   terrain.selectLods(cameraPosition, 64.f);
+ *   for (each chunk) draw(terrain.mesh(cx, cz), terrain.indices(cx, cz));
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <Core/FlatHashMap.h>
+#include <Core/Parallel.h>
+#include <Core/Trace.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Noise.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector3Stream.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Most LOD levels a terrain keeps per chunk.
+ constexpr uint32_t TERRAIN_MAX_LODS = 8;
+ /// Heightmap rows generated or re-normalled per task.
+ constexpr size_t TERRAIN_ROWS_PER_TASK = 16;
+
+ /** @brief Layout and generator of a Terrain. */
+ struct TerrainSettings {
+  uint32_t chunksX = 8;
+  uint32_t chunksZ = 8;
+  uint32_t chunkCells = 64;           ///< Cells per chunk side; a power of two
+  uint32_t lods = 4;                  ///< Levels per chunk, at most log2(chunkCells) + 1 and TERRAIN_MAX_LODS
+  float cellSize = 1.f;               ///< World units between samples
+  CVector3 origin;                    ///< World position of sample (0, 0) at height 0
+  float heightScale = 32.f;           ///< Noise output [-1, 1] is scaled by this
+  EngineMath::noise::FractalSettings noise = { 6, 1.f / 128.f, 2.f, 0.5f }; ///< Frequency per world unit
+  uint32_t seed = 0;
+ };
+
+ /** @brief Vertices of one chunk at one LOD, row-major along x. */
+ struct TerrainLodMesh {
+  Vector3Stream positions;
+  Vector3Stream normals;
+  uint32_t side = 0; ///< Vertices per row and per column
+ };
+
+ /**
+  * @class Terrain
+  * @brief Chunked heightmap with per-chunk LOD meshes.
+  */
+ class
+  Terrain {
+  public:
+  explicit Terrain(const TerrainSettings& settings = TerrainSettings()) {
+   reset(settings);
+  }
+
+  /** @brief Replaces the layout; heights become 0 until the next generate(). */
+  void
+   reset(const TerrainSettings& settings) {
+   m_settings = settings;
+   if (m_settings.chunkCells == 0) m_settings.chunkCells = 1;
+   m_settings.chunkCells = static_cast<uint32_t>(EngineMath::nextPow2(m_settings.chunkCells));
+   m_settings.chunksX = m_settings.chunksX ? m_settings.chunksX : 1;
+   m_settings.chunksZ = m_settings.chunksZ ? m_settings.chunksZ : 1;
+   uint32_t maxLods = 1;
+   while ((1u << maxLods) <= m_settings.chunkCells && maxLods < TERRAIN_MAX_LODS) ++maxLods;
+   m_settings.lods = m_settings.lods == 0 ? 1 : (m_settings.lods > maxLods ? maxLods : m_settings.lods);
+   m_width = m_settings.chunksX * m_settings.chunkCells + 1;
+   m_depth = m_settings.chunksZ * m_settings.chunkCells + 1;
+   m_heights.assign(size_t(m_width) * m_depth, 0.f);
+   m_normals.assign(3, std::vector<float>());
+   for (std::vector<float>& axis : m_normals) axis.assign(m_heights.size(), 0.f);
+   for (size_t i = 0; i < m_heights.size(); ++i) m_normals[1][i] = 1.f;
+   m_chunks.assign(size_t(m_settings.chunksX) * m_settings.chunksZ, Chunk());
+   for (Chunk& chunk : m_chunks) chunk.lods.resize(m_settings.lods);
+   m_indexCache.clear();
+   m_dirty = { 0, 0, m_width - 1, m_depth - 1, true };
+  }
+
+  /** @brief Fills the heightmap from the fractal noise of the settings and builds every chunk. */
+  void
+   generate(size_t threads = 0) {
+   const TerrainSettings& s = m_settings;
+   generateFrom([&s](const float* xs, const float* zs, float* out, size_t n) {
+    EngineMath::noise::fractal2(xs, zs, out, n, s.noise, s.seed);
+    for (size_t i = 0; i < n; ++i) out[i] *= s.heightScale;
+   }, threads);
+  }
+
+  /**
+   * @brief Fills the heightmap from rows(xs, zs, out, n): out[i] = height at world (xs[i],
+   * zs[i]), called concurrently for different rows. Then builds every chunk.
+   */
+  template<typename Rows>
+  void
+   generateFrom(const Rows& rows, size_t threads = 0) {
+   EU_TRACE_ZONE("Terrain::generate");
+   std::vector<float> xs(m_width);
+   for (uint32_t x = 0; x < m_width; ++x) xs[x] = m_settings.origin.x + x * m_settings.cellSize;
+   forEachRowBlock(0, m_depth, threads, [&](uint32_t z0, uint32_t z1) {
+    std::vector<float> zs(m_width);
+    for (uint32_t z = z0; z < z1; ++z) {
+     for (float& v : zs) v = m_settings.origin.z + z * m_settings.cellSize;
+     rows(xs.data(), zs.data(), &m_heights[size_t(z) * m_width], m_width);
+    }
+   });
+   m_dirty = { 0, 0, m_width - 1, m_depth - 1, true };
+   rebuild(threads);
+  }
+
+  /**
+   * @brief Calls fn(x, z, height&) for every sample in [x0, x1] x [z0, z1] (clamped to the
+   * map) and marks them for the next rebuild().
+   */
+  template<typename Fn>
+  void
+   edit(uint32_t x0, uint32_t z0, uint32_t x1, uint32_t z1, Fn fn) {
+   if (x1 >= m_width) x1 = m_width - 1;
+   if (z1 >= m_depth) z1 = m_depth - 1;
+   if (x0 > x1 || z0 > z1) return;
+   for (uint32_t z = z0; z <= z1; ++z) {
+    for (uint32_t x = x0; x <= x1; ++x) fn(x, z, m_heights[size_t(z) * m_width + x]);
+   }
+   if (!m_dirty.any) m_dirty = { x0, z0, x1, z1, true };
+   else {
+    m_dirty.x0 = x0 < m_dirty.x0 ? x0 : m_dirty.x0;
+    m_dirty.z0 = z0 < m_dirty.z0 ? z0 : m_dirty.z0;
+    m_dirty.x1 = x1 > m_dirty.x1 ? x1 : m_dirty.x1;
+    m_dirty.z1 = z1 > m_dirty.z1 ? z1 : m_dirty.z1;
+   }
+  }
+
+  /** @brief Adds amount * (1 - (d / radius)^2)^2 to the samples within radius of center (x, z). */
+  void
+   raise(const CVector3& center, float radius, float amount) {
+   if (radius <= 0.f) return;
+   const float inv = 1.f / m_settings.cellSize;
+   const float cx = (center.x - m_settings.origin.x) * inv, cz = (center.z - m_settings.origin.z) * inv;
+   const float r = radius * inv;
+   const float lx = EngineMath::ceil(cx - r), lz = EngineMath::ceil(cz - r);
+   const float hx = EngineMath::floor(cx + r), hz = EngineMath::floor(cz + r);
+   if (hx < 0.f || hz < 0.f || lx > m_width - 1.f || lz > m_depth - 1.f) return;
+   const float invR2 = 1.f / (r * r);
+   edit(lx > 0.f ? static_cast<uint32_t>(lx) : 0, lz > 0.f ? static_cast<uint32_t>(lz) : 0,
+        static_cast<uint32_t>(hx), static_cast<uint32_t>(hz), [&](uint32_t x, uint32_t z, float& h) {
+    const float dx = x - cx, dz = z - cz;
+    const float t = 1.f - (dx * dx + dz * dz) * invR2;
+    if (t > 0.f) h += amount * t * t;
+   });
+  }
+
+  /**
+   * @brief Recomputes the normals around the samples changed since the last rebuild() and
+   * the meshes of the chunks they touch. Returns the chunks rebuilt.
+   */
+  size_t
+   rebuild(size_t threads = 0) {
+   if (!m_dirty.any) return 0;
+   EU_TRACE_ZONE("Terrain::rebuild");
+   const uint32_t x0 = m_dirty.x0 ? m_dirty.x0 - 1 : 0, z0 = m_dirty.z0 ? m_dirty.z0 - 1 : 0;
+   const uint32_t x1 = m_dirty.x1 + 1 < m_width ? m_dirty.x1 + 1 : m_width - 1;
+   const uint32_t z1 = m_dirty.z1 + 1 < m_depth ? m_dirty.z1 + 1 : m_depth - 1;
+   m_dirty.any = false;
+   forEachRowBlock(z0, z1 + 1, threads, [&](uint32_t first, uint32_t last) {
+    for (uint32_t z = first; z < last; ++z) computeNormals(z, x0, x1 + 1);
+   });
+
+   // A sample on a chunk border belongs to the chunks on both sides.
+   const uint32_t cells = m_settings.chunkCells;
+   const uint32_t cx0 = x0 ? (x0 - 1) / cells : 0, cz0 = z0 ? (z0 - 1) / cells : 0;
+   const uint32_t cx1 = x1 / cells < m_settings.chunksX ? x1 / cells : m_settings.chunksX - 1;
+   const uint32_t cz1 = z1 / cells < m_settings.chunksZ ? z1 / cells : m_settings.chunksZ - 1;
+   const size_t columns = cx1 - cx0 + 1, count = columns * (cz1 - cz0 + 1);
+   detail::parallelTasks(count, detail::resolveThreads(threads, count), [&](size_t t) {
+    buildChunk(cx0 + static_cast<uint32_t>(t % columns), cz0 + static_cast<uint32_t>(t / columns));
+   });
+   EU_TRACE_COUNTER("terrain chunks rebuilt", count);
+   return count;
+  }
+
+  /**
+   * @brief Gives every chunk the LOD floor(log2(distance / lodDistance)) by its distance
+   * from eye to its bounds, clamped to the levels kept, and resolves its index buffer.
+   */
+  void
+   selectLods(const CVector3& eye, float lodDistance) {
+   EU_TRACE_ZONE("Terrain::selectLods");
+   const float extent = m_settings.chunkCells * m_settings.cellSize;
+   const float inv = lodDistance > 0.f ? 1.f / lodDistance : 0.f;
+   for (uint32_t cz = 0; cz < m_settings.chunksZ; ++cz) {
+    for (uint32_t cx = 0; cx < m_settings.chunksX; ++cx) {
+     Chunk& chunk = m_chunks[size_t(cz) * m_settings.chunksX + cx];
+     const float bx = m_settings.origin.x + cx * extent, bz = m_settings.origin.z + cz * extent;
+     const float dx = eye.x < bx ? bx - eye.x : (eye.x > bx + extent ? eye.x - bx - extent : 0.f);
+     const float dz = eye.z < bz ? bz - eye.z : (eye.z > bz + extent ? eye.z - bz - extent : 0.f);
+     const float y = eye.y - m_settings.origin.y;
+     const float dy = y < chunk.minHeight ? chunk.minHeight - y : (y > chunk.maxHeight ? y - chunk.maxHeight : 0.f);
+     const float ratio = EngineMath::sqrt(dx * dx + dy * dy + dz * dz) * inv;
+     uint32_t lod = 0;
+     while (lod + 1 < m_settings.lods && ratio >= float(2u << lod)) ++lod;
+     chunk.lod = lod;
+    }
+   }
+   for (uint32_t cz = 0; cz < m_settings.chunksZ; ++cz) {
+    for (uint32_t cx = 0; cx < m_settings.chunksX; ++cx) {
+     Chunk& chunk = m_chunks[size_t(cz) * m_settings.chunksX + cx];
+     const uint32_t neighbours[4] = { cz > 0 ? lodOf(cx, cz - 1) : 0, cx + 1 < m_settings.chunksX ? lodOf(cx + 1, cz) : 0,
+                                      cz + 1 < m_settings.chunksZ ? lodOf(cx, cz + 1) : 0, cx > 0 ? lodOf(cx - 1, cz) : 0 };
+     uint32_t key = chunk.lod;
+     for (int e = 0; e < 4; ++e) key |= (neighbours[e] > chunk.lod ? neighbours[e] - chunk.lod : 0) << (4 + 4 * e);
+     chunk.indices = &indexBuffer(key);
+    }
+   }
+  }
+
+  /** @brief LOD given to chunk (cx, cz) by the last selectLods(); 0 before. */
+  uint32_t
+   lod(uint32_t cx, uint32_t cz) const {
+   return lodOf(cx, cz);
+  }
+
+  /** @brief Vertices of chunk (cx, cz) at its selected LOD. */
+  const TerrainLodMesh&
+   mesh(uint32_t cx, uint32_t cz) const {
+   const Chunk& chunk = m_chunks[size_t(cz) * m_settings.chunksX + cx];
+   return chunk.lods[chunk.lod];
+  }
+
+  /** @brief Vertices of chunk (cx, cz) at level lod. */
+  const TerrainLodMesh&
+   mesh(uint32_t cx, uint32_t cz, uint32_t lod) const {
+   return m_chunks[size_t(cz) * m_settings.chunksX + cx].lods[lod];
+  }
+
+  /**
+   * @brief Triangle list for mesh(cx, cz), stitched to the neighbours' LODs of the last
+   * selectLods(); shared with every chunk in the same situation, valid until reset().
+   */
+  const std::vector<uint32_t>&
+   indices(uint32_t cx, uint32_t cz) {
+   const Chunk& chunk = m_chunks[size_t(cz) * m_settings.chunksX + cx];
+   return chunk.indices ? *chunk.indices : indexBuffer(chunk.lod);
+  }
+
+  /** @brief Height of sample (x, z) relative to the origin. */
+  float
+   height(uint32_t x, uint32_t z) const {
+   return m_heights[size_t(z) * m_width + x];
+  }
+
+  /** @brief Bilinear height at world (x, z), clamped to the map, relative to the origin. */
+  float
+   sampleHeight(float x, float z) const {
+   const float inv = 1.f / m_settings.cellSize;
+   float fx = (x - m_settings.origin.x) * inv, fz = (z - m_settings.origin.z) * inv;
+   fx = fx < 0.f ? 0.f : (fx > m_width - 1.f ? m_width - 1.f : fx);
+   fz = fz < 0.f ? 0.f : (fz > m_depth - 1.f ? m_depth - 1.f : fz);
+   const uint32_t ix = static_cast<uint32_t>(fx) < m_width - 1 ? static_cast<uint32_t>(fx) : m_width - 2;
+   const uint32_t iz = static_cast<uint32_t>(fz) < m_depth - 1 ? static_cast<uint32_t>(fz) : m_depth - 2;
+   const float tx = fx - ix, tz = fz - iz;
+   const float* row = &m_heights[size_t(iz) * m_width + ix];
+   const float a = row[0] + (row[1] - row[0]) * tx;
+   const float b = row[m_width] + (row[m_width + 1] - row[m_width]) * tx;
+   return a + (b - a) * tz;
+  }
+
+  /** @brief Unit normal of sample (x, z). */
+  CVector3
+   normal(uint32_t x, uint32_t z) const {
+   const size_t i = size_t(z) * m_width + x;
+   return CVector3(m_normals[0][i], m_normals[1][i], m_normals[2][i]);
+  }
+
+  /** @brief Samples per row. */
+  uint32_t
+   width() const {
+   return m_width;
+  }
+
+  /** @brief Samples per column. */
+  uint32_t
+   depth() const {
+   return m_depth;
+  }
+
+  const TerrainSettings&
+   settings() const {
+   return m_settings;
+  }
+
+  private:
+  struct Chunk {
+   std::vector<TerrainLodMesh> lods;
+   float minHeight = 0.f;
+   float maxHeight = 0.f;
+   uint32_t lod = 0;
+   const std::vector<uint32_t>* indices = nullptr; ///< Resolved by selectLods()
+  };
+
+  struct Region {
+   uint32_t x0, z0, x1, z1; ///< Inclusive sample bounds
+   bool any;
+  };
+
+  uint32_t
+   lodOf(uint32_t cx, uint32_t cz) const {
+   return m_chunks[size_t(cz) * m_settings.chunksX + cx].lod;
+  }
+
+  /** Runs fn(first, last) over [z0, z1) in blocks of TERRAIN_ROWS_PER_TASK rows. */
+  template<typename Fn>
+  void
+   forEachRowBlock(uint32_t z0, uint32_t z1, size_t threads, const Fn& fn) {
+   const size_t blocks = (z1 - z0 + TERRAIN_ROWS_PER_TASK - 1) / TERRAIN_ROWS_PER_TASK;
+   detail::parallelTasks(blocks, detail::resolveThreads(threads, blocks), [&](size_t b) {
+    const uint32_t first = z0 + static_cast<uint32_t>(b * TERRAIN_ROWS_PER_TASK);
+    fn(first, first + TERRAIN_ROWS_PER_TASK < z1 ? first + static_cast<uint32_t>(TERRAIN_ROWS_PER_TASK) : z1);
+   });
+  }
+
+  /** Normals of row z over [x0, x1): central differences, one-sided at the map's borders. */
+  void
+   computeNormals(uint32_t z, uint32_t x0, uint32_t x1) {
+   using detail::BatchLanes;
+   const float* row = &m_heights[size_t(z) * m_width];
+   const float* down = z > 0 ? row - m_width : row;
+   const float* up = z + 1 < m_depth ? row + m_width : row;
+   const float zSpan = (z > 0 && z + 1 < m_depth ? 2.f : (m_depth > 1 ? 1.f : 0.f)) * m_settings.cellSize;
+   float* nx = &m_normals[0][size_t(z) * m_width];
+   float* ny = &m_normals[1][size_t(z) * m_width];
+   float* nz = &m_normals[2][size_t(z) * m_width];
+   // Gradient (-dh/dx, 1, -dh/dz) with the y component scaled to the span, then normalized.
+   auto store = [&](size_t x, size_t count, BatchLanes gx, BatchLanes ySpan, BatchLanes gz) {
+    const BatchLanes lenSq = gx * gx + ySpan * ySpan + gz * gz;
+    const BatchLanes inv = EngineMath::batch::kernels::rsqrt(lenSq);
+    detail::storeLanes(gx * inv, nx, x, count);
+    detail::storeLanes(ySpan * inv, ny, x, count);
+    detail::storeLanes(gz * inv, nz, x, count);
+   };
+   const BatchLanes xSpan = BatchLanes::set1(2.f * m_settings.cellSize);
+   const BatchLanes zScale = BatchLanes::set1(zSpan > 0.f ? 2.f * m_settings.cellSize / zSpan : 0.f);
+   uint32_t x = x0;
+   if (x == 0) {
+    scalarNormal(z, 0, row, down, up, zSpan);
+    ++x;
+   }
+   const uint32_t interiorEnd = x1 < m_width - 1 ? x1 : m_width - 1;
+   for (; x < interiorEnd; x += static_cast<uint32_t>(detail::BATCH_WIDTH)) {
+    const size_t count = interiorEnd - x < detail::BATCH_WIDTH ? interiorEnd - x : detail::BATCH_WIDTH;
+    const BatchLanes gx = detail::loadLanes(row, x - 1, count) - detail::loadLanes(row, x + 1, count);
+    const BatchLanes gz = (detail::loadLanes(down, x, count) - detail::loadLanes(up, x, count)) * zScale;
+    store(x, count, gx, xSpan, gz);
+   }
+   if (x1 == m_width && m_width > 1) scalarNormal(z, m_width - 1, row, down, up, zSpan);
+  }
+
+  void
+   scalarNormal(uint32_t z, uint32_t x, const float* row, const float* down, const float* up, float zSpan) {
+   const uint32_t l = x > 0 ? x - 1 : x, r = x + 1 < m_width ? x + 1 : x;
+   const float xSpan = (r - l) * m_settings.cellSize;
+   const float gx = xSpan > 0.f ? (row[l] - row[r]) / xSpan : 0.f;
+   const float gz = zSpan > 0.f ? (down[x] - up[x]) / zSpan : 0.f;
+   const float inv = EngineMath::rsqrt(gx * gx + 1.f + gz * gz);
+   const size_t i = size_t(z) * m_width + x;
+   m_normals[0][i] = gx * inv;
+   m_normals[1][i] = inv;
+   m_normals[2][i] = gz * inv;
+  }
+
+  /** Vertex grids of every LOD of chunk (cx, cz) and its height bounds. */
+  void
+   buildChunk(uint32_t cx, uint32_t cz) {
+   Chunk& chunk = m_chunks[size_t(cz) * m_settings.chunksX + cx];
+   const uint32_t cells = m_settings.chunkCells;
+   const uint32_t sx0 = cx * cells, sz0 = cz * cells;
+   float lo = m_heights[size_t(sz0) * m_width + sx0], hi = lo;
+   for (uint32_t l = 0; l < m_settings.lods; ++l) {
+    const uint32_t step = 1u << l, side = cells / step + 1;
+    TerrainLodMesh& mesh = chunk.lods[l];
+    mesh.side = side;
+    mesh.positions.resize(size_t(side) * side);
+    mesh.normals.resize(size_t(side) * side);
+    float* px = mesh.positions.x();
+    float* py = mesh.positions.y();
+    float* pz = mesh.positions.z();
+    float* qx = mesh.normals.x();
+    float* qy = mesh.normals.y();
+    float* qz = mesh.normals.z();
+    for (uint32_t j = 0; j < side; ++j) {
+     const size_t z = sz0 + size_t(j) * step;
+     const float wz = m_settings.origin.z + z * m_settings.cellSize;
+     for (uint32_t i = 0; i < side; ++i) {
+      const size_t x = sx0 + size_t(i) * step, s = z * m_width + x, v = size_t(j) * side + i;
+      const float h = m_heights[s];
+      px[v] = m_settings.origin.x + x * m_settings.cellSize;
+      py[v] = m_settings.origin.y + h;
+      pz[v] = wz;
+      qx[v] = m_normals[0][s];
+      qy[v] = m_normals[1][s];
+      qz[v] = m_normals[2][s];
+      if (l == 0) {
+       lo = h < lo ? h : lo;
+       hi = h > hi ? h : hi;
+      }
+     }
+    }
+   }
+   chunk.minHeight = lo;
+   chunk.maxHeight = hi;
+  }
+
+  /**
+   * Index buffer of key: LOD in bits 0-3, then for the -z, +x, +z and -x edges (4 bits each)
+   * how many levels coarser the neighbour there is. Unstitched chunks are a plain grid.
+   */
+  const std::vector<uint32_t>&
+   indexBuffer(uint32_t key) {
+   std::unique_ptr<std::vector<uint32_t>>& slot = m_indexCache[key];
+   if (slot) return *slot;
+   slot.reset(new std::vector<uint32_t>());
+   std::vector<uint32_t>& out = *slot;
+   const uint32_t lod = key & 15u;
+   const uint32_t n = m_settings.chunkCells >> lod, side = n + 1;
+   uint32_t steps[4];
+   bool stitched = false;
+   for (int e = 0; e < 4; ++e) {
+    uint32_t d = key >> (4 + 4 * e) & 15u;
+    while (d > 0 && (1u << d) > n) --d;
+    steps[e] = 1u << d;
+    stitched |= d > 0;
+   }
+   out.reserve(size_t(n) * n * 6);
+   // Counter-clockwise seen from +y, i along x and j along z.
+   auto triangle = [&](uint32_t ai, uint32_t aj, uint32_t bi, uint32_t bj, uint32_t ci, uint32_t cj) {
+    const int64_t turn = (int64_t(bj) - aj) * (int64_t(ci) - ai) - (int64_t(bi) - ai) * (int64_t(cj) - aj);
+    if (turn == 0) return;
+    out.push_back(aj * side + ai);
+    out.push_back((turn > 0 ? bj : cj) * side + (turn > 0 ? bi : ci));
+    out.push_back((turn > 0 ? cj : bj) * side + (turn > 0 ? ci : bi));
+   };
+   if (!stitched || n < 2) {
+    for (uint32_t j = 0; j < n; ++j) {
+     for (uint32_t i = 0; i < n; ++i) {
+      triangle(i, j, i, j + 1, i + 1, j);
+      triangle(i + 1, j, i, j + 1, i + 1, j + 1);
+     }
+    }
+    return out;
+   }
+
+   // Full-resolution interior, then one strip per edge between the edge's vertices, every
+   // step-th one, and the row of vertices inside it; strips meet on the corner diagonals.
+   for (uint32_t j = 1; j + 1 < n; ++j) {
+    for (uint32_t i = 1; i + 1 < n; ++i) {
+     triangle(i, j, i, j + 1, i + 1, j);
+     triangle(i + 1, j, i, j + 1, i + 1, j + 1);
+    }
+   }
+   for (int e = 0; e < 4; ++e) {
+    // Along the edge at t, the edge vertex (grid coordinates) and the one inside it.
+    auto point = [&](uint32_t t, bool inner, uint32_t& i, uint32_t& j) {
+     const uint32_t offset = inner ? 1 : 0;
+     switch (e) {
+     case 0: i = t; j = offset; break;
+     case 1: i = n - offset; j = t; break;
+     case 2: i = t; j = n - offset; break;
+     default: i = offset; j = t; break;
+     }
+    };
+    uint32_t outer = 0, inner = 1;
+    while (outer < n || inner < n - 1) {
+     uint32_t ai, aj, bi, bj, ci, cj;
+     point(outer, false, ai, aj);
+     point(inner, true, bi, bj);
+     if (outer < n && (inner == n - 1 || outer + steps[e] <= inner + 1)) {
+      point(outer + steps[e], false, ci, cj);
+      outer += steps[e];
+     }
+     else {
+      point(inner + 1, true, ci, cj);
+      ++inner;
+     }
+     triangle(ai, aj, bi, bj, ci, cj);
+    }
+   }
+   return out;
+  }
+
+  TerrainSettings m_settings;
+  uint32_t m_width;
+  uint32_t m_depth;
+  std::vector<float> m_heights;
+  std::vector<std::vector<float>> m_normals; ///< [x, y, z][sample]
+  std::vector<Chunk> m_chunks;
+  FlatHashMap<uint32_t, std::unique_ptr<std::vector<uint32_t>>> m_indexCache;
+  Region m_dirty;
+ };
+}
@@ -0,0 +1,351 @@
+/**
+ * @file TimeOfImpact.h
+ * @brief Continuous collision: first time of contact of moving spheres, boxes and triangles
+ * over a step, one pair at a time or against candidate lists from a BVH.
+ *
+ * Motion is given over one step as a displacement (or a RigidMotion for bodies that also
+ * rotate), and times are fractions of the step in [0, 1].
+ *
+ * - Sphere-sphere and box-box have closed forms: a quadratic and a slab test of the relative
+ *   motion.
+ * - Sphere-triangle uses conservative advancement: step forward by the gap divided by a
+ *   bound on the closing speed, until the gap falls below TOI_TOLERANCE. Under pure
+ *   translation the gap is a convex function of time, so advancing along its tangent
+ *   (Newton's method from the left) never passes the contact and converges in a few steps.
+ *   A rotating triangle adds the arc its farthest corner can sweep to the bound (Mirtich).
+ *
+ * The batches test one moving sphere against many static spheres, or against candidate
+ * triangles gathered from BVH::overlap() of sweptBounds(), one SIMD lane per candidate.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <Core/Platform.h>
+#include <Core/SIMD.h>
+#include <Geometry/ClosestPoint.h>
+#include <Geometry/Primitives.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Gap at which conservative advancement reports contact.
+ constexpr float TOI_TOLERANCE = 1e-3f;
+ /// Conservative advancement steps before giving up on a pair.
+ constexpr uint32_t TOI_MAX_ITERATIONS = 32;
+
+ /**
+  * @brief First contact of a query.
+  */
+ struct TOIResult {
+  float t;             ///< Fraction of the step at contact; 0 when the shapes start touching
+  CVector3 point;      ///< Contact point on the second shape (the obstacle) at t
+  CVector3 normal;     ///< Unit, from the obstacle toward the moving shape; zero if undefined
+  uint32_t iterations; ///< Conservative advancement steps; 0 for the closed forms
+ };
+
+ EU_ASSERT_VALUE_TYPE(TOIResult);
+
+ /**
+  * @brief Pose of a rigid body over a step: position and rotation interpolate from 0 to 1.
+  */
+ struct RigidMotion {
+  CVector3 position0;
+  CVector3 position1;
+  Quaternion rotation0; ///< Unit length
+  Quaternion rotation1; ///< Unit length
+
+  /** @brief World position at t of local, a point given in the body's frame. */
+  CVector3
+   transform(const CVector3& local, float t) const {
+   return position0 + (position1 - position0) * t + Quaternion::slerp(rotation0, rotation1, t).rotateUnit(local);
+  }
+
+  /** @brief Rotation angle from rotation0 to rotation1, in radians. */
+  float
+   angle() const {
+   const float d = EngineMath::fabs(rotation0.dot(rotation1));
+   return 2.f * EngineMath::acos(d < 1.f ? d : 1.f);
+  }
+ };
+
+ EU_ASSERT_VALUE_TYPE(RigidMotion);
+
+ /**
+  * @brief Box holding a sphere along its whole path, for gathering candidates from a BVH.
+  */
+ inline AABB
+  sweptBounds(const Sphere& sphere, const CVector3& displacement) {
+  AABB box = AABB::fromSphere(sphere);
+  box.merge(AABB::fromSphere(Sphere(sphere.center + displacement, sphere.radius)));
+  return box;
+ }
+
+ /**
+  * @brief First contact of spheres a and b moving by their displacements over the step.
+  * @return False when they do not touch within the step.
+  */
+ inline bool
+  timeOfImpact(const Sphere& a, const CVector3& displacementA, const Sphere& b, const CVector3& displacementB,
+               TOIResult& result) {
+  const CVector3 s = a.center - b.center, d = displacementA - displacementB;
+  const float r = a.radius + b.radius;
+  const float c = s.lengthSquared() - r * r;
+  float t = 0.f;
+  if (c > 0.f) {
+   const float bb = s.dot(d), aa = d.lengthSquared();
+   const float disc = bb * bb - aa * c;
+   if (bb >= 0.f || disc < 0.f) return false;
+   t = (-bb - EngineMath::sqrtHardware(disc)) / aa;
+   if (t > 1.f) return false;
+  }
+  const CVector3 centerB = b.center + displacementB * t;
+  result.t = t;
+  result.normal = (s + d * t).normalized<EU::Precision::Exact>();
+  result.point = centerB + result.normal * b.radius;
+  result.iterations = 0;
+  return true;
+ }
+
+ /**
+  * @brief First contact of boxes a and b translating by their displacements over the step.
+  * @return False when they do not touch within the step. The normal is the face normal of
+  * b that a reaches last, zero when they start overlapping; point is a's min corner at t
+  * clamped into b, a point of the contact region.
+  */
+ inline bool
+  timeOfImpact(const AABB& a, const CVector3& displacementA, const AABB& b, const CVector3& displacementB,
+               TOIResult& result) {
+  const CVector3 d = displacementA - displacementB;
+  float enter = 0.f, leave = 1.f;
+  int axis = -1;
+  float sign = 0.f;
+  for (int k = 0; k < 3; ++k) {
+   const float lo = b.min[k] - a.max[k], hi = b.max[k] - a.min[k];
+   if (d[k] == 0.f) {
+    if (lo > 0.f || hi < 0.f) return false;
+    continue;
+   }
+   const float inv = 1.f / d[k];
+   float t0 = lo * inv, t1 = hi * inv;
+   if (t0 > t1) std::swap(t0, t1);
+   if (t0 > enter) {
+    enter = t0;
+    axis = k;
+    sign = d[k] > 0.f ? -1.f : 1.f;
+   }
+   if (t1 < leave) leave = t1;
+   if (enter > leave) return false;
+  }
+  result.t = enter;
+  result.normal = CVector3(0.f, 0.f, 0.f);
+  if (axis >= 0) result.normal[axis] = sign;
+  const CVector3 corner = a.min + displacementA * enter;
+  const AABB target(b.min + displacementB * enter, b.max + displacementB * enter);
+  result.point = CVector3(EngineMath::clamp(corner.x, target.min.x, target.max.x),
+                          EngineMath::clamp(corner.y, target.min.y, target.max.y),
+                          EngineMath::clamp(corner.z, target.min.z, target.max.z));
+  result.iterations = 0;
+  return true;
+ }
+
+ /**
+  * @brief First contact of a sphere moving by displacement with the static triangle (a, b, c),
+  * from either side.
+  * @return False when they do not come within TOI_TOLERANCE during the step.
+  */
+ inline bool
+  timeOfImpact(const Sphere& sphere, const CVector3& displacement, const CVector3& a, const CVector3& b,
+               const CVector3& c, TOIResult& result) {
+  float t = 0.f;
+  for (uint32_t it = 0; it < TOI_MAX_ITERATIONS; ++it) {
+   const CVector3 center = sphere.center + displacement * t;
+   const CVector3 closest = closestPointTriangle(center, a, b, c);
+   const CVector3 gap = center - closest;
+   const float distance = gap.length<EU::Precision::Exact>();
+   if (distance - sphere.radius <= TOI_TOLERANCE) {
+    result.t = t;
+    result.point = closest;
+    result.normal = distance > 0.f ? gap * (1.f / distance) : CVector3(0.f, 0.f, 0.f);
+    result.iterations = it;
+    return true;
+   }
+   // Slope of the gap; while it is not negative the (convex) gap only grows.
+   const float closing = -displacement.dot(gap) / distance;
+   if (closing <= 0.f) return false;
+   t += (distance - sphere.radius) / closing;
+   if (t > 1.f) return false;
+  }
+  return false;
+ }
+
+ /**
+  * @brief First contact of a sphere moving by displacement with the triangle (a, b, c) of a
+  * rigid body; the corners are in the body's frame and follow motion.
+  * @return False when they do not come within TOI_TOLERANCE during the step, or the steps
+  * run out.
+  */
+ inline bool
+  timeOfImpact(const Sphere& sphere, const CVector3& displacement, const CVector3& a, const CVector3& b,
+               const CVector3& c, const RigidMotion& motion, TOIResult& result) {
+  const float reach =
+   EngineMath::sqrtHardware(std::max(a.lengthSquared(), std::max(b.lengthSquared(), c.lengthSquared())));
+  const float angular = motion.angle() * reach;
+  const CVector3 relative = displacement - (motion.position1 - motion.position0);
+  float t = 0.f;
+  for (uint32_t it = 0; it < TOI_MAX_ITERATIONS; ++it) {
+   const CVector3 center = sphere.center + displacement * t;
+   const CVector3 closest =
+    closestPointTriangle(center, motion.transform(a, t), motion.transform(b, t), motion.transform(c, t));
+   const CVector3 gap = center - closest;
+   const float distance = gap.length<EU::Precision::Exact>();
+   if (distance - sphere.radius <= TOI_TOLERANCE) {
+    result.t = t;
+    result.point = closest;
+    result.normal = distance > 0.f ? gap * (1.f / distance) : CVector3(0.f, 0.f, 0.f);
+    result.iterations = it;
+    return true;
+   }
+   const float closing = -relative.dot(gap) / distance + angular;
+   if (closing <= 0.f) return false;
+   t += (distance - sphere.radius) / closing;
+   if (t > 1.f) return false;
+  }
+  return false;
+ }
+
+ /**
+  * @brief First of the static spheres (centers, radii)[0..n) that sphere, moving by
+  * displacement, touches during the step.
+  * @return False when it touches none; otherwise index and result describe the first.
+  */
+ inline bool
+  firstImpactSpheres(const Sphere& sphere, const CVector3& displacement, EngineMath::batch::ConstSoA3 centers,
+                     const float* radii, size_t n, TOIResult& result, uint32_t& index) {
+  using detail::BatchLanes;
+  BatchLanes p[3], d[3];
+  detail::splatLanes3(sphere.center, p);
+  detail::splatLanes3(displacement, d);
+  const BatchLanes aa = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+  const BatchLanes zero = BatchLanes::zero(), one = BatchLanes::set1(1.f), radius = BatchLanes::set1(sphere.radius);
+  const BatchLanes safe = EU::SIMD::select(aa > zero, aa, one);
+  float best = 2.f;
+  uint32_t bestIndex = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes c[3];
+   detail::loadLanes3(centers, i, count, c);
+   const BatchLanes s[3] = { p[0] - c[0], p[1] - c[1], p[2] - c[2] };
+   const BatchLanes r = radius + detail::loadLanes(radii, i, count);
+   const BatchLanes cc = s[0] * s[0] + s[1] * s[1] + s[2] * s[2] - r * r;
+   const BatchLanes bb = s[0] * d[0] + s[1] * d[1] + s[2] * d[2];
+   const BatchLanes disc = bb * bb - aa * cc;
+   const BatchLanes root = EU::SIMD::sqrt(EU::SIMD::max(disc, zero));
+   const BatchLanes moving = (bb < zero) & (disc >= zero) & (aa > zero);
+   BatchLanes t = EU::SIMD::select(cc <= zero, zero, EU::SIMD::select(moving, (zero - bb - root) / safe, BatchLanes::set1(2.f)));
+   t = EU::SIMD::select(detail::firstLanes(count) & (t <= one), t, BatchLanes::set1(2.f));
+   detail::keepNearest(t, i, count, best, bestIndex);
+  }
+  if (best > 1.f) return false;
+  index = bestIndex;
+  const Sphere hit(CVector3(centers.x[index], centers.y[index], centers.z[index]), radii[index]);
+  return timeOfImpact(sphere, displacement, hit, CVector3(0.f, 0.f, 0.f), result);
+ }
+
+ /**
+  * @brief First of the candidate triangles of an indexed mesh that sphere, moving by
+  * displacement, comes within TOI_TOLERANCE of during the step.
+  *
+  * Each lane advances one candidate as timeOfImpact() does, with the lanes that cannot beat
+  * the best time so far dropped from the next batch.
+  * @param candidates Triangle indices, e.g. from BVH::overlap(sweptBounds(sphere, displacement)).
+  * @return False when it touches none; otherwise triangle and result describe the first.
+  */
+ inline bool
+  firstImpactTriangles(const Sphere& sphere, const CVector3& displacement, const CVector3* vertices,
+                       const uint32_t* indices, const uint32_t* candidates, size_t n, TOIResult& result,
+                       uint32_t& triangle) {
+  using detail::BatchLanes;
+  const BatchLanes zero = BatchLanes::zero(), one = BatchLanes::set1(1.f);
+  const BatchLanes radius = BatchLanes::set1(sphere.radius), tolerance = BatchLanes::set1(TOI_TOLERANCE);
+  BatchLanes origin[3], d[3];
+  detail::splatLanes3(sphere.center, origin);
+  detail::splatLanes3(displacement, d);
+  float best = 2.f;
+  uint32_t bestIndex = 0;
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   float corners[3][3][detail::BATCH_WIDTH] = {};
+   for (size_t j = 0; j < count; ++j) {
+    const uint32_t* tri = indices + 3 * size_t(candidates[i + j]);
+    for (int v = 0; v < 3; ++v) {
+     const CVector3& p = vertices[tri[v]];
+     corners[v][0][j] = p.x;
+     corners[v][1][j] = p.y;
+     corners[v][2][j] = p.z;
+    }
+   }
+   BatchLanes a[3], b[3], c[3];
+   for (int k = 0; k < 3; ++k) {
+    a[k] = BatchLanes::load(corners[0][k]);
+    b[k] = BatchLanes::load(corners[1][k]);
+    c[k] = BatchLanes::load(corners[2][k]);
+   }
+   const BatchLanes limit = BatchLanes::set1(best < 1.f ? best : 1.f);
+   BatchLanes t = zero, hit = zero, active = detail::firstLanes(count);
+   for (uint32_t it = 0; it < TOI_MAX_ITERATIONS && EU::SIMD::movemask(active); ++it) {
+    BatchLanes center[3];
+    for (int k = 0; k < 3; ++k) center[k] = EU::SIMD::madd(d[k], t, origin[k]);
+    BatchLanes v, w;
+    detail::triangleWeightsLanes(center, a, b, c, v, w);
+    BatchLanes gap[3];
+    for (int k = 0; k < 3; ++k) gap[k] = center[k] - (a[k] + (b[k] - a[k]) * v + (c[k] - a[k]) * w);
+    const BatchLanes distance = EU::SIMD::sqrt(gap[0] * gap[0] + gap[1] * gap[1] + gap[2] * gap[2]);
+    const BatchLanes touching = active & (distance - radius <= tolerance);
+    hit = hit | touching;
+    active = active & (touching == zero);
+    const BatchLanes closing = zero - (d[0] * gap[0] + d[1] * gap[1] + d[2] * gap[2]);
+    const BatchLanes approaching = closing > zero;
+    const BatchLanes step = (distance - radius) * distance / EU::SIMD::select(approaching, closing, one);
+    t = EU::SIMD::select(active, t + step, t);
+    active = active & approaching & (t <= limit);
+   }
+   detail::keepNearest(EU::SIMD::select(hit, t, BatchLanes::set1(2.f)), i, count, best, bestIndex);
+  }
+  if (best > 1.f) return false;
+  triangle = candidates[bestIndex];
+  const uint32_t* tri = indices + 3 * size_t(triangle);
+  const CVector3 &a = vertices[tri[0]], &b = vertices[tri[1]], &c = vertices[tri[2]];
+  if (timeOfImpact(sphere, displacement, a, b, c, result)) return true;
+  // The lanes converged where the scalar steps did not quite; report the lanes' time.
+  const CVector3 center = sphere.center + displacement * best;
+  result.t = best;
+  result.point = closestPointTriangle(center, a, b, c);
+  result.normal = (center - result.point).normalized<EU::Precision::Exact>();
+  result.iterations = TOI_MAX_ITERATIONS;
+  return true;
+ }
+
+ /**
+  * @brief firstImpactTriangles() over the triangles of tree (a BVH or WideBVH built over
+  * vertices and indices) whose bounds overlap the sphere's path.
+  * @param candidates Scratch, cleared and refilled.
+  */
+ template<typename Tree>
+ inline bool
+  firstImpactTriangles(const Tree& tree, const Sphere& sphere, const CVector3& displacement, const CVector3* vertices,
+                       const uint32_t* indices, std::vector<uint32_t>& candidates, TOIResult& result,
+                       uint32_t& triangle) {
+  candidates.clear();
+  tree.overlap(sweptBounds(sphere, displacement), candidates);
+  return firstImpactTriangles(sphere, displacement, vertices, indices, candidates.data(), candidates.size(), result,
+                              triangle);
+ }
+}
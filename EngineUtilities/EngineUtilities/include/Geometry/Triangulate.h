@@ -0,0 +1,584 @@
+/**
+ * @file Triangulate.h
+ * @brief Ear-clipping triangulation of simple 2D polygons with holes.
+ *
+ * The algorithm is the one popularized by earcut: the outer ring and every hole become
+ * circular linked lists, each hole is bridged into the outer ring from its leftmost point, and
+ * ears are clipped off the resulting single ring. A vertex is an ear when it is convex and no
+ * reflex vertex lies inside its triangle. Polygons of more than TRIANGULATE_HASH_MIN points
+ * additionally keep their vertices in z-order (Morton) order, so the containment test only
+ * walks the vertices whose Morton code falls within the ear's bounding box instead of the
+ * whole ring. When no ear is left, the ring is filtered of duplicate and collinear points,
+ * small self-intersections are cured, and as a last resort the ring is split along a valid
+ * diagonal and both halves are triangulated on their own, so degenerate input still produces
+ * a plausible result instead of none.
+ *
+ * The points form one array: the outer ring first, then hole i from holes[i] up to the next
+ * hole (or the end). Rings may wind either way; the triangles always wind counter-clockwise
+ * with y up, which is clockwise on screen with SFML's y-down view. Nothing is drawn twice and
+ * the triangles cover the polygon minus its holes.
+ *
+ * Triangulator keeps its linked-list nodes, hole queue and output between calls, so
+ * re-triangulating a polygon of the same size or smaller allocates nothing.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Vectors/Vector2.h>
+
+namespace EU {
+ namespace detail {
+  /// Polygons (holes included) with more points than this use the z-order hash.
+  constexpr size_t TRIANGULATE_HASH_MIN = 80;
+  constexpr uint32_t TRIANGULATE_NONE = 0xffffffffu;
+
+  /** Interleaves the low 16 bits of x and y (x in the even bits). */
+  inline uint32_t
+   mortonCode(uint32_t x, uint32_t y) {
+   x = (x | (x << 8)) & 0x00ff00ffu;
+   x = (x | (x << 4)) & 0x0f0f0f0fu;
+   x = (x | (x << 2)) & 0x33333333u;
+   x = (x | (x << 1)) & 0x55555555u;
+   y = (y | (y << 8)) & 0x00ff00ffu;
+   y = (y | (y << 4)) & 0x0f0f0f0fu;
+   y = (y | (y << 2)) & 0x33333333u;
+   y = (y | (y << 1)) & 0x55555555u;
+   return x | (y << 1);
+  }
+ }
+
+ /**
+  * @class Triangulator
+  * @brief Reusable ear-clipping triangulator; see the file comment for the input layout.
+  */
+ class
+  Triangulator {
+  public:
+  /**
+   * @brief Triangulates points[0..n), the outer ring followed by the holes starting at
+   * holes[0..holeCount), which must be increasing, at least 3 and below n.
+   * @return Number of triangles written to indices(); 0 for fewer than 3 outer points or an
+   * invalid hole list.
+   */
+  size_t
+   triangulate(const CVector2* points, size_t n, const uint32_t* holes = nullptr, size_t holeCount = 0) {
+   m_indices.clear();
+   m_nodes.clear();
+   m_queue.clear();
+   const size_t outer = holeCount > 0 ? holes[0] : n;
+   if (outer < 3 || outer > n) return 0;
+   for (size_t h = 1; h < holeCount; ++h) {
+    if (holes[h] <= holes[h - 1] || holes[h] >= n) return 0;
+   }
+   m_nodes.reserve(n + 2 * holeCount + 2);
+   m_indices.reserve(3 * (n + 2 * holeCount));
+   uint32_t ring = linkRing(points, 0, outer, true);
+   if (ring == detail::TRIANGULATE_NONE || m_nodes[ring].next == m_nodes[ring].prev) return 0;
+   if (holeCount > 0) ring = eliminateHoles(points, n, holes, holeCount, ring);
+
+   m_invSize = 0.;
+   if (n > detail::TRIANGULATE_HASH_MIN) {
+    double minX = points[0].x, minY = points[0].y, maxX = minX, maxY = minY;
+    for (size_t i = 1; i < outer; ++i) {
+     minX = std::min(minX, static_cast<double>(points[i].x));
+     minY = std::min(minY, static_cast<double>(points[i].y));
+     maxX = std::max(maxX, static_cast<double>(points[i].x));
+     maxY = std::max(maxY, static_cast<double>(points[i].y));
+    }
+    const double size = std::max(maxX - minX, maxY - minY);
+    m_minX = minX;
+    m_minY = minY;
+    m_invSize = size != 0. ? 32767. / size : 0.;
+   }
+   clipEars(ring, 0);
+   return m_indices.size() / 3;
+  }
+
+  /** @brief Corner indices into the last triangulate() input, three per triangle. */
+  const std::vector<uint32_t>&
+   indices() const {
+   return m_indices;
+  }
+
+  size_t
+   triangleCount() const {
+   return m_indices.size() / 3;
+  }
+
+  private:
+  struct Node {
+   double x;
+   double y;
+   uint32_t index;
+   uint32_t prev;
+   uint32_t next;
+   uint32_t prevZ;
+   uint32_t nextZ;
+   uint32_t z;
+   bool steiner;
+  };
+
+  Node&
+   node(uint32_t i) {
+   return m_nodes[i];
+  }
+
+  /** Twice the signed area of (p, q, r), negative when they turn counter-clockwise. */
+  double
+   area(uint32_t p, uint32_t q, uint32_t r) const {
+   const Node &a = m_nodes[p], &b = m_nodes[q], &c = m_nodes[r];
+   return (b.y - a.y) * (c.x - b.x) - (b.x - a.x) * (c.y - b.y);
+  }
+
+  bool
+   equals(uint32_t p, uint32_t q) const {
+   return m_nodes[p].x == m_nodes[q].x && m_nodes[p].y == m_nodes[q].y;
+  }
+
+  static bool
+   pointInTriangle(double ax, double ay, double bx, double by, double cx, double cy, double px, double py) {
+   return (cx - px) * (ay - py) >= (ax - px) * (cy - py) && (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+          (bx - px) * (cy - py) >= (cx - px) * (by - py);
+  }
+
+  uint32_t
+   zOrder(double x, double y) const {
+   return detail::mortonCode(static_cast<uint32_t>(static_cast<int32_t>((x - m_minX) * m_invSize)),
+                             static_cast<uint32_t>(static_cast<int32_t>((y - m_minY) * m_invSize)));
+  }
+
+  /** Adds a node for points[i] after last (or as a ring of its own) and returns it. */
+  uint32_t
+   insertNode(const CVector2* points, uint32_t i, uint32_t last) {
+   const uint32_t p = static_cast<uint32_t>(m_nodes.size());
+   m_nodes.push_back(Node{ points[i].x, points[i].y, i, p, p, detail::TRIANGULATE_NONE, detail::TRIANGULATE_NONE, 0,
+                           false });
+   if (last != detail::TRIANGULATE_NONE) {
+    node(p).next = node(last).next;
+    node(p).prev = last;
+    node(node(last).next).prev = p;
+    node(last).next = p;
+   }
+   return p;
+  }
+
+  void
+   removeNode(uint32_t p) {
+   const Node& n = node(p);
+   node(n.next).prev = n.prev;
+   node(n.prev).next = n.next;
+   if (n.prevZ != detail::TRIANGULATE_NONE) node(n.prevZ).nextZ = n.nextZ;
+   if (n.nextZ != detail::TRIANGULATE_NONE) node(n.nextZ).prevZ = n.prevZ;
+  }
+
+  /** Ring of points[begin..end), linked counter-clockwise for the outer ring, clockwise for holes. */
+  uint32_t
+   linkRing(const CVector2* points, size_t begin, size_t end, bool outer) {
+   double sum = 0.;
+   for (size_t i = begin, j = end - 1; i < end; j = i++) {
+    sum += (static_cast<double>(points[j].x) - points[i].x) * (static_cast<double>(points[i].y) + points[j].y);
+   }
+   uint32_t last = detail::TRIANGULATE_NONE;
+   if (outer == (sum > 0.)) {
+    for (size_t i = begin; i < end; ++i) last = insertNode(points, static_cast<uint32_t>(i), last);
+   }
+   else {
+    for (size_t i = end; i-- > begin;) last = insertNode(points, static_cast<uint32_t>(i), last);
+   }
+   if (last != detail::TRIANGULATE_NONE && equals(last, node(last).next)) {
+    removeNode(last);
+    last = node(last).next;
+   }
+   return last;
+  }
+
+  /** Drops duplicate and collinear points from start up to end (or the whole ring). */
+  uint32_t
+   filterPoints(uint32_t start, uint32_t end = detail::TRIANGULATE_NONE) {
+   if (end == detail::TRIANGULATE_NONE) end = start;
+   uint32_t p = start;
+   bool again;
+   do {
+    again = false;
+    const uint32_t next = node(p).next;
+    if (!node(p).steiner && (equals(p, next) || area(node(p).prev, p, next) == 0.)) {
+     removeNode(p);
+     p = end = node(p).prev;
+     if (p == node(p).next) break;
+     again = true;
+    }
+    else {
+     p = next;
+    }
+   } while (again || p != end);
+   return end;
+  }
+
+  void
+   clipEars(uint32_t ear, int pass) {
+   if (pass == 0 && m_invSize != 0.) indexCurve(ear);
+   uint32_t stop = ear;
+   while (node(ear).prev != node(ear).next) {
+    const uint32_t prev = node(ear).prev, next = node(ear).next;
+    if (m_invSize != 0. ? isEarHashed(ear) : isEar(ear)) {
+     m_indices.push_back(node(prev).index);
+     m_indices.push_back(node(ear).index);
+     m_indices.push_back(node(next).index);
+     removeNode(ear);
+     // Skipping the next vertex leaves fewer sliver triangles.
+     ear = stop = node(next).next;
+     continue;
+    }
+    ear = next;
+    if (ear == stop) {
+     // No ear on a full lap: clean up the ring and retry, harder each pass.
+     if (pass == 0) {
+      clipEars(filterPoints(ear), 1);
+     }
+     else if (pass == 1) {
+      clipEars(cureLocalIntersections(filterPoints(ear)), 2);
+     }
+     else {
+      splitRing(ear);
+     }
+     break;
+    }
+   }
+  }
+
+  bool
+   isEar(uint32_t ear) const {
+   const uint32_t a = m_nodes[ear].prev, c = m_nodes[ear].next;
+   if (area(a, ear, c) >= 0.) return false; // reflex
+   const Node &na = m_nodes[a], &nb = m_nodes[ear], &nc = m_nodes[c];
+   const double x0 = std::min(na.x, std::min(nb.x, nc.x)), y0 = std::min(na.y, std::min(nb.y, nc.y));
+   const double x1 = std::max(na.x, std::max(nb.x, nc.x)), y1 = std::max(na.y, std::max(nb.y, nc.y));
+   for (uint32_t p = nc.next; p != a; p = m_nodes[p].next) {
+    const Node& np = m_nodes[p];
+    if (np.x >= x0 && np.x <= x1 && np.y >= y0 && np.y <= y1 &&
+        pointInTriangle(na.x, na.y, nb.x, nb.y, nc.x, nc.y, np.x, np.y) && area(np.prev, p, np.next) >= 0.) {
+     return false;
+    }
+   }
+   return true;
+  }
+
+  /** isEar() over the z-ordered neighbours whose Morton code lies within the ear's bounds. */
+  bool
+   isEarHashed(uint32_t ear) const {
+   const uint32_t a = m_nodes[ear].prev, c = m_nodes[ear].next;
+   if (area(a, ear, c) >= 0.) return false;
+   const Node &na = m_nodes[a], &nb = m_nodes[ear], &nc = m_nodes[c];
+   const double x0 = std::min(na.x, std::min(nb.x, nc.x)), y0 = std::min(na.y, std::min(nb.y, nc.y));
+   const double x1 = std::max(na.x, std::max(nb.x, nc.x)), y1 = std::max(na.y, std::max(nb.y, nc.y));
+   const uint32_t minZ = zOrder(x0, y0), maxZ = zOrder(x1, y1);
+   auto blocks = [&](uint32_t p) {
+    const Node& np = m_nodes[p];
+    return np.x >= x0 && np.x <= x1 && np.y >= y0 && np.y <= y1 && p != a && p != c &&
+           pointInTriangle(na.x, na.y, nb.x, nb.y, nc.x, nc.y, np.x, np.y) && area(np.prev, p, np.next) >= 0.;
+   };
+   uint32_t p = nb.prevZ, n = nb.nextZ;
+   while (p != detail::TRIANGULATE_NONE && m_nodes[p].z >= minZ && n != detail::TRIANGULATE_NONE &&
+          m_nodes[n].z <= maxZ) {
+    if (blocks(p) || blocks(n)) return false;
+    p = m_nodes[p].prevZ;
+    n = m_nodes[n].nextZ;
+   }
+   for (; p != detail::TRIANGULATE_NONE && m_nodes[p].z >= minZ; p = m_nodes[p].prevZ) {
+    if (blocks(p)) return false;
+   }
+   for (; n != detail::TRIANGULATE_NONE && m_nodes[n].z <= maxZ; n = m_nodes[n].nextZ) {
+    if (blocks(n)) return false;
+   }
+   return true;
+  }
+
+  /** Clips the triangle (a, p, b) off every local self-intersection a-p-n-b crossing at p-n. */
+  uint32_t
+   cureLocalIntersections(uint32_t start) {
+   uint32_t p = start;
+   do {
+    const uint32_t a = node(p).prev, b = node(node(p).next).next;
+    if (!equals(a, b) && intersects(a, p, node(p).next, b) && locallyInside(a, b) && locallyInside(b, a)) {
+     m_indices.push_back(node(a).index);
+     m_indices.push_back(node(p).index);
+     m_indices.push_back(node(b).index);
+     removeNode(node(p).next);
+     removeNode(p);
+     p = start = b;
+    }
+    p = node(p).next;
+   } while (p != start);
+   return filterPoints(p);
+  }
+
+  /** Splits the ring along the first valid diagonal and triangulates both halves. */
+  void
+   splitRing(uint32_t start) {
+   uint32_t a = start;
+   do {
+    for (uint32_t b = node(node(a).next).next; b != node(a).prev; b = node(b).next) {
+     if (node(a).index != node(b).index && isValidDiagonal(a, b)) {
+      uint32_t c = splitPolygon(a, b);
+      a = filterPoints(a, node(a).next);
+      c = filterPoints(c, node(c).next);
+      clipEars(a, 0);
+      clipEars(c, 0);
+      return;
+     }
+    }
+    a = node(a).next;
+   } while (a != start);
+  }
+
+  /** Sorts the ring's nodes by Morton code into the prevZ/nextZ list. */
+  void
+   indexCurve(uint32_t start) {
+   uint32_t p = start;
+   do {
+    Node& n = node(p);
+    if (n.z == 0) n.z = zOrder(n.x, n.y);
+    n.prevZ = n.prev;
+    n.nextZ = n.next;
+    p = n.next;
+   } while (p != start);
+   node(node(p).prevZ).nextZ = detail::TRIANGULATE_NONE;
+   node(p).prevZ = detail::TRIANGULATE_NONE;
+   sortLinked(p);
+  }
+
+  /** Bottom-up merge sort of the nextZ list starting at list, stable in z. */
+  void
+   sortLinked(uint32_t list) {
+   size_t run = 1, merges;
+   do {
+    uint32_t p = list, tail = detail::TRIANGULATE_NONE;
+    list = detail::TRIANGULATE_NONE;
+    merges = 0;
+    while (p != detail::TRIANGULATE_NONE) {
+     ++merges;
+     uint32_t q = p;
+     size_t pSize = 0;
+     for (size_t i = 0; i < run && q != detail::TRIANGULATE_NONE; ++i) {
+      ++pSize;
+      q = node(q).nextZ;
+     }
+     size_t qSize = run;
+     while (pSize > 0 || (qSize > 0 && q != detail::TRIANGULATE_NONE)) {
+      uint32_t e;
+      if (pSize != 0 && (qSize == 0 || q == detail::TRIANGULATE_NONE || node(p).z <= node(q).z)) {
+       e = p;
+       p = node(p).nextZ;
+       --pSize;
+      }
+      else {
+       e = q;
+       q = node(q).nextZ;
+       --qSize;
+      }
+      if (tail != detail::TRIANGULATE_NONE) {
+       node(tail).nextZ = e;
+      }
+      else {
+       list = e;
+      }
+      node(e).prevZ = tail;
+      tail = e;
+     }
+     p = q;
+    }
+    node(tail).nextZ = detail::TRIANGULATE_NONE;
+    run *= 2;
+   } while (merges > 1);
+  }
+
+  /** Bridges every hole into the ring, leftmost holes first. */
+  uint32_t
+   eliminateHoles(const CVector2* points, size_t n, const uint32_t* holes, size_t holeCount, uint32_t ring) {
+   for (size_t h = 0; h < holeCount; ++h) {
+    const uint32_t list = linkRing(points, holes[h], h + 1 < holeCount ? holes[h + 1] : n, false);
+    if (list == detail::TRIANGULATE_NONE) continue;
+    if (list == node(list).next) node(list).steiner = true;
+    m_queue.push_back(leftmost(list));
+   }
+   std::sort(m_queue.begin(), m_queue.end(), [&](uint32_t a, uint32_t b) {
+    return m_nodes[a].x < m_nodes[b].x || (m_nodes[a].x == m_nodes[b].x && a < b);
+   });
+   for (uint32_t hole : m_queue) {
+    const uint32_t bridge = findHoleBridge(hole, ring);
+    if (bridge == detail::TRIANGULATE_NONE) continue;
+    const uint32_t reverse = splitPolygon(bridge, hole);
+    filterPoints(reverse, node(reverse).next);
+    ring = filterPoints(bridge, node(bridge).next);
+   }
+   return ring;
+  }
+
+  uint32_t
+   leftmost(uint32_t start) const {
+   uint32_t p = start, best = start;
+   do {
+    const Node &np = m_nodes[p], &nb = m_nodes[best];
+    if (np.x < nb.x || (np.x == nb.x && np.y < nb.y)) best = p;
+    p = np.next;
+   } while (p != start);
+   return best;
+  }
+
+  /** Ring vertex the hole's leftmost point can connect to without crossing an edge (David Eberly's method). */
+  uint32_t
+   findHoleBridge(uint32_t hole, uint32_t ring) {
+   const double hx = node(hole).x, hy = node(hole).y;
+   double qx = -1e300;
+   uint32_t m = detail::TRIANGULATE_NONE, p = ring;
+   // The nearest edge crossed by a ray from the hole point to the left.
+   do {
+    const Node &np = node(p), &nn = node(np.next);
+    if (hy <= np.y && hy >= nn.y && nn.y != np.y) {
+     const double x = np.x + (hy - np.y) * (nn.x - np.x) / (nn.y - np.y);
+     if (x <= hx && x > qx) {
+      qx = x;
+      m = np.x < nn.x ? p : np.next;
+      if (x == hx) return m; // the hole touches the ring
+     }
+    }
+    p = np.next;
+   } while (p != ring);
+   if (m == detail::TRIANGULATE_NONE) return m;
+
+   // Ring vertices inside the triangle (hole, crossing, m) would block the bridge; take the one
+   // at the smallest angle to the ray instead.
+   const uint32_t stop = m;
+   const double mx = node(m).x, my = node(m).y;
+   double tanMin = 1e300;
+   p = m;
+   do {
+    const Node& np = node(p);
+    if (hx >= np.x && np.x >= mx && hx != np.x &&
+        pointInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, np.x, np.y)) {
+     const double tan = (hy > np.y ? hy - np.y : np.y - hy) / (hx - np.x);
+     if (locallyInside(p, hole) &&
+         (tan < tanMin || (tan == tanMin && (np.x > node(m).x || (np.x == node(m).x && sectorContainsSector(m, p)))))) {
+      m = p;
+      tanMin = tan;
+     }
+    }
+    p = np.next;
+   } while (p != stop);
+   return m;
+  }
+
+  bool
+   sectorContainsSector(uint32_t m, uint32_t p) const {
+   return area(m_nodes[m].prev, m, m_nodes[p].prev) < 0. && area(m_nodes[p].next, m, m_nodes[m].next) < 0.;
+  }
+
+  static int
+   sign(double v) {
+   return v > 0. ? 1 : v < 0. ? -1 : 0;
+  }
+
+  /** q lies within the bounds of segment p-r, for collinear p, q, r. */
+  bool
+   onSegment(uint32_t p, uint32_t q, uint32_t r) const {
+   const Node &a = m_nodes[p], &b = m_nodes[q], &c = m_nodes[r];
+   return b.x <= std::max(a.x, c.x) && b.x >= std::min(a.x, c.x) && b.y <= std::max(a.y, c.y) &&
+          b.y >= std::min(a.y, c.y);
+  }
+
+  bool
+   intersects(uint32_t p1, uint32_t q1, uint32_t p2, uint32_t q2) const {
+   const int o1 = sign(area(p1, q1, p2)), o2 = sign(area(p1, q1, q2));
+   const int o3 = sign(area(p2, q2, p1)), o4 = sign(area(p2, q2, q1));
+   if (o1 != o2 && o3 != o4) return true;
+   return (o1 == 0 && onSegment(p1, p2, q1)) || (o2 == 0 && onSegment(p1, q2, q1)) ||
+          (o3 == 0 && onSegment(p2, p1, q2)) || (o4 == 0 && onSegment(p2, q1, q2));
+  }
+
+  /** The diagonal a-b crosses an edge of the ring. */
+  bool
+   intersectsPolygon(uint32_t a, uint32_t b) const {
+   const uint32_t ia = m_nodes[a].index, ib = m_nodes[b].index;
+   uint32_t p = a;
+   do {
+    const uint32_t next = m_nodes[p].next;
+    const uint32_t ip = m_nodes[p].index, in = m_nodes[next].index;
+    if (ip != ia && in != ia && ip != ib && in != ib && intersects(p, next, a, b)) return true;
+    p = next;
+   } while (p != a);
+   return false;
+  }
+
+  /** The diagonal a-b leaves a into the polygon's interior. */
+  bool
+   locallyInside(uint32_t a, uint32_t b) const {
+   const uint32_t prev = m_nodes[a].prev, next = m_nodes[a].next;
+   return area(prev, a, next) < 0. ? area(a, b, next) >= 0. && area(a, prev, b) >= 0.
+                                   : area(a, b, prev) < 0. || area(a, next, b) < 0.;
+  }
+
+  /** The midpoint of a-b is inside the ring (even-odd). */
+  bool
+   middleInside(uint32_t a, uint32_t b) const {
+   const double px = (m_nodes[a].x + m_nodes[b].x) / 2., py = (m_nodes[a].y + m_nodes[b].y) / 2.;
+   bool inside = false;
+   uint32_t p = a;
+   do {
+    const Node &np = m_nodes[p], &nn = m_nodes[np.next];
+    if ((np.y > py) != (nn.y > py) && nn.y != np.y && px < (nn.x - np.x) * (py - np.y) / (nn.y - np.y) + np.x) {
+     inside = !inside;
+    }
+    p = np.next;
+   } while (p != a);
+   return inside;
+  }
+
+  bool
+   isValidDiagonal(uint32_t a, uint32_t b) const {
+   const Node &na = m_nodes[a], &nb = m_nodes[b];
+   if (m_nodes[na.next].index == nb.index || m_nodes[na.prev].index == nb.index || intersectsPolygon(a, b)) return false;
+   if (locallyInside(a, b) && locallyInside(b, a) && middleInside(a, b) &&
+       (area(na.prev, a, nb.prev) != 0. || area(a, nb.prev, b) != 0.)) {
+    return true;
+   }
+   // Coincident a and b with both corners convex, e.g. where a hole touches the ring.
+   return equals(a, b) && area(na.prev, a, na.next) > 0. && area(nb.prev, b, nb.next) > 0.;
+  }
+
+  /**
+   * Links a straight to b, cutting the ring in two: a-b-...-a's old successor side stays on a,
+   * and copies of a and b close the other half, whose node (b's copy) is returned.
+   */
+  uint32_t
+   splitPolygon(uint32_t a, uint32_t b) {
+   const uint32_t a2 = static_cast<uint32_t>(m_nodes.size()), b2 = a2 + 1;
+   Node copyA = node(a), copyB = node(b);
+   copyA.prevZ = copyA.nextZ = copyB.prevZ = copyB.nextZ = detail::TRIANGULATE_NONE;
+   copyA.z = copyB.z = 0;
+   copyA.steiner = copyB.steiner = false;
+   m_nodes.push_back(copyA);
+   m_nodes.push_back(copyB);
+   const uint32_t an = node(a).next, bp = node(b).prev;
+   node(a).next = b;
+   node(b).prev = a;
+   node(a2).next = an;
+   node(an).prev = a2;
+   node(b2).next = a2;
+   node(a2).prev = b2;
+   node(bp).next = b2;
+   node(b2).prev = bp;
+   return b2;
+  }
+
+  std::vector<Node> m_nodes;
+  std::vector<uint32_t> m_queue;
+  std::vector<uint32_t> m_indices;
+  double m_minX = 0.;
+  double m_minY = 0.;
+  double m_invSize = 0.;
+ };
+}
@@ -0,0 +1,485 @@
+/**
+ * @file VoxelMesh.h
+ * @brief Greedy meshing of 32^3 voxel chunks with bitmask face culling, packed 16-bit
+ * vertices, and a chunked voxel world that remeshes only dirty chunks, in parallel.
+ *
+ * A voxel is a 16-bit material, 0 for empty. meshVoxelChunk() first turns the chunk into
+ * one 64-bit occupancy column per (axis, row, column): bit i + 1 is the voxel at coordinate i
+ * along the axis, and bits 0 and 33 are the neighbouring chunks' voxels on either side. The
+ * visible faces of a whole column toward +axis are then col & ~(col >> 1), and toward -axis
+ * col & ~(col << 1): one shift and mask per 32 voxels instead of a neighbour test per face.
+ * The face bits are transposed into one 32 x 32 bit plane per slice, and each plane is
+ * merged greedily: the lowest set bit of a row starts a run as wide as the trailing ones,
+ * and the run grows down the rows while the next row contains it. Chunks of one material
+ * merge on the masks alone; mixed chunks also stop runs where the material changes, so a
+ * quad never spans two materials. Coplanar faces of a flat wall become one quad, which is
+ * where the naive emitter's six quads per exposed voxel go.
+ *
+ * Each quad is four VoxelVertex, 8 bytes each: the corner in voxel units within the chunk
+ * (0..32, exact in 16 bits) and a word holding the face and material. Triangles are the
+ * quad pattern 0 1 2, 0 2 3 with counter-clockwise front faces; VoxelWorld::quadIndices()
+ * is one index buffer for every chunk. Texture coordinates follow from the position and face
+ * (repeat the texture per voxel: uv = the two in-plane position components).
+ *
+ * VoxelWorld stores a grid of chunks. set() marks the voxel's chunk dirty, plus the chunks
+ * across any border it lies on, whose faces it hides or exposes; remesh() rebuilds every
+ * dirty chunk, VOXEL_REMESH_BATCH chunks per task through parallelTasks(), which runs on
+ * the job system once JobSystem::useForParallelTasks() is installed. Outside the world is
+ * empty, so border faces are emitted.
+ *
+ *   VoxelWorld world(8, 4, 8);
+ *   world.fill(0, 0, 0, 255, 40, 255, STONE);
+ *   world.set(10, 41, 12, GRASS);
+ *   world.remesh();
+ *   for (each chunk) draw(world.mesh(cx, cy, cz), world.quadIndices(), world.chunkOrigin(cx, cy, cz));
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/Trace.h>
+#include <Math/IntMath.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /// Voxels along each edge of a chunk.
+ constexpr uint32_t VOXEL_CHUNK = 32;
+ constexpr uint32_t VOXEL_CHUNK_VOXELS = VOXEL_CHUNK * VOXEL_CHUNK * VOXEL_CHUNK;
+ /// Bits of VoxelVertex::attributes holding the material; the face takes the rest.
+ constexpr uint32_t VOXEL_MATERIAL_BITS = 13;
+ /// Largest material a chunk can mesh.
+ constexpr uint16_t VOXEL_MAX_MATERIAL = (1u << VOXEL_MATERIAL_BITS) - 1;
+ /// Dirty chunks remeshed per task.
+ constexpr size_t VOXEL_REMESH_BATCH = 4;
+
+ /** @brief Direction a face looks: axis * 2, plus 1 toward -axis. */
+ enum VoxelFace : uint32_t {
+  VOXEL_FACE_POS_X,
+  VOXEL_FACE_NEG_X,
+  VOXEL_FACE_POS_Y,
+  VOXEL_FACE_NEG_Y,
+  VOXEL_FACE_POS_Z,
+  VOXEL_FACE_NEG_Z,
+ };
+
+ /**
+  * @struct VoxelVertex
+  * @brief Corner of a meshed quad: position in voxels from the chunk origin, face and material.
+  */
+ struct VoxelVertex {
+  uint16_t x;
+  uint16_t y;
+  uint16_t z;
+  uint16_t attributes; ///< face << VOXEL_MATERIAL_BITS | material
+
+  uint32_t
+   face() const {
+   return attributes >> VOXEL_MATERIAL_BITS;
+  }
+
+  uint16_t
+   material() const {
+   return static_cast<uint16_t>(attributes & VOXEL_MAX_MATERIAL);
+  }
+ };
+
+ static_assert(sizeof(VoxelVertex) == 8, "VoxelVertex must stay 8 bytes");
+
+ /** @brief Outward unit normal of a VoxelFace. */
+ inline CVector3
+  voxelFaceNormal(uint32_t face) {
+  const float sign = face & 1 ? -1.f : 1.f;
+  const uint32_t axis = face >> 1;
+  return CVector3(axis == 0 ? sign : 0.f, axis == 1 ? sign : 0.f, axis == 2 ? sign : 0.f);
+ }
+
+ /** @brief Index of voxel (x, y, z) in a chunk's VOXEL_CHUNK_VOXELS materials, x fastest. */
+ constexpr uint32_t
+  voxelIndex(uint32_t x, uint32_t y, uint32_t z) {
+  return x | y << 5 | z << 10;
+ }
+
+ namespace detail {
+  /**
+   * Per-call state of meshVoxelChunk(): columns[axis][v][u] with u and v the next two axes
+   * after axis (cyclically), and the face bit planes of one direction, planes[slice][v] bit u.
+   */
+  struct VoxelMeshScratch {
+   uint64_t columns[3][VOXEL_CHUNK][VOXEL_CHUNK];
+   uint32_t planes[VOXEL_CHUNK][VOXEL_CHUNK];
+  };
+
+  inline uint32_t
+   voxelLowestBit(uint64_t bits) {
+   return static_cast<uint32_t>(63 - EngineMath::detail::countLeadingZeros(bits & (~bits + 1)));
+  }
+
+  /** Transposes a 32 x 32 bit matrix in place: bit c of rows[r] moves to bit r of rows[c]. */
+  inline void
+   transposeVoxelBits(uint32_t (&rows)[VOXEL_CHUNK]) {
+   uint32_t mask = 0x0000ffffu;
+   for (uint32_t j = 16; j != 0; j >>= 1, mask ^= mask << j) {
+    for (uint32_t k = 0; k < VOXEL_CHUNK; k = (k + j + 1) & ~j) {
+     const uint32_t t = ((rows[k] >> j) ^ rows[k + j]) & mask;
+     rows[k + j] ^= t;
+     rows[k] ^= t << j;
+    }
+   }
+  }
+
+  /** Bit 15 of every 16-bit lane of word set where that lane is non-zero. */
+  inline uint64_t
+   voxelNonZeroLanes(uint64_t word) {
+   const uint64_t low = 0x7fff7fff7fff7fffull;
+   return (((word & low) + low) | word) & ~low;
+  }
+
+  /**
+   * Fills scratch.columns; returns whether every solid voxel has the same material. The x
+   * rows are read four voxels per 64-bit word, the y and z columns are bit transposes of them.
+   */
+  inline bool
+   buildVoxelColumns(const uint16_t* voxels, const uint16_t* const neighbours[6], VoxelMeshScratch& scratch) {
+   uint64_t (&columns)[3][VOXEL_CHUNK][VOXEL_CHUNK] = scratch.columns;
+   uint32_t (&rows)[VOXEL_CHUNK][VOXEL_CHUNK] = scratch.planes; // rows[z][y] bit x
+   uint64_t first = 0, mixed = 0;
+   for (uint32_t z = 0; z < VOXEL_CHUNK; ++z) {
+    for (uint32_t y = 0; y < VOXEL_CHUNK; ++y) {
+     const uint16_t* row = voxels + voxelIndex(0, y, z);
+     uint64_t words[VOXEL_CHUNK / 4];
+     std::memcpy(words, row, sizeof(words));
+     uint32_t bits = 0;
+     for (uint32_t w = 0; w < VOXEL_CHUNK / 4; ++w) {
+      const uint64_t solid = voxelNonZeroLanes(words[w]);
+      // The lane flags, shifted to bits 0, 16, 32 and 48, multiply onto bits 45..48 without carries.
+      bits |= static_cast<uint32_t>((solid >> 15) * 0x0000200040008001ull >> 45 & 0xf) << (w * 4);
+      if (first == 0 && solid != 0) first = row[w * 4 + voxelLowestBit(solid) / 16] * 0x0001000100010001ull;
+      mixed |= solid & voxelNonZeroLanes(words[w] ^ first);
+     }
+     rows[z][y] = bits;
+     columns[0][z][y] = static_cast<uint64_t>(bits) << 1;
+    }
+   }
+   uint32_t block[VOXEL_CHUNK];
+   // columns[1][x][z] bit y: per z, transpose (y, x).
+   for (uint32_t z = 0; z < VOXEL_CHUNK; ++z) {
+    for (uint32_t y = 0; y < VOXEL_CHUNK; ++y) block[y] = rows[z][y];
+    transposeVoxelBits(block);
+    for (uint32_t x = 0; x < VOXEL_CHUNK; ++x) columns[1][x][z] = static_cast<uint64_t>(block[x]) << 1;
+   }
+   // columns[2][y][x] bit z: per y, transpose (z, x).
+   for (uint32_t y = 0; y < VOXEL_CHUNK; ++y) {
+    for (uint32_t z = 0; z < VOXEL_CHUNK; ++z) block[z] = rows[z][y];
+    transposeVoxelBits(block);
+    for (uint32_t x = 0; x < VOXEL_CHUNK; ++x) columns[2][y][x] = static_cast<uint64_t>(block[x]) << 1;
+   }
+   const bool uniform = mixed == 0;
+   // Bit 0 is the -axis neighbour's last slice, bit 33 the +axis neighbour's first.
+   for (uint32_t axis = 0; axis < 3; ++axis) {
+    const uint16_t* below = neighbours[axis * 2 + 1];
+    const uint16_t* above = neighbours[axis * 2];
+    if (below == nullptr && above == nullptr) continue;
+    const uint32_t sa = 5 * axis, su = 5 * ((axis + 1) % 3), sv = 5 * ((axis + 2) % 3);
+    for (uint32_t v = 0; v < VOXEL_CHUNK; ++v) {
+     for (uint32_t u = 0; u < VOXEL_CHUNK; ++u) {
+      const uint32_t plane = u << su | v << sv;
+      if (below && below[plane | (VOXEL_CHUNK - 1) << sa]) columns[axis][v][u] |= 1ull;
+      if (above && above[plane]) columns[axis][v][u] |= 1ull << (VOXEL_CHUNK + 1);
+     }
+    }
+   }
+   return uniform;
+  }
+
+  /** Greedy quads of one face direction, appended to out. */
+  inline void
+   meshVoxelFaces(const uint16_t* voxels, uint32_t face, bool uniform, VoxelMeshScratch& scratch,
+                  std::vector<VoxelVertex>& out) {
+   const uint32_t axis = face >> 1;
+   const bool negative = (face & 1) != 0;
+   uint32_t (&planes)[VOXEL_CHUNK][VOXEL_CHUNK] = scratch.planes;
+   for (auto& plane : planes)
+    for (uint32_t& row : plane) row = 0;
+   for (uint32_t v = 0; v < VOXEL_CHUNK; ++v) {
+    for (uint32_t u = 0; u < VOXEL_CHUNK; ++u) {
+     const uint64_t column = scratch.columns[axis][v][u];
+     const uint64_t faces = negative ? column & ~(column << 1) : column & ~(column >> 1);
+     for (uint64_t d = (faces >> 1) & 0xffffffffull; d; d &= d - 1) planes[voxelLowestBit(d)][v] |= 1u << u;
+    }
+   }
+
+   const uint32_t sa = 5 * axis, su = 5 * ((axis + 1) % 3), sv = 5 * ((axis + 2) % 3);
+   const uint32_t ua = (axis + 1) % 3, va = (axis + 2) % 3;
+   for (uint32_t d = 0; d < VOXEL_CHUNK; ++d) {
+    uint32_t (&plane)[VOXEL_CHUNK] = planes[d];
+    const uint32_t slice = d << sa;
+    auto material = [&](uint32_t u, uint32_t v) { return voxels[slice | u << su | v << sv]; };
+    for (uint32_t v = 0; v < VOXEL_CHUNK; ++v) {
+     while (plane[v] != 0) {
+      const uint32_t u0 = voxelLowestBit(plane[v]);
+      const uint16_t m = material(u0, v);
+      // Trailing ones from u0; the 64-bit complement always has a zero above bit 31.
+      uint32_t w = voxelLowestBit(~(static_cast<uint64_t>(plane[v]) >> u0));
+      if (!uniform) {
+       for (uint32_t k = 1; k < w; ++k) {
+        if (material(u0 + k, v) != m) {
+         w = k;
+         break;
+        }
+       }
+      }
+      const uint32_t run = static_cast<uint32_t>(((1ull << w) - 1) << u0);
+      plane[v] &= ~run;
+      uint32_t h = 1;
+      for (; v + h < VOXEL_CHUNK && (plane[v + h] & run) == run; ++h) {
+       if (!uniform) {
+        uint32_t k = 0;
+        while (k < w && material(u0 + k, v + h) == m) ++k;
+        if (k < w) break;
+       }
+       plane[v + h] &= ~run;
+      }
+
+      const uint16_t attributes = static_cast<uint16_t>(face << VOXEL_MATERIAL_BITS | (m & VOXEL_MAX_MATERIAL));
+      const uint32_t depth = negative ? d : d + 1;
+      const uint32_t us[4] = { u0, u0 + w, u0 + w, u0 };
+      const uint32_t vs[4] = { v, v, v + h, v + h };
+      const size_t base = out.size();
+      out.resize(base + 4);
+      for (uint32_t c = 0; c < 4; ++c) {
+       // -axis faces walk the corners the other way round to stay counter-clockwise.
+       const uint32_t k = negative ? (4 - c) & 3 : c;
+       uint32_t p[3];
+       p[axis] = depth;
+       p[ua] = us[k];
+       p[va] = vs[k];
+       out[base + c] = VoxelVertex{ static_cast<uint16_t>(p[0]), static_cast<uint16_t>(p[1]),
+                                    static_cast<uint16_t>(p[2]), attributes };
+      }
+     }
+    }
+   }
+  }
+ }
+
+ /**
+  * @brief Greedy mesh of one chunk of VOXEL_CHUNK_VOXELS materials (see voxelIndex()).
+  * @param neighbours Chunks across each VoxelFace (neighbours[VOXEL_FACE_POS_X] is the one at
+  * +x), nullptr for empty space; only their border slices are read.
+  * @param out Cleared and refilled with four vertices per quad.
+  * @return Quads emitted.
+  */
+ inline size_t
+  meshVoxelChunk(const uint16_t* voxels, const uint16_t* const neighbours[6], std::vector<VoxelVertex>& out,
+                 detail::VoxelMeshScratch& scratch) {
+  out.clear();
+  const bool uniform = detail::buildVoxelColumns(voxels, neighbours, scratch);
+  for (uint32_t face = 0; face < 6; ++face) detail::meshVoxelFaces(voxels, face, uniform, scratch, out);
+  return out.size() / 4;
+ }
+
+ /** @brief meshVoxelChunk() with its own scratch. */
+ inline size_t
+  meshVoxelChunk(const uint16_t* voxels, const uint16_t* const neighbours[6], std::vector<VoxelVertex>& out) {
+  std::vector<detail::VoxelMeshScratch> scratch(1);
+  return meshVoxelChunk(voxels, neighbours, out, scratch[0]);
+ }
+
+ /**
+  * @class VoxelWorld
+  * @brief Grid of chunksX x chunksY x chunksZ voxel chunks with one greedy mesh each, rebuilt
+  * on remesh() for the chunks edited since.
+  */
+ class
+  VoxelWorld {
+  public:
+  VoxelWorld(uint32_t chunksX, uint32_t chunksY, uint32_t chunksZ)
+   : m_chunksX(chunksX), m_chunksY(chunksY), m_chunksZ(chunksZ),
+     m_voxels(static_cast<size_t>(chunksX) * chunksY * chunksZ * VOXEL_CHUNK_VOXELS, 0),
+     m_meshes(static_cast<size_t>(chunksX) * chunksY * chunksZ),
+     m_dirtyFlags(m_meshes.size(), 0) {
+  }
+
+  /** @brief Material at voxel (x, y, z); 0 outside the world. */
+  uint16_t
+   get(uint32_t x, uint32_t y, uint32_t z) const {
+   if (!inside(x, y, z)) return 0;
+   return m_voxels[voxelOffset(x, y, z)];
+  }
+
+  /**
+   * @brief Sets voxel (x, y, z) and marks the chunks whose mesh it can change. False if it
+   * is outside the world or material is above VOXEL_MAX_MATERIAL.
+   */
+  bool
+   set(uint32_t x, uint32_t y, uint32_t z, uint16_t material) {
+   if (!inside(x, y, z) || material > VOXEL_MAX_MATERIAL) return false;
+   uint16_t& voxel = m_voxels[voxelOffset(x, y, z)];
+   if (voxel == material) return true;
+   voxel = material;
+   const uint32_t c[3] = { x / VOXEL_CHUNK, y / VOXEL_CHUNK, z / VOXEL_CHUNK };
+   const uint32_t l[3] = { x % VOXEL_CHUNK, y % VOXEL_CHUNK, z % VOXEL_CHUNK };
+   const uint32_t n[3] = { m_chunksX, m_chunksY, m_chunksZ };
+   markDirty(c[0], c[1], c[2]);
+   for (uint32_t axis = 0; axis < 3; ++axis) {
+    uint32_t other[3] = { c[0], c[1], c[2] };
+    if (l[axis] == 0 && c[axis] > 0) {
+     --other[axis];
+     markDirty(other[0], other[1], other[2]);
+    }
+    else if (l[axis] == VOXEL_CHUNK - 1 && c[axis] + 1 < n[axis]) {
+     ++other[axis];
+     markDirty(other[0], other[1], other[2]);
+    }
+   }
+   return true;
+  }
+
+  /** @brief set() of every voxel in [x0, x1] x [y0, y1] x [z0, z1], clamped to the world. */
+  void
+   fill(uint32_t x0, uint32_t y0, uint32_t z0, uint32_t x1, uint32_t y1, uint32_t z1, uint16_t material) {
+   x1 = x1 < width() ? x1 : width() - 1;
+   y1 = y1 < height() ? y1 : height() - 1;
+   z1 = z1 < depth() ? z1 : depth() - 1;
+   for (uint32_t z = z0; z <= z1; ++z)
+    for (uint32_t y = y0; y <= y1; ++y)
+     for (uint32_t x = x0; x <= x1; ++x) set(x, y, z, material);
+  }
+
+  /**
+   * @brief Remeshes every chunk changed since the last call, VOXEL_REMESH_BATCH per task.
+   * Returns the chunks remeshed.
+   */
+  size_t
+   remesh(size_t threads = 0) {
+   if (m_dirty.empty()) return 0;
+   EU_TRACE_ZONE("VoxelWorld::remesh");
+   const size_t count = m_dirty.size(), tasks = (count + VOXEL_REMESH_BATCH - 1) / VOXEL_REMESH_BATCH;
+   if (m_scratch.size() < tasks) m_scratch.resize(tasks);
+   detail::parallelTasks(tasks, detail::resolveThreads(threads, tasks), [&](size_t t) {
+    const size_t end = (t + 1) * VOXEL_REMESH_BATCH < count ? (t + 1) * VOXEL_REMESH_BATCH : count;
+    for (size_t i = t * VOXEL_REMESH_BATCH; i < end; ++i) meshChunk(m_dirty[i], m_scratch[t]);
+   });
+   size_t quads = 0;
+   for (const std::vector<VoxelVertex>& mesh : m_meshes) quads = mesh.size() / 4 > quads ? mesh.size() / 4 : quads;
+   growQuadIndices(quads);
+   for (uint32_t chunk : m_dirty) m_dirtyFlags[chunk] = 0;
+   m_dirty.clear();
+   EU_TRACE_COUNTER("voxel chunks remeshed", count);
+   return count;
+  }
+
+  /** @brief Mesh of chunk (cx, cy, cz) as of the last remesh(), in voxels from chunkOrigin(). */
+  const std::vector<VoxelVertex>&
+   mesh(uint32_t cx, uint32_t cy, uint32_t cz) const {
+   return m_meshes[chunkIndex(cx, cy, cz)];
+  }
+
+  /** @brief First voxel of chunk (cx, cy, cz). */
+  CVector3
+   chunkOrigin(uint32_t cx, uint32_t cy, uint32_t cz) const {
+   return CVector3(static_cast<float>(cx * VOXEL_CHUNK), static_cast<float>(cy * VOXEL_CHUNK),
+                   static_cast<float>(cz * VOXEL_CHUNK));
+  }
+
+  /** @brief Triangles 0 1 2, 0 2 3 of every quad, long enough for the largest mesh. */
+  const std::vector<uint32_t>&
+   quadIndices() const {
+   return m_quadIndices;
+  }
+
+  /** @brief Materials of chunk (cx, cy, cz), indexed by voxelIndex(). */
+  const uint16_t*
+   chunkVoxels(uint32_t cx, uint32_t cy, uint32_t cz) const {
+   return m_voxels.data() + static_cast<size_t>(chunkIndex(cx, cy, cz)) * VOXEL_CHUNK_VOXELS;
+  }
+
+  /** @brief Chunks waiting for remesh(). */
+  size_t
+   dirtyCount() const {
+   return m_dirty.size();
+  }
+
+  uint32_t
+   width() const {
+   return m_chunksX * VOXEL_CHUNK;
+  }
+
+  uint32_t
+   height() const {
+   return m_chunksY * VOXEL_CHUNK;
+  }
+
+  uint32_t
+   depth() const {
+   return m_chunksZ * VOXEL_CHUNK;
+  }
+
+  private:
+  bool
+   inside(uint32_t x, uint32_t y, uint32_t z) const {
+   return x < width() && y < height() && z < depth();
+  }
+
+  uint32_t
+   chunkIndex(uint32_t cx, uint32_t cy, uint32_t cz) const {
+   return (cz * m_chunksY + cy) * m_chunksX + cx;
+  }
+
+  size_t
+   voxelOffset(uint32_t x, uint32_t y, uint32_t z) const {
+   return static_cast<size_t>(chunkIndex(x / VOXEL_CHUNK, y / VOXEL_CHUNK, z / VOXEL_CHUNK)) * VOXEL_CHUNK_VOXELS
+        + voxelIndex(x % VOXEL_CHUNK, y % VOXEL_CHUNK, z % VOXEL_CHUNK);
+  }
+
+  void
+   markDirty(uint32_t cx, uint32_t cy, uint32_t cz) {
+   const uint32_t chunk = chunkIndex(cx, cy, cz);
+   if (m_dirtyFlags[chunk]) return;
+   m_dirtyFlags[chunk] = 1;
+   m_dirty.push_back(chunk);
+  }
+
+  void
+   meshChunk(uint32_t chunk, detail::VoxelMeshScratch& scratch) {
+   const uint32_t cx = chunk % m_chunksX, cy = chunk / m_chunksX % m_chunksY, cz = chunk / (m_chunksX * m_chunksY);
+   const uint16_t* neighbours[6] = {
+    cx + 1 < m_chunksX ? chunkVoxels(cx + 1, cy, cz) : nullptr, cx > 0 ? chunkVoxels(cx - 1, cy, cz) : nullptr,
+    cy + 1 < m_chunksY ? chunkVoxels(cx, cy + 1, cz) : nullptr, cy > 0 ? chunkVoxels(cx, cy - 1, cz) : nullptr,
+    cz + 1 < m_chunksZ ? chunkVoxels(cx, cy, cz + 1) : nullptr, cz > 0 ? chunkVoxels(cx, cy, cz - 1) : nullptr,
+   };
+   meshVoxelChunk(chunkVoxels(cx, cy, cz), neighbours, m_meshes[chunk], scratch);
+  }
+
+  void
+   growQuadIndices(size_t quads) {
+   const size_t have = m_quadIndices.size() / 6;
+   if (quads <= have) return;
+   m_quadIndices.resize(quads * 6);
+   for (size_t q = have; q < quads; ++q) {
+    const uint32_t base = static_cast<uint32_t>(q * 4);
+    uint32_t* index = &m_quadIndices[q * 6];
+    index[0] = base;
+    index[1] = base + 1;
+    index[2] = base + 2;
+    index[3] = base;
+    index[4] = base + 2;
+    index[5] = base + 3;
+   }
+  }
+
+  uint32_t m_chunksX;
+  uint32_t m_chunksY;
+  uint32_t m_chunksZ;
+  std::vector<uint16_t> m_voxels;                      ///< Chunk after chunk, each indexed by voxelIndex()
+  std::vector<std::vector<VoxelVertex>> m_meshes;      ///< Per chunk
+  std::vector<uint8_t> m_dirtyFlags;                   ///< Per chunk: in m_dirty
+  std::vector<uint32_t> m_dirty;                       ///< Chunks to remesh, in edit order
+  std::vector<detail::VoxelMeshScratch> m_scratch;     ///< Per remesh() task
+  std::vector<uint32_t> m_quadIndices;
+ };
+}
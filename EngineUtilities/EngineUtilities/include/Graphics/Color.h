@@ -0,0 +1,486 @@
+/**
+ * @file Color.h
+ * @brief Color-space math for lighting bakes and UI: sRGB transfer, HSV, tonemapping and 8-bit
+ * packing, per color and over CVector3 arrays or SoA streams.
+ *
+ * Colors are CVector3 (r, g, b) or CVector4 with alpha in w, which every function passes through
+ * untouched. The scalar functions evaluate the sRGB transfer with EngineMath::pow; the array
+ * versions run the same piecewise curves a register at a time through a fixed-exponent pow,
+ * the batch exp2 of a division-free log2 polynomial (relative error below 1e-6, far under an
+ * 8-bit step), with the linear toe selected per lane rather than branched on.
+ *
+ * 8-bit data goes through tables instead. Decoding indexes 256 exact floats. Encoding splits
+ * [2^-13, 1) into 13 octaves of 256 buckets by the float's exponent and top mantissa bits; no
+ * bucket spans a whole 8-bit step, so each stores its first code and the float at which the
+ * next one starts, and one compare gives the correctly rounded code for every input. Both
+ * tables are built on first use. packColors() and unpackColors() move CVector4 arrays to and
+ * from RGBA8 (sf::Color layout; the sf::Color overloads live in VectorSFML.h), in sRGB or
+ * linear encoding.
+ *
+ * HSV hue is in [0, 1) turns rather than degrees. Tonemap::ACES is Narkowicz's fit of the ACES
+ * reference transform; all three operators take linear scene values, scaled by exposure first.
+ *
+ *   tonemapArray(radiance.data(), radiance.data(), n, Tonemap::ACES, exposure);
+ *   for (size_t i = 0; i < n; ++i) texels[i] = CVector4(radiance[i].x, radiance[i].y, radiance[i].z, 1.f);
+ *   packColors(texels.data(), pixels, n, ColorEncoding::SRGB);
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector4.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /** @brief How 8-bit channels map to linear values. */
+ enum class ColorEncoding : uint8_t {
+  Linear, ///< code / 255
+  SRGB    ///< IEC 61966-2-1 transfer curve
+ };
+
+ /** @brief Tonemapping operator of tonemap() and tonemapArray(). */
+ enum class Tonemap : uint8_t {
+  Reinhard,         ///< x / (1 + x)
+  ReinhardExtended, ///< Reinhard with white mapped to 1
+  ACES              ///< Narkowicz's ACES filmic fit, clamped to [0, 1]
+ };
+
+ namespace detail {
+  /// sRGB curve constants: toe threshold (encoded and linear), toe slope, and the power segment.
+  constexpr float SRGB_TOE_ENCODED = 0.04045f;
+  constexpr float SRGB_TOE_LINEAR = 0.0031308f;
+  constexpr float SRGB_TOE_SLOPE = 12.92f;
+  constexpr float SRGB_GAMMA = 2.4f;
+  constexpr float SRGB_SCALE = 1.055f;
+  constexpr float SRGB_OFFSET = 0.055f;
+
+  /// Narkowicz ACES fit (x (a x + b)) / (x (c x + d) + e).
+  constexpr float ACES_A = 2.51f;
+  constexpr float ACES_B = 0.03f;
+  constexpr float ACES_C = 2.43f;
+  constexpr float ACES_D = 0.59f;
+  constexpr float ACES_E = 0.14f;
+
+  /// Buckets per octave of the 8-bit encode table, and its octaves below 1.
+  constexpr uint32_t SRGB_BUCKET_BITS = 8;
+  constexpr uint32_t SRGB_OCTAVES = 13;
+  /// Float bits of 2^-13, the first bucket; everything below encodes to 0.
+  constexpr uint32_t SRGB_TABLE_MIN_BITS = (127u - SRGB_OCTAVES) << 23;
+
+  /** Reference curves in double with the exact decimal constants, used to build the tables. */
+  inline double
+   linearToSrgbReference(double x) {
+   return x <= 0.0031308 ? x * 12.92 : 1.055 * std::pow(x, 1.0 / 2.4) - 0.055;
+  }
+
+  inline double
+   srgbToLinearReference(double c) {
+   return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+  }
+
+  inline uint32_t
+   srgbCodeReference(float x) {
+   return static_cast<uint32_t>(std::floor(linearToSrgbReference(x) * 255.0 + 0.5));
+  }
+
+  /** Decode table (256 linear floats) and encode table (first code and next threshold per bucket). */
+  struct SrgbTables {
+   float decode[256];
+   float threshold[SRGB_OCTAVES << SRGB_BUCKET_BITS];
+   uint8_t base[SRGB_OCTAVES << SRGB_BUCKET_BITS];
+
+   SrgbTables() {
+    for (uint32_t k = 0; k < 256; ++k) {
+     decode[k] = static_cast<float>(srgbToLinearReference(k / 255.0));
+    }
+    constexpr uint32_t SHIFT = 23 - SRGB_BUCKET_BITS;
+    for (uint32_t b = 0; b < (SRGB_OCTAVES << SRGB_BUCKET_BITS); ++b) {
+     const uint32_t lo = SRGB_TABLE_MIN_BITS + (b << SHIFT), hi = lo + (1u << SHIFT);
+     base[b] = static_cast<uint8_t>(srgbCodeReference(floatOf(lo)));
+     // First float of the bucket with the next code, by bisection on the bit pattern.
+     if (srgbCodeReference(floatOf(hi - 1)) == base[b]) {
+      threshold[b] = floatOf(hi);
+      continue;
+     }
+     uint32_t first = lo, last = hi - 1;
+     while (first < last) {
+      const uint32_t mid = first + (last - first) / 2;
+      if (srgbCodeReference(floatOf(mid)) > base[b]) last = mid;
+      else first = mid + 1;
+     }
+     threshold[b] = floatOf(first);
+    }
+   }
+
+   static float
+    floatOf(uint32_t bits) {
+    float f;
+    std::memcpy(&f, &bits, 4);
+    return f;
+   }
+  };
+
+  inline const SrgbTables&
+   srgbTables() {
+   static const SrgbTables tables;
+   return tables;
+  }
+
+  /// log2(1 + u) = u (C0 + u (C1 + ... + u C6)) on [sqrt(1/2) - 1, sqrt(2) - 1], absolute error 3e-7.
+  constexpr float GAMMA_LOG2_C0 = 1.44269973f;
+  constexpr float GAMMA_LOG2_C1 = -0.72137586f;
+  constexpr float GAMMA_LOG2_C2 = 0.48046475f;
+  constexpr float GAMMA_LOG2_C3 = -0.358962503f;
+  constexpr float GAMMA_LOG2_C4 = 0.297267318f;
+  constexpr float GAMMA_LOG2_C5 = -0.272692161f;
+  constexpr float GAMMA_LOG2_C6 = 0.170609795f;
+
+  /**
+   * x^exponent for normal x > 0, 0 elsewhere: kernels::exp2 of a log2 that replaces the atanh
+   * series of kernels::log (and its division) with one polynomial. Relative error about
+   * 1e-7 * |exponent| plus that of exp2.
+   */
+  template<typename V>
+  inline V
+   gammaPowLanes(V x, float exponent) {
+   using I = typename V::Int;
+   const V one = V::set1(1.f);
+   const I bits = EU::SIMD::asInt(x);
+   V e = EU::SIMD::toFloat(EU::SIMD::shiftRight<23>(bits) - I::set1(127));
+   V m = EU::SIMD::asFloat((bits & I::set1(0x007fffff)) | I::set1(0x3f800000));
+   const V high = m > V::set1(1.41421356f);
+   e = e + (high & one);
+   const V u = EU::SIMD::select(high, m * V::set1(0.5f), m) - one;
+   V p = EU::SIMD::madd(u, V::set1(GAMMA_LOG2_C6), V::set1(GAMMA_LOG2_C5));
+   p = EU::SIMD::madd(u, p, V::set1(GAMMA_LOG2_C4));
+   p = EU::SIMD::madd(u, p, V::set1(GAMMA_LOG2_C3));
+   p = EU::SIMD::madd(u, p, V::set1(GAMMA_LOG2_C2));
+   p = EU::SIMD::madd(u, p, V::set1(GAMMA_LOG2_C1));
+   p = EU::SIMD::madd(u, p, V::set1(GAMMA_LOG2_C0));
+   const V power = EngineMath::batch::kernels::exp2(EU::SIMD::madd(u, p, e) * V::set1(exponent));
+   return power & (x > V::set1(1.17549435e-38f));
+  }
+
+  template<typename V>
+  inline V
+   srgbToLinearLanes(V c) {
+   const V power = gammaPowLanes(EU::SIMD::madd(c, V::set1(1.f / SRGB_SCALE), V::set1(SRGB_OFFSET / SRGB_SCALE)), SRGB_GAMMA);
+   return EU::SIMD::select(c <= V::set1(SRGB_TOE_ENCODED), c * V::set1(1.f / SRGB_TOE_SLOPE), power);
+  }
+
+  template<typename V>
+  inline V
+   linearToSrgbLanes(V c) {
+   const V power = EU::SIMD::msub(gammaPowLanes(c, 1.f / SRGB_GAMMA), V::set1(SRGB_SCALE), V::set1(SRGB_OFFSET));
+   return EU::SIMD::select(c <= V::set1(SRGB_TOE_LINEAR), c * V::set1(SRGB_TOE_SLOPE), power);
+  }
+
+  /** Hue in turns, saturation and value of (r, g, b); grey gives hue 0. */
+  template<typename V>
+  inline void
+   rgbToHsvLanes(V r, V g, V b, V& h, V& s, V& v) {
+   const V hi = EU::SIMD::max(r, EU::SIMD::max(g, b));
+   const V delta = hi - EU::SIMD::min(r, EU::SIMD::min(g, b));
+   const V zero = V::zero();
+   const V inv = EU::SIMD::select(delta > zero, V::set1(1.f) / delta, zero);
+   const V sector = EU::SIMD::select(hi == r, (g - b) * inv,
+                                     EU::SIMD::select(hi == g, EU::SIMD::madd(b - r, inv, V::set1(2.f)),
+                                                      EU::SIMD::madd(r - g, inv, V::set1(4.f))));
+   h = sector * V::set1(1.f / 6.f);
+   h = EU::SIMD::select(h < zero, h + V::set1(1.f), h);
+   s = EU::SIMD::select(hi > zero, delta / hi, zero);
+   v = hi;
+  }
+
+  /** Channel n (5 = red, 3 = green, 1 = blue) of hsv: v - v s clamp(min(k, 4 - k), 0, 1), k = (n + 6 h) mod 6. */
+  template<typename V>
+  inline V
+   hsvChannelLanes(float n, V h, V s, V v) {
+   const V t = EU::SIMD::madd(h, V::set1(6.f), V::set1(n));
+   const V k = t - V::set1(6.f) * EU::SIMD::floor(t * V::set1(1.f / 6.f));
+   const V ramp = EU::SIMD::min(EU::SIMD::max(EU::SIMD::min(k, V::set1(4.f) - k), V::zero()), V::set1(1.f));
+   return v - v * s * ramp;
+  }
+
+  template<typename V>
+  inline V
+   tonemapLanes(V x, Tonemap mode, float white) {
+   const V one = V::set1(1.f);
+   x = EU::SIMD::max(x, V::zero());
+   switch (mode) {
+   case Tonemap::Reinhard:
+    return x / (one + x);
+   case Tonemap::ReinhardExtended:
+    return x * EU::SIMD::madd(x, V::set1(1.f / (white * white)), one) / (one + x);
+   case Tonemap::ACES:
+   default:
+    break;
+   }
+   const V numerator = x * EU::SIMD::madd(x, V::set1(ACES_A), V::set1(ACES_B));
+   const V denominator = EU::SIMD::madd(x, EU::SIMD::madd(x, V::set1(ACES_C), V::set1(ACES_D)), V::set1(ACES_E));
+   return EU::SIMD::min(numerator / denominator, one);
+  }
+
+  /** out = fn applied to each channel of every packet of an AoS or SoA color array. */
+  template<typename In, typename Out, typename Fn>
+  inline void
+   mapChannels(In in, Out out, size_t n, Fn fn) {
+   forEachPacket3(in, n, [&](size_t i, size_t count, BatchLanes r, BatchLanes g, BatchLanes b) {
+    storePacket3(out, i, count, fn(r), fn(g), fn(b));
+   });
+  }
+
+  template<typename In, typename Out>
+  inline void
+   rgbToHsvArray(In in, Out out, size_t n) {
+   forEachPacket3(in, n, [&](size_t i, size_t count, BatchLanes r, BatchLanes g, BatchLanes b) {
+    BatchLanes h, s, v;
+    rgbToHsvLanes(r, g, b, h, s, v);
+    storePacket3(out, i, count, h, s, v);
+   });
+  }
+
+  template<typename In, typename Out>
+  inline void
+   hsvToRgbArray(In in, Out out, size_t n) {
+   forEachPacket3(in, n, [&](size_t i, size_t count, BatchLanes h, BatchLanes s, BatchLanes v) {
+    storePacket3(out, i, count, hsvChannelLanes(5.f, h, s, v), hsvChannelLanes(3.f, h, s, v), hsvChannelLanes(1.f, h, s, v));
+   });
+  }
+
+  inline uint8_t
+   unorm8(float x) {
+   const float v = x * 255.f + 0.5f;
+   return static_cast<uint8_t>(v > 0.f ? (v < 255.f ? v : 255.f) : 0.f);
+  }
+ }
+
+ /** @brief Decodes one sRGB channel in [0, 1] to linear, exactly (the piecewise IEC curve). */
+ inline float
+  srgbToLinear(float c) {
+  return c <= detail::SRGB_TOE_ENCODED ? c / detail::SRGB_TOE_SLOPE
+                                       : EngineMath::pow((c + detail::SRGB_OFFSET) / detail::SRGB_SCALE, detail::SRGB_GAMMA);
+ }
+
+ /** @brief Encodes one linear channel to sRGB. */
+ inline float
+  linearToSrgb(float c) {
+  return c <= detail::SRGB_TOE_LINEAR ? c * detail::SRGB_TOE_SLOPE
+                                      : detail::SRGB_SCALE * EngineMath::pow(c, 1.f / detail::SRGB_GAMMA) - detail::SRGB_OFFSET;
+ }
+
+ inline CVector3
+  srgbToLinear(const CVector3& c) {
+  return CVector3(srgbToLinear(c.x), srgbToLinear(c.y), srgbToLinear(c.z));
+ }
+
+ inline CVector3
+  linearToSrgb(const CVector3& c) {
+  return CVector3(linearToSrgb(c.x), linearToSrgb(c.y), linearToSrgb(c.z));
+ }
+
+ inline CVector4
+  srgbToLinear(const CVector4& c) {
+  return CVector4(srgbToLinear(c.x), srgbToLinear(c.y), srgbToLinear(c.z), c.w);
+ }
+
+ inline CVector4
+  linearToSrgb(const CVector4& c) {
+  return CVector4(linearToSrgb(c.x), linearToSrgb(c.y), linearToSrgb(c.z), c.w);
+ }
+
+ /** @brief Linear value of an 8-bit sRGB code, from the decode table. */
+ inline float
+  srgb8ToLinear(uint8_t code) {
+  return detail::srgbTables().decode[code];
+ }
+
+ /** @brief Correctly rounded 8-bit sRGB code of a linear value; clamps to [0, 255], NaN gives 0. */
+ inline uint8_t
+  linearToSrgb8(float x) {
+  if (!(x >= 1.f / 8192.f)) return 0;
+  if (x >= 1.f) return 255;
+  uint32_t bits;
+  std::memcpy(&bits, &x, 4);
+  const uint32_t bucket = (bits - detail::SRGB_TABLE_MIN_BITS) >> (23 - detail::SRGB_BUCKET_BITS);
+  const detail::SrgbTables& tables = detail::srgbTables();
+  return static_cast<uint8_t>(tables.base[bucket] + (x >= tables.threshold[bucket] ? 1 : 0));
+ }
+
+ /** @brief Hue (turns, [0, 1)), saturation and value of an RGB color. */
+ inline CVector3
+  rgbToHsv(const CVector3& c) {
+  const float hi = c.x > c.y ? (c.x > c.z ? c.x : c.z) : (c.y > c.z ? c.y : c.z);
+  const float lo = c.x < c.y ? (c.x < c.z ? c.x : c.z) : (c.y < c.z ? c.y : c.z);
+  const float delta = hi - lo;
+  const float inv = delta > 0.f ? 1.f / delta : 0.f;
+  float h = hi == c.x ? (c.y - c.z) * inv : (hi == c.y ? (c.z - c.x) * inv + 2.f : (c.x - c.y) * inv + 4.f);
+  h *= 1.f / 6.f;
+  if (h < 0.f) h += 1.f;
+  return CVector3(h, hi > 0.f ? delta / hi : 0.f, hi);
+ }
+
+ /** @brief RGB of a (hue in turns, saturation, value) triple; hue wraps. */
+ inline CVector3
+  hsvToRgb(const CVector3& hsv) {
+  auto channel = [&](float n) {
+   const float t = n + hsv.x * 6.f;
+   const float k = t - 6.f * std::floor(t * (1.f / 6.f));
+   float ramp = k < 4.f - k ? k : 4.f - k;
+   ramp = ramp < 0.f ? 0.f : (ramp > 1.f ? 1.f : ramp);
+   return hsv.z - hsv.z * hsv.y * ramp;
+  };
+  return CVector3(channel(5.f), channel(3.f), channel(1.f));
+ }
+
+ inline CVector4
+  rgbToHsv(const CVector4& c) {
+  const CVector3 hsv = rgbToHsv(CVector3(c.x, c.y, c.z));
+  return CVector4(hsv.x, hsv.y, hsv.z, c.w);
+ }
+
+ inline CVector4
+  hsvToRgb(const CVector4& hsv) {
+  const CVector3 rgb = hsvToRgb(CVector3(hsv.x, hsv.y, hsv.z));
+  return CVector4(rgb.x, rgb.y, rgb.z, hsv.w);
+ }
+
+ /** @brief Tonemaps one linear channel after scaling by exposure; white is the ReinhardExtended white point. */
+ inline float
+  tonemap(float x, Tonemap mode, float exposure = 1.f, float white = 4.f) {
+  x *= exposure;
+  x = x > 0.f ? x : 0.f;
+  switch (mode) {
+  case Tonemap::Reinhard:
+   return x / (1.f + x);
+  case Tonemap::ReinhardExtended:
+   return x * (1.f + x / (white * white)) / (1.f + x);
+  case Tonemap::ACES:
+  default:
+   break;
+  }
+  const float y = x * (detail::ACES_A * x + detail::ACES_B) / (x * (detail::ACES_C * x + detail::ACES_D) + detail::ACES_E);
+  return y < 1.f ? y : 1.f;
+ }
+
+ inline CVector3
+  tonemap(const CVector3& c, Tonemap mode, float exposure = 1.f, float white = 4.f) {
+  return CVector3(tonemap(c.x, mode, exposure, white), tonemap(c.y, mode, exposure, white), tonemap(c.z, mode, exposure, white));
+ }
+
+ inline CVector4
+  tonemap(const CVector4& c, Tonemap mode, float exposure = 1.f, float white = 4.f) {
+  return CVector4(tonemap(c.x, mode, exposure, white), tonemap(c.y, mode, exposure, white), tonemap(c.z, mode, exposure, white), c.w);
+ }
+
+ /** @brief out[i] = srgbToLinear(in[i]) a register at a time; out may alias in. */
+ inline void
+  srgbToLinearArray(const CVector3* in, CVector3* out, size_t n) {
+  detail::mapChannels(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n,
+                      [](detail::BatchLanes c) { return detail::srgbToLinearLanes(c); });
+ }
+
+ /** @brief SoA srgbToLinearArray(), e.g. over Vector3Stream::soa(). */
+ inline void
+  srgbToLinearArray(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n) {
+  detail::mapChannels(in, out, n, [](detail::BatchLanes c) { return detail::srgbToLinearLanes(c); });
+ }
+
+ /** @brief out[i] = linearToSrgb(in[i]) a register at a time; out may alias in. */
+ inline void
+  linearToSrgbArray(const CVector3* in, CVector3* out, size_t n) {
+  detail::mapChannels(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n,
+                      [](detail::BatchLanes c) { return detail::linearToSrgbLanes(c); });
+ }
+
+ /** @brief SoA linearToSrgbArray(). */
+ inline void
+  linearToSrgbArray(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n) {
+  detail::mapChannels(in, out, n, [](detail::BatchLanes c) { return detail::linearToSrgbLanes(c); });
+ }
+
+ /** @brief out[i] = rgbToHsv(in[i]); out may alias in. */
+ inline void
+  rgbToHsvArray(const CVector3* in, CVector3* out, size_t n) {
+  detail::rgbToHsvArray(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n);
+ }
+
+ /** @brief SoA rgbToHsvArray(). */
+ inline void
+  rgbToHsvArray(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n) {
+  detail::rgbToHsvArray(in, out, n);
+ }
+
+ /** @brief out[i] = hsvToRgb(in[i]); out may alias in. */
+ inline void
+  hsvToRgbArray(const CVector3* in, CVector3* out, size_t n) {
+  detail::hsvToRgbArray(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n);
+ }
+
+ /** @brief SoA hsvToRgbArray(). */
+ inline void
+  hsvToRgbArray(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n) {
+  detail::hsvToRgbArray(in, out, n);
+ }
+
+ /** @brief out[i] = tonemap(in[i], mode, exposure, white); out may alias in. */
+ inline void
+  tonemapArray(const CVector3* in, CVector3* out, size_t n, Tonemap mode, float exposure = 1.f, float white = 4.f) {
+  const detail::BatchLanes scale = detail::BatchLanes::set1(exposure);
+  detail::mapChannels(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n,
+                      [&](detail::BatchLanes c) { return detail::tonemapLanes(c * scale, mode, white); });
+ }
+
+ /** @brief SoA tonemapArray(). */
+ inline void
+  tonemapArray(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n, Tonemap mode, float exposure = 1.f,
+               float white = 4.f) {
+  const detail::BatchLanes scale = detail::BatchLanes::set1(exposure);
+  detail::mapChannels(in, out, n, [&](detail::BatchLanes c) { return detail::tonemapLanes(c * scale, mode, white); });
+ }
+
+ /**
+  * @brief Packs n colors to RGBA8 (four bytes per color, R first). RGB is encoded as asked,
+  * correctly rounded; alpha is always linear.
+  */
+ inline void
+  packColors(const CVector4* in, uint8_t* rgba, size_t n, ColorEncoding encoding) {
+  if (encoding == ColorEncoding::SRGB) {
+   for (size_t i = 0; i < n; ++i, rgba += 4) {
+    rgba[0] = linearToSrgb8(in[i].x);
+    rgba[1] = linearToSrgb8(in[i].y);
+    rgba[2] = linearToSrgb8(in[i].z);
+    rgba[3] = detail::unorm8(in[i].w);
+   }
+   return;
+  }
+  // Linear: one color's four channels per register.
+  using EU::SIMD::Float4;
+  const Float4 scale = Float4::set1(255.f), half = Float4::set1(0.5f);
+  for (size_t i = 0; i < n; ++i) {
+   EU::SIMD::storeBytes(EU::SIMD::truncToInt(EU::SIMD::madd(Float4::load(&in[i].x), scale, half)), rgba + 4 * i);
+  }
+ }
+
+ /** @brief Unpacks n RGBA8 colors, decoding RGB as asked; alpha is code / 255. */
+ inline void
+  unpackColors(const uint8_t* rgba, CVector4* out, size_t n, ColorEncoding encoding) {
+  if (encoding == ColorEncoding::SRGB) {
+   const float* decode = detail::srgbTables().decode;
+   for (size_t i = 0; i < n; ++i, rgba += 4) {
+    out[i] = CVector4(decode[rgba[0]], decode[rgba[1]], decode[rgba[2]], rgba[3] * (1.f / 255.f));
+   }
+   return;
+  }
+  float* f = reinterpret_cast<float*>(out);
+  const EU::SIMD::Float4 scale = EU::SIMD::Float4::set1(1.f / 255.f);
+  for (size_t i = 0; i < 4 * n; i += 4) (EU::SIMD::loadBytes(rgba + i) * scale).store(f + i);
+ }
+}
@@ -0,0 +1,701 @@
+/**
+ * @file GpuCompute.h
+ * @brief Optional OpenGL compute backend for the batch point transform, linear-blend
+ * skinning and sphere culling, on SoA buffers that stay resident on the GPU.
+ *
+ * GpuCompute loads the GL 4.3 compute and shader storage entry points through
+ * sf::Context::getFunction() and compiles one small program per kernel. Without them (an
+ * older context, or GLES) available() is false and nothing else may be called. GpuStream
+ * holds n points as three float blocks, x then y then z, in one shader storage buffer, the
+ * layout of a Vector3Stream, and GpuBuffer any other array; both are uploaded once and then
+ * fed from one kernel to the next without coming back to the CPU.
+ *
+ * The kernels compute what their CPU counterparts do: transformPoints() and skinPositions()
+ * the affine transform and palette blend of VectorTransform.h and Skinning.h, cullSpheres()
+ * the test of Frustum.h. Culling compacts on the GPU: one pass counts the visible spheres of
+ * each workgroup, one scans the counts and one writes each visible index at its offset, so
+ * only the count and the ascending index list are read back, the same list the CPU returns.
+ * Results agree with the CPU to rounding: GLSL may contract to FMA.
+ *
+ * BatchOffload puts both behind the CPU API, arrays in host memory, and picks the GPU only at
+ * and above a workload size where the upload and readback pay for themselves:
+ *
+ *   GpuCompute gpu;                               // with a GL 4.3 context active
+ *   BatchOffload batch(gpu.available() ? &gpu : nullptr);
+ *   batch.transformPoints(in.soa(), out.soa(), n, matrix);
+ *   size_t visible = batch.cullSpheres(frustum, centers, radii, n, indices);
+ *
+ * Calls must be made on a thread with a context active that shares with the one GpuCompute
+ * was created in; the current program and the shader storage bindings 0 to 4 are restored
+ * or reset on return. Needs sfml-window at link time.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+#include <SFML/Window/Context.hpp>
+#include <SFML/Window/GlResource.hpp>
+#include <Core/Trace.h>
+#include <Geometry/Frustum.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/Matrix4x4.h>
+#include <Matrices/Skinning.h>
+#include <Vectors/VectorTransform.h>
+
+#ifndef EU_GL_APIENTRY
+ #if defined(_WIN32) && !defined(_WIN64)
+  #define EU_GL_APIENTRY __stdcall
+ #else
+  #define EU_GL_APIENTRY
+ #endif
+#endif
+
+namespace EU {
+ /// Points per compute workgroup; the GLSL sources are written for this size.
+ constexpr size_t GPU_WORKGROUP = 256;
+ /// BatchOffload sends work of at least this many elements to the GPU by default.
+ constexpr size_t GPU_OFFLOAD_MIN = 1 << 18;
+
+ static_assert(sizeof(BoneInfluences) == 6 * sizeof(uint32_t), "BoneInfluences must be four floats and four uint16");
+ static_assert(sizeof(Affine3x4) == 12 * sizeof(float), "Affine3x4 must be three packed rows");
+
+ namespace detail {
+  constexpr unsigned GL_COMPUTE_SHADER = 0x91B9;
+  constexpr unsigned GL_SHADER_STORAGE_BUFFER = 0x90D2;
+  constexpr unsigned GL_COMPILE_STATUS = 0x8B81;
+  constexpr unsigned GL_LINK_STATUS = 0x8B82;
+  constexpr unsigned GL_DYNAMIC_COPY = 0x88EA;
+  constexpr unsigned GL_COMPUTE_CURRENT_PROGRAM = 0x8B8D;
+  constexpr unsigned GL_SHADER_STORAGE_BARRIER_BIT = 0x2000;
+  constexpr unsigned GL_BUFFER_UPDATE_BARRIER_BIT = 0x0200;
+  /// Workgroups per glDispatchCompute(); larger jobs are cut into several dispatches.
+  constexpr size_t GPU_MAX_GROUPS = 65535;
+
+  /** The GL 4.3 entry points the compute kernels use. */
+  struct GlComputeFunctions {
+   using CreateShader = unsigned (EU_GL_APIENTRY*)(unsigned);
+   using ShaderSource = void (EU_GL_APIENTRY*)(unsigned, int, const char* const*, const int*);
+   using Handle = void (EU_GL_APIENTRY*)(unsigned);
+   using GetObjectiv = void (EU_GL_APIENTRY*)(unsigned, unsigned, int*);
+   using CreateProgram = unsigned (EU_GL_APIENTRY*)();
+   using AttachShader = void (EU_GL_APIENTRY*)(unsigned, unsigned);
+   using GetUniformLocation = int (EU_GL_APIENTRY*)(unsigned, const char*);
+   using Uniform1ui = void (EU_GL_APIENTRY*)(int, unsigned);
+   using Uniform4fv = void (EU_GL_APIENTRY*)(int, int, const float*);
+   using GetIntegerv = void (EU_GL_APIENTRY*)(unsigned, int*);
+   using Buffers = void (EU_GL_APIENTRY*)(int, unsigned*);
+   using DeleteBuffers = void (EU_GL_APIENTRY*)(int, const unsigned*);
+   using BindBuffer = void (EU_GL_APIENTRY*)(unsigned, unsigned);
+   using BindBufferBase = void (EU_GL_APIENTRY*)(unsigned, unsigned, unsigned);
+   using BufferData = void (EU_GL_APIENTRY*)(unsigned, ptrdiff_t, const void*, unsigned);
+   using BufferSubData = void (EU_GL_APIENTRY*)(unsigned, ptrdiff_t, ptrdiff_t, const void*);
+   using GetBufferSubData = void (EU_GL_APIENTRY*)(unsigned, ptrdiff_t, ptrdiff_t, void*);
+   using DispatchCompute = void (EU_GL_APIENTRY*)(unsigned, unsigned, unsigned);
+   using MemoryBarrier = void (EU_GL_APIENTRY*)(unsigned);
+
+   CreateShader createShader = nullptr;
+   ShaderSource shaderSource = nullptr;
+   Handle compileShader = nullptr;
+   GetObjectiv getShaderiv = nullptr;
+   Handle deleteShader = nullptr;
+   CreateProgram createProgram = nullptr;
+   AttachShader attachShader = nullptr;
+   Handle linkProgram = nullptr;
+   GetObjectiv getProgramiv = nullptr;
+   Handle deleteProgram = nullptr;
+   Handle useProgram = nullptr;
+   GetUniformLocation getUniformLocation = nullptr;
+   Uniform1ui uniform1ui = nullptr;
+   Uniform4fv uniform4fv = nullptr;
+   GetIntegerv getIntegerv = nullptr;
+   Buffers genBuffers = nullptr;
+   DeleteBuffers deleteBuffers = nullptr;
+   BindBuffer bindBuffer = nullptr;
+   BindBufferBase bindBufferBase = nullptr;
+   BufferData bufferData = nullptr;
+   BufferSubData bufferSubData = nullptr;
+   GetBufferSubData getBufferSubData = nullptr;
+   DispatchCompute dispatchCompute = nullptr;
+   MemoryBarrier memoryBarrier = nullptr;
+
+   /** Loads the entry points from the active context; false if any is missing. */
+   bool
+    load() {
+    return get(createShader, "glCreateShader") && get(shaderSource, "glShaderSource") &&
+           get(compileShader, "glCompileShader") && get(getShaderiv, "glGetShaderiv") &&
+           get(deleteShader, "glDeleteShader") && get(createProgram, "glCreateProgram") &&
+           get(attachShader, "glAttachShader") && get(linkProgram, "glLinkProgram") &&
+           get(getProgramiv, "glGetProgramiv") && get(deleteProgram, "glDeleteProgram") &&
+           get(useProgram, "glUseProgram") && get(getUniformLocation, "glGetUniformLocation") &&
+           get(uniform1ui, "glUniform1ui") && get(uniform4fv, "glUniform4fv") &&
+           get(getIntegerv, "glGetIntegerv") && get(genBuffers, "glGenBuffers") &&
+           get(deleteBuffers, "glDeleteBuffers") && get(bindBuffer, "glBindBuffer") &&
+           get(bindBufferBase, "glBindBufferBase") && get(bufferData, "glBufferData") &&
+           get(bufferSubData, "glBufferSubData") && get(getBufferSubData, "glGetBufferSubData") &&
+           get(dispatchCompute, "glDispatchCompute") && get(memoryBarrier, "glMemoryBarrier");
+   }
+
+   private:
+   template<typename Fn>
+   static bool
+    get(Fn& fn, const char* name) {
+    fn = reinterpret_cast<Fn>(sf::Context::getFunction(name));
+    return fn != nullptr;
+   }
+  };
+
+  // Every kernel covers points [first, first + 256 * groups) of one dispatch; i indexes the
+  // SoA blocks, which lie stride floats apart.
+  constexpr const char* GPU_TRANSFORM_SOURCE = R"(#version 430
+layout(local_size_x = 256) in;
+layout(std430, binding = 0) readonly buffer Source { float src[]; };
+layout(std430, binding = 1) writeonly buffer Target { float dst[]; };
+uniform uint first;
+uniform uint count;
+uniform uint inStride;
+uniform uint outStride;
+uniform vec4 rows[3];
+void main() {
+ uint i = first + gl_GlobalInvocationID.x;
+ if (i >= count) return;
+ vec4 p = vec4(src[i], src[i + inStride], src[i + 2u * inStride], 1.0);
+ dst[i] = dot(rows[0], p);
+ dst[i + outStride] = dot(rows[1], p);
+ dst[i + 2u * outStride] = dot(rows[2], p);
+}
+)";
+
+  // BoneInfluences as six words: four float weights, then two pairs of 16-bit joints.
+  constexpr const char* GPU_SKIN_SOURCE = R"(#version 430
+layout(local_size_x = 256) in;
+layout(std430, binding = 0) readonly buffer Source { float src[]; };
+layout(std430, binding = 1) writeonly buffer Target { float dst[]; };
+layout(std430, binding = 2) readonly buffer Influences { uint influences[]; };
+layout(std430, binding = 3) readonly buffer Palette { vec4 palette[]; };
+uniform uint first;
+uniform uint count;
+uniform uint inStride;
+uniform uint outStride;
+void main() {
+ uint i = first + gl_GlobalInvocationID.x;
+ if (i >= count) return;
+ uint b = 6u * i;
+ vec4 w = uintBitsToFloat(uvec4(influences[b], influences[b + 1u], influences[b + 2u], influences[b + 3u]));
+ uint j01 = influences[b + 4u];
+ uint j23 = influences[b + 5u];
+ uvec4 j = 3u * uvec4(j01 & 0xffffu, j01 >> 16, j23 & 0xffffu, j23 >> 16);
+ vec4 r0 = w.x * palette[j.x] + w.y * palette[j.y] + w.z * palette[j.z] + w.w * palette[j.w];
+ vec4 r1 = w.x * palette[j.x + 1u] + w.y * palette[j.y + 1u] + w.z * palette[j.z + 1u] + w.w * palette[j.w + 1u];
+ vec4 r2 = w.x * palette[j.x + 2u] + w.y * palette[j.y + 2u] + w.z * palette[j.z + 2u] + w.w * palette[j.w + 2u];
+ vec4 p = vec4(src[i], src[i + inStride], src[i + 2u * inStride], 1.0);
+ dst[i] = dot(r0, p);
+ dst[i + outStride] = dot(r1, p);
+ dst[i + 2u * outStride] = dot(r2, p);
+}
+)";
+
+  // Prefix of the count and scatter passes of cullSpheres().
+  constexpr const char* GPU_CULL_COMMON_SOURCE = R"(#version 430
+layout(local_size_x = 256) in;
+layout(std430, binding = 0) readonly buffer Centers { float centers[]; };
+layout(std430, binding = 2) readonly buffer Radii { float radii[]; };
+layout(std430, binding = 3) buffer Offsets { uint offsets[]; };
+layout(std430, binding = 4) writeonly buffer Visible { uint visible[]; };
+uniform uint first;
+uniform uint count;
+uniform uint inStride;
+uniform vec4 planes[6];
+bool inside(uint i) {
+ if (i >= count) return false;
+ vec3 c = vec3(centers[i], centers[i + inStride], centers[i + 2u * inStride]);
+ float r = -radii[i];
+ bool v = true;
+ for (int p = 0; p < 6; ++p) v = v && dot(planes[p].xyz, c) + planes[p].w >= r;
+ return v;
+}
+shared uint scan[256];
+// Inclusive prefix sum of flag over the workgroup; returns the group total.
+uint groupScan(uint flag) {
+ uint l = gl_LocalInvocationID.x;
+ scan[l] = flag;
+ barrier();
+ for (uint d = 1u; d < 256u; d <<= 1) {
+  uint add = l >= d ? scan[l - d] : 0u;
+  barrier();
+  scan[l] += add;
+  barrier();
+ }
+ return scan[255];
+}
+)";
+
+  constexpr const char* GPU_CULL_COUNT_SOURCE = R"(
+void main() {
+ uint group = first / 256u + gl_WorkGroupID.x;
+ uint total = groupScan(inside(first + gl_GlobalInvocationID.x) ? 1u : 0u);
+ if (gl_LocalInvocationID.x == 0u) offsets[group] = total;
+}
+)";
+
+  constexpr const char* GPU_CULL_SCATTER_SOURCE = R"(
+void main() {
+ uint i = first + gl_GlobalInvocationID.x;
+ uint group = first / 256u + gl_WorkGroupID.x;
+ bool v = inside(i);
+ groupScan(v ? 1u : 0u);
+ if (v) visible[offsets[group] + scan[gl_LocalInvocationID.x] - 1u] = i;
+}
+)";
+
+  // One workgroup turns the group counts into exclusive offsets, total in offsets[count].
+  constexpr const char* GPU_CULL_SCAN_SOURCE = R"(#version 430
+layout(local_size_x = 256) in;
+layout(std430, binding = 3) buffer Offsets { uint offsets[]; };
+uniform uint count;
+shared uint scan[256];
+void main() {
+ uint l = gl_LocalInvocationID.x;
+ uint per = (count + 255u) / 256u;
+ uint begin = min(l * per, count);
+ uint end = min(begin + per, count);
+ uint sum = 0u;
+ for (uint g = begin; g < end; ++g) sum += offsets[g];
+ scan[l] = sum;
+ barrier();
+ for (uint d = 1u; d < 256u; d <<= 1) {
+  uint add = l >= d ? scan[l - d] : 0u;
+  barrier();
+  scan[l] += add;
+  barrier();
+ }
+ uint running = scan[l] - sum;
+ for (uint g = begin; g < end; ++g) {
+  uint c = offsets[g];
+  offsets[g] = running;
+  running += c;
+ }
+ if (l == 255u) offsets[count] = scan[255];
+}
+)";
+ }
+
+ class GpuCompute;
+
+ /**
+  * @class GpuBuffer
+  * @brief One shader storage buffer; growing it discards its contents.
+  */
+ class
+  GpuBuffer {
+  public:
+  explicit GpuBuffer(const GpuCompute& gpu);
+  ~GpuBuffer();
+
+  GpuBuffer(const GpuBuffer&) = delete;
+  GpuBuffer& operator=(const GpuBuffer&) = delete;
+
+  /** @brief Makes room for bytes; the contents are undefined after a reallocation. */
+  void
+   reserve(size_t bytes);
+
+  /** @brief Copies bytes from data to offset, growing the buffer first if needed. */
+  void
+   upload(const void* data, size_t bytes, size_t offset = 0);
+
+  /** @brief Reads bytes at offset back into data, after the pending kernels have written them. */
+  void
+   download(void* data, size_t bytes, size_t offset = 0) const;
+
+  /** @brief Uploads n elements of T, e.g. BoneInfluences or Affine3x4. */
+  template<typename T>
+  void
+   assign(const T* values, size_t n) {
+   upload(values, n * sizeof(T));
+  }
+
+  unsigned
+   handle() const {
+   return m_handle;
+  }
+
+  size_t
+   capacity() const {
+   return m_capacity;
+  }
+
+  private:
+  const detail::GlComputeFunctions& m_gl;
+  unsigned m_handle;
+  size_t m_capacity;
+ };
+
+ /**
+  * @class GpuStream
+  * @brief n points on the GPU as x, y and z float blocks, capacity() floats apart.
+  */
+ class
+  GpuStream {
+  public:
+  explicit GpuStream(const GpuCompute& gpu) : m_buffer(gpu), m_size(0), m_capacity(0) {}
+
+  /** @brief Sets the point count; growing past capacity() discards the contents. */
+  void
+   resize(size_t n) {
+   if (n > m_capacity) {
+    m_capacity = (n + GPU_WORKGROUP - 1) / GPU_WORKGROUP * GPU_WORKGROUP;
+    m_buffer.reserve(3 * m_capacity * sizeof(float));
+   }
+   m_size = n;
+  }
+
+  /** @brief Uploads n points, resizing to n. */
+  void
+   upload(EngineMath::batch::ConstSoA3 points, size_t n) {
+   resize(n);
+   m_buffer.upload(points.x, n * sizeof(float), 0);
+   m_buffer.upload(points.y, n * sizeof(float), m_capacity * sizeof(float));
+   m_buffer.upload(points.z, n * sizeof(float), 2 * m_capacity * sizeof(float));
+  }
+
+  /** @brief Reads the first n points (at most size()) back. */
+  void
+   download(EngineMath::batch::SoA3 points, size_t n) const {
+   n = n < m_size ? n : m_size;
+   m_buffer.download(points.x, n * sizeof(float), 0);
+   m_buffer.download(points.y, n * sizeof(float), m_capacity * sizeof(float));
+   m_buffer.download(points.z, n * sizeof(float), 2 * m_capacity * sizeof(float));
+  }
+
+  size_t
+   size() const {
+   return m_size;
+  }
+
+  /** @brief Floats between the x, y and z blocks. */
+  size_t
+   capacity() const {
+   return m_capacity;
+  }
+
+  const GpuBuffer&
+   buffer() const {
+   return m_buffer;
+  }
+
+  private:
+  GpuBuffer m_buffer;
+  size_t m_size;
+  size_t m_capacity;
+ };
+
+ /**
+  * @class GpuCompute
+  * @brief Compute programs of the batch kernels; see the file comment.
+  */
+ class
+  GpuCompute : sf::GlResource {
+  public:
+  /** @brief Loads GL and compiles the kernels in the active context; check available(). */
+  GpuCompute() : m_available(false), m_programs{} {
+   m_available = m_gl.load() && compile();
+  }
+
+  ~GpuCompute() {
+   m_scratch.reset();
+   if (!m_gl.deleteProgram) return;
+   for (Program& program : m_programs) {
+    if (program.handle) m_gl.deleteProgram(program.handle);
+   }
+  }
+
+  GpuCompute(const GpuCompute&) = delete;
+  GpuCompute& operator=(const GpuCompute&) = delete;
+
+  /** @brief True when the context offers compute shaders and every kernel compiled. */
+  bool
+   available() const {
+   return m_available;
+  }
+
+  const detail::GlComputeFunctions&
+   functions() const {
+   return m_gl;
+  }
+
+  /** @brief out = matrix * in for the first n points, as EU::transformPoints() by an affine matrix; out may be in. */
+  void
+   transformPoints(const GpuStream& in, GpuStream& out, size_t n, const Matrix4x4& matrix) {
+   EU_TRACE_ZONE("GpuCompute::transformPoints");
+   n = in.size() < n ? in.size() : n;
+   out.resize(n);
+   const Program& program = m_programs[TRANSFORM];
+   Binding binding(m_gl, program.handle);
+   m_gl.uniform4fv(program.rows, 3, &matrix.m[0][0]);
+   bindStreams(program, in, out);
+   dispatch(program, n);
+  }
+
+  /** @brief out = skinned in for the first n points, as EU::skinPositions() with an Affine3x4 palette. */
+  void
+   skinPositions(const GpuStream& in, GpuStream& out, size_t n, const GpuBuffer& influences, const GpuBuffer& palette) {
+   EU_TRACE_ZONE("GpuCompute::skinPositions");
+   n = in.size() < n ? in.size() : n;
+   out.resize(n);
+   const Program& program = m_programs[SKIN];
+   Binding binding(m_gl, program.handle);
+   bindStreams(program, in, out);
+   m_gl.bindBufferBase(detail::GL_SHADER_STORAGE_BUFFER, 2, influences.handle());
+   m_gl.bindBufferBase(detail::GL_SHADER_STORAGE_BUFFER, 3, palette.handle());
+   dispatch(program, n);
+  }
+
+  /**
+   * @brief EU::cullSpheres() of the first n centers with radii (n floats): writes the visible
+   * indices, ascending, to visible, which needs room for n, and returns their count.
+   */
+  size_t
+   cullSpheres(const Frustum& frustum, const GpuStream& centers, const GpuBuffer& radii, size_t n, uint32_t* visible) {
+   EU_TRACE_ZONE("GpuCompute::cullSpheres");
+   n = centers.size() < n ? centers.size() : n;
+   if (n == 0) return 0;
+   if (!m_scratch) m_scratch.reset(new Scratch(*this));
+   const size_t groups = (n + GPU_WORKGROUP - 1) / GPU_WORKGROUP;
+   m_scratch->offsets.reserve((groups + 1) * sizeof(uint32_t));
+   m_scratch->visible.reserve(n * sizeof(uint32_t));
+
+   int previous = 0;
+   m_gl.getIntegerv(detail::GL_COMPUTE_CURRENT_PROGRAM, &previous);
+   m_gl.bindBufferBase(detail::GL_SHADER_STORAGE_BUFFER, 0, centers.buffer().handle());
+   m_gl.bindBufferBase(detail::GL_SHADER_STORAGE_BUFFER, 2, radii.handle());
+   m_gl.bindBufferBase(detail::GL_SHADER_STORAGE_BUFFER, 3, m_scratch->offsets.handle());
+   m_gl.bindBufferBase(detail::GL_SHADER_STORAGE_BUFFER, 4, m_scratch->visible.handle());
+   for (size_t pass : { CULL_COUNT, CULL_SCAN, CULL_SCATTER }) {
+    const Program& program = m_programs[pass];
+    m_gl.useProgram(program.handle);
+    if (pass == CULL_SCAN) {
+     m_gl.uniform1ui(program.count, static_cast<unsigned>(groups));
+     m_gl.dispatchCompute(1, 1, 1);
+    }
+    else {
+     m_gl.uniform4fv(program.planes, 6, &frustum.planes[0][0]);
+     m_gl.uniform1ui(program.inStride, static_cast<unsigned>(centers.capacity()));
+     dispatch(program, n);
+    }
+    m_gl.memoryBarrier(detail::GL_SHADER_STORAGE_BARRIER_BIT);
+   }
+   m_gl.useProgram(static_cast<unsigned>(previous));
+   unbind();
+
+   m_gl.memoryBarrier(detail::GL_BUFFER_UPDATE_BARRIER_BIT);
+   uint32_t total = 0;
+   m_scratch->offsets.download(&total, sizeof(total), groups * sizeof(uint32_t));
+   total = total < n ? total : static_cast<uint32_t>(n);
+   m_scratch->visible.download(visible, total * sizeof(uint32_t));
+   return total;
+  }
+
+  private:
+  enum Kernel { TRANSFORM, SKIN, CULL_COUNT, CULL_SCAN, CULL_SCATTER, KERNEL_COUNT };
+
+  struct Program {
+   unsigned handle;
+   int first, count, inStride, outStride, rows, planes;
+  };
+
+  /** Compacted culling results, allocated on first use. */
+  struct Scratch {
+   explicit Scratch(const GpuCompute& gpu) : offsets(gpu), visible(gpu) {}
+   GpuBuffer offsets;
+   GpuBuffer visible;
+  };
+
+  /** Binds a program for one kernel call and restores the previous one and the buffer bindings. */
+  struct Binding {
+   Binding(const detail::GlComputeFunctions& gl, unsigned program) : gl(gl), previous(0) {
+    gl.getIntegerv(detail::GL_COMPUTE_CURRENT_PROGRAM, &previous);
+    gl.useProgram(program);
+   }
+
+   ~Binding() {
+    gl.memoryBarrier(detail::GL_SHADER_STORAGE_BARRIER_BIT);
+    gl.useProgram(static_cast<unsigned>(previous));
+    for (unsigned b = 0; b < 4; ++b) gl.bindBufferBase(detail::GL_SHADER_STORAGE_BUFFER, b, 0);
+   }
+
+   const detail::GlComputeFunctions& gl;
+   int previous;
+  };
+
+  bool
+   compile() {
+   // Prefix and body of each kernel; GL concatenates them.
+   const char* const sources[KERNEL_COUNT][2] = { { "", detail::GPU_TRANSFORM_SOURCE },
+                                                  { "", detail::GPU_SKIN_SOURCE },
+                                                  { detail::GPU_CULL_COMMON_SOURCE, detail::GPU_CULL_COUNT_SOURCE },
+                                                  { "", detail::GPU_CULL_SCAN_SOURCE },
+                                                  { detail::GPU_CULL_COMMON_SOURCE, detail::GPU_CULL_SCATTER_SOURCE } };
+   for (size_t k = 0; k < KERNEL_COUNT; ++k) {
+    Program& program = m_programs[k];
+    const unsigned shader = m_gl.createShader(detail::GL_COMPUTE_SHADER);
+    if (!shader) return false;
+    m_gl.shaderSource(shader, 2, sources[k], nullptr);
+    m_gl.compileShader(shader);
+    int ok = 0;
+    m_gl.getShaderiv(shader, detail::GL_COMPILE_STATUS, &ok);
+    if (ok) {
+     program.handle = m_gl.createProgram();
+     m_gl.attachShader(program.handle, shader);
+     m_gl.linkProgram(program.handle);
+     m_gl.getProgramiv(program.handle, detail::GL_LINK_STATUS, &ok);
+    }
+    m_gl.deleteShader(shader);
+    if (!ok) return false;
+    program.first = m_gl.getUniformLocation(program.handle, "first");
+    program.count = m_gl.getUniformLocation(program.handle, "count");
+    program.inStride = m_gl.getUniformLocation(program.handle, "inStride");
+    program.outStride = m_gl.getUniformLocation(program.handle, "outStride");
+    program.rows = m_gl.getUniformLocation(program.handle, "rows");
+    program.planes = m_gl.getUniformLocation(program.handle, "planes");
+   }
+   return true;
+  }
+
+  void
+   bindStreams(const Program& program, const GpuStream& in, const GpuStream& out) const {
+   m_gl.uniform1ui(program.inStride, static_cast<unsigned>(in.capacity()));
+   m_gl.uniform1ui(program.outStride, static_cast<unsigned>(out.capacity()));
+   m_gl.bindBufferBase(detail::GL_SHADER_STORAGE_BUFFER, 0, in.buffer().handle());
+   m_gl.bindBufferBase(detail::GL_SHADER_STORAGE_BUFFER, 1, out.buffer().handle());
+  }
+
+  /** Runs the bound program over [0, n), in dispatches of at most GPU_MAX_GROUPS workgroups. */
+  void
+   dispatch(const Program& program, size_t n) const {
+   m_gl.uniform1ui(program.count, static_cast<unsigned>(n));
+   const size_t groups = (n + GPU_WORKGROUP - 1) / GPU_WORKGROUP;
+   for (size_t g = 0; g < groups; g += detail::GPU_MAX_GROUPS) {
+    const size_t batch = groups - g < detail::GPU_MAX_GROUPS ? groups - g : detail::GPU_MAX_GROUPS;
+    m_gl.uniform1ui(program.first, static_cast<unsigned>(g * GPU_WORKGROUP));
+    m_gl.dispatchCompute(static_cast<unsigned>(batch), 1, 1);
+   }
+  }
+
+  void
+   unbind() const {
+   for (unsigned b = 0; b <= 4; ++b) m_gl.bindBufferBase(detail::GL_SHADER_STORAGE_BUFFER, b, 0);
+  }
+
+  detail::GlComputeFunctions m_gl;
+  bool m_available;
+  Program m_programs[KERNEL_COUNT];
+  std::unique_ptr<Scratch> m_scratch;
+ };
+
+ inline GpuBuffer::GpuBuffer(const GpuCompute& gpu) : m_gl(gpu.functions()), m_handle(0), m_capacity(0) {}
+
+ inline GpuBuffer::~GpuBuffer() {
+  if (m_handle) m_gl.deleteBuffers(1, &m_handle);
+ }
+
+ inline void
+  GpuBuffer::reserve(size_t bytes) {
+  if (bytes <= m_capacity && m_handle) return;
+  if (!m_handle) m_gl.genBuffers(1, &m_handle);
+  m_gl.bindBuffer(detail::GL_SHADER_STORAGE_BUFFER, m_handle);
+  m_gl.bufferData(detail::GL_SHADER_STORAGE_BUFFER, static_cast<ptrdiff_t>(bytes ? bytes : 4), nullptr,
+                  detail::GL_DYNAMIC_COPY);
+  m_gl.bindBuffer(detail::GL_SHADER_STORAGE_BUFFER, 0);
+  m_capacity = bytes;
+ }
+
+ inline void
+  GpuBuffer::upload(const void* data, size_t bytes, size_t offset) {
+  if (offset + bytes > m_capacity) reserve(offset + bytes);
+  if (bytes == 0) return;
+  m_gl.bindBuffer(detail::GL_SHADER_STORAGE_BUFFER, m_handle);
+  m_gl.bufferSubData(detail::GL_SHADER_STORAGE_BUFFER, static_cast<ptrdiff_t>(offset), static_cast<ptrdiff_t>(bytes), data);
+  m_gl.bindBuffer(detail::GL_SHADER_STORAGE_BUFFER, 0);
+ }
+
+ inline void
+  GpuBuffer::download(void* data, size_t bytes, size_t offset) const {
+  if (bytes == 0 || offset + bytes > m_capacity) return;
+  m_gl.memoryBarrier(detail::GL_BUFFER_UPDATE_BARRIER_BIT);
+  m_gl.bindBuffer(detail::GL_SHADER_STORAGE_BUFFER, m_handle);
+  m_gl.getBufferSubData(detail::GL_SHADER_STORAGE_BUFFER, static_cast<ptrdiff_t>(offset), static_cast<ptrdiff_t>(bytes), data);
+  m_gl.bindBuffer(detail::GL_SHADER_STORAGE_BUFFER, 0);
+ }
+
+ /**
+  * @class BatchOffload
+  * @brief The CPU batch kernels' signatures, run on the GPU for large enough workloads.
+  *
+  * Below threshold elements, or with no GpuCompute, every call is the CPU function of the
+  * same name. Above it the inputs are uploaded into buffers kept between calls, the kernel
+  * runs and only its results are read back.
+  */
+ class
+  BatchOffload {
+  public:
+  explicit BatchOffload(GpuCompute* gpu = nullptr, size_t threshold = GPU_OFFLOAD_MIN)
+   : m_gpu(gpu && gpu->available() ? gpu : nullptr), m_threshold(threshold) {
+   if (m_gpu) m_buffers.reset(new Buffers(*m_gpu));
+  }
+
+  /** @brief True when work of n elements goes to the GPU. */
+  bool
+   usesGpu(size_t n) const {
+   return m_gpu != nullptr && n >= m_threshold;
+  }
+
+  /** @brief EU::transformPoints() by an affine Matrix4x4. */
+  void
+   transformPoints(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n, const Matrix4x4& matrix) {
+   if (!usesGpu(n)) return EU::transformPoints(in, out, n, matrix);
+   m_buffers->in.upload(in, n);
+   m_gpu->transformPoints(m_buffers->in, m_buffers->out, n, matrix);
+   m_buffers->out.download(out, n);
+  }
+
+  /** @brief EU::skinPositions() with an Affine3x4 palette of paletteSize bones. */
+  void
+   skinPositions(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n,
+                 const BoneInfluences* influences, const Affine3x4* palette, size_t paletteSize) {
+   if (!usesGpu(n)) return EU::skinPositions(in, out, n, influences, palette);
+   m_buffers->in.upload(in, n);
+   m_buffers->influences.assign(influences, n);
+   m_buffers->palette.assign(palette, paletteSize);
+   m_gpu->skinPositions(m_buffers->in, m_buffers->out, n, m_buffers->influences, m_buffers->palette);
+   m_buffers->out.download(out, n);
+  }
+
+  /** @brief EU::cullSpheres(); the GPU path reads back only the visible indices. */
+  size_t
+   cullSpheres(const Frustum& frustum, EngineMath::batch::ConstSoA3 centers, const float* radii, size_t n,
+               uint32_t* visible, size_t threads = 0) {
+   if (!usesGpu(n)) return EU::cullSpheres(frustum, centers, radii, n, visible, threads);
+   m_buffers->in.upload(centers, n);
+   m_buffers->radii.assign(radii, n);
+   return m_gpu->cullSpheres(frustum, m_buffers->in, m_buffers->radii, n, visible);
+  }
+
+  private:
+  struct Buffers {
+   explicit Buffers(const GpuCompute& gpu) : in(gpu), out(gpu), influences(gpu), palette(gpu), radii(gpu) {}
+   GpuStream in;
+   GpuStream out;
+   GpuBuffer influences;
+   GpuBuffer palette;
+   GpuBuffer radii;
+  };
+
+  GpuCompute* m_gpu;
+  size_t m_threshold;
+  std::unique_ptr<Buffers> m_buffers;
+ };
+}
@@ -0,0 +1,423 @@
+/**
+ * @file ImageKernels.h
+ * @brief CPU post-processing of RGBA8 pixel buffers (sf::Image::getPixelsPtr() layout): box
+ * and Gaussian blur, bilinear resize, alpha premultiplication and Matrix4x4 color transforms.
+ *
+ * Every kernel reads tightly packed RGBA8 rows, R first, and writes to a caller-owned buffer
+ * of the same layout, so an sf::Image is processed straight from its pixel pointer and loaded
+ * back with create(); nothing here goes through getPixel()/setPixel() or links SFML.
+ *
+ * The blurs are separable. The image is cut into IMAGE_TILE_WIDTH x IMAGE_TILE_HEIGHT tiles,
+ * one task each: a tile converts its rows plus a radius of clamped border pixels to float,
+ * runs the horizontal pass into a per-thread scratch that stays in L2, then the vertical pass
+ * over the scratch rows, and converts back with rounding. Both passes run a float register of
+ * interleaved channels at a time. The box blur keeps running sums, so its cost does not grow
+ * with the radius, and its sums are exact integers; the Gaussian is a normalized kernel of
+ * radius ceil(3 sigma). Borders clamp to the edge pixel. Resizing and the per-pixel kernels
+ * split by fixed row bands or pixel blocks, so results never depend on the thread count.
+ *
+ * premultiplyAlpha() and unpremultiplyAlpha() are exact integer kernels (round to nearest)
+ * that the compiler vectorizes: two channels per 32-bit multiply, and a reciprocal table
+ * instead of division. transformColors() treats RGB as a point in [0, 1]^3 and applies the
+ * matrix the way transformPoints() does, translation column included; alpha is kept.
+ *
+ *   std::vector<uint8_t> out(size_t(w) * h * 4);
+ *   gaussianBlur(image.getPixelsPtr(), out.data(), w, h, 2.f);
+ *   image.create(w, h, out.data());
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Core/Trace.h>
+#include <Matrices/Matrix4x4.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Pixels along x per blur tile.
+ constexpr uint32_t IMAGE_TILE_WIDTH = 128;
+ /// Rows per blur tile, and per resize task.
+ constexpr uint32_t IMAGE_TILE_HEIGHT = 64;
+ /// Largest blur radius; box sums stay exact in float up to it.
+ constexpr uint32_t IMAGE_MAX_RADIUS = 128;
+
+ namespace detail {
+  /// Pixels per task of the per-pixel kernels.
+  constexpr size_t IMAGE_PIXEL_BLOCK = 1 << 14;
+  /// Per-pixel batches smaller than this run on the calling thread.
+  constexpr size_t PARALLEL_IMAGE_MIN = 1 << 16;
+
+  /** Float scratch of the calling thread, reused across tiles and calls. */
+  inline std::vector<float>&
+   imageScratch() {
+   static thread_local std::vector<float> scratch;
+   return scratch;
+  }
+
+  inline uint32_t
+   clampPixel(int64_t i, uint32_t n) {
+   return i < 0 ? 0 : (i >= static_cast<int64_t>(n) ? n - 1 : static_cast<uint32_t>(i));
+  }
+
+  /** BATCH_WIDTH bytes widened to float lanes. */
+  inline BatchLanes
+   imageLoadBytes(const uint8_t* p) {
+#if defined(EU_SIMD_AVX2)
+   return EU::SIMD::loadBytes8(p);
+#else
+   return EU::SIMD::loadBytes(p);
+#endif
+  }
+
+  /** Pixels [x0 - r, x1 + r) of an RGBA8 row as floats, clamped to [0, width). */
+  inline void
+   imageLoadRow(const uint8_t* row, uint32_t width, uint32_t x0, uint32_t x1, uint32_t r, float* out) {
+   for (uint32_t i = 0; i < r; ++i, out += 4) {
+    const uint8_t* p = row + 4 * clampPixel(static_cast<int64_t>(x0) - r + i, width);
+    for (int c = 0; c < 4; ++c) out[c] = p[c];
+   }
+   size_t i = 4 * size_t(x0);
+   const size_t end = 4 * size_t(x1);
+   for (; i + BATCH_WIDTH <= end; i += BATCH_WIDTH, out += BATCH_WIDTH) imageLoadBytes(row + i).store(out);
+   for (; i < end; ++i) *out++ = row[i];
+   for (uint32_t i = 0; i < r; ++i, out += 4) {
+    const uint8_t* p = row + 4 * clampPixel(static_cast<int64_t>(x1) + i, width);
+    for (int c = 0; c < 4; ++c) out[c] = p[c];
+   }
+  }
+
+  /** out[i] = in[i] * scale rounded and clamped to [0, 255]. */
+  inline void
+   imagePack(const float* in, uint8_t* out, size_t n, float scale) {
+   const BatchLanes s = BatchLanes::set1(scale), half = BatchLanes::set1(0.5f);
+   size_t i = 0;
+   // Negative values truncate toward zero and storeBytes() saturates, so no clamp is needed.
+   for (; i + BATCH_WIDTH <= n; i += BATCH_WIDTH) {
+    EU::SIMD::storeBytes(EU::SIMD::truncToInt(EU::SIMD::madd(BatchLanes::load(in + i), s, half)), out + i);
+   }
+   for (; i < n; ++i) {
+    const float v = in[i] * scale + 0.5f;
+    out[i] = static_cast<uint8_t>(v < 0.f ? 0.f : (v > 255.f ? 255.f : v));
+   }
+  }
+
+  /**
+   * out[i] = sum of weights[k] * in[i + k * step] over the 2r + 1 taps, for i in [0, n), with
+   * weights symmetric about tap r. Four registers are in flight so the adds do not wait on each other.
+   */
+  inline void
+   imageConvolve(const float* in, size_t step, const float* weights, uint32_t r, float* out, size_t n) {
+   constexpr size_t UNROLL = 4;
+   const float* mirror = in + 2 * r * step;
+   size_t i = 0;
+   for (; i + UNROLL * BATCH_WIDTH <= n; i += UNROLL * BATCH_WIDTH) {
+    BatchLanes acc[UNROLL];
+    const BatchLanes centre = BatchLanes::set1(weights[r]);
+    for (size_t u = 0; u < UNROLL; ++u) acc[u] = BatchLanes::load(in + r * step + i + u * BATCH_WIDTH) * centre;
+    for (uint32_t k = 0; k < r; ++k) {
+     const BatchLanes w = BatchLanes::set1(weights[k]);
+     const float* a = in + k * step + i;
+     const float* b = mirror - k * step + i;
+     for (size_t u = 0; u < UNROLL; ++u) {
+      acc[u] = EU::SIMD::madd(BatchLanes::load(a + u * BATCH_WIDTH) + BatchLanes::load(b + u * BATCH_WIDTH), w, acc[u]);
+     }
+    }
+    for (size_t u = 0; u < UNROLL; ++u) acc[u].store(out + i + u * BATCH_WIDTH);
+   }
+   for (; i < n; ++i) {
+    float acc = weights[r] * in[r * step + i];
+    for (uint32_t k = 0; k < r; ++k) acc += weights[k] * (in[k * step + i] + (mirror - k * step)[i]);
+    out[i] = acc;
+   }
+  }
+
+  /** acc[i] += add[i] - sub[i]; sub may be null. */
+  inline void
+   imageSlide(float* acc, const float* add, const float* sub, size_t n) {
+   size_t i = 0;
+   if (sub == nullptr) {
+    for (; i + BATCH_WIDTH <= n; i += BATCH_WIDTH) (BatchLanes::load(acc + i) + BatchLanes::load(add + i)).store(acc + i);
+    for (; i < n; ++i) acc[i] += add[i];
+    return;
+   }
+   for (; i + BATCH_WIDTH <= n; i += BATCH_WIDTH) {
+    (BatchLanes::load(acc + i) + (BatchLanes::load(add + i) - BatchLanes::load(sub + i))).store(acc + i);
+   }
+   for (; i < n; ++i) acc[i] += add[i] - sub[i];
+  }
+
+  /** Sliding sums of 2r + 1 pixels, one pixel's four channels per register: out has cols pixels, in cols + 2r. */
+  inline void
+   imageBoxRow(const float* in, float* out, uint32_t cols, uint32_t r) {
+   using EU::SIMD::Float4;
+   Float4 acc = Float4::zero();
+   for (uint32_t k = 0; k <= 2 * r; ++k) acc = acc + Float4::load(in + 4 * k);
+   acc.store(out);
+   for (uint32_t x = 1; x < cols; ++x) {
+    acc = acc + (Float4::load(in + 4 * (x + 2 * r)) - Float4::load(in + 4 * (x - 1)));
+    acc.store(out + 4 * x);
+   }
+  }
+
+  /**
+   * Runs one separable filter over every tile: horizontal(in, out, cols) turns each widened
+   * float row of the tile and its halo into a scratch row, then vertical(scratch, stride,
+   * rows, out, emit) produces the tile's rows and hands each to emit(i, row) for packing.
+   */
+  template<typename Horizontal, typename Vertical>
+  inline void
+   imageSeparable(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, uint32_t r, float scale,
+                  size_t threads, Horizontal horizontal, Vertical vertical) {
+   const uint32_t tilesX = (width + IMAGE_TILE_WIDTH - 1) / IMAGE_TILE_WIDTH;
+   const uint32_t tilesY = (height + IMAGE_TILE_HEIGHT - 1) / IMAGE_TILE_HEIGHT;
+   const size_t tasks = size_t(tilesX) * tilesY;
+   parallelTasks(tasks, resolveThreads(threads, tasks), [&](size_t t) {
+    const uint32_t x0 = static_cast<uint32_t>(t % tilesX) * IMAGE_TILE_WIDTH, y0 = static_cast<uint32_t>(t / tilesX) * IMAGE_TILE_HEIGHT;
+    const uint32_t x1 = x0 + IMAGE_TILE_WIDTH < width ? x0 + IMAGE_TILE_WIDTH : width;
+    const uint32_t y1 = y0 + IMAGE_TILE_HEIGHT < height ? y0 + IMAGE_TILE_HEIGHT : height;
+    const uint32_t cols = x1 - x0, rows = y1 - y0;
+    const size_t stride = 4 * size_t(cols), span = 4 * size_t(cols + 2 * r);
+    std::vector<float>& scratch = imageScratch();
+    scratch.resize(span + (rows + 2 * r) * stride + stride);
+    float* in = scratch.data();
+    float* tile = in + span;
+    float* out = tile + (rows + 2 * r) * stride;
+    for (uint32_t j = 0; j < rows + 2 * r; ++j) {
+     const uint32_t y = clampPixel(static_cast<int64_t>(y0) + j - r, height);
+     imageLoadRow(src + size_t(y) * width * 4, width, x0, x1, r, in);
+     horizontal(in, tile + j * stride, cols);
+    }
+    vertical(tile, stride, rows, out, [&](uint32_t i, const float* row) {
+     imagePack(row, dst + (size_t(y0 + i) * width + x0) * 4, stride, scale);
+    });
+   });
+  }
+
+  /** Runs fn(begin, end) over fixed blocks of count pixels. */
+  template<typename Fn>
+  inline void
+   imagePixelBlocks(size_t count, size_t threads, Fn fn) {
+   const size_t tasks = (count + IMAGE_PIXEL_BLOCK - 1) / IMAGE_PIXEL_BLOCK;
+   parallelTasks(tasks, count < PARALLEL_IMAGE_MIN ? 1 : resolveThreads(threads, tasks), [&](size_t t) {
+    const size_t begin = t * IMAGE_PIXEL_BLOCK;
+    fn(begin, begin + IMAGE_PIXEL_BLOCK < count ? begin + IMAGE_PIXEL_BLOCK : count);
+   });
+  }
+ }
+
+ /**
+  * @brief Box blur of radius pixels (a (2 radius + 1)^2 mean) from src into dst, both
+  * width x height RGBA8; they must not overlap. Cost is independent of the radius.
+  * @return False if radius exceeds IMAGE_MAX_RADIUS or the image is empty.
+  */
+ inline bool
+  boxBlur(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, uint32_t radius, size_t threads = 0) {
+  if (radius > IMAGE_MAX_RADIUS || width == 0 || height == 0) return false;
+  EU_TRACE_ZONE("boxBlur");
+  const float taps = static_cast<float>(2 * radius + 1);
+  detail::imageSeparable(src, dst, width, height, radius, 1.f / (taps * taps), threads,
+                         [&](const float* in, float* out, uint32_t cols) { detail::imageBoxRow(in, out, cols, radius); },
+                         [&](const float* tile, size_t stride, uint32_t rows, float* out, auto emit) {
+                          // Running column sums: add the row entering the window, drop the one leaving.
+                          std::fill(out, out + stride, 0.f);
+                          for (uint32_t k = 0; k <= 2 * radius; ++k) detail::imageSlide(out, tile + k * stride, nullptr, stride);
+                          emit(0, out);
+                          for (uint32_t i = 1; i < rows; ++i) {
+                           detail::imageSlide(out, tile + (i + 2 * radius) * stride, tile + (i - 1) * stride, stride);
+                           emit(i, out);
+                          }
+                         });
+  return true;
+ }
+
+ /**
+  * @brief Gaussian blur with standard deviation sigma pixels from src into dst, both
+  * width x height RGBA8; they must not overlap. The kernel spans ceil(3 sigma) pixels each way.
+  * @return False if sigma is not positive, the radius exceeds IMAGE_MAX_RADIUS or the image is empty.
+  */
+ inline bool
+  gaussianBlur(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, float sigma, size_t threads = 0) {
+  if (!(sigma > 0.f) || width == 0 || height == 0) return false;
+  const uint32_t radius = static_cast<uint32_t>(std::ceil(3.f * sigma));
+  if (radius > IMAGE_MAX_RADIUS) return false;
+  EU_TRACE_ZONE("gaussianBlur");
+  float weights[2 * IMAGE_MAX_RADIUS + 1];
+  float sum = 0.f;
+  for (uint32_t k = 0; k <= 2 * radius; ++k) {
+   const float d = static_cast<float>(k) - static_cast<float>(radius);
+   weights[k] = std::exp(-d * d / (2.f * sigma * sigma));
+   sum += weights[k];
+  }
+  for (uint32_t k = 0; k <= 2 * radius; ++k) weights[k] /= sum;
+  detail::imageSeparable(src, dst, width, height, radius, 1.f, threads,
+                         [&](const float* in, float* out, uint32_t cols) {
+                          detail::imageConvolve(in, 4, weights, radius, out, 4 * size_t(cols));
+                         },
+                         [&](const float* tile, size_t stride, uint32_t rows, float* out, auto emit) {
+                          for (uint32_t i = 0; i < rows; ++i) {
+                           detail::imageConvolve(tile + i * stride, stride, weights, radius, out, stride);
+                           emit(i, out);
+                          }
+                         });
+  return true;
+ }
+
+ /**
+  * @brief Bilinear resize of src (srcWidth x srcHeight) into dst (dstWidth x dstHeight), pixel
+  * centres aligned. Shrinking by more than 2x skips source pixels; boxBlur() first, or halve
+  * repeatedly, for thumbnails without aliasing.
+  * @return False if either image is empty.
+  */
+ inline bool
+  resizeBilinear(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth,
+                 uint32_t dstHeight, size_t threads = 0) {
+  if (srcWidth == 0 || srcHeight == 0 || dstWidth == 0 || dstHeight == 0) return false;
+  EU_TRACE_ZONE("resizeBilinear");
+  // Source columns and weights, shared by every row.
+  std::vector<uint32_t> columns(dstWidth);
+  std::vector<float> fractions(dstWidth);
+  const float sx = static_cast<float>(srcWidth) / static_cast<float>(dstWidth);
+  const float sy = static_cast<float>(srcHeight) / static_cast<float>(dstHeight);
+  for (uint32_t x = 0; x < dstWidth; ++x) {
+   float u = (static_cast<float>(x) + 0.5f) * sx - 0.5f;
+   u = u < 0.f ? 0.f : (u > static_cast<float>(srcWidth - 1) ? static_cast<float>(srcWidth - 1) : u);
+   columns[x] = static_cast<uint32_t>(u);
+   fractions[x] = u - static_cast<float>(columns[x]);
+  }
+  const size_t tasks = (dstHeight + IMAGE_TILE_HEIGHT - 1) / IMAGE_TILE_HEIGHT;
+  detail::parallelTasks(tasks, detail::resolveThreads(threads, tasks), [&](size_t t) {
+   const size_t n = 4 * size_t(srcWidth);
+   std::vector<float>& scratch = detail::imageScratch();
+   scratch.resize(3 * n + 4 * size_t(dstWidth));
+   float* top = scratch.data();
+   float* bottom = top + n;
+   float* blend = bottom + n;
+   float* out = blend + n;
+   const uint32_t y1 = static_cast<uint32_t>(t + 1) * IMAGE_TILE_HEIGHT < dstHeight ? static_cast<uint32_t>(t + 1) * IMAGE_TILE_HEIGHT : dstHeight;
+   for (uint32_t y = static_cast<uint32_t>(t) * IMAGE_TILE_HEIGHT; y < y1; ++y) {
+    float v = (static_cast<float>(y) + 0.5f) * sy - 0.5f;
+    v = v < 0.f ? 0.f : (v > static_cast<float>(srcHeight - 1) ? static_cast<float>(srcHeight - 1) : v);
+    const uint32_t r0 = static_cast<uint32_t>(v), r1 = r0 + 1 < srcHeight ? r0 + 1 : r0;
+    // Vertical lerp of the two source rows a register at a time, then the columns.
+    detail::imageLoadRow(src + size_t(r0) * n, srcWidth, 0, srcWidth, 0, top);
+    detail::imageLoadRow(src + size_t(r1) * n, srcWidth, 0, srcWidth, 0, bottom);
+    const detail::BatchLanes fy = detail::BatchLanes::set1(v - static_cast<float>(r0));
+    size_t i = 0;
+    for (; i + detail::BATCH_WIDTH <= n; i += detail::BATCH_WIDTH) {
+     const detail::BatchLanes a = detail::BatchLanes::load(top + i);
+     EU::SIMD::madd(detail::BatchLanes::load(bottom + i) - a, fy, a).store(blend + i);
+    }
+    for (; i < n; ++i) blend[i] = top[i] + (v - static_cast<float>(r0)) * (bottom[i] - top[i]);
+    for (uint32_t x = 0; x < dstWidth; ++x) {
+     const float* a = blend + 4 * size_t(columns[x]);
+     const EU::SIMD::Float4 left = EU::SIMD::Float4::load(a);
+     const EU::SIMD::Float4 right = EU::SIMD::Float4::load(columns[x] + 1 < srcWidth ? a + 4 : a);
+     EU::SIMD::madd(right - left, EU::SIMD::Float4::set1(fractions[x]), left).store(out + 4 * size_t(x));
+    }
+    detail::imagePack(out, dst + size_t(y) * dstWidth * 4, 4 * size_t(dstWidth), 1.f);
+   }
+  });
+  return true;
+ }
+
+ /** @brief Scales the RGB of count RGBA8 pixels by their alpha in place, rounded to nearest. */
+ inline void
+  premultiplyAlpha(uint8_t* pixels, size_t count, size_t threads = 0) {
+  detail::imagePixelBlocks(count, threads, [&](size_t begin, size_t end) {
+   for (size_t i = begin; i < end; ++i) {
+    uint8_t* p = pixels + 4 * i;
+    const uint32_t a = p[3];
+    // R and B share one multiply in separate 16-bit halves; t + (t >> 8) >> 8 is round(t / 255).
+    uint32_t rb = (static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[2]) << 16) * a + 0x00800080u;
+    rb = (rb + (rb >> 8 & 0x00ff00ffu)) >> 8 & 0x00ff00ffu;
+    uint32_t g = p[1] * a + 0x80u;
+    g = (g + (g >> 8)) >> 8;
+    p[0] = static_cast<uint8_t>(rb);
+    p[1] = static_cast<uint8_t>(g);
+    p[2] = static_cast<uint8_t>(rb >> 16);
+   }
+  });
+ }
+
+ /**
+  * @brief Undoes premultiplyAlpha(): RGB of count RGBA8 pixels divided by alpha in place,
+  * rounded to nearest and clamped to 255. Pixels with zero alpha become transparent black.
+  */
+ inline void
+  unpremultiplyAlpha(uint8_t* pixels, size_t count, size_t threads = 0) {
+  // ceil(255 * 2^16 / a): (c * r + 2^15) >> 16 is then round(c * 255 / a) for every c <= a.
+  static const struct Reciprocals {
+   uint32_t r[256];
+   Reciprocals() : r() {
+    for (uint32_t a = 1; a < 256; ++a) r[a] = ((255u << 16) + a - 1) / a;
+   }
+  } reciprocals;
+  detail::imagePixelBlocks(count, threads, [&](size_t begin, size_t end) {
+   for (size_t i = begin; i < end; ++i) {
+    uint8_t* p = pixels + 4 * i;
+    const uint32_t r = reciprocals.r[p[3]];
+    for (int c = 0; c < 3; ++c) {
+     const uint32_t v = (p[c] * r + 0x8000u) >> 16;
+     p[c] = static_cast<uint8_t>(v > 255u ? 255u : v);
+    }
+   }
+  });
+ }
+
+ /**
+  * @brief dst = matrix * src for count RGBA8 pixels, RGB as a point in [0, 1]^3 (see
+  * transformPoints()) and alpha copied. src and dst may be the same buffer.
+  */
+ inline void
+  transformColors(const uint8_t* src, uint8_t* dst, size_t count, const Matrix4x4& matrix, size_t threads = 0) {
+  EU_TRACE_ZONE("transformColors");
+  // Scaled so the translation column applies to 0..255 channels directly.
+  float m[3][4];
+  for (int r = 0; r < 3; ++r) {
+   for (int c = 0; c < 3; ++c) m[r][c] = matrix.m[r][c];
+   m[r][3] = matrix.m[r][3] * 255.f;
+  }
+  detail::imagePixelBlocks(count, threads, [&](size_t begin, size_t end) {
+   constexpr size_t BLOCK = 256;
+   float in[3][BLOCK], out[3][BLOCK];
+   uint8_t packed[3][BLOCK];
+   const detail::BatchLanes lanes[3][4] = {
+    { detail::BatchLanes::set1(m[0][0]), detail::BatchLanes::set1(m[0][1]), detail::BatchLanes::set1(m[0][2]), detail::BatchLanes::set1(m[0][3]) },
+    { detail::BatchLanes::set1(m[1][0]), detail::BatchLanes::set1(m[1][1]), detail::BatchLanes::set1(m[1][2]), detail::BatchLanes::set1(m[1][3]) },
+    { detail::BatchLanes::set1(m[2][0]), detail::BatchLanes::set1(m[2][1]), detail::BatchLanes::set1(m[2][2]), detail::BatchLanes::set1(m[2][3]) }
+   };
+   for (size_t base = begin; base < end; base += BLOCK) {
+    const size_t n = end - base < BLOCK ? end - base : BLOCK;
+    const uint8_t* s = src + 4 * base;
+    for (size_t i = 0; i < n; ++i) {
+     for (int c = 0; c < 3; ++c) in[c][i] = s[4 * i + c];
+    }
+    // Pad to whole registers; the padding lanes are never stored.
+    const size_t padded = (n + detail::BATCH_WIDTH - 1) / detail::BATCH_WIDTH * detail::BATCH_WIDTH;
+    for (size_t i = n; i < padded; ++i) {
+     for (int c = 0; c < 3; ++c) in[c][i] = 0.f;
+    }
+    for (size_t i = 0; i < padded; i += detail::BATCH_WIDTH) {
+     const detail::BatchLanes r = detail::BatchLanes::load(in[0] + i), g = detail::BatchLanes::load(in[1] + i), b = detail::BatchLanes::load(in[2] + i);
+     for (int c = 0; c < 3; ++c) {
+      EU::SIMD::madd(lanes[c][0], r, EU::SIMD::madd(lanes[c][1], g, EU::SIMD::madd(lanes[c][2], b, lanes[c][3]))).store(out[c] + i);
+     }
+    }
+    for (int c = 0; c < 3; ++c) detail::imagePack(out[c], packed[c], n, 1.f);
+    uint8_t* d = dst + 4 * base;
+    for (size_t i = 0; i < n; ++i) {
+     d[4 * i + 0] = packed[0][i];
+     d[4 * i + 1] = packed[1][i];
+     d[4 * i + 2] = packed[2][i];
+     d[4 * i + 3] = s[4 * i + 3];
+    }
+   }
+  });
+ }
+}
@@ -0,0 +1,444 @@
+/**
+ * @file LightClusters.h
+ * @brief Clustered (froxel) culling of point and spot lights on the CPU, producing per-cluster
+ * index lists for a forward renderer to upload.
+ *
+ * The view frustum is cut into tilesX x tilesY screen tiles and `slices` depth slices spaced
+ * exponentially between ClusterSettings::nearDepth and farDepth, so slice thickness grows with
+ * distance like the screen footprint of a tile does. Each cluster's view-space AABB comes
+ * straight from the projection's x and y terms (tile edges are planes x = depth * slope
+ * through the eye, or x = constant for orthographic), including off-center projections; the
+ * depth mapping does not matter, so standard and reversed-Z projections give the same
+ * clusters.
+ *
+ * build() moves the lights to view space and finds the slices each one can touch, then one
+ * task per slice narrows its lights by tile row and tests what is left against every cluster
+ * of the row, a register of lights at a time. A light hits a cluster when its sphere overlaps
+ * the cluster AABB and, for a spot, its cone reaches the cluster's bounding sphere (the
+ * axis/angle, front and back tests of a cone against a sphere). Both are conservative: a
+ * listed light may still contribute nothing to some pixels of the cluster, but no light that
+ * contributes is left out. Spots wider than 90 degrees are treated as points.
+ *
+ * The result is ranges(), one { offset, count } per cluster, and indices(), every cluster's
+ * light indices back to back in ascending light order: the two buffers a shader needs. The
+ * cluster of a fragment is tx + tilesX * (ty + tilesY * slice) with tile (0, 0) at the
+ * bottom left like gl_FragCoord, and slice = floor(log(depth) * sliceScale() + sliceBias()).
+ *
+ *   LightClusters clusters(settings);
+ *   clusters.build(camera.projection, camera.view, lights, lightCount);
+ *   upload(clusters.ranges(), clusters.clusterCount(), clusters.indices(), clusters.indexCount());
+ *
+ * The view matrix must be rigid (rotation and translation), since radii are not rescaled.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Core/Trace.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Matrix4x4.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Light sets smaller than this are clustered on the calling thread.
+ constexpr size_t CLUSTER_PARALLEL_MIN = 256;
+
+ /**
+  * @struct ClusterSettings
+  * @brief Shape of the cluster grid.
+  */
+ struct ClusterSettings {
+  uint32_t tilesX = 16;
+  uint32_t tilesY = 9;
+  uint32_t slices = 24;
+  float nearDepth = 0.1f;           ///< View depth where slice 0 starts, usually the camera near plane
+  float farDepth = 500.f;           ///< View depth where the last slice ends; nothing beyond is lit
+  uint32_t maxLightsPerCluster = 0; ///< Caps every list to its lowest light indices, 0 for no cap
+ };
+
+ /**
+  * @struct ClusterLightSet
+  * @brief World-space SoA lights. Leave directions and cosAngles null when all are points.
+  */
+ struct ClusterLightSet {
+  EngineMath::batch::ConstSoA3 positions;
+  const float* radii;                      ///< Range: the light contributes nothing beyond it
+  EngineMath::batch::ConstSoA3 directions; ///< Unit spot axes
+  const float* cosAngles;                  ///< Cosine of each outer half angle; -1 for a point light
+ };
+
+ /**
+  * @struct ClusterRange
+  * @brief Where one cluster's lights sit in LightClusters::indices().
+  */
+ struct ClusterRange {
+  uint32_t offset;
+  uint32_t count;
+ };
+
+ namespace detail {
+  /**
+   * View-space lights as SoA columns, with the original index of each. Columns are padded to
+   * whole registers, so the short lists of a tile row load without a partial tail.
+   */
+  struct ClusterLightLanes {
+   enum { PX, PY, PZ, RADIUS, DX, DY, DZ, COS, SIN, COLUMNS };
+
+   std::vector<float> columns[COLUMNS];
+   std::vector<uint32_t> ids;
+
+   size_t
+    size() const {
+    return ids.size();
+   }
+
+   void
+    resize(size_t n) {
+    const size_t padded = (n + BATCH_WIDTH - 1) / BATCH_WIDTH * BATCH_WIDTH;
+    for (std::vector<float>& column : columns) column.resize(padded);
+    ids.resize(n);
+   }
+
+   /** Copies the lights from[which[0..n)]. */
+   void
+    gather(const ClusterLightLanes& from, const uint32_t* which, size_t n) {
+    resize(n);
+    for (int c = 0; c < COLUMNS; ++c) {
+     const float* in = from.columns[c].data();
+     float* out = columns[c].data();
+     for (size_t k = 0; k < n; ++k) out[k] = in[which[k]];
+    }
+    for (size_t k = 0; k < n; ++k) ids[k] = from.ids[which[k]];
+   }
+  };
+
+  /** A view-space box and its bounding sphere, broadcast. */
+  struct ClusterBox {
+   BatchLanes min[3];
+   BatchLanes max[3];
+   BatchLanes center[3];
+   BatchLanes radius;
+
+   ClusterBox(const CVector3& lo, const CVector3& hi) {
+    const CVector3 c = (lo + hi) * 0.5f, half = (hi - lo) * 0.5f;
+    splatLanes3(lo, min);
+    splatLanes3(hi, max);
+    splatLanes3(c, center);
+    radius = BatchLanes::set1(std::sqrt(half.x * half.x + half.y * half.y + half.z * half.z));
+   }
+  };
+
+  /** Mask of the register of lights from i that may light some point of box; padding lanes are arbitrary. */
+  inline BatchLanes
+   clusterHitLanes(const ClusterBox& box, const ClusterLightLanes& lights, size_t i) {
+   using L = ClusterLightLanes;
+   const BatchLanes zero = BatchLanes::zero();
+   BatchLanes p[3], d[3];
+   for (int k = 0; k < 3; ++k) {
+    p[k] = BatchLanes::load(lights.columns[L::PX + k].data() + i);
+    d[k] = BatchLanes::load(lights.columns[L::DX + k].data() + i);
+   }
+   const BatchLanes r = BatchLanes::load(lights.columns[L::RADIUS].data() + i);
+   const BatchLanes cosAngle = BatchLanes::load(lights.columns[L::COS].data() + i);
+   const BatchLanes sinAngle = BatchLanes::load(lights.columns[L::SIN].data() + i);
+
+   // Sphere against box: squared distance from the center to the box.
+   BatchLanes distSq = zero, v[3];
+   for (int k = 0; k < 3; ++k) {
+    const BatchLanes out = EU::SIMD::max(EU::SIMD::max(box.min[k] - p[k], p[k] - box.max[k]), zero);
+    distSq = EU::SIMD::madd(out, out, distSq);
+    v[k] = box.center[k] - p[k];
+   }
+   // Cone against the box's sphere; points have a zero axis and cos -1 and always pass.
+   const BatchLanes lenSq = EU::SIMD::madd(v[2], v[2], EU::SIMD::madd(v[1], v[1], v[0] * v[0]));
+   const BatchLanes along = EU::SIMD::madd(v[2], d[2], EU::SIMD::madd(v[1], d[1], v[0] * d[0]));
+   const BatchLanes across = EU::SIMD::sqrt(EU::SIMD::max(lenSq - along * along, zero));
+   const BatchLanes closest = cosAngle * across - along * sinAngle;
+   return (distSq <= r * r) & (closest <= box.radius) & (along <= box.radius + r)
+        & (along >= zero - box.radius);
+  }
+
+  /** Per-slice scratch, kept between builds. */
+  struct ClusterSlice {
+   ClusterLightLanes lights;      ///< Lights whose depth range meets the slice
+   ClusterLightLanes row;         ///< Of those, the ones touching the current tile row
+   std::vector<uint32_t> hits;    ///< appendLanes() output
+   std::vector<uint32_t> indices; ///< Light lists of the slice's clusters, back to back
+   std::vector<uint32_t> counts;  ///< List length of each cluster of the slice
+  };
+ }
+
+ /**
+  * @class LightClusters
+  * @brief Cluster grid and the light lists of the last build().
+  */
+ class
+  LightClusters {
+  public:
+  explicit LightClusters(const ClusterSettings& settings = ClusterSettings()) {
+   setSettings(settings);
+  }
+
+  /** @brief Changes the grid; the lists are empty until the next build(). */
+  void
+   setSettings(const ClusterSettings& settings) {
+   m_settings = settings;
+   if (m_settings.tilesX == 0) m_settings.tilesX = 1;
+   if (m_settings.tilesY == 0) m_settings.tilesY = 1;
+   if (m_settings.slices == 0) m_settings.slices = 1;
+   const float logRatio = std::log(m_settings.farDepth / m_settings.nearDepth);
+   m_sliceScale = static_cast<float>(m_settings.slices) / logRatio;
+   m_sliceBias = -std::log(m_settings.nearDepth) * m_sliceScale;
+   m_depths.resize(m_settings.slices + 1);
+   for (uint32_t s = 0; s <= m_settings.slices; ++s) {
+    m_depths[s] = m_settings.nearDepth * std::exp(logRatio * static_cast<float>(s) / static_cast<float>(m_settings.slices));
+   }
+   m_depths[m_settings.slices] = m_settings.farDepth;
+   m_slices.resize(m_settings.slices);
+   m_ranges.assign(clusterCount(), ClusterRange{ 0, 0 });
+   m_indices.clear();
+  }
+
+  const ClusterSettings& settings() const { return m_settings; }
+  size_t clusterCount() const { return size_t(m_settings.tilesX) * m_settings.tilesY * m_settings.slices; }
+
+  /** @brief Index of the cluster at tile (tx, ty) of depth slice s. */
+  size_t
+   clusterIndex(uint32_t tx, uint32_t ty, uint32_t s) const {
+   return (size_t(s) * m_settings.tilesY + ty) * m_settings.tilesX + tx;
+  }
+
+  /// slice = floor(log(depth) * sliceScale() + sliceBias()), as a shader computes it.
+  float sliceScale() const { return m_sliceScale; }
+  float sliceBias() const { return m_sliceBias; }
+
+  /** @brief Slice of a view depth (distance along -z), or -1 outside [nearDepth, farDepth). */
+  int32_t
+   slice(float depth) const {
+   if (!(depth >= m_settings.nearDepth) || depth >= m_settings.farDepth) return -1;
+   int32_t s = static_cast<int32_t>(std::log(depth) * m_sliceScale + m_sliceBias);
+   // Rounding near a boundary can land one slice off; the exact depths decide.
+   while (s > 0 && depth < m_depths[s]) --s;
+   while (s + 1 < static_cast<int32_t>(m_settings.slices) && depth >= m_depths[s + 1]) ++s;
+   return s;
+  }
+
+  const ClusterRange* ranges() const { return m_ranges.data(); }
+  const uint32_t* indices() const { return m_indices.data(); }
+  size_t indexCount() const { return m_indices.size(); }
+
+  /** @brief View-space bounds of a cluster, as of the last build(); for debug drawing. */
+  void
+   bounds(size_t cluster, CVector3& lo, CVector3& hi) const {
+   const uint32_t tx = static_cast<uint32_t>(cluster % m_settings.tilesX);
+   const size_t rest = cluster / m_settings.tilesX;
+   tileBounds(tx, tx + 1, static_cast<uint32_t>(rest % m_settings.tilesY), static_cast<uint32_t>(rest / m_settings.tilesY), lo, hi);
+  }
+
+  /**
+   * @brief Clusters for projection, refilling ranges() and indices().
+   * @param view World to view transform; must be rigid.
+   * @param threads Worker threads across slices, 0 for hardware_concurrency().
+   * @return indexCount().
+   */
+  size_t
+   build(const Matrix4x4& projection, const Matrix4x4& view, const ClusterLightSet& lights, size_t count,
+         size_t threads = 0) {
+   EU_TRACE_ZONE("LightClusters::build");
+   setProjection(projection);
+   toView(view, lights, count);
+
+   const uint32_t slices = m_settings.slices;
+   detail::parallelTasks(slices, count < CLUSTER_PARALLEL_MIN ? 1 : detail::resolveThreads(threads, slices),
+                         [&](size_t s) { buildSlice(static_cast<uint32_t>(s)); });
+
+   size_t total = 0;
+   for (const detail::ClusterSlice& s : m_slices) total += s.indices.size();
+   m_indices.resize(total);
+   const size_t perSlice = size_t(m_settings.tilesX) * m_settings.tilesY;
+   uint32_t offset = 0;
+   for (uint32_t s = 0; s < slices; ++s) {
+    const detail::ClusterSlice& slice = m_slices[s];
+    if (!slice.indices.empty()) std::memcpy(m_indices.data() + offset, slice.indices.data(), slice.indices.size() * sizeof(uint32_t));
+    for (size_t c = 0; c < perSlice; ++c) {
+     m_ranges[s * perSlice + c] = ClusterRange{ offset, slice.counts[c] };
+     offset += slice.counts[c];
+    }
+   }
+   EU_TRACE_COUNTER("cluster light indices", total);
+   return total;
+  }
+
+  private:
+  /** Tile edges of the projection: x = depth * slope + intercept (slope 0 when orthographic). */
+  void
+   setProjection(const Matrix4x4& projection) {
+   m_orthographic = projection.m[3][3] != 0.f;
+   m_edgesX.resize(m_settings.tilesX + 1);
+   m_edgesY.resize(m_settings.tilesY + 1);
+   for (uint32_t t = 0; t <= m_settings.tilesX; ++t) {
+    const float ndc = -1.f + 2.f * static_cast<float>(t) / static_cast<float>(m_settings.tilesX);
+    m_edgesX[t] = m_orthographic ? (ndc - projection.m[0][3]) / projection.m[0][0] : (ndc + projection.m[0][2]) / projection.m[0][0];
+   }
+   for (uint32_t t = 0; t <= m_settings.tilesY; ++t) {
+    const float ndc = -1.f + 2.f * static_cast<float>(t) / static_cast<float>(m_settings.tilesY);
+    m_edgesY[t] = m_orthographic ? (ndc - projection.m[1][3]) / projection.m[1][1] : (ndc + projection.m[1][2]) / projection.m[1][1];
+   }
+   // Side planes as a * (x or y) + b * z + c >= 0 inside, normalized: lower x, upper x, lower y, upper y.
+   const float* edges[2] = { m_edgesX.data(), m_edgesY.data() };
+   const uint32_t last[2] = { m_settings.tilesX, m_settings.tilesY };
+   for (int axis = 0; axis < 2; ++axis) {
+    const float lo = std::min(edges[axis][0], edges[axis][last[axis]]), hi = std::max(edges[axis][0], edges[axis][last[axis]]);
+    for (int side = 0; side < 2; ++side) {
+     const float edge = side ? hi : lo, sign = side ? -1.f : 1.f;
+     float* plane = m_sides[2 * axis + side];
+     if (m_orthographic) {
+      plane[0] = sign;
+      plane[1] = 0.f;
+      plane[2] = -sign * edge;
+     } else {
+      // x >= edge * depth = -edge * z through the eye.
+      const float inv = 1.f / std::sqrt(1.f + edge * edge);
+      plane[0] = sign * inv;
+      plane[1] = sign * edge * inv;
+      plane[2] = 0.f;
+     }
+    }
+   }
+  }
+
+  /** Range of edge coordinate a over the depths [d0, d1] and across tiles from edges e0 to e1. */
+  void
+   edgeRange(float e0, float e1, float d0, float d1, float& lo, float& hi) const {
+   if (m_orthographic) {
+    lo = std::min(e0, e1);
+    hi = std::max(e0, e1);
+    return;
+   }
+   lo = std::min(std::min(e0 * d0, e0 * d1), std::min(e1 * d0, e1 * d1));
+   hi = std::max(std::max(e0 * d0, e0 * d1), std::max(e1 * d0, e1 * d1));
+  }
+
+  /** View-space box of tiles [x0, x1) of row ty in slice s. */
+  void
+   tileBounds(uint32_t x0, uint32_t x1, uint32_t ty, uint32_t s, CVector3& lo, CVector3& hi) const {
+   const float d0 = m_depths[s], d1 = m_depths[s + 1];
+   edgeRange(m_edgesX[x0], m_edgesX[x1], d0, d1, lo.x, hi.x);
+   edgeRange(m_edgesY[ty], m_edgesY[ty + 1], d0, d1, lo.y, hi.y);
+   lo.z = -d1;
+   hi.z = -d0;
+  }
+
+  /** Lights to view space, with the slice range each one's sphere covers. */
+  void
+   toView(const Matrix4x4& view, const ClusterLightSet& set, size_t count) {
+   using L = detail::ClusterLightLanes;
+   m_view.resize(count);
+   m_sliceRange.resize(2 * count);
+   const float(&m)[4][4] = view.m;
+   const float roundOff = 1e-3f;
+   for (size_t i = 0; i < count; ++i) {
+    const float x = set.positions.x[i], y = set.positions.y[i], z = set.positions.z[i], r = set.radii[i];
+    const float vx = m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3];
+    const float vy = m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3];
+    const float vz = m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3];
+    float dx = 0.f, dy = 0.f, dz = 0.f, cosAngle = -1.f, sinAngle = 0.f;
+    if (set.cosAngles && set.cosAngles[i] >= 0.f) {
+     const float ax = set.directions.x[i], ay = set.directions.y[i], az = set.directions.z[i];
+     dx = m[0][0] * ax + m[0][1] * ay + m[0][2] * az;
+     dy = m[1][0] * ax + m[1][1] * ay + m[1][2] * az;
+     dz = m[2][0] * ax + m[2][1] * ay + m[2][2] * az;
+     cosAngle = std::min(set.cosAngles[i], 1.f);
+     sinAngle = std::sqrt(1.f - cosAngle * cosAngle);
+    }
+    const float values[L::COLUMNS] = { vx, vy, vz, r, dx, dy, dz, cosAngle, sinAngle };
+    for (int c = 0; c < L::COLUMNS; ++c) m_view.columns[c][i] = values[c];
+    m_view.ids[i] = static_cast<uint32_t>(i);
+
+    // Slices of the depth range [-vz - r, -vz + r]; empty (first > last) when the sphere is
+    // out of range or outside a side of the frustum.
+    const float nearest = -vz - r, farthest = -vz + r;
+    bool inside = farthest >= m_settings.nearDepth && nearest < m_settings.farDepth;
+    for (int p = 0; p < 4; ++p) {
+     const float* plane = m_sides[p];
+     inside = inside && plane[0] * (p < 2 ? vx : vy) + plane[1] * vz + plane[2] >= -r;
+    }
+    int32_t first = 1, last = 0;
+    if (inside) {
+     const float lo = std::log(std::max(nearest, m_settings.nearDepth)) * m_sliceScale + m_sliceBias - roundOff;
+     const float hi = std::log(std::min(farthest, m_settings.farDepth)) * m_sliceScale + m_sliceBias + roundOff;
+     first = static_cast<int32_t>(std::max(lo, 0.f));
+     last = static_cast<int32_t>(std::min(hi, static_cast<float>(m_settings.slices - 1)));
+    }
+    m_sliceRange[2 * i] = first;
+    m_sliceRange[2 * i + 1] = last;
+   }
+  }
+
+  void
+   buildSlice(uint32_t s) {
+   detail::ClusterSlice& slice = m_slices[s];
+   const uint32_t tilesX = m_settings.tilesX, tilesY = m_settings.tilesY;
+   const uint32_t cap = m_settings.maxLightsPerCluster;
+   slice.indices.clear();
+   slice.counts.assign(size_t(tilesX) * tilesY, 0);
+
+   slice.hits.clear();
+   for (size_t i = 0; i < m_view.size(); ++i) {
+    if (m_sliceRange[2 * i] <= int32_t(s) && int32_t(s) <= m_sliceRange[2 * i + 1]) slice.hits.push_back(static_cast<uint32_t>(i));
+   }
+   if (slice.hits.empty()) return;
+   slice.lights.gather(m_view, slice.hits.data(), slice.hits.size());
+   slice.hits.resize(slice.lights.size());
+
+   CVector3 lo, hi;
+   for (uint32_t ty = 0; ty < tilesY; ++ty) {
+    tileBounds(0, tilesX, ty, s, lo, hi);
+    const size_t inRow = hitList(detail::ClusterBox(lo, hi), slice.lights, slice.hits.data());
+    if (inRow == 0) continue;
+    slice.row.gather(slice.lights, slice.hits.data(), inRow);
+    for (uint32_t tx = 0; tx < tilesX; ++tx) {
+     tileBounds(tx, tx + 1, ty, s, lo, hi);
+     size_t found = hitList(detail::ClusterBox(lo, hi), slice.row, slice.hits.data());
+     if (cap && found > cap) found = cap;
+     for (size_t k = 0; k < found; ++k) slice.indices.push_back(slice.row.ids[slice.hits[k]]);
+     slice.counts[size_t(ty) * tilesX + tx] = static_cast<uint32_t>(found);
+    }
+   }
+  }
+
+  /** Writes the positions in lights of those that hit box to out; returns how many. */
+  static size_t
+   hitList(const detail::ClusterBox& box, const detail::ClusterLightLanes& lights, uint32_t* out) {
+   size_t found = 0;
+   for (size_t i = 0; i < lights.size(); i += detail::BATCH_WIDTH) {
+    const size_t count = lights.size() - i < detail::BATCH_WIDTH ? lights.size() - i : detail::BATCH_WIDTH;
+    found = detail::appendLanes(detail::clusterHitLanes(box, lights, i), count, static_cast<uint32_t>(i), out, found);
+   }
+   return found;
+  }
+
+  ClusterSettings m_settings;
+  float m_sliceScale = 0.f;
+  float m_sliceBias = 0.f;
+  bool m_orthographic = false;
+  std::vector<float> m_depths;  ///< Start depth of each slice, then farDepth
+  std::vector<float> m_edgesX;  ///< Tile edge slopes (or positions when orthographic), left to right
+  std::vector<float> m_edgesY;  ///< Same, bottom to top
+  float m_sides[4][3] = {};      ///< Side planes of the whole grid, see setProjection()
+  detail::ClusterLightLanes m_view;
+  std::vector<int32_t> m_sliceRange; ///< First and last slice of each light
+  std::vector<detail::ClusterSlice> m_slices;
+  std::vector<ClusterRange> m_ranges;
+  std::vector<uint32_t> m_indices;
+ };
+}
@@ -0,0 +1,327 @@
+/**
+ * @file MatrixStaging.h
+ * @brief Persistently mapped ring buffer that matrix palettes are written straight into.
+ *
+ * A MatrixStagingBuffer is one OpenGL buffer created with glBufferStorage() and mapped once,
+ * for good, with GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT. It is split into two or three
+ * frame regions used in turn. beginFrame() waits on the fence of the region it is about to
+ * reuse, which only blocks if the GPU is still that many frames behind. write() transposes
+ * matrices into column-major mat4s directly in the mapped memory, the layout both std140 and
+ * std430 give a mat4 or mat4[] (a 64-byte stride). endFrame() fences the region. No
+ * glBufferData() or glBufferSubData() call, no driver-side copy and no reallocation happen after
+ * create().
+ *
+ * writeRows() stores Affine3x4 palettes as they are, 48 bytes each, for shaders that declare
+ * layout(row_major) mat3x4: a quarter less bandwidth than expanding them to mat4.
+ *
+ * The GL 4.4 entry points come from the context SFML created, through sf::Context::getFunction().
+ * Without GL 4.4 or ARB_buffer_storage, create() returns false; setUniformArray() in
+ * MatrixSFML.h is the fallback. Needs sfml-window at link time, and the context the buffer was
+ * created in (or one sharing with it) to be active on the thread that renders.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <SFML/Window/Context.hpp>
+#include <SFML/Window/GlResource.hpp>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/ColumnMatrix4x4.h>
+#include <Matrices/Matrix4x4.h>
+
+#if defined(_WIN32) && !defined(_WIN64)
+ #define EU_GL_APIENTRY __stdcall
+#else
+ #define EU_GL_APIENTRY
+#endif
+
+namespace EU {
+ namespace detail {
+  /** The GL 4.4 buffer and sync entry points used by MatrixStagingBuffer. */
+  struct GlStagingFunctions {
+   using GenBuffers = void (EU_GL_APIENTRY*)(int, unsigned*);
+   using DeleteBuffers = void (EU_GL_APIENTRY*)(int, const unsigned*);
+   using BindBuffer = void (EU_GL_APIENTRY*)(unsigned, unsigned);
+   using BufferStorage = void (EU_GL_APIENTRY*)(unsigned, ptrdiff_t, const void*, unsigned);
+   using MapBufferRange = void* (EU_GL_APIENTRY*)(unsigned, ptrdiff_t, ptrdiff_t, unsigned);
+   using UnmapBuffer = unsigned char (EU_GL_APIENTRY*)(unsigned);
+   using BindBufferRange = void (EU_GL_APIENTRY*)(unsigned, unsigned, unsigned, ptrdiff_t, ptrdiff_t);
+   using FenceSync = void* (EU_GL_APIENTRY*)(unsigned, unsigned);
+   using ClientWaitSync = unsigned (EU_GL_APIENTRY*)(void*, unsigned, uint64_t);
+   using DeleteSync = void (EU_GL_APIENTRY*)(void*);
+   using GetIntegerv = void (EU_GL_APIENTRY*)(unsigned, int*);
+
+   GenBuffers genBuffers = nullptr;
+   DeleteBuffers deleteBuffers = nullptr;
+   BindBuffer bindBuffer = nullptr;
+   BufferStorage bufferStorage = nullptr;
+   MapBufferRange mapBufferRange = nullptr;
+   UnmapBuffer unmapBuffer = nullptr;
+   BindBufferRange bindBufferRange = nullptr;
+   FenceSync fenceSync = nullptr;
+   ClientWaitSync clientWaitSync = nullptr;
+   DeleteSync deleteSync = nullptr;
+   GetIntegerv getIntegerv = nullptr;
+
+   /** Loads every entry point from the active context; false if any is missing. */
+   bool
+    load() {
+    return get(genBuffers, "glGenBuffers") && get(deleteBuffers, "glDeleteBuffers")
+           && get(bindBuffer, "glBindBuffer") && get(mapBufferRange, "glMapBufferRange")
+           && get(unmapBuffer, "glUnmapBuffer") && get(bindBufferRange, "glBindBufferRange")
+           && get(fenceSync, "glFenceSync") && get(clientWaitSync, "glClientWaitSync")
+           && get(deleteSync, "glDeleteSync") && get(getIntegerv, "glGetIntegerv")
+           && (get(bufferStorage, "glBufferStorage") || get(bufferStorage, "glBufferStorageARB"));
+   }
+
+   private:
+   template<typename Fn>
+   static bool
+    get(Fn& fn, const char* name) {
+    fn = reinterpret_cast<Fn>(sf::Context::getFunction(name));
+    return fn != nullptr;
+   }
+  };
+
+  // GL enums, so no GL 4.4 header is needed.
+  constexpr unsigned GL_STAGING_UNIFORM_BUFFER = 0x8A11;
+  constexpr unsigned GL_STAGING_SHADER_STORAGE_BUFFER = 0x90D2;
+  constexpr unsigned GL_STAGING_UNIFORM_OFFSET_ALIGNMENT = 0x8A34;
+  constexpr unsigned GL_STAGING_STORAGE_OFFSET_ALIGNMENT = 0x90DF;
+  constexpr unsigned GL_STAGING_MAP_FLAGS = 0x0002 | 0x0040 | 0x0080; // WRITE | PERSISTENT | COHERENT
+  constexpr unsigned GL_STAGING_SYNC_GPU_COMMANDS_COMPLETE = 0x9117;
+  constexpr unsigned GL_STAGING_SYNC_FLUSH_COMMANDS = 0x0001;
+  constexpr unsigned GL_STAGING_TIMEOUT_EXPIRED = 0x911B;
+  constexpr unsigned GL_STAGING_WAIT_FAILED = 0x911D;
+  constexpr uint64_t GL_STAGING_WAIT_NANOSECONDS = 1000000000ull;
+ }
+
+ /**
+  * @class MatrixStagingBuffer
+  * @brief Ring of per-frame regions in one persistently mapped uniform or storage buffer.
+  */
+ class
+  MatrixStagingBuffer : sf::GlResource {
+  public:
+  /// Binding point the buffer is meant for; decides the offset alignment of write().
+  enum Target {
+   Uniform,      ///< GL_UNIFORM_BUFFER (std140 blocks)
+   ShaderStorage ///< GL_SHADER_STORAGE_BUFFER (std430 blocks)
+  };
+
+  /// Returned by write() when the frame region is full or the buffer was not created.
+  static constexpr size_t NPOS = ~size_t(0);
+  /// Most frame regions create() accepts.
+  static constexpr unsigned MAX_FRAMES = 4;
+
+  MatrixStagingBuffer()
+   : m_mapped(nullptr), m_buffer(0), m_glTarget(0), m_regionSize(0), m_frames(0), m_alignment(64),
+     m_frame(0), m_cursor(0), m_fences{} {}
+
+  MatrixStagingBuffer(const MatrixStagingBuffer&) = delete;
+  MatrixStagingBuffer& operator=(const MatrixStagingBuffer&) = delete;
+
+  ~MatrixStagingBuffer() {
+   destroy();
+  }
+
+  /**
+   * @brief Creates and maps the buffer: frames regions of bytesPerFrame bytes each.
+   * @param frames Regions in the ring, 2 (double) to MAX_FRAMES; 3 lets the CPU run two
+   * frames ahead without waiting.
+   * @return false, with nothing created, when the context lacks GL 4.4 buffer storage.
+   */
+  bool
+   create(size_t bytesPerFrame, unsigned frames = 3, Target target = ShaderStorage) {
+   destroy();
+   TransientContextLock lock;
+   if (!m_gl.load()) {
+    return false;
+   }
+   frames = frames < 2 ? 2 : (frames > MAX_FRAMES ? MAX_FRAMES : frames);
+   m_glTarget = target == Uniform ? detail::GL_STAGING_UNIFORM_BUFFER : detail::GL_STAGING_SHADER_STORAGE_BUFFER;
+   int alignment = 0;
+   m_gl.getIntegerv(target == Uniform ? detail::GL_STAGING_UNIFORM_OFFSET_ALIGNMENT
+                                      : detail::GL_STAGING_STORAGE_OFFSET_ALIGNMENT, &alignment);
+   // Offsets also stay 64-byte aligned, so every ColumnMatrix4x4 written lands on a cache line.
+   m_alignment = alignment > 64 ? static_cast<size_t>(alignment) : 64;
+   m_regionSize = (bytesPerFrame + m_alignment - 1) / m_alignment * m_alignment;
+   m_frames = frames;
+   const ptrdiff_t total = static_cast<ptrdiff_t>(m_regionSize * m_frames);
+   m_gl.genBuffers(1, &m_buffer);
+   m_gl.bindBuffer(m_glTarget, m_buffer);
+   m_gl.bufferStorage(m_glTarget, total, nullptr, detail::GL_STAGING_MAP_FLAGS);
+   m_mapped = static_cast<unsigned char*>(m_gl.mapBufferRange(m_glTarget, 0, total, detail::GL_STAGING_MAP_FLAGS));
+   m_gl.bindBuffer(m_glTarget, 0);
+   if (m_mapped == nullptr) {
+    m_gl.deleteBuffers(1, &m_buffer);
+    m_buffer = 0;
+    m_frames = 0;
+    return false;
+   }
+   m_frame = 0;
+   m_cursor = 0;
+   return true;
+  }
+
+  /** @brief True between a successful create() and destruction. */
+  bool
+   isCreated() const {
+   return m_mapped != nullptr;
+  }
+
+  /** @brief The GL buffer name, e.g. for glBindBufferBase() by other code. */
+  unsigned
+   handle() const {
+   return m_buffer;
+  }
+
+  /** @brief Bytes available to each frame, rounded up to the offset alignment. */
+  size_t
+   regionSize() const {
+   return m_regionSize;
+  }
+
+  /** @brief Offset alignment of everything write() places. */
+  size_t
+   alignment() const {
+   return m_alignment;
+  }
+
+  /**
+   * @brief Starts writing the next region of the ring, first waiting until the GPU is done
+   * with the frame that used it last.
+   * @return false if the wait failed (context lost) or the buffer was not created.
+   */
+  bool
+   beginFrame() {
+   if (m_mapped == nullptr) {
+    return false;
+   }
+   m_cursor = 0;
+   void*& fence = m_fences[m_frame % m_frames];
+   if (fence == nullptr) {
+    return true;
+   }
+   unsigned status = m_gl.clientWaitSync(fence, detail::GL_STAGING_SYNC_FLUSH_COMMANDS, detail::GL_STAGING_WAIT_NANOSECONDS);
+   while (status == detail::GL_STAGING_TIMEOUT_EXPIRED) {
+    status = m_gl.clientWaitSync(fence, 0, detail::GL_STAGING_WAIT_NANOSECONDS);
+   }
+   m_gl.deleteSync(fence);
+   fence = nullptr;
+   return status != detail::GL_STAGING_WAIT_FAILED;
+  }
+
+  /**
+   * @brief Writes n matrices as column-major mat4s into this frame's region.
+   * @return Byte offset of the first one in the buffer, for bind(); NPOS if they do not fit.
+   */
+  size_t
+   write(const Matrix4x4* matrices, size_t n) {
+   const size_t offset = reserve(n * sizeof(ColumnMatrix4x4));
+   if (offset != NPOS) toColumnMajor(matrices, reinterpret_cast<ColumnMatrix4x4*>(m_mapped + offset), n);
+   return offset;
+  }
+
+  /** @brief Writes n affine transforms expanded to column-major mat4s; see write(). */
+  size_t
+   write(const Affine3x4* matrices, size_t n) {
+   const size_t offset = reserve(n * sizeof(ColumnMatrix4x4));
+   if (offset != NPOS) toColumnMajor(matrices, reinterpret_cast<ColumnMatrix4x4*>(m_mapped + offset), n);
+   return offset;
+  }
+
+  /** @brief Copies n matrices that are already column-major; see write(). */
+  size_t
+   write(const ColumnMatrix4x4* matrices, size_t n) {
+   const size_t offset = reserve(n * sizeof(ColumnMatrix4x4));
+   if (offset != NPOS) std::memcpy(m_mapped + offset, matrices, n * sizeof(ColumnMatrix4x4));
+   return offset;
+  }
+
+  /**
+   * @brief Writes n affine transforms as they are stored, three rows of four floats: the
+   * layout of a GLSL layout(row_major) mat3x4[] in std140 and std430. See write().
+   */
+  size_t
+   writeRows(const Affine3x4* matrices, size_t n) {
+   const size_t offset = reserve(n * sizeof(matrices->m));
+   if (offset == NPOS) {
+    return NPOS;
+   }
+   unsigned char* out = m_mapped + offset;
+   for (size_t i = 0; i < n; ++i) std::memcpy(out + i * sizeof(matrices->m), matrices[i].m, sizeof(matrices->m));
+   return offset;
+  }
+
+  /**
+   * @brief glBindBufferRange() of bytes at offset, a value write() returned, to the
+   * block binding index.
+   */
+  void
+   bind(unsigned index, size_t offset, size_t bytes) const {
+   if (m_mapped == nullptr || offset == NPOS) {
+    return;
+   }
+   m_gl.bindBufferRange(m_glTarget, index, m_buffer, static_cast<ptrdiff_t>(offset), static_cast<ptrdiff_t>(bytes));
+  }
+
+  /**
+   * @brief Fences this frame's region after the draw calls that read it have been issued,
+   * and moves the ring on.
+   */
+  void
+   endFrame() {
+   if (m_mapped == nullptr) {
+    return;
+   }
+   m_fences[m_frame % m_frames] = m_gl.fenceSync(detail::GL_STAGING_SYNC_GPU_COMMANDS_COMPLETE, 0);
+   ++m_frame;
+  }
+
+  private:
+  /** Claims bytes in the current region at the next aligned offset. */
+  size_t
+   reserve(size_t bytes) {
+   if (m_mapped == nullptr || bytes > m_regionSize - m_cursor) {
+    return NPOS;
+   }
+   const size_t offset = (m_frame % m_frames) * m_regionSize + m_cursor;
+   const size_t end = m_cursor + bytes;
+   m_cursor = end >= m_regionSize ? m_regionSize : (end + m_alignment - 1) / m_alignment * m_alignment;
+   return offset;
+  }
+
+  void
+   destroy() {
+   if (m_buffer == 0) {
+    return;
+   }
+   TransientContextLock lock;
+   for (void*& fence : m_fences) {
+    if (fence != nullptr) m_gl.deleteSync(fence);
+    fence = nullptr;
+   }
+   m_gl.bindBuffer(m_glTarget, m_buffer);
+   m_gl.unmapBuffer(m_glTarget);
+   m_gl.bindBuffer(m_glTarget, 0);
+   m_gl.deleteBuffers(1, &m_buffer);
+   m_buffer = 0;
+   m_mapped = nullptr;
+   m_frames = 0;
+  }
+
+  detail::GlStagingFunctions m_gl;
+  unsigned char* m_mapped;    ///< Whole buffer, mapped for the buffer's lifetime
+  unsigned m_buffer;          ///< GL buffer name
+  unsigned m_glTarget;        ///< GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER
+  size_t m_regionSize;        ///< Bytes per frame region, a multiple of m_alignment
+  unsigned m_frames;          ///< Regions in the ring
+  size_t m_alignment;         ///< Offset alignment of write()
+  uint64_t m_frame;           ///< Frames begun since create(); the region is m_frame % m_frames
+  size_t m_cursor;            ///< Bytes used in the current region
+  void* m_fences[MAX_FRAMES]; ///< GLsync per region, nullptr when not pending
+ };
+}
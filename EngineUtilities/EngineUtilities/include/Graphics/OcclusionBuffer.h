@@ -0,0 +1,556 @@
+/**
+ * @file OcclusionBuffer.h
+ * @brief CPU occlusion culling: a masked hierarchical-depth rasterizer for occluder meshes
+ * and conservative occludee box tests against it.
+ *
+ * The buffer is a low-resolution screen split into 32x8 pixel tiles. Following Hasselgren,
+ * Andersson and Akenine-Möller's masked occlusion culling, a tile stores no per-pixel depth:
+ * it keeps one coverage bit per pixel and two depths, layer 0 for the whole tile and layer 1
+ * for the pixels whose bit is set. Depth is 1 / w, larger is nearer, so a pixel is known to
+ * be hidden behind an occluder at least as near as its layer. A triangle covering part of a
+ * tile adds its coverage to layer 1 at its farthest depth over the tile; once every bit is
+ * set, layer 1 becomes the new layer 0 and the mask empties. A farther triangle that covers
+ * every pixel layer 1 does not raises layer 0 instead, and one much farther than layer 1
+ * replaces it rather than dragging it back. A row of coverage is one 32-bit word, computed
+ * for a register of rows at a time from the triangle's left and right edges.
+ *
+ * Two depths per tile cannot hold a tile's worth of buildings at different distances, so
+ * how much it culls depends on submission order: add occluders roughly front to back. In a
+ * city test at 512x256, sorting the buildings by distance took the boxes it culls from under
+ * half to over nine tenths of what a full-resolution depth buffer would.
+ *
+ * render() works in three passes over the occluders added since clear(): their vertices go
+ * to clip space through the batch Matrix4x4 kernel of VectorTransform.h, fixed chunks of
+ * triangles are clipped to the near plane, projected, set up and binned into screen
+ * regions of 4x4 tiles, and then every bin rasterizes its triangles, in submission order,
+ * on its own. Each pass is split over threads (0 = hardware_concurrency(), 1 = caller only;
+ * JobSystem::useForParallelTasks() lends a job system's workers), and the buffer comes out
+ * the same for any thread count.
+ *
+ * testBox() projects a world box and reports false only when every tile its screen rectangle
+ * touches holds nearer occluders over all the covered pixels; boxes crossing the near plane
+ * are always visible. testBoxes() filters a candidate list, such as the output of cullBoxes():
+ *
+ *   OcclusionBuffer occlusion(256, 128, camera.zNear);
+ *   occlusion.clear();
+ *   for (const Building& b : occluders) occlusion.addOccluder(b.vertices, b.vertexCount, b.indices, b.triangles, viewProj * b.world);
+ *   occlusion.render();
+ *   size_t n = cullBoxes(frustum, lo, hi, count, candidates);
+ *   n = occlusion.testBoxes(lo, hi, candidates, n, viewProj, visible);
+ *
+ * Occluders must be closed or solid from the camera (walls, terrain, merged building
+ * shells). Coverage samples pixel centers, so detail thinner than a buffer pixel neither
+ * occludes nor is missed by the test. The projection must be a perspective one: w is the
+ * view distance and nearW the near plane distance in the same units.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Constants.h>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Core/Trace.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Matrix4x4.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+#include <Vectors/VectorTransform.h>
+
+namespace EU {
+ /// Pixels per tile row; one coverage word.
+ constexpr int32_t OCCLUSION_TILE_WIDTH = 32;
+ /// Rows per tile.
+ constexpr int32_t OCCLUSION_TILE_HEIGHT = 8;
+
+ namespace detail {
+  /// Tiles per bin along x and y.
+  constexpr int32_t OCCLUSION_BIN_TILES = 4;
+  /// Vertices per transform task.
+  constexpr size_t OCCLUSION_VERTEX_CHUNK = 4096;
+  /// Triangles per setup and binning task; fixes the work split.
+  constexpr size_t OCCLUSION_TRIANGLE_CHUNK = 1024;
+  /// Boxes per testBoxes() task.
+  constexpr size_t OCCLUSION_TEST_CHUNK = 1024;
+
+  /** Masked depth tile: coverage rows, layer 0 for all pixels, layer 1 for the covered ones. */
+  struct OcclusionTile {
+   uint32_t mask[OCCLUSION_TILE_HEIGHT];
+   float layer0;
+   float layer1;
+  };
+
+  /**
+   * Screen triangle ready to rasterize: row spans are x in [max of the left edges, min of
+   * the right edges) for y in [top, bottom), each edge as x = q + m * y; depth is the plane
+   * a x + b y + c, never farther than farthest.
+   */
+  struct OcclusionTriangle {
+   float leftQ[2], leftM[2];
+   float rightQ[2], rightM[2];
+   float top, bottom;
+   float a, b, c;
+   float farthest;
+   int32_t tileX0, tileY0, tileX1, tileY1; ///< Inclusive tile bounds, on screen
+  };
+
+  /** One triangle chunk's output: its triangles and their bins, as CSR. */
+  struct OcclusionChunk {
+   std::vector<OcclusionTriangle> triangles;
+   std::vector<uint32_t> binStart;
+   std::vector<uint32_t> binTriangles;
+   std::vector<uint32_t> cursor; ///< Fill position per bin
+  };
+
+  /** Clip-space vertex: only x, y and w take part. */
+  struct OcclusionVertex {
+   float x, y, w;
+  };
+
+  /** Pixels [begin, end) of a 32-pixel row, both in [0, 32]. */
+  inline uint32_t
+   occlusionSpan(int32_t begin, int32_t end) {
+   return static_cast<uint32_t>(((uint64_t(1) << end) - 1) & ~((uint64_t(1) << begin) - 1));
+  }
+ }
+
+ /**
+  * @class OcclusionBuffer
+  * @brief Low-resolution masked depth buffer: occluders in, conservative box visibility out.
+  */
+ class
+  OcclusionBuffer {
+  public:
+  /**
+   * @param width, height Buffer size in pixels, rounded up to whole tiles; the view maps onto
+   * the rounded size.
+   * @param nearW w of the camera's near plane (its zNear for perspective()).
+   */
+  explicit OcclusionBuffer(int32_t width = 256, int32_t height = 128, float nearW = 0.1f) : m_nearW(nearW) {
+   m_tilesX = std::max<int32_t>(1, (width + OCCLUSION_TILE_WIDTH - 1) / OCCLUSION_TILE_WIDTH);
+   m_tilesY = std::max<int32_t>(1, (height + OCCLUSION_TILE_HEIGHT - 1) / OCCLUSION_TILE_HEIGHT);
+   m_binsX = (m_tilesX + detail::OCCLUSION_BIN_TILES - 1) / detail::OCCLUSION_BIN_TILES;
+   m_binsY = (m_tilesY + detail::OCCLUSION_BIN_TILES - 1) / detail::OCCLUSION_BIN_TILES;
+   m_tiles.resize(static_cast<size_t>(m_tilesX) * static_cast<size_t>(m_tilesY));
+   clear();
+  }
+
+  int32_t
+   width() const {
+   return m_tilesX * OCCLUSION_TILE_WIDTH;
+  }
+
+  int32_t
+   height() const {
+   return m_tilesY * OCCLUSION_TILE_HEIGHT;
+  }
+
+  /** @brief Empties the buffer and forgets the added occluders. */
+  void
+   clear() {
+   detail::OcclusionTile empty;
+   std::fill(empty.mask, empty.mask + OCCLUSION_TILE_HEIGHT, 0u);
+   empty.layer0 = 0.f;
+   empty.layer1 = Constants::INF;
+   std::fill(m_tiles.begin(), m_tiles.end(), empty);
+   m_draws.clear();
+   m_vertexCount = 0;
+   m_triangleCount = 0;
+  }
+
+  /**
+   * @brief Queues an indexed triangle mesh for the next render(); the arrays must stay valid
+   * until then.
+   * @param modelViewProjection Object to clip space.
+   * @param cullBackFaces Skip triangles wound clockwise on screen (OpenGL back faces).
+   */
+  void
+   addOccluder(const CVector3* vertices, size_t vertexCount, const uint32_t* indices, size_t triangleCount,
+               const Matrix4x4& modelViewProjection, bool cullBackFaces = true) {
+   Draw draw;
+   draw.vertices = vertices;
+   draw.indices = indices;
+   draw.vertexCount = vertexCount;
+   draw.triangleCount = triangleCount;
+   draw.firstVertex = m_vertexCount;
+   draw.firstTriangle = m_triangleCount;
+   draw.cullBackFaces = cullBackFaces;
+   for (int c = 0; c < 4; ++c) {
+    draw.rows[0][c] = modelViewProjection.m[0][c];
+    draw.rows[1][c] = modelViewProjection.m[1][c];
+    draw.rows[2][c] = modelViewProjection.m[3][c];
+   }
+   m_draws.push_back(draw);
+   m_vertexCount += vertexCount;
+   m_triangleCount += triangleCount;
+  }
+
+  /** @brief Rasterizes the queued occluders into the buffer. */
+  void
+   render(size_t threads = 0) {
+   EU_TRACE_ZONE("OcclusionBuffer::render");
+   transformVertices(threads);
+   const size_t chunks = (m_triangleCount + detail::OCCLUSION_TRIANGLE_CHUNK - 1) / detail::OCCLUSION_TRIANGLE_CHUNK;
+   if (m_chunks.size() < chunks) m_chunks.resize(chunks);
+   detail::parallelTasks(chunks, detail::resolveThreads(threads, chunks), [&](size_t c) { setupChunk(c); });
+   size_t triangles = 0;
+   for (size_t c = 0; c < chunks; ++c) triangles += m_chunks[c].triangles.size();
+   EU_TRACE_COUNTER("occluder triangles", triangles);
+   const size_t bins = static_cast<size_t>(m_binsX) * static_cast<size_t>(m_binsY);
+   detail::parallelTasks(bins, detail::resolveThreads(triangles == 0 ? 1 : threads, bins), [&](size_t bin) {
+    rasterizeBin(bin, chunks);
+   });
+   m_draws.clear();
+   m_vertexCount = 0;
+   m_triangleCount = 0;
+  }
+
+  /**
+   * @brief False only when the box [lo, hi] is certainly hidden behind rendered occluders.
+   * @param viewProjection World to clip space, as for the occluders.
+   */
+  bool
+   testBox(const CVector3& lo, const CVector3& hi, const Matrix4x4& viewProjection) const {
+   const float(*m)[4] = viewProjection.m;
+   float minX = Constants::INF, minY = Constants::INF, maxX = Constants::NEG_INF, maxY = Constants::NEG_INF;
+   float nearest = 0.f;
+   for (int k = 0; k < 8; ++k) {
+    const float px = (k & 1) ? hi.x : lo.x, py = (k & 2) ? hi.y : lo.y, pz = (k & 4) ? hi.z : lo.z;
+    const float w = m[3][0] * px + m[3][1] * py + m[3][2] * pz + m[3][3];
+    if (w < m_nearW) return true;
+    const float inv = 1.f / w;
+    const float sx = (m[0][0] * px + m[0][1] * py + m[0][2] * pz + m[0][3]) * inv;
+    const float sy = (m[1][0] * px + m[1][1] * py + m[1][2] * pz + m[1][3]) * inv;
+    minX = std::min(minX, sx);
+    maxX = std::max(maxX, sx);
+    minY = std::min(minY, sy);
+    maxY = std::max(maxY, sy);
+    nearest = std::max(nearest, inv);
+   }
+   // NDC to pixels, y down; every pixel the rectangle touches counts.
+   const float w = static_cast<float>(width()), h = static_cast<float>(height());
+   const int32_t x0 = std::max(EngineMath::floor((minX * 0.5f + 0.5f) * w), 0);
+   const int32_t x1 = std::min(EngineMath::ceil((maxX * 0.5f + 0.5f) * w), width());
+   const int32_t y0 = std::max(EngineMath::floor((0.5f - maxY * 0.5f) * h), 0);
+   const int32_t y1 = std::min(EngineMath::ceil((0.5f - minY * 0.5f) * h), height());
+   if (x0 >= x1 || y0 >= y1) return false;
+   for (int32_t ty = y0 / OCCLUSION_TILE_HEIGHT; ty <= (y1 - 1) / OCCLUSION_TILE_HEIGHT; ++ty) {
+    const int32_t rowBegin = std::max(y0 - ty * OCCLUSION_TILE_HEIGHT, 0);
+    const int32_t rowEnd = std::min(y1 - ty * OCCLUSION_TILE_HEIGHT, OCCLUSION_TILE_HEIGHT);
+    for (int32_t tx = x0 / OCCLUSION_TILE_WIDTH; tx <= (x1 - 1) / OCCLUSION_TILE_WIDTH; ++tx) {
+     const detail::OcclusionTile& tile = m_tiles[static_cast<size_t>(ty) * m_tilesX + tx];
+     if (nearest <= tile.layer0) continue;
+     if (nearest > tile.layer1) return true;
+     // Between the layers: visible through any pixel layer 1 does not cover.
+     const uint32_t span = detail::occlusionSpan(std::max(x0 - tx * OCCLUSION_TILE_WIDTH, 0),
+                                                 std::min(x1 - tx * OCCLUSION_TILE_WIDTH, OCCLUSION_TILE_WIDTH));
+     for (int32_t r = rowBegin; r < rowEnd; ++r) {
+      if (span & ~tile.mask[r]) return true;
+     }
+    }
+   }
+   return false;
+  }
+
+  /**
+   * @brief Writes the candidates[0..n) whose boxes (lo, hi indexed by candidate) may be
+   * visible to visible, in order; visible needs room for n and may be candidates.
+   * @return Number written.
+   */
+  size_t
+   testBoxes(EngineMath::batch::ConstSoA3 lo, EngineMath::batch::ConstSoA3 hi, const uint32_t* candidates, size_t n,
+             const Matrix4x4& viewProjection, uint32_t* visible, size_t threads = 0) const {
+   EU_TRACE_ZONE("OcclusionBuffer::testBoxes");
+   const size_t chunks = (n + detail::OCCLUSION_TEST_CHUNK - 1) / detail::OCCLUSION_TEST_CHUNK;
+   std::vector<size_t> found(chunks);
+   detail::parallelTasks(chunks, detail::resolveThreads(threads, chunks), [&](size_t c) {
+    const size_t begin = c * detail::OCCLUSION_TEST_CHUNK, end = std::min(n, begin + detail::OCCLUSION_TEST_CHUNK);
+    uint32_t* slice = visible + begin;
+    size_t count = 0;
+    for (size_t i = begin; i < end; ++i) {
+     const uint32_t k = candidates[i];
+     if (testBox(CVector3(lo.x[k], lo.y[k], lo.z[k]), CVector3(hi.x[k], hi.y[k], hi.z[k]), viewProjection)) slice[count++] = k;
+    }
+    found[c] = count;
+   });
+   size_t total = 0;
+   for (size_t c = 0; c < chunks; ++c) {
+    const uint32_t* slice = visible + c * detail::OCCLUSION_TEST_CHUNK;
+    for (size_t j = 0; j < found[c]; ++j) visible[total + j] = slice[j];
+    total += found[c];
+   }
+   return total;
+  }
+
+  private:
+  struct Draw {
+   const CVector3* vertices;
+   const uint32_t* indices;
+   size_t vertexCount;
+   size_t triangleCount;
+   size_t firstVertex;
+   size_t firstTriangle;
+   float rows[3][4]; ///< Rows x, y and w of the model-view-projection
+   bool cullBackFaces;
+  };
+
+  /** Clip-space x, y and w of every queued vertex into m_clipX/Y/W. */
+  void
+   transformVertices(size_t threads) {
+   m_clipX.resize(m_vertexCount);
+   m_clipY.resize(m_vertexCount);
+   m_clipW.resize(m_vertexCount);
+   m_vertexTasks.clear();
+   for (size_t d = 0; d < m_draws.size(); ++d) {
+    for (size_t v = 0; v < m_draws[d].vertexCount; v += detail::OCCLUSION_VERTEX_CHUNK) m_vertexTasks.push_back({ d, v });
+   }
+   detail::parallelTasks(m_vertexTasks.size(), detail::resolveThreads(threads, m_vertexTasks.size()), [&](size_t t) {
+    const Draw& draw = m_draws[m_vertexTasks[t].draw];
+    const size_t begin = m_vertexTasks[t].begin;
+    const size_t count = std::min(detail::OCCLUSION_VERTEX_CHUNK, draw.vertexCount - begin);
+    const size_t at = draw.firstVertex + begin;
+    detail::transform3(reinterpret_cast<const float*>(draw.vertices + begin),
+                       EngineMath::batch::SoA3{ m_clipX.data() + at, m_clipY.data() + at, m_clipW.data() + at }, count,
+                       draw.rows, true);
+   });
+  }
+
+  /** Clips, projects, sets up and bins triangle chunk c. */
+  void
+   setupChunk(size_t c) {
+   detail::OcclusionChunk& chunk = m_chunks[c];
+   chunk.triangles.clear();
+   const size_t begin = c * detail::OCCLUSION_TRIANGLE_CHUNK;
+   const size_t end = std::min(m_triangleCount, begin + detail::OCCLUSION_TRIANGLE_CHUNK);
+   size_t d = static_cast<size_t>(std::upper_bound(m_draws.begin(), m_draws.end(), begin, [](size_t t, const Draw& draw) {
+                                   return t < draw.firstTriangle;
+                                  }) - m_draws.begin()) - 1;
+   for (size_t t = begin; t < end; ++t) {
+    while (t >= m_draws[d].firstTriangle + m_draws[d].triangleCount) ++d;
+    const Draw& draw = m_draws[d];
+    const uint32_t* index = draw.indices + 3 * (t - draw.firstTriangle);
+    detail::OcclusionVertex v[3];
+    for (int k = 0; k < 3; ++k) {
+     const size_t at = draw.firstVertex + index[k];
+     v[k] = { m_clipX[at], m_clipY[at], m_clipW[at] };
+    }
+    clipTriangle(v, draw.cullBackFaces, chunk.triangles);
+   }
+   // Bin the chunk's triangles as CSR: count, prefix-sum, fill.
+   const size_t bins = static_cast<size_t>(m_binsX) * static_cast<size_t>(m_binsY);
+   chunk.binStart.assign(bins + 1, 0);
+   forEachBin(chunk, [&](size_t bin, uint32_t) { ++chunk.binStart[bin + 1]; });
+   for (size_t b = 0; b < bins; ++b) chunk.binStart[b + 1] += chunk.binStart[b];
+   chunk.binTriangles.resize(chunk.binStart[bins]);
+   chunk.cursor.assign(chunk.binStart.begin(), chunk.binStart.end() - 1);
+   forEachBin(chunk, [&](size_t bin, uint32_t i) { chunk.binTriangles[chunk.cursor[bin]++] = i; });
+  }
+
+  /** Calls fn(bin, triangle) for every bin each of chunk's triangles overlaps. */
+  template<typename Fn>
+  void
+   forEachBin(const detail::OcclusionChunk& chunk, Fn fn) const {
+   for (uint32_t i = 0; i < chunk.triangles.size(); ++i) {
+    const detail::OcclusionTriangle& tri = chunk.triangles[i];
+    for (int32_t by = tri.tileY0 / detail::OCCLUSION_BIN_TILES; by <= tri.tileY1 / detail::OCCLUSION_BIN_TILES; ++by) {
+     for (int32_t bx = tri.tileX0 / detail::OCCLUSION_BIN_TILES; bx <= tri.tileX1 / detail::OCCLUSION_BIN_TILES; ++bx) {
+      fn(static_cast<size_t>(by) * m_binsX + bx, i);
+     }
+    }
+   }
+  }
+
+  /** Rejects, near-clips and sets up one clip-space triangle, appending 0 to 2 to out. */
+  void
+   clipTriangle(const detail::OcclusionVertex* v, bool cullBackFaces, std::vector<detail::OcclusionTriangle>& out) const {
+   // Entirely outside one side plane, or behind the near plane.
+   if ((v[0].x > v[0].w && v[1].x > v[1].w && v[2].x > v[2].w) || (v[0].x < -v[0].w && v[1].x < -v[1].w && v[2].x < -v[2].w)
+       || (v[0].y > v[0].w && v[1].y > v[1].w && v[2].y > v[2].w) || (v[0].y < -v[0].w && v[1].y < -v[1].w && v[2].y < -v[2].w)) {
+    return;
+   }
+   const int inside = (v[0].w >= m_nearW) + (v[1].w >= m_nearW) + (v[2].w >= m_nearW);
+   if (inside == 3) {
+    setup(v[0], v[1], v[2], cullBackFaces, out);
+    return;
+   }
+   if (inside == 0) return;
+   // Sutherland-Hodgman against w = nearW keeps the winding: 3 or 4 vertices.
+   detail::OcclusionVertex poly[4];
+   int n = 0;
+   for (int k = 0; k < 3; ++k) {
+    const detail::OcclusionVertex& a = v[k];
+    const detail::OcclusionVertex& b = v[(k + 1) % 3];
+    const bool aIn = a.w >= m_nearW, bIn = b.w >= m_nearW;
+    if (aIn) poly[n++] = a;
+    if (aIn != bIn) {
+     const float s = (m_nearW - a.w) / (b.w - a.w);
+     poly[n++] = { a.x + (b.x - a.x) * s, a.y + (b.y - a.y) * s, m_nearW };
+    }
+   }
+   setup(poly[0], poly[1], poly[2], cullBackFaces, out);
+   if (n == 4) setup(poly[0], poly[2], poly[3], cullBackFaces, out);
+  }
+
+  /** Projects a triangle in front of the near plane and appends its raster setup to out. */
+  void
+   setup(const detail::OcclusionVertex& c0, const detail::OcclusionVertex& c1, const detail::OcclusionVertex& c2,
+         bool cullBackFaces, std::vector<detail::OcclusionTriangle>& out) const {
+   const float w = static_cast<float>(width()), h = static_cast<float>(height());
+   float x[3], y[3], z[3];
+   const detail::OcclusionVertex* c[3] = { &c0, &c1, &c2 };
+   for (int k = 0; k < 3; ++k) {
+    z[k] = 1.f / c[k]->w;
+    x[k] = (c[k]->x * z[k] * 0.5f + 0.5f) * w;
+    y[k] = (0.5f - c[k]->y * z[k] * 0.5f) * h;
+   }
+   // With y down, OpenGL front faces (counter-clockwise in NDC) have negative area.
+   float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+   if (area == 0.f || (cullBackFaces && area > 0.f)) return;
+   if (area < 0.f) {
+    std::swap(x[1], x[2]);
+    std::swap(y[1], y[2]);
+    std::swap(z[1], z[2]);
+    area = -area;
+   }
+   detail::OcclusionTriangle tri;
+   const float minX = std::min(std::min(x[0], x[1]), x[2]), maxX = std::max(std::max(x[0], x[1]), x[2]);
+   tri.top = std::min(std::min(y[0], y[1]), y[2]);
+   tri.bottom = std::max(std::max(y[0], y[1]), y[2]);
+   if (maxX <= 0.f || minX >= w || tri.bottom <= 0.f || tri.top >= h) return;
+   tri.tileX0 = std::max(EngineMath::floor(minX / OCCLUSION_TILE_WIDTH), 0);
+   tri.tileX1 = std::min(EngineMath::floor(maxX / OCCLUSION_TILE_WIDTH), m_tilesX - 1);
+   tri.tileY0 = std::max(EngineMath::floor(tri.top / OCCLUSION_TILE_HEIGHT), 0);
+   tri.tileY1 = std::min(EngineMath::floor(tri.bottom / OCCLUSION_TILE_HEIGHT), m_tilesY - 1);
+   // Positive area: an edge going down the screen bounds the span on the right.
+   int left = 0, right = 0;
+   tri.leftQ[0] = tri.leftQ[1] = Constants::NEG_INF;
+   tri.rightQ[0] = tri.rightQ[1] = Constants::INF;
+   tri.leftM[0] = tri.leftM[1] = tri.rightM[0] = tri.rightM[1] = 0.f;
+   for (int k = 0; k < 3; ++k) {
+    const int j = (k + 1) % 3;
+    const float dy = y[j] - y[k];
+    if (dy == 0.f) continue;
+    const float m = (x[j] - x[k]) / dy, q = x[k] - y[k] * m;
+    if (dy > 0.f) {
+     tri.rightQ[right] = q;
+     tri.rightM[right++] = m;
+    }
+    else {
+     tri.leftQ[left] = q;
+     tri.leftM[left++] = m;
+    }
+   }
+   const float dz1 = z[1] - z[0], dz2 = z[2] - z[0];
+   tri.a = (dz1 * (y[2] - y[0]) - dz2 * (y[1] - y[0])) / area;
+   tri.b = (dz2 * (x[1] - x[0]) - dz1 * (x[2] - x[0])) / area;
+   tri.c = z[0] - tri.a * x[0] - tri.b * y[0];
+   tri.farthest = std::min(std::min(z[0], z[1]), z[2]);
+   out.push_back(tri);
+  }
+
+  /** Rasterizes every triangle binned to bin, chunk by chunk in submission order. */
+  void
+   rasterizeBin(size_t bin, size_t chunks) {
+   const int32_t bx = static_cast<int32_t>(bin % m_binsX), by = static_cast<int32_t>(bin / m_binsX);
+   const int32_t binX0 = bx * detail::OCCLUSION_BIN_TILES, binY0 = by * detail::OCCLUSION_BIN_TILES;
+   const int32_t binX1 = std::min(binX0 + detail::OCCLUSION_BIN_TILES, m_tilesX) - 1;
+   const int32_t binY1 = std::min(binY0 + detail::OCCLUSION_BIN_TILES, m_tilesY) - 1;
+   for (size_t c = 0; c < chunks; ++c) {
+    const detail::OcclusionChunk& chunk = m_chunks[c];
+    for (uint32_t k = chunk.binStart[bin]; k < chunk.binStart[bin + 1]; ++k) {
+     const detail::OcclusionTriangle& tri = chunk.triangles[chunk.binTriangles[k]];
+     for (int32_t ty = std::max(tri.tileY0, binY0); ty <= std::min(tri.tileY1, binY1); ++ty) {
+      for (int32_t tx = std::max(tri.tileX0, binX0); tx <= std::min(tri.tileX1, binX1); ++tx) rasterizeTile(tri, tx, ty);
+     }
+    }
+   }
+  }
+
+  /** Coverage and depth of tri over tile (tx, ty), merged into the tile's layers. */
+  void
+   rasterizeTile(const detail::OcclusionTriangle& tri, int32_t tx, int32_t ty) {
+   detail::OcclusionTile& tile = m_tiles[static_cast<size_t>(ty) * m_tilesX + tx];
+   // Farthest depth over the tile: the plane's minimum at a tile corner, clamped to the triangle.
+   const float x0 = static_cast<float>(tx * OCCLUSION_TILE_WIDTH), y0 = static_cast<float>(ty * OCCLUSION_TILE_HEIGHT);
+   const float cornerX = tri.a > 0.f ? x0 : x0 + OCCLUSION_TILE_WIDTH, cornerY = tri.b > 0.f ? y0 : y0 + OCCLUSION_TILE_HEIGHT;
+   const float depth = std::max(tri.a * cornerX + tri.b * cornerY + tri.c, tri.farthest);
+   if (depth <= tile.layer0) return;
+
+   // Row spans for a register of rows at a time, relative to the tile, as pixel index ranges.
+   int32_t begin[OCCLUSION_TILE_HEIGHT], end[OCCLUSION_TILE_HEIGHT];
+   const detail::BatchLanes offset = detail::BatchLanes::set1(x0 + 0.5f), zero = detail::BatchLanes::zero();
+   const detail::BatchLanes full = detail::BatchLanes::set1(static_cast<float>(OCCLUSION_TILE_WIDTH));
+   const detail::BatchLanes lq0 = detail::BatchLanes::set1(tri.leftQ[0]), lm0 = detail::BatchLanes::set1(tri.leftM[0]);
+   const detail::BatchLanes lq1 = detail::BatchLanes::set1(tri.leftQ[1]), lm1 = detail::BatchLanes::set1(tri.leftM[1]);
+   const detail::BatchLanes rq0 = detail::BatchLanes::set1(tri.rightQ[0]), rm0 = detail::BatchLanes::set1(tri.rightM[0]);
+   const detail::BatchLanes rq1 = detail::BatchLanes::set1(tri.rightQ[1]), rm1 = detail::BatchLanes::set1(tri.rightM[1]);
+   const detail::BatchLanes top = detail::BatchLanes::set1(tri.top), bottom = detail::BatchLanes::set1(tri.bottom);
+   float rowY[detail::BATCH_WIDTH];
+   for (int r = 0; r < OCCLUSION_TILE_HEIGHT; r += static_cast<int>(detail::BATCH_WIDTH)) {
+    for (size_t k = 0; k < detail::BATCH_WIDTH; ++k) rowY[k] = y0 + static_cast<float>(r + static_cast<int>(k)) + 0.5f;
+    const detail::BatchLanes py = detail::BatchLanes::load(rowY);
+    detail::BatchLanes l = EU::SIMD::max(EU::SIMD::madd(lm0, py, lq0), EU::SIMD::madd(lm1, py, lq1)) - offset;
+    detail::BatchLanes rr = EU::SIMD::min(EU::SIMD::madd(rm0, py, rq0), EU::SIMD::madd(rm1, py, rq1)) - offset;
+    l = EU::SIMD::min(EU::SIMD::max(l, zero), full);
+    rr = EU::SIMD::min(EU::SIMD::max(rr, zero), full);
+    rr = EU::SIMD::select((py >= top) & (py < bottom), rr, zero);
+    // ceil() of values in [0, 32]: truncate, then add 1 (subtract the all-ones mask) where it dropped a fraction.
+    const detail::BatchInt lt = EU::SIMD::truncToInt(l), rt = EU::SIMD::truncToInt(rr);
+    (lt - EU::SIMD::asInt(EU::SIMD::toFloat(lt) < l)).store(begin + r);
+    (rt - EU::SIMD::asInt(EU::SIMD::toFloat(rt) < rr)).store(end + r);
+   }
+   uint32_t coverage[OCCLUSION_TILE_HEIGHT];
+   uint32_t any = 0;
+   for (int r = 0; r < OCCLUSION_TILE_HEIGHT; ++r) {
+    coverage[r] = begin[r] < end[r] ? detail::occlusionSpan(begin[r], end[r]) : 0u;
+    any |= coverage[r];
+   }
+   if (any == 0) return;
+
+   uint32_t fills = ~0u; // Whether the triangle and layer 1 together cover the tile
+   for (int r = 0; r < OCCLUSION_TILE_HEIGHT; ++r) fills &= coverage[r] | tile.mask[r];
+   if (depth < tile.layer1) {
+    // Farther than layer 1. Covering everything layer 1 does not, it raises layer 0 and
+    // layer 1 stays; otherwise it joins layer 1, or replaces it when nearer layer 0.
+    if (fills == ~0u) {
+     tile.layer0 = depth;
+     return;
+    }
+    const bool restart = tile.layer1 - depth > depth - tile.layer0;
+    for (int r = 0; r < OCCLUSION_TILE_HEIGHT; ++r) tile.mask[r] = restart ? coverage[r] : tile.mask[r] | coverage[r];
+    tile.layer1 = depth;
+    return;
+   }
+   // At least as near as layer 1: its pixels join layer 1, which becomes layer 0 once full.
+   if (fills == ~0u) {
+    tile.layer0 = tile.layer1;
+    tile.layer1 = Constants::INF;
+    std::fill(tile.mask, tile.mask + OCCLUSION_TILE_HEIGHT, 0u);
+    return;
+   }
+   for (int r = 0; r < OCCLUSION_TILE_HEIGHT; ++r) tile.mask[r] |= coverage[r];
+  }
+
+  struct VertexTask {
+   size_t draw;
+   size_t begin;
+  };
+
+  std::vector<detail::OcclusionTile> m_tiles;   ///< Row-major
+  std::vector<Draw> m_draws;                    ///< Queued since clear() or render()
+  std::vector<VertexTask> m_vertexTasks;
+  std::vector<float> m_clipX, m_clipY, m_clipW; ///< Clip space of the queued vertices, SoA
+  std::vector<detail::OcclusionChunk> m_chunks;
+  size_t m_vertexCount = 0;
+  size_t m_triangleCount = 0;
+  int32_t m_tilesX;
+  int32_t m_tilesY;
+  int32_t m_binsX;
+  int32_t m_binsY;
+  float m_nearW;
+ };
+}
@@ -0,0 +1,397 @@
+/**
+ * @file ParticleSystem.h
+ * @brief Emitters of SoA particles, simulated with ParticleIntegrate and drawn as one
+ * sf::VertexBuffer of billboards.
+ *
+ * Each emitter owns a pool: positions and velocities in Vector3Stream, remaining and inverse
+ * total lifetimes in float arrays. The z axis of a particle is its rotation in radians and
+ * z velocity its spin, so one integrateSemiImplicitEuler() call advances both (gravity has
+ * no z, and drag slows the spin too). A step ages every pool, swap-removes the expired
+ * particles with compactParticles(), integrates the survivors and spawns new ones from the
+ * emitter's own Random stream, so pools are independent tasks and the result does not
+ * depend on the thread count.
+ *
+ * Color and size interpolate from the emitter's start to end values over each particle's
+ * lifetime. computeVertices() evaluates them a register of particles at a time and writes
+ * six vertices (two triangles) per particle into a staging array reused from frame to frame,
+ * in emitter order, split into PARTICLE_BLOCK-sized tasks across every pool. upload()
+ * copies it into an sf::VertexBuffer with Stream usage that grows geometrically and persists.
+ * Emitters without spin skip the batched sincos.
+ *
+ * Coordinates are SFML's: y down, angles in radians clockwise on screen. Needs sfml-graphics
+ * at link time, and an active OpenGL context in upload() and draw().
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/VertexBuffer.hpp>
+#include <Core/Constants.h>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Graphics/SpriteBatch.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Random.h>
+#include <Vectors/ParticleIntegrate.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector3Stream.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ namespace detail {
+  /// Particles per vertex task; fixes the work split.
+  constexpr size_t PARTICLE_BLOCK = 4096;
+  /// Systems with fewer live particles than this are stepped on the calling thread.
+  constexpr size_t PARALLEL_PARTICLE_MIN = 1 << 14;
+
+  /** One emitter's particles. */
+  struct ParticlePool {
+   Vector3Stream position;        ///< x, y and rotation
+   Vector3Stream velocity;        ///< x, y and spin
+   std::vector<float> life;       ///< Remaining seconds
+   std::vector<float> inverseLife; ///< 1 / total seconds
+   Random random;
+   float pending = 0.f;           ///< Fraction of a particle owed by the emission rate
+
+   size_t
+    size() const {
+    return life.size();
+   }
+  };
+ }
+
+ /**
+  * @brief How an emitter spawns its particles and how they look over their lifetime.
+  */
+ struct ParticleEmitterDef {
+  CVector2 position;                          ///< Spawn center
+  float spawnRadius = 0.f;                    ///< Particles start uniformly inside this disk
+  float rate = 100.f;                         ///< Particles per second
+  size_t maxParticles = 10000;                ///< Live particles at most
+  float lifetimeMin = 1.f;                    ///< Seconds
+  float lifetimeMax = 2.f;
+  float direction = 0.f;                      ///< Radians, clockwise from +x
+  float spread = Constants::PI;               ///< Half-angle of the emission cone
+  float speedMin = 50.f;                      ///< Pixels per second
+  float speedMax = 100.f;
+  float spinMin = 0.f;                        ///< Radians per second
+  float spinMax = 0.f;
+  float sizeStart = 8.f;                      ///< Billboard edge in pixels
+  float sizeEnd = 2.f;
+  sf::Color colorStart = sf::Color::White;
+  sf::Color colorEnd = sf::Color(255, 255, 255, 0);
+  sf::FloatRect textureRect;                  ///< Texels each billboard shows
+  CVector2 gravity;                           ///< Pixels per second squared
+  float drag = 0.f;                           ///< Linear drag per second
+ };
+
+ /**
+  * @class ParticleSystem
+  * @brief Emitters and their particle pools, rendered as one vertex buffer.
+  */
+ class
+  ParticleSystem : public sf::Drawable {
+  public:
+  ParticleSystem() : m_texture(nullptr), m_buffer(sf::Triangles, sf::VertexBuffer::Stream), m_uploaded(0) {}
+
+  /**
+   * @brief Adds an emitter; seed and the emitter's index choose its Random stream.
+   * @return The emitter's index, always emitterCount() - 1.
+   */
+  size_t
+   addEmitter(const ParticleEmitterDef& def, uint64_t seed = Random::DEFAULT_SEED) {
+   const size_t i = m_emitters.size();
+   m_emitters.push_back(def);
+   m_pools.emplace_back();
+   m_pools.back().random = Random(seed, i + 1);
+   m_offsets.push_back(0);
+   return i;
+  }
+
+  size_t
+   emitterCount() const {
+   return m_emitters.size();
+  }
+
+  /** @brief Settings of emitter i; changes apply from the next step. */
+  ParticleEmitterDef&
+   emitter(size_t i) {
+   return m_emitters[i];
+  }
+
+  const ParticleEmitterDef&
+   emitter(size_t i) const {
+   return m_emitters[i];
+  }
+
+  /** @brief Live particles of emitter i. */
+  size_t
+   particleCount(size_t i) const {
+   return m_pools[i].size();
+  }
+
+  /** @brief Live particles of every emitter. */
+  size_t
+   particleCount() const {
+   size_t n = 0;
+   for (const detail::ParticlePool& pool : m_pools) n += pool.size();
+   return n;
+  }
+
+  /** @brief Spawns count particles from emitter i now, up to its maxParticles. */
+  void
+   burst(size_t i, size_t count) {
+   spawn(m_emitters[i], m_pools[i], count);
+  }
+
+  /** @brief Kills every particle; emitters and buffers are kept. */
+  void
+   clearParticles() {
+   for (detail::ParticlePool& pool : m_pools) {
+    pool.position.clear();
+    pool.velocity.clear();
+    pool.life.clear();
+    pool.inverseLife.clear();
+    pool.pending = 0.f;
+   }
+   m_vertices.clear();
+   m_uploaded = 0;
+  }
+
+  /** @brief Texture every billboard samples from, or nullptr for plain quads. */
+  void
+   setTexture(const sf::Texture* texture) {
+   m_texture = texture;
+  }
+
+  /**
+   * @brief Ages, removes, integrates and spawns the particles of every emitter.
+   *
+   * Emitters are tasks over threads (0 = hardware_concurrency(), 1 = caller only) once the
+   * system holds PARALLEL_PARTICLE_MIN particles.
+   */
+  void
+   simulate(float dt, size_t threads = 0) {
+   auto run = [&](size_t e) { step(m_emitters[e], m_pools[e], dt); };
+   threads = detail::resolveThreads(threads, m_pools.size());
+   if (particleCount() < detail::PARALLEL_PARTICLE_MIN || threads <= 1) {
+    for (size_t e = 0; e < m_pools.size(); ++e) run(e);
+    return;
+   }
+   detail::parallelTasks(m_pools.size(), threads, run);
+  }
+
+  /**
+   * @brief Rebuilds the staging vertices, six per live particle in emitter order.
+   *
+   * Split into PARTICLE_BLOCK-sized tasks across all emitters, so one large emitter still
+   * spreads over the threads.
+   */
+  void
+   computeVertices(size_t threads = 0) {
+   size_t total = 0;
+   for (size_t e = 0; e < m_pools.size(); ++e) {
+    m_offsets[e] = total;
+    total += m_pools[e].size();
+   }
+   m_vertices.resize(total * detail::SPRITE_VERTICES);
+   const size_t blocks = (total + detail::PARTICLE_BLOCK - 1) / detail::PARTICLE_BLOCK;
+   auto run = [&](size_t block) {
+    const size_t begin = block * detail::PARTICLE_BLOCK;
+    const size_t end = total - begin < detail::PARTICLE_BLOCK ? total : begin + detail::PARTICLE_BLOCK;
+    // Emitters overlapping [begin, end): the last one starting at or before begin onwards.
+    size_t e = static_cast<size_t>(std::upper_bound(m_offsets.begin(), m_offsets.end(), begin) - m_offsets.begin()) - 1;
+    for (size_t i = begin; i < end; ++e) {
+     const size_t stop = std::min(end, m_offsets[e] + m_pools[e].size());
+     if (stop > i) writeBillboards(m_emitters[e], m_pools[e], i - m_offsets[e], stop - m_offsets[e], &m_vertices[i * detail::SPRITE_VERTICES]);
+     i = std::max(i, stop);
+    }
+   };
+   threads = detail::resolveThreads(threads, blocks);
+   if (total < detail::PARALLEL_PARTICLE_MIN || threads <= 1) {
+    for (size_t block = 0; block < blocks; ++block) run(block);
+    return;
+   }
+   detail::parallelTasks(blocks, threads, run);
+  }
+
+  /**
+   * @brief Copies the staging vertices into the vertex buffer, growing it geometrically.
+   * @return False when vertex buffers are unsupported or the upload failed; draw() then
+   * falls back to drawing the staging array.
+   */
+  bool
+   upload() {
+   m_uploaded = 0;
+   if (!sf::VertexBuffer::isAvailable()) {
+    return false;
+   }
+   const size_t count = m_vertices.size();
+   if (count > m_buffer.getVertexCount()) {
+    const size_t grown = m_buffer.getVertexCount() + m_buffer.getVertexCount() / 2;
+    if (!m_buffer.create(count > grown ? count : grown)) {
+     return false;
+    }
+   }
+   if (count != 0 && !m_buffer.update(m_vertices.data(), count, 0)) {
+    return false;
+   }
+   m_uploaded = count;
+   return true;
+  }
+
+  /** @brief simulate(), computeVertices() and upload(). */
+  bool
+   update(float dt, size_t threads = 0) {
+   simulate(dt, threads);
+   computeVertices(threads);
+   return upload();
+  }
+
+  /** @brief The staging vertices, six per particle. */
+  const std::vector<sf::Vertex>&
+   vertices() const {
+   return m_vertices;
+  }
+
+  private:
+  void
+   draw(sf::RenderTarget& target, sf::RenderStates states) const override {
+   states.texture = m_texture;
+   if (m_uploaded == m_vertices.size() && m_uploaded != 0) {
+    target.draw(m_buffer, 0, m_uploaded, states);
+   }
+   else if (!m_vertices.empty()) {
+    target.draw(m_vertices.data(), m_vertices.size(), sf::Triangles, states);
+   }
+  }
+
+  static void
+   step(const ParticleEmitterDef& def, detail::ParticlePool& pool, float dt) {
+   size_t n = pool.size();
+   if (n != 0 && ageParticles(pool.life.data(), n, dt) != 0) {
+    n = compactParticles(pool.life.data(), n, pool.position, pool.velocity, pool.inverseLife);
+    pool.life.resize(n);
+   }
+   if (n != 0) {
+    ParticleForces forces;
+    forces.gravity = CVector3(def.gravity.x, def.gravity.y, 0.f);
+    forces.drag = def.drag;
+    integrateSemiImplicitEuler(pool.position, pool.velocity, nullptr, forces, dt);
+   }
+   pool.pending += def.rate * dt;
+   const size_t due = pool.pending > 0.f ? static_cast<size_t>(pool.pending) : 0;
+   pool.pending -= static_cast<float>(due);
+   spawn(def, pool, due);
+  }
+
+  static void
+   spawn(const ParticleEmitterDef& def, detail::ParticlePool& pool, size_t count) {
+   const size_t n = pool.size();
+   count = std::min(count, def.maxParticles > n ? def.maxParticles - n : size_t(0));
+   if (count == 0) return;
+   pool.position.reserve(n + count);
+   pool.velocity.reserve(n + count);
+   pool.life.reserve(n + count);
+   pool.inverseLife.reserve(n + count);
+   Random& random = pool.random;
+   for (size_t k = 0; k < count; ++k) {
+    const CVector2 offset = def.spawnRadius > 0.f ? random.inUnitDisk() * def.spawnRadius : CVector2();
+    float s = 0.f, c = 0.f;
+    EngineMath::sincos(def.direction + def.spread * (2.f * random.nextFloat() - 1.f), &s, &c);
+    const float speed = random.range(def.speedMin, def.speedMax);
+    const float life = random.range(def.lifetimeMin, def.lifetimeMax);
+    const float spin = def.spinMin == def.spinMax ? def.spinMin : random.range(def.spinMin, def.spinMax);
+    const float rotation = def.spinMin == 0.f && def.spinMax == 0.f ? 0.f : Constants::TWO_PI * random.nextFloat();
+    pool.position.push_back(CVector3(def.position.x + offset.x, def.position.y + offset.y, rotation));
+    pool.velocity.push_back(CVector3(c * speed, s * speed, spin));
+    pool.life.push_back(life > 0.f ? life : 0.f);
+    pool.inverseLife.push_back(life > 0.f ? 1.f / life : 0.f);
+   }
+  }
+
+  /**
+   * Billboards of particles [begin, end) of one pool into out, a register at a time: the
+   * corners are center +- rotated half size, the color the lifetime blend of the emitter's.
+   */
+  static void
+   writeBillboards(const ParticleEmitterDef& def, const detail::ParticlePool& pool, size_t begin, size_t end,
+                   sf::Vertex* out) {
+   using detail::BatchLanes;
+   using detail::BATCH_WIDTH;
+   const bool spins = def.spinMin != 0.f || def.spinMax != 0.f;
+   const BatchLanes one = BatchLanes::set1(1.f), zero = BatchLanes::zero();
+   const BatchLanes size0 = BatchLanes::set1(0.5f * def.sizeStart);
+   const BatchLanes sizeDelta = BatchLanes::set1(0.5f * (def.sizeEnd - def.sizeStart));
+   const sf::Uint8 start[4] = { def.colorStart.r, def.colorStart.g, def.colorStart.b, def.colorStart.a };
+   const sf::Uint8 finish[4] = { def.colorEnd.r, def.colorEnd.g, def.colorEnd.b, def.colorEnd.a };
+   const sf::FloatRect& rect = def.textureRect;
+   const sf::Vector2f texel[4] = { { rect.left, rect.top }, { rect.left + rect.width, rect.top },
+                                   { rect.left + rect.width, rect.top + rect.height },
+                                   { rect.left, rect.top + rect.height } };
+   for (size_t i = begin; i < end; i += BATCH_WIDTH) {
+    const size_t count = end - i < BATCH_WIDTH ? end - i : BATCH_WIDTH;
+    // Normalized age, 0 at spawn and 1 at death.
+    const BatchLanes age = EU::SIMD::min(one, EU::SIMD::max(zero, one - detail::loadLanes(pool.life.data(), i, count) *
+                                                                        detail::loadLanes(pool.inverseLife.data(), i, count)));
+    const BatchLanes half = EU::SIMD::madd(age, sizeDelta, size0);
+    BatchLanes a = half, b = zero;
+    if (spins) {
+     BatchLanes s, c;
+     EngineMath::batch::kernels::sincos(detail::loadLanes(pool.position.z(), i, count), s, c);
+     a = c * half;
+     b = s * half;
+    }
+    const BatchLanes x = detail::loadLanes(pool.position.x(), i, count);
+    const BatchLanes y = detail::loadLanes(pool.position.y(), i, count);
+    // Corners (-h, -h), (h, -h), (h, h), (-h, h) rotated: (a, b) is the rotated (h, 0).
+    float corner[8][BATCH_WIDTH];
+    (x - a + b).store(corner[0]);
+    (y - b - a).store(corner[1]);
+    (x + a + b).store(corner[2]);
+    (y + b - a).store(corner[3]);
+    (x + a - b).store(corner[4]);
+    (y + b + a).store(corner[5]);
+    (x - a - b).store(corner[6]);
+    (y - b + a).store(corner[7]);
+    float channel[4][BATCH_WIDTH];
+    for (int k = 0; k < 4; ++k) {
+     EU::SIMD::madd(age, BatchLanes::set1(static_cast<float>(finish[k] - start[k])),
+                    BatchLanes::set1(static_cast<float>(start[k]) + 0.5f)).store(channel[k]);
+    }
+    for (size_t j = 0; j < count; ++j) {
+     const sf::Color color(static_cast<sf::Uint8>(channel[0][j]), static_cast<sf::Uint8>(channel[1][j]),
+                           static_cast<sf::Uint8>(channel[2][j]), static_cast<sf::Uint8>(channel[3][j]));
+     sf::Vertex* v = out + (i - begin + j) * detail::SPRITE_VERTICES;
+     for (size_t k = 0; k < detail::SPRITE_VERTICES; ++k) {
+      const int q = detail::spriteCorner(k);
+      v[k].position.x = corner[2 * q][j];
+      v[k].position.y = corner[2 * q + 1][j];
+      v[k].color = color;
+      v[k].texCoords = texel[q];
+     }
+    }
+   }
+  }
+
+  std::vector<ParticleEmitterDef> m_emitters;
+  std::vector<detail::ParticlePool> m_pools;
+  std::vector<size_t> m_offsets;      ///< First particle of each emitter in the vertex order
+  std::vector<sf::Vertex> m_vertices; ///< Staging copy of the vertex buffer
+  const sf::Texture* m_texture;
+  sf::VertexBuffer m_buffer;
+  size_t m_uploaded;                  ///< Vertices in m_buffer that match m_vertices
+ };
+}
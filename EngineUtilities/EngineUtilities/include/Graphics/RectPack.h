@@ -0,0 +1,417 @@
+/**
+ * @file RectPack.h
+ * @brief Texture atlas packing: a skyline packer for incremental glyph and sprite caches, a
+ * MaxRects packer for tight atlases, and a sorted batch mode over both.
+ *
+ * Both packers place integer-sized rectangles into a fixed width x height atlas, one insert()
+ * at a time, and never move what they placed, so an atlas texture can be updated in place
+ * (sf::Texture::update() with the rect's position) as new glyphs or sprites arrive.
+ *
+ * SkylinePacker keeps the top outline of what it placed as a list of horizontal segments and
+ * puts each rectangle where its top edge ends up lowest (bottom-left rule), so an insert costs
+ * a walk over the segments. Space under an overhang is lost, which suits streams of
+ * similar-height items such as the glyphs of one font size.
+ *
+ * MaxRectsPacker (Jylänki, "A Thousand Ways to Pack the Bin") keeps every maximal free
+ * rectangle and places each rectangle in the free one it fits tightest (best short side fit).
+ * The placed rectangle is cut out of every free one it overlaps; only the new pieces are
+ * checked for containment, against the whole list, since no older free rectangle contains
+ * another. It wastes much less than a shelf or a skyline on mixed sizes, at a few times the
+ * cost per insert, and can rotate rectangles by 90 degrees when the caller's UVs allow it.
+ *
+ * packRects() is the offline mode: it sorts the whole set, largest first, and inserts it in
+ * that order, which packs markedly tighter than arrival order. With the skyline a few thousand
+ * sprites repack in well under a millisecond. MaxRects' cost grows with its free list: glyph
+ * sized sets and a few hundred sprites stay near a millisecond, a few thousand mixed sizes in a
+ * 2048x2048 atlas take tens of milliseconds for a slightly smaller atlas.
+ *
+ * Padding is added to the right of and below every rectangle, and the atlas edge counts as
+ * padding, so neighbours never share a texel under bilinear filtering.
+ *
+ *   SkylinePacker glyphs(1024, 1024, 1);
+ *   PackedRect r;
+ *   if (!glyphs.insert(int(bitmap.width), int(bitmap.rows), r)) rebuildLargerAtlas();
+ *   texture.update(bitmap.pixels, bitmap.width, bitmap.rows, r.x, r.y);
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+#include <Math/EngineMath.h>
+#include <Vectors/Vector.h>
+#include <Vectors/Vector2.h>
+
+namespace EU {
+ /// Bits of each field of MaxRectsPacker's fit keys: atlas sides and free list stay below 2^20.
+ constexpr int RECT_PACK_KEY_BITS = 20;
+ /// Largest atlas side (padding included) plus one.
+ constexpr int32_t RECT_PACK_MAX_SIDE = int32_t(1) << RECT_PACK_KEY_BITS;
+
+ /**
+  * @struct PackedRect
+  * @brief Where a rectangle went; x and y are -1 when it did not fit.
+  */
+ struct PackedRect {
+  int32_t x = -1;
+  int32_t y = -1;
+  int32_t width = 0;    ///< As placed: the requested height when rotated
+  int32_t height = 0;
+  bool rotated = false; ///< Turned by 90 degrees (MaxRectsPacker with rotation only)
+
+  constexpr bool packed() const { return x >= 0; }
+ };
+
+ /** @brief Packer packRects() uses. */
+ enum class RectPackMethod : uint8_t {
+  Skyline, ///< Fastest, the default; sorts by height
+  MaxRects ///< Tightest, cost grows with the free list; sorts by longer side
+ };
+
+ namespace detail {
+  inline int32_t
+   packSize(float size) {
+   return size > 0.f ? EngineMath::ceil(size) : 0;
+  }
+ }
+
+ /**
+  * @class SkylinePacker
+  * @brief Bottom-left skyline packer, for incremental caches.
+  */
+ class
+  SkylinePacker {
+  public:
+  /** @brief Empty atlas of width x height texels with padding texels around every rectangle. */
+  explicit SkylinePacker(int32_t width = 0, int32_t height = 0, int32_t padding = 0) {
+   reset(width, height, padding);
+  }
+
+  /** @brief Forgets every rectangle, optionally resizing the atlas. */
+  void
+   reset(int32_t width, int32_t height, int32_t padding = 0) {
+   m_width = std::max(width, 0);
+   m_height = std::max(height, 0);
+   m_padding = std::max(padding, 0);
+   m_used = 0;
+   m_skyline.assign(1, Segment{ 0, 0, m_width + m_padding });
+  }
+
+  int32_t width() const { return m_width; }
+  int32_t height() const { return m_height; }
+
+  /** @brief Places a width x height rectangle; false (out untouched) when it does not fit. */
+  bool
+   insert(int32_t width, int32_t height, PackedRect& out) {
+   if (width <= 0 || height <= 0) return false;
+   const int32_t w = width + m_padding, h = height + m_padding;
+   size_t bestIndex = m_skyline.size();
+   int32_t bestTop = INT32_MAX, bestWidth = INT32_MAX, bestY = 0;
+   for (size_t i = 0; i < m_skyline.size(); ++i) {
+    int32_t y;
+    if (!fits(i, w, h, y)) continue;
+    const int32_t top = y + h;
+    if (top < bestTop || (top == bestTop && m_skyline[i].width < bestWidth)) {
+     bestIndex = i;
+     bestTop = top;
+     bestWidth = m_skyline[i].width;
+     bestY = y;
+    }
+   }
+   if (bestIndex == m_skyline.size()) return false;
+   out.x = m_skyline[bestIndex].x;
+   out.y = bestY;
+   out.width = width;
+   out.height = height;
+   out.rotated = false;
+   place(bestIndex, out.x, w, bestTop);
+   m_used += int64_t(width) * height;
+   return true;
+  }
+
+  /** @brief insert() of a float size, rounded up to whole texels. */
+  bool
+   insert(const CVector2& size, PackedRect& out) {
+   return insert(detail::packSize(size.x), detail::packSize(size.y), out);
+  }
+
+  /** @brief Fraction of the atlas covered by rectangles, padding excluded. */
+  float
+   occupancy() const {
+   const int64_t area = int64_t(m_width) * m_height;
+   return area ? static_cast<float>(static_cast<double>(m_used) / static_cast<double>(area)) : 0.f;
+  }
+
+  private:
+  struct Segment {
+   int32_t x, y, width;
+  };
+
+  /** True when a w x h rectangle fits with its left edge on segment i; y is where it rests. */
+  bool
+   fits(size_t i, int32_t w, int32_t h, int32_t& y) const {
+   const int32_t x = m_skyline[i].x;
+   if (x + w > m_width + m_padding) return false;
+   y = 0;
+   for (int32_t left = w; left > 0; ++i) {
+    if (i == m_skyline.size()) return false;
+    y = std::max(y, m_skyline[i].y);
+    if (y + h > m_height + m_padding) return false;
+    left -= m_skyline[i].width;
+   }
+   return true;
+  }
+
+  /** Raises the skyline over [x, x + w) to top, starting at segment i. */
+  void
+   place(size_t i, int32_t x, int32_t w, int32_t top) {
+   m_skyline.insert(m_skyline.begin() + static_cast<std::ptrdiff_t>(i), Segment{ x, top, w });
+   // Trim or drop the segments now under the new one.
+   const int32_t end = x + w;
+   size_t j = i + 1;
+   while (j < m_skyline.size() && m_skyline[j].x < end) {
+    Segment& s = m_skyline[j];
+    const int32_t segmentEnd = s.x + s.width;
+    if (segmentEnd <= end) {
+     ++j;
+     continue;
+    }
+    s.width = segmentEnd - end;
+    s.x = end;
+    break;
+   }
+   m_skyline.erase(m_skyline.begin() + static_cast<std::ptrdiff_t>(i + 1), m_skyline.begin() + static_cast<std::ptrdiff_t>(j));
+   // Merge equal heights so the walk stays short.
+   if (i + 1 < m_skyline.size() && m_skyline[i + 1].y == top) {
+    m_skyline[i].width += m_skyline[i + 1].width;
+    m_skyline.erase(m_skyline.begin() + static_cast<std::ptrdiff_t>(i + 1));
+   }
+   if (i > 0 && m_skyline[i - 1].y == top) {
+    m_skyline[i - 1].width += m_skyline[i].width;
+    m_skyline.erase(m_skyline.begin() + static_cast<std::ptrdiff_t>(i));
+   }
+  }
+
+  std::vector<Segment> m_skyline; ///< Left to right, covering [0, width + padding)
+  int32_t m_width;
+  int32_t m_height;
+  int32_t m_padding;
+  int64_t m_used;
+ };
+
+ /**
+  * @class MaxRectsPacker
+  * @brief Maximal-rectangles packer with best short side fit.
+  */
+ class
+  MaxRectsPacker {
+  public:
+  /**
+   * @brief Empty atlas of width x height texels with padding texels around every rectangle.
+   * @param allowRotation Let insert() turn rectangles by 90 degrees when that fits better.
+   */
+  explicit MaxRectsPacker(int32_t width = 0, int32_t height = 0, int32_t padding = 0, bool allowRotation = false) {
+   reset(width, height, padding, allowRotation);
+  }
+
+  /** @brief Forgets every rectangle, optionally resizing the atlas (sides below RECT_PACK_MAX_SIDE). */
+  void
+   reset(int32_t width, int32_t height, int32_t padding = 0, bool allowRotation = false) {
+   m_padding = std::min(std::max(padding, 0), RECT_PACK_MAX_SIDE / 2);
+   m_width = std::min(std::max(width, 0), RECT_PACK_MAX_SIDE - m_padding);
+   m_height = std::min(std::max(height, 0), RECT_PACK_MAX_SIDE - m_padding);
+   m_rotate = allowRotation;
+   m_used = 0;
+   m_x.clear();
+   m_y.clear();
+   m_right.clear();
+   m_bottom.clear();
+   // The atlas edge stands in for the padding of the last row and column.
+   if (m_width && m_height) append({ 0, 0, m_width + m_padding, m_height + m_padding });
+  }
+
+  int32_t width() const { return m_width; }
+  int32_t height() const { return m_height; }
+
+  /** @brief Places a width x height rectangle; false (out untouched) when it does not fit. */
+  bool
+   insert(int32_t width, int32_t height, PackedRect& out) {
+   if (width <= 0 || height <= 0 || width >= RECT_PACK_MAX_SIDE || height >= RECT_PACK_MAX_SIDE) return false;
+   const int32_t w = width + m_padding, h = height + m_padding;
+   uint64_t best = bestFit(w, h);
+   bool rotated = false;
+   if (m_rotate && w != h) {
+    const uint64_t turned = bestFit(h, w);
+    rotated = turned < best;
+    best = rotated ? turned : best;
+   }
+   if (best == NO_FIT) return false;
+   const size_t i = static_cast<size_t>(best & (RECT_PACK_MAX_SIDE - 1));
+   out.x = m_x[i];
+   out.y = m_y[i];
+   out.width = rotated ? height : width;
+   out.height = rotated ? width : height;
+   out.rotated = rotated;
+   cut({ out.x, out.y, out.x + out.width + m_padding, out.y + out.height + m_padding });
+   m_used += int64_t(width) * height;
+   return true;
+  }
+
+  /** @brief insert() of a float size, rounded up to whole texels. */
+  bool
+   insert(const CVector2& size, PackedRect& out) {
+   return insert(detail::packSize(size.x), detail::packSize(size.y), out);
+  }
+
+  /** @brief Fraction of the atlas covered by rectangles, padding excluded. */
+  float
+   occupancy() const {
+   const int64_t area = int64_t(m_width) * m_height;
+   return area ? static_cast<float>(static_cast<double>(m_used) / static_cast<double>(area)) : 0.f;
+  }
+
+  /** @brief Number of maximal free rectangles, the cost driver of insert(). */
+  size_t freeCount() const { return m_x.size(); }
+
+  private:
+  static constexpr uint64_t NO_FIT = ~uint64_t(0);
+
+  /** Corners of a free rectangle: [x, right) x [y, bottom). */
+  struct Box {
+   int32_t x, y, right, bottom;
+
+   constexpr bool
+    contains(const Box& o) const {
+    return o.x >= x && o.y >= y && o.right <= right && o.bottom <= bottom;
+   }
+  };
+
+  void
+   append(const Box& box) {
+   m_x.push_back(box.x);
+   m_y.push_back(box.y);
+   m_right.push_back(box.right);
+   m_bottom.push_back(box.bottom);
+  }
+
+  /**
+   * Best short side fit of a w x h rectangle as one key, (short leftover, long leftover,
+   * index) from the top bits down, so a branch-free minimum over the list picks it; NO_FIT
+   * when nothing fits.
+   */
+  uint64_t
+   bestFit(int32_t w, int32_t h) const {
+   const size_t n = m_x.size();
+   const int32_t* x = m_x.data();
+   const int32_t* y = m_y.data();
+   const int32_t* right = m_right.data();
+   const int32_t* bottom = m_bottom.data();
+   uint64_t best = NO_FIT;
+   for (size_t i = 0; i < n; ++i) {
+    const int32_t dx = right[i] - x[i] - w, dy = bottom[i] - y[i] - h;
+    const uint64_t shortSide = static_cast<uint32_t>(dx < dy ? dx : dy), longSide = static_cast<uint32_t>(dx < dy ? dy : dx);
+    const uint64_t key = shortSide << (2 * RECT_PACK_KEY_BITS) | longSide << RECT_PACK_KEY_BITS | i;
+    best = (dx | dy) >= 0 && key < best ? key : best;
+   }
+   return best;
+  }
+
+  /** Removes used from every free rectangle, keeping the list maximal and containment-free. */
+  void
+   cut(const Box& used) {
+   const size_t count = m_x.size();
+   m_pieces.clear();
+   size_t kept = 0;
+   for (size_t i = 0; i < count; ++i) {
+    const Box f{ m_x[i], m_y[i], m_right[i], m_bottom[i] };
+    if (used.x >= f.right || used.right <= f.x || used.y >= f.bottom || used.bottom <= f.y) {
+     m_x[kept] = f.x;
+     m_y[kept] = f.y;
+     m_right[kept] = f.right;
+     m_bottom[kept] = f.bottom;
+     ++kept;
+     continue;
+    }
+    if (used.x > f.x) m_pieces.push_back({ f.x, f.y, used.x, f.bottom });
+    if (used.right < f.right) m_pieces.push_back({ used.right, f.y, f.right, f.bottom });
+    if (used.y > f.y) m_pieces.push_back({ f.x, f.y, f.right, used.y });
+    if (used.bottom < f.bottom) m_pieces.push_back({ f.x, used.bottom, f.right, f.bottom });
+   }
+   m_x.resize(kept);
+   m_y.resize(kept);
+   m_right.resize(kept);
+   m_bottom.resize(kept);
+   // Untouched rectangles never contain each other, and a piece cannot contain one of them,
+   // so each piece only has to be checked against the list and the other pieces.
+   for (size_t p = 0; p < m_pieces.size(); ++p) {
+    const Box& piece = m_pieces[p];
+    bool contained = false;
+    for (size_t q = 0; q < m_pieces.size() && !contained; ++q) {
+     // Of two equal pieces keep the first.
+     contained = q != p && m_pieces[q].contains(piece) && (q < p || !piece.contains(m_pieces[q]));
+    }
+    if (!contained && !containedInList(piece, kept)) append(piece);
+   }
+  }
+
+  /** True when one of the first count free rectangles contains box; branch-free. */
+  bool
+   containedInList(const Box& box, size_t count) const {
+   const int32_t* x = m_x.data();
+   const int32_t* y = m_y.data();
+   const int32_t* right = m_right.data();
+   const int32_t* bottom = m_bottom.data();
+   int32_t any = 0;
+   for (size_t i = 0; i < count; ++i) {
+    any |= (x[i] <= box.x) & (y[i] <= box.y) & (right[i] >= box.right) & (bottom[i] >= box.bottom);
+   }
+   return any != 0;
+  }
+
+  std::vector<int32_t> m_x, m_y, m_right, m_bottom; ///< The free rectangles, SoA
+  std::vector<Box> m_pieces;                         ///< Scratch of cut()
+  int32_t m_width;
+  int32_t m_height;
+  int32_t m_padding;
+  bool m_rotate;
+  int64_t m_used;
+ };
+
+ /**
+  * @brief Packs n rectangles of sizes into one width x height atlas, largest first.
+  * @param out n results in input order; the ones that did not fit are left unpacked.
+  * @param allowRotation MaxRects only: let rectangles turn by 90 degrees.
+  * @return Number of rectangles placed.
+  */
+ inline size_t
+  packRects(const Vector2i* sizes, size_t n, int32_t width, int32_t height, PackedRect* out,
+            RectPackMethod method = RectPackMethod::Skyline, int32_t padding = 0, bool allowRotation = false) {
+  std::vector<uint32_t> order(n);
+  std::iota(order.begin(), order.end(), 0u);
+  if (method == RectPackMethod::Skyline) {
+   std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return sizes[a].y != sizes[b].y ? sizes[a].y > sizes[b].y : sizes[a].x > sizes[b].x;
+   });
+  }
+  else {
+   std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    const int32_t longA = std::max(sizes[a].x, sizes[a].y), longB = std::max(sizes[b].x, sizes[b].y);
+    return longA != longB ? longA > longB : std::min(sizes[a].x, sizes[a].y) > std::min(sizes[b].x, sizes[b].y);
+   });
+  }
+  for (size_t i = 0; i < n; ++i) out[i] = PackedRect();
+  size_t placed = 0;
+  if (method == RectPackMethod::Skyline) {
+   SkylinePacker packer(width, height, padding);
+   for (const uint32_t i : order) placed += packer.insert(sizes[i].x, sizes[i].y, out[i]);
+  }
+  else {
+   MaxRectsPacker packer(width, height, padding, allowRotation);
+   for (const uint32_t i : order) placed += packer.insert(sizes[i].x, sizes[i].y, out[i]);
+  }
+  return placed;
+ }
+}
@@ -0,0 +1,321 @@
+/**
+ * @file SpriteBatch.h
+ * @brief Thousands of textured quads drawn with one sf::VertexBuffer draw call.
+ *
+ * A SpriteBatch keeps what sf::Sprite/sf::Transformable keep per sprite (position, rotation,
+ * scale, origin, texture rect, color) as structure-of-arrays. computeVertices() builds every
+ * sprite's transform, the Matrix3x3 that transform(i) returns, one register of sprites at a
+ * time. A single batched sincos covers the whole register. The four corners then go straight
+ * into a staging vertex array that is reused from frame to frame. upload() copies the array
+ * into an sf::VertexBuffer that also persists, so drawing the batch is one draw call
+ * instead of one per sprite.
+ *
+ * Each quad is two triangles (six vertices): sf::Quads is deprecated and missing on OpenGL ES.
+ * Texture coordinates and colors are written when they change, so the per-frame pass only
+ * touches positions. Rotation is in radians, clockwise on screen (y down) like SFML. The
+ * bulk arrays (positions(), rotations(), scales(), origins()) can be written directly by
+ * SoA systems; the next computeVertices() picks the changes up.
+ *
+ * Needs sfml-graphics at link time, and an active OpenGL context in upload() and draw().
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/VertexBuffer.hpp>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Matrix3x3.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ namespace detail {
+  /// Sprites per vertex task; fixes the work split.
+  constexpr size_t SPRITE_BLOCK = 1024;
+  /// Batches smaller than this are built on the calling thread.
+  constexpr size_t PARALLEL_SPRITE_MIN = 1 << 14;
+  /// Vertices per sprite: two triangles.
+  constexpr size_t SPRITE_VERTICES = 6;
+
+  /** Quad corner (0 = top-left, then clockwise) that sprite vertex k sits on. */
+  constexpr int
+   spriteCorner(size_t k) {
+   return k < 3 ? static_cast<int>(k) : (k == 3 ? 0 : static_cast<int>(k) - 2);
+  }
+ }
+
+ /**
+  * @class SpriteBatch
+  * @brief SoA sprite store that renders as one vertex buffer.
+  */
+ class
+  SpriteBatch : public sf::Drawable {
+  public:
+  SpriteBatch() : m_texture(nullptr), m_buffer(sf::Triangles, sf::VertexBuffer::Stream), m_uploaded(0) {}
+
+  /**
+   * @brief Adds a sprite showing textureRect (in texels) of the batch texture.
+   * @return The sprite's index, always size() - 1.
+   */
+  size_t
+   add(const CVector2& position, const sf::FloatRect& textureRect, const sf::Color& color = sf::Color::White) {
+   const size_t i = m_px.size();
+   m_px.push_back(position.x);
+   m_py.push_back(position.y);
+   m_rotation.push_back(0.f);
+   m_sx.push_back(1.f);
+   m_sy.push_back(1.f);
+   m_ox.push_back(0.f);
+   m_oy.push_back(0.f);
+   m_width.push_back(0.f);
+   m_height.push_back(0.f);
+   m_vertices.resize(m_vertices.size() + detail::SPRITE_VERTICES);
+   setTextureRect(i, textureRect);
+   setColor(i, color);
+   return i;
+  }
+
+  /** @brief Number of sprites. */
+  size_t
+   size() const {
+   return m_px.size();
+  }
+
+  /** @brief Reserves room for n sprites. */
+  void
+   reserve(size_t n) {
+   for (std::vector<float>* a : { &m_px, &m_py, &m_rotation, &m_sx, &m_sy, &m_ox, &m_oy, &m_width, &m_height }) {
+    a->reserve(n);
+   }
+   m_vertices.reserve(n * detail::SPRITE_VERTICES);
+  }
+
+  /** @brief Removes every sprite; the vertex buffer is kept for reuse. */
+  void
+   clear() {
+   for (std::vector<float>* a : { &m_px, &m_py, &m_rotation, &m_sx, &m_sy, &m_ox, &m_oy, &m_width, &m_height }) {
+    a->clear();
+   }
+   m_vertices.clear();
+   m_uploaded = 0;
+  }
+
+  /** @brief Texture every sprite samples from, or nullptr for untextured quads. */
+  void
+   setTexture(const sf::Texture* texture) {
+   m_texture = texture;
+  }
+
+  void
+   setPosition(size_t i, const CVector2& position) {
+   m_px[i] = position.x;
+   m_py[i] = position.y;
+  }
+
+  /** @brief Rotation in radians. */
+  void
+   setRotation(size_t i, float radians) {
+   m_rotation[i] = radians;
+  }
+
+  void
+   setScale(size_t i, const CVector2& scale) {
+   m_sx[i] = scale.x;
+   m_sy[i] = scale.y;
+  }
+
+  /** @brief Local point (in unscaled pixels from the top-left corner) placed at position. */
+  void
+   setOrigin(size_t i, const CVector2& origin) {
+   m_ox[i] = origin.x;
+   m_oy[i] = origin.y;
+  }
+
+  /** @brief Region of the texture shown; also sets the sprite's size, as sf::Sprite does. */
+  void
+   setTextureRect(size_t i, const sf::FloatRect& rect) {
+   m_width[i] = rect.width;
+   m_height[i] = rect.height;
+   const sf::Vector2f corner[4] = { { rect.left, rect.top }, { rect.left + rect.width, rect.top },
+                                    { rect.left + rect.width, rect.top + rect.height },
+                                    { rect.left, rect.top + rect.height } };
+   sf::Vertex* v = &m_vertices[i * detail::SPRITE_VERTICES];
+   for (size_t k = 0; k < detail::SPRITE_VERTICES; ++k) v[k].texCoords = corner[detail::spriteCorner(k)];
+  }
+
+  void
+   setColor(size_t i, const sf::Color& color) {
+   sf::Vertex* v = &m_vertices[i * detail::SPRITE_VERTICES];
+   for (size_t k = 0; k < detail::SPRITE_VERTICES; ++k) v[k].color = color;
+  }
+
+  /** @brief Positions of every sprite, for bulk updates. */
+  EngineMath::batch::SoA2
+   positions() {
+   return { m_px.data(), m_py.data() };
+  }
+
+  /** @brief Rotations in radians of every sprite. */
+  float*
+   rotations() {
+   return m_rotation.data();
+  }
+
+  EngineMath::batch::SoA2
+   scales() {
+   return { m_sx.data(), m_sy.data() };
+  }
+
+  EngineMath::batch::SoA2
+   origins() {
+   return { m_ox.data(), m_oy.data() };
+  }
+
+  /**
+   * @brief Local-to-world transform of sprite i: translate(position) * rotate * scale *
+   * translate(-origin), the same as sf::Transformable::getTransform().
+   */
+  Matrix3x3
+   transform(size_t i) const {
+   float s = 0.f, c = 0.f;
+   EngineMath::sincos(m_rotation[i], &s, &c);
+   const float a = c * m_sx[i], b = -s * m_sy[i], d = s * m_sx[i], e = c * m_sy[i];
+   return Matrix3x3(a, b, m_px[i] - (a * m_ox[i] + b * m_oy[i]),
+                    d, e, m_py[i] - (d * m_ox[i] + e * m_oy[i]),
+                    0.f, 0.f, 1.f);
+  }
+
+  /**
+   * @brief Rebuilds every vertex position from the sprite arrays.
+   *
+   * Batches of PARALLEL_SPRITE_MIN sprites and more are split into SPRITE_BLOCK-sized tasks
+   * over threads (0 = hardware_concurrency(), 1 = caller only).
+   */
+  void
+   computeVertices(size_t threads = 0) {
+   const size_t n = size();
+   const size_t blocks = (n + detail::SPRITE_BLOCK - 1) / detail::SPRITE_BLOCK;
+   auto run = [&](size_t block) {
+    const size_t begin = block * detail::SPRITE_BLOCK;
+    computeBlock(begin, n - begin < detail::SPRITE_BLOCK ? n : begin + detail::SPRITE_BLOCK);
+   };
+   threads = detail::resolveThreads(threads, blocks);
+   if (n < detail::PARALLEL_SPRITE_MIN || threads <= 1) {
+    for (size_t block = 0; block < blocks; ++block) run(block);
+    return;
+   }
+   detail::parallelTasks(blocks, threads, run);
+  }
+
+  /**
+   * @brief Copies the staging vertices into the vertex buffer, growing it geometrically.
+   * @return False when vertex buffers are unsupported or the upload failed; draw() then
+   * falls back to drawing the staging array.
+   */
+  bool
+   upload() {
+   m_uploaded = 0;
+   if (!sf::VertexBuffer::isAvailable()) {
+    return false;
+   }
+   const size_t count = m_vertices.size();
+   if (count > m_buffer.getVertexCount()) {
+    const size_t grown = m_buffer.getVertexCount() + m_buffer.getVertexCount() / 2;
+    if (!m_buffer.create(count > grown ? count : grown)) {
+     return false;
+    }
+   }
+   if (count != 0 && !m_buffer.update(m_vertices.data(), count, 0)) {
+    return false;
+   }
+   m_uploaded = count;
+   return true;
+  }
+
+  /** @brief computeVertices() followed by upload(). */
+  bool
+   update(size_t threads = 0) {
+   computeVertices(threads);
+   return upload();
+  }
+
+  /** @brief The staging vertices, six per sprite. */
+  const std::vector<sf::Vertex>&
+   vertices() const {
+   return m_vertices;
+  }
+
+  private:
+  void
+   draw(sf::RenderTarget& target, sf::RenderStates states) const override {
+   states.texture = m_texture;
+   if (m_uploaded == m_vertices.size() && m_uploaded != 0) {
+    target.draw(m_buffer, 0, m_uploaded, states);
+   }
+   else if (!m_vertices.empty()) {
+    target.draw(m_vertices.data(), m_vertices.size(), sf::Triangles, states);
+   }
+  }
+
+  /** Corner positions of sprites [begin, end), one register of sprites at a time. */
+  void
+   computeBlock(size_t begin, size_t end) {
+   using detail::BatchLanes;
+   using detail::BATCH_WIDTH;
+   for (size_t i = begin; i < end; i += BATCH_WIDTH) {
+    const size_t count = end - i < BATCH_WIDTH ? end - i : BATCH_WIDTH;
+    BatchLanes s, c;
+    EngineMath::batch::kernels::sincos(detail::loadLanes(m_rotation.data(), i, count), s, c);
+    const BatchLanes sx = detail::loadLanes(m_sx.data(), i, count), sy = detail::loadLanes(m_sy.data(), i, count);
+    const BatchLanes ox = detail::loadLanes(m_ox.data(), i, count), oy = detail::loadLanes(m_oy.data(), i, count);
+    const BatchLanes w = detail::loadLanes(m_width.data(), i, count);
+    const BatchLanes h = detail::loadLanes(m_height.data(), i, count);
+    // The 2x2 block and translation of transform(i), per lane.
+    const BatchLanes a = c * sx, b = (BatchLanes::zero() - s) * sy, d = s * sx, e = c * sy;
+    const BatchLanes tx = detail::loadLanes(m_px.data(), i, count) - (a * ox + b * oy);
+    const BatchLanes ty = detail::loadLanes(m_py.data(), i, count) - (d * ox + e * oy);
+    float corner[8][BATCH_WIDTH];
+    const BatchLanes ax = a * w, dx = d * w, by = b * h, ey = e * h;
+    tx.store(corner[0]);
+    ty.store(corner[1]);
+    (tx + ax).store(corner[2]);
+    (ty + dx).store(corner[3]);
+    (tx + ax + by).store(corner[4]);
+    (ty + dx + ey).store(corner[5]);
+    (tx + by).store(corner[6]);
+    (ty + ey).store(corner[7]);
+    for (size_t j = 0; j < count; ++j) {
+     sf::Vertex* v = &m_vertices[(i + j) * detail::SPRITE_VERTICES];
+     for (size_t k = 0; k < detail::SPRITE_VERTICES; ++k) {
+      const int q = detail::spriteCorner(k);
+      v[k].position.x = corner[2 * q][j];
+      v[k].position.y = corner[2 * q + 1][j];
+     }
+    }
+   }
+  }
+
+  std::vector<float> m_px, m_py;     ///< Positions
+  std::vector<float> m_rotation;     ///< Radians
+  std::vector<float> m_sx, m_sy;     ///< Scale factors
+  std::vector<float> m_ox, m_oy;     ///< Origins in local pixels
+  std::vector<float> m_width;        ///< Texture rect size in pixels
+  std::vector<float> m_height;
+  std::vector<sf::Vertex> m_vertices; ///< Staging copy of the vertex buffer
+  const sf::Texture* m_texture;
+  sf::VertexBuffer m_buffer;
+  size_t m_uploaded;                  ///< Vertices in m_buffer that match m_vertices
+ };
+}
@@ -0,0 +1,390 @@
+/**
+ * @file UniformCache.h
+ * @brief Shadowed uniforms of one sf::Shader, uploaded in one batch and only when changed.
+ *
+ * Every sf::Shader::setUniform() binds the program, looks the name up and restores the old
+ * program, so setting the same twenty uniforms per draw costs sixty GL calls and twenty string
+ * lookups even when nothing changed. A UniformCache resolves each name once, on the first
+ * flush() after it was added, and set() only writes the value into a shadow array. flush() compares the shadow with the
+ * values last uploaded, one approxEqualMask() (BatchCompare.h) per type, and uploads just the
+ * ones that differ: through glProgramUniform*() where GL 4.1 or EXT_direct_state_access
+ * provides it, otherwise with the program bound once for the whole batch. Call it right before
+ * the draw that uses the shader.
+ *
+ * The values go to GL as they are stored: CVector2/3/4 as packed floats and Matrix4x4,
+ * which is row-major, through glUniformMatrix4fv() with transpose set, so nothing is copied or
+ * converted. Without the GL entry points, flush() falls back to sf::Shader::setUniform() for
+ * the changed uniforms, passing the vectors as the sf::Glsl types they are layout-identical
+ * to; only Matrix4x4 then needs a transposed sf::Glsl::Mat4.
+ *
+ * The shadow assumes nothing else sets these uniforms: call invalidate() after code that does.
+ * A relinked shader (new native handle) is noticed by flush(), which resolves the names again
+ * and uploads everything. Needs sfml-graphics at link time, and the shader's context (or one
+ * sharing with it) on the thread that flushes.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <SFML/Graphics/Glsl.hpp>
+#include <SFML/Graphics/Shader.hpp>
+#include <SFML/Window/Context.hpp>
+#include <SFML/Window/GlResource.hpp>
+#include <Core/Trace.h>
+#include <Math/BatchCompare.h>
+#include <Math/EngineMath.h>
+#include <Matrices/Matrix4x4.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector4.h>
+
+#ifndef EU_GL_APIENTRY
+ #if defined(_WIN32) && !defined(_WIN64)
+  #define EU_GL_APIENTRY __stdcall
+ #else
+  #define EU_GL_APIENTRY
+ #endif
+#endif
+
+namespace EU {
+ static_assert(sizeof(sf::Glsl::Vec2) == sizeof(CVector2) && sizeof(sf::Glsl::Vec3) == sizeof(CVector3) &&
+               sizeof(sf::Glsl::Vec4) == sizeof(CVector4),
+               "sf::Glsl vectors and CVector2/3/4 must be the same packed floats");
+
+ namespace detail {
+  /** The GL 2.0 uniform entry points, plus the GL 4.1 program uniforms when available. */
+  struct GlUniformFunctions {
+   using GetUniformLocation = int (EU_GL_APIENTRY*)(unsigned, const char*);
+   using UseProgram = void (EU_GL_APIENTRY*)(unsigned);
+   using GetIntegerv = void (EU_GL_APIENTRY*)(unsigned, int*);
+   using UniformFv = void (EU_GL_APIENTRY*)(int, int, const float*);
+   using UniformMatrixFv = void (EU_GL_APIENTRY*)(int, int, unsigned char, const float*);
+   using ProgramUniformFv = void (EU_GL_APIENTRY*)(unsigned, int, int, const float*);
+   using ProgramUniformMatrixFv = void (EU_GL_APIENTRY*)(unsigned, int, int, unsigned char, const float*);
+
+   GetUniformLocation getUniformLocation = nullptr;
+   UseProgram useProgram = nullptr;
+   GetIntegerv getIntegerv = nullptr;
+   UniformFv uniform[4] = {};             ///< glUniform1fv .. glUniform4fv
+   UniformMatrixFv uniformMatrix4 = nullptr;
+   ProgramUniformFv programUniform[4] = {}; ///< glProgramUniform1fv .. 4fv, or all null
+   ProgramUniformMatrixFv programUniformMatrix4 = nullptr;
+
+   /** Loads the entry points from the active context; false if a GL 2.0 one is missing. */
+   bool
+    load() {
+    static const char* const vectors[] = { "glUniform1fv", "glUniform2fv", "glUniform3fv", "glUniform4fv" };
+    static const char* const programVectors[] = { "glProgramUniform1fv", "glProgramUniform2fv", "glProgramUniform3fv",
+                                                  "glProgramUniform4fv" };
+    static const char* const programVectorsEXT[] = { "glProgramUniform1fvEXT", "glProgramUniform2fvEXT",
+                                                     "glProgramUniform3fvEXT", "glProgramUniform4fvEXT" };
+    bool ok = get(getUniformLocation, "glGetUniformLocation") && get(useProgram, "glUseProgram") &&
+              get(getIntegerv, "glGetIntegerv") && get(uniformMatrix4, "glUniformMatrix4fv");
+    for (size_t i = 0; i < 4; ++i) ok = ok && get(uniform[i], vectors[i]);
+    bool direct = get(programUniformMatrix4, "glProgramUniformMatrix4fv");
+    for (size_t i = 0; i < 4; ++i) direct = direct && get(programUniform[i], programVectors[i]);
+    if (!direct) {
+     direct = get(programUniformMatrix4, "glProgramUniformMatrix4fvEXT");
+     for (size_t i = 0; i < 4; ++i) direct = direct && get(programUniform[i], programVectorsEXT[i]);
+    }
+    if (!direct) {
+     programUniformMatrix4 = nullptr;
+     for (ProgramUniformFv& fn : programUniform) fn = nullptr;
+    }
+    return ok;
+   }
+
+   /** True when uniforms can be set without binding the program. */
+   bool
+    direct() const {
+    return programUniformMatrix4 != nullptr;
+   }
+
+   private:
+   template<typename Fn>
+   static bool
+    get(Fn& fn, const char* name) {
+    fn = reinterpret_cast<Fn>(sf::Context::getFunction(name));
+    return fn != nullptr;
+   }
+  };
+
+  constexpr unsigned GL_UNIFORM_CURRENT_PROGRAM = 0x8B8D;
+  constexpr unsigned char GL_UNIFORM_TRUE = 1;
+  /// Location of a uniform added since the last flush().
+  constexpr int UNIFORM_UNRESOLVED = -2;
+
+  /** Names, locations, shadow and uploaded values of the cached uniforms of one type. */
+  template<typename T>
+  struct UniformSlots {
+   std::vector<std::string> names;
+   std::vector<int> locations;
+   std::vector<T> values;
+   std::vector<T> uploaded;
+   std::vector<uint64_t> mask;
+
+   /** Marks every uniform as never uploaded: NaN equals nothing. */
+   void
+    invalidate() {
+    for (T& value : uploaded) {
+     float* f = reinterpret_cast<float*>(&value);
+     for (size_t i = 0; i < sizeof(T) / sizeof(float); ++i) f[i] = std::numeric_limits<float>::quiet_NaN();
+    }
+   }
+  };
+
+  inline size_t
+   uniformEqualMask(const float* a, const float* b, uint64_t* mask, size_t n, float epsilon) {
+   size_t set = 0;
+   for (size_t w = 0; w < maskWords(n); ++w) mask[w] = 0;
+   for (size_t i = 0; i < n; ++i) {
+    const bool equal = EngineMath::approxEqual(a[i], b[i], epsilon);
+    mask[i >> 6] |= static_cast<uint64_t>(equal) << (i & 63);
+    set += equal;
+   }
+   return set;
+  }
+
+  template<typename T>
+  inline size_t
+   uniformEqualMask(const T* a, const T* b, uint64_t* mask, size_t n, float epsilon) {
+   return approxEqualMask(a, b, mask, n, epsilon);
+  }
+
+  /** Components of a vector uniform; 16 marks a mat4. */
+  template<typename T> struct UniformComponents;
+  template<> struct UniformComponents<float> { static constexpr size_t value = 1; };
+  template<> struct UniformComponents<CVector2> { static constexpr size_t value = 2; };
+  template<> struct UniformComponents<CVector3> { static constexpr size_t value = 3; };
+  template<> struct UniformComponents<CVector4> { static constexpr size_t value = 4; };
+  template<> struct UniformComponents<Matrix4x4> { static constexpr size_t value = 16; };
+
+  inline void
+   setShaderUniform(sf::Shader& shader, const std::string& name, const float& value) {
+   shader.setUniform(name, value);
+  }
+
+  inline void
+   setShaderUniform(sf::Shader& shader, const std::string& name, const CVector2& value) {
+   shader.setUniform(name, *reinterpret_cast<const sf::Glsl::Vec2*>(&value));
+  }
+
+  inline void
+   setShaderUniform(sf::Shader& shader, const std::string& name, const CVector3& value) {
+   shader.setUniform(name, *reinterpret_cast<const sf::Glsl::Vec3*>(&value));
+  }
+
+  inline void
+   setShaderUniform(sf::Shader& shader, const std::string& name, const CVector4& value) {
+   shader.setUniform(name, *reinterpret_cast<const sf::Glsl::Vec4*>(&value));
+  }
+
+  inline void
+   setShaderUniform(sf::Shader& shader, const std::string& name, const Matrix4x4& value) {
+   float columns[16];
+   for (size_t c = 0; c < 4; ++c)
+    for (size_t r = 0; r < 4; ++r) columns[4 * c + r] = value.m[r][c];
+   shader.setUniform(name, sf::Glsl::Mat4(columns));
+  }
+ }
+
+ /**
+  * @class UniformCache
+  * @brief Cached float, CVector2/3/4 and Matrix4x4 uniforms of one sf::Shader.
+  */
+ class
+  UniformCache : sf::GlResource {
+  public:
+  /** @brief A uniform added with add<T>(); only valid with the cache that returned it. */
+  template<typename T>
+  struct Handle {
+   uint32_t index;
+  };
+
+  /**
+   * @brief Cache for shader, which must outlive it.
+   * @param epsilon Changes up to this much per component are not uploaded; 0 uploads every
+   * change.
+   */
+  explicit UniformCache(sf::Shader& shader, float epsilon = 0.f)
+   : m_shader(&shader), m_program(0), m_epsilon(epsilon), m_loaded(false), m_gl() {}
+
+  UniformCache(const UniformCache&) = delete;
+  UniformCache& operator=(const UniformCache&) = delete;
+
+  /**
+   * @brief Adds the uniform name of type T (float, CVector2, CVector3, CVector4 or
+   * Matrix4x4) with value as its first shadow value. Adding a name twice returns the first
+   * handle. Uniforms the linker removed are kept but never uploaded.
+   */
+  template<typename T>
+  Handle<T>
+   add(const std::string& name, const T& value = T()) {
+   static_assert(detail::UniformComponents<T>::value != 0, "unsupported uniform type");
+   detail::UniformSlots<T>& s = slots(static_cast<const T*>(nullptr));
+   for (size_t i = 0; i < s.names.size(); ++i) {
+    if (s.names[i] == name) return Handle<T>{ static_cast<uint32_t>(i) };
+   }
+   s.names.push_back(name);
+   s.locations.push_back(detail::UNIFORM_UNRESOLVED);
+   s.values.push_back(value);
+   s.uploaded.push_back(value);
+   s.mask.resize(maskWords(s.names.size()));
+   s.invalidate();
+   // Resolved by the next flush(), with the context active.
+   m_unresolved = true;
+   return Handle<T>{ static_cast<uint32_t>(s.names.size() - 1) };
+  }
+
+  /** @brief Sets the shadow value; nothing reaches GL before flush(). */
+  template<typename T>
+  void
+   set(Handle<T> handle, const T& value) {
+   slots(static_cast<const T*>(nullptr)).values[handle.index] = value;
+  }
+
+  /** @brief The shadow value of handle. */
+  template<typename T>
+  const T&
+   get(Handle<T> handle) const {
+   return const_cast<UniformCache*>(this)->slots(static_cast<const T*>(nullptr)).values[handle.index];
+  }
+
+  /** @brief Makes the next flush() upload every uniform. */
+  void
+   invalidate() {
+   m_floats.invalidate();
+   m_vectors2.invalidate();
+   m_vectors3.invalidate();
+   m_vectors4.invalidate();
+   m_matrices.invalidate();
+  }
+
+  /**
+   * @brief Uploads the uniforms that changed since the last flush(), leaving the bound
+   * program as it was. Returns how many were uploaded.
+   */
+  size_t
+   flush() {
+   EU_TRACE_ZONE("UniformCache::flush");
+   const unsigned program = m_shader->getNativeHandle();
+   if (program == 0) return 0;
+   TransientContextLock lock;
+   if (!m_loaded) {
+    m_usable = m_gl.load();
+    m_loaded = true;
+   }
+   const bool relinked = program != m_program;
+   if (relinked) invalidate();
+   if ((relinked || m_unresolved) && m_usable) {
+    locate(m_floats, program, relinked);
+    locate(m_vectors2, program, relinked);
+    locate(m_vectors3, program, relinked);
+    locate(m_vectors4, program, relinked);
+    locate(m_matrices, program, relinked);
+   }
+   m_program = program;
+   m_unresolved = false;
+   Batch batch = { program, -1 };
+   size_t uploaded = upload(m_floats, batch) + upload(m_vectors2, batch) + upload(m_vectors3, batch) +
+                     upload(m_vectors4, batch) + upload(m_matrices, batch);
+   if (batch.previous >= 0 && static_cast<unsigned>(batch.previous) != program) {
+    m_gl.useProgram(static_cast<unsigned>(batch.previous));
+   }
+   EU_TRACE_COUNTER("Uniforms uploaded", uploaded);
+   return uploaded;
+  }
+
+  float
+   epsilon() const {
+   return m_epsilon;
+  }
+
+  void
+   setEpsilon(float epsilon) {
+   m_epsilon = epsilon;
+  }
+
+  private:
+  /** Program of the batch, and the one to restore once it is bound (-1: not bound yet). */
+  struct Batch {
+   unsigned program;
+   int previous;
+  };
+
+  detail::UniformSlots<float>& slots(const float*) { return m_floats; }
+  detail::UniformSlots<CVector2>& slots(const CVector2*) { return m_vectors2; }
+  detail::UniformSlots<CVector3>& slots(const CVector3*) { return m_vectors3; }
+  detail::UniformSlots<CVector4>& slots(const CVector4*) { return m_vectors4; }
+  detail::UniformSlots<Matrix4x4>& slots(const Matrix4x4*) { return m_matrices; }
+
+  template<typename T>
+  void
+   locate(detail::UniformSlots<T>& s, unsigned program, bool all) {
+   for (size_t i = 0; i < s.names.size(); ++i) {
+    if (all || s.locations[i] == detail::UNIFORM_UNRESOLVED) {
+     s.locations[i] = m_gl.getUniformLocation(program, s.names[i].c_str());
+    }
+   }
+  }
+
+  template<typename T>
+  size_t
+   upload(detail::UniformSlots<T>& s, Batch& batch) {
+   const size_t n = s.names.size();
+   if (n == 0) return 0;
+   if (detail::uniformEqualMask(s.values.data(), s.uploaded.data(), s.mask.data(), n, m_epsilon) == n) return 0;
+   size_t count = 0;
+   for (size_t i = 0; i < n; ++i) {
+    if ((s.mask[i >> 6] >> (i & 63)) & 1) continue;
+    s.uploaded[i] = s.values[i];
+    ++count;
+    if (!m_usable) {
+     detail::setShaderUniform(*m_shader, s.names[i], s.values[i]);
+     continue;
+    }
+    if (s.locations[i] < 0) continue;
+    if (!m_gl.direct() && batch.previous < 0) {
+     m_gl.getIntegerv(detail::GL_UNIFORM_CURRENT_PROGRAM, &batch.previous);
+     if (batch.previous < 0) batch.previous = 0;
+     if (static_cast<unsigned>(batch.previous) != batch.program) m_gl.useProgram(batch.program);
+    }
+    send(s.locations[i], batch.program, s.values[i]);
+   }
+   return count;
+  }
+
+  template<typename T>
+  void
+   send(int location, unsigned program, const T& value) {
+   const size_t k = detail::UniformComponents<T>::value - 1;
+   const float* data = reinterpret_cast<const float*>(&value);
+   if (m_gl.direct()) m_gl.programUniform[k](program, location, 1, data);
+   else m_gl.uniform[k](location, 1, data);
+  }
+
+  void
+   send(int location, unsigned program, const Matrix4x4& value) {
+   if (m_gl.direct()) m_gl.programUniformMatrix4(program, location, 1, detail::GL_UNIFORM_TRUE, &value.m[0][0]);
+   else m_gl.uniformMatrix4(location, 1, detail::GL_UNIFORM_TRUE, &value.m[0][0]);
+  }
+
+  sf::Shader* m_shader;
+  unsigned m_program; ///< Native handle the locations belong to, 0 before they are resolved
+  float m_epsilon;
+  bool m_loaded;
+  bool m_usable = false;
+  bool m_unresolved = false;
+  detail::GlUniformFunctions m_gl;
+  detail::UniformSlots<float> m_floats;
+  detail::UniformSlots<CVector2> m_vectors2;
+  detail::UniformSlots<CVector3> m_vectors3;
+  detail::UniformSlots<CVector4> m_vectors4;
+  detail::UniformSlots<Matrix4x4> m_matrices;
+ };
+}
@@ -0,0 +1,180 @@
+/**
+ * @file BatchCompare.h
+ * @brief Epsilon comparison of two arrays, one bit per element.
+ *
+ * approxEqualMask(a, b, mask, n) sets bit i of mask (bit i % 64 of word i / 64) when
+ * a[i].approxEqual(b[i], epsilon), and returns how many bits it set, so n minus the result
+ * is the number of changed elements. Vectors are compared SIMD-lane per element, in the AoS
+ * and SoA layouts of VectorBatch.h; quaternions and matrices are compared a register of
+ * components at a time. mask must hold maskWords(n) words; bits past n are left zero.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/Constants.h>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/IntMath.h>
+#include <Matrices/Matrix2x2.h>
+#include <Matrices/Matrix3x3.h>
+#include <Matrices/Matrix4x4.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector4.h>
+#include <Vectors/Vector4A.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /** @brief Number of 64-bit words an n-element mask needs. */
+ constexpr size_t
+  maskWords(size_t n) {
+  return (n + 63) / 64;
+ }
+
+ namespace detail {
+  static_assert(sizeof(CVector4) == 4 * sizeof(float), "CVector4 must be four packed floats");
+  static_assert(sizeof(Quaternion) == 4 * sizeof(float), "Quaternion must be four packed floats");
+  static_assert(sizeof(Matrix2x2) == 4 * sizeof(float), "Matrix2x2 must be four packed floats");
+  static_assert(sizeof(Matrix3x3) == 9 * sizeof(float), "Matrix3x3 must be nine packed floats");
+  static_assert(sizeof(Matrix4x4) == 16 * sizeof(float), "Matrix4x4 must be sixteen packed floats");
+
+  inline size_t
+   finishMask(uint64_t* mask, size_t n) {
+   size_t set = 0;
+   for (size_t w = 0; w < maskWords(n); ++w) set += static_cast<size_t>(EngineMath::detail::popCount(mask[w]));
+   return set;
+  }
+
+  inline void
+   clearMask(uint64_t* mask, size_t n) {
+   for (size_t w = 0; w < maskWords(n); ++w) mask[w] = 0;
+  }
+
+  /** Sets the first count bits of movemask(m) at bit i; BATCH_WIDTH divides 64, so a packet never straddles words. */
+  inline void
+   setMaskBits(uint64_t* mask, size_t i, size_t count, BatchLanes m) {
+   const uint64_t bits = static_cast<uint64_t>(EU::SIMD::movemask(m)) & ((uint64_t(1) << count) - 1);
+   mask[i >> 6] |= bits << (i & 63);
+  }
+
+  template<typename In>
+  inline size_t
+   approxEqualMask2(In a, In b, uint64_t* mask, size_t n, float epsilon) {
+   const BatchLanes e = BatchLanes::set1(epsilon);
+   clearMask(mask, n);
+   forEachPacketPair2(a, b, n, [&](size_t i, size_t count, BatchLanes ax, BatchLanes ay, BatchLanes bx, BatchLanes by) {
+    setMaskBits(mask, i, count, EU::SIMD::approxEqual(ax, bx, e) & EU::SIMD::approxEqual(ay, by, e));
+   });
+   return finishMask(mask, n);
+  }
+
+  template<typename In>
+  inline size_t
+   approxEqualMask3(In a, In b, uint64_t* mask, size_t n, float epsilon) {
+   const BatchLanes e = BatchLanes::set1(epsilon);
+   clearMask(mask, n);
+   forEachPacketPair3(a, b, n, [&](size_t i, size_t count, BatchLanes ax, BatchLanes ay, BatchLanes az,
+                                   BatchLanes bx, BatchLanes by, BatchLanes bz) {
+    setMaskBits(mask, i, count,
+                EU::SIMD::approxEqual(ax, bx, e) & EU::SIMD::approxEqual(ay, by, e) & EU::SIMD::approxEqual(az, bz, e));
+   });
+   return finishMask(mask, n);
+  }
+
+  /** Records of K packed floats, compared four components per register. */
+  template<size_t K>
+  inline size_t
+   approxEqualMaskRecords(const float* a, const float* b, uint64_t* mask, size_t n, float epsilon) {
+   const EU::SIMD::Float4 e = EU::SIMD::Float4::set1(epsilon);
+   clearMask(mask, n);
+   for (size_t i = 0; i < n; ++i, a += K, b += K) {
+    EU::SIMD::Float4 eq = EU::SIMD::approxEqual(EU::SIMD::Float4::load(a), EU::SIMD::Float4::load(b), e);
+    for (size_t c = 4; c + 4 <= K; c += 4) {
+     eq = eq & EU::SIMD::approxEqual(EU::SIMD::Float4::load(a + c), EU::SIMD::Float4::load(b + c), e);
+    }
+    bool equal = EU::SIMD::all(eq);
+    for (size_t c = K & ~size_t(3); c < K; ++c) equal = equal && EngineMath::approxEqual(a[c], b[c], epsilon);
+    mask[i >> 6] |= static_cast<uint64_t>(equal) << (i & 63);
+   }
+   return finishMask(mask, n);
+  }
+ }
+
+ // --- Vectors ---
+
+ /** @brief Bit i set when a[i].approxEqual(b[i], epsilon). @return Number of bits set. */
+ inline size_t
+  approxEqualMask(const CVector2* a, const CVector2* b, uint64_t* mask, size_t n,
+                  float epsilon = EU::Constants::EPSILON) {
+  return detail::approxEqualMask2(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), mask, n, epsilon);
+ }
+
+ /** @brief SoA approxEqualMask() for CVector2 streams. */
+ inline size_t
+  approxEqualMask(EngineMath::batch::ConstSoA2 a, EngineMath::batch::ConstSoA2 b, uint64_t* mask, size_t n,
+                  float epsilon = EU::Constants::EPSILON) {
+  return detail::approxEqualMask2(a, b, mask, n, epsilon);
+ }
+
+ /** @brief Bit i set when a[i].approxEqual(b[i], epsilon). @return Number of bits set. */
+ inline size_t
+  approxEqualMask(const CVector3* a, const CVector3* b, uint64_t* mask, size_t n,
+                  float epsilon = EU::Constants::EPSILON) {
+  return detail::approxEqualMask3(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), mask, n, epsilon);
+ }
+
+ /** @brief SoA approxEqualMask() for CVector3 streams. */
+ inline size_t
+  approxEqualMask(EngineMath::batch::ConstSoA3 a, EngineMath::batch::ConstSoA3 b, uint64_t* mask, size_t n,
+                  float epsilon = EU::Constants::EPSILON) {
+  return detail::approxEqualMask3(a, b, mask, n, epsilon);
+ }
+
+ /** @brief Bit i set when a[i].approxEqual(b[i], epsilon). @return Number of bits set. */
+ inline size_t
+  approxEqualMask(const CVector4* a, const CVector4* b, uint64_t* mask, size_t n,
+                  float epsilon = EU::Constants::EPSILON) {
+  return detail::approxEqualMaskRecords<4>(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), mask, n, epsilon);
+ }
+
+ /** @brief Bit i set when a[i].approxEqual(b[i], epsilon). @return Number of bits set. */
+ inline size_t
+  approxEqualMask(const CVector4A* a, const CVector4A* b, uint64_t* mask, size_t n,
+                  float epsilon = EU::Constants::EPSILON) {
+  return detail::approxEqualMaskRecords<4>(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), mask, n, epsilon);
+ }
+
+ // --- Rotations and transforms ---
+
+ /** @brief Bit i set when a[i].approxEqual(b[i], epsilon). @return Number of bits set. */
+ inline size_t
+  approxEqualMask(const Quaternion* a, const Quaternion* b, uint64_t* mask, size_t n,
+                  float epsilon = EU::Constants::EPSILON) {
+  return detail::approxEqualMaskRecords<4>(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), mask, n, epsilon);
+ }
+
+ /** @brief Bit i set when a[i].approxEqual(b[i], epsilon). @return Number of bits set. */
+ inline size_t
+  approxEqualMask(const Matrix2x2* a, const Matrix2x2* b, uint64_t* mask, size_t n,
+                  float epsilon = EU::Constants::EPSILON) {
+  return detail::approxEqualMaskRecords<4>(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), mask, n, epsilon);
+ }
+
+ /** @brief Bit i set when a[i].approxEqual(b[i], epsilon). @return Number of bits set. */
+ inline size_t
+  approxEqualMask(const Matrix3x3* a, const Matrix3x3* b, uint64_t* mask, size_t n,
+                  float epsilon = EU::Constants::EPSILON) {
+  return detail::approxEqualMaskRecords<9>(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), mask, n, epsilon);
+ }
+
+ /** @brief Bit i set when a[i].approxEqual(b[i], epsilon). @return Number of bits set. */
+ inline size_t
+  approxEqualMask(const Matrix4x4* a, const Matrix4x4* b, uint64_t* mask, size_t n,
+                  float epsilon = EU::Constants::EPSILON) {
+  return detail::approxEqualMaskRecords<16>(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), mask, n, epsilon);
+ }
+}
@@ -0,0 +1,363 @@
+/**
+ * @file Easing.h
+ * @brief Easing curves plus batched lerp, smoothstep and tweening over float, CVector3 and SoA arrays.
+ *
+ * Each curve is written once as a template over the value type and is instantiated for float
+ * (the scalar API) and for the SIMD types (the batch API), so both paths produce the same
+ * curve shape. Curves take t in [0, 1] and clamp it.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Vectors/Vector3.h>
+
+namespace EngineMath {
+ /**
+  * @brief Easing curve selector for the runtime-dispatched ease() and batch::tween().
+  */
+ enum class Ease {
+  Linear,
+  InQuad, OutQuad, InOutQuad,
+  InCubic, OutCubic, InOutCubic,
+  InExpo, OutExpo, InOutExpo,
+  InElastic, OutElastic, InOutElastic
+ };
+
+ namespace easing {
+  namespace detail {
+   /** Lane operations used by the curves; the primary template covers the SIMD types. */
+   template<typename T>
+   struct Ops {
+    using Mask = T;
+    static T splat(float c) { return T::set1(c); }
+    static Mask less(T a, T b) { return a < b; }
+    static Mask equal(T a, T b) { return a == b; }
+    static T select(Mask m, T a, T b) { return EU::SIMD::select(m, a, b); }
+    static T clamp01(T t) { return EU::SIMD::min(EU::SIMD::max(t, T::zero()), T::set1(1.0f)); }
+    static T exp2(T x) { return batch::kernels::exp2(x); }
+    static T sin(T x) { return batch::kernels::sin(x); }
+   };
+
+   template<>
+   struct Ops<float> {
+    using Mask = bool;
+    static float splat(float c) { return c; }
+    static bool less(float a, float b) { return a < b; }
+    static bool equal(float a, float b) { return a == b; }
+    static float select(bool m, float a, float b) { return m ? a : b; }
+    static float clamp01(float t) { return EngineMath::clamp(t, 0.0f, 1.0f); }
+    static float exp2(float x) { return EngineMath::exp2(x); }
+    static float sin(float x) { return EngineMath::sin(x); }
+   };
+
+   /** Maps the clamped t to 0 and 1 exactly at the endpoints (expo and elastic overshoot). */
+   template<typename T>
+   inline T
+    pinEnds(T t, T value) {
+    using O = Ops<T>;
+    value = O::select(O::equal(t, O::splat(0.0f)), O::splat(0.0f), value);
+    return O::select(O::equal(t, O::splat(1.0f)), O::splat(1.0f), value);
+   }
+  }
+
+  template<typename T>
+  inline T
+   inQuad(T t) {
+   t = detail::Ops<T>::clamp01(t);
+   return t * t;
+  }
+
+  template<typename T>
+  inline T
+   outQuad(T t) {
+   using O = detail::Ops<T>;
+   T u = O::splat(1.0f) - O::clamp01(t);
+   return O::splat(1.0f) - u * u;
+  }
+
+  template<typename T>
+  inline T
+   inOutQuad(T t) {
+   using O = detail::Ops<T>;
+   t = O::clamp01(t);
+   T u = O::splat(2.0f) - O::splat(2.0f) * t;
+   return O::select(O::less(t, O::splat(0.5f)), O::splat(2.0f) * t * t, O::splat(1.0f) - O::splat(0.5f) * u * u);
+  }
+
+  template<typename T>
+  inline T
+   inCubic(T t) {
+   t = detail::Ops<T>::clamp01(t);
+   return t * t * t;
+  }
+
+  template<typename T>
+  inline T
+   outCubic(T t) {
+   using O = detail::Ops<T>;
+   T u = O::splat(1.0f) - O::clamp01(t);
+   return O::splat(1.0f) - u * u * u;
+  }
+
+  template<typename T>
+  inline T
+   inOutCubic(T t) {
+   using O = detail::Ops<T>;
+   t = O::clamp01(t);
+   T u = O::splat(2.0f) - O::splat(2.0f) * t;
+   return O::select(O::less(t, O::splat(0.5f)), O::splat(4.0f) * t * t * t, O::splat(1.0f) - O::splat(0.5f) * u * u * u);
+  }
+
+  template<typename T>
+  inline T
+   inExpo(T t) {
+   using O = detail::Ops<T>;
+   t = O::clamp01(t);
+   return detail::pinEnds(t, O::exp2(O::splat(10.0f) * t - O::splat(10.0f)));
+  }
+
+  template<typename T>
+  inline T
+   outExpo(T t) {
+   using O = detail::Ops<T>;
+   t = O::clamp01(t);
+   return detail::pinEnds(t, O::splat(1.0f) - O::exp2(O::splat(-10.0f) * t));
+  }
+
+  template<typename T>
+  inline T
+   inOutExpo(T t) {
+   using O = detail::Ops<T>;
+   t = O::clamp01(t);
+   T low = O::splat(0.5f) * O::exp2(O::splat(20.0f) * t - O::splat(10.0f));
+   T high = O::splat(1.0f) - O::splat(0.5f) * O::exp2(O::splat(10.0f) - O::splat(20.0f) * t);
+   return detail::pinEnds(t, O::select(O::less(t, O::splat(0.5f)), low, high));
+  }
+
+  /** Elastic overshoot with period 0.3 (c4 = 2PI / 3), as in the common Penner set. */
+  template<typename T>
+  inline T
+   inElastic(T t) {
+   using O = detail::Ops<T>;
+   const float C4 = EU::Constants::TWO_PI / 3.0f;
+   t = O::clamp01(t);
+   T s = O::sin((O::splat(10.0f) * t - O::splat(10.75f)) * O::splat(C4));
+   return detail::pinEnds(t, O::splat(0.0f) - O::exp2(O::splat(10.0f) * t - O::splat(10.0f)) * s);
+  }
+
+  template<typename T>
+  inline T
+   outElastic(T t) {
+   using O = detail::Ops<T>;
+   const float C4 = EU::Constants::TWO_PI / 3.0f;
+   t = O::clamp01(t);
+   T s = O::sin((O::splat(10.0f) * t - O::splat(0.75f)) * O::splat(C4));
+   return detail::pinEnds(t, O::exp2(O::splat(-10.0f) * t) * s + O::splat(1.0f));
+  }
+
+  template<typename T>
+  inline T
+   inOutElastic(T t) {
+   using O = detail::Ops<T>;
+   const float C5 = EU::Constants::TWO_PI / 4.5f;
+   t = O::clamp01(t);
+   T s = O::sin((O::splat(20.0f) * t - O::splat(11.125f)) * O::splat(C5));
+   T low = O::splat(-0.5f) * O::exp2(O::splat(20.0f) * t - O::splat(10.0f)) * s;
+   T high = O::splat(0.5f) * O::exp2(O::splat(10.0f) - O::splat(20.0f) * t) * s + O::splat(1.0f);
+   return detail::pinEnds(t, O::select(O::less(t, O::splat(0.5f)), low, high));
+  }
+
+  /** @brief Evaluates the selected curve; Linear just clamps t. */
+  template<typename T>
+  inline T
+   evaluate(Ease curve, T t) {
+   switch (curve) {
+    case Ease::InQuad: return inQuad(t);
+    case Ease::OutQuad: return outQuad(t);
+    case Ease::InOutQuad: return inOutQuad(t);
+    case Ease::InCubic: return inCubic(t);
+    case Ease::OutCubic: return outCubic(t);
+    case Ease::InOutCubic: return inOutCubic(t);
+    case Ease::InExpo: return inExpo(t);
+    case Ease::OutExpo: return outExpo(t);
+    case Ease::InOutExpo: return inOutExpo(t);
+    case Ease::InElastic: return inElastic(t);
+    case Ease::OutElastic: return outElastic(t);
+    case Ease::InOutElastic: return inOutElastic(t);
+    default: return detail::Ops<T>::clamp01(t);
+   }
+  }
+ }
+
+ /**
+  * @brief Eased value of t in [0, 1] for the selected curve.
+  */
+ inline float
+  ease(Ease curve, float t) {
+  return easing::evaluate(curve, t);
+ }
+
+ namespace batch {
+  namespace detail {
+   /** Calls fn(kernel) with the curve's generic kernel, so the switch runs once per batch. */
+   template<typename Fn>
+   inline void
+    withCurve(Ease curve, Fn fn) {
+    switch (curve) {
+     case Ease::InQuad: fn([](auto t) { return easing::inQuad(t); }); break;
+     case Ease::OutQuad: fn([](auto t) { return easing::outQuad(t); }); break;
+     case Ease::InOutQuad: fn([](auto t) { return easing::inOutQuad(t); }); break;
+     case Ease::InCubic: fn([](auto t) { return easing::inCubic(t); }); break;
+     case Ease::OutCubic: fn([](auto t) { return easing::outCubic(t); }); break;
+     case Ease::InOutCubic: fn([](auto t) { return easing::inOutCubic(t); }); break;
+     case Ease::InExpo: fn([](auto t) { return easing::inExpo(t); }); break;
+     case Ease::OutExpo: fn([](auto t) { return easing::outExpo(t); }); break;
+     case Ease::InOutExpo: fn([](auto t) { return easing::inOutExpo(t); }); break;
+     case Ease::InElastic: fn([](auto t) { return easing::inElastic(t); }); break;
+     case Ease::OutElastic: fn([](auto t) { return easing::outElastic(t); }); break;
+     case Ease::InOutElastic: fn([](auto t) { return easing::inOutElastic(t); }); break;
+     default: fn([](auto t) { return easing::detail::Ops<decltype(t)>::clamp01(t); }); break;
+    }
+   }
+
+   /** Runs a three-input float batch over CVector3 arrays, repeating t[i] for each component. */
+   template<typename Batch>
+   inline void
+    forVector3(const CVector3* a, const CVector3* b, const float* t, CVector3* out, size_t n, Batch fn) {
+    const size_t CHUNK = 64;
+    float fa[3 * CHUNK];
+    float fb[3 * CHUNK];
+    float ft[3 * CHUNK];
+    for (size_t base = 0; base < n; base += CHUNK) {
+     size_t count = (n - base < CHUNK) ? n - base : CHUNK;
+     for (size_t i = 0; i < count; ++i) {
+      const CVector3& va = a[base + i];
+      const CVector3& vb = b[base + i];
+      fa[3 * i] = va.x; fa[3 * i + 1] = va.y; fa[3 * i + 2] = va.z;
+      fb[3 * i] = vb.x; fb[3 * i + 1] = vb.y; fb[3 * i + 2] = vb.z;
+      ft[3 * i] = ft[3 * i + 1] = ft[3 * i + 2] = t[base + i];
+     }
+     fn(fa, fb, ft, fa, 3 * count);
+     for (size_t i = 0; i < count; ++i) {
+      out[base + i] = CVector3(fa[3 * i], fa[3 * i + 1], fa[3 * i + 2]);
+     }
+    }
+   }
+  }
+
+  /** @brief out[i] = ease(curve, t[i]). */
+  inline void
+   ease(Ease curve, const float* t, float* out, size_t n) {
+   detail::withCurve(curve, [t, out, n](auto kernel) { detail::map(t, out, n, kernel); });
+  }
+
+  namespace detail {
+   /** Eases t into a stack buffer chunk by chunk and hands each chunk to fn(eased, base, count). */
+   template<typename Fn>
+   inline void
+    forEasedChunks(Ease curve, const float* t, size_t n, Fn fn) {
+    const size_t CHUNK = 256;
+    float eased[CHUNK];
+    for (size_t base = 0; base < n; base += CHUNK) {
+     size_t count = (n - base < CHUNK) ? n - base : CHUNK;
+     batch::ease(curve, t + base, eased, count);
+     fn(eased, base, count);
+    }
+   }
+  }
+
+  /** @brief out[i] = a[i] + (b[i] - a[i]) * t[i], t not clamped. */
+  inline void
+   lerpUnclamped(const float* a, const float* b, const float* t, float* out, size_t n) {
+   detail::map3(a, b, t, out, n, [](auto va, auto vb, auto vt) { return va + (vb - va) * vt; });
+  }
+
+  /** @brief out[i] = lerp(a[i], b[i], t[i]) with t clamped to [0, 1] by min/max, no branches. */
+  inline void
+   lerp(const float* a, const float* b, const float* t, float* out, size_t n) {
+   detail::map3(a, b, t, out, n, [](auto va, auto vb, auto vt) {
+    return va + (vb - va) * easing::detail::Ops<decltype(vt)>::clamp01(vt);
+   });
+  }
+
+  /** @brief CVector3 lerp with t clamped to [0, 1]. */
+  inline void
+   lerp(const CVector3* a, const CVector3* b, const float* t, CVector3* out, size_t n) {
+   detail::forVector3(a, b, t, out, n, [](const float* fa, const float* fb, const float* ft, float* o, size_t c) { lerp(fa, fb, ft, o, c); });
+  }
+
+  /** @brief CVector3 lerp without clamping. */
+  inline void
+   lerpUnclamped(const CVector3* a, const CVector3* b, const float* t, CVector3* out, size_t n) {
+   detail::forVector3(a, b, t, out, n, [](const float* fa, const float* fb, const float* ft, float* o, size_t c) { lerpUnclamped(fa, fb, ft, o, c); });
+  }
+
+  /** @brief SoA CVector3 lerp with t clamped to [0, 1]. */
+  inline void
+   lerp(ConstSoA3 a, ConstSoA3 b, const float* t, SoA3 out, size_t n) {
+   lerp(a.x, b.x, t, out.x, n);
+   lerp(a.y, b.y, t, out.y, n);
+   lerp(a.z, b.z, t, out.z, n);
+  }
+
+  /** @brief SoA CVector3 lerp without clamping. */
+  inline void
+   lerpUnclamped(ConstSoA3 a, ConstSoA3 b, const float* t, SoA3 out, size_t n) {
+   lerpUnclamped(a.x, b.x, t, out.x, n);
+   lerpUnclamped(a.y, b.y, t, out.y, n);
+   lerpUnclamped(a.z, b.z, t, out.z, n);
+  }
+
+  /** @brief out[i] = smoothstep(edge0, edge1, x[i]). */
+  inline void
+   smoothstep(float edge0, float edge1, const float* x, float* out, size_t n) {
+   const float scale = 1.0f / (edge1 - edge0);
+   detail::map(x, out, n, [edge0, scale](auto v) {
+    using V = decltype(v);
+    V t = easing::detail::Ops<V>::clamp01((v - V::set1(edge0)) * V::set1(scale));
+    return t * t * (V::set1(3.0f) - V::set1(2.0f) * t);
+   });
+  }
+
+  /** @brief out[i] = smootherstep(edge0, edge1, x[i]). */
+  inline void
+   smootherstep(float edge0, float edge1, const float* x, float* out, size_t n) {
+   const float scale = 1.0f / (edge1 - edge0);
+   detail::map(x, out, n, [edge0, scale](auto v) {
+    using V = decltype(v);
+    V t = easing::detail::Ops<V>::clamp01((v - V::set1(edge0)) * V::set1(scale));
+    return t * t * t * (t * (t * V::set1(6.0f) - V::set1(15.0f)) + V::set1(10.0f));
+   });
+  }
+
+  /** @brief Tween step: out[i] = lerpUnclamped(a[i], b[i], ease(curve, t[i])), overshoot preserved. */
+  inline void
+   tween(Ease curve, const float* a, const float* b, const float* t, float* out, size_t n) {
+   detail::withCurve(curve, [a, b, t, out, n](auto kernel) {
+    detail::map3(a, b, t, out, n, [kernel](auto va, auto vb, auto vt) { return va + (vb - va) * kernel(vt); });
+   });
+  }
+
+  /** @brief CVector3 tween step, the curve evaluated once per vector. */
+  inline void
+   tween(Ease curve, const CVector3* a, const CVector3* b, const float* t, CVector3* out, size_t n) {
+   detail::forEasedChunks(curve, t, n, [a, b, out](const float* et, size_t base, size_t c) {
+    lerpUnclamped(a + base, b + base, et, out + base, c);
+   });
+  }
+
+  /** @brief SoA CVector3 tween step, the curve evaluated once per vector. */
+  inline void
+   tween(Ease curve, ConstSoA3 a, ConstSoA3 b, const float* t, SoA3 out, size_t n) {
+   detail::forEasedChunks(curve, t, n, [a, b, out](const float* et, size_t base, size_t c) {
+    lerpUnclamped(a.x + base, b.x + base, et, out.x + base, c);
+    lerpUnclamped(a.y + base, b.y + base, et, out.y + base, c);
+    lerpUnclamped(a.z + base, b.z + base, et, out.z + base, c);
+   });
+  }
+ }
+}
@@ -3,58 +3,293 @@
  * @brief General math function bunch to use in game engines.
  *
  * Has common functions manually implemented, including arithmetic, trigonometric, geometric, and conversion operations.
- * And other utilities such as interpolation, round methods, and factorial.
+ * And other utilities such as interpolation and round methods; factorial, binomial and the
+ * integer bit helpers live in IntMath.h, included here.
  * All functions are contained inside EngineMath namespace.
+ * Everything that does not touch float bits is constexpr; the rest (sqrt, rsqrt, exp, log, pow)
+ * becomes constexpr when compiled as C++20, where std::bit_cast is available.
  */
 
 #pragma once
+
+#include <cstring>
+#include <Core/Constants.h>
+#include <Core/Platform.h>
+#include <Core/SIMD.h>
+#include <Math/IntMath.h>
+
 namespace EngineMath {
  /** pi */
- float pi = 3.14159265358979323846f;
+ constexpr float pi = EU::Constants::PI;
  /** Euler */
- float e = 2.71828182845904523536f;
+ constexpr float e = EU::Constants::E;
+ /** Returns number squared*/
+ constexpr float
+  square(float number) {
+  return number * number;
+ }
+ namespace detail {
+  /** Reinterprets the bits of a float as an unsigned int. */
+  EU_CONSTEXPR20 unsigned int
+   floatBits(float value) {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+   return std::bit_cast<unsigned int>(value);
+#else
+   unsigned int bits;
+   std::memcpy(&bits, &value, sizeof(bits));
+   return bits;
+#endif
+  }
+
+  /** Reinterprets the bits of an unsigned int as a float. */
+  EU_CONSTEXPR20 float
+   bitsFloat(unsigned int bits) {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+   return std::bit_cast<float>(bits);
+#else
+   float value;
+   std::memcpy(&value, &bits, sizeof(value));
+   return value;
+#endif
+  }
+
+  /** One Newton-Raphson step for 1/sqrt(number) starting from estimate y. */
+  constexpr float
+   rsqrtStep(float number, float y) {
+   return y * (1.5f - 0.5f * number * y * y);
+  }
+
+  /** Bit-level estimate of 1/sqrt(number), relative error below 3.5%. */
+  EU_CONSTEXPR20 float
+   rsqrtEstimate(float number) {
+   return bitsFloat(0x5f375a86u - (floatBits(number) >> 1));
+  }
+ }
+
  /**
-  * @brief Calculates square root using Newton Rhapson.
-  * @param number Value to applu operation to.
-  * @return number's approximate square root.
+  * @brief Fast reciprocal square root, about 12 bits of precision.
+  *
+  * Uses the hardware estimate when available (rsqrtss, or vrsqrte plus one vrsqrts step),
+  * otherwise the bit-level estimate plus one Newton-Raphson step. Max relative error 1.8e-3.
+  * EU_REPRODUCIBLE builds always take the bit-level path: the estimate instructions differ
+  * between vendors.
+  * @param number Positive value.
+  * @return Approximation of 1 / sqrt(number).
   */
- inline float
-  sqrt(float number) {
-  if (number <= 0) {
-   return 0;
+ EU_CONSTEXPR20 float
+  rsqrtFast(float number) {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+  if (std::is_constant_evaluated()) {
+   return detail::rsqrtStep(number, detail::rsqrtEstimate(number));
   }
-  float xi = number / 2;
-  for (int i = 0; i < 10; i++) {
-   xi = xi - (square(xi) - number) / (2 * xi);
+#endif
+#if defined(EU_REPRODUCIBLE)
+  return detail::rsqrtStep(number, detail::rsqrtEstimate(number));
+#elif defined(EU_SIMD_SSE2)
+  return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(number)));
+#elif defined(EU_SIMD_NEON)
+  float32x2_t v = vdup_n_f32(number);
+  float32x2_t y = vrsqrte_f32(v);
+  y = vmul_f32(y, vrsqrts_f32(vmul_f32(v, y), y));
+  return vget_lane_f32(y, 0);
+#else
+  return detail::rsqrtStep(number, detail::rsqrtEstimate(number));
+#endif
+ }
+
+ /**
+  * @brief Reciprocal square root with near full float precision.
+  *
+  * Refines rsqrtFast() with one more Newton-Raphson step. Max relative error 5e-6
+  * (2e-7 on SSE). The result is undefined for number <= 0.
+  * @param number Positive value.
+  * @return Approximation of 1 / sqrt(number).
+  */
+ EU_CONSTEXPR20 float
+  rsqrt(float number) {
+  return detail::rsqrtStep(number, rsqrtFast(number));
+ }
+ /**
+  * @brief Precision tiers for sqrt().
+  *
+  * Every tier runs a constant number of steps whatever the input magnitude.
+  * Select one per call site with sqrtFast()/sqrtStandard()/sqrtHardware(), or for the
+  * whole build by defining EU_SQRT_DEFAULT_TIER to 0 (Fast), 1 (Standard) or 2 (Hardware).
+  */
+ enum class SqrtTier {
+  Fast = 0,     ///< ~10 bits, one Heron step from the exponent-bit seed
+  Standard = 1, ///< Full float precision, division-free refinement
+  Hardware = 2  ///< sqrtss / vsqrt instruction, falls back to Standard
+ };
+
+#ifndef EU_SQRT_DEFAULT_TIER
+ #define EU_SQRT_DEFAULT_TIER 1
+#endif
+
+ namespace detail {
+  /** Exponent-bit estimate of sqrt(number): halves the biased exponent, relative error below 4.5%. */
+  EU_CONSTEXPR20 float
+   sqrtEstimate(float number) {
+   return bitsFloat((floatBits(number) >> 1) + 0x1fbd1df5u);
+  }
+
+  /** Exponent-bit estimate of sqrt(number) for doubles, relative error below 3.5%. */
+  EU_CONSTEXPR20 double
+   sqrtEstimate(double number) {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+   return std::bit_cast<double>((std::bit_cast<unsigned long long>(number) >> 1) + 0x1ff7a3bea91d9b1bull);
+#else
+   unsigned long long bits;
+   std::memcpy(&bits, &number, sizeof(bits));
+   bits = (bits >> 1) + 0x1ff7a3bea91d9b1bull;
+   double value;
+   std::memcpy(&value, &bits, sizeof(value));
+   return value;
+#endif
   }
-  return xi;
  }
- /** Returns number squared*/
- inline float
-  square(float number) {
-  return number * number;
+
+ namespace detail {
+  /// Scale that brings a float denormal into the normal range, and the square root of its inverse.
+  constexpr float DENORMAL_SCALE = 18446744073709551616.0f;  // 2^64
+  constexpr float DENORMAL_UNSCALE = 2.3283064365386963e-10f; // 2^-32
  }
- /** Returns number cubed */
- inline float
-  cube(float number) {
-  return number * number * number;
+
+ /**
+  * @brief Fast square root, relative error below 1e-3.
+  * @param number Value to apply operation to.
+  * @return number's approximate square root, 0 for number <= 0, infinity for infinity.
+  */
+ EU_CONSTEXPR20 float
+  sqrtFast(float number) {
+  if (number <= 0.0f) {
+   return 0.0f;
+  }
+  if (number > 3.40282347e+38f) {
+   return number;
+  }
+  // Denormals are scaled by 2^64 first so the seed stays within a few percent.
+  const bool tiny = number < 1.17549435e-38f;
+  const float x = tiny ? number * detail::DENORMAL_SCALE : number;
+  float y = detail::sqrtEstimate(x);
+  y = 0.5f * (y + x / y);
+  return tiny ? y * detail::DENORMAL_UNSCALE : y;
  }
+
  /**
-  * @brief Positive power.
-  * @param base Power base.
-  * @param exponent Positive exponent.
-  * @return Base result to the power of exponent.
+  * @brief Square root with full float precision (relative error below 1.2e-7), denormals
+  * included.
+  *
+  * Two Newton-Raphson steps on 1/sqrt from the bit seed, then one division-free
+  * correction of the product number * (1/sqrt(number)).
+  * @param number Value to apply operation to.
+  * @return number's square root, 0 for number <= 0, infinity for infinity.
   */
- inline float
-  power(float base, float exponent) {
-  float result = 1.0f;
-  for (int i = 0; i < exponent; i++) {
-   result *= base;
+ EU_CONSTEXPR20 float
+  sqrtStandard(float number) {
+  if (number <= 0.0f) {
+   return 0.0f;
   }
-  return result;
+  if (number > 3.40282347e+38f) {
+   return number;
+  }
+  // Denormals are scaled by 2^64 first: the bit seed assumes a normal exponent.
+  const bool tiny = number < 1.17549435e-38f;
+  const float x = tiny ? number * detail::DENORMAL_SCALE : number;
+  float y = detail::rsqrtEstimate(x);
+  y = detail::rsqrtStep(x, y);
+  y = detail::rsqrtStep(x, y);
+  float root = x * y;
+  root = root + 0.5f * y * (x - root * root);
+  return tiny ? root * detail::DENORMAL_UNSCALE : root;
+ }
+
+ /**
+  * @brief Square root through the hardware instruction when the target has one.
+  *
+  * The instruction is correctly rounded, so it is reproducible. EU_REPRODUCIBLE builds on
+  * targets without it use the compiler's IEEE sqrt rather than the sqrtStandard() fallback.
+  * @param number Value to apply operation to.
+  * @return number's square root, 0 for number <= 0.
+  */
+ EU_CONSTEXPR20 float
+  sqrtHardware(float number) {
+  if (number <= 0.0f) {
+   return 0.0f;
+  }
+#if defined(EU_HAS_CONSTEXPR_BITS)
+  if (std::is_constant_evaluated()) {
+   return sqrtStandard(number);
+  }
+#endif
+#if defined(EU_SIMD_SSE2)
+  return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(number)));
+#elif defined(EU_SIMD_NEON) && defined(__aarch64__)
+  return vget_lane_f32(vsqrt_f32(vdup_n_f32(number)), 0);
+#elif defined(EU_REPRODUCIBLE) && defined(__GNUC__)
+  return __builtin_sqrtf(number);
+#else
+  return sqrtStandard(number);
+#endif
+ }
+
+ /**
+  * @brief Double-precision square root, for the double vector types.
+  *
+  * Uses sqrtsd / fsqrt where available, otherwise four Newton-Raphson steps from the
+  * exponent-bit seed (within 1 ulp). Named apart from sqrt() so integer arguments to sqrt()
+  * stay unambiguous.
+  * @param number Value to apply operation to.
+  * @return number's square root, 0 for number <= 0.
+  */
+ EU_CONSTEXPR20 double
+  sqrtDouble(double number) {
+  if (number <= 0.0) {
+   return 0.0;
+  }
+#if defined(EU_HAS_CONSTEXPR_BITS)
+  if (!std::is_constant_evaluated())
+#endif
+  {
+#if defined(EU_SIMD_SSE2)
+   return _mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(number)));
+#elif defined(EU_SIMD_NEON) && defined(__aarch64__)
+   return vget_lane_f64(vsqrt_f64(vdup_n_f64(number)), 0);
+#endif
+  }
+  // Denormals are scaled by 2^100 first so the seed stays within a few percent.
+  const bool tiny = number < 2.2250738585072014e-308;
+  double x = tiny ? number * 1267650600228229401496703205376.0 : number;
+  double y = detail::sqrtEstimate(x);
+  for (int i = 0; i < 4; ++i) {
+   y = 0.5 * (y + x / y);
+  }
+  return tiny ? y * 8.8817841970012523e-16 : y;
+ }
+
+ /**
+  * @brief Calculates the square root with the build's default tier (EU_SQRT_DEFAULT_TIER).
+  * @param number Value to apply operation to.
+  * @return number's square root, 0 for number <= 0.
+  */
+ EU_CONSTEXPR20 float
+  sqrt(float number) {
+#if EU_SQRT_DEFAULT_TIER == 0
+  return sqrtFast(number);
+#elif EU_SQRT_DEFAULT_TIER == 2
+  return sqrtHardware(number);
+#else
+  return sqrtStandard(number);
+#endif
+ }
+
+ /** Returns number cubed */
+ constexpr float
+  cube(float number) {
+  return number * number * number;
  }
  /** int absolute */
- inline int
+ constexpr int
   abs(int number) {
   if (number < 0) {
    return -1 * number;
@@ -64,7 +299,7 @@ namespace EngineMath {
   }
  }
  /** Max value between two floats */
- inline float
+ constexpr float
   eMax(float a, float b) {
   if (a > b) {
    return a;
@@ -74,7 +309,7 @@ namespace EngineMath {
   }
  }
  /** Min value between two floats */
- inline float
+ constexpr float
   eMin(float a, float b) {
   if (a < b) {
    return a;
@@ -83,30 +318,8 @@ namespace EngineMath {
    return b;
   }
  }
- /** Rounds a float to nearest int */
- inline int
-  round(float number) {
-  int intPart = static_cast<int>(number);
-  float fPart = number - intPart;
-  if (fPart >= 0.5f) {
-   return intPart + 1;
-  }
-  else {
-   return intPart;
-  }
- }
- /** Round float to nearest inferior int (floor) */
- inline int
-  floor(float number) {
-  return static_cast<int>(number);
- }
- /** Round float to nearest superior int (ceil) */
- inline int
-  ceil(float number) {
-  return static_cast<int>(number) + 1;
- }
  /** Float absoulte */
- inline float
+ constexpr float
   fabs(float number) {
   if (number < 0.0f) {
    return number * -1;
@@ -115,96 +328,629 @@ namespace EngineMath {
    return number;
   }
  }
- /** Rest of division between two floats */
- inline float
+ /**
+  * @brief True when a and b differ by at most epsilon (absolute tolerance).
+  *
+  * Equal values, infinities included, always compare equal; NaN never does.
+  */
+ constexpr bool
+  approxEqual(float a, float b, float epsilon = EU::Constants::EPSILON) {
+  return a == b || fabs(a - b) <= epsilon;
+ }
+ namespace detail {
+  /// 2^23: floats of this magnitude or larger have no fractional bits.
+  constexpr float INTEGRAL_THRESHOLD = 8388608.0f;
+ }
+ /**
+  * @brief Rounds toward zero, keeping the result as a float.
+  *
+  * One truncating conversion; magnitudes of 2^23 and above are already integral and pass
+  * through unchanged, so the int conversion can never overflow.
+  */
+ constexpr float
+  ftrunc(float number) {
+  return fabs(number) < detail::INTEGRAL_THRESHOLD ? static_cast<float>(static_cast<int>(number)) : number;
+ }
+ /** @brief Rounds toward -inf, keeping the result as a float (branchless select on the truncation). */
+ constexpr float
+  ffloor(float number) {
+  float t = ftrunc(number);
+  return t - (t > number ? 1.0f : 0.0f);
+ }
+ /** @brief Rounds toward +inf, keeping the result as a float. */
+ constexpr float
+  fceil(float number) {
+  float t = ftrunc(number);
+  return t + (t < number ? 1.0f : 0.0f);
+ }
+ /** @brief Rounds to nearest with halfway cases away from zero, keeping the result as a float. */
+ constexpr float
+  fround(float number) {
+  float t = ftrunc(number);
+  float f = number - t;
+  return t + ((f >= 0.5f ? 1.0f : 0.0f) - (f <= -0.5f ? 1.0f : 0.0f));
+ }
+ /** Rounds a float to nearest int, halfway cases away from zero (2.5 -> 3, -2.5 -> -3) */
+ constexpr int
+  round(float number) {
+  int intPart = static_cast<int>(number);
+  float f = number - static_cast<float>(intPart);
+  return intPart + static_cast<int>(f >= 0.5f) - static_cast<int>(f <= -0.5f);
+ }
+ /** Round float to nearest inferior int (floor), correct for negative inputs */
+ constexpr int
+  floor(float number) {
+  int intPart = static_cast<int>(number);
+  return intPart - static_cast<int>(number < static_cast<float>(intPart));
+ }
+ /** Round float to nearest superior int (ceil), integral inputs are returned unchanged */
+ constexpr int
+  ceil(float number) {
+  int intPart = static_cast<int>(number);
+  return intPart + static_cast<int>(number > static_cast<float>(intPart));
+ }
+ /**
+  * @brief Remainder of a / b with the sign of a, like C fmod (a - b * trunc(a / b)).
+  * @return Remainder in (-|b|, |b|), 0 when b is 0.
+  */
+ constexpr float
+  fmod(float a, float b) {
+  if (b == 0.0f) {
+   return 0.0f;
+  }
+  return a - b * ftrunc(a / b);
+ }
+ /**
+  * @brief Floored modulo of a by b: the result has the sign of b.
+  *
+  * Wraps negative values around, so mod(-1, 4) == 3, which is what grid and tile indexing
+  * wants. Results that round up to b are folded back to 0.
+  * @return Remainder in [0, b) for b > 0, (b, 0] for b < 0, 0 when b is 0.
+  */
+ constexpr float
   mod(float a, float b) {
-  if (b == 0) {
-   return 0;
+  if (b == 0.0f) {
+   return 0.0f;
+  }
+  float r = a - b * ffloor(a / b);
+  return r == b ? 0.0f : r;
+ }
+ namespace detail {
+  /// Cody-Waite split of ln2: LN2_HI has trailing zero bits so k * LN2_HI is exact.
+  constexpr float LN2_HI = 0.693145751953125f;
+  constexpr float LN2_LO = 1.428606765330187045e-06f;
+
+  /// Taylor coefficients of e^r on [-ln2/2, ln2/2], shared with the batch kernels.
+  constexpr float EXP_C3 = 0.166666667f;
+  constexpr float EXP_C4 = 0.0416666667f;
+  constexpr float EXP_C5 = 0.00833333333f;
+  constexpr float EXP_C6 = 0.00138888889f;
+  constexpr float EXP_C7 = 0.000198412698f;
+
+  /** Degree-7 polynomial for e^r on [-ln2/2, ln2/2], relative error 1.2e-7. */
+  constexpr float
+   expPoly(float r) {
+   return 1.0f + r * (1.0f + r * (0.5f + r * (EXP_C3 + r * (EXP_C4 + r * (EXP_C5 + r * (EXP_C6 + r * EXP_C7))))));
+  }
+
+  /** Polynomial for 2^f on [-0.5, 0.5], relative error 1.3e-7. */
+  constexpr float
+   exp2Poly(float f) {
+   return 1.0f + f * (0.6931471805599453f + f * (0.2402265069591007f + f * (0.05550410866482158f +
+          f * (0.009618129107628477f + f * (0.0013333558146428443f + f * 0.00015403530393381606f)))));
+  }
+
+  /** Natural log of a mantissa m in [sqrt(1/2), sqrt(2)) through the atanh series in t = (m-1)/(m+1). */
+  constexpr float
+   logMantissa(float m) {
+   float t = (m - 1.0f) / (m + 1.0f);
+   float t2 = t * t;
+   return 2.0f * t * (1.0f + t2 * (0.333333333f + t2 * (0.2f + t2 * (0.142857143f + t2 * 0.111111111f))));
+  }
+
+  /**
+   * @brief Splits a positive finite float into exponent and mantissa.
+   * @param number Positive value (denormals are handled).
+   * @param exponent Receives e such that number = m * 2^e.
+   * @return Mantissa m in [sqrt(1/2), sqrt(2)).
+   */
+  EU_CONSTEXPR20 float
+   splitMantissa(float number, int& exponent) {
+   int bias = 127;
+   if (number < 1.17549435e-38f) {
+    number *= 8388608.0f; // 2^23, brings denormals into the normal range
+    bias += 23;
+   }
+   unsigned int bits = floatBits(number);
+   exponent = static_cast<int>(bits >> 23) - bias;
+   float m = bitsFloat((bits & 0x007fffffu) | 0x3f800000u);
+   bool high = m > 1.41421356f;
+   exponent += high ? 1 : 0;
+   return high ? m * 0.5f : m;
   }
-  return (a / b) - (static_cast<int>(a / b));
  }
- /** Calculates e^x using power function */
- inline float
+
+ /**
+  * @brief Calculates 2^x in constant time.
+  *
+  * Splits x into a rounded integer part, written straight into the exponent bits, and a
+  * fraction in [-0.5, 0.5] evaluated with a degree-6 polynomial. Relative error 2e-7.
+  * @param x Exponent, clamped to [-126, 127.49].
+  * @return 2 raised to x.
+  */
+ EU_CONSTEXPR20 float
+  exp2(float x) {
+  x = x < -126.0f ? -126.0f : (x > 127.49f ? 127.49f : x);
+  int i = static_cast<int>(x + (x < 0.0f ? -0.5f : 0.5f));
+  float f = x - static_cast<float>(i);
+  return detail::bitsFloat(static_cast<unsigned int>(i + 127) << 23) * detail::exp2Poly(f);
+ }
+
+ /**
+  * @brief Calculates e^x in constant time.
+  *
+  * Cody-Waite reduction x = k * ln2 + r with |r| <= ln2 / 2, degree-7 polynomial for e^r,
+  * k written into the exponent bits. Relative error 2e-7.
+  * @param exponent Exponent, clamped to [-87.3, 88.37].
+  * @return e raised to exponent.
+  */
+ EU_CONSTEXPR20 float
   exp(float exponent) {
-  return power(e, exponent);
+  float x = exponent < -87.3f ? -87.3f : (exponent > 88.37f ? 88.37f : exponent);
+  int k = static_cast<int>(x * EU::Constants::LOG2_E + (x < 0.0f ? -0.5f : 0.5f));
+  float fk = static_cast<float>(k);
+  float r = x - fk * detail::LN2_HI;
+  r -= fk * detail::LN2_LO;
+  return detail::bitsFloat(static_cast<unsigned int>(k + 127) << 23) * detail::expPoly(r);
  }
- /** Angle's sin in radians using Taylor's series */
- inline float
-  sin(float angle) {
-  int n = 0;
-  float result = 0;
-  float currentTerm = angle;
-  while (fabs(currentTerm) >= 0.0000001 || n == 0) {
-   result += currentTerm;
-   n++;
-   currentTerm *= (-1.0 * angle * angle) / ((2.0 * n) * (2.0 * n + 1.0));
+
+ /**
+  * @brief Calculates the natural logarithm in constant time.
+  *
+  * Takes the exponent from the float bits and evaluates a short series on the mantissa.
+  * Absolute error 1e-7 for results near 0, relative error 2e-7 elsewhere.
+  * @param number Positive value.
+  * @return ln(number), or Constants::NEG_INF for number <= 0.
+  */
+ EU_CONSTEXPR20 float
+  log(float number) {
+  if (number <= 0.0f) {
+   return EU::Constants::NEG_INF;
+  }
+  int exponent = 0;
+  float m = detail::splitMantissa(number, exponent);
+  return static_cast<float>(exponent) * EU::Constants::LN_2 + detail::logMantissa(m);
+ }
+
+ /** Base-2 logarithm, Constants::NEG_INF for number <= 0. */
+ EU_CONSTEXPR20 float
+  log2(float number) {
+  if (number <= 0.0f) {
+   return EU::Constants::NEG_INF;
+  }
+  int exponent = 0;
+  float m = detail::splitMantissa(number, exponent);
+  return static_cast<float>(exponent) + detail::logMantissa(m) * EU::Constants::LOG2_E;
+ }
+
+ /**
+  * @brief Integer power by repeated squaring, O(log |exponent|) multiplies.
+  * @param base Power base.
+  * @param exponent Integer exponent (negative values return the reciprocal).
+  * @return base raised to exponent.
+  */
+ constexpr float
+  powi(float base, int exponent) {
+  unsigned int n = exponent < 0 ? static_cast<unsigned int>(-(exponent + 1)) + 1u
+                                : static_cast<unsigned int>(exponent);
+  float result = 1.0f;
+  while (n) {
+   if (n & 1u) {
+    result *= base;
+   }
+   base *= base;
+   n >>= 1;
+  }
+  return exponent < 0 ? 1.0f / result : result;
+ }
+
+ /**
+  * @brief Real power with fractional exponents, computed as exp2(exponent * log2(base)).
+  *
+  * Constant time. Relative error about 1e-7 * |exponent * log2(base)|, so 2e-6 for typical
+  * gamma and falloff curves. Negative bases are only defined for integral exponents;
+  * otherwise 0 is returned.
+  * @param base Power base.
+  * @param exponent Any real exponent.
+  * @return base raised to exponent.
+  */
+ EU_CONSTEXPR20 float
+  pow(float base, float exponent) {
+  if (base == 0.0f) {
+   return exponent == 0.0f ? 1.0f : 0.0f;
+  }
+  float magnitude = base < 0.0f ? -base : base;
+  float result = exp2(exponent * log2(magnitude));
+  if (base < 0.0f) {
+   int whole = static_cast<int>(exponent);
+   if (static_cast<float>(whole) != exponent) {
+    return 0.0f;
+   }
+   return (whole & 1) ? -result : result;
   }
   return result;
  }
+
  /**
-  * @brief Computes the cosine of the given angle in radians using Taylor series approximation.
+  * @brief Power with a real exponent. Kept for existing callers, same as pow().
+  * @param base Power base.
+  * @param exponent Exponent, fractional parts are honoured.
+  * @return Base result to the power of exponent.
+  */
+ EU_CONSTEXPR20 float
+  power(float base, float exponent) {
+  return pow(base, exponent);
+ }
+ namespace detail {
+  /**
+   * @brief Cody-Waite split of PI/2 in three floats.
+   *
+   * PIO2_1 and PIO2_2 have their low mantissa bits cleared, so the products with the
+   * quadrant count stay exact and the reduction keeps full accuracy up to |angle| = 8192.
+   */
+  constexpr float PIO2_1 = 1.5703125f;
+  constexpr float PIO2_2 = 4.837512969970703125e-4f;
+  constexpr float PIO2_3 = 7.54978995489188216e-8f;
+  constexpr float TWO_OVER_PI = 0.636619772367581343076f;
+
+  /// Minimax coefficients of the sin/cos polynomials, shared with the batch kernels.
+  constexpr float SIN_C3 = -1.6666654611e-1f;
+  constexpr float SIN_C5 = 8.3321608736e-3f;
+  constexpr float SIN_C7 = -1.9515295891e-4f;
+  constexpr float COS_C4 = 4.166664568298827e-2f;
+  constexpr float COS_C6 = -1.388731625493765e-3f;
+  constexpr float COS_C8 = 2.443315711809948e-5f;
+
+  /**
+   * @brief Reduces an angle to r in [-PI/4, PI/4] with angle = quadrant * PI/2 + r.
+   * @param angle Angle in radians.
+   * @param quadrant Receives the quarter-turn count (only the low 2 bits matter).
+   * @return Reduced angle r.
+   */
+  constexpr float
+   reduceHalfPi(float angle, int& quadrant) {
+   float half = angle < 0.0f ? -0.5f : 0.5f;
+   quadrant = static_cast<int>(angle * TWO_OVER_PI + half);
+   float k = static_cast<float>(quadrant);
+   float r = angle - k * PIO2_1;
+   r -= k * PIO2_2;
+   r -= k * PIO2_3;
+   return r;
+  }
+
+  /** Minimax sin polynomial on [-PI/4, PI/4] (degree 7, max error 6e-8). */
+  constexpr float
+   sinPoly(float r, float r2) {
+   return r + r * r2 * (SIN_C3 + r2 * (SIN_C5 + r2 * SIN_C7));
+  }
+
+  /** Minimax cos polynomial on [-PI/4, PI/4] (degree 8, max error 6e-8). */
+  constexpr float
+   cosPoly(float r2) {
+   return 1.0f - 0.5f * r2 + r2 * r2 * (COS_C4 + r2 * (COS_C6 + r2 * COS_C8));
+  }
+ }
+
+ /**
+  * @brief Computes the sine of an angle in radians.
+  *
+  * Fixed cost: one Cody-Waite reduction to [-PI/4, PI/4] and one minimax polynomial,
+  * no loops. Max absolute error is 1e-7 for |angle| <= 8192 (3e-7 at 2e4, 1e-6 at 1e5).
+  * @param angle Angle in radians.
+  * @return Approximated sine of the angle.
+  */
+ constexpr float
+  sin(float angle) {
+  int q = 0;
+  float r = detail::reduceHalfPi(angle, q);
+  float r2 = r * r;
+  float s = detail::sinPoly(r, r2);
+  float c = detail::cosPoly(r2);
+  float v = (q & 1) ? c : s;
+  return (q & 2) ? -v : v;
+ }
+
+ /**
+  * @brief Computes the cosine of an angle in radians.
+  *
+  * Same reduction and error bound as sin(): cos(x) is the sine polynomial shifted one quadrant.
   * @param radians Angle in radians.
   * @return Approximated cosine of the angle.
   */
- inline float
+ constexpr float
   cos(float radians) {
-  // Normalize the angle to [-π, π] for better precision
-  while (radians > 3.14159265f) radians -= 6.28318530f;
-  while (radians < -3.14159265f) radians += 6.28318530f;
-  float result = 1.0f;
-  float term = 1.0f;
-  float x2 = radians * radians;
-  int sign = -1;
-  // Use 6 terms of the Taylor series: enough for good approximation
-  for (int i = 2; i <= 10; i += 2) {
-   term *= x2 / (i * (i - 1));
-   result += sign * term;
-   sign *= -1;
+  int q = 0;
+  float r = detail::reduceHalfPi(radians, q);
+  float r2 = r * r;
+  float s = detail::sinPoly(r, r2);
+  float c = detail::cosPoly(r2);
+  float v = (q & 1) ? s : c;
+  return ((q + 1) & 2) ? -v : v;
+ }
+ /**
+  * @brief Computes sine and cosine of the same angle in one pass.
+  *
+  * Shares the range reduction and the r^2 term between both polynomials, so it costs
+  * little more than a single sin() call. Same error bound as sin() and cos().
+  * @param angle Angle in radians.
+  * @param s Receives sin(angle).
+  * @param c Receives cos(angle).
+  */
+ constexpr void
+  sincos(float angle, float* s, float* c) {
+  int q = 0;
+  float r = detail::reduceHalfPi(angle, q);
+  float r2 = r * r;
+  float ps = detail::sinPoly(r, r2);
+  float pc = detail::cosPoly(r2);
+  float vs = (q & 1) ? pc : ps;
+  float vc = (q & 1) ? ps : pc;
+  *s = (q & 2) ? -vs : vs;
+  *c = ((q + 1) & 2) ? -vc : vc;
+ }
+ namespace detail {
+  /// Cephes-derived minimax coefficients for tan, atan and asin, shared with the batch kernels.
+  constexpr float TAN_C3 = 3.33331568548e-1f;
+  constexpr float TAN_C5 = 1.33387994085e-1f;
+  constexpr float TAN_C7 = 5.34112807005e-2f;
+  constexpr float TAN_C9 = 2.44301354525e-2f;
+  constexpr float TAN_C11 = 3.11992232697e-3f;
+  constexpr float TAN_C13 = 9.38540185543e-3f;
+  constexpr float ATAN_C3 = -3.33329491539e-1f;
+  constexpr float ATAN_C5 = 1.99777106478e-1f;
+  constexpr float ATAN_C7 = -1.38776856032e-1f;
+  constexpr float ATAN_C9 = 8.05374449538e-2f;
+  constexpr float ASIN_C3 = 1.6666752422e-1f;
+  constexpr float ASIN_C5 = 7.4953002686e-2f;
+  constexpr float ASIN_C7 = 4.5470025998e-2f;
+  constexpr float ASIN_C9 = 2.4181311049e-2f;
+  constexpr float ASIN_C11 = 4.2163199048e-2f;
+
+  /// atan() argument reduction thresholds tan(PI/8) and tan(3PI/8).
+  constexpr float TAN_PI_8 = 0.414213562373095f;
+  constexpr float TAN_3PI_8 = 2.414213562373095f;
+
+  /** tan polynomial on [-PI/4, PI/4]. */
+  constexpr float
+   tanPoly(float r, float r2) {
+   return r + r * r2 * (TAN_C3 + r2 * (TAN_C5 + r2 * (TAN_C7 + r2 * (TAN_C9 + r2 * (TAN_C11 + r2 * TAN_C13)))));
   }
-  return result;
+
+  /** atan polynomial on [-tan(PI/8), tan(PI/8)]. */
+  constexpr float
+   atanPoly(float x) {
+   float z = x * x;
+   return x + x * z * (ATAN_C3 + z * (ATAN_C5 + z * (ATAN_C7 + z * ATAN_C9)));
+  }
+
+  /** asin polynomial on [0, 0.5], z = x * x. */
+  constexpr float
+   asinPoly(float x, float z) {
+   return x + x * z * (ASIN_C3 + z * (ASIN_C5 + z * (ASIN_C7 + z * (ASIN_C9 + z * ASIN_C11))));
+  }
+ }
+
+ /**
+  * @brief Computes the tangent of an angle in radians.
+  *
+  * Same Cody-Waite reduction as sin(); odd quadrants use -1 / tan(r).
+  * Max error is 2e-7 (relative above 1, absolute below) for |angle| <= 8192 while |tan| stays
+  * under about 1e3. Closer to an odd multiple of PI/2 the absolute error of the reduction,
+  * up to 4e-15 |angle|, is divided by the distance to the pole, so the relative error grows
+  * to 2e-7 + 4e-15 |angle * tan(angle)|: 1e-6 at the poles below 100, 4e-5 at 5854.358 and
+  * 8e-5 by 8192.
+  * @param angle Angle in radians.
+  * @return Approximated tangent of the angle.
+  */
+ constexpr float
+  tan(float angle) {
+  int q = 0;
+  float r = detail::reduceHalfPi(angle, q);
+  float t = detail::tanPoly(r, r * r);
+  return (q & 1) ? -1.0f / t : t;
+ }
+
+ /**
+  * @brief Computes the arc tangent.
+  *
+  * Reduces |x| to [0, tan(PI/8)] with the identities for PI/4 and PI/2, then one polynomial.
+  * Max absolute error is 1.5e-7 over the whole float range.
+  * @param x Any value (infinities map to +-PI/2).
+  * @return Angle in radians within [-PI/2, PI/2].
+  */
+ constexpr float
+  atan(float x) {
+  float a = x < 0.0f ? -x : x;
+  float offset = 0.0f;
+  if (a > detail::TAN_3PI_8) {
+   offset = EU::Constants::HALF_PI;
+   a = -1.0f / a;
+  }
+  else if (a > detail::TAN_PI_8) {
+   offset = EU::Constants::QUARTER_PI;
+   a = (a - 1.0f) / (a + 1.0f);
+  }
+  float r = offset + detail::atanPoly(a);
+  return x < 0.0f ? -r : r;
+ }
+
+ /**
+  * @brief Computes the angle of the vector (x, y) from the positive X axis.
+  *
+  * atan(y / x) corrected by +-PI for the left half-plane. Max absolute error is 3.5e-7.
+  * @param y Y component.
+  * @param x X component.
+  * @return Angle in radians within [-PI, PI], 0 when both components are zero.
+  */
+ constexpr float
+  atan2(float y, float x) {
+  if (x == 0.0f) {
+   if (y > 0.0f) return EU::Constants::HALF_PI;
+   if (y < 0.0f) return -EU::Constants::HALF_PI;
+   return 0.0f;
+  }
+  float r = atan(y / x);
+  if (x < 0.0f) {
+   r += (y < 0.0f) ? -EU::Constants::PI : EU::Constants::PI;
+  }
+  return r;
+ }
+
+ /**
+  * @brief Computes the arc sine.
+  *
+  * |x| > 0.5 goes through asin(x) = PI/2 - 2 asin(sqrt((1 - x) / 2)), so both halves share one
+  * polynomial. Max absolute error is 2e-7.
+  * @param x Sine value, clamped to [-1, 1] so rounding noise like 1.0000001 stays valid.
+  * @return Angle in radians within [-PI/2, PI/2].
+  */
+ EU_CONSTEXPR20 float
+  asin(float x) {
+  float a = x < 0.0f ? -x : x;
+  if (a > 1.0f) a = 1.0f;
+  float r = 0.0f;
+  if (a > 0.5f) {
+   float z = 0.5f * (1.0f - a);
+   r = EU::Constants::HALF_PI - 2.0f * detail::asinPoly(sqrtHardware(z), z);
+  }
+  else {
+   r = detail::asinPoly(a, a * a);
+  }
+  return x < 0.0f ? -r : r;
+ }
+
+ /**
+  * @brief Computes the arc cosine.
+  *
+  * Uses acos(x) = 2 asin(sqrt((1 - x) / 2)) near +-1, so results stay accurate for the
+  * small angles slerp sees with nearly parallel quaternions. Max absolute error is 3.5e-7.
+  * @param x Cosine value, clamped to [-1, 1].
+  * @return Angle in radians within [0, PI].
+  */
+ EU_CONSTEXPR20 float
+  acos(float x) {
+  float c = x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x);
+  if (c > 0.5f) {
+   float z = 0.5f * (1.0f - c);
+   return 2.0f * detail::asinPoly(sqrtHardware(z), z);
+  }
+  if (c < -0.5f) {
+   float z = 0.5f * (1.0f + c);
+   return EU::Constants::PI - 2.0f * detail::asinPoly(sqrtHardware(z), z);
+  }
+  return EU::Constants::HALF_PI - detail::asinPoly(c, c * c);
+ }
+ /**
+  * @brief Wraps an angle into [-PI, PI] in constant time.
+  *
+  * Subtracts the nearest whole number of turns using the Cody-Waite split of 2PI, so angles
+  * accumulated over long sessions keep their fractional accuracy. One select-based fix-up
+  * covers the turn count rounding the wrong way right at +-PI.
+  * @param angle Angle in radians.
+  * @return Equivalent angle within [-PI, PI].
+  */
+ constexpr float
+  wrapAngle(float angle) {
+  float k = fround(angle * (0.25f * detail::TWO_OVER_PI));
+  float r = angle - k * (4.0f * detail::PIO2_1);
+  r -= k * (4.0f * detail::PIO2_2);
+  r -= k * (4.0f * detail::PIO2_3);
+  float fix = (r > EU::Constants::PI ? 1.0f : 0.0f) - (r < -EU::Constants::PI ? 1.0f : 0.0f);
+  return r - fix * EU::Constants::TWO_PI;
+ }
+ /**
+  * @brief Wraps an angle into [-PI, PI] in constant time; same as wrapAngle().
+  */
+ constexpr float
+  wrapPi(float angle) {
+  return wrapAngle(angle);
+ }
+ /**
+  * @brief Wraps an angle into [0, 2PI) in constant time.
+  * @param angle Angle in radians.
+  * @return Equivalent angle within [0, 2PI).
+  */
+ constexpr float
+  wrap2Pi(float angle) {
+  float r = wrapAngle(angle);
+  r = r < 0.0f ? r + EU::Constants::TWO_PI : r;
+  return r < EU::Constants::TWO_PI ? r : 0.0f;
+ }
+ /**
+  * @brief Signed shortest-arc difference between two angles.
+  * @param from Start angle in radians.
+  * @param to End angle in radians.
+  * @return The angle d in [-PI, PI] such that from + d is equivalent to to.
+  */
+ constexpr float
+  angleDelta(float from, float to) {
+  return wrapAngle(to - from);
+ }
+ /**
+  * @brief Interpolates between two angles along the shortest arc.
+  *
+  * The result is continuous in t and is not wrapped, so it stays close to from; pass it
+  * through wrapPi() if it has to be kept in range.
+  * @param from Start angle in radians.
+  * @param to End angle in radians.
+  * @param t Interpolation factor, not clamped.
+  */
+ constexpr float
+  angleLerp(float from, float to, float t) {
+  return from + angleDelta(from, to) * t;
  }
  /** Converts degree to radians */
- inline float
+ constexpr float
   radians(float degrees) {
   return (degrees * pi) / 180.0f;
  }
  /** Converts radians to degree */
- inline float
+ constexpr float
   degrees(float radian) {
   return (radian * 180) / pi;
  }
  /** Calculates circle area */
- inline float
+ constexpr float
   circleArea(float radius) {
   return pi * radius * radius;
  }
  /** Calculates circle circunference */
- inline float
+ constexpr float
   circleCircumference(float radius) {
   return 2.0f * pi * radius;
  }
  /** Calculates rectangle area */
- inline float
+ constexpr float
   rectArea(float width, float height) {
   return width * height;
  }
  /** Calculates circle perimeter */
- inline float
+ constexpr float
   rectPerimeter(float width, float height) {
   return 2.0f * (width + height);
  }
  /** Calculates triangle area */
- inline float
+ constexpr float
   triArea(float base, float height) {
   return 0.5f * base * height;
  }
  /** Calculates triangle perimeter */
- inline float
+ constexpr float
   triPerimeter(float side1, float side2, float side3) {
   return side1 + side2 + side3;
  }
  /** Calculates equilateral triangle perimeter */
- inline float
+ constexpr float
   triPerimeter(float side) {
   return 3 * side;
  }
@@ -216,7 +962,7 @@ namespace EngineMath {
   * @param x1 Y Coordinate second point.
   * @return Distance between both points.
   */
- inline float
+ EU_CONSTEXPR20 float
   distance(float x1, float y1, float x2, float y2) {
   float dx = x2 - x1;
   float dy = y2 - y1;
@@ -229,17 +975,38 @@ namespace EngineMath {
   * @param t Interpolant value (0-1).
   * @return Interpolated value.
   */
- inline float
+ constexpr float
   lerp(float start, float end, float t) {
   return start + (end - start) * t;
  }
- /** Positive integer factorial */
- inline long
-  factorial(int number) {
-  int result = 1;
-  for (int i = number; i > 0; i--) {
-   result *= i;
-  }
-  return result;
+
+ /**
+  * @brief Clamps a value to [low, high] with two compares that compile to minss/maxss.
+  * @return low for NaN input.
+  */
+ constexpr float
+  clamp(float value, float low, float high) {
+  return value > low ? (value < high ? value : high) : low;
+ }
+
+ /**
+  * @brief Hermite interpolation 3x^2 - 2x^3 of x between two edges, clamped to [0, 1].
+  * @param edge0 Value mapped to 0.
+  * @param edge1 Value mapped to 1 (must differ from edge0).
+  * @param x Input value.
+  */
+ constexpr float
+  smoothstep(float edge0, float edge1, float x) {
+  float t = clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+  return t * t * (3.0f - 2.0f * t);
+ }
+
+ /**
+  * @brief Perlin's smootherstep 6x^5 - 15x^4 + 10x^3, with zero first and second derivatives at the edges.
+  */
+ constexpr float
+  smootherstep(float edge0, float edge1, float x) {
+  float t = clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+  return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
  }
 }
\ No newline at end of file
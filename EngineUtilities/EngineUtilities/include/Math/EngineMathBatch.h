@@ -0,0 +1,589 @@
+/**
+ * @file EngineMathBatch.h
+ * @brief Batched versions of the EngineMath kernels over contiguous float arrays.
+ *
+ * Each function processes n values from `in` into `out` (in == out is allowed) with the widest
+ * SIMD register available (AVX2, SSE2 or NEON), using the same reductions and polynomials as the
+ * scalar functions in EngineMath.h. Remainders are padded into one extra vector, so every element
+ * gets the exact same code path regardless of its position in the array.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+
+namespace EngineMath {
+ namespace batch {
+  /**
+   * @namespace kernels
+   * @brief Lane-generic kernels, instantiated for EU::SIMD::Float4 and Float8.
+   */
+  namespace kernels {
+   /** Cody-Waite reduction to [-PI/4, PI/4], returns r and the quadrant per lane. */
+   template<typename V>
+   inline V
+    reduceHalfPi(V x, typename V::Int& quadrant) {
+    quadrant = EU::SIMD::roundToInt(x * V::set1(detail::TWO_OVER_PI));
+    V k = EU::SIMD::toFloat(quadrant);
+    V r = x - k * V::set1(detail::PIO2_1);
+    r = r - k * V::set1(detail::PIO2_2);
+    return r - k * V::set1(detail::PIO2_3);
+   }
+
+   template<typename V>
+   inline V
+    sinPoly(V r, V r2) {
+    V p = V::set1(detail::SIN_C5) + r2 * V::set1(detail::SIN_C7);
+    p = V::set1(detail::SIN_C3) + r2 * p;
+    return r + r * r2 * p;
+   }
+
+   template<typename V>
+   inline V
+    cosPoly(V r2) {
+    V p = V::set1(detail::COS_C6) + r2 * V::set1(detail::COS_C8);
+    p = V::set1(detail::COS_C4) + r2 * p;
+    return V::set1(1.0f) - V::set1(0.5f) * r2 + r2 * r2 * p;
+   }
+
+   /** Lane mask of (value & bit) != 0. */
+   template<typename V>
+   inline V
+    bitMask(typename V::Int value, int bit) {
+    using I = typename V::Int;
+    return EU::SIMD::asFloat((value & I::set1(bit)) == I::set1(bit));
+   }
+
+   /** Sign bit set where (value & 2) != 0. */
+   template<typename V>
+   inline V
+    quadrantSign(typename V::Int value) {
+    using I = typename V::Int;
+    return EU::SIMD::asFloat(EU::SIMD::shiftLeft<30>(value & I::set1(2)));
+   }
+
+   template<typename V>
+   inline V
+    sin(V x) {
+    typename V::Int q;
+    V r = reduceHalfPi(x, q);
+    V r2 = r * r;
+    V v = EU::SIMD::select(bitMask<V>(q, 1), cosPoly(r2), sinPoly(r, r2));
+    return v ^ quadrantSign<V>(q);
+   }
+
+   template<typename V>
+   inline V
+    cos(V x) {
+    using I = typename V::Int;
+    typename V::Int q;
+    V r = reduceHalfPi(x, q);
+    V r2 = r * r;
+    V v = EU::SIMD::select(bitMask<V>(q, 1), sinPoly(r, r2), cosPoly(r2));
+    return v ^ quadrantSign<V>(q + I::set1(1));
+   }
+
+   /** sin(x) and cos(x) from one reduction and one pair of polynomials. */
+   template<typename V>
+   inline void
+    sincos(V x, V& s, V& c) {
+    using I = typename V::Int;
+    typename V::Int q;
+    V r = reduceHalfPi(x, q);
+    V r2 = r * r;
+    V ps = sinPoly(r, r2), pc = cosPoly(r2);
+    V swap = bitMask<V>(q, 1);
+    s = EU::SIMD::select(swap, pc, ps) ^ quadrantSign<V>(q);
+    c = EU::SIMD::select(swap, ps, pc) ^ quadrantSign<V>(q + I::set1(1));
+   }
+
+   template<typename V>
+   inline V
+    sqrt(V x) {
+    return EU::SIMD::sqrt(EU::SIMD::max(x, V::zero()));
+   }
+
+   template<typename V>
+   inline V
+    rsqrt(V x) {
+    V y = EU::SIMD::rsqrtEstimate(x);
+    return y * (V::set1(1.5f) - V::set1(0.5f) * x * y * y);
+   }
+
+   template<typename V>
+   inline V
+    exp(V x) {
+    using I = typename V::Int;
+    x = EU::SIMD::min(EU::SIMD::max(x, V::set1(-87.3f)), V::set1(88.37f));
+    I k = EU::SIMD::roundToInt(x * V::set1(EU::Constants::LOG2_E));
+    V fk = EU::SIMD::toFloat(k);
+    V r = x - fk * V::set1(detail::LN2_HI);
+    r = r - fk * V::set1(detail::LN2_LO);
+    V p = V::set1(detail::EXP_C6) + r * V::set1(detail::EXP_C7);
+    p = V::set1(detail::EXP_C5) + r * p;
+    p = V::set1(detail::EXP_C4) + r * p;
+    p = V::set1(detail::EXP_C3) + r * p;
+    p = V::set1(0.5f) + r * p;
+    p = V::set1(1.0f) + r * p;
+    p = V::set1(1.0f) + r * p;
+    V scale = EU::SIMD::asFloat(EU::SIMD::shiftLeft<23>(k + I::set1(127)));
+    return scale * p;
+   }
+
+   template<typename V>
+   inline V
+    exp2(V x) {
+    using I = typename V::Int;
+    x = EU::SIMD::min(EU::SIMD::max(x, V::set1(-126.0f)), V::set1(127.49f));
+    I i = EU::SIMD::roundToInt(x);
+    V f = x - EU::SIMD::toFloat(i);
+    V p = V::set1(0.0013333558146428443f) + f * V::set1(0.00015403530393381606f);
+    p = V::set1(0.009618129107628477f) + f * p;
+    p = V::set1(0.05550410866482158f) + f * p;
+    p = V::set1(0.2402265069591007f) + f * p;
+    p = V::set1(0.6931471805599453f) + f * p;
+    p = V::set1(1.0f) + f * p;
+    return EU::SIMD::asFloat(EU::SIMD::shiftLeft<23>(i + I::set1(127))) * p;
+   }
+
+   /** EngineMath::log() across lanes: exponent from the float bits, atanh series on the mantissa. */
+   template<typename V>
+   inline V
+    log(V x) {
+    using I = typename V::Int;
+    const V one = V::set1(1.0f);
+    const V tiny = x < V::set1(1.17549435e-38f);
+    const I bits = EU::SIMD::asInt(EU::SIMD::select(tiny, x * V::set1(8388608.0f), x));
+    V e = EU::SIMD::toFloat(EU::SIMD::shiftRight<23>(bits) - I::set1(127)) - (tiny & V::set1(23.0f));
+    V m = EU::SIMD::asFloat((bits & I::set1(0x007fffff)) | I::set1(0x3f800000));
+    const V high = m > V::set1(1.41421356f);
+    e = e + (high & one);
+    m = EU::SIMD::select(high, m * V::set1(0.5f), m);
+    const V t = (m - one) / (m + one);
+    const V t2 = t * t;
+    V p = V::set1(0.142857143f) + t2 * V::set1(0.111111111f);
+    p = V::set1(0.2f) + t2 * p;
+    p = V::set1(0.333333333f) + t2 * p;
+    p = one + t2 * p;
+    const V r = e * V::set1(EU::Constants::LN_2) + V::set1(2.0f) * t * p;
+    return EU::SIMD::select(x > V::zero(), r, V::set1(EU::Constants::NEG_INF));
+   }
+
+   /** EngineMath::pow() across lanes as exp2(exponent * log2(base)); bases <= 0 give 0, or 1 for a zero exponent. */
+   template<typename V>
+   inline V
+    pow(V base, V exponent) {
+    const V r = exp2(exponent * log(base) * V::set1(EU::Constants::LOG2_E));
+    return EU::SIMD::select(base > V::zero(), r, (exponent == V::zero()) & V::set1(1.0f));
+   }
+
+   /** Sign bit of each lane. */
+   template<typename V>
+   inline V
+    signBit(V x) {
+    return x & V::set1(-0.0f);
+   }
+
+   template<typename V>
+   inline V
+    tan(V x) {
+    typename V::Int q;
+    V r = reduceHalfPi(x, q);
+    V r2 = r * r;
+    V p = V::set1(detail::TAN_C11) + r2 * V::set1(detail::TAN_C13);
+    p = V::set1(detail::TAN_C9) + r2 * p;
+    p = V::set1(detail::TAN_C7) + r2 * p;
+    p = V::set1(detail::TAN_C5) + r2 * p;
+    p = V::set1(detail::TAN_C3) + r2 * p;
+    V t = r + r * r2 * p;
+    return EU::SIMD::select(bitMask<V>(q, 1), V::set1(-1.0f) / t, t);
+   }
+
+   template<typename V>
+   inline V
+    atan(V x) {
+    V sign = signBit(x);
+    V a = x ^ sign;
+    V big = a > V::set1(detail::TAN_3PI_8);
+    V mid = a > V::set1(detail::TAN_PI_8);
+    V xr = EU::SIMD::select(big, V::set1(-1.0f) / a,
+                            EU::SIMD::select(mid, (a - V::set1(1.0f)) / (a + V::set1(1.0f)), a));
+    V offset = EU::SIMD::select(big, V::set1(EU::Constants::HALF_PI),
+                                EU::SIMD::select(mid, V::set1(EU::Constants::QUARTER_PI), V::zero()));
+    V z = xr * xr;
+    V p = V::set1(detail::ATAN_C7) + z * V::set1(detail::ATAN_C9);
+    p = V::set1(detail::ATAN_C5) + z * p;
+    p = V::set1(detail::ATAN_C3) + z * p;
+    return (offset + (xr + xr * z * p)) ^ sign;
+   }
+
+   template<typename V>
+   inline V
+    atan2(V y, V x) {
+    V r = atan(y / x);
+    V halfTurn = EU::SIMD::select(y < V::zero(), V::set1(-EU::Constants::PI), V::set1(EU::Constants::PI));
+    r = r + EU::SIMD::select(x < V::zero(), halfTurn, V::zero());
+    V axis = EU::SIMD::select(y > V::zero(), V::set1(EU::Constants::HALF_PI),
+                              EU::SIMD::select(y < V::zero(), V::set1(-EU::Constants::HALF_PI), V::zero()));
+    return EU::SIMD::select(x == V::zero(), axis, r);
+   }
+
+   /** Shared asin core: a = |x| clamped to [0, 1], returns the polynomial and the a > 0.5 mask. */
+   template<typename V>
+   inline V
+    asinCore(V a, V& big) {
+    big = a > V::set1(0.5f);
+    V z = EU::SIMD::select(big, V::set1(0.5f) * (V::set1(1.0f) - a), a * a);
+    V s = EU::SIMD::select(big, EU::SIMD::sqrt(z), a);
+    V p = V::set1(detail::ASIN_C9) + z * V::set1(detail::ASIN_C11);
+    p = V::set1(detail::ASIN_C7) + z * p;
+    p = V::set1(detail::ASIN_C5) + z * p;
+    p = V::set1(detail::ASIN_C3) + z * p;
+    return s + s * z * p;
+   }
+
+   template<typename V>
+   inline V
+    asin(V x) {
+    V sign = signBit(x);
+    V a = EU::SIMD::min(x ^ sign, V::set1(1.0f));
+    V big;
+    V p = asinCore(a, big);
+    V r = EU::SIMD::select(big, V::set1(EU::Constants::HALF_PI) - V::set1(2.0f) * p, p);
+    return r ^ sign;
+   }
+
+   template<typename V>
+   inline V
+    acos(V x) {
+    V c = EU::SIMD::min(EU::SIMD::max(x, V::set1(-1.0f)), V::set1(1.0f));
+    V sign = signBit(c);
+    V big;
+    V p = asinCore(c ^ sign, big);
+    V twice = V::set1(2.0f) * p;
+    V nearOne = EU::SIMD::select(c < V::zero(), V::set1(EU::Constants::PI) - twice, twice);
+    return EU::SIMD::select(big, nearOne, V::set1(EU::Constants::HALF_PI) - (p ^ sign));
+   }
+
+   template<typename V>
+   inline V
+    round(V x) {
+    V t = EU::SIMD::truncate(x);
+    V f = x - t;
+    V one = V::set1(1.0f);
+    return t + ((f >= V::set1(0.5f)) & one) - ((f <= V::set1(-0.5f)) & one);
+   }
+
+   template<typename V>
+   inline V
+    fmod(V a, V b) {
+    V r = a - b * EU::SIMD::truncate(a / b);
+    return EU::SIMD::select(b == V::zero(), V::zero(), r);
+   }
+
+   template<typename V>
+   inline V
+    mod(V a, V b) {
+    V r = a - b * EU::SIMD::floor(a / b);
+    r = EU::SIMD::select(r == b, V::zero(), r);
+    return EU::SIMD::select(b == V::zero(), V::zero(), r);
+   }
+
+   template<typename V>
+   inline V
+    wrapAngle(V x) {
+    V k = round(x * V::set1(0.25f * detail::TWO_OVER_PI));
+    V r = x - k * V::set1(4.0f * detail::PIO2_1);
+    r = r - k * V::set1(4.0f * detail::PIO2_2);
+    r = r - k * V::set1(4.0f * detail::PIO2_3);
+    V one = V::set1(1.0f);
+    V fix = ((r > V::set1(EU::Constants::PI)) & one) - ((r < V::set1(-EU::Constants::PI)) & one);
+    return r - fix * V::set1(EU::Constants::TWO_PI);
+   }
+
+   template<typename V>
+   inline V
+    wrap2Pi(V x) {
+    V r = wrapAngle(x);
+    V twoPi = V::set1(EU::Constants::TWO_PI);
+    r = r + ((r < V::zero()) & twoPi);
+    return r & (r < twoPi);
+   }
+
+   template<typename V>
+   inline V
+    angleLerp(V from, V to, V t) {
+    return from + wrapAngle(to - from) * t;
+   }
+  }
+
+  namespace detail {
+   /**
+    * @brief Applies a lane-generic kernel over an array, widest lanes first.
+    * @param in Source values.
+    * @param out Destination values (may alias in).
+    * @param n Element count.
+    * @param kernel Generic callable taking and returning a SIMD float type.
+    */
+   template<typename Kernel>
+   inline void
+    map(const float* in, float* out, size_t n, Kernel kernel) {
+    using V = EU::SIMD::FloatN;
+    const size_t W = static_cast<size_t>(V::WIDTH);
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+     kernel(V::load(in + i)).store(out + i);
+    }
+    if (i < n) {
+     float tmp[EU::SIMD::FloatN::WIDTH] = {};
+     for (size_t j = i; j < n; ++j) tmp[j - i] = in[j];
+     kernel(V::load(tmp)).store(tmp);
+     for (size_t j = i; j < n; ++j) out[j] = tmp[j - i];
+    }
+   }
+
+   /** @brief Two-input variant of map(): out[i] = kernel(a[i], b[i]). */
+   template<typename Kernel>
+   inline void
+    map2(const float* a, const float* b, float* out, size_t n, Kernel kernel) {
+    using V = EU::SIMD::FloatN;
+    const size_t W = static_cast<size_t>(V::WIDTH);
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+     kernel(V::load(a + i), V::load(b + i)).store(out + i);
+    }
+    if (i < n) {
+     float ta[EU::SIMD::FloatN::WIDTH] = {};
+     float tb[EU::SIMD::FloatN::WIDTH] = {};
+     for (size_t j = i; j < n; ++j) {
+      ta[j - i] = a[j];
+      tb[j - i] = b[j];
+     }
+     kernel(V::load(ta), V::load(tb)).store(ta);
+     for (size_t j = i; j < n; ++j) out[j] = ta[j - i];
+    }
+   }
+
+   /** @brief Three-input variant of map(): out[i] = kernel(a[i], b[i], c[i]). */
+   template<typename Kernel>
+   inline void
+    map3(const float* a, const float* b, const float* c, float* out, size_t n, Kernel kernel) {
+    using V = EU::SIMD::FloatN;
+    const size_t W = static_cast<size_t>(V::WIDTH);
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+     kernel(V::load(a + i), V::load(b + i), V::load(c + i)).store(out + i);
+    }
+    if (i < n) {
+     float ta[EU::SIMD::FloatN::WIDTH] = {};
+     float tb[EU::SIMD::FloatN::WIDTH] = {};
+     float tc[EU::SIMD::FloatN::WIDTH] = {};
+     for (size_t j = i; j < n; ++j) {
+      ta[j - i] = a[j];
+      tb[j - i] = b[j];
+      tc[j - i] = c[j];
+     }
+     kernel(V::load(ta), V::load(tb), V::load(tc)).store(ta);
+     for (size_t j = i; j < n; ++j) out[j] = ta[j - i];
+    }
+   }
+  }
+
+  /** @brief Read-only structure-of-arrays view of n 2D vectors. */
+  struct ConstSoA2 {
+   const float* x;
+   const float* y;
+  };
+
+  /** @brief Structure-of-arrays view of n 2D vectors. */
+  struct SoA2 {
+   float* x;
+   float* y;
+   operator ConstSoA2() const { return { x, y }; }
+  };
+
+  /** @brief Read-only structure-of-arrays view of n 3D vectors. */
+  struct ConstSoA3 {
+   const float* x;
+   const float* y;
+   const float* z;
+  };
+
+  /** @brief Structure-of-arrays view of n 3D vectors. */
+  struct SoA3 {
+   float* x;
+   float* y;
+   float* z;
+   operator ConstSoA3() const { return { x, y, z }; }
+  };
+
+  /** @brief out[i] = sin(in[i]). Same error bound as EngineMath::sin. */
+  inline void
+   sin(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::sin(v); });
+  }
+
+  /** @brief out[i] = cos(in[i]). Same error bound as EngineMath::cos. */
+  inline void
+   cos(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::cos(v); });
+  }
+
+  /** @brief s[i] = sin(in[i]) and c[i] = cos(in[i]) with one shared range reduction. */
+  inline void
+   sincos(const float* in, float* s, float* c, size_t n) {
+   using V = EU::SIMD::FloatN;
+   const size_t W = static_cast<size_t>(V::WIDTH);
+   V vs, vc;
+   size_t i = 0;
+   for (; i + W <= n; i += W) {
+    kernels::sincos(V::load(in + i), vs, vc);
+    vs.store(s + i);
+    vc.store(c + i);
+   }
+   if (i < n) {
+    float ts[EU::SIMD::FloatN::WIDTH] = {};
+    float tc[EU::SIMD::FloatN::WIDTH];
+    for (size_t j = i; j < n; ++j) ts[j - i] = in[j];
+    kernels::sincos(V::load(ts), vs, vc);
+    vs.store(ts);
+    vc.store(tc);
+    for (size_t j = i; j < n; ++j) {
+     s[j] = ts[j - i];
+     c[j] = tc[j - i];
+    }
+   }
+  }
+
+  /** @brief out[i] = sqrt(in[i]) through the hardware instruction, 0 for negative inputs. */
+  inline void
+   sqrt(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::sqrt(v); });
+  }
+
+  /** @brief out[i] = 1 / sqrt(in[i]), hardware estimate plus one Newton-Raphson step. */
+  inline void
+   rsqrt(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::rsqrt(v); });
+  }
+
+  /** @brief out[i] = e^in[i]. Same error bound and clamping as EngineMath::exp. */
+  inline void
+   exp(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::exp(v); });
+  }
+
+  /** @brief out[i] = 2^in[i]. Same error bound and clamping as EngineMath::exp2. */
+  inline void
+   exp2(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::exp2(v); });
+  }
+
+  /** @brief out[i] = ln(in[i]). Same error bound as EngineMath::log, NEG_INF for in[i] <= 0. */
+  inline void
+   log(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::log(v); });
+  }
+
+  /**
+   * @brief out[i] = base[i]^exponent[i] for base[i] > 0, as EngineMath::pow; bases <= 0 give
+   * 0, or 1 for a zero exponent.
+   */
+  inline void
+   pow(const float* base, const float* exponent, float* out, size_t n) {
+   detail::map2(base, exponent, out, n, [](auto b, auto e) { return kernels::pow(b, e); });
+  }
+
+  /** @brief out[i] = tan(in[i]). Same error bound as EngineMath::tan. */
+  inline void
+   tan(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::tan(v); });
+  }
+
+  /** @brief out[i] = atan(in[i]). Same error bound as EngineMath::atan. */
+  inline void
+   atan(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::atan(v); });
+  }
+
+  /** @brief out[i] = atan2(y[i], x[i]). Same error bound and zero handling as EngineMath::atan2. */
+  inline void
+   atan2(const float* y, const float* x, float* out, size_t n) {
+   detail::map2(y, x, out, n, [](auto vy, auto vx) { return kernels::atan2(vy, vx); });
+  }
+
+  /** @brief out[i] = asin(in[i]), inputs clamped to [-1, 1]. Same error bound as EngineMath::asin. */
+  inline void
+   asin(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::asin(v); });
+  }
+
+  /** @brief out[i] = acos(in[i]), inputs clamped to [-1, 1]. Same error bound as EngineMath::acos. */
+  inline void
+   acos(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::acos(v); });
+  }
+
+  /** @brief out[i] = floor(in[i]) as floats, roundps on SSE4.1/AVX2. */
+  inline void
+   floor(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return EU::SIMD::floor(v); });
+  }
+
+  /** @brief out[i] = ceil(in[i]) as floats. */
+  inline void
+   ceil(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return EU::SIMD::ceil(v); });
+  }
+
+  /** @brief out[i] = round(in[i]) as floats, halfway cases away from zero like EngineMath::fround. */
+  inline void
+   round(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::round(v); });
+  }
+
+  /** @brief out[i] = fmod(a[i], b[i]), remainder with the sign of a. */
+  inline void
+   fmod(const float* a, const float* b, float* out, size_t n) {
+   detail::map2(a, b, out, n, [](auto va, auto vb) { return kernels::fmod(va, vb); });
+  }
+
+  /** @brief out[i] = mod(a[i], b[i]), floored modulo with the sign of b. */
+  inline void
+   mod(const float* a, const float* b, float* out, size_t n) {
+   detail::map2(a, b, out, n, [](auto va, auto vb) { return kernels::mod(va, vb); });
+  }
+
+  /** @brief out[i] = wrapAngle(in[i]), every angle wrapped into [-PI, PI]. */
+  inline void
+   wrapAngle(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::wrapAngle(v); });
+  }
+
+  /** @brief out[i] = wrapPi(in[i]), same as wrapAngle(). */
+  inline void
+   wrapPi(const float* in, float* out, size_t n) {
+   wrapAngle(in, out, n);
+  }
+
+  /** @brief out[i] = wrap2Pi(in[i]), every angle wrapped into [0, 2PI). */
+  inline void
+   wrap2Pi(const float* in, float* out, size_t n) {
+   detail::map(in, out, n, [](auto v) { return kernels::wrap2Pi(v); });
+  }
+
+  /** @brief out[i] = angleDelta(from[i], to[i]), shortest signed arc in [-PI, PI]. */
+  inline void
+   angleDelta(const float* from, const float* to, float* out, size_t n) {
+   detail::map2(from, to, out, n, [](auto a, auto b) { return kernels::wrapAngle(b - a); });
+  }
+
+  /** @brief out[i] = angleLerp(from[i], to[i], t[i]) along the shortest arc. */
+  inline void
+   angleLerp(const float* from, const float* to, const float* t, float* out, size_t n) {
+   detail::map3(from, to, t, out, n, [](auto a, auto b, auto vt) { return kernels::angleLerp(a, b, vt); });
+  }
+ }
+}
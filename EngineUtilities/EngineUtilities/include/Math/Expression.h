@@ -0,0 +1,437 @@
+/**
+ * @file Expression.h
+ * @brief Opt-in expression templates that fuse vector and matrix arithmetic into one pass.
+ *
+ * Wrapping an operand with EU::expr::ref() switches the expression to lazy nodes:
+ * `CVector3 p = ref(a) + (ref(b) - ref(a)) * t;` builds no intermediate CVector3 and evaluates
+ * every component once, when the result is converted or assign()ed. Element-wise nodes fuse
+ * without storage; a matrix product or matrix-vector product evaluates a compound operand once
+ * into a plain float array instead of a full matrix object. Results match the regular
+ * operators bit for bit, as every node uses the same evaluation order.
+ *
+ * Nodes hold references to their leaf operands, so evaluate an expression in the statement
+ * that builds it instead of storing it in an `auto` variable.
+ */
+
+#pragma once
+
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector4.h>
+#include <Matrices/Matrix2x2.h>
+#include <Matrices/Matrix3x3.h>
+#include <Matrices/Matrix4x4.h>
+
+namespace EU {
+ /**
+  * @namespace expr
+  * @brief Lazy vector/matrix expression nodes and the ref(), evaluate() and assign() entry points.
+  */
+ namespace expr {
+  namespace detail {
+   /** Component count and indexed access for the vector types. */
+   template<typename Vec> struct VectorTraits;
+
+   template<> struct VectorTraits<CVector2> {
+    static constexpr int N = 2;
+    static constexpr float get(const CVector2& v, int i) { return i == 0 ? v.x : v.y; }
+    static constexpr void set(CVector2& v, int i, float value) { (i == 0 ? v.x : v.y) = value; }
+   };
+
+   template<> struct VectorTraits<CVector3> {
+    static constexpr int N = 3;
+    static constexpr float get(const CVector3& v, int i) { return i == 0 ? v.x : i == 1 ? v.y : v.z; }
+    static constexpr void set(CVector3& v, int i, float value) { (i == 0 ? v.x : i == 1 ? v.y : v.z) = value; }
+   };
+
+   template<> struct VectorTraits<CVector4> {
+    static constexpr int N = 4;
+    static constexpr float get(const CVector4& v, int i) { return i == 0 ? v.x : i == 1 ? v.y : i == 2 ? v.z : v.w; }
+    static constexpr void set(CVector4& v, int i, float value) { (i == 0 ? v.x : i == 1 ? v.y : i == 2 ? v.z : v.w) = value; }
+   };
+
+   /** Size and matching column vector type for the square matrix types. */
+   template<typename Mat> struct MatrixTraits;
+   template<> struct MatrixTraits<Matrix2x2> { static constexpr int N = 2; using Vector = CVector2; };
+   template<> struct MatrixTraits<Matrix3x3> { static constexpr int N = 3; using Vector = CVector3; };
+   template<> struct MatrixTraits<Matrix4x4> { static constexpr int N = 4; using Vector = CVector4; };
+
+   struct Add { static constexpr float apply(float a, float b) { return a + b; } };
+   struct Sub { static constexpr float apply(float a, float b) { return a - b; } };
+  }
+
+  /**
+   * @brief CRTP base of every vector expression producing a Vec.
+   */
+  template<typename E, typename Vec>
+  struct VectorExpr {
+   using Vector = Vec;
+   static constexpr int N = detail::VectorTraits<Vec>::N;
+
+   constexpr const E& self() const { return static_cast<const E&>(*this); }
+
+   /** @brief Evaluates the expression, one pass over the components. */
+   constexpr Vec
+    evaluate() const {
+    Vec out;
+    for (int i = 0; i < N; ++i) detail::VectorTraits<Vec>::set(out, i, self()[i]);
+    return out;
+   }
+
+   constexpr operator Vec() const { return evaluate(); }
+  };
+
+  /** @brief Leaf node referring to an existing vector. */
+  template<typename Vec>
+  struct VectorRef : VectorExpr<VectorRef<Vec>, Vec> {
+   static constexpr bool IS_LEAF = true;
+   const Vec& v;
+   constexpr explicit VectorRef(const Vec& v) : v(v) {}
+   constexpr float operator[](int i) const { return detail::VectorTraits<Vec>::get(v, i); }
+  };
+
+  /** @brief Component-wise a op b. */
+  template<typename L, typename R, typename Op, typename Vec>
+  struct VectorBinary : VectorExpr<VectorBinary<L, R, Op, Vec>, Vec> {
+   static constexpr bool IS_LEAF = false;
+   L l;
+   R r;
+   constexpr VectorBinary(const L& l, const R& r) : l(l), r(r) {}
+   constexpr float operator[](int i) const { return Op::apply(l[i], r[i]); }
+  };
+
+  /** @brief Every component times a scalar. */
+  template<typename E, typename Vec>
+  struct VectorScale : VectorExpr<VectorScale<E, Vec>, Vec> {
+   static constexpr bool IS_LEAF = false;
+   E e;
+   float s;
+   constexpr VectorScale(const E& e, float s) : e(e), s(s) {}
+   constexpr float operator[](int i) const { return e[i] * s; }
+  };
+
+  /** @brief Every component divided by a scalar. */
+  template<typename E, typename Vec>
+  struct VectorDivide : VectorExpr<VectorDivide<E, Vec>, Vec> {
+   static constexpr bool IS_LEAF = false;
+   E e;
+   float s;
+   constexpr VectorDivide(const E& e, float s) : e(e), s(s) {}
+   constexpr float operator[](int i) const { return e[i] / s; }
+  };
+
+  /** @brief Component-wise negation. */
+  template<typename E, typename Vec>
+  struct VectorNegate : VectorExpr<VectorNegate<E, Vec>, Vec> {
+   static constexpr bool IS_LEAF = false;
+   E e;
+   constexpr explicit VectorNegate(const E& e) : e(e) {}
+   constexpr float operator[](int i) const { return -e[i]; }
+  };
+
+  /**
+   * @brief CRTP base of every square matrix expression producing a Mat.
+   */
+  template<typename E, typename Mat>
+  struct MatrixExpr {
+   using Matrix = Mat;
+   static constexpr int N = detail::MatrixTraits<Mat>::N;
+
+   constexpr const E& self() const { return static_cast<const E&>(*this); }
+
+   /** @brief Evaluates the expression element by element. */
+   constexpr Mat
+    evaluate() const {
+    Mat out = Mat::zero();
+    for (int r = 0; r < N; ++r)
+     for (int c = 0; c < N; ++c)
+      out.m[r][c] = self()(r, c);
+    return out;
+   }
+
+   constexpr operator Mat() const { return evaluate(); }
+  };
+
+  /** @brief Leaf node referring to an existing matrix. */
+  template<typename Mat>
+  struct MatrixRef : MatrixExpr<MatrixRef<Mat>, Mat> {
+   static constexpr bool IS_LEAF = true;
+   const Mat& a;
+   constexpr explicit MatrixRef(const Mat& a) : a(a) {}
+   constexpr float operator()(int r, int c) const { return a.m[r][c]; }
+  };
+
+  /** @brief Element-wise a op b. */
+  template<typename L, typename R, typename Op, typename Mat>
+  struct MatrixBinary : MatrixExpr<MatrixBinary<L, R, Op, Mat>, Mat> {
+   static constexpr bool IS_LEAF = false;
+   L l;
+   R r;
+   constexpr MatrixBinary(const L& l, const R& r) : l(l), r(r) {}
+   constexpr float operator()(int row, int col) const { return Op::apply(l(row, col), r(row, col)); }
+  };
+
+  /** @brief Every element times a scalar. */
+  template<typename E, typename Mat>
+  struct MatrixScale : MatrixExpr<MatrixScale<E, Mat>, Mat> {
+   static constexpr bool IS_LEAF = false;
+   E e;
+   float s;
+   constexpr MatrixScale(const E& e, float s) : e(e), s(s) {}
+   constexpr float operator()(int r, int c) const { return e(r, c) * s; }
+  };
+
+  namespace detail {
+   /** Operand of a product: leaves are read in place, compound expressions evaluated once. */
+   template<typename E, int N, bool Leaf = E::IS_LEAF>
+   struct MatrixOperand {
+    E e;
+    constexpr explicit MatrixOperand(const E& e) : e(e) {}
+    constexpr float operator()(int r, int c) const { return e(r, c); }
+   };
+
+   template<typename E, int N>
+   struct MatrixOperand<E, N, false> {
+    float v[N][N];
+    constexpr explicit MatrixOperand(const E& e) : v() {
+     for (int r = 0; r < N; ++r)
+      for (int c = 0; c < N; ++c)
+       v[r][c] = e(r, c);
+    }
+    constexpr float operator()(int r, int c) const { return v[r][c]; }
+   };
+
+   /** Vector operand of a matrix-vector product, always read up front so out may alias it. */
+   template<typename E, int N>
+   struct VectorOperand {
+    float v[N];
+    constexpr explicit VectorOperand(const E& e) : v() {
+     for (int i = 0; i < N; ++i) v[i] = e[i];
+    }
+    constexpr float operator[](int i) const { return v[i]; }
+   };
+  }
+
+  /**
+   * @brief Matrix product; each element accumulates k = 0..N-1 left to right like
+   * Matrix4x4::operator*.
+   */
+  template<typename L, typename R, typename Mat>
+  struct MatrixProduct : MatrixExpr<MatrixProduct<L, R, Mat>, Mat> {
+   static constexpr bool IS_LEAF = false;
+   static constexpr int N = detail::MatrixTraits<Mat>::N;
+   detail::MatrixOperand<L, N> l;
+   detail::MatrixOperand<R, N> r;
+   constexpr MatrixProduct(const L& l, const R& r) : l(l), r(r) {}
+   constexpr float
+    operator()(int row, int col) const {
+    float sum = l(row, 0) * r(0, col);
+    for (int k = 1; k < N; ++k) sum += l(row, k) * r(k, col);
+    return sum;
+   }
+  };
+
+  /** @brief Matrix times column vector, each row summed left to right. */
+  template<typename M, typename V, typename Vec>
+  struct MatrixVector : VectorExpr<MatrixVector<M, V, Vec>, Vec> {
+   static constexpr bool IS_LEAF = false;
+   static constexpr int N = detail::VectorTraits<Vec>::N;
+   detail::MatrixOperand<M, N> a;
+   detail::VectorOperand<V, N> v;
+   constexpr MatrixVector(const M& a, const V& v) : a(a), v(v) {}
+   constexpr float
+    operator[](int row) const {
+    float sum = a(row, 0) * v[0];
+    for (int k = 1; k < N; ++k) sum += a(row, k) * v[k];
+    return sum;
+   }
+  };
+
+  /** @brief Starts an expression from a vector. */
+  template<typename Vec>
+  constexpr VectorRef<Vec>
+   ref(const Vec& v) {
+   return VectorRef<Vec>(v);
+  }
+
+  /** @brief Starts an expression from a matrix. */
+  constexpr MatrixRef<Matrix2x2> ref(const Matrix2x2& a) { return MatrixRef<Matrix2x2>(a); }
+  constexpr MatrixRef<Matrix3x3> ref(const Matrix3x3& a) { return MatrixRef<Matrix3x3>(a); }
+  constexpr MatrixRef<Matrix4x4> ref(const Matrix4x4& a) { return MatrixRef<Matrix4x4>(a); }
+
+  // --- Vector operators (at least one operand must already be an expression) ---
+
+  template<typename L, typename R, typename Vec>
+  constexpr VectorBinary<L, R, detail::Add, Vec>
+   operator+(const VectorExpr<L, Vec>& l, const VectorExpr<R, Vec>& r) {
+   return VectorBinary<L, R, detail::Add, Vec>(l.self(), r.self());
+  }
+
+  template<typename L, typename Vec>
+  constexpr VectorBinary<L, VectorRef<Vec>, detail::Add, Vec>
+   operator+(const VectorExpr<L, Vec>& l, const Vec& r) {
+   return VectorBinary<L, VectorRef<Vec>, detail::Add, Vec>(l.self(), VectorRef<Vec>(r));
+  }
+
+  template<typename R, typename Vec>
+  constexpr VectorBinary<VectorRef<Vec>, R, detail::Add, Vec>
+   operator+(const Vec& l, const VectorExpr<R, Vec>& r) {
+   return VectorBinary<VectorRef<Vec>, R, detail::Add, Vec>(VectorRef<Vec>(l), r.self());
+  }
+
+  template<typename L, typename R, typename Vec>
+  constexpr VectorBinary<L, R, detail::Sub, Vec>
+   operator-(const VectorExpr<L, Vec>& l, const VectorExpr<R, Vec>& r) {
+   return VectorBinary<L, R, detail::Sub, Vec>(l.self(), r.self());
+  }
+
+  template<typename L, typename Vec>
+  constexpr VectorBinary<L, VectorRef<Vec>, detail::Sub, Vec>
+   operator-(const VectorExpr<L, Vec>& l, const Vec& r) {
+   return VectorBinary<L, VectorRef<Vec>, detail::Sub, Vec>(l.self(), VectorRef<Vec>(r));
+  }
+
+  template<typename R, typename Vec>
+  constexpr VectorBinary<VectorRef<Vec>, R, detail::Sub, Vec>
+   operator-(const Vec& l, const VectorExpr<R, Vec>& r) {
+   return VectorBinary<VectorRef<Vec>, R, detail::Sub, Vec>(VectorRef<Vec>(l), r.self());
+  }
+
+  template<typename E, typename Vec>
+  constexpr VectorScale<E, Vec>
+   operator*(const VectorExpr<E, Vec>& e, float s) {
+   return VectorScale<E, Vec>(e.self(), s);
+  }
+
+  template<typename E, typename Vec>
+  constexpr VectorScale<E, Vec>
+   operator*(float s, const VectorExpr<E, Vec>& e) {
+   return VectorScale<E, Vec>(e.self(), s);
+  }
+
+  template<typename E, typename Vec>
+  constexpr VectorDivide<E, Vec>
+   operator/(const VectorExpr<E, Vec>& e, float s) {
+   return VectorDivide<E, Vec>(e.self(), s);
+  }
+
+  template<typename E, typename Vec>
+  constexpr VectorNegate<E, Vec>
+   operator-(const VectorExpr<E, Vec>& e) {
+   return VectorNegate<E, Vec>(e.self());
+  }
+
+  // --- Matrix operators ---
+
+  template<typename L, typename R, typename Mat>
+  constexpr MatrixBinary<L, R, detail::Add, Mat>
+   operator+(const MatrixExpr<L, Mat>& l, const MatrixExpr<R, Mat>& r) {
+   return MatrixBinary<L, R, detail::Add, Mat>(l.self(), r.self());
+  }
+
+  template<typename L, typename R, typename Mat>
+  constexpr MatrixBinary<L, R, detail::Sub, Mat>
+   operator-(const MatrixExpr<L, Mat>& l, const MatrixExpr<R, Mat>& r) {
+   return MatrixBinary<L, R, detail::Sub, Mat>(l.self(), r.self());
+  }
+
+  template<typename E, typename Mat>
+  constexpr MatrixScale<E, Mat>
+   operator*(const MatrixExpr<E, Mat>& e, float s) {
+   return MatrixScale<E, Mat>(e.self(), s);
+  }
+
+  template<typename E, typename Mat>
+  constexpr MatrixScale<E, Mat>
+   operator*(float s, const MatrixExpr<E, Mat>& e) {
+   return MatrixScale<E, Mat>(e.self(), s);
+  }
+
+  template<typename L, typename R, typename Mat>
+  constexpr MatrixProduct<L, R, Mat>
+   operator*(const MatrixExpr<L, Mat>& l, const MatrixExpr<R, Mat>& r) {
+   return MatrixProduct<L, R, Mat>(l.self(), r.self());
+  }
+
+  template<typename L, typename Mat>
+  constexpr MatrixProduct<L, MatrixRef<Mat>, Mat>
+   operator*(const MatrixExpr<L, Mat>& l, const Mat& r) {
+   return MatrixProduct<L, MatrixRef<Mat>, Mat>(l.self(), MatrixRef<Mat>(r));
+  }
+
+  template<typename R, typename Mat>
+  constexpr MatrixProduct<MatrixRef<Mat>, R, Mat>
+   operator*(const Mat& l, const MatrixExpr<R, Mat>& r) {
+   return MatrixProduct<MatrixRef<Mat>, R, Mat>(MatrixRef<Mat>(l), r.self());
+  }
+
+  template<typename M, typename V, typename Mat>
+  constexpr MatrixVector<M, V, typename detail::MatrixTraits<Mat>::Vector>
+   operator*(const MatrixExpr<M, Mat>& a, const VectorExpr<V, typename detail::MatrixTraits<Mat>::Vector>& v) {
+   return MatrixVector<M, V, typename detail::MatrixTraits<Mat>::Vector>(a.self(), v.self());
+  }
+
+  template<typename M, typename Mat>
+  constexpr MatrixVector<M, VectorRef<typename detail::MatrixTraits<Mat>::Vector>, typename detail::MatrixTraits<Mat>::Vector>
+   operator*(const MatrixExpr<M, Mat>& a, const typename detail::MatrixTraits<Mat>::Vector& v) {
+   using Vec = typename detail::MatrixTraits<Mat>::Vector;
+   return MatrixVector<M, VectorRef<Vec>, Vec>(a.self(), VectorRef<Vec>(v));
+  }
+
+  // --- Helpers ---
+
+  /** @brief a + (b - a) * t as one fused expression (t not clamped). */
+  template<typename A, typename B, typename Vec>
+  constexpr auto
+   lerp(const VectorExpr<A, Vec>& a, const VectorExpr<B, Vec>& b, float t)
+   -> decltype(a + (b - a) * t) {
+   return a + (b - a) * t;
+  }
+
+  /** @brief Dot product of two expressions, evaluated component by component in one pass. */
+  template<typename A, typename B, typename Vec>
+  constexpr float
+   dot(const VectorExpr<A, Vec>& a, const VectorExpr<B, Vec>& b) {
+   float sum = a.self()[0] * b.self()[0];
+   for (int i = 1; i < VectorExpr<A, Vec>::N; ++i) sum += a.self()[i] * b.self()[i];
+   return sum;
+  }
+
+  /** @brief Evaluates a vector expression. */
+  template<typename E, typename Vec>
+  constexpr Vec
+   evaluate(const VectorExpr<E, Vec>& e) {
+   return e.evaluate();
+  }
+
+  /** @brief Evaluates a matrix expression. */
+  template<typename E, typename Mat>
+  constexpr Mat
+   evaluate(const MatrixExpr<E, Mat>& e) {
+   return e.evaluate();
+  }
+
+  /**
+   * @brief Writes a vector expression into out without a temporary. out may also appear as an
+   * operand: element-wise nodes only read component i to write it, and matrix-vector nodes
+   * read their vector up front.
+   */
+  template<typename E, typename Vec>
+  constexpr void
+   assign(Vec& out, const VectorExpr<E, Vec>& e) {
+   for (int i = 0; i < VectorExpr<E, Vec>::N; ++i) detail::VectorTraits<Vec>::set(out, i, e.self()[i]);
+  }
+
+  /**
+   * @brief Writes a matrix expression into out. Products read their compound operands up
+   * front, but a product whose leaf operand is out itself must go through evaluate() instead.
+   */
+  template<typename E, typename Mat>
+  constexpr void
+   assign(Mat& out, const MatrixExpr<E, Mat>& e) {
+   for (int r = 0; r < MatrixExpr<E, Mat>::N; ++r)
+    for (int c = 0; c < MatrixExpr<E, Mat>::N; ++c)
+     out.m[r][c] = e.self()(r, c);
+  }
+ }
+}
@@ -0,0 +1,255 @@
+/**
+ * @file Fixed.h
+ * @brief Q16.16 fixed-point scalar and its EngineMath functions for deterministic simulation.
+ *
+ * Every operation is plain 32/64-bit integer arithmetic with a fixed evaluation order, so
+ * results are bit-identical on every compiler and CPU. sin/cos read a compile-time table,
+ * sqrt is an integer square root; nothing touches the FPU once values are converted in.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <Math/EngineMath.h>
+#include <Math/TrigLUT.h>
+
+namespace EU {
+ /**
+  * @class Fixed
+  * @brief Signed Q16.16 fixed-point number: range [-32768, 32768), resolution 1/65536.
+  *
+  * Addition and subtraction wrap like int32. Multiplication rounds to nearest, division
+  * truncates toward zero and saturates when dividing by zero.
+  */
+ class
+  Fixed {
+  public:
+  int32_t raw; ///< Two's complement value scaled by 2^16
+
+  /// Number of fractional bits.
+  static constexpr int FRACTION_BITS = 16;
+  /// Raw representation of 1.0.
+  static constexpr int32_t RAW_ONE = 1 << FRACTION_BITS;
+
+  /**
+   * @brief Default constructor. Initializes to zero.
+   */
+  constexpr Fixed() : raw(0) {}
+
+  /**
+   * @brief Converts an integer (wraps outside [-32768, 32767]).
+   */
+  constexpr explicit Fixed(int value)
+   : raw(static_cast<int32_t>(static_cast<uint32_t>(value) << FRACTION_BITS)) {
+  }
+
+  /**
+   * @brief Converts a float, rounding to the nearest step and saturating at the range limits.
+   *
+   * Deterministic for a given float: the scale is a power of two, so only the final rounding
+   * happens. NaN converts to zero.
+   */
+  constexpr explicit Fixed(float value) : raw(fromFloatRaw(value)) {}
+
+  /**
+   * @brief Builds a value from its raw Q16.16 representation.
+   */
+  static constexpr Fixed
+   fromRaw(int32_t raw) {
+   Fixed f;
+   f.raw = raw;
+   return f;
+  }
+
+  /** @brief Converts to float (exact up to |value| = 256). */
+  constexpr float
+   toFloat() const {
+   return static_cast<float>(raw) * (1.0f / RAW_ONE);
+  }
+
+  /** @brief Integer part rounded toward -inf. */
+  constexpr int
+   toInt() const {
+   return raw >> FRACTION_BITS;
+  }
+
+  constexpr Fixed
+   operator+(Fixed other) const {
+   return fromRaw(static_cast<int32_t>(static_cast<uint32_t>(raw) + static_cast<uint32_t>(other.raw)));
+  }
+
+  constexpr Fixed
+   operator-(Fixed other) const {
+   return fromRaw(static_cast<int32_t>(static_cast<uint32_t>(raw) - static_cast<uint32_t>(other.raw)));
+  }
+
+  constexpr Fixed
+   operator-() const {
+   return fromRaw(static_cast<int32_t>(0u - static_cast<uint32_t>(raw)));
+  }
+
+  /** @brief Product rounded to nearest through a 64-bit intermediate. */
+  constexpr Fixed
+   operator*(Fixed other) const {
+   int64_t p = static_cast<int64_t>(raw) * other.raw + (int64_t(1) << (FRACTION_BITS - 1));
+   return fromRaw(static_cast<int32_t>(p >> FRACTION_BITS));
+  }
+
+  /** @brief Quotient truncated toward zero; dividing by zero saturates toward the dividend's sign. */
+  constexpr Fixed
+   operator/(Fixed other) const {
+   if (other.raw == 0) {
+    return fromRaw(raw >= 0 ? INT32_MAX : INT32_MIN);
+   }
+   int64_t q = (static_cast<int64_t>(raw) * RAW_ONE) / other.raw;
+   return fromRaw(static_cast<int32_t>(q));
+  }
+
+  constexpr Fixed& operator+=(Fixed other) { *this = *this + other; return *this; }
+  constexpr Fixed& operator-=(Fixed other) { *this = *this - other; return *this; }
+  constexpr Fixed& operator*=(Fixed other) { *this = *this * other; return *this; }
+  constexpr Fixed& operator/=(Fixed other) { *this = *this / other; return *this; }
+
+  constexpr bool operator==(Fixed other) const { return raw == other.raw; }
+  constexpr bool operator!=(Fixed other) const { return raw != other.raw; }
+  constexpr bool operator<(Fixed other) const { return raw < other.raw; }
+  constexpr bool operator>(Fixed other) const { return raw > other.raw; }
+  constexpr bool operator<=(Fixed other) const { return raw <= other.raw; }
+  constexpr bool operator>=(Fixed other) const { return raw >= other.raw; }
+
+  /** @brief 0. */
+  static constexpr Fixed zero() { return fromRaw(0); }
+  /** @brief 1. */
+  static constexpr Fixed one() { return fromRaw(RAW_ONE); }
+  /** @brief PI rounded to Q16.16. */
+  static constexpr Fixed pi() { return fromRaw(205887); }
+  /** @brief PI / 2 rounded to Q16.16. */
+  static constexpr Fixed halfPi() { return fromRaw(102944); }
+  /** @brief 2PI rounded to Q16.16. */
+  static constexpr Fixed twoPi() { return fromRaw(411775); }
+
+  private:
+  static constexpr int32_t
+   fromFloatRaw(float value) {
+   float s = value * static_cast<float>(RAW_ONE);
+   if (!(s == s)) return 0;
+   if (s >= 2147483520.0f) return INT32_MAX;
+   if (s <= -2147483648.0f) return INT32_MIN;
+   return static_cast<int32_t>(EngineMath::fround(s));
+  }
+ };
+
+ EU_ASSERT_VALUE_TYPE(Fixed);
+}
+
+namespace EngineMath {
+ namespace detail {
+  /**
+   * @brief Integer square root of a 64-bit value, one result bit per iteration.
+   * @return floor(sqrt(value)).
+   */
+  constexpr uint32_t
+   isqrt64(uint64_t value) {
+   uint64_t result = 0;
+   uint64_t bit = uint64_t(1) << 62;
+   while (bit > value) bit >>= 2;
+   while (bit != 0) {
+    if (value >= result + bit) {
+     value -= result + bit;
+     result = (result >> 1) + bit;
+    }
+    else {
+     result >>= 1;
+    }
+    bit >>= 2;
+   }
+   return static_cast<uint32_t>(result);
+  }
+
+  /** @brief One period of sine in Q16.16, 1024 samples plus a wrap-around guard entry. */
+  struct FixedSinTable {
+   static constexpr unsigned int RESOLUTION = 1024;
+   int32_t values[RESOLUTION + 1];
+
+   constexpr FixedSinTable() : values() {
+    for (unsigned int i = 0; i <= RESOLUTION; ++i) {
+     double s = constexprSin(6.28318530717958647692 * i / RESOLUTION) * 65536.0;
+     values[i] = static_cast<int32_t>(s < 0.0 ? s - 0.5 : s + 0.5);
+    }
+   }
+  };
+
+  /** Holder giving the table a single definition across translation units. */
+  template<typename Tag = void>
+  struct FixedTrig {
+   static constexpr FixedSinTable table = FixedSinTable();
+   /// round(RESOLUTION / 2PI * 2^16): radians to table position in Q16.16.
+   static constexpr int64_t STEPS_PER_RADIAN_RAW = 10680707;
+
+   /** Interpolated table read at a Q16.16 position, offset in whole steps. */
+   static constexpr int32_t
+    sample(int32_t angleRaw, unsigned int offset) {
+    int64_t pos = (static_cast<int64_t>(angleRaw) * STEPS_PER_RADIAN_RAW) >> 16;
+    unsigned int i = (static_cast<unsigned int>(pos >> 16) + offset) & (FixedSinTable::RESOLUTION - 1);
+    int32_t frac = static_cast<int32_t>(pos & 0xffff);
+    int32_t a = table.values[i];
+    int32_t b = table.values[i + 1];
+    return a + static_cast<int32_t>((static_cast<int64_t>(b - a) * frac) >> 16);
+   }
+  };
+
+  template<typename Tag>
+  constexpr FixedSinTable FixedTrig<Tag>::table;
+
+  template<typename Tag>
+  constexpr int64_t FixedTrig<Tag>::STEPS_PER_RADIAN_RAW;
+ }
+
+ /** @brief Absolute value of a fixed-point number. */
+ constexpr EU::Fixed
+  abs(EU::Fixed value) {
+  return value.raw < 0 ? -value : value;
+ }
+
+ /**
+  * @brief Square root of a fixed-point number, exact to the last bit (floor of the true root).
+  * @return sqrt(value), or 0 for negative inputs.
+  */
+ constexpr EU::Fixed
+  sqrt(EU::Fixed value) {
+  if (value.raw <= 0) {
+   return EU::Fixed();
+  }
+  return EU::Fixed::fromRaw(static_cast<int32_t>(detail::isqrt64(static_cast<uint64_t>(value.raw) << 16)));
+ }
+
+ /**
+  * @brief Table sine of a fixed-point angle in radians, linearly interpolated.
+  *
+  * Max error is 2 steps (3e-5) for |angle| <= 2PI. Larger angles also pick up a phase error
+  * of about 5e-8 * |angle| from the rounded radians-to-table scale, so wrap accumulated angles.
+  */
+ constexpr EU::Fixed
+  sin(EU::Fixed angle) {
+  return EU::Fixed::fromRaw(detail::FixedTrig<>::sample(angle.raw, 0));
+ }
+
+ /** @brief Table cosine of a fixed-point angle in radians (same table, a quarter period ahead). */
+ constexpr EU::Fixed
+  cos(EU::Fixed angle) {
+  return EU::Fixed::fromRaw(detail::FixedTrig<>::sample(angle.raw, detail::FixedSinTable::RESOLUTION / 4));
+ }
+
+ /** @brief Fixed-point sine and cosine of the same angle. */
+ constexpr void
+  sincos(EU::Fixed angle, EU::Fixed* s, EU::Fixed* c) {
+  *s = sin(angle);
+  *c = cos(angle);
+ }
+
+ /** @brief Fixed-point linear interpolation, start + (end - start) * t. */
+ constexpr EU::Fixed
+  lerp(EU::Fixed start, EU::Fixed end, EU::Fixed t) {
+  return start + (end - start) * t;
+ }
+}
@@ -0,0 +1,175 @@
+/**
+ * @file Half.h
+ * @brief float <-> IEEE half (binary16) and bfloat16 conversion, scalar and bulk.
+ *
+ * 16-bit values are passed around as their raw uint16_t bit patterns. Float to 16-bit rounds
+ * to nearest even, overflows to infinity and keeps NaNs quiet; denormal halves are supported.
+ * Bulk routines use F16C on x86 and the native AArch64 conversions, with a bit-exact software
+ * fallback, so every path produces the same bits.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+
+namespace EngineMath {
+ /**
+  * @brief Rounds a float to the nearest IEEE half, returned as its bit pattern.
+  */
+ EU_CONSTEXPR20 uint16_t
+  toHalf(float value) {
+  uint32_t f = detail::floatBits(value);
+  uint32_t sign = (f >> 16) & 0x8000u;
+  f &= 0x7fffffffu;
+  if (f >= 0x47800000u) {
+   // 65536 and up overflow; NaNs keep their top payload bits and become quiet.
+   return static_cast<uint16_t>(sign | (f > 0x7f800000u ? 0x7e00u | ((f >> 13) & 0x3ffu) : 0x7c00u));
+  }
+  if (f < 0x38800000u) {
+   // Below 2^-14 the result is denormal: adding 0.5 aligns the mantissa so the FPU rounds it.
+   float aligned = detail::bitsFloat(f) + 0.5f;
+   return static_cast<uint16_t>(sign | (detail::floatBits(aligned) - 0x3f000000u));
+  }
+  // Rebias the exponent from 127 to 15 and round the 13 dropped bits to nearest even.
+  f += 0xc8000fffu + ((f >> 13) & 1u);
+  return static_cast<uint16_t>(sign | (f >> 13));
+ }
+
+ /**
+  * @brief Expands an IEEE half bit pattern to float (exact).
+  */
+ EU_CONSTEXPR20 float
+  fromHalf(uint16_t half) {
+  const uint32_t EXPONENT = 0x7c00u << 13;
+  uint32_t o = (static_cast<uint32_t>(half) & 0x7fffu) << 13;
+  uint32_t exponent = o & EXPONENT;
+  o += (127u - 15u) << 23;
+  if (exponent == EXPONENT) {
+   o += (128u - 16u) << 23;
+   // Quiet signaling NaNs, as the hardware conversions do.
+   o |= (o & 0x007fffffu) ? 0x00400000u : 0u;
+  }
+  else if (exponent == 0) {
+   o += 1u << 23;
+   o = detail::floatBits(detail::bitsFloat(o) - detail::bitsFloat(113u << 23));
+  }
+  return detail::bitsFloat(o | ((static_cast<uint32_t>(half) & 0x8000u) << 16));
+ }
+
+ /**
+  * @brief Rounds a float to the nearest bfloat16 (the top 16 bits of a float).
+  */
+ EU_CONSTEXPR20 uint16_t
+  toBFloat16(float value) {
+  uint32_t f = detail::floatBits(value);
+  if ((f & 0x7fffffffu) > 0x7f800000u) {
+   return static_cast<uint16_t>((f >> 16) | 0x40u);
+  }
+  f += 0x7fffu + ((f >> 16) & 1u);
+  return static_cast<uint16_t>(f >> 16);
+ }
+
+ /**
+  * @brief Expands a bfloat16 bit pattern to float (exact).
+  */
+ EU_CONSTEXPR20 float
+  fromBFloat16(uint16_t value) {
+  return detail::bitsFloat(static_cast<uint32_t>(value) << 16);
+ }
+
+ namespace batch {
+  /** @brief out[i] = toHalf(in[i]). */
+  inline void
+   toHalf(const float* in, uint16_t* out, size_t n) {
+   size_t i = 0;
+#if defined(EU_SIMD_F16C)
+   for (; i + 4 <= n; i += 4) {
+    __m128i h = _mm_cvtps_ph(_mm_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), h);
+   }
+#elif defined(EU_SIMD_NEON_FP16)
+   for (; i + 4 <= n; i += 4) {
+    vst1_u16(out + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(in + i))));
+   }
+#endif
+   for (; i < n; ++i) out[i] = EngineMath::toHalf(in[i]);
+  }
+
+  /** @brief out[i] = fromHalf(in[i]). */
+  inline void
+   fromHalf(const uint16_t* in, float* out, size_t n) {
+   size_t i = 0;
+#if defined(EU_SIMD_F16C)
+   for (; i + 4 <= n; i += 4) {
+    __m128i h = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+    _mm_storeu_ps(out + i, _mm_cvtph_ps(h));
+   }
+#elif defined(EU_SIMD_NEON_FP16)
+   for (; i + 4 <= n; i += 4) {
+    vst1q_f32(out + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(in + i))));
+   }
+#endif
+   for (; i < n; ++i) out[i] = EngineMath::fromHalf(in[i]);
+  }
+
+  /** @brief out[i] = toBFloat16(in[i]). */
+  inline void
+   toBFloat16(const float* in, uint16_t* out, size_t n) {
+   size_t i = 0;
+#if defined(EU_SIMD_SSE2)
+   const __m128i one = _mm_set1_epi32(1);
+   const __m128i bias = _mm_set1_epi32(0x7fff);
+   const __m128i absMask = _mm_set1_epi32(0x7fffffff);
+   const __m128i infinity = _mm_set1_epi32(0x7f800000);
+   const __m128i quiet = _mm_set1_epi32(0x00400000);
+   for (; i + 8 <= n; i += 8) {
+    __m128i half[2];
+    for (int k = 0; k < 2; ++k) {
+     __m128i f = _mm_castps_si128(_mm_loadu_ps(in + i + 4 * k));
+     __m128i nan = _mm_cmpgt_epi32(_mm_and_si128(f, absMask), infinity);
+     __m128i rounded = _mm_add_epi32(f, _mm_add_epi32(bias, _mm_and_si128(_mm_srli_epi32(f, 16), one)));
+     __m128i r = _mm_or_si128(_mm_and_si128(nan, _mm_or_si128(f, quiet)), _mm_andnot_si128(nan, rounded));
+     // Arithmetic shift keeps the top half sign-extended so the signed pack is lossless.
+     half[k] = _mm_srai_epi32(r, 16);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(half[0], half[1]));
+   }
+#elif defined(EU_SIMD_NEON)
+   const uint32x4_t one = vdupq_n_u32(1);
+   const uint32x4_t bias = vdupq_n_u32(0x7fff);
+   const uint32x4_t infinity = vdupq_n_u32(0x7f800000);
+   const uint32x4_t quiet = vdupq_n_u32(0x00400000);
+   for (; i + 4 <= n; i += 4) {
+    uint32x4_t f = vreinterpretq_u32_f32(vld1q_f32(in + i));
+    uint32x4_t nan = vcgtq_u32(vandq_u32(f, vdupq_n_u32(0x7fffffff)), infinity);
+    uint32x4_t rounded = vaddq_u32(f, vaddq_u32(bias, vandq_u32(vshrq_n_u32(f, 16), one)));
+    uint32x4_t r = vbslq_u32(nan, vorrq_u32(f, quiet), rounded);
+    vst1_u16(out + i, vshrn_n_u32(r, 16));
+   }
+#endif
+   for (; i < n; ++i) out[i] = EngineMath::toBFloat16(in[i]);
+  }
+
+  /** @brief out[i] = fromBFloat16(in[i]). */
+  inline void
+   fromBFloat16(const uint16_t* in, float* out, size_t n) {
+   size_t i = 0;
+#if defined(EU_SIMD_SSE2)
+   const __m128i zero = _mm_setzero_si128();
+   for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    _mm_storeu_ps(out + i, _mm_castsi128_ps(_mm_unpacklo_epi16(zero, h)));
+    _mm_storeu_ps(out + i + 4, _mm_castsi128_ps(_mm_unpackhi_epi16(zero, h)));
+   }
+#elif defined(EU_SIMD_NEON)
+   for (; i + 4 <= n; i += 4) {
+    vst1q_f32(out + i, vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(in + i), 16)));
+   }
+#endif
+   for (; i < n; ++i) out[i] = EngineMath::fromBFloat16(in[i]);
+  }
+ }
+}
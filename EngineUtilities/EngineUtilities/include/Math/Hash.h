@@ -0,0 +1,284 @@
+/**
+ * @file Hash.h
+ * @brief 64-bit hashes of integers, floats, vectors, quaternions and quantized positions,
+ * for FlatHashMap and the standard unordered containers.
+ *
+ * Everything reduces to hashWords(): up to four 64-bit words are XORed with fixed secrets and
+ * folded through full 64 x 64 -> 128-bit multiplies (the high and low halves XORed), the mix
+ * used by wyhash. One multiply folds two words, so a CVector3 costs two multiplies and every
+ * input bit reaches every output bit. Single integers take one multiply.
+ *
+ * Floats are hashed by their bits after adding +0, which maps -0 to +0, so keys that compare
+ * equal hash equally. NaN keys never compare equal and cannot be looked up in any case.
+ *
+ * The vector and quaternion overloads cover CVector2/3/4, CVector4A, every BasicVector,
+ * FixedVector2/3, Quaternion and QuaternionA. EU::Hash<T> calls hashValue(), and the std::hash
+ * specializations at the end forward to it, so these types also work as std::unordered_map
+ * keys without a hasher argument.
+ *
+ * Floating-point keys only match bit-for-bit. Positions that should merge when they are
+ * close (vertex welding, spatial hashing) are quantized first; quantizeKey() floors them onto
+ * a grid, and packKey() folds the cell into one uint64_t, the cheapest key FlatHashMap has.
+ *
+ *   FlatHashMap<uint64_t, uint32_t> cells;
+ *   const uint64_t key = packKey(quantizeKey(position, 1.f / cellSize));
+ *   cells[key] = index;
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <Math/EngineMath.h>
+#include <Rotations/Quaternion.h>
+#include <Rotations/QuaternionA.h>
+#include <Vectors/FixedVector.h>
+#include <Vectors/Vector.h>
+#include <Vectors/Vector4A.h>
+
+#if defined(_MSC_VER) && defined(_M_X64) && !defined(__clang__)
+ #include <intrin.h>
+#endif
+
+namespace EU {
+ /// Bits per axis packKey() keeps of a 3D cell; cells are cut to +-2^20.
+ constexpr int HASH_KEY_BITS3 = 21;
+
+ namespace detail {
+  constexpr uint64_t HASH_SECRET0 = 0xa0761d6478bd642full;
+  constexpr uint64_t HASH_SECRET1 = 0xe7037ed1a0b428dbull;
+  constexpr uint64_t HASH_SECRET2 = 0x8ebc6af09c88c6e3ull;
+  constexpr uint64_t HASH_SECRET3 = 0x589965cc75374cc3ull;
+
+  /** 128-bit product of a and b, high half XOR low half. */
+  inline uint64_t
+   hashMix(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+   // __extension__ keeps -pedantic quiet about the GCC / Clang 128-bit type.
+   __extension__ typedef unsigned __int128 Uint128;
+   const Uint128 product = static_cast<Uint128>(a) * b;
+   return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64) && !defined(__clang__)
+   uint64_t high;
+   const uint64_t low = _umul128(a, b, &high);
+   return low ^ high;
+#else
+   const uint64_t aLow = a & 0xffffffffull, aHigh = a >> 32, bLow = b & 0xffffffffull, bHigh = b >> 32;
+   const uint64_t ll = aLow * bLow, lh = aLow * bHigh, hl = aHigh * bLow, hh = aHigh * bHigh;
+   const uint64_t middle = (ll >> 32) + (lh & 0xffffffffull) + (hl & 0xffffffffull);
+   const uint64_t low = (middle << 32) | (ll & 0xffffffffull);
+   const uint64_t high = hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+   return low ^ high;
+#endif
+  }
+
+  /** Bits of v with -0 folded onto +0. */
+  inline uint64_t
+   hashBits(float v) {
+   return EngineMath::detail::floatBits(v + 0.f);
+  }
+
+  inline uint64_t
+   hashBits(double v) {
+   v += 0.;
+   uint64_t bits;
+   std::memcpy(&bits, &v, sizeof(bits));
+   return bits;
+  }
+
+  /** Integers and Fixed pass through as their (zero-extended) two's complement bits. */
+  template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+  constexpr uint64_t
+   hashBits(T v) {
+   return static_cast<uint64_t>(static_cast<typename std::make_unsigned<T>::type>(v));
+  }
+
+  constexpr uint64_t
+   hashBits(Fixed v) {
+   return static_cast<uint32_t>(v.raw);
+  }
+
+  /** Two components of at most 32 bits in one word, wider ones mixed into each other. */
+  template<typename T>
+  inline uint64_t
+   hashPair(T a, T b) {
+   return sizeof(T) <= 4 ? hashBits(a) | hashBits(b) << 32 : hashBits(a) ^ hashMix(hashBits(b) ^ HASH_SECRET3, HASH_SECRET2);
+  }
+ }
+
+ /** @brief Hash of one 64-bit word (one multiply). */
+ inline uint64_t
+  hashWords(uint64_t a) {
+  return detail::hashMix(a ^ detail::HASH_SECRET0, detail::HASH_SECRET1);
+ }
+
+ /** @brief Hash of two words (two multiplies). */
+ inline uint64_t
+  hashWords(uint64_t a, uint64_t b) {
+  return detail::hashMix(detail::hashMix(a ^ detail::HASH_SECRET0, b ^ detail::HASH_SECRET1), detail::HASH_SECRET2);
+ }
+
+ /** @brief Hash of four words (three multiplies). */
+ inline uint64_t
+  hashWords(uint64_t a, uint64_t b, uint64_t c, uint64_t d) {
+  const uint64_t low = detail::hashMix(a ^ detail::HASH_SECRET0, b ^ detail::HASH_SECRET1);
+  const uint64_t high = detail::hashMix(c ^ detail::HASH_SECRET2, d ^ detail::HASH_SECRET3);
+  return detail::hashMix(low ^ high, detail::HASH_SECRET1 ^ high);
+ }
+
+ /** @brief Mixes hash into seed, for keys built from several hashed fields. */
+ inline uint64_t
+  hashCombine(uint64_t seed, uint64_t hash) {
+  return detail::hashMix(seed ^ detail::HASH_SECRET0, hash ^ detail::HASH_SECRET2);
+ }
+
+ /** @brief Hash of size bytes at data, 16 at a time; meant for padding-free POD keys. */
+ inline uint64_t
+  hashBytes(const void* data, size_t size) {
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  uint64_t h = hashWords(size);
+  for (; size >= 16; size -= 16, p += 16) {
+   uint64_t a, b;
+   std::memcpy(&a, p, 8);
+   std::memcpy(&b, p + 8, 8);
+   h = detail::hashMix(a ^ h ^ detail::HASH_SECRET0, b ^ detail::HASH_SECRET1);
+  }
+  uint64_t tail[2] = {0, 0};
+  std::memcpy(tail, p, size);
+  return hashWords(tail[0] ^ h, tail[1]);
+ }
+
+ /// @name Scalars
+ /// @{
+ template<typename T, typename = typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type>
+ inline uint64_t
+  hashValue(T v) {
+  using Int = typename std::conditional<std::is_enum<T>::value, std::underlying_type<T>, std::enable_if<true, T>>::type::type;
+  return hashWords(detail::hashBits(static_cast<Int>(v)));
+ }
+
+ inline uint64_t hashValue(float v) { return hashWords(detail::hashBits(v)); }
+ inline uint64_t hashValue(double v) { return hashWords(detail::hashBits(v)); }
+ /// @}
+
+ /// @name Vectors and quaternions
+ /// @{
+ inline uint64_t
+  hashValue(const CVector2& v) {
+  return hashWords(detail::hashPair(v.x, v.y));
+ }
+
+ inline uint64_t
+  hashValue(const CVector3& v) {
+  return hashWords(detail::hashPair(v.x, v.y), detail::hashBits(v.z));
+ }
+
+ inline uint64_t
+  hashValue(const CVector4& v) {
+  return hashWords(detail::hashPair(v.x, v.y), detail::hashPair(v.z, v.w));
+ }
+
+ inline uint64_t
+  hashValue(const CVector4A& v) {
+  return hashWords(detail::hashPair(v.x, v.y), detail::hashPair(v.z, v.w));
+ }
+
+ template<typename T>
+ inline uint64_t
+  hashValue(const BasicVector<T, 2>& v) {
+  return hashWords(detail::hashPair(v.x, v.y));
+ }
+
+ template<typename T>
+ inline uint64_t
+  hashValue(const BasicVector<T, 3>& v) {
+  return hashWords(detail::hashPair(v.x, v.y), detail::hashBits(v.z));
+ }
+
+ template<typename T>
+ inline uint64_t
+  hashValue(const BasicVector<T, 4>& v) {
+  return hashWords(detail::hashPair(v.x, v.y), detail::hashPair(v.z, v.w));
+ }
+
+ inline uint64_t
+  hashValue(const FixedVector2& v) {
+  return hashWords(detail::hashPair(v.x, v.y));
+ }
+
+ inline uint64_t
+  hashValue(const FixedVector3& v) {
+  return hashWords(detail::hashPair(v.x, v.y), detail::hashBits(v.z));
+ }
+
+ /** q and -q are the same rotation but hash apart, as they compare apart with operator==. */
+ inline uint64_t
+  hashValue(const Quaternion& q) {
+  return hashWords(detail::hashPair(q.x, q.y), detail::hashPair(q.z, q.w));
+ }
+
+ inline uint64_t
+  hashValue(const QuaternionA& q) {
+  return hashWords(detail::hashPair(q.x, q.y), detail::hashPair(q.z, q.w));
+ }
+ /// @}
+
+ /// @name Quantized keys
+ /// @{
+ /** @brief Grid cell of p with cells 1 / scale wide: floor(p * scale) per axis. */
+ inline Vector2i
+  quantizeKey(const CVector2& p, float scale) {
+  return Vector2i(EngineMath::floor(p.x * scale), EngineMath::floor(p.y * scale));
+ }
+
+ inline Vector3i
+  quantizeKey(const CVector3& p, float scale) {
+  return Vector3i(EngineMath::floor(p.x * scale), EngineMath::floor(p.y * scale), EngineMath::floor(p.z * scale));
+ }
+
+ /** @brief Both cell coordinates in one word; distinct cells give distinct keys. */
+ constexpr uint64_t
+  packKey(const Vector2i& cell) {
+  return static_cast<uint64_t>(static_cast<uint32_t>(cell.x)) | static_cast<uint64_t>(static_cast<uint32_t>(cell.y)) << 32;
+ }
+
+ /**
+  * @brief The low HASH_KEY_BITS3 bits of each coordinate in one word; distinct as long as
+  * the cells stay within +-2^20 of each other on every axis.
+  */
+ constexpr uint64_t
+  packKey(const Vector3i& cell) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(cell.x)) & ((1ull << HASH_KEY_BITS3) - 1))
+       | (static_cast<uint64_t>(static_cast<uint32_t>(cell.y)) & ((1ull << HASH_KEY_BITS3) - 1)) << HASH_KEY_BITS3
+       | (static_cast<uint64_t>(static_cast<uint32_t>(cell.z)) & ((1ull << HASH_KEY_BITS3) - 1)) << (2 * HASH_KEY_BITS3);
+ }
+ /// @}
+
+ /**
+  * @struct Hash
+  * @brief Hasher calling hashValue(); the default of FlatHashMap. Overload hashValue() next
+  * to a key type of your own to make it usable.
+  */
+ template<typename T>
+ struct Hash {
+  size_t
+   operator()(const T& value) const {
+   return static_cast<size_t>(hashValue(value));
+  }
+ };
+}
+
+namespace std {
+ template<> struct hash<CVector2> : EU::Hash<CVector2> {};
+ template<> struct hash<CVector3> : EU::Hash<CVector3> {};
+ template<> struct hash<CVector4> : EU::Hash<CVector4> {};
+ template<> struct hash<CVector4A> : EU::Hash<CVector4A> {};
+ template<typename T, int N> struct hash<EU::BasicVector<T, N>> : EU::Hash<EU::BasicVector<T, N>> {};
+ template<> struct hash<EU::FixedVector2> : EU::Hash<EU::FixedVector2> {};
+ template<> struct hash<EU::FixedVector3> : EU::Hash<EU::FixedVector3> {};
+ template<> struct hash<EU::Quaternion> : EU::Hash<EU::Quaternion> {};
+ template<> struct hash<EU::QuaternionA> : EU::Hash<EU::QuaternionA> {};
+}
@@ -0,0 +1,222 @@
+/**
+ * @file IntMath.h
+ * @brief Constexpr integer math: factorial and binomial tables, integer powers and bit helpers.
+ *
+ * Tables are generated by constexpr constructors, so lookups cost one load and can be used
+ * in constant expressions. Bit helpers use std::countl_zero in C++20 and the compiler's
+ * count-leading-zeros intrinsic otherwise.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <Core/Platform.h>
+
+#if defined(_MSC_VER) && !defined(__cpp_lib_bitops)
+ #include <intrin.h>
+#endif
+
+namespace EngineMath {
+ namespace detail {
+  /** @brief 0! through 20!, every factorial that fits in 64 bits. */
+  struct FactorialTable {
+   static constexpr int SIZE = 21;
+   uint64_t values[SIZE];
+
+   constexpr FactorialTable() : values() {
+    values[0] = 1;
+    for (int i = 1; i < SIZE; ++i) {
+     values[i] = values[i - 1] * static_cast<uint64_t>(i);
+    }
+   }
+  };
+
+  /** @brief Pascal's triangle up to n = 33, enough for Bezier and Bernstein bases of degree 33. */
+  struct BinomialTable {
+   static constexpr int SIZE = 34;
+   uint64_t values[SIZE][SIZE];
+
+   constexpr BinomialTable() : values() {
+    for (int n = 0; n < SIZE; ++n) {
+     values[n][0] = 1;
+     for (int k = 1; k <= n; ++k) {
+      values[n][k] = values[n - 1][k - 1] + (k < n ? values[n - 1][k] : 0);
+     }
+    }
+   }
+  };
+
+  /** Holder giving the tables a single definition across translation units. */
+  template<typename Tag = void>
+  struct IntTables {
+   static constexpr FactorialTable factorials = FactorialTable();
+   static constexpr BinomialTable binomials = BinomialTable();
+  };
+
+  template<typename Tag>
+  constexpr FactorialTable IntTables<Tag>::factorials;
+
+  template<typename Tag>
+  constexpr BinomialTable IntTables<Tag>::binomials;
+
+  /** Leading zero bits of a non-zero 32-bit value. */
+  EU_CONSTEXPR20 int
+   countLeadingZeros(uint32_t value) {
+#if defined(__cpp_lib_bitops)
+   return std::countl_zero(value);
+#elif defined(__GNUC__)
+   return __builtin_clz(value);
+#elif defined(_MSC_VER)
+   unsigned long index = 0;
+   _BitScanReverse(&index, value);
+   return 31 - static_cast<int>(index);
+#else
+   int n = 0;
+   while (!(value & 0x80000000u)) { value <<= 1; ++n; }
+   return n;
+#endif
+  }
+
+  /** Leading zero bits of a non-zero 64-bit value. */
+  EU_CONSTEXPR20 int
+   countLeadingZeros(uint64_t value) {
+#if defined(__cpp_lib_bitops)
+   return std::countl_zero(value);
+#elif defined(__GNUC__)
+   return __builtin_clzll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+   unsigned long index = 0;
+   _BitScanReverse64(&index, value);
+   return 63 - static_cast<int>(index);
+#else
+   uint32_t high = static_cast<uint32_t>(value >> 32);
+   return high ? countLeadingZeros(high) : 32 + countLeadingZeros(static_cast<uint32_t>(value));
+#endif
+  }
+
+  /** Set bits of a 64-bit value. */
+  EU_CONSTEXPR20 int
+   popCount(uint64_t value) {
+#if defined(__cpp_lib_bitops)
+   return std::popcount(value);
+#elif defined(__GNUC__)
+   return __builtin_popcountll(value);
+#else
+   value = value - ((value >> 1) & 0x5555555555555555ull);
+   value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+   value = (value + (value >> 4)) & 0x0f0f0f0f0f0f0f0full;
+   return static_cast<int>((value * 0x0101010101010101ull) >> 56);
+#endif
+  }
+
+  /** Unsigned type of the same width class (32 or 64 bits) used by the bit helpers. */
+  template<typename T>
+  struct BitWord {
+   using Type = typename std::conditional<(sizeof(T) > 4), uint64_t, uint32_t>::type;
+  };
+ }
+
+ /**
+  * @brief Positive integer factorial from a compile-time table.
+  * @param number Value in [0, 20]; negative values return 1 like the empty product.
+  * @return number!, or 0 when number! does not fit in 64 bits (number > 20).
+  */
+ constexpr uint64_t
+  factorial(int number) {
+  if (number < 0) {
+   return 1;
+  }
+  if (number >= detail::FactorialTable::SIZE) {
+   return 0;
+  }
+  return detail::IntTables<>::factorials.values[number];
+ }
+
+ /**
+  * @brief Binomial coefficient C(n, k), the number of k-element subsets of n elements.
+  *
+  * Table lookup for n <= 33; larger n use the multiplicative formula, exact while the
+  * result times n fits in 64 bits.
+  * @return C(n, k), 0 when k < 0 or k > n.
+  */
+ constexpr uint64_t
+  binomial(int n, int k) {
+  if (k < 0 || n < 0 || k > n) {
+   return 0;
+  }
+  if (n < detail::BinomialTable::SIZE) {
+   return detail::IntTables<>::binomials.values[n][k];
+  }
+  if (k > n - k) {
+   k = n - k;
+  }
+  uint64_t result = 1;
+  for (int i = 1; i <= k; ++i) {
+   result = result * static_cast<uint64_t>(n - k + i) / static_cast<uint64_t>(i);
+  }
+  return result;
+ }
+
+ /**
+  * @brief Integer power by repeated squaring (at most 2 * log2(exponent) multiplies).
+  * @param base Integer base.
+  * @param exponent Non-negative exponent; the result wraps on overflow like unsigned math.
+  * @return base^exponent.
+  */
+ constexpr int64_t
+  ipow(int64_t base, unsigned int exponent) {
+  uint64_t result = 1;
+  uint64_t b = static_cast<uint64_t>(base);
+  while (exponent != 0) {
+   if (exponent & 1u) {
+    result *= b;
+   }
+   b *= b;
+   exponent >>= 1;
+  }
+  return static_cast<int64_t>(result);
+ }
+
+ /**
+  * @brief True when value is a power of two (0 is not).
+  */
+ template<typename T>
+ constexpr bool
+  isPow2(T value) {
+  using U = typename detail::BitWord<T>::Type;
+  return value > 0 && (static_cast<U>(value) & (static_cast<U>(value) - 1)) == 0;
+ }
+
+ /**
+  * @brief Integer base-2 logarithm, floor(log2(value)), with one count-leading-zeros.
+  * @return Index of the highest set bit, -1 for value <= 0.
+  */
+ template<typename T>
+ EU_CONSTEXPR20 int
+  ilog2(T value) {
+  using U = typename detail::BitWord<T>::Type;
+  if (value <= 0) {
+   return -1;
+  }
+  return static_cast<int>(sizeof(U) * 8 - 1) - detail::countLeadingZeros(static_cast<U>(value));
+ }
+
+ /**
+  * @brief Smallest power of two greater than or equal to value.
+  * @return The power of two, 1 for value <= 1, 0 when it does not fit in the type's width.
+  */
+ template<typename T>
+ EU_CONSTEXPR20 T
+  nextPow2(T value) {
+  using U = typename detail::BitWord<T>::Type;
+  if (value <= 1) {
+   return 1;
+  }
+  int shift = static_cast<int>(sizeof(U) * 8) - detail::countLeadingZeros(static_cast<U>(value - 1));
+  if (shift >= static_cast<int>(sizeof(T) * 8) - (std::is_signed<T>::value ? 1 : 0)) {
+   return 0;
+  }
+  return static_cast<T>(static_cast<U>(1) << shift);
+ }
+}
@@ -0,0 +1,582 @@
+/**
+ * @file Noise.h
+ * @brief Perlin and simplex gradient noise in 2D/3D, fractal octaves and domain warping.
+ *
+ * Every function is one lane-generic kernel evaluated FloatN::WIDTH samples at a time
+ * (8 with AVX2, 4 with SSE2/NEON). Lattice hashing is pure integer arithmetic instead of a
+ * permutation table, so SIMD lanes need no gathers and results are identical on every ISA.
+ * The single-sample CVector2/CVector3 overloads run the same kernel on one lane.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+
+namespace EngineMath {
+ /**
+  * @namespace noise
+  * @brief Gradient noise for procedural terrain and textures, output roughly in [-1, 1].
+  */
+ namespace noise {
+  /**
+   * @brief Octave layout for the fractal (fBm) variants.
+   */
+  struct FractalSettings {
+   int octaves = 5;          ///< Number of summed noise layers
+   float frequency = 1.0f;   ///< Frequency of the first octave
+   float lacunarity = 2.0f;  ///< Frequency multiplier between octaves
+   float gain = 0.5f;        ///< Amplitude multiplier between octaves
+  };
+
+  namespace kernels {
+   /** Integer hash of a lattice point, low bits pick the gradient. */
+   template<typename V>
+   inline typename V::Int
+    hash(typename V::Int x, typename V::Int y, typename V::Int z, typename V::Int seed) {
+    using I = typename V::Int;
+    I h = (x * I::set1(static_cast<int>(0x8da6b343u))) ^
+          (y * I::set1(static_cast<int>(0xd8163841u))) ^
+          (z * I::set1(static_cast<int>(0xcb1ab31fu))) ^ seed;
+    h = h ^ EU::SIMD::shiftRight<15>(h);
+    h = h * I::set1(0x2c1b3c6d);
+    return h ^ EU::SIMD::shiftRight<12>(h);
+   }
+
+   /** Sign bit taken from one bit of the hash, for XOR-negation. */
+   template<typename V, int Bit>
+   inline V
+    hashSign(typename V::Int h) {
+    using I = typename V::Int;
+    return EU::SIMD::asFloat(EU::SIMD::shiftLeft<31 - Bit>(h & I::set1(1 << Bit)));
+   }
+
+   /** Dot product with one of 8 gradients (+-1, +-2) / (+-2, +-1). */
+   template<typename V>
+   inline V
+    grad2(typename V::Int h, V x, V y) {
+    using I = typename V::Int;
+    V lo = EU::SIMD::asFloat((h & I::set1(4)) == I::set1(0));
+    V u = EU::SIMD::select(lo, x, y);
+    V v = EU::SIMD::select(lo, y, x);
+    return (u ^ hashSign<V, 0>(h)) + V::set1(2.0f) * (v ^ hashSign<V, 1>(h));
+   }
+
+   /** Dot product with one of the 12 cube-edge gradients of improved Perlin noise. */
+   template<typename V>
+   inline V
+    grad3(typename V::Int h, V x, V y, V z) {
+    using I = typename V::Int;
+    I h15 = h & I::set1(15);
+    V u = EU::SIMD::select(EU::SIMD::asFloat(I::set1(8) > h15), x, y);
+    V xz = EU::SIMD::asFloat((h15 == I::set1(12)) | (h15 == I::set1(14)));
+    V v = EU::SIMD::select(EU::SIMD::asFloat(I::set1(4) > h15), y, EU::SIMD::select(xz, x, z));
+    return (u ^ hashSign<V, 0>(h)) + (v ^ hashSign<V, 1>(h));
+   }
+
+   /** Quintic fade curve 6t^5 - 15t^4 + 10t^3. */
+   template<typename V>
+   inline V
+    fade(V t) {
+    return t * t * t * (t * (t * V::set1(6.0f) - V::set1(15.0f)) + V::set1(10.0f));
+   }
+
+   template<typename V>
+   inline V
+    mix(V a, V b, V t) {
+    return a + t * (b - a);
+   }
+
+   template<typename V>
+   inline V
+    perlin2(V x, V y, typename V::Int seed) {
+    using I = typename V::Int;
+    V fx = EU::SIMD::floor(x);
+    V fy = EU::SIMD::floor(y);
+    I ix = EU::SIMD::truncToInt(fx);
+    I iy = EU::SIMD::truncToInt(fy);
+    I one = I::set1(1);
+    I zero = I::set1(0);
+    V x0 = x - fx;
+    V y0 = y - fy;
+    V x1 = x0 - V::set1(1.0f);
+    V y1 = y0 - V::set1(1.0f);
+    V n00 = grad2(hash<V>(ix, iy, zero, seed), x0, y0);
+    V n10 = grad2(hash<V>(ix + one, iy, zero, seed), x1, y0);
+    V n01 = grad2(hash<V>(ix, iy + one, zero, seed), x0, y1);
+    V n11 = grad2(hash<V>(ix + one, iy + one, zero, seed), x1, y1);
+    V u = fade(x0);
+    return V::set1(0.62f) * mix(mix(n00, n10, u), mix(n01, n11, u), fade(y0));
+   }
+
+   template<typename V>
+   inline V
+    perlin3(V x, V y, V z, typename V::Int seed) {
+    using I = typename V::Int;
+    V fx = EU::SIMD::floor(x);
+    V fy = EU::SIMD::floor(y);
+    V fz = EU::SIMD::floor(z);
+    I ix = EU::SIMD::truncToInt(fx);
+    I iy = EU::SIMD::truncToInt(fy);
+    I iz = EU::SIMD::truncToInt(fz);
+    I one = I::set1(1);
+    V x0 = x - fx;
+    V y0 = y - fy;
+    V z0 = z - fz;
+    V x1 = x0 - V::set1(1.0f);
+    V y1 = y0 - V::set1(1.0f);
+    V z1 = z0 - V::set1(1.0f);
+    V u = fade(x0);
+    V v = fade(y0);
+    V n000 = grad3(hash<V>(ix, iy, iz, seed), x0, y0, z0);
+    V n100 = grad3(hash<V>(ix + one, iy, iz, seed), x1, y0, z0);
+    V n010 = grad3(hash<V>(ix, iy + one, iz, seed), x0, y1, z0);
+    V n110 = grad3(hash<V>(ix + one, iy + one, iz, seed), x1, y1, z0);
+    V n001 = grad3(hash<V>(ix, iy, iz + one, seed), x0, y0, z1);
+    V n101 = grad3(hash<V>(ix + one, iy, iz + one, seed), x1, y0, z1);
+    V n011 = grad3(hash<V>(ix, iy + one, iz + one, seed), x0, y1, z1);
+    V n111 = grad3(hash<V>(ix + one, iy + one, iz + one, seed), x1, y1, z1);
+    V layer0 = mix(mix(n000, n100, u), mix(n010, n110, u), v);
+    V layer1 = mix(mix(n001, n101, u), mix(n011, n111, u), v);
+    return mix(layer0, layer1, fade(z0));
+   }
+
+   /** Radial falloff (r - d^2)^4 of one simplex corner, zero outside its radius. */
+   template<typename V>
+   inline V
+    corner(V t, V g) {
+    t = EU::SIMD::max(t, V::zero());
+    t = t * t;
+    return t * t * g;
+   }
+
+   template<typename V>
+   inline V
+    simplex2(V x, V y, typename V::Int seed) {
+    using I = typename V::Int;
+    const float F2 = 0.366025403784438647f;
+    const float G2 = 0.211324865405187118f;
+    V s = (x + y) * V::set1(F2);
+    V fi = EU::SIMD::floor(x + s);
+    V fj = EU::SIMD::floor(y + s);
+    I i = EU::SIMD::truncToInt(fi);
+    I j = EU::SIMD::truncToInt(fj);
+    V t = (fi + fj) * V::set1(G2);
+    V x0 = x - (fi - t);
+    V y0 = y - (fj - t);
+    V upper = x0 > y0;
+    V one = V::set1(1.0f);
+    V i1 = upper & one;
+    V j1 = one - i1;
+    V x1 = x0 - i1 + V::set1(G2);
+    V y1 = y0 - j1 + V::set1(G2);
+    V x2 = x0 - V::set1(1.0f - 2.0f * G2);
+    V y2 = y0 - V::set1(1.0f - 2.0f * G2);
+    I ii1 = EU::SIMD::truncToInt(i1);
+    I jj1 = EU::SIMD::truncToInt(j1);
+    I zero = I::set1(0);
+    I ione = I::set1(1);
+    V half = V::set1(0.5f);
+    V n0 = corner(half - x0 * x0 - y0 * y0, grad2(hash<V>(i, j, zero, seed), x0, y0));
+    V n1 = corner(half - x1 * x1 - y1 * y1, grad2(hash<V>(i + ii1, j + jj1, zero, seed), x1, y1));
+    V n2 = corner(half - x2 * x2 - y2 * y2, grad2(hash<V>(i + ione, j + ione, zero, seed), x2, y2));
+    return V::set1(45.0f) * (n0 + n1 + n2);
+   }
+
+   template<typename V>
+   inline V
+    simplex3(V x, V y, V z, typename V::Int seed) {
+    using I = typename V::Int;
+    const float F3 = 1.0f / 3.0f;
+    const float G3 = 1.0f / 6.0f;
+    V s = (x + y + z) * V::set1(F3);
+    V fi = EU::SIMD::floor(x + s);
+    V fj = EU::SIMD::floor(y + s);
+    V fk = EU::SIMD::floor(z + s);
+    I i = EU::SIMD::truncToInt(fi);
+    I j = EU::SIMD::truncToInt(fj);
+    I k = EU::SIMD::truncToInt(fk);
+    V t = (fi + fj + fk) * V::set1(G3);
+    V x0 = x - (fi - t);
+    V y0 = y - (fj - t);
+    V z0 = z - (fk - t);
+    // Rank the offsets to pick the simplex corners without branches.
+    V xy = x0 >= y0;
+    V xz = x0 >= z0;
+    V yz = y0 >= z0;
+    V one = V::set1(1.0f);
+    V i1 = (xy & xz) & one;
+    V j1 = EU::SIMD::select(xy, V::zero(), yz & one);
+    V k1 = one - i1 - j1;
+    V i2 = (xy | xz) & one;
+    V j2 = EU::SIMD::select(xy, yz & one, one);
+    V k2 = V::set1(2.0f) - i2 - j2;
+    V x1 = x0 - i1 + V::set1(G3);
+    V y1 = y0 - j1 + V::set1(G3);
+    V z1 = z0 - k1 + V::set1(G3);
+    V x2 = x0 - i2 + V::set1(2.0f * G3);
+    V y2 = y0 - j2 + V::set1(2.0f * G3);
+    V z2 = z0 - k2 + V::set1(2.0f * G3);
+    V x3 = x0 - V::set1(1.0f - 3.0f * G3);
+    V y3 = y0 - V::set1(1.0f - 3.0f * G3);
+    V z3 = z0 - V::set1(1.0f - 3.0f * G3);
+    I ione = I::set1(1);
+    V r = V::set1(0.6f);
+    V n0 = corner(r - x0 * x0 - y0 * y0 - z0 * z0, grad3(hash<V>(i, j, k, seed), x0, y0, z0));
+    V n1 = corner(r - x1 * x1 - y1 * y1 - z1 * z1,
+                  grad3(hash<V>(i + EU::SIMD::truncToInt(i1), j + EU::SIMD::truncToInt(j1),
+                                k + EU::SIMD::truncToInt(k1), seed), x1, y1, z1));
+    V n2 = corner(r - x2 * x2 - y2 * y2 - z2 * z2,
+                  grad3(hash<V>(i + EU::SIMD::truncToInt(i2), j + EU::SIMD::truncToInt(j2),
+                                k + EU::SIMD::truncToInt(k2), seed), x2, y2, z2));
+    V n3 = corner(r - x3 * x3 - y3 * y3 - z3 * z3, grad3(hash<V>(i + ione, j + ione, k + ione, seed), x3, y3, z3));
+    return V::set1(32.0f) * (n0 + n1 + n2 + n3);
+   }
+
+   /** Normalized sum of octaves of a 2D noise kernel. */
+   template<typename V, typename Noise>
+   inline V
+    fractal2(V x, V y, typename V::Int seed, const FractalSettings& fs, Noise noise) {
+    using I = typename V::Int;
+    V sum = V::zero();
+    float amplitude = 1.0f;
+    float total = 0.0f;
+    float frequency = fs.frequency;
+    for (int o = 0; o < fs.octaves; ++o) {
+     V f = V::set1(frequency);
+     sum = sum + V::set1(amplitude) * noise(x * f, y * f, seed + I::set1(o * 1013));
+     total += amplitude;
+     amplitude *= fs.gain;
+     frequency *= fs.lacunarity;
+    }
+    return total > 0.0f ? sum * V::set1(1.0f / total) : sum;
+   }
+
+   /** Normalized sum of octaves of a 3D noise kernel. */
+   template<typename V, typename Noise>
+   inline V
+    fractal3(V x, V y, V z, typename V::Int seed, const FractalSettings& fs, Noise noise) {
+    using I = typename V::Int;
+    V sum = V::zero();
+    float amplitude = 1.0f;
+    float total = 0.0f;
+    float frequency = fs.frequency;
+    for (int o = 0; o < fs.octaves; ++o) {
+     V f = V::set1(frequency);
+     sum = sum + V::set1(amplitude) * noise(x * f, y * f, z * f, seed + I::set1(o * 1013));
+     total += amplitude;
+     amplitude *= fs.gain;
+     frequency *= fs.lacunarity;
+    }
+    return total > 0.0f ? sum * V::set1(1.0f / total) : sum;
+   }
+
+   /** Offsets (x, y) by amplitude times two decorrelated fractal simplex fields. */
+   template<typename V>
+   inline void
+    warp2(V& x, V& y, float amplitude, typename V::Int seed, const FractalSettings& fs) {
+    using I = typename V::Int;
+    auto n = [](V a, V b, I s) { return simplex2(a, b, s); };
+    V qx = fractal2(x, y, seed + I::set1(7919), fs, n);
+    V qy = fractal2(x + V::set1(5.2f), y + V::set1(1.3f), seed + I::set1(15887), fs, n);
+    x = x + V::set1(amplitude) * qx;
+    y = y + V::set1(amplitude) * qy;
+   }
+
+   /** 3D variant of warp2(). */
+   template<typename V>
+   inline void
+    warp3(V& x, V& y, V& z, float amplitude, typename V::Int seed, const FractalSettings& fs) {
+    using I = typename V::Int;
+    auto n = [](V a, V b, V c, I s) { return simplex3(a, b, c, s); };
+    V qx = fractal3(x, y, z, seed + I::set1(7919), fs, n);
+    V qy = fractal3(x + V::set1(5.2f), y + V::set1(1.3f), z + V::set1(2.9f), seed + I::set1(15887), fs, n);
+    V qz = fractal3(x + V::set1(9.7f), y + V::set1(4.1f), z + V::set1(6.6f), seed + I::set1(23873), fs, n);
+    x = x + V::set1(amplitude) * qx;
+    y = y + V::set1(amplitude) * qy;
+    z = z + V::set1(amplitude) * qz;
+   }
+  }
+
+  namespace detail {
+   using Lane = EU::SIMD::Float4;
+   using LaneInt = EU::SIMD::Int4;
+
+   inline LaneInt
+    seedLanes(uint32_t seed) {
+    return LaneInt::set1(static_cast<int>(seed));
+   }
+
+   inline EU::SIMD::FloatN::Int
+    seedLanesN(uint32_t seed) {
+    return EU::SIMD::FloatN::Int::set1(static_cast<int>(seed));
+   }
+
+   /** First lane of a single-sample kernel evaluation. */
+   inline float
+    first(Lane v) {
+    float lanes[Lane::WIDTH];
+    v.store(lanes);
+    return lanes[0];
+   }
+
+   /** Splits an AoS array into SoA chunks on the stack and forwards them. */
+   template<typename Fn>
+   inline void
+    forChunks2(const CVector2* points, float* out, size_t n, Fn fn) {
+    const size_t CHUNK = 64;
+    float xs[CHUNK];
+    float ys[CHUNK];
+    for (size_t base = 0; base < n; base += CHUNK) {
+     size_t count = (n - base < CHUNK) ? n - base : CHUNK;
+     for (size_t i = 0; i < count; ++i) {
+      xs[i] = points[base + i].x;
+      ys[i] = points[base + i].y;
+     }
+     fn(xs, ys, out + base, count);
+    }
+   }
+
+   template<typename Fn>
+   inline void
+    forChunks3(const CVector3* points, float* out, size_t n, Fn fn) {
+    const size_t CHUNK = 64;
+    float xs[CHUNK];
+    float ys[CHUNK];
+    float zs[CHUNK];
+    for (size_t base = 0; base < n; base += CHUNK) {
+     size_t count = (n - base < CHUNK) ? n - base : CHUNK;
+     for (size_t i = 0; i < count; ++i) {
+      xs[i] = points[base + i].x;
+      ys[i] = points[base + i].y;
+      zs[i] = points[base + i].z;
+     }
+     fn(xs, ys, zs, out + base, count);
+    }
+   }
+  }
+
+  // --- Single samples ---
+
+  /** @brief 2D Perlin noise at p. */
+  inline float
+   perlin(const CVector2& p, uint32_t seed = 0) {
+   using V = detail::Lane;
+   return detail::first(kernels::perlin2(V::set1(p.x), V::set1(p.y), detail::seedLanes(seed)));
+  }
+
+  /** @brief 3D Perlin noise at p. */
+  inline float
+   perlin(const CVector3& p, uint32_t seed = 0) {
+   using V = detail::Lane;
+   return detail::first(kernels::perlin3(V::set1(p.x), V::set1(p.y), V::set1(p.z), detail::seedLanes(seed)));
+  }
+
+  /** @brief 2D simplex noise at p. */
+  inline float
+   simplex(const CVector2& p, uint32_t seed = 0) {
+   using V = detail::Lane;
+   return detail::first(kernels::simplex2(V::set1(p.x), V::set1(p.y), detail::seedLanes(seed)));
+  }
+
+  /** @brief 3D simplex noise at p. */
+  inline float
+   simplex(const CVector3& p, uint32_t seed = 0) {
+   using V = detail::Lane;
+   return detail::first(kernels::simplex3(V::set1(p.x), V::set1(p.y), V::set1(p.z), detail::seedLanes(seed)));
+  }
+
+  /** @brief Fractal (fBm) 2D simplex noise at p. */
+  inline float
+   fractal(const CVector2& p, const FractalSettings& settings = FractalSettings(), uint32_t seed = 0) {
+   using V = detail::Lane;
+   auto n = [](V a, V b, detail::LaneInt s) { return kernels::simplex2(a, b, s); };
+   return detail::first(kernels::fractal2(V::set1(p.x), V::set1(p.y), detail::seedLanes(seed), settings, n));
+  }
+
+  /** @brief Fractal (fBm) 3D simplex noise at p. */
+  inline float
+   fractal(const CVector3& p, const FractalSettings& settings = FractalSettings(), uint32_t seed = 0) {
+   using V = detail::Lane;
+   auto n = [](V a, V b, V c, detail::LaneInt s) { return kernels::simplex3(a, b, c, s); };
+   return detail::first(kernels::fractal3(V::set1(p.x), V::set1(p.y), V::set1(p.z), detail::seedLanes(seed), settings, n));
+  }
+
+  /** @brief Domain-warped copy of p: p + amplitude * (fractal simplex offsets). */
+  inline CVector2
+   warp(const CVector2& p, float amplitude, const FractalSettings& settings = FractalSettings(), uint32_t seed = 0) {
+   using V = detail::Lane;
+   V x = V::set1(p.x);
+   V y = V::set1(p.y);
+   kernels::warp2(x, y, amplitude, detail::seedLanes(seed), settings);
+   return CVector2(detail::first(x), detail::first(y));
+  }
+
+  /** @brief Domain-warped copy of p in 3D. */
+  inline CVector3
+   warp(const CVector3& p, float amplitude, const FractalSettings& settings = FractalSettings(), uint32_t seed = 0) {
+   using V = detail::Lane;
+   V x = V::set1(p.x);
+   V y = V::set1(p.y);
+   V z = V::set1(p.z);
+   kernels::warp3(x, y, z, amplitude, detail::seedLanes(seed), settings);
+   return CVector3(detail::first(x), detail::first(y), detail::first(z));
+  }
+
+  // --- SoA batches: out[i] = noise(xs[i], ys[i](, zs[i])) ---
+
+  /** @brief Batch 2D Perlin noise over SoA coordinates. */
+  inline void
+   perlin2(const float* xs, const float* ys, float* out, size_t n, uint32_t seed = 0) {
+   auto s = detail::seedLanesN(seed);
+   batch::detail::map2(xs, ys, out, n, [s](auto x, auto y) { return kernels::perlin2(x, y, s); });
+  }
+
+  /** @brief Batch 3D Perlin noise over SoA coordinates. */
+  inline void
+   perlin3(const float* xs, const float* ys, const float* zs, float* out, size_t n, uint32_t seed = 0) {
+   auto s = detail::seedLanesN(seed);
+   batch::detail::map3(xs, ys, zs, out, n, [s](auto x, auto y, auto z) { return kernels::perlin3(x, y, z, s); });
+  }
+
+  /** @brief Batch 2D simplex noise over SoA coordinates. */
+  inline void
+   simplex2(const float* xs, const float* ys, float* out, size_t n, uint32_t seed = 0) {
+   auto s = detail::seedLanesN(seed);
+   batch::detail::map2(xs, ys, out, n, [s](auto x, auto y) { return kernels::simplex2(x, y, s); });
+  }
+
+  /** @brief Batch 3D simplex noise over SoA coordinates. */
+  inline void
+   simplex3(const float* xs, const float* ys, const float* zs, float* out, size_t n, uint32_t seed = 0) {
+   auto s = detail::seedLanesN(seed);
+   batch::detail::map3(xs, ys, zs, out, n, [s](auto x, auto y, auto z) { return kernels::simplex3(x, y, z, s); });
+  }
+
+  /** @brief Batch fractal 2D simplex noise over SoA coordinates. */
+  inline void
+   fractal2(const float* xs, const float* ys, float* out, size_t n,
+            const FractalSettings& settings = FractalSettings(), uint32_t seed = 0) {
+   auto s = detail::seedLanesN(seed);
+   batch::detail::map2(xs, ys, out, n, [s, &settings](auto x, auto y) {
+    using V = decltype(x);
+    return kernels::fractal2(x, y, s, settings, [](V a, V b, typename V::Int sd) { return kernels::simplex2(a, b, sd); });
+   });
+  }
+
+  /** @brief Batch fractal 3D simplex noise over SoA coordinates. */
+  inline void
+   fractal3(const float* xs, const float* ys, const float* zs, float* out, size_t n,
+            const FractalSettings& settings = FractalSettings(), uint32_t seed = 0) {
+   auto s = detail::seedLanesN(seed);
+   batch::detail::map3(xs, ys, zs, out, n, [s, &settings](auto x, auto y, auto z) {
+    using V = decltype(x);
+    return kernels::fractal3(x, y, z, s, settings, [](V a, V b, V c, typename V::Int sd) { return kernels::simplex3(a, b, c, sd); });
+   });
+  }
+
+  /** @brief Domain-warps SoA coordinates in place. */
+  inline void
+   warp2(float* xs, float* ys, size_t n, float amplitude,
+         const FractalSettings& settings = FractalSettings(), uint32_t seed = 0) {
+   using V = EU::SIMD::FloatN;
+   const size_t W = static_cast<size_t>(V::WIDTH);
+   auto s = detail::seedLanesN(seed);
+   for (size_t i = 0; i < n; i += W) {
+    float tx[V::WIDTH] = {};
+    float ty[V::WIDTH] = {};
+    size_t count = (n - i < W) ? n - i : W;
+    for (size_t j = 0; j < count; ++j) {
+     tx[j] = xs[i + j];
+     ty[j] = ys[i + j];
+    }
+    V x = V::load(tx);
+    V y = V::load(ty);
+    kernels::warp2(x, y, amplitude, s, settings);
+    x.store(tx);
+    y.store(ty);
+    for (size_t j = 0; j < count; ++j) {
+     xs[i + j] = tx[j];
+     ys[i + j] = ty[j];
+    }
+   }
+  }
+
+  /** @brief 3D variant of warp2(), in place. */
+  inline void
+   warp3(float* xs, float* ys, float* zs, size_t n, float amplitude,
+         const FractalSettings& settings = FractalSettings(), uint32_t seed = 0) {
+   using V = EU::SIMD::FloatN;
+   const size_t W = static_cast<size_t>(V::WIDTH);
+   auto s = detail::seedLanesN(seed);
+   for (size_t i = 0; i < n; i += W) {
+    float tx[V::WIDTH] = {};
+    float ty[V::WIDTH] = {};
+    float tz[V::WIDTH] = {};
+    size_t count = (n - i < W) ? n - i : W;
+    for (size_t j = 0; j < count; ++j) {
+     tx[j] = xs[i + j];
+     ty[j] = ys[i + j];
+     tz[j] = zs[i + j];
+    }
+    V x = V::load(tx);
+    V y = V::load(ty);
+    V z = V::load(tz);
+    kernels::warp3(x, y, z, amplitude, s, settings);
+    x.store(tx);
+    y.store(ty);
+    z.store(tz);
+    for (size_t j = 0; j < count; ++j) {
+     xs[i + j] = tx[j];
+     ys[i + j] = ty[j];
+     zs[i + j] = tz[j];
+    }
+   }
+  }
+
+  // --- AoS batches over CVector2 / CVector3 arrays ---
+
+  /** @brief Batch 2D simplex noise at every point. */
+  inline void
+   simplex(const CVector2* points, float* out, size_t n, uint32_t seed = 0) {
+   detail::forChunks2(points, out, n, [seed](const float* x, const float* y, float* o, size_t c) { simplex2(x, y, o, c, seed); });
+  }
+
+  /** @brief Batch 3D simplex noise at every point. */
+  inline void
+   simplex(const CVector3* points, float* out, size_t n, uint32_t seed = 0) {
+   detail::forChunks3(points, out, n, [seed](const float* x, const float* y, const float* z, float* o, size_t c) { simplex3(x, y, z, o, c, seed); });
+  }
+
+  /** @brief Batch 2D Perlin noise at every point. */
+  inline void
+   perlin(const CVector2* points, float* out, size_t n, uint32_t seed = 0) {
+   detail::forChunks2(points, out, n, [seed](const float* x, const float* y, float* o, size_t c) { perlin2(x, y, o, c, seed); });
+  }
+
+  /** @brief Batch 3D Perlin noise at every point. */
+  inline void
+   perlin(const CVector3* points, float* out, size_t n, uint32_t seed = 0) {
+   detail::forChunks3(points, out, n, [seed](const float* x, const float* y, const float* z, float* o, size_t c) { perlin3(x, y, z, o, c, seed); });
+  }
+
+  /** @brief Batch fractal 2D simplex noise at every point. */
+  inline void
+   fractal(const CVector2* points, float* out, size_t n,
+           const FractalSettings& settings = FractalSettings(), uint32_t seed = 0) {
+   detail::forChunks2(points, out, n, [seed, &settings](const float* x, const float* y, float* o, size_t c) { fractal2(x, y, o, c, settings, seed); });
+  }
+
+  /** @brief Batch fractal 3D simplex noise at every point. */
+  inline void
+   fractal(const CVector3* points, float* out, size_t n,
+           const FractalSettings& settings = FractalSettings(), uint32_t seed = 0) {
+   detail::forChunks3(points, out, n, [seed, &settings](const float* x, const float* y, const float* z, float* o, size_t c) { fractal3(x, y, z, o, c, settings, seed); });
+  }
+ }
+}
@@ -0,0 +1,229 @@
+/**
+ * @file Precision.h
+ * @brief Precision policies that select the approximation kernels used by the math types.
+ *
+ * A policy is a stateless type passed as a template argument, e.g. `v.normalize<EU::Precision::Fast>()`,
+ * or chosen for the whole build through EU_PRECISION_DEFAULT (0 = Fast, 1 = Balanced, 2 = Exact).
+ * Each policy decides the sqrt tier, rsqrt versus sqrt plus division, and whether multiply-adds fuse.
+ * The *Lanes() members make the same choice for SIMD register types, for the packet vector types.
+ *
+ * invLength() is only accurate for a normal squared length: the rsqrt seeds assume a normal
+ * exponent and a subnormal reciprocal flushes to zero. normalize() therefore checks
+ * normalizable(lenSq) and, for vectors whose squares underflow or overflow, divides by the
+ * largest component first.
+ */
+
+#pragma once
+
+#include <cfloat>
+#include <Core/Platform.h>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+
+namespace EU {
+ /**
+  * @namespace Precision
+  * @brief Fast, Balanced and Exact policies plus the build-wide Default.
+  */
+ namespace Precision {
+  namespace detail {
+   /** a * b + c with a single rounding when the target has FMA (never in EU_REPRODUCIBLE builds). */
+   EU_CONSTEXPR20 float
+    fusedMadd(float a, float b, float c) {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+    if (std::is_constant_evaluated()) {
+     return a * b + c;
+    }
+#endif
+#if defined(EU_REPRODUCIBLE)
+    return a * b + c;
+#elif defined(EU_SIMD_FMA)
+    return _mm_cvtss_f32(_mm_fmadd_ss(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(c)));
+#elif defined(EU_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+    return vget_lane_f32(vfma_f32(vdup_n_f32(c), vdup_n_f32(a), vdup_n_f32(b)), 0);
+#else
+    return a * b + c;
+#endif
+   }
+
+   /** value where x > 0, else 0 (lane-wise). */
+   template<typename V>
+   inline V
+    maskPositive(V x, V value) {
+    return value & (x > V::zero());
+   }
+
+   /** Hardware rsqrt estimate refined by one Newton-Raphson step (lane-wise). */
+   template<typename V>
+   inline V
+    refinedRsqrt(V x) {
+    V y = EU::SIMD::rsqrtEstimate(x);
+    return y * (V::set1(1.5f) - V::set1(0.5f) * x * y * y);
+   }
+  }
+
+  /**
+   * @brief Throughput first: ~10-bit sqrt, ~12-bit rsqrt, fused multiply-adds.
+   */
+  struct Fast {
+   static constexpr const char* NAME = "Fast";
+   static EU_CONSTEXPR20 float sqrt(float x) { return EngineMath::sqrtFast(x); }
+   static EU_CONSTEXPR20 float rsqrt(float x) { return EngineMath::rsqrtFast(x); }
+   /** Factor that normalizes a vector of squared length lenSq (lenSq > 0). */
+   static EU_CONSTEXPR20 float invLength(float lenSq) { return EngineMath::rsqrtFast(lenSq); }
+   static EU_CONSTEXPR20 float madd(float a, float b, float c) { return detail::fusedMadd(a, b, c); }
+   static constexpr float sin(float x) { return EngineMath::sin(x); }
+   static constexpr float cos(float x) { return EngineMath::cos(x); }
+   template<typename V> static V sqrtLanes(V x) { return detail::maskPositive(x, x * EU::SIMD::rsqrtEstimate(x)); }
+   template<typename V> static V invLengthLanes(V lenSq) { return EU::SIMD::rsqrtEstimate(lenSq); }
+   template<typename V> static V maddLanes(V a, V b, V c) { return EU::SIMD::madd(a, b, c); }
+  };
+
+  /**
+   * @brief The library default: full-float sqrt tier from EU_SQRT_DEFAULT_TIER, refined rsqrt, fused multiply-adds.
+   */
+  struct Balanced {
+   static constexpr const char* NAME = "Balanced";
+   static EU_CONSTEXPR20 float sqrt(float x) { return EngineMath::sqrt(x); }
+   static EU_CONSTEXPR20 float rsqrt(float x) { return EngineMath::rsqrt(x); }
+   static EU_CONSTEXPR20 float invLength(float lenSq) { return EngineMath::rsqrt(lenSq); }
+   static EU_CONSTEXPR20 float madd(float a, float b, float c) { return detail::fusedMadd(a, b, c); }
+   static constexpr float sin(float x) { return EngineMath::sin(x); }
+   static constexpr float cos(float x) { return EngineMath::cos(x); }
+   template<typename V> static V sqrtLanes(V x) { return EU::SIMD::sqrt(EU::SIMD::max(x, V::zero())); }
+   template<typename V> static V invLengthLanes(V lenSq) { return detail::refinedRsqrt(lenSq); }
+   template<typename V> static V maddLanes(V a, V b, V c) { return EU::SIMD::madd(a, b, c); }
+  };
+
+  /**
+   * @brief Reference results: correctly rounded hardware sqrt, true division, and
+   * multiplies and adds rounded separately in the order they are written.
+   */
+  struct Exact {
+   static constexpr const char* NAME = "Exact";
+   static EU_CONSTEXPR20 float sqrt(float x) { return EngineMath::sqrtHardware(x); }
+   static EU_CONSTEXPR20 float rsqrt(float x) { return 1.0f / EngineMath::sqrtHardware(x); }
+   static EU_CONSTEXPR20 float invLength(float lenSq) { return 1.0f / EngineMath::sqrtHardware(lenSq); }
+   static constexpr float madd(float a, float b, float c) { return a * b + c; }
+   static constexpr float sin(float x) { return EngineMath::sin(x); }
+   static constexpr float cos(float x) { return EngineMath::cos(x); }
+   template<typename V> static V sqrtLanes(V x) { return EU::SIMD::sqrt(EU::SIMD::max(x, V::zero())); }
+   template<typename V> static V invLengthLanes(V lenSq) { return V::set1(1.0f) / EU::SIMD::sqrt(lenSq); }
+   template<typename V> static V maddLanes(V a, V b, V c) { return a * b + c; }
+  };
+
+  /**
+   * @brief True when invLength(lenSq) is accurate under every policy: lenSq is a normal float.
+   * Zero, subnormal, infinite and NaN squared lengths are not.
+   */
+  constexpr bool
+   normalizable(float lenSq) {
+   return lenSq >= FLT_MIN && lenSq <= FLT_MAX;
+  }
+
+  /** @brief Largest magnitude among the components, the divisor that brings a vector back into range. */
+  constexpr float
+   largestMagnitude(float a, float b, float c = 0.f, float d = 0.f) {
+   const float ma = a < 0.f ? -a : a, mb = b < 0.f ? -b : b, mc = c < 0.f ? -c : c, md = d < 0.f ? -d : d;
+   const float ab = ma > mb ? ma : mb, cd = mc > md ? mc : md;
+   return ab > cd ? ab : cd;
+  }
+
+  /** @brief Lane-wise normalizable(): the mask of lanes whose lenSq invLengthLanes() is accurate for. */
+  template<typename V>
+  inline V
+   normalizableLanes(V lenSq) {
+   return (lenSq >= V::set1(FLT_MIN)) & (lenSq <= V::set1(FLT_MAX));
+  }
+
+  /**
+   * @brief normalize()'s rescaling for packets: in lanes whose lenSq is not normalizable(),
+   * divides x and y by their largest magnitude and recomputes lenSq. Zero lanes stay zero;
+   * when every lane is in range nothing is done beyond the check.
+   */
+  template<typename V>
+  inline void
+   rescaleLanes(V& x, V& y, V& lenSq) {
+   const V ok = normalizableLanes(lenSq);
+   if (EU::SIMD::all(ok)) return;
+   const V one = V::set1(1.0f);
+   const V m = EU::SIMD::max(EU::SIMD::abs(x), EU::SIMD::abs(y));
+   const V d = EU::SIMD::select(ok | (m == V::zero()), one, m);
+   x = x / d;
+   y = y / d;
+   lenSq = EU::SIMD::select(ok, lenSq, x * x + y * y);
+  }
+
+  /** @brief rescaleLanes() for three components. */
+  template<typename V>
+  inline void
+   rescaleLanes(V& x, V& y, V& z, V& lenSq) {
+   const V ok = normalizableLanes(lenSq);
+   if (EU::SIMD::all(ok)) return;
+   const V one = V::set1(1.0f);
+   const V m = EU::SIMD::max(EU::SIMD::abs(x), EU::SIMD::max(EU::SIMD::abs(y), EU::SIMD::abs(z)));
+   const V d = EU::SIMD::select(ok | (m == V::zero()), one, m);
+   x = x / d;
+   y = y / d;
+   z = z / d;
+   lenSq = EU::SIMD::select(ok, lenSq, x * x + y * y + z * z);
+  }
+
+  /** @brief rescaleLanes() for four components, e.g. quaternion packets. */
+  template<typename V>
+  inline void
+   rescaleLanes(V& x, V& y, V& z, V& w, V& lenSq) {
+   const V ok = normalizableLanes(lenSq);
+   if (EU::SIMD::all(ok)) return;
+   const V one = V::set1(1.0f);
+   const V m = EU::SIMD::max(EU::SIMD::max(EU::SIMD::abs(x), EU::SIMD::abs(y)),
+                             EU::SIMD::max(EU::SIMD::abs(z), EU::SIMD::abs(w)));
+   const V d = EU::SIMD::select(ok | (m == V::zero()), one, m);
+   x = x / d;
+   y = y / d;
+   z = z / d;
+   w = w / d;
+   lenSq = EU::SIMD::select(ok, lenSq, x * x + y * y + z * z + w * w);
+  }
+
+#ifndef EU_PRECISION_DEFAULT
+ #define EU_PRECISION_DEFAULT 1
+#endif
+
+#if EU_PRECISION_DEFAULT == 0
+  /// Policy used when a call site does not name one.
+  using Default = Fast;
+#elif EU_PRECISION_DEFAULT == 2
+  /// Policy used when a call site does not name one.
+  using Default = Exact;
+#else
+  /// Policy used when a call site does not name one.
+  using Default = Balanced;
+#endif
+ }
+}
+
+namespace EngineMath {
+ /** @brief Square root through a precision policy, e.g. `EngineMath::sqrt<EU::Precision::Fast>(x)`. */
+ template<typename Policy>
+ EU_CONSTEXPR20 float
+  sqrt(float number) {
+  return Policy::sqrt(number);
+ }
+
+ /** @brief Reciprocal square root through a precision policy. */
+ template<typename Policy>
+ EU_CONSTEXPR20 float
+  rsqrt(float number) {
+  return Policy::rsqrt(number);
+ }
+
+ /** @brief Distance between two 2D points through a precision policy. */
+ template<typename Policy>
+ EU_CONSTEXPR20 float
+  distance(float x1, float y1, float x2, float y2) {
+  float dx = x2 - x1;
+  float dy = y2 - y1;
+  return Policy::sqrt(Policy::madd(dx, dx, dy * dy));
+ }
+}
@@ -0,0 +1,310 @@
+/**
+ * @file Random.h
+ * @brief Small-state xoshiro128+ generator with SIMD bulk fill and geometric sampling.
+ *
+ * 16 bytes of state and a handful of shifts, XORs and adds per 32-bit output. Bulk fills run
+ * FloatN::WIDTH independent generators side by side, each seeded from the parent stream, so a
+ * given seed yields the same buffer on every machine with the same SIMD width.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Rotations/Quaternion.h>
+
+namespace EU {
+ namespace detail {
+  /** SplitMix64 step, used to expand a 64-bit seed into well-mixed generator state. */
+  inline uint64_t
+   splitMix64(uint64_t& state) {
+   uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+   z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+   return z ^ (z >> 31);
+  }
+
+  /** Top 24 bits of a random word as a float in [0, 1). */
+  inline float
+   unitFloat(uint32_t bits) {
+   return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+  }
+ }
+
+ /**
+  * @class Random
+  * @brief xoshiro128+ pseudo-random generator (period 2^128 - 1).
+  *
+  * Not cryptographically secure. Instances are cheap to copy and are not thread safe; give
+  * each thread its own stream with the (seed, stream) constructor or threadLocal().
+  */
+ class
+  Random {
+  public:
+  static constexpr uint64_t DEFAULT_SEED = 0x853c49e6748fea9bULL;
+
+  uint32_t s[4]; ///< Generator state, never all zero
+
+  /**
+   * @brief Seeds the generator.
+   * @param seed Base seed shared by related streams.
+   * @param stream Stream index; different indices give statistically independent sequences.
+   */
+  explicit Random(uint64_t seed = DEFAULT_SEED, uint64_t stream = 0) : s() {
+   uint64_t sm = seed ^ (stream * 0xda942042e4dd58b5ULL);
+   if (stream != 0) {
+    detail::splitMix64(sm);
+   }
+   uint64_t a = detail::splitMix64(sm);
+   uint64_t b = detail::splitMix64(sm);
+   s[0] = static_cast<uint32_t>(a);
+   s[1] = static_cast<uint32_t>(a >> 32);
+   s[2] = static_cast<uint32_t>(b);
+   s[3] = static_cast<uint32_t>(b >> 32);
+   if ((s[0] | s[1] | s[2] | s[3]) == 0) {
+    s[0] = 1;
+   }
+  }
+
+  /**
+   * @brief Per-thread generator, each thread receiving the next stream of DEFAULT_SEED.
+   */
+  static Random&
+   threadLocal() {
+   static std::atomic<uint64_t> nextStream(1);
+   thread_local Random generator(DEFAULT_SEED, nextStream.fetch_add(1, std::memory_order_relaxed));
+   return generator;
+  }
+
+  /** @brief Next 32 random bits. The lowest bits are weaker; prefer the high bits. */
+  uint32_t
+   next() {
+   const uint32_t result = s[0] + s[3];
+   const uint32_t t = s[1] << 9;
+   s[2] ^= s[0];
+   s[3] ^= s[1];
+   s[1] ^= s[2];
+   s[0] ^= s[3];
+   s[2] ^= t;
+   s[3] = (s[3] << 11) | (s[3] >> 21);
+   return result;
+  }
+
+  /**
+   * @brief Advances the state by 2^64 steps, for carving non-overlapping sub-streams.
+   */
+  void
+   jump() {
+   static const uint32_t JUMP[4] = { 0x8764000bu, 0xf542d2d3u, 0x6fa035c3u, 0x77f2db5bu };
+   uint32_t j[4] = { 0, 0, 0, 0 };
+   for (int i = 0; i < 4; ++i) {
+    for (int b = 0; b < 32; ++b) {
+     if (JUMP[i] & (1u << b)) {
+      j[0] ^= s[0];
+      j[1] ^= s[1];
+      j[2] ^= s[2];
+      j[3] ^= s[3];
+     }
+     next();
+    }
+   }
+   s[0] = j[0];
+   s[1] = j[1];
+   s[2] = j[2];
+   s[3] = j[3];
+  }
+
+  /** @brief Uniform float in [0, 1). */
+  float
+   nextFloat() {
+   return detail::unitFloat(next());
+  }
+
+  /** @brief Uniform float in [min, max). */
+  float
+   range(float min, float max) {
+   return min + (max - min) * nextFloat();
+  }
+
+  /**
+   * @brief Uniform integer in [0, bound) by multiply-shift, 0 for bound 0.
+   */
+  uint32_t
+   nextBelow(uint32_t bound) {
+   return static_cast<uint32_t>((static_cast<uint64_t>(next()) * bound) >> 32);
+  }
+
+  /** @brief Uniform integer in [min, max], both inclusive; min when max < min. */
+  int
+   range(int min, int max) {
+   if (max <= min) {
+    return min;
+   }
+   uint32_t span = static_cast<uint32_t>(max) - static_cast<uint32_t>(min) + 1u;
+   uint32_t offset = span == 0 ? next() : nextBelow(span);
+   return static_cast<int>(static_cast<uint32_t>(min) + offset);
+  }
+
+  /** @brief Uniform point on the unit circle. */
+  CVector2
+   onUnitCircle() {
+   float sn, cs;
+   EngineMath::sincos(EU::Constants::TWO_PI * nextFloat(), &sn, &cs);
+   return CVector2(cs, sn);
+  }
+
+  /** @brief Uniform point inside the unit disk (area-uniform, no rejection). */
+  CVector2
+   inUnitDisk() {
+   float r = EngineMath::sqrt(nextFloat());
+   return onUnitCircle() * r;
+  }
+
+  /** @brief Uniform direction on the unit sphere (Archimedes' cylinder projection). */
+  CVector3
+   onUnitSphere() {
+   float z = 2.0f * nextFloat() - 1.0f;
+   float r = EngineMath::sqrt(1.0f - z * z);
+   float sn, cs;
+   EngineMath::sincos(EU::Constants::TWO_PI * nextFloat(), &sn, &cs);
+   return CVector3(r * cs, r * sn, z);
+  }
+
+  /** @brief Uniform point inside the unit ball, by rejection from the enclosing cube. */
+  CVector3
+   inUnitSphere() {
+   for (;;) {
+    CVector3 p(range(-1.0f, 1.0f), range(-1.0f, 1.0f), range(-1.0f, 1.0f));
+    if (p.x * p.x + p.y * p.y + p.z * p.z <= 1.0f) {
+     return p;
+    }
+   }
+  }
+
+  /** @brief Uniformly distributed unit quaternion (Shoemake's method). */
+  Quaternion
+   rotation() {
+   float u = nextFloat();
+   float a = EngineMath::sqrt(1.0f - u);
+   float b = EngineMath::sqrt(u);
+   float s1, c1, s2, c2;
+   EngineMath::sincos(EU::Constants::TWO_PI * nextFloat(), &s1, &c1);
+   EngineMath::sincos(EU::Constants::TWO_PI * nextFloat(), &s2, &c2);
+   return Quaternion(a * s1, a * c1, b * s2, b * c2);
+  }
+
+  /** @brief Fills out[0..n) with random 32-bit words (SIMD). */
+  void
+   fill(uint32_t* out, size_t n);
+
+  /** @brief Fills out[0..n) with uniform floats in [0, 1) (SIMD). */
+  void
+   fill(float* out, size_t n);
+
+  /** @brief Fills out[0..n) with uniform floats in [min, max) (SIMD). */
+  void
+   fill(float* out, size_t n, float min, float max);
+
+  private:
+  template<typename Store>
+  void
+   fillLanes(size_t n, Store store);
+ };
+
+ namespace detail {
+  /** FloatN::WIDTH xoshiro128+ generators in SIMD registers, one per lane. */
+  struct RandomLanes {
+   using I = EU::SIMD::FloatN::Int;
+   static constexpr int WIDTH = EU::SIMD::FloatN::WIDTH;
+   I s0, s1, s2, s3;
+
+   explicit RandomLanes(Random& parent) {
+    int32_t lanes[4][WIDTH];
+    for (int l = 0; l < WIDTH; ++l) {
+     uint64_t high = parent.next();
+     Random lane((high << 32) | parent.next());
+     for (int k = 0; k < 4; ++k) {
+      lanes[k][l] = static_cast<int32_t>(lane.s[k]);
+     }
+    }
+    s0 = I::load(lanes[0]);
+    s1 = I::load(lanes[1]);
+    s2 = I::load(lanes[2]);
+    s3 = I::load(lanes[3]);
+   }
+
+   I
+    next() {
+    I result = s0 + s3;
+    I t = EU::SIMD::shiftLeft<9>(s1);
+    s2 = s2 ^ s0;
+    s3 = s3 ^ s1;
+    s1 = s1 ^ s2;
+    s0 = s0 ^ s3;
+    s2 = s2 ^ t;
+    s3 = EU::SIMD::shiftLeft<11>(s3) | EU::SIMD::shiftRight<21>(s3);
+    return result;
+   }
+
+   EU::SIMD::FloatN
+    nextFloat() {
+    return EU::SIMD::toFloat(EU::SIMD::shiftRight<8>(next())) *
+           EU::SIMD::FloatN::set1(1.0f / 16777216.0f);
+   }
+  };
+ }
+
+ template<typename Store>
+ inline void
+  Random::fillLanes(size_t n, Store store) {
+  const size_t W = static_cast<size_t>(detail::RandomLanes::WIDTH);
+  detail::RandomLanes lanes(*this);
+  size_t i = 0;
+  for (; i + W <= n; i += W) {
+   store(lanes, i, W);
+  }
+  if (i < n) {
+   store(lanes, i, n - i);
+  }
+ }
+
+ inline void
+  Random::fill(uint32_t* out, size_t n) {
+  fillLanes(n, [out](detail::RandomLanes& lanes, size_t i, size_t count) {
+   if (count == static_cast<size_t>(detail::RandomLanes::WIDTH)) {
+    lanes.next().store(reinterpret_cast<int32_t*>(out + i));
+    return;
+   }
+   int32_t tmp[detail::RandomLanes::WIDTH];
+   lanes.next().store(tmp);
+   for (size_t j = 0; j < count; ++j) out[i + j] = static_cast<uint32_t>(tmp[j]);
+  });
+ }
+
+ inline void
+  Random::fill(float* out, size_t n) {
+  fill(out, n, 0.0f, 1.0f);
+ }
+
+ inline void
+  Random::fill(float* out, size_t n, float min, float max) {
+  using V = EU::SIMD::FloatN;
+  V lo = V::set1(min);
+  V span = V::set1(max - min);
+  fillLanes(n, [out, lo, span](detail::RandomLanes& lanes, size_t i, size_t count) {
+   V v = lo + span * lanes.nextFloat();
+   if (count == static_cast<size_t>(V::WIDTH)) {
+    v.store(out + i);
+    return;
+   }
+   float tmp[V::WIDTH];
+   v.store(tmp);
+   for (size_t j = 0; j < count; ++j) out[i + j] = tmp[j];
+  });
+ }
+}
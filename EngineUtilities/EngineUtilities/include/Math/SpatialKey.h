@@ -0,0 +1,306 @@
+/**
+ * @file SpatialKey.h
+ * @brief Morton (Z-order) and Hilbert keys for 2D and 3D integer coordinates.
+ *
+ * A key interleaves the coordinate bits, so points that are close in space mostly get close
+ * keys and sorting by key groups them in memory. 2D keys hold 32 bits per axis, 3D keys 21.
+ * Morton encode/decode is one pdep/pext per axis when BMI2 is available (EU_SIMD_BMI2 on
+ * x64) and byte-table lookups otherwise. Hilbert keys cost a loop over the bits but never
+ * jump between distant cells, which makes neighbouring keys slightly more coherent.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <Core/Platform.h>
+#include <Core/SIMD.h>
+
+#if defined(EU_SIMD_BMI2) && (defined(_M_X64) || defined(__x86_64__))
+ /// 64-bit pdep/pext are usable for the Morton keys.
+ #define EU_MORTON_BMI2 1
+#endif
+
+namespace EngineMath {
+ /// Bits per axis in a 2D key.
+ constexpr int MORTON_BITS2 = 32;
+ /// Bits per axis in a 3D key; the key uses the low 63 bits.
+ constexpr int MORTON_BITS3 = 21;
+
+ namespace detail {
+  constexpr uint64_t MORTON2_X = 0x5555555555555555ull;
+  constexpr uint64_t MORTON2_Y = 0xaaaaaaaaaaaaaaaaull;
+  constexpr uint64_t MORTON3_X = 0x1249249249249249ull;
+  constexpr uint64_t MORTON3_Y = 0x2492492492492492ull;
+  constexpr uint64_t MORTON3_Z = 0x4924924924924924ull;
+
+  /** @brief Byte tables for the Morton fallbacks: spread one byte apart, gather it back. */
+  struct MortonTable {
+   uint16_t spread2[256];  ///< bit i to bit 2i
+   uint32_t spread3[256];  ///< bit i to bit 3i
+   uint8_t compact2[256];  ///< even bits to the low nibble, odd bits to the high nibble
+   uint16_t compact3[512]; ///< bits 3i, 3i+1, 3i+2 to bit i, i+3, i+6
+
+   constexpr MortonTable() : spread2(), spread3(), compact2(), compact3() {
+    for (int v = 0; v < 256; ++v) {
+     for (int b = 0; b < 8; ++b) {
+      if (v & (1 << b)) {
+       spread2[v] = static_cast<uint16_t>(spread2[v] | (1u << (2 * b)));
+       spread3[v] |= 1u << (3 * b);
+       compact2[v] = static_cast<uint8_t>(compact2[v] | (1u << ((b >> 1) + ((b & 1) << 2))));
+      }
+     }
+    }
+    for (int v = 0; v < 512; ++v) {
+     for (int b = 0; b < 9; ++b) {
+      if (v & (1 << b)) compact3[v] = static_cast<uint16_t>(compact3[v] | (1u << (b / 3 + (b % 3) * 3)));
+     }
+    }
+   }
+  };
+
+  /** Holder giving the table a single definition across translation units. */
+  template<typename Tag = void>
+  struct MortonTables {
+   static constexpr MortonTable table = MortonTable();
+  };
+
+  template<typename Tag>
+  constexpr MortonTable MortonTables<Tag>::table;
+
+  constexpr uint64_t
+   mortonTable2(uint32_t x, uint32_t y) {
+   uint64_t key = 0;
+   for (int b = 0; b < 4; ++b) {
+    const uint64_t lanes = MortonTables<>::table.spread2[(x >> (8 * b)) & 0xff] |
+                           static_cast<uint64_t>(MortonTables<>::table.spread2[(y >> (8 * b)) & 0xff]) << 1;
+    key |= lanes << (16 * b);
+   }
+   return key;
+  }
+
+  constexpr uint64_t
+   mortonTable3(uint32_t x, uint32_t y, uint32_t z) {
+   uint64_t key = 0;
+   for (int b = 0; b < 3; ++b) {
+    const uint64_t lanes = static_cast<uint64_t>(MortonTables<>::table.spread3[(x >> (8 * b)) & 0xff]) |
+                           static_cast<uint64_t>(MortonTables<>::table.spread3[(y >> (8 * b)) & 0xff]) << 1 |
+                           static_cast<uint64_t>(MortonTables<>::table.spread3[(z >> (8 * b)) & 0xff]) << 2;
+    key |= lanes << (24 * b);
+   }
+   // The top byte of each axis only contributes its low five bits (21 bits per axis).
+   return key & (MORTON3_X | MORTON3_Y | MORTON3_Z);
+  }
+
+  constexpr void
+   mortonTableDecode2(uint64_t key, uint32_t* x, uint32_t* y) {
+   uint32_t rx = 0, ry = 0;
+   for (int b = 0; b < 8; ++b) {
+    const uint32_t nibbles = MortonTables<>::table.compact2[(key >> (8 * b)) & 0xff];
+    rx |= (nibbles & 0xfu) << (4 * b);
+    ry |= (nibbles >> 4) << (4 * b);
+   }
+   *x = rx;
+   *y = ry;
+  }
+
+  constexpr void
+   mortonTableDecode3(uint64_t key, uint32_t* x, uint32_t* y, uint32_t* z) {
+   uint32_t rx = 0, ry = 0, rz = 0;
+   for (int b = 0; b < 7; ++b) {
+    const uint32_t triples = MortonTables<>::table.compact3[(key >> (9 * b)) & 0x1ff];
+    rx |= (triples & 7u) << (3 * b);
+    ry |= ((triples >> 3) & 7u) << (3 * b);
+    rz |= (triples >> 6) << (3 * b);
+   }
+   *x = rx;
+   *y = ry;
+   *z = rz;
+  }
+
+  /** Bit count clamped to [1, maxBits]. */
+  constexpr int
+   clampBits(int bits, int maxBits) {
+   return bits < 1 ? 1 : (bits > maxBits ? maxBits : bits);
+  }
+
+  /** Low bits of value, for bits in [1, 32]. */
+  constexpr uint32_t
+   lowBits(uint32_t value, int bits) {
+   return bits >= 32 ? value : value & ((1u << bits) - 1u);
+  }
+
+  /**
+   * Skilling's axes-to-transpose step: after it, interleaving the N axes (axis 0 most
+   * significant at every level) gives the Hilbert index.
+   */
+  template<int N>
+  constexpr void
+   hilbertTranspose(uint32_t (&axes)[N], int bits) {
+   const uint32_t top = 1u << (bits - 1);
+   for (uint32_t q = top; q > 1; q >>= 1) {
+    const uint32_t p = q - 1;
+    for (int i = 0; i < N; ++i) {
+     if (axes[i] & q) {
+      axes[0] ^= p;
+     }
+     else {
+      const uint32_t t = (axes[0] ^ axes[i]) & p;
+      axes[0] ^= t;
+      axes[i] ^= t;
+     }
+    }
+   }
+   for (int i = 1; i < N; ++i) axes[i] ^= axes[i - 1];
+   uint32_t t = 0;
+   for (uint32_t q = top; q > 1; q >>= 1) {
+    if (axes[N - 1] & q) t ^= q - 1;
+   }
+   for (int i = 0; i < N; ++i) axes[i] ^= t;
+  }
+
+  /** Inverse of hilbertTranspose(). */
+  template<int N>
+  constexpr void
+   hilbertUntranspose(uint32_t (&axes)[N], int bits) {
+   // Unsigned wrap makes end 0 for bits == 32, where q stops after 1 << 31.
+   const uint32_t end = 2u << (bits - 1);
+   uint32_t t = axes[N - 1] >> 1;
+   for (int i = N - 1; i > 0; --i) axes[i] ^= axes[i - 1];
+   axes[0] ^= t;
+   for (uint32_t q = 2; q != end; q <<= 1) {
+    const uint32_t p = q - 1;
+    for (int i = N - 1; i >= 0; --i) {
+     if (axes[i] & q) {
+      axes[0] ^= p;
+     }
+     else {
+      t = (axes[0] ^ axes[i]) & p;
+      axes[0] ^= t;
+      axes[i] ^= t;
+     }
+    }
+   }
+  }
+ }
+
+ /**
+  * @brief 2D Morton key: bit i of x goes to bit 2i, bit i of y to bit 2i + 1.
+  */
+ EU_CONSTEXPR20 uint64_t
+  morton2(uint32_t x, uint32_t y) {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+  if (std::is_constant_evaluated()) {
+   return detail::mortonTable2(x, y);
+  }
+#endif
+#if defined(EU_MORTON_BMI2)
+  return _pdep_u64(x, detail::MORTON2_X) | _pdep_u64(y, detail::MORTON2_Y);
+#else
+  return detail::mortonTable2(x, y);
+#endif
+ }
+
+ /**
+  * @brief 3D Morton key from the low 21 bits of each axis: x to bits 3i, y to 3i + 1, z to 3i + 2.
+  */
+ EU_CONSTEXPR20 uint64_t
+  morton3(uint32_t x, uint32_t y, uint32_t z) {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+  if (std::is_constant_evaluated()) {
+   return detail::mortonTable3(x, y, z);
+  }
+#endif
+#if defined(EU_MORTON_BMI2)
+  return _pdep_u64(x, detail::MORTON3_X) | _pdep_u64(y, detail::MORTON3_Y) | _pdep_u64(z, detail::MORTON3_Z);
+#else
+  return detail::mortonTable3(x, y, z);
+#endif
+ }
+
+ /** @brief Splits a morton2() key back into its coordinates. */
+ EU_CONSTEXPR20 void
+  mortonDecode2(uint64_t key, uint32_t* x, uint32_t* y) {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+  if (std::is_constant_evaluated()) {
+   detail::mortonTableDecode2(key, x, y);
+   return;
+  }
+#endif
+#if defined(EU_MORTON_BMI2)
+  *x = static_cast<uint32_t>(_pext_u64(key, detail::MORTON2_X));
+  *y = static_cast<uint32_t>(_pext_u64(key, detail::MORTON2_Y));
+#else
+  detail::mortonTableDecode2(key, x, y);
+#endif
+ }
+
+ /** @brief Splits a morton3() key back into its coordinates; bit 63 is ignored. */
+ EU_CONSTEXPR20 void
+  mortonDecode3(uint64_t key, uint32_t* x, uint32_t* y, uint32_t* z) {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+  if (std::is_constant_evaluated()) {
+   detail::mortonTableDecode3(key, x, y, z);
+   return;
+  }
+#endif
+#if defined(EU_MORTON_BMI2)
+  *x = static_cast<uint32_t>(_pext_u64(key, detail::MORTON3_X));
+  *y = static_cast<uint32_t>(_pext_u64(key, detail::MORTON3_Y));
+  *z = static_cast<uint32_t>(_pext_u64(key, detail::MORTON3_Z));
+#else
+  detail::mortonTableDecode3(key, x, y, z);
+#endif
+ }
+
+ /**
+  * @brief Index of (x, y) along a 2D Hilbert curve over a 2^bits square.
+  * @param bits Bits per axis in [1, 32] (clamped); higher coordinate bits are ignored.
+  * @return Key in [0, 2^(2 bits)).
+  */
+ EU_CONSTEXPR20 uint64_t
+  hilbert2(uint32_t x, uint32_t y, int bits = MORTON_BITS2) {
+  bits = detail::clampBits(bits, MORTON_BITS2);
+  uint32_t axes[2] = { detail::lowBits(x, bits), detail::lowBits(y, bits) };
+  detail::hilbertTranspose(axes, bits);
+  return morton2(axes[1], axes[0]);
+ }
+
+ /**
+  * @brief Index of (x, y, z) along a 3D Hilbert curve over a 2^bits cube.
+  * @param bits Bits per axis in [1, 21] (clamped); higher coordinate bits are ignored.
+  * @return Key in [0, 2^(3 bits)).
+  */
+ EU_CONSTEXPR20 uint64_t
+  hilbert3(uint32_t x, uint32_t y, uint32_t z, int bits = MORTON_BITS3) {
+  bits = detail::clampBits(bits, MORTON_BITS3);
+  uint32_t axes[3] = { detail::lowBits(x, bits), detail::lowBits(y, bits), detail::lowBits(z, bits) };
+  detail::hilbertTranspose(axes, bits);
+  return morton3(axes[2], axes[1], axes[0]);
+ }
+
+ /** @brief Inverse of hilbert2() for the same bits. */
+ EU_CONSTEXPR20 void
+  hilbertDecode2(uint64_t key, uint32_t* x, uint32_t* y, int bits = MORTON_BITS2) {
+  bits = detail::clampBits(bits, MORTON_BITS2);
+  uint32_t axes[2] = {};
+  mortonDecode2(key, &axes[1], &axes[0]);
+  axes[0] = detail::lowBits(axes[0], bits);
+  axes[1] = detail::lowBits(axes[1], bits);
+  detail::hilbertUntranspose(axes, bits);
+  *x = axes[0];
+  *y = axes[1];
+ }
+
+ /** @brief Inverse of hilbert3() for the same bits. */
+ EU_CONSTEXPR20 void
+  hilbertDecode3(uint64_t key, uint32_t* x, uint32_t* y, uint32_t* z, int bits = MORTON_BITS3) {
+  bits = detail::clampBits(bits, MORTON_BITS3);
+  uint32_t axes[3] = {};
+  mortonDecode3(key, &axes[2], &axes[1], &axes[0]);
+  for (uint32_t& axis : axes) axis = detail::lowBits(axis, bits);
+  detail::hilbertUntranspose(axes, bits);
+  *x = axes[0];
+  *y = axes[1];
+  *z = axes[2];
+ }
+}
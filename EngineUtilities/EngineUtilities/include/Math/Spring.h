@@ -0,0 +1,288 @@
+/**
+ * @file Spring.h
+ * @brief Damped springs that follow a target exactly for any dt: critically damped "smooth
+ * damp" followers and frequency/damping-ratio springs, for floats, CVector2/3, Quaternion
+ * and SoA arrays of them.
+ *
+ * A spring pulls value toward target with angular frequency omega (radians per second) and
+ * damping ratio zeta: x'' = -omega^2 (x - target) - 2 zeta omega x'. Each step uses the
+ * closed-form solution of that equation over dt with the target held still, so a step is
+ * exact, unconditionally stable and gives the same motion whether dt is one long frame or
+ * many short ones (Juckett). zeta = 1 is critical damping, the fastest approach that never
+ * overshoots; below 1 the spring oscillates, above 1 it creeps. For followers tuned by a
+ * smooth time, springFrequency(smoothTime) gives an omega with the feel of Unity's
+ * SmoothDamp.
+ *
+ * The solution is linear in the offset from the target and the velocity, so it comes down
+ * to four coefficients per (omega, zeta, dt). SpringCoefficients computes them once and
+ * springStep() applies them with four multiply-adds per component; springStepArray() does
+ * the same for a whole array per SIMD register. Springs that each have their own omega use
+ * criticalSpring() / criticalSpringArray(), which evaluate the critically damped solution
+ * with one exp per spring, batch::kernels::exp in the array version.
+ *
+ * Quaternion springs run the same equation on the rotation vector of rotation * target^-1
+ * (the shorter arc), with the velocity a world-space angular velocity in radians per second.
+ *
+ *   const SpringCoefficients k = SpringCoefficients::damped(springFrequency(0.3f), 1.f, dt);
+ *   springStep(cameraPosition, cameraVelocity, player.position, k);
+ *   springStepArray(reinterpret_cast<float*>(icons), reinterpret_cast<float*>(iconVelocities),
+ *                   reinterpret_cast<const float*>(slots), 2 * iconCount, k); // CVector2 arrays
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/PoseBlend.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Damping ratios this close to 1 use the critically damped solution.
+ constexpr float SPRING_CRITICAL_BAND = 1e-3f;
+
+ /** @brief omega of a critically damped spring that settles like SmoothDamp(smoothTime). */
+ constexpr float
+  springFrequency(float smoothTime) {
+  return smoothTime > 0.f ? 2.f / smoothTime : 0.f;
+ }
+
+ /**
+  * @struct SpringCoefficients
+  * @brief One step of one spring as offset' = posPos offset + posVel velocity and
+  * velocity' = velPos offset + velVel velocity, with offset = value - target.
+  */
+ struct SpringCoefficients {
+  float posPos = 1.f;
+  float posVel = 0.f;
+  float velPos = 0.f;
+  float velVel = 1.f;
+
+  /**
+   * @brief Step of dt seconds for angular frequency omega and damping ratio zeta; omega <= 0
+   * or dt <= 0 leave everything where it is.
+   */
+  static SpringCoefficients
+   damped(float omega, float zeta, float dt) {
+   SpringCoefficients c;
+   if (omega <= 0.f || dt <= 0.f) return c;
+   zeta = zeta > 0.f ? zeta : 0.f;
+   if (zeta > 1.f + SPRING_CRITICAL_BAND) {
+    // Over-damped: two real exponentials.
+    const float za = -omega * zeta, zb = omega * EngineMath::sqrt(zeta * zeta - 1.f);
+    const float z1 = za - zb, z2 = za + zb;
+    const float invTwoZb = 1.f / (2.f * zb);
+    const float e1 = EngineMath::exp(z1 * dt) * invTwoZb, e2 = EngineMath::exp(z2 * dt) * invTwoZb;
+    c.posPos = e1 * z2 - z2 * e2 + e2 * 2.f * zb;
+    c.posVel = e2 - e1;
+    c.velPos = (z1 * e1 - z2 * e2 + e2 * 2.f * zb) * z2;
+    c.velVel = z2 * e2 - z1 * e1;
+   }
+   else if (zeta < 1.f - SPRING_CRITICAL_BAND) {
+    // Under-damped: a decaying oscillation.
+    const float omegaZeta = omega * zeta, alpha = omega * EngineMath::sqrt(1.f - zeta * zeta);
+    float s = 0.f, co = 1.f;
+    EngineMath::sincos(alpha * dt, &s, &co);
+    const float decay = EngineMath::exp(-omegaZeta * dt);
+    const float expSin = decay * s, expCos = decay * co;
+    const float expZetaSin = expSin * omegaZeta / alpha;
+    c.posPos = expCos + expZetaSin;
+    c.posVel = expSin / alpha;
+    c.velPos = -expSin * alpha - omegaZeta * expZetaSin;
+    c.velVel = expCos - expZetaSin;
+   }
+   else {
+    const float decay = EngineMath::exp(-omega * dt);
+    const float timeDecay = dt * decay, timeDecayOmega = timeDecay * omega;
+    c.posPos = timeDecayOmega + decay;
+    c.posVel = timeDecay;
+    c.velPos = -omega * timeDecayOmega;
+    c.velVel = decay - timeDecayOmega;
+   }
+   return c;
+  }
+
+  /** @brief damped(omega, 1, dt). */
+  static SpringCoefficients
+   critical(float omega, float dt) {
+   return damped(omega, 1.f, dt);
+  }
+ };
+
+ /**
+  * @brief Advances value and velocity one step toward target (float, CVector2 or CVector3).
+  */
+ template<typename T>
+ inline void
+  springStep(T& value, T& velocity, const T& target, const SpringCoefficients& c) {
+  const T offset = value - target;
+  value = target + offset * c.posPos + velocity * c.posVel;
+  velocity = offset * c.velPos + velocity * c.velVel;
+ }
+
+ /**
+  * @brief Critically damped step of dt with this spring's own omega; one exp.
+  */
+ template<typename T>
+ inline void
+  criticalSpring(T& value, T& velocity, const T& target, float omega, float dt) {
+  const T offset = value - target;
+  const T j = velocity + offset * omega;
+  const float decay = EngineMath::exp(-omega * dt);
+  value = target + (offset + j * dt) * decay;
+  velocity = (velocity - j * (omega * dt)) * decay;
+ }
+
+ namespace detail {
+  /** Rotation vector of rotation * target^-1, the shorter way round. */
+  inline CVector3
+   springRotationOffset(const Quaternion& rotation, const Quaternion& target) {
+   Quaternion delta = rotation * Quaternion(-target.x, -target.y, -target.z, target.w);
+   if (delta.w < 0.f) delta = Quaternion(-delta.x, -delta.y, -delta.z, -delta.w);
+   const Quaternion l = delta.log();
+   return CVector3(2.f * l.x, 2.f * l.y, 2.f * l.z);
+  }
+
+  /** target turned further by the rotation vector offset. */
+  inline Quaternion
+   springRotation(const CVector3& offset, const Quaternion& target) {
+   return (Quaternion(0.5f * offset.x, 0.5f * offset.y, 0.5f * offset.z, 0.f).exp() * target).normalized();
+  }
+ }
+
+ /** @brief springStep() of a unit quaternion; angularVelocity is world space, in radians per second. */
+ inline void
+  springStep(Quaternion& rotation, CVector3& angularVelocity, const Quaternion& target, const SpringCoefficients& c) {
+  CVector3 offset = detail::springRotationOffset(rotation, target);
+  const CVector3 zero(0.f, 0.f, 0.f);
+  springStep(offset, angularVelocity, zero, c);
+  rotation = detail::springRotation(offset, target);
+ }
+
+ /** @brief criticalSpring() of a unit quaternion. */
+ inline void
+  criticalSpring(Quaternion& rotation, CVector3& angularVelocity, const Quaternion& target, float omega, float dt) {
+  CVector3 offset = detail::springRotationOffset(rotation, target);
+  const CVector3 zero(0.f, 0.f, 0.f);
+  criticalSpring(offset, angularVelocity, zero, omega, dt);
+  rotation = detail::springRotation(offset, target);
+ }
+
+ namespace detail {
+  /**
+   * Runs fn(i, count) over [0, n) one register at a time; the caller loads and stores
+   * through springLoad()/springStore(), which pad the last register with pad.
+   */
+  template<typename Fn>
+  inline void
+   forEachSpringPacket(size_t n, Fn fn) {
+   for (size_t i = 0; i < n; i += BATCH_WIDTH) fn(i, n - i < BATCH_WIDTH ? n - i : BATCH_WIDTH);
+  }
+
+  inline BatchLanes
+   springLoad(const float* p, size_t i, size_t count, float pad = 0.f) {
+   if (count == BATCH_WIDTH) return BatchLanes::load(p + i);
+   float lanes[BATCH_WIDTH];
+   for (size_t k = 0; k < BATCH_WIDTH; ++k) lanes[k] = k < count ? p[i + k] : pad;
+   return BatchLanes::load(lanes);
+  }
+
+  inline void
+   springStore(BatchLanes v, float* p, size_t i, size_t count) {
+   if (count == BATCH_WIDTH) {
+    v.store(p + i);
+    return;
+   }
+   float lanes[BATCH_WIDTH];
+   v.store(lanes);
+   for (size_t k = 0; k < count; ++k) p[i + k] = lanes[k];
+  }
+ }
+
+ /**
+  * @brief springStep() of value[i] and velocity[i] toward target[i] for i in [0, n), every
+  * spring sharing c. Components are independent, so arrays of CVector2 or CVector3 pass as
+  * 2n or 3n floats.
+  */
+ inline void
+  springStepArray(float* value, float* velocity, const float* target, size_t n, const SpringCoefficients& c) {
+  using V = detail::BatchLanes;
+  const V pp = V::set1(c.posPos), pv = V::set1(c.posVel), vp = V::set1(c.velPos), vv = V::set1(c.velVel);
+  detail::forEachSpringPacket(n, [&](size_t i, size_t count) {
+   const V t = detail::springLoad(target, i, count);
+   const V offset = detail::springLoad(value, i, count) - t;
+   const V v = detail::springLoad(velocity, i, count);
+   detail::springStore(t + EU::SIMD::madd(pv, v, pp * offset), value, i, count);
+   detail::springStore(EU::SIMD::madd(vv, v, vp * offset), velocity, i, count);
+  });
+ }
+
+ /**
+  * @brief criticalSpring() of value[i] with omega[i] for i in [0, n); for vectors, call it on
+  * each component array of an SoA layout with the same omega.
+  */
+ inline void
+  criticalSpringArray(float* value, float* velocity, const float* target, const float* omega, size_t n, float dt) {
+  using V = detail::BatchLanes;
+  const V step = V::set1(dt);
+  detail::forEachSpringPacket(n, [&](size_t i, size_t count) {
+   const V t = detail::springLoad(target, i, count), w = detail::springLoad(omega, i, count);
+   const V offset = detail::springLoad(value, i, count) - t;
+   const V v = detail::springLoad(velocity, i, count);
+   const V j = EU::SIMD::madd(offset, w, v);
+   const V decay = EngineMath::batch::kernels::exp(-(w * step));
+   detail::springStore(t + EU::SIMD::madd(j, step, offset) * decay, value, i, count);
+   detail::springStore((v - j * (w * step)) * decay, velocity, i, count);
+  });
+ }
+
+ /**
+  * @brief springStep() of rotations[i] and angularVelocities[i] toward targets[i] for i in
+  * [0, n), through the lane versions of Quaternion::log() and exp().
+  */
+ inline void
+  springStepArray(QuaternionSoA rotations, EngineMath::batch::SoA3 angularVelocities, ConstQuaternionSoA targets,
+                  size_t n, const SpringCoefficients& c) {
+  using V = detail::BatchLanes;
+  const V pp = V::set1(c.posPos), pv = V::set1(c.posVel), vp = V::set1(c.velPos), vv = V::set1(c.velVel);
+  const V half = V::set1(0.5f), two = V::set1(2.f), zero = V::zero();
+  detail::forEachSpringPacket(n, [&](size_t i, size_t count) {
+   // Padding lanes are identity quaternions so log() stays finite.
+   const V q[4] = { detail::springLoad(rotations.x, i, count), detail::springLoad(rotations.y, i, count),
+                    detail::springLoad(rotations.z, i, count), detail::springLoad(rotations.w, i, count, 1.f) };
+   const V t[4] = { detail::springLoad(targets.x, i, count), detail::springLoad(targets.y, i, count),
+                    detail::springLoad(targets.z, i, count), detail::springLoad(targets.w, i, count, 1.f) };
+   // delta = q * conjugate(t), flipped onto the shorter arc.
+   V d[4] = { t[3] * q[0] - q[3] * t[0] - q[1] * t[2] + q[2] * t[1],
+              t[3] * q[1] + q[0] * t[2] - q[3] * t[1] - q[2] * t[0],
+              t[3] * q[2] - q[0] * t[1] + q[1] * t[0] - q[3] * t[2],
+              q[3] * t[3] + q[0] * t[0] + q[1] * t[1] + q[2] * t[2] };
+   const V flip = d[3] < zero;
+   for (int e = 0; e < 4; ++e) d[e] = EU::SIMD::select(flip, -d[e], d[e]);
+   V l[4];
+   detail::quaternionLogLanes(d, l);
+   float* const w[3] = { angularVelocities.x, angularVelocities.y, angularVelocities.z };
+   V turn[4];
+   for (int e = 0; e < 3; ++e) {
+    const V offset = two * l[e], v = detail::springLoad(w[e], i, count);
+    turn[e] = half * EU::SIMD::madd(pv, v, pp * offset);
+    detail::springStore(EU::SIMD::madd(vv, v, vp * offset), w[e], i, count);
+   }
+   turn[3] = zero;
+   V r[4];
+   detail::quaternionExpLanes(turn, r);
+   // rotation = r * t, renormalized.
+   V o[4] = { r[3] * t[0] + r[0] * t[3] + r[1] * t[2] - r[2] * t[1],
+              r[3] * t[1] - r[0] * t[2] + r[1] * t[3] + r[2] * t[0],
+              r[3] * t[2] + r[0] * t[1] - r[1] * t[0] + r[2] * t[3],
+              r[3] * t[3] - r[0] * t[0] - r[1] * t[1] - r[2] * t[2] };
+   const V inv = V::set1(1.f) / EU::SIMD::sqrt(o[0] * o[0] + o[1] * o[1] + o[2] * o[2] + o[3] * o[3]);
+   float* const out[4] = { rotations.x, rotations.y, rotations.z, rotations.w };
+   for (int e = 0; e < 4; ++e) detail::springStore(o[e] * inv, out[e], i, count);
+  });
+ }
+}
@@ -0,0 +1,373 @@
+/**
+ * @file Affine3x4.h
+ * @brief Affine transform stored as the top three rows of a Matrix4x4.
+ *
+ * The bottom row of an affine Matrix4x4 is always (0, 0, 0, 1), so Affine3x4 keeps only
+ * the other twelve floats: 48 bytes instead of 64 per world transform or bone. Layout and
+ * conventions match Matrix4x4 (row-major, column vectors, translation in column 3), so the
+ * rows can be uploaded as-is wherever a shader expects three float4 rows.
+ *
+ * Composition multiplies the 3x3 blocks and adds the translation column directly, 36
+ * multiplies instead of the 64 of a full product.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Matrices/Matrix3x3.h>
+#include <Matrices/Matrix4x4.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+
+ /**
+  * @class Affine3x4
+  * @brief 3x4 affine transform: a 3x3 linear block plus a translation column.
+  */
+ class
+  Affine3x4 {
+  public:
+  float m[3][4]; ///< Matrix elements in row-major order; m[i][3] is the translation
+
+  /**
+   * @brief Default constructor. Initializes to the identity transform.
+   */
+  constexpr Affine3x4()
+   : m{ { 1.f, 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f, 0.f }, { 0.f, 0.f, 1.f, 0.f } } {}
+
+  /**
+   * @brief Leaves every element uninitialized; see EU::NoInit.
+   */
+  explicit Affine3x4(EU::NoInitTag) {}
+
+  /**
+   * @brief Constructor with individual elements, row by row.
+   */
+  constexpr Affine3x4(float m00, float m01, float m02, float m03,
+                      float m10, float m11, float m12, float m13,
+                      float m20, float m21, float m22, float m23)
+   : m{ { m00, m01, m02, m03 }, { m10, m11, m12, m13 }, { m20, m21, m22, m23 } } {}
+
+  /**
+   * @brief Top three rows of a Matrix4x4; its bottom row is assumed to be (0, 0, 0, 1).
+   */
+  explicit constexpr Affine3x4(const Matrix4x4& mat)
+   : m{ { mat.m[0][0], mat.m[0][1], mat.m[0][2], mat.m[0][3] },
+        { mat.m[1][0], mat.m[1][1], mat.m[1][2], mat.m[1][3] },
+        { mat.m[2][0], mat.m[2][1], mat.m[2][2], mat.m[2][3] } } {}
+
+  /**
+   * @brief Expands to a Matrix4x4 with bottom row (0, 0, 0, 1).
+   */
+  constexpr Matrix4x4
+   toMatrix4x4() const {
+   return Matrix4x4(
+   m[0][0], m[0][1], m[0][2], m[0][3],
+   m[1][0], m[1][1], m[1][2], m[1][3],
+   m[2][0], m[2][1], m[2][2], m[2][3],
+   0.f, 0.f, 0.f, 1.f
+   );
+  }
+
+  /**
+   * @brief Composes translation * rotation * scale: scales first, then rotates, then moves.
+   * @param rotation Rotation quaternion; it does not need to be normalized.
+   */
+  static constexpr Affine3x4
+   fromTRS(const CVector3& translation, const Quaternion& rotation, const CVector3& scale) {
+   const float lenSq = rotation.x * rotation.x + rotation.y * rotation.y
+                       + rotation.z * rotation.z + rotation.w * rotation.w;
+   const float s = lenSq == 0.f ? 0.f : 2.f / lenSq;
+   const float xx = rotation.x * rotation.x * s, yy = rotation.y * rotation.y * s, zz = rotation.z * rotation.z * s;
+   const float xy = rotation.x * rotation.y * s, xz = rotation.x * rotation.z * s, yz = rotation.y * rotation.z * s;
+   const float wx = rotation.w * rotation.x * s, wy = rotation.w * rotation.y * s, wz = rotation.w * rotation.z * s;
+   return Affine3x4(
+   (1.f - (yy + zz)) * scale.x, (xy - wz) * scale.y, (xz + wy) * scale.z, translation.x,
+   (xy + wz) * scale.x, (1.f - (xx + zz)) * scale.y, (yz - wx) * scale.z, translation.y,
+   (xz - wy) * scale.x, (yz + wx) * scale.y, (1.f - (xx + yy)) * scale.z, translation.z
+   );
+  }
+
+  /**
+   * @brief Splits the transform back into the parts fromTRS() takes.
+   *
+   * Scale is the length of each column of the 3x3 block; a mirrored block (negative
+   * determinant) reports a negative x scale. Shear is not representable and is folded into
+   * the rotation, which is then only approximate. A zero scale gives an identity rotation.
+   */
+  template<typename Policy = EU::Precision::Default>
+  EU_CONSTEXPR20 void
+   decompose(CVector3& translation, Quaternion& rotation, CVector3& scale) const {
+   translation = CVector3(m[0][3], m[1][3], m[2][3]);
+   float sx = Policy::sqrt(m[0][0] * m[0][0] + m[1][0] * m[1][0] + m[2][0] * m[2][0]);
+   const float sy = Policy::sqrt(m[0][1] * m[0][1] + m[1][1] * m[1][1] + m[2][1] * m[2][1]);
+   const float sz = Policy::sqrt(m[0][2] * m[0][2] + m[1][2] * m[1][2] + m[2][2] * m[2][2]);
+   if (determinant() < 0.f) sx = -sx;
+   scale = CVector3(sx, sy, sz);
+   if (sx == 0.f || sy == 0.f || sz == 0.f) {
+    rotation = Quaternion();
+    return;
+   }
+   const float ix = 1.f / sx, iy = 1.f / sy, iz = 1.f / sz;
+   const float r00 = m[0][0] * ix, r01 = m[0][1] * iy, r02 = m[0][2] * iz;
+   const float r10 = m[1][0] * ix, r11 = m[1][1] * iy, r12 = m[1][2] * iz;
+   const float r20 = m[2][0] * ix, r21 = m[2][1] * iy, r22 = m[2][2] * iz;
+   // Pivot on the largest of w, x, y, z so the divisor never gets small.
+   const float trace = r00 + r11 + r22;
+   if (trace > 0.f) {
+    const float t = Policy::sqrt(trace + 1.f) * 2.f;
+    rotation = Quaternion((r21 - r12) / t, (r02 - r20) / t, (r10 - r01) / t, 0.25f * t);
+   }
+   else if (r00 > r11 && r00 > r22) {
+    const float t = Policy::sqrt(1.f + r00 - r11 - r22) * 2.f;
+    rotation = Quaternion(0.25f * t, (r01 + r10) / t, (r02 + r20) / t, (r21 - r12) / t);
+   }
+   else if (r11 > r22) {
+    const float t = Policy::sqrt(1.f + r11 - r00 - r22) * 2.f;
+    rotation = Quaternion((r01 + r10) / t, 0.25f * t, (r12 + r21) / t, (r02 - r20) / t);
+   }
+   else {
+    const float t = Policy::sqrt(1.f + r22 - r00 - r11) * 2.f;
+    rotation = Quaternion((r02 + r20) / t, (r12 + r21) / t, 0.25f * t, (r10 - r01) / t);
+   }
+   rotation = rotation.normalized<Policy>();
+  }
+
+  /**
+   * @brief Composes two transforms: (a * b) applies b first, like Matrix4x4::operator*.
+   *
+   * Row i is sum over k < 3 of m[i][k] * row k of otro, accumulated left to right, plus
+   * m[i][3] in the translation lane. SSE2/NEON do one row per register, plain loops
+   * otherwise and in constant expressions; every path gives the same bits unless the
+   * multiply-adds are fused (FMA targets outside EU_REPRODUCIBLE).
+   */
+  EU_CONSTEXPR20 Affine3x4
+   operator*(const Affine3x4& otro) const {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+   if (std::is_constant_evaluated()) {
+    return multiplyScalar(otro);
+   }
+#endif
+#if defined(EU_SIMD_SSE2) || defined(EU_SIMD_NEON)
+   using EU::SIMD::Float4;
+   const int32_t translationLane[4] = { 0, 0, 0, -1 };
+   const Float4 lane = EU::SIMD::asFloat(EU::SIMD::Int4::load(translationLane));
+   Affine3x4 r(EU::NoInit);
+   const Float4 b0 = Float4::load(otro.m[0]), b1 = Float4::load(otro.m[1]), b2 = Float4::load(otro.m[2]);
+   for (int fil = 0; fil < 3; ++fil) {
+    const Float4 a = Float4::load(m[fil]);
+    Float4 acc = EU::SIMD::shuffle<0, 0, 0, 0>(a) * b0;
+    acc = EU::SIMD::madd(EU::SIMD::shuffle<1, 1, 1, 1>(a), b1, acc);
+    acc = EU::SIMD::madd(EU::SIMD::shuffle<2, 2, 2, 2>(a), b2, acc);
+    (acc + (a & lane)).store(r.m[fil]);
+   }
+   return r;
+#else
+   return multiplyScalar(otro);
+#endif
+  }
+
+  /**
+   * @brief In-place composition: *this = *this * otro, so otro applies first.
+   */
+  EU_CONSTEXPR20 Affine3x4&
+   operator*=(const Affine3x4& otro) {
+   *this = *this * otro;
+   return *this;
+  }
+
+  /**
+   * @brief Transforms a point: the 3x3 block plus the translation.
+   */
+  constexpr CVector3
+   transformPoint(const CVector3& p) const {
+   return CVector3(
+   m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+   m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+   m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]
+   );
+  }
+
+  /**
+   * @brief Transforms a direction: the 3x3 block only, no translation.
+   *
+   * Normals need the inverse transpose instead unless the scale is uniform.
+   */
+  constexpr CVector3
+   transformDirection(const CVector3& d) const {
+   return CVector3(
+   m[0][0] * d.x + m[0][1] * d.y + m[0][2] * d.z,
+   m[1][0] * d.x + m[1][1] * d.y + m[1][2] * d.z,
+   m[2][0] * d.x + m[2][1] * d.y + m[2][2] * d.z
+   );
+  }
+
+  /**
+   * @brief Translation column.
+   */
+  constexpr CVector3
+   translation() const {
+   return CVector3(m[0][3], m[1][3], m[2][3]);
+  }
+
+  /**
+   * @brief Replaces the translation column, keeping the 3x3 block.
+   */
+  constexpr void
+   setTranslation(const CVector3& t) {
+   m[0][3] = t.x;
+   m[1][3] = t.y;
+   m[2][3] = t.z;
+  }
+
+  /**
+   * @brief Accesses an element by row and column.
+   */
+  constexpr float&
+   operator()(int fil, int col) {
+   return m[fil][col];
+  }
+
+  /**
+   * @brief Const access to an element by row and column.
+   */
+  constexpr const float&
+   operator()(int fil, int col) const {
+   return m[fil][col];
+  }
+
+  /**
+   * @brief True when every element is within epsilon of otro's.
+   */
+  constexpr bool
+   approxEqual(const Affine3x4& otro, float epsilon = EU::Constants::EPSILON) const {
+   for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 4; ++j)
+     if (!EngineMath::approxEqual(m[i][j], otro.m[i][j], epsilon)) return false;
+   return true;
+  }
+
+  /**
+   * @brief Determinant of the 3x3 block, which is that of the whole transform.
+   */
+  constexpr float
+   determinant() const {
+   return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+          + m[0][1] * (m[1][2] * m[2][0] - m[1][0] * m[2][2])
+          + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+  }
+
+  /**
+   * @brief Inverse transform, same arithmetic as Matrix4x4::inverseAffine(). Returns identity
+   * if the 3x3 block is singular.
+   */
+  constexpr Affine3x4
+   inverse() const {
+   const float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+   const float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+   const float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+   const float det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+   if (det == 0.f) return Affine3x4();
+   const float s = 1.f / det;
+   const float a00 = c00 * s;
+   const float a01 = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * s;
+   const float a02 = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * s;
+   const float a10 = c01 * s;
+   const float a11 = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * s;
+   const float a12 = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * s;
+   const float a20 = c02 * s;
+   const float a21 = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * s;
+   const float a22 = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * s;
+   const float tx = m[0][3], ty = m[1][3], tz = m[2][3];
+   return Affine3x4(
+   a00, a01, a02, -(a00 * tx + a01 * ty + a02 * tz),
+   a10, a11, a12, -(a10 * tx + a11 * ty + a12 * tz),
+   a20, a21, a22, -(a20 * tx + a21 * ty + a22 * tz)
+   );
+  }
+
+  /**
+   * @brief Inverse of a rotation plus translation (orthonormal 3x3 block): the transposed
+   * rotation and the translation rotated back and negated.
+   */
+  constexpr Affine3x4
+   inverseRigid() const {
+   const float tx = m[0][3], ty = m[1][3], tz = m[2][3];
+   return Affine3x4(
+   m[0][0], m[1][0], m[2][0], -(m[0][0] * tx + m[1][0] * ty + m[2][0] * tz),
+   m[0][1], m[1][1], m[2][1], -(m[0][1] * tx + m[1][1] * ty + m[2][1] * tz),
+   m[0][2], m[1][2], m[2][2], -(m[0][2] * tx + m[1][2] * ty + m[2][2] * tz)
+   );
+  }
+
+  /**
+   * @brief The 3x3 linear block.
+   */
+  constexpr Matrix3x3
+   linear() const {
+   return Matrix3x3(m[0][0], m[0][1], m[0][2],
+                    m[1][0], m[1][1], m[1][2],
+                    m[2][0], m[2][1], m[2][2]);
+  }
+
+  /**
+   * @brief Normal matrix: the inverse transpose of the linear block, through
+   * Matrix3x3::normalMatrix() (no cofactors under uniform scale).
+   */
+  constexpr Matrix3x3
+   normalMatrix(float tolerance = 1e-5f) const {
+   return linear().normalMatrix(tolerance);
+  }
+
+  /**
+   * @brief Returns the identity transform.
+   */
+  static constexpr Affine3x4
+   identity() {
+   return Affine3x4();
+  }
+
+  private:
+  /**
+   * Scalar product with the same accumulation as the SIMD path, including the + 0 that the
+   * masked translation lane adds to the 3x3 block (it turns -0 into +0).
+   */
+  constexpr Affine3x4
+   multiplyScalar(const Affine3x4& otro) const {
+   Affine3x4 r;
+   for (int fil = 0; fil < 3; ++fil)
+    for (int col = 0; col < 4; ++col)
+     r.m[fil][col] = ((m[fil][0] * otro.m[0][col] + m[fil][1] * otro.m[1][col])
+                      + m[fil][2] * otro.m[2][col]) + (col == 3 ? m[fil][3] : 0.f);
+   return r;
+  }
+ };
+
+ static_assert(sizeof(Affine3x4) == 12 * sizeof(float), "Affine3x4 must stay three packed rows");
+ EU_ASSERT_VALUE_TYPE(Affine3x4);
+
+ /**
+  * @brief out[i] = in[i].normalMatrix(tolerance), bit for bit unless the multiply-adds are
+  * fused (FMA targets outside EU_REPRODUCIBLE).
+  */
+ inline void
+  normalMatrixArray(const Affine3x4* in, Matrix3x3* out, size_t n, float tolerance = 1e-5f) {
+  detail::normalMatrixLanes(in, nullptr, n, out, tolerance);
+ }
+
+ /**
+  * @brief out[nodes[k]] = in[nodes[k]].normalMatrix(tolerance) for k < count: refreshes a
+  * cached normal-matrix array for just the listed transforms, e.g.
+  * TransformHierarchy::changedNodes().
+  */
+ inline void
+  normalMatrixArray(const Affine3x4* in, const uint32_t* nodes, size_t count, Matrix3x3* out,
+                    float tolerance = 1e-5f) {
+  detail::normalMatrixLanes(in, nodes, count, out, tolerance);
+ }
+}
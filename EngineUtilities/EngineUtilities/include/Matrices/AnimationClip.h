@@ -0,0 +1,396 @@
+/**
+ * @file AnimationClip.h
+ * @brief Compressed skeletal animation clips and their single-pass sampler.
+ *
+ * A clip holds uniformly sampled keys for n bones. AnimationClip::compress() quantizes them:
+ * rotations in the 48-bit smallest-three format of QuaternionPacked.h, translations and
+ * scales as 16 bits per axis within the range the bone covers over a segment. A key costs 6
+ * bytes for the rotation and 6 for the translation, plus 6 for the scale when the clip has
+ * one, against 28 (40 with scale) uncompressed. Rotations land within 0.01 degrees of the
+ * original; translations and scales within half a step of their segment range.
+ *
+ * Keys are grouped in segments of CLIP_SEGMENT_FRAMES frames. A segment stores its ranges
+ * first, then its keys frame by frame, every bone of a frame next to each other. The key that
+ * ends one segment is repeated at the start of the next, so the two keys sampled for any time
+ * always lie in one segment, in two adjacent rows. sample() walks those rows and the ranges
+ * front to back, decoding and interpolating bone after bone into a PoseSoA in one sequential
+ * pass. Rotations are nlerped on the shortest arc, as in blendPoses().
+ *
+ * Sampling goes through AnimationClipView, which reads arrays it does not own, so a clip
+ * stored in a mapped pack file (PackTypes.h) plays straight from the mapping.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Platform.h>
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Matrices/PoseBlend.h>
+#include <Rotations/Quaternion.h>
+#include <Rotations/QuaternionPacked.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /// Frames per clip segment; each segment stores one more key, shared with the next one.
+ constexpr size_t CLIP_SEGMENT_FRAMES = 16;
+
+ namespace detail {
+  /// Largest 16-bit code of a range-quantized axis.
+  constexpr float CLIP_RANGE_STEPS = 65535.f;
+
+  /** Stores the 47-bit QuaternionFormat::Bits48 code of q in three words, low word first. */
+  inline void
+   packRotationKey(const Quaternion& q, uint16_t* out) {
+   const uint64_t code = packQuaternion(q, QuaternionFormat::Bits48);
+   out[0] = static_cast<uint16_t>(code);
+   out[1] = static_cast<uint16_t>(code >> 16);
+   out[2] = static_cast<uint16_t>(code >> 32);
+  }
+
+  template<typename Policy>
+  inline Quaternion
+   unpackRotationKey(const uint16_t* in) {
+   return unpackQuaternion<Policy>(uint64_t(in[0]) | uint64_t(in[1]) << 16 | uint64_t(in[2]) << 32,
+                                   QuaternionFormat::Bits48);
+  }
+
+  /** 16-bit code of value in [lo, lo + extent]; 0 when the range is empty. */
+  inline uint16_t
+   quantizeClipRange(float value, float lo, float extent) {
+   if (!(extent > 0.f)) return 0;
+   const float t = EngineMath::clamp((value - lo) / extent, 0.f, 1.f);
+   return static_cast<uint16_t>(t * CLIP_RANGE_STEPS + 0.5f);
+  }
+ }
+
+ /**
+  * @struct AnimationClipLayout
+  * @brief Shape of a clip's key and range arrays; stored as-is in pack files (PackTypes.h).
+  */
+ struct
+  AnimationClipLayout {
+  uint32_t boneCount = 0;
+  uint32_t frameCount = 0;
+  uint32_t segmentFrames = static_cast<uint32_t>(CLIP_SEGMENT_FRAMES);
+  float sampleRate = 0.f;
+  uint32_t hasScale = 0;
+
+  /** @brief Words per bone key: rotation, translation and optionally scale, three each. */
+  size_t
+   keyStride() const {
+   return hasScale ? 9 : 6;
+  }
+
+  /** @brief Floats per bone range: minimum and step per axis of translation and optionally scale. */
+  size_t
+   rangeStride() const {
+   return hasScale ? 12 : 6;
+  }
+
+  size_t
+   segmentCount() const {
+   return frameCount <= 1 ? 1 : (frameCount - 2) / segmentFrames + 1;
+  }
+
+  /** @brief Keys stored for segment s, including the one shared with the next segment. */
+  size_t
+   keysInSegment(size_t s) const {
+   const size_t first = s * segmentFrames;
+   const size_t remaining = frameCount - first;
+   return remaining < size_t(segmentFrames) + 1 ? remaining : size_t(segmentFrames) + 1;
+  }
+
+  /** @brief Length of the key array in 16-bit words. */
+  size_t
+   keyWords() const {
+   if (boneCount == 0 || frameCount == 0) return 0;
+   const size_t segments = segmentCount();
+   return ((segments - 1) * (segmentFrames + 1) + keysInSegment(segments - 1)) * boneCount * keyStride();
+  }
+
+  /** @brief Length of the range array in floats. */
+  size_t
+   rangeFloats() const {
+   return boneCount == 0 || frameCount == 0 ? 0 : segmentCount() * boneCount * rangeStride();
+  }
+ };
+
+ EU_ASSERT_VALUE_TYPE(AnimationClipLayout);
+
+ /**
+  * @class AnimationClipView
+  * @brief Read-only clip over key and range arrays it does not own, e.g. inside a mapped
+  * pack file; an AnimationClip samples through one.
+  */
+ class
+  AnimationClipView {
+  public:
+  AnimationClipView() : m_keys(nullptr), m_ranges(nullptr) {}
+
+  /** @brief View of layout.keyWords() keys and layout.rangeFloats() ranges. */
+  AnimationClipView(const AnimationClipLayout& layout, const uint16_t* keys, const float* ranges)
+   : m_layout(layout), m_keys(keys), m_ranges(ranges) {}
+
+  /**
+   * @brief Decodes and interpolates every bone at time seconds into out (boneCount() entries).
+   *
+   * time is clamped to [0, duration()]; wrap it first for looping playback.
+   */
+  template<typename Policy = EU::Precision::Default>
+  void
+   sample(float time, const PoseSoA& out) const {
+   if (empty()) return;
+   const size_t segmentFrames = m_layout.segmentFrames, boneCount = m_layout.boneCount;
+   const size_t segments = m_layout.segmentCount();
+   const float last = static_cast<float>(m_layout.frameCount - 1);
+   const float position = EngineMath::clamp(time * m_layout.sampleRate, 0.f, last);
+   const size_t frame = static_cast<size_t>(position);
+   const size_t segment = frame / segmentFrames < segments ? frame / segmentFrames : segments - 1;
+   const size_t keys = m_layout.keysInSegment(segment);
+   size_t k0 = frame - segment * segmentFrames;
+   if (keys > 1 && k0 >= keys - 1) k0 = keys - 2;
+   const float alpha = keys > 1 ? position - static_cast<float>(segment * segmentFrames + k0) : 0.f;
+   const size_t stride = m_layout.keyStride(), rangeStep = m_layout.rangeStride();
+   const size_t row = boneCount * stride;
+   const float* r = m_ranges + segment * boneCount * rangeStep;
+   const uint16_t* key0 = m_keys + (segment * (segmentFrames + 1) + k0) * row;
+   const uint16_t* key1 = keys > 1 ? key0 + row : key0;
+   for (size_t b = 0; b < boneCount; ++b, r += rangeStep, key0 += stride, key1 += stride) {
+    const Quaternion q0 = detail::unpackRotationKey<Policy>(key0);
+    const Quaternion q1 = detail::unpackRotationKey<Policy>(key1);
+    const float wb = q0.dot(q1) < 0.f ? -alpha : alpha, wa = 1.f - alpha;
+    const Quaternion q(q0.x * wa + q1.x * wb, q0.y * wa + q1.y * wb, q0.z * wa + q1.z * wb, q0.w * wa + q1.w * wb);
+    const float inv = Policy::invLength(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    out.rotations.x[b] = q.x * inv;
+    out.rotations.y[b] = q.y * inv;
+    out.rotations.z[b] = q.z * inv;
+    out.rotations.w[b] = q.w * inv;
+    const CVector3 t = lerpAxes(key0 + 3, key1 + 3, r, alpha);
+    out.translations.x[b] = t.x;
+    out.translations.y[b] = t.y;
+    out.translations.z[b] = t.z;
+    const CVector3 s = m_layout.hasScale ? lerpAxes(key0 + 6, key1 + 6, r + 6, alpha) : CVector3(1.f, 1.f, 1.f);
+    out.scales.x[b] = s.x;
+    out.scales.y[b] = s.y;
+    out.scales.z[b] = s.z;
+   }
+  }
+
+  /** @brief True when the clip has no bones or no frames. */
+  bool
+   empty() const {
+   return m_layout.boneCount == 0 || m_layout.frameCount == 0;
+  }
+
+  size_t
+   boneCount() const {
+   return m_layout.boneCount;
+  }
+
+  size_t
+   frameCount() const {
+   return m_layout.frameCount;
+  }
+
+  /** @brief Keys per second. */
+  float
+   sampleRate() const {
+   return m_layout.sampleRate;
+  }
+
+  /** @brief Time of the last key in seconds. */
+  float
+   duration() const {
+   return empty() ? 0.f : static_cast<float>(m_layout.frameCount - 1) / m_layout.sampleRate;
+  }
+
+  /** @brief True when the clip stores scale tracks. */
+  bool
+   hasScale() const {
+   return m_layout.hasScale != 0;
+  }
+
+  /** @brief Bytes of key and range data. */
+  size_t
+   sizeBytes() const {
+   return m_layout.keyWords() * sizeof(uint16_t) + m_layout.rangeFloats() * sizeof(float);
+  }
+
+  const AnimationClipLayout&
+   layout() const {
+   return m_layout;
+  }
+
+  /** @brief Segment after segment, frame-major within a segment. */
+  const uint16_t*
+   keys() const {
+   return m_keys;
+  }
+
+  /** @brief Per segment, per bone: translation then scale minimum and step. */
+  const float*
+   ranges() const {
+   return m_ranges;
+  }
+
+  private:
+  static CVector3
+   lerpAxes(const uint16_t* a, const uint16_t* b, const float* range, float alpha) {
+   float r[3] = {};
+   for (int i = 0; i < 3; ++i) {
+    const float va = range[i] + static_cast<float>(a[i]) * range[3 + i];
+    const float vb = range[i] + static_cast<float>(b[i]) * range[3 + i];
+    r[i] = va + (vb - va) * alpha;
+   }
+   return CVector3(r[0], r[1], r[2]);
+  }
+
+  AnimationClipLayout m_layout;
+  const uint16_t* m_keys;
+  const float* m_ranges;
+ };
+
+ /**
+  * @class AnimationClip
+  * @brief Quantized, segment-interleaved keys of one animation, sampled into a PoseSoA.
+  *
+  * Built once by compress() and read-only afterwards. An empty clip (no bones or no frames)
+  * samples to nothing.
+  */
+ class
+  AnimationClip {
+  public:
+  AnimationClip() {}
+
+  /**
+   * @brief Compresses frameCount keys of boneCount bones, sampled at sampleRate keys per second.
+   *
+   * The inputs are frame-major: bone b of frame f is at [f * boneCount + b]. Rotations are
+   * normalized first (a zero quaternion becomes the identity). scales may be null, in which
+   * case the clip stores none and samples them as 1. Returns an empty clip when boneCount,
+   * frameCount or segmentFrames is 0 or sampleRate is not positive.
+   */
+  static AnimationClip
+   compress(const Quaternion* rotations, const CVector3* translations, const CVector3* scales, size_t boneCount,
+            size_t frameCount, float sampleRate, size_t segmentFrames = CLIP_SEGMENT_FRAMES) {
+   AnimationClip clip;
+   if (boneCount == 0 || frameCount == 0 || segmentFrames == 0 || !(sampleRate > 0.f)) return clip;
+   AnimationClipLayout& layout = clip.m_layout;
+   layout.boneCount = static_cast<uint32_t>(boneCount);
+   layout.frameCount = static_cast<uint32_t>(frameCount);
+   layout.segmentFrames = static_cast<uint32_t>(segmentFrames);
+   layout.sampleRate = sampleRate;
+   layout.hasScale = scales != nullptr;
+   const size_t segments = layout.segmentCount();
+   const size_t stride = layout.keyStride(), rangeStep = layout.rangeStride();
+   clip.m_ranges.resize(layout.rangeFloats());
+   clip.m_keys.resize(layout.keyWords());
+   uint16_t* key = clip.m_keys.data();
+   for (size_t s = 0; s < segments; ++s) {
+    const size_t first = s * segmentFrames, keys = layout.keysInSegment(s);
+    float* ranges = clip.m_ranges.data() + s * boneCount * rangeStep;
+    for (size_t b = 0; b < boneCount; ++b) {
+     float* r = ranges + b * rangeStep;
+     segmentRange(translations + first * boneCount + b, boneCount, keys, r);
+     if (scales) segmentRange(scales + first * boneCount + b, boneCount, keys, r + 6);
+    }
+    for (size_t k = 0; k < keys; ++k) {
+     const size_t frame = (first + k) * boneCount;
+     for (size_t b = 0; b < boneCount; ++b, key += stride) {
+      const float* r = ranges + b * rangeStep;
+      detail::packRotationKey(rotations[frame + b].normalized<EU::Precision::Exact>(), key);
+      quantizeAxes(translations[frame + b], r, key + 3);
+      if (scales) quantizeAxes(scales[frame + b], r + 6, key + 6);
+     }
+    }
+   }
+   return clip;
+  }
+
+  /** @brief AnimationClipView::sample(). */
+  template<typename Policy = EU::Precision::Default>
+  void
+   sample(float time, const PoseSoA& out) const {
+   view().template sample<Policy>(time, out);
+  }
+
+  /** @brief Non-owning view of the keys, valid until the clip is destroyed or reassigned. */
+  AnimationClipView
+   view() const {
+   return AnimationClipView(m_layout, m_keys.data(), m_ranges.data());
+  }
+
+  /** @brief True when the clip has no bones or no frames. */
+  bool
+   empty() const {
+   return view().empty();
+  }
+
+  size_t
+   boneCount() const {
+   return m_layout.boneCount;
+  }
+
+  size_t
+   frameCount() const {
+   return m_layout.frameCount;
+  }
+
+  /** @brief Keys per second. */
+  float
+   sampleRate() const {
+   return m_layout.sampleRate;
+  }
+
+  /** @brief Time of the last key in seconds. */
+  float
+   duration() const {
+   return view().duration();
+  }
+
+  /** @brief True when the clip stores scale tracks. */
+  bool
+   hasScale() const {
+   return m_layout.hasScale != 0;
+  }
+
+  /** @brief Bytes of key and range data. */
+  size_t
+   sizeBytes() const {
+   return m_keys.size() * sizeof(uint16_t) + m_ranges.size() * sizeof(float);
+  }
+
+  private:
+  /** Minimum and step per axis of keys values[0], values[stride], ... (count of them). */
+  static void
+   segmentRange(const CVector3* values, size_t stride, size_t count, float* range) {
+   float lo[3] = { values[0].x, values[0].y, values[0].z }, hi[3] = { lo[0], lo[1], lo[2] };
+   for (size_t k = 1; k < count; ++k) {
+    const CVector3& v = values[k * stride];
+    const float c[3] = { v.x, v.y, v.z };
+    for (int a = 0; a < 3; ++a) {
+     lo[a] = c[a] < lo[a] ? c[a] : lo[a];
+     hi[a] = c[a] > hi[a] ? c[a] : hi[a];
+    }
+   }
+   for (int a = 0; a < 3; ++a) {
+    range[a] = lo[a];
+    range[3 + a] = (hi[a] - lo[a]) / detail::CLIP_RANGE_STEPS;
+   }
+  }
+
+  static void
+   quantizeAxes(const CVector3& v, const float* range, uint16_t* out) {
+   out[0] = detail::quantizeClipRange(v.x, range[0], range[3] * detail::CLIP_RANGE_STEPS);
+   out[1] = detail::quantizeClipRange(v.y, range[1], range[4] * detail::CLIP_RANGE_STEPS);
+   out[2] = detail::quantizeClipRange(v.z, range[2], range[5] * detail::CLIP_RANGE_STEPS);
+  }
+
+  std::vector<uint16_t> m_keys; ///< Segment after segment, frame-major within a segment
+  std::vector<float> m_ranges;  ///< Per segment, per bone: translation then scale minimum and step
+  AnimationClipLayout m_layout;
+ };
+}
@@ -0,0 +1,156 @@
+/**
+ * @file CameraMatrices.h
+ * @brief Perspective, orthographic and look-at matrices built together with their inverses.
+ *
+ * Every builder returns a CameraMatrix: the matrix and its analytic inverse, written from the
+ * same few terms, so unprojection and picking never go through Matrix4x4::inverse(). Field of
+ * view trig is one EngineMath::sincos() call.
+ *
+ * Conventions match the rest of the library: column vectors, right-handed view space with
+ * the camera looking down -Z. perspective() and orthographic() map depth to [-1, 1] like
+ * OpenGL. The reversed-Z variants map near to 1 and far (or infinity) to 0, for a [0, 1]
+ * depth range (glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE) or Vulkan) with a floating point
+ * depth buffer cleared to 0.
+ */
+
+#pragma once
+
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Matrices/Matrix4x4.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /**
+  * @struct CameraMatrix
+  * @brief A view or projection matrix and its inverse.
+  */
+ struct
+  CameraMatrix {
+  Matrix4x4 matrix;  ///< View or projection transform
+  Matrix4x4 inverse; ///< matrix.inverse(), computed in closed form
+ };
+
+ namespace detail {
+  /**
+   * The perspective shape shared by every variant: x and y scaled by cot(fovY / 2), clip
+   * z = depthScale * z + depthOffset and w = -z.
+   */
+  constexpr CameraMatrix
+   perspectiveMatrix(float fovY, float aspect, float depthScale, float depthOffset) {
+   float s = 0.f, c = 0.f;
+   EngineMath::sincos(fovY * 0.5f, &s, &c);
+   const float focal = c / s;
+   return CameraMatrix{
+    Matrix4x4(
+    focal / aspect, 0.f, 0.f, 0.f,
+    0.f, focal, 0.f, 0.f,
+    0.f, 0.f, depthScale, depthOffset,
+    0.f, 0.f, -1.f, 0.f
+    ),
+    Matrix4x4(
+    aspect / focal, 0.f, 0.f, 0.f,
+    0.f, s / c, 0.f, 0.f,
+    0.f, 0.f, 0.f, -1.f,
+    0.f, 0.f, 1.f / depthOffset, depthScale / depthOffset
+    )
+   };
+  }
+ }
+
+ /**
+  * @brief OpenGL style perspective projection, depth -1 at near and 1 at far.
+  * @param fovY Vertical field of view in radians, in (0, pi).
+  * @param aspect Width over height.
+  * @param zNear Distance to the near plane, > 0.
+  * @param zFar Distance to the far plane, > zNear.
+  */
+ constexpr CameraMatrix
+  perspective(float fovY, float aspect, float zNear, float zFar) {
+  return detail::perspectiveMatrix(fovY, aspect, (zFar + zNear) / (zNear - zFar),
+                                   2.f * zFar * zNear / (zNear - zFar));
+ }
+
+ /**
+  * @brief Reversed-Z perspective projection: depth 1 at near and 0 at far.
+  *
+  * Floating point depth is densest near 0, which this puts at the far plane where a
+  * standard projection loses the most precision.
+  */
+ constexpr CameraMatrix
+  perspectiveReversedZ(float fovY, float aspect, float zNear, float zFar) {
+  return detail::perspectiveMatrix(fovY, aspect, zNear / (zFar - zNear), zFar * zNear / (zFar - zNear));
+ }
+
+ /**
+  * @brief perspective() with the far plane at infinity: depth -1 at near, approaching 1.
+  */
+ constexpr CameraMatrix
+  perspectiveInfinite(float fovY, float aspect, float zNear) {
+  return detail::perspectiveMatrix(fovY, aspect, -1.f, -2.f * zNear);
+ }
+
+ /**
+  * @brief Reversed-Z perspective with the far plane at infinity: depth 1 at near,
+  * approaching 0. The usual choice for large open scenes.
+  */
+ constexpr CameraMatrix
+  perspectiveInfiniteReversedZ(float fovY, float aspect, float zNear) {
+  return detail::perspectiveMatrix(fovY, aspect, 0.f, zNear);
+ }
+
+ /**
+  * @brief OpenGL style orthographic projection of the box [left, right] x [bottom, top] x
+  * [-zNear, -zFar] onto [-1, 1] on every axis.
+  */
+ constexpr CameraMatrix
+  orthographic(float left, float right, float bottom, float top, float zNear, float zFar) {
+  const float width = right - left, height = top - bottom, depth = zFar - zNear;
+  return CameraMatrix{
+   Matrix4x4(
+   2.f / width, 0.f, 0.f, -(right + left) / width,
+   0.f, 2.f / height, 0.f, -(top + bottom) / height,
+   0.f, 0.f, -2.f / depth, -(zFar + zNear) / depth,
+   0.f, 0.f, 0.f, 1.f
+   ),
+   Matrix4x4(
+   width * 0.5f, 0.f, 0.f, (right + left) * 0.5f,
+   0.f, height * 0.5f, 0.f, (top + bottom) * 0.5f,
+   0.f, 0.f, depth * -0.5f, (zFar + zNear) * -0.5f,
+   0.f, 0.f, 0.f, 1.f
+   )
+  };
+ }
+
+ /**
+  * @brief Right-handed view matrix of a camera at eye looking at target.
+  *
+  * The inverse is the camera's world transform (the rotation transposed plus eye as the
+  * translation). Returns identity for both when eye == target or up is parallel to the view
+  * direction.
+  */
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 CameraMatrix
+  lookAt(const CVector3& eye, const CVector3& target, const CVector3& up) {
+  const CVector3 f = (target - eye).normalized<Policy>();
+  const CVector3 s = f.cross(up).normalized<Policy>();
+  if (s.lengthSquared() == 0.f) {
+   return CameraMatrix{ Matrix4x4::identity(), Matrix4x4::identity() };
+  }
+  const CVector3 u = s.cross(f);
+  return CameraMatrix{
+   Matrix4x4(
+   s.x, s.y, s.z, -s.dot(eye),
+   u.x, u.y, u.z, -u.dot(eye),
+   -f.x, -f.y, -f.z, f.dot(eye),
+   0.f, 0.f, 0.f, 1.f
+   ),
+   Matrix4x4(
+   s.x, u.x, -f.x, eye.x,
+   s.y, u.y, -f.y, eye.y,
+   s.z, u.z, -f.z, eye.z,
+   0.f, 0.f, 0.f, 1.f
+   )
+  };
+ }
+}
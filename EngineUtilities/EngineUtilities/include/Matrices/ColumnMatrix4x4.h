@@ -0,0 +1,216 @@
+/**
+ * @file ColumnMatrix4x4.h
+ * @brief Column-major, cache-line aligned twin of Matrix4x4 for GPU upload.
+ *
+ * Matrix4x4 keeps its rows contiguous; GLSL, sf::Glsl::Mat4 and Vulkan expect columns.
+ * ColumnMatrix4x4 holds the same matrix with each column contiguous, so its 64 bytes are
+ * exactly what glUniformMatrix4fv or a std140/std430 mat4 wants and an array of them can be
+ * uploaded as-is (see MatrixSFML.h). Each one sits on its own 64-byte cache line.
+ *
+ * The math convention does not change: column vectors, translation in column 3. Convert once
+ * when a matrix (or a whole palette with toColumnMajor()) is built rather than transposing
+ * on every upload.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/Matrix4x4.h>
+#include <Vectors/Vector4.h>
+
+namespace EU {
+
+ /**
+  * @class ColumnMatrix4x4
+  * @brief 4x4 matrix stored column by column; m[col][fil] is row fil of column col.
+  */
+ class alignas(64)
+  ColumnMatrix4x4 {
+  public:
+  float m[4][4]; ///< Matrix elements in column-major order
+
+  /**
+   * @brief Default constructor. Initializes to identity matrix.
+   */
+  constexpr ColumnMatrix4x4()
+   : m{ { 1.f, 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f, 0.f }, { 0.f, 0.f, 1.f, 0.f }, { 0.f, 0.f, 0.f, 1.f } } {}
+
+  /**
+   * @brief Leaves every element uninitialized; see EU::NoInit.
+   */
+  explicit ColumnMatrix4x4(EU::NoInitTag) {}
+
+  /**
+   * @brief Same matrix as mat, stored by columns.
+   */
+  explicit constexpr ColumnMatrix4x4(const Matrix4x4& mat)
+   : m{ { mat.m[0][0], mat.m[1][0], mat.m[2][0], mat.m[3][0] },
+        { mat.m[0][1], mat.m[1][1], mat.m[2][1], mat.m[3][1] },
+        { mat.m[0][2], mat.m[1][2], mat.m[2][2], mat.m[3][2] },
+        { mat.m[0][3], mat.m[1][3], mat.m[2][3], mat.m[3][3] } } {}
+
+  /**
+   * @brief Same transform as affine, with bottom row (0, 0, 0, 1).
+   */
+  explicit constexpr ColumnMatrix4x4(const Affine3x4& affine)
+   : m{ { affine.m[0][0], affine.m[1][0], affine.m[2][0], 0.f },
+        { affine.m[0][1], affine.m[1][1], affine.m[2][1], 0.f },
+        { affine.m[0][2], affine.m[1][2], affine.m[2][2], 0.f },
+        { affine.m[0][3], affine.m[1][3], affine.m[2][3], 1.f } } {}
+
+  /**
+   * @brief Back to the row-major Matrix4x4.
+   */
+  constexpr Matrix4x4
+   toMatrix4x4() const {
+   return Matrix4x4(
+   m[0][0], m[1][0], m[2][0], m[3][0],
+   m[0][1], m[1][1], m[2][1], m[3][1],
+   m[0][2], m[1][2], m[2][2], m[3][2],
+   m[0][3], m[1][3], m[2][3], m[3][3]
+   );
+  }
+
+  /**
+   * @brief Matrix product, column j = this * column j of otro.
+   *
+   * The same products and left-to-right sums as Matrix4x4::operator*, so converting the
+   * operands first or the result afterwards gives the same bits.
+   */
+  EU_CONSTEXPR20 ColumnMatrix4x4
+   operator*(const ColumnMatrix4x4& otro) const {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+   if (std::is_constant_evaluated()) {
+    return multiplyScalar(otro);
+   }
+#endif
+#if defined(EU_SIMD_SSE2) || defined(EU_SIMD_NEON)
+   using EU::SIMD::Float4;
+   ColumnMatrix4x4 r(EU::NoInit);
+   const Float4 a0 = Float4::loadAligned(m[0]), a1 = Float4::loadAligned(m[1]);
+   const Float4 a2 = Float4::loadAligned(m[2]), a3 = Float4::loadAligned(m[3]);
+   for (int col = 0; col < 4; ++col) {
+    const Float4 b = Float4::loadAligned(otro.m[col]);
+    Float4 acc = a0 * EU::SIMD::shuffle<0, 0, 0, 0>(b);
+    acc = EU::SIMD::madd(a1, EU::SIMD::shuffle<1, 1, 1, 1>(b), acc);
+    acc = EU::SIMD::madd(a2, EU::SIMD::shuffle<2, 2, 2, 2>(b), acc);
+    acc = EU::SIMD::madd(a3, EU::SIMD::shuffle<3, 3, 3, 3>(b), acc);
+    acc.storeAligned(r.m[col]);
+   }
+   return r;
+#else
+   return multiplyScalar(otro);
+#endif
+  }
+
+  /**
+   * @brief Transforms a 4D vector.
+   */
+  constexpr CVector4
+   operator*(const CVector4& vec) const {
+   return CVector4(
+   m[0][0] * vec.x + m[1][0] * vec.y + m[2][0] * vec.z + m[3][0] * vec.w,
+   m[0][1] * vec.x + m[1][1] * vec.y + m[2][1] * vec.z + m[3][1] * vec.w,
+   m[0][2] * vec.x + m[1][2] * vec.y + m[2][2] * vec.z + m[3][2] * vec.w,
+   m[0][3] * vec.x + m[1][3] * vec.y + m[2][3] * vec.z + m[3][3] * vec.w
+   );
+  }
+
+  /**
+   * @brief Element at row fil, column col, indexed like Matrix4x4.
+   */
+  constexpr float&
+   operator()(int fil, int col) {
+   return m[col][fil];
+  }
+
+  /**
+   * @brief Const element at row fil, column col.
+   */
+  constexpr const float&
+   operator()(int fil, int col) const {
+   return m[col][fil];
+  }
+
+  /**
+   * @brief The 16 floats in upload order.
+   */
+  constexpr const float*
+   data() const {
+   return &m[0][0];
+  }
+
+  /**
+   * @brief True when every element is within epsilon of otro's.
+   */
+  constexpr bool
+   approxEqual(const ColumnMatrix4x4& otro, float epsilon = EU::Constants::EPSILON) const {
+   for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+     if (!EngineMath::approxEqual(m[i][j], otro.m[i][j], epsilon)) return false;
+   return true;
+  }
+
+  /**
+   * @brief Returns an identity matrix.
+   */
+  static constexpr ColumnMatrix4x4
+   identity() {
+   return ColumnMatrix4x4();
+  }
+
+  private:
+  /** Scalar product with the same accumulation as the SIMD path. */
+  constexpr ColumnMatrix4x4
+   multiplyScalar(const ColumnMatrix4x4& otro) const {
+   ColumnMatrix4x4 r;
+   for (int col = 0; col < 4; ++col)
+    for (int fil = 0; fil < 4; ++fil)
+     r.m[col][fil] = ((m[0][fil] * otro.m[col][0] + m[1][fil] * otro.m[col][1])
+                      + m[2][fil] * otro.m[col][2]) + m[3][fil] * otro.m[col][3];
+   return r;
+  }
+ };
+
+ static_assert(sizeof(ColumnMatrix4x4) == 16 * sizeof(float), "ColumnMatrix4x4 must be 16 packed floats");
+ static_assert(alignof(ColumnMatrix4x4) == 64, "ColumnMatrix4x4 must start a cache line");
+ EU_ASSERT_VALUE_TYPE(ColumnMatrix4x4);
+
+ /**
+  * @brief out[i] = in[i] in column-major order, four rows transposed per register pass.
+  */
+ inline void
+  toColumnMajor(const Matrix4x4* in, ColumnMatrix4x4* out, size_t n) {
+  using EU::SIMD::Float4;
+  for (size_t i = 0; i < n; ++i) {
+   Float4 r0 = Float4::load(in[i].m[0]), r1 = Float4::load(in[i].m[1]);
+   Float4 r2 = Float4::load(in[i].m[2]), r3 = Float4::load(in[i].m[3]);
+   EU::SIMD::transpose(r0, r1, r2, r3);
+   r0.storeAligned(out[i].m[0]);
+   r1.storeAligned(out[i].m[1]);
+   r2.storeAligned(out[i].m[2]);
+   r3.storeAligned(out[i].m[3]);
+  }
+ }
+
+ /**
+  * @brief out[i] = in[i] expanded to a column-major 4x4, e.g. a bone palette before upload.
+  */
+ inline void
+  toColumnMajor(const Affine3x4* in, ColumnMatrix4x4* out, size_t n) {
+  using EU::SIMD::Float4;
+  const float bottom[4] = { 0.f, 0.f, 0.f, 1.f };
+  for (size_t i = 0; i < n; ++i) {
+   Float4 r0 = Float4::load(in[i].m[0]), r1 = Float4::load(in[i].m[1]);
+   Float4 r2 = Float4::load(in[i].m[2]), r3 = Float4::load(bottom);
+   EU::SIMD::transpose(r0, r1, r2, r3);
+   r0.storeAligned(out[i].m[0]);
+   r1.storeAligned(out[i].m[1]);
+   r2.storeAligned(out[i].m[2]);
+   r3.storeAligned(out[i].m[3]);
+  }
+ }
+}
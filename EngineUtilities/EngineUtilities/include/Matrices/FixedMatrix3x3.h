@@ -0,0 +1,193 @@
+#pragma once
+
+#include <Math/Fixed.h>
+#include <Vectors/FixedVector.h>
+#include <Matrices/Matrix3x3.h>
+
+namespace EU {
+
+ /**
+  * @class FixedMatrix3x3
+  * @brief Q16.16 counterpart of Matrix3x3 for deterministic 2D transforms.
+  *
+  * Same row-major layout and multiplication order as Matrix3x3. Products are accumulated
+  * in 64 bits and rounded once per element, so chains of transforms lose less precision
+  * than multiplying Fixed values term by term.
+  */
+ class
+  FixedMatrix3x3 {
+  public:
+  Fixed m[3][3]; ///< Matrix elements in row-major order
+
+  /**
+   * @brief Default constructor. Initializes to identity matrix.
+   */
+  constexpr FixedMatrix3x3() : m{} {
+   setIdentity();
+  }
+
+  /**
+   * @brief Constructs a matrix with given element values.
+   */
+  constexpr FixedMatrix3x3(Fixed m00, Fixed m01, Fixed m02,
+                           Fixed m10, Fixed m11, Fixed m12,
+                           Fixed m20, Fixed m21, Fixed m22)
+   : m{ { m00, m01, m02 },
+        { m10, m11, m12 },
+        { m20, m21, m22 } } {
+  }
+
+  /**
+   * @brief Converts a float matrix, rounding each element to the nearest step.
+   */
+  constexpr explicit FixedMatrix3x3(const Matrix3x3& f) : m{} {
+   for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+     m[i][j] = Fixed(f.m[i][j]);
+  }
+
+  /** @brief Converts back to a float matrix. */
+  constexpr Matrix3x3
+   toFloat() const {
+   Matrix3x3 r;
+   for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+     r.m[i][j] = m[i][j].toFloat();
+   return r;
+  }
+
+  /**
+   * @brief Multiplies this matrix by another matrix.
+   */
+  constexpr FixedMatrix3x3
+   operator*(const FixedMatrix3x3& otro) const {
+   FixedMatrix3x3 r;
+   for (int fil = 0; fil < 3; ++fil)
+    for (int col = 0; col < 3; ++col)
+     r.m[fil][col] = dot3(m[fil][0], m[fil][1], m[fil][2],
+                          otro.m[0][col], otro.m[1][col], otro.m[2][col]);
+   return r;
+  }
+
+  /**
+   * @brief Transforms a 2D point using homogeneous coordinates (w = 1).
+   */
+  constexpr FixedVector2
+   operator*(const FixedVector2& vec) const {
+   Fixed one = Fixed::one();
+   Fixed x = dot3(m[0][0], m[0][1], m[0][2], vec.x, vec.y, one);
+   Fixed y = dot3(m[1][0], m[1][1], m[1][2], vec.x, vec.y, one);
+   Fixed w = dot3(m[2][0], m[2][1], m[2][2], vec.x, vec.y, one);
+   if (w != one && w.raw != 0) {
+    x /= w;
+    y /= w;
+   }
+   return FixedVector2(x, y);
+  }
+
+  /**
+   * @brief Transforms a 3D vector.
+   */
+  constexpr FixedVector3
+   operator*(const FixedVector3& vec) const {
+   return FixedVector3(
+   dot3(m[0][0], m[0][1], m[0][2], vec.x, vec.y, vec.z),
+   dot3(m[1][0], m[1][1], m[1][2], vec.x, vec.y, vec.z),
+   dot3(m[2][0], m[2][1], m[2][2], vec.x, vec.y, vec.z)
+   );
+  }
+
+  constexpr bool
+   operator==(const FixedMatrix3x3& otro) const {
+   for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+     if (m[i][j] != otro.m[i][j]) return false;
+   return true;
+  }
+
+  /**
+   * @brief Accesses an element of the matrix.
+   */
+  constexpr Fixed&
+   operator()(int fil, int col) {
+   return m[fil][col];
+  }
+
+  /**
+   * @brief Const access to an element of the matrix.
+   */
+  constexpr const Fixed&
+   operator()(int fil, int col) const {
+   return m[fil][col];
+  }
+
+  /**
+   * @brief Returns the transposed version of the matrix.
+   */
+  constexpr FixedMatrix3x3
+   transpose() const {
+   return FixedMatrix3x3(
+   m[0][0], m[1][0], m[2][0],
+   m[0][1], m[1][1], m[2][1],
+   m[0][2], m[1][2], m[2][2]
+   );
+  }
+
+  /**
+   * @brief Sets this matrix to identity.
+   */
+  constexpr void
+   setIdentity() {
+   for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+     m[i][j] = (i == j) ? Fixed::one() : Fixed::zero();
+  }
+
+  /**
+   * @brief Returns an identity matrix.
+   */
+  static constexpr FixedMatrix3x3
+   identity() {
+   return FixedMatrix3x3();
+  }
+
+  /**
+   * @brief 2D rotation about the origin, angle in radians (table sin/cos).
+   */
+  static constexpr FixedMatrix3x3
+   rotation(Fixed radians) {
+   Fixed s, c;
+   EngineMath::sincos(radians, &s, &c);
+   return FixedMatrix3x3(
+   c, -s, Fixed::zero(),
+   s, c, Fixed::zero(),
+   Fixed::zero(), Fixed::zero(), Fixed::one()
+   );
+  }
+
+  /**
+   * @brief 2D translation.
+   */
+  static constexpr FixedMatrix3x3
+   translation(Fixed tx, Fixed ty) {
+   return FixedMatrix3x3(
+   Fixed::one(), Fixed::zero(), tx,
+   Fixed::zero(), Fixed::one(), ty,
+   Fixed::zero(), Fixed::zero(), Fixed::one()
+   );
+  }
+
+  private:
+  /** a0 * b0 + a1 * b1 + a2 * b2 accumulated in Q32.32 and rounded once. */
+  static constexpr Fixed
+   dot3(Fixed a0, Fixed a1, Fixed a2, Fixed b0, Fixed b1, Fixed b2) {
+   int64_t sum = static_cast<int64_t>(a0.raw) * b0.raw +
+                 static_cast<int64_t>(a1.raw) * b1.raw +
+                 static_cast<int64_t>(a2.raw) * b2.raw;
+   sum += int64_t(1) << (Fixed::FRACTION_BITS - 1);
+   return Fixed::fromRaw(static_cast<int32_t>(sum >> Fixed::FRACTION_BITS));
+  }
+ };
+
+ EU_ASSERT_VALUE_TYPE(FixedMatrix3x3);
+}
@@ -0,0 +1,460 @@
+/**
+ * @file InverseKinematics.h
+ * @brief FABRIK and CCD inverse kinematics for many independent joint chains, a register of
+ * chains at a time, with swing-twist joint limits.
+ *
+ * IKChains holds a set of chains that all have the same number of joints: a root transform,
+ * and per joint a local rotation (relative to its parent joint, or to the root for joint 0)
+ * and a bone offset in the joint's own frame, which places the next joint (or, for the last
+ * joint, the tip). Everything is stored SoA with the chains innermost, so joint j of
+ * BATCH_WIDTH neighbouring chains fills one register per component and each lane of the
+ * solvers is one chain. A leg of hip, knee and ankle is a three-joint chain whose tip is the
+ * foot's contact point.
+ *
+ * FABRIK (Aristidou and Lasenby) alternates a backward pass, pulling the tip onto the target,
+ * with a forward pass that pins the root again, keeping every bone length. The positions are
+ * then turned back into local rotations joint by joint, each the shortest arc from the bone's
+ * current direction to its solved one, so twist is never introduced. CCD rotates each joint,
+ * from the tip towards the root, by the shortest arc taking the tip towards the target. With
+ * limits set, each solved local rotation goes through clampSwingTwist() (the lane version)
+ * before the joints below it are placed, inside every iteration.
+ *
+ * Both run at most IKSettings::iterations iterations and stop early once the tip of every
+ * chain of the register is within tolerance of its target; an unreachable target leaves the
+ * chain stretched towards it. Registers are independent, so solve() splits them over threads
+ * or the JobSystem and the result does not depend on the split.
+ *
+ *   IKChains legs(count, 3);
+ *   legs.setBone(c, 0, CVector3(0.f, -0.45f, 0.f)); // per chain and joint, once
+ *   legs.setLimit(c, 1, JointLimit::fromAngles(axis, 0.05f, 0.f, 2.4f));
+ *   legs.setRoot(c, hipPosition, pelvisRotation);   // per frame
+ *   legs.setTarget(c, footTarget);
+ *   legs.solve(IKSettings(), jobs);
+ *   const Quaternion knee = legs.rotation(c, 1);
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/JobSystem.h>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Core/Trace.h>
+#include <Math/Precision.h>
+#include <Matrices/PoseBlend.h>
+#include <Rotations/Quaternion.h>
+#include <Rotations/SwingTwist.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Most joints per chain.
+ constexpr size_t IK_MAX_JOINTS = 16;
+ /// Chains per solver task; a multiple of every BATCH_WIDTH.
+ constexpr size_t IK_CHUNK = 64;
+ /// Sets with fewer chains are solved on the calling thread.
+ constexpr size_t IK_PARALLEL_MIN = 512;
+
+ enum class IKAlgorithm {
+  FABRIK,
+  CCD
+ };
+
+ /**
+  * @struct IKSettings
+  * @brief Solver choice and stopping rule of one IKChains::solve().
+  */
+ struct IKSettings {
+  IKAlgorithm algorithm = IKAlgorithm::FABRIK;
+  uint32_t iterations = 10; ///< Upper bound on iterations
+  float tolerance = 1e-3f;  ///< Tip-to-target distance at which a register of chains stops
+ };
+
+ namespace detail {
+  using IKVector = BatchLanes[3];
+  using IKRotation = BatchLanes[4];
+
+  inline void
+   crossLanes(const BatchLanes* a, const BatchLanes* b, BatchLanes* out) {
+   const BatchLanes x = a[1] * b[2] - a[2] * b[1];
+   const BatchLanes y = a[2] * b[0] - a[0] * b[2];
+   const BatchLanes z = a[0] * b[1] - a[1] * b[0];
+   out[0] = x;
+   out[1] = y;
+   out[2] = z;
+  }
+
+  /** out = q v q^-1 for unit q: v + w t + q.xyz x t with t = 2 q.xyz x v. */
+  inline void
+   rotateLanes(const IKRotation& q, const BatchLanes* v, BatchLanes* out) {
+   IKVector t, u;
+   crossLanes(q, v, t);
+   for (int c = 0; c < 3; ++c) t[c] = t[c] + t[c];
+   crossLanes(q, t, u);
+   for (int c = 0; c < 3; ++c) out[c] = v[c] + q[3] * t[c] + u[c];
+  }
+
+  /** Scales v to unit length; returns the mask of lanes that had a length. */
+  template<typename Policy>
+  inline BatchLanes
+   normalizeLanes(BatchLanes* v) {
+   const BatchLanes lenSq = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+   const BatchLanes valid = lenSq > BatchLanes::set1(1e-20f);
+   const BatchLanes inv = Policy::invLengthLanes(EU::SIMD::select(valid, lenSq, BatchLanes::set1(1.f))) & valid;
+   for (int c = 0; c < 3; ++c) v[c] = v[c] * inv;
+   return valid;
+  }
+
+  /**
+   * Shortest-arc rotation from unit a to unit b; lanes outside valid get the identity.
+   * Opposite directions turn half a turn about an axis perpendicular to a.
+   */
+  template<typename Policy>
+  inline void
+   arcLanes(const BatchLanes* a, const BatchLanes* b, BatchLanes valid, IKRotation& out) {
+   const BatchLanes zero = BatchLanes::zero(), one = BatchLanes::set1(1.f);
+   crossLanes(a, b, out);
+   out[3] = one + a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+   const BatchLanes opposite = out[3] < BatchLanes::set1(1e-6f);
+   if (EU::SIMD::any(opposite)) {
+    // a x X, or a x Y when a is close to X.
+    const BatchLanes useY = EU::SIMD::abs(a[0]) > BatchLanes::set1(0.9f);
+    const BatchLanes px = EU::SIMD::select(useY, zero - a[2], zero);
+    const BatchLanes py = EU::SIMD::select(useY, zero, a[2]);
+    const BatchLanes pz = EU::SIMD::select(useY, a[0], zero - a[1]);
+    out[0] = EU::SIMD::select(opposite, px, out[0]);
+    out[1] = EU::SIMD::select(opposite, py, out[1]);
+    out[2] = EU::SIMD::select(opposite, pz, out[2]);
+    out[3] = EU::SIMD::select(opposite, zero, out[3]);
+   }
+   normalizeRotationLanes<Policy>(out);
+   for (int c = 0; c < 3; ++c) out[c] = out[c] & valid;
+   out[3] = EU::SIMD::select(valid, out[3], one);
+  }
+
+  inline void
+   conjugateLanes(const IKRotation& q, IKRotation& out) {
+   out[0] = BatchLanes::zero() - q[0];
+   out[1] = BatchLanes::zero() - q[1];
+   out[2] = BatchLanes::zero() - q[2];
+   out[3] = q[3];
+  }
+ }
+
+ /**
+  * @class IKChains
+  * @brief A set of equally long joint chains and their targets, solved together.
+  */
+ class
+  IKChains {
+  public:
+  IKChains() = default;
+
+  IKChains(size_t chains, size_t joints) {
+   resize(chains, joints);
+  }
+
+  /**
+   * @brief Resizes to chains chains of joints joints (at most IK_MAX_JOINTS): identity
+   * rotations, zero bones, roots at the origin and no limits.
+   */
+  void
+   resize(size_t chains, size_t joints) {
+   m_chains = chains;
+   m_joints = joints < IK_MAX_JOINTS ? joints : IK_MAX_JOINTS;
+   m_stride = (chains + IK_CHUNK - 1) / IK_CHUNK * IK_CHUNK;
+   for (int c = 0; c < 4; ++c) {
+    m_rotation[c].assign(m_joints * m_stride, c == 3 ? 1.f : 0.f);
+    m_rootRotation[c].assign(m_stride, c == 3 ? 1.f : 0.f);
+   }
+   for (int c = 0; c < 3; ++c) {
+    m_bone[c].assign(m_joints * m_stride, 0.f);
+    m_position[c].assign((m_joints + 1) * m_stride, 0.f);
+    m_rootPosition[c].assign(m_stride, 0.f);
+    m_target[c].assign(m_stride, 0.f);
+   }
+   m_limits.clear();
+   m_error.assign(m_stride, 0.f);
+  }
+
+  size_t
+   chains() const {
+   return m_chains;
+  }
+
+  size_t
+   joints() const {
+   return m_joints;
+  }
+
+  /** @brief World transform the chain hangs from: joint 0 sits at position. */
+  void
+   setRoot(size_t chain, const CVector3& position, const Quaternion& rotation = Quaternion()) {
+   setVector(m_rootPosition, chain, position);
+   setQuaternion(m_rootRotation, chain, rotation);
+  }
+
+  /** @brief Offset from joint to the next joint (the tip after the last), in joint's frame. */
+  void
+   setBone(size_t chain, size_t joint, const CVector3& offset) {
+   setVector(m_bone, joint * m_stride + chain, offset);
+  }
+
+  /** @brief Local rotation of joint; also the starting pose of the next solve(). */
+  void
+   setRotation(size_t chain, size_t joint, const Quaternion& local) {
+   setQuaternion(m_rotation, joint * m_stride + chain, local);
+  }
+
+  /** @brief Swing-twist limit of joint's local rotation; chains without any are unlimited. */
+  void
+   setLimit(size_t chain, size_t joint, const JointLimit& limit) {
+   if (m_limits.empty()) {
+    m_limits.assign(m_joints * m_stride, JointLimit{ CVector3(0.f, 0.f, 1.f), 0.f, 1.f, 0.f, -1.f, 0.f, 1.f });
+   }
+   m_limits[joint * m_stride + chain] = limit;
+  }
+
+  void
+   setTarget(size_t chain, const CVector3& target) {
+   setVector(m_target, chain, target);
+  }
+
+  /** @brief Local rotation of joint, solved by the last solve(). */
+  Quaternion
+   rotation(size_t chain, size_t joint) const {
+   const size_t i = joint * m_stride + chain;
+   return Quaternion(m_rotation[0][i], m_rotation[1][i], m_rotation[2][i], m_rotation[3][i]);
+  }
+
+  /** @brief World position of joint (joints() for the tip) after the last solve(). */
+  CVector3
+   position(size_t chain, size_t joint) const {
+   const size_t i = joint * m_stride + chain;
+   return CVector3(m_position[0][i], m_position[1][i], m_position[2][i]);
+  }
+
+  /** @brief Distance from the tip to the target after the last solve(). */
+  float
+   error(size_t chain) const {
+   return m_error[chain];
+  }
+
+  /**
+   * @brief Solves every chain on up to threads threads (0 = hardware_concurrency(), 1 =
+   * caller only); small sets stay on the caller.
+   */
+  template<typename Policy = EU::Precision::Default>
+  void
+   solve(const IKSettings& settings = IKSettings(), size_t threads = 0) {
+   EU_TRACE_ZONE("IKChains::solve");
+   const size_t tasks = m_stride / IK_CHUNK;
+   threads = m_chains < IK_PARALLEL_MIN ? 1 : detail::resolveThreads(threads, tasks);
+   detail::parallelTasks(tasks, threads, [&](size_t t) { solveRange<Policy>(t * IK_CHUNK, (t + 1) * IK_CHUNK, settings); });
+  }
+
+  /** @brief Solves every chain on the workers of jobs, IK_CHUNK chains per job. */
+  template<typename Policy = EU::Precision::Default>
+  void
+   solve(const IKSettings& settings, JobSystem& jobs) {
+   EU_TRACE_ZONE("IKChains::solve");
+   jobs.parallelFor(0, m_stride / IK_CHUNK, 1, [&](size_t first, size_t last) {
+    solveRange<Policy>(first * IK_CHUNK, last * IK_CHUNK, settings);
+   });
+  }
+
+  private:
+  using V = detail::BatchLanes;
+
+  void
+   setVector(std::vector<float> (&soa)[3], size_t i, const CVector3& v) {
+   soa[0][i] = v.x;
+   soa[1][i] = v.y;
+   soa[2][i] = v.z;
+  }
+
+  void
+   setQuaternion(std::vector<float> (&soa)[4], size_t i, const Quaternion& q) {
+   soa[0][i] = q.x;
+   soa[1][i] = q.y;
+   soa[2][i] = q.z;
+   soa[3][i] = q.w;
+  }
+
+  /** Register-local state of BATCH_WIDTH chains. */
+  struct Lanes {
+   detail::IKRotation root;
+   detail::IKVector rootPosition;
+   detail::IKVector target;
+   detail::IKRotation local[IK_MAX_JOINTS];
+   detail::IKRotation world[IK_MAX_JOINTS];
+   detail::IKVector bone[IK_MAX_JOINTS];
+   V length[IK_MAX_JOINTS];
+   detail::IKVector p[IK_MAX_JOINTS + 1];
+   detail::JointLimitLanes limit[IK_MAX_JOINTS];
+  };
+
+  template<typename Policy>
+  void
+   solveRange(size_t begin, size_t end, const IKSettings& settings) {
+   Lanes l;
+   for (size_t c = begin; c < end && c < m_chains; c += detail::BATCH_WIDTH) solveRegister<Policy>(l, c, settings);
+  }
+
+  /** Local rotation of joint j, as world = parent * local, composed back from a world delta. */
+  template<typename Policy>
+  void
+   applyDelta(Lanes& l, size_t j, const detail::IKRotation& delta) const {
+   const detail::IKRotation& parent = j == 0 ? l.root : l.world[j - 1];
+   detail::IKRotation inverse, rotated, local;
+   detail::multiplyRotationLanes(delta, l.world[j], rotated);
+   detail::conjugateLanes(parent, inverse);
+   detail::multiplyRotationLanes(inverse, rotated, local);
+   detail::normalizeRotationLanes<Policy>(local);
+   if (m_limits.empty()) {
+    for (int c = 0; c < 4; ++c) l.local[j][c] = local[c];
+   }
+   else {
+    detail::clampSwingTwistLanes<Policy>(local, l.limit[j], l.local[j]);
+   }
+  }
+
+  /** World rotation of joint j and the position of the joint after it. */
+  void
+   place(Lanes& l, size_t j) const {
+   detail::multiplyRotationLanes(j == 0 ? l.root : l.world[j - 1], l.local[j], l.world[j]);
+   detail::IKVector offset;
+   detail::rotateLanes(l.world[j], l.bone[j], offset);
+   for (int c = 0; c < 3; ++c) l.p[j + 1][c] = l.p[j][c] + offset[c];
+  }
+
+  /** place() of joints from..m_joints - 1, down to the tip. */
+  void
+   forward(Lanes& l, size_t from) const {
+   for (size_t j = from; j < m_joints; ++j) place(l, j);
+  }
+
+  /** Squared tip-to-target distance. */
+  V
+   errorSq(const Lanes& l) const {
+   V d[3];
+   for (int c = 0; c < 3; ++c) d[c] = l.p[m_joints][c] - l.target[c];
+   return d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+  }
+
+  /** Re-derives local rotations from FABRIK's positions, clamping and re-placing joint by joint. */
+  template<typename Policy>
+  void
+   fitRotations(Lanes& l) const {
+   for (size_t j = 0; j < m_joints; ++j) {
+    detail::multiplyRotationLanes(j == 0 ? l.root : l.world[j - 1], l.local[j], l.world[j]);
+    V current[3], wanted[3];
+    detail::rotateLanes(l.world[j], l.bone[j], current);
+    for (int c = 0; c < 3; ++c) wanted[c] = l.p[j + 1][c] - l.p[j][c];
+    const V valid = detail::normalizeLanes<Policy>(current) & detail::normalizeLanes<Policy>(wanted);
+    detail::IKRotation delta;
+    detail::arcLanes<Policy>(current, wanted, valid, delta);
+    applyDelta<Policy>(l, j, delta);
+    place(l, j);
+   }
+  }
+
+  template<typename Policy>
+  void
+   iterateFabrik(Lanes& l) const {
+   const size_t J = m_joints;
+   for (int c = 0; c < 3; ++c) l.p[J][c] = l.target[c];
+   for (size_t j = J; j-- > 0;) {
+    V d[3];
+    for (int c = 0; c < 3; ++c) d[c] = l.p[j][c] - l.p[j + 1][c];
+    detail::normalizeLanes<Policy>(d);
+    for (int c = 0; c < 3; ++c) l.p[j][c] = EU::SIMD::madd(d[c], l.length[j], l.p[j + 1][c]);
+   }
+   for (int c = 0; c < 3; ++c) l.p[0][c] = l.rootPosition[c];
+   for (size_t j = 0; j < J; ++j) {
+    V d[3];
+    for (int c = 0; c < 3; ++c) d[c] = l.p[j + 1][c] - l.p[j][c];
+    detail::normalizeLanes<Policy>(d);
+    for (int c = 0; c < 3; ++c) l.p[j + 1][c] = EU::SIMD::madd(d[c], l.length[j], l.p[j][c]);
+   }
+  }
+
+  template<typename Policy>
+  void
+   iterateCcd(Lanes& l) const {
+   for (size_t j = m_joints; j-- > 0;) {
+    V toTip[3], toTarget[3];
+    for (int c = 0; c < 3; ++c) {
+     toTip[c] = l.p[m_joints][c] - l.p[j][c];
+     toTarget[c] = l.target[c] - l.p[j][c];
+    }
+    const V valid = detail::normalizeLanes<Policy>(toTip) & detail::normalizeLanes<Policy>(toTarget);
+    detail::IKRotation delta;
+    detail::arcLanes<Policy>(toTip, toTarget, valid, delta);
+    applyDelta<Policy>(l, j, delta);
+    forward(l, j);
+   }
+  }
+
+  template<typename Policy>
+  void
+   solveRegister(Lanes& l, size_t c0, const IKSettings& settings) {
+   const size_t J = m_joints;
+   for (int c = 0; c < 4; ++c) l.root[c] = V::load(&m_rootRotation[c][c0]);
+   for (int c = 0; c < 3; ++c) {
+    l.rootPosition[c] = V::load(&m_rootPosition[c][c0]);
+    l.target[c] = V::load(&m_target[c][c0]);
+    l.p[0][c] = l.rootPosition[c];
+   }
+   const size_t count = m_chains - c0 < detail::BATCH_WIDTH ? m_chains - c0 : detail::BATCH_WIDTH;
+   for (size_t j = 0; j < J; ++j) {
+    const size_t i = j * m_stride + c0;
+    for (int c = 0; c < 4; ++c) l.local[j][c] = V::load(&m_rotation[c][i]);
+    for (int c = 0; c < 3; ++c) l.bone[j][c] = V::load(&m_bone[c][i]);
+    l.length[j] = EU::SIMD::sqrt(l.bone[j][0] * l.bone[j][0] + l.bone[j][1] * l.bone[j][1] + l.bone[j][2] * l.bone[j][2]);
+    if (!m_limits.empty()) l.limit[j].load(&m_limits[i], count);
+   }
+   forward(l, 0);
+
+   const V toleranceSq = V::set1(settings.tolerance * settings.tolerance);
+   bool fitted = true;
+   for (uint32_t iteration = 0; iteration < settings.iterations; ++iteration) {
+    if (EU::SIMD::all(errorSq(l) <= toleranceSq)) break;
+    if (settings.algorithm == IKAlgorithm::CCD) {
+     iterateCcd<Policy>(l);
+     continue;
+    }
+    iterateFabrik<Policy>(l);
+    fitted = false;
+    if (!m_limits.empty()) {
+     fitRotations<Policy>(l);
+     fitted = true;
+    }
+   }
+   if (!fitted) fitRotations<Policy>(l);
+
+   for (size_t j = 0; j < J; ++j) {
+    const size_t i = j * m_stride + c0;
+    for (int c = 0; c < 4; ++c) l.local[j][c].store(&m_rotation[c][i]);
+   }
+   for (size_t j = 0; j <= J; ++j) {
+    for (int c = 0; c < 3; ++c) l.p[j][c].store(&m_position[c][j * m_stride + c0]);
+   }
+   EU::SIMD::sqrt(errorSq(l)).store(&m_error[c0]);
+  }
+
+  std::vector<float> m_rotation[4];     ///< Local rotation of joint j, chain c at [j * m_stride + c]
+  std::vector<float> m_bone[3];
+  std::vector<float> m_position[3];     ///< (m_joints + 1) rows of world positions
+  std::vector<float> m_rootRotation[4];
+  std::vector<float> m_rootPosition[3];
+  std::vector<float> m_target[3];
+  std::vector<JointLimit> m_limits;     ///< Same layout as m_rotation; empty when no chain has limits
+  std::vector<float> m_error;
+  size_t m_chains = 0;
+  size_t m_joints = 0;
+  size_t m_stride = 0;                  ///< m_chains rounded up to IK_CHUNK
+ };
+}
@@ -1,5 +1,5 @@
 ﻿#pragma once
-#include "../Prerequisites.h"
+//#include "../Prerequisites.h"
 #include <Vectors/Vector2.h>
 #include <Math/EngineMath.h>
 
@@ -20,10 +20,15 @@ namespace EU {
   /**
    * @brief Default constructor. Initializes as identity matrix.
    */
-  Matrix2x2() {
+  constexpr Matrix2x2() : m{} {
    setIdentity();
   }
 
+  /**
+   * @brief Leaves every element uninitialized; see EU::NoInit.
+   */
+  explicit Matrix2x2(EU::NoInitTag) {}
+
   /**
    * @brief Constructor with individual elements.
    * @param m00 Element at row 0, column 0.
@@ -31,9 +36,8 @@ namespace EU {
    * @param m10 Element at row 1, column 0.
    * @param m11 Element at row 1, column 1.
    */
-  Matrix2x2(float m00, float m01, float m10, float m11) {
-   m[0][0] = m00; m[0][1] = m01;
-   m[1][0] = m10; m[1][1] = m11;
+  constexpr Matrix2x2(float m00, float m01, float m10, float m11)
+   : m{ { m00, m01 }, { m10, m11 } } {
   }
 
   /**
@@ -41,7 +45,7 @@ namespace EU {
    * @param other Matrix to add.
    * @return Resulting matrix.
    */
-  Matrix2x2
+  constexpr Matrix2x2
    operator+(const Matrix2x2& other) const {
    Matrix2x2 r;
    for (int i = 0; i < 2; ++i)
@@ -55,7 +59,7 @@ namespace EU {
    * @param other Matrix to subtract.
    * @return Resulting matrix.
    */
-  Matrix2x2 
+  constexpr Matrix2x2
    operator-(const Matrix2x2& other) const {
    Matrix2x2 r;
    for (int i = 0; i < 2; ++i)
@@ -69,7 +73,7 @@ namespace EU {
    * @param sca Scalar value.
    * @return Scaled matrix.
    */
-  Matrix2x2
+  constexpr Matrix2x2
    operator*(float sca) const {
    Matrix2x2 r;
    for (int i = 0; i < 2; ++i)
@@ -83,7 +87,7 @@ namespace EU {
    * @param sca Scalar value.
    * @return Reference to this matrix after scaling.
    */
-  Matrix2x2&
+  constexpr Matrix2x2&
    operator*=(float sca) {
    for (int i = 0; i < 2; ++i)
     for (int j = 0; j < 2; ++j)
@@ -96,7 +100,7 @@ namespace EU {
    * @param other Matrix to multiply with.
    * @return Resulting matrix.
    */
-  Matrix2x2
+  constexpr Matrix2x2
    operator*(const Matrix2x2& other) const {
    Matrix2x2 r = zero();
    for (int i = 0; i < 2; ++i)
@@ -111,7 +115,7 @@ namespace EU {
    * @param vec Input vector.
    * @return Transformed vector.
    */
-  CVector2
+  constexpr CVector2
    operator*(const CVector2& vec) const {
    float x = m[0][0] * vec.x + m[0][1] * vec.y;
    float y = m[1][0] * vec.x + m[1][1] * vec.y;
@@ -123,7 +127,7 @@ namespace EU {
    * @param other Matrix to add.
    * @return Reference to this matrix.
    */
-  Matrix2x2&
+  constexpr Matrix2x2&
    operator+=(const Matrix2x2& other) {
    for (int i = 0; i < 2; ++i)
     for (int j = 0; j < 2; ++j)
@@ -136,7 +140,7 @@ namespace EU {
    * @param other Matrix to subtract.
    * @return Reference to this matrix.
    */
-  Matrix2x2&
+  constexpr Matrix2x2&
    operator-=(const Matrix2x2& other) {
    for (int i = 0; i < 2; ++i)
     for (int j = 0; j < 2; ++j)
@@ -150,7 +154,7 @@ namespace EU {
    * @param col Column index.
    * @return Reference to element.
    */
-  float&
+  constexpr float&
    operator()(int row, int col) {
    return m[row][col];
   }
@@ -161,16 +165,29 @@ namespace EU {
    * @param col Column index.
    * @return Const reference to element.
    */
-  const float&
+  constexpr const float&
    operator()(int row, int col) const {
    return m[row][col];
   }
 
+  /**
+   * @brief True when every element is within epsilon of other's.
+   * @param other Matrix to compare against.
+   * @param epsilon Largest allowed difference per element.
+   */
+  constexpr bool
+   approxEqual(const Matrix2x2& other, float epsilon = EU::Constants::EPSILON) const {
+   for (int i = 0; i < 2; ++i)
+    for (int j = 0; j < 2; ++j)
+     if (!EngineMath::approxEqual(m[i][j], other.m[i][j], epsilon)) return false;
+   return true;
+  }
+
   /**
    * @brief Calculates the determinant of the matrix.
    * @return Determinant value.
    */
-  float
+  constexpr float
    determinant() const {
    return m[0][0] * m[1][1] - m[0][1] * m[1][0];
   }
@@ -179,7 +196,7 @@ namespace EU {
    * @brief Returns the transposed version of the matrix.
    * @return Transposed matrix.
    */
-  Matrix2x2
+  constexpr Matrix2x2
    transpose() const {
    return Matrix2x2(
    m[0][0], m[1][0],
@@ -191,7 +208,7 @@ namespace EU {
    * @brief Returns the inverse of the matrix, or identity if not invertible.
    * @return Inverted matrix.
    */
-  Matrix2x2
+  constexpr Matrix2x2
    inverse() const {
    float det = determinant();
    if (det == 0.f) return Matrix2x2(); // returns identity
@@ -205,7 +222,7 @@ namespace EU {
   /**
    * @brief Sets this matrix as the identity matrix.
    */
-  void
+  constexpr void
    setIdentity() {
    m[0][0] = 1.f; m[0][1] = 0.f;
    m[1][0] = 0.f; m[1][1] = 1.f;
@@ -216,7 +233,7 @@ namespace EU {
    * @param scaleX Scale factor on X-axis.
    * @param scaleY Scale factor on Y-axis.
    */
-  void 
+  constexpr void
    setScale(float scaleX, float scaleY) {
    m[0][0] = scaleX; m[0][1] = 0.f;
    m[1][0] = 0.f;    m[1][1] = scaleY;
@@ -226,10 +243,10 @@ namespace EU {
    * @brief Sets this matrix as a 2D rotation matrix.
    * @param radians Angle in radians.
    */
-  void
+  constexpr void
    setRotation(float radians) {
-   float c = EU::Math::cos(radians);
-   float s = EU::Math::sin(radians);
+   float s = 0.f, c = 0.f;
+   EngineMath::sincos(radians, &s, &c);
    m[0][0] = c;  m[0][1] = -s;
    m[1][0] = s;  m[1][1] = c;
   }
@@ -238,7 +255,7 @@ namespace EU {
    * @brief Returns a matrix filled with zeros.
    * @return Zero matrix.
    */
-  static Matrix2x2 
+  static constexpr Matrix2x2
    zero() {
    return Matrix2x2(
    0.f, 0.f,
@@ -250,8 +267,10 @@ namespace EU {
    * @brief Returns the identity matrix.
    * @return Identity matrix.
    */
-  static Matrix2x2 identity() {
+  static constexpr Matrix2x2 identity() {
    return Matrix2x2();
   }
  };
+
+ EU_ASSERT_VALUE_TYPE(Matrix2x2);
 }
@@ -1,4 +1,7 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <Core/SIMD.h>
 #include <Vectors/Vector2.h>
 #include <Vectors/Vector3.h>
 #include <Math/EngineMath.h>
@@ -20,25 +23,30 @@ namespace EU {
   /**
    * @brief Default constructor. Initializes to identity matrix.
    */
-  Matrix3x3() {
+  constexpr Matrix3x3() : m{} {
    setIdentity();
   }
 
+  /**
+   * @brief Leaves every element uninitialized; see EU::NoInit.
+   */
+  explicit Matrix3x3(EU::NoInitTag) {}
+
   /**
    * @brief Constructs a matrix with given element values.
    */
-  Matrix3x3(float m00, float m01, float m02,
-            float m10, float m11, float m12,
-            float m20, float m21, float m22) {
-   m[0][0] = m00; m[0][1] = m01; m[0][2] = m02;
-   m[1][0] = m10; m[1][1] = m11; m[1][2] = m12;
-   m[2][0] = m20; m[2][1] = m21; m[2][2] = m22;
+  constexpr Matrix3x3(float m00, float m01, float m02,
+                      float m10, float m11, float m12,
+                      float m20, float m21, float m22)
+   : m{ { m00, m01, m02 },
+        { m10, m11, m12 },
+        { m20, m21, m22 } } {
   }
 
   /**
    * @brief Adds two matrices.
    */
-  Matrix3x3
+  constexpr Matrix3x3
    operator+(const Matrix3x3& otro) const {
    Matrix3x3 r;
    for (int i = 0; i < 3; ++i)
@@ -50,7 +58,7 @@ namespace EU {
   /**
    * @brief Adds another matrix in-place.
    */
-  Matrix3x3&
+  constexpr Matrix3x3&
    operator+=(const Matrix3x3& otro) {
    for (int i = 0; i < 3; ++i)
     for (int j = 0; j < 3; ++j)
@@ -61,7 +69,7 @@ namespace EU {
   /**
    * @brief Subtracts two matrices.
    */
-  Matrix3x3
+  constexpr Matrix3x3
    operator-(const Matrix3x3& otro) const {
    Matrix3x3 r;
    for (int i = 0; i < 3; ++i)
@@ -73,7 +81,7 @@ namespace EU {
   /**
    * @brief Subtracts another matrix in-place.
    */
-  Matrix3x3&
+  constexpr Matrix3x3&
    operator-=(const Matrix3x3& otro) {
    for (int i = 0; i < 3; ++i)
     for (int j = 0; j < 3; ++j)
@@ -84,7 +92,7 @@ namespace EU {
   /**
    * @brief Multiplies the matrix by a scalar.
    */
-  Matrix3x3
+  constexpr Matrix3x3
    operator*(float sca) const {
    Matrix3x3 r;
    for (int i = 0; i < 3; ++i)
@@ -96,7 +104,7 @@ namespace EU {
   /**
    * @brief Multiplies the matrix by a scalar in-place.
    */
-  Matrix3x3&
+  constexpr Matrix3x3&
    operator*=(float sca) {
     for (int i = 0; i < 3; ++i)
      for (int j = 0; j < 3; ++j)
@@ -107,7 +115,7 @@ namespace EU {
   /**
    * @brief Multiplies this matrix by another matrix.
    */
-  Matrix3x3 
+  constexpr Matrix3x3
    operator*(const Matrix3x3& otro) const {
    Matrix3x3 r = zero();
    for (int fil = 0; fil < 3; ++fil)
@@ -120,7 +128,7 @@ namespace EU {
   /**
    * @brief Transforms a 2D vector using homogeneous coordinates.
    */
-  CVector2
+  constexpr CVector2
    operator*(const CVector2& vec) const {
    float x = m[0][0] * vec.x + m[0][1] * vec.y + m[0][2] * 1.0f;
    float y = m[1][0] * vec.x + m[1][1] * vec.y + m[1][2] * 1.0f;
@@ -135,7 +143,7 @@ namespace EU {
   /**
    * @brief Transforms a 3D vector.
    */
-  CVector3
+  constexpr CVector3
    operator*(const CVector3& vec) const {
    return CVector3(
    m[0][0] * vec.x + m[0][1] * vec.y + m[0][2] * vec.z,
@@ -147,7 +155,7 @@ namespace EU {
   /**
    * @brief Compares two matrices for equality.
    */
-  bool
+  constexpr bool
    operator==(const Matrix3x3& otro) const {
    for (int i = 0; i < 3; ++i)
     for (int j = 0; j < 3; ++j)
@@ -155,24 +163,35 @@ namespace EU {
    return true;
   }
 
+  /**
+   * @brief True when every element is within epsilon of otro's.
+   */
+  constexpr bool
+   approxEqual(const Matrix3x3& otro, float epsilon = EU::Constants::EPSILON) const {
+   for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+     if (!EngineMath::approxEqual(m[i][j], otro.m[i][j], epsilon)) return false;
+   return true;
+  }
+
   /**
    * @brief Accesses an element of the matrix.
    */
-  float&
+  constexpr float&
    operator()(int fil, int col) {
    return m[fil][col];
   }
   /**
    * @brief Const access to an element of the matrix.
    */
-  const float&
+  constexpr const float&
    operator()(int fil, int col) const {
    return m[fil][col];
   }
   /**
    * @brief Computes the determinant of the matrix.
    */
-  float
+  constexpr float
    determinant() const {
    return
    m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
@@ -183,7 +202,7 @@ namespace EU {
   /**
    * @brief Returns the transposed version of the matrix.
    */
-  Matrix3x3
+  constexpr Matrix3x3
    transpose() const {
    return Matrix3x3(
    m[0][0], m[1][0], m[2][0],
@@ -193,48 +212,92 @@ namespace EU {
   }
   /**
    * @brief Computes the cofactor of a specific element.
+   *
+   * With the other rows and columns taken cyclically (fil + 1, fil + 2), the 2x2 minor
+   * already carries the (-1)^(fil + col) sign.
    */
-  float
+  constexpr float
    cofactor(int fil, int col) const {
    int r1 = (fil + 1) % 3, r2 = (fil + 2) % 3;
    int c1 = (col + 1) % 3, c2 = (col + 2) % 3;
-   float minor = m[r1][c1] * m[r2][c2] - m[r1][c2] * m[r2][c1];
-   return ((fil + col) % 2 == 0) ? minor : -minor;
+   return m[r1][c1] * m[r2][c2] - m[r1][c2] * m[r2][c1];
   }
 
   /**
    * @brief Builds the cofactor matrix.
    */
-  Matrix3x3
+  constexpr Matrix3x3
    cofactorMatrix() const {
-   return Matrix3x3(
-   cofactor(0, 0), cofactor(0, 1), cofactor(0, 2),
-   cofactor(1, 0), cofactor(1, 1), cofactor(1, 2),
-   cofactor(2, 0), cofactor(2, 1), cofactor(2, 2)
-   );
+   return crossRows();
   }
 
   /**
    * @brief Computes the adjugate (transposed cofactor matrix).
+   *
+   * Its columns are the cross products row1 x row2, row2 x row0 and row0 x row1.
    */
-  Matrix3x3
+  constexpr Matrix3x3
    adjugate() const {
-   return cofactorMatrix().transpose();
+   return crossRows().transpose();
   }
+
   /**
    * @brief Computes the inverse of the matrix. Returns identity if not invertible.
+   *
+   * Closed form: the adjugate's columns are cross products of the rows and the determinant
+   * is row0 . (row1 x row2), so every 2x2 minor is computed once. Same bits as
+   * inverseArray() unless the multiply-adds are fused (FMA targets outside EU_REPRODUCIBLE).
    */
-  Matrix3x3 
+  constexpr Matrix3x3
    inverse() const {
-   float det = determinant();
+   return inverseTranspose().transpose();
+  }
+
+  /**
+   * @brief Transpose of inverse(), e.g. the normal matrix of a linear transform. Returns
+   * identity if not invertible.
+   *
+   * Row i is the cross product of the other two rows over the determinant, so this is the
+   * cheaper of the two.
+   */
+  constexpr Matrix3x3
+   inverseTranspose() const {
+   Matrix3x3 r = crossRows();
+   const float det = (m[0][0] * r.m[0][0] + m[0][1] * r.m[0][1]) + m[0][2] * r.m[0][2];
    if (det == 0.f) return identity();
-   return adjugate() * (1.f / det);
+   return r * (1.f / det);
+  }
+
+  /**
+   * @brief inverseTranspose() for transforming normals, with a shortcut for uniform scale.
+   *
+   * When the columns are orthogonal and of equal squared length s^2 (a rotation, possibly
+   * mirrored, times a uniform scale s) the inverse transpose is the matrix itself over s^2:
+   * one reciprocal instead of the cofactors. tolerance bounds the relative mismatch
+   * accepted as uniform. Same bits as normalMatrixArray() unless the multiply-adds are fused
+   * (FMA targets outside EU_REPRODUCIBLE), when a matrix near the tolerance can also take the
+   * other branch.
+   */
+  constexpr Matrix3x3
+   normalMatrix(float tolerance = 1e-5f) const {
+   float lenSq[3] = {}, dot[3] = {};
+   for (int c = 0; c < 3; ++c) {
+    const int c1 = (c + 1) % 3;
+    lenSq[c] = (m[0][c] * m[0][c] + m[1][c] * m[1][c]) + m[2][c] * m[2][c];
+    dot[c] = (m[0][c] * m[0][c1] + m[1][c] * m[1][c1]) + m[2][c] * m[2][c1];
+   }
+   const float bound = tolerance * lenSq[0];
+   if (lenSq[0] > 0.f && EngineMath::fabs(lenSq[1] - lenSq[0]) <= bound && EngineMath::fabs(lenSq[2] - lenSq[0]) <= bound
+       && EngineMath::fabs(dot[0]) <= bound && EngineMath::fabs(dot[1]) <= bound && EngineMath::fabs(dot[2]) <= bound) {
+    return *this * (1.f / lenSq[0]);
+   }
+   return inverseTranspose();
   }
 
   /**
    * @brief Sets this matrix to identity.
    */
-  void
+  constexpr void
    setIdentity() {
    m[0][0] = 1.f; m[0][1] = 0.f; m[0][2] = 0.f;
    m[1][0] = 0.f; m[1][1] = 1.f; m[1][2] = 0.f;
@@ -244,7 +307,7 @@ namespace EU {
   /**
    * @brief Returns an identity matrix.
    */
-  static Matrix3x3 
+  static constexpr Matrix3x3
    identity() {
    return Matrix3x3(
    1.f, 0.f, 0.f,
@@ -256,7 +319,7 @@ namespace EU {
   /**
    * @brief Returns a zero matrix.
    */
-  static Matrix3x3
+  static constexpr Matrix3x3
    zero() {
    return Matrix3x3(
    0.f, 0.f, 0.f,
@@ -264,6 +327,146 @@ namespace EU {
    0.f, 0.f, 0.f
    );
   }
+
+  private:
+  /** Rows row1 x row2, row2 x row0 and row0 x row1: the cofactor matrix. */
+  constexpr Matrix3x3
+   crossRows() const {
+   return Matrix3x3(
+   m[1][1] * m[2][2] - m[1][2] * m[2][1], m[1][2] * m[2][0] - m[1][0] * m[2][2], m[1][0] * m[2][1] - m[1][1] * m[2][0],
+   m[2][1] * m[0][2] - m[2][2] * m[0][1], m[2][2] * m[0][0] - m[2][0] * m[0][2], m[2][0] * m[0][1] - m[2][1] * m[0][0],
+   m[0][1] * m[1][2] - m[0][2] * m[1][1], m[0][2] * m[1][0] - m[0][0] * m[1][2], m[0][0] * m[1][1] - m[0][1] * m[1][0]
+   );
+  }
  };
 
+ EU_ASSERT_VALUE_TYPE(Matrix3x3);
+
+ namespace detail {
+  /**
+   * Inverts n matrices one register of them at a time: the nine elements are gathered into
+   * lanes, the closed-form inverse runs with plain multiplies and subtracts (no fused
+   * multiply-add, so every lane matches Matrix3x3::inverseTranspose()), and singular lanes
+   * select the identity.
+   */
+  inline void
+   inverseArray(const Matrix3x3* in, Matrix3x3* out, size_t n, bool transposed) {
+   using V = EU::SIMD::FloatN;
+   const size_t W = static_cast<size_t>(V::WIDTH);
+   const V zero = V::zero(), one = V::set1(1.f);
+   size_t i = 0;
+   for (; i + W <= n; i += W) {
+    float lanes[9][V::WIDTH];
+    for (size_t k = 0; k < W; ++k)
+     for (int e = 0; e < 9; ++e) lanes[e][k] = in[i + k].m[e / 3][e % 3];
+    V a[3][3];
+    for (int e = 0; e < 9; ++e) a[e / 3][e % 3] = V::load(lanes[e]);
+    V c[3][3];
+    for (int r = 0; r < 3; ++r) {
+     const int r1 = (r + 1) % 3, r2 = (r + 2) % 3;
+     c[r][0] = a[r1][1] * a[r2][2] - a[r1][2] * a[r2][1];
+     c[r][1] = a[r1][2] * a[r2][0] - a[r1][0] * a[r2][2];
+     c[r][2] = a[r1][0] * a[r2][1] - a[r1][1] * a[r2][0];
+    }
+    const V det = (a[0][0] * c[0][0] + a[0][1] * c[0][1]) + a[0][2] * c[0][2];
+    const V singular = det == zero;
+    const V s = one / EU::SIMD::select(singular, one, det);
+    for (int r = 0; r < 3; ++r) {
+     for (int col = 0; col < 3; ++col) {
+      const V v = EU::SIMD::select(singular, r == col ? one : zero, c[r][col] * s);
+      v.store(transposed ? lanes[r * 3 + col] : lanes[col * 3 + r]);
+     }
+    }
+    for (size_t k = 0; k < W; ++k)
+     for (int e = 0; e < 9; ++e) out[i + k].m[e / 3][e % 3] = lanes[e][k];
+   }
+   for (; i < n; ++i) out[i] = transposed ? in[i].inverseTranspose() : in[i].inverse();
+  }
+
+  /**
+   * Matrix3x3::normalMatrix() of the upper 3x3 blocks of in[nodes[k]] (in[k] without nodes)
+   * for k < n, written to out at the same index. Both the uniform-scale and the cofactor
+   * result are computed per lane and the test selects one, in the scalar operation order;
+   * the padding lanes of the last register are identities.
+   */
+  template<typename Matrix>
+  inline void
+   normalMatrixLanes(const Matrix* in, const uint32_t* nodes, size_t n, Matrix3x3* out, float tolerance) {
+   using V = EU::SIMD::FloatN;
+   const size_t W = static_cast<size_t>(V::WIDTH);
+   const V zero = V::zero(), one = V::set1(1.f), tol = V::set1(tolerance);
+   for (size_t i = 0; i < n; i += W) {
+    const size_t count = n - i < W ? n - i : W;
+    float lanes[9][V::WIDTH];
+    for (size_t k = 0; k < W; ++k) {
+     if (k < count) {
+      const Matrix& matrix = in[nodes != nullptr ? nodes[i + k] : i + k];
+      for (int e = 0; e < 9; ++e) lanes[e][k] = matrix.m[e / 3][e % 3];
+     }
+     else {
+      for (int e = 0; e < 9; ++e) lanes[e][k] = e % 4 == 0 ? 1.f : 0.f;
+     }
+    }
+    V a[3][3];
+    for (int e = 0; e < 9; ++e) a[e / 3][e % 3] = V::load(lanes[e]);
+    V lenSq[3], dot[3];
+    for (int c = 0; c < 3; ++c) {
+     const int c1 = (c + 1) % 3;
+     lenSq[c] = (a[0][c] * a[0][c] + a[1][c] * a[1][c]) + a[2][c] * a[2][c];
+     dot[c] = (a[0][c] * a[0][c1] + a[1][c] * a[1][c1]) + a[2][c] * a[2][c1];
+    }
+    const V bound = tol * lenSq[0], negBound = zero - bound;
+    V uniform = lenSq[0] > zero;
+    const V diff[5] = { lenSq[1] - lenSq[0], lenSq[2] - lenSq[0], dot[0], dot[1], dot[2] };
+    for (int d = 0; d < 5; ++d) uniform = uniform & (diff[d] <= bound) & (diff[d] >= negBound);
+    V c[3][3];
+    for (int r = 0; r < 3; ++r) {
+     const int r1 = (r + 1) % 3, r2 = (r + 2) % 3;
+     c[r][0] = a[r1][1] * a[r2][2] - a[r1][2] * a[r2][1];
+     c[r][1] = a[r1][2] * a[r2][0] - a[r1][0] * a[r2][2];
+     c[r][2] = a[r1][0] * a[r2][1] - a[r1][1] * a[r2][0];
+    }
+    const V det = (a[0][0] * c[0][0] + a[0][1] * c[0][1]) + a[0][2] * c[0][2];
+    const V singular = det == zero;
+    const V s = one / EU::SIMD::select(singular, one, det);
+    const V u = one / EU::SIMD::select(uniform, lenSq[0], one);
+    for (int r = 0; r < 3; ++r) {
+     for (int col = 0; col < 3; ++col) {
+      const V cofactor = EU::SIMD::select(singular, r == col ? one : zero, c[r][col] * s);
+      EU::SIMD::select(uniform, a[r][col] * u, cofactor).store(lanes[r * 3 + col]);
+     }
+    }
+    for (size_t k = 0; k < count; ++k) {
+     Matrix3x3& result = out[nodes != nullptr ? nodes[i + k] : i + k];
+     for (int e = 0; e < 9; ++e) result.m[e / 3][e % 3] = lanes[e][k];
+    }
+   }
+  }
+ }
+
+ /**
+  * @brief out[i] = in[i].inverse(), identity for singular matrices. out may be in.
+  */
+ inline void
+  inverseArray(const Matrix3x3* in, Matrix3x3* out, size_t n) {
+  detail::inverseArray(in, out, n, false);
+ }
+
+ /**
+  * @brief out[i] = in[i].inverseTranspose(), e.g. per-object normal matrices. out may be in.
+  */
+ inline void
+  inverseTransposeArray(const Matrix3x3* in, Matrix3x3* out, size_t n) {
+  detail::inverseArray(in, out, n, true);
+ }
+
+ /**
+  * @brief out[i] = in[i].normalMatrix(tolerance), one register of matrices per step. out
+  * may be in.
+  */
+ inline void
+  normalMatrixArray(const Matrix3x3* in, Matrix3x3* out, size_t n, float tolerance = 1e-5f) {
+  detail::normalMatrixLanes(in, nullptr, n, out, tolerance);
+ }
+
 }
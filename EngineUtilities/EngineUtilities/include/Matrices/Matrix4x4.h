@@ -1,8 +1,12 @@
 #pragma once
 
-#include "../Prerequisites.h"
+//#include "../Prerequisites.h"
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Matrices/Matrix3x3.h>
 #include <Vectors/Vector3.h>
 #include <Vectors/Vector4.h>
+#include <Vectors/Vector4A.h>
 #include <Math/EngineMath.h>
 
 namespace EU {
@@ -23,27 +27,32 @@ namespace EU {
   /**
    * @brief Default constructor. Initializes to identity matrix.
    */
-  Matrix4x4() {
+  constexpr Matrix4x4() : m{} {
    setIdentity();
   }
 
+  /**
+   * @brief Leaves every element uninitialized; see EU::NoInit.
+   */
+  explicit Matrix4x4(EU::NoInitTag) {}
+
   /**
    * @brief Constructor with element-wise initialization.
    */
-  Matrix4x4(float m00, float m01, float m02, float m03,
-            float m10, float m11, float m12, float m13,
-            float m20, float m21, float m22, float m23,
-            float m30, float m31, float m32, float m33) {
-   m[0][0] = m00; m[0][1] = m01; m[0][2] = m02; m[0][3] = m03;
-   m[1][0] = m10; m[1][1] = m11; m[1][2] = m12; m[1][3] = m13;
-   m[2][0] = m20; m[2][1] = m21; m[2][2] = m22; m[2][3] = m23;
-   m[3][0] = m30; m[3][1] = m31; m[3][2] = m32; m[3][3] = m33;
+  constexpr Matrix4x4(float m00, float m01, float m02, float m03,
+                      float m10, float m11, float m12, float m13,
+                      float m20, float m21, float m22, float m23,
+                      float m30, float m31, float m32, float m33)
+   : m{ { m00, m01, m02, m03 },
+        { m10, m11, m12, m13 },
+        { m20, m21, m22, m23 },
+        { m30, m31, m32, m33 } } {
   }
 
   /**
    * @brief Adds two matrices.
    */
-  Matrix4x4 
+  constexpr Matrix4x4
    operator+(const Matrix4x4& otro) const {
    Matrix4x4 r;
    for (int i = 0; i < 4; ++i)
@@ -55,7 +64,7 @@ namespace EU {
   /**
    * @brief Subtracts two matrices.
    */
-  Matrix4x4 
+  constexpr Matrix4x4
    operator-(const Matrix4x4& otro) const {
    Matrix4x4 r;
    for (int i = 0; i < 4; ++i)
@@ -67,7 +76,7 @@ namespace EU {
   /**
    * @brief Multiplies the matrix by a scalar.
    */
-  Matrix4x4 
+  constexpr Matrix4x4
    operator*(float sca) const {
    Matrix4x4 r;
    for (int i = 0; i < 4; ++i)
@@ -78,21 +87,59 @@ namespace EU {
 
   /**
    * @brief Matrix multiplication.
+   *
+   * Each result row is the sum of otro's rows scaled by the broadcast elements of ours, with
+   * k = 0..3 accumulated left to right: two rows per register with AVX2, one with SSE2/NEON,
+   * plain loops otherwise and in constant expressions. Every path gives the same bits unless
+   * the multiply-adds are fused (FMA targets outside EU_REPRODUCIBLE).
    */
-  Matrix4x4 
+  EU_CONSTEXPR20 Matrix4x4
    operator*(const Matrix4x4& otro) const {
-   Matrix4x4 r = zero();
-   for (int fil = 0; fil < 4; ++fil)
-    for (int col = 0; col < 4; ++col)
-     for (int k = 0; k < 4; ++k)
-      r.m[fil][col] += m[fil][k] * otro.m[k][col];
+#if defined(EU_HAS_CONSTEXPR_BITS)
+   if (std::is_constant_evaluated()) {
+    return multiplyScalar(otro);
+   }
+#endif
+#if defined(EU_SIMD_AVX2)
+   using EU::SIMD::Float8;
+   Matrix4x4 r(EU::NoInit);
+   const Float8 b0 = { _mm256_broadcast_ps(reinterpret_cast<const __m128*>(otro.m[0])) };
+   const Float8 b1 = { _mm256_broadcast_ps(reinterpret_cast<const __m128*>(otro.m[1])) };
+   const Float8 b2 = { _mm256_broadcast_ps(reinterpret_cast<const __m128*>(otro.m[2])) };
+   const Float8 b3 = { _mm256_broadcast_ps(reinterpret_cast<const __m128*>(otro.m[3])) };
+   for (int fil = 0; fil < 4; fil += 2) {
+    // Rows fil and fil + 1 side by side; in-lane shuffles broadcast element k of each.
+    const __m256 a = _mm256_loadu_ps(&m[fil][0]);
+    Float8 acc = Float8{ _mm256_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)) } * b0;
+    acc = EU::SIMD::madd(Float8{ _mm256_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)) }, b1, acc);
+    acc = EU::SIMD::madd(Float8{ _mm256_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)) }, b2, acc);
+    acc = EU::SIMD::madd(Float8{ _mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)) }, b3, acc);
+    acc.store(&r.m[fil][0]);
+   }
    return r;
+#elif defined(EU_SIMD_SSE2) || defined(EU_SIMD_NEON)
+   using EU::SIMD::Float4;
+   Matrix4x4 r(EU::NoInit);
+   const Float4 b0 = Float4::load(otro.m[0]), b1 = Float4::load(otro.m[1]);
+   const Float4 b2 = Float4::load(otro.m[2]), b3 = Float4::load(otro.m[3]);
+   for (int fil = 0; fil < 4; ++fil) {
+    const Float4 a = Float4::load(m[fil]);
+    Float4 acc = EU::SIMD::shuffle<0, 0, 0, 0>(a) * b0;
+    acc = EU::SIMD::madd(EU::SIMD::shuffle<1, 1, 1, 1>(a), b1, acc);
+    acc = EU::SIMD::madd(EU::SIMD::shuffle<2, 2, 2, 2>(a), b2, acc);
+    acc = EU::SIMD::madd(EU::SIMD::shuffle<3, 3, 3, 3>(a), b3, acc);
+    acc.store(r.m[fil]);
+   }
+   return r;
+#else
+   return multiplyScalar(otro);
+#endif
   }
 
   /**
    * @brief Transforms a 4D vector.
    */
-  CVector4 
+  constexpr CVector4
    operator*(const CVector4& vec) const {
    return CVector4(
    m[0][0] * vec.x + m[0][1] * vec.y + m[0][2] * vec.z + m[0][3] * vec.w,
@@ -102,10 +149,26 @@ namespace EU {
    );
   }
 
+  /**
+   * @brief Transforms an aligned 4D vector with SIMD, bit-identical to the CVector4 overload
+   * when multiply-adds are not fused.
+   */
+  CVector4A
+   operator*(const CVector4A& vec) const {
+   using EU::SIMD::Float4;
+   Float4 v = vec.simd();
+   Float4 r0 = Float4::load(m[0]) * v;
+   Float4 r1 = Float4::load(m[1]) * v;
+   Float4 r2 = Float4::load(m[2]) * v;
+   Float4 r3 = Float4::load(m[3]) * v;
+   EU::SIMD::transpose(r0, r1, r2, r3);
+   return CVector4A(((r0 + r1) + r2) + r3);
+  }
+
   /**
    * @brief Transforms a 3D vector using homogeneous coordinates.
    */
-  CVector3 
+  constexpr CVector3
    operator*(const CVector3& vec) const {
    float x = m[0][0] * vec.x + m[0][1] * vec.y + m[0][2] * vec.z + m[0][3];
    float y = m[1][0] * vec.x + m[1][1] * vec.y + m[1][2] * vec.z + m[1][3];
@@ -122,7 +185,7 @@ namespace EU {
   /**
    * @brief Adds another matrix in-place.
    */
-  Matrix4x4& 
+  constexpr Matrix4x4&
    operator+=(const Matrix4x4& otro) {
    for (int i = 0; i < 4; ++i)
     for (int j = 0; j < 4; ++j)
@@ -133,7 +196,7 @@ namespace EU {
   /**
    * @brief Subtracts another matrix in-place.
    */
-  Matrix4x4& 
+  constexpr Matrix4x4&
    operator-=(const Matrix4x4& otro) {
    for (int i = 0; i < 4; ++i)
     for (int j = 0; j < 4; ++j)
@@ -144,7 +207,7 @@ namespace EU {
   /**
    * @brief Multiplies this matrix by a scalar in-place.
    */
-  Matrix4x4& 
+  constexpr Matrix4x4&
    operator*=(float sca) {
    for (int i = 0; i < 4; ++i)
     for (int j = 0; j < 4; ++j)
@@ -155,7 +218,7 @@ namespace EU {
   /**
    * @brief Accesses a matrix element by row and column.
    */
-  float& 
+  constexpr float&
    operator()(int fil, int col) {
    return m[fil][col];
   }
@@ -163,15 +226,26 @@ namespace EU {
   /**
    * @brief Const access to a matrix element by row and column.
    */
-  const float& 
+  constexpr const float&
    operator()(int fil, int col) const {
    return m[fil][col];
   }
 
+  /**
+   * @brief True when every element is within epsilon of otro's.
+   */
+  constexpr bool
+   approxEqual(const Matrix4x4& otro, float epsilon = EU::Constants::EPSILON) const {
+   for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+     if (!EngineMath::approxEqual(m[i][j], otro.m[i][j], epsilon)) return false;
+   return true;
+  }
+
   /**
    * @brief Returns the transpose of this matrix.
    */
-  Matrix4x4 
+  constexpr Matrix4x4
    transpose() const {
    return Matrix4x4(
    m[0][0], m[1][0], m[2][0], m[3][0],
@@ -181,21 +255,199 @@ namespace EU {
    );
   }
 
+  /**
+   * @brief Computes the determinant from the twelve 2x2 minors of the top and bottom row pairs.
+   */
+  constexpr float
+   determinant() const {
+   const float s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+   const float s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+   const float s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+   const float s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+   const float s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+   const float s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+   const float c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+   const float c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+   const float c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+   const float c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+   const float c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+   const float c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+   return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+  }
+
+  /**
+   * @brief Determinant of the upper 3x3 block, expanded along the first row as in
+   * inverseAffine(). Its sign is the handedness of the transform.
+   */
+  constexpr float
+   determinant3x3() const {
+   const float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+   const float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+   const float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+   return (m[0][0] * c00 + m[0][1] * c01) + m[0][2] * c02;
+  }
+
+  /**
+   * @brief True when the bottom row is exactly (0, 0, 0, 1), so inverseAffine() applies.
+   * Products of affine matrices keep those zeros exact.
+   */
+  constexpr bool
+   isAffine() const {
+   return m[3][0] == 0.f && m[3][1] == 0.f && m[3][2] == 0.f && m[3][3] == 1.f;
+  }
+
+  /**
+   * @brief True when the upper 3x3 columns are unit length and mutually perpendicular to
+   * within epsilon, i.e. a rotation (possibly mirrored) that inverseRigid() can invert.
+   */
+  constexpr bool
+   isOrthonormal(float epsilon = EU::Constants::EPSILON) const {
+   for (int a = 0; a < 3; ++a) {
+    for (int b = a; b < 3; ++b) {
+     const float d = (m[0][a] * m[0][b] + m[1][a] * m[1][b]) + m[2][a] * m[2][b];
+     const float e = d - (a == b ? 1.f : 0.f);
+     if (e > epsilon || e < -epsilon) return false;
+    }
+   }
+   return true;
+  }
+
+  /**
+   * @brief True when the upper 3x3 block mirrors space (negative determinant), the case
+   * where triangle winding flips.
+   */
+  constexpr bool
+   hasNegativeScale() const {
+   return determinant3x3() < 0.f;
+  }
+
+  /**
+   * @brief Upper 3x3 block, the linear part of an affine transform.
+   */
+  constexpr Matrix3x3
+   linear() const {
+   return Matrix3x3(m[0][0], m[0][1], m[0][2],
+                    m[1][0], m[1][1], m[1][2],
+                    m[2][0], m[2][1], m[2][2]);
+  }
+
+  /**
+   * @brief Normal matrix: the inverse transpose of the upper 3x3 block, through
+   * Matrix3x3::normalMatrix() (no cofactors under uniform scale).
+   */
+  constexpr Matrix3x3
+   normalMatrix(float tolerance = 1e-5f) const {
+   return linear().normalMatrix(tolerance);
+  }
+
+  /**
+   * @brief Computes the inverse of the matrix. Returns identity if not invertible.
+   *
+   * Cofactor expansion with the 2x2 minors of the lower rows built four lanes at a time, so
+   * the whole inverse is a few dozen register operations and one division. Constant expressions
+   * run the same arithmetic lane by lane and give the same bits.
+   */
+  EU_CONSTEXPR20 Matrix4x4
+   inverse() const {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+   if (std::is_constant_evaluated()) {
+    return inverseScalar();
+   }
+#endif
+   using EU::SIMD::Float4;
+   using EU::SIMD::shuffle2;
+   const Float4 r0 = Float4::load(m[0]), r1 = Float4::load(m[1]);
+   const Float4 r2 = Float4::load(m[2]), r3 = Float4::load(m[3]);
+   const Float4 fac0 = minors<2, 3>(r1, r2, r3), fac1 = minors<1, 3>(r1, r2, r3);
+   const Float4 fac2 = minors<1, 2>(r1, r2, r3), fac3 = minors<0, 3>(r1, r2, r3);
+   const Float4 fac4 = minors<0, 2>(r1, r2, r3), fac5 = minors<0, 1>(r1, r2, r3);
+   // vecJ = (m[1][j], m[0][j], m[0][j], m[0][j])
+   const Float4 vec0 = EU::SIMD::shuffle<0, 2, 2, 2>(shuffle2<0, 0, 0, 0>(r1, r0));
+   const Float4 vec1 = EU::SIMD::shuffle<0, 2, 2, 2>(shuffle2<1, 1, 1, 1>(r1, r0));
+   const Float4 vec2 = EU::SIMD::shuffle<0, 2, 2, 2>(shuffle2<2, 2, 2, 2>(r1, r0));
+   const Float4 vec3 = EU::SIMD::shuffle<0, 2, 2, 2>(shuffle2<3, 3, 3, 3>(r1, r0));
+   const float evenSigns[4] = { 1.f, -1.f, 1.f, -1.f };
+   const float oddSigns[4] = { -1.f, 1.f, -1.f, 1.f };
+   const Float4 signA = Float4::load(evenSigns), signB = Float4::load(oddSigns);
+   const Float4 inv0 = ((vec1 * fac0 - vec2 * fac1) + vec3 * fac2) * signA;
+   const Float4 inv1 = ((vec0 * fac0 - vec2 * fac3) + vec3 * fac4) * signB;
+   const Float4 inv2 = ((vec0 * fac1 - vec1 * fac3) + vec3 * fac5) * signA;
+   const Float4 inv3 = ((vec0 * fac2 - vec1 * fac4) + vec2 * fac5) * signB;
+   // The first column of the adjugate against the first row gives the determinant.
+   const Float4 column0 = shuffle2<0, 2, 0, 2>(shuffle2<0, 0, 0, 0>(inv0, inv1), shuffle2<0, 0, 0, 0>(inv2, inv3));
+   const float det = EU::SIMD::first(EU::SIMD::dot4(r0, column0));
+   if (det == 0.f) {
+    return identity();
+   }
+   const Float4 scale = Float4::set1(1.f / det);
+   Matrix4x4 r(EU::NoInit);
+   (inv0 * scale).store(r.m[0]);
+   (inv1 * scale).store(r.m[1]);
+   (inv2 * scale).store(r.m[2]);
+   (inv3 * scale).store(r.m[3]);
+   return r;
+  }
+
+  /**
+   * @brief Inverse of an affine transform (bottom row 0, 0, 0, 1): the inverse of the upper
+   * 3x3 block applied to the negated translation. Returns identity if the block is singular.
+   */
+  constexpr Matrix4x4
+   inverseAffine() const {
+   const float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+   const float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+   const float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+   const float det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+   if (det == 0.f) return identity();
+   const float s = 1.f / det;
+   const float a00 = c00 * s;
+   const float a01 = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * s;
+   const float a02 = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * s;
+   const float a10 = c01 * s;
+   const float a11 = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * s;
+   const float a12 = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * s;
+   const float a20 = c02 * s;
+   const float a21 = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * s;
+   const float a22 = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * s;
+   const float tx = m[0][3], ty = m[1][3], tz = m[2][3];
+   return Matrix4x4(
+   a00, a01, a02, -(a00 * tx + a01 * ty + a02 * tz),
+   a10, a11, a12, -(a10 * tx + a11 * ty + a12 * tz),
+   a20, a21, a22, -(a20 * tx + a21 * ty + a22 * tz),
+   0.f, 0.f, 0.f, 1.f
+   );
+  }
+
+  /**
+   * @brief Inverse of a rotation plus translation (orthonormal upper 3x3, e.g. a camera's
+   * view matrix): the transposed rotation and the translation rotated back and negated.
+   */
+  constexpr Matrix4x4
+   inverseRigid() const {
+   const float tx = m[0][3], ty = m[1][3], tz = m[2][3];
+   return Matrix4x4(
+   m[0][0], m[1][0], m[2][0], -(m[0][0] * tx + m[1][0] * ty + m[2][0] * tz),
+   m[0][1], m[1][1], m[2][1], -(m[0][1] * tx + m[1][1] * ty + m[2][1] * tz),
+   m[0][2], m[1][2], m[2][2], -(m[0][2] * tx + m[1][2] * ty + m[2][2] * tz),
+   0.f, 0.f, 0.f, 1.f
+   );
+  }
+
   /**
    * @brief Sets this matrix to identity.
    */
-  void 
+  constexpr void
    setIdentity() {
    m[0][0] = 1.f; m[0][1] = 0.f; m[0][2] = 0.f; m[0][3] = 0.f;
    m[1][0] = 0.f; m[1][1] = 1.f; m[1][2] = 0.f; m[1][3] = 0.f;
    m[2][0] = 0.f; m[2][1] = 0.f; m[2][2] = 1.f; m[2][3] = 0.f;
-   m[3][0] = 0.f; m[3][1] = 0.f; m[3][2] = 1.f; m[3][3] = 0.f;
+   m[3][0] = 0.f; m[3][1] = 0.f; m[3][2] = 0.f; m[3][3] = 1.f;
   }
 
   /**
    * @brief Converts this matrix to a scaling matrix.
    */
-  void 
+  constexpr void
    setScale(float scaX, float scaY, float scaZ) {
    for (int i = 0; i < 4; ++i)
     for (int j = 0; j < 4; ++j)
@@ -208,7 +460,7 @@ namespace EU {
   /**
    * @brief Converts this matrix to a translation matrix.
    */
-  void 
+  constexpr void
    setTranslation(float tx, float ty, float tz) {
     for (int i = 0; i < 4; ++i)
      for (int j = 0; j < 4; ++j)
@@ -225,10 +477,10 @@ namespace EU {
   /**
    * @brief Converts this matrix to a rotation matrix around the Z axis.
    */
-  void 
+  constexpr void
    setRotation(float radians) {
-   float c = cos(radians);
-   float s = sin(radians);
+   float s = 0.f, c = 0.f;
+   EngineMath::sincos(radians, &s, &c);
    for (int i = 0; i < 4; ++i)
     for (int j = 0; j < 4; ++j)
      m[i][j] = 0.0f;
@@ -243,7 +495,7 @@ namespace EU {
   /**
    * @brief Returns an identity matrix.
    */
-  static Matrix4x4 
+  static constexpr Matrix4x4
    identity() {
    return Matrix4x4(
    1.f, 0.f, 0.f, 0.f,
@@ -256,7 +508,7 @@ namespace EU {
   /**
    * @brief Returns a matrix filled with zeros.
    */
-  static Matrix4x4
+  static constexpr Matrix4x4
    zero() {
    return Matrix4x4(
    0.f, 0.f, 0.f, 0.f,
@@ -265,5 +517,204 @@ namespace EU {
    0.f, 0.f, 0.f, 0.f
    );
   }
+
+  private:
+  /**
+   * 2x2 minors of columns X and Y over the row pairs (2, 3), (2, 3), (1, 3) and (1, 2), one
+   * per lane: the cofactor building blocks of the first two rows.
+   */
+  template<int X, int Y>
+  static EU::SIMD::Float4
+   minors(EU::SIMD::Float4 r1, EU::SIMD::Float4 r2, EU::SIMD::Float4 r3) {
+   using EU::SIMD::shuffle;
+   using EU::SIMD::shuffle2;
+   const EU::SIMD::Float4 px = shuffle2<X, X, X, X>(r2, r1), py = shuffle2<Y, Y, Y, Y>(r2, r1);
+   const EU::SIMD::Float4 qx = shuffle<0, 0, 0, 2>(shuffle2<X, X, X, X>(r3, r2));
+   const EU::SIMD::Float4 qy = shuffle<0, 0, 0, 2>(shuffle2<Y, Y, Y, Y>(r3, r2));
+   return px * qy - qx * py;
+  }
+
+  /** inverse() one lane at a time, for constant evaluation. */
+  constexpr Matrix4x4
+   inverseScalar() const {
+   const int cols[6][2] = { { 2, 3 }, { 1, 3 }, { 1, 2 }, { 0, 3 }, { 0, 2 }, { 0, 1 } };
+   const int rows[4][2] = { { 2, 3 }, { 2, 3 }, { 1, 3 }, { 1, 2 } };
+   // Row i of the adjugate is (vec[a] * fac[b] - vec[c] * fac[d]) + vec[e] * fac[f].
+   const int terms[4][6] = { { 1, 0, 2, 1, 3, 2 }, { 0, 0, 2, 3, 3, 4 }, { 0, 1, 1, 3, 3, 5 }, { 0, 2, 1, 4, 2, 5 } };
+   float fac[6][4] = {};
+   float vec[4][4] = {};
+   for (int f = 0; f < 6; ++f) {
+    for (int l = 0; l < 4; ++l) {
+     const int p = rows[l][0], q = rows[l][1], x = cols[f][0], y = cols[f][1];
+     fac[f][l] = m[p][x] * m[q][y] - m[q][x] * m[p][y];
+    }
+   }
+   for (int j = 0; j < 4; ++j) {
+    for (int l = 0; l < 4; ++l) vec[j][l] = m[l == 0 ? 1 : 0][j];
+   }
+   Matrix4x4 r = zero();
+   for (int i = 0; i < 4; ++i) {
+    const int* t = terms[i];
+    for (int l = 0; l < 4; ++l) {
+     const float v = (vec[t[0]][l] * fac[t[1]][l] - vec[t[2]][l] * fac[t[3]][l]) + vec[t[4]][l] * fac[t[5]][l];
+     r.m[i][l] = (i + l) % 2 == 0 ? v : -v;
+    }
+   }
+   const float det = (m[0][0] * r.m[0][0] + m[0][1] * r.m[1][0]) + (m[0][2] * r.m[2][0] + m[0][3] * r.m[3][0]);
+   if (det == 0.f) return identity();
+   return r * (1.f / det);
+  }
+
+  /** Scalar product with the same left-to-right accumulation as the SIMD paths. */
+  constexpr Matrix4x4
+   multiplyScalar(const Matrix4x4& otro) const {
+   Matrix4x4 r = zero();
+   for (int fil = 0; fil < 4; ++fil)
+    for (int col = 0; col < 4; ++col)
+     r.m[fil][col] = ((m[fil][0] * otro.m[0][col] + m[fil][1] * otro.m[1][col])
+                      + m[fil][2] * otro.m[2][col]) + m[fil][3] * otro.m[3][col];
+   return r;
+  }
  };
+
+ EU_ASSERT_VALUE_TYPE(Matrix4x4);
+
+ namespace detail {
+  /**
+   * Calls kernel(a, i, count) once per register of matrices, with a[r][c] holding element
+   * (r, c) of in[i + k] in lane k. The last partial register is padded with identity.
+   */
+  template<typename Kernel>
+  inline void
+   forEachMatrixLanes(const Matrix4x4* in, size_t n, Kernel kernel) {
+   using V = EU::SIMD::FloatN;
+   const size_t W = static_cast<size_t>(V::WIDTH);
+   for (size_t i = 0; i < n; i += W) {
+    const size_t count = n - i < W ? n - i : W;
+    float lanes[16][V::WIDTH];
+    for (size_t k = 0; k < W; ++k)
+     for (int e = 0; e < 16; ++e) lanes[e][k] = k < count ? in[i + k].m[e / 4][e % 4] : (e % 5 == 0 ? 1.f : 0.f);
+    V a[4][4];
+    for (int e = 0; e < 16; ++e) a[e / 4][e % 4] = V::load(lanes[e]);
+    kernel(a, i, count);
+   }
+  }
+
+  /** Writes the first count lanes of v to out. */
+  inline void
+   storeMatrixLanes(EU::SIMD::FloatN v, size_t count, float* out) {
+   float lanes[EU::SIMD::FloatN::WIDTH];
+   v.store(lanes);
+   for (size_t k = 0; k < count; ++k) out[k] = lanes[k];
+  }
+
+  /** Writes the first count lanes of mask to out as bools. */
+  inline void
+   storeMatrixLanes(EU::SIMD::FloatN mask, size_t count, bool* out) {
+   const int bits = EU::SIMD::movemask(mask);
+   for (size_t k = 0; k < count; ++k) out[k] = ((bits >> k) & 1) != 0;
+  }
+
+  /** Matrix4x4::determinant3x3() on every lane. */
+  inline EU::SIMD::FloatN
+   determinant3x3Lanes(const EU::SIMD::FloatN (&a)[4][4]) {
+   const EU::SIMD::FloatN c00 = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+   const EU::SIMD::FloatN c01 = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+   const EU::SIMD::FloatN c02 = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+   return (a[0][0] * c00 + a[0][1] * c01) + a[0][2] * c02;
+  }
+ }
+
+ /**
+  * @brief out[i] = in[i].determinant(), a register of matrices at a time with the same
+  * operation order, so the results match the member bit for bit unless the multiply-adds
+  * are fused (FMA targets outside EU_REPRODUCIBLE).
+  */
+ inline void
+  determinantArray(const Matrix4x4* in, float* out, size_t n) {
+  using V = EU::SIMD::FloatN;
+  detail::forEachMatrixLanes(in, n, [&](const V (&a)[4][4], size_t i, size_t count) {
+   const V s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+   const V s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+   const V s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+   const V s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+   const V s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+   const V s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+   const V c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+   const V c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+   const V c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+   const V c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+   const V c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+   const V c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+   detail::storeMatrixLanes(s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0, count, out + i);
+  });
+ }
+
+ /**
+  * @brief out[i] = in[i].determinant3x3(), bit for bit unless the multiply-adds are fused
+  * (FMA targets outside EU_REPRODUCIBLE).
+  */
+ inline void
+  determinant3x3Array(const Matrix4x4* in, float* out, size_t n) {
+  using V = EU::SIMD::FloatN;
+  detail::forEachMatrixLanes(in, n, [&](const V (&a)[4][4], size_t i, size_t count) {
+   detail::storeMatrixLanes(detail::determinant3x3Lanes(a), count, out + i);
+  });
+ }
+
+ /**
+  * @brief out[i] = in[i].isAffine().
+  */
+ inline void
+  isAffineArray(const Matrix4x4* in, bool* out, size_t n) {
+  using V = EU::SIMD::FloatN;
+  const V zero = V::zero(), one = V::set1(1.f);
+  detail::forEachMatrixLanes(in, n, [&](const V (&a)[4][4], size_t i, size_t count) {
+   const V affine = (a[3][0] == zero) & (a[3][1] == zero) & (a[3][2] == zero) & (a[3][3] == one);
+   detail::storeMatrixLanes(affine, count, out + i);
+  });
+ }
+
+ /**
+  * @brief out[i] = in[i].isOrthonormal(epsilon).
+  */
+ inline void
+  isOrthonormalArray(const Matrix4x4* in, bool* out, size_t n, float epsilon = EU::Constants::EPSILON) {
+  using V = EU::SIMD::FloatN;
+  const V zero = V::zero(), one = V::set1(1.f), eps = V::set1(epsilon), negEps = V::set1(-epsilon);
+  detail::forEachMatrixLanes(in, n, [&](const V (&a)[4][4], size_t i, size_t count) {
+   V ok = EU::SIMD::asFloat(V::Int::set1(-1));
+   for (int c0 = 0; c0 < 3; ++c0) {
+    for (int c1 = c0; c1 < 3; ++c1) {
+     const V d = (a[0][c0] * a[0][c1] + a[1][c0] * a[1][c1]) + a[2][c0] * a[2][c1];
+     const V e = d - (c0 == c1 ? one : zero);
+     ok = ok & (e <= eps) & (e >= negEps);
+    }
+   }
+   detail::storeMatrixLanes(ok, count, out + i);
+  });
+ }
+
+ /**
+  * @brief out[i] = in[i].hasNegativeScale(); the matrices whose triangles need their winding
+  * flipped. When the multiply-adds are fused (FMA targets outside EU_REPRODUCIBLE), a
+  * determinant within rounding of zero can take either sign here and in the member.
+  */
+ inline void
+  hasNegativeScaleArray(const Matrix4x4* in, bool* out, size_t n) {
+  using V = EU::SIMD::FloatN;
+  const V zero = V::zero();
+  detail::forEachMatrixLanes(in, n, [&](const V (&a)[4][4], size_t i, size_t count) {
+   detail::storeMatrixLanes(detail::determinant3x3Lanes(a) < zero, count, out + i);
+  });
+ }
+
+ /**
+  * @brief out[i] = in[i].normalMatrix(tolerance), bit for bit unless the multiply-adds are
+  * fused (FMA targets outside EU_REPRODUCIBLE).
+  */
+ inline void
+  normalMatrixArray(const Matrix4x4* in, Matrix3x3* out, size_t n, float tolerance = 1e-5f) {
+  detail::normalMatrixLanes(in, nullptr, n, out, tolerance);
+ }
 }
@@ -0,0 +1,210 @@
+/**
+ * @file MatrixDecompose.h
+ * @brief Translation/rotation/scale and polar decomposition of composed matrices.
+ *
+ * decompose() is the common affine case: each column's length comes from one inverse
+ * square root (scale = lenSq * rsqrt(lenSq)), and the rotation is read from the unit columns
+ * with Quaternion::fromMatrix() (Shepperd's method with the pivot selected, normalized once,
+ * so no divide or extra square root is needed). Shear cannot be represented and leaks into
+ * the rotation.
+ *
+ * polarDecompose() handles shear: M = R S with R a rotation and S symmetric, found by scaled
+ * Newton iteration on Matrix3x3::inverseTranspose(). It converges in a handful of steps for
+ * well-conditioned matrices.
+ *
+ * decomposeArray() runs decompose() one register of matrices at a time; the lane path uses
+ * the policy's lane rsqrt, so it agrees with the scalar call to within the policy's
+ * precision rather than bit for bit.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/Matrix3x3.h>
+#include <Matrices/Matrix4x4.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ namespace detail {
+  /** Squared Frobenius norm. */
+  constexpr float
+   normSq(const Matrix3x3& a) {
+   float sum = 0.f;
+   for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j) sum += a.m[i][j] * a.m[i][j];
+   return sum;
+  }
+
+  /** decompose() for the top three rows of any 3x4 or 4x4 row-major matrix. */
+  template<typename Policy, typename Matrix>
+  EU_CONSTEXPR20 void
+   decomposeRows(const Matrix& a, CVector3& translation, Quaternion& rotation, CVector3& scale) {
+   translation = CVector3(a.m[0][3], a.m[1][3], a.m[2][3]);
+   float inv[3] = {}, len[3] = {};
+   for (int c = 0; c < 3; ++c) {
+    const float lenSq = a.m[0][c] * a.m[0][c] + a.m[1][c] * a.m[1][c] + a.m[2][c] * a.m[2][c];
+    inv[c] = lenSq > 0.f ? Policy::invLength(lenSq) : 0.f;
+    len[c] = lenSq * inv[c];
+   }
+   const float det = a.m[0][0] * (a.m[1][1] * a.m[2][2] - a.m[1][2] * a.m[2][1])
+                     - a.m[0][1] * (a.m[1][0] * a.m[2][2] - a.m[1][2] * a.m[2][0])
+                     + a.m[0][2] * (a.m[1][0] * a.m[2][1] - a.m[1][1] * a.m[2][0]);
+   if (det < 0.f) {
+    len[0] = -len[0];
+    inv[0] = -inv[0];
+   }
+   scale = CVector3(len[0], len[1], len[2]);
+   Matrix3x3 r;
+   for (int i = 0; i < 3; ++i)
+    for (int c = 0; c < 3; ++c) r.m[i][c] = a.m[i][c] * inv[c];
+   rotation = Quaternion::fromMatrix<Policy>(r);
+  }
+
+  /**
+   * decomposeRows() across a register of matrices: the twelve elements are gathered into
+   * lanes (identity padding for the last partial register), every pivot candidate is built
+   * and the largest selected per lane.
+   */
+  template<typename Policy, typename Matrix>
+  inline void
+   decomposeArray(const Matrix* in, CVector3* translations, Quaternion* rotations, CVector3* scales, size_t n) {
+   using V = EU::SIMD::FloatN;
+   const size_t W = static_cast<size_t>(V::WIDTH);
+   const V zero = V::zero();
+   for (size_t i = 0; i < n; i += W) {
+    const size_t count = n - i < W ? n - i : W;
+    float lanes[12][V::WIDTH];
+    for (size_t k = 0; k < W; ++k)
+     for (int e = 0; e < 12; ++e) lanes[e][k] = k < count ? in[i + k].m[e / 4][e % 4] : (e % 5 == 0 ? 1.f : 0.f);
+    V a[3][4];
+    for (int e = 0; e < 12; ++e) a[e / 4][e % 4] = V::load(lanes[e]);
+    V inv[3], len[3];
+    for (int c = 0; c < 3; ++c) {
+     const V lenSq = Policy::maddLanes(a[2][c], a[2][c], Policy::maddLanes(a[1][c], a[1][c], a[0][c] * a[0][c]));
+     inv[c] = Policy::invLengthLanes(lenSq) & (lenSq > zero);
+     len[c] = lenSq * inv[c];
+    }
+    const V det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+                  - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+                  + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    const V mirrored = det < zero;
+    len[0] = EU::SIMD::select(mirrored, zero - len[0], len[0]);
+    inv[0] = EU::SIMD::select(mirrored, zero - inv[0], inv[0]);
+    V r[3][3];
+    for (int row = 0; row < 3; ++row)
+     for (int c = 0; c < 3; ++c) r[row][c] = a[row][c] * inv[c];
+    V q[4];
+    detail::rotationToQuaternionLanes<Policy>(r, q);
+    for (int c = 0; c < 3; ++c) len[c].store(lanes[c]);
+    for (int c = 0; c < 4; ++c) q[c].store(lanes[3 + c]);
+    for (size_t k = 0; k < count; ++k) {
+     translations[i + k] = CVector3(in[i + k].m[0][3], in[i + k].m[1][3], in[i + k].m[2][3]);
+     scales[i + k] = CVector3(lanes[0][k], lanes[1][k], lanes[2][k]);
+     rotations[i + k] = Quaternion(lanes[3][k], lanes[4][k], lanes[5][k], lanes[6][k]);
+    }
+   }
+  }
+ }
+
+ /**
+  * @brief Splits an affine matrix into translation * rotation * scale, the inverse of
+  * Affine3x4::fromTRS().
+  *
+  * A mirrored matrix (negative determinant) reports a negative x scale. The bottom row is not
+  * read. A zero-length column gives zero scale and drops out of the rotation.
+  */
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 void
+  decompose(const Matrix4x4& matrix, CVector3& translation, Quaternion& rotation, CVector3& scale) {
+  detail::decomposeRows<Policy>(matrix, translation, rotation, scale);
+ }
+
+ /**
+  * @brief Polar decomposition matrix = rotation * stretch, with rotation proper and stretch
+  * symmetric (it carries scale, shear and any mirroring).
+  *
+  * Iterates X = (g X + X^-T / g) / 2 with Frobenius scaling g until X stops changing. A
+  * singular matrix has no unique polar factor: rotation is the identity and stretch the
+  * matrix itself.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  polarDecompose(const Matrix3x3& matrix, Matrix3x3& rotation, Matrix3x3& stretch,
+                 int maxIterations = 20, float tolerance = 1e-6f) {
+  const float det = matrix.determinant();
+  if (det == 0.f) {
+   rotation = Matrix3x3::identity();
+   stretch = matrix;
+   return;
+  }
+  // The polar factor of a mirrored matrix is a reflection; iterate on -matrix instead so the
+  // factor is a rotation and the reflection ends up in stretch.
+  Matrix3x3 x = det < 0.f ? matrix * -1.f : matrix;
+  for (int k = 0; k < maxIterations; ++k) {
+   const Matrix3x3 y = x.inverseTranspose();
+   const float xNormSq = detail::normSq(x);
+   const float g = Policy::sqrt(Policy::sqrt(detail::normSq(y) / xNormSq));
+   const Matrix3x3 next = x * (0.5f * g) + y * (0.5f / g);
+   const float changeSq = detail::normSq(next - x);
+   x = next;
+   if (changeSq <= tolerance * tolerance * xNormSq) break;
+  }
+  rotation = x;
+  const Matrix3x3 s = x.transpose() * matrix;
+  stretch = (s + s.transpose()) * 0.5f;
+ }
+
+ /**
+  * @brief polarDecompose() of the upper 3x3 block of an affine matrix, with the rotation as
+  * a quaternion and the translation split off.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  polarDecompose(const Matrix4x4& matrix, CVector3& translation, Quaternion& rotation, Matrix3x3& stretch,
+                 int maxIterations = 20, float tolerance = 1e-6f) {
+  translation = CVector3(matrix.m[0][3], matrix.m[1][3], matrix.m[2][3]);
+  const Matrix3x3 linear(matrix.m[0][0], matrix.m[0][1], matrix.m[0][2],
+                         matrix.m[1][0], matrix.m[1][1], matrix.m[1][2],
+                         matrix.m[2][0], matrix.m[2][1], matrix.m[2][2]);
+  Matrix3x3 r(EU::NoInit);
+  polarDecompose<Policy>(linear, r, stretch, maxIterations, tolerance);
+  rotation = Quaternion::fromMatrix<Policy>(r);
+ }
+
+ /** @brief decompose() of in[0..n), one register of matrices per step. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  decomposeArray(const Matrix4x4* in, CVector3* translations, Quaternion* rotations, CVector3* scales, size_t n) {
+  detail::decomposeArray<Policy>(in, translations, rotations, scales, n);
+ }
+
+ /** @brief Affine3x4::decompose() of in[0..n), one register of transforms per step. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  decomposeArray(const Affine3x4* in, CVector3* translations, Quaternion* rotations, CVector3* scales, size_t n) {
+  detail::decomposeArray<Policy>(in, translations, rotations, scales, n);
+ }
+
+ /**
+  * @brief polarDecompose() of in[0..n). Each matrix converges in its own number of steps,
+  * so this is a plain loop.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  polarDecomposeArray(const Matrix3x3* in, Matrix3x3* rotations, Matrix3x3* stretches, size_t n) {
+  for (size_t i = 0; i < n; ++i) polarDecompose<Policy>(in[i], rotations[i], stretches[i]);
+ }
+
+ /** @brief polarDecompose() of the affine matrices in[0..n). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  polarDecomposeArray(const Matrix4x4* in, CVector3* translations, Quaternion* rotations,
+                      Matrix3x3* stretches, size_t n) {
+  for (size_t i = 0; i < n; ++i) polarDecompose<Policy>(in[i], translations[i], rotations[i], stretches[i]);
+ }
+}
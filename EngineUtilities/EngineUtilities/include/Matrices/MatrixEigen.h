@@ -0,0 +1,122 @@
+/**
+ * @file MatrixEigen.h
+ * @brief Eigen decomposition of symmetric 3x3 matrices (covariances, inertia tensors).
+ *
+ * symmetricEigen() runs cyclic Jacobi: each sweep zeroes the three off-diagonal pairs in
+ * turn with one plane rotation apiece, accumulating the rotations into the eigenvector
+ * matrix. Convergence is quadratic, so the default of five sweeps (fifteen rotations) reaches
+ * float precision for any input. The sweep count is fixed rather than tested against a
+ * tolerance, which keeps the cost of a call predictable. Rotations on pairs that are already
+ * zero are skipped.
+ *
+ * Each rotation is built from one Policy::sqrt and one Policy::invLength. The rotation angle
+ * only affects how fast the sweeps converge, but the cosine/sine pair has to be unit length
+ * for the eigenvectors to stay orthonormal, so the Fast policy leaves them orthonormal only
+ * to about 1e-3.
+ *
+ * Results are sorted by decreasing eigenvalue and the eigenvector matrix is a proper rotation
+ * (determinant +1), so it converts directly to a Quaternion. For an inertia tensor the
+ * eigenvalues are the principal moments and the rotation is the principal frame; for a
+ * covariance the first column is the direction of largest spread.
+ */
+
+#pragma once
+
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Matrices/Matrix3x3.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ namespace detail {
+  /**
+   * One Jacobi rotation zeroing a[p][q] of the symmetric a (updated in place), applied to the
+   * columns p and q of v. r is the remaining index.
+   */
+  template<typename Policy>
+  EU_CONSTEXPR20 void
+   jacobiRotate(float (&a)[3][3], float (&v)[3][3], int p, int q, int r) {
+   const float apq = a[p][q];
+   if (apq == 0.f) return;
+   // tan of the rotation angle, the smaller root of t^2 + 2 theta t - 1 = 0.
+   const float theta = (a[q][q] - a[p][p]) / (2.f * apq);
+   const float absTheta = EngineMath::fabs(theta);
+   float t = absTheta > 1e10f ? 0.5f / theta : 1.f / (absTheta + Policy::sqrt(theta * theta + 1.f));
+   if (theta < 0.f && absTheta <= 1e10f) t = -t;
+   const float c = Policy::invLength(t * t + 1.f);
+   const float s = t * c;
+   a[p][p] -= t * apq;
+   a[q][q] += t * apq;
+   a[p][q] = a[q][p] = 0.f;
+   const float arp = a[r][p], arq = a[r][q];
+   a[r][p] = a[p][r] = c * arp - s * arq;
+   a[r][q] = a[q][r] = s * arp + c * arq;
+   for (int k = 0; k < 3; ++k) {
+    const float vkp = v[k][p], vkq = v[k][q];
+    v[k][p] = c * vkp - s * vkq;
+    v[k][q] = s * vkp + c * vkq;
+   }
+  }
+
+  /** Swaps eigenpairs i and j: the values and the matching columns of v. */
+  constexpr void
+   swapEigenPair(float (&values)[3], float (&v)[3][3], int i, int j) {
+   const float value = values[i];
+   values[i] = values[j];
+   values[j] = value;
+   for (int k = 0; k < 3; ++k) {
+    const float e = v[k][i];
+    v[k][i] = v[k][j];
+    v[k][j] = e;
+   }
+  }
+ }
+
+ /**
+  * @brief Eigenvalues and eigenvectors of the symmetric matrix a (only its lower triangle is
+  * read).
+  *
+  * eigenvalues come out in decreasing order; column i of eigenvectors is the unit
+  * eigenvector of eigenvalues[i], and the columns form a rotation. a = V diag(values) V^T.
+  */
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 void
+  symmetricEigen(const Matrix3x3& a, CVector3& eigenvalues, Matrix3x3& eigenvectors, int sweeps = 5) {
+  float s[3][3] = {};
+  for (int i = 0; i < 3; ++i)
+   for (int j = 0; j <= i; ++j) s[i][j] = s[j][i] = a.m[i][j];
+  float v[3][3] = { { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f, 1.f } };
+  for (int sweep = 0; sweep < sweeps; ++sweep) {
+   detail::jacobiRotate<Policy>(s, v, 0, 1, 2);
+   detail::jacobiRotate<Policy>(s, v, 0, 2, 1);
+   detail::jacobiRotate<Policy>(s, v, 1, 2, 0);
+  }
+  float values[3] = { s[0][0], s[1][1], s[2][2] };
+  if (values[1] > values[0]) detail::swapEigenPair(values, v, 0, 1);
+  if (values[2] > values[1]) detail::swapEigenPair(values, v, 1, 2);
+  if (values[1] > values[0]) detail::swapEigenPair(values, v, 0, 1);
+  // Swaps flip the handedness; an eigenvector's sign is free, so flip the last one back.
+  const float det = v[0][0] * (v[1][1] * v[2][2] - v[1][2] * v[2][1])
+                    - v[0][1] * (v[1][0] * v[2][2] - v[1][2] * v[2][0])
+                    + v[0][2] * (v[1][0] * v[2][1] - v[1][1] * v[2][0]);
+  if (det < 0.f) {
+   for (int k = 0; k < 3; ++k) v[k][2] = -v[k][2];
+  }
+  eigenvalues = CVector3(values[0], values[1], values[2]);
+  for (int i = 0; i < 3; ++i)
+   for (int j = 0; j < 3; ++j) eigenvectors.m[i][j] = v[i][j];
+ }
+
+ /**
+  * @brief symmetricEigen() with the eigenvector rotation returned as a quaternion: rotating
+  * the x, y and z axes by rotation gives the eigenvectors in decreasing eigenvalue order.
+  */
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 void
+  symmetricEigen(const Matrix3x3& a, CVector3& eigenvalues, Quaternion& rotation, int sweeps = 5) {
+  Matrix3x3 v;
+  symmetricEigen<Policy>(a, eigenvalues, v, sweeps);
+  rotation = Quaternion::fromMatrix<Policy>(v);
+ }
+}
@@ -0,0 +1,502 @@
+/**
+ * @file MatrixN.h
+ * @brief Fixed-size Matrix<R, C> and dynamic MatrixX for solver-sized linear algebra.
+ *
+ * Matrix<R, C> is a constexpr value type for the small dense systems of constraint solvers
+ * and IK (6x6, 12x12 Jacobian blocks); VectorN<N> is its column vector. Sizes are checked
+ * at compile time, so a mismatched product does not build.
+ *
+ * MatrixX holds any size in one 64-byte aligned block, each row padded with zeros to a
+ * whole number of SIMD registers. resize() keeps the block whenever the new size fits, so
+ * a solver that reuses its matrices allocates once. multiply() and transposeMultiply()
+ * walk B in KC x NC blocks that stay in cache, and compute each register tile of four rows
+ * by two registers of C in registers. Every element still accumulates over k in ascending
+ * order, so the result does not depend on the blocking.
+ *
+ * Matrix2x2, Matrix3x3 and Matrix4x4 stay separate types; their hand-written SIMD paths do
+ * not fit a generic layout. Matrix<R, C>(m.m) copies any of them into the template.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <Core/Platform.h>
+#include <Core/SIMD.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /**
+  * @class Matrix
+  * @brief Dense R x C matrix in row-major order.
+  */
+ template<size_t R, size_t C>
+ class
+  Matrix {
+  static_assert(R > 0 && C > 0, "Matrix needs at least one row and one column");
+
+  public:
+  float m[R][C]; ///< Matrix elements in row-major order
+
+  /**
+   * @brief Default constructor. Initializes to zero.
+   */
+  constexpr Matrix() : m{} {}
+
+  /**
+   * @brief Leaves every element uninitialized; see EU::NoInit.
+   */
+  explicit Matrix(EU::NoInitTag) {}
+
+  /**
+   * @brief Copies a row-major element array, e.g. the m member of Matrix4x4.
+   */
+  explicit constexpr Matrix(const float (&elements)[R][C]) : m{} {
+   for (size_t i = 0; i < R; ++i)
+    for (size_t j = 0; j < C; ++j)
+     m[i][j] = elements[i][j];
+  }
+
+  static constexpr size_t
+   rows() {
+   return R;
+  }
+
+  static constexpr size_t
+   cols() {
+   return C;
+  }
+
+  constexpr Matrix
+   operator+(const Matrix& otro) const {
+   Matrix r;
+   for (size_t i = 0; i < R; ++i)
+    for (size_t j = 0; j < C; ++j)
+     r.m[i][j] = m[i][j] + otro.m[i][j];
+   return r;
+  }
+
+  constexpr Matrix
+   operator-(const Matrix& otro) const {
+   Matrix r;
+   for (size_t i = 0; i < R; ++i)
+    for (size_t j = 0; j < C; ++j)
+     r.m[i][j] = m[i][j] - otro.m[i][j];
+   return r;
+  }
+
+  constexpr Matrix
+   operator*(float sca) const {
+   Matrix r;
+   for (size_t i = 0; i < R; ++i)
+    for (size_t j = 0; j < C; ++j)
+     r.m[i][j] = m[i][j] * sca;
+   return r;
+  }
+
+  /**
+   * @brief Matrix product. Each row is accumulated as a sum of otro's rows, k = 0..C-1, a
+   * loop the compiler vectorizes for the usual solver sizes.
+   */
+  template<size_t K>
+  constexpr Matrix<R, K>
+   operator*(const Matrix<C, K>& otro) const {
+   Matrix<R, K> r;
+   for (size_t i = 0; i < R; ++i)
+    for (size_t k = 0; k < C; ++k)
+     for (size_t j = 0; j < K; ++j)
+      r.m[i][j] += m[i][k] * otro.m[k][j];
+   return r;
+  }
+
+  /**
+   * @brief transpose() * otro without forming the transpose, e.g. J^T J.
+   */
+  template<size_t K>
+  constexpr Matrix<C, K>
+   transposeMultiply(const Matrix<R, K>& otro) const {
+   Matrix<C, K> r;
+   for (size_t k = 0; k < R; ++k)
+    for (size_t i = 0; i < C; ++i)
+     for (size_t j = 0; j < K; ++j)
+      r.m[i][j] += m[k][i] * otro.m[k][j];
+   return r;
+  }
+
+  constexpr Matrix&
+   operator+=(const Matrix& otro) {
+   for (size_t i = 0; i < R; ++i)
+    for (size_t j = 0; j < C; ++j)
+     m[i][j] += otro.m[i][j];
+   return *this;
+  }
+
+  constexpr Matrix&
+   operator-=(const Matrix& otro) {
+   for (size_t i = 0; i < R; ++i)
+    for (size_t j = 0; j < C; ++j)
+     m[i][j] -= otro.m[i][j];
+   return *this;
+  }
+
+  constexpr Matrix&
+   operator*=(float sca) {
+   for (size_t i = 0; i < R; ++i)
+    for (size_t j = 0; j < C; ++j)
+     m[i][j] *= sca;
+   return *this;
+  }
+
+  constexpr float&
+   operator()(size_t fil, size_t col) {
+   return m[fil][col];
+  }
+
+  constexpr const float&
+   operator()(size_t fil, size_t col) const {
+   return m[fil][col];
+  }
+
+  constexpr Matrix<C, R>
+   transpose() const {
+   Matrix<C, R> r;
+   for (size_t i = 0; i < R; ++i)
+    for (size_t j = 0; j < C; ++j)
+     r.m[j][i] = m[i][j];
+   return r;
+  }
+
+  /**
+   * @brief Returns an identity matrix; square sizes only.
+   */
+  static constexpr Matrix
+   identity() {
+   static_assert(R == C, "identity() needs a square matrix");
+   Matrix r;
+   for (size_t i = 0; i < R; ++i) r.m[i][i] = 1.f;
+   return r;
+  }
+
+  /**
+   * @brief Returns a zero matrix.
+   */
+  static constexpr Matrix
+   zero() {
+   return Matrix();
+  }
+ };
+
+ /// Column vector of N elements; Matrix<R, N> * VectorN<N> is a VectorN<R>.
+ template<size_t N>
+ using VectorN = Matrix<N, 1>;
+
+ EU_ASSERT_VALUE_TYPE(Matrix<6, 6>);
+
+ /**
+  * @class MatrixX
+  * @brief Dense matrix sized at run time, stored row-major with SIMD-padded rows.
+  *
+  * Elements past cols() in each row are always zero. Copies allocate only when the
+  * destination's block is too small.
+  */
+ class
+  MatrixX {
+  public:
+  /// Alignment of the element block and therefore of every row.
+  static constexpr size_t ALIGNMENT = 64;
+
+  MatrixX() : m_storage(nullptr), m_data(nullptr), m_capacity(0), m_rows(0), m_cols(0), m_stride(0) {}
+
+  /**
+   * @brief A rows x cols zero matrix.
+   */
+  MatrixX(size_t rows, size_t cols) : MatrixX() {
+   resize(rows, cols);
+  }
+
+  /**
+   * @brief Copies a fixed-size matrix.
+   */
+  template<size_t R, size_t C>
+  explicit MatrixX(const Matrix<R, C>& fixed) : MatrixX(R, C) {
+   for (size_t i = 0; i < R; ++i) std::memcpy(row(i), fixed.m[i], C * sizeof(float));
+  }
+
+  MatrixX(const MatrixX& otro) : MatrixX() {
+   *this = otro;
+  }
+
+  MatrixX(MatrixX&& otro) noexcept
+   : m_storage(otro.m_storage), m_data(otro.m_data), m_capacity(otro.m_capacity),
+     m_rows(otro.m_rows), m_cols(otro.m_cols), m_stride(otro.m_stride) {
+   otro.m_storage = nullptr;
+   otro.m_data = nullptr;
+   otro.m_capacity = otro.m_rows = otro.m_cols = otro.m_stride = 0;
+  }
+
+  ~MatrixX() {
+   ::operator delete(m_storage);
+  }
+
+  MatrixX&
+   operator=(const MatrixX& otro) {
+   if (this != &otro) {
+    resize(otro.m_rows, otro.m_cols);
+    if (m_data != nullptr) std::memcpy(m_data, otro.m_data, m_rows * m_stride * sizeof(float));
+   }
+   return *this;
+  }
+
+  MatrixX&
+   operator=(MatrixX&& otro) noexcept {
+   if (this != &otro) {
+    ::operator delete(m_storage);
+    m_storage = otro.m_storage;
+    m_data = otro.m_data;
+    m_capacity = otro.m_capacity;
+    m_rows = otro.m_rows;
+    m_cols = otro.m_cols;
+    m_stride = otro.m_stride;
+    otro.m_storage = nullptr;
+    otro.m_data = nullptr;
+    otro.m_capacity = otro.m_rows = otro.m_cols = otro.m_stride = 0;
+   }
+   return *this;
+  }
+
+  /**
+   * @brief Makes this a rows x cols zero matrix. The element block is reused when it is
+   * large enough, so shrinking or regrowing within the first size never allocates.
+   */
+  void
+   resize(size_t rows, size_t cols) {
+   const size_t width = static_cast<size_t>(EU::SIMD::FloatN::WIDTH);
+   const size_t stride = (cols + width - 1) / width * width;
+   const size_t count = rows * stride;
+   if (count > m_capacity) {
+    void* storage = ::operator new(count * sizeof(float) + ALIGNMENT);
+    ::operator delete(m_storage);
+    m_storage = storage;
+    const uintptr_t address = reinterpret_cast<uintptr_t>(storage);
+    m_data = reinterpret_cast<float*>((address + ALIGNMENT) & ~uintptr_t(ALIGNMENT - 1));
+    m_capacity = count;
+   }
+   m_rows = rows;
+   m_cols = cols;
+   m_stride = stride;
+   setZero();
+  }
+
+  size_t
+   rows() const {
+   return m_rows;
+  }
+
+  size_t
+   cols() const {
+   return m_cols;
+  }
+
+  /** @brief Floats between the starts of consecutive rows, a multiple of the SIMD width. */
+  size_t
+   stride() const {
+   return m_stride;
+  }
+
+  float*
+   data() {
+   return m_data;
+  }
+
+  const float*
+   data() const {
+   return m_data;
+  }
+
+  /** @brief Start of row fil; ALIGNMENT-aligned. */
+  float*
+   row(size_t fil) {
+   return m_data + fil * m_stride;
+  }
+
+  const float*
+   row(size_t fil) const {
+   return m_data + fil * m_stride;
+  }
+
+  float&
+   operator()(size_t fil, size_t col) {
+   return m_data[fil * m_stride + col];
+  }
+
+  const float&
+   operator()(size_t fil, size_t col) const {
+   return m_data[fil * m_stride + col];
+  }
+
+  /** @brief Sets every element to zero. */
+  void
+   setZero() {
+   if (m_data != nullptr) std::memset(m_data, 0, m_rows * m_stride * sizeof(float));
+  }
+
+  /** @brief Ones on the diagonal, zeros elsewhere; rectangular sizes get a partial identity. */
+  void
+   setIdentity() {
+   setZero();
+   for (size_t i = 0; i < m_rows && i < m_cols; ++i) (*this)(i, i) = 1.f;
+  }
+
+  private:
+  void* m_storage;   ///< Block returned by operator new
+  float* m_data;     ///< m_storage rounded up to ALIGNMENT
+  size_t m_capacity; ///< Floats available at m_data
+  size_t m_rows;
+  size_t m_cols;
+  size_t m_stride;   ///< Padded row length in floats
+ };
+
+ namespace detail {
+  /// Rows of B per cache block.
+  constexpr size_t GEMM_KC = 128;
+  /// Registers of B columns per cache block (256 floats with AVX, 128 with SSE).
+  constexpr size_t GEMM_NC = 32;
+
+  /**
+   * C tile of ROWS rows by VECS registers at c += A * B over kCount values of k. Element
+   * (r, k) of A is a[r * rowStep + k * kStep], so the same tile serves A * B and A^T * B.
+   */
+  template<int ROWS, int VECS>
+  inline void
+   gemmTile(const float* a, size_t rowStep, size_t kStep, const float* b, size_t bStride,
+            float* c, size_t cStride, size_t kCount) {
+   using V = EU::SIMD::FloatN;
+   const size_t W = static_cast<size_t>(V::WIDTH);
+   V acc[ROWS][VECS];
+   for (int r = 0; r < ROWS; ++r)
+    for (int v = 0; v < VECS; ++v) acc[r][v] = V::load(c + r * cStride + v * W);
+   for (size_t k = 0; k < kCount; ++k) {
+    V bk[VECS];
+    for (int v = 0; v < VECS; ++v) bk[v] = V::load(b + k * bStride + v * W);
+    for (int r = 0; r < ROWS; ++r) {
+     const V ark = V::set1(a[r * rowStep + k * kStep]);
+     for (int v = 0; v < VECS; ++v) acc[r][v] = EU::SIMD::madd(ark, bk[v], acc[r][v]);
+    }
+   }
+   for (int r = 0; r < ROWS; ++r)
+    for (int v = 0; v < VECS; ++v) acc[r][v].store(c + r * cStride + v * W);
+  }
+
+  /**
+   * c (m x b.cols(), zeroed) += A * b with A given as in gemmTile() and kDim = b.rows().
+   */
+  inline void
+   gemm(const float* a, size_t rowStep, size_t kStep, size_t m, const MatrixX& b, MatrixX& c) {
+   const size_t W = static_cast<size_t>(EU::SIMD::FloatN::WIDTH);
+   const size_t vecs = b.stride() / W, kDim = b.rows();
+   for (size_t jj = 0; jj < vecs; jj += GEMM_NC) {
+    const size_t jEnd = vecs - jj < GEMM_NC ? vecs : jj + GEMM_NC;
+    for (size_t kk = 0; kk < kDim; kk += GEMM_KC) {
+     const size_t kCount = kDim - kk < GEMM_KC ? kDim - kk : GEMM_KC;
+     const float* bBlock = b.row(kk);
+     size_t i = 0;
+     for (; i + 4 <= m; i += 4) {
+      const float* ai = a + i * rowStep + kk * kStep;
+      size_t j = jj;
+      for (; j + 2 <= jEnd; j += 2) gemmTile<4, 2>(ai, rowStep, kStep, bBlock + j * W, b.stride(), c.row(i) + j * W, c.stride(), kCount);
+      if (j < jEnd) gemmTile<4, 1>(ai, rowStep, kStep, bBlock + j * W, b.stride(), c.row(i) + j * W, c.stride(), kCount);
+     }
+     for (; i < m; ++i) {
+      const float* ai = a + i * rowStep + kk * kStep;
+      size_t j = jj;
+      for (; j + 2 <= jEnd; j += 2) gemmTile<1, 2>(ai, rowStep, kStep, bBlock + j * W, b.stride(), c.row(i) + j * W, c.stride(), kCount);
+      if (j < jEnd) gemmTile<1, 1>(ai, rowStep, kStep, bBlock + j * W, b.stride(), c.row(i) + j * W, c.stride(), kCount);
+     }
+    }
+   }
+  }
+
+  /** Sum of the lanes of v, first to last. */
+  inline float
+   sumLanes(EU::SIMD::FloatN v) {
+   float lanes[EU::SIMD::FloatN::WIDTH];
+   v.store(lanes);
+   float sum = lanes[0];
+   for (int k = 1; k < EU::SIMD::FloatN::WIDTH; ++k) sum += lanes[k];
+   return sum;
+  }
+ }
+
+ /**
+  * @brief out = a * b. out is resized to a.rows() x b.cols(), reusing its block if it fits.
+  * @return false, leaving out untouched, when a.cols() != b.rows() or out is a or b.
+  */
+ inline bool
+  multiply(const MatrixX& a, const MatrixX& b, MatrixX& out) {
+  if (a.cols() != b.rows() || &out == &a || &out == &b) {
+   return false;
+  }
+  out.resize(a.rows(), b.cols());
+  detail::gemm(a.data(), a.stride(), 1, a.rows(), b, out);
+  return true;
+ }
+
+ /**
+  * @brief out = a^T * b without forming the transpose, e.g. the normal matrix J^T J.
+  * @return false, leaving out untouched, when a.rows() != b.rows() or out is a or b.
+  */
+ inline bool
+  transposeMultiply(const MatrixX& a, const MatrixX& b, MatrixX& out) {
+  if (a.rows() != b.rows() || &out == &a || &out == &b) {
+   return false;
+  }
+  out.resize(a.cols(), b.cols());
+  detail::gemm(a.data(), 1, a.stride(), a.cols(), b, out);
+  return true;
+ }
+
+ /**
+  * @brief y = a * x, with x of a.cols() and y of a.rows() floats. y must not overlap x.
+  */
+ inline void
+  multiply(const MatrixX& a, const float* x, float* y) {
+  using V = EU::SIMD::FloatN;
+  const size_t W = static_cast<size_t>(V::WIDTH);
+  for (size_t i = 0; i < a.rows(); ++i) {
+   const float* row = a.row(i);
+   V acc = V::zero();
+   for (size_t j = 0; j < a.cols(); j += W) {
+    const size_t count = a.cols() - j < W ? a.cols() - j : W;
+    acc = EU::SIMD::madd(V::load(row + j), detail::loadLanes(x, j, count), acc);
+   }
+   y[i] = detail::sumLanes(acc);
+  }
+ }
+
+ /**
+  * @brief y = a^T * x, with x of a.rows() and y of a.cols() floats. y must not overlap x.
+  *
+  * Runs over the rows once per group of four registers of columns, accumulating in
+  * registers, so y is written once.
+  */
+ inline void
+  transposeMultiply(const MatrixX& a, const float* x, float* y) {
+  using V = EU::SIMD::FloatN;
+  const size_t W = static_cast<size_t>(V::WIDTH);
+  for (size_t j = 0; j < a.cols(); j += 4 * W) {
+   const size_t vecs = (a.cols() - j + W - 1) / W < 4 ? (a.cols() - j + W - 1) / W : 4;
+   V acc[4] = { V::zero(), V::zero(), V::zero(), V::zero() };
+   for (size_t i = 0; i < a.rows(); ++i) {
+    const V xi = V::set1(x[i]);
+    const float* row = a.row(i) + j;
+    for (size_t v = 0; v < vecs; ++v) acc[v] = EU::SIMD::madd(xi, V::load(row + v * W), acc[v]);
+   }
+   for (size_t v = 0; v < vecs; ++v) {
+    const size_t col = j + v * W;
+    detail::storeLanes(acc[v], y, col, a.cols() - col < W ? a.cols() - col : W);
+   }
+  }
+ }
+}
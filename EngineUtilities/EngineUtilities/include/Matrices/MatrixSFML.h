@@ -0,0 +1,124 @@
+/**
+ * @file MatrixSFML.h
+ * @brief Zero-copy upload of ColumnMatrix4x4 uniforms through sf::Shader, and zero-copy
+ * views of TransformMatrix and ColumnMatrix4x4 as sf::Transform.
+ *
+ * sf::Glsl::Mat4 is sixteen column-major floats, the same bytes as a ColumnMatrix4x4 (checked
+ * below), so a matrix array is handed to sf::Shader::setUniformArray() by reinterpreting the
+ * pointer: no per-matrix copy, no transpose. The 64-byte alignment of ColumnMatrix4x4 keeps the
+ * stride at exactly 64 bytes. Needs sfml-graphics at link time.
+ *
+ * sf::Transform is the same sixteen column-major floats, so TransformMatrix (the 2D layout it
+ * builds) and ColumnMatrix4x4 (any 4x4, sent to GL as is) are viewed as one in place:
+ *
+ *   target.draw(vertices, sf::RenderStates(asTransform(world)));
+ *
+ * toTransform() and toMatrix3x3() / toMatrix4x4() are the copying conversions for the
+ * row-major types.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <SFML/Graphics/Glsl.hpp>
+#include <SFML/Graphics/Shader.hpp>
+#include <SFML/Graphics/Transform.hpp>
+#include <Matrices/ColumnMatrix4x4.h>
+#include <Matrices/Matrix3x3.h>
+#include <Matrices/Matrix4x4.h>
+#include <Matrices/TransformMatrix.h>
+
+namespace EU {
+ static_assert(sizeof(sf::Glsl::Mat4) == sizeof(ColumnMatrix4x4),
+               "sf::Glsl::Mat4 and ColumnMatrix4x4 must have the same size");
+ static_assert(std::is_standard_layout<sf::Glsl::Mat4>::value && offsetof(sf::Glsl::Mat4, array) == 0,
+               "sf::Glsl::Mat4 must be a bare float[16]");
+ static_assert(sizeof(sf::Transform) == sizeof(TransformMatrix) && std::is_trivially_copyable<sf::Transform>::value,
+               "sf::Transform must be a bare float[16]");
+ static_assert(alignof(sf::Transform) <= alignof(TransformMatrix),
+               "TransformMatrix must be at least as aligned as sf::Transform");
+
+ /** @brief View of a ColumnMatrix4x4 as the sf::Glsl::Mat4 it already is. */
+ inline const sf::Glsl::Mat4&
+  asGlsl(const ColumnMatrix4x4& matrix) {
+  return *reinterpret_cast<const sf::Glsl::Mat4*>(&matrix);
+ }
+
+ /** @brief View of a ColumnMatrix4x4 array as a sf::Glsl::Mat4 array. */
+ inline const sf::Glsl::Mat4*
+  asGlsl(const ColumnMatrix4x4* matrices) {
+  return reinterpret_cast<const sf::Glsl::Mat4*>(matrices);
+ }
+
+ /** @brief shader.setUniform(name, matrix) without building a sf::Glsl::Mat4. */
+ inline void
+  setUniform(sf::Shader& shader, const std::string& name, const ColumnMatrix4x4& matrix) {
+  shader.setUniform(name, asGlsl(matrix));
+ }
+
+ /**
+  * @brief Uploads matrices[0..n) to the mat4[] uniform name, e.g. a bone palette built with
+  * toColumnMajor().
+  */
+ inline void
+  setUniformArray(sf::Shader& shader, const std::string& name, const ColumnMatrix4x4* matrices, size_t n) {
+  shader.setUniformArray(name, asGlsl(matrices), n);
+ }
+
+ /** @brief View of a TransformMatrix as the sf::Transform it already is. */
+ inline const sf::Transform&
+  asTransform(const TransformMatrix& matrix) {
+  return *reinterpret_cast<const sf::Transform*>(&matrix);
+ }
+
+ /** @brief View of a TransformMatrix array as a sf::Transform array. */
+ inline const sf::Transform*
+  asTransform(const TransformMatrix* matrices) {
+  return reinterpret_cast<const sf::Transform*>(matrices);
+ }
+
+ /**
+  * @brief View of a ColumnMatrix4x4 as sf::Transform. SFML only reads its 2D part on the CPU
+  * (transformPoint, bounds) but loads all sixteen floats into GL, so z and projective terms reach
+  * the vertex pipeline.
+  */
+ inline const sf::Transform&
+  asTransform(const ColumnMatrix4x4& matrix) {
+  return *reinterpret_cast<const sf::Transform*>(&matrix);
+ }
+
+ /** @brief View of a ColumnMatrix4x4 array as a sf::Transform array, e.g. after toColumnMajor(). */
+ inline const sf::Transform*
+  asTransform(const ColumnMatrix4x4* matrices) {
+  return reinterpret_cast<const sf::Transform*>(matrices);
+ }
+
+ /** @brief The sf::Transform of a Matrix3x3; same bytes as TransformMatrix(matrix). */
+ inline sf::Transform
+  toTransform(const Matrix3x3& matrix) {
+  return sf::Transform(matrix.m[0][0], matrix.m[0][1], matrix.m[0][2],
+                       matrix.m[1][0], matrix.m[1][1], matrix.m[1][2],
+                       matrix.m[2][0], matrix.m[2][1], matrix.m[2][2]);
+ }
+
+ /** @brief The Matrix3x3 of a sf::Transform, dropping the z row and column. */
+ inline Matrix3x3
+  toMatrix3x3(const sf::Transform& transform) {
+  const float* c = transform.getMatrix();
+  return Matrix3x3(c[0], c[4], c[12],
+                   c[1], c[5], c[13],
+                   c[3], c[7], c[15]);
+ }
+
+ /** @brief The full row-major 4x4 matrix of a sf::Transform. */
+ inline Matrix4x4
+  toMatrix4x4(const sf::Transform& transform) {
+  const float* c = transform.getMatrix();
+  return Matrix4x4(c[0], c[4], c[8], c[12],
+                   c[1], c[5], c[9], c[13],
+                   c[2], c[6], c[10], c[14],
+                   c[3], c[7], c[11], c[15]);
+ }
+}
@@ -0,0 +1,336 @@
+/**
+ * @file MatrixSolve.h
+ * @brief In-place Cholesky and LDLT factorization and solve for small symmetric systems.
+ *
+ * For the 3x3, 4x4 and 6x6 systems of contact solvers and IK, where a general inverse
+ * spends most of its work on cofactors a symmetric matrix does not need. Only the lower
+ * triangle of the input is read; factorization overwrites the matrix with its factor and
+ * zeroes the upper triangle. The loops have compile-time trip counts, so they unroll fully.
+ *
+ * choleskyFactor() gives A = L L^T for symmetric positive definite A. Each column costs one
+ * Policy::invLength(), so Fast and Default trade accuracy for speed as everywhere else.
+ * ldltFactor() gives A = L D L^T with unit L and D on the diagonal: no square root, and it
+ * also works for indefinite matrices (e.g. the KKT system of a constrained solve) as long
+ * as no pivot is zero. Neither pivots, so badly conditioned matrices lose accuracy.
+ *
+ * choleskySolveSoA() and ldltSolveSoA() factor and solve many independent systems at once,
+ * one system per SIMD lane, from structure-of-arrays input: element (r, c) of system k is
+ * matrices[(r * N + c) * n + k] and its right-hand side is rhs[r * n + k]. Their results
+ * are the lane form of the same arithmetic, and agree with the scalar calls to within the
+ * policy's precision.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Math/Precision.h>
+#include <Matrices/Matrix3x3.h>
+#include <Matrices/Matrix4x4.h>
+#include <Matrices/MatrixN.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector4.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ namespace detail {
+  /** Cholesky factor of the lower triangle of a in place; false if a is not positive definite. */
+  template<typename Policy, size_t N>
+  EU_CONSTEXPR20 bool
+   choleskyFactor(float (&a)[N][N]) {
+   for (size_t j = 0; j < N; ++j) {
+    float d = a[j][j];
+    for (size_t k = 0; k < j; ++k) d -= a[j][k] * a[j][k];
+    if (!(d > 0.f)) {
+     return false;
+    }
+    const float inv = Policy::invLength(d);
+    a[j][j] = d * inv;
+    for (size_t i = j + 1; i < N; ++i) {
+     float s = a[i][j];
+     for (size_t k = 0; k < j; ++k) s -= a[i][k] * a[j][k];
+     a[i][j] = s * inv;
+    }
+   }
+   for (size_t i = 0; i < N; ++i)
+    for (size_t j = i + 1; j < N; ++j) a[i][j] = 0.f;
+   return true;
+  }
+
+  /** b = (L L^T)^-1 b by forward and back substitution. */
+  template<size_t N>
+  constexpr void
+   choleskySolve(const float (&l)[N][N], float (&b)[N]) {
+   for (size_t i = 0; i < N; ++i) {
+    float s = b[i];
+    for (size_t k = 0; k < i; ++k) s -= l[i][k] * b[k];
+    b[i] = s / l[i][i];
+   }
+   for (size_t i = N; i-- > 0;) {
+    float s = b[i];
+    for (size_t k = i + 1; k < N; ++k) s -= l[k][i] * b[k];
+    b[i] = s / l[i][i];
+   }
+  }
+
+  /** LDLT factor of the lower triangle of a in place, D on the diagonal; false on a zero pivot. */
+  template<size_t N>
+  constexpr bool
+   ldltFactor(float (&a)[N][N]) {
+   for (size_t j = 0; j < N; ++j) {
+    float d = a[j][j];
+    for (size_t k = 0; k < j; ++k) d -= a[j][k] * a[j][k] * a[k][k];
+    if (d == 0.f || d != d) {
+     return false;
+    }
+    a[j][j] = d;
+    const float inv = 1.f / d;
+    for (size_t i = j + 1; i < N; ++i) {
+     float s = a[i][j];
+     for (size_t k = 0; k < j; ++k) s -= a[i][k] * a[j][k] * a[k][k];
+     a[i][j] = s * inv;
+    }
+   }
+   for (size_t i = 0; i < N; ++i)
+    for (size_t j = i + 1; j < N; ++j) a[i][j] = 0.f;
+   return true;
+  }
+
+  /** b = (L D L^T)^-1 b. */
+  template<size_t N>
+  constexpr void
+   ldltSolve(const float (&ld)[N][N], float (&b)[N]) {
+   for (size_t i = 0; i < N; ++i) {
+    float s = b[i];
+    for (size_t k = 0; k < i; ++k) s -= ld[i][k] * b[k];
+    b[i] = s;
+   }
+   for (size_t i = 0; i < N; ++i) b[i] /= ld[i][i];
+   for (size_t i = N; i-- > 0;) {
+    float s = b[i];
+    for (size_t k = i + 1; k < N; ++k) s -= ld[k][i] * b[k];
+    b[i] = s;
+   }
+  }
+
+  /**
+   * Runs solve(a, b, ok) on every register of systems, a and b gathered from the SoA arrays.
+   * Padding lanes of the last register hold the identity. The factor is stored back for
+   * every system, and the solution only for systems whose ok lane is set; the others keep
+   * their right-hand side.
+   */
+  template<size_t N, typename Solve>
+  inline size_t
+   solveSoA(float* matrices, float* rhs, size_t n, bool* solved, Solve solve) {
+   using V = EU::SIMD::FloatN;
+   const size_t W = static_cast<size_t>(V::WIDTH);
+   const V one = V::set1(1.f);
+   size_t count = 0;
+   for (size_t i = 0; i < n; i += W) {
+    const size_t lanes = n - i < W ? n - i : W;
+    const V pad = EU::SIMD::select(firstLanes(lanes), V::zero(), one);
+    V a[N][N], b[N];
+    for (size_t r = 0; r < N; ++r) {
+     for (size_t c = 0; c < N; ++c) {
+      a[r][c] = loadLanes(matrices + (r * N + c) * n, i, lanes);
+      if (r == c) a[r][c] = a[r][c] + pad;
+     }
+     b[r] = loadLanes(rhs + r * n, i, lanes);
+    }
+    V x[N];
+    for (size_t r = 0; r < N; ++r) x[r] = b[r];
+    V ok = EU::SIMD::asFloat(V::Int::set1(-1));
+    solve(a, x, ok);
+    for (size_t r = 0; r < N; ++r) {
+     for (size_t c = 0; c < N; ++c) storeLanes(a[r][c], matrices + (r * N + c) * n, i, lanes);
+     storeLanes(EU::SIMD::select(ok, x[r], b[r]), rhs + r * n, i, lanes);
+    }
+    const int bits = EU::SIMD::movemask(ok);
+    for (size_t k = 0; k < lanes; ++k) {
+     const bool hit = ((bits >> k) & 1) != 0;
+     if (solved != nullptr) solved[i + k] = hit;
+     count += hit ? 1 : 0;
+    }
+   }
+   return count;
+  }
+ }
+
+ // --- Cholesky ---
+
+ /**
+  * @brief Replaces a (symmetric positive definite, lower triangle read) with its Cholesky
+  * factor L. Returns false, leaving a partly overwritten, if a is not positive definite.
+  */
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 bool
+  choleskyFactor(Matrix3x3& a) {
+  return detail::choleskyFactor<Policy>(a.m);
+ }
+
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 bool
+  choleskyFactor(Matrix4x4& a) {
+  return detail::choleskyFactor<Policy>(a.m);
+ }
+
+ template<typename Policy = EU::Precision::Default, size_t N>
+ EU_CONSTEXPR20 bool
+  choleskyFactor(Matrix<N, N>& a) {
+  return detail::choleskyFactor<Policy>(a.m);
+ }
+
+ /**
+  * @brief Replaces b with the solution x of L L^T x = b, l from choleskyFactor().
+  */
+ constexpr void
+  choleskySolve(const Matrix3x3& l, CVector3& b) {
+  float x[3] = { b.x, b.y, b.z };
+  detail::choleskySolve(l.m, x);
+  b = CVector3(x[0], x[1], x[2]);
+ }
+
+ constexpr void
+  choleskySolve(const Matrix4x4& l, CVector4& b) {
+  float x[4] = { b.x, b.y, b.z, b.w };
+  detail::choleskySolve(l.m, x);
+  b = CVector4(x[0], x[1], x[2], x[3]);
+ }
+
+ template<size_t N>
+ constexpr void
+  choleskySolve(const Matrix<N, N>& l, VectorN<N>& b) {
+  float x[N] = {};
+  for (size_t i = 0; i < N; ++i) x[i] = b.m[i][0];
+  detail::choleskySolve(l.m, x);
+  for (size_t i = 0; i < N; ++i) b.m[i][0] = x[i];
+ }
+
+ // --- LDLT ---
+
+ /**
+  * @brief Replaces a (symmetric, lower triangle read) with its LDLT factor: unit L below
+  * the diagonal and D on it. Returns false, leaving a partly overwritten, on a zero pivot.
+  */
+ constexpr bool
+  ldltFactor(Matrix3x3& a) {
+  return detail::ldltFactor(a.m);
+ }
+
+ constexpr bool
+  ldltFactor(Matrix4x4& a) {
+  return detail::ldltFactor(a.m);
+ }
+
+ template<size_t N>
+ constexpr bool
+  ldltFactor(Matrix<N, N>& a) {
+  return detail::ldltFactor(a.m);
+ }
+
+ /**
+  * @brief Replaces b with the solution x of L D L^T x = b, ld from ldltFactor().
+  */
+ constexpr void
+  ldltSolve(const Matrix3x3& ld, CVector3& b) {
+  float x[3] = { b.x, b.y, b.z };
+  detail::ldltSolve(ld.m, x);
+  b = CVector3(x[0], x[1], x[2]);
+ }
+
+ constexpr void
+  ldltSolve(const Matrix4x4& ld, CVector4& b) {
+  float x[4] = { b.x, b.y, b.z, b.w };
+  detail::ldltSolve(ld.m, x);
+  b = CVector4(x[0], x[1], x[2], x[3]);
+ }
+
+ template<size_t N>
+ constexpr void
+  ldltSolve(const Matrix<N, N>& ld, VectorN<N>& b) {
+  float x[N] = {};
+  for (size_t i = 0; i < N; ++i) x[i] = b.m[i][0];
+  detail::ldltSolve(ld.m, x);
+  for (size_t i = 0; i < N; ++i) b.m[i][0] = x[i];
+ }
+
+ // --- Batches ---
+
+ /**
+  * @brief Cholesky-factors and solves n independent N x N systems in SoA layout (see the
+  * file comment), one per SIMD lane. matrices receives the factors; rhs receives the
+  * solutions of the systems that are positive definite and is kept for the others.
+  * @param solved Optional, n flags: whether each system was solved.
+  * @return Number of systems solved.
+  */
+ template<size_t N, typename Policy = EU::Precision::Default>
+ inline size_t
+  choleskySolveSoA(float* matrices, float* rhs, size_t n, bool* solved = nullptr) {
+  using V = EU::SIMD::FloatN;
+  return detail::solveSoA<N>(matrices, rhs, n, solved, [](V (&a)[N][N], V (&x)[N], V& ok) {
+   const V zero = V::zero(), one = V::set1(1.f);
+   for (size_t j = 0; j < N; ++j) {
+    V d = a[j][j];
+    for (size_t k = 0; k < j; ++k) d = d - a[j][k] * a[j][k];
+    ok = ok & (d > zero);
+    d = EU::SIMD::select(ok, d, one);
+    const V inv = Policy::invLengthLanes(d);
+    a[j][j] = d * inv;
+    for (size_t i = j + 1; i < N; ++i) {
+     V s = a[i][j];
+     for (size_t k = 0; k < j; ++k) s = s - a[i][k] * a[j][k];
+     a[i][j] = s * inv;
+    }
+   }
+   for (size_t i = 0; i < N; ++i) {
+    for (size_t j = i + 1; j < N; ++j) a[i][j] = zero;
+   }
+   for (size_t i = 0; i < N; ++i) {
+    V s = x[i];
+    for (size_t k = 0; k < i; ++k) s = s - a[i][k] * x[k];
+    x[i] = s / a[i][i];
+   }
+   for (size_t i = N; i-- > 0;) {
+    V s = x[i];
+    for (size_t k = i + 1; k < N; ++k) s = s - a[k][i] * x[k];
+    x[i] = s / a[i][i];
+   }
+  });
+ }
+
+ /**
+  * @brief LDLT-factors and solves n independent N x N systems in SoA layout, one per SIMD
+  * lane; systems with a zero pivot keep their right-hand side. See choleskySolveSoA().
+  */
+ template<size_t N>
+ inline size_t
+  ldltSolveSoA(float* matrices, float* rhs, size_t n, bool* solved = nullptr) {
+  using V = EU::SIMD::FloatN;
+  return detail::solveSoA<N>(matrices, rhs, n, solved, [](V (&a)[N][N], V (&x)[N], V& ok) {
+   const V zero = V::zero(), one = V::set1(1.f);
+   for (size_t j = 0; j < N; ++j) {
+    V d = a[j][j];
+    for (size_t k = 0; k < j; ++k) d = d - a[j][k] * a[j][k] * a[k][k];
+    ok = ok & (d != zero) & (d == d);
+    d = EU::SIMD::select(ok, d, one);
+    a[j][j] = d;
+    const V inv = one / d;
+    for (size_t i = j + 1; i < N; ++i) {
+     V s = a[i][j];
+     for (size_t k = 0; k < j; ++k) s = s - a[i][k] * a[j][k] * a[k][k];
+     a[i][j] = s * inv;
+    }
+   }
+   for (size_t i = 0; i < N; ++i) {
+    for (size_t j = i + 1; j < N; ++j) a[i][j] = zero;
+   }
+   for (size_t i = 0; i < N; ++i) {
+    for (size_t k = 0; k < i; ++k) x[i] = x[i] - a[i][k] * x[k];
+   }
+   for (size_t i = 0; i < N; ++i) x[i] = x[i] / a[i][i];
+   for (size_t i = N; i-- > 0;) {
+    for (size_t k = i + 1; k < N; ++k) x[i] = x[i] - a[k][i] * x[k];
+   }
+  });
+ }
+}
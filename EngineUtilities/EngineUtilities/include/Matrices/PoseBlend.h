@@ -0,0 +1,289 @@
+/**
+ * @file PoseBlend.h
+ * @brief Batch blending of skeletal poses stored as SoA translation, rotation and scale.
+ *
+ * A pose is the local TRS of n bones, one float array per component (PoseSoA), the layout
+ * the blend kernels read a register of bones at a time from. Translations and scales are
+ * lerped; rotations are nlerped on the shortest arc (the second quaternion is negated where
+ * the dot product is negative) and normalized once. nlerp is not constant-velocity, but over
+ * the small angles between animation samples it is indistinguishable from slerp and costs
+ * one rsqrt.
+ *
+ * blendPoses() mixes two poses by one weight, optionally scaled per bone by a mask (0 keeps
+ * a, 1 takes the full weight of b), or averages any number of poses by per-pose weights.
+ * addPoses() layers an additive pose (makeAdditivePose(): a pose relative to a reference) on
+ * top of a base: translations add, rotations and scales compose. Weights are used as given,
+ * without clamping. out may be one of the inputs.
+ *
+ * poseToAffineArray() turns a pose into the local Affine3x4 transforms, in the same
+ * arithmetic as Affine3x4::fromTRS(), ready for TransformHierarchy or buildPalette().
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Precision.h>
+#include <Matrices/Affine3x4.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /** @brief Read-only structure-of-arrays view of n quaternions. */
+ struct ConstQuaternionSoA {
+  const float* x;
+  const float* y;
+  const float* z;
+  const float* w;
+ };
+
+ /** @brief Structure-of-arrays view of n quaternions. */
+ struct QuaternionSoA {
+  float* x;
+  float* y;
+  float* z;
+  float* w;
+  operator ConstQuaternionSoA() const { return { x, y, z, w }; }
+ };
+
+ /** @brief Read-only local transforms of n bones. */
+ struct ConstPoseSoA {
+  EngineMath::batch::ConstSoA3 translations;
+  ConstQuaternionSoA rotations;
+  EngineMath::batch::ConstSoA3 scales;
+ };
+
+ /** @brief Local transforms of n bones. */
+ struct PoseSoA {
+  EngineMath::batch::SoA3 translations;
+  QuaternionSoA rotations;
+  EngineMath::batch::SoA3 scales;
+  operator ConstPoseSoA() const { return { translations, rotations, scales }; }
+ };
+
+ namespace detail {
+  /** One register of bones, ten lanes per component. */
+  struct PoseLanes {
+   BatchLanes t[3];
+   BatchLanes r[4];
+   BatchLanes s[3];
+
+   /** Loads bones [i, i + count); padding lanes are zero. */
+   static PoseLanes
+    load(const ConstPoseSoA& pose, size_t i, size_t count) {
+    PoseLanes p;
+    p.t[0] = loadLanes(pose.translations.x, i, count);
+    p.t[1] = loadLanes(pose.translations.y, i, count);
+    p.t[2] = loadLanes(pose.translations.z, i, count);
+    p.r[0] = loadLanes(pose.rotations.x, i, count);
+    p.r[1] = loadLanes(pose.rotations.y, i, count);
+    p.r[2] = loadLanes(pose.rotations.z, i, count);
+    p.r[3] = loadLanes(pose.rotations.w, i, count);
+    p.s[0] = loadLanes(pose.scales.x, i, count);
+    p.s[1] = loadLanes(pose.scales.y, i, count);
+    p.s[2] = loadLanes(pose.scales.z, i, count);
+    return p;
+   }
+
+   void
+    store(const PoseSoA& pose, size_t i, size_t count) const {
+    storeLanes(t[0], pose.translations.x, i, count);
+    storeLanes(t[1], pose.translations.y, i, count);
+    storeLanes(t[2], pose.translations.z, i, count);
+    storeLanes(r[0], pose.rotations.x, i, count);
+    storeLanes(r[1], pose.rotations.y, i, count);
+    storeLanes(r[2], pose.rotations.z, i, count);
+    storeLanes(r[3], pose.rotations.w, i, count);
+    storeLanes(s[0], pose.scales.x, i, count);
+    storeLanes(s[1], pose.scales.y, i, count);
+    storeLanes(s[2], pose.scales.z, i, count);
+   }
+  };
+
+  /** Normalizes the quaternion lanes q; zero lanes become the identity. */
+  template<typename Policy>
+  inline void
+   normalizeRotationLanes(BatchLanes (&q)[4]) {
+   const BatchLanes lenSq = Policy::maddLanes(q[3], q[3], Policy::maddLanes(q[2], q[2],
+                                              Policy::maddLanes(q[1], q[1], q[0] * q[0])));
+   const BatchLanes valid = lenSq > BatchLanes::zero();
+   const BatchLanes inv = Policy::invLengthLanes(lenSq) & valid;
+   for (int c = 0; c < 4; ++c) q[c] = q[c] * inv;
+   q[3] = EU::SIMD::select(valid, q[3], BatchLanes::set1(1.f));
+  }
+
+  /** Lane-wise a * b in the order of Quaternion::operator*. */
+  inline void
+   multiplyRotationLanes(const BatchLanes (&a)[4], const BatchLanes (&b)[4], BatchLanes (&out)[4]) {
+   const BatchLanes x = a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1];
+   const BatchLanes y = a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0];
+   const BatchLanes z = a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3];
+   const BatchLanes w = a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2];
+   out[0] = x;
+   out[1] = y;
+   out[2] = z;
+   out[3] = w;
+  }
+
+  /** Per-bone weight lanes: weight, times mask[i..] when there is a mask. */
+  inline BatchLanes
+   weightLanes(float weight, const float* mask, size_t i, size_t count) {
+   const BatchLanes w = BatchLanes::set1(weight);
+   return mask != nullptr ? w * loadLanes(mask, i, count) : w;
+  }
+ }
+
+ /**
+  * @brief out = a blended towards b by weight (0 gives a, 1 gives b), per bone scaled by
+  * mask[i] when mask is given, e.g. an upper-body layer.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  blendPoses(const ConstPoseSoA& a, const ConstPoseSoA& b, float weight, const PoseSoA& out, size_t n,
+             const float* mask = nullptr) {
+  using detail::BatchLanes;
+  const BatchLanes zero = BatchLanes::zero();
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   const BatchLanes w = detail::weightLanes(weight, mask, i, count);
+   detail::PoseLanes p = detail::PoseLanes::load(a, i, count);
+   const detail::PoseLanes q = detail::PoseLanes::load(b, i, count);
+   for (int c = 0; c < 3; ++c) {
+    p.t[c] = Policy::maddLanes(q.t[c] - p.t[c], w, p.t[c]);
+    p.s[c] = Policy::maddLanes(q.s[c] - p.s[c], w, p.s[c]);
+   }
+   const BatchLanes dot = Policy::maddLanes(p.r[3], q.r[3], Policy::maddLanes(p.r[2], q.r[2],
+                                            Policy::maddLanes(p.r[1], q.r[1], p.r[0] * q.r[0])));
+   const BatchLanes signedW = EU::SIMD::select(dot < zero, zero - w, w);
+   for (int c = 0; c < 4; ++c) {
+    // a + (+-b - a) w, with the sign folded into the weight of b.
+    p.r[c] = Policy::maddLanes(q.r[c], signedW, Policy::maddLanes(zero - p.r[c], w, p.r[c]));
+   }
+   detail::normalizeRotationLanes<Policy>(p.r);
+   p.store(out, i, count);
+  }
+ }
+
+ /**
+  * @brief out = the weighted average of poses[0..poseCount) by weights (normally summing to
+  * one). Each rotation is flipped into the hemisphere of poses[0] before it is added.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  blendPoses(const ConstPoseSoA* poses, const float* weights, size_t poseCount, const PoseSoA& out, size_t n) {
+  using detail::BatchLanes;
+  if (poseCount == 0) return;
+  const BatchLanes zero = BatchLanes::zero();
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   const detail::PoseLanes first = detail::PoseLanes::load(poses[0], i, count);
+   detail::PoseLanes sum;
+   const BatchLanes w0 = BatchLanes::set1(weights[0]);
+   for (int c = 0; c < 3; ++c) {
+    sum.t[c] = first.t[c] * w0;
+    sum.s[c] = first.s[c] * w0;
+   }
+   for (int c = 0; c < 4; ++c) sum.r[c] = first.r[c] * w0;
+   for (size_t k = 1; k < poseCount; ++k) {
+    const detail::PoseLanes p = detail::PoseLanes::load(poses[k], i, count);
+    const BatchLanes w = BatchLanes::set1(weights[k]);
+    for (int c = 0; c < 3; ++c) {
+     sum.t[c] = Policy::maddLanes(p.t[c], w, sum.t[c]);
+     sum.s[c] = Policy::maddLanes(p.s[c], w, sum.s[c]);
+    }
+    const BatchLanes dot = Policy::maddLanes(first.r[3], p.r[3], Policy::maddLanes(first.r[2], p.r[2],
+                                             Policy::maddLanes(first.r[1], p.r[1], first.r[0] * p.r[0])));
+    const BatchLanes signedW = EU::SIMD::select(dot < zero, zero - w, w);
+    for (int c = 0; c < 4; ++c) sum.r[c] = Policy::maddLanes(p.r[c], signedW, sum.r[c]);
+   }
+   detail::normalizeRotationLanes<Policy>(sum.r);
+   sum.store(out, i, count);
+  }
+ }
+
+ /**
+  * @brief out = pose relative to reference: translation difference, rotation
+  * conj(reference) * rotation and scale ratio (1 where the reference scale is 0). Rotations
+  * should be unit length.
+  */
+ inline void
+  makeAdditivePose(const ConstPoseSoA& pose, const ConstPoseSoA& reference, const PoseSoA& out, size_t n) {
+  using detail::BatchLanes;
+  const BatchLanes zero = BatchLanes::zero(), one = BatchLanes::set1(1.f);
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   detail::PoseLanes p = detail::PoseLanes::load(pose, i, count);
+   const detail::PoseLanes ref = detail::PoseLanes::load(reference, i, count);
+   for (int c = 0; c < 3; ++c) {
+    p.t[c] = p.t[c] - ref.t[c];
+    const BatchLanes valid = ref.s[c] != zero;
+    p.s[c] = EU::SIMD::select(valid, p.s[c] / EU::SIMD::select(valid, ref.s[c], one), one);
+   }
+   const BatchLanes conj[4] = { zero - ref.r[0], zero - ref.r[1], zero - ref.r[2], ref.r[3] };
+   const BatchLanes rotation[4] = { p.r[0], p.r[1], p.r[2], p.r[3] };
+   detail::multiplyRotationLanes(conj, rotation, p.r);
+   p.store(out, i, count);
+  }
+ }
+
+ /**
+  * @brief out = base with additive (from makeAdditivePose()) applied at weight, per bone
+  * scaled by mask[i] when given: translation + w * delta, rotation * nlerp(identity, delta, w)
+  * and scale * lerp(1, delta, w).
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  addPoses(const ConstPoseSoA& base, const ConstPoseSoA& additive, float weight, const PoseSoA& out, size_t n,
+           const float* mask = nullptr) {
+  using detail::BatchLanes;
+  const BatchLanes zero = BatchLanes::zero(), one = BatchLanes::set1(1.f);
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   const BatchLanes w = detail::weightLanes(weight, mask, i, count);
+   detail::PoseLanes p = detail::PoseLanes::load(base, i, count);
+   const detail::PoseLanes d = detail::PoseLanes::load(additive, i, count);
+   for (int c = 0; c < 3; ++c) {
+    p.t[c] = Policy::maddLanes(d.t[c], w, p.t[c]);
+    p.s[c] = p.s[c] * Policy::maddLanes(d.s[c] - one, w, one);
+   }
+   // nlerp from the identity, on the arc where the delta's w is positive.
+   const BatchLanes signedW = EU::SIMD::select(d.r[3] < zero, zero - w, w);
+   BatchLanes delta[4];
+   for (int c = 0; c < 3; ++c) delta[c] = d.r[c] * signedW;
+   delta[3] = Policy::maddLanes(d.r[3], signedW, one - w);
+   detail::normalizeRotationLanes<Policy>(delta);
+   const BatchLanes rotation[4] = { p.r[0], p.r[1], p.r[2], p.r[3] };
+   detail::multiplyRotationLanes(rotation, delta, p.r);
+   p.store(out, i, count);
+  }
+ }
+
+ /**
+  * @brief out[i] = Affine3x4::fromTRS() of bone i of pose, one register of bones per step.
+  */
+ inline void
+  poseToAffineArray(const ConstPoseSoA& pose, Affine3x4* out, size_t n) {
+  using detail::BatchLanes;
+  const BatchLanes zero = BatchLanes::zero(), one = BatchLanes::set1(1.f), two = BatchLanes::set1(2.f);
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   const detail::PoseLanes p = detail::PoseLanes::load(pose, i, count);
+   const BatchLanes (&q)[4] = p.r;
+   const BatchLanes lenSq = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+   const BatchLanes valid = lenSq != zero;
+   const BatchLanes s = (two / EU::SIMD::select(valid, lenSq, one)) & valid;
+   const BatchLanes xx = q[0] * q[0] * s, yy = q[1] * q[1] * s, zz = q[2] * q[2] * s;
+   const BatchLanes xy = q[0] * q[1] * s, xz = q[0] * q[2] * s, yz = q[1] * q[2] * s;
+   const BatchLanes wx = q[3] * q[0] * s, wy = q[3] * q[1] * s, wz = q[3] * q[2] * s;
+   const BatchLanes m[12] = {
+    (one - (yy + zz)) * p.s[0], (xy - wz) * p.s[1], (xz + wy) * p.s[2], p.t[0],
+    (xy + wz) * p.s[0], (one - (xx + zz)) * p.s[1], (yz - wx) * p.s[2], p.t[1],
+    (xz - wy) * p.s[0], (yz + wx) * p.s[1], (one - (xx + yy)) * p.s[2], p.t[2]
+   };
+   float lanes[12][detail::BATCH_WIDTH];
+   for (int e = 0; e < 12; ++e) m[e].store(lanes[e]);
+   for (size_t k = 0; k < count; ++k)
+    for (int e = 0; e < 12; ++e) out[i + k].m[e / 4][e % 4] = lanes[e][k];
+  }
+ }
+}
@@ -0,0 +1,557 @@
+/**
+ * @file Skinning.h
+ * @brief Bone palette construction and linear-blend skinning over CVector3 arrays.
+ *
+ * buildPalette() turns joint world transforms and inverse bind matrices into the skinning
+ * palette world * inverseBind in one pass, optionally gathering the joints out of a larger
+ * world array (TransformHierarchy::worlds()) and writing column-major matrices ready for
+ * upload (MatrixSFML.h).
+ *
+ * skinPositions() and skinVertices() blend up to four palette matrices per vertex. The blend
+ * runs on Float4 rows, four vertices are transposed into lanes, and the blended transforms
+ * then stream through the same madd chain as transformPoints(), in AoS or SoA layout.
+ * Weights are used as given: they should sum to one, and unused influences need weight 0
+ * and any valid joint.
+ *
+ * The DualQuaternion overloads do dual-quaternion skinning instead: 32 bytes per bone, and
+ * joints keep their volume under twist where the matrix blend collapses. Each influence is
+ * blended into two Float4 registers (its weight negated when its rotation is on the other
+ * hemisphere from the first influence's), four vertices are transposed into lanes, and the
+ * blend is normalized by one rsqrt and applied as a rotation plus translation. The palette
+ * must be rigid; scale is not representable.
+ *
+ * Culling needs the skinned mesh's bounds, two ways. Every skinning call takes an optional
+ * AABB* that receives the exact box of the positions it writes, reduced in lanes in the same
+ * pass at the cost of six min/max per packet. When the vertices are not skinned on the CPU
+ * at all, SkinBounds keeps one bind-pose box per bone, the vertices with a nonzero weight on
+ * it, and bounds(palette) merges each box moved by its palette matrix (AABB::transformed()):
+ * a skinned position is a convex blend of its joints' palette images, so the union holds it.
+ * That box is conservative, loosest at joints with large rotations, and costs one box
+ * transform per bone instead of one blend per vertex:
+ *
+ *   SkinBounds boneBoxes(bones);
+ *   boneBoxes.add(bindPositions, vertexCount, influences);      // once, per morph target too
+ *   const AABB box = boneBoxes.bounds(palette);                   // every frame
+ *
+ * The conservative bound needs nonnegative weights summing to one and, being a property of
+ * the matrix blend, does not hold for dual-quaternion skinning.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Constants.h>
+#include <Core/Platform.h>
+#include <Core/SIMD.h>
+#include <Geometry/Primitives.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Precision.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/ColumnMatrix4x4.h>
+#include <Matrices/Matrix4x4.h>
+#include <Rotations/DualQuaternion.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /**
+  * @struct BoneInfluences
+  * @brief The four joints that move a vertex and their blend weights.
+  */
+ struct
+  BoneInfluences {
+  float weights[4];   ///< Blend weights, normally summing to one
+  uint16_t joints[4]; ///< Palette indices matching weights
+ };
+
+ EU_ASSERT_VALUE_TYPE(BoneInfluences);
+
+ namespace detail {
+  /** The top three rows of sum(weights[k] * palette[joints[k]]). */
+  template<typename Matrix>
+  inline void
+   blendRows(const BoneInfluences& influences, const Matrix* palette,
+             EU::SIMD::Float4& r0, EU::SIMD::Float4& r1, EU::SIMD::Float4& r2) {
+   using EU::SIMD::Float4;
+   const Matrix& m0 = palette[influences.joints[0]];
+   const Float4 w0 = Float4::set1(influences.weights[0]);
+   r0 = Float4::load(m0.m[0]) * w0;
+   r1 = Float4::load(m0.m[1]) * w0;
+   r2 = Float4::load(m0.m[2]) * w0;
+   for (int k = 1; k < 4; ++k) {
+    const Matrix& mk = palette[influences.joints[k]];
+    const Float4 wk = Float4::set1(influences.weights[k]);
+    r0 = EU::SIMD::madd(Float4::load(mk.m[0]), wk, r0);
+    r1 = EU::SIMD::madd(Float4::load(mk.m[1]), wk, r1);
+    r2 = EU::SIMD::madd(Float4::load(mk.m[2]), wk, r2);
+   }
+  }
+
+  /**
+   * Blends the transforms of the count vertices at influences[i..] into lanes: blended[r][c]
+   * holds element (r, c) of every vertex. Padding lanes repeat vertex i.
+   */
+  template<typename Matrix>
+  inline void
+   blendPacket(const BoneInfluences* influences, const Matrix* palette, size_t i, size_t count,
+               BatchLanes (&blended)[3][4]) {
+   using EU::SIMD::Float4;
+   static_assert(BATCH_WIDTH % 4 == 0, "skinning transposes four vertices at a time");
+   float lanes[3][4][BATCH_WIDTH];
+   for (size_t q = 0; q < BATCH_WIDTH; q += 4) {
+    Float4 rows[3][4];
+    for (size_t v = 0; v < 4; ++v) {
+     const size_t lane = q + v;
+     blendRows(influences[i + (lane < count ? lane : 0)], palette, rows[0][v], rows[1][v], rows[2][v]);
+    }
+    for (int r = 0; r < 3; ++r) {
+     EU::SIMD::transpose(rows[r][0], rows[r][1], rows[r][2], rows[r][3]);
+     for (int c = 0; c < 4; ++c) rows[r][c].store(lanes[r][c] + q);
+    }
+   }
+   for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 4; ++c) blended[r][c] = BatchLanes::load(lanes[r][c]);
+   }
+  }
+
+  /** Running per-lane bounds of skinned positions, the inputs of reduceLaneBounds(). */
+  struct LaneBounds {
+   BatchLanes lo[3];
+   BatchLanes hi[3];
+
+   LaneBounds() {
+    for (int c = 0; c < 3; ++c) {
+     lo[c] = BatchLanes::set1(EU::Constants::INF);
+     hi[c] = BatchLanes::set1(EU::Constants::NEG_INF);
+    }
+   }
+
+   /** Grows the lanes by the first count lanes of (x, y, z); the padding lanes are not points. */
+   void
+    grow(BatchLanes x, BatchLanes y, BatchLanes z, size_t count) {
+    const BatchLanes p[3] = { x, y, z };
+    if (count == BATCH_WIDTH) {
+     for (int c = 0; c < 3; ++c) {
+      lo[c] = EU::SIMD::min(lo[c], p[c]);
+      hi[c] = EU::SIMD::max(hi[c], p[c]);
+     }
+     return;
+    }
+    const BatchLanes mask = firstLanes(count);
+    for (int c = 0; c < 3; ++c) {
+     lo[c] = EU::SIMD::min(lo[c], EU::SIMD::select(mask, p[c], lo[c]));
+     hi[c] = EU::SIMD::max(hi[c], EU::SIMD::select(mask, p[c], hi[c]));
+    }
+   }
+
+   /** The box of every point grown into the lanes; empty if there was none. */
+   AABB
+    reduce() const {
+    float l[3][BATCH_WIDTH], h[3][BATCH_WIDTH];
+    for (int c = 0; c < 3; ++c) {
+     lo[c].store(l[c]);
+     hi[c].store(h[c]);
+    }
+    AABB box;
+    for (size_t j = 0; j < BATCH_WIDTH; ++j) {
+     for (int c = 0; c < 3; ++c) {
+      box.min[c] = l[c][j] < box.min[c] ? l[c][j] : box.min[c];
+      box.max[c] = h[c][j] > box.max[c] ? h[c][j] : box.max[c];
+     }
+    }
+    return box;
+   }
+  };
+
+  /**
+   * Linear-blend skinning of positions and, when Normals, of unit normals; bounds, when not
+   * null, receives the box of the skinned positions.
+   */
+  template<bool Normals, typename Policy, typename Matrix, typename In, typename Out>
+  inline void
+   skin(In positions, In normals, Out outPositions, Out outNormals, size_t n,
+        const BoneInfluences* influences, const Matrix* palette, AABB* bounds) {
+   LaneBounds lanes;
+   for (size_t i = 0; i < n; i += BATCH_WIDTH) {
+    const size_t count = n - i < BATCH_WIDTH ? n - i : BATCH_WIDTH;
+    BatchLanes m[3][4];
+    blendPacket(influences, palette, i, count, m);
+    BatchLanes x, y, z;
+    loadPacket3(positions, i, count, x, y, z);
+    const BatchLanes px = EU::SIMD::madd(m[0][2], z, EU::SIMD::madd(m[0][1], y, m[0][0] * x)) + m[0][3];
+    const BatchLanes py = EU::SIMD::madd(m[1][2], z, EU::SIMD::madd(m[1][1], y, m[1][0] * x)) + m[1][3];
+    const BatchLanes pz = EU::SIMD::madd(m[2][2], z, EU::SIMD::madd(m[2][1], y, m[2][0] * x)) + m[2][3];
+    storePacket3(outPositions, i, count, px, py, pz);
+    if (bounds) lanes.grow(px, py, pz, count);
+    if (Normals) {
+     loadPacket3(normals, i, count, x, y, z);
+     const BatchLanes nx = EU::SIMD::madd(m[0][2], z, EU::SIMD::madd(m[0][1], y, m[0][0] * x));
+     const BatchLanes ny = EU::SIMD::madd(m[1][2], z, EU::SIMD::madd(m[1][1], y, m[1][0] * x));
+     const BatchLanes nz = EU::SIMD::madd(m[2][2], z, EU::SIMD::madd(m[2][1], y, m[2][0] * x));
+     // Blending (and any scale) changes the length; renormalize like normalizeArray().
+     const BatchLanes inv = safeInvLength<Policy>(Policy::maddLanes(nz, nz, Policy::maddLanes(ny, ny, nx * nx)));
+     storePacket3(outNormals, i, count, nx * inv, ny * inv, nz * inv);
+    }
+   }
+   if (bounds) *bounds = lanes.reduce();
+  }
+
+  /**
+   * sum(weights[k] * palette[joints[k]]) as the real and dual registers, each weight negated
+   * when its rotation's dot product with the first influence's is negative.
+   */
+  inline void
+   blendDual(const BoneInfluences& influences, const DualQuaternion* palette,
+             EU::SIMD::Float4& real, EU::SIMD::Float4& dual) {
+   using EU::SIMD::Float4;
+   const DualQuaternion& q0 = palette[influences.joints[0]];
+   const Float4 w0 = Float4::set1(influences.weights[0]);
+   real = Float4::load(&q0.real.x) * w0;
+   dual = Float4::load(&q0.dual.x) * w0;
+   for (int k = 1; k < 4; ++k) {
+    const DualQuaternion& qk = palette[influences.joints[k]];
+    const float weight = q0.real.dot(qk.real) < 0.f ? -influences.weights[k] : influences.weights[k];
+    const Float4 wk = Float4::set1(weight);
+    real = EU::SIMD::madd(Float4::load(&qk.real.x), wk, real);
+    dual = EU::SIMD::madd(Float4::load(&qk.dual.x), wk, dual);
+   }
+  }
+
+  /**
+   * Blends the count vertices at influences[i..] into lanes: blended[0..3] are the real x, y,
+   * z, w and blended[4..7] the dual ones. Padding lanes repeat vertex i.
+   */
+  inline void
+   blendDualPacket(const BoneInfluences* influences, const DualQuaternion* palette, size_t i, size_t count,
+                   BatchLanes (&blended)[8]) {
+   using EU::SIMD::Float4;
+   static_assert(BATCH_WIDTH % 4 == 0, "skinning transposes four vertices at a time");
+   float lanes[8][BATCH_WIDTH];
+   for (size_t q = 0; q < BATCH_WIDTH; q += 4) {
+    Float4 real[4], dual[4];
+    for (size_t v = 0; v < 4; ++v) {
+     const size_t lane = q + v;
+     blendDual(influences[i + (lane < count ? lane : 0)], palette, real[v], dual[v]);
+    }
+    EU::SIMD::transpose(real[0], real[1], real[2], real[3]);
+    EU::SIMD::transpose(dual[0], dual[1], dual[2], dual[3]);
+    for (int c = 0; c < 4; ++c) {
+     real[c].store(lanes[c] + q);
+     dual[c].store(lanes[4 + c] + q);
+    }
+   }
+   for (int c = 0; c < 8; ++c) blended[c] = BatchLanes::load(lanes[c]);
+  }
+
+  /** Dual-quaternion skinning of positions and, when Normals, of normals; bounds as skin(). */
+  template<bool Normals, typename Policy, typename In, typename Out>
+  inline void
+   skinDual(In positions, In normals, Out outPositions, Out outNormals, size_t n,
+            const BoneInfluences* influences, const DualQuaternion* palette, AABB* bounds) {
+   const BatchLanes two = BatchLanes::set1(2.f);
+   LaneBounds lanes;
+   for (size_t i = 0; i < n; i += BATCH_WIDTH) {
+    const size_t count = n - i < BATCH_WIDTH ? n - i : BATCH_WIDTH;
+    BatchLanes b[8];
+    blendDualPacket(influences, palette, i, count, b);
+    // Normalizing by |real| scales both parts; the factor 2 of the rotation and translation
+    // formulas is folded into the vector part of real and all of dual.
+    const BatchLanes inv = safeInvLength<Policy>(Policy::maddLanes(b[3], b[3],
+                                                 Policy::maddLanes(b[2], b[2], Policy::maddLanes(b[1], b[1], b[0] * b[0]))));
+    const BatchLanes inv2 = inv * two;
+    const BatchLanes rx = b[0] * inv, ry = b[1] * inv, rz = b[2] * inv, rw = b[3] * inv;
+    const BatchLanes dx = b[4] * inv2, dy = b[5] * inv2, dz = b[6] * inv2, dw = b[7] * inv2;
+    // Translation 2 (rw dv - dw rv + rv x dv).
+    const BatchLanes tx = rw * dx - dw * rx + (ry * dz - rz * dy);
+    const BatchLanes ty = rw * dy - dw * ry + (rz * dx - rx * dz);
+    const BatchLanes tz = rw * dz - dw * rz + (rx * dy - ry * dx);
+    const BatchLanes sx = rx * two, sy = ry * two, sz = rz * two;
+    BatchLanes x, y, z;
+    loadPacket3(positions, i, count, x, y, z);
+    // v + rw u + rv x u with u = 2 (rv x v), as Quaternion::rotateUnit().
+    BatchLanes ux = sy * z - sz * y, uy = sz * x - sx * z, uz = sx * y - sy * x;
+    const BatchLanes px = x + rw * ux + (ry * uz - rz * uy) + tx;
+    const BatchLanes py = y + rw * uy + (rz * ux - rx * uz) + ty;
+    const BatchLanes pz = z + rw * uz + (rx * uy - ry * ux) + tz;
+    storePacket3(outPositions, i, count, px, py, pz);
+    if (bounds) lanes.grow(px, py, pz, count);
+    if (Normals) {
+     loadPacket3(normals, i, count, x, y, z);
+     ux = sy * z - sz * y;
+     uy = sz * x - sx * z;
+     uz = sx * y - sy * x;
+     storePacket3(outNormals, i, count,
+                  x + rw * ux + (ry * uz - rz * uy),
+                  y + rw * uy + (rz * ux - rx * uz),
+                  z + rw * uz + (rx * uy - ry * ux));
+    }
+   }
+   if (bounds) *bounds = lanes.reduce();
+  }
+ }
+
+ // --- Palette ---
+
+ /** @brief palette[i] = worlds[i] * inverseBind[i]. */
+ inline void
+  buildPalette(const Affine3x4* worlds, const Affine3x4* inverseBind, Affine3x4* palette, size_t n) {
+  for (size_t i = 0; i < n; ++i) palette[i] = worlds[i] * inverseBind[i];
+ }
+
+ /**
+  * @brief palette[i] = worlds[jointNodes[i]] * inverseBind[i], for a skeleton whose joints
+  * are nodes of a larger hierarchy.
+  */
+ inline void
+  buildPalette(const Affine3x4* worlds, const uint32_t* jointNodes, const Affine3x4* inverseBind,
+               Affine3x4* palette, size_t n) {
+  for (size_t i = 0; i < n; ++i) palette[i] = worlds[jointNodes[i]] * inverseBind[i];
+ }
+
+ /** @brief palette[i] = worlds[i] * inverseBind[i] for Matrix4x4 skeletons. */
+ inline void
+  buildPalette(const Matrix4x4* worlds, const Matrix4x4* inverseBind, Matrix4x4* palette, size_t n) {
+  for (size_t i = 0; i < n; ++i) palette[i] = worlds[i] * inverseBind[i];
+ }
+
+ /** @brief buildPalette() written straight to the column-major upload layout. */
+ inline void
+  buildPalette(const Affine3x4* worlds, const Affine3x4* inverseBind, ColumnMatrix4x4* palette, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+   const Affine3x4 bone = worlds[i] * inverseBind[i];
+   toColumnMajor(&bone, palette + i, 1);
+  }
+ }
+
+ /** @brief Gathering buildPalette() written to the column-major upload layout. */
+ inline void
+  buildPalette(const Affine3x4* worlds, const uint32_t* jointNodes, const Affine3x4* inverseBind,
+               ColumnMatrix4x4* palette, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+   const Affine3x4 bone = worlds[jointNodes[i]] * inverseBind[i];
+   toColumnMajor(&bone, palette + i, 1);
+  }
+ }
+
+ /** @brief Dual-quaternion palette: the rigid part of worlds[i] * inverseBind[i]. */
+ inline void
+  buildPalette(const Affine3x4* worlds, const Affine3x4* inverseBind, DualQuaternion* palette, size_t n) {
+  for (size_t i = 0; i < n; ++i) palette[i] = DualQuaternion::fromAffine3x4(worlds[i] * inverseBind[i]);
+ }
+
+ /** @brief Gathering buildPalette() for a dual-quaternion palette. */
+ inline void
+  buildPalette(const Affine3x4* worlds, const uint32_t* jointNodes, const Affine3x4* inverseBind,
+               DualQuaternion* palette, size_t n) {
+  for (size_t i = 0; i < n; ++i) palette[i] = DualQuaternion::fromAffine3x4(worlds[jointNodes[i]] * inverseBind[i]);
+ }
+
+ // --- Skinning, AoS ---
+
+ /**
+  * @brief out[i] = in[i] moved by the blend of its influences[i] in palette.
+  *
+  * bounds, when not null, receives the box of out[0..n) from the same pass; this holds for every
+  * skinPositions() and skinVertices() overload.
+  */
+ inline void
+  skinPositions(const CVector3* in, CVector3* out, size_t n, const BoneInfluences* influences,
+                const Affine3x4* palette, AABB* bounds = nullptr) {
+  const float* p = reinterpret_cast<const float*>(in);
+  float* o = reinterpret_cast<float*>(out);
+  detail::skin<false, EU::Precision::Default>(p, p, o, o, n, influences, palette, bounds);
+ }
+
+ /** @brief skinPositions() with a Matrix4x4 palette; its bottom rows are not read. */
+ inline void
+  skinPositions(const CVector3* in, CVector3* out, size_t n, const BoneInfluences* influences,
+                const Matrix4x4* palette, AABB* bounds = nullptr) {
+  const float* p = reinterpret_cast<const float*>(in);
+  float* o = reinterpret_cast<float*>(out);
+  detail::skin<false, EU::Precision::Default>(p, p, o, o, n, influences, palette, bounds);
+ }
+
+ /**
+  * @brief Skins positions and normals with one blend per vertex; normals come out unit length.
+  *
+  * Normals use the blended 3x3 block directly, which is exact for rotations and uniform scale.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  skinVertices(const CVector3* positions, const CVector3* normals, CVector3* outPositions,
+               CVector3* outNormals, size_t n, const BoneInfluences* influences, const Affine3x4* palette,
+               AABB* bounds = nullptr) {
+  detail::skin<true, Policy>(reinterpret_cast<const float*>(positions), reinterpret_cast<const float*>(normals),
+                             reinterpret_cast<float*>(outPositions), reinterpret_cast<float*>(outNormals),
+                             n, influences, palette, bounds);
+ }
+
+ /** @brief skinVertices() with a Matrix4x4 palette. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  skinVertices(const CVector3* positions, const CVector3* normals, CVector3* outPositions,
+               CVector3* outNormals, size_t n, const BoneInfluences* influences, const Matrix4x4* palette,
+               AABB* bounds = nullptr) {
+  detail::skin<true, Policy>(reinterpret_cast<const float*>(positions), reinterpret_cast<const float*>(normals),
+                             reinterpret_cast<float*>(outPositions), reinterpret_cast<float*>(outNormals),
+                             n, influences, palette, bounds);
+ }
+
+ /** @brief skinPositions() with dual-quaternion skinning. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  skinPositions(const CVector3* in, CVector3* out, size_t n, const BoneInfluences* influences,
+                const DualQuaternion* palette, AABB* bounds = nullptr) {
+  const float* p = reinterpret_cast<const float*>(in);
+  float* o = reinterpret_cast<float*>(out);
+  detail::skinDual<false, Policy>(p, p, o, o, n, influences, palette, bounds);
+ }
+
+ /** @brief skinVertices() with dual-quaternion skinning; normals are rotated only. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  skinVertices(const CVector3* positions, const CVector3* normals, CVector3* outPositions,
+               CVector3* outNormals, size_t n, const BoneInfluences* influences, const DualQuaternion* palette,
+               AABB* bounds = nullptr) {
+  detail::skinDual<true, Policy>(reinterpret_cast<const float*>(positions), reinterpret_cast<const float*>(normals),
+                                 reinterpret_cast<float*>(outPositions), reinterpret_cast<float*>(outNormals),
+                                 n, influences, palette, bounds);
+ }
+
+ // --- Skinning, SoA ---
+
+ /** @brief SoA skinPositions(). */
+ inline void
+  skinPositions(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n,
+                const BoneInfluences* influences, const Affine3x4* palette, AABB* bounds = nullptr) {
+  detail::skin<false, EU::Precision::Default>(in, in, out, out, n, influences, palette, bounds);
+ }
+
+ /** @brief SoA skinPositions() with a Matrix4x4 palette. */
+ inline void
+  skinPositions(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n,
+                const BoneInfluences* influences, const Matrix4x4* palette, AABB* bounds = nullptr) {
+  detail::skin<false, EU::Precision::Default>(in, in, out, out, n, influences, palette, bounds);
+ }
+
+ /** @brief SoA skinVertices(). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  skinVertices(EngineMath::batch::ConstSoA3 positions, EngineMath::batch::ConstSoA3 normals,
+               EngineMath::batch::SoA3 outPositions, EngineMath::batch::SoA3 outNormals, size_t n,
+               const BoneInfluences* influences, const Affine3x4* palette, AABB* bounds = nullptr) {
+  detail::skin<true, Policy>(positions, normals, outPositions, outNormals, n, influences, palette, bounds);
+ }
+
+ /** @brief SoA skinVertices() with a Matrix4x4 palette. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  skinVertices(EngineMath::batch::ConstSoA3 positions, EngineMath::batch::ConstSoA3 normals,
+               EngineMath::batch::SoA3 outPositions, EngineMath::batch::SoA3 outNormals, size_t n,
+               const BoneInfluences* influences, const Matrix4x4* palette, AABB* bounds = nullptr) {
+  detail::skin<true, Policy>(positions, normals, outPositions, outNormals, n, influences, palette, bounds);
+ }
+ /** @brief SoA skinPositions() with dual-quaternion skinning. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  skinPositions(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n,
+                const BoneInfluences* influences, const DualQuaternion* palette, AABB* bounds = nullptr) {
+  detail::skinDual<false, Policy>(in, in, out, out, n, influences, palette, bounds);
+ }
+
+ /** @brief SoA skinVertices() with dual-quaternion skinning. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  skinVertices(EngineMath::batch::ConstSoA3 positions, EngineMath::batch::ConstSoA3 normals,
+               EngineMath::batch::SoA3 outPositions, EngineMath::batch::SoA3 outNormals, size_t n,
+               const BoneInfluences* influences, const DualQuaternion* palette, AABB* bounds = nullptr) {
+  detail::skinDual<true, Policy>(positions, normals, outPositions, outNormals, n, influences, palette, bounds);
+ }
+
+ // --- Bounds ---
+
+ /**
+  * @class SkinBounds
+  * @brief Bind-pose box per bone, merged under a palette into a conservative box of the
+  * linear-blend skinned mesh; see the file comment.
+  */
+ class
+  SkinBounds {
+  public:
+  SkinBounds() = default;
+
+  /** @brief bones empty boxes. */
+  explicit SkinBounds(size_t bones)
+   : m_boxes(bones) {}
+
+  /** @brief Sets the bone count and empties every box. */
+  void
+   reset(size_t bones) {
+   m_boxes.assign(bones, AABB());
+  }
+
+  /**
+   * @brief Merges each of positions[0..n) into the box of every joint it has a nonzero weight
+   * on. Called once with the bind pose and again with any morph target or other deformation the
+   * vertices go through before skinning, the boxes then cover them all.
+   */
+  void
+   add(const CVector3* positions, size_t n, const BoneInfluences* influences) {
+   for (size_t i = 0; i < n; ++i) {
+    for (int k = 0; k < 4; ++k) {
+     if (influences[i].weights[k] != 0.f) m_boxes[influences[i].joints[k]].merge(positions[i]);
+    }
+   }
+  }
+
+  /** @brief SoA add(). */
+  void
+   add(EngineMath::batch::ConstSoA3 positions, size_t n, const BoneInfluences* influences) {
+   for (size_t i = 0; i < n; ++i) {
+    const CVector3 p(positions.x[i], positions.y[i], positions.z[i]);
+    for (int k = 0; k < 4; ++k) {
+     if (influences[i].weights[k] != 0.f) m_boxes[influences[i].joints[k]].merge(p);
+    }
+   }
+  }
+
+  /** @brief Box holding the mesh as skinPositions() would skin it with palette. */
+  AABB
+   bounds(const Affine3x4* palette) const {
+   return merge(palette);
+  }
+
+  /** @brief bounds() with a Matrix4x4 palette; its bottom rows are not read. */
+  AABB
+   bounds(const Matrix4x4* palette) const {
+   return merge(palette);
+  }
+
+  /** @brief The bind-pose box of bone; empty when no vertex weighs on it. */
+  const AABB&
+   bone(size_t bone) const {
+   return m_boxes[bone];
+  }
+
+  size_t
+   bones() const {
+   return m_boxes.size();
+  }
+
+  private:
+  /** Union of the non-empty boxes moved by their palette matrices. */
+  template<typename Matrix>
+  AABB
+   merge(const Matrix* palette) const {
+   AABB box;
+   for (size_t b = 0; b < m_boxes.size(); ++b) {
+    if (!m_boxes[b].empty()) box.merge(m_boxes[b].transformed(palette[b]));
+   }
+   return box;
+  }
+
+  std::vector<AABB> m_boxes; ///< Bind-pose box per palette entry
+ };
+}
@@ -0,0 +1,363 @@
+/**
+ * @file StructuredMatrix.h
+ * @brief Translation, scale and rotation-only matrices whose products skip the known zeros.
+ *
+ * A Matrix4x4 built with setTranslation(), setScale() or setRotation() still costs a full
+ * 64-multiply product when composed. TranslationMatrix, ScaleMatrix and RotationMatrix3 store
+ * only their free elements, and every product between them, with Matrix4x4 and with
+ * Affine3x4 is chosen by overload at compile time and does only the arithmetic its structure
+ * needs:
+ *
+ *   T * T -> T (3 adds)               S * S -> S (3 multiplies)     R * R -> R (27 multiplies)
+ *   T * S, S * T, T * R, R * T, S * R, R * S -> Affine3x4 (0 to 9 multiplies)
+ *   Matrix4x4 * T/S/R and T/S/R * Matrix4x4 -> Matrix4x4 (12 to 48 multiplies instead of 64)
+ *   Affine3x4 * T/S/R and T/S/R * Affine3x4 -> Affine3x4
+ *
+ * A result is widened to Affine3x4 or Matrix4x4 only when the structure is really lost.
+ * Conventions are those of Matrix4x4: column vectors, a * b applies b first.
+ */
+
+#pragma once
+
+#include <Math/EngineMath.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/Matrix4x4.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /**
+  * @class TranslationMatrix
+  * @brief Pure translation; the same matrix as Matrix4x4::setTranslation().
+  */
+ class
+  TranslationMatrix {
+  public:
+  CVector3 t; ///< Translation
+
+  constexpr TranslationMatrix() : t(0.f, 0.f, 0.f) {}
+
+  explicit constexpr TranslationMatrix(const CVector3& translation) : t(translation) {}
+
+  constexpr TranslationMatrix(float tx, float ty, float tz) : t(tx, ty, tz) {}
+
+  constexpr CVector3
+   transformPoint(const CVector3& p) const {
+   return CVector3(p.x + t.x, p.y + t.y, p.z + t.z);
+  }
+
+  constexpr TranslationMatrix
+   inverse() const {
+   return TranslationMatrix(-t.x, -t.y, -t.z);
+  }
+
+  constexpr Affine3x4
+   toAffine3x4() const {
+   return Affine3x4(1.f, 0.f, 0.f, t.x, 0.f, 1.f, 0.f, t.y, 0.f, 0.f, 1.f, t.z);
+  }
+
+  constexpr Matrix4x4
+   toMatrix4x4() const {
+   return Matrix4x4(1.f, 0.f, 0.f, t.x, 0.f, 1.f, 0.f, t.y, 0.f, 0.f, 1.f, t.z, 0.f, 0.f, 0.f, 1.f);
+  }
+ };
+
+ /**
+  * @class ScaleMatrix
+  * @brief Pure axis-aligned scale; the same matrix as Matrix4x4::setScale().
+  */
+ class
+  ScaleMatrix {
+  public:
+  CVector3 s; ///< Scale factor per axis
+
+  constexpr ScaleMatrix() : s(1.f, 1.f, 1.f) {}
+
+  explicit constexpr ScaleMatrix(const CVector3& scale) : s(scale) {}
+
+  constexpr ScaleMatrix(float sx, float sy, float sz) : s(sx, sy, sz) {}
+
+  constexpr CVector3
+   transformPoint(const CVector3& p) const {
+   return CVector3(p.x * s.x, p.y * s.y, p.z * s.z);
+  }
+
+  /**
+   * @brief Reciprocal scale. Zero factors stay zero, matching inverse() of the other types
+   * returning a fallback instead of dividing by zero.
+   */
+  constexpr ScaleMatrix
+   inverse() const {
+   return ScaleMatrix(s.x == 0.f ? 0.f : 1.f / s.x, s.y == 0.f ? 0.f : 1.f / s.y, s.z == 0.f ? 0.f : 1.f / s.z);
+  }
+
+  constexpr Affine3x4
+   toAffine3x4() const {
+   return Affine3x4(s.x, 0.f, 0.f, 0.f, 0.f, s.y, 0.f, 0.f, 0.f, 0.f, s.z, 0.f);
+  }
+
+  constexpr Matrix4x4
+   toMatrix4x4() const {
+   return Matrix4x4(s.x, 0.f, 0.f, 0.f, 0.f, s.y, 0.f, 0.f, 0.f, 0.f, s.z, 0.f, 0.f, 0.f, 0.f, 1.f);
+  }
+ };
+
+ /**
+  * @class RotationMatrix3
+  * @brief Orthonormal 3x3 rotation; inverse() is its transpose.
+  */
+ class
+  RotationMatrix3 {
+  public:
+  float m[3][3]; ///< Rotation in row-major order
+
+  /**
+   * @brief Default constructor. Initializes to the identity rotation.
+   */
+  constexpr RotationMatrix3() : m{ { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f, 1.f } } {}
+
+  /**
+   * @brief Takes the nine elements as given; they must form a rotation.
+   */
+  constexpr RotationMatrix3(float m00, float m01, float m02,
+                            float m10, float m11, float m12,
+                            float m20, float m21, float m22)
+   : m{ { m00, m01, m02 }, { m10, m11, m12 }, { m20, m21, m22 } } {}
+
+  /**
+   * @brief Rotation about the Z axis; the same matrix as Matrix4x4::setRotation().
+   */
+  static constexpr RotationMatrix3
+   aroundZ(float radians) {
+   float s = 0.f, c = 0.f;
+   EngineMath::sincos(radians, &s, &c);
+   return RotationMatrix3(c, -s, 0.f, s, c, 0.f, 0.f, 0.f, 1.f);
+  }
+
+  /**
+   * @brief Rotation of a quaternion; it does not need to be normalized.
+   */
+  static constexpr RotationMatrix3
+   fromQuaternion(const Quaternion& q) {
+   const Affine3x4 a = Affine3x4::fromTRS(CVector3(0.f, 0.f, 0.f), q, CVector3(1.f, 1.f, 1.f));
+   return RotationMatrix3(a.m[0][0], a.m[0][1], a.m[0][2], a.m[1][0], a.m[1][1], a.m[1][2],
+                          a.m[2][0], a.m[2][1], a.m[2][2]);
+  }
+
+  constexpr CVector3
+   transformPoint(const CVector3& p) const {
+   return CVector3(
+   m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z,
+   m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z,
+   m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z
+   );
+  }
+
+  /** @brief The transpose, which is the inverse of a rotation. */
+  constexpr RotationMatrix3
+   inverse() const {
+   return RotationMatrix3(m[0][0], m[1][0], m[2][0], m[0][1], m[1][1], m[2][1], m[0][2], m[1][2], m[2][2]);
+  }
+
+  constexpr Affine3x4
+   toAffine3x4() const {
+   return Affine3x4(m[0][0], m[0][1], m[0][2], 0.f, m[1][0], m[1][1], m[1][2], 0.f,
+                    m[2][0], m[2][1], m[2][2], 0.f);
+  }
+
+  constexpr Matrix4x4
+   toMatrix4x4() const {
+   return Matrix4x4(m[0][0], m[0][1], m[0][2], 0.f, m[1][0], m[1][1], m[1][2], 0.f,
+                    m[2][0], m[2][1], m[2][2], 0.f, 0.f, 0.f, 0.f, 1.f);
+  }
+ };
+
+ EU_ASSERT_VALUE_TYPE(TranslationMatrix);
+ EU_ASSERT_VALUE_TYPE(ScaleMatrix);
+ EU_ASSERT_VALUE_TYPE(RotationMatrix3);
+
+ // --- Structured * structured ---
+
+ constexpr TranslationMatrix
+  operator*(const TranslationMatrix& a, const TranslationMatrix& b) {
+  return TranslationMatrix(a.t.x + b.t.x, a.t.y + b.t.y, a.t.z + b.t.z);
+ }
+
+ constexpr ScaleMatrix
+  operator*(const ScaleMatrix& a, const ScaleMatrix& b) {
+  return ScaleMatrix(a.s.x * b.s.x, a.s.y * b.s.y, a.s.z * b.s.z);
+ }
+
+ constexpr RotationMatrix3
+  operator*(const RotationMatrix3& a, const RotationMatrix3& b) {
+  RotationMatrix3 r;
+  for (int i = 0; i < 3; ++i)
+   for (int j = 0; j < 3; ++j)
+    r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+  return r;
+ }
+
+ /** @brief Scale, then translate: no multiplies. */
+ constexpr Affine3x4
+  operator*(const TranslationMatrix& a, const ScaleMatrix& b) {
+  return Affine3x4(b.s.x, 0.f, 0.f, a.t.x, 0.f, b.s.y, 0.f, a.t.y, 0.f, 0.f, b.s.z, a.t.z);
+ }
+
+ /** @brief Translate, then scale: the translation is scaled. */
+ constexpr Affine3x4
+  operator*(const ScaleMatrix& a, const TranslationMatrix& b) {
+  return Affine3x4(a.s.x, 0.f, 0.f, a.s.x * b.t.x, 0.f, a.s.y, 0.f, a.s.y * b.t.y,
+                   0.f, 0.f, a.s.z, a.s.z * b.t.z);
+ }
+
+ /** @brief Rotate, then translate: no multiplies. */
+ constexpr Affine3x4
+  operator*(const TranslationMatrix& a, const RotationMatrix3& b) {
+  return Affine3x4(b.m[0][0], b.m[0][1], b.m[0][2], a.t.x, b.m[1][0], b.m[1][1], b.m[1][2], a.t.y,
+                   b.m[2][0], b.m[2][1], b.m[2][2], a.t.z);
+ }
+
+ /** @brief Translate, then rotate: the translation is rotated. */
+ constexpr Affine3x4
+  operator*(const RotationMatrix3& a, const TranslationMatrix& b) {
+  const CVector3 t = a.transformPoint(b.t);
+  return Affine3x4(a.m[0][0], a.m[0][1], a.m[0][2], t.x, a.m[1][0], a.m[1][1], a.m[1][2], t.y,
+                   a.m[2][0], a.m[2][1], a.m[2][2], t.z);
+ }
+
+ /** @brief Scale, then rotate: column j of the rotation times s[j]. */
+ constexpr Affine3x4
+  operator*(const RotationMatrix3& a, const ScaleMatrix& b) {
+  return Affine3x4(a.m[0][0] * b.s.x, a.m[0][1] * b.s.y, a.m[0][2] * b.s.z, 0.f,
+                   a.m[1][0] * b.s.x, a.m[1][1] * b.s.y, a.m[1][2] * b.s.z, 0.f,
+                   a.m[2][0] * b.s.x, a.m[2][1] * b.s.y, a.m[2][2] * b.s.z, 0.f);
+ }
+
+ /** @brief Rotate, then scale: row i of the rotation times s[i]. */
+ constexpr Affine3x4
+  operator*(const ScaleMatrix& a, const RotationMatrix3& b) {
+  return Affine3x4(a.s.x * b.m[0][0], a.s.x * b.m[0][1], a.s.x * b.m[0][2], 0.f,
+                   a.s.y * b.m[1][0], a.s.y * b.m[1][1], a.s.y * b.m[1][2], 0.f,
+                   a.s.z * b.m[2][0], a.s.z * b.m[2][1], a.s.z * b.m[2][2], 0.f);
+ }
+
+ // --- Matrix4x4 ---
+
+ /** @brief Column 3 becomes m * (t, 1); 12 multiplies. */
+ constexpr Matrix4x4
+  operator*(const Matrix4x4& a, const TranslationMatrix& b) {
+  Matrix4x4 r = a;
+  for (int i = 0; i < 4; ++i) r.m[i][3] = a.m[i][0] * b.t.x + a.m[i][1] * b.t.y + a.m[i][2] * b.t.z + a.m[i][3];
+  return r;
+ }
+
+ /** @brief Row i += t[i] * row 3; 12 multiplies. */
+ constexpr Matrix4x4
+  operator*(const TranslationMatrix& a, const Matrix4x4& b) {
+  Matrix4x4 r = b;
+  const float t[3] = { a.t.x, a.t.y, a.t.z };
+  for (int i = 0; i < 3; ++i)
+   for (int j = 0; j < 4; ++j) r.m[i][j] = b.m[i][j] + t[i] * b.m[3][j];
+  return r;
+ }
+
+ /** @brief Column j times s[j]; 12 multiplies. */
+ constexpr Matrix4x4
+  operator*(const Matrix4x4& a, const ScaleMatrix& b) {
+  Matrix4x4 r = a;
+  for (int i = 0; i < 4; ++i) {
+   r.m[i][0] = a.m[i][0] * b.s.x;
+   r.m[i][1] = a.m[i][1] * b.s.y;
+   r.m[i][2] = a.m[i][2] * b.s.z;
+  }
+  return r;
+ }
+
+ /** @brief Row i times s[i]; 12 multiplies. */
+ constexpr Matrix4x4
+  operator*(const ScaleMatrix& a, const Matrix4x4& b) {
+  Matrix4x4 r = b;
+  const float s[3] = { a.s.x, a.s.y, a.s.z };
+  for (int i = 0; i < 3; ++i)
+   for (int j = 0; j < 4; ++j) r.m[i][j] = s[i] * b.m[i][j];
+  return r;
+ }
+
+ /** @brief Columns 0-2 times the rotation; column 3 unchanged. 36 multiplies. */
+ constexpr Matrix4x4
+  operator*(const Matrix4x4& a, const RotationMatrix3& b) {
+  Matrix4x4 r = a;
+  for (int i = 0; i < 4; ++i)
+   for (int j = 0; j < 3; ++j) r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+  return r;
+ }
+
+ /** @brief Rows 0-2 rotated; row 3 unchanged. 36 multiplies. */
+ constexpr Matrix4x4
+  operator*(const RotationMatrix3& a, const Matrix4x4& b) {
+  Matrix4x4 r = b;
+  for (int i = 0; i < 3; ++i)
+   for (int j = 0; j < 4; ++j) r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+  return r;
+ }
+
+ // --- Affine3x4 ---
+
+ /** @brief Translation column becomes a.transformPoint(t); 9 multiplies. */
+ constexpr Affine3x4
+  operator*(const Affine3x4& a, const TranslationMatrix& b) {
+  Affine3x4 r = a;
+  r.setTranslation(a.transformPoint(b.t));
+  return r;
+ }
+
+ /** @brief Translation column plus t; 3 adds. */
+ constexpr Affine3x4
+  operator*(const TranslationMatrix& a, const Affine3x4& b) {
+  Affine3x4 r = b;
+  r.m[0][3] = b.m[0][3] + a.t.x;
+  r.m[1][3] = b.m[1][3] + a.t.y;
+  r.m[2][3] = b.m[2][3] + a.t.z;
+  return r;
+ }
+
+ /** @brief Column j of the 3x3 block times s[j]; 9 multiplies. */
+ constexpr Affine3x4
+  operator*(const Affine3x4& a, const ScaleMatrix& b) {
+  Affine3x4 r = a;
+  for (int i = 0; i < 3; ++i) {
+   r.m[i][0] = a.m[i][0] * b.s.x;
+   r.m[i][1] = a.m[i][1] * b.s.y;
+   r.m[i][2] = a.m[i][2] * b.s.z;
+  }
+  return r;
+ }
+
+ /** @brief Row i times s[i]; 12 multiplies. */
+ constexpr Affine3x4
+  operator*(const ScaleMatrix& a, const Affine3x4& b) {
+  Affine3x4 r = b;
+  const float s[3] = { a.s.x, a.s.y, a.s.z };
+  for (int i = 0; i < 3; ++i)
+   for (int j = 0; j < 4; ++j) r.m[i][j] = s[i] * b.m[i][j];
+  return r;
+ }
+
+ /** @brief 3x3 block times the rotation; translation unchanged. 27 multiplies. */
+ constexpr Affine3x4
+  operator*(const Affine3x4& a, const RotationMatrix3& b) {
+  Affine3x4 r = a;
+  for (int i = 0; i < 3; ++i)
+   for (int j = 0; j < 3; ++j) r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+  return r;
+ }
+
+ /** @brief Every row (translation included) rotated; 36 multiplies. */
+ constexpr Affine3x4
+  operator*(const RotationMatrix3& a, const Affine3x4& b) {
+  Affine3x4 r = b;
+  for (int i = 0; i < 3; ++i)
+   for (int j = 0; j < 4; ++j) r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+  return r;
+ }
+}
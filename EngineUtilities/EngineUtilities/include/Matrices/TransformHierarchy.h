@@ -0,0 +1,397 @@
+/**
+ * @file TransformHierarchy.h
+ * @brief Parent-child transform tree with lazily propagated world transforms.
+ *
+ * Nodes keep a local translation, rotation and scale in separate arrays and a world
+ * Affine3x4 per node. A node is always added after its parent, so the arrays are in
+ * parent-before-child order and one forward pass updates the whole tree: a node is
+ * recomputed (parent world * local, through the SIMD Affine3x4 product) only if its own
+ * local transform changed or its parent's world transform was recomputed in the same pass.
+ * The pass starts at the first dirty node and returns immediately when nothing moved, so
+ * static parts of a scene cost a flag check at most.
+ *
+ * Nodes are also grouped by depth, one list per level. Large trees are updated level by
+ * level over threads (0 = hardware_concurrency(), 1 = caller only). Each level is cut into
+ * fixed HIERARCHY_CHUNK-sized tasks; a task waits only until every task of the level above
+ * it has finished, not on a barrier over the whole pass. Every node runs the same
+ * computation as in the sequential pass, so the result is the same for any thread count.
+ *
+ * After update(), changedNodes() lists the recomputed nodes in ascending order. Feeding it
+ * to updateNormalMatrices() keeps a cached array of normal matrices current while touching
+ * only the objects that moved.
+ *
+ * rotate() composes an increment into a local rotation through accumulateRotation(): each
+ * node tracks a bound on its rotation's drift from unit length and is renormalized only once
+ * that passes rotationDriftLimit(). The limit is 0 by default, which renormalizes after
+ * every rotate(); setRotationDriftLimit() opts into the lazy mode for nodes that spin every
+ * frame. fromTRS() divides the length out, so drift below the limit never shows in world().
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/Trace.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/Matrix3x3.h>
+#include <Matrices/Matrix4x4.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ namespace detail {
+  /// Nodes of one level per update task; fixes the work split.
+  constexpr size_t HIERARCHY_CHUNK = 4096;
+  /// Trees smaller than this are updated on the calling thread.
+  constexpr size_t PARALLEL_HIERARCHY_MIN = 1 << 15;
+ }
+
+ /**
+  * @class TransformHierarchy
+  * @brief Depth-ordered SoA store of local TRS transforms and their world transforms.
+  *
+  * Nodes are identified by their index, which never changes. world() is valid after the
+  * update() that follows the last change; in between it still holds the previous result.
+  */
+ class
+  TransformHierarchy {
+  public:
+  using Node = uint32_t;
+  /// Parent of root nodes.
+  static constexpr Node NO_PARENT = 0xffffffffu;
+
+  TransformHierarchy() : m_firstDirty(0), m_pass(1), m_driftLimit(0.f) {}
+
+  /**
+   * @brief Adds a node below parent with the given local transform.
+   * @param parent An existing node, or NO_PARENT for a root; anything else adds a root.
+   * @return The new node, always size() - 1.
+   */
+  Node
+   add(Node parent, const CVector3& translation = CVector3(), const Quaternion& rotation = Quaternion(),
+       const CVector3& scale = CVector3(1.f, 1.f, 1.f)) {
+   const Node node = static_cast<Node>(m_parents.size());
+   parent = parent < node ? parent : Node(NO_PARENT);
+   const uint32_t level = parent == NO_PARENT ? 0 : m_depths[parent] + 1;
+   if (level == m_levels.size()) m_levels.emplace_back();
+   m_levels[level].push_back(node);
+   m_parents.push_back(parent);
+   m_depths.push_back(level);
+   m_translations.push_back(translation);
+   m_rotations.push_back(rotation);
+   m_rotationDrift.push_back(rotation.drift());
+   m_scales.push_back(scale);
+   m_worlds.push_back(Affine3x4());
+   m_dirty.push_back(1);
+   m_updated.push_back(0);
+   markDirty(node);
+   return node;
+  }
+
+  /** @brief Number of nodes. */
+  size_t
+   size() const {
+   return m_parents.size();
+  }
+
+  /** @brief Reserves room for n nodes in every array. */
+  void
+   reserve(size_t n) {
+   m_parents.reserve(n);
+   m_depths.reserve(n);
+   m_translations.reserve(n);
+   m_rotations.reserve(n);
+   m_rotationDrift.reserve(n);
+   m_scales.reserve(n);
+   m_worlds.reserve(n);
+   m_dirty.reserve(n);
+   m_updated.reserve(n);
+   m_changed.reserve(n);
+  }
+
+  /** @brief Removes every node. */
+  void
+   clear() {
+   m_parents.clear();
+   m_depths.clear();
+   m_levels.clear();
+   m_translations.clear();
+   m_rotations.clear();
+   m_rotationDrift.clear();
+   m_scales.clear();
+   m_worlds.clear();
+   m_dirty.clear();
+   m_updated.clear();
+   m_changed.clear();
+   m_firstDirty = 0;
+  }
+
+  /** @brief Parent of node, or NO_PARENT. */
+  Node
+   parent(Node node) const {
+   return m_parents[node];
+  }
+
+  /** @brief Depth of node; roots are at depth 0. */
+  uint32_t
+   depth(Node node) const {
+   return m_depths[node];
+  }
+
+  /** @brief Number of depth levels, one more than the deepest node's depth. */
+  size_t
+   levels() const {
+   return m_levels.size();
+  }
+
+  /** @brief The nodes at depth level, in ascending order. */
+  const std::vector<Node>&
+   level(size_t level) const {
+   return m_levels[level];
+  }
+
+  const CVector3&
+   translation(Node node) const {
+   return m_translations[node];
+  }
+
+  const Quaternion&
+   rotation(Node node) const {
+   return m_rotations[node];
+  }
+
+  const CVector3&
+   scale(Node node) const {
+   return m_scales[node];
+  }
+
+  void
+   setTranslation(Node node, const CVector3& translation) {
+   m_translations[node] = translation;
+   markDirty(node);
+  }
+
+  void
+   setRotation(Node node, const Quaternion& rotation) {
+   m_rotations[node] = rotation;
+   m_rotationDrift[node] = rotation.drift();
+   markDirty(node);
+  }
+
+  /**
+   * @brief Composes delta (unit length, in the parent's space) onto node's local rotation:
+   * rotation = delta * rotation, renormalized as rotationDriftLimit() allows.
+   */
+  void
+   rotate(Node node, const Quaternion& delta) {
+   accumulateRotation(m_rotations[node], m_rotationDrift[node], delta, m_driftLimit);
+   markDirty(node);
+  }
+
+  /** @brief Drift rotate() lets a rotation accumulate before renormalizing it; 0 = every call. */
+  float
+   rotationDriftLimit() const {
+   return m_driftLimit;
+  }
+
+  /**
+   * @brief Opts into lazy renormalization for rotate(); QUATERNION_DRIFT_LIMIT is a good
+   * value. Limits above 1e-2 leave noticeable length error after the first-order step.
+   */
+  void
+   setRotationDriftLimit(float limit) {
+   m_driftLimit = limit > 0.f ? limit : 0.f;
+  }
+
+  void
+   setScale(Node node, const CVector3& scale) {
+   m_scales[node] = scale;
+   markDirty(node);
+  }
+
+  /** @brief Replaces the whole local transform of node. */
+  void
+   setLocal(Node node, const CVector3& translation, const Quaternion& rotation, const CVector3& scale) {
+   m_translations[node] = translation;
+   m_rotations[node] = rotation;
+   m_rotationDrift[node] = rotation.drift();
+   m_scales[node] = scale;
+   markDirty(node);
+  }
+
+  /** @brief Local transform of node, built from its translation, rotation and scale. */
+  Affine3x4
+   local(Node node) const {
+   return Affine3x4::fromTRS(m_translations[node], m_rotations[node], m_scales[node]);
+  }
+
+  /** @brief World transform of node as of the last update(). */
+  const Affine3x4&
+   world(Node node) const {
+   return m_worlds[node];
+  }
+
+  /** @brief world() expanded to a Matrix4x4. */
+  Matrix4x4
+   worldMatrix(Node node) const {
+   return m_worlds[node].toMatrix4x4();
+  }
+
+  /** @brief Every world transform in node order, e.g. for a single upload. */
+  const Affine3x4*
+   worlds() const {
+   return m_worlds.data();
+  }
+
+  /** @brief True when the last update() recomputed node's world transform. */
+  bool
+   changed(Node node) const {
+   return m_updated[node] == m_pass;
+  }
+
+  /** @brief The nodes the last update() recomputed, ascending; changed() is true for exactly these. */
+  const std::vector<Node>&
+   changedNodes() const {
+   return m_changed;
+  }
+
+  /**
+   * @brief Recomputes normals[node] = world(node).normalMatrix() for every changedNodes()
+   * entry. normals holds size() matrices and persists across frames; call after update().
+   */
+  void
+   updateNormalMatrices(Matrix3x3* normals) const {
+   normalMatrixArray(m_worlds.data(), m_changed.data(), m_changed.size(), normals);
+  }
+
+  /** @brief Number of the last update() pass; consecutive passes differ by one, except at wrap-around. */
+  uint32_t
+   pass() const {
+   return m_pass;
+  }
+
+  /** @brief True when some local transform changed since the last update(). */
+  bool
+   dirty() const {
+   return m_firstDirty < m_parents.size();
+  }
+
+  /**
+   * @brief Recomputes the world transform of every changed node and of its descendants.
+   * @param threads Worker threads for large trees, 0 for hardware_concurrency().
+   * @return Number of world transforms recomputed.
+   */
+  size_t
+   update(size_t threads = 0) {
+   EU_TRACE_ZONE("TransformHierarchy::update");
+   // A new pass number retires every changed() flag of the previous pass at once.
+   if (++m_pass == 0) {
+    for (uint32_t& updated : m_updated) updated = 0;
+    m_pass = 1;
+   }
+   const size_t n = m_parents.size();
+   m_changed.clear();
+   if (m_firstDirty >= n) {
+    return 0;
+   }
+   size_t recomputed = 0;
+   threads = n < detail::PARALLEL_HIERARCHY_MIN ? 1 : detail::resolveThreads(threads, n / detail::HIERARCHY_CHUNK);
+   if (threads <= 1) {
+    for (size_t i = m_firstDirty; i < n; ++i) recomputed += updateNode(static_cast<Node>(i));
+   }
+   else {
+    recomputed = updateLevels(threads);
+   }
+   for (size_t i = m_firstDirty; i < n; ++i) {
+    if (m_updated[i] == m_pass) m_changed.push_back(static_cast<Node>(i));
+   }
+   m_firstDirty = n;
+   EU_TRACE_COUNTER("Transforms recomputed", recomputed);
+   return recomputed;
+  }
+
+  private:
+  /** Recomputes node if it or its parent changed in this pass; returns 1 if it did. */
+  size_t
+   updateNode(Node i) {
+   const Node p = m_parents[i];
+   const bool parentMoved = p != NO_PARENT && m_updated[p] == m_pass;
+   if (!m_dirty[i] && !parentMoved) {
+    return 0;
+   }
+   const Affine3x4 local = Affine3x4::fromTRS(m_translations[i], m_rotations[i], m_scales[i]);
+   m_worlds[i] = p == NO_PARENT ? local : m_worlds[p] * local;
+   m_dirty[i] = 0;
+   m_updated[i] = m_pass;
+   return 1;
+  }
+
+  /**
+   * The level-parallel pass. Tasks are numbered level by level and parallelTasks() hands
+   * them out in ascending order, so every task of the level above a waiting task has
+   * already been claimed by a running thread and the wait always ends.
+   */
+  size_t
+   updateLevels(size_t threads) {
+   struct Task {
+    uint32_t level;
+    size_t begin;
+   };
+   const size_t levelCount = m_levels.size();
+   std::vector<Task> tasks;
+   std::vector<size_t> levelTasks(levelCount);
+   for (size_t l = 0; l < levelCount; ++l) {
+    const size_t count = m_levels[l].size();
+    for (size_t begin = 0; begin < count; begin += detail::HIERARCHY_CHUNK) {
+     tasks.push_back(Task{ static_cast<uint32_t>(l), begin });
+    }
+    levelTasks[l] = (count + detail::HIERARCHY_CHUNK - 1) / detail::HIERARCHY_CHUNK;
+   }
+   std::unique_ptr<std::atomic<size_t>[]> finished(new std::atomic<size_t>[levelCount]);
+   for (size_t l = 0; l < levelCount; ++l) finished[l].store(0, std::memory_order_relaxed);
+   std::vector<size_t> recomputed(tasks.size());
+   detail::parallelTasks(tasks.size(), threads, [&](size_t t) {
+    const Task task = tasks[t];
+    if (task.level > 0) {
+     const size_t above = task.level - 1;
+     while (finished[above].load(std::memory_order_acquire) < levelTasks[above]) std::this_thread::yield();
+    }
+    const std::vector<Node>& nodes = m_levels[task.level];
+    const size_t end = nodes.size() - task.begin < detail::HIERARCHY_CHUNK ? nodes.size() : task.begin + detail::HIERARCHY_CHUNK;
+    size_t count = 0;
+    for (size_t j = task.begin; j < end; ++j) count += updateNode(nodes[j]);
+    recomputed[t] = count;
+    finished[task.level].fetch_add(1, std::memory_order_release);
+   });
+   size_t total = 0;
+   for (size_t count : recomputed) total += count;
+   return total;
+  }
+
+  void
+   markDirty(Node node) {
+   m_dirty[node] = 1;
+   if (node < m_firstDirty) m_firstDirty = node;
+  }
+
+  std::vector<Node> m_parents;
+  std::vector<uint32_t> m_depths; ///< Depth of each node, 0 for roots
+  std::vector<std::vector<Node>> m_levels; ///< Nodes of each depth, ascending
+  std::vector<CVector3> m_translations;
+  std::vector<Quaternion> m_rotations;
+  std::vector<float> m_rotationDrift; ///< Bound on each rotation's drift(), for rotate()
+  std::vector<CVector3> m_scales;
+  std::vector<Affine3x4> m_worlds;
+  std::vector<uint8_t> m_dirty;    ///< Local transform changed since the last update()
+  std::vector<uint32_t> m_updated; ///< Pass that last recomputed the world transform
+  std::vector<Node> m_changed;     ///< Nodes recomputed by the last update(), ascending
+  size_t m_firstDirty;             ///< No node before this one is dirty
+  uint32_t m_pass;                 ///< Number of the last update() pass, never 0
+  float m_driftLimit;              ///< rotate() renormalizes past this drift
+ };
+}
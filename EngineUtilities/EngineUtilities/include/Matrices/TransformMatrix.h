@@ -0,0 +1,179 @@
+/**
+ * @file TransformMatrix.h
+ * @brief 2D affine transforms stored the way sf::Transform stores them, so a render state
+ * can be built from them without reformatting.
+ *
+ * sf::Transform keeps a 2D transform as the sixteen column-major floats of a 4x4 matrix that
+ * leaves z alone, ready for glLoadMatrixf. TransformMatrix holds the same bytes: a Matrix3x3
+ *
+ *   | a00 a01 a02 |
+ *   | a10 a11 a12 |
+ *   | a20 a21 a22 |
+ *
+ * is stored as the columns (a00, a10, 0, a20), (a01, a11, 0, a21), (0, 0, 1, 0) and
+ * (a02, a12, 0, a22). MatrixSFML.h checks the layout against sf::Transform and views a
+ * TransformMatrix, or an array of them, as sf::Transform in place:
+ *
+ *   TransformMatrix world(sprites.transform(i));
+ *   target.draw(vertices, sf::RenderStates(asTransform(world)));
+ *
+ * The math convention is Matrix3x3's: column vectors, translation in the last column.
+ * toTransformMatrix() converts arrays with one register transpose per matrix; composing
+ * directly in this layout with operator* spares the conversion altogether.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/Platform.h>
+#include <Core/SIMD.h>
+#include <Matrices/Matrix3x3.h>
+#include <Vectors/Vector2.h>
+
+namespace EU {
+
+ /**
+  * @class TransformMatrix
+  * @brief 2D affine matrix as the column-major float[16] of sf::Transform::getMatrix().
+  */
+ class alignas(16)
+  TransformMatrix {
+  public:
+  float m[16]; ///< Columns of the 4x4 embedding, m[4 * col + fil]
+
+  /**
+   * @brief Default constructor. Initializes to identity matrix.
+   */
+  constexpr TransformMatrix()
+   : m{ 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f } {}
+
+  /**
+   * @brief Leaves every element uninitialized; see EU::NoInit.
+   */
+  explicit TransformMatrix(EU::NoInitTag) {}
+
+  /**
+   * @brief The 2D transform mat, element for element what sf::Transform(a00, ..., a22) stores.
+   */
+  explicit constexpr TransformMatrix(const Matrix3x3& mat)
+   : m{ mat.m[0][0], mat.m[1][0], 0.f, mat.m[2][0],
+        mat.m[0][1], mat.m[1][1], 0.f, mat.m[2][1],
+        0.f, 0.f, 1.f, 0.f,
+        mat.m[0][2], mat.m[1][2], 0.f, mat.m[2][2] } {}
+
+  /**
+   * @brief Back to the row-major Matrix3x3.
+   */
+  constexpr Matrix3x3
+   toMatrix3x3() const {
+   return Matrix3x3(m[0], m[4], m[12],
+                    m[1], m[5], m[13],
+                    m[3], m[7], m[15]);
+  }
+
+  /**
+   * @brief Composition, this applied after otro, as sf::Transform::combine() computes it:
+   * the 3x3 product with each element summed left to right.
+   */
+  EU_CONSTEXPR20 TransformMatrix
+   operator*(const TransformMatrix& otro) const {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+   if (std::is_constant_evaluated()) {
+    return multiplyScalar(otro);
+   }
+#endif
+#if defined(EU_SIMD_SSE2) || defined(EU_SIMD_NEON)
+   using EU::SIMD::Float4;
+   TransformMatrix r(EU::NoInit);
+   // Columns 0, 1 and 3 hold the 2D transform; their z lanes are 0, so the products keep them 0.
+   const Float4 a0 = Float4::loadAligned(m), a1 = Float4::loadAligned(m + 4), a3 = Float4::loadAligned(m + 12);
+   for (int col = 0; col < 4; col += col == 1 ? 2 : 1) {
+    const Float4 b = Float4::loadAligned(otro.m + 4 * col);
+    Float4 acc = a0 * EU::SIMD::shuffle<0, 0, 0, 0>(b);
+    acc = acc + a1 * EU::SIMD::shuffle<1, 1, 1, 1>(b);
+    acc = acc + a3 * EU::SIMD::shuffle<3, 3, 3, 3>(b);
+    acc.storeAligned(r.m + 4 * col);
+   }
+   Float4::loadAligned(m + 8).storeAligned(r.m + 8);
+   return r;
+#else
+   return multiplyScalar(otro);
+#endif
+  }
+
+  /**
+   * @brief Transforms a point as sf::Transform::transformPoint() does, without a
+   * perspective divide.
+   */
+  constexpr CVector2
+   transformPoint(const CVector2& point) const {
+   return CVector2(m[0] * point.x + m[4] * point.y + m[12],
+                   m[1] * point.x + m[5] * point.y + m[13]);
+  }
+
+  /**
+   * @brief The 16 floats in sf::Transform::getMatrix() order.
+   */
+  constexpr const float*
+   data() const {
+   return m;
+  }
+
+  /**
+   * @brief Returns an identity matrix.
+   */
+  static constexpr TransformMatrix
+   identity() {
+   return TransformMatrix();
+  }
+
+  private:
+  /** Scalar product with the same accumulation as the SIMD path. */
+  constexpr TransformMatrix
+   multiplyScalar(const TransformMatrix& otro) const {
+   TransformMatrix r;
+   for (int col = 0; col < 4; col += col == 1 ? 2 : 1)
+    for (int fil = 0; fil < 4; ++fil)
+     r.m[4 * col + fil] = (m[fil] * otro.m[4 * col] + m[4 + fil] * otro.m[4 * col + 1]) + m[12 + fil] * otro.m[4 * col + 3];
+   return r;
+  }
+ };
+
+ static_assert(sizeof(TransformMatrix) == 16 * sizeof(float), "TransformMatrix must be 16 packed floats");
+ EU_ASSERT_VALUE_TYPE(TransformMatrix);
+
+ /**
+  * @brief out[i] = TransformMatrix(in[i]). Each matrix is three row loads and one register
+  * transpose, rows 0, 1, a zero row and row 2 becoming columns 0, 1 and 3.
+  */
+ inline void
+  toTransformMatrix(const Matrix3x3* in, TransformMatrix* out, size_t n) {
+  using EU::SIMD::Float4;
+  const float depth[4] = { 0.f, 0.f, 1.f, 0.f };
+  const Float4 column2 = Float4::load(depth);
+  for (size_t i = 0; i < n; ++i) {
+   // A row load takes one float past the row; the last row of the last matrix is copied
+   // first so no load leaves the array. That lane ends up in no stored column.
+   Float4 r0 = Float4::load(in[i].m[0]), r1 = Float4::load(in[i].m[1]), zero = Float4::zero();
+   Float4 r2 = zero;
+   if (i + 1 < n) {
+    r2 = Float4::load(in[i].m[2]);
+   }
+   else {
+    const float last[4] = { in[i].m[2][0], in[i].m[2][1], in[i].m[2][2], 0.f };
+    r2 = Float4::load(last);
+   }
+   EU::SIMD::transpose(r0, r1, zero, r2);
+   r0.storeAligned(out[i].m);
+   r1.storeAligned(out[i].m + 4);
+   column2.storeAligned(out[i].m + 8);
+   zero.storeAligned(out[i].m + 12);
+  }
+ }
+
+ /** @brief out[i] = in[i].toMatrix3x3(). */
+ inline void
+  toMatrix3x3(const TransformMatrix* in, Matrix3x3* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) out[i] = in[i].toMatrix3x3();
+ }
+}
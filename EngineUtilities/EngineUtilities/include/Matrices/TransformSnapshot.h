@@ -0,0 +1,214 @@
+/**
+ * @file TransformSnapshot.h
+ * @brief Triple-buffered, lock-free handoff of world transforms from the simulation thread
+ * to a render thread.
+ *
+ * TransformSnapshots holds three copies of the world transform array. The simulation calls
+ * publish() once per frame, after TransformHierarchy::update(), and the render thread calls
+ * acquire() at the start of its frame. publish() fills the buffer neither side is using,
+ * then swaps it with the ready slot through one atomic exchange; acquire() swaps the ready
+ * slot with its own buffer only when a newer frame has been published since. Neither thread
+ * ever waits for the other: the simulation can run ahead, dropping frames the renderer did
+ * not get to, and the renderer keeps drawing its last frame until a new one is ready. What
+ * acquire() returns stays unchanged until the next acquire() on the same thread.
+ *
+ * Only what changed is copied. publish() turns changedNodes() into index ranges, merging
+ * ranges less than SNAPSHOT_RANGE_GAP nodes apart into one memcpy, and remembers the ranges
+ * of the last SNAPSHOT_HISTORY frames. A buffer that comes back to the simulation missing k
+ * frames gets the ranges of those k frames copied from the current worlds; a buffer older
+ * than the history, a resized hierarchy or an update() that was not published falls back to
+ * one copy of the whole array.
+ *
+ *   // simulation thread
+ *   hierarchy.update();
+ *   snapshots.publish(hierarchy);
+ *   // render thread
+ *   const TransformSnapshot& frame = snapshots.acquire();
+ *   for (size_t i = 0; i < frame.size(); ++i) draw(frame.worldMatrix(i));
+ *
+ * One thread may publish and one other thread may acquire; more of either need a lock.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <Core/Trace.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/Matrix4x4.h>
+#include <Matrices/TransformHierarchy.h>
+
+namespace EU {
+ /// Frames of changed ranges kept; a buffer missing more is copied whole.
+ constexpr size_t SNAPSHOT_HISTORY = 4;
+ /// Changed nodes closer than this are copied as one range, unchanged ones in between included.
+ constexpr uint32_t SNAPSHOT_RANGE_GAP = 16;
+
+ /**
+  * @class TransformSnapshot
+  * @brief Read-only world transforms of one published frame.
+  */
+ class
+  TransformSnapshot {
+  public:
+  /** @brief Frame number of the publish() that produced it; 0 before the first. */
+  uint64_t
+   frame() const {
+   return m_frame;
+  }
+
+  size_t
+   size() const {
+   return m_worlds.size();
+  }
+
+  const Affine3x4*
+   worlds() const {
+   return m_worlds.data();
+  }
+
+  const Affine3x4&
+   world(size_t node) const {
+   return m_worlds[node];
+  }
+
+  /** @brief world(node) expanded to a Matrix4x4. */
+  Matrix4x4
+   worldMatrix(size_t node) const {
+   return m_worlds[node].toMatrix4x4();
+  }
+
+  private:
+  friend class TransformSnapshots;
+
+  std::vector<Affine3x4> m_worlds;
+  uint64_t m_frame = 0;
+ };
+
+ /**
+  * @class TransformSnapshots
+  * @brief Three TransformSnapshot buffers passed between one writer and one reader.
+  */
+ class
+  TransformSnapshots {
+  public:
+  TransformSnapshots() : m_ready(READY_INITIAL), m_front(FRONT_INITIAL), m_back(BACK_INITIAL), m_frame(0), m_pass(0) {}
+
+  TransformSnapshots(const TransformSnapshots&) = delete;
+  TransformSnapshots& operator=(const TransformSnapshots&) = delete;
+
+  /**
+   * @brief Publishes the world transforms of hierarchy as of its last update(). Call once
+   * after every update(); a skipped update() is noticed and costs a full copy.
+   */
+  void
+   publish(const TransformHierarchy& hierarchy) {
+   const bool consecutive = hierarchy.pass() == m_pass + 1;
+   m_pass = hierarchy.pass();
+   const std::vector<uint32_t>& changed = hierarchy.changedNodes();
+   publish(hierarchy.worlds(), hierarchy.size(), changed.data(), changed.size(), !consecutive);
+  }
+
+  /**
+   * @brief Publishes n world transforms of which only the ascending indices changed[0..count)
+   * differ from the previous publish(), or all of them when all is set.
+   */
+  void
+   publish(const Affine3x4* worlds, size_t n, const uint32_t* changed, size_t count, bool all = false) {
+   EU_TRACE_ZONE("TransformSnapshots::publish");
+   ++m_frame;
+   Ranges& history = m_history[m_frame % SNAPSHOT_HISTORY];
+   history.frame = m_frame;
+   history.all = all;
+   history.size = n;
+   history.ranges.clear();
+   if (!all) {
+    for (size_t k = 0; k < count; ++k) {
+     const uint32_t node = changed[k];
+     if (node >= n) continue;
+     if (!history.ranges.empty() && node - history.ranges.back().end < SNAPSHOT_RANGE_GAP) history.ranges.back().end = node + 1;
+     else history.ranges.push_back({ node, node + 1 });
+    }
+   }
+
+   TransformSnapshot& back = m_buffers[m_back];
+   size_t copied = 0;
+   if (missingAll(back, n)) {
+    back.m_worlds.resize(n);
+    if (n) std::memcpy(back.m_worlds.data(), worlds, n * sizeof(Affine3x4));
+    copied = n;
+   }
+   else {
+    for (uint64_t f = back.m_frame + 1; f <= m_frame; ++f) {
+     for (const Range& range : m_history[f % SNAPSHOT_HISTORY].ranges) {
+      std::memcpy(&back.m_worlds[range.begin], &worlds[range.begin], (range.end - range.begin) * sizeof(Affine3x4));
+      copied += range.end - range.begin;
+     }
+    }
+   }
+   back.m_frame = m_frame;
+   EU_TRACE_COUNTER("Snapshot transforms copied", copied);
+   m_back = m_ready.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+  }
+
+  /**
+   * @brief The newest published frame, or the one returned last time if nothing newer was
+   * published. Valid until the next acquire().
+   */
+  const TransformSnapshot&
+   acquire() {
+   if (m_ready.load(std::memory_order_relaxed) & FRESH) {
+    m_front = m_ready.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+   }
+   return m_buffers[m_front];
+  }
+
+  /** @brief Frames published so far. */
+  uint64_t
+   frame() const {
+   return m_frame;
+  }
+
+  private:
+  static constexpr uint32_t INDEX = 3;
+  static constexpr uint32_t FRESH = 4; ///< The ready buffer has not been acquired yet
+  static constexpr uint32_t FRONT_INITIAL = 0;
+  static constexpr uint32_t READY_INITIAL = 1;
+  static constexpr uint32_t BACK_INITIAL = 2;
+
+  struct Range {
+   uint32_t begin;
+   uint32_t end;
+  };
+
+  /** Changed ranges of one published frame. */
+  struct Ranges {
+   uint64_t frame = 0;
+   bool all = true;
+   size_t size = 0;
+   std::vector<Range> ranges;
+  };
+
+  /** True when buffer cannot be brought to the current frame from the range history. */
+  bool
+   missingAll(const TransformSnapshot& buffer, size_t n) const {
+   if (buffer.m_frame == 0 || buffer.m_worlds.size() != n || m_frame - buffer.m_frame > SNAPSHOT_HISTORY) return true;
+   for (uint64_t f = buffer.m_frame + 1; f <= m_frame; ++f) {
+    const Ranges& history = m_history[f % SNAPSHOT_HISTORY];
+    if (history.frame != f || history.all || history.size != n) return true;
+   }
+   return false;
+  }
+
+  TransformSnapshot m_buffers[3];
+  alignas(64) std::atomic<uint32_t> m_ready; ///< Index of the ready buffer, | FRESH once published
+  alignas(64) uint32_t m_front;              ///< Reader's buffer
+  alignas(64) uint32_t m_back;               ///< Writer's buffer
+  uint64_t m_frame;
+  uint32_t m_pass;                           ///< TransformHierarchy::pass() at the last publish()
+  Ranges m_history[SNAPSHOT_HISTORY];
+ };
+}
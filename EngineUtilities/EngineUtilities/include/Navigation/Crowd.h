@@ -0,0 +1,370 @@
+/**
+ * @file Crowd.h
+ * @brief ORCA crowd avoidance (optimal reciprocal collision avoidance) for 2D agents stored
+ * as SoA streams, with neighbours from SpatialHash2D and the agents split over threads.
+ *
+ * Every agent is a disc with a position, velocity, radius, top speed and the velocity it
+ * would like (usually toward its next path point). step() picks for each agent the velocity
+ * nearest its preferred one that avoids every neighbour for timeHorizon seconds, assuming
+ * the neighbour takes half of the avoiding effort (van den Berg, Guy, Lin and Manocha,
+ * "Reciprocal n-body Collision Avoidance"). Each neighbour contributes one half-plane of
+ * allowed velocities; a 2D linear program over the half-planes and the top-speed disc
+ * finds the answer in expected linear time, and when a dense crowd leaves no allowed
+ * velocity, a 3D program finds the one that violates the half-planes the least, so agents
+ * in a jam press into each other slightly instead of freezing.
+ *
+ * Agents live in one array per attribute (positions, velocities, preferred velocities,
+ * radii and top speeds), indexed by the id add() returned; the whole array is handed to
+ * the SpatialHash2D once per step. Each agent considers its maxNeighbors nearest
+ * neighbours within neighborDistance, ties broken by id.
+ *
+ * Agents are processed in fixed CROWD_CHUNK-sized chunks over threads (0 =
+ * hardware_concurrency(), 1 = caller only; JobSystem::useForParallelTasks() lends a job
+ * system's workers). Every agent reads the state from before the step and writes only its
+ * own new velocity, so the result does not depend on the thread count.
+ *
+ *   Crowd crowd;
+ *   for (const Unit& u : units) u.agent = crowd.add(u.position, 0.5f, 3.f);
+ *   // every frame:
+ *   for (const Unit& u : units) crowd.setPreferredVelocity(u.agent, u.steer());
+ *   crowd.step(dt);
+ *   for (Unit& u : units) u.position = crowd.position(u.agent);
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/Trace.h>
+#include <Geometry/SpatialHash2D.h>
+#include <Math/EngineMath.h>
+#include <Vectors/Vector2.h>
+
+namespace EU {
+ namespace detail {
+  /// Agents per step() task; fixes the work split.
+  constexpr size_t CROWD_CHUNK = 256;
+  /// Determinants below this treat two half-plane boundaries as parallel.
+  constexpr float CROWD_EPSILON = 1e-5f;
+
+  /** Half-plane of allowed velocities: the left side of point + t * direction. */
+  struct OrcaLine {
+   CVector2 point;
+   CVector2 direction; ///< Unit length
+  };
+
+  /** Per-task scratch, reused between steps. */
+  struct CrowdScratch {
+   std::vector<uint32_t> found;
+   std::vector<std::pair<float, uint32_t>> neighbors; ///< (distance squared, id)
+   std::vector<OrcaLine> lines;
+   std::vector<OrcaLine> projected;
+  };
+
+  /**
+   * Optimum on the boundary of lines[index] inside the speed disc and the lines before it;
+   * false when that segment is empty.
+   */
+  inline bool
+   orcaProgram1(const OrcaLine* lines, size_t index, float radius, const CVector2& optimum, bool directionOpt,
+                CVector2& result) {
+   const OrcaLine& line = lines[index];
+   const float along = line.point.dot(line.direction);
+   const float discriminant = along * along + radius * radius - line.point.lengthSquared();
+   if (discriminant < 0.f) return false;
+   const float root = EngineMath::sqrt(discriminant);
+   float tLeft = -along - root, tRight = -along + root;
+   for (size_t i = 0; i < index; ++i) {
+    const float denominator = line.direction.cross(lines[i].direction);
+    const float numerator = lines[i].direction.cross(line.point - lines[i].point);
+    if (EngineMath::fabs(denominator) <= CROWD_EPSILON) {
+     if (numerator < 0.f) return false;
+     continue;
+    }
+    const float t = numerator / denominator;
+    if (denominator >= 0.f) tRight = std::min(tRight, t);
+    else tLeft = std::max(tLeft, t);
+    if (tLeft > tRight) return false;
+   }
+   if (directionOpt) {
+    result = line.point + line.direction * (optimum.dot(line.direction) > 0.f ? tRight : tLeft);
+   }
+   else {
+    const float t = line.direction.dot(optimum - line.point);
+    result = line.point + line.direction * EngineMath::clamp(t, tLeft, tRight);
+   }
+   return true;
+  }
+
+  /**
+   * Velocity nearest optimum (or furthest along it when directionOpt) inside the speed disc
+   * and every line; returns the index of the first line it could not satisfy, or count.
+   */
+  inline size_t
+   orcaProgram2(const OrcaLine* lines, size_t count, float radius, const CVector2& optimum, bool directionOpt,
+                CVector2& result) {
+   if (directionOpt) result = optimum * radius;
+   else if (optimum.lengthSquared() > radius * radius) result = optimum * (radius / EngineMath::sqrt(optimum.lengthSquared()));
+   else result = optimum;
+   for (size_t i = 0; i < count; ++i) {
+    if (lines[i].direction.cross(lines[i].point - result) > 0.f) {
+     const CVector2 previous = result;
+     if (!orcaProgram1(lines, i, radius, optimum, directionOpt, result)) {
+      result = previous;
+      return i;
+     }
+    }
+   }
+   return count;
+  }
+
+  /**
+   * From line begin on, where orcaProgram2() failed: the velocity in the speed disc whose
+   * largest violation of any line is smallest.
+   */
+  inline void
+   orcaProgram3(const std::vector<OrcaLine>& lines, size_t begin, float radius, std::vector<OrcaLine>& projected,
+                CVector2& result) {
+   float distance = 0.f;
+   for (size_t i = begin; i < lines.size(); ++i) {
+    const OrcaLine& line = lines[i];
+    if (line.direction.cross(line.point - result) <= distance) continue;
+    projected.clear();
+    for (size_t j = 0; j < i; ++j) {
+     OrcaLine p;
+     const float determinant = line.direction.cross(lines[j].direction);
+     if (EngineMath::fabs(determinant) <= CROWD_EPSILON) {
+      if (line.direction.dot(lines[j].direction) > 0.f) continue; // Same direction
+      p.point = (line.point + lines[j].point) * 0.5f;
+     }
+     else {
+      p.point = line.point + line.direction * (lines[j].direction.cross(line.point - lines[j].point) / determinant);
+     }
+     const CVector2 d = lines[j].direction - line.direction;
+     p.direction = d * (1.f / EngineMath::sqrt(d.lengthSquared()));
+     projected.push_back(p);
+    }
+    const CVector2 previous = result;
+    if (orcaProgram2(projected.data(), projected.size(), radius, CVector2(-line.direction.y, line.direction.x), true,
+                     result) < projected.size()) {
+     result = previous; // Rounding; the result cannot get worse than before
+    }
+    distance = line.direction.cross(line.point - result);
+   }
+  }
+ }
+
+ /**
+  * @struct CrowdSettings
+  * @brief Tuning shared by every agent of a Crowd.
+  */
+ struct CrowdSettings {
+  float timeHorizon = 2.f;      ///< Seconds ahead that velocities must stay collision-free
+  float neighborDistance = 5.f; ///< Centre distance within which agents are considered; also the hash cell size
+  uint32_t maxNeighbors = 10;   ///< Nearest neighbours considered per agent
+ };
+
+ /**
+  * @class Crowd
+  * @brief ORCA agents in SoA streams, stepped in parallel.
+  */
+ class
+  Crowd {
+  public:
+  explicit Crowd(const CrowdSettings& settings = CrowdSettings()) : m_hash(settings.neighborDistance), m_settings(settings) {}
+
+  const CrowdSettings&
+   settings() const {
+   return m_settings;
+  }
+
+  void
+   setSettings(const CrowdSettings& settings) {
+   m_settings = settings;
+   m_hash.setCellSize(settings.neighborDistance);
+  }
+
+  /** @brief Adds an agent at rest and returns its id, the number of agents before the call. */
+  uint32_t
+   add(const CVector2& position, float radius, float maxSpeed) {
+   m_position.push_back(position);
+   m_velocity.push_back(CVector2(0.f, 0.f));
+   m_preferred.push_back(CVector2(0.f, 0.f));
+   m_radius.push_back(radius);
+   m_maxSpeed.push_back(maxSpeed);
+   return static_cast<uint32_t>(m_position.size() - 1);
+  }
+
+  /** @brief Removes every agent. */
+  void
+   clear() {
+   m_position.clear();
+   m_velocity.clear();
+   m_preferred.clear();
+   m_radius.clear();
+   m_maxSpeed.clear();
+   m_next.clear();
+   m_hash.clear();
+  }
+
+  size_t
+   size() const {
+   return m_position.size();
+  }
+
+  void
+   setPreferredVelocity(uint32_t id, const CVector2& velocity) {
+   m_preferred[id] = velocity;
+  }
+
+  /** @brief Teleports agent id; its velocity is kept. */
+  void
+   setPosition(uint32_t id, const CVector2& position) {
+   m_position[id] = position;
+  }
+
+  void
+   setVelocity(uint32_t id, const CVector2& velocity) {
+   m_velocity[id] = velocity;
+  }
+
+  const CVector2&
+   position(uint32_t id) const {
+   return m_position[id];
+  }
+
+  const CVector2&
+   velocity(uint32_t id) const {
+   return m_velocity[id];
+  }
+
+  /** @brief Position stream, indexed by id. */
+  const CVector2*
+   positions() const {
+   return m_position.data();
+  }
+
+  /** @brief Velocity stream, indexed by id. */
+  const CVector2*
+   velocities() const {
+   return m_velocity.data();
+  }
+
+  /** @brief Preferred velocity stream, writable in bulk before step(). */
+  CVector2*
+   preferredVelocities() {
+   return m_preferred.data();
+  }
+
+  /**
+   * @brief Replaces every velocity with its collision-avoiding one and moves every agent
+   * by it for dt seconds.
+   */
+  void
+   step(float dt, size_t threads = 0) {
+   EU_TRACE_ZONE("Crowd::step");
+   const size_t n = m_position.size();
+   if (n == 0 || dt <= 0.f) return;
+   m_hash.assign(m_position.data(), m_radius.data(), n);
+   m_hash.rebuild(threads);
+   m_next.resize(n);
+   const size_t chunks = (n + detail::CROWD_CHUNK - 1) / detail::CROWD_CHUNK;
+   if (m_scratch.size() < chunks) m_scratch.resize(chunks);
+   detail::parallelTasks(chunks, detail::resolveThreads(threads, chunks), [&](size_t c) {
+    const size_t end = std::min(n, (c + 1) * detail::CROWD_CHUNK);
+    for (size_t i = c * detail::CROWD_CHUNK; i < end; ++i) m_next[i] = avoid(static_cast<uint32_t>(i), dt, m_scratch[c]);
+   });
+   for (size_t i = 0; i < n; ++i) {
+    m_velocity[i] = m_next[i];
+    m_position[i] += m_next[i] * dt;
+   }
+  }
+
+  private:
+  /** ORCA velocity of agent i for a step of dt from the current state. */
+  CVector2
+   avoid(uint32_t i, float dt, detail::CrowdScratch& scratch) const {
+   const CVector2 position = m_position[i], velocity = m_velocity[i];
+   const float radius = m_radius[i];
+   const float range = m_settings.neighborDistance, rangeSq = range * range;
+
+   // Nearest neighbours by centre distance, ties by id.
+   scratch.found.clear();
+   m_hash.queryRadius(position, range, scratch.found);
+   scratch.neighbors.clear();
+   for (const uint32_t j : scratch.found) {
+    const float distanceSq = (m_position[j] - position).lengthSquared();
+    if (j != i && distanceSq < rangeSq) scratch.neighbors.push_back({ distanceSq, j });
+   }
+   const size_t keep = std::min<size_t>(scratch.neighbors.size(), m_settings.maxNeighbors);
+   std::partial_sort(scratch.neighbors.begin(), scratch.neighbors.begin() + keep, scratch.neighbors.end());
+
+   const float invHorizon = 1.f / m_settings.timeHorizon, invStep = 1.f / dt;
+   scratch.lines.clear();
+   for (size_t k = 0; k < keep; ++k) {
+    const uint32_t j = scratch.neighbors[k].second;
+    const CVector2 relativePosition = m_position[j] - position;
+    const CVector2 relativeVelocity = velocity - m_velocity[j];
+    const float distanceSq = scratch.neighbors[k].first;
+    const float combined = radius + m_radius[j], combinedSq = combined * combined;
+    detail::OrcaLine line;
+    CVector2 u;
+    if (distanceSq > combinedSq) {
+     // Apart: project the relative velocity on the truncated cone of colliding velocities.
+     const CVector2 w = relativeVelocity - relativePosition * invHorizon;
+     const float wLengthSq = w.lengthSquared(), along = w.dot(relativePosition);
+     if (along < 0.f && along * along > combinedSq * wLengthSq) {
+      // Onto the cut-off circle.
+      const float wLength = EngineMath::sqrt(wLengthSq);
+      const CVector2 unitW = w * (1.f / wLength);
+      line.direction = CVector2(unitW.y, -unitW.x);
+      u = unitW * (combined * invHorizon - wLength);
+     }
+     else {
+      // Onto a leg of the cone.
+      const float leg = EngineMath::sqrt(distanceSq - combinedSq);
+      if (relativePosition.cross(w) > 0.f) {
+       line.direction = CVector2(relativePosition.x * leg - relativePosition.y * combined,
+                                 relativePosition.x * combined + relativePosition.y * leg) * (1.f / distanceSq);
+      }
+      else {
+       line.direction = CVector2(relativePosition.x * leg + relativePosition.y * combined,
+                                 -relativePosition.x * combined + relativePosition.y * leg) * (-1.f / distanceSq);
+      }
+      u = line.direction * relativeVelocity.dot(line.direction) - relativeVelocity;
+     }
+    }
+    else {
+     // Overlapping: separate within this step.
+     const CVector2 w = relativeVelocity - relativePosition * invStep;
+     const float wLength = EngineMath::sqrt(w.lengthSquared());
+     const CVector2 unitW = wLength > 0.f ? w * (1.f / wLength) : CVector2(1.f, 0.f);
+     line.direction = CVector2(unitW.y, -unitW.x);
+     u = unitW * (combined * invStep - wLength);
+    }
+    line.point = velocity + u * 0.5f;
+    scratch.lines.push_back(line);
+   }
+
+   const float maxSpeed = m_maxSpeed[i];
+   CVector2 result;
+   const size_t failed = detail::orcaProgram2(scratch.lines.data(), scratch.lines.size(), maxSpeed, m_preferred[i], false, result);
+   if (failed < scratch.lines.size()) detail::orcaProgram3(scratch.lines, failed, maxSpeed, scratch.projected, result);
+   return result;
+  }
+
+  std::vector<CVector2> m_position;  ///< Per agent id
+  std::vector<CVector2> m_velocity;  ///< Per agent id
+  std::vector<CVector2> m_preferred; ///< Per agent id
+  std::vector<float> m_radius;       ///< Per agent id
+  std::vector<float> m_maxSpeed;     ///< Per agent id
+  std::vector<CVector2> m_next;      ///< New velocities during step()
+  std::vector<detail::CrowdScratch> m_scratch; ///< Per step() task
+  SpatialHash2D m_hash;
+  CrowdSettings m_settings;
+ };
+}
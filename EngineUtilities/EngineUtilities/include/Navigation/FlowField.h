@@ -0,0 +1,566 @@
+/**
+ * @file FlowField.h
+ * @brief Flow fields over PathGrid tiles: one eikonal solve toward a set of goals, a
+ * direction per tile, and bilinear direction lookups for SoA batches of agents.
+ *
+ * When thousands of units share a goal, one field replaces a search per unit. build()
+ * solves the eikonal equation |grad T| = cost on the grid, T = 0 on the goals and infinite
+ * on blocked tiles, with the Godunov upwind scheme on the four axis neighbours; the result
+ * is the travel time from every tile to its nearest goal with far fewer of the 45-degree
+ * artefacts of an 8-connected Dijkstra. Tiles cost 1 unless setCost() says otherwise.
+ *
+ * The grid is solved in FLOW_BLOCK x FLOW_BLOCK blocks. A pass first copies every active
+ * block and its one-tile halo into its own buffer, then solves the blocks on threads, each
+ * to convergence against that frozen halo: rows are updated a register at a time, sweeping
+ * down and up, then again on a transposed copy for the columns, until nothing changes.
+ * Blocks whose edge tiles changed activate the neighbours across those edges for the next
+ * pass, so the solve runs as a wavefront of blocks out from the goals. Since a pass only
+ * reads the buffers taken before it, the field does not depend on the thread count.
+ *
+ * Directions point down the travel-time gradient, taken one-sided toward the smaller
+ * neighbour of each axis and normalized; they are zero on goals, blocked tiles and tiles
+ * that cannot reach a goal. sampleArray() blends the four tile centres around each agent
+ * and renormalizes, vectorized over agents with the gathers done per lane.
+ *
+ *   FlowField field;
+ *   field.build(grid, &goal, 1);
+ *   field.sampleArray(agents.soa(), steering.soa(), agents.size()); // positions in tile units
+ *   // a door closes
+ *   grid.fill(x0, y0, x1, y1, false);
+ *   field.invalidate(x0, y0, x1, y1);
+ *   field.update(grid);
+ *
+ * update() re-solves incrementally: the invalidated tiles, and every tile whose travel time
+ * was derived from one of them through the upwind neighbours it was computed from, are
+ * reset and the blocks holding them solved again; directions are refreshed only in and
+ * around the blocks that ran. The result matches a fresh build() to within float rounding,
+ * the tiles converging in a different order. Positions are in tile units, tile (x, y) covering
+ * [x, x + 1) x [y, y + 1) as in GridPoint::fromVector(). The grid must not change during
+ * build() or update().
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Core/Trace.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Precision.h>
+#include <Navigation/GridPath.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Tiles per side of a FlowField solve block.
+ constexpr int32_t FLOW_BLOCK = 32;
+
+ namespace detail {
+  /// Rows and columns of a block buffer: the block and its halo.
+  constexpr int32_t FLOW_SPAN = FLOW_BLOCK + 2;
+  /// Floats per block buffer row, a multiple of every register width.
+  constexpr int32_t FLOW_STRIDE = 40;
+  constexpr size_t FLOW_BUFFER = size_t(FLOW_SPAN) * FLOW_STRIDE;
+  /// Sweep rounds a block runs in one pass before it yields to the next.
+  constexpr int FLOW_MAX_ROUNDS = 64;
+  static_assert(FLOW_BLOCK % EU::SIMD::FloatN::WIDTH == 0, "blocks must be whole registers wide");
+
+  constexpr uint8_t FLOW_GOAL = 1;
+  constexpr uint8_t FLOW_RESET = 2;
+
+  inline float
+   flowInfinity() {
+   return std::numeric_limits<float>::infinity();
+  }
+
+  /**
+   * Godunov update of |grad T| = f from the smaller neighbour of each axis, a and b,
+   * lane-wise: min(old, solution), with the lanes that improved ORed into changed.
+   * Infinite neighbours or costs give infinity, never NaN.
+   */
+  template<typename V>
+  inline V
+   eikonalLanes(V old, V a, V b, V f, V& changed) {
+   const V lo = EU::SIMD::min(a, b), d = EU::SIMD::max(a, b) - lo;
+   const V one = lo + f;
+   const V two = V::set1(0.5f) * (lo + lo + d + EU::SIMD::sqrt(EU::SIMD::max(V::set1(2.f) * f * f - d * d, V::zero())));
+   const V candidate = EU::SIMD::select(d < f, two, one);
+   const V better = candidate < old;
+   changed = changed | better;
+   return EU::SIMD::select(better, candidate, old);
+  }
+
+  /**
+   * Sweeps rows 1..FLOW_BLOCK of a block buffer down, then up. A row is updated a register
+   * at a time from the row before it in the sweep, already updated, the row after it and
+   * its own neighbours as they were before the row. Returns whether any tile changed.
+   */
+  inline bool
+   flowSweep(float* t, const float* f) {
+   using V = BatchLanes;
+   V changed = V::zero();
+   constexpr int32_t REGISTERS = FLOW_BLOCK / int32_t(BATCH_WIDTH);
+   auto row = [&](int32_t r) {
+    float* c = t + r * FLOW_STRIDE + 1;
+    // The row's side neighbours are all loaded before its first store: a load straddling
+    // the register just stored would stall on store forwarding.
+    V a[REGISTERS];
+    for (int32_t k = 0; k < REGISTERS; ++k) a[k] = EU::SIMD::min(V::load(c + k * BATCH_WIDTH - 1), V::load(c + k * BATCH_WIDTH + 1));
+    for (int32_t k = 0; k < REGISTERS; ++k) {
+     float* x = c + k * BATCH_WIDTH;
+     const V b = EU::SIMD::min(V::load(x - FLOW_STRIDE), V::load(x + FLOW_STRIDE));
+     eikonalLanes(V::load(x), a[k], b, V::load(f + (x - t)), changed).store(x);
+    }
+   };
+   for (int32_t r = 1; r <= FLOW_BLOCK; ++r) row(r);
+   for (int32_t r = FLOW_BLOCK; r >= 1; --r) row(r);
+   return EU::SIMD::any(changed);
+  }
+
+  inline void
+   flowTranspose(const float* in, float* out) {
+   for (int32_t r = 0; r < FLOW_SPAN; ++r) {
+    for (int32_t c = 0; c < FLOW_SPAN; ++c) out[c * FLOW_STRIDE + r] = in[r * FLOW_STRIDE + c];
+   }
+  }
+
+  /**
+   * Solves a block buffer t with costs f against its halo: vertical sweeps on t, horizontal
+   * ones on a transposed copy. Returns false if it had not converged after FLOW_MAX_ROUNDS.
+   */
+  inline bool
+   flowSolveBlock(float* t, const float* f) {
+   float ft[FLOW_BUFFER], tt[FLOW_BUFFER];
+   flowTranspose(f, ft);
+   for (int round = 0; round < FLOW_MAX_ROUNDS; ++round) {
+    bool changed = flowSweep(t, f);
+    flowTranspose(t, tt);
+    changed = flowSweep(tt, ft) || changed;
+    flowTranspose(tt, t);
+    if (!changed) return true;
+   }
+   return false;
+  }
+ }
+
+ /**
+  * @class FlowField
+  * @brief Travel times to a set of goal tiles and the steering directions down them.
+  */
+ class
+  FlowField {
+  public:
+  /**
+   * @brief Solves the field of grid toward goals[0..count) on up to threads threads (0 =
+   * hardware_concurrency(), 1 = caller only). Costs are kept if the grid size is unchanged,
+   * reset to 1 otherwise. Returns false, with every tile unreachable, if no goal is walkable.
+   */
+  bool
+   build(const PathGrid& grid, const GridPoint* goals, size_t count, size_t threads = 0) {
+   EU_TRACE_ZONE("FlowField::build");
+   resize(grid);
+   for (const GridPoint& g : m_goals) m_flags[grid.node(g.x, g.y)] = 0;
+   m_goals.clear();
+   for (size_t i = 0; i < count; ++i) {
+    if (grid.walkable(goals[i])) m_goals.push_back(goals[i]);
+   }
+   std::fill(m_time.begin(), m_time.end(), detail::flowInfinity());
+   m_dirty.clear();
+   m_active.clear();
+   for (const GridPoint& g : m_goals) {
+    const uint32_t n = grid.node(g.x, g.y);
+    m_flags[n] = detail::FLOW_GOAL;
+    m_time[n] = 0.f;
+    activate(blockOf(g.x, g.y));
+   }
+   solve(grid, threads);
+   std::fill(m_touched.begin(), m_touched.end(), uint8_t(1));
+   refreshDirections(threads);
+   return !m_goals.empty();
+  }
+
+  /**
+   * @brief Marks the tiles of [x0, x1] x [y0, y1] (clipped to the grid) as changed, e.g.
+   * after PathGrid::fill(); the next update() re-solves around them.
+   */
+  void
+   invalidate(int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+   x0 = std::max(x0, 0);
+   y0 = std::max(y0, 0);
+   x1 = std::min(x1, int32_t(m_width) - 1);
+   y1 = std::min(y1, int32_t(m_height) - 1);
+   for (int32_t y = y0; y <= y1; ++y) {
+    for (int32_t x = x0; x <= x1; ++x) m_dirty.push_back(node(x, y));
+   }
+  }
+
+  /** @brief Cost of crossing tile (x, y), > 0 (default 1); takes effect at the next update(). */
+  void
+   setCost(int32_t x, int32_t y, float cost) {
+   if (x < 0 || y < 0 || uint32_t(x) >= m_width || uint32_t(y) >= m_height || !(cost > 0.f)) return;
+   m_cost[node(x, y)] = cost;
+   invalidate(x, y, x, y);
+  }
+
+  /**
+   * @brief Brings the field up to date with the invalidated tiles of grid. A grid of another
+   * size is rebuilt from scratch. Returns the number of tiles whose travel time was reset.
+   */
+  size_t
+   update(const PathGrid& grid, size_t threads = 0) {
+   EU_TRACE_ZONE("FlowField::update");
+   if (grid.width() != m_width || grid.height() != m_height) {
+    const std::vector<GridPoint> goals = m_goals;
+    build(grid, goals.data(), goals.size(), threads);
+    return size_t(m_width) * m_height;
+   }
+   if (m_dirty.empty()) return 0;
+   const size_t reset = raise(grid);
+   solve(grid, threads);
+   refreshDirections(threads);
+   EU_TRACE_COUNTER("flow tiles reset", static_cast<double>(reset));
+   return reset;
+  }
+
+  /** @brief Travel time from tile p to the nearest goal; infinity if blocked, unreachable or outside. */
+  float
+   cost(GridPoint p) const {
+   return contains(p) ? m_time[node(p.x, p.y)] : detail::flowInfinity();
+  }
+
+  /** @brief Unit steering direction of tile p, or zero. */
+  CVector2
+   direction(GridPoint p) const {
+   if (!contains(p)) return CVector2(0.f, 0.f);
+   const uint32_t n = node(p.x, p.y);
+   return CVector2(m_dirX[n], m_dirY[n]);
+  }
+
+  /** @brief Bilinear direction at position p (tile units), as sampleArray() computes it. */
+  template<typename Policy = EU::Precision::Default>
+  CVector2
+   sample(const CVector2& p) const {
+   CVector2 out;
+   sampleDirections<Policy>(EngineMath::batch::ConstSoA2{ &p.x, &p.y }, EngineMath::batch::SoA2{ &out.x, &out.y }, 1);
+   return out;
+  }
+
+  /**
+   * @brief directions[i] = the four tile directions around positions[i] blended bilinearly
+   * and renormalized; positions outside the grid are clamped to its edge tile centres.
+   */
+  template<typename Policy = EU::Precision::Default>
+  void
+   sampleArray(EngineMath::batch::ConstSoA2 positions, EngineMath::batch::SoA2 directions, size_t n) const {
+   sampleDirections<Policy>(positions, directions, n);
+  }
+
+  /** @brief Interleaved CVector2 sampleArray(). */
+  template<typename Policy = EU::Precision::Default>
+  void
+   sampleArray(const CVector2* positions, CVector2* directions, size_t n) const {
+   sampleDirections<Policy>(reinterpret_cast<const float*>(positions), reinterpret_cast<float*>(directions), n);
+  }
+
+  uint32_t
+   width() const {
+   return m_width;
+  }
+
+  uint32_t
+   height() const {
+   return m_height;
+  }
+
+  /** @brief Walkable goals of the last build(). */
+  const std::vector<GridPoint>&
+   goals() const {
+   return m_goals;
+  }
+
+  /** @brief Travel times in the padded layout of PathGrid::node(). */
+  const float*
+   times() const {
+   return m_time.data();
+  }
+
+  private:
+  bool
+   contains(GridPoint p) const {
+   return p.x >= 0 && p.y >= 0 && uint32_t(p.x) < m_width && uint32_t(p.y) < m_height;
+  }
+
+  uint32_t
+   node(int32_t x, int32_t y) const {
+   return uint32_t(y + 1) * m_pitch + uint32_t(x + 1);
+  }
+
+  uint32_t
+   blockOf(int32_t x, int32_t y) const {
+   return uint32_t(y / FLOW_BLOCK) * m_blocksX + uint32_t(x / FLOW_BLOCK);
+  }
+
+  void
+   resize(const PathGrid& grid) {
+   const size_t nodes = grid.nodeCount();
+   if (grid.width() != m_width || grid.height() != m_height || m_cost.size() != nodes) {
+    m_width = grid.width();
+    m_height = grid.height();
+    m_pitch = grid.pitch();
+    m_blocksX = (m_width + FLOW_BLOCK - 1) / FLOW_BLOCK;
+    m_blocksY = (m_height + FLOW_BLOCK - 1) / FLOW_BLOCK;
+    m_cost.assign(nodes, 1.f);
+    m_flags.assign(nodes, 0);
+    m_goals.clear();
+    m_time.assign(nodes, detail::flowInfinity());
+    m_dirX.assign(nodes, 0.f);
+    m_dirY.assign(nodes, 0.f);
+    m_queued.assign(size_t(m_blocksX) * m_blocksY, 0);
+    m_touched.assign(size_t(m_blocksX) * m_blocksY, 0);
+   }
+  }
+
+  void
+   activate(uint32_t block) {
+   if (m_queued[block]) return;
+   m_queued[block] = 1;
+   m_active.push_back(block);
+  }
+
+  /**
+   * True when tile t's travel time was computed from its axis neighbour s: s is the smaller
+   * neighbour on its axis (ties count for both) and lies below t.
+   */
+  bool
+   dependsOn(uint32_t t, uint32_t s, uint32_t other) const {
+   const float ts = m_time[s];
+   return m_time[t] < detail::flowInfinity() && ts < m_time[t] && ts <= m_time[other];
+  }
+
+  /**
+   * Resets the dirty tiles and, transitively, every tile computed from one of them, and
+   * activates the blocks holding them. Returns the number of tiles reset.
+   */
+  size_t
+   raise(const PathGrid& grid) {
+   m_queue.clear();
+   for (uint32_t n : m_dirty) {
+    if (m_flags[n] & detail::FLOW_RESET) continue;
+    m_flags[n] |= detail::FLOW_RESET;
+    m_queue.push_back(n);
+   }
+   m_dirty.clear();
+   const uint32_t p = m_pitch;
+   for (size_t head = 0; head < m_queue.size(); ++head) {
+    const uint32_t s = m_queue[head];
+    // Each neighbour t of s, with the tile across t from s: t - 1 for t = s + 1, and so on.
+    const uint32_t around[4][2] = { { s + 1, s + 2 }, { s - 1, s - 2 }, { s + p, s + 2 * p }, { s - p, s - 2 * p } };
+    for (const uint32_t* pair : around) {
+     const uint32_t t = pair[0];
+     if ((m_flags[t] & detail::FLOW_RESET) || !dependsOn(t, s, pair[1])) continue;
+     m_flags[t] |= detail::FLOW_RESET;
+     m_queue.push_back(t);
+    }
+   }
+   const uint8_t* cells = grid.cells();
+   for (uint32_t n : m_queue) {
+    m_flags[n] &= uint8_t(~detail::FLOW_RESET);
+    m_time[n] = (m_flags[n] & detail::FLOW_GOAL) && cells[n] ? 0.f : detail::flowInfinity();
+    activate(blockOf(int32_t(n % p) - 1, int32_t(n / p) - 1));
+   }
+   return m_queue.size();
+  }
+
+  /** Runs passes over the active blocks until none is left. */
+  void
+   solve(const PathGrid& grid, size_t threads) {
+   while (!m_active.empty()) {
+    std::sort(m_active.begin(), m_active.end());
+    const size_t count = m_active.size();
+    m_buffers.resize(count * detail::FLOW_BUFFER);
+    m_edges.assign(count, 0);
+    const size_t workers = detail::resolveThreads(threads, count);
+    detail::parallelTasks(count, workers, [&](size_t k) { gather(m_active[k], &m_buffers[k * detail::FLOW_BUFFER]); });
+    detail::parallelTasks(count, workers, [&](size_t k) {
+     m_edges[k] = solveBlock(grid, m_active[k], &m_buffers[k * detail::FLOW_BUFFER]);
+    });
+    m_next.clear();
+    for (size_t k = 0; k < count; ++k) m_queued[m_active[k]] = 0;
+    std::swap(m_active, m_next);
+    for (size_t k = 0; k < count; ++k) {
+     const uint32_t b = m_next[k], bx = b % m_blocksX, by = b / m_blocksX;
+     const uint8_t edges = m_edges[k];
+     if (edges & 16) activate(b);
+     if ((edges & 1) && bx > 0) activate(b - 1);
+     if ((edges & 2) && bx + 1 < m_blocksX) activate(b + 1);
+     if ((edges & 4) && by > 0) activate(b - m_blocksX);
+     if ((edges & 8) && by + 1 < m_blocksY) activate(b + m_blocksX);
+    }
+   }
+  }
+
+  /** Copies block b and its halo into buf; tiles past the grid's blocked border are infinite. */
+  void
+   gather(uint32_t b, float* buf) const {
+   const int32_t x0 = int32_t(b % m_blocksX) * FLOW_BLOCK - 1, y0 = int32_t(b / m_blocksX) * FLOW_BLOCK - 1;
+   for (int32_t r = 0; r < detail::FLOW_SPAN; ++r) {
+    float* row = buf + r * detail::FLOW_STRIDE;
+    std::fill_n(row, detail::FLOW_STRIDE, detail::flowInfinity());
+    const int32_t y = y0 + r;
+    if (y < -1 || y > int32_t(m_height)) continue;
+    const int32_t from = std::max(x0, -1), to = std::min(x0 + detail::FLOW_SPAN - 1, int32_t(m_width));
+    if (from <= to) std::copy_n(&m_time[node(from, y)], to - from + 1, row + (from - x0));
+   }
+  }
+
+  /**
+   * Solves block b in buf and writes its tiles back. Returns a mask of the edges (1 left,
+   * 2 right, 4 top, 8 bottom) with a changed tile, plus 16 if the block must run again.
+   */
+  uint8_t
+   solveBlock(const PathGrid& grid, uint32_t b, float* buf) {
+   const int32_t x0 = int32_t(b % m_blocksX) * FLOW_BLOCK - 1, y0 = int32_t(b / m_blocksX) * FLOW_BLOCK - 1;
+   const int32_t w = std::min(FLOW_BLOCK, int32_t(m_width) - x0 - 1), h = std::min(FLOW_BLOCK, int32_t(m_height) - y0 - 1);
+   float f[detail::FLOW_BUFFER];
+   std::fill_n(f, detail::FLOW_BUFFER, detail::flowInfinity());
+   const uint8_t* cells = grid.cells();
+   for (int32_t r = 1; r <= h; ++r) {
+    const uint32_t n = node(x0 + 1, y0 + r);
+    for (int32_t c = 0; c < w; ++c) f[r * detail::FLOW_STRIDE + 1 + c] = cells[n + c] ? m_cost[n + c] : detail::flowInfinity();
+   }
+   uint8_t edges = detail::flowSolveBlock(buf, f) ? 0 : 16;
+   for (int32_t r = 1; r <= h; ++r) {
+    float* time = &m_time[node(x0 + 1, y0 + r)];
+    const float* row = buf + r * detail::FLOW_STRIDE + 1;
+    for (int32_t c = 0; c < w; ++c) {
+     if (row[c] == time[c]) continue;
+     time[c] = row[c];
+     edges |= uint8_t((c == 0 ? 1 : 0) | (c == FLOW_BLOCK - 1 ? 2 : 0) | (r == 1 ? 4 : 0) | (r == FLOW_BLOCK ? 8 : 0));
+    }
+   }
+   m_touched[b] = 1;
+   return edges;
+  }
+
+  /** Recomputes the directions of every touched block and of the blocks next to one. */
+  void
+   refreshDirections(size_t threads) {
+   m_next.clear();
+   for (uint32_t b = 0; b < m_touched.size(); ++b) {
+    const uint32_t bx = b % m_blocksX, by = b / m_blocksX;
+    const bool nearTouched = m_touched[b] || (bx > 0 && m_touched[b - 1]) || (bx + 1 < m_blocksX && m_touched[b + 1]) ||
+                             (by > 0 && m_touched[b - m_blocksX]) || (by + 1 < m_blocksY && m_touched[b + m_blocksX]);
+    if (nearTouched) m_next.push_back(b);
+   }
+   std::fill(m_touched.begin(), m_touched.end(), uint8_t(0));
+   detail::parallelTasks(m_next.size(), detail::resolveThreads(threads, m_next.size()), [&](size_t k) {
+    const uint32_t b = m_next[k];
+    const int32_t x0 = int32_t(b % m_blocksX) * FLOW_BLOCK, y0 = int32_t(b / m_blocksX) * FLOW_BLOCK;
+    const int32_t x1 = std::min(x0 + FLOW_BLOCK, int32_t(m_width)), y1 = std::min(y0 + FLOW_BLOCK, int32_t(m_height));
+    for (int32_t y = y0; y < y1; ++y) directionRow(node(x0, y), size_t(x1 - x0));
+   });
+  }
+
+  /** Directions of count tiles from node n on, a register at a time. */
+  void
+   directionRow(uint32_t n, size_t count) {
+   using V = detail::BatchLanes;
+   const size_t W = detail::BATCH_WIDTH;
+   const float* t = m_time.data();
+   const int32_t p = int32_t(m_pitch);
+   for (size_t i = 0; i < count; i += W) {
+    const size_t lanes = std::min(W, count - i);
+    const float* c = t + n + i;
+    float tc[detail::BATCH_WIDTH], tl[detail::BATCH_WIDTH], tr[detail::BATCH_WIDTH], tu[detail::BATCH_WIDTH], td[detail::BATCH_WIDTH];
+    for (size_t j = 0; j < W; ++j) {
+     const int32_t k = int32_t(j < lanes ? j : 0);
+     tc[j] = c[k];
+     tl[j] = c[k - 1];
+     tr[j] = c[k + 1];
+     tu[j] = c[k - p];
+     td[j] = c[k + p];
+    }
+    const V centre = V::load(tc), left = V::load(tl), right = V::load(tr), up = V::load(tu), down = V::load(td);
+    const V reached = centre < V::set1(detail::flowInfinity());
+    const V gx = EU::SIMD::select(left < right, centre - left, right - centre) & (EU::SIMD::min(left, right) < centre) & reached;
+    const V gy = EU::SIMD::select(up < down, centre - up, down - centre) & (EU::SIMD::min(up, down) < centre) & reached;
+    const V lengthSq = gx * gx + gy * gy;
+    const V scale = (V::zero() - EU::Precision::Default::invLengthLanes(lengthSq)) & (lengthSq > V::zero());
+    detail::storeLanes(gx * scale, m_dirX.data() + n, i, lanes);
+    detail::storeLanes(gy * scale, m_dirY.data() + n, i, lanes);
+   }
+  }
+
+  template<typename Policy, typename In, typename Out>
+  void
+   sampleDirections(In positions, Out directions, size_t n) const {
+   using V = detail::BatchLanes;
+   using I = V::Int;
+   const size_t W = detail::BATCH_WIDTH;
+   if (m_width == 0 || m_height == 0) {
+    detail::forEachPacket2(positions, n, [&](size_t i, size_t count, V, V) {
+     detail::storePacket2(directions, i, count, V::zero(), V::zero());
+    });
+    return;
+   }
+   const V half = V::set1(0.5f);
+   const V maxX = V::set1(float(m_width - 1)), maxY = V::set1(float(m_height - 1));
+   const float* dx = m_dirX.data();
+   const float* dy = m_dirY.data();
+   const uint32_t p = m_pitch;
+   detail::forEachPacket2(positions, n, [&](size_t i, size_t count, V x, V y) {
+    const V u = EU::SIMD::min(EU::SIMD::max(x - half, V::zero()), maxX);
+    const V v = EU::SIMD::min(EU::SIMD::max(y - half, V::zero()), maxY);
+    const I iu = EU::SIMD::truncToInt(u), iv = EU::SIMD::truncToInt(v);
+    const V fu = u - EU::SIMD::toFloat(iu), fv = v - EU::SIMD::toFloat(iv);
+    int32_t cx[detail::BATCH_WIDTH], cy[detail::BATCH_WIDTH];
+    iu.store(cx);
+    iv.store(cy);
+    float c[8][detail::BATCH_WIDTH];
+    for (size_t j = 0; j < W; ++j) {
+     const uint32_t k = uint32_t(cy[j] + 1) * p + uint32_t(cx[j] + 1);
+     c[0][j] = dx[k];
+     c[1][j] = dx[k + 1];
+     c[2][j] = dx[k + p];
+     c[3][j] = dx[k + p + 1];
+     c[4][j] = dy[k];
+     c[5][j] = dy[k + 1];
+     c[6][j] = dy[k + p];
+     c[7][j] = dy[k + p + 1];
+    }
+    const V x0 = Policy::maddLanes(V::load(c[1]) - V::load(c[0]), fu, V::load(c[0]));
+    const V x1 = Policy::maddLanes(V::load(c[3]) - V::load(c[2]), fu, V::load(c[2]));
+    const V y0 = Policy::maddLanes(V::load(c[5]) - V::load(c[4]), fu, V::load(c[4]));
+    const V y1 = Policy::maddLanes(V::load(c[7]) - V::load(c[6]), fu, V::load(c[6]));
+    const V rx = Policy::maddLanes(x1 - x0, fv, x0), ry = Policy::maddLanes(y1 - y0, fv, y0);
+    const V lengthSq = rx * rx + ry * ry;
+    const V scale = Policy::invLengthLanes(lengthSq) & (lengthSq > V::zero());
+    detail::storePacket2(directions, i, count, rx * scale, ry * scale);
+   });
+  }
+
+  uint32_t m_width = 0;
+  uint32_t m_height = 0;
+  uint32_t m_pitch = 2;
+  uint32_t m_blocksX = 0;
+  uint32_t m_blocksY = 0;
+  std::vector<float> m_time;        ///< Travel time per padded tile
+  std::vector<float> m_cost;        ///< Crossing cost per padded tile
+  std::vector<float> m_dirX;        ///< Unit direction per padded tile...
+  std::vector<float> m_dirY;        ///< ...y component
+  std::vector<uint8_t> m_flags;     ///< FLOW_GOAL and FLOW_RESET per padded tile
+  std::vector<GridPoint> m_goals;
+  std::vector<uint32_t> m_dirty;    ///< Invalidated tiles since the last update()
+  std::vector<uint32_t> m_queue;    ///< raise() work list
+  std::vector<uint32_t> m_active;   ///< Blocks of the next pass
+  std::vector<uint32_t> m_next;
+  std::vector<uint8_t> m_queued;    ///< Per block: in m_active
+  std::vector<uint8_t> m_touched;   ///< Per block: solved since the directions were refreshed
+  std::vector<uint8_t> m_edges;     ///< Per active block: solveBlock() result
+  std::vector<float> m_buffers;     ///< Per active block: FLOW_BUFFER floats
+ };
+}
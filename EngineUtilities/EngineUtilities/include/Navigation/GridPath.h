@@ -0,0 +1,654 @@
+/**
+ * @file GridPath.h
+ * @brief A* and Jump Point Search on 8-connected tile grids, with reusable per-thread search
+ * state and batch queries over the job system.
+ *
+ * PathGrid stores one walkable byte per tile, surrounded by a one-tile blocked border so the
+ * searches never test coordinates against the bounds, in row-major and column-major copies. Moves cost 1 straight and sqrt(2)
+ * diagonally; a diagonal move needs both tiles it passes between to be walkable (no corner
+ * cutting). The heuristic is the octile distance, which is exact on an empty grid.
+ *
+ * PathFinder keeps the per-node search data (g cost, parent, open-heap position) in flat
+ * arrays indexed by tile, stamped with a query generation: a node whose stamp is old counts
+ * as unvisited, so nothing is cleared between queries and, once the arrays have grown to the
+ * grid, a query allocates nothing but its output. The open list is a binary heap of (f, node)
+ * kept as two parallel arrays, so sifting reads only the keys; each node records its heap
+ * slot for decrease-key. Costs are integers in a sqrt(2) ratio, so ties on f are exact and go
+ * to the node with the larger g, the one nearer the goal; f and g share one 64-bit key.
+ *
+ * PathAlgorithm::JumpPoint (the default) is Harabor and Grastien's JPS adapted to the no
+ * corner cutting rule: straight and diagonal runs are scanned in place, eight tiles per word
+ * along a row or a column, and only their jump points enter the heap, which on open maps is
+ * tens of times fewer nodes than A*. It returns
+ * the same cost as A* and a path of jump points joined by straight or diagonal runs;
+ * expandPath() turns it into every tile. AStar returns every tile directly.
+ *
+ *   PathGrid grid(256, 256);
+ *   grid.setWalkable(10, 4, false);
+ *   PathFinder finder;
+ *   std::vector<GridPoint> path;
+ *   if (finder.find(grid, { 0, 0 }, { 200, 120 }, path)) follow(path);
+ *
+ *   PathBatch batch;                                    // one PathFinder per thread
+ *   batch.find(grid, queries, results, count, jobs);    // or (..., threads)
+ *
+ * The grid must not change during a search; any number of PathFinders may read one grid.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <Core/JobSystem.h>
+#include <Core/Parallel.h>
+#include <Core/Trace.h>
+#include <Math/EngineMath.h>
+#include <Math/IntMath.h>
+#include <Vectors/Vector2.h>
+
+namespace EU {
+ constexpr uint32_t PATH_NONE = 0xffffffffu;
+ /// Cost of one diagonal move.
+ constexpr float PATH_DIAGONAL_COST = 1.41421356237309504880f;
+
+ /**
+  * @struct GridPoint
+  * @brief Integer tile coordinates.
+  */
+ struct GridPoint {
+  int32_t x = 0;
+  int32_t y = 0;
+
+  constexpr GridPoint() = default;
+  constexpr GridPoint(int32_t x, int32_t y) : x(x), y(y) {}
+
+  /** @brief The tile containing v (components floored). */
+  static GridPoint
+   fromVector(const CVector2& v) {
+   return { static_cast<int32_t>(EngineMath::floor(v.x)), static_cast<int32_t>(EngineMath::floor(v.y)) };
+  }
+
+  CVector2
+   toVector() const {
+   return CVector2(static_cast<float>(x), static_cast<float>(y));
+  }
+
+  constexpr bool
+   operator==(const GridPoint& otro) const {
+   return x == otro.x && y == otro.y;
+  }
+
+  constexpr bool
+   operator!=(const GridPoint& otro) const {
+   return !(*this == otro);
+  }
+ };
+
+ enum class PathAlgorithm {
+  AStar,
+  JumpPoint
+ };
+
+ /**
+  * @class PathGrid
+  * @brief Walkable tiles of a width x height grid; tiles outside it are blocked.
+  *
+  * Tiles are kept twice, row-major and column-major, so that JPS scans columns as
+  * contiguous bytes too.
+  */
+ class
+  PathGrid {
+  public:
+  /// Blocked bytes before and after each layout, so eight-tile scans never leave the array.
+  static constexpr size_t PAD = 16;
+
+  PathGrid() {
+   resize(0, 0);
+  }
+
+  /** @brief A grid of walkable tiles. */
+  PathGrid(uint32_t width, uint32_t height) {
+   resize(width, height);
+  }
+
+  /** @brief Resizes to width x height, every tile walkable. */
+  void
+   resize(uint32_t width, uint32_t height) {
+   m_width = width;
+   m_height = height;
+   m_pitch = width + 2;
+   m_columnPitch = height + 2;
+   m_rows.assign(nodeCount() + 2 * PAD, 0);
+   m_columns.assign(nodeCount() + 2 * PAD, 0);
+   fill(0, 0, int32_t(width) - 1, int32_t(height) - 1, true);
+  }
+
+  uint32_t
+   width() const {
+   return m_width;
+  }
+
+  uint32_t
+   height() const {
+   return m_height;
+  }
+
+  bool
+   contains(GridPoint p) const {
+   return p.x >= 0 && p.y >= 0 && uint32_t(p.x) < m_width && uint32_t(p.y) < m_height;
+  }
+
+  bool
+   walkable(GridPoint p) const {
+   return contains(p) && cells()[node(p.x, p.y)];
+  }
+
+  void
+   setWalkable(int32_t x, int32_t y, bool walkable) {
+   if (!contains({ x, y })) return;
+   m_rows[PAD + node(x, y)] = walkable ? 1 : 0;
+   m_columns[PAD + columnNode(x, y)] = walkable ? 1 : 0;
+  }
+
+  /** @brief Sets every tile of the rectangle [x0, x1] x [y0, y1] (clipped to the grid). */
+  void
+   fill(int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool walkable) {
+   x0 = std::max(x0, 0);
+   y0 = std::max(y0, 0);
+   x1 = std::min(x1, int32_t(m_width) - 1);
+   y1 = std::min(y1, int32_t(m_height) - 1);
+   if (x0 > x1 || y0 > y1) return;
+   const uint8_t value = walkable ? 1 : 0;
+   for (int32_t y = y0; y <= y1; ++y) std::fill_n(&m_rows[PAD + node(x0, y)], x1 - x0 + 1, value);
+   for (int32_t x = x0; x <= x1; ++x) std::fill_n(&m_columns[PAD + columnNode(x, y0)], y1 - y0 + 1, value);
+  }
+
+  /** @brief Node index of tile (x, y) in the padded row-major layout the searches use. */
+  uint32_t
+   node(int32_t x, int32_t y) const {
+   return uint32_t(y + 1) * m_pitch + uint32_t(x + 1);
+  }
+
+  /** @brief Index of tile (x, y) in the padded column-major layout. */
+  uint32_t
+   columnNode(int32_t x, int32_t y) const {
+   return uint32_t(x + 1) * m_columnPitch + uint32_t(y + 1);
+  }
+
+  GridPoint
+   point(uint32_t node) const {
+   return { int32_t(node % m_pitch) - 1, int32_t(node / m_pitch) - 1 };
+  }
+
+  /** @brief Row stride of the row-major layout, width + 2. */
+  uint32_t
+   pitch() const {
+   return m_pitch;
+  }
+
+  /** @brief Column stride of the column-major layout, height + 2. */
+  uint32_t
+   columnPitch() const {
+   return m_columnPitch;
+  }
+
+  /** @brief Walkable bytes of the row-major layout, (width + 2) x (height + 2) with a blocked border. */
+  const uint8_t*
+   cells() const {
+   return m_rows.data() + PAD;
+  }
+
+  /** @brief The same bytes column-major. */
+  const uint8_t*
+   columns() const {
+   return m_columns.data() + PAD;
+  }
+
+  size_t
+   nodeCount() const {
+   return size_t(m_pitch) * m_columnPitch;
+  }
+
+  private:
+  std::vector<uint8_t> m_rows;
+  std::vector<uint8_t> m_columns;
+  uint32_t m_width = 0;
+  uint32_t m_height = 0;
+  uint32_t m_pitch = 2;
+  uint32_t m_columnPitch = 2;
+ };
+
+ /** @brief Octile distance: the cost of the shortest path between a and b on an empty grid. */
+ inline float
+  octileDistance(GridPoint a, GridPoint b) {
+  const int32_t dx = std::abs(a.x - b.x), dy = std::abs(a.y - b.y);
+  return float(std::max(dx, dy)) + (PATH_DIAGONAL_COST - 1.f) * float(std::min(dx, dy));
+ }
+
+ /**
+  * @brief Appends every tile of the path through waypoints, each pair joined by a straight or
+  * diagonal run (as JPS returns them), to cells (cleared first).
+  */
+ inline void
+  expandPath(const std::vector<GridPoint>& waypoints, std::vector<GridPoint>& cells) {
+  cells.clear();
+  if (waypoints.empty()) return;
+  cells.push_back(waypoints[0]);
+  for (size_t i = 1; i < waypoints.size(); ++i) {
+   GridPoint p = waypoints[i - 1];
+   const GridPoint to = waypoints[i];
+   const int32_t sx = (to.x > p.x) - (to.x < p.x), sy = (to.y > p.y) - (to.y < p.y);
+   while (p != to) {
+    p.x += p.x != to.x ? sx : 0;
+    p.y += p.y != to.y ? sy : 0;
+    cells.push_back(p);
+   }
+  }
+ }
+
+ /**
+  * @class PathFinder
+  * @brief Search state for one thread; reuse it for every query on that thread.
+  */
+ class
+  PathFinder {
+  public:
+  /**
+   * @brief Finds a shortest path from start to goal.
+   * @param path Receives the path from start to goal inclusive (jump points for JumpPoint,
+   * every tile for AStar), or is cleared when there is none.
+   * @return False when either end is blocked or the goal cannot be reached.
+   */
+  bool
+   find(const PathGrid& grid, GridPoint start, GridPoint goal, std::vector<GridPoint>& path,
+        PathAlgorithm algorithm = PathAlgorithm::JumpPoint) {
+   path.clear();
+   m_cost = 0.f;
+   m_expanded = 0;
+   if (!grid.walkable(start) || !grid.walkable(goal)) return false;
+   begin(grid, goal);
+   const uint32_t first = grid.node(start.x, start.y);
+   visit(first);
+   m_g[first] = 0;
+   push(first, heuristic(start));
+   const bool found = algorithm == PathAlgorithm::JumpPoint ? searchJumpPoint(grid) : searchAStar(grid);
+   EU_TRACE_COUNTER("path nodes expanded", m_expanded);
+   if (!found) return false;
+   m_cost = float(m_g[m_goal]) / float(STRAIGHT);
+   for (uint32_t n = m_goal; n != PATH_NONE; n = m_parent[n]) path.push_back(grid.point(n));
+   std::reverse(path.begin(), path.end());
+   return true;
+  }
+
+  /** @brief Cost of the last path found, 0 when none was. */
+  float
+   cost() const {
+   return m_cost;
+  }
+
+  /** @brief Nodes taken off the open list by the last query. */
+  size_t
+   expanded() const {
+   return m_expanded;
+  }
+
+  private:
+  /**
+   * Integer step costs, in the ratio 19601 / 13860 = sqrt(2) + 3e-9, so that equal costs
+   * compare equal and ties on f are real ties. Paths of up to ~200k steps fit in 32 bits.
+   */
+  static constexpr uint32_t STRAIGHT = 13860;
+  static constexpr uint32_t DIAGONAL = 19601;
+  static constexpr uint32_t CLOSED = 0xfffffffeu; ///< m_heapIndex of an expanded node
+  static constexpr uint32_t UNREACHED = 0xffffffffu;
+
+  /** Sizes the node arrays to grid and starts a new generation. */
+  void
+   begin(const PathGrid& grid, GridPoint goal) {
+   if (m_stamp.size() != grid.nodeCount()) {
+    m_stamp.assign(grid.nodeCount(), 0);
+    m_g.resize(grid.nodeCount());
+    m_parent.resize(grid.nodeCount());
+    m_heapIndex.resize(grid.nodeCount());
+    m_generation = 0;
+   }
+   if (++m_generation == 0) {
+    std::fill(m_stamp.begin(), m_stamp.end(), 0u);
+    m_generation = 1;
+   }
+   m_heapKey.clear();
+   m_heapNode.clear();
+   m_cells = grid.cells();
+   m_columns = grid.columns();
+   m_pitch = int32_t(grid.pitch());
+   m_columnPitch = int32_t(grid.columnPitch());
+   m_goal = grid.node(goal.x, goal.y);
+   m_goalColumn = grid.columnNode(goal.x, goal.y);
+   m_goalPoint = goal;
+  }
+
+  /** Octile distance from p to the goal in step units. */
+  uint32_t
+   heuristic(GridPoint p) const {
+   const uint32_t dx = uint32_t(std::abs(p.x - m_goalPoint.x)), dy = uint32_t(std::abs(p.y - m_goalPoint.y));
+   return STRAIGHT * std::max(dx, dy) + (DIAGONAL - STRAIGHT) * std::min(dx, dy);
+  }
+
+  void
+   visit(uint32_t n) {
+   if (m_stamp[n] == m_generation) return;
+   m_stamp[n] = m_generation;
+   m_g[n] = UNREACHED;
+   m_parent[n] = PATH_NONE;
+   m_heapIndex[n] = PATH_NONE;
+  }
+
+  bool
+   walk(uint32_t n) const {
+   return m_cells[n] != 0;
+  }
+
+  /** Heap key: f in the high half, ~g in the low half, so lower f and then higher g come first. */
+  static uint64_t
+   key(uint32_t f, uint32_t g) {
+   return (uint64_t(f) << 32) | uint32_t(~g);
+  }
+
+  void
+   place(size_t slot, uint64_t k, uint32_t n) {
+   m_heapKey[slot] = k;
+   m_heapNode[slot] = n;
+   m_heapIndex[n] = uint32_t(slot);
+  }
+
+  void
+   siftUp(size_t i, uint64_t k, uint32_t n) {
+   while (i > 0) {
+    const size_t parent = (i - 1) / 2;
+    if (m_heapKey[parent] <= k) break;
+    place(i, m_heapKey[parent], m_heapNode[parent]);
+    i = parent;
+   }
+   place(i, k, n);
+  }
+
+  void
+   siftDown(size_t i, uint64_t k, uint32_t n) {
+   const size_t size = m_heapKey.size();
+   for (;;) {
+    size_t child = 2 * i + 1;
+    if (child >= size) break;
+    if (child + 1 < size && m_heapKey[child + 1] < m_heapKey[child]) ++child;
+    if (k <= m_heapKey[child]) break;
+    place(i, m_heapKey[child], m_heapNode[child]);
+    i = child;
+   }
+   place(i, k, n);
+  }
+
+  void
+   push(uint32_t n, uint32_t f) {
+   m_heapKey.push_back(0);
+   m_heapNode.push_back(0);
+   siftUp(m_heapKey.size() - 1, key(f, m_g[n]), n);
+  }
+
+  uint32_t
+   pop() {
+   const uint32_t top = m_heapNode[0];
+   const uint64_t lastKey = m_heapKey.back();
+   const uint32_t lastNode = m_heapNode.back();
+   m_heapKey.pop_back();
+   m_heapNode.pop_back();
+   if (!m_heapKey.empty()) siftDown(0, lastKey, lastNode);
+   m_heapIndex[top] = CLOSED;
+   ++m_expanded;
+   return top;
+  }
+
+  /** Offers node n at tile p, reached from parent at cost g. */
+  void
+   relax(uint32_t n, GridPoint p, uint32_t parent, uint32_t g) {
+   visit(n);
+   if (m_heapIndex[n] == CLOSED || g >= m_g[n]) return;
+   m_g[n] = g;
+   m_parent[n] = parent;
+   const uint32_t f = g + heuristic(p);
+   if (m_heapIndex[n] == PATH_NONE) push(n, f);
+   else siftUp(m_heapIndex[n], key(f, g), n);
+  }
+
+  bool
+   searchAStar(const PathGrid& grid) {
+   const int32_t p = m_pitch;
+   while (!m_heapKey.empty()) {
+    const uint32_t n = pop();
+    if (n == m_goal) return true;
+    const GridPoint at = grid.point(n);
+    const uint32_t g = m_g[n];
+    const int32_t c = int32_t(n);
+    const bool east = walk(uint32_t(c + 1)), west = walk(uint32_t(c - 1));
+    const bool south = walk(uint32_t(c + p)), north = walk(uint32_t(c - p));
+    if (east) relax(uint32_t(c + 1), { at.x + 1, at.y }, n, g + STRAIGHT);
+    if (west) relax(uint32_t(c - 1), { at.x - 1, at.y }, n, g + STRAIGHT);
+    if (south) relax(uint32_t(c + p), { at.x, at.y + 1 }, n, g + STRAIGHT);
+    if (north) relax(uint32_t(c - p), { at.x, at.y - 1 }, n, g + STRAIGHT);
+    if (east && south && walk(uint32_t(c + 1 + p))) relax(uint32_t(c + 1 + p), { at.x + 1, at.y + 1 }, n, g + DIAGONAL);
+    if (west && south && walk(uint32_t(c - 1 + p))) relax(uint32_t(c - 1 + p), { at.x - 1, at.y + 1 }, n, g + DIAGONAL);
+    if (east && north && walk(uint32_t(c + 1 - p))) relax(uint32_t(c + 1 - p), { at.x + 1, at.y - 1 }, n, g + DIAGONAL);
+    if (west && north && walk(uint32_t(c - 1 - p))) relax(uint32_t(c - 1 - p), { at.x - 1, at.y - 1 }, n, g + DIAGONAL);
+   }
+   return false;
+  }
+
+  static uint64_t
+   load8(const uint8_t* p) {
+   uint64_t value;
+   std::memcpy(&value, p, sizeof(value));
+   return value;
+  }
+
+  /**
+   * Scans a run of one layout from n (entered from n - step, step = +-1) until a jump point,
+   * the goal or a wall, eight tiles per iteration; side is the layout's pitch. A tile is a
+   * jump point when one of its side neighbours is open but the tile behind that neighbour is
+   * not. Whole bytes compare as one little-endian word, the tile order of x86 and ARM.
+   */
+  static uint32_t
+   scanRun(const uint8_t* cells, int32_t n, int32_t step, int32_t side, uint32_t goal) {
+   constexpr uint64_t ONES = 0x0101010101010101ull;
+   for (;; n += 8 * step) {
+    const int32_t base = step > 0 ? n : n - 7;
+    const uint64_t blocked = load8(cells + base) ^ ONES;
+    const uint64_t forced = (load8(cells + base - side) & ~load8(cells + base - side - step)) |
+                            (load8(cells + base + side) & ~load8(cells + base + side - step));
+    uint64_t stop = blocked | forced;
+    const uint32_t goalByte = goal - uint32_t(base);
+    if (goalByte < 8) stop |= uint64_t(1) << (8 * goalByte);
+    if (!stop) continue;
+    const int bit = 63 - EngineMath::detail::countLeadingZeros(step > 0 ? stop & (0 - stop) : stop);
+    return (blocked >> bit) & 1 ? PATH_NONE : uint32_t(base + bit / 8);
+   }
+  }
+
+  /** Horizontal jump from n, entered by a step of dx. */
+  uint32_t
+   jumpRow(int32_t n, int32_t dx) const {
+   return scanRun(m_cells, n, dx, m_pitch, m_goal);
+  }
+
+  /** Vertical jump from column index c, entered by a step of dy; returns a column index. */
+  uint32_t
+   jumpColumn(int32_t c, int32_t dy) const {
+   return scanRun(m_columns, c, dy, m_columnPitch, m_goalColumn);
+  }
+
+  /** Scans diagonally from n (column index c, entered legally) until a jump point, the goal or a wall. */
+  uint32_t
+   jumpDiagonal(int32_t n, int32_t c, int32_t dx, int32_t dy) const {
+   const int32_t step = dx + dy * m_pitch, columnStep = dx * m_columnPitch + dy;
+   for (;; n += step, c += columnStep) {
+    if (!walk(uint32_t(n))) return PATH_NONE;
+    if (uint32_t(n) == m_goal) return uint32_t(n);
+    if (jumpRow(n + dx, dx) != PATH_NONE || jumpColumn(c + dy, dy) != PATH_NONE) return uint32_t(n);
+    if (!walk(uint32_t(n + dx)) || !walk(uint32_t(n + dy * m_pitch))) return PATH_NONE;
+   }
+  }
+
+  /** Jumps from n at tile at one step in direction (dx, dy) and relaxes the jump point found. */
+  void
+   jumpFrom(const PathGrid& grid, uint32_t n, GridPoint at, int32_t dx, int32_t dy) {
+   const int32_t c = int32_t(grid.columnNode(at.x, at.y));
+   uint32_t jump;
+   if (dx != 0 && dy != 0) {
+    jump = jumpDiagonal(int32_t(n) + dx + dy * m_pitch, c + dx * m_columnPitch + dy, dx, dy);
+   }
+   else if (dx != 0) {
+    jump = jumpRow(int32_t(n) + dx, dx);
+   }
+   else {
+    jump = jumpColumn(c + dy, dy);
+    if (jump != PATH_NONE) jump = (jump % uint32_t(m_columnPitch)) * uint32_t(m_pitch) + jump / uint32_t(m_columnPitch);
+   }
+   if (jump == PATH_NONE) return;
+   // Every jump is a straight or diagonal run, so its length is the larger coordinate delta.
+   const GridPoint to = grid.point(jump);
+   const uint32_t steps = uint32_t(std::max(std::abs(to.x - at.x), std::abs(to.y - at.y)));
+   relax(jump, to, n, m_g[n] + steps * (dx != 0 && dy != 0 ? DIAGONAL : STRAIGHT));
+  }
+
+  bool
+   searchJumpPoint(const PathGrid& grid) {
+   const int32_t p = m_pitch;
+   while (!m_heapKey.empty()) {
+    const uint32_t n = pop();
+    if (n == m_goal) return true;
+    const int32_t c = int32_t(n);
+    const GridPoint at = grid.point(n);
+    auto open = [&](int32_t dx, int32_t dy) { return walk(uint32_t(c + dx + dy * p)); };
+    if (m_parent[n] == PATH_NONE) {
+     for (int32_t dy = -1; dy <= 1; ++dy) {
+      for (int32_t dx = -1; dx <= 1; ++dx) {
+       if ((dx == 0 && dy == 0) || !open(dx, dy)) continue;
+       if (dx != 0 && dy != 0 && (!open(dx, 0) || !open(0, dy))) continue;
+       jumpFrom(grid, n, at, dx, dy);
+      }
+     }
+     continue;
+    }
+    const GridPoint from = grid.point(m_parent[n]);
+    const int32_t dx = (at.x > from.x) - (at.x < from.x), dy = (at.y > from.y) - (at.y < from.y);
+    if (dx != 0 && dy != 0) {
+     const bool horizontal = open(dx, 0), vertical = open(0, dy);
+     if (vertical) jumpFrom(grid, n, at, 0, dy);
+     if (horizontal) jumpFrom(grid, n, at, dx, 0);
+     if (horizontal && vertical && open(dx, dy)) jumpFrom(grid, n, at, dx, dy);
+    }
+    else {
+     // Straight arrival: ahead, both sides, and the diagonals ahead that are not corner cuts.
+     const int32_t sx = dy, sy = dx;
+     const bool ahead = open(dx, dy), left = open(sx, sy), right = open(-sx, -sy);
+     if (ahead) {
+      jumpFrom(grid, n, at, dx, dy);
+      if (left && open(dx + sx, dy + sy)) jumpFrom(grid, n, at, dx + sx, dy + sy);
+      if (right && open(dx - sx, dy - sy)) jumpFrom(grid, n, at, dx - sx, dy - sy);
+     }
+     if (left) jumpFrom(grid, n, at, sx, sy);
+     if (right) jumpFrom(grid, n, at, -sx, -sy);
+    }
+   }
+   return false;
+  }
+
+  std::vector<uint32_t> m_stamp;     ///< Generation a node was last touched in
+  std::vector<uint32_t> m_g;         ///< Cost from the start in STRAIGHT / DIAGONAL units
+  std::vector<uint32_t> m_parent;
+  std::vector<uint32_t> m_heapIndex; ///< Slot in the open heap, PATH_NONE or CLOSED
+  std::vector<uint64_t> m_heapKey;   ///< Open heap: key() of each slot...
+  std::vector<uint32_t> m_heapNode;  ///< ...and its node
+  const uint8_t* m_cells = nullptr;
+  const uint8_t* m_columns = nullptr;
+  int32_t m_pitch = 0;
+  int32_t m_columnPitch = 0;
+  uint32_t m_goal = 0;
+  uint32_t m_goalColumn = 0;
+  GridPoint m_goalPoint;
+  uint32_t m_generation = 0;
+  float m_cost = 0.f;
+  size_t m_expanded = 0;
+ };
+
+ /** @brief One query of a PathBatch. */
+ struct PathQuery {
+  GridPoint start;
+  GridPoint goal;
+ };
+
+ /** @brief Answer to one PathQuery; keep the array between batches to reuse the paths. */
+ struct PathResult {
+  std::vector<GridPoint> path; ///< Empty when no path was found
+  float cost = 0.f;
+  bool found = false;
+ };
+
+ /**
+  * @class PathBatch
+  * @brief Runs many queries at once, one PathFinder per participating thread.
+  *
+  * Threads take queries one at a time from a shared counter, so a few long searches do not
+  * hold up the rest. Results do not depend on the thread count.
+  */
+ class
+  PathBatch {
+  public:
+  explicit PathBatch(PathAlgorithm algorithm = PathAlgorithm::JumpPoint) : m_algorithm(algorithm) {}
+
+  /** @brief Answers queries[0..count) into results[0..count) on the workers of jobs. */
+  void
+   find(const PathGrid& grid, const PathQuery* queries, PathResult* results, size_t count, JobSystem& jobs) {
+   EU_TRACE_ZONE("PathBatch::find");
+   const size_t threads = std::max<size_t>(1, std::min(jobs.threadCount(), count));
+   reserve(threads);
+   std::atomic<size_t> next(0);
+   JobCounter counter;
+   auto work = [&](size_t t) { drain(grid, queries, results, count, m_finders[t], next); };
+   for (size_t t = 1; t < threads; ++t) jobs.run([&work, t]() { work(t); }, counter);
+   work(0);
+   jobs.wait(counter);
+  }
+
+  /** @brief Answers queries on up to threads threads (0 = hardware_concurrency(), 1 = caller only). */
+  void
+   find(const PathGrid& grid, const PathQuery* queries, PathResult* results, size_t count, size_t threads = 0) {
+   EU_TRACE_ZONE("PathBatch::find");
+   threads = detail::resolveThreads(threads, count);
+   reserve(threads);
+   std::atomic<size_t> next(0);
+   detail::parallelTasks(threads, threads, [&](size_t t) { drain(grid, queries, results, count, m_finders[t], next); });
+  }
+
+  private:
+  void
+   reserve(size_t threads) {
+   if (m_finders.size() < threads) m_finders.resize(threads);
+  }
+
+  void
+   drain(const PathGrid& grid, const PathQuery* queries, PathResult* results, size_t count, PathFinder& finder,
+         std::atomic<size_t>& next) const {
+   for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed)) {
+    PathResult& result = results[i];
+    result.found = finder.find(grid, queries[i].start, queries[i].goal, result.path, m_algorithm);
+    result.cost = finder.cost();
+   }
+  }
+
+  std::vector<PathFinder> m_finders;
+  PathAlgorithm m_algorithm;
+ };
+}
@@ -0,0 +1,389 @@
+/**
+ * @file Interest.h
+ * @brief Server-side interest management: which entities each client should be sent, kept
+ * up to date incrementally on a hashed uniform grid, with per-client send priorities.
+ *
+ * Entities and clients are filed under cubic cells of cellSize. An entity enters a client's
+ * relevant set when its cell is within radius cells of the client's (Chebyshev distance) and
+ * leaves once it is more than radius + hysteresis cells away, so an entity pacing along the
+ * edge does not flap in and out. update() only does work where something crossed a cell:
+ * entities that stayed in their cell are not looked at, a client that stayed in its cell
+ * only checks the entities that moved, and a client that changed cell re-reads the cells
+ * around it from the grid. The cost per tick is O(entities + clients x movers + the
+ * neighbourhoods of the clients that moved), not O(clients x entities), and clients are
+ * processed in parallel (threads: 0 = hardware_concurrency(), 1 = caller only) with the same
+ * results for any thread count.
+ *
+ * Each relevant set is a sorted id list; entered() and left() are the changes of the last
+ * update(), ascending. prioritize() scores every relevant entity by distance and speed,
+ * adds the score to a per-client accumulator and picks the highest budget accumulators to
+ * send this tick, resetting them: near and fast entities go out often, the rest still go out
+ * eventually.
+ *
+ *   interest.setClient(c, playerPosition);
+ *   interest.update(positions, velocities, n);
+ *   interest.prioritize(64);
+ *   for (uint32_t id : interest.selected(c)) ...   // write to the client's sf::Packet
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/Trace.h>
+#include <Geometry/SpatialHash2D.h>
+#include <Math/EngineMath.h>
+#include <Math/IntMath.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ namespace detail {
+  /** One cell of the interest grid. */
+  struct InterestCell {
+   int32_t x;
+   int32_t y;
+   int32_t z;
+
+   constexpr bool
+    operator==(const InterestCell& otro) const {
+    return x == otro.x && y == otro.y && z == otro.z;
+   }
+
+   constexpr bool
+    operator!=(const InterestCell& otro) const {
+    return !(*this == otro);
+   }
+  };
+
+  /** Chebyshev distance between two cells, in cells. */
+  inline int64_t
+   cellDistance(InterestCell a, InterestCell b) {
+   const int64_t dx = int64_t(a.x) - b.x, dy = int64_t(a.y) - b.y, dz = int64_t(a.z) - b.z;
+   const int64_t ax = dx < 0 ? -dx : dx, ay = dy < 0 ? -dy : dy, az = dz < 0 ? -dz : dz;
+   return ax > ay ? (ax > az ? ax : az) : (ay > az ? ay : az);
+  }
+
+  constexpr uint32_t
+   interestBucket(InterestCell cell, uint32_t mask) {
+   return ((static_cast<uint32_t>(cell.x) * 73856093u) ^ (static_cast<uint32_t>(cell.y) * 19349663u) ^
+           (static_cast<uint32_t>(cell.z) * 83492791u)) & mask;
+  }
+ }
+
+ /**
+  * @class InterestManager
+  * @brief Incremental per-client relevant sets and send priorities over an interest grid.
+  */
+ class
+  InterestManager {
+  public:
+  /**
+   * @param cellSize Edge of a grid cell; non-positive sizes are replaced by 1.
+   * @param radius Cells around a client whose entities enter its set.
+   * @param hysteresis Extra cells an entity may drift out before it leaves.
+   */
+  explicit InterestManager(float cellSize = 32.f, int radius = 2, int hysteresis = 1)
+   : m_cellSize(cellSize > 0.f ? cellSize : 1.f), m_radius(radius < 0 ? 0 : radius),
+     m_hysteresis(hysteresis < 0 ? 0 : hysteresis) {}
+
+  /// Weights of the priority score (1 + velocityWeight * speed) / (1 + distanceWeight * distance).
+  float distanceWeight = 0.05f;
+  float velocityWeight = 0.1f;
+
+  /** @brief Adds a client at position and returns its id; its set fills at the next update(). */
+  size_t
+   addClient(const CVector3& position = CVector3()) {
+   size_t id = 0;
+   while (id < m_clients.size() && m_clients[id].active) ++id;
+   if (id == m_clients.size()) m_clients.emplace_back();
+   m_clients[id] = Client();
+   m_clients[id].active = true;
+   m_clients[id].position = position;
+   return id;
+  }
+
+  /** @brief Frees a client id for reuse. */
+  void
+   removeClient(size_t client) {
+   if (client < m_clients.size()) m_clients[client] = Client();
+  }
+
+  /** @brief Moves a client's point of view; takes effect at the next update(). */
+  void
+   setClient(size_t client, const CVector3& position) {
+   m_clients[client].position = position;
+  }
+
+  /**
+   * @brief Files n entities, at positions with velocities (nullptr = at rest), under their
+   * cells and brings every client's set up to date. Entity ids are slots: ids that are new
+   * since the last call enter like movers, ids beyond n leave.
+   */
+  void
+   update(const CVector3* positions, const CVector3* velocities, size_t n, size_t threads = 0) {
+   EU_TRACE_ZONE("InterestManager::update");
+   const size_t old = m_cell.size();
+   m_position.assign(positions, positions + n);
+   if (velocities) m_velocity.assign(velocities, velocities + n);
+   else m_velocity.assign(n, CVector3());
+   m_cell.resize(n);
+
+   // Cells in parallel chunks, then the movers in id order.
+   const size_t chunks = (n + detail::GRID_CHUNK - 1) / detail::GRID_CHUNK;
+   std::vector<std::vector<uint32_t>> moved(chunks);
+   detail::forEachGridChunk(n, threads, [&](size_t c, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+     const detail::InterestCell cell = cellOf(m_position[i]);
+     if (i >= old || cell != m_cell[i]) {
+      m_cell[i] = cell;
+      moved[c].push_back(static_cast<uint32_t>(i));
+     }
+    }
+   });
+   m_movers.clear();
+   for (const auto& chunk : moved) m_movers.insert(m_movers.end(), chunk.begin(), chunk.end());
+   if (!m_movers.empty() || n != old) sortGrid();
+   EU_TRACE_COUNTER("interest movers", m_movers.size());
+
+   detail::parallelTasks(m_clients.size(), detail::resolveThreads(threads, m_clients.size()), [&](size_t c) {
+    Client& client = m_clients[c];
+    if (!client.active) return;
+    client.entered.clear();
+    client.left.clear();
+    const detail::InterestCell cell = cellOf(client.position);
+    if (!client.placed || cell != client.cell) {
+     client.cell = cell;
+     client.placed = true;
+     refresh(client);
+    }
+    else applyMovers(client);
+   });
+  }
+
+  /**
+   * @brief Scores every relevant entity of every client and picks up to budget of them per
+   * client into selected(), highest accumulated priority first.
+   */
+  void
+   prioritize(size_t budget, size_t threads = 0) {
+   EU_TRACE_ZONE("InterestManager::prioritize");
+   detail::parallelTasks(m_clients.size(), detail::resolveThreads(threads, m_clients.size()), [&](size_t c) {
+    Client& client = m_clients[c];
+    client.selected.clear();
+    if (!client.active) return;
+    const size_t count = client.relevant.size();
+    std::vector<std::pair<float, uint32_t>>& order = client.order;
+    order.resize(count);
+    for (size_t k = 0; k < count; ++k) {
+     const uint32_t id = client.relevant[k];
+     const float distance = (m_position[id] - client.position).length();
+     const float speed = m_velocity[id].length();
+     client.priority[k] += (1.f + velocityWeight * speed) / (1.f + distanceWeight * distance);
+     order[k] = { client.priority[k], static_cast<uint32_t>(k) };
+    }
+    const size_t take = budget < count ? budget : count;
+    // Highest first; ties go to the lower id so the choice does not depend on the sort.
+    auto higher = [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) {
+     return a.first > b.first || (a.first == b.first && a.second < b.second);
+    };
+    std::partial_sort(order.begin(), order.begin() + take, order.end(), higher);
+    for (size_t k = 0; k < take; ++k) {
+     client.selected.push_back(client.relevant[order[k].second]);
+     client.priority[order[k].second] = 0.f;
+    }
+   });
+  }
+
+  /** @brief Entities the client should know about, ascending. */
+  const std::vector<uint32_t>&
+   relevant(size_t client) const {
+   return m_clients[client].relevant;
+  }
+
+  /** @brief Entities that joined the client's set in the last update(), ascending. */
+  const std::vector<uint32_t>&
+   entered(size_t client) const {
+   return m_clients[client].entered;
+  }
+
+  /** @brief Entities that left the client's set in the last update(), ascending. */
+  const std::vector<uint32_t>&
+   left(size_t client) const {
+   return m_clients[client].left;
+  }
+
+  /** @brief Entities the last prioritize() picked for the client, highest priority first. */
+  const std::vector<uint32_t>&
+   selected(size_t client) const {
+   return m_clients[client].selected;
+  }
+
+  /** @brief Entities that changed cell in the last update(). */
+  size_t
+   moverCount() const {
+   return m_movers.size();
+  }
+
+  size_t
+   size() const {
+   return m_cell.size();
+  }
+
+  float
+   cellSize() const {
+   return m_cellSize;
+  }
+
+  private:
+  struct Client {
+   bool active = false;
+   bool placed = false;          ///< cell is valid
+   CVector3 position;
+   detail::InterestCell cell = { 0, 0, 0 };
+   std::vector<uint32_t> relevant;
+   std::vector<float> priority;  ///< Per relevant entity: accumulated score
+   std::vector<uint32_t> entered;
+   std::vector<uint32_t> left;
+   std::vector<uint32_t> selected;
+   std::vector<std::pair<float, uint32_t>> order;
+   std::vector<uint32_t> scratch;
+   std::vector<float> scratchPriority;
+   std::vector<std::pair<uint32_t, bool>> candidates;
+  };
+
+  detail::InterestCell
+   cellOf(const CVector3& p) const {
+   const float inverseCell = 1.f / m_cellSize;
+   return { detail::gridCoordinate(p.x, inverseCell), detail::gridCoordinate(p.y, inverseCell),
+            detail::gridCoordinate(p.z, inverseCell) };
+  }
+
+  /** Counting sort of the entity ids by cell bucket. */
+  void
+   sortGrid() {
+   const size_t n = m_cell.size();
+   const uint32_t buckets = EngineMath::nextPow2(static_cast<uint32_t>(n < 8 ? 16 : 2 * n));
+   m_mask = buckets - 1;
+   m_bucketStart.assign(size_t(buckets) + 1, 0);
+   for (size_t i = 0; i < n; ++i) ++m_bucketStart[detail::interestBucket(m_cell[i], m_mask) + 1];
+   for (size_t b = 0; b < buckets; ++b) m_bucketStart[b + 1] += m_bucketStart[b];
+   std::vector<uint32_t> next(m_bucketStart.begin(), m_bucketStart.end() - 1);
+   m_ids.resize(n);
+   for (size_t i = 0; i < n; ++i) m_ids[next[detail::interestBucket(m_cell[i], m_mask)]++] = static_cast<uint32_t>(i);
+  }
+
+  /** Rebuilds the set of a client that changed cell from the grid cells within its reach. */
+  void
+   refresh(Client& client) const {
+   const int64_t enter = m_radius, keep = int64_t(m_radius) + m_hysteresis;
+   std::vector<std::pair<uint32_t, bool>>& candidates = client.candidates; // (id, within radius)
+   candidates.clear();
+   auto consider = [&](uint32_t id) {
+    const int64_t d = detail::cellDistance(m_cell[id], client.cell);
+    if (d <= keep) candidates.emplace_back(id, d <= enter);
+   };
+   const uint64_t span = uint64_t(2 * keep + 1);
+   if (span * span * span > m_ids.size()) {
+    for (size_t i = 0; i < m_cell.size(); ++i) consider(static_cast<uint32_t>(i));
+   }
+   else {
+    const detail::InterestCell c = client.cell;
+    for (int64_t z = int64_t(c.z) - keep; z <= int64_t(c.z) + keep; ++z)
+     for (int64_t y = int64_t(c.y) - keep; y <= int64_t(c.y) + keep; ++y)
+      for (int64_t x = int64_t(c.x) - keep; x <= int64_t(c.x) + keep; ++x) {
+       const detail::InterestCell cell = { static_cast<int32_t>(x), static_cast<int32_t>(y), static_cast<int32_t>(z) };
+       const uint32_t b = detail::interestBucket(cell, m_mask);
+       for (uint32_t s = m_bucketStart[b]; s < m_bucketStart[b + 1]; ++s) {
+        if (m_cell[m_ids[s]] == cell) candidates.emplace_back(m_ids[s], detail::cellDistance(cell, c) <= enter);
+       }
+      }
+    std::sort(candidates.begin(), candidates.end());
+   }
+
+   // New set: the candidates within radius, plus those within the hysteresis band already in it.
+   client.scratch.clear();
+   client.scratchPriority.clear();
+   size_t k = 0;
+   for (const auto& candidate : candidates) {
+    while (k < client.relevant.size() && client.relevant[k] < candidate.first) client.left.push_back(client.relevant[k++]);
+    const bool had = k < client.relevant.size() && client.relevant[k] == candidate.first;
+    if (had || candidate.second) {
+     client.scratch.push_back(candidate.first);
+     client.scratchPriority.push_back(had ? client.priority[k] : 0.f);
+     if (!had) client.entered.push_back(candidate.first);
+    }
+    if (had) ++k;
+   }
+   while (k < client.relevant.size()) client.left.push_back(client.relevant[k++]);
+   client.relevant.swap(client.scratch);
+   client.priority.swap(client.scratchPriority);
+  }
+
+  /** Updates the set of a client that stayed in its cell from the entities that moved. */
+  void
+   applyMovers(Client& client) const {
+   const int64_t enter = m_radius, keep = int64_t(m_radius) + m_hysteresis;
+   const size_t n = m_cell.size();
+   while (!client.relevant.empty() && client.relevant.back() >= n) {
+    client.priority.pop_back();
+    client.left.push_back(client.relevant.back());
+    client.relevant.pop_back();
+   }
+   std::reverse(client.left.begin(), client.left.end());
+   if (m_movers.empty()) return;
+
+   // Movers and the set are both ascending, so one merge finds every membership.
+   const size_t firstLeft = client.left.size();
+   size_t k = 0;
+   for (uint32_t id : m_movers) {
+    while (k < client.relevant.size() && client.relevant[k] < id) ++k;
+    const bool had = k < client.relevant.size() && client.relevant[k] == id;
+    const int64_t d = detail::cellDistance(m_cell[id], client.cell);
+    if (had && d > keep) client.left.push_back(id);
+    else if (!had && d <= enter) client.entered.push_back(id);
+   }
+   if (client.entered.empty() && client.left.size() == firstLeft) return;
+
+   client.scratch.clear();
+   client.scratchPriority.clear();
+   size_t e = 0, l = firstLeft;
+   for (size_t r = 0; r < client.relevant.size(); ++r) {
+    const uint32_t id = client.relevant[r];
+    while (e < client.entered.size() && client.entered[e] < id) {
+     client.scratch.push_back(client.entered[e++]);
+     client.scratchPriority.push_back(0.f);
+    }
+    if (l < client.left.size() && client.left[l] == id) {
+     ++l;
+     continue;
+    }
+    client.scratch.push_back(id);
+    client.scratchPriority.push_back(client.priority[r]);
+   }
+   for (; e < client.entered.size(); ++e) {
+    client.scratch.push_back(client.entered[e]);
+    client.scratchPriority.push_back(0.f);
+   }
+   client.relevant.swap(client.scratch);
+   client.priority.swap(client.scratchPriority);
+   // The removed slots, all >= n, were listed first; put them after the movers.
+   std::rotate(client.left.begin(), client.left.begin() + firstLeft, client.left.end());
+  }
+
+  float m_cellSize;
+  int m_radius;
+  int m_hysteresis;
+  uint32_t m_mask = 0;
+  std::vector<CVector3> m_position;         ///< Per entity, as of the last update()
+  std::vector<CVector3> m_velocity;         ///< Per entity
+  std::vector<detail::InterestCell> m_cell; ///< Per entity
+  std::vector<uint32_t> m_movers;           ///< Entities that changed cell, ascending
+  std::vector<uint32_t> m_bucketStart{ 0 }; ///< First slot of each bucket, then the slot count
+  std::vector<uint32_t> m_ids;              ///< Entity ids by bucket
+  std::vector<Client> m_clients;
+ };
+}
@@ -0,0 +1,496 @@
+/**
+ * @file Replication.h
+ * @brief Snapshot delta compression of replicated transforms: each client is sent only the
+ * positions and rotations that changed since the last snapshot it acknowledged.
+ *
+ * ReplicationServer quantizes the transforms of n entity slots once per snapshot, positions
+ * to a Bounds3 box at positionBits per axis and rotations in a smallest-three
+ * QuaternionFormat, and keeps the decoded values. For every client it remembers a baseline,
+ * the decoded state of the last snapshot the client acknowledged; writeSnapshot() compares
+ * the snapshot against it with approxEqualMask() and writes, after a header, a change mask
+ * of one bit per 64-entity word plus the nonzero mask words, then the codes of the changed
+ * entries. Since both ends only ever see decoded values, a baseline holds the same codes on
+ * both sides and errors never accumulate. The decoded values are the same bits when both ends
+ * are built alike and the policy's scalar and lane square roots agree, as with Exact (see
+ * QuaternionPacked.h); otherwise rotations can differ in the last bits.
+ *
+ * ReplicationClient keeps the codes of the last REPLICATION_HISTORY snapshots it read;
+ * read() rebuilds a snapshot from the baseline it names and the caller acknowledges the
+ * returned sequence over any channel. Snapshots can arrive out of order or not at all: a
+ * packet whose baseline the client no longer has is dropped, as is one REPLICATION_HISTORY
+ * snapshots late, and the server falls back to a full snapshot once a baseline is
+ * REPLICATION_HISTORY snapshots old.
+ *
+ *   server.beginSnapshot(positions, rotations, n);
+ *   for (client : clients) { sf::Packet p; server.writeSnapshot(client.id, p); send(p); }
+ *   // on the client
+ *   if (replica.read(p, sequence)) sendAck(sequence);
+ *   // back on the server
+ *   server.acknowledge(client.id, sequence);
+ *
+ * Entity slots are fixed: spawning and despawning, e.g. as a visibility bit per slot, is up
+ * to the game. Needs sfml-network at link time.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <SFML/Network/Packet.hpp>
+#include <Core/Trace.h>
+#include <Math/BatchCompare.h>
+#include <Math/IntMath.h>
+#include <Math/Precision.h>
+#include <Rotations/Quaternion.h>
+#include <Rotations/QuaternionPacked.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorNetwork.h>
+#include <Vectors/VectorReduce.h>
+
+namespace EU {
+ /// Snapshots each end remembers; a baseline older than this is replaced by a full snapshot.
+ constexpr uint32_t REPLICATION_HISTORY = 32;
+ /// Baseline sequence of a full snapshot.
+ constexpr uint32_t REPLICATION_NONE = 0xffffffffu;
+ /// Most entity slots a snapshot may carry.
+ constexpr uint32_t MAX_REPLICATED_ENTITIES = 1u << 24;
+
+ /** @brief Quantization and change thresholds; both ends must use the same one. */
+ struct ReplicationFormat {
+  Bounds3 bounds;                                           ///< Box every position is clamped to
+  int positionBits = 18;                                    ///< Bits per axis, in [1, MAX_QUANTIZE_BITS]
+  QuaternionFormat rotationFormat = QuaternionFormat::Bits32;
+  float positionEpsilon = 0.f;                              ///< approxEqualMask() tolerance of positions
+  float rotationEpsilon = 0.f;                              ///< approxEqualMask() tolerance of rotation components
+ };
+
+ namespace detail {
+  /** True when sequence a is newer than b, modulo 2^32. */
+  inline bool
+   sequenceNewer(uint32_t a, uint32_t b) {
+   return static_cast<int32_t>(a - b) > 0;
+  }
+
+  /** Writes the set bits of mask[maskWords(n)]: one bit per word, then the nonzero words. */
+  inline void
+   writeChangeMask(BitWriter& writer, const uint64_t* mask, size_t n) {
+   const size_t words = maskWords(n);
+   for (size_t w = 0; w < words; ++w) writer.writeBool(mask[w] != 0);
+   for (size_t w = 0; w < words; ++w) {
+    if (mask[w] == 0) continue;
+    writer.write(static_cast<uint32_t>(mask[w]), 32);
+    writer.write(static_cast<uint32_t>(mask[w] >> 32), 32);
+   }
+  }
+
+  /** Reads a writeChangeMask() mask; bits past n are cleared. */
+  inline void
+   readChangeMask(BitReader& reader, std::vector<uint64_t>& mask, size_t n) {
+   const size_t words = maskWords(n);
+   mask.assign(words, 0);
+   for (size_t w = 0; w < words; ++w) mask[w] = reader.readBool() ? 1u : 0u;
+   for (size_t w = 0; w < words; ++w) {
+    if (mask[w] == 0) continue;
+    mask[w] = reader.read(32);
+    mask[w] |= static_cast<uint64_t>(reader.read(32)) << 32;
+   }
+   if (words && (n & 63)) mask[words - 1] &= (uint64_t(1) << (n & 63)) - 1;
+  }
+
+  /** Turns an approxEqualMask() of n entries into the mask of the entries that differ. */
+  inline size_t
+   invertMask(uint64_t* mask, size_t n) {
+   const size_t words = maskWords(n);
+   size_t count = 0;
+   for (size_t w = 0; w < words; ++w) {
+    mask[w] = ~mask[w];
+    if (w + 1 == words && (n & 63)) mask[w] &= (uint64_t(1) << (n & 63)) - 1;
+    count += static_cast<size_t>(EngineMath::detail::popCount(mask[w]));
+   }
+   return count;
+  }
+
+  inline void
+   writeRotationCode(BitWriter& writer, uint64_t code, int bits) {
+   writer.write(static_cast<uint32_t>(code), bits < 32 ? bits : 32);
+   if (bits > 32) writer.write(static_cast<uint32_t>(code >> 32), bits - 32);
+  }
+
+  inline uint64_t
+   readRotationCode(BitReader& reader, int bits) {
+   uint64_t code = reader.read(bits < 32 ? bits : 32);
+   if (bits > 32) code |= static_cast<uint64_t>(reader.read(bits - 32)) << 32;
+   return code;
+  }
+
+  /** Calls fn(i) for every set bit of mask[maskWords(n)], in increasing order. */
+  template<typename Fn>
+  inline void
+   forEachSetBit(const uint64_t* mask, size_t n, Fn fn) {
+   for (size_t w = 0; w < maskWords(n); ++w) {
+    for (uint64_t bits = mask[w]; bits; bits &= bits - 1) {
+     fn((w << 6) + static_cast<size_t>(63 - EngineMath::detail::countLeadingZeros(bits & (~bits + 1))));
+    }
+   }
+  }
+ }
+
+ /**
+  * @class ReplicationServer
+  * @brief Per-client baselines and delta snapshots of n replicated transforms.
+  */
+ class
+  ReplicationServer {
+  public:
+  explicit ReplicationServer(const ReplicationFormat& format = ReplicationFormat())
+   : m_format(format), m_sequence(0) {
+   m_format.positionBits = detail::quantizeBits(m_format.positionBits);
+  }
+
+  const ReplicationFormat&
+   format() const {
+   return m_format;
+  }
+
+  /** @brief Registers a client with no baseline, so it is first sent a full snapshot. Returns its id. */
+  size_t
+   addClient() {
+   for (size_t c = 0; c < m_clients.size(); ++c) {
+    if (!m_clients[c].active) {
+     m_clients[c] = Client();
+     m_clients[c].active = true;
+     return c;
+    }
+   }
+   m_clients.emplace_back();
+   m_clients.back().active = true;
+   return m_clients.size() - 1;
+  }
+
+  /** @brief Frees a client id for reuse by addClient(). */
+  void
+   removeClient(size_t client) {
+   if (client < m_clients.size()) m_clients[client] = Client();
+  }
+
+  /** @brief Forgets a client's baseline, e.g. after it reconnected; its next snapshot is full. */
+  void
+   resetClient(size_t client) {
+   Client& c = m_clients[client];
+   c.baseline = REPLICATION_NONE;
+   for (Record& r : c.records) r.sequence = REPLICATION_NONE;
+  }
+
+  /**
+   * @brief Starts snapshot sequence() + 1 from the transforms of n entity slots, which are
+   * quantized and decoded here once for all clients. Returns the new sequence.
+   */
+  template<typename Policy = EU::Precision::Default>
+  uint32_t
+   beginSnapshot(const CVector3* positions, const Quaternion* rotations, size_t n) {
+   EU_TRACE_ZONE("ReplicationServer::beginSnapshot");
+   if (n > MAX_REPLICATED_ENTITIES) n = MAX_REPLICATED_ENTITIES;
+   const Bounds3& box = m_format.bounds;
+   const int bits = m_format.positionBits;
+   m_positionCodes.resize(3 * n);
+   m_positions.resize(n);
+   for (size_t i = 0; i < n; ++i) {
+    uint32_t* q = &m_positionCodes[3 * i];
+    q[0] = detail::quantizeRange(positions[i].x, box.minimum.x, box.maximum.x, bits);
+    q[1] = detail::quantizeRange(positions[i].y, box.minimum.y, box.maximum.y, bits);
+    q[2] = detail::quantizeRange(positions[i].z, box.minimum.z, box.maximum.z, bits);
+    m_positions[i] = CVector3(detail::dequantizeRange(q[0], box.minimum.x, box.maximum.x, bits),
+                              detail::dequantizeRange(q[1], box.minimum.y, box.maximum.y, bits),
+                              detail::dequantizeRange(q[2], box.minimum.z, box.maximum.z, bits));
+   }
+   m_rotationCodes.resize(n);
+   m_rotations.resize(n);
+   packQuaternionArray(rotations, m_rotationCodes.data(), n, m_format.rotationFormat);
+   unpackQuaternionArray<Policy>(m_rotationCodes.data(), m_rotations.data(), n, m_format.rotationFormat);
+   if (++m_sequence == REPLICATION_NONE) m_sequence = 0;
+   return m_sequence;
+  }
+
+  /**
+   * @brief Appends the current snapshot for a client, as a delta against its baseline.
+   * Returns the number of changed positions plus changed rotations written.
+   */
+  size_t
+   writeSnapshot(size_t client, sf::Packet& packet) {
+   EU_TRACE_ZONE("ReplicationServer::writeSnapshot");
+   Client& c = m_clients[client];
+   const size_t n = m_positions.size();
+   uint32_t baseline = c.baseline;
+   if (baseline != REPLICATION_NONE && m_sequence - baseline >= REPLICATION_HISTORY) baseline = REPLICATION_NONE;
+   if (baseline == REPLICATION_NONE) {
+    c.positions.clear();
+    c.rotations.clear();
+   }
+   // Slots the baseline does not cover compare unequal to everything.
+   c.positions.resize(n, unknownPosition());
+   c.rotations.resize(n, unknownRotation());
+
+   m_positionMask.assign(maskWords(n), 0);
+   m_rotationMask.assign(maskWords(n), 0);
+   approxEqualMask(m_positions.data(), c.positions.data(), m_positionMask.data(), n, m_format.positionEpsilon);
+   approxEqualMask(m_rotations.data(), c.rotations.data(), m_rotationMask.data(), n, m_format.rotationEpsilon);
+   const size_t changed = detail::invertMask(m_positionMask.data(), n) + detail::invertMask(m_rotationMask.data(), n);
+
+   packet << static_cast<sf::Uint32>(m_sequence) << static_cast<sf::Uint32>(baseline) << static_cast<sf::Uint32>(n);
+   Record& record = c.records[m_sequence % REPLICATION_HISTORY];
+   record.sequence = m_sequence;
+   record.baseline = baseline;
+   record.size = n;
+   record.positionIndices.clear();
+   record.positions.clear();
+   record.rotationIndices.clear();
+   record.rotations.clear();
+
+   BitWriter writer(packet);
+   detail::writeChangeMask(writer, m_positionMask.data(), n);
+   detail::writeChangeMask(writer, m_rotationMask.data(), n);
+   const int bits = m_format.positionBits;
+   detail::forEachSetBit(m_positionMask.data(), n, [&](size_t i) {
+    for (size_t a = 0; a < 3; ++a) writer.write(m_positionCodes[3 * i + a], bits);
+    record.positionIndices.push_back(static_cast<uint32_t>(i));
+    record.positions.push_back(m_positions[i]);
+   });
+   const int rotationBits = quaternionCodeBits(m_format.rotationFormat);
+   detail::forEachSetBit(m_rotationMask.data(), n, [&](size_t i) {
+    detail::writeRotationCode(writer, m_rotationCodes[i], rotationBits);
+    record.rotationIndices.push_back(static_cast<uint32_t>(i));
+    record.rotations.push_back(m_rotations[i]);
+   });
+   writer.flush();
+   EU_TRACE_COUNTER("replicated changes", static_cast<double>(changed));
+   return changed;
+  }
+
+  /**
+   * @brief Makes snapshot sequence the client's baseline. An acknowledgement only counts if
+   * the snapshot was a full one or a delta against the current baseline; acks of snapshots
+   * built on an older baseline, or REPLICATION_HISTORY snapshots old, are ignored and the
+   * baseline moves on with a later ack.
+   */
+  void
+   acknowledge(size_t client, uint32_t sequence) {
+   if (client >= m_clients.size() || !m_clients[client].active) return;
+   Client& c = m_clients[client];
+   Record& r = c.records[sequence % REPLICATION_HISTORY];
+   if (r.sequence != sequence || sequence == REPLICATION_NONE) return;
+   if (c.baseline != REPLICATION_NONE && !detail::sequenceNewer(sequence, c.baseline)) return;
+   if (r.baseline != REPLICATION_NONE && r.baseline != c.baseline) return;
+   if (r.baseline == REPLICATION_NONE) {
+    c.positions.clear();
+    c.rotations.clear();
+   }
+   c.positions.resize(r.size, unknownPosition());
+   c.rotations.resize(r.size, unknownRotation());
+   for (size_t k = 0; k < r.positionIndices.size(); ++k) c.positions[r.positionIndices[k]] = r.positions[k];
+   for (size_t k = 0; k < r.rotationIndices.size(); ++k) c.rotations[r.rotationIndices[k]] = r.rotations[k];
+   c.baseline = sequence;
+   r.sequence = REPLICATION_NONE;
+  }
+
+  /** @brief Sequence of the current snapshot; 0 before the first beginSnapshot(). */
+  uint32_t
+   sequence() const {
+   return m_sequence;
+  }
+
+  /** @brief Last snapshot the client acknowledged, or REPLICATION_NONE. */
+  uint32_t
+   baseline(size_t client) const {
+   return m_clients[client].baseline;
+  }
+
+  /** @brief Entity slots of the current snapshot. */
+  size_t
+   size() const {
+   return m_positions.size();
+  }
+
+  private:
+  /** A sent snapshot: what the client's baseline becomes once it is acknowledged. */
+  struct Record {
+   uint32_t sequence = REPLICATION_NONE;
+   uint32_t baseline = REPLICATION_NONE;
+   size_t size = 0;
+   std::vector<uint32_t> positionIndices;
+   std::vector<CVector3> positions;
+   std::vector<uint32_t> rotationIndices;
+   std::vector<Quaternion> rotations;
+  };
+
+  struct Client {
+   bool active = false;
+   uint32_t baseline = REPLICATION_NONE;
+   std::vector<CVector3> positions; ///< Decoded baseline
+   std::vector<Quaternion> rotations;
+   Record records[REPLICATION_HISTORY];
+  };
+
+  static CVector3
+   unknownPosition() {
+   const float nan = std::numeric_limits<float>::quiet_NaN();
+   return CVector3(nan, nan, nan);
+  }
+
+  static Quaternion
+   unknownRotation() {
+   const float nan = std::numeric_limits<float>::quiet_NaN();
+   return Quaternion(nan, nan, nan, nan);
+  }
+
+  ReplicationFormat m_format;
+  uint32_t m_sequence;
+  std::vector<uint32_t> m_positionCodes; ///< Current snapshot, three codes per slot
+  std::vector<uint64_t> m_rotationCodes;
+  std::vector<CVector3> m_positions;     ///< Current snapshot, decoded
+  std::vector<Quaternion> m_rotations;
+  std::vector<uint64_t> m_positionMask;
+  std::vector<uint64_t> m_rotationMask;
+  std::vector<Client> m_clients;
+ };
+
+ /**
+  * @class ReplicationClient
+  * @brief Rebuilds the transforms of ReplicationServer snapshots from their deltas.
+  */
+ class
+  ReplicationClient {
+  public:
+  explicit ReplicationClient(const ReplicationFormat& format = ReplicationFormat())
+   : m_format(format), m_latest(REPLICATION_NONE) {
+   m_format.positionBits = detail::quantizeBits(m_format.positionBits);
+  }
+
+  /**
+   * @brief Reads one snapshot. On success sequence is set to the snapshot to acknowledge
+   * and, if it is the newest read so far, positions() and rotations() show it. Returns false
+   * for a malformed packet, one whose baseline is no longer at hand, or one REPLICATION_HISTORY
+   * or more snapshots older than the newest read, whose slot a newer snapshot holds.
+   */
+  template<typename Policy = EU::Precision::Default>
+  bool
+   read(sf::Packet& packet, uint32_t& sequence) {
+   EU_TRACE_ZONE("ReplicationClient::read");
+   sf::Uint32 seq = 0, baseline = 0, count = 0;
+   if (!(packet >> seq >> baseline >> count)) return false;
+   if (seq == REPLICATION_NONE || seq == baseline || count > MAX_REPLICATED_ENTITIES) return false;
+   const State* base = nullptr;
+   if (baseline != REPLICATION_NONE) {
+    base = &m_states[baseline % REPLICATION_HISTORY];
+    if (base->sequence != baseline || seq - baseline >= REPLICATION_HISTORY) return false;
+   }
+
+   // A snapshot that late would overwrite the newer one in its slot, which may be a baseline.
+   if (m_latest != REPLICATION_NONE && !detail::sequenceNewer(seq, m_latest) && m_latest - seq >= REPLICATION_HISTORY) return false;
+   State& state = m_states[seq % REPLICATION_HISTORY];
+   if (state.sequence != REPLICATION_NONE && detail::sequenceNewer(state.sequence, seq)) return false;
+   const size_t n = count;
+   if (base) {
+    state.positionCodes.assign(base->positionCodes.begin(), base->positionCodes.end());
+    state.rotationCodes.assign(base->rotationCodes.begin(), base->rotationCodes.end());
+   }
+   else {
+    state.positionCodes.clear();
+    state.rotationCodes.clear();
+   }
+   state.positionCodes.resize(3 * n, 0);
+   state.rotationCodes.resize(n, 0);
+
+   BitReader reader(packet);
+   detail::readChangeMask(reader, m_positionMask, n);
+   detail::readChangeMask(reader, m_rotationMask, n);
+   const int bits = m_format.positionBits;
+   detail::forEachSetBit(m_positionMask.data(), n, [&](size_t i) {
+    for (size_t a = 0; a < 3; ++a) state.positionCodes[3 * i + a] = reader.read(bits);
+   });
+   const int rotationBits = quaternionCodeBits(m_format.rotationFormat);
+   detail::forEachSetBit(m_rotationMask.data(), n, [&](size_t i) {
+    state.rotationCodes[i] = detail::readRotationCode(reader, rotationBits);
+   });
+   if (!reader.valid()) {
+    state.sequence = REPLICATION_NONE;
+    return false;
+   }
+   state.sequence = seq;
+   if (m_latest == REPLICATION_NONE || detail::sequenceNewer(seq, m_latest)) show<Policy>(state);
+   sequence = seq;
+   return true;
+  }
+
+  /** @brief Newest snapshot read, or REPLICATION_NONE. */
+  uint32_t
+   sequence() const {
+   return m_latest;
+  }
+
+  size_t
+   size() const {
+   return m_positions.size();
+  }
+
+  const CVector3*
+   positions() const {
+   return m_positions.data();
+  }
+
+  const Quaternion*
+   rotations() const {
+   return m_rotations.data();
+  }
+
+  private:
+  struct State {
+   uint32_t sequence = REPLICATION_NONE;
+   std::vector<uint32_t> positionCodes;
+   std::vector<uint64_t> rotationCodes;
+  };
+
+  /** Decodes the slots of state whose codes differ from the ones shown. */
+  template<typename Policy>
+  void
+   show(const State& state) {
+   const size_t n = state.rotationCodes.size();
+   const size_t old = m_positions.size();
+   m_shownPositionCodes.resize(3 * n);
+   m_shownRotationCodes.resize(n);
+   m_positions.resize(n);
+   m_rotations.resize(n);
+   const Bounds3& box = m_format.bounds;
+   const int bits = m_format.positionBits;
+   for (size_t i = 0; i < n; ++i) {
+    const uint32_t* q = &state.positionCodes[3 * i];
+    uint32_t* shown = &m_shownPositionCodes[3 * i];
+    if (i >= old || q[0] != shown[0] || q[1] != shown[1] || q[2] != shown[2]) {
+     shown[0] = q[0];
+     shown[1] = q[1];
+     shown[2] = q[2];
+     m_positions[i] = CVector3(detail::dequantizeRange(q[0], box.minimum.x, box.maximum.x, bits),
+                               detail::dequantizeRange(q[1], box.minimum.y, box.maximum.y, bits),
+                               detail::dequantizeRange(q[2], box.minimum.z, box.maximum.z, bits));
+    }
+    if (i >= old || state.rotationCodes[i] != m_shownRotationCodes[i]) {
+     m_shownRotationCodes[i] = state.rotationCodes[i];
+     m_rotations[i] = unpackQuaternion<Policy>(state.rotationCodes[i], m_format.rotationFormat);
+    }
+   }
+   m_latest = state.sequence;
+  }
+
+  ReplicationFormat m_format;
+  uint32_t m_latest;
+  State m_states[REPLICATION_HISTORY];
+  std::vector<uint32_t> m_shownPositionCodes;
+  std::vector<uint64_t> m_shownRotationCodes;
+  std::vector<CVector3> m_positions;
+  std::vector<Quaternion> m_rotations;
+  std::vector<uint64_t> m_positionMask;
+  std::vector<uint64_t> m_rotationMask;
+ };
+}
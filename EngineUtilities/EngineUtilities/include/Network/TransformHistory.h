@@ -0,0 +1,292 @@
+/**
+ * @file TransformHistory.h
+ * @brief Server-side history of quantized entity transforms for lag compensation: rewind
+ * positions and rotations to the tick a client was seeing when it fired.
+ *
+ * TransformHistory keeps the last capacity ticks of n entity slots in one ring. A tick is
+ * stored as two SoA arrays across the slots: positions quantized to a Bounds3 box at
+ * positionBits per axis and packed into one uint64_t, and rotations as smallest-three codes
+ * of QuaternionPacked.h, so a slot costs 16 bytes per tick instead of a 28-byte copy of a
+ * CVector3 and a Quaternion, and the whole history is allocated once.
+ *
+ * Ticks must be recorded in increasing order but may skip. A lookup of tick t finds the
+ * newest stored tick at or before t, directly when the ticks in between were all recorded
+ * and by bisection otherwise, and blends it with the next one: positions are lerped and
+ * rotations go through Quaternion::slerpFast(). Times past the newest tick clamp to it;
+ * times before the oldest fail.
+ *
+ *   history.record(tick, positions, rotations, n);
+ *   // hit validation for a shot fired at the client's interpolated view time
+ *   if (history.rewind(viewTick, viewFraction, rewound.data(), rewoundRotations.data())) {
+ *    transformColliders(rewound, rewoundRotations); // e.g. fill the vertices of a world BVH
+ *    world.refit(vertices.data());                  // BVH.h: no rebuild needed
+ *    hit = world.closestHit(ray, range, result);
+ *   }
+ *
+ * rewind() decodes and blends whole ticks through the packed and packet array paths of
+ * QuaternionPacked.h and QuaternionPacket.h; sample() rewinds a single slot, for the common
+ * case of testing one target, and agrees with rewind() exactly under Precision::Exact (the
+ * lane and scalar square roots of other policies may differ in the last bits). Lookups only
+ * ever see decoded values, so rewinding twice to the same time gives the same transforms.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Trace.h>
+#include <Math/Precision.h>
+#include <Rotations/Quaternion.h>
+#include <Rotations/QuaternionPacked.h>
+#include <Rotations/QuaternionPacket.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorReduce.h>
+
+namespace EU {
+ /// Widest position field: three of them share one uint64_t.
+ constexpr int MAX_HISTORY_POSITION_BITS = 21;
+
+ /** @brief Quantization of a TransformHistory. */
+ struct TransformHistoryFormat {
+  Bounds3 bounds;                                           ///< Box every position is clamped to
+  int positionBits = 20;                                    ///< Bits per axis, in [1, MAX_HISTORY_POSITION_BITS]
+  QuaternionFormat rotationFormat = QuaternionFormat::Bits32;
+ };
+
+ /**
+  * @class TransformHistory
+  * @brief Fixed-capacity ring of quantized transforms of n entity slots, one frame per tick.
+  */
+ class
+  TransformHistory {
+  public:
+  /**
+   * @brief History of capacity ticks (at least 2) of slots entity slots, allocated here.
+   */
+  TransformHistory(size_t slots, size_t capacity, const TransformHistoryFormat& format = TransformHistoryFormat())
+   : m_format(format), m_slots(slots), m_capacity(capacity < 2 ? 2 : capacity), m_head(0), m_count(0) {
+   int& bits = m_format.positionBits;
+   bits = bits < 1 ? 1 : (bits > MAX_HISTORY_POSITION_BITS ? MAX_HISTORY_POSITION_BITS : bits);
+   const Bounds3& box = m_format.bounds;
+   const float steps = static_cast<float>((1u << bits) - 1u);
+   const float extent[3] = { box.maximum.x - box.minimum.x, box.maximum.y - box.minimum.y, box.maximum.z - box.minimum.z };
+   for (int a = 0; a < 3; ++a) {
+    m_scale[a] = extent[a] > 0.f ? steps / extent[a] : 0.f;
+    m_step[a] = extent[a] > 0.f ? extent[a] / steps : 0.f;
+   }
+   m_ticks.resize(m_capacity, 0);
+   m_positions.resize(m_capacity * m_slots, 0);
+   m_rotations.resize(m_capacity * m_slots, 0);
+  }
+
+  const TransformHistoryFormat&
+   format() const {
+   return m_format;
+  }
+
+  /**
+   * @brief Stores the transforms of the first n slots at tick, overwriting the oldest tick
+   * once the ring is full; slots past n keep the values of the previous tick (or identity).
+   * Returns false, storing nothing, unless tick is newer than newestTick().
+   */
+  bool
+   record(uint32_t tick, const CVector3* positions, const Quaternion* rotations, size_t n) {
+   EU_TRACE_ZONE("TransformHistory::record");
+   if (m_count && tick <= newestTick()) return false;
+   if (n > m_slots) n = m_slots;
+   const size_t frame = (m_head + m_count) % m_capacity;
+   const size_t previous = (frame + m_capacity - 1) % m_capacity;
+   const bool carry = m_count != 0;
+   if (m_count == m_capacity) m_head = (m_head + 1) % m_capacity;
+   else ++m_count;
+   m_ticks[frame] = tick;
+
+   uint64_t* p = &m_positions[frame * m_slots];
+   uint64_t* r = &m_rotations[frame * m_slots];
+   for (size_t i = 0; i < n; ++i) p[i] = packPosition(positions[i]);
+   packQuaternionArray(rotations, r, n, m_format.rotationFormat);
+   for (size_t i = n; i < m_slots; ++i) {
+    p[i] = carry ? m_positions[previous * m_slots + i] : packPosition(CVector3(0.f, 0.f, 0.f));
+    r[i] = carry ? m_rotations[previous * m_slots + i] : packQuaternion(Quaternion(0.f, 0.f, 0.f, 1.f), m_format.rotationFormat);
+   }
+   return true;
+  }
+
+  /**
+   * @brief Transforms of all slots at tick + fraction, fraction in [0, 1), into
+   * positions[size()] and rotations[size()]. Returns false if that time is before
+   * oldestTick() or nothing was recorded.
+   */
+  template<typename Policy = EU::Precision::Default>
+  bool
+   rewind(uint32_t tick, float fraction, CVector3* positions, Quaternion* rotations) const {
+   EU_TRACE_ZONE("TransformHistory::rewind");
+   size_t a = 0, b = 0;
+   float t = 0.f;
+   if (!locate(tick, fraction, a, b, t)) return false;
+   const uint64_t* pa = &m_positions[a * m_slots];
+   unpackQuaternionArray<Policy>(&m_rotations[a * m_slots], rotations, m_slots, m_format.rotationFormat);
+   if (a == b) {
+    for (size_t i = 0; i < m_slots; ++i) positions[i] = unpackPosition(pa[i]);
+    return true;
+   }
+   thread_local std::vector<Quaternion> next;
+   next.resize(m_slots);
+   unpackQuaternionArray<Policy>(&m_rotations[b * m_slots], next.data(), m_slots, m_format.rotationFormat);
+   const uint64_t* pb = &m_positions[b * m_slots];
+   for (size_t i = 0; i < m_slots; ++i) {
+    const CVector3 from = unpackPosition(pa[i]);
+    positions[i] = from + (unpackPosition(pb[i]) - from) * t;
+   }
+   slerpFastArray<Policy>(rotations, next.data(), t, rotations, m_slots);
+   return true;
+  }
+
+  /**
+   * @brief Transform of one slot at tick + fraction, as rewind() would give it. Returns
+   * false for a slot out of range or a time before oldestTick().
+   */
+  template<typename Policy = EU::Precision::Default>
+  bool
+   sample(size_t slot, uint32_t tick, float fraction, CVector3& position, Quaternion& rotation) const {
+   size_t a = 0, b = 0;
+   float t = 0.f;
+   if (slot >= m_slots || !locate(tick, fraction, a, b, t)) return false;
+   const CVector3 from = unpackPosition(m_positions[a * m_slots + slot]);
+   Quaternion q[2];
+   unpackQuaternionArray<Policy>(&m_rotations[a * m_slots + slot], &q[0], 1, m_format.rotationFormat);
+   if (a == b) {
+    position = from;
+    rotation = q[0];
+    return true;
+   }
+   unpackQuaternionArray<Policy>(&m_rotations[b * m_slots + slot], &q[1], 1, m_format.rotationFormat);
+   position = from + (unpackPosition(m_positions[b * m_slots + slot]) - from) * t;
+   rotation = Quaternion::slerpFast<Policy>(q[0], q[1], t);
+   return true;
+  }
+
+  /** @brief Forgets every recorded tick; the next record() may use any tick. */
+  void
+   clear() {
+   m_head = 0;
+   m_count = 0;
+  }
+
+  /** @brief Entity slots per tick. */
+  size_t
+   size() const {
+   return m_slots;
+  }
+
+  /** @brief Most ticks held at once. */
+  size_t
+   capacity() const {
+   return m_capacity;
+  }
+
+  /** @brief Ticks currently held. */
+  size_t
+   frames() const {
+   return m_count;
+  }
+
+  bool
+   empty() const {
+   return m_count == 0;
+  }
+
+  /** @brief Oldest tick a lookup can reach; only meaningful when !empty(). */
+  uint32_t
+   oldestTick() const {
+   return m_ticks[m_head];
+  }
+
+  /** @brief Last recorded tick; only meaningful when !empty(). */
+  uint32_t
+   newestTick() const {
+   return m_ticks[(m_head + m_count - 1) % m_capacity];
+  }
+
+  private:
+  /** Ring index of the k-th oldest frame. */
+  size_t
+   frameAt(size_t k) const {
+   return (m_head + k) % m_capacity;
+  }
+
+  /**
+   * Frames a and b around tick + fraction and the blend t between them; a == b when the
+   * time falls on a recorded tick or past the newest one.
+   */
+  bool
+   locate(uint32_t tick, float fraction, size_t& a, size_t& b, float& t) const {
+   if (m_count == 0 || tick < oldestTick()) return false;
+   if (tick >= newestTick()) {
+    a = b = frameAt(m_count - 1);
+    t = 0.f;
+    return true;
+   }
+   // With no ticks skipped since tick, it is found by its distance to the newest one.
+   size_t k = 0;
+   const uint32_t back = newestTick() - tick;
+   if (back < m_count && m_ticks[frameAt(m_count - 1 - back)] == tick) k = m_count - 1 - back;
+   else {
+    size_t lo = 0, hi = m_count - 1; // ticks[lo] <= tick < ticks[hi]
+    while (hi - lo > 1) {
+     const size_t mid = lo + (hi - lo) / 2;
+     if (m_ticks[frameAt(mid)] <= tick) lo = mid;
+     else hi = mid;
+    }
+    k = lo;
+   }
+   a = frameAt(k);
+   b = frameAt(k + 1);
+   const float span = static_cast<float>(m_ticks[b] - m_ticks[a]);
+   t = (static_cast<float>(tick - m_ticks[a]) + EngineMath::clamp(fraction, 0.f, 1.f)) / span;
+   if (t <= 0.f) b = a;
+   return true;
+  }
+
+  uint64_t
+   packPosition(const CVector3& v) const {
+   const Bounds3& box = m_format.bounds;
+   const int bits = m_format.positionBits;
+   return static_cast<uint64_t>(quantize(v.x - box.minimum.x, 0))
+    | static_cast<uint64_t>(quantize(v.y - box.minimum.y, 1)) << bits
+    | static_cast<uint64_t>(quantize(v.z - box.minimum.z, 2)) << (2 * bits);
+  }
+
+  CVector3
+   unpackPosition(uint64_t code) const {
+   const Bounds3& box = m_format.bounds;
+   const int bits = m_format.positionBits;
+   const uint64_t field = (uint64_t(1) << bits) - 1;
+   // Fields fit an int32_t, which converts to float in one instruction, unlike uint64_t.
+   return CVector3(box.minimum.x + static_cast<float>(static_cast<int32_t>(code & field)) * m_step[0],
+                   box.minimum.y + static_cast<float>(static_cast<int32_t>((code >> bits) & field)) * m_step[1],
+                   box.minimum.z + static_cast<float>(static_cast<int32_t>((code >> (2 * bits)) & field)) * m_step[2]);
+  }
+
+  /** round(offset * scale) clamped to the field; NaN maps to 0. */
+  uint32_t
+   quantize(float offset, int axis) const {
+   const float steps = static_cast<float>((1u << m_format.positionBits) - 1u);
+   const float q = offset * m_scale[axis];
+   if (!(q > 0.f)) return 0;
+   return static_cast<uint32_t>((q < steps ? q : steps) + 0.5f);
+  }
+
+  TransformHistoryFormat m_format;
+  size_t m_slots;
+  size_t m_capacity;
+  size_t m_head;                    ///< Ring index of the oldest frame
+  size_t m_count;
+  float m_scale[3];                 ///< Steps per unit of each axis
+  float m_step[3];                  ///< Units per step of each axis
+  std::vector<uint32_t> m_ticks;    ///< Tick of each ring frame
+  std::vector<uint64_t> m_positions; ///< capacity frames of slots packed positions
+  std::vector<uint64_t> m_rotations; ///< capacity frames of slots smallest-three codes
+ };
+}
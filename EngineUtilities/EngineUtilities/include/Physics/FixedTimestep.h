@@ -0,0 +1,282 @@
+/**
+ * @file FixedTimestep.h
+ * @brief Fixed-rate simulation clock on sf::Clock, and render-time interpolation of the
+ * simulated positions and orientations in one SoA pass.
+ *
+ * FixedTimestep accumulates real time and runs the step callback once per elapsed step, so
+ * physics and gameplay always advance by the same dt however fast frames render. A frame
+ * that falls behind by more than maxSteps steps drops the excess instead of spiralling into
+ * ever longer catch-ups. alpha() is the fraction of a step left in the accumulator: how far
+ * the real time has moved past the last simulated state.
+ *
+ * InterpolatedTransforms holds the translation and rotation of every renderable twice. The
+ * simulation writes current(); beginStep(), called before each step, copies it to the
+ * previous buffer. interpolate() then renders previous + (current - previous) * alpha: one
+ * pass over all objects, lerping positions and nlerping rotations on the shortest arc a
+ * register of objects at a time, in the arithmetic of blendPoses(). What is drawn lags the
+ * simulation by up to one step but moves smoothly at any frame rate. teleport() copies an
+ * object's current state to the previous buffer so a jump is not smeared over a frame.
+ *
+ *   FixedTimestep clock(1.f / 60.f);
+ *   clock.update([&](float dt) { transforms.beginStep(); simulate(transforms.current(), dt); });
+ *   transforms.interpolate(clock.alpha(), renderPositions, renderRotations);
+ *
+ * Needs sfml-system at link time.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <SFML/System/Clock.hpp>
+#include <Core/SIMD.h>
+#include <Core/Trace.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Precision.h>
+#include <Matrices/PoseBlend.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector3Stream.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /**
+  * @class FixedTimestep
+  * @brief Turns real frame times into a whole number of fixed simulation steps.
+  */
+ class
+  FixedTimestep {
+  public:
+  /**
+   * @param step Simulated seconds per step.
+   * @param maxSteps Most steps one update() runs; time beyond them is dropped.
+   */
+  explicit FixedTimestep(float step = 1.f / 60.f, size_t maxSteps = 8)
+   : m_step(step), m_maxSteps(maxSteps ? maxSteps : 1), m_accumulator(0.0), m_time(0.0), m_steps(0) {}
+
+  /**
+   * @brief Adds the time since the previous call (since construction or reset() for the
+   * first) and calls step(dt) for every step that is due. Returns the steps run.
+   */
+  template<typename Step>
+  size_t
+   update(Step step) {
+   return update(m_clock.restart().asSeconds(), step);
+  }
+
+  /** @brief update() for elapsed seconds measured elsewhere, e.g. a replay or a paused clock. */
+  template<typename Step>
+  size_t
+   update(float elapsed, Step step) {
+   EU_TRACE_ZONE("FixedTimestep::update");
+   const size_t due = advance(elapsed);
+   for (size_t i = 0; i < due; ++i) step(m_step);
+   return due;
+  }
+
+  /**
+   * @brief Adds elapsed seconds and takes the steps now due off the accumulator without
+   * running anything, for loops that drive the steps themselves.
+   */
+  size_t
+   advance(float elapsed) {
+   m_accumulator += elapsed > 0.f ? elapsed : 0.f;
+   size_t due = static_cast<size_t>(m_accumulator / m_step);
+   if (due > m_maxSteps) {
+    due = m_maxSteps;
+    m_accumulator = m_step * static_cast<double>(due);
+   }
+   m_accumulator -= m_step * static_cast<double>(due);
+   m_time += m_step * static_cast<double>(due);
+   m_steps += due;
+   return due;
+  }
+
+  /** @brief Fraction of a step real time is ahead of the last simulated state, in [0, 1). */
+  float
+   alpha() const {
+   const float a = static_cast<float>(m_accumulator / m_step);
+   return a < 1.f ? a : 1.f;
+  }
+
+  /** @brief Simulated seconds per step. */
+  float
+   step() const {
+   return m_step;
+  }
+
+  /** @brief Simulated seconds so far. */
+  double
+   time() const {
+   return m_time;
+  }
+
+  /** @brief Steps run so far. */
+  uint64_t
+   stepCount() const {
+   return m_steps;
+  }
+
+  /** @brief Restarts the clock, e.g. after loading, and empties the accumulator. */
+  void
+   reset() {
+   m_clock.restart();
+   m_accumulator = 0.0;
+  }
+
+  private:
+  sf::Clock m_clock;
+  float m_step;
+  size_t m_maxSteps;
+  double m_accumulator;
+  double m_time;
+  uint64_t m_steps;
+ };
+
+ /**
+  * @brief out = a + (b - a) * alpha for n positions, and the shortest-arc nlerp of the
+  * rotations by alpha. out may be a or b.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  interpolateTransforms(EngineMath::batch::ConstSoA3 aPositions, const ConstQuaternionSoA& aRotations,
+                        EngineMath::batch::ConstSoA3 bPositions, const ConstQuaternionSoA& bRotations, float alpha,
+                        EngineMath::batch::SoA3 outPositions, const QuaternionSoA& outRotations, size_t n) {
+  using detail::BatchLanes;
+  const BatchLanes zero = BatchLanes::zero();
+  const BatchLanes w = BatchLanes::set1(alpha);
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   BatchLanes p[3], q[3];
+   detail::loadLanes3(aPositions, i, count, p);
+   detail::loadLanes3(bPositions, i, count, q);
+   for (int c = 0; c < 3; ++c) p[c] = Policy::maddLanes(q[c] - p[c], w, p[c]);
+   detail::storeLanes(p[0], outPositions.x, i, count);
+   detail::storeLanes(p[1], outPositions.y, i, count);
+   detail::storeLanes(p[2], outPositions.z, i, count);
+
+   BatchLanes r[4] = { detail::loadLanes(aRotations.x, i, count), detail::loadLanes(aRotations.y, i, count),
+                       detail::loadLanes(aRotations.z, i, count), detail::loadLanes(aRotations.w, i, count) };
+   const BatchLanes s[4] = { detail::loadLanes(bRotations.x, i, count), detail::loadLanes(bRotations.y, i, count),
+                             detail::loadLanes(bRotations.z, i, count), detail::loadLanes(bRotations.w, i, count) };
+   const BatchLanes dot = Policy::maddLanes(r[3], s[3], Policy::maddLanes(r[2], s[2],
+                                            Policy::maddLanes(r[1], s[1], r[0] * s[0])));
+   const BatchLanes signedW = EU::SIMD::select(dot < zero, zero - w, w);
+   for (int c = 0; c < 4; ++c) r[c] = Policy::maddLanes(s[c], signedW, Policy::maddLanes(zero - r[c], w, r[c]));
+   detail::normalizeRotationLanes<Policy>(r);
+   detail::storeLanes(r[0], outRotations.x, i, count);
+   detail::storeLanes(r[1], outRotations.y, i, count);
+   detail::storeLanes(r[2], outRotations.z, i, count);
+   detail::storeLanes(r[3], outRotations.w, i, count);
+  }
+ }
+
+ /**
+  * @class InterpolatedTransforms
+  * @brief Previous and current translation and rotation of n renderables, SoA.
+  */
+ class
+  InterpolatedTransforms {
+  public:
+  /** @brief Simulated state written by the step: positions and rotations of every object. */
+  struct State {
+   EngineMath::batch::SoA3 positions;
+   QuaternionSoA rotations;
+  };
+
+  InterpolatedTransforms() : m_size(0) {}
+
+  explicit InterpolatedTransforms(size_t n) : InterpolatedTransforms() {
+   resize(n);
+  }
+
+  /** @brief Changes the object count; new objects sit at the origin, unrotated, in both buffers. */
+  void
+   resize(size_t n) {
+   for (size_t b = 0; b < 2; ++b) {
+    m_positions[b].resize(n);
+    m_rotations[b][0].resize(n, 0.f);
+    m_rotations[b][1].resize(n, 0.f);
+    m_rotations[b][2].resize(n, 0.f);
+    m_rotations[b][3].resize(n, 1.f);
+   }
+   m_size = n;
+  }
+
+  size_t
+   size() const {
+   return m_size;
+  }
+
+  /** @brief State the simulation reads and writes; valid until the next resize(). */
+  State
+   current() {
+   return state(CURRENT);
+  }
+
+  /** @brief State as of the last beginStep(). */
+  State
+   previous() {
+   return state(PREVIOUS);
+  }
+
+  /** @brief Sets object i in the current state. */
+  void
+   set(size_t i, const CVector3& position, const Quaternion& rotation) {
+   m_positions[CURRENT].set(i, position);
+   m_rotations[CURRENT][0][i] = rotation.x;
+   m_rotations[CURRENT][1][i] = rotation.y;
+   m_rotations[CURRENT][2][i] = rotation.z;
+   m_rotations[CURRENT][3][i] = rotation.w;
+  }
+
+  /** @brief Keeps the current state as the previous one; call before every simulation step. */
+  void
+   beginStep() {
+   if (m_size == 0) return;
+   std::memcpy(m_positions[PREVIOUS].x(), m_positions[CURRENT].x(), m_size * sizeof(float));
+   std::memcpy(m_positions[PREVIOUS].y(), m_positions[CURRENT].y(), m_size * sizeof(float));
+   std::memcpy(m_positions[PREVIOUS].z(), m_positions[CURRENT].z(), m_size * sizeof(float));
+   for (size_t c = 0; c < 4; ++c) {
+    std::memcpy(m_rotations[PREVIOUS][c].data(), m_rotations[CURRENT][c].data(), m_size * sizeof(float));
+   }
+  }
+
+  /** @brief Makes object i's previous state its current one, so a jump renders at once. */
+  void
+   teleport(size_t i) {
+   m_positions[PREVIOUS].set(i, m_positions[CURRENT].get(i));
+   for (size_t c = 0; c < 4; ++c) m_rotations[PREVIOUS][c][i] = m_rotations[CURRENT][c][i];
+  }
+
+  /** @brief Render state at alpha (FixedTimestep::alpha()) between previous and current. */
+  template<typename Policy = EU::Precision::Default>
+  void
+   interpolate(float alpha, EngineMath::batch::SoA3 positions, const QuaternionSoA& rotations) const {
+   EU_TRACE_ZONE("InterpolatedTransforms::interpolate");
+   interpolateTransforms<Policy>(m_positions[PREVIOUS].soa(), constRotations(PREVIOUS), m_positions[CURRENT].soa(),
+                                 constRotations(CURRENT), alpha, positions, rotations, m_size);
+  }
+
+  private:
+  static constexpr size_t PREVIOUS = 0;
+  static constexpr size_t CURRENT = 1;
+
+  State
+   state(size_t b) {
+   return { m_positions[b].soa(),
+            { m_rotations[b][0].data(), m_rotations[b][1].data(), m_rotations[b][2].data(), m_rotations[b][3].data() } };
+  }
+
+  ConstQuaternionSoA
+   constRotations(size_t b) const {
+   return { m_rotations[b][0].data(), m_rotations[b][1].data(), m_rotations[b][2].data(), m_rotations[b][3].data() };
+  }
+
+  Vector3Stream m_positions[2];
+  std::vector<float> m_rotations[2][4]; ///< [buffer][x, y, z, w]
+  size_t m_size;
+ };
+}
@@ -0,0 +1,828 @@
+/**
+ * @file PhysicsWorld2D.h
+ * @brief 2D rigid bodies (circles and boxes): grid broadphase, contact manifolds, a
+ * sequential-impulse solver with warm starting, and islands solved in parallel.
+ *
+ * Bodies live in SoA arrays indexed by id. A step runs in six passes:
+ *  1. Broadphase: every body's bounds, widened by PHYSICS_MARGIN, are filed into the hashed
+ *     grid cells they cover, and each overlapping pair is reported once, by the cell holding
+ *     the corner max(minA, minB). Bodies covering more than detail::PHYSICS_LARGE_CELLS cells
+ *     (ground, walls) are tested against everything instead of filling the grid.
+ *  2. Narrowphase: circle-circle, circle-box and box-box (SAT with edge clipping) manifolds of
+ *     up to two points, each point tagged with the features it came from.
+ *  3. Gravity is applied to the velocities of the dynamic bodies.
+ *  4. Islands: bodies joined through contacts are grouped by union-find; static bodies never
+ *     join, so they do not merge the islands resting on them.
+ *  5. Every island runs its own solver iterations as a separate task: no two islands share a
+ *     dynamic body, so they need no synchronization. Contact points whose pair and features
+ *     match one of the previous step start from its impulses (warm starting).
+ *  6. Positions and angles integrate from the solved velocities (semi-implicit Euler).
+ *
+ * Overlap is resolved with Baumgarte stabilization past a small slop, and restitution applies
+ * above PHYSICS_RESTITUTION_SPEED. Contacts are solved in the broadphase's order, which
+ * depends on the bodies only, so a step gives the same result for any thread count.
+ *
+ * Per-step scratch (bounds, grid, pairs, manifolds, islands) comes from a FrameArena reset
+ * at the start of each step, and the warm-start caches are two vectors swapped each step, so
+ * once a scene has settled into its size, stepping allocates nothing.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <Core/FrameArena.h>
+#include <Core/Parallel.h>
+#include <Core/Trace.h>
+#include <Geometry/SpatialHash2D.h>
+#include <Math/EngineMath.h>
+#include <Math/IntMath.h>
+#include <Matrices/Matrix2x2.h>
+#include <Vectors/Vector2.h>
+
+namespace EU {
+ /// Distance by which bounds are widened, so resting contacts stay in the broadphase.
+ constexpr float PHYSICS_MARGIN = 0.02f;
+ /// Penetration left alone by position correction, so resting contacts do not jitter.
+ constexpr float PHYSICS_SLOP = 0.01f;
+ /// Fraction of the remaining penetration corrected per step.
+ constexpr float PHYSICS_BAUMGARTE = 0.2f;
+ /// Closing speed below which contacts do not bounce.
+ constexpr float PHYSICS_RESTITUTION_SPEED = 1.f;
+
+ /** @brief Collision shape of a body. */
+ enum class Shape2D : uint8_t {
+  Circle, ///< radius
+  Box     ///< halfExtents, rotated by the body's angle
+ };
+
+ /**
+  * @brief Everything a body is created from; density 0 makes it static.
+  */
+ struct BodyDef2D {
+  Shape2D shape = Shape2D::Box;
+  CVector2 position;
+  float angle = 0.f;
+  CVector2 halfExtents = CVector2(0.5f, 0.5f);
+  float radius = 0.5f;
+  CVector2 velocity;
+  float angularVelocity = 0.f;
+  float density = 1.f;
+  float friction = 0.5f;
+  float restitution = 0.f;
+ };
+
+ namespace detail {
+  /// Bodies per integration task; fixes the work split.
+  constexpr size_t PHYSICS_CHUNK = 2048;
+  /// Grid buckets per pair-finding task.
+  constexpr size_t PHYSICS_BUCKET_CHUNK = 4096;
+  /// Bodies covering more cells than this are tested against every other body instead.
+  constexpr int64_t PHYSICS_LARGE_CELLS = 64;
+  constexpr uint32_t PHYSICS_NONE = 0xffffffffu;
+
+  inline float
+   cross2(const CVector2& a, const CVector2& b) {
+   return a.x * b.y - a.y * b.x;
+  }
+
+  /** w x r for a scalar angular velocity w. */
+  inline CVector2
+   cross2(float w, const CVector2& r) {
+   return CVector2(-w * r.y, w * r.x);
+  }
+
+  struct ContactPoint2D {
+   CVector2 rA;          ///< From body a's center
+   CVector2 rB;          ///< From body b's center
+   float separation;     ///< Negative when overlapping
+   float normalImpulse;
+   float tangentImpulse;
+   float normalMass;
+   float tangentMass;
+   float bias;
+   uint32_t feature;     ///< Features that produced the point, for warm starting
+  };
+
+  struct Contact2D {
+   uint32_t a;
+   uint32_t b;
+   CVector2 normal;      ///< From a toward b
+   float friction;
+   float restitution;
+   uint32_t count;
+   ContactPoint2D points[2];
+  };
+
+  /** Previous step's impulses of one contact point. */
+  struct ContactCache2D {
+   uint64_t key;         ///< a << 32 | b
+   uint32_t feature;
+   float normalImpulse;
+   float tangentImpulse;
+
+   bool
+    operator<(const ContactCache2D& otro) const {
+    return key < otro.key || (key == otro.key && feature < otro.feature);
+   }
+  };
+
+  /** One grid cell covered by a body. */
+  struct GridEntry2D {
+   GridCell cell;
+   uint32_t body;
+  };
+
+  /** Body transform and shape as the narrowphase sees it. */
+  struct Pose2D {
+   CVector2 center;
+   Matrix2x2 rotation;   ///< Columns are the box axes
+   CVector2 half;        ///< Box half extents, or (radius, radius) for circles
+   Shape2D shape;
+  };
+
+  inline CVector2
+   axis(const Pose2D& pose, int k) {
+   return CVector2(pose.rotation.m[0][k], pose.rotation.m[1][k]);
+  }
+
+  inline void
+   addPoint(Contact2D& contact, const CVector2& point, float separation, uint32_t feature, const Pose2D& a,
+            const Pose2D& b) {
+   ContactPoint2D& p = contact.points[contact.count++];
+   p.rA = point - a.center;
+   p.rB = point - b.center;
+   p.separation = separation;
+   p.normalImpulse = 0.f;
+   p.tangentImpulse = 0.f;
+   p.normalMass = 0.f;
+   p.tangentMass = 0.f;
+   p.bias = 0.f;
+   p.feature = feature;
+  }
+
+  inline void
+   collideCircles(const Pose2D& a, const Pose2D& b, Contact2D& contact) {
+   const CVector2 d = b.center - a.center;
+   const float distSq = d.lengthSquared(), r = a.half.x + b.half.x;
+   if (distSq > r * r) return;
+   const float dist = EngineMath::sqrtHardware(distSq);
+   contact.normal = dist > 0.f ? d * (1.f / dist) : CVector2(0.f, 1.f);
+   const float separation = dist - r;
+   addPoint(contact, a.center + contact.normal * (a.half.x + 0.5f * separation), separation, 0, a, b);
+  }
+
+  /** Circle against box; the normal points from box to circle, and the other way when flip. */
+  inline void
+   collideBoxCircle(const Pose2D& box, const Pose2D& circle, bool flip, Contact2D& contact) {
+   const CVector2 d = circle.center - box.center;
+   const CVector2 local(d.x * box.rotation.m[0][0] + d.y * box.rotation.m[1][0],
+                        d.x * box.rotation.m[0][1] + d.y * box.rotation.m[1][1]);
+   const CVector2 clamped(EngineMath::clamp(local.x, -box.half.x, box.half.x),
+                          EngineMath::clamp(local.y, -box.half.y, box.half.y));
+   const float r = circle.half.x;
+   CVector2 normalLocal, surface;
+   float separation;
+   if (clamped.x == local.x && clamped.y == local.y) {
+    // Center inside the box: push out through the nearest face.
+    const float px = box.half.x - EngineMath::fabs(local.x), py = box.half.y - EngineMath::fabs(local.y);
+    if (px < py) {
+     normalLocal = CVector2(local.x < 0.f ? -1.f : 1.f, 0.f);
+     surface = CVector2(normalLocal.x * box.half.x, local.y);
+     separation = -px - r;
+    }
+    else {
+     normalLocal = CVector2(0.f, local.y < 0.f ? -1.f : 1.f);
+     surface = CVector2(local.x, normalLocal.y * box.half.y);
+     separation = -py - r;
+    }
+   }
+   else {
+    const CVector2 delta = local - clamped;
+    const float distSq = delta.lengthSquared();
+    if (distSq > r * r) return;
+    const float dist = EngineMath::sqrtHardware(distSq);
+    normalLocal = delta * (1.f / dist);
+    surface = clamped;
+    separation = dist - r;
+   }
+   const CVector2 normal = box.rotation * normalLocal;
+   const CVector2 point = box.center + box.rotation * surface + normal * (0.5f * separation);
+   contact.normal = flip ? normal * -1.f : normal;
+   if (flip) addPoint(contact, point, separation, 0, circle, box);
+   else addPoint(contact, point, separation, 0, box, circle);
+  }
+
+  /** Largest separation of box b from box a along a's face normals, and its axis. */
+  inline float
+   faceSeparation(const Pose2D& a, const Pose2D& b, int& face) {
+   const CVector2 d = b.center - a.center;
+   float best = -Constants::INF;
+   for (int k = 0; k < 2; ++k) {
+    const CVector2 n = axis(a, k);
+    const float reach = b.half.x * EngineMath::fabs(n.dot(axis(b, 0))) + b.half.y * EngineMath::fabs(n.dot(axis(b, 1)));
+    const float s = EngineMath::fabs(n.dot(d)) - (k == 0 ? a.half.x : a.half.y) - reach;
+    if (s > best) {
+     best = s;
+     face = k;
+    }
+   }
+   return best;
+  }
+
+  /**
+   * Box-box manifold: the reference face is the face of least penetration (a's preferred
+   * within a tolerance, for stable resting stacks), the incident edge is b's face most
+   * opposed to it, and the edge is clipped to the reference face's side planes.
+   */
+  inline void
+   collideBoxes(const Pose2D& a, const Pose2D& b, Contact2D& contact) {
+   int faceA = 0, faceB = 0;
+   const float sa = faceSeparation(a, b, faceA);
+   if (sa > 0.f) return;
+   const float sb = faceSeparation(b, a, faceB);
+   if (sb > 0.f) return;
+   const bool flip = sb > 0.95f * sa + 0.01f * PHYSICS_SLOP;
+   const Pose2D& ref = flip ? b : a;
+   const Pose2D& inc = flip ? a : b;
+   const int face = flip ? faceB : faceA;
+   CVector2 n = axis(ref, face);
+   if (n.dot(inc.center - ref.center) < 0.f) n = n * -1.f;
+   const float refHalf = face == 0 ? ref.half.x : ref.half.y, sideHalf = face == 0 ? ref.half.y : ref.half.x;
+   const CVector2 side = axis(ref, 1 - face);
+
+   // Incident face: the one of inc whose outward normal is most opposed to n.
+   int incFace = 0;
+   float incSign = 1.f, most = Constants::INF;
+   for (int k = 0; k < 2; ++k) {
+    const float dn = axis(inc, k).dot(n);
+    if (dn < most) {
+     most = dn;
+     incFace = k;
+     incSign = 1.f;
+    }
+    if (-dn < most) {
+     most = -dn;
+     incFace = k;
+     incSign = -1.f;
+    }
+   }
+   const CVector2 incNormal = axis(inc, incFace) * incSign, incSide = axis(inc, 1 - incFace);
+   const float incHalf = incFace == 0 ? inc.half.x : inc.half.y, incSideHalf = incFace == 0 ? inc.half.y : inc.half.x;
+   const CVector2 mid = inc.center + incNormal * incHalf;
+   CVector2 v[2] = { mid - incSide * incSideHalf, mid + incSide * incSideHalf };
+
+   // Clip the incident edge to -sideHalf <= (p - ref.center) . side <= sideHalf. A clipped
+   // endpoint keeps its feature id, so a point that is clipped on one step and not the next
+   // still finds its warm-start impulse.
+   for (int bound = 0; bound < 2; ++bound) {
+    const float sign = bound == 0 ? -1.f : 1.f;
+    const float d0 = sign * (v[0] - ref.center).dot(side) - sideHalf;
+    const float d1 = sign * (v[1] - ref.center).dot(side) - sideHalf;
+    if (d0 > 0.f && d1 > 0.f) return;
+    if (d0 > 0.f || d1 > 0.f) {
+     const CVector2 cut = v[0] + (v[1] - v[0]) * (d0 / (d0 - d1));
+     v[d0 > 0.f ? 0 : 1] = cut;
+    }
+   }
+   contact.normal = flip ? n * -1.f : n;
+   const uint32_t base = (flip ? 1u : 0u) << 12 | static_cast<uint32_t>(face) << 8 | static_cast<uint32_t>(incFace) << 4 |
+                         (incSign > 0.f ? 1u : 0u) << 3;
+   for (int k = 0; k < 2; ++k) {
+    const float separation = (v[k] - ref.center).dot(n) - refHalf;
+    if (separation > PHYSICS_MARGIN) continue;
+    // The midpoint between the two surfaces.
+    addPoint(contact, v[k] - n * (0.5f * separation), separation, base | static_cast<uint32_t>(k), a, b);
+   }
+  }
+ }
+
+ /**
+  * @class PhysicsWorld2D
+  * @brief Rigid-body world of circles and boxes; see the file comment.
+  */
+ class
+  PhysicsWorld2D {
+  public:
+  /**
+   * @param cellSize Broadphase cell size; around the typical body diameter works best.
+   */
+  explicit PhysicsWorld2D(float cellSize = 1.f) : m_cellSize(cellSize > 0.f ? cellSize : 1.f) {}
+
+  /** @brief Adds a body and returns its id; ids of destroyed bodies are reused. */
+  uint32_t
+   createBody(const BodyDef2D& def) {
+   uint32_t id;
+   if (!m_free.empty()) {
+    id = m_free.back();
+    m_free.pop_back();
+   }
+   else {
+    id = static_cast<uint32_t>(m_px.size());
+    for (std::vector<float>* v : { &m_px, &m_py, &m_angle, &m_vx, &m_vy, &m_w, &m_invMass, &m_invInertia, &m_hx, &m_hy,
+                                   &m_friction, &m_restitution }) {
+     v->push_back(0.f);
+    }
+    m_shape.push_back(Shape2D::Box);
+    m_alive.push_back(0);
+   }
+   const bool circle = def.shape == Shape2D::Circle;
+   const float hx = circle ? def.radius : def.halfExtents.x, hy = circle ? def.radius : def.halfExtents.y;
+   const float mass = def.density * (circle ? Constants::PI * hx * hx : 4.f * hx * hy);
+   const float inertia = circle ? 0.5f * mass * hx * hx : mass * (hx * hx + hy * hy) / 3.f;
+   m_px[id] = def.position.x;
+   m_py[id] = def.position.y;
+   m_angle[id] = def.angle;
+   m_vx[id] = def.velocity.x;
+   m_vy[id] = def.velocity.y;
+   m_w[id] = def.angularVelocity;
+   m_invMass[id] = mass > 0.f ? 1.f / mass : 0.f;
+   m_invInertia[id] = inertia > 0.f ? 1.f / inertia : 0.f;
+   m_hx[id] = hx;
+   m_hy[id] = hy;
+   m_friction[id] = def.friction;
+   m_restitution[id] = def.restitution;
+   m_shape[id] = def.shape;
+   m_alive[id] = 1;
+   return id;
+  }
+
+  /** @brief Removes body id; an id that is not alive is ignored. */
+  void
+   destroyBody(uint32_t id) {
+   if (!alive(id)) return;
+   m_alive[id] = 0;
+   m_free.push_back(id);
+  }
+
+  bool
+   alive(uint32_t id) const {
+   return id < m_alive.size() && m_alive[id] != 0;
+  }
+
+  /** @brief Removes every body and forgets the warm-start cache. */
+  void
+   clear() {
+   for (std::vector<float>* v : { &m_px, &m_py, &m_angle, &m_vx, &m_vy, &m_w, &m_invMass, &m_invInertia, &m_hx, &m_hy,
+                                  &m_friction, &m_restitution }) {
+    v->clear();
+   }
+   m_shape.clear();
+   m_alive.clear();
+   m_free.clear();
+   m_cache.clear();
+   m_nextCache.clear();
+   m_contactCount = 0;
+   m_islandCount = 0;
+  }
+
+  CVector2
+   position(uint32_t id) const {
+   return CVector2(m_px[id], m_py[id]);
+  }
+
+  float
+   angle(uint32_t id) const {
+   return m_angle[id];
+  }
+
+  CVector2
+   velocity(uint32_t id) const {
+   return CVector2(m_vx[id], m_vy[id]);
+  }
+
+  float
+   angularVelocity(uint32_t id) const {
+   return m_w[id];
+  }
+
+  bool
+   isStatic(uint32_t id) const {
+   return m_invMass[id] == 0.f;
+  }
+
+  /** @brief Teleports body id; contacts are rebuilt at the next step. */
+  void
+   setTransform(uint32_t id, const CVector2& position, float angle) {
+   m_px[id] = position.x;
+   m_py[id] = position.y;
+   m_angle[id] = angle;
+  }
+
+  void
+   setVelocity(uint32_t id, const CVector2& velocity, float angularVelocity) {
+   m_vx[id] = velocity.x;
+   m_vy[id] = velocity.y;
+   m_w[id] = angularVelocity;
+  }
+
+  /** @brief Applies impulse at the world-space point; ignored by static bodies. */
+  void
+   applyImpulse(uint32_t id, const CVector2& impulse, const CVector2& point) {
+   m_vx[id] += impulse.x * m_invMass[id];
+   m_vy[id] += impulse.y * m_invMass[id];
+   m_w[id] += m_invInertia[id] * detail::cross2(point - position(id), impulse);
+  }
+
+  void
+   setGravity(const CVector2& gravity) {
+   m_gravity = gravity;
+  }
+
+  const CVector2&
+   gravity() const {
+   return m_gravity;
+  }
+
+  /** @brief Velocity iterations per step (default 8). */
+  void
+   setIterations(uint32_t iterations) {
+   m_iterations = iterations;
+  }
+
+  /** @brief Body slots, live or not; ids are below this. */
+  size_t
+   capacity() const {
+   return m_px.size();
+  }
+
+  /** @brief Touching pairs in the last step. */
+  size_t
+   contactCount() const {
+   return m_contactCount;
+  }
+
+  /** @brief Islands solved in the last step. */
+  size_t
+   islandCount() const {
+   return m_islandCount;
+  }
+
+  /** @brief Per-step scratch arena, e.g. to check that used() has settled. */
+  const FrameArena&
+   arena() const {
+   return m_arena;
+  }
+
+  /**
+   * @brief Advances the world by dt seconds.
+   * @param threads Worker threads, 0 for hardware_concurrency(); the result does not
+   * depend on it.
+   */
+  void
+   step(float dt, size_t threads = 0) {
+   if (!(dt > 0.f)) return;
+   EU_TRACE_ZONE("PhysicsWorld2D::step");
+   m_arena.reset();
+   const size_t n = m_px.size();
+   detail::Pose2D* poses = m_arena.allocateArray<detail::Pose2D>(n);
+   float* bounds = m_arena.allocateArray<float>(4 * n);
+   forEachChunk(n, threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) computePose(i, poses[i], bounds + 4 * i);
+   });
+
+   size_t pairCount = 0;
+   const std::pair<uint32_t, uint32_t>* pairs = findPairs(bounds, pairCount, threads);
+
+   detail::Contact2D* contacts = m_arena.allocateArray<detail::Contact2D>(pairCount);
+   forEachChunk(pairCount, threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) collide(pairs[i].first, pairs[i].second, poses, contacts[i]);
+   });
+   size_t count = 0;
+   for (size_t i = 0; i < pairCount; ++i) {
+    if (contacts[i].count > 0) contacts[count++] = contacts[i];
+   }
+   m_contactCount = count;
+
+   const float gx = m_gravity.x * dt, gy = m_gravity.y * dt;
+   forEachChunk(n, threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+     if (m_invMass[i] == 0.f || !m_alive[i]) continue;
+     m_vx[i] += gx;
+     m_vy[i] += gy;
+    }
+   });
+
+   uint32_t* islandStart = nullptr;
+   uint32_t* islandContacts = nullptr;
+   m_islandCount = buildIslands(contacts, count, islandStart, islandContacts);
+   EU_TRACE_COUNTER("Contacts", count);
+   EU_TRACE_COUNTER("Islands", m_islandCount);
+   const float inverseDt = 1.f / dt;
+   detail::parallelTasks(m_islandCount, detail::resolveThreads(threads, m_islandCount), [&](size_t island) {
+    solveIsland(contacts, islandContacts + islandStart[island], islandStart[island + 1] - islandStart[island], inverseDt);
+   });
+   storeCache(contacts, count);
+
+   forEachChunk(n, threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+     if (m_invMass[i] == 0.f || !m_alive[i]) continue;
+     m_px[i] += m_vx[i] * dt;
+     m_py[i] += m_vy[i] * dt;
+     m_angle[i] += m_w[i] * dt;
+    }
+   });
+  }
+
+  private:
+  template<typename Fn>
+  void
+   forEachChunk(size_t n, size_t threads, Fn fn) const {
+   const size_t chunks = (n + detail::PHYSICS_CHUNK - 1) / detail::PHYSICS_CHUNK;
+   detail::parallelTasks(chunks, chunks < 2 ? 1 : detail::resolveThreads(threads, chunks), [&](size_t c) {
+    const size_t begin = c * detail::PHYSICS_CHUNK;
+    fn(begin, n - begin < detail::PHYSICS_CHUNK ? n : begin + detail::PHYSICS_CHUNK);
+   });
+  }
+
+  /** Pose and widened bounds (min x, min y, max x, max y) of body i. */
+  void
+   computePose(size_t i, detail::Pose2D& pose, float* box) const {
+   pose.center = CVector2(m_px[i], m_py[i]);
+   pose.rotation.setRotation(m_angle[i]);
+   pose.half = CVector2(m_hx[i], m_hy[i]);
+   pose.shape = m_shape[i];
+   float ex = m_hx[i], ey = m_hy[i];
+   if (pose.shape == Shape2D::Box) {
+    const float c = EngineMath::fabs(pose.rotation.m[0][0]), s = EngineMath::fabs(pose.rotation.m[1][0]);
+    ex = c * m_hx[i] + s * m_hy[i];
+    ey = s * m_hx[i] + c * m_hy[i];
+   }
+   box[0] = pose.center.x - ex - PHYSICS_MARGIN;
+   box[1] = pose.center.y - ey - PHYSICS_MARGIN;
+   box[2] = pose.center.x + ex + PHYSICS_MARGIN;
+   box[3] = pose.center.y + ey + PHYSICS_MARGIN;
+  }
+
+  bool
+   overlaps(const float* bounds, uint32_t a, uint32_t b) const {
+   const float* p = bounds + 4 * a;
+   const float* q = bounds + 4 * b;
+   return p[0] <= q[2] && q[0] <= p[2] && p[1] <= q[3] && q[1] <= p[3];
+  }
+
+  /** Pairs worth a narrowphase test: live, overlapping bounds, at least one side dynamic. */
+  bool
+   candidate(const float* bounds, uint32_t a, uint32_t b) const {
+   return (m_invMass[a] != 0.f || m_invMass[b] != 0.f) && overlaps(bounds, a, b);
+  }
+
+  /**
+   * Grid broadphase into the arena: cells counted, counting-sorted by bucket, then each
+   * bucket chunk's pairs counted and written in a second pass, then the large bodies.
+   */
+  const std::pair<uint32_t, uint32_t>*
+   findPairs(const float* bounds, size_t& pairCount, size_t threads) {
+   const size_t n = m_px.size();
+   const float inverseCell = 1.f / m_cellSize;
+   int32_t* range = m_arena.allocateArray<int32_t>(4 * n);
+   uint8_t* large = m_arena.allocateArray<uint8_t>(n);
+   size_t entries = 0;
+   for (size_t i = 0; i < n; ++i) {
+    large[i] = 0;
+    if (!m_alive[i]) continue;
+    int32_t* r = range + 4 * i;
+    for (int k = 0; k < 4; ++k) r[k] = detail::gridCoordinate(bounds[4 * i + k], inverseCell);
+    const int64_t cells = (int64_t(r[2]) - r[0] + 1) * (int64_t(r[3]) - r[1] + 1);
+    if (cells > detail::PHYSICS_LARGE_CELLS) {
+     large[i] = 1;
+    }
+    else {
+     entries += static_cast<size_t>(cells);
+    }
+   }
+   const uint32_t buckets = EngineMath::nextPow2(static_cast<uint32_t>(entries < 8 ? 16 : 2 * entries));
+   uint32_t* start = m_arena.allocateArray<uint32_t>(size_t(buckets) + 1);
+   std::fill(start, start + buckets + 1, 0u);
+   for (size_t i = 0; i < n; ++i) {
+    if (!m_alive[i] || large[i]) continue;
+    const int32_t* r = range + 4 * i;
+    for (int32_t y = r[1]; y <= r[3]; ++y)
+     for (int32_t x = r[0]; x <= r[2]; ++x) ++start[detail::gridBucket(detail::GridCell{ x, y }, buckets - 1) + 1];
+   }
+   for (uint32_t b = 0; b < buckets; ++b) start[b + 1] += start[b];
+   uint32_t* fill = m_arena.allocateArray<uint32_t>(buckets);
+   std::copy(start, start + buckets, fill);
+   detail::GridEntry2D* grid = m_arena.allocateArray<detail::GridEntry2D>(entries);
+   for (size_t i = 0; i < n; ++i) {
+    if (!m_alive[i] || large[i]) continue;
+    const int32_t* r = range + 4 * i;
+    for (int32_t y = r[1]; y <= r[3]; ++y)
+     for (int32_t x = r[0]; x <= r[2]; ++x) {
+      const detail::GridCell cell{ x, y };
+      grid[fill[detail::gridBucket(cell, buckets - 1)]++] = detail::GridEntry2D{ cell, static_cast<uint32_t>(i) };
+     }
+   }
+
+   // A pair sharing several cells is reported by the one holding the corner max(minA, minB).
+   auto bucketPairs = [&](uint32_t bucket, auto emit) {
+    for (uint32_t e = start[bucket]; e < start[bucket + 1]; ++e) {
+     for (uint32_t f = e + 1; f < start[bucket + 1]; ++f) {
+      if (!(grid[e].cell == grid[f].cell)) continue;
+      const uint32_t a = grid[e].body, b = grid[f].body;
+      if (!candidate(bounds, a, b)) continue;
+      const detail::GridCell owner{ std::max(range[4 * a], range[4 * b]), std::max(range[4 * a + 1], range[4 * b + 1]) };
+      if (owner == grid[e].cell) emit(a < b ? a : b, a < b ? b : a);
+     }
+    }
+   };
+   const size_t chunks = (buckets + detail::PHYSICS_BUCKET_CHUNK - 1) / detail::PHYSICS_BUCKET_CHUNK;
+   const size_t workers = chunks < 2 ? 1 : detail::resolveThreads(threads, chunks);
+   uint32_t* found = m_arena.allocateArray<uint32_t>(chunks + 1);
+   found[0] = 0;
+   detail::parallelTasks(chunks, workers, [&](size_t c) {
+    uint32_t k = 0;
+    const uint32_t end = static_cast<uint32_t>(std::min<size_t>(buckets, (c + 1) * detail::PHYSICS_BUCKET_CHUNK));
+    for (uint32_t b = static_cast<uint32_t>(c * detail::PHYSICS_BUCKET_CHUNK); b < end; ++b) {
+     bucketPairs(b, [&](uint32_t, uint32_t) { ++k; });
+    }
+    found[c + 1] = k;
+   });
+   for (size_t c = 0; c < chunks; ++c) found[c + 1] += found[c];
+
+   size_t largePairs = 0;
+   for (size_t i = 0; i < n; ++i) {
+    if (!large[i]) continue;
+    for (size_t j = 0; j < n; ++j) {
+     if (j != i && m_alive[j] && (!large[j] || j > i) && candidate(bounds, uint32_t(i), uint32_t(j))) ++largePairs;
+    }
+   }
+   pairCount = found[chunks] + largePairs;
+   std::pair<uint32_t, uint32_t>* pairs = m_arena.allocateArray<std::pair<uint32_t, uint32_t>>(pairCount);
+   detail::parallelTasks(chunks, workers, [&](size_t c) {
+    uint32_t k = found[c];
+    const uint32_t end = static_cast<uint32_t>(std::min<size_t>(buckets, (c + 1) * detail::PHYSICS_BUCKET_CHUNK));
+    for (uint32_t b = static_cast<uint32_t>(c * detail::PHYSICS_BUCKET_CHUNK); b < end; ++b) {
+     bucketPairs(b, [&](uint32_t a, uint32_t d) { pairs[k++] = std::make_pair(a, d); });
+    }
+   });
+   size_t k = found[chunks];
+   for (size_t i = 0; i < n; ++i) {
+    if (!large[i]) continue;
+    for (size_t j = 0; j < n; ++j) {
+     if (j != i && m_alive[j] && (!large[j] || j > i) && candidate(bounds, uint32_t(i), uint32_t(j))) {
+      pairs[k++] = std::make_pair(static_cast<uint32_t>(std::min(i, j)), static_cast<uint32_t>(std::max(i, j)));
+     }
+    }
+   }
+   return pairs;
+  }
+
+  void
+   collide(uint32_t a, uint32_t b, const detail::Pose2D* poses, detail::Contact2D& contact) const {
+   contact.a = a;
+   contact.b = b;
+   contact.count = 0;
+   contact.normal = CVector2(0.f, 1.f);
+   contact.friction = EngineMath::sqrtHardware(m_friction[a] * m_friction[b]);
+   contact.restitution = std::max(m_restitution[a], m_restitution[b]);
+   const detail::Pose2D &pa = poses[a], &pb = poses[b];
+   if (pa.shape == Shape2D::Circle && pb.shape == Shape2D::Circle) detail::collideCircles(pa, pb, contact);
+   else if (pa.shape == Shape2D::Box && pb.shape == Shape2D::Box) detail::collideBoxes(pa, pb, contact);
+   else if (pa.shape == Shape2D::Box) detail::collideBoxCircle(pa, pb, false, contact);
+   else detail::collideBoxCircle(pb, pa, true, contact);
+  }
+
+  /**
+   * Union-find over dynamic bodies, then the contacts of each island in ascending order as
+   * CSR (start has islands + 1 entries). Returns the island count.
+   */
+  uint32_t
+   buildIslands(const detail::Contact2D* contacts, size_t count, uint32_t*& start, uint32_t*& order) {
+   const size_t n = m_px.size();
+   uint32_t* parent = m_arena.allocateArray<uint32_t>(n);
+   for (size_t i = 0; i < n; ++i) parent[i] = static_cast<uint32_t>(i);
+   auto find = [&](uint32_t x) {
+    while (parent[x] != x) x = parent[x] = parent[parent[x]];
+    return x;
+   };
+   for (size_t c = 0; c < count; ++c) {
+    const uint32_t a = contacts[c].a, b = contacts[c].b;
+    if (m_invMass[a] == 0.f || m_invMass[b] == 0.f) continue;
+    const uint32_t ra = find(a), rb = find(b);
+    if (ra != rb) parent[ra > rb ? ra : rb] = ra > rb ? rb : ra;
+   }
+   uint32_t* island = m_arena.allocateArray<uint32_t>(n);
+   uint32_t islands = 0;
+   for (size_t i = 0; i < n; ++i) island[i] = detail::PHYSICS_NONE;
+   uint32_t* owner = m_arena.allocateArray<uint32_t>(count);
+   for (size_t c = 0; c < count; ++c) {
+    const uint32_t body = m_invMass[contacts[c].a] != 0.f ? contacts[c].a : contacts[c].b;
+    const uint32_t root = find(body);
+    if (island[root] == detail::PHYSICS_NONE) island[root] = islands++;
+    owner[c] = island[root];
+   }
+   start = m_arena.allocateArray<uint32_t>(size_t(islands) + 1);
+   std::fill(start, start + islands + 1, 0u);
+   for (size_t c = 0; c < count; ++c) ++start[owner[c] + 1];
+   for (uint32_t i = 0; i < islands; ++i) start[i + 1] += start[i];
+   uint32_t* fill = m_arena.allocateArray<uint32_t>(islands);
+   std::copy(start, start + islands, fill);
+   order = m_arena.allocateArray<uint32_t>(count);
+   for (size_t c = 0; c < count; ++c) order[fill[owner[c]]++] = static_cast<uint32_t>(c);
+   return islands;
+  }
+
+  /** Velocity of body i at offset r from its center. */
+  CVector2
+   pointVelocity(uint32_t i, const CVector2& r) const {
+   return CVector2(m_vx[i], m_vy[i]) + detail::cross2(m_w[i], r);
+  }
+
+  void
+   applyContactImpulse(uint32_t a, uint32_t b, const detail::ContactPoint2D& p, const CVector2& impulse) {
+   // Static bodies are shared between islands; only dynamic ones are written.
+   if (m_invMass[a] != 0.f) {
+    m_vx[a] -= impulse.x * m_invMass[a];
+    m_vy[a] -= impulse.y * m_invMass[a];
+    m_w[a] -= m_invInertia[a] * detail::cross2(p.rA, impulse);
+   }
+   if (m_invMass[b] != 0.f) {
+    m_vx[b] += impulse.x * m_invMass[b];
+    m_vy[b] += impulse.y * m_invMass[b];
+    m_w[b] += m_invInertia[b] * detail::cross2(p.rB, impulse);
+   }
+  }
+
+  /** Warm start and m_iterations of sequential impulses over one island's contacts. */
+  void
+   solveIsland(detail::Contact2D* contacts, const uint32_t* order, size_t count, float inverseDt) {
+   for (size_t k = 0; k < count; ++k) {
+    detail::Contact2D& c = contacts[order[k]];
+    const CVector2 tangent(c.normal.y, -c.normal.x);
+    const float ma = m_invMass[c.a], mb = m_invMass[c.b], ia = m_invInertia[c.a], ib = m_invInertia[c.b];
+    const uint64_t key = uint64_t(c.a) << 32 | c.b;
+    for (uint32_t i = 0; i < c.count; ++i) {
+     detail::ContactPoint2D& p = c.points[i];
+     const float rnA = detail::cross2(p.rA, c.normal), rnB = detail::cross2(p.rB, c.normal);
+     const float rtA = detail::cross2(p.rA, tangent), rtB = detail::cross2(p.rB, tangent);
+     p.normalMass = 1.f / (ma + mb + ia * rnA * rnA + ib * rnB * rnB);
+     p.tangentMass = 1.f / (ma + mb + ia * rtA * rtA + ib * rtB * rtB);
+     p.bias = -PHYSICS_BAUMGARTE * inverseDt * std::min(0.f, p.separation + PHYSICS_SLOP);
+     const float vn = (pointVelocity(c.b, p.rB) - pointVelocity(c.a, p.rA)).dot(c.normal);
+     if (vn < -PHYSICS_RESTITUTION_SPEED) p.bias = std::max(p.bias, -c.restitution * vn);
+     const detail::ContactCache2D probe{ key, p.feature, 0.f, 0.f };
+     const auto hit = std::lower_bound(m_cache.begin(), m_cache.end(), probe);
+     if (hit != m_cache.end() && hit->key == key && hit->feature == p.feature) {
+      p.normalImpulse = hit->normalImpulse;
+      p.tangentImpulse = hit->tangentImpulse;
+      applyContactImpulse(c.a, c.b, p, c.normal * p.normalImpulse + tangent * p.tangentImpulse);
+     }
+    }
+   }
+   for (uint32_t iteration = 0; iteration < m_iterations; ++iteration) {
+    for (size_t k = 0; k < count; ++k) {
+     detail::Contact2D& c = contacts[order[k]];
+     const CVector2 tangent(c.normal.y, -c.normal.x);
+     for (uint32_t i = 0; i < c.count; ++i) {
+      detail::ContactPoint2D& p = c.points[i];
+      CVector2 dv = pointVelocity(c.b, p.rB) - pointVelocity(c.a, p.rA);
+      const float normal = p.normalImpulse;
+      p.normalImpulse = std::max(normal + p.normalMass * (p.bias - dv.dot(c.normal)), 0.f);
+      applyContactImpulse(c.a, c.b, p, c.normal * (p.normalImpulse - normal));
+
+      dv = pointVelocity(c.b, p.rB) - pointVelocity(c.a, p.rA);
+      const float limit = c.friction * p.normalImpulse, friction = p.tangentImpulse;
+      p.tangentImpulse = EngineMath::clamp(friction - p.tangentMass * dv.dot(tangent), -limit, limit);
+      applyContactImpulse(c.a, c.b, p, tangent * (p.tangentImpulse - friction));
+     }
+    }
+   }
+  }
+
+  /** Keeps this step's impulses, sorted by pair and feature, for the next step's warm start. */
+  void
+   storeCache(const detail::Contact2D* contacts, size_t count) {
+   m_nextCache.clear();
+   for (size_t k = 0; k < count; ++k) {
+    const detail::Contact2D& c = contacts[k];
+    for (uint32_t i = 0; i < c.count; ++i) {
+     m_nextCache.push_back(detail::ContactCache2D{ uint64_t(c.a) << 32 | c.b, c.points[i].feature,
+                                                   c.points[i].normalImpulse, c.points[i].tangentImpulse });
+    }
+   }
+   std::sort(m_nextCache.begin(), m_nextCache.end());
+   m_cache.swap(m_nextCache);
+  }
+
+  std::vector<float> m_px, m_py, m_angle;
+  std::vector<float> m_vx, m_vy, m_w;
+  std::vector<float> m_invMass, m_invInertia;
+  std::vector<float> m_hx, m_hy;
+  std::vector<float> m_friction, m_restitution;
+  std::vector<Shape2D> m_shape;
+  std::vector<uint8_t> m_alive;
+  std::vector<uint32_t> m_free;
+  std::vector<detail::ContactCache2D> m_cache;
+  std::vector<detail::ContactCache2D> m_nextCache;
+  FrameArena m_arena;
+  CVector2 m_gravity = CVector2(0.f, -9.81f);
+  float m_cellSize;
+  uint32_t m_iterations = 8;
+  size_t m_contactCount = 0;
+  size_t m_islandCount = 0;
+ };
+}
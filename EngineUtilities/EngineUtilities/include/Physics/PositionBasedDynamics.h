@@ -0,0 +1,595 @@
+/**
+ * @file PositionBasedDynamics.h
+ * @brief XPBD particle solver for cloth and ropes: distance and bending constraints solved
+ * by graph color across SIMD lanes and threads, static colliders and substepping.
+ *
+ * Particles live in Vector3Stream SoA arrays, and every cloth or rope is simply a range of
+ * them, so putting all instances in one PBDSolver gives each color enough constraints to
+ * fill the lanes and threads. A step is split into substeps (Macklin et al., "Small Steps in
+ * Physics Simulation"); each substep runs four passes:
+ *  1. Predict: x += v h + g h^2 for every particle with a nonzero inverse mass.
+ *  2. Constraints: distance and bending, a color at a time, for setIterations() iterations.
+ *  3. Colliders: spheres and planes push particles out and remove setFriction() of their
+ *     tangential motion.
+ *  4. Velocities: v = (x - x_previous) / h, drag-damped.
+ *
+ * Constraints are XPBD: compliance is inverse stiffness (0 is rigid) and stays independent
+ * of the substep count. Bending is the three-particle constraint of Kelager et al., "A
+ * Triangle Bending Constraint Model for Position-Based Dynamics": the middle particle keeps
+ * its rest distance from the centroid of the triple, which works for ropes and for the rows
+ * and columns of a cloth.
+ *
+ * The first step after constraints change colors them greedily so that no two constraints
+ * of a color share a particle, then reorders them by color. A color's constraints are
+ * therefore independent: each batch of BATCH_WIDTH gathers its particles into lanes, solves
+ * and scatters them back, and large colors split into fixed-size thread tasks. The result
+ * does not depend on the thread count. Constraints left without a free color among the
+ * first PBD_MAX_COLORS are solved last, one by one.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Core/Trace.h>
+#include <Math/EngineMath.h>
+#include <Vectors/ParticleIntegrate.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector3Stream.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Colors the greedy coloring hands out; constraints that need more are solved serially.
+ constexpr size_t PBD_MAX_COLORS = 64;
+
+ /** @brief Sphere collider: particles stay at least radius from center. */
+ struct PBDSphere {
+  CVector3 center;
+  float radius = 0.f;
+ };
+
+ /** @brief Plane collider: particles stay where dot(normal, x) >= offset. */
+ struct PBDPlane {
+  CVector3 normal = CVector3(0.f, 1.f, 0.f); ///< Unit length
+  float offset = 0.f;
+ };
+
+ namespace detail {
+  /// Constraints or particles per thread task; fixes the work split.
+  constexpr size_t PBD_CHUNK = 2048;
+  /// Work below which a pass stays on the calling thread.
+  constexpr size_t PBD_PARALLEL_MIN = 8192;
+  /// Lengths below this are treated as zero, leaving the constraint alone.
+  constexpr float PBD_EPSILON = 1e-9f;
+
+  /**
+   * Constraints on K particles each, with XPBD multipliers, grouped by color once colored:
+   * color c holds [colors[c], colors[c + 1]), and the last range is the serial overflow.
+   */
+  template<size_t K>
+  struct PBDConstraints {
+   std::vector<uint32_t> particles[K];
+   std::vector<float> rest;
+   std::vector<float> compliance;
+   std::vector<float> lambda;
+   std::vector<uint32_t> colors;
+
+   size_t
+    size() const {
+    return rest.size();
+   }
+
+   void
+    clear() {
+    for (size_t k = 0; k < K; ++k) particles[k].clear();
+    rest.clear();
+    compliance.clear();
+    lambda.clear();
+    colors.clear();
+   }
+  };
+
+  /** Greedily colors set, then reorders it so every color is contiguous. */
+  template<size_t K>
+  inline void
+   colorConstraints(PBDConstraints<K>& set, size_t particleCount, std::vector<uint64_t>& used,
+                    std::vector<uint32_t>& color, std::vector<uint32_t>& order) {
+   const size_t n = set.size();
+   used.assign(particleCount, 0);
+   color.resize(n);
+   uint32_t counts[PBD_MAX_COLORS + 1] = {};
+   for (size_t i = 0; i < n; ++i) {
+    uint64_t taken = 0;
+    for (size_t k = 0; k < K; ++k) taken |= used[set.particles[k][i]];
+    uint32_t c = 0;
+    while (c < PBD_MAX_COLORS && (taken >> c) & 1u) ++c;
+    if (c < PBD_MAX_COLORS) {
+     for (size_t k = 0; k < K; ++k) used[set.particles[k][i]] |= uint64_t(1) << c;
+    }
+    color[i] = c;
+    ++counts[c];
+   }
+
+   size_t colorCount = 0;
+   for (size_t c = 0; c < PBD_MAX_COLORS; ++c) {
+    if (counts[c]) colorCount = c + 1;
+   }
+   set.colors.assign(colorCount + 2, 0);
+   for (size_t c = 0; c < colorCount; ++c) set.colors[c + 1] = set.colors[c] + counts[c];
+   set.colors[colorCount + 1] = static_cast<uint32_t>(n);
+
+   // Counting sort by color; the overflow color goes last.
+   uint32_t next[PBD_MAX_COLORS + 1];
+   for (size_t c = 0; c < colorCount; ++c) next[c] = set.colors[c];
+   next[PBD_MAX_COLORS] = set.colors[colorCount];
+   order.resize(n);
+   for (size_t i = 0; i < n; ++i) order[next[color[i]]++] = static_cast<uint32_t>(i);
+   auto permute = [&](auto& values) {
+    auto copy = values;
+    for (size_t i = 0; i < n; ++i) values[i] = copy[order[i]];
+   };
+   for (size_t k = 0; k < K; ++k) permute(set.particles[k]);
+   permute(set.rest);
+   permute(set.compliance);
+   set.lambda.assign(n, 0.f);
+  }
+
+  /** Gathers component p[index[j]] into lane j for the first count lanes, zero padded. */
+  inline BatchLanes
+   gatherLanes(const float* p, const uint32_t* index, size_t count) {
+   float tmp[BATCH_WIDTH] = {};
+   for (size_t j = 0; j < count; ++j) tmp[j] = p[index[j]];
+   return BatchLanes::load(tmp);
+  }
+
+  /** Writes lane j of v back to p[index[j]] for the first count lanes. */
+  inline void
+   scatterLanes(BatchLanes v, float* p, const uint32_t* index, size_t count) {
+   float tmp[BATCH_WIDTH];
+   v.store(tmp);
+   for (size_t j = 0; j < count; ++j) p[index[j]] = tmp[j];
+  }
+
+  /** Runs fn(begin, end) over [0, count) in PBD_CHUNK pieces, threaded when count is large. */
+  template<typename Fn>
+  inline void
+   forEachPBDRange(size_t count, size_t threads, Fn fn) {
+   if (count < PBD_PARALLEL_MIN || threads <= 1) {
+    if (count) fn(size_t(0), count);
+    return;
+   }
+   const size_t tasks = (count + PBD_CHUNK - 1) / PBD_CHUNK;
+   parallelTasks(tasks, resolveThreads(threads, tasks), [&](size_t task) {
+    const size_t begin = task * PBD_CHUNK;
+    fn(begin, std::min(begin + PBD_CHUNK, count));
+   });
+  }
+ }
+
+ /**
+  * @class PBDSolver
+  * @brief XPBD cloth and rope particles with distance, bending and collider constraints.
+  */
+ class
+  PBDSolver {
+  public:
+  /**
+   * @brief Adds a particle; inverseMass 0 pins it in place.
+   * @return Its index.
+   */
+  uint32_t
+   addParticle(const CVector3& position, float inverseMass) {
+   const uint32_t index = static_cast<uint32_t>(m_positions.size());
+   m_positions.push_back(position);
+   m_velocities.push_back(CVector3(0.f, 0.f, 0.f));
+   m_inverseMass.resize(m_positions.capacity(), 0.f);
+   m_inverseMass[index] = inverseMass > 0.f ? inverseMass : 0.f;
+   return index;
+  }
+
+  /**
+   * @brief Keeps particles a and b at their current distance.
+   * @return False, adding nothing, for an unknown or repeated particle.
+   */
+  bool
+   addDistance(uint32_t a, uint32_t b, float compliance = 0.f) {
+   if (a >= particleCount() || b >= particleCount() || a == b) return false;
+   const uint32_t particles[2] = { a, b };
+   addConstraint(m_distance, particles, (m_positions.get(a) - m_positions.get(b)).length<EU::Precision::Exact>(),
+                 compliance);
+   return true;
+  }
+
+  /**
+   * @brief Keeps middle at its current distance from the centroid of (a, middle, b).
+   * @return False, adding nothing, for an unknown or repeated particle.
+   */
+  bool
+   addBending(uint32_t a, uint32_t middle, uint32_t b, float compliance = 0.f) {
+   if (a >= particleCount() || middle >= particleCount() || b >= particleCount()) return false;
+   if (a == middle || a == b || middle == b) return false;
+   const CVector3 m = m_positions.get(middle);
+   const CVector3 centroid = (m_positions.get(a) + m + m_positions.get(b)) * (1.f / 3.f);
+   const uint32_t particles[3] = { a, b, middle };
+   addConstraint(m_bending, particles, (m - centroid).length<EU::Precision::Exact>(), compliance);
+   return true;
+  }
+
+  /**
+   * @brief Adds a columns x rows cloth spanning origin + [0, 1] edgeU + [0, 1] edgeV, with
+   * stretch and shear distance constraints and bending along its rows and columns.
+   * @param mass Mass of each particle.
+   * @return Index of its first particle; particle (col, fil) is first + fil * columns + col.
+   * Returns the current particle count, adding nothing, for fewer than 2 columns or rows.
+   */
+  uint32_t
+   addCloth(const CVector3& origin, const CVector3& edgeU, const CVector3& edgeV, uint32_t columns, uint32_t rows,
+            float mass, float stretchCompliance = 0.f, float bendCompliance = 1e-3f) {
+   const uint32_t first = static_cast<uint32_t>(particleCount());
+   if (columns < 2 || rows < 2) return first;
+   const float inverseMass = mass > 0.f ? 1.f / mass : 0.f;
+   const CVector3 du = edgeU * (1.f / static_cast<float>(columns - 1));
+   const CVector3 dv = edgeV * (1.f / static_cast<float>(rows - 1));
+   for (uint32_t fil = 0; fil < rows; ++fil) {
+    for (uint32_t col = 0; col < columns; ++col) {
+     addParticle(origin + du * static_cast<float>(col) + dv * static_cast<float>(fil), inverseMass);
+    }
+   }
+   auto at = [&](uint32_t col, uint32_t fil) { return first + fil * columns + col; };
+   for (uint32_t fil = 0; fil < rows; ++fil) {
+    for (uint32_t col = 0; col < columns; ++col) {
+     if (col + 1 < columns) addDistance(at(col, fil), at(col + 1, fil), stretchCompliance);
+     if (fil + 1 < rows) addDistance(at(col, fil), at(col, fil + 1), stretchCompliance);
+     if (col + 1 < columns && fil + 1 < rows) {
+      addDistance(at(col, fil), at(col + 1, fil + 1), stretchCompliance);
+      addDistance(at(col + 1, fil), at(col, fil + 1), stretchCompliance);
+     }
+     if (col + 2 < columns) addBending(at(col, fil), at(col + 1, fil), at(col + 2, fil), bendCompliance);
+     if (fil + 2 < rows) addBending(at(col, fil), at(col, fil + 1), at(col, fil + 2), bendCompliance);
+    }
+   }
+   return first;
+  }
+
+  /**
+   * @brief Adds a rope of count particles from start to end.
+   * @return Index of its first particle, or the current particle count, adding nothing, for
+   * fewer than 2 particles.
+   */
+  uint32_t
+   addRope(const CVector3& start, const CVector3& end, uint32_t count, float mass, float stretchCompliance = 0.f,
+           float bendCompliance = 1e-3f) {
+   const uint32_t first = static_cast<uint32_t>(particleCount());
+   if (count < 2) return first;
+   const float inverseMass = mass > 0.f ? 1.f / mass : 0.f;
+   const CVector3 step = (end - start) * (1.f / static_cast<float>(count - 1));
+   for (uint32_t i = 0; i < count; ++i) addParticle(start + step * static_cast<float>(i), inverseMass);
+   for (uint32_t i = 0; i + 1 < count; ++i) addDistance(first + i, first + i + 1, stretchCompliance);
+   for (uint32_t i = 0; i + 2 < count; ++i) addBending(first + i, first + i + 1, first + i + 2, bendCompliance);
+   return first;
+  }
+
+  /** @brief Adds a sphere collider; returns its index for sphere(). */
+  size_t
+   addSphere(const PBDSphere& sphere) {
+   m_spheres.push_back(sphere);
+   return m_spheres.size() - 1;
+  }
+
+  /** @brief Adds a plane collider; returns its index for plane(). */
+  size_t
+   addPlane(const PBDPlane& plane) {
+   m_planes.push_back(plane);
+   return m_planes.size() - 1;
+  }
+
+  /** @brief Collider i, to move between steps. */
+  PBDSphere& sphere(size_t i) { return m_spheres[i]; }
+  PBDPlane& plane(size_t i) { return m_planes[i]; }
+
+  /** @brief Removes every collider. */
+  void
+   clearColliders() {
+   m_spheres.clear();
+   m_planes.clear();
+  }
+
+  /** @brief Removes every particle, constraint and collider. */
+  void
+   clear() {
+   m_positions.clear();
+   m_velocities.clear();
+   m_previous.clear();
+   m_inverseMass.clear();
+   m_distance.clear();
+   m_bending.clear();
+   m_colored = false;
+   clearColliders();
+  }
+
+  /** @brief Acceleration applied to every unpinned particle. */
+  void setGravity(const CVector3& gravity) { m_gravity = gravity; }
+  /** @brief Linear velocity drag per second; 0 disables it. */
+  void setDrag(float drag) { m_drag = drag; }
+  /** @brief Fraction of tangential motion colliders remove from touching particles, in [0, 1]. */
+  void setFriction(float friction) { m_friction = EngineMath::clamp(friction, 0.f, 1.f); }
+  /** @brief Constraint iterations per substep; 1 is the small-steps default. */
+  void setIterations(uint32_t iterations) { m_iterations = iterations ? iterations : 1; }
+
+  size_t particleCount() const { return m_positions.size(); }
+  size_t distanceCount() const { return m_distance.size(); }
+  size_t bendingCount() const { return m_bending.size(); }
+  /** @brief Colors of the distance and bending constraints, once a step has colored them. */
+  size_t
+   colorCount() const {
+   return (m_distance.colors.empty() ? 0 : m_distance.colors.size() - 2) +
+          (m_bending.colors.empty() ? 0 : m_bending.colors.size() - 2);
+  }
+
+  const Vector3Stream& positions() const { return m_positions; }
+  const Vector3Stream& velocities() const { return m_velocities; }
+  CVector3 position(uint32_t i) const { return m_positions.get(i); }
+  CVector3 velocity(uint32_t i) const { return m_velocities.get(i); }
+  float inverseMass(uint32_t i) const { return m_inverseMass[i]; }
+
+  /** @brief Teleports particle i (e.g. a pinned corner following a character). */
+  void setPosition(uint32_t i, const CVector3& position) { m_positions.set(i, position); }
+  void setVelocity(uint32_t i, const CVector3& velocity) { m_velocities.set(i, velocity); }
+  /** @brief Changes the inverse mass of particle i; 0 pins it. */
+  void setInverseMass(uint32_t i, float inverseMass) { m_inverseMass[i] = inverseMass > 0.f ? inverseMass : 0.f; }
+
+  /**
+   * @brief Advances the simulation by dt in substeps equal substeps.
+   * @param threads Threads for the large passes; 0 uses every hardware thread.
+   */
+  void
+   step(float dt, uint32_t substeps = 8, size_t threads = 0) {
+   if (dt <= 0.f || particleCount() == 0) return;
+   EU_TRACE_ZONE("PBDSolver::step");
+   if (!m_colored) {
+    detail::colorConstraints(m_distance, particleCount(), m_used, m_color, m_order);
+    detail::colorConstraints(m_bending, particleCount(), m_used, m_color, m_order);
+    m_colored = true;
+   }
+   if (substeps == 0) substeps = 1;
+   if (threads == 0) threads = detail::resolveThreads(0, ~size_t(0));
+   const float h = dt / static_cast<float>(substeps);
+   m_previous.resize(particleCount());
+   for (uint32_t s = 0; s < substeps; ++s) {
+    predict(h, threads);
+    std::fill(m_distance.lambda.begin(), m_distance.lambda.end(), 0.f);
+    std::fill(m_bending.lambda.begin(), m_bending.lambda.end(), 0.f);
+    const float timeScale = 1.f / (h * h);
+    for (uint32_t it = 0; it < m_iterations; ++it) {
+     solveColors(m_distance, timeScale, threads, [this](size_t i, size_t count, float scale) {
+      solveDistance(i, count, scale);
+     });
+     solveColors(m_bending, timeScale, threads, [this](size_t i, size_t count, float scale) {
+      solveBending(i, count, scale);
+     });
+    }
+    finish(h, threads);
+   }
+  }
+
+  private:
+  template<size_t K>
+  void
+   addConstraint(detail::PBDConstraints<K>& set, const uint32_t (&particles)[K], float rest, float compliance) {
+   for (size_t k = 0; k < K; ++k) set.particles[k].push_back(particles[k]);
+   set.rest.push_back(rest);
+   set.compliance.push_back(compliance > 0.f ? compliance : 0.f);
+   m_colored = false;
+  }
+
+  /** Solves every color of set in order: batches across threads, then the serial overflow. */
+  template<size_t K, typename Solve>
+  void
+   solveColors(const detail::PBDConstraints<K>& set, float timeScale, size_t threads, Solve solve) {
+   if (set.colors.empty()) return;
+   const size_t colors = set.colors.size() - 2;
+   for (size_t c = 0; c < colors; ++c) {
+    const size_t begin = set.colors[c], count = set.colors[c + 1] - begin;
+    detail::forEachPBDRange(count, threads, [&](size_t from, size_t to) {
+     for (size_t i = from; i < to; i += detail::BATCH_WIDTH) {
+      solve(begin + i, std::min(detail::BATCH_WIDTH, to - i), timeScale);
+     }
+    });
+   }
+   for (size_t i = set.colors[colors]; i < set.size(); ++i) solve(i, 1, timeScale);
+  }
+
+  /** Loads the positions and inverse masses of particles index[0..count). */
+  void
+   gatherParticles(const uint32_t* index, size_t count, detail::BatchLanes (&p)[3], detail::BatchLanes& w) const {
+   p[0] = detail::gatherLanes(m_positions.x(), index, count);
+   p[1] = detail::gatherLanes(m_positions.y(), index, count);
+   p[2] = detail::gatherLanes(m_positions.z(), index, count);
+   w = detail::gatherLanes(m_inverseMass.data(), index, count);
+  }
+
+  void
+   scatterParticles(const uint32_t* index, size_t count, const detail::BatchLanes (&p)[3]) {
+   detail::scatterLanes(p[0], m_positions.x(), index, count);
+   detail::scatterLanes(p[1], m_positions.y(), index, count);
+   detail::scatterLanes(p[2], m_positions.z(), index, count);
+  }
+
+  /**
+   * XPBD multiplier update for count lanes of set at i, given C and the sum of w |grad C|^2;
+   * lanes whose denominator vanishes get 0.
+   */
+  template<size_t K>
+  static detail::BatchLanes
+   deltaLambda(detail::PBDConstraints<K>& set, size_t i, size_t count, detail::BatchLanes c,
+               detail::BatchLanes weight, detail::BatchLanes valid, float timeScale) {
+   using V = detail::BatchLanes;
+   const V alpha = detail::loadLanes(set.compliance.data(), i, count) * V::set1(timeScale);
+   const V lambda = detail::loadLanes(set.lambda.data(), i, count);
+   const V denominator = weight + alpha;
+   const V ok = valid & (denominator > V::zero());
+   const V delta = EU::SIMD::select(ok, (V::zero() - c - alpha * lambda) / EU::SIMD::select(ok, denominator, V::set1(1.f)),
+                                    V::zero());
+   detail::storeLanes(lambda + delta, set.lambda.data(), i, count);
+   return delta;
+  }
+
+  /** C = |a - b| - rest for count constraints at i. */
+  void
+   solveDistance(size_t i, size_t count, float timeScale) {
+   using V = detail::BatchLanes;
+   const uint32_t* ia = m_distance.particles[0].data() + i;
+   const uint32_t* ib = m_distance.particles[1].data() + i;
+   V a[3], b[3], wa, wb;
+   gatherParticles(ia, count, a, wa);
+   gatherParticles(ib, count, b, wb);
+   const V d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+   const V length = EU::SIMD::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+   const V valid = length > V::set1(detail::PBD_EPSILON);
+   const V inverse = V::set1(1.f) / EU::SIMD::select(valid, length, V::set1(1.f));
+   const V c = length - detail::loadLanes(m_distance.rest.data(), i, count);
+   const V delta = deltaLambda(m_distance, i, count, c, wa + wb, valid, timeScale) * inverse;
+   const V sa = wa * delta, sb = wb * delta;
+   for (int k = 0; k < 3; ++k) {
+    a[k] = EU::SIMD::madd(sa, d[k], a[k]);
+    b[k] = b[k] - sb * d[k];
+   }
+   scatterParticles(ia, count, a);
+   scatterParticles(ib, count, b);
+  }
+
+  /** C = |m - (a + b + m) / 3| - rest for count constraints at i. */
+  void
+   solveBending(size_t i, size_t count, float timeScale) {
+   using V = detail::BatchLanes;
+   const uint32_t* ia = m_bending.particles[0].data() + i;
+   const uint32_t* ib = m_bending.particles[1].data() + i;
+   const uint32_t* im = m_bending.particles[2].data() + i;
+   V a[3], b[3], m[3], wa, wb, wm;
+   gatherParticles(ia, count, a, wa);
+   gatherParticles(ib, count, b, wb);
+   gatherParticles(im, count, m, wm);
+   const V third = V::set1(1.f / 3.f);
+   V d[3];
+   for (int k = 0; k < 3; ++k) d[k] = m[k] - (a[k] + b[k] + m[k]) * third;
+   const V length = EU::SIMD::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+   const V valid = length > V::set1(detail::PBD_EPSILON);
+   const V inverse = V::set1(1.f) / EU::SIMD::select(valid, length, V::set1(1.f));
+   const V c = length - detail::loadLanes(m_bending.rest.data(), i, count);
+   // Gradients: 2/3 n for the middle particle, -1/3 n for the other two.
+   const V weight = (V::set1(4.f) * wm + wa + wb) * V::set1(1.f / 9.f);
+   const V delta = deltaLambda(m_bending, i, count, c, weight, valid, timeScale) * inverse * third;
+   const V sm = V::set1(2.f) * wm * delta, sa = wa * delta, sb = wb * delta;
+   for (int k = 0; k < 3; ++k) {
+    m[k] = EU::SIMD::madd(sm, d[k], m[k]);
+    a[k] = a[k] - sa * d[k];
+    b[k] = b[k] - sb * d[k];
+   }
+   scatterParticles(ia, count, a);
+   scatterParticles(ib, count, b);
+   scatterParticles(im, count, m);
+  }
+
+  /** Saves the positions and moves every unpinned particle by v h + g h^2. */
+  void
+   predict(float h, size_t threads) {
+   using V = detail::BatchLanes;
+   const V step = V::set1(h), zero = V::zero();
+   const V g[3] = { V::set1(m_gravity.x * h), V::set1(m_gravity.y * h), V::set1(m_gravity.z * h) };
+   float* p[3] = { m_positions.x(), m_positions.y(), m_positions.z() };
+   float* v[3] = { m_velocities.x(), m_velocities.y(), m_velocities.z() };
+   float* q[3] = { m_previous.x(), m_previous.y(), m_previous.z() };
+   const float* w = m_inverseMass.data();
+   detail::forEachPBDRange(particleCount(), threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i += detail::BATCH_WIDTH) {
+     const V free = V::load(w + i) > zero;
+     for (int k = 0; k < 3; ++k) {
+      const V x = V::loadAligned(p[k] + i);
+      x.storeAligned(q[k] + i);
+      const V vel = EU::SIMD::select(free, V::loadAligned(v[k] + i) + g[k], zero);
+      vel.storeAligned(v[k] + i);
+      EU::SIMD::madd(vel, step, x).storeAligned(p[k] + i);
+     }
+    }
+   });
+  }
+
+  /** Resolves the colliders, then derives the velocities from the substep's motion. */
+  void
+   finish(float h, size_t threads) {
+   using V = detail::BatchLanes;
+   const V zero = V::zero(), one = V::set1(1.f), friction = V::set1(m_friction);
+   const V rate = V::set1(detail::dragFactor(m_drag, h) / h);
+   float* p[3] = { m_positions.x(), m_positions.y(), m_positions.z() };
+   float* v[3] = { m_velocities.x(), m_velocities.y(), m_velocities.z() };
+   const float* q[3] = { m_previous.x(), m_previous.y(), m_previous.z() };
+   const float* w = m_inverseMass.data();
+   detail::forEachPBDRange(particleCount(), threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i += detail::BATCH_WIDTH) {
+     const V free = V::load(w + i) > zero;
+     V x[3], prev[3];
+     for (int k = 0; k < 3; ++k) {
+      x[k] = V::loadAligned(p[k] + i);
+      prev[k] = V::loadAligned(q[k] + i);
+     }
+     for (const PBDSphere& sphere : m_spheres) {
+      const V d[3] = { x[0] - V::set1(sphere.center.x), x[1] - V::set1(sphere.center.y),
+                       x[2] - V::set1(sphere.center.z) };
+      const V length = EU::SIMD::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+      const V radius = V::set1(sphere.radius);
+      const V hit = free & (length < radius) & (length > V::set1(detail::PBD_EPSILON));
+      const V inverse = one / EU::SIMD::select(hit, length, one);
+      const V push = EU::SIMD::select(hit, radius - length, zero) * inverse;
+      const V n[3] = { d[0] * inverse, d[1] * inverse, d[2] * inverse };
+      for (int k = 0; k < 3; ++k) x[k] = EU::SIMD::madd(push, d[k], x[k]);
+      applyFriction(x, prev, n, hit, friction);
+     }
+     for (const PBDPlane& plane : m_planes) {
+      const V n[3] = { V::set1(plane.normal.x), V::set1(plane.normal.y), V::set1(plane.normal.z) };
+      const V depth = V::set1(plane.offset) - (n[0] * x[0] + n[1] * x[1] + n[2] * x[2]);
+      const V hit = free & (depth > zero);
+      const V push = EU::SIMD::select(hit, depth, zero);
+      for (int k = 0; k < 3; ++k) x[k] = EU::SIMD::madd(push, n[k], x[k]);
+      applyFriction(x, prev, n, hit, friction);
+     }
+     for (int k = 0; k < 3; ++k) {
+      x[k].storeAligned(p[k] + i);
+      ((x[k] - prev[k]) * rate).storeAligned(v[k] + i);
+     }
+    }
+   });
+  }
+
+  /** Removes friction of the motion x - prev tangential to unit n in the hit lanes. */
+  static void
+   applyFriction(detail::BatchLanes (&x)[3], const detail::BatchLanes (&prev)[3], const detail::BatchLanes (&n)[3],
+                 detail::BatchLanes hit, detail::BatchLanes friction) {
+   using V = detail::BatchLanes;
+   const V d[3] = { x[0] - prev[0], x[1] - prev[1], x[2] - prev[2] };
+   const V normal = d[0] * n[0] + d[1] * n[1] + d[2] * n[2];
+   const V scale = EU::SIMD::select(hit, friction, V::zero());
+   for (int k = 0; k < 3; ++k) x[k] = x[k] - scale * (d[k] - normal * n[k]);
+  }
+
+  Vector3Stream m_positions;
+  Vector3Stream m_velocities;
+  Vector3Stream m_previous;
+  std::vector<float> m_inverseMass;      ///< Padded to the position capacity with zeros
+  detail::PBDConstraints<2> m_distance;
+  detail::PBDConstraints<3> m_bending;   ///< Particles a, b, then the middle one
+  std::vector<PBDSphere> m_spheres;
+  std::vector<PBDPlane> m_planes;
+  CVector3 m_gravity = CVector3(0.f, -9.81f, 0.f);
+  float m_drag = 0.f;
+  float m_friction = 0.5f;
+  uint32_t m_iterations = 1;
+  bool m_colored = false;
+  std::vector<uint64_t> m_used;          ///< Coloring scratch: colors taken per particle
+  std::vector<uint32_t> m_color;
+  std::vector<uint32_t> m_order;
+ };
+}
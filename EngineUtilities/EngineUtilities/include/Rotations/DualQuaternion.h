@@ -0,0 +1,215 @@
+/**
+ * @file DualQuaternion.h
+ * @brief Rigid transforms (rotation plus translation) as unit dual quaternions.
+ *
+ * A dual quaternion real + eps dual stores the rotation r in real and 0.5 * t * r in dual,
+ * 32 bytes against the 48 of an Affine3x4. Composition is two quaternion products for the
+ * real part and the sum of two for the dual one, and a weighted sum of unit dual quaternions
+ * renormalizes to a rigid transform again, which is what dual-quaternion skinning relies on
+ * (see Skinning.h): blended joints rotate around their center instead of collapsing the
+ * way a blend of matrices does. Scale cannot be represented.
+ *
+ * Conventions follow Quaternion and Affine3x4: a * b applies b first, and transformPoint()
+ * rotates, then translates.
+ */
+
+#pragma once
+
+#include <Math/Precision.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/Matrix3x3.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+
+ /**
+  * @class DualQuaternion
+  * @brief Rotation real and translation-carrying dual part of a rigid transform.
+  */
+ class
+  DualQuaternion {
+  public:
+  Quaternion real; ///< Rotation
+  Quaternion dual; ///< 0.5 * translation * real
+
+  /**
+   * @brief Default constructor. The identity transform.
+   */
+  constexpr DualQuaternion() : real(), dual(0.f, 0.f, 0.f, 0.f) {}
+
+  /**
+   * @brief Leaves every component uninitialized; see EU::NoInit.
+   */
+  explicit DualQuaternion(EU::NoInitTag) : real(EU::NoInit), dual(EU::NoInit) {}
+
+  /**
+   * @brief Constructs from the two parts as stored.
+   */
+  constexpr DualQuaternion(const Quaternion& real, const Quaternion& dual)
+   : real(real), dual(dual) {
+  }
+
+  /**
+   * @brief Rotation rotation (unit length) followed by translation translation.
+   */
+  static constexpr DualQuaternion
+   fromRotationTranslation(const Quaternion& rotation, const CVector3& translation) {
+   const Quaternion d = Quaternion(translation.x, translation.y, translation.z, 0.f) * rotation;
+   return DualQuaternion(rotation, Quaternion(d.x * 0.5f, d.y * 0.5f, d.z * 0.5f, d.w * 0.5f));
+  }
+
+  /**
+   * @brief Rigid part of transform: the rotation of its 3x3 block (see Quaternion::fromMatrix())
+   * and its translation. Scale and shear are dropped.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static EU_CONSTEXPR20 DualQuaternion
+   fromAffine3x4(const Affine3x4& transform) {
+   return fromRotationTranslation(Quaternion::fromMatrix<Policy>(transform.linear()), transform.translation());
+  }
+
+  /**
+   * @brief Composition: the transform that applies otro first, then this.
+   */
+  constexpr DualQuaternion
+   operator*(const DualQuaternion& otro) const {
+   const Quaternion a = real * otro.dual, b = dual * otro.real;
+   return DualQuaternion(real * otro.real, Quaternion(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w));
+  }
+
+  /**
+   * @brief In-place composition.
+   */
+  constexpr DualQuaternion&
+   operator*=(const DualQuaternion& otro) {
+   *this = *this * otro;
+   return *this;
+  }
+
+  /**
+   * @brief Compares two dual quaternions for equality.
+   */
+  constexpr bool
+   operator==(const DualQuaternion& otro) const {
+   return real == otro.real && dual == otro.dual;
+  }
+
+  /**
+   * @brief Compares two dual quaternions for inequality.
+   */
+  constexpr bool
+   operator!=(const DualQuaternion& otro) const {
+   return !(*this == otro);
+  }
+
+  /**
+   * @brief Component-wise comparison within epsilon; q and -q are not equal here.
+   */
+  constexpr bool
+   approxEqual(const DualQuaternion& otro, float epsilon = EU::Constants::EPSILON) const {
+   return real.approxEqual(otro.real, epsilon) && dual.approxEqual(otro.dual, epsilon);
+  }
+
+  /**
+   * @brief Scales both parts so real is unit length, then removes the part of dual along
+   * real, so the result is an exact rigid transform. A zero real part is left unchanged.
+   */
+  template<typename Policy = EU::Precision::Default>
+  EU_CONSTEXPR20 void
+   normalize() {
+   const float lenSq = real.dot(real);
+   if (lenSq == 0.f) return;
+   const float inv = Policy::invLength(lenSq);
+   real = Quaternion(real.x * inv, real.y * inv, real.z * inv, real.w * inv);
+   const float d = real.dot(dual) * inv;
+   dual = Quaternion(dual.x * inv - real.x * d, dual.y * inv - real.y * d,
+                     dual.z * inv - real.z * d, dual.w * inv - real.w * d);
+  }
+
+  /**
+   * @brief Returns a normalized copy; see normalize().
+   */
+  template<typename Policy = EU::Precision::Default>
+  EU_CONSTEXPR20 DualQuaternion
+   normalized() const {
+   DualQuaternion r = *this;
+   r.normalize<Policy>();
+   return r;
+  }
+
+  /**
+   * @brief Quaternion conjugate of both parts, the inverse of a unit dual quaternion.
+   */
+  constexpr DualQuaternion
+   conjugate() const {
+   return DualQuaternion(Quaternion(-real.x, -real.y, -real.z, real.w), Quaternion(-dual.x, -dual.y, -dual.z, dual.w));
+  }
+
+  /**
+   * @brief Inverse transform; identity fallback when real is zero, as Quaternion::inverse().
+   */
+  constexpr DualQuaternion
+   inverse() const {
+   const Quaternion ri = real.inverse();
+   const Quaternion di = ri * dual * ri;
+   return DualQuaternion(ri, Quaternion(-di.x, -di.y, -di.z, -di.w));
+  }
+
+  /**
+   * @brief Rotation part (unit length for a unit dual quaternion).
+   */
+  constexpr Quaternion
+   rotation() const {
+   return real;
+  }
+
+  /**
+   * @brief Translation 2 * dual * conjugate(real), for a unit dual quaternion.
+   */
+  constexpr CVector3
+   translation() const {
+   return CVector3(2.f * (real.w * dual.x - dual.w * real.x + (real.y * dual.z - real.z * dual.y)),
+                   2.f * (real.w * dual.y - dual.w * real.y + (real.z * dual.x - real.x * dual.z)),
+                   2.f * (real.w * dual.z - dual.w * real.z + (real.x * dual.y - real.y * dual.x)));
+  }
+
+  /**
+   * @brief Rotates, then translates p; for a unit dual quaternion.
+   */
+  constexpr CVector3
+   transformPoint(const CVector3& p) const {
+   return real.rotateUnit(p) + translation();
+  }
+
+  /**
+   * @brief Rotates a direction or normal; the translation does not apply.
+   */
+  constexpr CVector3
+   transformVector(const CVector3& v) const {
+   return real.rotateUnit(v);
+  }
+
+  /**
+   * @brief The same transform as an Affine3x4.
+   */
+  constexpr Affine3x4
+   toAffine3x4() const {
+   const Matrix3x3 r = real.toMatrix3();
+   const CVector3 t = translation();
+   return Affine3x4(r.m[0][0], r.m[0][1], r.m[0][2], t.x,
+                    r.m[1][0], r.m[1][1], r.m[1][2], t.y,
+                    r.m[2][0], r.m[2][1], r.m[2][2], t.z);
+  }
+
+  /**
+   * @brief Returns the identity transform.
+   */
+  static constexpr DualQuaternion identity() {
+   return DualQuaternion();
+  }
+ };
+
+ static_assert(sizeof(DualQuaternion) == 8 * sizeof(float), "two quaternions, no padding");
+ EU_ASSERT_VALUE_TYPE(DualQuaternion);
+}
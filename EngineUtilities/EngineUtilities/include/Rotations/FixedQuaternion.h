@@ -0,0 +1,165 @@
+#pragma once
+
+#include <Math/Fixed.h>
+#include <Vectors/FixedVector.h>
+#include <Rotations/Quaternion.h>
+
+namespace EU {
+
+ /**
+  * @class FixedQuaternion
+  * @brief Q16.16 counterpart of Quaternion for deterministic lockstep simulation.
+  *
+  * Same component layout and multiplication order as Quaternion, with table-driven
+  * fromAxisAngle() and integer normalization.
+  */
+ class
+  FixedQuaternion {
+  public:
+  Fixed x; ///< X component
+  Fixed y; ///< Y component
+  Fixed z; ///< Z component
+  Fixed w; ///< W component (real part)
+
+  /**
+   * @brief Default constructor. Initializes to identity quaternion (no rotation).
+   */
+  constexpr FixedQuaternion() : x(), y(), z(), w(Fixed::one()) {}
+
+  /**
+   * @brief Constructs a quaternion with specified components.
+   */
+  constexpr FixedQuaternion(Fixed x, Fixed y, Fixed z, Fixed w)
+   : x(x), y(y), z(z), w(w) {
+  }
+
+  /**
+   * @brief Converts a float quaternion, rounding each component to the nearest step.
+   */
+  constexpr explicit FixedQuaternion(const Quaternion& q)
+   : x(q.x), y(q.y), z(q.z), w(q.w) {
+  }
+
+  /** @brief Converts back to a float quaternion. */
+  constexpr Quaternion
+   toFloat() const {
+   return Quaternion(x.toFloat(), y.toFloat(), z.toFloat(), w.toFloat());
+  }
+
+  /**
+   * @brief Multiplies this quaternion with another (same order as Quaternion::operator*).
+   */
+  constexpr FixedQuaternion
+   operator*(const FixedQuaternion& otro) const {
+   return FixedQuaternion(
+   w * otro.x + x * otro.w + y * otro.z - z * otro.y,
+   w * otro.y - x * otro.z + y * otro.w + z * otro.x,
+   w * otro.z + x * otro.y - y * otro.x + z * otro.w,
+   w * otro.w - x * otro.x - y * otro.y - z * otro.z
+   );
+  }
+
+  /**
+   * @brief In-place multiplication of this quaternion with another.
+   */
+  constexpr FixedQuaternion&
+   operator*=(const FixedQuaternion& otro) {
+   *this = *this * otro;
+   return *this;
+  }
+
+  constexpr bool
+   operator==(const FixedQuaternion& otro) const {
+   return x == otro.x && y == otro.y && z == otro.z && w == otro.w;
+  }
+
+  constexpr bool
+   operator!=(const FixedQuaternion& otro) const {
+   return !(*this == otro);
+  }
+
+  /**
+   * @brief Exact magnitude (floor of the true value).
+   */
+  constexpr Fixed
+   length() const {
+   return detail::fixedLength(detail::rawSquare(x) + detail::rawSquare(y) +
+                              detail::rawSquare(z) + detail::rawSquare(w));
+  }
+
+  /**
+   * @brief Returns a normalized copy, identity for the zero quaternion.
+   */
+  constexpr FixedQuaternion
+   normalized() const {
+   Fixed len = length();
+   if (len.raw == 0) return FixedQuaternion();
+   return FixedQuaternion(x / len, y / len, z / len, w / len);
+  }
+
+  /**
+   * @brief Normalizes this quaternion in-place.
+   */
+  constexpr void
+   normalize() {
+   *this = normalized();
+  }
+
+  /**
+   * @brief Conjugate, the inverse of a unit quaternion.
+   */
+  constexpr FixedQuaternion
+   conjugate() const {
+   return FixedQuaternion(-x, -y, -z, w);
+  }
+
+  /**
+   * @brief Creates a quaternion from a unit axis and an angle in radians.
+   */
+  static constexpr FixedQuaternion
+   fromAxisAngle(const FixedVector3& axis, Fixed angle) {
+   Fixed half = Fixed::fromRaw(angle.raw / 2);
+   Fixed s, c;
+   EngineMath::sincos(half, &s, &c);
+   return FixedQuaternion(axis.x * s, axis.y * s, axis.z * s, c);
+  }
+
+  /**
+   * @brief Rotates a vector by this unit quaternion.
+   *
+   * Uses v + w * t + q.xyz x t with t = 2 * (q.xyz x v), which needs fewer roundings than
+   * q * v * conjugate(q).
+   */
+  constexpr FixedVector3
+   rotate(const FixedVector3& v) const {
+   FixedVector3 u(x, y, z);
+   FixedVector3 t = u.cross(v);
+   t = t + t;
+   return v + t * w + u.cross(t);
+  }
+
+  /**
+   * @brief Normalized linear interpolation with t clamped to [0, 1].
+   */
+  static constexpr FixedQuaternion
+   lerp(const FixedQuaternion& a, const FixedQuaternion& b, Fixed t) {
+   if (t < Fixed::zero()) t = Fixed::zero();
+   if (t > Fixed::one()) t = Fixed::one();
+   return FixedQuaternion(
+    EngineMath::lerp(a.x, b.x, t),
+    EngineMath::lerp(a.y, b.y, t),
+    EngineMath::lerp(a.z, b.z, t),
+    EngineMath::lerp(a.w, b.w, t)
+    ).normalized();
+  }
+
+  /**
+   * @brief Returns the identity quaternion (no rotation).
+   */
+  static constexpr FixedQuaternion identity() {
+   return FixedQuaternion();
+  }
+ };
+
+ EU_ASSERT_VALUE_TYPE(FixedQuaternion);
+}
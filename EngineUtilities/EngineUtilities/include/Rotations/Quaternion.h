@@ -1,18 +1,68 @@
 #pragma once
 
 //#include "../Prerequisites.h"
+#include <cstddef>
+#include <Core/SIMD.h>
 #include <Vectors/Vector3.h>
 #include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Precision.h>
+#include <Matrices/Matrix3x3.h>
+#include <Matrices/Matrix4x4.h>
 using namespace EngineMath;
 
 namespace EU {
 
+ /**
+  * @brief Order in which Euler angles are applied, first axis first.
+  *
+  * XYZ rotates about X, then Y, then Z, all fixed (world) axes, so its matrix is Rz Ry Rx;
+  * read backwards it is the intrinsic (body-axis) order Z, Y', X''. The angles themselves are
+  * always passed as a CVector3 of radians about X, Y and Z, whatever the order.
+  */
+ enum class EulerOrder {
+  XYZ,
+  XZY,
+  YXZ,
+  YZX,
+  ZXY,
+  ZYX
+ };
+
+ namespace detail {
+  /// fromToRotation() treats directions as opposite when 1 + cos(angle) is below this (within 0.08 degrees),
+  /// a few float epsilons above the rounding of |from| |to| + from . to.
+  constexpr float FROM_TO_OPPOSITE = 1e-6f;
+  /// Length of the vector part below which exp() uses the series of sin(s) / s.
+  constexpr float QUATERNION_SERIES_ANGLE = 1e-4f;
+
+  /** Axes i, j, k of order, first applied first, and whether (i, j, k) is an odd permutation of XYZ. */
+  constexpr void
+   eulerAxes(EulerOrder order, int& i, int& j, int& k, bool& odd) {
+   switch (order) {
+   case EulerOrder::XYZ: i = 0; j = 1; k = 2; odd = false; break;
+   case EulerOrder::YZX: i = 1; j = 2; k = 0; odd = false; break;
+   case EulerOrder::ZXY: i = 2; j = 0; k = 1; odd = false; break;
+   case EulerOrder::XZY: i = 0; j = 2; k = 1; odd = true; break;
+   case EulerOrder::YXZ: i = 1; j = 0; k = 2; odd = true; break;
+   default: i = 2; j = 1; k = 0; odd = true; break;
+   }
+  }
+ }
+
  /**
   * @class Quaternion
   * @brief Represents a quaternion used for 3D rotations and orientation.
   *
   * Supports quaternion multiplication, normalization, inversion, vector rotation,
-  * construction from axis-angle, and linear interpolation.
+  * construction from axis-angle or Euler angles, and linear interpolation.
+  *
+  * toMatrix3()/toMatrix4() and fromMatrix() convert to and from rotation matrices (row-major,
+  * column vectors). fromMatrix() is Shepperd's method with the four-way pivot reduced to
+  * selects: every candidate is a scaled copy of the quaternion, the one with the largest
+  * pivot is kept and normalized once. A pure sign-selected form (each component from its own
+  * diagonal term, signs from the off-diagonal differences) would avoid even that, but loses
+  * the relative signs of half-turn rotations, where every difference is zero.
   */
  class 
   Quaternion {
@@ -25,7 +75,12 @@ namespace EU {
   /**
    * @brief Default constructor. Initializes to identity quaternion (no rotation).
    */
-  Quaternion() : x(0.f), y(0.f), z(0.f), w(1.f) {}
+  constexpr Quaternion() : x(0.f), y(0.f), z(0.f), w(1.f) {}
+
+  /**
+   * @brief Leaves every component uninitialized; see EU::NoInit.
+   */
+  explicit Quaternion(EU::NoInitTag) {}
 
   /**
    * @brief Constructs a quaternion with specified components.
@@ -34,16 +89,19 @@ namespace EU {
    * @param z Z component
    * @param w W component
    */
-  Quaternion(float x, float y, float z, float w)
+  constexpr Quaternion(float x, float y, float z, float w)
    : x(x), y(y), z(z), w(w) {
   }
 
   /**
    * @brief Multiplies this quaternion with another.
+   *
+   * Each component is evaluated left to right as written, which EU_REPRODUCIBLE builds
+   * rely on for bit-identical results.
    * @param otro The other quaternion.
    * @return Resulting quaternion.
    */
-  Quaternion 
+  constexpr Quaternion
    operator*(const Quaternion& otro) const {
    return Quaternion(
    w * otro.x + x * otro.w + y * otro.z - z * otro.y,
@@ -58,7 +116,7 @@ namespace EU {
    * @param otro The other quaternion.
    * @return Reference to this quaternion after multiplication.
    */
-  Quaternion& 
+  constexpr Quaternion&
    operator*=(const Quaternion& otro) {
    *this = *this * otro;
    return *this;
@@ -67,7 +125,7 @@ namespace EU {
   /**
    * @brief Compares two quaternions for equality.
    */
-  bool 
+  constexpr bool
    operator==(const Quaternion& otro) const {
    return x == otro.x && y == otro.y && z == otro.z && w == otro.w;
   }
@@ -75,48 +133,101 @@ namespace EU {
   /**
    * @brief Compares two quaternions for inequality.
    */
-  bool 
+  constexpr bool
    operator!=(const Quaternion& otro) const {
    return !(*this == otro);
   }
 
+  /**
+   * @brief Component-wise comparison within epsilon.
+   *
+   * q and -q are the same rotation but do not compare equal here, as with operator==.
+   */
+  constexpr bool
+   approxEqual(const Quaternion& otro, float epsilon = EU::Constants::EPSILON) const {
+   return EngineMath::approxEqual(x, otro.x, epsilon) && EngineMath::approxEqual(y, otro.y, epsilon)
+       && EngineMath::approxEqual(z, otro.z, epsilon) && EngineMath::approxEqual(w, otro.w, epsilon);
+  }
+
   /**
    * @brief Computes the magnitude (length) of the quaternion.
    */
-  float 
+  template<typename Policy = EU::Precision::Default>
+  EU_CONSTEXPR20 float
    length() const {
-   return sqrt(x * x + y * y + z * z + w * w);
+   return Policy::sqrt(Policy::madd(x, x, Policy::madd(y, y, Policy::madd(z, z, w * w))));
   }
 
   /**
    * @brief Normalizes this quaternion in-place.
    */
-  void 
+  template<typename Policy = EU::Precision::Default>
+  EU_CONSTEXPR20 void
    normalize() {
-   float len = length();
-   if (len == 0.f) return;
-   x /= len;
-   y /= len;
-   z /= len;
-   w /= len;
+   if (x == 0.f && y == 0.f && z == 0.f && w == 0.f) return;
+   *this = normalized<Policy>();
   }
 
   /**
    * @brief Returns a normalized copy of this quaternion.
    * @return Normalized quaternion.
    */
-  Quaternion 
+  template<typename Policy = EU::Precision::Default>
+  EU_CONSTEXPR20 Quaternion
    normalized() const {
-   float len = length();
-   if (len == 0.f) return Quaternion(0.f, 0.f, 0.f, 1.f);
-   return Quaternion(x / len, y / len, z / len, w / len);
+   float lenSq = x * x + y * y + z * z + w * w;
+   if (!EU::Precision::normalizable(lenSq)) {
+    // Zero, or squares that underflow or overflow: scale by the largest component first.
+    const float m = EU::Precision::largestMagnitude(x, y, z, w);
+    if (m == 0.f) return Quaternion(0.f, 0.f, 0.f, 1.f);
+    const float sx = x / m, sy = y / m, sz = z / m, sw = w / m;
+    float inv = Policy::invLength(sx * sx + sy * sy + sz * sz + sw * sw);
+    return Quaternion(sx * inv, sy * inv, sz * inv, sw * inv);
+   }
+   float inv = Policy::invLength(lenSq);
+   return Quaternion(x * inv, y * inv, z * inv, w * inv);
+  }
+
+  /**
+   * @brief First-order renormalization q * (1.5 - 0.5 |q|^2), in place: no square root or
+   * division.
+   *
+   * One Newton step of 1 / sqrt(|q|^2) from 1, so only for quaternions that are already
+   * nearly unit, such as the result of a few products: a squared length of 1 + e comes out
+   * within 0.75 e^2 of 1 (float precision below |e| = 4e-4). Use normalize() for arbitrary
+   * lengths.
+   */
+  constexpr void
+   renormalize() {
+   const float k = 1.5f - 0.5f * (x * x + y * y + z * z + w * w);
+   x *= k;
+   y *= k;
+   z *= k;
+   w *= k;
+  }
+
+  /**
+   * @brief Returns a renormalize()d copy of this quaternion.
+   */
+  constexpr Quaternion
+   renormalized() const {
+   const float k = 1.5f - 0.5f * (x * x + y * y + z * z + w * w);
+   return Quaternion(x * k, y * k, z * k, w * k);
+  }
+
+  /**
+   * @brief Distance of the squared length from 1, the drift accumulateRotation() tracks.
+   */
+  constexpr float
+   drift() const {
+   return EngineMath::fabs(x * x + y * y + z * z + w * w - 1.f);
   }
 
   /**
    * @brief Returns the inverse of this quaternion.
    * @return Inverted quaternion.
    */
-  Quaternion 
+  constexpr Quaternion
    inverse() const {
    float lenSq = x * x + y * y + z * z + w * w;
    if (lenSq == 0.f) return Quaternion(); // Identity fallback
@@ -129,24 +240,199 @@ namespace EU {
    * @param angle The rotation angle in radians.
    * @return Resulting quaternion.
    */
-  static Quaternion
+  static constexpr Quaternion
    fromAxisAngle(const CVector3& axis, float angle) {
    float halfAngle = angle * 0.5f;
-   float s = sin(halfAngle);
-   float c = cos(halfAngle);
+   float s = 0.f, c = 0.f;
+   EngineMath::sincos(halfAngle, &s, &c);
    return Quaternion(axis.x * s, axis.y * s, axis.z * s, c);
   }
 
+  /**
+   * @brief Rotation by the Euler angles (radians about X, Y and Z) applied in order.
+   *
+   * Three sincos() calls and the closed-form product of the three axis rotations, instead of
+   * three fromAxisAngle() calls and two products. An odd order is the even product with the
+   * middle angle and the middle component negated, so every order shares one formula.
+   */
+  static constexpr Quaternion
+   fromEuler(const CVector3& angles, EulerOrder order = EulerOrder::XYZ) {
+   int i = 0, j = 1, k = 2;
+   bool odd = false;
+   detail::eulerAxes(order, i, j, k, odd);
+   const float a[3] = { angles.x * 0.5f, angles.y * 0.5f, angles.z * 0.5f };
+   float si = 0.f, ci = 0.f, sj = 0.f, cj = 0.f, sk = 0.f, ck = 0.f;
+   EngineMath::sincos(a[i], &si, &ci);
+   EngineMath::sincos(odd ? -a[j] : a[j], &sj, &cj);
+   EngineMath::sincos(a[k], &sk, &ck);
+   float r[3] = { 0.f, 0.f, 0.f };
+   r[i] = si * cj * ck - ci * sj * sk;
+   r[j] = ci * sj * ck + si * cj * sk;
+   r[k] = ci * cj * sk - si * sj * ck;
+   if (odd) r[j] = -r[j];
+   return Quaternion(r[0], r[1], r[2], ci * cj * ck + si * sj * sk);
+  }
+
+  /**
+   * @brief Euler angles (radians about X, Y and Z) that fromEuler() turns back into this unit
+   * quaternion's rotation.
+   *
+   * The first and last angles lie in [-PI, PI], the middle one in [-PI/2, PI/2]. The first
+   * comes from two matrix entries, the middle from an atan2 against their common cosine, and
+   * the last from entries with the first rotation taken out (Day's method), so the result
+   * stays exact near gimbal lock: there the first angle is arbitrary (0 at the lock itself)
+   * and the last carries the remaining twist.
+   */
+  EU_CONSTEXPR20 CVector3
+   toEuler(EulerOrder order = EulerOrder::XYZ) const {
+   int i = 0, j = 1, k = 2;
+   bool odd = false;
+   detail::eulerAxes(order, i, j, k, odd);
+   const float c[3] = { x, y, z };
+   const float qi = c[i], qj = odd ? -c[j] : c[j], qk = c[k];
+   const float r00 = 1.f - 2.f * (qj * qj + qk * qk), r01 = 2.f * (qi * qj - w * qk), r02 = 2.f * (qi * qk + w * qj);
+   const float r10 = 2.f * (qi * qj + w * qk), r11 = 1.f - 2.f * (qi * qi + qk * qk), r12 = 2.f * (qj * qk - w * qi);
+   const float r20 = 2.f * (qi * qk - w * qj), r21 = 2.f * (qj * qk + w * qi), r22 = 1.f - 2.f * (qi * qi + qj * qj);
+   const float lenSq = r21 * r21 + r22 * r22;
+   const float inv = lenSq > 0.f ? 1.f / EngineMath::sqrtHardware(lenSq) : 0.f;
+   const float s1 = r21 * inv, c1 = lenSq > 0.f ? r22 * inv : 1.f;
+   float a[3] = { 0.f, 0.f, 0.f };
+   a[i] = EngineMath::atan2(r21, r22);
+   a[j] = EngineMath::atan2(-r20, EngineMath::sqrtHardware(r00 * r00 + r10 * r10));
+   a[k] = EngineMath::atan2(r02 * s1 - r01 * c1, r11 * c1 - r12 * s1);
+   if (odd) a[j] = -a[j];
+   return CVector3(a[0], a[1], a[2]);
+  }
+
+  /**
+   * @brief Shortest rotation taking the direction of from onto the direction of to.
+   *
+   * The half-vector form (from x to, |from| |to| + from . to) normalized: one sqrt and one
+   * rsqrt, no trigonometry. Lengths need not be 1. Opposite directions turn half a turn about
+   * an axis perpendicular to from; a zero input gives the identity.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static EU_CONSTEXPR20 Quaternion
+   fromToRotation(const CVector3& from, const CVector3& to) {
+   const float lengths = Policy::sqrt(from.lengthSquared() * to.lengthSquared());
+   if (lengths == 0.f) return Quaternion();
+   const float w = lengths + from.dot(to);
+   if (w <= detail::FROM_TO_OPPOSITE * lengths) {
+    const Quaternion q = EngineMath::fabs(from.x) > EngineMath::fabs(from.z) ? Quaternion(-from.y, from.x, 0.f, 0.f)
+                                                                             : Quaternion(0.f, -from.z, from.y, 0.f);
+    return q.normalized<Policy>();
+   }
+   const CVector3 c = from.cross(to);
+   return Quaternion(c.x, c.y, c.z, w).normalized<Policy>();
+  }
+
+  /**
+   * @brief Orientation looking along forward with up as close to up as possible, in the
+   * right-handed camera convention of lookAt(): local -Z maps to forward and local +Y to the
+   * projected up. This is the rotation of the inverse lookAt() view matrix.
+   *
+   * Trig-free (two cross products and fromMatrix()). When up is parallel to forward the
+   * result is fromToRotation(-Z, forward); a zero forward gives the identity.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static EU_CONSTEXPR20 Quaternion
+   lookRotation(const CVector3& forward, const CVector3& up = CVector3(0.f, 1.f, 0.f)) {
+   const CVector3 f = forward.normalized<Policy>();
+   const CVector3 s = f.cross(up).normalized<Policy>();
+   if (s.lengthSquared() == 0.f) {
+    return f.lengthSquared() == 0.f ? Quaternion() : fromToRotation<Policy>(CVector3(0.f, 0.f, -1.f), f);
+   }
+   const CVector3 u = s.cross(f);
+   return fromMatrix<Policy>(Matrix3x3(s.x, u.x, -f.x,
+                                       s.y, u.y, -f.y,
+                                       s.z, u.z, -f.z));
+  }
+
+  /**
+   * @brief Rotation matrix of this quaternion, which need not be unit length (it is divided
+   * out). Same arithmetic as the 3x3 block of Affine3x4::fromTRS().
+   */
+  constexpr Matrix3x3
+   toMatrix3() const {
+   const float lenSq = x * x + y * y + z * z + w * w;
+   const float s = lenSq == 0.f ? 0.f : 2.f / lenSq;
+   const float xx = x * x * s, yy = y * y * s, zz = z * z * s;
+   const float xy = x * y * s, xz = x * z * s, yz = y * z * s;
+   const float wx = w * x * s, wy = w * y * s, wz = w * z * s;
+   return Matrix3x3(1.f - (yy + zz), xy - wz, xz + wy,
+                    xy + wz, 1.f - (xx + zz), yz - wx,
+                    xz - wy, yz + wx, 1.f - (xx + yy));
+  }
+
+  /**
+   * @brief toMatrix3() as a Matrix4x4 with no translation.
+   */
+  constexpr Matrix4x4
+   toMatrix4() const {
+   const Matrix3x3 r = toMatrix3();
+   return Matrix4x4(r.m[0][0], r.m[0][1], r.m[0][2], 0.f,
+                    r.m[1][0], r.m[1][1], r.m[1][2], 0.f,
+                    r.m[2][0], r.m[2][1], r.m[2][2], 0.f,
+                    0.f, 0.f, 0.f, 1.f);
+  }
+
+  /**
+   * @brief Unit quaternion of the rotation matrix r (pivot-selected Shepperd, see above).
+   * Scale in r is not separated out; use decompose() or polarDecompose() for that.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static EU_CONSTEXPR20 Quaternion
+   fromMatrix(const Matrix3x3& matrix) {
+   const float (&r)[3][3] = matrix.m;
+   const float tw = 1.f + r[0][0] + r[1][1] + r[2][2];
+   const float tx = 1.f + r[0][0] - r[1][1] - r[2][2];
+   const float ty = 1.f - r[0][0] + r[1][1] - r[2][2];
+   const float tz = 1.f - r[0][0] - r[1][1] + r[2][2];
+   const float sxy = r[0][1] + r[1][0], sxz = r[0][2] + r[2][0], syz = r[1][2] + r[2][1];
+   const float dx = r[2][1] - r[1][2], dy = r[0][2] - r[2][0], dz = r[1][0] - r[0][1];
+   Quaternion q(dx, dy, dz, tw);
+   float best = tw;
+   const bool px = tx > best;
+   q = px ? Quaternion(tx, sxy, sxz, dx) : q;
+   best = px ? tx : best;
+   const bool py = ty > best;
+   q = py ? Quaternion(sxy, ty, syz, dy) : q;
+   best = py ? ty : best;
+   q = tz > best ? Quaternion(sxz, syz, tz, dz) : q;
+   return q.normalized<Policy>();
+  }
+
+  /**
+   * @brief fromMatrix() of the upper 3x3 block.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static EU_CONSTEXPR20 Quaternion
+   fromMatrix(const Matrix4x4& matrix) {
+   return fromMatrix<Policy>(matrix.linear());
+  }
+
   /**
    * @brief Rotates a 3D vector using this quaternion.
+   *
+   * Same result as q v q^-1 without building the inverse: with t = (2 / |q|^2) (q x v), the
+   * rotated vector is v + w t + q x t. A zero quaternion gives the zero vector.
    * @param v Vector to rotate.
    * @return Rotated vector.
    */
-  CVector3
+  constexpr CVector3
    rotate(const CVector3& v) const {
-   Quaternion qv(v.x, v.y, v.z, 0.f);
-   Quaternion result = (*this) * qv * inverse();
-   return CVector3(result.x, result.y, result.z);
+   const float lenSq = x * x + y * y + z * z + w * w;
+   if (lenSq == 0.f) return CVector3(0.f, 0.f, 0.f);
+   return rotateScaled(v, 2.f / lenSq);
+  }
+
+  /**
+   * @brief rotate() for a unit quaternion: v + 2w (q x v) + 2 q x (q x v), two cross
+   * products and no division.
+   */
+  constexpr CVector3
+   rotateUnit(const CVector3& v) const {
+   return rotateScaled(v, 2.f);
   }
 
   /**
@@ -156,22 +442,576 @@ namespace EU {
    * @param t Interpolation factor [0, 1].
    * @return Interpolated quaternion (normalized).
    */
-  static Quaternion 
+  template<typename Policy = EU::Precision::Default>
+  static EU_CONSTEXPR20 Quaternion
    lerp(const Quaternion& a, const Quaternion& b, float t) {
-   t = (t < 0.f) ? 0.f : ((t > 1.f) ? 1.f : t);
+   t = EngineMath::clamp(t, 0.f, 1.f);
    return Quaternion(
     a.x + (b.x - a.x) * t,
     a.y + (b.y - a.y) * t,
     a.z + (b.z - a.z) * t,
     a.w + (b.w - a.w) * t
-    ).normalized();
+    ).normalized<Policy>();
+  }
+
+  /**
+   * @brief Four-dimensional dot product, the cosine of half the angle between two rotations.
+   */
+  constexpr float
+   dot(const Quaternion& otro) const {
+   return x * otro.x + y * otro.y + z * otro.z + w * otro.w;
+  }
+
+  /**
+   * @brief Spherical linear interpolation: constant angular velocity along the shorter arc.
+   *
+   * b is negated when dot(a, b) < 0, so the result never takes the long way round. Nearly
+   * parallel inputs (dot > 0.9995) use normalized lerp instead, which agrees to float
+   * precision there and avoids dividing by a vanishing sine. t is not clamped; values
+   * outside [0, 1] extrapolate along the arc. a and b should be unit length.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static EU_CONSTEXPR20 Quaternion
+   slerp(const Quaternion& a, const Quaternion& b, float t) {
+   const float d = a.dot(b);
+   const float sign = d < 0.f ? -1.f : 1.f;
+   float wa = 1.f - t, wb = t;
+   if (d * sign < 0.9995f) {
+    const float theta = EngineMath::acos(d * sign);
+    const float inv = 1.f / EngineMath::sin(theta);
+    wa = EngineMath::sin(wa * theta) * inv;
+    wb = EngineMath::sin(t * theta) * inv;
+   }
+   wb *= sign;
+   return Quaternion(a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb)
+    .normalized<Policy>();
+  }
+
+  /**
+   * @brief Approximate slerp() without trigonometry: nlerp with t reshaped by a cubic whose
+   * coefficients are fitted to the angle between a and b (Kapoulkine's fit).
+   *
+   * Shortest arc and unclamped t as in slerp(). For t in [0, 1] the result is within 8e-4
+   * radians of rotation of slerp() for any pair of unit inputs (plain nlerp is off by up to
+   * 0.14), at the cost of a dozen multiply-adds and one rsqrt.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static EU_CONSTEXPR20 Quaternion
+   slerpFast(const Quaternion& a, const Quaternion& b, float t) {
+   const float d = a.dot(b);
+   const float sign = d < 0.f ? -1.f : 1.f;
+   const float ad = d * sign;
+   const float ka = 1.0904f + ad * (-3.2452f + ad * (3.55645f - ad * 1.43519f));
+   const float kb = 0.848013f + ad * (-1.06021f + ad * 0.215638f);
+   const float h = t - 0.5f;
+   const float u = t + t * h * (t - 1.f) * (ka * h * h + kb);
+   const float wa = 1.f - u, wb = u * sign;
+   return Quaternion(a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb)
+    .normalized<Policy>();
+  }
+
+  /**
+   * @brief Quaternion exponential e^w (cos s, sin s v / s) of this = (v, w), s = |v|.
+   *
+   * The inverse of log(). For a pure quaternion (axis * half angle, 0) it is the unit
+   * rotation by that angle about axis, which is how rotation vectors are rebuilt. Polynomial
+   * sincos and exp, no <cmath>; below detail::QUATERNION_SERIES_ANGLE sin(s) / s is its series.
+   */
+  EU_CONSTEXPR20 Quaternion
+   exp() const {
+   const float s = EngineMath::sqrtHardware(x * x + y * y + z * z);
+   float sn = 0.f, c = 1.f;
+   EngineMath::sincos(s, &sn, &c);
+   const float scale = EngineMath::exp(w);
+   const float k = scale * (s < detail::QUATERNION_SERIES_ANGLE ? 1.f - s * s * (1.f / 6.f) : sn / s);
+   return Quaternion(x * k, y * k, z * k, scale * c);
+  }
+
+  /**
+   * @brief Quaternion logarithm (atan2(s, w) v / s, ln |q|) of this = (v, w), s = |v|.
+   *
+   * For a unit quaternion w is zero (to rounding) and the vector part is axis * half angle,
+   * with the angle in [0, 2 PI]: -q gives the long way round, flip it first when the short
+   * one is wanted. A real quaternion has a zero vector part, including -1, whose axis is
+   * arbitrary; the zero quaternion gets w = Constants::NEG_INF, as EngineMath::log().
+   */
+  EU_CONSTEXPR20 Quaternion
+   log() const {
+   const float sSq = x * x + y * y + z * z;
+   const float s = EngineMath::sqrtHardware(sSq);
+   const float k = s > 0.f ? EngineMath::atan2(s, w) / s : 0.f;
+   return Quaternion(x * k, y * k, z * k, 0.5f * EngineMath::log(sSq + w * w));
+  }
+
+  /**
+   * @brief exp(t * log()): for a unit quaternion the same axis with t times the angle.
+   *
+   * t = 0 gives the identity and t = 1 the quaternion itself. As with log(), the angle is
+   * measured from q as given, so negate a quaternion with w < 0 first to scale the shorter arc.
+   */
+  EU_CONSTEXPR20 Quaternion
+   pow(float t) const {
+   const Quaternion l = log();
+   return Quaternion(l.x * t, l.y * t, l.z * t, l.w * t).exp();
   }
 
   /**
    * @brief Returns the identity quaternion (no rotation).
    */
-  static Quaternion identity() {
+  static constexpr Quaternion identity() {
    return Quaternion(0.f, 0.f, 0.f, 1.f);
   }
+
+  private:
+  /** v + w t + q x t with t = scale (q x v). */
+  constexpr CVector3
+   rotateScaled(const CVector3& v, float scale) const {
+   const float tx = (y * v.z - z * v.y) * scale;
+   const float ty = (z * v.x - x * v.z) * scale;
+   const float tz = (x * v.y - y * v.x) * scale;
+   return CVector3(v.x + w * tx + (y * tz - z * ty),
+                   v.y + w * ty + (z * tx - x * tz),
+                   v.z + w * tz + (x * ty - y * tx));
+  }
  };
+
+ EU_ASSERT_VALUE_TYPE(Quaternion);
+
+ /// Bound on the drift() one product of unit quaternions adds: 4 float epsilons (2.4 measured).
+ constexpr float QUATERNION_PRODUCT_DRIFT = 4.f * 1.1920929e-7f;
+ /// Default limit of accumulateRotation(); renormalizing at it leaves a drift of 7.5e-7.
+ constexpr float QUATERNION_DRIFT_LIMIT = 1e-3f;
+ /// Largest drift accumulateRotation() corrects with renormalize() (leaving 7.5e-3 at most).
+ constexpr float QUATERNION_RENORMALIZE_RANGE = 0.1f;
+
+ /**
+  * @brief q = delta * q, renormalized only once the accumulated drift passes limit.
+  *
+  * drift carries a bound on q.drift() between calls: each call adds delta.drift() (four
+  * multiply-adds) and QUATERNION_PRODUCT_DRIFT, and when the sum passes limit, q is
+  * renormalize()d and drift reset to what is left. Starting from a unit q and drift 0, a
+  * chain of unit deltas renormalizes about once every 2000 products with the default limit
+  * and q never drifts further than limit. limit 0 renormalizes on every call. A q that has
+  * drifted past QUATERNION_RENORMALIZE_RANGE, the reach of the first-order step, gets a full
+  * normalize() instead.
+  */
+ EU_CONSTEXPR20 void
+  accumulateRotation(Quaternion& q, float& drift, const Quaternion& delta, float limit = QUATERNION_DRIFT_LIMIT) {
+  q = delta * q;
+  drift += delta.drift() + QUATERNION_PRODUCT_DRIFT;
+  if (drift > limit) {
+   if (q.drift() < QUATERNION_RENORMALIZE_RANGE) q.renormalize();
+   else q.normalize<EU::Precision::Exact>();
+   drift = q.drift();
+  }
+ }
+
+ namespace detail {
+  /**
+   * Quaternion::fromMatrix() across lanes: the pivot candidates are selected per lane in the
+   * same order, then normalized with the policy's lane rsqrt.
+   */
+  template<typename Policy, typename V>
+  inline void
+   rotationToQuaternionLanes(const V (&r)[3][3], V (&q)[4]) {
+   const V one = V::set1(1.f);
+   const V tw = one + r[0][0] + r[1][1] + r[2][2];
+   const V tx = one + r[0][0] - r[1][1] - r[2][2];
+   const V ty = one - r[0][0] + r[1][1] - r[2][2];
+   const V tz = one - r[0][0] - r[1][1] + r[2][2];
+   const V sxy = r[0][1] + r[1][0], sxz = r[0][2] + r[2][0], syz = r[1][2] + r[2][1];
+   const V dx = r[2][1] - r[1][2], dy = r[0][2] - r[2][0], dz = r[1][0] - r[0][1];
+   q[0] = dx;
+   q[1] = dy;
+   q[2] = dz;
+   q[3] = tw;
+   V best = tw;
+   V take = tx > best;
+   q[0] = EU::SIMD::select(take, tx, q[0]);
+   q[1] = EU::SIMD::select(take, sxy, q[1]);
+   q[2] = EU::SIMD::select(take, sxz, q[2]);
+   q[3] = EU::SIMD::select(take, dx, q[3]);
+   best = EU::SIMD::select(take, tx, best);
+   take = ty > best;
+   q[0] = EU::SIMD::select(take, sxy, q[0]);
+   q[1] = EU::SIMD::select(take, ty, q[1]);
+   q[2] = EU::SIMD::select(take, syz, q[2]);
+   q[3] = EU::SIMD::select(take, dy, q[3]);
+   best = EU::SIMD::select(take, ty, best);
+   take = tz > best;
+   q[0] = EU::SIMD::select(take, sxz, q[0]);
+   q[1] = EU::SIMD::select(take, syz, q[1]);
+   q[2] = EU::SIMD::select(take, tz, q[2]);
+   q[3] = EU::SIMD::select(take, dz, q[3]);
+   const V lenSq = Policy::maddLanes(q[3], q[3], Policy::maddLanes(q[2], q[2],
+                                     Policy::maddLanes(q[1], q[1], q[0] * q[0])));
+   const V inv = Policy::invLengthLanes(lenSq);
+   for (int c = 0; c < 4; ++c) q[c] = q[c] * inv;
+  }
+
+  /** Quaternion::fromEuler() across lanes; angles are the full angles about X, Y and Z. */
+  template<typename V>
+  inline void
+   eulerToQuaternionLanes(const V (&angles)[3], EulerOrder order, V (&q)[4]) {
+   int i = 0, j = 1, k = 2;
+   bool odd = false;
+   eulerAxes(order, i, j, k, odd);
+   const V half = V::set1(0.5f);
+   const V aj = angles[j] * half;
+   V si, ci, sj, cj, sk, ck;
+   EngineMath::batch::kernels::sincos(angles[i] * half, si, ci);
+   EngineMath::batch::kernels::sincos(odd ? -aj : aj, sj, cj);
+   EngineMath::batch::kernels::sincos(angles[k] * half, sk, ck);
+   q[i] = si * cj * ck - ci * sj * sk;
+   q[j] = ci * sj * ck + si * cj * sk;
+   q[k] = ci * cj * sk - si * sj * ck;
+   if (odd) q[j] = -q[j];
+   q[3] = ci * cj * ck + si * sj * sk;
+  }
+
+  /** Quaternion::toEuler() across lanes, in the same order of operations. */
+  template<typename V>
+  inline void
+   quaternionToEulerLanes(const V (&q)[4], EulerOrder order, V (&angles)[3]) {
+   int i = 0, j = 1, k = 2;
+   bool odd = false;
+   eulerAxes(order, i, j, k, odd);
+   const V zero = V::zero(), one = V::set1(1.f), two = V::set1(2.f);
+   const V w = q[3], qi = q[i], qj = odd ? -q[j] : q[j], qk = q[k];
+   const V r00 = one - two * (qj * qj + qk * qk), r01 = two * (qi * qj - w * qk), r02 = two * (qi * qk + w * qj);
+   const V r10 = two * (qi * qj + w * qk), r11 = one - two * (qi * qi + qk * qk), r12 = two * (qj * qk - w * qi);
+   const V r20 = two * (qi * qk - w * qj), r21 = two * (qj * qk + w * qi), r22 = one - two * (qi * qi + qj * qj);
+   const V lenSq = r21 * r21 + r22 * r22;
+   const V valid = lenSq > zero;
+   const V inv = (one / EU::SIMD::sqrt(EU::SIMD::select(valid, lenSq, one))) & valid;
+   const V s1 = r21 * inv, c1 = EU::SIMD::select(valid, r22 * inv, one);
+   angles[i] = EngineMath::batch::kernels::atan2(r21, r22);
+   angles[j] = EngineMath::batch::kernels::atan2(-r20, EU::SIMD::sqrt(r00 * r00 + r10 * r10));
+   angles[k] = EngineMath::batch::kernels::atan2(r02 * s1 - r01 * c1, r11 * c1 - r12 * s1);
+   if (odd) angles[j] = -angles[j];
+  }
+
+  /** Quaternion::fromToRotation() across lanes, both branches evaluated and selected. */
+  template<typename Policy, typename V>
+  inline void
+   fromToRotationLanes(const V (&from)[3], const V (&to)[3], V (&q)[4]) {
+   const V zero = V::zero(), one = V::set1(1.f);
+   const V fromSq = from[0] * from[0] + from[1] * from[1] + from[2] * from[2];
+   const V toSq = to[0] * to[0] + to[1] * to[1] + to[2] * to[2];
+   const V lengths = Policy::sqrtLanes(fromSq * toSq);
+   const V w = lengths + (from[0] * to[0] + from[1] * to[1] + from[2] * to[2]);
+   const V opposite = w <= V::set1(FROM_TO_OPPOSITE) * lengths;
+   const V useZ = EU::SIMD::abs(from[0]) > EU::SIMD::abs(from[2]);
+   const V px = EU::SIMD::select(useZ, -from[1], zero);
+   const V py = EU::SIMD::select(useZ, from[0], -from[2]);
+   const V pz = EU::SIMD::select(useZ, zero, from[1]);
+   q[0] = EU::SIMD::select(opposite, px, from[1] * to[2] - from[2] * to[1]);
+   q[1] = EU::SIMD::select(opposite, py, from[2] * to[0] - from[0] * to[2]);
+   q[2] = EU::SIMD::select(opposite, pz, from[0] * to[1] - from[1] * to[0]);
+   q[3] = EU::SIMD::select(opposite, zero, w);
+   const V lenSq = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+   const V valid = (lengths != zero) & (lenSq != zero);
+   const V inv = Policy::invLengthLanes(EU::SIMD::select(valid, lenSq, one));
+   for (int c = 0; c < 3; ++c) q[c] = (q[c] * inv) & valid;
+   q[3] = EU::SIMD::select(valid, q[3] * inv, one);
+  }
+
+  /** Quaternion::exp() across lanes. */
+  template<typename V>
+  inline void
+   quaternionExpLanes(const V (&q)[4], V (&out)[4]) {
+   const V s = EU::SIMD::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2]);
+   V sn, c;
+   EngineMath::batch::kernels::sincos(s, sn, c);
+   const V scale = EngineMath::batch::kernels::exp(q[3]);
+   const V small = s < V::set1(QUATERNION_SERIES_ANGLE);
+   const V one = V::set1(1.f);
+   const V k = scale * EU::SIMD::select(small, one - s * s * V::set1(1.f / 6.f), sn / EU::SIMD::select(small, one, s));
+   for (int e = 0; e < 3; ++e) out[e] = q[e] * k;
+   out[3] = scale * c;
+  }
+
+  /** Quaternion::log() across lanes. */
+  template<typename V>
+  inline void
+   quaternionLogLanes(const V (&q)[4], V (&out)[4]) {
+   const V sSq = q[0] * q[0] + q[1] * q[1] + q[2] * q[2];
+   const V s = EU::SIMD::sqrt(sSq);
+   const V valid = s > V::zero();
+   const V k = (EngineMath::batch::kernels::atan2(s, q[3]) / EU::SIMD::select(valid, s, V::set1(1.f))) & valid;
+   const V lnLength = V::set1(0.5f) * EngineMath::batch::kernels::log(sSq + q[3] * q[3]);
+   for (int e = 0; e < 3; ++e) out[e] = q[e] * k;
+   out[3] = lnLength;
+  }
+
+  /** Runs lanes(q, out) over in[0..n) one register at a time, identity padding past n. */
+  template<typename Lanes>
+  inline void
+   mapQuaternionArray(const Quaternion* in, Quaternion* out, size_t n, Lanes lanes) {
+   using V = EU::SIMD::FloatN;
+   const size_t W = static_cast<size_t>(V::WIDTH);
+   for (size_t i = 0; i < n; i += W) {
+    const size_t count = n - i < W ? n - i : W;
+    float c[4][V::WIDTH];
+    for (size_t k = 0; k < W; ++k) {
+     const Quaternion q = k < count ? in[i + k] : Quaternion();
+     c[0][k] = q.x;
+     c[1][k] = q.y;
+     c[2][k] = q.z;
+     c[3][k] = q.w;
+    }
+    const V q[4] = { V::load(c[0]), V::load(c[1]), V::load(c[2]), V::load(c[3]) };
+    V r[4];
+    lanes(q, r);
+    for (int e = 0; e < 4; ++e) r[e].store(c[e]);
+    for (size_t k = 0; k < count; ++k) out[i + k] = Quaternion(c[0][k], c[1][k], c[2][k], c[3][k]);
+   }
+  }
+
+  /** fromMatrixArray() for anything with a row-major m[3][N] upper block. */
+  template<typename Policy, typename Matrix>
+  inline void
+   fromMatrixArray(const Matrix* in, Quaternion* out, size_t n) {
+   using V = EU::SIMD::FloatN;
+   const size_t W = static_cast<size_t>(V::WIDTH);
+   for (size_t i = 0; i < n; i += W) {
+    const size_t count = n - i < W ? n - i : W;
+    float lanes[9][V::WIDTH];
+    for (size_t k = 0; k < W; ++k)
+     for (int e = 0; e < 9; ++e) lanes[e][k] = k < count ? in[i + k].m[e / 3][e % 3] : (e % 4 == 0 ? 1.f : 0.f);
+    V r[3][3];
+    for (int e = 0; e < 9; ++e) r[e / 3][e % 3] = V::load(lanes[e]);
+    V q[4];
+    rotationToQuaternionLanes<Policy>(r, q);
+    for (int c = 0; c < 4; ++c) q[c].store(lanes[c]);
+    for (size_t k = 0; k < count; ++k) out[i + k] = Quaternion(lanes[0][k], lanes[1][k], lanes[2][k], lanes[3][k]);
+   }
+  }
+
+  /** Quaternion::toMatrix3() of in[i..i + W) into lanes, identity padding past count. */
+  inline void
+   quaternionToMatrixLanes(const Quaternion* in, size_t count, float (&lanes)[9][EU::SIMD::FloatN::WIDTH]) {
+   using V = EU::SIMD::FloatN;
+   float c[4][V::WIDTH];
+   for (size_t k = 0; k < static_cast<size_t>(V::WIDTH); ++k) {
+    const Quaternion q = k < count ? in[k] : Quaternion();
+    c[0][k] = q.x;
+    c[1][k] = q.y;
+    c[2][k] = q.z;
+    c[3][k] = q.w;
+   }
+   const V x = V::load(c[0]), y = V::load(c[1]), z = V::load(c[2]), w = V::load(c[3]);
+   const V zero = V::zero(), one = V::set1(1.f);
+   const V lenSq = x * x + y * y + z * z + w * w;
+   const V valid = lenSq != zero;
+   const V s = (V::set1(2.f) / EU::SIMD::select(valid, lenSq, one)) & valid;
+   const V xx = x * x * s, yy = y * y * s, zz = z * z * s;
+   const V xy = x * y * s, xz = x * z * s, yz = y * z * s;
+   const V wx = w * x * s, wy = w * y * s, wz = w * z * s;
+   const V m[9] = { one - (yy + zz), xy - wz, xz + wy,
+                    xy + wz, one - (xx + zz), yz - wx,
+                    xz - wy, yz + wx, one - (xx + yy) };
+   for (int e = 0; e < 9; ++e) m[e].store(lanes[e]);
+  }
+ }
+
+ /**
+  * @brief out[i] = in[i].toMatrix3(), one register of quaternions per step, bit for bit.
+  */
+ inline void
+  toMatrixArray(const Quaternion* in, Matrix3x3* out, size_t n) {
+  const size_t W = static_cast<size_t>(EU::SIMD::FloatN::WIDTH);
+  for (size_t i = 0; i < n; i += W) {
+   const size_t count = n - i < W ? n - i : W;
+   float lanes[9][EU::SIMD::FloatN::WIDTH];
+   detail::quaternionToMatrixLanes(in + i, count, lanes);
+   for (size_t k = 0; k < count; ++k)
+    for (int e = 0; e < 9; ++e) out[i + k].m[e / 3][e % 3] = lanes[e][k];
+  }
+ }
+
+ /**
+  * @brief out[i] = in[i].toMatrix4(), bit for bit.
+  */
+ inline void
+  toMatrixArray(const Quaternion* in, Matrix4x4* out, size_t n) {
+  const size_t W = static_cast<size_t>(EU::SIMD::FloatN::WIDTH);
+  for (size_t i = 0; i < n; i += W) {
+   const size_t count = n - i < W ? n - i : W;
+   float lanes[9][EU::SIMD::FloatN::WIDTH];
+   detail::quaternionToMatrixLanes(in + i, count, lanes);
+   for (size_t k = 0; k < count; ++k) {
+    Matrix4x4& m = out[i + k];
+    for (int e = 0; e < 9; ++e) m.m[e / 3][e % 3] = lanes[e][k];
+    m.m[0][3] = m.m[1][3] = m.m[2][3] = 0.f;
+    m.m[3][0] = m.m[3][1] = m.m[3][2] = 0.f;
+    m.m[3][3] = 1.f;
+   }
+  }
+ }
+
+ /**
+  * @brief out[i] = Quaternion::fromMatrix(in[i]), one register of matrices per step. The lane
+  * rsqrt agrees with the scalar call to within the policy's precision.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  fromMatrixArray(const Matrix3x3* in, Quaternion* out, size_t n) {
+  detail::fromMatrixArray<Policy>(in, out, n);
+ }
+
+ /** @brief out[i] = Quaternion::fromMatrix(in[i]) of the upper 3x3 blocks. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  fromMatrixArray(const Matrix4x4* in, Quaternion* out, size_t n) {
+  detail::fromMatrixArray<Policy>(in, out, n);
+ }
+ /**
+  * @brief out[i] = Quaternion::fromEuler(angles[i], order), one register of angles per step.
+  * The lane sincos agrees with the scalar one to within its error bound.
+  */
+ inline void
+  fromEulerArray(const CVector3* angles, Quaternion* out, size_t n, EulerOrder order = EulerOrder::XYZ) {
+  using V = EU::SIMD::FloatN;
+  const size_t W = static_cast<size_t>(V::WIDTH);
+  for (size_t i = 0; i < n; i += W) {
+   const size_t count = n - i < W ? n - i : W;
+   float lanes[4][V::WIDTH] = {};
+   for (size_t k = 0; k < count; ++k) {
+    lanes[0][k] = angles[i + k].x;
+    lanes[1][k] = angles[i + k].y;
+    lanes[2][k] = angles[i + k].z;
+   }
+   const V a[3] = { V::load(lanes[0]), V::load(lanes[1]), V::load(lanes[2]) };
+   V q[4];
+   detail::eulerToQuaternionLanes(a, order, q);
+   for (int c = 0; c < 4; ++c) q[c].store(lanes[c]);
+   for (size_t k = 0; k < count; ++k) out[i + k] = Quaternion(lanes[0][k], lanes[1][k], lanes[2][k], lanes[3][k]);
+  }
+ }
+
+ /**
+  * @brief out[i] = in[i].toEuler(order), one register of quaternions per step.
+  */
+ inline void
+  toEulerArray(const Quaternion* in, CVector3* out, size_t n, EulerOrder order = EulerOrder::XYZ) {
+  using V = EU::SIMD::FloatN;
+  const size_t W = static_cast<size_t>(V::WIDTH);
+  for (size_t i = 0; i < n; i += W) {
+   const size_t count = n - i < W ? n - i : W;
+   float lanes[4][V::WIDTH];
+   for (size_t k = 0; k < W; ++k) {
+    const Quaternion q = k < count ? in[i + k] : Quaternion();
+    lanes[0][k] = q.x;
+    lanes[1][k] = q.y;
+    lanes[2][k] = q.z;
+    lanes[3][k] = q.w;
+   }
+   const V q[4] = { V::load(lanes[0]), V::load(lanes[1]), V::load(lanes[2]), V::load(lanes[3]) };
+   V a[3];
+   detail::quaternionToEulerLanes(q, order, a);
+   for (int c = 0; c < 3; ++c) a[c].store(lanes[c]);
+   for (size_t k = 0; k < count; ++k) out[i + k] = CVector3(lanes[0][k], lanes[1][k], lanes[2][k]);
+  }
+ }
+ /**
+  * @brief out[i] = Quaternion::fromToRotation(from[i], to[i]), one register per step.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  fromToRotationArray(const CVector3* from, const CVector3* to, Quaternion* out, size_t n) {
+  using V = EU::SIMD::FloatN;
+  const size_t W = static_cast<size_t>(V::WIDTH);
+  for (size_t i = 0; i < n; i += W) {
+   const size_t count = n - i < W ? n - i : W;
+   float lanes[6][V::WIDTH] = {};
+   for (size_t k = 0; k < count; ++k) {
+    lanes[0][k] = from[i + k].x;
+    lanes[1][k] = from[i + k].y;
+    lanes[2][k] = from[i + k].z;
+    lanes[3][k] = to[i + k].x;
+    lanes[4][k] = to[i + k].y;
+    lanes[5][k] = to[i + k].z;
+   }
+   const V a[3] = { V::load(lanes[0]), V::load(lanes[1]), V::load(lanes[2]) };
+   const V b[3] = { V::load(lanes[3]), V::load(lanes[4]), V::load(lanes[5]) };
+   V q[4];
+   detail::fromToRotationLanes<Policy>(a, b, q);
+   for (int c = 0; c < 4; ++c) q[c].store(lanes[c]);
+   for (size_t k = 0; k < count; ++k) out[i + k] = Quaternion(lanes[0][k], lanes[1][k], lanes[2][k], lanes[3][k]);
+  }
+ }
+
+ /**
+  * @brief out[i] = Quaternion::lookRotation(forward[i], up), e.g. for turrets or billboards
+  * sharing one up vector. Lanes whose forward is parallel to up fall back as in the scalar call.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  lookRotationArray(const CVector3* forward, const CVector3& up, Quaternion* out, size_t n) {
+  using V = EU::SIMD::FloatN;
+  const size_t W = static_cast<size_t>(V::WIDTH);
+  const V zero = V::zero(), one = V::set1(1.f);
+  const V ux = V::set1(up.x), uy = V::set1(up.y), uz = V::set1(up.z);
+  for (size_t i = 0; i < n; i += W) {
+   const size_t count = n - i < W ? n - i : W;
+   float lanes[4][V::WIDTH] = {};
+   for (size_t k = 0; k < count; ++k) {
+    lanes[0][k] = forward[i + k].x;
+    lanes[1][k] = forward[i + k].y;
+    lanes[2][k] = forward[i + k].z;
+   }
+   const V fx0 = V::load(lanes[0]), fy0 = V::load(lanes[1]), fz0 = V::load(lanes[2]);
+   const V fSq = fx0 * fx0 + fy0 * fy0 + fz0 * fz0;
+   const V hasForward = fSq != zero;
+   const V fInv = Policy::invLengthLanes(EU::SIMD::select(hasForward, fSq, one)) & hasForward;
+   const V f[3] = { fx0 * fInv, fy0 * fInv, fz0 * fInv };
+   const V sx0 = f[1] * uz - f[2] * uy, sy0 = f[2] * ux - f[0] * uz, sz0 = f[0] * uy - f[1] * ux;
+   const V sSq = sx0 * sx0 + sy0 * sy0 + sz0 * sz0;
+   const V hasSide = sSq != zero;
+   const V sInv = Policy::invLengthLanes(EU::SIMD::select(hasSide, sSq, one)) & hasSide;
+   const V sx = sx0 * sInv, sy = sy0 * sInv, sz = sz0 * sInv;
+   const V r[3][3] = { { sx, sy * f[2] - sz * f[1], -f[0] },
+                       { sy, sz * f[0] - sx * f[2], -f[1] },
+                       { sz, sx * f[1] - sy * f[0], -f[2] } };
+   V q[4];
+   detail::rotationToQuaternionLanes<Policy>(r, q);
+   const V minusZ[3] = { zero, zero, -one };
+   V fallback[4];
+   detail::fromToRotationLanes<Policy>(minusZ, f, fallback);
+   for (int c = 0; c < 4; ++c) q[c] = EU::SIMD::select(hasSide, q[c], fallback[c]);
+   for (int c = 0; c < 4; ++c) q[c].store(lanes[c]);
+   for (size_t k = 0; k < count; ++k) out[i + k] = Quaternion(lanes[0][k], lanes[1][k], lanes[2][k], lanes[3][k]);
+  }
+ }
+
+ /**
+  * @brief out[i] = in[i].exp(), one register per step; e.g. rotation vectors (axis * half
+  * angle, 0) back to unit quaternions. out may alias in.
+  */
+ inline void
+  expArray(const Quaternion* in, Quaternion* out, size_t n) {
+  using V = EU::SIMD::FloatN;
+  detail::mapQuaternionArray(in, out, n, [](const V (&q)[4], V (&r)[4]) { detail::quaternionExpLanes(q, r); });
+ }
+
+ /** @brief out[i] = in[i].log(), one register per step. out may alias in. */
+ inline void
+  logArray(const Quaternion* in, Quaternion* out, size_t n) {
+  using V = EU::SIMD::FloatN;
+  detail::mapQuaternionArray(in, out, n, [](const V (&q)[4], V (&r)[4]) { detail::quaternionLogLanes(q, r); });
+ }
+
+ /** @brief out[i] = in[i].pow(t), one register per step. out may alias in. */
+ inline void
+  powArray(const Quaternion* in, float t, Quaternion* out, size_t n) {
+  using V = EU::SIMD::FloatN;
+  const V vt = V::set1(t);
+  detail::mapQuaternionArray(in, out, n, [vt](const V (&q)[4], V (&r)[4]) {
+   V l[4];
+   detail::quaternionLogLanes(q, l);
+   for (int e = 0; e < 4; ++e) l[e] = l[e] * vt;
+   detail::quaternionExpLanes(l, r);
+  });
+ }
 }
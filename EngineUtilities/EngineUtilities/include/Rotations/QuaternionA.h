@@ -0,0 +1,286 @@
+#pragma once
+
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Matrices/Matrix3x3.h>
+#include <Matrices/Matrix4x4.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+
+ /**
+  * @class QuaternionA
+  * @brief 16-byte aligned Quaternion whose products run on one SSE/NEON register.
+  *
+  * Same members and API as Quaternion, and converts to and from it implicitly, so it can be
+  * swapped in for hierarchy and IK composition. operator* broadcasts each component of the
+  * left operand, multiplies it by a shuffle of the right one with its signs flipped by a
+  * mask, and accumulates the four products with EU::SIMD::madd. The products are summed in
+  * the same order as Quaternion::operator*, so the two agree bit for bit unless the
+  * multiply-adds are fused (EU_SIMD_FMA without EU_REPRODUCIBLE). dot(), normalize() and lerp()
+  * also stay in the register; dot() sums pairwise and may differ from Quaternion::dot() in the
+  * last bit. Conversions, rotation and slerp forward to Quaternion.
+  */
+ class alignas(16)
+  QuaternionA {
+  public:
+  float x; ///< X component
+  float y; ///< Y component
+  float z; ///< Z component
+  float w; ///< W component (real part)
+
+  /**
+   * @brief Default constructor. Initializes to identity quaternion (no rotation).
+   */
+  constexpr QuaternionA() : x(0.f), y(0.f), z(0.f), w(1.f) {}
+
+  /**
+   * @brief Leaves every component uninitialized; see EU::NoInit.
+   */
+  explicit QuaternionA(EU::NoInitTag) {}
+
+  /**
+   * @brief Constructs a quaternion with specified components.
+   */
+  constexpr QuaternionA(float x, float y, float z, float w)
+   : x(x), y(y), z(z), w(w) {
+  }
+
+  /**
+   * @brief Converts from an unaligned Quaternion.
+   */
+  constexpr QuaternionA(const Quaternion& q)
+   : x(q.x), y(q.y), z(q.z), w(q.w) {
+  }
+
+  /**
+   * @brief Stores a SIMD register (x, y, z, w).
+   */
+  explicit QuaternionA(EU::SIMD::Float4 v) : x(0.f), y(0.f), z(0.f), w(1.f) {
+   v.storeAligned(&x);
+  }
+
+  /**
+   * @brief Converts to an unaligned Quaternion.
+   */
+  constexpr operator Quaternion() const {
+   return Quaternion(x, y, z, w);
+  }
+
+  /**
+   * @brief The components as a SIMD register.
+   */
+  EU::SIMD::Float4
+   simd() const {
+   return EU::SIMD::Float4::loadAligned(&x);
+  }
+
+  /**
+   * @brief Multiplies this quaternion with another: four broadcasts, four shuffles, one
+   * multiply and three multiply-adds.
+   */
+  QuaternionA
+   operator*(const QuaternionA& otro) const {
+   using EU::SIMD::Float4;
+   alignas(16) static const float signX[4] = { 0.f, -0.f, 0.f, -0.f };
+   alignas(16) static const float signY[4] = { 0.f, 0.f, -0.f, -0.f };
+   alignas(16) static const float signZ[4] = { -0.f, 0.f, 0.f, -0.f };
+   const Float4 a = simd(), b = otro.simd();
+   Float4 r = EU::SIMD::shuffle<3, 3, 3, 3>(a) * b;
+   r = EU::SIMD::madd(EU::SIMD::shuffle<0, 0, 0, 0>(a) ^ Float4::loadAligned(signX),
+                      EU::SIMD::shuffle<3, 2, 1, 0>(b), r);
+   r = EU::SIMD::madd(EU::SIMD::shuffle<1, 1, 1, 1>(a) ^ Float4::loadAligned(signY),
+                      EU::SIMD::shuffle<2, 3, 0, 1>(b), r);
+   r = EU::SIMD::madd(EU::SIMD::shuffle<2, 2, 2, 2>(a) ^ Float4::loadAligned(signZ),
+                      EU::SIMD::shuffle<1, 0, 3, 2>(b), r);
+   return QuaternionA(r);
+  }
+
+  /**
+   * @brief In-place multiplication; the product is stored straight from the register.
+   */
+  QuaternionA&
+   operator*=(const QuaternionA& otro) {
+   (*this * otro).simd().storeAligned(&x);
+   return *this;
+  }
+
+  /**
+   * @brief Compares two quaternions for equality.
+   */
+  bool
+   operator==(const QuaternionA& otro) const {
+   return EU::SIMD::movemask(simd() == otro.simd()) == 0xf;
+  }
+
+  /**
+   * @brief Compares two quaternions for inequality.
+   */
+  bool
+   operator!=(const QuaternionA& otro) const {
+   return !(*this == otro);
+  }
+
+  /**
+   * @brief Component-wise comparison within epsilon; one compare per quaternion.
+   */
+  bool
+   approxEqual(const QuaternionA& otro, float epsilon = EU::Constants::EPSILON) const {
+   return EU::SIMD::all(EU::SIMD::approxEqual(simd(), otro.simd(), EU::SIMD::Float4::set1(epsilon)));
+  }
+
+  /**
+   * @brief Computes the magnitude (length) of the quaternion.
+   */
+  template<typename Policy = EU::Precision::Default>
+  float
+   length() const {
+   return Policy::sqrt(dot(*this));
+  }
+
+  /**
+   * @brief Normalizes this quaternion in-place.
+   */
+  template<typename Policy = EU::Precision::Default>
+  void
+   normalize() {
+   const float lenSq = dot(*this);
+   if (!EU::Precision::normalizable(lenSq)) {
+    // Zero, or squares that underflow or overflow: scale by the largest component first.
+    const float m = EU::Precision::largestMagnitude(x, y, z, w);
+    if (m == 0.f) return;
+    (simd() / EU::SIMD::Float4::set1(m)).storeAligned(&x);
+    (simd() * EU::SIMD::Float4::set1(Policy::invLength(dot(*this)))).storeAligned(&x);
+    return;
+   }
+   (simd() * EU::SIMD::Float4::set1(Policy::invLength(lenSq))).storeAligned(&x);
+  }
+
+  /**
+   * @brief Returns a normalized copy of this quaternion (identity for a zero quaternion).
+   */
+  template<typename Policy = EU::Precision::Default>
+  QuaternionA
+   normalized() const {
+   if (x == 0.f && y == 0.f && z == 0.f && w == 0.f) return QuaternionA();
+   QuaternionA q(*this);
+   q.normalize<Policy>();
+   return q;
+  }
+
+  /**
+   * @brief Returns the inverse of this quaternion.
+   */
+  constexpr QuaternionA
+   inverse() const {
+   return Quaternion(*this).inverse();
+  }
+
+  /**
+   * @brief Creates a quaternion from an axis and an angle (in radians).
+   */
+  static constexpr QuaternionA
+   fromAxisAngle(const CVector3& axis, float angle) {
+   return Quaternion::fromAxisAngle(axis, angle);
+  }
+
+  /**
+   * @brief Rotation matrix of this quaternion; see Quaternion::toMatrix3().
+   */
+  constexpr Matrix3x3
+   toMatrix3() const {
+   return Quaternion(*this).toMatrix3();
+  }
+
+  /**
+   * @brief toMatrix3() as a Matrix4x4 with no translation.
+   */
+  constexpr Matrix4x4
+   toMatrix4() const {
+   return Quaternion(*this).toMatrix4();
+  }
+
+  /**
+   * @brief Unit quaternion of the rotation matrix; see Quaternion::fromMatrix().
+   */
+  template<typename Policy = EU::Precision::Default>
+  static EU_CONSTEXPR20 QuaternionA
+   fromMatrix(const Matrix3x3& matrix) {
+   return Quaternion::fromMatrix<Policy>(matrix);
+  }
+
+  /**
+   * @brief fromMatrix() of the upper 3x3 block.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static EU_CONSTEXPR20 QuaternionA
+   fromMatrix(const Matrix4x4& matrix) {
+   return Quaternion::fromMatrix<Policy>(matrix);
+  }
+
+  /**
+   * @brief Rotates a 3D vector; see Quaternion::rotate().
+   */
+  constexpr CVector3
+   rotate(const CVector3& v) const {
+   return Quaternion(*this).rotate(v);
+  }
+
+  /**
+   * @brief rotate() for a unit quaternion; see Quaternion::rotateUnit().
+   */
+  constexpr CVector3
+   rotateUnit(const CVector3& v) const {
+   return Quaternion(*this).rotateUnit(v);
+  }
+
+  /**
+   * @brief Normalized linear interpolation, t clamped to [0, 1].
+   */
+  template<typename Policy = EU::Precision::Default>
+  static QuaternionA
+   lerp(const QuaternionA& a, const QuaternionA& b, float t) {
+   const EU::SIMD::Float4 va = a.simd();
+   const EU::SIMD::Float4 vt = EU::SIMD::Float4::set1(EngineMath::clamp(t, 0.f, 1.f));
+   return QuaternionA(EU::SIMD::madd(b.simd() - va, vt, va)).normalized<Policy>();
+  }
+
+  /**
+   * @brief Four-dimensional dot product, the cosine of half the angle between two rotations.
+   */
+  float
+   dot(const QuaternionA& otro) const {
+   return EU::SIMD::first(EU::SIMD::dot4(simd(), otro.simd()));
+  }
+
+  /**
+   * @brief Spherical linear interpolation; see Quaternion::slerp().
+   */
+  template<typename Policy = EU::Precision::Default>
+  static EU_CONSTEXPR20 QuaternionA
+   slerp(const QuaternionA& a, const QuaternionA& b, float t) {
+   return Quaternion::slerp<Policy>(a, b, t);
+  }
+
+  /**
+   * @brief Trigonometry-free approximate slerp(); see Quaternion::slerpFast().
+   */
+  template<typename Policy = EU::Precision::Default>
+  static EU_CONSTEXPR20 QuaternionA
+   slerpFast(const QuaternionA& a, const QuaternionA& b, float t) {
+   return Quaternion::slerpFast<Policy>(a, b, t);
+  }
+
+  /**
+   * @brief Returns the identity quaternion (no rotation).
+   */
+  static constexpr QuaternionA identity() {
+   return QuaternionA(0.f, 0.f, 0.f, 1.f);
+  }
+ };
+
+ static_assert(sizeof(QuaternionA) == 4 * sizeof(float) && alignof(QuaternionA) == 16, "one SIMD register");
+ EU_ASSERT_VALUE_TYPE(QuaternionA);
+}
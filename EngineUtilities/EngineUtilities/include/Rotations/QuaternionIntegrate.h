@@ -0,0 +1,158 @@
+/**
+ * @file QuaternionIntegrate.h
+ * @brief Orientation integration from angular velocities, per body and over SoA batches.
+ *
+ * Angular velocities are world-space vectors in radians per second. The first-order update
+ * is q' = normalize(q + 0.5 dt (omega, 0) q), evaluated as the single product
+ * (0.5 dt omega, 1) q plus one rsqrt; accurate while |omega| dt stays small, it loses angle
+ * (not axis) as the step grows. The exponential-map update
+ * q' = normalize((sin(h) omega / |omega|, cos(h)) q) with h = 0.5 |omega| dt is exact for a
+ * constant omega at any step, at the cost of a sincos and a sqrt per body; below h = 1e-3 it
+ * switches to the series of sin(h) / |omega|.
+ *
+ * Both batch kernels read a register of bodies at a time from QuaternionSoA/ConstSoA3
+ * arrays, fuse the normalization through Policy::invLengthLanes (an rsqrt under the Fast and
+ * Balanced policies), and write back in place. A zero quaternion becomes the identity, as
+ * with Quaternion::normalized().
+ *
+ * angularVelocity() goes the other way: the constant omega that takes one orientation to
+ * another in dt, 2 log(q1 q0^-1) / dt, so that integrateAngularVelocityExp(q0, omega, dt)
+ * lands back on q1 (e.g. to extrapolate networked bodies from their last two snapshots).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Precision.h>
+#include <Matrices/PoseBlend.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ namespace detail {
+  /// Half-angle below which the exponential map uses the series of sin(h) / |omega|.
+  constexpr float EXP_MAP_SERIES_ANGLE = 1e-3f;
+
+  /** Loads bodies [i, i + count) of rotations, applies step * q to each and normalizes. */
+  template<typename Policy>
+  inline void
+   applyStepLanes(const QuaternionSoA& rotations, size_t i, size_t count, const BatchLanes (&step)[4]) {
+   const BatchLanes q[4] = { loadLanes(rotations.x, i, count), loadLanes(rotations.y, i, count),
+                             loadLanes(rotations.z, i, count), loadLanes(rotations.w, i, count) };
+   BatchLanes r[4];
+   multiplyRotationLanes(step, q, r);
+   normalizeRotationLanes<Policy>(r);
+   storeLanes(r[0], rotations.x, i, count);
+   storeLanes(r[1], rotations.y, i, count);
+   storeLanes(r[2], rotations.z, i, count);
+   storeLanes(r[3], rotations.w, i, count);
+  }
+ }
+
+ /**
+  * @brief First-order step of q by the world-space angular velocity omega over dt, normalized.
+  */
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 Quaternion
+  integrateAngularVelocity(const Quaternion& q, const CVector3& omega, float dt) {
+  const float h = 0.5f * dt;
+  return (Quaternion(omega.x * h, omega.y * h, omega.z * h, 1.f) * q).normalized<Policy>();
+ }
+
+ /**
+  * @brief Exponential-map step of q by omega over dt: exact for a constant omega.
+  */
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 Quaternion
+  integrateAngularVelocityExp(const Quaternion& q, const CVector3& omega, float dt) {
+  const float rate = EngineMath::sqrtHardware(omega.x * omega.x + omega.y * omega.y + omega.z * omega.z);
+  const float h = 0.5f * dt * rate;
+  const float k = h < detail::EXP_MAP_SERIES_ANGLE ? 0.5f * dt * (1.f - h * h * (1.f / 6.f))
+                                                   : Policy::sin(h) / rate;
+  return (Quaternion(omega.x * k, omega.y * k, omega.z * k, Policy::cos(h)) * q).normalized<Policy>();
+ }
+
+ /**
+  * @brief First-order step of n orientations in place; omega[i] drives rotations[i].
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  integrateOrientations(const QuaternionSoA& rotations, EngineMath::batch::ConstSoA3 omega, size_t n, float dt) {
+  using detail::BatchLanes;
+  const BatchLanes h = BatchLanes::set1(0.5f * dt), one = BatchLanes::set1(1.f);
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   const BatchLanes step[4] = { detail::loadLanes(omega.x, i, count) * h, detail::loadLanes(omega.y, i, count) * h,
+                                detail::loadLanes(omega.z, i, count) * h, one };
+   detail::applyStepLanes<Policy>(rotations, i, count, step);
+  }
+ }
+
+ /**
+  * @brief Exponential-map step of n orientations in place.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  integrateOrientationsExp(const QuaternionSoA& rotations, EngineMath::batch::ConstSoA3 omega, size_t n, float dt) {
+  using detail::BatchLanes;
+  const BatchLanes halfStep = BatchLanes::set1(0.5f * dt), sixth = BatchLanes::set1(1.f / 6.f);
+  const BatchLanes one = BatchLanes::set1(1.f), series = BatchLanes::set1(detail::EXP_MAP_SERIES_ANGLE);
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   const BatchLanes ox = detail::loadLanes(omega.x, i, count), oy = detail::loadLanes(omega.y, i, count);
+   const BatchLanes oz = detail::loadLanes(omega.z, i, count);
+   const BatchLanes rate = EU::SIMD::sqrt(ox * ox + oy * oy + oz * oz);
+   const BatchLanes h = halfStep * rate;
+   BatchLanes s, c;
+   EngineMath::batch::kernels::sincos(h, s, c);
+   // Lanes below the series angle (including omega = 0) never divide.
+   const BatchLanes small = h < series;
+   const BatchLanes k = EU::SIMD::select(small, halfStep * (one - h * h * sixth), s / EU::SIMD::select(small, one, rate));
+   const BatchLanes step[4] = { ox * k, oy * k, oz * k, c };
+   detail::applyStepLanes<Policy>(rotations, i, count, step);
+  }
+ }
+
+ /**
+  * @brief World-space angular velocity that turns unit q0 into unit q1 over dt, along the
+  * shorter arc; zero for dt <= 0.
+  */
+ EU_CONSTEXPR20 CVector3
+  angularVelocity(const Quaternion& q0, const Quaternion& q1, float dt) {
+  if (!(dt > 0.f)) return CVector3();
+  Quaternion delta = q1 * Quaternion(-q0.x, -q0.y, -q0.z, q0.w);
+  if (delta.w < 0.f) delta = Quaternion(-delta.x, -delta.y, -delta.z, -delta.w);
+  const Quaternion l = delta.log();
+  const float k = 2.f / dt;
+  return CVector3(l.x * k, l.y * k, l.z * k);
+ }
+
+ /**
+  * @brief omega[i] = angularVelocity(from[i], to[i], dt) for n bodies.
+  */
+ inline void
+  angularVelocities(ConstQuaternionSoA from, ConstQuaternionSoA to, const EngineMath::batch::SoA3& omega, size_t n, float dt) {
+  using detail::BatchLanes;
+  const BatchLanes k = BatchLanes::set1(dt > 0.f ? 2.f / dt : 0.f);
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   const size_t count = n - i < detail::BATCH_WIDTH ? n - i : detail::BATCH_WIDTH;
+   const BatchLanes inv0[4] = { -detail::loadLanes(from.x, i, count), -detail::loadLanes(from.y, i, count),
+                                -detail::loadLanes(from.z, i, count), detail::loadLanes(from.w, i, count) };
+   const BatchLanes q1[4] = { detail::loadLanes(to.x, i, count), detail::loadLanes(to.y, i, count),
+                              detail::loadLanes(to.z, i, count), detail::loadLanes(to.w, i, count) };
+   BatchLanes delta[4];
+   detail::multiplyRotationLanes(q1, inv0, delta);
+   const BatchLanes flip = delta[3] < BatchLanes::zero();
+   for (int c = 0; c < 4; ++c) delta[c] = EU::SIMD::select(flip, -delta[c], delta[c]);
+   BatchLanes l[4];
+   detail::quaternionLogLanes(delta, l);
+   detail::storeLanes(l[0] * k, omega.x, i, count);
+   detail::storeLanes(l[1] * k, omega.y, i, count);
+   detail::storeLanes(l[2] * k, omega.z, i, count);
+  }
+ }
+}
@@ -0,0 +1,73 @@
+/**
+ * @file QuaternionNetwork.h
+ * @brief Smallest-three Quaternion fields for the BitWriter/BitReader streams of VectorNetwork.h.
+ *
+ * writeQuantized() appends the packQuaternion() code of an orientation, 29, 32 or 47 bits
+ * instead of 128, with no padding, so orientations and quantized positions can share one bit
+ * stream. Both ends must agree on the format; it is not written to the stream. Needs
+ * sfml-network at link time.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Math/Precision.h>
+#include <Rotations/Quaternion.h>
+#include <Rotations/QuaternionPacked.h>
+#include <Vectors/VectorNetwork.h>
+
+namespace EU {
+ /**
+  * @brief Writes the unit quaternion q as a quaternionCodeBits(format)-bit field.
+  */
+ inline void
+  writeQuantized(BitWriter& writer, const Quaternion& q, QuaternionFormat format) {
+  const int bits = quaternionCodeBits(format);
+  const uint64_t code = packQuaternion(q, format);
+  writer.write(static_cast<uint32_t>(code), bits < 32 ? bits : 32);
+  if (bits > 32) writer.write(static_cast<uint32_t>(code >> 32), bits - 32);
+ }
+
+ /** @brief Reads a quaternion written by writeQuantized() in the same format. */
+ template<typename Policy = EU::Precision::Default>
+ inline Quaternion
+  readQuantized(BitReader& reader, QuaternionFormat format) {
+  const int bits = quaternionCodeBits(format);
+  uint64_t code = reader.read(bits < 32 ? bits : 32);
+  if (bits > 32) code |= static_cast<uint64_t>(reader.read(bits - 32)) << 32;
+  return unpackQuaternion<Policy>(code, format);
+ }
+
+ /** @brief Writes n quaternions back to back, packed a register at a time. */
+ inline void
+  writeQuantized(BitWriter& writer, const Quaternion* q, size_t n, QuaternionFormat format) {
+  const int bits = quaternionCodeBits(format);
+  uint64_t codes[64];
+  for (size_t i = 0; i < n; i += 64) {
+   const size_t count = n - i < 64 ? n - i : 64;
+   packQuaternionArray(q + i, codes, count, format);
+   for (size_t j = 0; j < count; ++j) {
+    writer.write(static_cast<uint32_t>(codes[j]), bits < 32 ? bits : 32);
+    if (bits > 32) writer.write(static_cast<uint32_t>(codes[j] >> 32), bits - 32);
+   }
+  }
+ }
+
+ /** @brief Reads n quaternions into out. @return False if the packet ran out; the rest decode from zero codes. */
+ template<typename Policy = EU::Precision::Default>
+ inline bool
+  readQuantized(BitReader& reader, Quaternion* out, size_t n, QuaternionFormat format) {
+  const int bits = quaternionCodeBits(format);
+  uint64_t codes[64];
+  for (size_t i = 0; i < n; i += 64) {
+   const size_t count = n - i < 64 ? n - i : 64;
+   for (size_t j = 0; j < count; ++j) {
+    codes[j] = reader.read(bits < 32 ? bits : 32);
+    if (bits > 32) codes[j] |= static_cast<uint64_t>(reader.read(bits - 32)) << 32;
+   }
+   unpackQuaternionArray<Policy>(codes, out + i, count, format);
+  }
+  return reader.valid();
+ }
+}
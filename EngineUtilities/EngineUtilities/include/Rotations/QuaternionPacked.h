@@ -0,0 +1,214 @@
+/**
+ * @file QuaternionPacked.h
+ * @brief "Smallest three" storage formats for unit quaternions in 29, 32 or 48 bits.
+ *
+ * The component with the largest magnitude is dropped and rebuilt on decode from the unit
+ * length; the quaternion is negated first when that component is negative, which keeps the
+ * rotation. The other three lie in [-1/sqrt(2), 1/sqrt(2)] and are stored as snorm fields of
+ * 9, 10 or 15 bits after the 2-bit index of the dropped one. Zero is exact, so the identity
+ * round-trips unchanged. The decoded rotation is within 0.5 degrees of the original for 29
+ * bits, 0.24 degrees for 32 and 0.01 degrees for 48 (components within 3.7e-3, 1.7e-3 and
+ * 6.1e-5; the rebuilt one carries most of it).
+ *
+ * Codes are returned in the low bits of a uint64_t; the 29 and 32-bit formats fit a
+ * uint32_t. Like VectorPacked.h this is storage only: do the math on Quaternion. The bulk
+ * packQuaternionArray() produces the same codes as packQuaternion(), and
+ * unpackQuaternionArray() the same quaternions as unpackQuaternion() at run time whenever the
+ * policy's scalar and lane square roots agree, as with Exact. Both sum the squares of the
+ * stored components with explicit multiply-adds so FMA contraction cannot split the two;
+ * build with -ffp-contract=off under EU_REPRODUCIBLE on GCC, as Platform.h says.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Precision.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/VectorBatch.h>
+#include <Vectors/VectorPacked.h>
+
+namespace EU {
+ /**
+  * @brief Width of a smallest-three quaternion code.
+  */
+ enum class QuaternionFormat {
+  Bits29, ///< Three 9-bit fields; fine for remote characters at gameplay distances
+  Bits32, ///< Three 10-bit fields, one 32-bit word
+  Bits48  ///< Three 15-bit fields (47 bits used); close to float precision for animation
+ };
+
+ /** @brief Bits per stored component of format. */
+ constexpr int
+  quaternionComponentBits(QuaternionFormat format) {
+  return format == QuaternionFormat::Bits29 ? 9 : (format == QuaternionFormat::Bits32 ? 10 : 15);
+ }
+
+ /** @brief Bits of a code, index included: 29, 32 or 47. */
+ constexpr int
+  quaternionCodeBits(QuaternionFormat format) {
+  return 2 + 3 * quaternionComponentBits(format);
+ }
+
+ namespace detail {
+  /// Range of the three smallest components of a unit quaternion: [-1/sqrt(2), 1/sqrt(2)].
+  constexpr float SMALLEST_THREE_RANGE = 0.707106781f;
+
+  /** Largest snorm code of a component field; codes are stored offset by it, in [0, 2 qmax]. */
+  constexpr int
+   smallestThreeMax(int bits) {
+   return (1 << (bits - 1)) - 1;
+  }
+
+  /** Assembles a code from the dropped index and the three offset fields. */
+  constexpr uint64_t
+   smallestThreeCode(int largest, int a, int b, int c, int bits) {
+   return static_cast<uint64_t>(largest) | static_cast<uint64_t>(a) << 2
+        | static_cast<uint64_t>(b) << (2 + bits) | static_cast<uint64_t>(c) << (2 + 2 * bits);
+  }
+ }
+
+ /**
+  * @brief Smallest-three code of q in format. q should be unit length; it is not normalized
+  * here.
+  */
+ constexpr uint64_t
+  packQuaternion(const Quaternion& q, QuaternionFormat format) {
+  const int bits = quaternionComponentBits(format);
+  const int qmax = detail::smallestThreeMax(bits);
+  const float fmax = static_cast<float>(qmax);
+  int largest = 0;
+  float best = EngineMath::fabs(q.x);
+  if (EngineMath::fabs(q.y) > best) { largest = 1; best = EngineMath::fabs(q.y); }
+  if (EngineMath::fabs(q.z) > best) { largest = 2; best = EngineMath::fabs(q.z); }
+  if (EngineMath::fabs(q.w) > best) largest = 3;
+  const float c[4] = { q.x, q.y, q.z, q.w };
+  const bool negate = c[largest] < 0.f;
+  const float inv = 1.f / detail::SMALLEST_THREE_RANGE;
+  const float a = largest == 0 ? q.y : q.x;
+  const float b = largest <= 1 ? q.z : q.y;
+  const float d = largest <= 2 ? q.w : q.z;
+  return detail::smallestThreeCode(largest,
+                                   detail::quantizeSnorm((negate ? -a : a) * inv, fmax) + qmax,
+                                   detail::quantizeSnorm((negate ? -b : b) * inv, fmax) + qmax,
+                                   detail::quantizeSnorm((negate ? -d : d) * inv, fmax) + qmax, bits);
+ }
+
+ /**
+  * @brief Unit quaternion of a code written by packQuaternion() in the same format.
+  */
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 Quaternion
+  unpackQuaternion(uint64_t code, QuaternionFormat format) {
+  const int bits = quaternionComponentBits(format);
+  const int qmax = detail::smallestThreeMax(bits);
+  const float fmax = static_cast<float>(qmax);
+  const uint64_t field = (uint64_t(1) << bits) - 1;
+  const int largest = static_cast<int>(code & 3u);
+  const float a = detail::dequantizeSnorm(static_cast<int>((code >> 2) & field) - qmax, fmax) * detail::SMALLEST_THREE_RANGE;
+  const float b = detail::dequantizeSnorm(static_cast<int>((code >> (2 + bits)) & field) - qmax, fmax) * detail::SMALLEST_THREE_RANGE;
+  const float c = detail::dequantizeSnorm(static_cast<int>((code >> (2 + 2 * bits)) & field) - qmax, fmax) * detail::SMALLEST_THREE_RANGE;
+  const float restSq = 1.f - EU::Precision::detail::fusedMadd(c, c, EU::Precision::detail::fusedMadd(b, b, a * a));
+  const float d = Policy::sqrt(restSq > 0.f ? restSq : 0.f);
+  return largest == 0 ? Quaternion(d, a, b, c)
+       : largest == 1 ? Quaternion(a, d, b, c)
+       : largest == 2 ? Quaternion(a, b, d, c)
+       : Quaternion(a, b, c, d);
+ }
+
+ /**
+  * @brief Bulk packQuaternion() of n quaternions: the index selection and quantization run
+  * a register of quaternions at a time, only the final field assembly is scalar.
+  */
+ inline void
+  packQuaternionArray(const Quaternion* in, uint64_t* out, size_t n, QuaternionFormat format) {
+  using V = EU::detail::BatchLanes;
+  using I = EU::detail::BatchInt;
+  constexpr size_t W = EU::detail::BATCH_WIDTH;
+  const int bits = quaternionComponentBits(format);
+  const int qmax = detail::smallestThreeMax(bits);
+  const float fmax = static_cast<float>(qmax);
+  for (size_t i = 0; i < n; i += W) {
+   const size_t count = n - i < W ? n - i : W;
+   float lanes[4][W] = {};
+   for (size_t j = 0; j < count; ++j) {
+    lanes[0][j] = in[i + j].x;
+    lanes[1][j] = in[i + j].y;
+    lanes[2][j] = in[i + j].z;
+    lanes[3][j] = in[i + j].w;
+   }
+   const V x = V::load(lanes[0]), y = V::load(lanes[1]), z = V::load(lanes[2]), w = V::load(lanes[3]);
+   const V ax = EU::detail::absLanes(x), ay = EU::detail::absLanes(y);
+   const V az = EU::detail::absLanes(z), aw = EU::detail::absLanes(w);
+   V best = ax, largest = V::zero(), top = x;
+   V m = ay > best;
+   best = EU::SIMD::select(m, ay, best);
+   largest = EU::SIMD::select(m, V::set1(1.f), largest);
+   top = EU::SIMD::select(m, y, top);
+   m = az > best;
+   best = EU::SIMD::select(m, az, best);
+   largest = EU::SIMD::select(m, V::set1(2.f), largest);
+   top = EU::SIMD::select(m, z, top);
+   m = aw > best;
+   largest = EU::SIMD::select(m, V::set1(3.f), largest);
+   top = EU::SIMD::select(m, w, top);
+   const V sign = top & EU::SIMD::asFloat(I::set1(static_cast<int32_t>(0x80000000u)));
+   const V inv = V::set1(1.f / detail::SMALLEST_THREE_RANGE);
+   const V a = EU::SIMD::select(largest == V::zero(), y, x);
+   const V b = EU::SIMD::select(largest <= V::set1(1.f), z, y);
+   const V c = EU::SIMD::select(largest <= V::set1(2.f), w, z);
+   const I offset = I::set1(qmax);
+   int32_t idx[W], qa[W], qb[W], qc[W];
+   EU::SIMD::truncToInt(largest).store(idx);
+   (EU::detail::quantizeSnormLanes((a ^ sign) * inv, fmax) + offset).store(qa);
+   (EU::detail::quantizeSnormLanes((b ^ sign) * inv, fmax) + offset).store(qb);
+   (EU::detail::quantizeSnormLanes((c ^ sign) * inv, fmax) + offset).store(qc);
+   for (size_t j = 0; j < count; ++j) out[i + j] = detail::smallestThreeCode(idx[j], qa[j], qb[j], qc[j], bits);
+  }
+ }
+
+ /**
+  * @brief Bulk unpackQuaternion() of n codes: fields are extracted per code, then decoded a
+  * register at a time.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  unpackQuaternionArray(const uint64_t* in, Quaternion* out, size_t n, QuaternionFormat format) {
+  using V = EU::detail::BatchLanes;
+  using I = EU::detail::BatchInt;
+  constexpr size_t W = EU::detail::BATCH_WIDTH;
+  const int bits = quaternionComponentBits(format);
+  const int qmax = detail::smallestThreeMax(bits);
+  const uint64_t field = (uint64_t(1) << bits) - 1;
+  for (size_t i = 0; i < n; i += W) {
+   const size_t count = n - i < W ? n - i : W;
+   int32_t idx[W] = {}, qa[W] = {}, qb[W] = {}, qc[W] = {};
+   for (size_t j = 0; j < count; ++j) {
+    const uint64_t code = in[i + j];
+    idx[j] = static_cast<int32_t>(code & 3u);
+    qa[j] = static_cast<int32_t>((code >> 2) & field);
+    qb[j] = static_cast<int32_t>((code >> (2 + bits)) & field);
+    qc[j] = static_cast<int32_t>((code >> (2 + 2 * bits)) & field);
+   }
+   const I offset = I::set1(qmax);
+   const V fmax = V::set1(static_cast<float>(qmax)), range = V::set1(detail::SMALLEST_THREE_RANGE);
+   const V minusOne = V::set1(-1.f);
+   const V a = EU::SIMD::max(EU::SIMD::toFloat(I::load(qa) - offset) / fmax, minusOne) * range;
+   const V b = EU::SIMD::max(EU::SIMD::toFloat(I::load(qb) - offset) / fmax, minusOne) * range;
+   const V c = EU::SIMD::max(EU::SIMD::toFloat(I::load(qc) - offset) / fmax, minusOne) * range;
+   const V d = Policy::sqrtLanes(EU::SIMD::max(V::set1(1.f) - EU::SIMD::madd(c, c, EU::SIMD::madd(b, b, a * a)), V::zero()));
+   const V largest = EU::SIMD::toFloat(I::load(idx));
+   const V at0 = largest == V::zero(), at1 = largest == V::set1(1.f);
+   const V at2 = largest == V::set1(2.f), at3 = largest == V::set1(3.f);
+   float lanes[4][W];
+   EU::SIMD::select(at0, d, a).store(lanes[0]);
+   EU::SIMD::select(at0, a, EU::SIMD::select(at1, d, b)).store(lanes[1]);
+   EU::SIMD::select(at3, c, EU::SIMD::select(at2, d, b)).store(lanes[2]);
+   EU::SIMD::select(at3, d, c).store(lanes[3]);
+   for (size_t j = 0; j < count; ++j) out[i + j] = Quaternion(lanes[0][j], lanes[1][j], lanes[2][j], lanes[3][j]);
+  }
+ }
+}
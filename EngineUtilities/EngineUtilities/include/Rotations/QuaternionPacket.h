@@ -0,0 +1,407 @@
+/**
+ * @file QuaternionPacket.h
+ * @brief AoSoA packet of 4 or 8 quaternions, one SIMD register per component.
+ *
+ * QuaternionPacket<V> mirrors the Quaternion interface lane-wise, in the same evaluation order,
+ * and works with CVector3Packet<V> for rotate() and fromAxisAngle().
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Precision.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3Packet.h>
+
+namespace EU {
+
+ /**
+  * @class QuaternionPacket
+  * @brief V::WIDTH quaternions stored as one register per component.
+  * @tparam V Lane type, EU::SIMD::Float4 or Float8.
+  */
+ template<typename V>
+ class
+  QuaternionPacket {
+  public:
+  /// Number of quaternions in a packet.
+  static constexpr int WIDTH = V::WIDTH;
+
+  V x; ///< X components
+  V y; ///< Y components
+  V z; ///< Z components
+  V w; ///< W components (real part)
+
+  /**
+   * @brief Default constructor. Initializes every lane to the identity.
+   */
+  QuaternionPacket() : x(V::zero()), y(V::zero()), z(V::zero()), w(V::set1(1.f)) {}
+
+  /**
+   * @brief Leaves every lane uninitialized; see EU::NoInit.
+   */
+  explicit QuaternionPacket(EU::NoInitTag) {}
+
+  /**
+   * @brief Constructs a packet from component registers.
+   */
+  QuaternionPacket(V x, V y, V z, V w) : x(x), y(y), z(z), w(w) {}
+
+  /**
+   * @brief Broadcasts one quaternion to every lane.
+   */
+  explicit QuaternionPacket(const Quaternion& q)
+   : x(V::set1(q.x)), y(V::set1(q.y)), z(V::set1(q.z)), w(V::set1(q.w)) {
+  }
+
+  /**
+   * @brief Loads WIDTH consecutive quaternions.
+   */
+  static QuaternionPacket
+   load(const Quaternion* in) {
+   float px[WIDTH], py[WIDTH], pz[WIDTH], pw[WIDTH];
+   for (int i = 0; i < WIDTH; ++i) {
+    px[i] = in[i].x;
+    py[i] = in[i].y;
+    pz[i] = in[i].z;
+    pw[i] = in[i].w;
+   }
+   return QuaternionPacket(V::load(px), V::load(py), V::load(pz), V::load(pw));
+  }
+
+  /**
+   * @brief Stores WIDTH consecutive quaternions.
+   */
+  void
+   store(Quaternion* out) const {
+   float px[WIDTH], py[WIDTH], pz[WIDTH], pw[WIDTH];
+   x.store(px);
+   y.store(py);
+   z.store(pz);
+   w.store(pw);
+   for (int i = 0; i < WIDTH; ++i) {
+    out[i] = Quaternion(px[i], py[i], pz[i], pw[i]);
+   }
+  }
+
+  /**
+   * @brief Extracts lane i as a Quaternion.
+   */
+  Quaternion
+   lane(int i) const {
+   Quaternion lanes[WIDTH];
+   store(lanes);
+   return lanes[i];
+  }
+
+  /**
+   * @brief Lane-wise quaternion product, evaluated in the same order as Quaternion::operator*.
+   */
+  QuaternionPacket
+   operator*(const QuaternionPacket& otro) const {
+   return QuaternionPacket(
+   w * otro.x + x * otro.w + y * otro.z - z * otro.y,
+   w * otro.y - x * otro.z + y * otro.w + z * otro.x,
+   w * otro.z + x * otro.y - y * otro.x + z * otro.w,
+   w * otro.w - x * otro.x - y * otro.y - z * otro.z
+   );
+  }
+
+  /**
+   * @brief In-place lane-wise multiplication.
+   */
+  QuaternionPacket&
+   operator*=(const QuaternionPacket& otro) {
+   *this = *this * otro;
+   return *this;
+  }
+
+  /**
+   * @brief Lane mask of equal quaternions.
+   */
+  V
+   operator==(const QuaternionPacket& otro) const {
+   return (x == otro.x) & (y == otro.y) & (z == otro.z) & (w == otro.w);
+  }
+
+  /**
+   * @brief Lane mask of different quaternions.
+   */
+  V
+   operator!=(const QuaternionPacket& otro) const {
+   return (x != otro.x) | (y != otro.y) | (z != otro.z) | (w != otro.w);
+  }
+
+  /**
+   * @brief Lane mask of quaternions whose components are all within epsilon of otro's.
+   */
+  V
+   approxEqual(const QuaternionPacket& otro, float epsilon = EU::Constants::EPSILON) const {
+   const V e = V::set1(epsilon);
+   return EU::SIMD::approxEqual(x, otro.x, e) & EU::SIMD::approxEqual(y, otro.y, e)
+        & EU::SIMD::approxEqual(z, otro.z, e) & EU::SIMD::approxEqual(w, otro.w, e);
+  }
+
+  /**
+   * @brief Magnitude of every lane.
+   */
+  template<typename Policy = EU::Precision::Default>
+  V
+   length() const {
+   return Policy::sqrtLanes(Policy::maddLanes(x, x, Policy::maddLanes(y, y, Policy::maddLanes(z, z, w * w))));
+  }
+
+  /**
+   * @brief Normalizes every lane in-place; zero lanes are left unchanged.
+   */
+  template<typename Policy = EU::Precision::Default>
+  void
+   normalize() {
+   V lenSq = x * x + y * y + z * z + w * w;
+   EU::Precision::rescaleLanes(x, y, z, w, lenSq);
+   V inv = EU::SIMD::select(lenSq != V::zero(), Policy::invLengthLanes(lenSq), V::set1(1.f));
+   x = x * inv;
+   y = y * inv;
+   z = z * inv;
+   w = w * inv;
+  }
+
+  /**
+   * @brief Returns a normalized copy; zero lanes become the identity.
+   */
+  template<typename Policy = EU::Precision::Default>
+  QuaternionPacket
+   normalized() const {
+   QuaternionPacket r(*this);
+   V lenSq = x * x + y * y + z * z + w * w;
+   EU::Precision::rescaleLanes(r.x, r.y, r.z, r.w, lenSq);
+   V valid = lenSq != V::zero();
+   V inv = Policy::invLengthLanes(lenSq);
+   r = QuaternionPacket(r.x * inv, r.y * inv, r.z * inv, r.w * inv);
+   return select(valid, r, identity());
+  }
+
+  /**
+   * @brief Lane-wise inverse; zero lanes become the identity.
+   */
+  QuaternionPacket
+   inverse() const {
+   V lenSq = x * x + y * y + z * z + w * w;
+   V valid = lenSq != V::zero();
+   QuaternionPacket r(-x / lenSq, -y / lenSq, -z / lenSq, w / lenSq);
+   return select(valid, r, identity());
+  }
+
+  /**
+   * @brief Rotations about per-lane axes (should be normalized) by per-lane angles in radians.
+   */
+  static QuaternionPacket
+   fromAxisAngle(const CVector3Packet<V>& axis, V angle) {
+   V halfAngle = angle * V::set1(0.5f);
+   V s = EngineMath::batch::kernels::sin(halfAngle);
+   V c = EngineMath::batch::kernels::cos(halfAngle);
+   return QuaternionPacket(axis.x * s, axis.y * s, axis.z * s, c);
+  }
+
+  /**
+   * @brief Rotates every lane's vector by that lane's quaternion, as Quaternion::rotate().
+   */
+  CVector3Packet<V>
+   rotate(const CVector3Packet<V>& v) const {
+   const V lenSq = x * x + y * y + z * z + w * w;
+   const V valid = lenSq != V::zero();
+   const V scale = (V::set1(2.f) / EU::SIMD::select(valid, lenSq, V::set1(1.f))) & valid;
+   const CVector3Packet<V> r = rotateScaled(v, scale);
+   return CVector3Packet<V>(r.x & valid, r.y & valid, r.z & valid);
+  }
+
+  /**
+   * @brief Quaternion::rotateUnit() per lane, for unit quaternions.
+   */
+  CVector3Packet<V>
+   rotateUnit(const CVector3Packet<V>& v) const {
+   return rotateScaled(v, V::set1(2.f));
+  }
+
+  /**
+   * @brief Normalized lerp of every lane by its own factor, clamped to [0, 1].
+   */
+  template<typename Policy = EU::Precision::Default>
+  static QuaternionPacket
+   lerp(const QuaternionPacket& a, const QuaternionPacket& b, V t) {
+   t = EU::SIMD::min(EU::SIMD::max(t, V::zero()), V::set1(1.f));
+   return QuaternionPacket(
+    a.x + (b.x - a.x) * t,
+    a.y + (b.y - a.y) * t,
+    a.z + (b.z - a.z) * t,
+    a.w + (b.w - a.w) * t
+    ).template normalized<Policy>();
+  }
+
+  /**
+   * @brief Normalized lerp of every lane by the same factor, clamped to [0, 1].
+   */
+  template<typename Policy = EU::Precision::Default>
+  static QuaternionPacket
+   lerp(const QuaternionPacket& a, const QuaternionPacket& b, float t) {
+   return lerp<Policy>(a, b, V::set1(t));
+  }
+
+  /**
+   * @brief Lane-wise Quaternion::slerp() by per-lane factors; both branches are evaluated
+   * and the nlerp one selected for nearly parallel lanes.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static QuaternionPacket
+   slerp(const QuaternionPacket& a, const QuaternionPacket& b, V t) {
+   const V one = V::set1(1.f);
+   const V d = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+   const V sign = EU::SIMD::select(d < V::zero(), V::set1(-1.f), one);
+   const V ad = d * sign;
+   const V theta = EngineMath::batch::kernels::acos(ad);
+   const V curved = ad < V::set1(0.9995f);
+   const V inv = one / EU::SIMD::select(curved, EngineMath::batch::kernels::sin(theta), one);
+   const V wa = EU::SIMD::select(curved, EngineMath::batch::kernels::sin((one - t) * theta) * inv, one - t);
+   const V wb = EU::SIMD::select(curved, EngineMath::batch::kernels::sin(t * theta) * inv, t) * sign;
+   return QuaternionPacket(a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb)
+    .template normalized<Policy>();
+  }
+
+  /**
+   * @brief slerp() with the same factor for every lane.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static QuaternionPacket
+   slerp(const QuaternionPacket& a, const QuaternionPacket& b, float t) {
+   return slerp<Policy>(a, b, V::set1(t));
+  }
+
+  /**
+   * @brief Lane-wise Quaternion::slerpFast(), in the same evaluation order.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static QuaternionPacket
+   slerpFast(const QuaternionPacket& a, const QuaternionPacket& b, V t) {
+   const V one = V::set1(1.f), half = V::set1(0.5f);
+   const V d = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+   const V sign = EU::SIMD::select(d < V::zero(), V::set1(-1.f), one);
+   const V ad = d * sign;
+   const V ka = V::set1(1.0904f) + ad * (V::set1(-3.2452f) + ad * (V::set1(3.55645f) - ad * V::set1(1.43519f)));
+   const V kb = V::set1(0.848013f) + ad * (V::set1(-1.06021f) + ad * V::set1(0.215638f));
+   const V h = t - half;
+   const V u = t + t * h * (t - one) * (ka * h * h + kb);
+   const V wa = one - u, wb = u * sign;
+   return QuaternionPacket(a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb)
+    .template normalized<Policy>();
+  }
+
+  /**
+   * @brief slerpFast() with the same factor for every lane.
+   */
+  template<typename Policy = EU::Precision::Default>
+  static QuaternionPacket
+   slerpFast(const QuaternionPacket& a, const QuaternionPacket& b, float t) {
+   return slerpFast<Policy>(a, b, V::set1(t));
+  }
+
+  /**
+   * @brief Returns a packet of identity quaternions.
+   */
+  static QuaternionPacket
+   identity() {
+   return QuaternionPacket();
+  }
+
+  private:
+  /** v + w t + q x t with t = scale (q x v), in the order of Quaternion::rotateScaled(). */
+  CVector3Packet<V>
+   rotateScaled(const CVector3Packet<V>& v, V scale) const {
+   const V tx = (y * v.z - z * v.y) * scale;
+   const V ty = (z * v.x - x * v.z) * scale;
+   const V tz = (x * v.y - y * v.x) * scale;
+   return CVector3Packet<V>(v.x + w * tx + (y * tz - z * ty),
+                            v.y + w * ty + (z * tx - x * tz),
+                            v.z + w * tz + (x * ty - y * tx));
+  }
+ };
+
+ /**
+  * @brief Lane-wise mask ? a : b.
+  */
+ template<typename V>
+ inline QuaternionPacket<V>
+  select(V mask, const QuaternionPacket<V>& a, const QuaternionPacket<V>& b) {
+  return QuaternionPacket<V>(EU::SIMD::select(mask, a.x, b.x), EU::SIMD::select(mask, a.y, b.y),
+                             EU::SIMD::select(mask, a.z, b.z), EU::SIMD::select(mask, a.w, b.w));
+ }
+
+ /// Four quaternions in SSE2/NEON registers (scalar lanes without SIMD).
+ using Quaternionx4 = QuaternionPacket<EU::SIMD::Float4>;
+#if defined(EU_SIMD_AVX2)
+ /// Eight quaternions in AVX2 registers.
+ using Quaternionx8 = QuaternionPacket<EU::SIMD::Float8>;
+#endif
+ /// The widest packet the target supports.
+ using QuaternionxN = QuaternionPacket<EU::SIMD::FloatN>;
+
+ EU_ASSERT_VALUE_TYPE(Quaternionx4);
+ EU_ASSERT_VALUE_TYPE(QuaternionxN);
+
+ namespace detail {
+  /**
+   * out[i] = slerp(a[i], b[i], t[i]) (t[0] for all when uniform) through full packets and
+   * the scalar call for the tail; fast picks slerpFast().
+   */
+  template<bool Fast, typename Policy>
+  inline void
+   slerpArray(const Quaternion* a, const Quaternion* b, const float* t, bool uniform, Quaternion* out, size_t n) {
+   using V = EU::SIMD::FloatN;
+   const size_t W = static_cast<size_t>(V::WIDTH);
+   size_t i = 0;
+   for (; i + W <= n; i += W) {
+    const QuaternionxN qa = QuaternionxN::load(a + i), qb = QuaternionxN::load(b + i);
+    const V ti = uniform ? V::set1(t[0]) : V::load(t + i);
+    (Fast ? QuaternionxN::slerpFast<Policy>(qa, qb, ti) : QuaternionxN::slerp<Policy>(qa, qb, ti)).store(out + i);
+   }
+   for (; i < n; ++i) {
+    const float ti = uniform ? t[0] : t[i];
+    out[i] = Fast ? Quaternion::slerpFast<Policy>(a[i], b[i], ti) : Quaternion::slerp<Policy>(a[i], b[i], ti);
+   }
+  }
+ }
+
+ /**
+  * @brief out[i] = Quaternion::slerp(a[i], b[i], t), one packet per step. Packet lanes use the
+  * batch trig kernels, so they agree with the scalar call to within their error bounds. out
+  * may be a or b.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  slerpArray(const Quaternion* a, const Quaternion* b, float t, Quaternion* out, size_t n) {
+  detail::slerpArray<false, Policy>(a, b, &t, true, out, n);
+ }
+
+ /** @brief out[i] = Quaternion::slerp(a[i], b[i], t[i]). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  slerpArray(const Quaternion* a, const Quaternion* b, const float* t, Quaternion* out, size_t n) {
+  detail::slerpArray<false, Policy>(a, b, t, false, out, n);
+ }
+
+ /** @brief out[i] = Quaternion::slerpFast(a[i], b[i], t). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  slerpFastArray(const Quaternion* a, const Quaternion* b, float t, Quaternion* out, size_t n) {
+  detail::slerpArray<true, Policy>(a, b, &t, true, out, n);
+ }
+
+ /** @brief out[i] = Quaternion::slerpFast(a[i], b[i], t[i]). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  slerpFastArray(const Quaternion* a, const Quaternion* b, const float* t, Quaternion* out, size_t n) {
+  detail::slerpArray<true, Policy>(a, b, t, false, out, n);
+ }
+}
@@ -0,0 +1,445 @@
+/**
+ * @file QuaternionStream.h
+ * @brief Structure-of-arrays container of quaternions with SIMD batch operations.
+ *
+ * The quaternion counterpart of Vector3Stream: x, y, z and w live in separate arrays aligned
+ * to 32 bytes and padded to a multiple of QuaternionStream::LANES, so the batch operations run
+ * whole FloatN registers with aligned loads and no scalar tail. soa() hands the arrays to the
+ * QuaternionSoA kernels (pose blending, integration, skinning) without a copy.
+ *
+ * Products follow Quaternion::operator*: multiply(a, b, out) applies b[i] first.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Matrices/PoseBlend.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3Stream.h>
+
+namespace EU {
+ /**
+  * @class QuaternionStream
+  * @brief Growable SoA array of quaternions, e.g. the local rotations of a skeleton.
+  *
+  * Element i is (x()[i], y()[i], z()[i], w()[i]). Each component array has room for
+  * capacity() floats; the padding past size() is readable and writable but its contents are
+  * unspecified.
+  */
+ class
+  QuaternionStream {
+  public:
+  /// Every component array is padded to a multiple of this many floats (covers AVX2).
+  static constexpr size_t LANES = 8;
+  /// Byte alignment of each component array.
+  static constexpr size_t ALIGNMENT = LANES * sizeof(float);
+
+  /** @brief Empty stream. */
+  QuaternionStream() : m_size(0), m_capacity(0) {}
+
+  /** @brief Stream of n identity quaternions. */
+  explicit QuaternionStream(size_t n) : QuaternionStream() {
+   resize(n);
+  }
+
+  /** @brief Stream holding a copy of n Quaternions. */
+  QuaternionStream(const Quaternion* in, size_t n) : QuaternionStream() {
+   gather(in, n);
+  }
+
+  /** @brief Copies the elements; the copy gets its own aligned storage. */
+  QuaternionStream(const QuaternionStream& other) : QuaternionStream() {
+   *this = other;
+  }
+
+  /** @brief Takes the storage of other, which is left empty. */
+  QuaternionStream(QuaternionStream&& other) noexcept
+   : m_storage(static_cast<std::vector<float>&&>(other.m_storage)), m_size(other.m_size), m_capacity(other.m_capacity) {
+   other.m_size = 0;
+   other.m_capacity = 0;
+  }
+
+  QuaternionStream&
+   operator=(const QuaternionStream& other) {
+   if (this != &other) {
+    resize(other.m_size);
+    copyComponents(other, m_size);
+   }
+   return *this;
+  }
+
+  QuaternionStream&
+   operator=(QuaternionStream&& other) noexcept {
+   if (this != &other) {
+    m_storage = static_cast<std::vector<float>&&>(other.m_storage);
+    m_size = other.m_size;
+    m_capacity = other.m_capacity;
+    other.m_storage.clear();
+    other.m_size = 0;
+    other.m_capacity = 0;
+   }
+   return *this;
+  }
+
+  /** @brief Number of quaternions. */
+  size_t
+   size() const {
+   return m_size;
+  }
+
+  /** @brief Quaternions that fit before the next reallocation, always a multiple of LANES. */
+  size_t
+   capacity() const {
+   return m_capacity;
+  }
+
+  /** @brief True when the stream holds no quaternions. */
+  bool
+   empty() const {
+   return m_size == 0;
+  }
+
+  /** @brief Grows the storage to hold at least n quaternions, keeping the contents. */
+  void
+   reserve(size_t n) {
+   if (n <= m_capacity) {
+    return;
+   }
+   QuaternionStream grown;
+   grown.m_capacity = roundUp(n > 2 * m_capacity ? n : 2 * m_capacity);
+   grown.m_storage.assign(4 * grown.m_capacity + ALIGNMENT / sizeof(float), 0.0f);
+   grown.m_size = m_size;
+   grown.copyComponents(*this, m_size);
+   *this = static_cast<QuaternionStream&&>(grown);
+  }
+
+  /** @brief Changes the size; new quaternions are the identity. */
+  void
+   resize(size_t n) {
+   reserve(n);
+   for (size_t i = m_size; i < n; ++i) {
+    set(i, Quaternion());
+   }
+   m_size = n;
+  }
+
+  /** @brief Removes all quaternions, keeping the storage. */
+  void
+   clear() {
+   m_size = 0;
+  }
+
+  /** @brief Appends one quaternion. */
+  void
+   push_back(const Quaternion& q) {
+   reserve(m_size + 1);
+   set(m_size++, q);
+  }
+
+  /** @brief X components, ALIGNMENT-aligned. */
+  float* x() { return base(); }
+  /** @brief Y components, ALIGNMENT-aligned. */
+  float* y() { return base() + m_capacity; }
+  /** @brief Z components, ALIGNMENT-aligned. */
+  float* z() { return base() + 2 * m_capacity; }
+  /** @brief W components, ALIGNMENT-aligned. */
+  float* w() { return base() + 3 * m_capacity; }
+  const float* x() const { return base(); }
+  const float* y() const { return base() + m_capacity; }
+  const float* z() const { return base() + 2 * m_capacity; }
+  const float* w() const { return base() + 3 * m_capacity; }
+
+  /** @brief Copy of quaternion i. */
+  Quaternion
+   get(size_t i) const {
+   return Quaternion(x()[i], y()[i], z()[i], w()[i]);
+  }
+
+  /** @brief Overwrites quaternion i. */
+  void
+   set(size_t i, const Quaternion& q) {
+   x()[i] = q.x;
+   y()[i] = q.y;
+   z()[i] = q.z;
+   w()[i] = q.w;
+  }
+
+  /** @brief The component arrays as a batch SoA view. */
+  QuaternionSoA
+   soa() {
+   return { x(), y(), z(), w() };
+  }
+
+  /** @brief The component arrays as a read-only batch SoA view. */
+  ConstQuaternionSoA
+   soa() const {
+   return { x(), y(), z(), w() };
+  }
+
+  /** @brief Replaces the contents with in[0..n) (AoS to SoA). */
+  void
+   gather(const Quaternion* in, size_t n) {
+   resize(n);
+   float* px = x();
+   float* py = y();
+   float* pz = z();
+   float* pw = w();
+   for (size_t i = 0; i < n; ++i) {
+    px[i] = in[i].x;
+    py[i] = in[i].y;
+    pz[i] = in[i].z;
+    pw[i] = in[i].w;
+   }
+  }
+
+  /** @brief Replaces the contents with source[indices[i]] for i in [0, n). */
+  void
+   gather(const Quaternion* source, const uint32_t* indices, size_t n) {
+   resize(n);
+   float* px = x();
+   float* py = y();
+   float* pz = z();
+   float* pw = w();
+   for (size_t i = 0; i < n; ++i) {
+    const Quaternion& q = source[indices[i]];
+    px[i] = q.x;
+    py[i] = q.y;
+    pz[i] = q.z;
+    pw[i] = q.w;
+   }
+  }
+
+  /** @brief Writes the size() quaternions to out (SoA to AoS). */
+  void
+   scatter(Quaternion* out) const {
+   const float* px = x();
+   const float* py = y();
+   const float* pz = z();
+   const float* pw = w();
+   for (size_t i = 0; i < m_size; ++i) {
+    out[i] = Quaternion(px[i], py[i], pz[i], pw[i]);
+   }
+  }
+
+  /** @brief Writes quaternion i to dest[indices[i]] for every i in [0, size()). */
+  void
+   scatter(Quaternion* dest, const uint32_t* indices) const {
+   const float* px = x();
+   const float* py = y();
+   const float* pz = z();
+   const float* pw = w();
+   for (size_t i = 0; i < m_size; ++i) {
+    dest[indices[i]] = Quaternion(px[i], py[i], pz[i], pw[i]);
+   }
+  }
+
+  private:
+  static size_t
+   roundUp(size_t n) {
+   return (n + LANES - 1) / LANES * LANES;
+  }
+
+  /** Start of the x array: the first ALIGNMENT boundary inside m_storage. */
+  float*
+   base() const {
+   uintptr_t p = reinterpret_cast<uintptr_t>(m_storage.data());
+   p = (p + ALIGNMENT - 1) & ~static_cast<uintptr_t>(ALIGNMENT - 1);
+   return const_cast<float*>(reinterpret_cast<const float*>(p));
+  }
+
+  void
+   copyComponents(const QuaternionStream& from, size_t n) {
+   for (size_t i = 0; i < n; ++i) {
+    x()[i] = from.x()[i];
+    y()[i] = from.y()[i];
+    z()[i] = from.z()[i];
+    w()[i] = from.w()[i];
+   }
+  }
+
+  std::vector<float> m_storage; ///< 4 * m_capacity floats plus alignment slack
+  size_t m_size;
+  size_t m_capacity;
+ };
+
+ namespace detail {
+  inline size_t
+   commonSize(const QuaternionStream& a, const QuaternionStream& b) {
+   return a.size() < b.size() ? a.size() : b.size();
+  }
+
+  /** Aligned load of the packet of a at i. */
+  inline void
+   loadPacket(const QuaternionStream& a, size_t i, EU::SIMD::FloatN (&q)[4]) {
+   using V = EU::SIMD::FloatN;
+   q[0] = V::loadAligned(a.x() + i);
+   q[1] = V::loadAligned(a.y() + i);
+   q[2] = V::loadAligned(a.z() + i);
+   q[3] = V::loadAligned(a.w() + i);
+  }
+
+  /** Aligned store of q as the packet of out at i. */
+  inline void
+   storePacket(const EU::SIMD::FloatN (&q)[4], QuaternionStream& out, size_t i) {
+   q[0].storeAligned(out.x() + i);
+   q[1].storeAligned(out.y() + i);
+   q[2].storeAligned(out.z() + i);
+   q[3].storeAligned(out.w() + i);
+  }
+ }
+
+ /**
+  * @brief out[i] = a[i] * b[i] (b[i] applied first) over the shorter of the two streams; out
+  * may alias either input.
+  */
+ inline void
+  multiply(const QuaternionStream& a, const QuaternionStream& b, QuaternionStream& out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = detail::commonSize(a, b);
+  out.resize(n);
+  detail::forEachPacket(n, [&](size_t i) {
+   V qa[4], qb[4], r[4];
+   detail::loadPacket(a, i, qa);
+   detail::loadPacket(b, i, qb);
+   detail::multiplyRotationLanes(qa, qb, r);
+   detail::storePacket(r, out, i);
+  });
+ }
+
+ /** @brief out[i] = a * b[i]: one rotation applied after every element, e.g. a parent. */
+ inline void
+  multiply(const Quaternion& a, const QuaternionStream& b, QuaternionStream& out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = b.size();
+  const V qa[4] = { V::set1(a.x), V::set1(a.y), V::set1(a.z), V::set1(a.w) };
+  out.resize(n);
+  detail::forEachPacket(n, [&](size_t i) {
+   V qb[4], r[4];
+   detail::loadPacket(b, i, qb);
+   detail::multiplyRotationLanes(qa, qb, r);
+   detail::storePacket(r, out, i);
+  });
+ }
+
+ /** @brief out[i] = a[i] * b: one rotation applied before every element, e.g. an offset. */
+ inline void
+  multiply(const QuaternionStream& a, const Quaternion& b, QuaternionStream& out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = a.size();
+  const V qb[4] = { V::set1(b.x), V::set1(b.y), V::set1(b.z), V::set1(b.w) };
+  out.resize(n);
+  detail::forEachPacket(n, [&](size_t i) {
+   V qa[4], r[4];
+   detail::loadPacket(a, i, qa);
+   detail::multiplyRotationLanes(qa, qb, r);
+   detail::storePacket(r, out, i);
+  });
+ }
+
+ /** @brief out[i] = conjugate of a[i], the inverse of a unit quaternion; out may alias a. */
+ inline void
+  conjugate(const QuaternionStream& a, QuaternionStream& out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = a.size();
+  out.resize(n);
+  detail::forEachPacket(n, [&](size_t i) {
+   (-V::loadAligned(a.x() + i)).storeAligned(out.x() + i);
+   (-V::loadAligned(a.y() + i)).storeAligned(out.y() + i);
+   (-V::loadAligned(a.z() + i)).storeAligned(out.z() + i);
+   V::loadAligned(a.w() + i).storeAligned(out.w() + i);
+  });
+ }
+
+ /**
+  * @brief out[i] = inverse of a[i] for any length; a zero quaternion becomes the identity, as
+  * with Quaternion::inverse(). out may alias a.
+  */
+ inline void
+  inverse(const QuaternionStream& a, QuaternionStream& out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = a.size();
+  const V one = V::set1(1.0f);
+  out.resize(n);
+  detail::forEachPacket(n, [&](size_t i) {
+   V q[4];
+   detail::loadPacket(a, i, q);
+   const V lenSq = EU::SIMD::madd(q[3], q[3], EU::SIMD::madd(q[2], q[2], EU::SIMD::madd(q[1], q[1], q[0] * q[0])));
+   const V valid = lenSq > V::zero();
+   const V inv = one / EU::SIMD::select(valid, lenSq, one);
+   const V r[4] = { -q[0] * inv, -q[1] * inv, -q[2] * inv, EU::SIMD::select(valid, q[3] * inv, one) };
+   detail::storePacket(r, out, i);
+  });
+ }
+
+ /** @brief out[i] = dot(a[i], b[i]); out holds the shorter stream's size() floats. */
+ inline void
+  dot(const QuaternionStream& a, const QuaternionStream& b, float* out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = detail::commonSize(a, b);
+  detail::forEachPacket(n, [&](size_t i) {
+   V d = V::loadAligned(a.x() + i) * V::loadAligned(b.x() + i);
+   d = EU::SIMD::madd(V::loadAligned(a.y() + i), V::loadAligned(b.y() + i), d);
+   d = EU::SIMD::madd(V::loadAligned(a.z() + i), V::loadAligned(b.z() + i), d);
+   d = EU::SIMD::madd(V::loadAligned(a.w() + i), V::loadAligned(b.w() + i), d);
+   detail::storePacket(d, out, i, n);
+  });
+ }
+
+ /**
+  * @brief out[i] = a[i] normalized through Policy::invLengthLanes; a zero quaternion becomes
+  * the identity. out may alias a.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  normalize(const QuaternionStream& a, QuaternionStream& out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = a.size();
+  out.resize(n);
+  detail::forEachPacket(n, [&](size_t i) {
+   V q[4];
+   detail::loadPacket(a, i, q);
+   detail::normalizeRotationLanes<Policy>(q);
+   detail::storePacket(q, out, i);
+  });
+ }
+
+ /** @brief Normalizes every quaternion of the stream in place. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  normalize(QuaternionStream& a) {
+  normalize<Policy>(a, a);
+ }
+
+ /**
+  * @brief out[i] = normalize(lerp(a[i], b[i], t)) along the shorter arc, with t clamped to
+  * [0, 1]; b[i] is negated when dot(a[i], b[i]) < 0. out may alias either input.
+  *
+  * Matches slerp at t = 0, 0.5 and 1; in between it drifts off with the angle between the
+  * keys, up to about 0.12 radians for keys half a turn apart.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  nlerp(const QuaternionStream& a, const QuaternionStream& b, float t, QuaternionStream& out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = detail::commonSize(a, b);
+  const float tc = EngineMath::clamp(t, 0.0f, 1.0f);
+  const V wa = V::set1(1.0f - tc), wb = V::set1(tc);
+  out.resize(n);
+  detail::forEachPacket(n, [&](size_t i) {
+   V qa[4], qb[4];
+   detail::loadPacket(a, i, qa);
+   detail::loadPacket(b, i, qb);
+   const V d = EU::SIMD::madd(qa[3], qb[3], EU::SIMD::madd(qa[2], qb[2], EU::SIMD::madd(qa[1], qb[1], qa[0] * qb[0])));
+   const V k = EU::SIMD::select(d < V::zero(), -wb, wb);
+   V r[4];
+   for (int c = 0; c < 4; ++c) r[c] = EU::SIMD::madd(qb[c], k, qa[c] * wa);
+   detail::normalizeRotationLanes<Policy>(r);
+   detail::storePacket(r, out, i);
+  });
+ }
+}
@@ -0,0 +1,249 @@
+/**
+ * @file SwingTwist.h
+ * @brief Swing-twist decomposition of rotations and cone/twist joint limits, for IK and ragdolls.
+ *
+ * A unit q splits as q = swing * twist, twist being the rotation about a joint axis a and
+ * swing the rotation moving a. The twist is the projection (dot(q.xyz, a) a, q.w) normalized,
+ * and its normalization length is cos(swing / 2), so both limit tests compare squared or
+ * scaled components against half-angle sines and cosines precomputed in JointLimit: no
+ * trigonometry and no square root until a joint actually has to be clamped, and then one
+ * rsqrt per part (Policy::invLength). The twist range may be asymmetric; the swing limit is
+ * a circular cone around a.
+ *
+ * A swing of half a turn leaves the twist undefined; it is taken as the identity there
+ * (twist lengths below SWING_TWIST_DEGENERATE). The batch versions run a register of joints
+ * at a time over AoS joint arrays, each joint with its own axis and limits.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Matrices/PoseBlend.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /// Squared twist length below which the twist is taken as the identity.
+ constexpr float SWING_TWIST_DEGENERATE = 1e-12f;
+
+ /**
+  * @struct JointLimit
+  * @brief Joint axis with a swing cone and a twist range, stored as half-angle sines and cosines.
+  */
+ struct
+  JointLimit {
+  CVector3 axis;     ///< Twist axis in the joint's parent space, unit length
+  float swingCos;    ///< cos(maxSwing / 2)
+  float swingSin;    ///< sin(maxSwing / 2)
+  float twistMinCos; ///< cos(minTwist / 2)
+  float twistMinSin; ///< sin(minTwist / 2)
+  float twistMaxCos; ///< cos(maxTwist / 2)
+  float twistMaxSin; ///< sin(maxTwist / 2)
+
+  /**
+   * @brief Limit from angles in radians: a swing cone of half-angle maxSwing in [0, PI] and
+   * a twist range [minTwist, maxTwist] within [-PI, PI].
+   */
+  static constexpr JointLimit
+   fromAngles(const CVector3& axis, float maxSwing, float minTwist, float maxTwist) {
+   JointLimit limit{ axis, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+   EngineMath::sincos(maxSwing * 0.5f, &limit.swingSin, &limit.swingCos);
+   EngineMath::sincos(minTwist * 0.5f, &limit.twistMinSin, &limit.twistMinCos);
+   EngineMath::sincos(maxTwist * 0.5f, &limit.twistMaxSin, &limit.twistMaxCos);
+   return limit;
+  }
+ };
+
+ EU_ASSERT_VALUE_TYPE(JointLimit);
+
+ /**
+  * @brief Splits the unit quaternion q into swing * twist, twist about the unit axis.
+  */
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 void
+  decomposeSwingTwist(const Quaternion& q, const CVector3& axis, Quaternion& swing, Quaternion& twist) {
+  const float t = q.x * axis.x + q.y * axis.y + q.z * axis.z;
+  const float lenSq = t * t + q.w * q.w;
+  if (lenSq < SWING_TWIST_DEGENERATE) {
+   twist = Quaternion();
+   swing = q;
+   return;
+  }
+  const float inv = Policy::invLength(lenSq);
+  twist = Quaternion(axis.x * (t * inv), axis.y * (t * inv), axis.z * (t * inv), q.w * inv);
+  swing = q * Quaternion(-twist.x, -twist.y, -twist.z, twist.w);
+ }
+
+ /**
+  * @brief q with its swing clamped to limit's cone and its twist to limit's range, as
+  * clampedSwing * clampedTwist. A q within both limits is returned unchanged.
+  */
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 Quaternion
+  clampSwingTwist(const Quaternion& q, const JointLimit& limit) {
+  const CVector3& a = limit.axis;
+  // Work on the sign of q whose twist has w >= 0, so half-angles lie in [-PI/2, PI/2].
+  const float flip = q.w < 0.f ? -1.f : 1.f;
+  const Quaternion p(q.x * flip, q.y * flip, q.z * flip, q.w * flip);
+  float t = p.x * a.x + p.y * a.y + p.z * a.z, tw = p.w;
+  float lenSq = t * t + tw * tw;
+  const bool overSwing = lenSq < limit.swingCos * limit.swingCos;
+  if (lenSq < SWING_TWIST_DEGENERATE) {
+   t = 0.f;
+   tw = 1.f;
+   lenSq = 1.f;
+  }
+  // sin(half - limitHalf) > 0 past the maximum, < 0 before the minimum; any positive scale works.
+  const bool overMax = t * limit.twistMaxCos - tw * limit.twistMaxSin > 0.f;
+  const bool underMin = t * limit.twistMinCos - tw * limit.twistMinSin < 0.f;
+  if (!overMax && !underMin && !overSwing) return q;
+  const float inv = Policy::invLength(lenSq);
+  const float ts = t * inv, tc = tw * inv;
+  // swing = p * conjugate(twist)
+  Quaternion s = p * Quaternion(-a.x * ts, -a.y * ts, -a.z * ts, tc);
+  if (overSwing) {
+   const float vLenSq = s.x * s.x + s.y * s.y + s.z * s.z;
+   const float k = vLenSq > 0.f ? limit.swingSin * Policy::invLength(vLenSq) : 0.f;
+   s = Quaternion(s.x * k, s.y * k, s.z * k, limit.swingCos);
+  }
+  const float cs = overMax ? limit.twistMaxSin : (underMin ? limit.twistMinSin : ts);
+  const float cc = overMax ? limit.twistMaxCos : (underMin ? limit.twistMinCos : tc);
+  return s * Quaternion(a.x * cs, a.y * cs, a.z * cs, cc);
+ }
+
+ namespace detail {
+  /** Loads in[0..count) into component lanes, identity past count. */
+  inline void
+   loadQuaternionLanes(const Quaternion* in, size_t count, BatchLanes (&q)[4]) {
+   float lanes[4][BATCH_WIDTH];
+   for (size_t k = 0; k < BATCH_WIDTH; ++k) {
+    const Quaternion v = k < count ? in[k] : Quaternion();
+    lanes[0][k] = v.x;
+    lanes[1][k] = v.y;
+    lanes[2][k] = v.z;
+    lanes[3][k] = v.w;
+   }
+   for (int c = 0; c < 4; ++c) q[c] = BatchLanes::load(lanes[c]);
+  }
+
+  /** Stores component lanes as count quaternions. */
+  inline void
+   storeQuaternionLanes(const BatchLanes (&q)[4], Quaternion* out, size_t count) {
+   float lanes[4][BATCH_WIDTH];
+   for (int c = 0; c < 4; ++c) q[c].store(lanes[c]);
+   for (size_t k = 0; k < count; ++k) out[k] = Quaternion(lanes[0][k], lanes[1][k], lanes[2][k], lanes[3][k]);
+  }
+ }
+
+ /**
+  * @brief decomposeSwingTwist() of n joints, joint i about axes[i], a register at a time.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  decomposeSwingTwistArray(const Quaternion* q, const CVector3* axes, Quaternion* swing, Quaternion* twist, size_t n) {
+  using V = detail::BatchLanes;
+  const size_t W = detail::BATCH_WIDTH;
+  for (size_t i = 0; i < n; i += W) {
+   const size_t count = n - i < W ? n - i : W;
+   float lanes[3][detail::BATCH_WIDTH] = {};
+   for (size_t k = 0; k < count; ++k) {
+    lanes[0][k] = axes[i + k].x;
+    lanes[1][k] = axes[i + k].y;
+    lanes[2][k] = axes[i + k].z;
+   }
+   const V ax = V::load(lanes[0]), ay = V::load(lanes[1]), az = V::load(lanes[2]);
+   V p[4];
+   detail::loadQuaternionLanes(q + i, count, p);
+   const V t = p[0] * ax + p[1] * ay + p[2] * az;
+   const V lenSq = t * t + p[3] * p[3];
+   const V valid = lenSq >= V::set1(SWING_TWIST_DEGENERATE);
+   const V inv = Policy::invLengthLanes(EU::SIMD::select(valid, lenSq, V::set1(1.f)));
+   const V ts = (t * inv) & valid;
+   const V tw[4] = { ax * ts, ay * ts, az * ts, EU::SIMD::select(valid, p[3] * inv, V::set1(1.f)) };
+   const V conj[4] = { -tw[0], -tw[1], -tw[2], tw[3] };
+   V s[4];
+   detail::multiplyRotationLanes(p, conj, s);
+   for (int c = 0; c < 4; ++c) s[c] = EU::SIMD::select(valid, s[c], p[c]);
+   detail::storeQuaternionLanes(tw, twist + i, count);
+   detail::storeQuaternionLanes(s, swing + i, count);
+  }
+ }
+
+ namespace detail {
+  /** JointLimit components of a register of joints. */
+  struct JointLimitLanes {
+   BatchLanes ax, ay, az, swingCos, swingSin, minCos, minSin, maxCos, maxSin;
+
+   /** Loads limits[0..count); padding lanes get an open limit (half-angles of PI/2) that never clamps. */
+   void
+    load(const JointLimit* limits, size_t count) {
+    float lanes[9][BATCH_WIDTH];
+    for (size_t k = 0; k < BATCH_WIDTH; ++k) {
+     const JointLimit l = k < count ? limits[k] : JointLimit{ CVector3(0.f, 0.f, 1.f), 0.f, 1.f, 0.f, -1.f, 0.f, 1.f };
+     const float v[9] = { l.axis.x, l.axis.y, l.axis.z, l.swingCos, l.swingSin,
+                          l.twistMinCos, l.twistMinSin, l.twistMaxCos, l.twistMaxSin };
+     for (int e = 0; e < 9; ++e) lanes[e][k] = v[e];
+    }
+    BatchLanes* fields[9] = { &ax, &ay, &az, &swingCos, &swingSin, &minCos, &minSin, &maxCos, &maxSin };
+    for (int e = 0; e < 9; ++e) *fields[e] = BatchLanes::load(lanes[e]);
+   }
+  };
+
+  /** clampSwingTwist() of the quaternion lanes q; lanes within their limits keep q exactly. */
+  template<typename Policy>
+  inline void
+   clampSwingTwistLanes(const BatchLanes (&q)[4], const JointLimitLanes& l, BatchLanes (&out)[4]) {
+   using V = BatchLanes;
+   const V zero = V::zero(), one = V::set1(1.f);
+   const V flip = EU::SIMD::select(q[3] < zero, -one, one);
+   const V p[4] = { q[0] * flip, q[1] * flip, q[2] * flip, q[3] * flip };
+   const V t0 = p[0] * l.ax + p[1] * l.ay + p[2] * l.az;
+   const V lenSq0 = t0 * t0 + p[3] * p[3];
+   const V valid = lenSq0 >= V::set1(SWING_TWIST_DEGENERATE);
+   const V t = t0 & valid, tw = EU::SIMD::select(valid, p[3], one), lenSq = EU::SIMD::select(valid, lenSq0, one);
+   const V overMax = t * l.maxCos - tw * l.maxSin > zero;
+   const V underMin = t * l.minCos - tw * l.minSin < zero;
+   const V overSwing = lenSq0 < l.swingCos * l.swingCos;
+   const V inv = Policy::invLengthLanes(lenSq);
+   const V ts = t * inv, tc = tw * inv;
+   const V conj[4] = { -l.ax * ts, -l.ay * ts, -l.az * ts, tc };
+   V s[4];
+   multiplyRotationLanes(p, conj, s);
+   const V vLenSq = s[0] * s[0] + s[1] * s[1] + s[2] * s[2];
+   const V hasAxis = vLenSq > zero;
+   const V k = (l.swingSin * Policy::invLengthLanes(EU::SIMD::select(hasAxis, vLenSq, one))) & hasAxis;
+   for (int c = 0; c < 3; ++c) s[c] = EU::SIMD::select(overSwing, s[c] * k, s[c]);
+   s[3] = EU::SIMD::select(overSwing, l.swingCos, s[3]);
+   const V cs = EU::SIMD::select(overMax, l.maxSin, EU::SIMD::select(underMin, l.minSin, ts));
+   const V cc = EU::SIMD::select(overMax, l.maxCos, EU::SIMD::select(underMin, l.minCos, tc));
+   const V twist[4] = { l.ax * cs, l.ay * cs, l.az * cs, cc };
+   V r[4];
+   multiplyRotationLanes(s, twist, r);
+   const V clamped = overMax | underMin | overSwing;
+   for (int c = 0; c < 4; ++c) out[c] = EU::SIMD::select(clamped, r[c], q[c]);
+  }
+ }
+
+ /**
+  * @brief out[i] = clampSwingTwist(in[i], limits[i]), a register of joints at a time; out may
+  * be in. Lanes within their limits keep their input exactly.
+  */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  clampSwingTwistArray(const Quaternion* in, const JointLimit* limits, Quaternion* out, size_t n) {
+  const size_t W = detail::BATCH_WIDTH;
+  for (size_t i = 0; i < n; i += W) {
+   const size_t count = n - i < W ? n - i : W;
+   detail::JointLimitLanes l;
+   l.load(limits + i, count);
+   detail::BatchLanes q[4], r[4];
+   detail::loadQuaternionLanes(in + i, count, q);
+   detail::clampSwingTwistLanes<Policy>(q, l, r);
+   detail::storeQuaternionLanes(r, out + i, count);
+  }
+ }
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <Math/Fixed.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ namespace detail {
+  /** Q32.32 sum of raw squares reduced to a Q16.16 length without intermediate overflow. */
+  constexpr Fixed
+   fixedLength(int64_t rawSquares) {
+   return Fixed::fromRaw(static_cast<int32_t>(EngineMath::detail::isqrt64(static_cast<uint64_t>(rawSquares))));
+  }
+
+  constexpr int64_t
+   rawSquare(Fixed f) {
+   return static_cast<int64_t>(f.raw) * f.raw;
+  }
+ }
+
+ /**
+  * @class FixedVector2
+  * @brief Q16.16 counterpart of CVector2 for deterministic lockstep simulation.
+  *
+  * length() and normalized() work on 64-bit sums of the raw components, so they stay exact
+  * for every representable vector instead of overflowing at |v| > 181.
+  */
+ class
+  FixedVector2 {
+  public:
+  Fixed x; ///< X component
+  Fixed y; ///< Y component
+
+  /** @brief Default constructor. Initializes to (0, 0). */
+  constexpr FixedVector2() : x(), y() {}
+
+  /** @brief Constructs a vector with given x, y values. */
+  constexpr FixedVector2(Fixed x, Fixed y) : x(x), y(y) {}
+
+  /** @brief Converts a float vector, rounding each component to the nearest step. */
+  constexpr explicit FixedVector2(const CVector2& v) : x(v.x), y(v.y) {}
+
+  /** @brief Converts back to a float vector. */
+  constexpr CVector2
+   toFloat() const {
+   return CVector2(x.toFloat(), y.toFloat());
+  }
+
+  constexpr FixedVector2 operator+(const FixedVector2& otro) const { return FixedVector2(x + otro.x, y + otro.y); }
+  constexpr FixedVector2 operator-(const FixedVector2& otro) const { return FixedVector2(x - otro.x, y - otro.y); }
+  constexpr FixedVector2 operator-() const { return FixedVector2(-x, -y); }
+  constexpr FixedVector2 operator*(Fixed s) const { return FixedVector2(x * s, y * s); }
+  constexpr FixedVector2 operator/(Fixed s) const { return FixedVector2(x / s, y / s); }
+  constexpr FixedVector2& operator+=(const FixedVector2& otro) { x += otro.x; y += otro.y; return *this; }
+  constexpr FixedVector2& operator-=(const FixedVector2& otro) { x -= otro.x; y -= otro.y; return *this; }
+  constexpr FixedVector2& operator*=(Fixed s) { x *= s; y *= s; return *this; }
+  constexpr bool operator==(const FixedVector2& otro) const { return x == otro.x && y == otro.y; }
+  constexpr bool operator!=(const FixedVector2& otro) const { return !(*this == otro); }
+
+  /** @brief Dot product. */
+  constexpr Fixed
+   dot(const FixedVector2& otro) const {
+   return x * otro.x + y * otro.y;
+  }
+
+  /** @brief Squared length (overflows for |v| > 181, prefer length() for comparisons of big vectors). */
+  constexpr Fixed
+   lengthSquared() const {
+   return x * x + y * y;
+  }
+
+  /** @brief Exact length, floor of the true value. */
+  constexpr Fixed
+   length() const {
+   return detail::fixedLength(detail::rawSquare(x) + detail::rawSquare(y));
+  }
+
+  /** @brief Returns a unit-length copy, or zero for the zero vector. */
+  constexpr FixedVector2
+   normalized() const {
+   Fixed len = length();
+   if (len.raw == 0) return FixedVector2();
+   return FixedVector2(x / len, y / len);
+  }
+
+  /** @brief Normalizes in-place. */
+  constexpr void
+   normalize() {
+   *this = normalized();
+  }
+
+  /** @brief Distance between two points. */
+  static constexpr Fixed
+   distance(const FixedVector2& a, const FixedVector2& b) {
+   return (a - b).length();
+  }
+
+  /** @brief Linear interpolation with t clamped to [0, 1]. */
+  static constexpr FixedVector2
+   lerp(const FixedVector2& a, const FixedVector2& b, Fixed t) {
+   if (t < Fixed::zero()) t = Fixed::zero();
+   if (t > Fixed::one()) t = Fixed::one();
+   return a + (b - a) * t;
+  }
+
+  /** @brief Returns the zero vector (0, 0). */
+  static constexpr FixedVector2 zero() { return FixedVector2(); }
+ };
+
+ EU_ASSERT_VALUE_TYPE(FixedVector2);
+
+ /**
+  * @class FixedVector3
+  * @brief Q16.16 counterpart of CVector3 for deterministic lockstep simulation.
+  */
+ class
+  FixedVector3 {
+  public:
+  Fixed x; ///< X component
+  Fixed y; ///< Y component
+  Fixed z; ///< Z component
+
+  /** @brief Default constructor. Initializes to (0, 0, 0). */
+  constexpr FixedVector3() : x(), y(), z() {}
+
+  /** @brief Constructs a vector with given x, y, z values. */
+  constexpr FixedVector3(Fixed x, Fixed y, Fixed z) : x(x), y(y), z(z) {}
+
+  /** @brief Converts a float vector, rounding each component to the nearest step. */
+  constexpr explicit FixedVector3(const CVector3& v) : x(v.x), y(v.y), z(v.z) {}
+
+  /** @brief Converts back to a float vector. */
+  constexpr CVector3
+   toFloat() const {
+   return CVector3(x.toFloat(), y.toFloat(), z.toFloat());
+  }
+
+  constexpr FixedVector3 operator+(const FixedVector3& otro) const { return FixedVector3(x + otro.x, y + otro.y, z + otro.z); }
+  constexpr FixedVector3 operator-(const FixedVector3& otro) const { return FixedVector3(x - otro.x, y - otro.y, z - otro.z); }
+  constexpr FixedVector3 operator-() const { return FixedVector3(-x, -y, -z); }
+  constexpr FixedVector3 operator*(Fixed s) const { return FixedVector3(x * s, y * s, z * s); }
+  constexpr FixedVector3 operator/(Fixed s) const { return FixedVector3(x / s, y / s, z / s); }
+  constexpr FixedVector3& operator+=(const FixedVector3& otro) { x += otro.x; y += otro.y; z += otro.z; return *this; }
+  constexpr FixedVector3& operator-=(const FixedVector3& otro) { x -= otro.x; y -= otro.y; z -= otro.z; return *this; }
+  constexpr FixedVector3& operator*=(Fixed s) { x *= s; y *= s; z *= s; return *this; }
+  constexpr bool operator==(const FixedVector3& otro) const { return x == otro.x && y == otro.y && z == otro.z; }
+  constexpr bool operator!=(const FixedVector3& otro) const { return !(*this == otro); }
+
+  /** @brief Dot product. */
+  constexpr Fixed
+   dot(const FixedVector3& otro) const {
+   return x * otro.x + y * otro.y + z * otro.z;
+  }
+
+  /** @brief Cross product. */
+  constexpr FixedVector3
+   cross(const FixedVector3& otro) const {
+   return FixedVector3(
+    y * otro.z - z * otro.y,
+    z * otro.x - x * otro.z,
+    x * otro.y - y * otro.x
+   );
+  }
+
+  /** @brief Squared length (overflows for |v| > 181, prefer length() for big vectors). */
+  constexpr Fixed
+   lengthSquared() const {
+   return x * x + y * y + z * z;
+  }
+
+  /** @brief Exact length, floor of the true value. */
+  constexpr Fixed
+   length() const {
+   return detail::fixedLength(detail::rawSquare(x) + detail::rawSquare(y) + detail::rawSquare(z));
+  }
+
+  /** @brief Returns a unit-length copy, or zero for the zero vector. */
+  constexpr FixedVector3
+   normalized() const {
+   Fixed len = length();
+   if (len.raw == 0) return FixedVector3();
+   return FixedVector3(x / len, y / len, z / len);
+  }
+
+  /** @brief Normalizes in-place. */
+  constexpr void
+   normalize() {
+   *this = normalized();
+  }
+
+  /** @brief Distance between two points. */
+  static constexpr Fixed
+   distance(const FixedVector3& a, const FixedVector3& b) {
+   return (a - b).length();
+  }
+
+  /** @brief Linear interpolation with t clamped to [0, 1]. */
+  static constexpr FixedVector3
+   lerp(const FixedVector3& a, const FixedVector3& b, Fixed t) {
+   if (t < Fixed::zero()) t = Fixed::zero();
+   if (t > Fixed::one()) t = Fixed::one();
+   return a + (b - a) * t;
+  }
+
+  /** @brief Returns the zero vector (0, 0, 0). */
+  static constexpr FixedVector3 zero() { return FixedVector3(); }
+ };
+
+ EU_ASSERT_VALUE_TYPE(FixedVector3);
+}
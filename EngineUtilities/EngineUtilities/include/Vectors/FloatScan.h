@@ -0,0 +1,147 @@
+/**
+ * @file FloatScan.h
+ * @brief Batch NaN / infinity / denormal census of float arrays and SoA streams, with a
+ * debug-only check macro.
+ *
+ * scanFloats() classifies a register of floats at a time from their bits: with the sign
+ * cleared, a NaN is above 0x7f800000, an infinity equals it and a denormal is nonzero but
+ * below the smallest exponent. The tests are integer compares, so the census stays right on
+ * threads running under DenormalGuard (DAZ would make a float compare read denormals as
+ * zero). FloatScan holds the three counts and the index of the first offending element.
+ *
+ * EU_CHECK_FLOATS(name, ...) scans the same arguments as scanFloats() and hands a scan that
+ * is not clean() to the float check handler (by default a line on stderr), but only in builds
+ * that define EU_FLOAT_CHECKS; otherwise it compiles to nothing, arguments included. The
+ * batch kernels that integrate or accumulate state check their outputs with it.
+ *
+ *   EU_CHECK_FLOATS("velocities", velocities);      // a Vector3Stream
+ *   const FloatScan scan = scanFloats(gains, count); // always available
+ *   if (scan.nans) reset(scan.firstBad);
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <Core/SIMD.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/IntMath.h>
+#include <Vectors/Vector3Stream.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /**
+  * @struct FloatScan
+  * @brief Counts of non-finite and denormal values found by scanFloats().
+  */
+ struct FloatScan {
+  static constexpr size_t NONE = ~size_t(0);
+
+  size_t nans = 0;
+  size_t infinities = 0;
+  size_t denormals = 0;
+  size_t firstBad = NONE; ///< Element of the first NaN, infinity or denormal; NONE when clean
+
+  bool
+   clean() const {
+   return nans == 0 && infinities == 0 && denormals == 0;
+  }
+
+  /** @brief Adds the counts of other, a scan of the elements starting at offset. */
+  FloatScan&
+   merge(const FloatScan& other, size_t offset) {
+   nans += other.nans;
+   infinities += other.infinities;
+   denormals += other.denormals;
+   if (firstBad == NONE && other.firstBad != NONE) firstBad = other.firstBad + offset;
+   return *this;
+  }
+ };
+
+ /** @brief Scans the floats p[0..n). */
+ inline FloatScan
+  scanFloats(const float* p, size_t n) {
+  using detail::BatchInt;
+  FloatScan scan;
+  const BatchInt absMask = BatchInt::set1(0x7fffffff);
+  const BatchInt infinity = BatchInt::set1(0x7f800000);
+  const BatchInt maxDenormal = BatchInt::set1(0x007fffff);
+  const BatchInt zero = BatchInt::set1(0);
+  for (size_t i = 0; i < n; i += detail::BATCH_WIDTH) {
+   // Padding lanes load as +0, which is none of the three.
+   const size_t count = std::min(detail::BATCH_WIDTH, n - i);
+   const BatchInt a = EU::SIMD::asInt(detail::loadLanes(p, i, count)) & absMask;
+   const uint32_t nan = static_cast<uint32_t>(EU::SIMD::movemask(EU::SIMD::asFloat(a > infinity)));
+   const uint32_t inf = static_cast<uint32_t>(EU::SIMD::movemask(EU::SIMD::asFloat(a == infinity)));
+   const uint32_t denormal = static_cast<uint32_t>(EU::SIMD::movemask(EU::SIMD::asFloat((a > zero) ^ (a > maxDenormal))));
+   const uint32_t bad = nan | inf | denormal;
+   if (!bad) continue;
+   scan.nans += static_cast<size_t>(EngineMath::detail::popCount(nan));
+   scan.infinities += static_cast<size_t>(EngineMath::detail::popCount(inf));
+   scan.denormals += static_cast<size_t>(EngineMath::detail::popCount(denormal));
+   if (scan.firstBad == FloatScan::NONE) scan.firstBad = i + static_cast<size_t>(EngineMath::ilog2(bad & (0u - bad)));
+  }
+  return scan;
+ }
+
+ /**
+  * @brief Scans the n vectors of an SoA view; every component counts, and firstBad is the
+  * lowest vector index with a bad component.
+  */
+ inline FloatScan
+  scanFloats(EngineMath::batch::ConstSoA3 p, size_t n) {
+  FloatScan scan = scanFloats(p.x, n);
+  const FloatScan y = scanFloats(p.y, n);
+  const FloatScan z = scanFloats(p.z, n);
+  scan.merge(y, 0).merge(z, 0);
+  scan.firstBad = std::min(scan.firstBad, std::min(y.firstBad, z.firstBad));
+  return scan;
+ }
+
+ /** @brief Scans the size() vectors of stream. */
+ inline FloatScan
+  scanFloats(const Vector3Stream& stream) {
+  return scanFloats(stream.soa(), stream.size());
+ }
+
+ /** @brief Receives every scan of EU_CHECK_FLOATS that is not clean. */
+ using FloatCheckHandler = void (*)(const char* name, const FloatScan& scan);
+
+ namespace detail {
+  inline void
+   printFloatCheck(const char* name, const FloatScan& scan) {
+   std::fprintf(stderr, "EU_CHECK_FLOATS %s: %zu NaN, %zu Inf, %zu denormal (first at %zu)\n", name,
+                scan.nans, scan.infinities, scan.denormals, scan.firstBad);
+  }
+
+  inline FloatCheckHandler&
+   floatCheckHandler() {
+   static FloatCheckHandler handler = &printFloatCheck;
+   return handler;
+  }
+
+  inline void
+   checkFloats(const char* name, const FloatScan& scan) {
+   if (!scan.clean() && floatCheckHandler()) floatCheckHandler()(name, scan);
+  }
+ }
+
+ /**
+  * @brief Replaces the EU_CHECK_FLOATS handler (nullptr silences it); returns the previous one.
+  * Set it before any thread checks.
+  */
+ inline FloatCheckHandler
+  setFloatCheckHandler(FloatCheckHandler handler) {
+  FloatCheckHandler previous = detail::floatCheckHandler();
+  detail::floatCheckHandler() = handler;
+  return previous;
+ }
+}
+
+#if defined(EU_FLOAT_CHECKS)
+ #define EU_CHECK_FLOATS(name, ...) ::EU::detail::checkFloats(name, ::EU::scanFloats(__VA_ARGS__))
+#else
+ #define EU_CHECK_FLOATS(name, ...) ((void)0)
+#endif
@@ -0,0 +1,268 @@
+/**
+ * @file ParticleIntegrate.h
+ * @brief SIMD particle integrators and lifetime compaction over Vector3Stream.
+ *
+ * Positions, velocities and accelerations live in Vector3Stream SoA arrays, so each step is
+ * a handful of multiply-adds per register of particles with no CVector3 temporaries. The
+ * integrators add ParticleForces::gravity to the per-particle accelerations (which may be
+ * omitted) and apply linear drag as v / (1 + drag dt), which stays stable for any step.
+ * Each one processes the particles that every stream passed to it has in common.
+ *
+ * Lifetimes are plain float arrays of remaining seconds: ageParticles() counts down and
+ * reports how many expired, and compactParticles() swap-removes the dead ones from any
+ * number of streams (Vector3Stream or per-particle float vectors), scanning a register of
+ * lifetimes at a time.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/SIMD.h>
+#include <Math/IntMath.h>
+#include <Vectors/FloatScan.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector3Stream.h>
+
+namespace EU {
+ /**
+  * @brief Forces shared by every particle of a step.
+  */
+ struct ParticleForces {
+  CVector3 gravity; ///< Acceleration added to every particle
+  float drag = 0.f; ///< Linear drag per second; 0 disables it
+ };
+
+ namespace detail {
+  /** Velocity factor for one step of linear drag; 1 for no (or negative) drag. */
+  inline float
+   dragFactor(float drag, float dt) {
+   return drag > 0.f ? 1.f / (1.f + drag * dt) : 1.f;
+  }
+
+  inline size_t
+   commonSize(const Vector3Stream& a, const Vector3Stream& b, const Vector3Stream* c) {
+   const size_t n = commonSize(a, b);
+   return c && c->size() < n ? c->size() : n;
+  }
+
+  /** Total acceleration of the packet at i: a[i] + g, or g alone without an acceleration stream. */
+  inline EU::SIMD::FloatN
+   acceleration(const float* a, size_t i, EU::SIMD::FloatN g) {
+   return a ? EU::SIMD::FloatN::loadAligned(a + i) + g : g;
+  }
+
+  /** One axis of explicit (semiImplicit = false) or semi-implicit Euler. */
+  inline void
+   eulerAxis(float* p, float* v, const float* a, size_t n, float gravity, float damping, float dt,
+             bool semiImplicit) {
+   using V = EU::SIMD::FloatN;
+   const V g = V::set1(gravity), damp = V::set1(damping), step = V::set1(dt);
+   forEachPacket(n, [&](size_t i) {
+    const V pos = V::loadAligned(p + i), vel = V::loadAligned(v + i);
+    const V next = EU::SIMD::madd(acceleration(a, i, g), step, vel) * damp;
+    EU::SIMD::madd(semiImplicit ? next : vel, step, pos).storeAligned(p + i);
+    next.storeAligned(v + i);
+   });
+  }
+
+  /** One axis of position Verlet: p' = p + (p - prev) damping + a dt^2, prev' = p. */
+  inline void
+   verletAxis(float* p, float* prev, const float* a, size_t n, float gravity, float damping, float dt) {
+   using V = EU::SIMD::FloatN;
+   const V g = V::set1(gravity), damp = V::set1(damping), step2 = V::set1(dt * dt);
+   forEachPacket(n, [&](size_t i) {
+    const V pos = V::loadAligned(p + i), old = V::loadAligned(prev + i);
+    EU::SIMD::madd(acceleration(a, i, g), step2, EU::SIMD::madd(pos - old, damp, pos)).storeAligned(p + i);
+    pos.storeAligned(prev + i);
+   });
+  }
+
+  template<typename Fn>
+  inline void
+   forEachAxis(Vector3Stream& a, Vector3Stream& b, const Vector3Stream* c, const CVector3& g, Fn fn) {
+   fn(a.x(), b.x(), c ? c->x() : nullptr, g.x);
+   fn(a.y(), b.y(), c ? c->y() : nullptr, g.y);
+   fn(a.z(), b.z(), c ? c->z() : nullptr, g.z);
+  }
+
+  inline void
+   moveParticle(size_t, size_t) {}
+
+  template<typename... Streams>
+  inline void
+   moveParticle(size_t to, size_t from, Vector3Stream& stream, Streams&... rest);
+
+  template<typename... Streams>
+  inline void
+   moveParticle(size_t to, size_t from, std::vector<float>& values, Streams&... rest);
+
+  /** Copies particle from over particle to in every stream. */
+  template<typename... Streams>
+  inline void
+   moveParticle(size_t to, size_t from, Vector3Stream& stream, Streams&... rest) {
+   stream.x()[to] = stream.x()[from];
+   stream.y()[to] = stream.y()[from];
+   stream.z()[to] = stream.z()[from];
+   moveParticle(to, from, rest...);
+  }
+
+  template<typename... Streams>
+  inline void
+   moveParticle(size_t to, size_t from, std::vector<float>& values, Streams&... rest) {
+   values[to] = values[from];
+   moveParticle(to, from, rest...);
+  }
+
+  inline void
+   resizeStreams(size_t) {}
+
+  template<typename... Streams>
+  inline void
+   resizeStreams(size_t n, Vector3Stream& stream, Streams&... rest);
+
+  template<typename... Streams>
+  inline void
+   resizeStreams(size_t n, std::vector<float>& values, Streams&... rest);
+
+  template<typename... Streams>
+  inline void
+   resizeStreams(size_t n, Vector3Stream& stream, Streams&... rest) {
+   stream.resize(n);
+   resizeStreams(n, rest...);
+  }
+
+  template<typename... Streams>
+  inline void
+   resizeStreams(size_t n, std::vector<float>& values, Streams&... rest) {
+   values.resize(n);
+   resizeStreams(n, rest...);
+  }
+ }
+
+ /**
+  * @brief Explicit Euler step: p += v dt, then v = (v + (a + gravity) dt) drag-damped.
+  * @param accelerations Per-particle accelerations, or nullptr for gravity only.
+  */
+ inline void
+  integrateEuler(Vector3Stream& positions, Vector3Stream& velocities, const Vector3Stream* accelerations,
+                 const ParticleForces& forces, float dt) {
+  const size_t n = detail::commonSize(positions, velocities, accelerations);
+  const float damping = detail::dragFactor(forces.drag, dt);
+  detail::forEachAxis(positions, velocities, accelerations, forces.gravity,
+                      [&](float* p, float* v, const float* a, float g) {
+                       detail::eulerAxis(p, v, a, n, g, damping, dt, false);
+                      });
+  EU_CHECK_FLOATS("particle positions", positions.soa(), n);
+  EU_CHECK_FLOATS("particle velocities", velocities.soa(), n);
+ }
+
+ /**
+  * @brief Semi-implicit (symplectic) Euler step: v updates first and p moves by the new v.
+  *
+  * Same cost as integrateEuler() but keeps orbits and springs from gaining energy.
+  */
+ inline void
+  integrateSemiImplicitEuler(Vector3Stream& positions, Vector3Stream& velocities,
+                             const Vector3Stream* accelerations, const ParticleForces& forces, float dt) {
+  const size_t n = detail::commonSize(positions, velocities, accelerations);
+  const float damping = detail::dragFactor(forces.drag, dt);
+  detail::forEachAxis(positions, velocities, accelerations, forces.gravity,
+                      [&](float* p, float* v, const float* a, float g) {
+                       detail::eulerAxis(p, v, a, n, g, damping, dt, true);
+                      });
+  EU_CHECK_FLOATS("particle positions", positions.soa(), n);
+  EU_CHECK_FLOATS("particle velocities", velocities.soa(), n);
+ }
+
+ /**
+  * @brief Position Verlet step; velocity is implied by positions - previous.
+  *
+  * previous receives the positions from before the step. The implied velocity assumes a
+  * fixed dt: rescale positions - previous when the step changes. Start with previous equal
+  * to positions - v0 dt.
+  */
+ inline void
+  integrateVerlet(Vector3Stream& positions, Vector3Stream& previous, const Vector3Stream* accelerations,
+                  const ParticleForces& forces, float dt) {
+  const size_t n = detail::commonSize(positions, previous, accelerations);
+  const float damping = detail::dragFactor(forces.drag, dt);
+  detail::forEachAxis(positions, previous, accelerations, forces.gravity,
+                      [&](float* p, float* prev, const float* a, float g) {
+                       detail::verletAxis(p, prev, a, n, g, damping, dt);
+                      });
+  EU_CHECK_FLOATS("particle positions", positions.soa(), n);
+  EU_CHECK_FLOATS("particle previous", previous.soa(), n);
+ }
+
+ /**
+  * @brief lifetimes[i] -= dt for every particle.
+  * @return Number of particles whose lifetime is no longer positive.
+  */
+ inline size_t
+  ageParticles(float* lifetimes, size_t n, float dt) {
+  using V = EU::SIMD::FloatN;
+  const size_t W = static_cast<size_t>(V::WIDTH);
+  const V step = V::set1(dt), zero = V::zero();
+  size_t dead = 0;
+  size_t i = 0;
+  for (; i + W <= n; i += W) {
+   const V life = V::load(lifetimes + i) - step;
+   life.store(lifetimes + i);
+   dead += W - static_cast<size_t>(EngineMath::detail::popCount(static_cast<uint64_t>(EU::SIMD::movemask(life > zero))));
+  }
+  for (; i < n; ++i) {
+   lifetimes[i] -= dt;
+   dead += lifetimes[i] > 0.f ? 0 : 1;
+  }
+  return dead;
+ }
+
+ /**
+  * @brief Removes every particle whose lifetime is not positive from lifetimes and streams.
+  *
+  * A dead particle is overwritten by the last live one, so the live particles stay packed at
+  * the front but change order. Runs of live particles are skipped a register at a time.
+  * Each stream (a Vector3Stream or a std::vector<float>) must hold at least n particles and
+  * is resized to the survivors.
+  * @return Number of live particles.
+  */
+ template<typename... Streams>
+ inline size_t
+  compactParticles(float* lifetimes, size_t n, Streams&... streams) {
+  using V = EU::SIMD::FloatN;
+  const size_t W = static_cast<size_t>(V::WIDTH);
+  const uint32_t allAlive = (1u << W) - 1u;
+  const V zero = V::zero();
+  size_t end = n;
+  size_t i = 0;
+  while (i < end) {
+   if (end - i >= W) {
+    const uint32_t alive = static_cast<uint32_t>(EU::SIMD::movemask(V::load(lifetimes + i) > zero));
+    if (alive == allAlive) {
+     i += W;
+     continue;
+    }
+    // Skip to the first dead lane: the lowest clear bit of alive.
+    i += static_cast<size_t>(EngineMath::detail::popCount(static_cast<uint64_t>(~alive & (alive + 1u)) - 1u));
+   }
+   else if (lifetimes[i] > 0.f) {
+    ++i;
+    continue;
+   }
+   // lifetimes[i] is dead: drop dead particles off the end, then move the last live one here.
+   do {
+    --end;
+   } while (end > i && !(lifetimes[end] > 0.f));
+   if (end == i) {
+    break;
+   }
+   lifetimes[i] = lifetimes[end];
+   detail::moveParticle(i, end, streams...);
+   ++i;
+  }
+  detail::resizeStreams(end, streams...);
+  return end;
+ }
+}
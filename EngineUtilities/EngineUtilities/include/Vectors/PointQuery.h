@@ -0,0 +1,215 @@
+/**
+ * @file PointQuery.h
+ * @brief Nearest, k-nearest and radius queries from one point against a CVector2/CVector3 set.
+ *
+ * Everything runs on squared distances, so no square root is ever taken. nearestIndex()
+ * keeps a running minimum and its index per SIMD lane and reduces the lanes once at the
+ * end; nearestIndices() and indicesWithinRadius() skip whole packets whose lanes all miss
+ * the current bound. Sets are plain AoS arrays or SoA views, as in VectorBatch.h, and hold
+ * fewer than 2^31 points. Ties resolve to the lower index.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <Core/SIMD.h>
+#include <Math/EngineMathBatch.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ namespace detail {
+  /** Calls fn(i, count, d2) with the squared distances from point for every packet. */
+  template<typename In, typename Fn>
+  inline void
+   forEachDistanceSquared(const CVector2& point, In in, size_t n, Fn fn) {
+   const BatchLanes px = BatchLanes::set1(point.x), py = BatchLanes::set1(point.y);
+   forEachPacket2(in, n, [&](size_t i, size_t count, BatchLanes x, BatchLanes y) {
+    BatchLanes dx = x - px, dy = y - py;
+    fn(i, count, dx * dx + dy * dy);
+   });
+  }
+
+  template<typename In, typename Fn>
+  inline void
+   forEachDistanceSquared(const CVector3& point, In in, size_t n, Fn fn) {
+   const BatchLanes px = BatchLanes::set1(point.x), py = BatchLanes::set1(point.y), pz = BatchLanes::set1(point.z);
+   forEachPacket3(in, n, [&](size_t i, size_t count, BatchLanes x, BatchLanes y, BatchLanes z) {
+    BatchLanes dx = x - px, dy = y - py, dz = z - pz;
+    fn(i, count, dx * dx + dy * dy + dz * dz);
+   });
+  }
+
+  /** Lane-wise argmin over the whole set, then one horizontal reduction. */
+  template<typename Point, typename In>
+  inline size_t
+   nearest(const Point& point, In in, size_t n) {
+   if (n == 0) {
+    return 0;
+   }
+   static const int32_t iota[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+   const BatchLanes infinity = EU::SIMD::asFloat(BatchInt::set1(0x7f800000));
+   const BatchInt step = BatchInt::set1(static_cast<int>(BATCH_WIDTH));
+   BatchLanes best = infinity;
+   BatchLanes bestIndex = BatchLanes::zero();
+   BatchInt index = BatchInt::load(iota);
+   forEachDistanceSquared(point, in, n, [&](size_t, size_t count, BatchLanes d2) {
+    if (count < BATCH_WIDTH) d2 = EU::SIMD::select(firstLanes(count), d2, infinity);
+    BatchLanes closer = d2 < best;
+    best = EU::SIMD::select(closer, d2, best);
+    bestIndex = EU::SIMD::select(closer, EU::SIMD::asFloat(index), bestIndex);
+    index = index + step;
+   });
+   float d[BATCH_WIDTH];
+   int32_t idx[BATCH_WIDTH];
+   best.store(d);
+   EU::SIMD::asInt(bestIndex).store(idx);
+   size_t lane = 0;
+   for (size_t j = 1; j < BATCH_WIDTH; ++j) {
+    if (d[j] < d[lane] || (d[j] == d[lane] && idx[j] < idx[lane])) lane = j;
+   }
+   return static_cast<size_t>(idx[lane]);
+  }
+
+  /** k smallest squared distances, kept in a max-heap bounded by the current k-th distance. */
+  template<typename Point, typename In>
+  inline size_t
+   nearestK(const Point& point, In in, size_t n, size_t k, uint32_t* out) {
+   if (k > n) k = n;
+   if (k == 0) {
+    return 0;
+   }
+   std::vector<std::pair<float, uint32_t>> heap;
+   heap.reserve(k);
+   BatchLanes bound = EU::SIMD::asFloat(BatchInt::set1(0x7f800000));
+   forEachDistanceSquared(point, in, n, [&](size_t i, size_t count, BatchLanes d2) {
+    int hits = EU::SIMD::movemask(d2 <= bound) & ((1 << count) - 1);
+    if (heap.size() < k) hits = (1 << count) - 1;
+    if (hits == 0) {
+     return;
+    }
+    float d[BATCH_WIDTH];
+    d2.store(d);
+    for (size_t j = 0; j < count; ++j) {
+     if (!(hits & (1 << j))) continue;
+     std::pair<float, uint32_t> candidate(d[j], static_cast<uint32_t>(i + j));
+     if (heap.size() < k) {
+      heap.push_back(candidate);
+      std::push_heap(heap.begin(), heap.end());
+     } else if (candidate < heap.front()) {
+      std::pop_heap(heap.begin(), heap.end());
+      heap.back() = candidate;
+      std::push_heap(heap.begin(), heap.end());
+     }
+    }
+    if (heap.size() == k) bound = BatchLanes::set1(heap.front().first);
+   });
+   std::sort_heap(heap.begin(), heap.end());
+   for (size_t j = 0; j < k; ++j) out[j] = heap[j].second;
+   return k;
+  }
+
+  /** Every index with squared distance <= radius^2, in ascending order. */
+  template<typename Point, typename In>
+  inline size_t
+   withinRadius(const Point& point, In in, size_t n, float radius, uint32_t* out) {
+   const BatchLanes r2 = BatchLanes::set1(radius * radius);
+   size_t found = 0;
+   forEachDistanceSquared(point, in, n, [&](size_t i, size_t count, BatchLanes d2) {
+    int hits = EU::SIMD::movemask(d2 <= r2) & ((1 << count) - 1);
+    for (size_t j = 0; hits != 0; ++j, hits >>= 1) {
+     if (hits & 1) out[found++] = static_cast<uint32_t>(i + j);
+    }
+   });
+   return found;
+  }
+ }
+
+ // --- CVector3 ---
+
+ /** @brief Index of the point closest to point, or 0 for an empty set. */
+ inline size_t
+  nearestIndex(const CVector3& point, const CVector3* points, size_t n) {
+  return detail::nearest(point, reinterpret_cast<const float*>(points), n);
+ }
+
+ /** @brief SoA nearestIndex(). */
+ inline size_t
+  nearestIndex(const CVector3& point, EngineMath::batch::ConstSoA3 points, size_t n) {
+  return detail::nearest(point, points, n);
+ }
+
+ /**
+  * @brief Writes the indices of the min(k, n) closest points to out, closest first.
+  * @return Number of indices written.
+  */
+ inline size_t
+  nearestIndices(const CVector3& point, const CVector3* points, size_t n, size_t k, uint32_t* out) {
+  return detail::nearestK(point, reinterpret_cast<const float*>(points), n, k, out);
+ }
+
+ /** @brief SoA nearestIndices(). */
+ inline size_t
+  nearestIndices(const CVector3& point, EngineMath::batch::ConstSoA3 points, size_t n, size_t k, uint32_t* out) {
+  return detail::nearestK(point, points, n, k, out);
+ }
+
+ /**
+  * @brief Writes the indices of all points within radius (inclusive) to out, in ascending order.
+  * @param out Room for up to n indices.
+  * @return Number of indices written.
+  */
+ inline size_t
+  indicesWithinRadius(const CVector3& point, const CVector3* points, size_t n, float radius, uint32_t* out) {
+  return detail::withinRadius(point, reinterpret_cast<const float*>(points), n, radius, out);
+ }
+
+ /** @brief SoA indicesWithinRadius(). */
+ inline size_t
+  indicesWithinRadius(const CVector3& point, EngineMath::batch::ConstSoA3 points, size_t n, float radius, uint32_t* out) {
+  return detail::withinRadius(point, points, n, radius, out);
+ }
+
+ // --- CVector2 ---
+
+ /** @brief Index of the point closest to point, or 0 for an empty set. */
+ inline size_t
+  nearestIndex(const CVector2& point, const CVector2* points, size_t n) {
+  return detail::nearest(point, reinterpret_cast<const float*>(points), n);
+ }
+
+ /** @brief SoA nearestIndex(). */
+ inline size_t
+  nearestIndex(const CVector2& point, EngineMath::batch::ConstSoA2 points, size_t n) {
+  return detail::nearest(point, points, n);
+ }
+
+ /** @brief Writes the indices of the min(k, n) closest points to out, closest first. */
+ inline size_t
+  nearestIndices(const CVector2& point, const CVector2* points, size_t n, size_t k, uint32_t* out) {
+  return detail::nearestK(point, reinterpret_cast<const float*>(points), n, k, out);
+ }
+
+ /** @brief SoA nearestIndices(). */
+ inline size_t
+  nearestIndices(const CVector2& point, EngineMath::batch::ConstSoA2 points, size_t n, size_t k, uint32_t* out) {
+  return detail::nearestK(point, points, n, k, out);
+ }
+
+ /** @brief Writes the indices of all points within radius (inclusive) to out, in ascending order. */
+ inline size_t
+  indicesWithinRadius(const CVector2& point, const CVector2* points, size_t n, float radius, uint32_t* out) {
+  return detail::withinRadius(point, reinterpret_cast<const float*>(points), n, radius, out);
+ }
+
+ /** @brief SoA indicesWithinRadius(). */
+ inline size_t
+  indicesWithinRadius(const CVector2& point, EngineMath::batch::ConstSoA2 points, size_t n, float radius, uint32_t* out) {
+  return detail::withinRadius(point, points, n, radius, out);
+ }
+}
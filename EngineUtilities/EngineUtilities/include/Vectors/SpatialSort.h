@@ -0,0 +1,268 @@
+/**
+ * @file SpatialSort.h
+ * @brief Locality ordering of CVector2/CVector3 sets by Morton or Hilbert key.
+ *
+ * spatialKeys() quantizes each point inside a bounding box to the integer grid of
+ * SpatialKey.h and encodes it. radixSort() is a stable LSD radix sort of 64-bit keys that
+ * carries a uint32_t payload, normally point indices; byte passes where every key agrees
+ * are skipped. spatialOrder() combines the two into a permutation, which applyOrder() uses
+ * to reorder the points or any array indexed like them. spatialSort() reorders a point array
+ * directly.
+ *
+ * Large inputs are split into fixed-size chunks over threads (0 = hardware_concurrency(),
+ * 1 = caller only). The chunking never depends on the thread count, so results are identical
+ * for any thread count. Sets hold fewer than 2^32 points.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Math/SpatialKey.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorReduce.h>
+
+namespace EU {
+ /**
+  * @brief Space-filling curve used for the keys.
+  */
+ enum class SpatialCurve {
+  Morton, ///< Z-order; one bit interleave per key (pdep with BMI2)
+  Hilbert ///< No jumps between distant cells; a loop over the bits per key
+ };
+
+ namespace detail {
+  /// Elements per key or radix task; fixes the work split.
+  constexpr size_t SPATIAL_CHUNK = 1 << 16;
+  /// Inputs smaller than this stay on the calling thread.
+  constexpr size_t PARALLEL_SPATIAL_MIN = 1 << 17;
+  /// Radix digit width and bucket count.
+  constexpr int RADIX_BITS = 8;
+  constexpr size_t RADIX_BUCKETS = size_t(1) << RADIX_BITS;
+
+  /** Threads for n elements in tasks chunks: 1 below PARALLEL_SPATIAL_MIN. */
+  inline size_t
+   spatialThreads(size_t threads, size_t n, size_t tasks) {
+   return n < PARALLEL_SPATIAL_MIN ? 1 : resolveThreads(threads, tasks);
+  }
+
+  /** Grid step so that (v - lo) * scale spans [0, limit] over [lo, hi]; 0 for an empty extent. */
+  inline float
+   quantizeScale(float lo, float hi, uint32_t limit) {
+   const float extent = hi - lo;
+   return extent > 0.f ? static_cast<float>(limit) / extent : 0.f;
+  }
+
+  /** Grid cell of v, clamped to [0, limit]; NaN maps to 0. */
+  inline uint32_t
+   quantize(float v, float lo, float scale, uint32_t limit) {
+   const float q = (v - lo) * scale;
+   if (!(q > 0.f)) return 0;
+   if (q >= static_cast<float>(limit)) return limit;
+   return static_cast<uint32_t>(q);
+  }
+
+  /** Calls fn(begin, end) for every SPATIAL_CHUNK-sized range of [0, n). */
+  template<typename Fn>
+  inline void
+   forEachChunk(size_t n, size_t threads, Fn fn) {
+   const size_t chunks = (n + SPATIAL_CHUNK - 1) / SPATIAL_CHUNK;
+   parallelTasks(chunks, spatialThreads(threads, n, chunks), [&](size_t c) {
+    const size_t begin = c * SPATIAL_CHUNK;
+    fn(begin, n - begin < SPATIAL_CHUNK ? n : begin + SPATIAL_CHUNK);
+   });
+  }
+ }
+
+ /**
+  * @brief keys[i] = key of points[i] on a 2^21 grid spanning box.
+  *
+  * Points outside box are clamped to its faces.
+  */
+ inline void
+  spatialKeys(const CVector3* points, size_t n, uint64_t* keys, const Bounds3& box,
+              SpatialCurve curve = SpatialCurve::Morton, size_t threads = 0) {
+  const uint32_t limit = (1u << EngineMath::MORTON_BITS3) - 1u;
+  const CVector3 lo = box.minimum;
+  const float sx = detail::quantizeScale(lo.x, box.maximum.x, limit);
+  const float sy = detail::quantizeScale(lo.y, box.maximum.y, limit);
+  const float sz = detail::quantizeScale(lo.z, box.maximum.z, limit);
+  detail::forEachChunk(n, threads, [&](size_t begin, size_t end) {
+   for (size_t i = begin; i < end; ++i) {
+    const uint32_t x = detail::quantize(points[i].x, lo.x, sx, limit);
+    const uint32_t y = detail::quantize(points[i].y, lo.y, sy, limit);
+    const uint32_t z = detail::quantize(points[i].z, lo.z, sz, limit);
+    keys[i] = curve == SpatialCurve::Hilbert ? EngineMath::hilbert3(x, y, z) : EngineMath::morton3(x, y, z);
+   }
+  });
+ }
+
+ /** @brief spatialKeys() over the set's own bounds(). */
+ inline void
+  spatialKeys(const CVector3* points, size_t n, uint64_t* keys, SpatialCurve curve = SpatialCurve::Morton,
+              size_t threads = 0) {
+  spatialKeys(points, n, keys, bounds(points, n, threads), curve, threads);
+ }
+
+ /**
+  * @brief keys[i] = key of points[i] on a 2^32 grid spanning box.
+  *
+  * Points outside box are clamped to its edges.
+  */
+ inline void
+  spatialKeys(const CVector2* points, size_t n, uint64_t* keys, const Bounds2& box,
+              SpatialCurve curve = SpatialCurve::Morton, size_t threads = 0) {
+  const uint32_t limit = 0xffffffffu;
+  const CVector2 lo = box.minimum;
+  const float sx = detail::quantizeScale(lo.x, box.maximum.x, limit);
+  const float sy = detail::quantizeScale(lo.y, box.maximum.y, limit);
+  detail::forEachChunk(n, threads, [&](size_t begin, size_t end) {
+   for (size_t i = begin; i < end; ++i) {
+    const uint32_t x = detail::quantize(points[i].x, lo.x, sx, limit);
+    const uint32_t y = detail::quantize(points[i].y, lo.y, sy, limit);
+    keys[i] = curve == SpatialCurve::Hilbert ? EngineMath::hilbert2(x, y) : EngineMath::morton2(x, y);
+   }
+  });
+ }
+
+ /** @brief spatialKeys() over the set's own bounds(). */
+ inline void
+  spatialKeys(const CVector2* points, size_t n, uint64_t* keys, SpatialCurve curve = SpatialCurve::Morton,
+              size_t threads = 0) {
+  spatialKeys(points, n, keys, bounds(points, n, threads), curve, threads);
+ }
+
+ /**
+  * @brief Stable ascending sort of keys[0..n), applying the same permutation to values.
+  *
+  * @param values Payload moved with each key, e.g. indices; may be nullptr.
+  */
+ inline void
+  radixSort(uint64_t* keys, uint32_t* values, size_t n, size_t threads = 0) {
+  if (n < 2) {
+   return;
+  }
+  const size_t chunks = (n + detail::SPATIAL_CHUNK - 1) / detail::SPATIAL_CHUNK;
+  threads = detail::spatialThreads(threads, n, chunks);
+  auto chunkEnd = [&](size_t c) {
+   return n - c * detail::SPATIAL_CHUNK < detail::SPATIAL_CHUNK ? n : (c + 1) * detail::SPATIAL_CHUNK;
+  };
+
+  // Bits that differ from keys[0] anywhere; digits without one are already in order.
+  std::vector<uint64_t> differ(chunks, 0);
+  detail::parallelTasks(chunks, threads, [&](size_t c) {
+   uint64_t bits = 0;
+   for (size_t i = c * detail::SPATIAL_CHUNK, end = chunkEnd(c); i < end; ++i) bits |= keys[i] ^ keys[0];
+   differ[c] = bits;
+  });
+  uint64_t varying = 0;
+  for (uint64_t bits : differ) varying |= bits;
+  if (varying == 0) {
+   return;
+  }
+
+  std::vector<uint64_t> keyScratch(n);
+  std::vector<uint32_t> valueScratch(values ? n : 0);
+  std::vector<size_t> offsets(chunks * detail::RADIX_BUCKETS);
+  uint64_t* keySrc = keys;
+  uint64_t* keyDst = keyScratch.data();
+  uint32_t* valueSrc = values;
+  uint32_t* valueDst = values ? valueScratch.data() : nullptr;
+
+  for (int shift = 0; shift < 64; shift += detail::RADIX_BITS) {
+   if (((varying >> shift) & (detail::RADIX_BUCKETS - 1)) == 0) {
+    continue;
+   }
+   detail::parallelTasks(chunks, threads, [&](size_t c) {
+    size_t* count = &offsets[c * detail::RADIX_BUCKETS];
+    for (size_t d = 0; d < detail::RADIX_BUCKETS; ++d) count[d] = 0;
+    for (size_t i = c * detail::SPATIAL_CHUNK, end = chunkEnd(c); i < end; ++i) {
+     ++count[(keySrc[i] >> shift) & (detail::RADIX_BUCKETS - 1)];
+    }
+   });
+   // Digit-major, chunk-minor prefix sum: earlier chunks land first, which keeps the sort stable.
+   size_t total = 0;
+   for (size_t d = 0; d < detail::RADIX_BUCKETS; ++d) {
+    for (size_t c = 0; c < chunks; ++c) {
+     const size_t count = offsets[c * detail::RADIX_BUCKETS + d];
+     offsets[c * detail::RADIX_BUCKETS + d] = total;
+     total += count;
+    }
+   }
+   detail::parallelTasks(chunks, threads, [&](size_t c) {
+    size_t* next = &offsets[c * detail::RADIX_BUCKETS];
+    for (size_t i = c * detail::SPATIAL_CHUNK, end = chunkEnd(c); i < end; ++i) {
+     const size_t to = next[(keySrc[i] >> shift) & (detail::RADIX_BUCKETS - 1)]++;
+     keyDst[to] = keySrc[i];
+     if (valueSrc) valueDst[to] = valueSrc[i];
+    }
+   });
+   std::swap(keySrc, keyDst);
+   std::swap(valueSrc, valueDst);
+  }
+
+  if (keySrc != keys) {
+   detail::forEachChunk(n, threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+     keys[i] = keySrc[i];
+     if (values) values[i] = valueSrc[i];
+    }
+   });
+  }
+ }
+
+ /**
+  * @brief order[0..n) = indices of points sorted along the curve; equal keys keep index order.
+  */
+ inline void
+  spatialOrder(const CVector3* points, size_t n, uint32_t* order, SpatialCurve curve = SpatialCurve::Morton,
+               size_t threads = 0) {
+  std::vector<uint64_t> keys(n);
+  spatialKeys(points, n, keys.data(), curve, threads);
+  for (size_t i = 0; i < n; ++i) order[i] = static_cast<uint32_t>(i);
+  radixSort(keys.data(), order, n, threads);
+ }
+
+ /** @brief spatialOrder() for a CVector2 set. */
+ inline void
+  spatialOrder(const CVector2* points, size_t n, uint32_t* order, SpatialCurve curve = SpatialCurve::Morton,
+               size_t threads = 0) {
+  std::vector<uint64_t> keys(n);
+  spatialKeys(points, n, keys.data(), curve, threads);
+  for (size_t i = 0; i < n; ++i) order[i] = static_cast<uint32_t>(i);
+  radixSort(keys.data(), order, n, threads);
+ }
+
+ /**
+  * @brief out[i] = in[order[i]], e.g. to reorder velocities or colors to match spatialOrder().
+  *
+  * @p out must not overlap @p in.
+  */
+ template<typename T>
+ inline void
+  applyOrder(const T* in, T* out, const uint32_t* order, size_t n) {
+  for (size_t i = 0; i < n; ++i) out[i] = in[order[i]];
+ }
+
+ /** @brief Reorders points[0..n) in place along the curve. */
+ inline void
+  spatialSort(CVector3* points, size_t n, SpatialCurve curve = SpatialCurve::Morton, size_t threads = 0) {
+  std::vector<uint32_t> order(n);
+  spatialOrder(points, n, order.data(), curve, threads);
+  const std::vector<CVector3> copy(points, points + n);
+  applyOrder(copy.data(), points, order.data(), n);
+ }
+
+ /** @brief Reorders points[0..n) in place along the curve. */
+ inline void
+  spatialSort(CVector2* points, size_t n, SpatialCurve curve = SpatialCurve::Morton, size_t threads = 0) {
+  std::vector<uint32_t> order(n);
+  spatialOrder(points, n, order.data(), curve, threads);
+  const std::vector<CVector2> copy(points, points + n);
+  applyOrder(copy.data(), points, order.data(), n);
+ }
+}
@@ -0,0 +1,407 @@
+/**
+ * @file Vector.h
+ * @brief Generic EU::Vector<T, N> for any arithmetic element type, N = 2, 3 or 4.
+ *
+ * Vector<float, N> names the existing CVector2/3/4, so float code keeps its constexpr API and
+ * precision policies; every other element type (int tile coordinates, double world positions,
+ * uint8_t colors) gets BasicVector<T, N>, written once with the same interface. 4 x int32
+ * arithmetic runs on one EU::SIMD::Int4 register.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Vectors/VectorComponents.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector4.h>
+
+namespace EU {
+ namespace detail {
+  /** Named components and index access for N = 2, 3 and 4. */
+  template<typename T, int N> struct VectorStorage;
+
+  template<typename T>
+  struct VectorStorage<T, 2> {
+   T x; ///< X component
+   T y; ///< Y component
+   constexpr VectorStorage() : x(), y() {}
+   explicit VectorStorage(EU::NoInitTag) {}
+   constexpr VectorStorage(T x, T y) : x(x), y(y) {}
+   constexpr T& operator[](int i) { return Components::get(*this, i); }
+   constexpr const T& operator[](int i) const { return Components::get(*this, i); }
+  private:
+   using Components = ComponentTable<VectorStorage, T, &VectorStorage::x, &VectorStorage::y>;
+  };
+
+  template<typename T>
+  struct VectorStorage<T, 3> {
+   T x; ///< X component
+   T y; ///< Y component
+   T z; ///< Z component
+   constexpr VectorStorage() : x(), y(), z() {}
+   explicit VectorStorage(EU::NoInitTag) {}
+   constexpr VectorStorage(T x, T y, T z) : x(x), y(y), z(z) {}
+   constexpr T& operator[](int i) { return Components::get(*this, i); }
+   constexpr const T& operator[](int i) const { return Components::get(*this, i); }
+  private:
+   using Components = ComponentTable<VectorStorage, T, &VectorStorage::x, &VectorStorage::y, &VectorStorage::z>;
+  };
+
+  template<typename T>
+  struct VectorStorage<T, 4> {
+   T x; ///< X component
+   T y; ///< Y component
+   T z; ///< Z component
+   T w; ///< W component
+   constexpr VectorStorage() : x(), y(), z(), w() {}
+   explicit VectorStorage(EU::NoInitTag) {}
+   constexpr VectorStorage(T x, T y, T z, T w) : x(x), y(y), z(z), w(w) {}
+   constexpr T& operator[](int i) { return Components::get(*this, i); }
+   constexpr const T& operator[](int i) const { return Components::get(*this, i); }
+  private:
+   using Components = ComponentTable<VectorStorage, T, &VectorStorage::x, &VectorStorage::y, &VectorStorage::z, &VectorStorage::w>;
+  };
+
+  /** Component-wise kernels; specialized where a layout fills a SIMD register. */
+  template<typename T, int N>
+  struct VectorOps {
+   template<typename V>
+   static constexpr void
+    add(V& out, const V& a, const V& b) {
+    for (int i = 0; i < N; ++i) out[i] = static_cast<T>(a[i] + b[i]);
+   }
+
+   template<typename V>
+   static constexpr void
+    sub(V& out, const V& a, const V& b) {
+    for (int i = 0; i < N; ++i) out[i] = static_cast<T>(a[i] - b[i]);
+   }
+
+   template<typename V>
+   static constexpr void
+    mul(V& out, const V& a, const V& b) {
+    for (int i = 0; i < N; ++i) out[i] = static_cast<T>(a[i] * b[i]);
+   }
+  };
+
+  /** 4 x int32 runs on one Int4 register (plain loops during constant evaluation). */
+  template<>
+  struct VectorOps<int32_t, 4> {
+   template<typename V, typename Op, typename Scalar>
+   static EU_CONSTEXPR20 void
+    apply(V& out, const V& a, const V& b, Op op, Scalar scalar) {
+#if defined(EU_HAS_CONSTEXPR_BITS)
+    if (std::is_constant_evaluated()) {
+     for (int i = 0; i < 4; ++i) out[i] = scalar(a[i], b[i]);
+     return;
+    }
+#endif
+    (void)scalar;
+    op(EU::SIMD::Int4::load(&a.x), EU::SIMD::Int4::load(&b.x)).store(&out.x);
+   }
+
+   template<typename V>
+   static EU_CONSTEXPR20 void
+    add(V& out, const V& a, const V& b) {
+    apply(out, a, b, [](EU::SIMD::Int4 p, EU::SIMD::Int4 q) { return p + q; },
+          [](int32_t p, int32_t q) { return static_cast<int32_t>(static_cast<uint32_t>(p) + static_cast<uint32_t>(q)); });
+   }
+
+   template<typename V>
+   static EU_CONSTEXPR20 void
+    sub(V& out, const V& a, const V& b) {
+    apply(out, a, b, [](EU::SIMD::Int4 p, EU::SIMD::Int4 q) { return p - q; },
+          [](int32_t p, int32_t q) { return static_cast<int32_t>(static_cast<uint32_t>(p) - static_cast<uint32_t>(q)); });
+   }
+
+   template<typename V>
+   static EU_CONSTEXPR20 void
+    mul(V& out, const V& a, const V& b) {
+    apply(out, a, b, [](EU::SIMD::Int4 p, EU::SIMD::Int4 q) { return p * q; },
+          [](int32_t p, int32_t q) { return static_cast<int32_t>(static_cast<uint32_t>(p) * static_cast<uint32_t>(q)); });
+   }
+  };
+
+  /** Square root in the element type's own precision. */
+  EU_CONSTEXPR20 float vectorSqrt(float value) { return EngineMath::sqrt(value); }
+  EU_CONSTEXPR20 double vectorSqrt(double value) { return EngineMath::sqrtDouble(value); }
+ }
+
+ /**
+  * @class BasicVector
+  * @brief N-component vector of T with the CVector2/3/4 interface.
+  *
+  * Arithmetic wraps around for integer T like the built-in operators on T. length(),
+  * normalized(), distance() and lerp() need a floating-point T; cross() needs N == 3.
+  * @tparam T Arithmetic element type.
+  * @tparam N Component count, 2 to 4.
+  */
+ template<typename T, int N>
+ class
+  BasicVector : public detail::VectorStorage<T, N> {
+  static_assert(std::is_arithmetic<T>::value, "BasicVector needs an arithmetic element type");
+  static_assert(N >= 2 && N <= 4, "BasicVector supports 2, 3 or 4 components");
+  using Storage = detail::VectorStorage<T, N>;
+  using Ops = detail::VectorOps<T, N>;
+
+  public:
+  using value_type = T;
+  static constexpr int SIZE = N;
+
+  using Storage::Storage;
+
+  /** @brief Default constructor. Initializes every component to 0. */
+  constexpr BasicVector() : Storage() {}
+
+  /** @brief Leaves every component uninitialized; see EU::NoInit. */
+  explicit BasicVector(EU::NoInitTag tag) : Storage(tag) {}
+
+  /** @brief Converts from any vector of the same size with x, y, (z, w) members. */
+  template<typename Other, typename = decltype(std::declval<const Other&>().x)>
+  constexpr explicit BasicVector(const Other& other) : Storage() {
+   convertFrom(other);
+  }
+
+  /** @brief Converts to another vector type of the same size, e.g. `v.as<CVector3>()`. */
+  template<typename Other>
+  constexpr Other
+   as() const {
+   using C = typename std::decay<decltype(std::declval<Other&>().x)>::type;
+   Other out;
+   out.x = static_cast<C>(this->x);
+   out.y = static_cast<C>(this->y);
+   copyRest<C>(out, std::integral_constant<int, N>());
+   return out;
+  }
+
+  /** @brief Adds two vectors. */
+  constexpr BasicVector
+   operator+(const BasicVector& otro) const {
+   BasicVector r;
+   Ops::add(r, *this, otro);
+   return r;
+  }
+
+  /** @brief Subtracts one vector from another. */
+  constexpr BasicVector
+   operator-(const BasicVector& otro) const {
+   BasicVector r;
+   Ops::sub(r, *this, otro);
+   return r;
+  }
+
+  /** @brief Multiplies the vector by a scalar. */
+  constexpr BasicVector
+   operator*(T sca) const {
+   BasicVector r;
+   Ops::mul(r, *this, splat(sca));
+   return r;
+  }
+
+  /** @brief Divides the vector by a scalar. */
+  constexpr BasicVector
+   operator/(T sca) const {
+   BasicVector r;
+   for (int i = 0; i < N; ++i) r[i] = static_cast<T>((*this)[i] / sca);
+   return r;
+  }
+
+  /** @brief In-place vector addition. */
+  constexpr BasicVector& operator+=(const BasicVector& otro) { return *this = *this + otro; }
+  /** @brief In-place vector subtraction. */
+  constexpr BasicVector& operator-=(const BasicVector& otro) { return *this = *this - otro; }
+  /** @brief In-place scalar multiplication. */
+  constexpr BasicVector& operator*=(T sca) { return *this = *this * sca; }
+  /** @brief In-place scalar division. */
+  constexpr BasicVector& operator/=(T sca) { return *this = *this / sca; }
+
+  /** @brief Equality comparison. */
+  constexpr bool
+   operator==(const BasicVector& otro) const {
+   for (int i = 0; i < N; ++i) {
+    if ((*this)[i] != otro[i]) return false;
+   }
+   return true;
+  }
+
+  /** @brief Inequality comparison. */
+  constexpr bool
+   operator!=(const BasicVector& otro) const {
+   return !(*this == otro);
+  }
+
+  /** @brief True when every component is within epsilon of otro's; integer T with epsilon 0 compares exactly. */
+  constexpr bool
+   approxEqual(const BasicVector& otro, T epsilon = static_cast<T>(EU::Constants::EPSILON)) const {
+   for (int i = 0; i < N; ++i) {
+    T a = (*this)[i], b = otro[i];
+    if (!(a == b || (a > b ? a - b : b - a) <= epsilon)) return false;
+   }
+   return true;
+  }
+
+  /** @brief Returns the squared magnitude, in T. */
+  constexpr T
+   lengthSquared() const {
+   return dot(*this);
+  }
+
+  /** @brief Computes the dot product with another vector, in T. */
+  constexpr T
+   dot(const BasicVector& other) const {
+   T sum = static_cast<T>(this->x * other.x);
+   for (int i = 1; i < N; ++i) sum = static_cast<T>(sum + (*this)[i] * other[i]);
+   return sum;
+  }
+
+  /** @brief Computes the cross product with another vector (N == 3). */
+  constexpr BasicVector
+   cross(const BasicVector& otro) const {
+   static_assert(N == 3, "cross() needs a 3-component vector");
+   BasicVector r;
+   r[0] = static_cast<T>((*this)[1] * otro[2] - (*this)[2] * otro[1]);
+   r[1] = static_cast<T>((*this)[2] * otro[0] - (*this)[0] * otro[2]);
+   r[2] = static_cast<T>((*this)[0] * otro[1] - (*this)[1] * otro[0]);
+   return r;
+  }
+
+  /** @brief Returns the magnitude (floating-point T). */
+  EU_CONSTEXPR20 T
+   length() const {
+   static_assert(std::is_floating_point<T>::value, "length() needs a floating-point element type");
+   return detail::vectorSqrt(lengthSquared());
+  }
+
+  /** @brief Returns a normalized copy, zero for the zero vector (floating-point T). */
+  EU_CONSTEXPR20 BasicVector
+   normalized() const {
+   T len = length();
+   if (len == T(0)) return zero();
+   return *this / len;
+  }
+
+  /** @brief Normalizes the vector in-place (floating-point T). */
+  EU_CONSTEXPR20 void
+   normalize() {
+   *this = normalized();
+  }
+
+  /** @brief Euclidean distance between two points (floating-point T). */
+  static EU_CONSTEXPR20 T
+   distance(const BasicVector& a, const BasicVector& b) {
+   return (a - b).length();
+  }
+
+  /** @brief Linearly interpolates with t clamped to [0, 1] (floating-point T). */
+  static constexpr BasicVector
+   lerp(const BasicVector& a, const BasicVector& b, T t) {
+   return lerpUnclamped(a, b, t < T(0) ? T(0) : (t > T(1) ? T(1) : t));
+  }
+
+  /** @brief Linear interpolation without clamping (floating-point T). */
+  static constexpr BasicVector
+   lerpUnclamped(const BasicVector& a, const BasicVector& b, T t) {
+   static_assert(std::is_floating_point<T>::value, "lerp() needs a floating-point element type");
+   return a + (b - a) * t;
+  }
+
+  /** @brief Returns the zero vector. */
+  static constexpr BasicVector
+   zero() {
+   return BasicVector();
+  }
+
+  /** @brief Returns the vector with every component 1. */
+  static constexpr BasicVector
+   one() {
+   return splat(T(1));
+  }
+
+  // --- Transformation Utilities (for debugging and manipulation) ---
+
+  /** @brief Sets this vector as a position. */
+  constexpr void setPosition(const BasicVector& pos) { *this = pos; }
+  /** @brief Moves this vector by an offset. */
+  constexpr void move(const BasicVector& ofs) { *this += ofs; }
+  /** @brief Sets this vector as a scale. */
+  constexpr void setScale(const BasicVector& fac) { *this = fac; }
+  /** @brief Scales this vector component-wise. */
+  constexpr void scale(const BasicVector& fac) { Ops::mul(*this, *this, fac); }
+  /** @brief Sets this vector as an origin. */
+  constexpr void setOrigin(const BasicVector& ori) { *this = ori; }
+
+  private:
+  static constexpr BasicVector
+   splat(T value) {
+   BasicVector r;
+   for (int i = 0; i < N; ++i) r[i] = value;
+   return r;
+  }
+
+  template<typename Other>
+  constexpr void
+   convertFrom(const Other& other) {
+   this->x = static_cast<T>(other.x);
+   this->y = static_cast<T>(other.y);
+   convertRest(other, std::integral_constant<int, N>());
+  }
+
+  template<typename Other> constexpr void convertRest(const Other&, std::integral_constant<int, 2>) {}
+  template<typename Other>
+  constexpr void
+   convertRest(const Other& other, std::integral_constant<int, 3>) {
+   (*this)[2] = static_cast<T>(other.z);
+  }
+  template<typename Other>
+  constexpr void
+   convertRest(const Other& other, std::integral_constant<int, 4>) {
+   (*this)[2] = static_cast<T>(other.z);
+   (*this)[3] = static_cast<T>(other.w);
+  }
+
+  template<typename C, typename Other> constexpr void copyRest(Other&, std::integral_constant<int, 2>) const {}
+  template<typename C, typename Other>
+  constexpr void
+   copyRest(Other& out, std::integral_constant<int, 3>) const {
+   out.z = static_cast<C>((*this)[2]);
+  }
+  template<typename C, typename Other>
+  constexpr void
+   copyRest(Other& out, std::integral_constant<int, 4>) const {
+   out.z = static_cast<C>((*this)[2]);
+   out.w = static_cast<C>((*this)[3]);
+  }
+ };
+
+ namespace detail {
+  template<typename T, int N> struct VectorSelect { using type = BasicVector<T, N>; };
+  template<> struct VectorSelect<float, 2> { using type = CVector2; };
+  template<> struct VectorSelect<float, 3> { using type = CVector3; };
+  template<> struct VectorSelect<float, 4> { using type = CVector4; };
+ }
+
+ /**
+  * @brief N-component vector of T: CVector2/3/4 for float, BasicVector<T, N> otherwise.
+  */
+ template<typename T, int N>
+ using Vector = typename detail::VectorSelect<T, N>::type;
+
+ using Vector2i = Vector<int32_t, 2>;   ///< Tile and grid coordinates
+ using Vector3i = Vector<int32_t, 3>;   ///< Voxel coordinates
+ using Vector4i = Vector<int32_t, 4>;   ///< SIMD-backed integer quad
+ using Vector2d = Vector<double, 2>;    ///< Double-precision 2D position
+ using Vector3d = Vector<double, 3>;    ///< Double-precision world position
+ using Vector4d = Vector<double, 4>;    ///< Double-precision homogeneous vector
+ using Vector4u8 = Vector<uint8_t, 4>;  ///< 8-bit RGBA color
+
+ EU_ASSERT_VALUE_TYPE(Vector2i);
+ EU_ASSERT_VALUE_TYPE(Vector3i);
+ EU_ASSERT_VALUE_TYPE(Vector4i);
+ EU_ASSERT_VALUE_TYPE(Vector3d);
+ EU_ASSERT_VALUE_TYPE(Vector4u8);
+}
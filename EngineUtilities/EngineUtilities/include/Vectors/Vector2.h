@@ -1,6 +1,10 @@
 #pragma once
 //#include "../Prerequisites.h"
 #include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Vectors/VectorInterop.h>
+#include <Vectors/VectorComponents.h>
+#include <Vectors/VectorSwizzle.h>
 #include <Vectors/Vector2.h>
 using namespace EngineMath;
 
@@ -17,37 +21,50 @@ public:
  float y; ///< Y component of the vector
 
  /** @brief Default constructor. Initializes vector to (0, 0). */
- CVector2() : x(0.f), y(0.f) {}
+ constexpr CVector2() : x(0.f), y(0.f) {}
+
+ /** @brief Leaves every component uninitialized; see EU::NoInit. */
+ explicit CVector2(EU::NoInitTag) {}
 
  /** @brief Parameterized constructor. */
- CVector2(float x, float y) : x(x), y(y) {}
+ constexpr CVector2(float x, float y) : x(x), y(y) {}
+
+ /** @brief Implicit conversion from a vector type registered through EU::VectorInterop. */
+ template<typename T, EU::detail::EnableInterop<T, CVector2> = 0>
+ constexpr CVector2(const T& v) : CVector2(EU::VectorInterop<T>::toNative(v)) {}
+
+ /** @brief Implicit conversion to a vector type registered through EU::VectorInterop. */
+ template<typename T, EU::detail::EnableInterop<T, CVector2> = 0>
+ operator T() const {
+  return EU::VectorInterop<T>::fromNative(*this);
+ }
 
  /** @brief Adds two vectors. */
- CVector2 
+ constexpr CVector2
   operator+(const CVector2& otro) const {
   return CVector2(x + otro.x, y + otro.y);
  }
 
  /** @brief Subtracts two vectors. */
- CVector2 
+ constexpr CVector2
   operator-(const CVector2& otro) const {
   return CVector2(x - otro.x, y - otro.y);
  }
 
  /** @brief Multiplies the vector by a scalar. */
- CVector2 
+ constexpr CVector2
   operator*(float fac) const {
   return CVector2(x * fac, y * fac);
  }
 
  /** @brief Divides the vector by a scalar. */
- CVector2 
+ constexpr CVector2
   operator/(float fac) const {
   return CVector2(x / fac, y / fac);
  }
 
  /** @brief Adds another vector to this one (in-place). */
- CVector2& 
+ constexpr CVector2&
   operator+=(const CVector2& otro) {
   x += otro.x;
   y += otro.y;
@@ -55,7 +72,7 @@ public:
  }
 
  /** @brief Subtracts another vector from this one (in-place). */
- CVector2& 
+ constexpr CVector2&
   operator-=(const CVector2& otro) {
   x -= otro.x;
   y -= otro.y;
@@ -63,7 +80,7 @@ public:
  }
 
  /** @brief Multiplies this vector by a scalar (in-place). */
- CVector2& 
+ constexpr CVector2&
   operator*=(float fac) {
   x *= fac;
   y *= fac;
@@ -71,7 +88,7 @@ public:
  }
 
  /** @brief Divides this vector by a scalar (in-place). */
- CVector2& 
+ constexpr CVector2&
   operator/=(float fac) {
   x /= fac;
   y /= fac;
@@ -79,69 +96,85 @@ public:
  }
 
  /** @brief Checks if two vectors are equal. */
- bool 
+ constexpr bool
   operator==(const CVector2& otro) const {
   return x == otro.x && y == otro.y;
  }
 
  /** @brief Checks if two vectors are not equal. */
- bool 
+ constexpr bool
   operator!=(const CVector2& otro) const {
   return !(*this == otro);
  }
 
+ /** @brief True when every component is within epsilon of otro's. */
+ constexpr bool
+  approxEqual(const CVector2& otro, float epsilon = EU::Constants::EPSILON) const {
+  return EngineMath::approxEqual(x, otro.x, epsilon) && EngineMath::approxEqual(y, otro.y, epsilon);
+ }
+
  /** @brief Accesses a vector component by index (0 = x, 1 = y). */
- float& 
+ constexpr float&
  operator[](int i) {
-  return i == 0 ? x : y;
+  return EU::detail::ComponentTable<CVector2, float, &CVector2::x, &CVector2::y>::get(*this, i);
  }
 
  /** @brief Const access to a vector component by index. */
- const float& 
+ constexpr const float&
  operator[](int index) const {
-  return index == 0 ? x : y;
+  return EU::detail::ComponentTable<CVector2, float, &CVector2::x, &CVector2::y>::get(*this, index);
  }
 
+ /** @brief Swizzles v.xy(), v.yx(), v.xx(), ...; see VectorSwizzle.h. */
+ EU_SWIZZLES_2(CVector2, 2, CVector2)
+
  /** @brief Returns the magnitude (length) of the vector. */
- float 
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 float
   length() const {
-  return sqrt(x * x + y * y);
+  return Policy::sqrt(Policy::madd(x, x, y * y));
  }
  /** @brief Returns the squared length of the vector (avoids sqrt). */
- float 
+ constexpr float
   lengthSquared() const {
   return x * x + y * y;
  }
 
  /** @brief Computes the dot product between two vectors. */
- float 
+ constexpr float
   dot(const CVector2& otro) const {
   return x * otro.x + y * otro.y;
  }
 
  /** @brief Computes the 2D cross product (scalar). */
- float 
+ constexpr float
   cross(const CVector2& otro) const {
   return x * otro.y - y * otro.x;
  }
 
  /** @brief Returns a normalized copy of this vector. */
- CVector2 
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 CVector2
   normalized() const {
-  float len = length();
-  if (len == 0.f)
-   return CVector2(0.f, 0.f);
-    return CVector2(x / len, y / len);
+  float lenSq = lengthSquared();
+  if (!EU::Precision::normalizable(lenSq)) {
+   // Zero, or squares that underflow or overflow: scale by the largest component first.
+   const float m = EU::Precision::largestMagnitude(x, y);
+   if (m == 0.f)
+    return CVector2(0.f, 0.f);
+   const CVector2 scaled(x / m, y / m);
+   float inv = Policy::invLength(scaled.lengthSquared());
+   return CVector2(scaled.x * inv, scaled.y * inv);
+  }
+  float inv = Policy::invLength(lenSq);
+  return CVector2(x * inv, y * inv);
  }
 
  /** @brief Normalizes this vector in-place. */
- void 
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 void
   normalize() {
-  float len = length();
-  if (len != 0.f) {
-   x /= len;
-   y /= len;
-  }
+  *this = normalized<Policy>();
  }
 
  /**
@@ -150,9 +183,10 @@ public:
   * @param b Second point.
   * @return Distance between a and b.
   */
- static float 
+ template<typename Policy = EU::Precision::Default>
+ static EU_CONSTEXPR20 float
   distance(const CVector2& a, const CVector2& b) {
-  return (a - b).length();
+  return (a - b).length<Policy>();
  }
 
  /**
@@ -162,20 +196,26 @@ public:
   * @param t Interpolation factor [0, 1].
   * @return Interpolated vector.
   */
- static CVector2
+ static constexpr CVector2
   lerp(const CVector2& a, const CVector2& b, float t) {
-  if (t < 0.f) t = 0.f;
-  if (t > 1.f) t = 1.f;
+  return lerpUnclamped(a, b, EngineMath::clamp(t, 0.f, 1.f));
+ }
+
+ /**
+  * @brief Linear interpolation without clamping, extrapolates for t outside [0, 1].
+  */
+ static constexpr CVector2
+  lerpUnclamped(const CVector2& a, const CVector2& b, float t) {
   return a + (b - a) * t;
  }
  /** @brief Returns a vector (0, 0). */
- static CVector2 
+ static constexpr CVector2
   zero() {
   return CVector2(0.f, 0.f);
  }
 
  /** @brief Returns a vector (1, 1). */
- static CVector2 
+ static constexpr CVector2
   one() {
   return CVector2(1.f, 1.f);
  }
@@ -183,37 +223,39 @@ public:
  // Debug-style transform emulation methods:
 
  /** @brief Sets this vector to a position value. */
- void 
+ constexpr void
   setPosition(const CVector2& position) {
   x = position.x;
   y = position.y;
  }
 
  /** @brief Moves this vector by an offset. */
- void
+ constexpr void
   move(const CVector2& ofs) {
   x += ofs.x;
   y += ofs.y;
  }
 
  /** @brief Sets this vector as a scale. */
- void
+ constexpr void
   setScale(const CVector2& fac) {
   x = fac.x;
   y = fac.y;
  }
 
  /** @brief Scales this vector component-wise. */
- void 
+ constexpr void
   scale(const CVector2& fac) {
   x *= fac.x;
   y *= fac.y;
  }
 
  /** @brief Sets this vector as an origin point. */
- void 
+ constexpr void
   setOrigin(const CVector2& origin) {
   x = origin.x;
   y = origin.y;
  }
 };
+
+EU_ASSERT_VALUE_TYPE(CVector2);
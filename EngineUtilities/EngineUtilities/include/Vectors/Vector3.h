@@ -1,8 +1,13 @@
 #pragma once
 
-#include "../Prerequisites.h"
-using namespace EngineMath;
+//#include "../Prerequisites.h"
 #include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Vectors/VectorInterop.h>
+#include <Vectors/VectorComponents.h>
+#include <Vectors/VectorSwizzle.h>
+#include <Vectors/Vector2.h>
+using namespace EngineMath;
 
 /**
  * @class CVector3
@@ -19,111 +24,132 @@ public:
  float z; ///< Z component
 
  /** @brief Default constructor. Initializes to (0, 0, 0). */
- CVector3() : x(0.f), y(0.f), z(0.f) {}
+ constexpr CVector3() : x(0.f), y(0.f), z(0.f) {}
+
+ /** @brief Leaves every component uninitialized; see EU::NoInit. */
+ explicit CVector3(EU::NoInitTag) {}
 
  /** @brief Constructs a vector with given x, y, z values. */
- CVector3(float x, float y, float z) : x(x), y(y), z(z) {}
+ constexpr CVector3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+ /** @brief Implicit conversion from a vector type registered through EU::VectorInterop. */
+ template<typename T, EU::detail::EnableInterop<T, CVector3> = 0>
+ constexpr CVector3(const T& v) : CVector3(EU::VectorInterop<T>::toNative(v)) {}
+
+ /** @brief Implicit conversion to a vector type registered through EU::VectorInterop. */
+ template<typename T, EU::detail::EnableInterop<T, CVector3> = 0>
+ operator T() const {
+  return EU::VectorInterop<T>::fromNative(*this);
+ }
 
  /** @brief Adds two vectors. */
- CVector3 
+ constexpr CVector3
   operator+(const CVector3& otro) const {
   return CVector3(x + otro.x, y + otro.y, z + otro.z);
  }
 
  /** @brief Subtracts one vector from another. */
- CVector3 
+ constexpr CVector3
   operator-(const CVector3& otro) const {
   return CVector3(x - otro.x, y - otro.y, z - otro.z);
  }
 
  /** @brief Multiplies the vector by a scalar. */
- CVector3 
+ constexpr CVector3
   operator*(float sca) const {
   return CVector3(x * sca, y * sca, z * sca);
  }
 
  /** @brief Divides the vector by a scalar. */
- CVector3 
+ constexpr CVector3
   operator/(float sca) const {
   return CVector3(x / sca, y / sca, z / sca);
  }
 
  /** @brief In-place vector addition. */
- CVector3& 
+ constexpr CVector3&
   operator+=(const CVector3& otro) {
   x += otro.x; y += otro.y; z += otro.z;
   return *this;
  }
 
  /** @brief In-place vector subtraction. */
- CVector3& 
+ constexpr CVector3&
   operator-=(const CVector3& otro) {
   x -= otro.x; y -= otro.y; z -= otro.z;
   return *this;
  }
 
  /** @brief In-place scalar multiplication. */
- CVector3& 
+ constexpr CVector3&
   operator*=(float sca) {
   x *= sca; y *= sca; z *= sca;
   return *this;
  }
 
  /** @brief In-place scalar division. */
- CVector3& 
+ constexpr CVector3&
   operator/=(float sca) {
   x /= sca; y /= sca; z /= sca;
   return *this;
  }
 
  /** @brief Equality comparison. */
- bool 
+ constexpr bool
   operator==(const CVector3& otro) const {
   return x == otro.x && y == otro.y && z == otro.z;
  }
 
  /** @brief Inequality comparison. */
- bool 
+ constexpr bool
   operator!=(const CVector3& otro) const {
   return !(*this == otro);
  }
 
+ /** @brief True when every component is within epsilon of otro's. */
+ constexpr bool
+  approxEqual(const CVector3& otro, float epsilon = EU::Constants::EPSILON) const {
+  return EngineMath::approxEqual(x, otro.x, epsilon) && EngineMath::approxEqual(y, otro.y, epsilon)
+      && EngineMath::approxEqual(z, otro.z, epsilon);
+ }
+
  /** @brief Access vector component by index (0 = x, 1 = y, 2 = z). */
- float& 
+ constexpr float&
   operator[](int index) {
-  if (index == 0) return x;
-  if (index == 1) return y;
-  return z;
+  return EU::detail::ComponentTable<CVector3, float, &CVector3::x, &CVector3::y, &CVector3::z>::get(*this, index);
  }
 
  /** @brief Const access to vector component by index. */
- const float& 
+ constexpr const float&
   operator[](int index) const {
-  if (index == 0) return x;
-  if (index == 1) return y;
-  return z;
+  return EU::detail::ComponentTable<CVector3, float, &CVector3::x, &CVector3::y, &CVector3::z>::get(*this, index);
  }
 
+ /** @brief Swizzles v.xz(), v.yzx(), ...; see VectorSwizzle.h. */
+ EU_SWIZZLES_2(CVector3, 3, CVector2)
+ EU_SWIZZLES_3(CVector3, 3, CVector3)
+
  /** @brief Returns the magnitude (length) of the vector. */
- float
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 float
   length() const {
-  return sqrt(x * x + y * y + z * z);
+  return Policy::sqrt(Policy::madd(x, x, Policy::madd(y, y, z * z)));
  }
 
  /** @brief Returns the squared magnitude (avoids sqrt). */
- float
+ constexpr float
   lengthSquared() const {
   return x * x + y * y + z * z;
  }
 
  /** @brief Computes the dot product with another vector. */
- float
+ constexpr float
   dot(const CVector3& other) const {
   return x * other.x + y * other.y + z * other.z;
  }
 
  /** @brief Computes the cross product with another vector. */
- CVector3 
+ constexpr CVector3
   cross(const CVector3& otro) const {
   return CVector3(
   y * otro.z - z * otro.y,
@@ -133,22 +159,27 @@ public:
  }
 
  /** @brief Returns a normalized copy of the vector. */
- CVector3 
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 CVector3
   normalized() const {
-  float len = length();
-  if (len == 0.f) return CVector3(0.f, 0.f, 0.f);
-  return CVector3(x / len, y / len, z / len);
+  float lenSq = lengthSquared();
+  if (!EU::Precision::normalizable(lenSq)) {
+   // Zero, or squares that underflow or overflow: scale by the largest component first.
+   const float m = EU::Precision::largestMagnitude(x, y, z);
+   if (m == 0.f) return CVector3(0.f, 0.f, 0.f);
+   const CVector3 scaled(x / m, y / m, z / m);
+   float inv = Policy::invLength(scaled.lengthSquared());
+   return CVector3(scaled.x * inv, scaled.y * inv, scaled.z * inv);
+  }
+  float inv = Policy::invLength(lenSq);
+  return CVector3(x * inv, y * inv, z * inv);
  }
 
  /** @brief Normalizes the vector in-place. */
- void 
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 void
   normalize() {
-  float len = length();
-  if (len != 0.f) {
-   x /= len;
-   y /= len;
-   z /= len;
-  }
+  *this = normalized<Policy>();
  }
 
  /**
@@ -157,9 +188,10 @@ public:
   * @param b Second point.
   * @return Euclidean distance between a and b.
   */
- static float 
+ template<typename Policy = EU::Precision::Default>
+ static EU_CONSTEXPR20 float
   distance(const CVector3& a, const CVector3& b) {
-  return (a - b).length();
+  return (a - b).length<Policy>();
  }
 
  /**
@@ -169,21 +201,27 @@ public:
   * @param t Interpolation factor [0, 1].
   * @return Interpolated vector.
   */
- static CVector3 
+ static constexpr CVector3
   lerp(const CVector3& a, const CVector3& b, float t) {
-  if (t < 0.f) t = 0.f;
-  if (t > 1.f) t = 1.f;
+  return lerpUnclamped(a, b, EngineMath::clamp(t, 0.f, 1.f));
+ }
+
+ /**
+  * @brief Linear interpolation without clamping, extrapolates for t outside [0, 1].
+  */
+ static constexpr CVector3
+  lerpUnclamped(const CVector3& a, const CVector3& b, float t) {
   return a + (b - a) * t;
  }
 
  /** @brief Returns the zero vector (0, 0, 0). */
- static CVector3 
+ static constexpr CVector3
   zero() {
   return CVector3(0.f, 0.f, 0.f);
  }
 
  /** @brief Returns the unit vector (1, 1, 1). */
- static CVector3
+ static constexpr CVector3
   one() {
   return CVector3(1.f, 1.f, 1.f);
  }
@@ -191,31 +229,31 @@ public:
  // --- Transformation Utilities (for debugging and manipulation) ---
 
  /** @brief Sets this vector as a position. */
- void 
+ constexpr void
   setPosition(const CVector3& pos) {
   x = pos.x; y = pos.y; z = pos.z;
  }
 
  /** @brief Moves this vector by an offset. */
- void 
+ constexpr void
   move(const CVector3& ofs) {
   x += ofs.x; y += ofs.y; z += ofs.z;
  }
 
  /** @brief Sets this vector as a scale. */
- void 
+ constexpr void
   setScale(const CVector3& fac) {
   x = fac.x; y = fac.y; z = fac.z;
  }
 
  /** @brief Scales this vector component-wise. */
- void
+ constexpr void
   scale(const CVector3& fac) {
   x *= fac.x; y *= fac.y; z *= fac.z;
  }
 
  /** @brief Sets this vector as an origin. */
- void 
+ constexpr void
   setOrigin(const CVector3& ori) {
   x = ori.x; y = ori.y; z = ori.z;
  }
@@ -223,3 +261,5 @@ public:
 private:
  // No internal data other than x, y, z
 };
+
+EU_ASSERT_VALUE_TYPE(CVector3);
@@ -0,0 +1,347 @@
+/**
+ * @file Vector3Packet.h
+ * @brief AoSoA packet of 4 or 8 3D vectors, one SIMD register per component.
+ *
+ * CVector3Packet<V> mirrors the CVector3 interface with every float replaced by the lane type V,
+ * so a scalar kernel ports by swapping the types: lane i of every result is what CVector3 would
+ * compute for lane i. Comparisons return lane masks (see EU::SIMD) for select(), any() and all()
+ * instead of bool.
+ */
+
+#pragma once
+
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Vectors/VectorComponents.h>
+#include <Vectors/VectorSwizzle.h>
+#include <Vectors/Vector3.h>
+
+/**
+ * @class CVector3Packet
+ * @brief V::WIDTH 3D vectors stored as one register per component.
+ * @tparam V Lane type, EU::SIMD::Float4 or Float8.
+ */
+template<typename V>
+class CVector3Packet {
+public:
+ /// Number of vectors in a packet.
+ static constexpr int WIDTH = V::WIDTH;
+
+ V x; ///< X components
+ V y; ///< Y components
+ V z; ///< Z components
+
+ /** @brief Default constructor. Initializes every lane to (0, 0, 0). */
+ CVector3Packet() : x(V::zero()), y(V::zero()), z(V::zero()) {}
+
+ /** @brief Leaves every lane uninitialized; see EU::NoInit. */
+ explicit CVector3Packet(EU::NoInitTag) {}
+
+ /** @brief Constructs a packet from component registers. */
+ CVector3Packet(V x, V y, V z) : x(x), y(y), z(z) {}
+
+ /** @brief Broadcasts one vector to every lane. */
+ explicit CVector3Packet(const CVector3& v) : x(V::set1(v.x)), y(V::set1(v.y)), z(V::set1(v.z)) {}
+
+ /** @brief Loads WIDTH consecutive CVector3s (AoS to packet). */
+ static CVector3Packet
+  load(const CVector3* in) {
+  float px[WIDTH], py[WIDTH], pz[WIDTH];
+  for (int i = 0; i < WIDTH; ++i) {
+   px[i] = in[i].x;
+   py[i] = in[i].y;
+   pz[i] = in[i].z;
+  }
+  return CVector3Packet(V::load(px), V::load(py), V::load(pz));
+ }
+
+ /** @brief Loads WIDTH vectors from separate component arrays. */
+ static CVector3Packet
+  load(const float* inX, const float* inY, const float* inZ) {
+  return CVector3Packet(V::load(inX), V::load(inY), V::load(inZ));
+ }
+
+ /** @brief Stores WIDTH consecutive CVector3s (packet to AoS). */
+ void
+  store(CVector3* out) const {
+  float px[WIDTH], py[WIDTH], pz[WIDTH];
+  x.store(px);
+  y.store(py);
+  z.store(pz);
+  for (int i = 0; i < WIDTH; ++i) {
+   out[i] = CVector3(px[i], py[i], pz[i]);
+  }
+ }
+
+ /** @brief Stores WIDTH vectors to separate component arrays. */
+ void
+  store(float* outX, float* outY, float* outZ) const {
+  x.store(outX);
+  y.store(outY);
+  z.store(outZ);
+ }
+
+ /** @brief Extracts lane i as a CVector3. */
+ CVector3
+  lane(int i) const {
+  float px[WIDTH], py[WIDTH], pz[WIDTH];
+  x.store(px);
+  y.store(py);
+  z.store(pz);
+  return CVector3(px[i], py[i], pz[i]);
+ }
+
+ /** @brief Adds two packets. */
+ CVector3Packet
+  operator+(const CVector3Packet& otro) const {
+  return CVector3Packet(x + otro.x, y + otro.y, z + otro.z);
+ }
+
+ /** @brief Subtracts one packet from another. */
+ CVector3Packet
+  operator-(const CVector3Packet& otro) const {
+  return CVector3Packet(x - otro.x, y - otro.y, z - otro.z);
+ }
+
+ /** @brief Multiplies every lane by its own scalar. */
+ CVector3Packet
+  operator*(V sca) const {
+  return CVector3Packet(x * sca, y * sca, z * sca);
+ }
+
+ /** @brief Multiplies every lane by the same scalar. */
+ CVector3Packet
+  operator*(float sca) const {
+  return *this * V::set1(sca);
+ }
+
+ /** @brief Divides every lane by its own scalar. */
+ CVector3Packet
+  operator/(V sca) const {
+  return CVector3Packet(x / sca, y / sca, z / sca);
+ }
+
+ /** @brief Divides every lane by the same scalar. */
+ CVector3Packet
+  operator/(float sca) const {
+  return *this / V::set1(sca);
+ }
+
+ /** @brief In-place packet addition. */
+ CVector3Packet&
+  operator+=(const CVector3Packet& otro) {
+  return *this = *this + otro;
+ }
+
+ /** @brief In-place packet subtraction. */
+ CVector3Packet&
+  operator-=(const CVector3Packet& otro) {
+  return *this = *this - otro;
+ }
+
+ /** @brief In-place scalar multiplication. */
+ template<typename S>
+ CVector3Packet&
+  operator*=(S sca) {
+  return *this = *this * sca;
+ }
+
+ /** @brief In-place scalar division. */
+ template<typename S>
+ CVector3Packet&
+  operator/=(S sca) {
+  return *this = *this / sca;
+ }
+
+ /** @brief Lane mask of equal vectors. */
+ V
+  operator==(const CVector3Packet& otro) const {
+  return (x == otro.x) & (y == otro.y) & (z == otro.z);
+ }
+
+ /** @brief Lane mask of different vectors. */
+ V
+  operator!=(const CVector3Packet& otro) const {
+  return (x != otro.x) | (y != otro.y) | (z != otro.z);
+ }
+
+ /** @brief Lane mask of vectors whose components are all within epsilon of otro's. */
+ V
+  approxEqual(const CVector3Packet& otro, float epsilon = EU::Constants::EPSILON) const {
+  const V e = V::set1(epsilon);
+  return EU::SIMD::approxEqual(x, otro.x, e) & EU::SIMD::approxEqual(y, otro.y, e) & EU::SIMD::approxEqual(z, otro.z, e);
+ }
+
+ /** @brief Access component register by index (0 = x, 1 = y, 2 = z). */
+ V&
+  operator[](int index) {
+  return EU::detail::ComponentTable<CVector3Packet, V, &CVector3Packet::x, &CVector3Packet::y, &CVector3Packet::z>::get(*this, index);
+ }
+
+ /** @brief Const access to component register by index. */
+ const V&
+  operator[](int index) const {
+  return EU::detail::ComponentTable<CVector3Packet, V, &CVector3Packet::x, &CVector3Packet::y, &CVector3Packet::z>::get(*this, index);
+ }
+
+ /** @brief Swizzles p.yzx(), p.zxy(), ...; a swizzle only renames registers. */
+ EU_SWIZZLES_3(CVector3Packet, 3, CVector3Packet)
+
+ /** @brief Returns the magnitude of every lane. */
+ template<typename Policy = EU::Precision::Default>
+ V
+  length() const {
+  return Policy::sqrtLanes(Policy::maddLanes(x, x, Policy::maddLanes(y, y, z * z)));
+ }
+
+ /** @brief Returns the squared magnitude of every lane. */
+ V
+  lengthSquared() const {
+  return x * x + y * y + z * z;
+ }
+
+ /** @brief Lane-wise dot product. */
+ V
+  dot(const CVector3Packet& other) const {
+  return x * other.x + y * other.y + z * other.z;
+ }
+
+ /** @brief Lane-wise cross product. */
+ CVector3Packet
+  cross(const CVector3Packet& otro) const {
+  return CVector3Packet(
+  y * otro.z - z * otro.y,
+  z * otro.x - x * otro.z,
+  x * otro.y - y * otro.x
+  );
+ }
+
+ /**
+  * @brief Returns a normalized copy; zero-length lanes stay zero. Lanes whose squared length
+  * underflows or overflows are rescaled first, as by CVector3::normalized().
+  */
+ template<typename Policy = EU::Precision::Default>
+ CVector3Packet
+  normalized() const {
+  CVector3Packet r(*this);
+  r.normalize<Policy>();
+  return r;
+ }
+
+ /** @brief Normalizes every lane in-place; zero-length lanes are left unchanged. */
+ template<typename Policy = EU::Precision::Default>
+ void
+  normalize() {
+  V lenSq = lengthSquared();
+  EU::Precision::rescaleLanes(x, y, z, lenSq);
+  V valid = lenSq != V::zero();
+  V inv = EU::SIMD::select(valid, Policy::invLengthLanes(lenSq), V::set1(1.0f));
+  x = x * inv;
+  y = y * inv;
+  z = z * inv;
+ }
+
+ /**
+  * @brief Lane-wise distance between two packets.
+  */
+ template<typename Policy = EU::Precision::Default>
+ static V
+  distance(const CVector3Packet& a, const CVector3Packet& b) {
+  return (a - b).template length<Policy>();
+ }
+
+ /**
+  * @brief Linearly interpolates every lane by its own factor, clamped to [0, 1].
+  */
+ static CVector3Packet
+  lerp(const CVector3Packet& a, const CVector3Packet& b, V t) {
+  return lerpUnclamped(a, b, EU::SIMD::min(EU::SIMD::max(t, V::zero()), V::set1(1.0f)));
+ }
+
+ /** @brief Linearly interpolates every lane by the same factor, clamped to [0, 1]. */
+ static CVector3Packet
+  lerp(const CVector3Packet& a, const CVector3Packet& b, float t) {
+  return lerpUnclamped(a, b, V::set1(EngineMath::clamp(t, 0.f, 1.f)));
+ }
+
+ /**
+  * @brief Linear interpolation without clamping, extrapolates for t outside [0, 1].
+  */
+ static CVector3Packet
+  lerpUnclamped(const CVector3Packet& a, const CVector3Packet& b, V t) {
+  return a + (b - a) * t;
+ }
+
+ static CVector3Packet
+  lerpUnclamped(const CVector3Packet& a, const CVector3Packet& b, float t) {
+  return lerpUnclamped(a, b, V::set1(t));
+ }
+
+ /** @brief Returns a packet of zero vectors. */
+ static CVector3Packet
+  zero() {
+  return CVector3Packet();
+ }
+
+ /** @brief Returns a packet of (1, 1, 1) vectors. */
+ static CVector3Packet
+  one() {
+  return CVector3Packet(V::set1(1.f), V::set1(1.f), V::set1(1.f));
+ }
+
+ // --- Transformation Utilities (for debugging and manipulation) ---
+
+ /** @brief Sets this packet as a position. */
+ void
+  setPosition(const CVector3Packet& pos) {
+  *this = pos;
+ }
+
+ /** @brief Moves this packet by an offset. */
+ void
+  move(const CVector3Packet& ofs) {
+  *this += ofs;
+ }
+
+ /** @brief Sets this packet as a scale. */
+ void
+  setScale(const CVector3Packet& fac) {
+  *this = fac;
+ }
+
+ /** @brief Scales this packet component-wise. */
+ void
+  scale(const CVector3Packet& fac) {
+  x = x * fac.x; y = y * fac.y; z = z * fac.z;
+ }
+
+ /** @brief Sets this packet as an origin. */
+ void
+  setOrigin(const CVector3Packet& ori) {
+  *this = ori;
+ }
+};
+
+/**
+ * @brief Lane-wise mask ? a : b, e.g. select(hit, reflected, direction).
+ */
+template<typename V>
+inline CVector3Packet<V>
+ select(V mask, const CVector3Packet<V>& a, const CVector3Packet<V>& b) {
+ return CVector3Packet<V>(EU::SIMD::select(mask, a.x, b.x),
+                          EU::SIMD::select(mask, a.y, b.y),
+                          EU::SIMD::select(mask, a.z, b.z));
+}
+
+/// Four 3D vectors in SSE2/NEON registers (scalar lanes without SIMD).
+using CVector3x4 = CVector3Packet<EU::SIMD::Float4>;
+#if defined(EU_SIMD_AVX2)
+/// Eight 3D vectors in AVX2 registers.
+using CVector3x8 = CVector3Packet<EU::SIMD::Float8>;
+#endif
+/// The widest packet the target supports.
+using CVector3xN = CVector3Packet<EU::SIMD::FloatN>;
+
+EU_ASSERT_VALUE_TYPE(CVector3x4);
+EU_ASSERT_VALUE_TYPE(CVector3xN);
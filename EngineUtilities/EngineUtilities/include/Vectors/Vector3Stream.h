@@ -0,0 +1,411 @@
+/**
+ * @file Vector3Stream.h
+ * @brief Structure-of-arrays container of 3D vectors with SIMD batch operations.
+ *
+ * x, y and z live in separate arrays aligned to 32 bytes and padded to a multiple of
+ * Vector3Stream::LANES, so the batch operations run whole FloatN registers with aligned loads
+ * and no scalar tail. gather()/scatter() convert from and to CVector3 arrays.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /**
+  * @class Vector3Stream
+  * @brief Growable SoA array of 3D vectors, e.g. particle positions or velocities.
+  *
+  * Element i is (x()[i], y()[i], z()[i]). Each component array has room for capacity()
+  * floats; the padding past size() is readable and writable but its contents are unspecified.
+  */
+ class
+  Vector3Stream {
+  public:
+  /// Every component array is padded to a multiple of this many floats (covers AVX2).
+  static constexpr size_t LANES = 8;
+  /// Byte alignment of each component array.
+  static constexpr size_t ALIGNMENT = LANES * sizeof(float);
+
+  /** @brief Empty stream. */
+  Vector3Stream() : m_size(0), m_capacity(0) {}
+
+  /** @brief Stream of n zero vectors. */
+  explicit Vector3Stream(size_t n) : Vector3Stream() {
+   resize(n);
+  }
+
+  /** @brief Stream holding a copy of n CVector3s. */
+  Vector3Stream(const CVector3* in, size_t n) : Vector3Stream() {
+   gather(in, n);
+  }
+
+  /** @brief Copies the elements; the copy gets its own aligned storage. */
+  Vector3Stream(const Vector3Stream& other) : Vector3Stream() {
+   *this = other;
+  }
+
+  /** @brief Takes the storage of other, which is left empty. */
+  Vector3Stream(Vector3Stream&& other) noexcept
+   : m_storage(static_cast<std::vector<float>&&>(other.m_storage)), m_size(other.m_size), m_capacity(other.m_capacity) {
+   other.m_size = 0;
+   other.m_capacity = 0;
+  }
+
+  Vector3Stream&
+   operator=(const Vector3Stream& other) {
+   if (this != &other) {
+    resize(other.m_size);
+    copyComponents(other, m_size);
+   }
+   return *this;
+  }
+
+  Vector3Stream&
+   operator=(Vector3Stream&& other) noexcept {
+   if (this != &other) {
+    m_storage = static_cast<std::vector<float>&&>(other.m_storage);
+    m_size = other.m_size;
+    m_capacity = other.m_capacity;
+    other.m_storage.clear();
+    other.m_size = 0;
+    other.m_capacity = 0;
+   }
+   return *this;
+  }
+
+  /** @brief Number of vectors. */
+  size_t
+   size() const {
+   return m_size;
+  }
+
+  /** @brief Vectors that fit before the next reallocation, always a multiple of LANES. */
+  size_t
+   capacity() const {
+   return m_capacity;
+  }
+
+  /** @brief True when the stream holds no vectors. */
+  bool
+   empty() const {
+   return m_size == 0;
+  }
+
+  /** @brief Grows the storage to hold at least n vectors, keeping the contents. */
+  void
+   reserve(size_t n) {
+   if (n <= m_capacity) {
+    return;
+   }
+   Vector3Stream grown;
+   grown.m_capacity = roundUp(n > 2 * m_capacity ? n : 2 * m_capacity);
+   grown.m_storage.assign(3 * grown.m_capacity + ALIGNMENT / sizeof(float), 0.0f);
+   grown.m_size = m_size;
+   grown.copyComponents(*this, m_size);
+   *this = static_cast<Vector3Stream&&>(grown);
+  }
+
+  /** @brief Changes the size; new vectors are zero. */
+  void
+   resize(size_t n) {
+   reserve(n);
+   for (size_t i = m_size; i < n; ++i) {
+    x()[i] = 0.0f;
+    y()[i] = 0.0f;
+    z()[i] = 0.0f;
+   }
+   m_size = n;
+  }
+
+  /** @brief Removes all vectors, keeping the storage. */
+  void
+   clear() {
+   m_size = 0;
+  }
+
+  /** @brief Appends one vector. */
+  void
+   push_back(const CVector3& v) {
+   reserve(m_size + 1);
+   set(m_size++, v);
+  }
+
+  /** @brief X components, ALIGNMENT-aligned. */
+  float* x() { return base(); }
+  /** @brief Y components, ALIGNMENT-aligned. */
+  float* y() { return base() + m_capacity; }
+  /** @brief Z components, ALIGNMENT-aligned. */
+  float* z() { return base() + 2 * m_capacity; }
+  const float* x() const { return base(); }
+  const float* y() const { return base() + m_capacity; }
+  const float* z() const { return base() + 2 * m_capacity; }
+
+  /** @brief Copy of vector i. */
+  CVector3
+   get(size_t i) const {
+   return CVector3(x()[i], y()[i], z()[i]);
+  }
+
+  /** @brief Overwrites vector i. */
+  void
+   set(size_t i, const CVector3& v) {
+   x()[i] = v.x;
+   y()[i] = v.y;
+   z()[i] = v.z;
+  }
+
+  /** @brief The component arrays as a batch SoA view. */
+  EngineMath::batch::SoA3
+   soa() {
+   return { x(), y(), z() };
+  }
+
+  /** @brief The component arrays as a read-only batch SoA view. */
+  EngineMath::batch::ConstSoA3
+   soa() const {
+   return { x(), y(), z() };
+  }
+
+  /** @brief Replaces the contents with in[0..n) (AoS to SoA). */
+  void
+   gather(const CVector3* in, size_t n) {
+   resize(n);
+   float* px = x();
+   float* py = y();
+   float* pz = z();
+   for (size_t i = 0; i < n; ++i) {
+    px[i] = in[i].x;
+    py[i] = in[i].y;
+    pz[i] = in[i].z;
+   }
+  }
+
+  /** @brief Replaces the contents with source[indices[i]] for i in [0, n). */
+  void
+   gather(const CVector3* source, const uint32_t* indices, size_t n) {
+   resize(n);
+   float* px = x();
+   float* py = y();
+   float* pz = z();
+   for (size_t i = 0; i < n; ++i) {
+    const CVector3& v = source[indices[i]];
+    px[i] = v.x;
+    py[i] = v.y;
+    pz[i] = v.z;
+   }
+  }
+
+  /** @brief Writes the size() vectors to out (SoA to AoS). */
+  void
+   scatter(CVector3* out) const {
+   const float* px = x();
+   const float* py = y();
+   const float* pz = z();
+   for (size_t i = 0; i < m_size; ++i) {
+    out[i] = CVector3(px[i], py[i], pz[i]);
+   }
+  }
+
+  /** @brief Writes vector i to dest[indices[i]] for every i in [0, size()). */
+  void
+   scatter(CVector3* dest, const uint32_t* indices) const {
+   const float* px = x();
+   const float* py = y();
+   const float* pz = z();
+   for (size_t i = 0; i < m_size; ++i) {
+    dest[indices[i]] = CVector3(px[i], py[i], pz[i]);
+   }
+  }
+
+  private:
+  static size_t
+   roundUp(size_t n) {
+   return (n + LANES - 1) / LANES * LANES;
+  }
+
+  /** Start of the x array: the first ALIGNMENT boundary inside m_storage. */
+  float*
+   base() const {
+   uintptr_t p = reinterpret_cast<uintptr_t>(m_storage.data());
+   p = (p + ALIGNMENT - 1) & ~static_cast<uintptr_t>(ALIGNMENT - 1);
+   return const_cast<float*>(reinterpret_cast<const float*>(p));
+  }
+
+  void
+   copyComponents(const Vector3Stream& from, size_t n) {
+   for (size_t i = 0; i < n; ++i) {
+    x()[i] = from.x()[i];
+    y()[i] = from.y()[i];
+    z()[i] = from.z()[i];
+   }
+  }
+
+  std::vector<float> m_storage; ///< 3 * m_capacity floats plus alignment slack
+  size_t m_size;
+  size_t m_capacity;
+ };
+
+ namespace detail {
+  /**
+   * Runs fn(i) for every register-sized packet of an n-vector stream. Streams are padded to
+   * LANES, so the last packet may read and write padding but never past the allocation.
+   */
+  template<typename Fn>
+  inline void
+   forEachPacket(size_t n, Fn fn) {
+   const size_t W = static_cast<size_t>(EU::SIMD::FloatN::WIDTH);
+   for (size_t i = 0; i < n; i += W) {
+    fn(i);
+   }
+  }
+
+  /** Stores the lanes of v at out[i..] that fall below n. */
+  inline void
+   storePacket(EU::SIMD::FloatN v, float* out, size_t i, size_t n) {
+   const size_t W = static_cast<size_t>(EU::SIMD::FloatN::WIDTH);
+   if (i + W <= n) {
+    v.store(out + i);
+    return;
+   }
+   float tmp[EU::SIMD::FloatN::WIDTH];
+   v.store(tmp);
+   for (size_t j = i; j < n; ++j) out[j] = tmp[j - i];
+  }
+
+  inline size_t
+   commonSize(const Vector3Stream& a, const Vector3Stream& b) {
+   return a.size() < b.size() ? a.size() : b.size();
+  }
+ }
+
+ /** @brief out[i] = a[i] + b[i] over the shorter of the two streams; out may alias either input. */
+ inline void
+  add(const Vector3Stream& a, const Vector3Stream& b, Vector3Stream& out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = detail::commonSize(a, b);
+  out.resize(n);
+  detail::forEachPacket(n, [&](size_t i) {
+   (V::loadAligned(a.x() + i) + V::loadAligned(b.x() + i)).storeAligned(out.x() + i);
+   (V::loadAligned(a.y() + i) + V::loadAligned(b.y() + i)).storeAligned(out.y() + i);
+   (V::loadAligned(a.z() + i) + V::loadAligned(b.z() + i)).storeAligned(out.z() + i);
+  });
+ }
+
+ /** @brief out[i] = a[i] * factor; out may alias a. */
+ inline void
+  scale(const Vector3Stream& a, float factor, Vector3Stream& out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = a.size();
+  const V f = V::set1(factor);
+  out.resize(n);
+  detail::forEachPacket(n, [&](size_t i) {
+   (V::loadAligned(a.x() + i) * f).storeAligned(out.x() + i);
+   (V::loadAligned(a.y() + i) * f).storeAligned(out.y() + i);
+   (V::loadAligned(a.z() + i) * f).storeAligned(out.z() + i);
+  });
+ }
+
+ /** @brief out[i] = dot(a[i], b[i]); out holds the shorter stream's size() floats. */
+ inline void
+  dot(const Vector3Stream& a, const Vector3Stream& b, float* out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = detail::commonSize(a, b);
+  detail::forEachPacket(n, [&](size_t i) {
+   V d = V::loadAligned(a.x() + i) * V::loadAligned(b.x() + i);
+   d = EU::SIMD::madd(V::loadAligned(a.y() + i), V::loadAligned(b.y() + i), d);
+   d = EU::SIMD::madd(V::loadAligned(a.z() + i), V::loadAligned(b.z() + i), d);
+   detail::storePacket(d, out, i, n);
+  });
+ }
+
+ /** @brief out[i] = cross(a[i], b[i]); out may alias either input. */
+ inline void
+  cross(const Vector3Stream& a, const Vector3Stream& b, Vector3Stream& out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = detail::commonSize(a, b);
+  out.resize(n);
+  detail::forEachPacket(n, [&](size_t i) {
+   V ax = V::loadAligned(a.x() + i), ay = V::loadAligned(a.y() + i), az = V::loadAligned(a.z() + i);
+   V bx = V::loadAligned(b.x() + i), by = V::loadAligned(b.y() + i), bz = V::loadAligned(b.z() + i);
+   (ay * bz - az * by).storeAligned(out.x() + i);
+   (az * bx - ax * bz).storeAligned(out.y() + i);
+   (ax * by - ay * bx).storeAligned(out.z() + i);
+  });
+ }
+
+ /**
+  * @brief out[i] = a[i] normalized; zero vectors stay zero. out may alias a.
+  *
+  * Uses the batch rsqrt (hardware estimate plus one Newton-Raphson step). Vectors whose
+  * squared length underflows or overflows are rescaled first, as by CVector3::normalized().
+  */
+ inline void
+  normalize(const Vector3Stream& a, Vector3Stream& out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = a.size();
+  out.resize(n);
+  detail::forEachPacket(n, [&](size_t i) {
+   V x = V::loadAligned(a.x() + i), y = V::loadAligned(a.y() + i), z = V::loadAligned(a.z() + i);
+   V lenSq = EU::SIMD::madd(z, z, EU::SIMD::madd(y, y, x * x));
+   EU::Precision::rescaleLanes(x, y, z, lenSq);
+   V inv = EngineMath::batch::kernels::rsqrt(lenSq) & (lenSq > V::zero());
+   (x * inv).storeAligned(out.x() + i);
+   (y * inv).storeAligned(out.y() + i);
+   (z * inv).storeAligned(out.z() + i);
+  });
+ }
+
+ /** @brief Normalizes every vector of the stream in place. */
+ inline void
+  normalize(Vector3Stream& a) {
+  normalize(a, a);
+ }
+
+ /** @brief out[i] = length(a[i]); out holds a.size() floats. */
+ inline void
+  length(const Vector3Stream& a, float* out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = a.size();
+  detail::forEachPacket(n, [&](size_t i) {
+   V x = V::loadAligned(a.x() + i), y = V::loadAligned(a.y() + i), z = V::loadAligned(a.z() + i);
+   V lenSq = EU::SIMD::madd(z, z, EU::SIMD::madd(y, y, x * x));
+   detail::storePacket(EngineMath::batch::kernels::sqrt(lenSq), out, i, n);
+  });
+ }
+
+ /** @brief out[i] = lerp(a[i], b[i], t) with t clamped to [0, 1]; out may alias either input. */
+ inline void
+  lerp(const Vector3Stream& a, const Vector3Stream& b, float t, Vector3Stream& out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = detail::commonSize(a, b);
+  const V vt = V::set1(EngineMath::clamp(t, 0.0f, 1.0f));
+  out.resize(n);
+  detail::forEachPacket(n, [&](size_t i) {
+   V ax = V::loadAligned(a.x() + i), ay = V::loadAligned(a.y() + i), az = V::loadAligned(a.z() + i);
+   EU::SIMD::madd(V::loadAligned(b.x() + i) - ax, vt, ax).storeAligned(out.x() + i);
+   EU::SIMD::madd(V::loadAligned(b.y() + i) - ay, vt, ay).storeAligned(out.y() + i);
+   EU::SIMD::madd(V::loadAligned(b.z() + i) - az, vt, az).storeAligned(out.z() + i);
+  });
+ }
+
+ /** @brief out[i] = distance(a[i], b[i]); out holds the shorter stream's size() floats. */
+ inline void
+  distance(const Vector3Stream& a, const Vector3Stream& b, float* out) {
+  using V = EU::SIMD::FloatN;
+  const size_t n = detail::commonSize(a, b);
+  detail::forEachPacket(n, [&](size_t i) {
+   V dx = V::loadAligned(a.x() + i) - V::loadAligned(b.x() + i);
+   V dy = V::loadAligned(a.y() + i) - V::loadAligned(b.y() + i);
+   V dz = V::loadAligned(a.z() + i) - V::loadAligned(b.z() + i);
+   V d2 = EU::SIMD::madd(dz, dz, EU::SIMD::madd(dy, dy, dx * dx));
+   detail::storePacket(EngineMath::batch::kernels::sqrt(d2), out, i, n);
+  });
+ }
+}
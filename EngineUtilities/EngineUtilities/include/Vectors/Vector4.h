@@ -2,6 +2,11 @@
 
 //#include "../Prerequisites.h"
 #include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Vectors/VectorComponents.h>
+#include <Vectors/VectorSwizzle.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
 using namespace EngineMath;
 
 /**
@@ -19,114 +24,125 @@ public:
  float w; ///< W component
 
  /** @brief Default constructor. Initializes all components to 0. */
- CVector4() : x(0.f), y(0.f), z(0.f), w(0.f) {}
+ constexpr CVector4() : x(0.f), y(0.f), z(0.f), w(0.f) {}
+ /** @brief Leaves every component uninitialized; see EU::NoInit. */
+ explicit CVector4(EU::NoInitTag) {}
  /** @brief Parameterized constructor. */
- CVector4(float x, float y, float z, float w)
+ constexpr CVector4(float x, float y, float z, float w)
   : x(x), y(y), z(z), w(w) {
  }
 
  /** @brief Adds two vectors. */
- CVector4 operator+(const CVector4& otro) const {
+ constexpr CVector4 operator+(const CVector4& otro) const {
   return CVector4(x + otro.x, y + otro.y, z + otro.z, w + otro.w);
  }
 
  /** @brief Subtracts two vectors. */
- CVector4 operator-(const CVector4& otro) const {
+ constexpr CVector4 operator-(const CVector4& otro) const {
   return CVector4(x - otro.x, y - otro.y, z - otro.z, w - otro.w);
  }
 
  /** @brief Multiplies the vector by a scalar. */
- CVector4 operator*(float fac) const {
+ constexpr CVector4 operator*(float fac) const {
   return CVector4(x * fac, y * fac, z * fac, w * fac);
  }
 
  /** @brief Divides the vector by a scalar. */
- CVector4 operator/(float fac) const {
+ constexpr CVector4 operator/(float fac) const {
   return CVector4(x / fac, y / fac, z / fac, w / fac);
  }
 
  /** @brief In-place addition. */
- CVector4& operator+=(const CVector4& otro) {
+ constexpr CVector4& operator+=(const CVector4& otro) {
   x += otro.x; y += otro.y; z += otro.z; w += otro.w;
   return *this;
  }
 
  /** @brief In-place subtraction. */
- CVector4& operator-=(const CVector4& otro) {
+ constexpr CVector4& operator-=(const CVector4& otro) {
   x -= otro.x; y -= otro.y; z -= otro.z; w -= otro.w;
   return *this;
  }
 
  /** @brief In-place scalar multiplication. */
- CVector4& operator*=(float fac) {
+ constexpr CVector4& operator*=(float fac) {
   x *= fac; y *= fac; z *= fac; w *= fac;
   return *this;
  }
 
  /** @brief In-place scalar division. */
- CVector4& operator/=(float fac) {
+ constexpr CVector4& operator/=(float fac) {
   x /= fac; y /= fac; z /= fac; w /= fac;
   return *this;
  }
 
  /** @brief Equality comparison. */
- bool operator==(const CVector4& otro) const {
+ constexpr bool operator==(const CVector4& otro) const {
   return x == otro.x && y == otro.y && z == otro.z && w == otro.w;
  }
 
  /** @brief Inequality comparison. */
- bool operator!=(const CVector4& otro) const {
+ constexpr bool operator!=(const CVector4& otro) const {
   return !(*this == otro);
  }
 
+ /** @brief True when every component is within epsilon of otro's. */
+ constexpr bool approxEqual(const CVector4& otro, float epsilon = EU::Constants::EPSILON) const {
+  return EngineMath::approxEqual(x, otro.x, epsilon) && EngineMath::approxEqual(y, otro.y, epsilon)
+      && EngineMath::approxEqual(z, otro.z, epsilon) && EngineMath::approxEqual(w, otro.w, epsilon);
+ }
+
  /** @brief Access component by index (0 = x, 1 = y, 2 = z, 3 = w). */
- float& operator[](int i) {
-  switch (i) {
-   case 0: return x;
-   case 1: return y;
-   case 2: return z;
-   default: return w;
-  }
+ constexpr float& operator[](int i) {
+  return EU::detail::ComponentTable<CVector4, float, &CVector4::x, &CVector4::y, &CVector4::z, &CVector4::w>::get(*this, i);
  }
 
  /** @brief Const access to component by index. */
- const float& operator[](int i) const {
-  switch (i) {
-   case 0: return x;
-   case 1: return y;
-   case 2: return z;
-   default: return w;
-  }
+ constexpr const float& operator[](int i) const {
+  return EU::detail::ComponentTable<CVector4, float, &CVector4::x, &CVector4::y, &CVector4::z, &CVector4::w>::get(*this, i);
  }
 
+ /** @brief Swizzles v.xz(), v.xyz(), v.wzyx(), ...; see VectorSwizzle.h. */
+ EU_SWIZZLES_2(CVector4, 4, CVector2)
+ EU_SWIZZLES_3(CVector4, 4, CVector3)
+ EU_SWIZZLES_4(CVector4, 4, CVector4)
+
  /** @brief Returns the vector's magnitude. */
- float length() const {
-  return sqrt(x * x + y * y + z * z + w * w);
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 float length() const {
+  return Policy::sqrt(Policy::madd(x, x, Policy::madd(y, y, Policy::madd(z, z, w * w))));
  }
 
  /** @brief Returns the squared magnitude (avoids sqrt). */
- float lengthSquared() const {
+ constexpr float lengthSquared() const {
   return x * x + y * y + z * z + w * w;
  }
 
  /** @brief Computes the dot product with another vector. */
- float dot(const CVector4& other) const {
+ constexpr float dot(const CVector4& other) const {
   return x * other.x + y * other.y + z * other.z + w * other.w;
  }
 
  /** @brief Returns a normalized copy of this vector. */
- CVector4 normalized() const {
-  float len = length();
-  if (len == 0.f) return CVector4(0.f, 0.f, 0.f, 0.f);
-  return CVector4(x / len, y / len, z / len, w / len);
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 CVector4 normalized() const {
+  float lenSq = lengthSquared();
+  if (!EU::Precision::normalizable(lenSq)) {
+   // Zero, or squares that underflow or overflow: scale by the largest component first.
+   const float m = EU::Precision::largestMagnitude(x, y, z, w);
+   if (m == 0.f) return CVector4(0.f, 0.f, 0.f, 0.f);
+   const CVector4 scaled(x / m, y / m, z / m, w / m);
+   float inv = Policy::invLength(scaled.lengthSquared());
+   return CVector4(scaled.x * inv, scaled.y * inv, scaled.z * inv, scaled.w * inv);
+  }
+  float inv = Policy::invLength(lenSq);
+  return CVector4(x * inv, y * inv, z * inv, w * inv);
  }
 
  /** @brief Normalizes this vector in-place. */
- void normalize() {
-  float len = length();
-  if (len != 0.f) {
-   x /= len; y /= len; z /= len; w /= len;
-  }
+ template<typename Policy = EU::Precision::Default>
+ EU_CONSTEXPR20 void normalize() {
+  *this = normalized<Policy>();
  }
 
  /**
@@ -135,8 +151,9 @@ public:
   * @param b Second vector.
   * @return Euclidean distance.
   */
- static float distance(const CVector4& a, const CVector4& b) {
-  return (a - b).length();
+ template<typename Policy = EU::Precision::Default>
+ static EU_CONSTEXPR20 float distance(const CVector4& a, const CVector4& b) {
+  return (a - b).length<Policy>();
  }
 
  /**
@@ -146,45 +163,52 @@ public:
   * @param t Interpolation factor [0, 1].
   * @return Interpolated vector.
   */
- static CVector4 lerp(const CVector4& a, const CVector4& b, float t) {
-  if (t < 0.f) t = 0.f;
-  if (t > 1.f) t = 1.f;
+ static constexpr CVector4 lerp(const CVector4& a, const CVector4& b, float t) {
+  return lerpUnclamped(a, b, EngineMath::clamp(t, 0.f, 1.f));
+ }
+
+ /**
+  * @brief Linear interpolation without clamping, extrapolates for t outside [0, 1].
+  */
+ static constexpr CVector4 lerpUnclamped(const CVector4& a, const CVector4& b, float t) {
   return a + (b - a) * t;
  }
 
  /** @brief Returns a vector (0, 0, 0, 0). */
- static CVector4 zero() {
+ static constexpr CVector4 zero() {
   return CVector4(0.f, 0.f, 0.f, 0.f);
  }
  /** @brief Returns a vector (1, 1, 1, 1). */
- static CVector4 one() {
+ static constexpr CVector4 one() {
   return CVector4(1.f, 1.f, 1.f, 1.f);
  }
 
  // --- Transformation Helpers (for debugging or simulation) ---
 
  /** @brief Sets this vector as a position. */
- void setPosition(const CVector4& pos) {
+ constexpr void setPosition(const CVector4& pos) {
   x = pos.x; y = pos.y; z = pos.z; w = pos.w;
  }
 
     /** @brief Moves this vector by an offset. */
-    void move(const CVector4& ofs) {
+    constexpr void move(const CVector4& ofs) {
         x += ofs.x; y += ofs.y; z += ofs.z; w += ofs.w;
     }
 
     /** @brief Sets this vector as a scale. */
-    void setScale(const CVector4& fac) {
+    constexpr void setScale(const CVector4& fac) {
         x = fac.x; y = fac.y; z = fac.z; w = fac.w;
     }
 
     /** @brief Scales this vector component-wise. */
-    void scale(const CVector4& fac) {
+    constexpr void scale(const CVector4& fac) {
         x *= fac.x; y *= fac.y; z *= fac.z; w *= fac.w;
     }
 
     /** @brief Sets this vector as an origin point. */
-    void setOrigin(const CVector4& ori) {
+    constexpr void setOrigin(const CVector4& ori) {
         x = ori.x; y = ori.y; z = ori.z; w = ori.w;
     }
 };
+
+EU_ASSERT_VALUE_TYPE(CVector4);
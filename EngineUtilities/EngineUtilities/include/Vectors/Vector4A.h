@@ -0,0 +1,244 @@
+#pragma once
+
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/Precision.h>
+#include <Vectors/VectorComponents.h>
+#include <Vectors/VectorSwizzle.h>
+#include <Vectors/Vector4.h>
+using namespace EngineMath;
+
+/**
+ * @class CVector4A
+ * @brief 16-byte aligned 4D vector whose operations run on one SSE/NEON register.
+ *
+ * Same members and API as CVector4, and converts to and from it implicitly, so it can be
+ * swapped in on hot paths. Arithmetic, dot, length and lerp each load the vector with a single
+ * aligned load and compute in EU::SIMD::Float4 (scalar lanes when no SIMD is available). The
+ * trade-off is that only construction and conversion are constexpr, and dot() sums pairwise,
+ * so it may differ from CVector4::dot() in the last bit.
+ */
+class alignas(16) CVector4A {
+public:
+ float x; ///< X component
+ float y; ///< Y component
+ float z; ///< Z component
+ float w; ///< W component
+
+ /** @brief Default constructor. Initializes all components to 0. */
+ constexpr CVector4A() : x(0.f), y(0.f), z(0.f), w(0.f) {}
+ /** @brief Leaves every component uninitialized; see EU::NoInit. */
+ explicit CVector4A(EU::NoInitTag) {}
+ /** @brief Parameterized constructor. */
+ constexpr CVector4A(float x, float y, float z, float w)
+  : x(x), y(y), z(z), w(w) {
+ }
+ /** @brief Converts from an unaligned CVector4. */
+ constexpr CVector4A(const CVector4& v)
+  : x(v.x), y(v.y), z(v.z), w(v.w) {
+ }
+ /** @brief Stores a SIMD register. */
+ explicit CVector4A(EU::SIMD::Float4 v) : x(0.f), y(0.f), z(0.f), w(0.f) {
+  v.storeAligned(&x);
+ }
+
+ /** @brief Converts to an unaligned CVector4. */
+ constexpr operator CVector4() const {
+  return CVector4(x, y, z, w);
+ }
+
+ /** @brief The components as a SIMD register. */
+ EU::SIMD::Float4 simd() const {
+  return EU::SIMD::Float4::loadAligned(&x);
+ }
+
+ /** @brief Adds two vectors. */
+ CVector4A operator+(const CVector4A& otro) const {
+  return CVector4A(simd() + otro.simd());
+ }
+
+ /** @brief Subtracts two vectors. */
+ CVector4A operator-(const CVector4A& otro) const {
+  return CVector4A(simd() - otro.simd());
+ }
+
+ /** @brief Multiplies the vector by a scalar. */
+ CVector4A operator*(float fac) const {
+  return CVector4A(simd() * EU::SIMD::Float4::set1(fac));
+ }
+
+ /** @brief Divides the vector by a scalar. */
+ CVector4A operator/(float fac) const {
+  return CVector4A(simd() / EU::SIMD::Float4::set1(fac));
+ }
+
+ /** @brief In-place addition. */
+ CVector4A& operator+=(const CVector4A& otro) {
+  return *this = *this + otro;
+ }
+
+ /** @brief In-place subtraction. */
+ CVector4A& operator-=(const CVector4A& otro) {
+  return *this = *this - otro;
+ }
+
+ /** @brief In-place scalar multiplication. */
+ CVector4A& operator*=(float fac) {
+  return *this = *this * fac;
+ }
+
+ /** @brief In-place scalar division. */
+ CVector4A& operator/=(float fac) {
+  return *this = *this / fac;
+ }
+
+ /** @brief Equality comparison. */
+ bool operator==(const CVector4A& otro) const {
+  return EU::SIMD::movemask(simd() == otro.simd()) == 0xf;
+ }
+
+ /** @brief Inequality comparison. */
+ bool operator!=(const CVector4A& otro) const {
+  return !(*this == otro);
+ }
+
+ /** @brief True when every component is within epsilon of otro's; one compare per vector. */
+ bool approxEqual(const CVector4A& otro, float epsilon = EU::Constants::EPSILON) const {
+  return EU::SIMD::all(EU::SIMD::approxEqual(simd(), otro.simd(), EU::SIMD::Float4::set1(epsilon)));
+ }
+
+ /** @brief Access component by index (0 = x, 1 = y, 2 = z, 3 = w). */
+ constexpr float& operator[](int i) {
+  return EU::detail::ComponentTable<CVector4A, float, &CVector4A::x, &CVector4A::y, &CVector4A::z, &CVector4A::w>::get(*this, i);
+ }
+
+ /** @brief Const access to component by index. */
+ constexpr const float& operator[](int i) const {
+  return EU::detail::ComponentTable<CVector4A, float, &CVector4A::x, &CVector4A::y, &CVector4A::z, &CVector4A::w>::get(*this, i);
+ }
+
+ /**
+  * @brief Swizzles v.xz(), v.xyz(), v.wzyx(), ...; see VectorSwizzle.h.
+  *
+  * Four-component reads are a single register shuffle.
+  */
+ EU_SWIZZLES_2(CVector4A, 4, CVector2)
+ EU_SWIZZLES_3(CVector4A, 4, CVector3)
+ EU_SWIZZLES_4(CVector4A, 4, CVector4A)
+
+ /** @brief Returns the vector's magnitude. */
+ template<typename Policy = EU::Precision::Default>
+ float length() const {
+  return Policy::sqrt(lengthSquared());
+ }
+
+ /** @brief Returns the squared magnitude (avoids sqrt). */
+ float lengthSquared() const {
+  EU::SIMD::Float4 v = simd();
+  return EU::SIMD::first(EU::SIMD::dot4(v, v));
+ }
+
+ /** @brief Computes the dot product with another vector. */
+ float dot(const CVector4A& other) const {
+  return EU::SIMD::first(EU::SIMD::dot4(simd(), other.simd()));
+ }
+
+ /** @brief Returns a normalized copy of this vector. */
+ template<typename Policy = EU::Precision::Default>
+ CVector4A normalized() const {
+  float lenSq = lengthSquared();
+  if (lenSq == 0.f) return CVector4A(0.f, 0.f, 0.f, 0.f);
+  return *this * Policy::invLength(lenSq);
+ }
+
+ /** @brief Normalizes this vector in-place. */
+ template<typename Policy = EU::Precision::Default>
+ void normalize() {
+  float lenSq = lengthSquared();
+  if (lenSq != 0.f) {
+   *this *= Policy::invLength(lenSq);
+  }
+ }
+
+ /**
+  * @brief Calculates the distance between two 4D vectors.
+  * @param a First vector.
+  * @param b Second vector.
+  * @return Euclidean distance.
+  */
+ template<typename Policy = EU::Precision::Default>
+ static float distance(const CVector4A& a, const CVector4A& b) {
+  return (a - b).length<Policy>();
+ }
+
+ /**
+  * @brief Linearly interpolates between two vectors.
+  * @param a Start vector.
+  * @param b End vector.
+  * @param t Interpolation factor [0, 1].
+  * @return Interpolated vector.
+  */
+ static CVector4A lerp(const CVector4A& a, const CVector4A& b, float t) {
+  return lerpUnclamped(a, b, EngineMath::clamp(t, 0.f, 1.f));
+ }
+
+ /**
+  * @brief Linear interpolation without clamping, extrapolates for t outside [0, 1].
+  */
+ static CVector4A lerpUnclamped(const CVector4A& a, const CVector4A& b, float t) {
+  EU::SIMD::Float4 va = a.simd();
+  return CVector4A(EU::SIMD::madd(b.simd() - va, EU::SIMD::Float4::set1(t), va));
+ }
+
+ /** @brief Returns a vector (0, 0, 0, 0). */
+ static constexpr CVector4A zero() {
+  return CVector4A(0.f, 0.f, 0.f, 0.f);
+ }
+ /** @brief Returns a vector (1, 1, 1, 1). */
+ static constexpr CVector4A one() {
+  return CVector4A(1.f, 1.f, 1.f, 1.f);
+ }
+
+ // --- Transformation Helpers (for debugging or simulation) ---
+
+ /** @brief Sets this vector as a position. */
+ constexpr void setPosition(const CVector4A& pos) {
+  x = pos.x; y = pos.y; z = pos.z; w = pos.w;
+ }
+
+ /** @brief Moves this vector by an offset. */
+ void move(const CVector4A& ofs) {
+  *this += ofs;
+ }
+
+ /** @brief Sets this vector as a scale. */
+ constexpr void setScale(const CVector4A& fac) {
+  x = fac.x; y = fac.y; z = fac.z; w = fac.w;
+ }
+
+ /** @brief Scales this vector component-wise. */
+ void scale(const CVector4A& fac) {
+  *this = CVector4A(simd() * fac.simd());
+ }
+
+ /** @brief Sets this vector as an origin point. */
+ constexpr void setOrigin(const CVector4A& ori) {
+  x = ori.x; y = ori.y; z = ori.z; w = ori.w;
+ }
+};
+
+static_assert(sizeof(CVector4A) == 4 * sizeof(float) && alignof(CVector4A) == 16, "one SIMD register");
+EU_ASSERT_VALUE_TYPE(CVector4A);
+
+namespace EU {
+ namespace detail {
+  /** Four-component CVector4A swizzles read with one EU::SIMD::shuffle. */
+  template<int A, int B, int C, int D>
+  struct SwizzleRead<CVector4A, CVector4A, A, B, C, D> {
+   static CVector4A
+    read(const CVector4A& v) {
+    return CVector4A(EU::SIMD::shuffle<A, B, C, D>(v.simd()));
+   }
+  };
+ }
+}
@@ -0,0 +1,574 @@
+/**
+ * @file VectorBatch.h
+ * @brief Array-at-a-time normalize, length, distance, dot and cross for CVector2 and CVector3.
+ *
+ * Every function comes in two layouts: plain CVector2/CVector3 arrays (AoS), deinterleaved into
+ * registers on load, and SoA views (EngineMath::batch::SoA2/SoA3, e.g. Vector3Stream::soa()).
+ * Zero-length vectors are masked instead of branched on, so they normalize to zero; packets
+ * with a squared length that underflows or overflows are rescaled first, as by normalize(). The
+ * Policy argument picks the sqrt/rsqrt tier exactly as for the scalar and packet types.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/SIMD.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Precision.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ namespace detail {
+  using BatchLanes = EU::SIMD::FloatN;
+  constexpr size_t BATCH_WIDTH = static_cast<size_t>(BatchLanes::WIDTH);
+
+  static_assert(sizeof(CVector2) == 2 * sizeof(float), "CVector2 must be two packed floats");
+  static_assert(sizeof(CVector3) == 3 * sizeof(float), "CVector3 must be three packed floats");
+
+  using BatchInt = BatchLanes::Int;
+
+  /** Lane mask with the first count lanes set (count <= BATCH_WIDTH). */
+  inline BatchLanes
+   firstLanes(size_t count) {
+   static const int32_t bits[16] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+   return EU::SIMD::asFloat(BatchInt::load(bits + 8 - count));
+  }
+
+  /** Loads the count (<= BATCH_WIDTH) floats at p[i..], zero padded. */
+  inline BatchLanes
+   loadLanes(const float* p, size_t i, size_t count) {
+   if (count == BATCH_WIDTH) {
+    return BatchLanes::load(p + i);
+   }
+   float tmp[BATCH_WIDTH] = {};
+   for (size_t j = 0; j < count; ++j) tmp[j] = p[i + j];
+   return BatchLanes::load(tmp);
+  }
+
+  /** Every lane of out[k] set to component k of p. */
+  inline void
+   splatLanes3(const CVector3& p, BatchLanes (&out)[3]) {
+   out[0] = BatchLanes::set1(p.x);
+   out[1] = BatchLanes::set1(p.y);
+   out[2] = BatchLanes::set1(p.z);
+  }
+
+  /** loadLanes() of each component of the SoA p. */
+  inline void
+   loadLanes3(EngineMath::batch::ConstSoA3 p, size_t i, size_t count, BatchLanes (&out)[3]) {
+   out[0] = loadLanes(p.x, i, count);
+   out[1] = loadLanes(p.y, i, count);
+   out[2] = loadLanes(p.z, i, count);
+  }
+
+  /** Stores the first count lanes of v at out[i..]. */
+  inline void
+   storeLanes(BatchLanes v, float* out, size_t i, size_t count) {
+   if (count == BATCH_WIDTH) {
+    v.store(out + i);
+    return;
+   }
+   float tmp[BATCH_WIDTH];
+   v.store(tmp);
+   for (size_t j = 0; j < count; ++j) out[i + j] = tmp[j];
+  }
+
+  /** Appends base + lane to out for every set lane of mask among the first count. */
+  inline size_t
+   appendLanes(BatchLanes mask, size_t count, uint32_t base, uint32_t* out, size_t found) {
+   int hits = EU::SIMD::movemask(mask) & ((1 << count) - 1);
+   for (uint32_t j = 0; hits != 0; ++j, hits >>= 1) {
+    if (hits & 1) out[found++] = base + j;
+   }
+   return found;
+  }
+
+  /**
+   * Calls fn(i, count, x, y) for every packet of an interleaved (x, y) array. The last packet
+   * is zero padded and count tells how many of its lanes are real.
+   */
+  template<typename Fn>
+  inline void
+   forEachPacket2(const float* in, size_t n, Fn fn) {
+   BatchLanes x, y;
+   size_t i = 0;
+   for (; i + BATCH_WIDTH <= n; i += BATCH_WIDTH) {
+    EU::SIMD::loadInterleaved2(in + 2 * i, x, y);
+    fn(i, BATCH_WIDTH, x, y);
+   }
+   if (i < n) {
+    float tmp[2 * BATCH_WIDTH] = {};
+    for (size_t j = 0; j < 2 * (n - i); ++j) tmp[j] = in[2 * i + j];
+    EU::SIMD::loadInterleaved2(tmp, x, y);
+    fn(i, n - i, x, y);
+   }
+  }
+
+  /** SoA variant of forEachPacket2(). */
+  template<typename Fn>
+  inline void
+   forEachPacket2(EngineMath::batch::ConstSoA2 in, size_t n, Fn fn) {
+   size_t i = 0;
+   for (; i + BATCH_WIDTH <= n; i += BATCH_WIDTH) {
+    fn(i, BATCH_WIDTH, BatchLanes::load(in.x + i), BatchLanes::load(in.y + i));
+   }
+   if (i < n) {
+    float tx[BATCH_WIDTH] = {}, ty[BATCH_WIDTH] = {};
+    for (size_t j = i; j < n; ++j) {
+     tx[j - i] = in.x[j];
+     ty[j - i] = in.y[j];
+    }
+    fn(i, n - i, BatchLanes::load(tx), BatchLanes::load(ty));
+   }
+  }
+
+  /** Calls fn(i, count, x, y, z) for every packet of an interleaved (x, y, z) array. */
+  template<typename Fn>
+  inline void
+   forEachPacket3(const float* in, size_t n, Fn fn) {
+   BatchLanes x, y, z;
+   size_t i = 0;
+   for (; i + BATCH_WIDTH <= n; i += BATCH_WIDTH) {
+    EU::SIMD::loadInterleaved3(in + 3 * i, x, y, z);
+    fn(i, BATCH_WIDTH, x, y, z);
+   }
+   if (i < n) {
+    float tmp[3 * BATCH_WIDTH] = {};
+    for (size_t j = 0; j < 3 * (n - i); ++j) tmp[j] = in[3 * i + j];
+    EU::SIMD::loadInterleaved3(tmp, x, y, z);
+    fn(i, n - i, x, y, z);
+   }
+  }
+
+  /** SoA variant of forEachPacket3(). */
+  template<typename Fn>
+  inline void
+   forEachPacket3(EngineMath::batch::ConstSoA3 in, size_t n, Fn fn) {
+   size_t i = 0;
+   for (; i + BATCH_WIDTH <= n; i += BATCH_WIDTH) {
+    fn(i, BATCH_WIDTH, BatchLanes::load(in.x + i), BatchLanes::load(in.y + i), BatchLanes::load(in.z + i));
+   }
+   if (i < n) {
+    float tx[BATCH_WIDTH] = {}, ty[BATCH_WIDTH] = {}, tz[BATCH_WIDTH] = {};
+    for (size_t j = i; j < n; ++j) {
+     tx[j - i] = in.x[j];
+     ty[j - i] = in.y[j];
+     tz[j - i] = in.z[j];
+    }
+    fn(i, n - i, BatchLanes::load(tx), BatchLanes::load(ty), BatchLanes::load(tz));
+   }
+  }
+
+  /** Loads the count (<= BATCH_WIDTH) interleaved vectors at in[i..], zero padded. */
+  inline void
+   loadPacket2(const float* in, size_t i, size_t count, BatchLanes& x, BatchLanes& y) {
+   if (count == BATCH_WIDTH) {
+    EU::SIMD::loadInterleaved2(in + 2 * i, x, y);
+    return;
+   }
+   float tmp[2 * BATCH_WIDTH] = {};
+   for (size_t j = 0; j < 2 * count; ++j) tmp[j] = in[2 * i + j];
+   EU::SIMD::loadInterleaved2(tmp, x, y);
+  }
+
+  inline void
+   loadPacket2(EngineMath::batch::ConstSoA2 in, size_t i, size_t count, BatchLanes& x, BatchLanes& y) {
+   if (count == BATCH_WIDTH) {
+    x = BatchLanes::load(in.x + i);
+    y = BatchLanes::load(in.y + i);
+    return;
+   }
+   float tx[BATCH_WIDTH] = {}, ty[BATCH_WIDTH] = {};
+   for (size_t j = 0; j < count; ++j) {
+    tx[j] = in.x[i + j];
+    ty[j] = in.y[i + j];
+   }
+   x = BatchLanes::load(tx);
+   y = BatchLanes::load(ty);
+  }
+
+  inline void
+   loadPacket3(const float* in, size_t i, size_t count, BatchLanes& x, BatchLanes& y, BatchLanes& z) {
+   if (count == BATCH_WIDTH) {
+    EU::SIMD::loadInterleaved3(in + 3 * i, x, y, z);
+    return;
+   }
+   float tmp[3 * BATCH_WIDTH] = {};
+   for (size_t j = 0; j < 3 * count; ++j) tmp[j] = in[3 * i + j];
+   EU::SIMD::loadInterleaved3(tmp, x, y, z);
+  }
+
+  inline void
+   loadPacket3(EngineMath::batch::ConstSoA3 in, size_t i, size_t count, BatchLanes& x, BatchLanes& y, BatchLanes& z) {
+   if (count == BATCH_WIDTH) {
+    x = BatchLanes::load(in.x + i);
+    y = BatchLanes::load(in.y + i);
+    z = BatchLanes::load(in.z + i);
+    return;
+   }
+   float tx[BATCH_WIDTH] = {}, ty[BATCH_WIDTH] = {}, tz[BATCH_WIDTH] = {};
+   for (size_t j = 0; j < count; ++j) {
+    tx[j] = in.x[i + j];
+    ty[j] = in.y[i + j];
+    tz[j] = in.z[i + j];
+   }
+   x = BatchLanes::load(tx);
+   y = BatchLanes::load(ty);
+   z = BatchLanes::load(tz);
+  }
+
+  /** Calls fn(i, count, ax, ay, bx, by) for every packet of two sets of the same layout. */
+  template<typename In, typename Fn>
+  inline void
+   forEachPacketPair2(In a, In b, size_t n, Fn fn) {
+   for (size_t i = 0; i < n; i += BATCH_WIDTH) {
+    size_t count = n - i < BATCH_WIDTH ? n - i : BATCH_WIDTH;
+    BatchLanes ax, ay, bx, by;
+    loadPacket2(a, i, count, ax, ay);
+    loadPacket2(b, i, count, bx, by);
+    fn(i, count, ax, ay, bx, by);
+   }
+  }
+
+  /** Calls fn(i, count, ax, ay, az, bx, by, bz) for every packet of two sets of the same layout. */
+  template<typename In, typename Fn>
+  inline void
+   forEachPacketPair3(In a, In b, size_t n, Fn fn) {
+   for (size_t i = 0; i < n; i += BATCH_WIDTH) {
+    size_t count = n - i < BATCH_WIDTH ? n - i : BATCH_WIDTH;
+    BatchLanes ax, ay, az, bx, by, bz;
+    loadPacket3(a, i, count, ax, ay, az);
+    loadPacket3(b, i, count, bx, by, bz);
+    fn(i, count, ax, ay, az, bx, by, bz);
+   }
+  }
+
+  /** Writes count interleaved (x, y) records at out[i..]. */
+  inline void
+   storePacket2(float* out, size_t i, size_t count, BatchLanes x, BatchLanes y) {
+   if (count == BATCH_WIDTH) {
+    EU::SIMD::storeInterleaved2(out + 2 * i, x, y);
+    return;
+   }
+   float tmp[2 * BATCH_WIDTH];
+   EU::SIMD::storeInterleaved2(tmp, x, y);
+   for (size_t j = 0; j < 2 * count; ++j) out[2 * i + j] = tmp[j];
+  }
+
+  inline void
+   storePacket2(EngineMath::batch::SoA2 out, size_t i, size_t count, BatchLanes x, BatchLanes y) {
+   storeLanes(x, out.x, i, count);
+   storeLanes(y, out.y, i, count);
+  }
+
+  /** Writes count interleaved (x, y, z) records at out[i..]. */
+  inline void
+   storePacket3(float* out, size_t i, size_t count, BatchLanes x, BatchLanes y, BatchLanes z) {
+   if (count == BATCH_WIDTH) {
+    EU::SIMD::storeInterleaved3(out + 3 * i, x, y, z);
+    return;
+   }
+   float tmp[3 * BATCH_WIDTH];
+   EU::SIMD::storeInterleaved3(tmp, x, y, z);
+   for (size_t j = 0; j < 3 * count; ++j) out[3 * i + j] = tmp[j];
+  }
+
+  inline void
+   storePacket3(EngineMath::batch::SoA3 out, size_t i, size_t count, BatchLanes x, BatchLanes y, BatchLanes z) {
+   storeLanes(x, out.x, i, count);
+   storeLanes(y, out.y, i, count);
+   storeLanes(z, out.z, i, count);
+  }
+
+  /** 1 / sqrt(lenSq) where lenSq > 0, else 0, so zero vectors scale to zero; lenSq is normalizable() or zero. */
+  template<typename Policy>
+  inline BatchLanes
+   safeInvLength(BatchLanes lenSq) {
+   return Policy::invLengthLanes(lenSq) & (lenSq > BatchLanes::zero());
+  }
+
+  template<typename Policy, typename In, typename Out>
+  inline void
+   normalize2(In in, Out out, size_t n) {
+   forEachPacket2(in, n, [&](size_t i, size_t count, BatchLanes x, BatchLanes y) {
+    BatchLanes lenSq = Policy::maddLanes(y, y, x * x);
+    EU::Precision::rescaleLanes(x, y, lenSq);
+    BatchLanes inv = safeInvLength<Policy>(lenSq);
+    storePacket2(out, i, count, x * inv, y * inv);
+   });
+  }
+
+  template<typename Policy, typename In, typename Out>
+  inline void
+   normalize3(In in, Out out, size_t n) {
+   forEachPacket3(in, n, [&](size_t i, size_t count, BatchLanes x, BatchLanes y, BatchLanes z) {
+    BatchLanes lenSq = Policy::maddLanes(z, z, Policy::maddLanes(y, y, x * x));
+    EU::Precision::rescaleLanes(x, y, z, lenSq);
+    BatchLanes inv = safeInvLength<Policy>(lenSq);
+    storePacket3(out, i, count, x * inv, y * inv, z * inv);
+   });
+  }
+
+  /** out[i] = dot(a[i], b[i]), accumulated x, y, z with multiply-adds. */
+  template<typename In>
+  inline void
+   dot3(In a, In b, float* out, size_t n) {
+   forEachPacketPair3(a, b, n, [&](size_t i, size_t count, BatchLanes ax, BatchLanes ay, BatchLanes az,
+                                   BatchLanes bx, BatchLanes by, BatchLanes bz) {
+    storeLanes(EU::SIMD::madd(az, bz, EU::SIMD::madd(ay, by, ax * bx)), out, i, count);
+   });
+  }
+
+  /** out[i] = cross(a[i], b[i]): three multiplies and three multiply-subtracts per packet. */
+  template<typename In, typename Out>
+  inline void
+   cross3(In a, In b, Out out, size_t n) {
+   forEachPacketPair3(a, b, n, [&](size_t i, size_t count, BatchLanes ax, BatchLanes ay, BatchLanes az,
+                                   BatchLanes bx, BatchLanes by, BatchLanes bz) {
+    storePacket3(out, i, count,
+                 EU::SIMD::msub(ay, bz, az * by),
+                 EU::SIMD::msub(az, bx, ax * bz),
+                 EU::SIMD::msub(ax, by, ay * bx));
+   });
+  }
+
+  /** out[i] = dot(v, in[i]). */
+  template<typename In>
+  inline void
+   dotOne3(const CVector3& v, In in, float* out, size_t n) {
+   const BatchLanes vx = BatchLanes::set1(v.x), vy = BatchLanes::set1(v.y), vz = BatchLanes::set1(v.z);
+   forEachPacket3(in, n, [&](size_t i, size_t count, BatchLanes x, BatchLanes y, BatchLanes z) {
+    storeLanes(EU::SIMD::madd(vz, z, EU::SIMD::madd(vy, y, vx * x)), out, i, count);
+   });
+  }
+
+  /** out[i] = sqrt(|in[i] - point|^2), or the squared value when Squared is set. */
+  template<typename Policy, bool Squared, typename In>
+  inline void
+   distance2(CVector2 point, In in, float* out, size_t n) {
+   const BatchLanes px = BatchLanes::set1(point.x), py = BatchLanes::set1(point.y);
+   forEachPacket2(in, n, [&](size_t i, size_t count, BatchLanes x, BatchLanes y) {
+    BatchLanes dx = x - px, dy = y - py;
+    BatchLanes d2 = Policy::maddLanes(dy, dy, dx * dx);
+    storeLanes(Squared ? d2 : Policy::sqrtLanes(d2), out, i, count);
+   });
+  }
+
+  template<typename Policy, bool Squared, typename In>
+  inline void
+   distance3(const CVector3& point, In in, float* out, size_t n) {
+   const BatchLanes px = BatchLanes::set1(point.x), py = BatchLanes::set1(point.y), pz = BatchLanes::set1(point.z);
+   forEachPacket3(in, n, [&](size_t i, size_t count, BatchLanes x, BatchLanes y, BatchLanes z) {
+    BatchLanes dx = x - px, dy = y - py, dz = z - pz;
+    BatchLanes d2 = Policy::maddLanes(dz, dz, Policy::maddLanes(dy, dy, dx * dx));
+    storeLanes(Squared ? d2 : Policy::sqrtLanes(d2), out, i, count);
+   });
+  }
+ }
+
+ // --- CVector3, AoS ---
+
+ /** @brief out[i] = in[i] normalized; zero vectors stay zero. out may alias in. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  normalizeArray(const CVector3* in, CVector3* out, size_t n) {
+  detail::normalize3<Policy>(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n);
+ }
+
+ /** @brief Normalizes n vectors in place. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  normalizeArray(CVector3* v, size_t n) {
+  normalizeArray<Policy>(v, v, n);
+ }
+
+ /** @brief out[i] = in[i].length(). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  lengthArray(const CVector3* in, float* out, size_t n) {
+  detail::distance3<Policy, false>(CVector3(), reinterpret_cast<const float*>(in), out, n);
+ }
+
+ /** @brief out[i] = in[i].lengthSquared(). */
+ inline void
+  lengthSquaredArray(const CVector3* in, float* out, size_t n) {
+  detail::distance3<EU::Precision::Default, true>(CVector3(), reinterpret_cast<const float*>(in), out, n);
+ }
+
+ /** @brief out[i] = distance(point, in[i]). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  distanceArray(const CVector3& point, const CVector3* in, float* out, size_t n) {
+  detail::distance3<Policy, false>(point, reinterpret_cast<const float*>(in), out, n);
+ }
+
+ /** @brief out[i] = squared distance from point to in[i]; no square root. */
+ inline void
+  distanceSquaredArray(const CVector3& point, const CVector3* in, float* out, size_t n) {
+  detail::distance3<EU::Precision::Default, true>(point, reinterpret_cast<const float*>(in), out, n);
+ }
+
+ /** @brief out[i] = a[i].dot(b[i]). */
+ inline void
+  dotArray(const CVector3* a, const CVector3* b, float* out, size_t n) {
+  detail::dot3(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), out, n);
+ }
+
+ /** @brief out[i] = v.dot(in[i]), e.g. projecting many points onto one axis. */
+ inline void
+  dotArray(const CVector3& v, const CVector3* in, float* out, size_t n) {
+  detail::dotOne3(v, reinterpret_cast<const float*>(in), out, n);
+ }
+
+ /** @brief out[i] = a[i].cross(b[i]); out may alias a or b. */
+ inline void
+  crossArray(const CVector3* a, const CVector3* b, CVector3* out, size_t n) {
+  detail::cross3(reinterpret_cast<const float*>(a), reinterpret_cast<const float*>(b), reinterpret_cast<float*>(out), n);
+ }
+
+ // --- CVector3, SoA ---
+
+ /** @brief SoA normalizeArray(); out may alias in. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  normalizeArray(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n) {
+  detail::normalize3<Policy>(in, out, n);
+ }
+
+ /** @brief Normalizes an SoA view in place, e.g. normalizeArray(stream.soa(), stream.size()). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  normalizeArray(EngineMath::batch::SoA3 v, size_t n) {
+  normalizeArray<Policy>(v, v, n);
+ }
+
+ /** @brief SoA lengthArray(). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  lengthArray(EngineMath::batch::ConstSoA3 in, float* out, size_t n) {
+  detail::distance3<Policy, false>(CVector3(), in, out, n);
+ }
+
+ /** @brief SoA lengthSquaredArray(). */
+ inline void
+  lengthSquaredArray(EngineMath::batch::ConstSoA3 in, float* out, size_t n) {
+  detail::distance3<EU::Precision::Default, true>(CVector3(), in, out, n);
+ }
+
+ /** @brief SoA distanceArray(). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  distanceArray(const CVector3& point, EngineMath::batch::ConstSoA3 in, float* out, size_t n) {
+  detail::distance3<Policy, false>(point, in, out, n);
+ }
+
+ /** @brief SoA distanceSquaredArray(). */
+ inline void
+  distanceSquaredArray(const CVector3& point, EngineMath::batch::ConstSoA3 in, float* out, size_t n) {
+  detail::distance3<EU::Precision::Default, true>(point, in, out, n);
+ }
+
+ /** @brief SoA dotArray(). */
+ inline void
+  dotArray(EngineMath::batch::ConstSoA3 a, EngineMath::batch::ConstSoA3 b, float* out, size_t n) {
+  detail::dot3(a, b, out, n);
+ }
+
+ /** @brief SoA dotArray() of one vector against many. */
+ inline void
+  dotArray(const CVector3& v, EngineMath::batch::ConstSoA3 in, float* out, size_t n) {
+  detail::dotOne3(v, in, out, n);
+ }
+
+ /** @brief SoA crossArray(); out may alias a or b. */
+ inline void
+  crossArray(EngineMath::batch::ConstSoA3 a, EngineMath::batch::ConstSoA3 b, EngineMath::batch::SoA3 out, size_t n) {
+  detail::cross3(a, b, out, n);
+ }
+
+ // --- CVector2, AoS ---
+
+ /** @brief out[i] = in[i] normalized; zero vectors stay zero. out may alias in. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  normalizeArray(const CVector2* in, CVector2* out, size_t n) {
+  detail::normalize2<Policy>(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n);
+ }
+
+ /** @brief Normalizes n vectors in place. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  normalizeArray(CVector2* v, size_t n) {
+  normalizeArray<Policy>(v, v, n);
+ }
+
+ /** @brief out[i] = in[i].length(). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  lengthArray(const CVector2* in, float* out, size_t n) {
+  detail::distance2<Policy, false>(CVector2(), reinterpret_cast<const float*>(in), out, n);
+ }
+
+ /** @brief out[i] = in[i].lengthSquared(). */
+ inline void
+  lengthSquaredArray(const CVector2* in, float* out, size_t n) {
+  detail::distance2<EU::Precision::Default, true>(CVector2(), reinterpret_cast<const float*>(in), out, n);
+ }
+
+ /** @brief out[i] = distance(point, in[i]). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  distanceArray(const CVector2& point, const CVector2* in, float* out, size_t n) {
+  detail::distance2<Policy, false>(point, reinterpret_cast<const float*>(in), out, n);
+ }
+
+ /** @brief out[i] = squared distance from point to in[i]; no square root. */
+ inline void
+  distanceSquaredArray(const CVector2& point, const CVector2* in, float* out, size_t n) {
+  detail::distance2<EU::Precision::Default, true>(point, reinterpret_cast<const float*>(in), out, n);
+ }
+
+ // --- CVector2, SoA ---
+
+ /** @brief SoA normalizeArray(); out may alias in. */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  normalizeArray(EngineMath::batch::ConstSoA2 in, EngineMath::batch::SoA2 out, size_t n) {
+  detail::normalize2<Policy>(in, out, n);
+ }
+
+ /** @brief Normalizes an SoA view in place, e.g. normalizeArray(stream.soa(), stream.size()). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  normalizeArray(EngineMath::batch::SoA2 v, size_t n) {
+  normalizeArray<Policy>(v, v, n);
+ }
+
+ /** @brief SoA lengthArray(). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  lengthArray(EngineMath::batch::ConstSoA2 in, float* out, size_t n) {
+  detail::distance2<Policy, false>(CVector2(), in, out, n);
+ }
+
+ /** @brief SoA lengthSquaredArray(). */
+ inline void
+  lengthSquaredArray(EngineMath::batch::ConstSoA2 in, float* out, size_t n) {
+  detail::distance2<EU::Precision::Default, true>(CVector2(), in, out, n);
+ }
+
+ /** @brief SoA distanceArray(). */
+ template<typename Policy = EU::Precision::Default>
+ inline void
+  distanceArray(const CVector2& point, EngineMath::batch::ConstSoA2 in, float* out, size_t n) {
+  detail::distance2<Policy, false>(point, in, out, n);
+ }
+
+ /** @brief SoA distanceSquaredArray(). */
+ inline void
+  distanceSquaredArray(const CVector2& point, EngineMath::batch::ConstSoA2 in, float* out, size_t n) {
+  detail::distance2<EU::Precision::Default, true>(point, in, out, n);
+ }
+}
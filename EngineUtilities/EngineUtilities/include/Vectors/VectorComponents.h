@@ -0,0 +1,40 @@
+/**
+ * @file VectorComponents.h
+ * @brief Branch-free index access to named vector components.
+ *
+ * The vector classes keep their components as named members x, y, z, w, and operator[] goes
+ * through a constant table of pointers to those members: one table load and one indexed
+ * load, with no branches and no union punning or pointer arithmetic across members.
+ */
+
+#pragma once
+
+namespace EU {
+ namespace detail {
+  /** Constant table of the members M... of V, all of type T. */
+  template<typename V, typename T, T V::*... M>
+  struct ComponentTable {
+   static constexpr int COUNT = static_cast<int>(sizeof...(M));
+   static constexpr T V::* members[sizeof...(M)] = { M... };
+
+   /** Index clamped to [0, COUNT - 1] without a branch; out-of-range picks the last member. */
+   static constexpr int
+    clampIndex(int i) {
+    return static_cast<unsigned>(i) < static_cast<unsigned>(COUNT) ? i : COUNT - 1;
+   }
+
+   static constexpr T&
+    get(V& v, int i) {
+    return v.*members[clampIndex(i)];
+   }
+
+   static constexpr const T&
+    get(const V& v, int i) {
+    return v.*members[clampIndex(i)];
+   }
+  };
+
+  template<typename V, typename T, T V::*... M>
+  constexpr T V::* ComponentTable<V, T, M...>::members[sizeof...(M)];
+ }
+}
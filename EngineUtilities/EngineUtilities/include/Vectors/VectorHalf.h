@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Math/Half.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector4.h>
+
+/**
+ * @class CVector2h
+ * @brief Storage-only 2D vector of IEEE half components (4 bytes), e.g. for UVs.
+ *
+ * There is deliberately no arithmetic: values are converted once when stored (explicit
+ * constructor, pack()) and once when loaded (toFloat(), unpack()), and all math happens on
+ * CVector2.
+ */
+class CVector2h {
+public:
+ uint16_t x; ///< X component, binary16 bits
+ uint16_t y; ///< Y component, binary16 bits
+
+ /** @brief Default constructor. Initializes to (+0, +0). */
+ constexpr CVector2h() : x(0), y(0) {}
+
+ /** @brief Stores a float vector, rounding each component to the nearest half. */
+ EU_CONSTEXPR20 explicit CVector2h(const CVector2& v)
+  : x(EngineMath::toHalf(v.x)), y(EngineMath::toHalf(v.y)) {
+ }
+
+ /** @brief Loads the vector back as floats (exact). */
+ EU_CONSTEXPR20 CVector2
+  toFloat() const {
+  return CVector2(EngineMath::fromHalf(x), EngineMath::fromHalf(y));
+ }
+
+ /** @brief Bitwise comparison of the stored halves. */
+ constexpr bool
+  operator==(const CVector2h& otro) const {
+  return x == otro.x && y == otro.y;
+ }
+
+ constexpr bool
+  operator!=(const CVector2h& otro) const {
+  return !(*this == otro);
+ }
+
+ /** @brief Bulk store of n vectors (F16C / NEON when available). */
+ static void
+  pack(const CVector2* in, CVector2h* out, size_t n) {
+  EngineMath::batch::toHalf(reinterpret_cast<const float*>(in), reinterpret_cast<uint16_t*>(out), 2 * n);
+ }
+
+ /** @brief Bulk load of n vectors. */
+ static void
+  unpack(const CVector2h* in, CVector2* out, size_t n) {
+  EngineMath::batch::fromHalf(reinterpret_cast<const uint16_t*>(in), reinterpret_cast<float*>(out), 2 * n);
+ }
+};
+
+/**
+ * @class CVector3h
+ * @brief Storage-only 3D vector of IEEE half components (6 bytes), e.g. for normals.
+ */
+class CVector3h {
+public:
+ uint16_t x; ///< X component, binary16 bits
+ uint16_t y; ///< Y component, binary16 bits
+ uint16_t z; ///< Z component, binary16 bits
+
+ /** @brief Default constructor. Initializes to (+0, +0, +0). */
+ constexpr CVector3h() : x(0), y(0), z(0) {}
+
+ /** @brief Stores a float vector, rounding each component to the nearest half. */
+ EU_CONSTEXPR20 explicit CVector3h(const CVector3& v)
+  : x(EngineMath::toHalf(v.x)), y(EngineMath::toHalf(v.y)), z(EngineMath::toHalf(v.z)) {
+ }
+
+ /** @brief Loads the vector back as floats (exact). */
+ EU_CONSTEXPR20 CVector3
+  toFloat() const {
+  return CVector3(EngineMath::fromHalf(x), EngineMath::fromHalf(y), EngineMath::fromHalf(z));
+ }
+
+ /** @brief Bitwise comparison of the stored halves. */
+ constexpr bool
+  operator==(const CVector3h& otro) const {
+  return x == otro.x && y == otro.y && z == otro.z;
+ }
+
+ constexpr bool
+  operator!=(const CVector3h& otro) const {
+  return !(*this == otro);
+ }
+
+ /** @brief Bulk store of n vectors (F16C / NEON when available). */
+ static void
+  pack(const CVector3* in, CVector3h* out, size_t n) {
+  EngineMath::batch::toHalf(reinterpret_cast<const float*>(in), reinterpret_cast<uint16_t*>(out), 3 * n);
+ }
+
+ /** @brief Bulk load of n vectors. */
+ static void
+  unpack(const CVector3h* in, CVector3* out, size_t n) {
+  EngineMath::batch::fromHalf(reinterpret_cast<const uint16_t*>(in), reinterpret_cast<float*>(out), 3 * n);
+ }
+};
+
+/**
+ * @class CVector4h
+ * @brief Storage-only 4D vector of IEEE half components (8 bytes), e.g. for animation channels.
+ */
+class CVector4h {
+public:
+ uint16_t x; ///< X component, binary16 bits
+ uint16_t y; ///< Y component, binary16 bits
+ uint16_t z; ///< Z component, binary16 bits
+ uint16_t w; ///< W component, binary16 bits
+
+ /** @brief Default constructor. Initializes to (+0, +0, +0, +0). */
+ constexpr CVector4h() : x(0), y(0), z(0), w(0) {}
+
+ /** @brief Stores a float vector, rounding each component to the nearest half. */
+ EU_CONSTEXPR20 explicit CVector4h(const CVector4& v)
+  : x(EngineMath::toHalf(v.x)), y(EngineMath::toHalf(v.y)),
+    z(EngineMath::toHalf(v.z)), w(EngineMath::toHalf(v.w)) {
+ }
+
+ /** @brief Loads the vector back as floats (exact). */
+ EU_CONSTEXPR20 CVector4
+  toFloat() const {
+  return CVector4(EngineMath::fromHalf(x), EngineMath::fromHalf(y),
+                  EngineMath::fromHalf(z), EngineMath::fromHalf(w));
+ }
+
+ /** @brief Bitwise comparison of the stored halves. */
+ constexpr bool
+  operator==(const CVector4h& otro) const {
+  return x == otro.x && y == otro.y && z == otro.z && w == otro.w;
+ }
+
+ constexpr bool
+  operator!=(const CVector4h& otro) const {
+  return !(*this == otro);
+ }
+
+ /** @brief Bulk store of n vectors (F16C / NEON when available). */
+ static void
+  pack(const CVector4* in, CVector4h* out, size_t n) {
+  EngineMath::batch::toHalf(reinterpret_cast<const float*>(in), reinterpret_cast<uint16_t*>(out), 4 * n);
+ }
+
+ /** @brief Bulk load of n vectors. */
+ static void
+  unpack(const CVector4h* in, CVector4* out, size_t n) {
+  EngineMath::batch::fromHalf(reinterpret_cast<const uint16_t*>(in), reinterpret_cast<float*>(out), 4 * n);
+ }
+};
+
+static_assert(sizeof(CVector2) == 2 * sizeof(float) && sizeof(CVector2h) == 2 * sizeof(uint16_t), "packed layout");
+static_assert(sizeof(CVector3) == 3 * sizeof(float) && sizeof(CVector3h) == 3 * sizeof(uint16_t), "packed layout");
+static_assert(sizeof(CVector4) == 4 * sizeof(float) && sizeof(CVector4h) == 4 * sizeof(uint16_t), "packed layout");
+EU_ASSERT_VALUE_TYPE(CVector2h);
+EU_ASSERT_VALUE_TYPE(CVector3h);
+EU_ASSERT_VALUE_TYPE(CVector4h);
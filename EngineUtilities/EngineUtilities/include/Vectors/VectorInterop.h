@@ -0,0 +1,24 @@
+/**
+ * @file VectorInterop.h
+ * @brief Opt-in implicit conversions between CVector2/CVector3 and third-party vector types.
+ *
+ * Specialize EU::VectorInterop<T> with `using Native = CVector2;` (or CVector3) and static
+ * toNative(const T&) / fromNative(const Native&) to make T convert implicitly both ways.
+ * Types without a specialization are unaffected. VectorSFML.h registers the SFML vectors.
+ */
+
+#pragma once
+
+#include <type_traits>
+
+namespace EU {
+ /** @brief Conversion hooks for a foreign vector type T; empty (disabled) unless specialized. */
+ template<typename T>
+ struct VectorInterop {};
+
+ namespace detail {
+  /** int when VectorInterop<T> maps T to Native, otherwise a substitution failure. */
+  template<typename T, typename Native>
+  using EnableInterop = typename std::enable_if<std::is_same<typename VectorInterop<T>::Native, Native>::value, int>::type;
+ }
+}
@@ -0,0 +1,273 @@
+/**
+ * @file VectorNetwork.h
+ * @brief Bit-packed, quantized CVector2/CVector3 serialization on top of sf::Packet.
+ *
+ * BitWriter appends fields of any width from 1 to 32 bits to a packet with no padding between
+ * them, and BitReader reads them back in the same order. writeQuantized()/readQuantized() map
+ * each axis of a vector inside known bounds onto 2^bits evenly spaced steps, so a position in
+ * a 4 km world at 18 bits per axis costs 54 bits instead of 96 and lands within 8 mm of the
+ * original. Values outside the bounds are clamped to them. Both ends must agree on the bounds
+ * and bit counts; nothing about them is written to the stream.
+ *
+ * Bits are packed least significant first and emitted as bytes, so the format is the same on
+ * every platform. Anything written through the packet's own operator<< between a
+ * BitWriter's flushes ends up in the middle of the bit stream, so finish one before the other.
+ * Needs sfml-network at link time.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <SFML/Network/Packet.hpp>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorReduce.h>
+
+namespace EU {
+ /**
+  * @class BitWriter
+  * @brief Appends bit fields to an sf::Packet; the last partial byte is written by flush().
+  *
+  * The destructor flushes, so a scoped writer never loses its tail.
+  */
+ class
+  BitWriter {
+  public:
+  explicit BitWriter(sf::Packet& packet) : m_packet(packet), m_pending(0), m_count(0), m_written(0) {}
+
+  BitWriter(const BitWriter&) = delete;
+  BitWriter& operator=(const BitWriter&) = delete;
+
+  ~BitWriter() {
+   flush();
+  }
+
+  /** @brief Appends the low bits of value; bits is clamped to [0, 32]. */
+  void
+   write(uint32_t value, int bits) {
+   bits = bits < 0 ? 0 : (bits > 32 ? 32 : bits);
+   if (bits == 0) {
+    return;
+   }
+   const uint64_t mask = (uint64_t(1) << bits) - 1;
+   m_pending |= (static_cast<uint64_t>(value) & mask) << m_count;
+   m_count += bits;
+   m_written += static_cast<size_t>(bits);
+   if (m_count >= 32) {
+    emit(4);
+   }
+  }
+
+  /** @brief Appends one bit. */
+  void
+   writeBool(bool value) {
+   write(value ? 1u : 0u, 1);
+  }
+
+  /** @brief Writes the pending bits, zero-padded to a whole byte. */
+  void
+   flush() {
+   emit(static_cast<size_t>(m_count + 7) / 8);
+  }
+
+  /** @brief Bits written so far, including pending ones. */
+  size_t
+   bitCount() const {
+   return m_written;
+  }
+
+  private:
+  /** Appends the low bytes of the pending bits, least significant first. */
+  void
+   emit(size_t bytes) {
+   if (bytes == 0) {
+    return;
+   }
+   uint8_t out[4];
+   for (size_t i = 0; i < bytes; ++i) out[i] = static_cast<uint8_t>(m_pending >> (8 * i));
+   m_packet.append(out, bytes);
+   const int used = static_cast<int>(8 * bytes);
+   m_pending = used >= m_count ? 0 : m_pending >> used;
+   m_count = used >= m_count ? 0 : m_count - used;
+  }
+
+  sf::Packet& m_packet;
+  uint64_t m_pending; ///< Bits not yet appended, the oldest in bit 0
+  int m_count;        ///< Number of valid bits in m_pending (below 32 between calls)
+  size_t m_written;
+ };
+
+ /**
+  * @class BitReader
+  * @brief Reads bit fields written by BitWriter from an sf::Packet.
+  *
+  * Bytes are taken from the packet at its read position as they are needed; a field that runs
+  * past the end of the packet reads as 0 and leaves the reader (and the packet) invalid.
+  */
+ class
+  BitReader {
+  public:
+  explicit BitReader(sf::Packet& packet) : m_packet(packet), m_pending(0), m_count(0), m_valid(true) {}
+
+  BitReader(const BitReader&) = delete;
+  BitReader& operator=(const BitReader&) = delete;
+
+  /** @brief Reads a bits-wide field; bits is clamped to [0, 32]. */
+  uint32_t
+   read(int bits) {
+   bits = bits < 0 ? 0 : (bits > 32 ? 32 : bits);
+   while (m_count < bits) {
+    sf::Uint8 byte = 0;
+    if (!m_valid || !(m_packet >> byte)) {
+     m_valid = false;
+     return 0;
+    }
+    m_pending |= static_cast<uint64_t>(byte) << m_count;
+    m_count += 8;
+   }
+   const uint64_t mask = (uint64_t(1) << bits) - 1;
+   const uint32_t value = static_cast<uint32_t>(m_pending & mask);
+   m_pending >>= bits;
+   m_count -= bits;
+   return value;
+  }
+
+  /** @brief Reads one bit. */
+  bool
+   readBool() {
+   return read(1) != 0;
+  }
+
+  /** @brief Drops the rest of the current byte, matching BitWriter::flush(). */
+  void
+   alignToByte() {
+   m_pending = 0;
+   m_count = 0;
+  }
+
+  /** @brief False once a read ran past the end of the packet. */
+  bool
+   valid() const {
+   return m_valid;
+  }
+
+  explicit operator bool() const {
+   return m_valid;
+  }
+
+  private:
+  sf::Packet& m_packet;
+  uint64_t m_pending; ///< Bytes read but not yet consumed, the oldest bit in bit 0
+  int m_count;        ///< Number of valid bits in m_pending (below 8 between calls)
+  bool m_valid;
+ };
+
+ namespace detail {
+  /// Widest quantized field: a float only has 24 significant bits.
+  constexpr int MAX_QUANTIZE_BITS = 24;
+
+  constexpr int
+   quantizeBits(int bits) {
+   return bits < 1 ? 1 : (bits > MAX_QUANTIZE_BITS ? MAX_QUANTIZE_BITS : bits);
+  }
+
+  /**
+   * round((value - lo) / (hi - lo) * (2^bits - 1)), clamped to the range; NaN maps to 0.
+   * Done in double so the error stays within half a step even at 24 bits.
+   */
+  inline uint32_t
+   quantizeRange(float value, float lo, float hi, int bits) {
+   const double steps = static_cast<double>((1u << bits) - 1u);
+   const double t = hi > lo ? (static_cast<double>(value) - lo) / (static_cast<double>(hi) - lo) : 0.0;
+   if (!(t > 0.0)) return 0;
+   if (t >= 1.0) return static_cast<uint32_t>(steps);
+   return static_cast<uint32_t>(t * steps + 0.5);
+  }
+
+  /** Inverse of quantizeRange(); both ends of the range decode exactly. */
+  inline float
+   dequantizeRange(uint32_t q, float lo, float hi, int bits) {
+   const uint32_t steps = (1u << bits) - 1u;
+   if (q >= steps) return hi > lo ? hi : lo;
+   return static_cast<float>(lo + static_cast<double>(q) * ((static_cast<double>(hi) - lo) / steps));
+  }
+ }
+
+ /**
+  * @brief Largest error per axis when quantizing [lo, hi] at bitsPerAxis: half a step.
+  */
+ inline float
+  quantizationError(float lo, float hi, int bitsPerAxis) {
+  const int bits = detail::quantizeBits(bitsPerAxis);
+  return (hi - lo) / static_cast<float>((1u << bits) - 1u) * 0.5f;
+ }
+
+ /**
+  * @brief Writes v as bitsPerAxis bits per axis inside box.
+  * @param bitsPerAxis Bits per component, clamped to [1, 24].
+  */
+ inline void
+  writeQuantized(BitWriter& writer, const CVector3& v, const Bounds3& box, int bitsPerAxis) {
+  const int bits = detail::quantizeBits(bitsPerAxis);
+  writer.write(detail::quantizeRange(v.x, box.minimum.x, box.maximum.x, bits), bits);
+  writer.write(detail::quantizeRange(v.y, box.minimum.y, box.maximum.y, bits), bits);
+  writer.write(detail::quantizeRange(v.z, box.minimum.z, box.maximum.z, bits), bits);
+ }
+
+ /** @brief Writes v as bitsPerAxis bits per axis inside box. */
+ inline void
+  writeQuantized(BitWriter& writer, const CVector2& v, const Bounds2& box, int bitsPerAxis) {
+  const int bits = detail::quantizeBits(bitsPerAxis);
+  writer.write(detail::quantizeRange(v.x, box.minimum.x, box.maximum.x, bits), bits);
+  writer.write(detail::quantizeRange(v.y, box.minimum.y, box.maximum.y, bits), bits);
+ }
+
+ /** @brief Reads a vector written by writeQuantized() with the same box and bits. */
+ inline CVector3
+  readQuantized(BitReader& reader, const Bounds3& box, int bitsPerAxis) {
+  const int bits = detail::quantizeBits(bitsPerAxis);
+  const uint32_t x = reader.read(bits);
+  const uint32_t y = reader.read(bits);
+  const uint32_t z = reader.read(bits);
+  return CVector3(detail::dequantizeRange(x, box.minimum.x, box.maximum.x, bits),
+                  detail::dequantizeRange(y, box.minimum.y, box.maximum.y, bits),
+                  detail::dequantizeRange(z, box.minimum.z, box.maximum.z, bits));
+ }
+
+ /** @brief Reads a vector written by writeQuantized() with the same box and bits. */
+ inline CVector2
+  readQuantized(BitReader& reader, const Bounds2& box, int bitsPerAxis) {
+  const int bits = detail::quantizeBits(bitsPerAxis);
+  const uint32_t x = reader.read(bits);
+  const uint32_t y = reader.read(bits);
+  return CVector2(detail::dequantizeRange(x, box.minimum.x, box.maximum.x, bits),
+                  detail::dequantizeRange(y, box.minimum.y, box.maximum.y, bits));
+ }
+
+ /** @brief Writes n vectors back to back, e.g. every entity position of a snapshot. */
+ inline void
+  writeQuantized(BitWriter& writer, const CVector3* v, size_t n, const Bounds3& box, int bitsPerAxis) {
+  for (size_t i = 0; i < n; ++i) writeQuantized(writer, v[i], box, bitsPerAxis);
+ }
+
+ /** @brief Writes n vectors back to back. */
+ inline void
+  writeQuantized(BitWriter& writer, const CVector2* v, size_t n, const Bounds2& box, int bitsPerAxis) {
+  for (size_t i = 0; i < n; ++i) writeQuantized(writer, v[i], box, bitsPerAxis);
+ }
+
+ /** @brief Reads n vectors into out. @return False if the packet ran out; the rest read as box.minimum. */
+ inline bool
+  readQuantized(BitReader& reader, CVector3* out, size_t n, const Bounds3& box, int bitsPerAxis) {
+  for (size_t i = 0; i < n; ++i) out[i] = readQuantized(reader, box, bitsPerAxis);
+  return reader.valid();
+ }
+
+ /** @brief Reads n vectors into out. @return False if the packet ran out. */
+ inline bool
+  readQuantized(BitReader& reader, CVector2* out, size_t n, const Bounds2& box, int bitsPerAxis) {
+  for (size_t i = 0; i < n; ++i) out[i] = readQuantized(reader, box, bitsPerAxis);
+  return reader.valid();
+ }
+}
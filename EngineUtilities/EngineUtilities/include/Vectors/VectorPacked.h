@@ -0,0 +1,415 @@
+/**
+ * @file VectorPacked.h
+ * @brief 32-bit storage formats for unit vectors and UVs: octahedral, 10:10:10:2 and 16-bit norms.
+ *
+ * Like the half vectors in VectorHalf.h these are storage-only: convert once when storing,
+ * once when loading, and do all math on CVector2/CVector3. Components are clamped to the
+ * format's range and rounded to nearest (halfway away from zero); snorm values decode as
+ * max(q / qmax, -1) so both ends of the range are exact. The bulk pack()/unpack() functions
+ * produce the same bits as the constructors and toFloat() at run time, vectorized with
+ * EU::SIMD; the octahedral decode spells out its multiply-adds so FMA contraction cannot
+ * split the two. Build with -ffp-contract=off under EU_REPRODUCIBLE on GCC, as Platform.h says.
+ * Packed words assume a little-endian target (x86, ARM).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Math/Precision.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ namespace detail {
+  /** round(clamp(value, -1, 1) * qmax). */
+  constexpr int
+   quantizeSnorm(float value, float qmax) {
+   return static_cast<int>(EngineMath::fround(EngineMath::clamp(value, -1.0f, 1.0f) * qmax));
+  }
+
+  /** round(clamp(value, 0, 1) * qmax). */
+  constexpr int
+   quantizeUnorm(float value, float qmax) {
+   return static_cast<int>(EngineMath::fround(EngineMath::clamp(value, 0.0f, 1.0f) * qmax));
+  }
+
+  /** max(q / qmax, -1). */
+  constexpr float
+   dequantizeSnorm(int q, float qmax) {
+   return static_cast<float>(q) / qmax > -1.0f ? static_cast<float>(q) / qmax : -1.0f;
+  }
+
+  /** Sign-extends the low bits of field, given its sign bit (e.g. 0x200 for 10 bits). */
+  constexpr int
+   signExtend(uint32_t field, int signBit) {
+   return (static_cast<int>(field) ^ signBit) - signBit;
+  }
+
+  /** Octahedral projection of v onto the [-1, 1]^2 square; the zero vector maps to (0, 0). */
+  EU_CONSTEXPR20 void
+   octEncode(const CVector3& v, float& u, float& w) {
+   float s = EngineMath::fabs(v.x) + EngineMath::fabs(v.y) + EngineMath::fabs(v.z);
+   u = 0.0f;
+   w = 0.0f;
+   if (s > 0.0f) {
+    float inv = 1.0f / s;
+    u = v.x * inv;
+    w = v.y * inv;
+    if (v.z < 0.0f) {
+     float fu = (1.0f - EngineMath::fabs(w)) * (u >= 0.0f ? 1.0f : -1.0f);
+     w = (1.0f - EngineMath::fabs(u)) * (w >= 0.0f ? 1.0f : -1.0f);
+     u = fu;
+    }
+   }
+  }
+
+  /**
+   * Unit vector for the octahedral coordinates (u, w). The squared length is written as the
+   * multiply-adds of CNormalOct::unpack(), so neither side is left to contraction.
+   */
+  EU_CONSTEXPR20 CVector3
+   octDecode(float u, float w) {
+   float z = 1.0f - EngineMath::fabs(u) - EngineMath::fabs(w);
+   float t = -z > 0.0f ? -z : 0.0f;
+   u = u + (u >= 0.0f ? -t : t);
+   w = w + (w >= 0.0f ? -t : t);
+   float inv = 1.0f / EngineMath::sqrtHardware(EU::Precision::detail::fusedMadd(u, u, EU::Precision::detail::fusedMadd(w, w, z * z)));
+   return CVector3(u * inv, w * inv, z * inv);
+  }
+
+  using BatchInt = BatchLanes::Int;
+
+  inline BatchLanes
+   absLanes(BatchLanes v) {
+   return v & EU::SIMD::asFloat(BatchInt::set1(0x7fffffff));
+  }
+
+  inline BatchInt
+   quantizeSnormLanes(BatchLanes v, float qmax) {
+   BatchLanes c = EU::SIMD::min(EU::SIMD::max(v, BatchLanes::set1(-1.0f)), BatchLanes::set1(1.0f));
+   return EU::SIMD::truncToInt(EngineMath::batch::kernels::round(c * BatchLanes::set1(qmax)));
+  }
+
+  inline BatchInt
+   quantizeUnormLanes(BatchLanes v, float qmax) {
+   BatchLanes c = EU::SIMD::min(EU::SIMD::max(v, BatchLanes::zero()), BatchLanes::set1(1.0f));
+   return EU::SIMD::truncToInt(EngineMath::batch::kernels::round(c * BatchLanes::set1(qmax)));
+  }
+
+  /**
+   * max(q / qmax, -1) for a signed field already shifted to the top of the word, where scale
+   * is 2^-shift; the int to float conversion and the scale are exact.
+   */
+  inline BatchLanes
+   dequantizeSnormLanes(BatchInt top, float scale, float qmax) {
+   BatchLanes q = EU::SIMD::toFloat(top) * BatchLanes::set1(scale);
+   return EU::SIMD::max(q / BatchLanes::set1(qmax), BatchLanes::set1(-1.0f));
+  }
+
+  /** Stores the first count lanes of v at out[i..]. */
+  inline void
+   storeWords(BatchInt v, uint32_t* out, size_t i, size_t count) {
+   int32_t tmp[BATCH_WIDTH];
+   v.store(tmp);
+   for (size_t j = 0; j < count; ++j) out[i + j] = static_cast<uint32_t>(tmp[j]);
+  }
+
+  /** Calls fn(i, count, words) for every packet of n 32-bit words; the tail is zero padded. */
+  template<typename Fn>
+  inline void
+   forEachWords(const uint32_t* in, size_t n, Fn fn) {
+   for (size_t i = 0; i < n; i += BATCH_WIDTH) {
+    size_t count = n - i < BATCH_WIDTH ? n - i : BATCH_WIDTH;
+    int32_t tmp[BATCH_WIDTH] = {};
+    for (size_t j = 0; j < count; ++j) tmp[j] = static_cast<int32_t>(in[i + j]);
+    fn(i, count, BatchInt::load(tmp));
+   }
+  }
+ }
+}
+
+/**
+ * @class CNormalOct
+ * @brief Unit vector in 32 bits: octahedral mapping with two snorm16 coordinates.
+ *
+ * The worst-case angular error is about 0.005 degrees, spread evenly over the sphere. The
+ * zero vector is stored as +Z.
+ */
+class CNormalOct {
+public:
+ uint32_t bits; ///< u in the low 16 bits, v in the high 16 bits, both snorm16
+
+ /** @brief Default constructor. Stores +Z. */
+ constexpr CNormalOct() : bits(0) {}
+
+ /** @brief Encodes a unit vector; the input only needs to be non-zero, not normalized. */
+ EU_CONSTEXPR20 explicit CNormalOct(const CVector3& v) : bits(0) {
+  float u = 0.0f, w = 0.0f;
+  EU::detail::octEncode(v, u, w);
+  bits = (static_cast<uint32_t>(EU::detail::quantizeSnorm(u, 32767.0f)) & 0xffffu)
+       | (static_cast<uint32_t>(EU::detail::quantizeSnorm(w, 32767.0f)) << 16);
+ }
+
+ /** @brief Decodes back to a unit vector. */
+ EU_CONSTEXPR20 CVector3
+  toFloat() const {
+  return EU::detail::octDecode(EU::detail::dequantizeSnorm(EU::detail::signExtend(bits & 0xffffu, 0x8000), 32767.0f),
+                               EU::detail::dequantizeSnorm(EU::detail::signExtend(bits >> 16, 0x8000), 32767.0f));
+ }
+
+ constexpr bool
+  operator==(const CNormalOct& otro) const {
+  return bits == otro.bits;
+ }
+
+ constexpr bool
+  operator!=(const CNormalOct& otro) const {
+  return !(*this == otro);
+ }
+
+ /** @brief Bulk encode of n vectors. */
+ static void
+  pack(const CVector3* in, CNormalOct* out, size_t n) {
+  using V = EU::detail::BatchLanes;
+  using I = EU::detail::BatchInt;
+  EU::detail::forEachPacket3(reinterpret_cast<const float*>(in), n,
+   [&](size_t i, size_t count, V x, V y, V z) {
+   const V zero = V::zero(), one = V::set1(1.0f);
+   V s = EU::detail::absLanes(x) + EU::detail::absLanes(y) + EU::detail::absLanes(z);
+   V valid = s > zero;
+   V inv = one / s;
+   V u = (x * inv) & valid;
+   V w = (y * inv) & valid;
+   V fu = (one - EU::detail::absLanes(w)) * EU::SIMD::select(u >= zero, one, -one);
+   V fw = (one - EU::detail::absLanes(u)) * EU::SIMD::select(w >= zero, one, -one);
+   V fold = (z < zero) & valid;
+   u = EU::SIMD::select(fold, fu, u);
+   w = EU::SIMD::select(fold, fw, w);
+   I word = (EU::detail::quantizeSnormLanes(u, 32767.0f) & I::set1(0xffff))
+          | EU::SIMD::shiftLeft<16>(EU::detail::quantizeSnormLanes(w, 32767.0f));
+   EU::detail::storeWords(word, reinterpret_cast<uint32_t*>(out), i, count);
+  });
+ }
+
+ /** @brief Bulk decode of n vectors. */
+ static void
+  unpack(const CNormalOct* in, CVector3* out, size_t n) {
+  using V = EU::detail::BatchLanes;
+  using I = EU::detail::BatchInt;
+  EU::detail::forEachWords(reinterpret_cast<const uint32_t*>(in), n, [&](size_t i, size_t count, I word) {
+   const V zero = V::zero(), one = V::set1(1.0f);
+   V u = EU::detail::dequantizeSnormLanes(EU::SIMD::shiftLeft<16>(word), 1.0f / 65536.0f, 32767.0f);
+   V w = EU::detail::dequantizeSnormLanes(word & I::set1(-65536), 1.0f / 65536.0f, 32767.0f);
+   V z = one - EU::detail::absLanes(u) - EU::detail::absLanes(w);
+   V t = EU::SIMD::max(-z, zero);
+   u = u + EU::SIMD::select(u >= zero, -t, t);
+   w = w + EU::SIMD::select(w >= zero, -t, t);
+   V inv = one / EU::SIMD::sqrt(EU::SIMD::madd(u, u, EU::SIMD::madd(w, w, z * z)));
+   EU::detail::storePacket3(reinterpret_cast<float*>(out), i, count, u * inv, w * inv, z * inv);
+  });
+ }
+};
+
+/**
+ * @class CPacked1010102
+ * @brief x, y, z as snorm10 plus a 2-bit snorm w, e.g. a tangent and its bitangent sign.
+ */
+class CPacked1010102 {
+public:
+ uint32_t bits; ///< x in bits 0-9, y in 10-19, z in 20-29, w in 30-31
+
+ /** @brief Default constructor. Stores (0, 0, 0, 0). */
+ constexpr CPacked1010102() : bits(0) {}
+
+ /** @brief Encodes components in [-1, 1]; w is rounded to -1, 0 or 1. */
+ constexpr explicit CPacked1010102(const CVector3& v, float w = 0.0f)
+  : bits((static_cast<uint32_t>(EU::detail::quantizeSnorm(v.x, 511.0f)) & 0x3ffu)
+       | (static_cast<uint32_t>(EU::detail::quantizeSnorm(v.y, 511.0f)) & 0x3ffu) << 10
+       | (static_cast<uint32_t>(EU::detail::quantizeSnorm(v.z, 511.0f)) & 0x3ffu) << 20
+       | static_cast<uint32_t>(EU::detail::quantizeSnorm(w, 1.0f)) << 30) {
+ }
+
+ /** @brief Decodes x, y and z. */
+ constexpr CVector3
+  toFloat() const {
+  return CVector3(EU::detail::dequantizeSnorm(EU::detail::signExtend(bits & 0x3ffu, 0x200), 511.0f),
+                  EU::detail::dequantizeSnorm(EU::detail::signExtend((bits >> 10) & 0x3ffu, 0x200), 511.0f),
+                  EU::detail::dequantizeSnorm(EU::detail::signExtend((bits >> 20) & 0x3ffu, 0x200), 511.0f));
+ }
+
+ /** @brief Decodes w: -1, 0 or 1. */
+ constexpr float
+  w() const {
+  return EU::detail::dequantizeSnorm(EU::detail::signExtend(bits >> 30, 0x2), 1.0f);
+ }
+
+ constexpr bool
+  operator==(const CPacked1010102& otro) const {
+  return bits == otro.bits;
+ }
+
+ constexpr bool
+  operator!=(const CPacked1010102& otro) const {
+  return !(*this == otro);
+ }
+
+ /** @brief Bulk encode of n vectors with w = 0. */
+ static void
+  pack(const CVector3* in, CPacked1010102* out, size_t n) {
+  using V = EU::detail::BatchLanes;
+  using I = EU::detail::BatchInt;
+  EU::detail::forEachPacket3(reinterpret_cast<const float*>(in), n,
+   [&](size_t i, size_t count, V x, V y, V z) {
+   const I field = I::set1(0x3ff);
+   I word = (EU::detail::quantizeSnormLanes(x, 511.0f) & field)
+          | EU::SIMD::shiftLeft<10>(EU::detail::quantizeSnormLanes(y, 511.0f) & field)
+          | EU::SIMD::shiftLeft<20>(EU::detail::quantizeSnormLanes(z, 511.0f) & field);
+   EU::detail::storeWords(word, reinterpret_cast<uint32_t*>(out), i, count);
+  });
+ }
+
+ /** @brief Bulk decode of x, y and z for n vectors. */
+ static void
+  unpack(const CPacked1010102* in, CVector3* out, size_t n) {
+  using I = EU::detail::BatchInt;
+  EU::detail::forEachWords(reinterpret_cast<const uint32_t*>(in), n, [&](size_t i, size_t count, I word) {
+   const I top = I::set1(-4194304); // bits 22-31
+   const float scale = 1.0f / 4194304.0f;
+   EU::detail::storePacket3(reinterpret_cast<float*>(out), i, count,
+                            EU::detail::dequantizeSnormLanes(EU::SIMD::shiftLeft<22>(word), scale, 511.0f),
+                            EU::detail::dequantizeSnormLanes(EU::SIMD::shiftLeft<12>(word) & top, scale, 511.0f),
+                            EU::detail::dequantizeSnormLanes(EU::SIMD::shiftLeft<2>(word) & top, scale, 511.0f));
+  });
+ }
+};
+
+/**
+ * @class CVector2snorm16
+ * @brief 2D vector of snorm16 components in [-1, 1] (4 bytes).
+ */
+class CVector2snorm16 {
+public:
+ int16_t x; ///< X component, round(x * 32767)
+ int16_t y; ///< Y component, round(y * 32767)
+
+ /** @brief Default constructor. Initializes to (0, 0). */
+ constexpr CVector2snorm16() : x(0), y(0) {}
+
+ /** @brief Stores a float vector, clamped to [-1, 1]. */
+ constexpr explicit CVector2snorm16(const CVector2& v)
+  : x(static_cast<int16_t>(EU::detail::quantizeSnorm(v.x, 32767.0f))),
+    y(static_cast<int16_t>(EU::detail::quantizeSnorm(v.y, 32767.0f))) {
+ }
+
+ /** @brief Loads the vector back as floats. */
+ constexpr CVector2
+  toFloat() const {
+  return CVector2(EU::detail::dequantizeSnorm(x, 32767.0f), EU::detail::dequantizeSnorm(y, 32767.0f));
+ }
+
+ constexpr bool
+  operator==(const CVector2snorm16& otro) const {
+  return x == otro.x && y == otro.y;
+ }
+
+ constexpr bool
+  operator!=(const CVector2snorm16& otro) const {
+  return !(*this == otro);
+ }
+
+ /** @brief Bulk store of n vectors. */
+ static void
+  pack(const CVector2* in, CVector2snorm16* out, size_t n) {
+  using V = EU::detail::BatchLanes;
+  using I = EU::detail::BatchInt;
+  EU::detail::forEachPacket2(reinterpret_cast<const float*>(in), n, [&](size_t i, size_t count, V x, V y) {
+   I word = (EU::detail::quantizeSnormLanes(x, 32767.0f) & I::set1(0xffff))
+          | EU::SIMD::shiftLeft<16>(EU::detail::quantizeSnormLanes(y, 32767.0f));
+   EU::detail::storeWords(word, reinterpret_cast<uint32_t*>(out), i, count);
+  });
+ }
+
+ /** @brief Bulk load of n vectors. */
+ static void
+  unpack(const CVector2snorm16* in, CVector2* out, size_t n) {
+  using I = EU::detail::BatchInt;
+  EU::detail::forEachWords(reinterpret_cast<const uint32_t*>(in), n, [&](size_t i, size_t count, I word) {
+   EU::detail::storePacket2(reinterpret_cast<float*>(out), i, count,
+                            EU::detail::dequantizeSnormLanes(EU::SIMD::shiftLeft<16>(word), 1.0f / 65536.0f, 32767.0f),
+                            EU::detail::dequantizeSnormLanes(word & I::set1(-65536), 1.0f / 65536.0f, 32767.0f));
+  });
+ }
+};
+
+/**
+ * @class CVector2unorm16
+ * @brief 2D vector of unorm16 components in [0, 1] (4 bytes), e.g. for UVs in a texture atlas.
+ */
+class CVector2unorm16 {
+public:
+ uint16_t x; ///< X component, round(x * 65535)
+ uint16_t y; ///< Y component, round(y * 65535)
+
+ /** @brief Default constructor. Initializes to (0, 0). */
+ constexpr CVector2unorm16() : x(0), y(0) {}
+
+ /** @brief Stores a float vector, clamped to [0, 1]. */
+ constexpr explicit CVector2unorm16(const CVector2& v)
+  : x(static_cast<uint16_t>(EU::detail::quantizeUnorm(v.x, 65535.0f))),
+    y(static_cast<uint16_t>(EU::detail::quantizeUnorm(v.y, 65535.0f))) {
+ }
+
+ /** @brief Loads the vector back as floats. */
+ constexpr CVector2
+  toFloat() const {
+  return CVector2(static_cast<float>(x) / 65535.0f, static_cast<float>(y) / 65535.0f);
+ }
+
+ constexpr bool
+  operator==(const CVector2unorm16& otro) const {
+  return x == otro.x && y == otro.y;
+ }
+
+ constexpr bool
+  operator!=(const CVector2unorm16& otro) const {
+  return !(*this == otro);
+ }
+
+ /** @brief Bulk store of n vectors. */
+ static void
+  pack(const CVector2* in, CVector2unorm16* out, size_t n) {
+  using V = EU::detail::BatchLanes;
+  using I = EU::detail::BatchInt;
+  EU::detail::forEachPacket2(reinterpret_cast<const float*>(in), n, [&](size_t i, size_t count, V x, V y) {
+   I word = EU::detail::quantizeUnormLanes(x, 65535.0f) | EU::SIMD::shiftLeft<16>(EU::detail::quantizeUnormLanes(y, 65535.0f));
+   EU::detail::storeWords(word, reinterpret_cast<uint32_t*>(out), i, count);
+  });
+ }
+
+ /** @brief Bulk load of n vectors. */
+ static void
+  unpack(const CVector2unorm16* in, CVector2* out, size_t n) {
+  using V = EU::detail::BatchLanes;
+  using I = EU::detail::BatchInt;
+  EU::detail::forEachWords(reinterpret_cast<const uint32_t*>(in), n, [&](size_t i, size_t count, I word) {
+   const V qmax = V::set1(65535.0f);
+   EU::detail::storePacket2(reinterpret_cast<float*>(out), i, count,
+                            EU::SIMD::toFloat(word & I::set1(0xffff)) / qmax,
+                            EU::SIMD::toFloat(EU::SIMD::shiftRight<16>(word)) / qmax);
+  });
+ }
+};
+
+static_assert(sizeof(CNormalOct) == 4, "CNormalOct must be 4 bytes");
+static_assert(sizeof(CPacked1010102) == 4, "CPacked1010102 must be 4 bytes");
+static_assert(sizeof(CVector2snorm16) == 4, "CVector2snorm16 must be 4 bytes");
+static_assert(sizeof(CVector2unorm16) == 4, "CVector2unorm16 must be 4 bytes");
+EU_ASSERT_VALUE_TYPE(CNormalOct);
+EU_ASSERT_VALUE_TYPE(CPacked1010102);
+EU_ASSERT_VALUE_TYPE(CVector2snorm16);
+EU_ASSERT_VALUE_TYPE(CVector2unorm16);
@@ -0,0 +1,359 @@
+/**
+ * @file VectorReduce.h
+ * @brief Sum, centroid and axis-aligned bounds of a CVector2/CVector3 set.
+ *
+ * The set is cut into fixed REDUCE_CHUNK-sized chunks. Each chunk is reduced with per-lane SIMD
+ * accumulators, and the chunk results are folded together in chunk order, with the sums carried
+ * in double. The chunking never depends on how many threads run it, so a given build returns
+ * the same bits whether the call runs on one thread or on all of them. Builds with different
+ * SIMD widths may differ in the last bits of sum() and centroid(); bounds are always exact.
+ *
+ * Large sets (PARALLEL_REDUCE_MIN points and up) are spread over worker threads. threads = 0
+ * means std::thread::hardware_concurrency(), threads = 1 keeps the call on the caller.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include <Core/Parallel.h>
+#include <Core/SIMD.h>
+#include <Math/EngineMathBatch.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ /** @brief Axis-aligned box of a CVector3 set. */
+ struct Bounds3 {
+  CVector3 minimum;
+  CVector3 maximum;
+ };
+
+ /** @brief Axis-aligned box of a CVector2 set. */
+ struct Bounds2 {
+  CVector2 minimum;
+  CVector2 maximum;
+ };
+
+ namespace detail {
+  /// Points per reduction chunk; fixes the summation order.
+  constexpr size_t REDUCE_CHUNK = 16384;
+  /// Sets smaller than this are reduced on the calling thread.
+  constexpr size_t PARALLEL_REDUCE_MIN = 1 << 18;
+
+  /** Reduction of one chunk, or of the whole set once folded. */
+  template<size_t N>
+  struct Reduction {
+   double sum[N];
+   float lo[N];
+   float hi[N];
+  };
+
+  template<size_t N>
+  inline Reduction<N>
+   emptyReduction() {
+   Reduction<N> r;
+   for (size_t c = 0; c < N; ++c) {
+    r.sum[c] = 0.0;
+    r.lo[c] = std::numeric_limits<float>::infinity();
+    r.hi[c] = -std::numeric_limits<float>::infinity();
+   }
+   return r;
+  }
+
+  template<size_t N>
+  inline void
+   fold(Reduction<N>& into, const Reduction<N>& r) {
+   for (size_t c = 0; c < N; ++c) {
+    into.sum[c] += r.sum[c];
+    into.lo[c] = r.lo[c] < into.lo[c] ? r.lo[c] : into.lo[c];
+    into.hi[c] = r.hi[c] > into.hi[c] ? r.hi[c] : into.hi[c];
+   }
+  }
+
+  /** Per-lane accumulators for one chunk; only the requested parts are computed. */
+  template<size_t N, bool WithSum, bool WithBounds>
+  struct LaneReducer {
+   BatchLanes sum[N], lo[N], hi[N];
+
+   LaneReducer() {
+    for (size_t c = 0; c < N; ++c) {
+     sum[c] = BatchLanes::zero();
+     lo[c] = BatchLanes::set1(std::numeric_limits<float>::infinity());
+     hi[c] = BatchLanes::set1(-std::numeric_limits<float>::infinity());
+    }
+   }
+
+   void
+    add(const BatchLanes* v, size_t count) {
+    if (WithSum) {
+     // Padding lanes are zero, so they drop out of the sum.
+     for (size_t c = 0; c < N; ++c) sum[c] = sum[c] + v[c];
+    }
+    if (WithBounds) {
+     if (count == BATCH_WIDTH) {
+      for (size_t c = 0; c < N; ++c) {
+       lo[c] = EU::SIMD::min(lo[c], v[c]);
+       hi[c] = EU::SIMD::max(hi[c], v[c]);
+      }
+     }
+     else {
+      const BatchLanes live = firstLanes(count);
+      for (size_t c = 0; c < N; ++c) {
+       lo[c] = EU::SIMD::min(lo[c], EU::SIMD::select(live, v[c], lo[c]));
+       hi[c] = EU::SIMD::max(hi[c], EU::SIMD::select(live, v[c], hi[c]));
+      }
+     }
+    }
+   }
+
+   Reduction<N>
+    finish() const {
+    Reduction<N> r = emptyReduction<N>();
+    for (size_t c = 0; c < N; ++c) {
+     float s[BATCH_WIDTH], l[BATCH_WIDTH], h[BATCH_WIDTH];
+     sum[c].store(s);
+     lo[c].store(l);
+     hi[c].store(h);
+     for (size_t j = 0; j < BATCH_WIDTH; ++j) {
+      r.sum[c] += s[j];
+      r.lo[c] = l[j] < r.lo[c] ? l[j] : r.lo[c];
+      r.hi[c] = h[j] > r.hi[c] ? h[j] : r.hi[c];
+     }
+    }
+    return r;
+   }
+  };
+
+  /** Feeds points [begin, begin + count) of a set to the reducer. */
+  template<typename Reducer>
+  inline void
+   reduceRange(const CVector3* in, size_t begin, size_t count, Reducer& r) {
+   forEachPacket3(reinterpret_cast<const float*>(in + begin), count,
+                  [&](size_t, size_t lanes, BatchLanes x, BatchLanes y, BatchLanes z) {
+    const BatchLanes v[3] = { x, y, z };
+    r.add(v, lanes);
+   });
+  }
+
+  template<typename Reducer>
+  inline void
+   reduceRange(EngineMath::batch::ConstSoA3 in, size_t begin, size_t count, Reducer& r) {
+   EngineMath::batch::ConstSoA3 range = { in.x + begin, in.y + begin, in.z + begin };
+   forEachPacket3(range, count, [&](size_t, size_t lanes, BatchLanes x, BatchLanes y, BatchLanes z) {
+    const BatchLanes v[3] = { x, y, z };
+    r.add(v, lanes);
+   });
+  }
+
+  template<typename Reducer>
+  inline void
+   reduceRange(const CVector2* in, size_t begin, size_t count, Reducer& r) {
+   forEachPacket2(reinterpret_cast<const float*>(in + begin), count,
+                  [&](size_t, size_t lanes, BatchLanes x, BatchLanes y) {
+    const BatchLanes v[2] = { x, y };
+    r.add(v, lanes);
+   });
+  }
+
+  template<typename Reducer>
+  inline void
+   reduceRange(EngineMath::batch::ConstSoA2 in, size_t begin, size_t count, Reducer& r) {
+   EngineMath::batch::ConstSoA2 range = { in.x + begin, in.y + begin };
+   forEachPacket2(range, count, [&](size_t, size_t lanes, BatchLanes x, BatchLanes y) {
+    const BatchLanes v[2] = { x, y };
+    r.add(v, lanes);
+   });
+  }
+
+  /** Reduces the whole set chunk by chunk and folds the chunks in order. */
+  template<size_t N, bool WithSum, bool WithBounds, typename In>
+  inline Reduction<N>
+   reduce(In in, size_t n, size_t threads) {
+   const size_t chunks = (n + REDUCE_CHUNK - 1) / REDUCE_CHUNK;
+   auto reduceChunk = [&](size_t chunk) {
+    const size_t begin = chunk * REDUCE_CHUNK;
+    LaneReducer<N, WithSum, WithBounds> r;
+    reduceRange(in, begin, n - begin < REDUCE_CHUNK ? n - begin : REDUCE_CHUNK, r);
+    return r.finish();
+   };
+
+   threads = resolveThreads(threads, chunks);
+   Reduction<N> result = emptyReduction<N>();
+   if (n < PARALLEL_REDUCE_MIN || threads <= 1) {
+    for (size_t chunk = 0; chunk < chunks; ++chunk) fold(result, reduceChunk(chunk));
+    return result;
+   }
+
+   std::vector<Reduction<N>> partial(chunks);
+   parallelTasks(chunks, threads, [&](size_t chunk) { partial[chunk] = reduceChunk(chunk); });
+   for (size_t chunk = 0; chunk < chunks; ++chunk) fold(result, partial[chunk]);
+   return result;
+  }
+
+  inline Bounds3
+   toBounds(const Reduction<3>& r, size_t n) {
+   if (n == 0) {
+    return Bounds3();
+   }
+   return { CVector3(r.lo[0], r.lo[1], r.lo[2]), CVector3(r.hi[0], r.hi[1], r.hi[2]) };
+  }
+
+  inline Bounds2
+   toBounds(const Reduction<2>& r, size_t n) {
+   if (n == 0) {
+    return Bounds2();
+   }
+   return { CVector2(r.lo[0], r.lo[1]), CVector2(r.hi[0], r.hi[1]) };
+  }
+
+  inline CVector3
+   mean(const Reduction<3>& r, size_t n) {
+   if (n == 0) {
+    return CVector3();
+   }
+   const double inv = 1.0 / static_cast<double>(n);
+   return CVector3(static_cast<float>(r.sum[0] * inv), static_cast<float>(r.sum[1] * inv),
+                   static_cast<float>(r.sum[2] * inv));
+  }
+
+  inline CVector2
+   mean(const Reduction<2>& r, size_t n) {
+   if (n == 0) {
+    return CVector2();
+   }
+   const double inv = 1.0 / static_cast<double>(n);
+   return CVector2(static_cast<float>(r.sum[0] * inv), static_cast<float>(r.sum[1] * inv));
+  }
+ }
+
+ // --- CVector3 ---
+
+ /** @brief Axis-aligned bounds of the set; both corners are zero for an empty set. */
+ inline Bounds3
+  bounds(const CVector3* points, size_t n, size_t threads = 0) {
+  return detail::toBounds(detail::reduce<3, false, true>(points, n, threads), n);
+ }
+
+ /** @brief SoA bounds(). */
+ inline Bounds3
+  bounds(EngineMath::batch::ConstSoA3 points, size_t n, size_t threads = 0) {
+  return detail::toBounds(detail::reduce<3, false, true>(points, n, threads), n);
+ }
+
+ /** @brief Component-wise minimum of the set, or zero for an empty set. */
+ inline CVector3
+  minComponent(const CVector3* points, size_t n, size_t threads = 0) {
+  return bounds(points, n, threads).minimum;
+ }
+
+ /** @brief SoA minComponent(). */
+ inline CVector3
+  minComponent(EngineMath::batch::ConstSoA3 points, size_t n, size_t threads = 0) {
+  return bounds(points, n, threads).minimum;
+ }
+
+ /** @brief Component-wise maximum of the set, or zero for an empty set. */
+ inline CVector3
+  maxComponent(const CVector3* points, size_t n, size_t threads = 0) {
+  return bounds(points, n, threads).maximum;
+ }
+
+ /** @brief SoA maxComponent(). */
+ inline CVector3
+  maxComponent(EngineMath::batch::ConstSoA3 points, size_t n, size_t threads = 0) {
+  return bounds(points, n, threads).maximum;
+ }
+
+ /** @brief Sum of the set, accumulated per chunk in float and across chunks in double. */
+ inline CVector3
+  sum(const CVector3* points, size_t n, size_t threads = 0) {
+  detail::Reduction<3> r = detail::reduce<3, true, false>(points, n, threads);
+  return CVector3(static_cast<float>(r.sum[0]), static_cast<float>(r.sum[1]), static_cast<float>(r.sum[2]));
+ }
+
+ /** @brief SoA sum(). */
+ inline CVector3
+  sum(EngineMath::batch::ConstSoA3 points, size_t n, size_t threads = 0) {
+  detail::Reduction<3> r = detail::reduce<3, true, false>(points, n, threads);
+  return CVector3(static_cast<float>(r.sum[0]), static_cast<float>(r.sum[1]), static_cast<float>(r.sum[2]));
+ }
+
+ /** @brief Mean of the set, or zero for an empty set. */
+ inline CVector3
+  centroid(const CVector3* points, size_t n, size_t threads = 0) {
+  return detail::mean(detail::reduce<3, true, false>(points, n, threads), n);
+ }
+
+ /** @brief SoA centroid(). */
+ inline CVector3
+  centroid(EngineMath::batch::ConstSoA3 points, size_t n, size_t threads = 0) {
+  return detail::mean(detail::reduce<3, true, false>(points, n, threads), n);
+ }
+
+ // --- CVector2 ---
+
+ /** @brief Axis-aligned bounds of the set; both corners are zero for an empty set. */
+ inline Bounds2
+  bounds(const CVector2* points, size_t n, size_t threads = 0) {
+  return detail::toBounds(detail::reduce<2, false, true>(points, n, threads), n);
+ }
+
+ /** @brief SoA bounds(). */
+ inline Bounds2
+  bounds(EngineMath::batch::ConstSoA2 points, size_t n, size_t threads = 0) {
+  return detail::toBounds(detail::reduce<2, false, true>(points, n, threads), n);
+ }
+
+ /** @brief Component-wise minimum of the set, or zero for an empty set. */
+ inline CVector2
+  minComponent(const CVector2* points, size_t n, size_t threads = 0) {
+  return bounds(points, n, threads).minimum;
+ }
+
+ /** @brief SoA minComponent(). */
+ inline CVector2
+  minComponent(EngineMath::batch::ConstSoA2 points, size_t n, size_t threads = 0) {
+  return bounds(points, n, threads).minimum;
+ }
+
+ /** @brief Component-wise maximum of the set, or zero for an empty set. */
+ inline CVector2
+  maxComponent(const CVector2* points, size_t n, size_t threads = 0) {
+  return bounds(points, n, threads).maximum;
+ }
+
+ /** @brief SoA maxComponent(). */
+ inline CVector2
+  maxComponent(EngineMath::batch::ConstSoA2 points, size_t n, size_t threads = 0) {
+  return bounds(points, n, threads).maximum;
+ }
+
+ /** @brief Sum of the set, accumulated per chunk in float and across chunks in double. */
+ inline CVector2
+  sum(const CVector2* points, size_t n, size_t threads = 0) {
+  detail::Reduction<2> r = detail::reduce<2, true, false>(points, n, threads);
+  return CVector2(static_cast<float>(r.sum[0]), static_cast<float>(r.sum[1]));
+ }
+
+ /** @brief SoA sum(). */
+ inline CVector2
+  sum(EngineMath::batch::ConstSoA2 points, size_t n, size_t threads = 0) {
+  detail::Reduction<2> r = detail::reduce<2, true, false>(points, n, threads);
+  return CVector2(static_cast<float>(r.sum[0]), static_cast<float>(r.sum[1]));
+ }
+
+ /** @brief Mean of the set, or zero for an empty set. */
+ inline CVector2
+  centroid(const CVector2* points, size_t n, size_t threads = 0) {
+  return detail::mean(detail::reduce<2, true, false>(points, n, threads), n);
+ }
+
+ /** @brief SoA centroid(). */
+ inline CVector2
+  centroid(EngineMath::batch::ConstSoA2 points, size_t n, size_t threads = 0) {
+  return detail::mean(detail::reduce<2, true, false>(points, n, threads), n);
+ }
+}
@@ -0,0 +1,320 @@
+/**
+ * @file VectorSFML.h
+ * @brief Zero-copy interop between CVector2/CVector3 and sf::Vector2f/sf::Vector3f.
+ *
+ * The pairs are checked below to be layout-identical (size, alignment, member offsets), so
+ * the implicit conversions compile to plain register moves and whole buffers can be handed
+ * across with asSfml()/fromSfml() instead of being copied element by element. sf::Vertex
+ * interleaves position, color and texture coordinates, so vertex arrays use the strided
+ * setPositions()/getPositions() helpers instead, and transformPositions() runs a Matrix3x3
+ * over the positions in place with the VectorTransform.h kernels, split across threads for
+ * large batches. triangulate() runs a Triangulator straight into an sf::Triangles array, and
+ * tessellateUniform()/appendCurve() write Curves.h tessellations into vertices and line strips;
+ * setIndexedLines() draws indexed segments such as MarchingSquares contours. packColors() and
+ * unpackColors() convert CVector4 colors to and from sf::Color arrays in place of byte buffers.
+ *
+ * Only SFML headers are used. The sf::Vertex* functions need no SFML library at link time;
+ * the sf::VertexArray, sf::VertexBuffer and sf::ConvexShape overloads call into sfml-graphics.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/ConvexShape.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+#include <SFML/Graphics/VertexBuffer.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <SFML/System/Vector3.hpp>
+#include <Core/Parallel.h>
+#include <Geometry/Curves.h>
+#include <Geometry/Triangulate.h>
+#include <Graphics/Color.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Matrix3x3.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorInterop.h>
+#include <Vectors/VectorTransform.h>
+
+namespace EU {
+ static_assert(sizeof(CVector2) == sizeof(sf::Vector2f) && alignof(CVector2) == alignof(sf::Vector2f),
+               "CVector2 and sf::Vector2f must share size and alignment");
+ static_assert(std::is_standard_layout<CVector2>::value && std::is_standard_layout<sf::Vector2f>::value,
+               "CVector2 and sf::Vector2f must be standard layout");
+ static_assert(offsetof(CVector2, x) == offsetof(sf::Vector2f, x) && offsetof(CVector2, y) == offsetof(sf::Vector2f, y),
+               "CVector2 and sf::Vector2f must place x and y identically");
+ static_assert(sizeof(CVector3) == sizeof(sf::Vector3f) && alignof(CVector3) == alignof(sf::Vector3f),
+               "CVector3 and sf::Vector3f must share size and alignment");
+ static_assert(std::is_standard_layout<CVector3>::value && std::is_standard_layout<sf::Vector3f>::value,
+               "CVector3 and sf::Vector3f must be standard layout");
+ static_assert(offsetof(CVector3, x) == offsetof(sf::Vector3f, x) && offsetof(CVector3, y) == offsetof(sf::Vector3f, y)
+               && offsetof(CVector3, z) == offsetof(sf::Vector3f, z),
+               "CVector3 and sf::Vector3f must place x, y and z identically");
+ static_assert(sizeof(sf::Color) == 4 && offsetof(sf::Color, r) == 0 && offsetof(sf::Color, g) == 1
+               && offsetof(sf::Color, b) == 2 && offsetof(sf::Color, a) == 3,
+               "sf::Color must be four RGBA bytes");
+
+ /** @brief Makes sf::Vector2f and CVector2 convert implicitly both ways. */
+ template<>
+ struct VectorInterop<sf::Vector2f> {
+  using Native = CVector2;
+  static CVector2 toNative(const sf::Vector2f& v) { return CVector2(v.x, v.y); }
+  static sf::Vector2f fromNative(const CVector2& v) { return sf::Vector2f(v.x, v.y); }
+ };
+
+ /** @brief Makes sf::Vector3f and CVector3 convert implicitly both ways. */
+ template<>
+ struct VectorInterop<sf::Vector3f> {
+  using Native = CVector3;
+  static CVector3 toNative(const sf::Vector3f& v) { return CVector3(v.x, v.y, v.z); }
+  static sf::Vector3f fromNative(const CVector3& v) { return sf::Vector3f(v.x, v.y, v.z); }
+ };
+
+ /** @brief Views a CVector2 buffer as sf::Vector2f, e.g. to pass positions to SFML APIs. */
+ inline sf::Vector2f*
+  asSfml(CVector2* v) {
+  return reinterpret_cast<sf::Vector2f*>(v);
+ }
+
+ inline const sf::Vector2f*
+  asSfml(const CVector2* v) {
+  return reinterpret_cast<const sf::Vector2f*>(v);
+ }
+
+ /** @brief Views an sf::Vector2f buffer as CVector2, e.g. to run batch math on it in place. */
+ inline CVector2*
+  fromSfml(sf::Vector2f* v) {
+  return reinterpret_cast<CVector2*>(v);
+ }
+
+ inline const CVector2*
+  fromSfml(const sf::Vector2f* v) {
+  return reinterpret_cast<const CVector2*>(v);
+ }
+
+ /** @brief Views a CVector3 buffer as sf::Vector3f. */
+ inline sf::Vector3f*
+  asSfml(CVector3* v) {
+  return reinterpret_cast<sf::Vector3f*>(v);
+ }
+
+ inline const sf::Vector3f*
+  asSfml(const CVector3* v) {
+  return reinterpret_cast<const sf::Vector3f*>(v);
+ }
+
+ /** @brief Views an sf::Vector3f buffer as CVector3. */
+ inline CVector3*
+  fromSfml(sf::Vector3f* v) {
+  return reinterpret_cast<CVector3*>(v);
+ }
+
+ inline const CVector3*
+  fromSfml(const sf::Vector3f* v) {
+  return reinterpret_cast<const CVector3*>(v);
+ }
+
+ /** @brief vertices[i].position = positions[i]; colors and texture coordinates are untouched. */
+ inline void
+  setPositions(sf::Vertex* vertices, const CVector2* positions, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+   vertices[i].position.x = positions[i].x;
+   vertices[i].position.y = positions[i].y;
+  }
+ }
+
+ /** @brief positions[i] = vertices[i].position. */
+ inline void
+  getPositions(const sf::Vertex* vertices, CVector2* positions, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+   positions[i] = CVector2(vertices[i].position.x, vertices[i].position.y);
+  }
+ }
+
+ /** @brief vertices[i].texCoords = texCoords[i]. */
+ inline void
+  setTexCoords(sf::Vertex* vertices, const CVector2* texCoords, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+   vertices[i].texCoords.x = texCoords[i].x;
+   vertices[i].texCoords.y = texCoords[i].y;
+  }
+ }
+
+ /** @brief packColors() straight into an sf::Color array. */
+ inline void
+  packColors(const CVector4* in, sf::Color* out, size_t n, ColorEncoding encoding) {
+  packColors(in, reinterpret_cast<uint8_t*>(out), n, encoding);
+ }
+
+ /** @brief unpackColors() straight from an sf::Color array. */
+ inline void
+  unpackColors(const sf::Color* in, CVector4* out, size_t n, ColorEncoding encoding) {
+  unpackColors(reinterpret_cast<const uint8_t*>(in), out, n, encoding);
+ }
+
+ /** @brief Makes points[0..n) the outline of shape, e.g. a convexHull() of a sprite mask. */
+ inline void
+  setPoints(sf::ConvexShape& shape, const CVector2* points, size_t n) {
+  shape.setPointCount(n);
+  for (size_t i = 0; i < n; ++i) {
+   shape.setPoint(i, sf::Vector2f(points[i].x, points[i].y));
+  }
+ }
+
+ /**
+  * @brief Triangulates the polygon points[0..n) with holes (see Triangulator::triangulate())
+  * into vertices as sf::Triangles, three vertices per triangle. Only positions are written,
+  * and vertices keeps its storage, so re-triangulating an edited shape allocates nothing once
+  * both triangulator and vertices have grown to its size.
+  * @return Number of triangles.
+  */
+ inline size_t
+  triangulate(Triangulator& triangulator, const CVector2* points, size_t n, sf::VertexArray& vertices,
+              const uint32_t* holes = nullptr, size_t holeCount = 0) {
+  const size_t triangles = triangulator.triangulate(points, n, holes, holeCount);
+  const std::vector<uint32_t>& indices = triangulator.indices();
+  vertices.setPrimitiveType(sf::Triangles);
+  vertices.resize(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+   vertices[i].position.x = points[indices[i]].x;
+   vertices[i].position.y = points[indices[i]].y;
+  }
+  return triangles;
+ }
+
+ /**
+  * @brief Writes the positions of the segments + 1 points of curve's forward-differenced
+  * tessellation, p0 first, to vertices; colors and texture coordinates are untouched.
+  */
+ inline void
+  tessellateUniform(const CubicBezier2& curve, size_t segments, sf::Vertex* vertices) {
+  vertices->position = sf::Vector2f(curve.p0.x, curve.p0.y);
+  forEachUniformPoint(curve, segments, [&](const CVector2& p) { (++vertices)->position = sf::Vector2f(p.x, p.y); });
+ }
+
+ /**
+  * @brief Appends curve's adaptive tessellation within tolerance to strip as sf::LineStrip
+  * vertices of color. p0 is appended only when strip is empty, so consecutive segments of a
+  * path chain into one strip; strip.clear() keeps the storage for the next frame.
+  * @return Number of vertices appended.
+  */
+ inline size_t
+  appendCurve(sf::VertexArray& strip, const CubicBezier2& curve, float tolerance, const sf::Color& color = sf::Color::White) {
+  const size_t before = strip.getVertexCount();
+  strip.setPrimitiveType(sf::LineStrip);
+  if (before == 0) strip.append(sf::Vertex(sf::Vector2f(curve.p0.x, curve.p0.y), color));
+  forEachAdaptivePoint(curve, tolerance, [&](const CVector2& p) { strip.append(sf::Vertex(sf::Vector2f(p.x, p.y), color)); });
+  return strip.getVertexCount() - before;
+ }
+
+ /**
+  * @brief Writes segments index pairs into points (e.g. MarchingSquares::indices()) to vertices
+  * as sf::Lines of color, two vertices per segment; vertices keeps its storage across frames.
+  */
+ inline void
+  setIndexedLines(sf::VertexArray& vertices, const CVector2* points, const uint32_t* pairs, size_t segments,
+                  const sf::Color& color = sf::Color::White) {
+  vertices.setPrimitiveType(sf::Lines);
+  vertices.resize(segments * 2);
+  for (size_t i = 0; i < segments * 2; ++i) {
+   vertices[i] = sf::Vertex(sf::Vector2f(points[pairs[i]].x, points[pairs[i]].y), color);
+  }
+ }
+
+ namespace detail {
+  /// Vertices per transform task; also the size of the on-stack position block.
+  constexpr size_t VERTEX_BLOCK = 1024;
+  /// Batches smaller than this are transformed on the calling thread.
+  constexpr size_t PARALLEL_VERTEX_MIN = 1 << 16;
+
+  /**
+   * Transforms the positions of in[0..n) (n <= VERTEX_BLOCK) into out, copying color and
+   * texture coordinates when out is a different buffer. Positions are gathered into SoA
+   * blocks so the Matrix3x3 runs through the same SIMD kernel as transformArray().
+   */
+  inline void
+   transformVertexBlock(const sf::Vertex* in, sf::Vertex* out, size_t n, const Matrix3x3& matrix) {
+   float x[VERTEX_BLOCK], y[VERTEX_BLOCK];
+   for (size_t i = 0; i < n; ++i) {
+    x[i] = in[i].position.x;
+    y[i] = in[i].position.y;
+   }
+   EngineMath::batch::SoA2 block = { x, y };
+   project2(EngineMath::batch::ConstSoA2(block), block, n, matrix);
+   if (out != in) {
+    for (size_t i = 0; i < n; ++i) out[i] = in[i];
+   }
+   for (size_t i = 0; i < n; ++i) {
+    out[i].position.x = x[i];
+    out[i].position.y = y[i];
+   }
+  }
+ }
+
+ /**
+  * @brief out[i] = in[i] with position replaced by matrix * position, as transformArray().
+  *
+  * @p out may be @p in. Batches of PARALLEL_VERTEX_MIN vertices and more are split into
+  * VERTEX_BLOCK-sized tasks over @p threads threads (0 = hardware_concurrency(), 1 = caller only).
+  */
+ inline void
+  transformPositions(const sf::Vertex* in, sf::Vertex* out, size_t n, const Matrix3x3& matrix, size_t threads = 0) {
+  const size_t blocks = (n + detail::VERTEX_BLOCK - 1) / detail::VERTEX_BLOCK;
+  auto run = [&](size_t block) {
+   const size_t begin = block * detail::VERTEX_BLOCK;
+   const size_t count = n - begin < detail::VERTEX_BLOCK ? n - begin : detail::VERTEX_BLOCK;
+   detail::transformVertexBlock(in + begin, out + begin, count, matrix);
+  };
+  threads = detail::resolveThreads(threads, blocks);
+  if (n < detail::PARALLEL_VERTEX_MIN || threads <= 1) {
+   for (size_t block = 0; block < blocks; ++block) run(block);
+   return;
+  }
+  detail::parallelTasks(blocks, threads, run);
+ }
+
+ /** @brief Transforms the positions of vertices[0..n) in place. */
+ inline void
+  transformPositions(sf::Vertex* vertices, size_t n, const Matrix3x3& matrix, size_t threads = 0) {
+  transformPositions(vertices, vertices, n, matrix, threads);
+ }
+
+ /** @brief Transforms every position of a vertex array in place. */
+ inline void
+  transformPositions(sf::VertexArray& vertices, const Matrix3x3& matrix, size_t threads = 0) {
+  if (vertices.getVertexCount() != 0) {
+   transformPositions(&vertices[0], vertices.getVertexCount(), matrix, threads);
+  }
+ }
+
+ /**
+  * @brief Writes the vertex array, positions transformed, into staging (resized to fit);
+  * the source array is left untouched.
+  */
+ inline void
+  transformPositions(const sf::VertexArray& vertices, std::vector<sf::Vertex>& staging, const Matrix3x3& matrix,
+                     size_t threads = 0) {
+  staging.resize(vertices.getVertexCount());
+  if (!staging.empty()) {
+   transformPositions(&vertices[0], staging.data(), staging.size(), matrix, threads);
+  }
+ }
+
+ /**
+  * @brief Transforms vertices[0..n) into staging and uploads them to buffer at offset.
+  *
+  * A vertex buffer lives on the GPU and cannot be read back, so the CPU copy is passed in.
+  * @return What sf::VertexBuffer::update() returns (false if the buffer is too small).
+  */
+ inline bool
+  updateTransformed(sf::VertexBuffer& buffer, const sf::Vertex* vertices, size_t n, const Matrix3x3& matrix,
+                    std::vector<sf::Vertex>& staging, unsigned int offset = 0, size_t threads = 0) {
+  staging.resize(n);
+  transformPositions(vertices, staging.data(), n, matrix, threads);
+  return buffer.update(staging.data(), n, offset);
+ }
+}
@@ -0,0 +1,131 @@
+/**
+ * @file VectorSwizzle.h
+ * @brief GLSL-style swizzle accessors (v.xz(), v.yzx(), v.wzyx()) for the vector classes.
+ *
+ * An accessor returns an EU::Swizzle, a small proxy holding a reference to the vector. It
+ * converts to the result vector type on read and scatters the components back on assignment,
+ * so v.xz() = CVector2(1.f, 2.f) writes v.x and v.z. Nothing is copied until the proxy is
+ * used. Swizzles that repeat a component (v.xxy()) can be read but not assigned. Types
+ * with a SIMD register specialize detail::SwizzleRead, so the read becomes one shuffle.
+ *
+ * Because the accessors return proxies, `auto s = v.xz();` keeps a reference to v. Spell out
+ * the vector type to keep a copy.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace EU {
+ namespace detail {
+  /** Component letter to index, used by the accessor macros below. */
+  enum SwizzleComponent { swizzle_x = 0, swizzle_y = 1, swizzle_z = 2, swizzle_w = 3 };
+
+  /** True when no index appears twice, i.e. the swizzle can be written through. */
+  template<int... I>
+  constexpr bool
+   distinctComponents() {
+   const int indices[] = { I... };
+   for (size_t a = 0; a < sizeof...(I); ++a) {
+    for (size_t b = a + 1; b < sizeof...(I); ++b) {
+     if (indices[a] == indices[b]) return false;
+    }
+   }
+   return true;
+  }
+
+  /** Gathers components I... of v into an Out; specialized where a register shuffle exists. */
+  template<typename V, typename Out, int... I>
+  struct SwizzleRead {
+   static constexpr Out
+    read(const V& v) {
+    return Out(v[I]...);
+   }
+  };
+ }
+
+ /**
+  * @brief Proxy for the components I... of a V, read as an Out.
+  */
+ template<typename V, typename Out, int... I>
+ class Swizzle {
+ public:
+  constexpr explicit Swizzle(V& v) : m_v(v) {}
+
+  /** @brief Gathers the components into a new vector. */
+  constexpr
+   operator Out() const {
+   return detail::SwizzleRead<typename std::remove_const<V>::type, Out, I...>::read(m_v);
+  }
+
+  /** @brief Scatters the components of value back into the vector. */
+  constexpr Swizzle&
+   operator=(const Out& value) {
+   static_assert(!std::is_const<V>::value, "cannot assign through a swizzle of a const vector");
+   static_assert(detail::distinctComponents<I...>(), "cannot assign through a swizzle that repeats a component");
+   assign(value, std::make_index_sequence<sizeof...(I)>());
+   return *this;
+  }
+
+  /** @brief Same-pattern assignment, e.g. a.xz() = b.xz(). */
+  constexpr Swizzle&
+   operator=(const Swizzle& other) {
+   return *this = static_cast<Out>(other);
+  }
+
+ private:
+  template<size_t... K>
+  constexpr void
+   assign(const Out& value, std::index_sequence<K...>) {
+   // Read everything first, so overlapping sources such as v.xy() = v.yx() still work.
+   const Out copy = value;
+   const int unused[] = { (m_v[I] = copy[static_cast<int>(K)], 0)... };
+   (void)unused;
+  }
+
+  V& m_v;
+ };
+}
+
+/*
+ * Accessor generation. EU_SWIZZLES_<N>(V, D, Out) declares, inside class V with D components,
+ * every N-letter accessor over the first D of x, y, z, w, each returning an EU::Swizzle read as
+ * Out. The EU_SWIZZLE_LIST<level>_<D> macros enumerate one letter per level; they're kept
+ * separate per level because a macro may not expand inside itself.
+ */
+#define EU_SWIZZLE_LIST1_2(F, V, D, R) F(V, D, R, x) F(V, D, R, y)
+#define EU_SWIZZLE_LIST1_3(F, V, D, R) EU_SWIZZLE_LIST1_2(F, V, D, R) F(V, D, R, z)
+#define EU_SWIZZLE_LIST1_4(F, V, D, R) EU_SWIZZLE_LIST1_3(F, V, D, R) F(V, D, R, w)
+#define EU_SWIZZLE_LIST2_2(F, V, D, R, a) F(V, D, R, a, x) F(V, D, R, a, y)
+#define EU_SWIZZLE_LIST2_3(F, V, D, R, a) EU_SWIZZLE_LIST2_2(F, V, D, R, a) F(V, D, R, a, z)
+#define EU_SWIZZLE_LIST2_4(F, V, D, R, a) EU_SWIZZLE_LIST2_3(F, V, D, R, a) F(V, D, R, a, w)
+#define EU_SWIZZLE_LIST3_2(F, V, D, R, a, b) F(V, D, R, a, b, x) F(V, D, R, a, b, y)
+#define EU_SWIZZLE_LIST3_3(F, V, D, R, a, b) EU_SWIZZLE_LIST3_2(F, V, D, R, a, b) F(V, D, R, a, b, z)
+#define EU_SWIZZLE_LIST3_4(F, V, D, R, a, b) EU_SWIZZLE_LIST3_3(F, V, D, R, a, b) F(V, D, R, a, b, w)
+#define EU_SWIZZLE_LIST4_4(F, V, D, R, a, b, c) \
+ F(V, D, R, a, b, c, x) F(V, D, R, a, b, c, y) F(V, D, R, a, b, c, z) F(V, D, R, a, b, c, w)
+
+#define EU_SWIZZLE_ACCESSOR(V, R, NAME, ...) \
+ constexpr EU::Swizzle<V, R, __VA_ARGS__> NAME() { return EU::Swizzle<V, R, __VA_ARGS__>(*this); } \
+ constexpr EU::Swizzle<const V, R, __VA_ARGS__> NAME() const { return EU::Swizzle<const V, R, __VA_ARGS__>(*this); }
+
+#define EU_SWIZZLE_EMIT2(V, D, R, a, b) \
+ EU_SWIZZLE_ACCESSOR(V, R, a##b, EU::detail::swizzle_##a, EU::detail::swizzle_##b)
+#define EU_SWIZZLE_EMIT3(V, D, R, a, b, c) \
+ EU_SWIZZLE_ACCESSOR(V, R, a##b##c, EU::detail::swizzle_##a, EU::detail::swizzle_##b, EU::detail::swizzle_##c)
+#define EU_SWIZZLE_EMIT4(V, D, R, a, b, c, d) \
+ EU_SWIZZLE_ACCESSOR(V, R, a##b##c##d, EU::detail::swizzle_##a, EU::detail::swizzle_##b, \
+                     EU::detail::swizzle_##c, EU::detail::swizzle_##d)
+
+#define EU_SWIZZLE_STEP2(V, D, R, a) EU_SWIZZLE_LIST2_##D(EU_SWIZZLE_EMIT2, V, D, R, a)
+#define EU_SWIZZLE_STEP3B(V, D, R, a, b) EU_SWIZZLE_LIST3_##D(EU_SWIZZLE_EMIT3, V, D, R, a, b)
+#define EU_SWIZZLE_STEP3(V, D, R, a) EU_SWIZZLE_LIST2_##D(EU_SWIZZLE_STEP3B, V, D, R, a)
+#define EU_SWIZZLE_STEP4C(V, D, R, a, b, c) EU_SWIZZLE_LIST4_##D(EU_SWIZZLE_EMIT4, V, D, R, a, b, c)
+#define EU_SWIZZLE_STEP4B(V, D, R, a, b) EU_SWIZZLE_LIST3_##D(EU_SWIZZLE_STEP4C, V, D, R, a, b)
+#define EU_SWIZZLE_STEP4(V, D, R, a) EU_SWIZZLE_LIST2_##D(EU_SWIZZLE_STEP4B, V, D, R, a)
+
+#define EU_SWIZZLES_2(V, D, R) EU_SWIZZLE_LIST1_##D(EU_SWIZZLE_STEP2, V, D, R)
+#define EU_SWIZZLES_3(V, D, R) EU_SWIZZLE_LIST1_##D(EU_SWIZZLE_STEP3, V, D, R)
+#define EU_SWIZZLES_4(V, D, R) EU_SWIZZLE_LIST1_##D(EU_SWIZZLE_STEP4, V, D, R)
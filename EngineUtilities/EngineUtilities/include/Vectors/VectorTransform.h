@@ -0,0 +1,339 @@
+/**
+ * @file VectorTransform.h
+ * @brief Array-at-a-time 2D rotate and transform of CVector2 sets, and 3D point, direction
+ * and projective transforms of CVector3 sets.
+ *
+ * The rotation's sin/cos (or the matrix elements) are broadcast once and the points stream
+ * through SIMD registers, in the same AoS and SoA layouts as VectorBatch.h. Each point gets
+ * the same arithmetic as Matrix2x2/Matrix3x3/Matrix4x4::operator*, so without FMA the results
+ * match the scalar path bit for bit. Input and output may be the same array.
+ *
+ * The 3D functions split what Matrix4x4::operator*(CVector3) decides per point: affine
+ * transforms (transformPoints(), transformDirections()) never compute w, and projectPoints()
+ * always does, dividing through a lane select instead of a branch. rotateArray() by a
+ * Quaternion converts it to a matrix once, so each vector costs nine multiply-adds.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Math/EngineMath.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Matrix2x2.h>
+#include <Matrices/Matrix3x3.h>
+#include <Matrices/Matrix4x4.h>
+#include <Matrices/Affine3x4.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/VectorBatch.h>
+
+namespace EU {
+ namespace detail {
+  /** out[i] = (a x + b y + tx, c x + d y + ty) for every in[i] = (x, y). */
+  template<typename In, typename Out>
+  inline void
+   transform2(In in, Out out, size_t n, float a, float b, float c, float d, float tx, float ty) {
+   const BatchLanes m00 = BatchLanes::set1(a), m01 = BatchLanes::set1(b);
+   const BatchLanes m10 = BatchLanes::set1(c), m11 = BatchLanes::set1(d);
+   const BatchLanes t0 = BatchLanes::set1(tx), t1 = BatchLanes::set1(ty);
+   const bool translate = tx != 0.f || ty != 0.f;
+   forEachPacket2(in, n, [&](size_t i, size_t count, BatchLanes x, BatchLanes y) {
+    BatchLanes rx = EU::SIMD::madd(m01, y, m00 * x);
+    BatchLanes ry = EU::SIMD::madd(m11, y, m10 * x);
+    if (translate) {
+     rx = rx + t0;
+     ry = ry + t1;
+    }
+    storePacket2(out, i, count, rx, ry);
+   });
+  }
+
+  /** Full homogeneous Matrix3x3 transform, dividing by w where w != 0. */
+  template<typename In, typename Out>
+  inline void
+   project2(In in, Out out, size_t n, const Matrix3x3& mat) {
+   if (mat.m[2][0] == 0.f && mat.m[2][1] == 0.f && mat.m[2][2] == 1.f) {
+    transform2(in, out, n, mat.m[0][0], mat.m[0][1], mat.m[1][0], mat.m[1][1], mat.m[0][2], mat.m[1][2]);
+    return;
+   }
+   BatchLanes m[3][3];
+   for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) m[r][c] = BatchLanes::set1(mat.m[r][c]);
+   }
+   const BatchLanes zero = BatchLanes::zero();
+   forEachPacket2(in, n, [&](size_t i, size_t count, BatchLanes x, BatchLanes y) {
+    BatchLanes rx = EU::SIMD::madd(m[0][1], y, m[0][0] * x) + m[0][2];
+    BatchLanes ry = EU::SIMD::madd(m[1][1], y, m[1][0] * x) + m[1][2];
+    BatchLanes w = EU::SIMD::madd(m[2][1], y, m[2][0] * x) + m[2][2];
+    BatchLanes divide = w != zero;
+    storePacket2(out, i, count, EU::SIMD::select(divide, rx / w, rx), EU::SIMD::select(divide, ry / w, ry));
+   });
+  }
+
+  /**
+   * out[i] = the top three rows (row stride 4) of an affine matrix applied to in[i], adding
+   * column 3 only for points.
+   */
+  template<typename In, typename Out>
+  inline void
+   transform3(In in, Out out, size_t n, const float (*rows)[4], bool point) {
+   BatchLanes m[3][4];
+   for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 4; ++c) m[r][c] = BatchLanes::set1(rows[r][c]);
+   }
+   forEachPacket3(in, n, [&](size_t i, size_t count, BatchLanes x, BatchLanes y, BatchLanes z) {
+    BatchLanes rx = EU::SIMD::madd(m[0][2], z, EU::SIMD::madd(m[0][1], y, m[0][0] * x));
+    BatchLanes ry = EU::SIMD::madd(m[1][2], z, EU::SIMD::madd(m[1][1], y, m[1][0] * x));
+    BatchLanes rz = EU::SIMD::madd(m[2][2], z, EU::SIMD::madd(m[2][1], y, m[2][0] * x));
+    if (point) {
+     rx = rx + m[0][3];
+     ry = ry + m[1][3];
+     rz = rz + m[2][3];
+    }
+    storePacket3(out, i, count, rx, ry, rz);
+   });
+  }
+
+  /** Full homogeneous Matrix4x4 transform, dividing by w where w != 0. */
+  template<typename In, typename Out>
+  inline void
+   project3(In in, Out out, size_t n, const Matrix4x4& mat) {
+   BatchLanes m[4][4];
+   for (int r = 0; r < 4; ++r) {
+    for (int c = 0; c < 4; ++c) m[r][c] = BatchLanes::set1(mat.m[r][c]);
+   }
+   const BatchLanes zero = BatchLanes::zero();
+   forEachPacket3(in, n, [&](size_t i, size_t count, BatchLanes x, BatchLanes y, BatchLanes z) {
+    BatchLanes row[4];
+    for (int r = 0; r < 4; ++r) {
+     row[r] = EU::SIMD::madd(m[r][2], z, EU::SIMD::madd(m[r][1], y, m[r][0] * x)) + m[r][3];
+    }
+    const BatchLanes divide = row[3] != zero;
+    storePacket3(out, i, count, EU::SIMD::select(divide, row[0] / row[3], row[0]),
+                 EU::SIMD::select(divide, row[1] / row[3], row[1]), EU::SIMD::select(divide, row[2] / row[3], row[2]));
+   });
+  }
+ }
+
+ // --- CVector2, AoS ---
+
+ /** @brief out[i] = in[i] rotated counter-clockwise by radians about the origin. */
+ inline void
+  rotateArray(const CVector2* in, CVector2* out, size_t n, float radians) {
+  float s = 0.f, c = 0.f;
+  EngineMath::sincos(radians, &s, &c);
+  detail::transform2(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n, c, -s, s, c, 0.f, 0.f);
+ }
+
+ /** @brief Rotates v[0..n) in place; one sincos for the whole array. */
+ inline void
+  rotateArray(CVector2* v, size_t n, float radians) {
+  rotateArray(v, v, n, radians);
+ }
+
+ /** @brief out[i] = in[i] rotated by radians about pivot, e.g. a sprite's centre. */
+ inline void
+  rotateArray(const CVector2* in, CVector2* out, size_t n, float radians, const CVector2& pivot) {
+  float s = 0.f, c = 0.f;
+  EngineMath::sincos(radians, &s, &c);
+  // R (p - pivot) + pivot = R p + (pivot - R pivot)
+  detail::transform2(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n, c, -s, s, c,
+                     pivot.x - (c * pivot.x - s * pivot.y), pivot.y - (s * pivot.x + c * pivot.y));
+ }
+
+ /** @brief out[i] = matrix * in[i]. */
+ inline void
+  transformArray(const CVector2* in, CVector2* out, size_t n, const Matrix2x2& matrix) {
+  detail::transform2(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n,
+                     matrix.m[0][0], matrix.m[0][1], matrix.m[1][0], matrix.m[1][1], 0.f, 0.f);
+ }
+
+ /** @brief Transforms v[0..n) in place by matrix. */
+ inline void
+  transformArray(CVector2* v, size_t n, const Matrix2x2& matrix) {
+  transformArray(v, v, n, matrix);
+ }
+
+ /**
+  * @brief out[i] = matrix * in[i] in homogeneous coordinates, like Matrix3x3::operator*.
+  *
+  * Affine matrices (bottom row 0, 0, 1) skip the divide by w.
+  */
+ inline void
+  transformArray(const CVector2* in, CVector2* out, size_t n, const Matrix3x3& matrix) {
+  detail::project2(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n, matrix);
+ }
+
+ /** @brief Transforms v[0..n) in place by matrix. */
+ inline void
+  transformArray(CVector2* v, size_t n, const Matrix3x3& matrix) {
+  transformArray(v, v, n, matrix);
+ }
+
+ // --- CVector2, SoA ---
+
+ /** @brief SoA rotateArray(). */
+ inline void
+  rotateArray(EngineMath::batch::ConstSoA2 in, EngineMath::batch::SoA2 out, size_t n, float radians) {
+  float s = 0.f, c = 0.f;
+  EngineMath::sincos(radians, &s, &c);
+  detail::transform2(in, out, n, c, -s, s, c, 0.f, 0.f);
+ }
+
+ /** @brief SoA in-place rotateArray(). */
+ inline void
+  rotateArray(EngineMath::batch::SoA2 v, size_t n, float radians) {
+  rotateArray(v, v, n, radians);
+ }
+
+ /** @brief SoA transformArray() by a Matrix2x2. */
+ inline void
+  transformArray(EngineMath::batch::ConstSoA2 in, EngineMath::batch::SoA2 out, size_t n, const Matrix2x2& matrix) {
+  detail::transform2(in, out, n, matrix.m[0][0], matrix.m[0][1], matrix.m[1][0], matrix.m[1][1], 0.f, 0.f);
+ }
+
+ /** @brief SoA transformArray() by a Matrix3x3. */
+ inline void
+  transformArray(EngineMath::batch::ConstSoA2 in, EngineMath::batch::SoA2 out, size_t n, const Matrix3x3& matrix) {
+  detail::project2(in, out, n, matrix);
+ }
+
+ // --- CVector3, AoS ---
+
+ /**
+  * @brief out[i] = matrix * in[i] as a point, for an affine matrix.
+  *
+  * The bottom row is taken to be (0, 0, 0, 1) and never read, so there is no w and no divide;
+  * use projectPoints() for perspective matrices.
+  */
+ inline void
+  transformPoints(const CVector3* in, CVector3* out, size_t n, const Matrix4x4& matrix) {
+  detail::transform3(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n, matrix.m, true);
+ }
+
+ /** @brief Transforms points v[0..n) in place by an affine matrix. */
+ inline void
+  transformPoints(CVector3* v, size_t n, const Matrix4x4& matrix) {
+  transformPoints(v, v, n, matrix);
+ }
+
+ /** @brief out[i] = transform.transformPoint(in[i]). */
+ inline void
+  transformPoints(const CVector3* in, CVector3* out, size_t n, const Affine3x4& transform) {
+  detail::transform3(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n, transform.m, true);
+ }
+
+ /** @brief Transforms points v[0..n) in place. */
+ inline void
+  transformPoints(CVector3* v, size_t n, const Affine3x4& transform) {
+  transformPoints(v, v, n, transform);
+ }
+
+ /**
+  * @brief out[i] = the upper 3x3 block of matrix * in[i]: directions ignore translation.
+  */
+ inline void
+  transformDirections(const CVector3* in, CVector3* out, size_t n, const Matrix4x4& matrix) {
+  detail::transform3(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n, matrix.m, false);
+ }
+
+ /** @brief Transforms directions v[0..n) in place. */
+ inline void
+  transformDirections(CVector3* v, size_t n, const Matrix4x4& matrix) {
+  transformDirections(v, v, n, matrix);
+ }
+
+ /** @brief out[i] = transform.transformDirection(in[i]). */
+ inline void
+  transformDirections(const CVector3* in, CVector3* out, size_t n, const Affine3x4& transform) {
+  detail::transform3(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n, transform.m, false);
+ }
+
+ /** @brief Transforms directions v[0..n) in place. */
+ inline void
+  transformDirections(CVector3* v, size_t n, const Affine3x4& transform) {
+  transformDirections(v, v, n, transform);
+ }
+
+ /**
+  * @brief out[i] = rotation.rotate(in[i]). The rotation becomes a 3x3 matrix once
+  * (Affine3x4::fromTRS(), so it need not be unit length) and the vectors stream through
+  * transformDirections(); a zero quaternion gives zero vectors.
+  */
+ inline void
+  rotateArray(const Quaternion& rotation, const CVector3* in, CVector3* out, size_t n) {
+  const Affine3x4 matrix = Affine3x4::fromTRS(CVector3(0.f, 0.f, 0.f), rotation, CVector3(1.f, 1.f, 1.f));
+  transformDirections(in, out, n, matrix);
+ }
+
+ /** @brief Rotates v[0..n) in place by rotation. */
+ inline void
+  rotateArray(const Quaternion& rotation, CVector3* v, size_t n) {
+  rotateArray(rotation, v, v, n);
+ }
+
+ /**
+  * @brief out[i] = matrix * in[i] in homogeneous coordinates, like Matrix4x4::operator*.
+  *
+  * Always computes w; points with w == 0 are left undivided, as in the scalar operator.
+  */
+ inline void
+  projectPoints(const CVector3* in, CVector3* out, size_t n, const Matrix4x4& matrix) {
+  detail::project3(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), n, matrix);
+ }
+
+ /** @brief Projects points v[0..n) in place. */
+ inline void
+  projectPoints(CVector3* v, size_t n, const Matrix4x4& matrix) {
+  projectPoints(v, v, n, matrix);
+ }
+
+ // --- CVector3, SoA ---
+
+ /** @brief SoA transformPoints() by an affine Matrix4x4. */
+ inline void
+  transformPoints(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n, const Matrix4x4& matrix) {
+  detail::transform3(in, out, n, matrix.m, true);
+ }
+
+ /** @brief SoA transformPoints() by an Affine3x4. */
+ inline void
+  transformPoints(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n, const Affine3x4& transform) {
+  detail::transform3(in, out, n, transform.m, true);
+ }
+
+ /** @brief SoA transformDirections() by a Matrix4x4. */
+ inline void
+  transformDirections(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n,
+                      const Matrix4x4& matrix) {
+  detail::transform3(in, out, n, matrix.m, false);
+ }
+
+ /** @brief SoA transformDirections() by an Affine3x4. */
+ inline void
+  transformDirections(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n,
+                      const Affine3x4& transform) {
+  detail::transform3(in, out, n, transform.m, false);
+ }
+
+ /** @brief SoA rotateArray(). */
+ inline void
+  rotateArray(const Quaternion& rotation, EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n) {
+  const Affine3x4 matrix = Affine3x4::fromTRS(CVector3(0.f, 0.f, 0.f), rotation, CVector3(1.f, 1.f, 1.f));
+  transformDirections(in, out, n, matrix);
+ }
+
+ /** @brief SoA in-place rotateArray(). */
+ inline void
+  rotateArray(const Quaternion& rotation, EngineMath::batch::SoA3 v, size_t n) {
+  rotateArray(rotation, v, v, n);
+ }
+
+ /** @brief SoA projectPoints(). */
+ inline void
+  projectPoints(EngineMath::batch::ConstSoA3 in, EngineMath::batch::SoA3 out, size_t n, const Matrix4x4& matrix) {
+  detail::project3(in, out, n, matrix);
+ }
+}
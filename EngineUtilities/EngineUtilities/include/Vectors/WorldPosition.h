@@ -0,0 +1,147 @@
+/**
+ * @file WorldPosition.h
+ * @brief Double-precision world positions and their camera-relative float conversion.
+ *
+ * Objects keep their placement as WorldPosition (EU::Vector3d), which stays exact to well
+ * below a millimetre across hundreds of kilometres. Once per frame, rebaseToCamera() subtracts
+ * the camera position in double and rounds the offsets to float CVector3 / Matrix4x4, so
+ * everything downstream (culling, skinning, the GPU) works in small float coordinates around
+ * the viewer. The view matrix then carries only the camera rotation, never its translation.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <Core/SIMD.h>
+#include <Matrices/Matrix4x4.h>
+#include <Vectors/Vector.h>
+#include <Vectors/Vector3.h>
+
+namespace EU {
+ /// Double-precision position in world space.
+ using WorldPosition = Vector3d;
+
+ static_assert(sizeof(WorldPosition) == 3 * sizeof(double), "WorldPosition must be three packed doubles");
+ static_assert(sizeof(CVector3) == 3 * sizeof(float), "CVector3 must be three packed floats");
+
+ /**
+  * @brief position - camera, subtracted in double and rounded to float.
+  */
+ inline CVector3
+  toCameraRelative(const WorldPosition& position, const WorldPosition& camera) {
+  return CVector3(static_cast<float>(position.x - camera.x),
+                  static_cast<float>(position.y - camera.y),
+                  static_cast<float>(position.z - camera.z));
+ }
+
+ /**
+  * @brief Inverse of toCameraRelative(): lifts a camera-relative offset back to world space.
+  */
+ inline WorldPosition
+  toWorld(const CVector3& offset, const WorldPosition& camera) {
+  return WorldPosition(camera.x + offset.x, camera.y + offset.y, camera.z + offset.z);
+ }
+
+ /**
+  * @brief Camera-relative model matrix.
+  *
+  * Keeps the rotation/scale of @p transform and replaces its translation column with
+  * toCameraRelative(position, camera).
+  */
+ inline Matrix4x4
+  toCameraRelative(const Matrix4x4& transform, const WorldPosition& position, const WorldPosition& camera) {
+  Matrix4x4 result = transform;
+  CVector3 offset = toCameraRelative(position, camera);
+  result.m[0][3] = offset.x;
+  result.m[1][3] = offset.y;
+  result.m[2][3] = offset.z;
+  return result;
+ }
+
+ /**
+  * @brief out[i] = toCameraRelative(positions[i], camera), in one vectorized pass.
+  *
+  * Produces the same bits as the scalar conversion on every path.
+  */
+ inline void
+  rebaseToCamera(const WorldPosition* positions, const WorldPosition& camera, CVector3* out, size_t n) {
+  // Both arrays are read as flat component streams; four positions are 12 doubles, so the
+  // camera pattern (x, y, z) lines up with the registers again after every group of four.
+  const double* in = &positions[0].x;
+  float* dst = &out[0].x;
+  size_t i = 0;
+#if defined(EU_SIMD_AVX2)
+  const __m256d c0 = _mm256_setr_pd(camera.x, camera.y, camera.z, camera.x);
+  const __m256d c1 = _mm256_setr_pd(camera.y, camera.z, camera.x, camera.y);
+  const __m256d c2 = _mm256_setr_pd(camera.z, camera.x, camera.y, camera.z);
+  for (; i + 4 <= n; i += 4) {
+   const double* p = in + 3 * i;
+   float* o = dst + 3 * i;
+   _mm_storeu_ps(o + 0, _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(p + 0), c0)));
+   _mm_storeu_ps(o + 4, _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(p + 4), c1)));
+   _mm_storeu_ps(o + 8, _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(p + 8), c2)));
+  }
+#elif defined(EU_SIMD_SSE2)
+  const __m128d c0 = _mm_setr_pd(camera.x, camera.y);
+  const __m128d c1 = _mm_setr_pd(camera.z, camera.x);
+  const __m128d c2 = _mm_setr_pd(camera.y, camera.z);
+  for (; i + 4 <= n; i += 4) {
+   const double* p = in + 3 * i;
+   float* o = dst + 3 * i;
+   __m128 d0 = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(p + 0), c0));
+   __m128 d1 = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(p + 2), c1));
+   __m128 d2 = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(p + 4), c2));
+   __m128 d3 = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(p + 6), c0));
+   __m128 d4 = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(p + 8), c1));
+   __m128 d5 = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(p + 10), c2));
+   _mm_storeu_ps(o + 0, _mm_movelh_ps(d0, d1));
+   _mm_storeu_ps(o + 4, _mm_movelh_ps(d2, d3));
+   _mm_storeu_ps(o + 8, _mm_movelh_ps(d4, d5));
+  }
+#elif defined(EU_SIMD_NEON) && defined(__aarch64__)
+  const double cx[6] = { camera.x, camera.y, camera.z, camera.x, camera.y, camera.z };
+  const float64x2_t c0 = vld1q_f64(cx + 0);
+  const float64x2_t c1 = vld1q_f64(cx + 2);
+  const float64x2_t c2 = vld1q_f64(cx + 4);
+  for (; i + 4 <= n; i += 4) {
+   const double* p = in + 3 * i;
+   float* o = dst + 3 * i;
+   float32x2_t d0 = vcvt_f32_f64(vsubq_f64(vld1q_f64(p + 0), c0));
+   float32x2_t d1 = vcvt_f32_f64(vsubq_f64(vld1q_f64(p + 2), c1));
+   float32x2_t d2 = vcvt_f32_f64(vsubq_f64(vld1q_f64(p + 4), c2));
+   float32x2_t d3 = vcvt_f32_f64(vsubq_f64(vld1q_f64(p + 6), c0));
+   float32x2_t d4 = vcvt_f32_f64(vsubq_f64(vld1q_f64(p + 8), c1));
+   float32x2_t d5 = vcvt_f32_f64(vsubq_f64(vld1q_f64(p + 10), c2));
+   vst1q_f32(o + 0, vcombine_f32(d0, d1));
+   vst1q_f32(o + 4, vcombine_f32(d2, d3));
+   vst1q_f32(o + 8, vcombine_f32(d4, d5));
+  }
+#endif
+  (void)in;
+  (void)dst;
+  for (; i < n; ++i) out[i] = toCameraRelative(positions[i], camera);
+ }
+
+ /**
+  * @brief out[i] = toCameraRelative(transforms[i], positions[i], camera) for all visible objects.
+  *
+  * @p out may alias @p transforms; the positions are rebased in blocks through rebaseToCamera().
+  */
+ inline void
+  rebaseToCamera(const Matrix4x4* transforms, const WorldPosition* positions, const WorldPosition& camera,
+                 Matrix4x4* out, size_t n) {
+  const size_t BLOCK = 64;
+  CVector3 offsets[BLOCK];
+  for (size_t base = 0; base < n; base += BLOCK) {
+   size_t count = n - base < BLOCK ? n - base : BLOCK;
+   rebaseToCamera(positions + base, camera, offsets, count);
+   for (size_t i = 0; i < count; ++i) {
+    Matrix4x4& m = out[base + i];
+    if (&m != &transforms[base + i]) m = transforms[base + i];
+    m.m[0][3] = offsets[i].x;
+    m.m[1][3] = offsets[i].y;
+    m.m[2][3] = offsets[i].z;
+   }
+  }
+ }
+}
@@ -0,0 +1,180 @@
+/**
+ * @file Kernels.inl
+ * @brief Body shared by the per-ISA dispatch units: compiles the batch kernels under the
+ * including file's flags and publishes them as EU::Dispatch::detail::EU_DISPATCH_TABLE().
+ *
+ * The math headers are inline, and their bodies depend on the ISA macros, so two units
+ * built with different flags would define the same inline functions differently and the
+ * linker could keep the AVX2 copy for everyone. They are therefore included inside an
+ * unnamed namespace, which gives every one of their functions internal linkage in this unit.
+ * That only works if the standard and intrinsic headers they use are already included at
+ * global scope first; add any new ones to the list below.
+ *
+ * Parallel work is left to Dispatch.h: the copied Parallel.h would not see a TaskBackend
+ * installed by the program.
+ */
+
+#if !defined(EU_DISPATCH_TABLE)
+ #error "define EU_DISPATCH_TABLE before including Kernels.inl"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L) || __cplusplus >= 202002L
+ #include <bit>
+#endif
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+ #if defined(_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+ #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+ #include <arm_neon.h>
+#endif
+#include <Core/KernelTable.h>
+
+namespace {
+#include <Geometry/Frustum.h>
+#include <Math/EngineMathBatch.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/Skinning.h>
+#include <Vectors/VectorBatch.h>
+#include <Vectors/VectorTransform.h>
+
+ namespace dispatched {
+  void
+   sin(const float* in, float* out, size_t n) {
+   EngineMath::batch::sin(in, out, n);
+  }
+
+  void
+   cos(const float* in, float* out, size_t n) {
+   EngineMath::batch::cos(in, out, n);
+  }
+
+  void
+   sincos(const float* in, float* s, float* c, size_t n) {
+   EngineMath::batch::sincos(in, s, c, n);
+  }
+
+  void
+   normalize3(const float* in, float* out, size_t n) {
+   EU::normalizeArray(reinterpret_cast<const CVector3*>(in), reinterpret_cast<CVector3*>(out), n);
+  }
+
+  void
+   normalize3SoA(const float* x, const float* y, const float* z, float* ox, float* oy, float* oz, size_t n) {
+   EU::normalizeArray(EngineMath::batch::ConstSoA3{ x, y, z }, EngineMath::batch::SoA3{ ox, oy, oz }, n);
+  }
+
+  void
+   transformPoints(const float* in, float* out, size_t n, const float* matrix) {
+   EU::Matrix4x4 m(EU::NoInit);
+   std::memcpy(m.m, matrix, sizeof(m.m));
+   EU::transformPoints(reinterpret_cast<const CVector3*>(in), reinterpret_cast<CVector3*>(out), n, m);
+  }
+
+  EU::Frustum
+   toFrustum(const float* planes) {
+   EU::Frustum frustum;
+   std::memcpy(frustum.planes, planes, sizeof(frustum.planes));
+   return frustum;
+  }
+
+  size_t
+   cullSpheres(const float* planes, const float* x, const float* y, const float* z, const float* radii,
+               size_t begin, size_t end, uint32_t* out) {
+   const EU::detail::CullPlanes lanes(toFrustum(planes));
+   return EU::detail::cullSpheresRange(lanes, EngineMath::batch::ConstSoA3{ x, y, z }, radii, begin, end, out);
+  }
+
+  size_t
+   cullBoxes(const float* planes, const float* lx, const float* ly, const float* lz, const float* hx,
+             const float* hy, const float* hz, size_t begin, size_t end, uint32_t* out) {
+   const EU::Frustum frustum = toFrustum(planes);
+   const EU::detail::CullPlanes lanes(frustum);
+   return EU::detail::cullBoxesRange(frustum, lanes, EngineMath::batch::ConstSoA3{ lx, ly, lz },
+                                     EngineMath::batch::ConstSoA3{ hx, hy, hz }, begin, end, out);
+  }
+
+  /** Writes box as the six floats of KernelTable's skinning bounds. */
+  void
+   storeBounds(const EU::AABB& box, float* bounds) {
+   const float values[6] = { box.min.x, box.min.y, box.min.z, box.max.x, box.max.y, box.max.z };
+   std::memcpy(bounds, values, sizeof(values));
+  }
+
+  void
+   skinPositions(const float* in, float* out, size_t n, const void* influences, const float* palette, float* bounds) {
+   EU::AABB box;
+   EU::skinPositions(reinterpret_cast<const CVector3*>(in), reinterpret_cast<CVector3*>(out), n,
+                     static_cast<const EU::BoneInfluences*>(influences), reinterpret_cast<const EU::Affine3x4*>(palette),
+                     bounds ? &box : nullptr);
+   if (bounds) storeBounds(box, bounds);
+  }
+
+  void
+   skinVertices(const float* positions, const float* normals, float* outPositions, float* outNormals, size_t n,
+                const void* influences, const float* palette, float* bounds) {
+   EU::AABB box;
+   EU::skinVertices(reinterpret_cast<const CVector3*>(positions), reinterpret_cast<const CVector3*>(normals),
+                    reinterpret_cast<CVector3*>(outPositions), reinterpret_cast<CVector3*>(outNormals), n,
+                    static_cast<const EU::BoneInfluences*>(influences), reinterpret_cast<const EU::Affine3x4*>(palette),
+                    bounds ? &box : nullptr);
+   if (bounds) storeBounds(box, bounds);
+  }
+
+  /** The tier these flags really produced, which may be above or below the file's name. */
+  constexpr ::EU::CpuTier
+   compiledTier() {
+#if defined(EU_SIMD_AVX2) && defined(EU_SIMD_FMA) && defined(EU_SIMD_F16C)
+   return ::EU::CpuTier::AVX2;
+#elif defined(EU_SIMD_SSE41)
+   return ::EU::CpuTier::SSE41;
+#else
+   return ::EU::CpuTier::Baseline;
+#endif
+  }
+
+  constexpr bool
+   compiledSimd() {
+#if defined(EU_SIMD_SSE2) || defined(EU_SIMD_NEON)
+   return true;
+#else
+   return false;
+#endif
+  }
+
+  constexpr const char*
+   compiledName() {
+   return compiledTier() == ::EU::CpuTier::AVX2 ? "AVX2"
+        : compiledTier() == ::EU::CpuTier::SSE41 ? "SSE4.1" : compiledSimd() ? "Baseline" : "Scalar";
+  }
+ }
+}
+
+const ::EU::Dispatch::KernelTable&
+ ::EU::Dispatch::detail::EU_DISPATCH_TABLE() {
+ static const KernelTable table = {
+  dispatched::compiledName(), dispatched::compiledTier(), dispatched::compiledSimd(),
+  &dispatched::sin, &dispatched::cos, &dispatched::sincos,
+  &dispatched::normalize3, &dispatched::normalize3SoA,
+  &dispatched::transformPoints,
+  &dispatched::cullSpheres, &dispatched::cullBoxes,
+  &dispatched::skinPositions, &dispatched::skinVertices,
+ };
+ return table;
+}
@@ -0,0 +1,9 @@
+/**
+ * @file KernelsAVX2.cpp
+ * @brief Dispatch kernels using AVX2 with FMA and F16C (8-wide lanes).
+ *
+ * Build with /arch:AVX2 on MSVC, or -mavx2 -mfma -mf16c -mbmi2 on GCC and Clang.
+ */
+
+#define EU_DISPATCH_TABLE kernelTableAVX2
+#include "Kernels.inl"
@@ -0,0 +1,9 @@
+/**
+ * @file KernelsBaseline.cpp
+ * @brief Dispatch kernels built with the project's own flags (SSE2 on x64, NEON on AArch64).
+ *
+ * Must not get any ISA flag above the lowest CPU the binary supports; it is the fallback.
+ */
+
+#define EU_DISPATCH_TABLE kernelTableBaseline
+#include "Kernels.inl"
@@ -0,0 +1,13 @@
+/**
+ * @file KernelsSSE41.cpp
+ * @brief Dispatch kernels using SSE4.1 (roundps, blendvps, dpps).
+ *
+ * Build with -msse4.1 on GCC and Clang. MSVC has no SSE4.1 switch but accepts the intrinsics
+ * anywhere, so the file requests the path through EU_TARGET_SSE41 instead.
+ */
+
+#if defined(_MSC_VER) && !defined(__clang__)
+ #define EU_TARGET_SSE41 1
+#endif
+#define EU_DISPATCH_TABLE kernelTableSSE41
+#include "Kernels.inl"
@@ -0,0 +1,589 @@
+/**
+ * @file Scenarios.cpp
+ * @brief End-to-end frame benchmarks of the engine systems, at several thread counts, with
+ *        a machine-readable report that can be checked against a stored baseline.
+ *
+ * Each scenario builds a deterministic world and then runs whole frames of one system on it:
+ *
+ *   hierarchy   100k-node transform hierarchy, 1000 animated trees, TransformHierarchy::update()
+ *   particles   1M particles in 16 streams, semi-implicit Euler with gravity and drag
+ *   cull        500k bounding spheres against a turning camera, cullSpheres()
+ *   broadphase  10k moving circles, SpatialHash2D rebuild() and pairs()
+ *   skinning    2k characters of 64 bones and 1000 vertices, buildPalette() and skinVertices()
+ *
+ * For every thread count (1, 2, 4 and hardware_concurrency() unless --threads says otherwise)
+ * a JobSystem of that size is installed with useForParallelTasks(), so the library's own
+ * parallel paths run on it. After WARMUP_FRAMES, every frame is timed on its own; a row reports
+ * throughput (items per second over the timed frames), the median and 99th percentile frame
+ * time, and the peak heap the scenario held, world included, through the operator new
+ * replacements below.
+ *
+ *   Scenarios [filter] [--frames N] [--threads 1,2,8] [--csv out.csv]
+ *             [--baseline base.csv] [--tolerance 0.1]
+ *
+ * --csv writes the rows as CSV (lines starting with # are comments). --baseline reads such a
+ * file and compares every row it shares with this run: a median frame time or peak heap more
+ * than tolerance above the baseline is a regression, and the exit code is 1 if there is any.
+ * Record a baseline per machine and build with --csv, in Release, on an idle system.
+ *
+ * Build in Release (the Scenarios project in the solution), or by hand with e.g.
+ *   cl /O2 /std:c++17 /EHsc /I ..\EngineUtilities\include src\Scenarios.cpp
+ *   g++ -O2 -std=c++17 -march=native -pthread -I ../EngineUtilities/include src/Scenarios.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <Core/JobSystem.h>
+#include <Core/Parallel.h>
+#include <Geometry/Frustum.h>
+#include <Geometry/SpatialHash2D.h>
+#include <Math/EngineMath.h>
+#include <Matrices/Affine3x4.h>
+#include <Matrices/CameraMatrices.h>
+#include <Matrices/Skinning.h>
+#include <Matrices/TransformHierarchy.h>
+#include <Rotations/Quaternion.h>
+#include <Vectors/ParticleIntegrate.h>
+#include <Vectors/Vector2.h>
+#include <Vectors/Vector3.h>
+#include <Vectors/Vector3Stream.h>
+
+namespace {
+ const size_t WARMUP_FRAMES = 10;    ///< Untimed frames before each row
+ const size_t DEFAULT_FRAMES = 100;  ///< Timed frames per row
+ const float FRAME_DT = 1.f / 60.f;
+
+ std::atomic<size_t> g_liveBytes(0);
+ std::atomic<size_t> g_peakBytes(0);
+
+ /** Allocation header: the size handed out and the block malloc() returned. */
+ struct alignas(16) AllocHeader {
+  size_t size;
+  void* block;
+ };
+
+ void*
+  trackedAlloc(size_t size, size_t alignment) {
+  if (alignment < alignof(AllocHeader)) alignment = alignof(AllocHeader);
+  void* block = std::malloc(size + sizeof(AllocHeader) + alignment - 1);
+  if (!block) return nullptr;
+  const uintptr_t first = reinterpret_cast<uintptr_t>(block) + sizeof(AllocHeader);
+  void* user = reinterpret_cast<void*>((first + alignment - 1) & ~uintptr_t(alignment - 1));
+  AllocHeader* header = static_cast<AllocHeader*>(user) - 1;
+  header->size = size;
+  header->block = block;
+  const size_t live = g_liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+  size_t peak = g_peakBytes.load(std::memory_order_relaxed);
+  while (live > peak && !g_peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+  return user;
+ }
+
+ void
+  trackedFree(void* p) {
+  if (!p) return;
+  const AllocHeader* header = static_cast<AllocHeader*>(p) - 1;
+  g_liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+  std::free(header->block);
+ }
+
+ void*
+  trackedNew(size_t size, size_t alignment) {
+  void* p = trackedAlloc(size ? size : 1, alignment);
+  if (!p) throw std::bad_alloc();
+  return p;
+ }
+}
+
+void* operator new(size_t size) { return trackedNew(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return trackedNew(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size ? size : 1, alignof(std::max_align_t)); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size ? size : 1, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t a) { return trackedNew(size, static_cast<size_t>(a)); }
+void* operator new[](size_t size, std::align_val_t a) { return trackedNew(size, static_cast<size_t>(a)); }
+void operator delete(void* p) noexcept { trackedFree(p); }
+void operator delete[](void* p) noexcept { trackedFree(p); }
+void operator delete(void* p, size_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, size_t) noexcept { trackedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { trackedFree(p); }
+void operator delete(void* p, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { trackedFree(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { trackedFree(p); }
+
+namespace {
+ using EU::Quaternion;
+
+ /** Deterministic xorshift stream of uniform floats. */
+ struct Random {
+  uint32_t s;
+
+  explicit Random(uint32_t seed) : s(seed * 2654435761u + 1u) {}
+
+  uint32_t
+   next() {
+   s ^= s << 13;
+   s ^= s >> 17;
+   s ^= s << 5;
+   return s;
+  }
+
+  /** Uniform in [lo, hi]. */
+  float
+   uniform(float lo, float hi) {
+   return lo + (hi - lo) * static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+  }
+ };
+
+ /**
+  * One benchmark world. The constructor builds it; frame() advances it by one frame on up to
+  * threads threads.
+  */
+ class
+  Scenario {
+  public:
+  virtual ~Scenario() = default;
+  virtual void frame(size_t threads) = 0;
+  /** Items one frame processes. */
+  virtual size_t items() const = 0;
+  /** Folded result of the last frame, printed so the work cannot be optimized away. */
+  virtual double checksum() const = 0;
+ };
+
+ class
+  HierarchyScenario : public Scenario {
+  public:
+  static constexpr size_t TREES = 1000;
+  static constexpr size_t NODES_PER_TREE = 100;
+
+  HierarchyScenario() : m_frame(0) {
+   Random random(1);
+   m_hierarchy.reserve(TREES * NODES_PER_TREE);
+   for (size_t t = 0; t < TREES; ++t) {
+    const auto root = m_hierarchy.add(EU::TransformHierarchy::NO_PARENT,
+                                      CVector3(random.uniform(-500.f, 500.f), 0.f, random.uniform(-500.f, 500.f)));
+    m_animated.push_back(root);
+    for (size_t k = 1; k < NODES_PER_TREE; ++k) {
+     // Parents drawn from the earlier nodes of the tree give bushy trees about ten levels deep at most.
+     const auto parent = root + static_cast<uint32_t>(random.next() % k);
+     const auto node = m_hierarchy.add(parent, CVector3(random.uniform(-1.f, 1.f), random.uniform(0.f, 2.f), 0.f),
+                                       Quaternion::fromAxisAngle(CVector3(0.f, 0.f, 1.f), random.uniform(-1.f, 1.f)));
+     if (k % 4 == 0) m_animated.push_back(node);
+    }
+   }
+   m_hierarchy.update(1);
+  }
+
+  void
+   frame(size_t threads) override {
+   const Quaternion delta = Quaternion::fromAxisAngle(CVector3(0.f, 1.f, 0.f), (m_frame++ & 1) ? 0.01f : -0.01f);
+   for (const auto node : m_animated) m_hierarchy.rotate(node, delta);
+   m_hierarchy.update(threads);
+  }
+
+  size_t items() const override { return m_hierarchy.size(); }
+
+  double
+   checksum() const override {
+   return m_hierarchy.world(static_cast<uint32_t>(m_hierarchy.size() - 1)).m[0][3];
+  }
+
+  private:
+  EU::TransformHierarchy m_hierarchy;
+  std::vector<EU::TransformHierarchy::Node> m_animated;
+  size_t m_frame;
+ };
+
+ class
+  ParticleScenario : public Scenario {
+  public:
+  static constexpr size_t STREAMS = 16;
+  static constexpr size_t PARTICLES_PER_STREAM = 65536;
+
+  ParticleScenario() {
+   Random random(2);
+   m_positions.resize(STREAMS);
+   m_velocities.resize(STREAMS);
+   for (size_t s = 0; s < STREAMS; ++s) {
+    m_positions[s].resize(PARTICLES_PER_STREAM);
+    m_velocities[s].resize(PARTICLES_PER_STREAM);
+    for (size_t i = 0; i < PARTICLES_PER_STREAM; ++i) {
+     m_positions[s].set(i, CVector3(random.uniform(-100.f, 100.f), random.uniform(0.f, 100.f), random.uniform(-100.f, 100.f)));
+     m_velocities[s].set(i, CVector3(random.uniform(-5.f, 5.f), random.uniform(0.f, 10.f), random.uniform(-5.f, 5.f)));
+    }
+   }
+   m_forces.gravity = CVector3(0.f, -9.81f, 0.f);
+   m_forces.drag = 0.1f;
+  }
+
+  void
+   frame(size_t threads) override {
+   EU::detail::parallelTasks(STREAMS, EU::detail::resolveThreads(threads, STREAMS), [&](size_t s) {
+    EU::integrateSemiImplicitEuler(m_positions[s], m_velocities[s], nullptr, m_forces, FRAME_DT);
+   });
+  }
+
+  size_t items() const override { return STREAMS * PARTICLES_PER_STREAM; }
+
+  double
+   checksum() const override {
+   return m_positions[STREAMS - 1].y()[PARTICLES_PER_STREAM - 1];
+  }
+
+  private:
+  std::vector<EU::Vector3Stream> m_positions;
+  std::vector<EU::Vector3Stream> m_velocities;
+  EU::ParticleForces m_forces;
+ };
+
+ class
+  CullScenario : public Scenario {
+  public:
+  static constexpr size_t OBJECTS = 500000;
+
+  CullScenario() : m_x(OBJECTS), m_y(OBJECTS), m_z(OBJECTS), m_radius(OBJECTS), m_visible(OBJECTS), m_found(0), m_angle(0.f) {
+   Random random(3);
+   for (size_t i = 0; i < OBJECTS; ++i) {
+    m_x[i] = random.uniform(-1000.f, 1000.f);
+    m_y[i] = random.uniform(-50.f, 50.f);
+    m_z[i] = random.uniform(-1000.f, 1000.f);
+    m_radius[i] = random.uniform(0.5f, 4.f);
+   }
+   m_projection = EU::perspective(1.0f, 16.f / 9.f, 0.1f, 800.f).matrix;
+  }
+
+  void
+   frame(size_t threads) override {
+   m_angle += 0.01f;
+   const CVector3 eye(0.f, 10.f, 0.f);
+   const CVector3 target(EngineMath::sin(m_angle), 10.f, EngineMath::cos(m_angle));
+   const EU::Matrix4x4 view = EU::lookAt(eye, target, CVector3(0.f, 1.f, 0.f)).matrix;
+   const EU::Frustum frustum = EU::Frustum::fromMatrix(m_projection * view);
+   m_found = EU::cullSpheres(frustum, { m_x.data(), m_y.data(), m_z.data() }, m_radius.data(), OBJECTS,
+                             m_visible.data(), threads);
+  }
+
+  size_t items() const override { return OBJECTS; }
+  double checksum() const override { return static_cast<double>(m_found); }
+
+  private:
+  std::vector<float> m_x, m_y, m_z, m_radius;
+  std::vector<uint32_t> m_visible;
+  EU::Matrix4x4 m_projection;
+  size_t m_found;
+  float m_angle;
+ };
+
+ class
+  BroadphaseScenario : public Scenario {
+  public:
+  static constexpr size_t BODIES = 10000;
+  static constexpr float WORLD = 500.f;
+
+  BroadphaseScenario() : m_grid(4.f), m_position(BODIES), m_velocity(BODIES), m_radius(BODIES) {
+   Random random(4);
+   for (size_t i = 0; i < BODIES; ++i) {
+    m_position[i] = CVector2(random.uniform(0.f, WORLD), random.uniform(0.f, WORLD));
+    m_velocity[i] = CVector2(random.uniform(-20.f, 20.f), random.uniform(-20.f, 20.f));
+    m_radius[i] = random.uniform(0.5f, 2.f);
+   }
+   m_grid.assign(m_position.data(), m_radius.data(), BODIES);
+  }
+
+  void
+   frame(size_t threads) override {
+   for (size_t i = 0; i < BODIES; ++i) {
+    CVector2& p = m_position[i];
+    CVector2& v = m_velocity[i];
+    p += v * FRAME_DT;
+    if (p.x < 0.f || p.x > WORLD) v.x = -v.x;
+    if (p.y < 0.f || p.y > WORLD) v.y = -v.y;
+    m_grid.update(static_cast<uint32_t>(i), p);
+   }
+   m_grid.rebuild(threads);
+   m_pairs.clear();
+   m_grid.pairs(m_pairs, threads);
+  }
+
+  size_t items() const override { return BODIES; }
+  double checksum() const override { return static_cast<double>(m_pairs.size()); }
+
+  private:
+  EU::SpatialHash2D m_grid;
+  std::vector<CVector2> m_position, m_velocity;
+  std::vector<float> m_radius;
+  std::vector<std::pair<uint32_t, uint32_t>> m_pairs;
+ };
+
+ class
+  SkinningScenario : public Scenario {
+  public:
+  static constexpr size_t CHARACTERS = 2000;
+  static constexpr size_t BONES = 64;
+  static constexpr size_t VERTICES = 1000;
+  /// Characters per task.
+  static constexpr size_t CHARACTER_CHUNK = 16;
+
+  SkinningScenario()
+   : m_bindPositions(VERTICES), m_bindNormals(VERTICES), m_influences(VERTICES), m_inverseBind(BONES),
+     m_worlds(CHARACTERS * BONES), m_palettes(CHARACTERS * BONES), m_positions(CHARACTERS * VERTICES),
+     m_normals(CHARACTERS * VERTICES), m_frame(0) {
+   Random random(5);
+   // One shared mesh: a column of bones along y, every vertex weighted to up to four nearby ones.
+   for (size_t b = 0; b < BONES; ++b) {
+    m_inverseBind[b] = EU::Affine3x4::fromTRS(CVector3(0.f, -0.05f * static_cast<float>(b), 0.f), Quaternion(),
+                                              CVector3(1.f, 1.f, 1.f));
+   }
+   for (size_t v = 0; v < VERTICES; ++v) {
+    const float height = random.uniform(0.f, 0.05f * (BONES - 1));
+    const float angle = random.uniform(-3.14159265f, 3.14159265f);
+    m_bindPositions[v] = CVector3(0.2f * EngineMath::cos(angle), height, 0.2f * EngineMath::sin(angle));
+    m_bindNormals[v] = CVector3(EngineMath::cos(angle), 0.f, EngineMath::sin(angle));
+    const size_t first = std::min(static_cast<size_t>(height / 0.05f), BONES - 4);
+    float total = 0.f;
+    for (int k = 0; k < 4; ++k) {
+     m_influences[v].joints[k] = static_cast<uint16_t>(first + k);
+     m_influences[v].weights[k] = random.uniform(0.1f, 1.f);
+     total += m_influences[v].weights[k];
+    }
+    for (int k = 0; k < 4; ++k) m_influences[v].weights[k] /= total;
+   }
+  }
+
+  void
+   frame(size_t threads) override {
+   const float phase = 0.05f * static_cast<float>(m_frame++);
+   const size_t tasks = (CHARACTERS + CHARACTER_CHUNK - 1) / CHARACTER_CHUNK;
+   EU::detail::parallelTasks(tasks, EU::detail::resolveThreads(threads, tasks), [&](size_t t) {
+    const size_t end = std::min(CHARACTERS, (t + 1) * CHARACTER_CHUNK);
+    for (size_t c = t * CHARACTER_CHUNK; c < end; ++c) skinCharacter(c, phase);
+   });
+  }
+
+  size_t items() const override { return CHARACTERS * VERTICES; }
+
+  double
+   checksum() const override {
+   return m_positions.back().x + m_normals.back().z;
+  }
+
+  private:
+  /** Poses character c as a bent chain and skins its copy of the mesh. */
+  void
+   skinCharacter(size_t c, float phase) {
+   EU::Affine3x4* worlds = &m_worlds[c * BONES];
+   const float bend = 0.02f * EngineMath::sin(phase + 0.1f * static_cast<float>(c));
+   const EU::Affine3x4 step = EU::Affine3x4::fromTRS(CVector3(0.f, 0.05f, 0.f),
+                                                     Quaternion::fromAxisAngle(CVector3(0.f, 0.f, 1.f), bend),
+                                                     CVector3(1.f, 1.f, 1.f));
+   worlds[0] = EU::Affine3x4::fromTRS(CVector3(static_cast<float>(c), 0.f, 0.f), Quaternion(), CVector3(1.f, 1.f, 1.f));
+   for (size_t b = 1; b < BONES; ++b) worlds[b] = worlds[b - 1] * step;
+   EU::Affine3x4* palette = &m_palettes[c * BONES];
+   EU::buildPalette(worlds, m_inverseBind.data(), palette, BONES);
+   EU::skinVertices(m_bindPositions.data(), m_bindNormals.data(), &m_positions[c * VERTICES],
+                    &m_normals[c * VERTICES], VERTICES, m_influences.data(), palette);
+  }
+
+  std::vector<CVector3> m_bindPositions, m_bindNormals;
+  std::vector<EU::BoneInfluences> m_influences;
+  std::vector<EU::Affine3x4> m_inverseBind, m_worlds, m_palettes;
+  std::vector<CVector3> m_positions, m_normals;
+  size_t m_frame;
+ };
+
+ struct ScenarioInfo {
+  const char* name;
+  const char* unit;
+  std::unique_ptr<Scenario> (*make)();
+ };
+
+ template<typename T>
+ std::unique_ptr<Scenario>
+  makeScenario() {
+  return std::unique_ptr<Scenario>(new T());
+ }
+
+ const ScenarioInfo SCENARIOS[] = {
+  { "hierarchy", "nodes", &makeScenario<HierarchyScenario> },
+  { "particles", "particles", &makeScenario<ParticleScenario> },
+  { "cull", "spheres", &makeScenario<CullScenario> },
+  { "broadphase", "bodies", &makeScenario<BroadphaseScenario> },
+  { "skinning", "vertices", &makeScenario<SkinningScenario> },
+ };
+
+ struct Row {
+  std::string scenario;
+  size_t threads = 0;
+  double itemsPerSecond = 0.0;
+  double p50 = 0.0;  ///< Milliseconds
+  double p99 = 0.0;  ///< Milliseconds
+  double peakMB = 0.0;
+ };
+
+ /** Value at fraction q of the sorted samples, nearest rank. */
+ double
+  percentile(const std::vector<double>& sorted, double q) {
+  size_t rank = static_cast<size_t>(q * static_cast<double>(sorted.size()) + 0.5);
+  rank = rank == 0 ? 0 : rank - 1;
+  return sorted[std::min(rank, sorted.size() - 1)];
+ }
+
+ Row
+  run(const ScenarioInfo& info, size_t threads, size_t frames) {
+  using Clock = std::chrono::steady_clock;
+  EU::JobSystem jobs(threads);
+  jobs.useForParallelTasks();
+
+  const size_t baseline = g_liveBytes.load();
+  g_peakBytes.store(baseline);
+  std::unique_ptr<Scenario> scenario = info.make();
+  for (size_t f = 0; f < WARMUP_FRAMES; ++f) scenario->frame(threads);
+
+  std::vector<double> times;
+  times.reserve(frames);
+  double total = 0.0;
+  for (size_t f = 0; f < frames; ++f) {
+   const Clock::time_point start = Clock::now();
+   scenario->frame(threads);
+   const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+   times.push_back(seconds * 1e3);
+   total += seconds;
+  }
+  std::sort(times.begin(), times.end());
+
+  Row row;
+  row.scenario = info.name;
+  row.threads = threads;
+  row.itemsPerSecond = total > 0.0 ? static_cast<double>(scenario->items()) * static_cast<double>(frames) / total : 0.0;
+  row.p50 = percentile(times, 0.50);
+  row.p99 = percentile(times, 0.99);
+  row.peakMB = static_cast<double>(g_peakBytes.load() - baseline) / (1024.0 * 1024.0);
+  std::printf("%-12s %8zu %14.4g %-10s %10.3f %10.3f %10.1f   (checksum %g)\n", info.name, threads,
+              row.itemsPerSecond, info.unit, row.p50, row.p99, row.peakMB, scenario->checksum());
+  return row;
+ }
+
+ bool
+  writeCsv(const char* path, const std::vector<Row>& rows) {
+  FILE* file = std::fopen(path, "w");
+  if (!file) return false;
+  std::fprintf(file, "# EngineUtilities scenarios, hardware_threads=%u\n", std::thread::hardware_concurrency());
+  std::fprintf(file, "scenario,threads,items_per_s,p50_ms,p99_ms,peak_mb\n");
+  for (const Row& r : rows) {
+   std::fprintf(file, "%s,%zu,%.6g,%.6g,%.6g,%.6g\n", r.scenario.c_str(), r.threads, r.itemsPerSecond, r.p50, r.p99, r.peakMB);
+  }
+  return std::fclose(file) == 0;
+ }
+
+ bool
+  readCsv(const char* path, std::vector<Row>& rows) {
+  FILE* file = std::fopen(path, "r");
+  if (!file) return false;
+  char line[512];
+  while (std::fgets(line, sizeof(line), file)) {
+   if (line[0] == '#' || std::strncmp(line, "scenario,", 9) == 0) continue;
+   char name[128];
+   Row r;
+   if (std::sscanf(line, "%127[^,],%zu,%lf,%lf,%lf,%lf", name, &r.threads, &r.itemsPerSecond, &r.p50, &r.p99, &r.peakMB) == 6) {
+    r.scenario = name;
+    rows.push_back(r);
+   }
+  }
+  std::fclose(file);
+  return true;
+ }
+
+ /** Prints the change of every row against base; returns the number of regressions. */
+ size_t
+  compare(const std::vector<Row>& rows, const std::vector<Row>& base, double tolerance) {
+  std::printf("\n== against baseline (tolerance %.0f%%)\n", tolerance * 100.0);
+  std::printf("%-12s %8s %12s %12s   %s\n", "scenario", "threads", "p50 change", "peak change", "");
+  size_t regressions = 0;
+  for (const Row& r : rows) {
+   const auto b = std::find_if(base.begin(), base.end(), [&](const Row& o) { return o.scenario == r.scenario && o.threads == r.threads; });
+   if (b == base.end()) continue;
+   const double time = b->p50 > 0.0 ? r.p50 / b->p50 - 1.0 : 0.0;
+   const double memory = b->peakMB > 0.0 ? r.peakMB / b->peakMB - 1.0 : 0.0;
+   const bool regressed = time > tolerance || memory > tolerance;
+   regressions += regressed;
+   std::printf("%-12s %8zu %+11.1f%% %+11.1f%%   %s\n", r.scenario.c_str(), r.threads, time * 100.0, memory * 100.0,
+               regressed ? "REGRESSION" : "ok");
+  }
+  return regressions;
+ }
+
+ /** Comma-separated thread counts, 0 entries dropped. */
+ std::vector<size_t>
+  parseThreads(const char* list) {
+  std::vector<size_t> counts;
+  for (const char* p = list; *p;) {
+   char* end;
+   const unsigned long n = std::strtoul(p, &end, 10);
+   if (end == p) break;
+   if (n) counts.push_back(n);
+   p = *end == ',' ? end + 1 : end;
+  }
+  return counts;
+ }
+}
+
+int
+ main(int argc, char** argv) {
+ const char* filter = nullptr;
+ const char* csvPath = nullptr;
+ const char* baselinePath = nullptr;
+ size_t frames = DEFAULT_FRAMES;
+ double tolerance = 0.1;
+ const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+ std::vector<size_t> threadCounts = { 1, 2, 4, hardware };
+
+ for (int i = 1; i < argc; ++i) {
+  const bool hasValue = i + 1 < argc;
+  if (std::strcmp(argv[i], "--frames") == 0 && hasValue) frames = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+  else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) threadCounts = parseThreads(argv[++i]);
+  else if (std::strcmp(argv[i], "--csv") == 0 && hasValue) csvPath = argv[++i];
+  else if (std::strcmp(argv[i], "--baseline") == 0 && hasValue) baselinePath = argv[++i];
+  else if (std::strcmp(argv[i], "--tolerance") == 0 && hasValue) tolerance = std::atof(argv[++i]);
+  else if (argv[i][0] != '-') filter = argv[i];
+  else {
+   std::fprintf(stderr, "usage: %s [filter] [--frames N] [--threads 1,2,8] [--csv out.csv] [--baseline base.csv] [--tolerance 0.1]\n", argv[0]);
+   return 2;
+  }
+ }
+ std::sort(threadCounts.begin(), threadCounts.end());
+ threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+
+ std::printf("%zu timed frames per row after %zu warmup, %zu hardware threads\n\n", frames, WARMUP_FRAMES, hardware);
+ std::printf("%-12s %8s %14s %-10s %10s %10s %10s\n", "scenario", "threads", "throughput", "per s", "p50 ms", "p99 ms", "peak MB");
+ std::vector<Row> rows;
+ for (const ScenarioInfo& info : SCENARIOS) {
+  if (filter && !std::strstr(info.name, filter)) continue;
+  for (const size_t threads : threadCounts) rows.push_back(run(info, threads, frames));
+ }
+
+ if (csvPath && !writeCsv(csvPath, rows)) {
+  std::fprintf(stderr, "cannot write %s\n", csvPath);
+  return 2;
+ }
+ if (baselinePath) {
+  std::vector<Row> base;
+  if (!readCsv(baselinePath, base)) {
+   std::fprintf(stderr, "cannot read %s\n", baselinePath);
+   return 2;
+  }
+  if (compare(rows, base, tolerance)) return 1;
+ }
+ return 0;
+}